@@ -0,0 +1,28 @@
+# ============================================================================
+# cmake/EmbedShader.cmake
+# ============================================================================
+# cmake -DINPUT=<file.spv> -DOUTPUT=<file.spv.inl> [-DNULL_TERMINATE=ON] -P EmbedShader.cmake
+#
+# Writes the bytes of INPUT as a comma-separated initializer list, twelve per line,
+# for #include inside a std::vector<uint8> initializer.
+# NULL_TERMINATE appends a zero byte, for text such as WGSL embedded as a char array
+# (string literals that long exceed MSVC's limit).
+
+file(READ ${INPUT} hex HEX)
+string(LENGTH "${hex}" hexLength)
+
+set(bytesPerLine 12)
+math(EXPR charsPerLine "${bytesPerLine} * 2")
+set(content "")
+set(offset 0)
+while(offset LESS hexLength)
+    string(SUBSTRING "${hex}" ${offset} ${charsPerLine} line)
+    string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " line "${line}")
+    string(APPEND content "\n    ${line}")
+    math(EXPR offset "${offset} + ${charsPerLine}")
+endwhile()
+if(NULL_TERMINATE)
+    string(APPEND content "\n    0x00,")
+endif()
+
+file(WRITE ${OUTPUT} "${content}")
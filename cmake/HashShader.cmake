@@ -0,0 +1,36 @@
+# ============================================================================
+# cmake/HashShader.cmake
+# ============================================================================
+# cmake -DINPUT=<file.spv> -DOUTPUT=<file.spv.hash> -P HashShader.cmake
+#
+# Writes the 64-bit FNV-1a hash of INPUT as a C++ literal (0x...ull), the key the
+# backends' shader caches use (WebGPUShaderCache::HashSpirv()). CMake's math is signed
+# 64-bit, so the hash is kept as two 32-bit halves: multiplying by the FNV prime
+# 2^40 + 0x1b3 is hash * 0x1b3 plus the low half shifted into the high one by 8.
+
+file(READ ${INPUT} hex HEX)
+string(REGEX MATCHALL ".." bytes "${hex}")
+
+set(high 0xcbf29ce4)
+set(low 0x84222325)
+foreach(byte ${bytes})
+    math(EXPR low "${low} ^ 0x${byte}")
+    math(EXPR product "${low} * 0x1b3")
+    math(EXPR high "(${high} * 0x1b3 + (${product} >> 32) + (${low} << 8)) & 0xffffffff")
+    math(EXPR low "${product} & 0xffffffff")
+endforeach()
+
+# Eight hex digits per half
+set(digits "")
+foreach(half ${high} ${low})
+    math(EXPR half "${half}" OUTPUT_FORMAT HEXADECIMAL)
+    string(SUBSTRING "${half}" 2 -1 half)
+    string(LENGTH "${half}" length)
+    while(length LESS 8)
+        string(PREPEND half "0")
+        math(EXPR length "${length} + 1")
+    endwhile()
+    string(APPEND digits "${half}")
+endforeach()
+
+file(WRITE ${OUTPUT} "0x${digits}ull")
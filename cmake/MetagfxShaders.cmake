@@ -0,0 +1,170 @@
+# ============================================================================
+# cmake/MetagfxShaders.cmake
+# ============================================================================
+# Offline shader build: GLSL -> SPIR-V (glslc or glslangValidator) -> spirv-opt -O ->
+# .spv.inl byte array, per shader, as build steps with #include dependency tracking.
+# Debug builds keep debug information; other configurations strip it.
+#
+# With Metal or WebGPU enabled, spirv-cross and tint (when found) also translate every
+# module to MSL and WGSL next to it, so translation failures surface at build time.
+# The WGSL is embedded as well: precompiled_wgsl.inl lists it by SPIR-V hash for
+# GraphicsDeviceDesc::precompiledShaders, so WebGPU skips Tint at startup. Metal still
+# translates at runtime and caches the result per SPIR-V hash.
+#
+# A GLSL compiler is required: prebuilt SPIR-V would lag behind the GLSL and the C++ side
+# of its descriptor and push constant layouts. Only OPTIONAL shaders, whose users check
+# for them with __has_include, may go without one.
+
+find_program(METAGFX_GLSLC glslc HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+find_program(METAGFX_GLSLANG_VALIDATOR glslangValidator HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+find_program(METAGFX_SPIRV_OPT spirv-opt HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+find_program(METAGFX_SPIRV_CROSS spirv-cross HINTS "$ENV{VULKAN_SDK}/bin" "$ENV{VULKAN_SDK}/Bin")
+find_program(METAGFX_TINT tint)
+
+set(METAGFX_EMBED_SHADER_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/EmbedShader.cmake)
+set(METAGFX_HASH_SHADER_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/HashShader.cmake)
+
+# metagfx_add_shaders(<target> [OPTIONAL] <shader>... [VARIANTS <name> <source> <define>...])
+#
+# Compiles the shaders (paths relative to the current source directory) into
+# ${CMAKE_CURRENT_BINARY_DIR}/shaders/<shader>.spv.inl and puts that directory first on
+# the target's include path. Each VARIANTS triple compiles <source> again with the macro
+# <define> set, as if it were a shader called <name>. Without a GLSL compiler configuring
+# fails, unless OPTIONAL is given: then nothing is generated.
+function(metagfx_add_shaders TARGET)
+    cmake_parse_arguments(PARSE_ARGV 1 ARG "OPTIONAL" "" "VARIANTS")
+
+    if(METAGFX_GLSLC)
+        set(compiler ${METAGFX_GLSLC})
+    elseif(METAGFX_GLSLANG_VALIDATOR)
+        set(compiler ${METAGFX_GLSLANG_VALIDATOR})
+    elseif(ARG_OPTIONAL)
+        message(STATUS "No GLSL compiler found (glslc, glslangValidator): ${TARGET} is built without its shaders")
+        return()
+    else()
+        message(FATAL_ERROR "No GLSL compiler found (glslc, glslangValidator), which ${TARGET}'s shaders need. "
+                            "Install the Vulkan SDK or put either on PATH.")
+    endif()
+
+    set(outputDir ${CMAKE_CURRENT_BINARY_DIR}/shaders)
+    file(MAKE_DIRECTORY ${outputDir})
+    set(generated)
+    set(wgslArrays "")
+    set(wgslEntries "")
+
+    set(shaders ${ARG_UNPARSED_ARGUMENTS})
+    list(LENGTH ARG_VARIANTS variantValues)
+    math(EXPR variantRemainder "${variantValues} % 3")
+    if(NOT variantRemainder EQUAL 0)
+        message(FATAL_ERROR "metagfx_add_shaders: VARIANTS takes <name> <source> <define> triples")
+    endif()
+    while(ARG_VARIANTS)
+        list(POP_FRONT ARG_VARIANTS variantName variantSource variantDefine)
+        list(APPEND shaders ${variantName})
+        set(variantSource_${variantName} ${variantSource})
+        set(variantDefine_${variantName} ${variantDefine})
+    endwhile()
+
+    foreach(shader ${shaders})
+        if(DEFINED variantSource_${shader})
+            set(source ${CMAKE_CURRENT_SOURCE_DIR}/${variantSource_${shader}})
+            set(defineFlags -D${variantDefine_${shader}})
+        else()
+            set(source ${CMAKE_CURRENT_SOURCE_DIR}/${shader})
+            set(defineFlags)
+        endif()
+        set(rawSpv ${outputDir}/${shader}.unopt.spv)
+        set(spv ${outputDir}/${shader}.spv)
+        set(inl ${outputDir}/${shader}.spv.inl)
+        set(depfile ${outputDir}/${shader}.d)
+
+        # SPIR-V 1.0 for Vulkan 1.0, as glslangValidator -V produces.
+        # Ray query shaders need SPIR-V 1.4 (Vulkan 1.2) and MSL 2.4.
+        file(STRINGS ${source} rayQuery REGEX "GL_EXT_ray_query")
+        if(rayQuery)
+            set(targetEnv vulkan1.2)
+            set(mslVersion 20400)
+        else()
+            set(targetEnv vulkan1.0)
+            set(mslVersion 20100)
+        endif()
+        if(METAGFX_GLSLC)
+            set(compileCommand ${compiler} --target-env=${targetEnv} $<$<CONFIG:Debug>:-g> ${defineFlags}
+                -MD -MF ${depfile} -MT ${rawSpv} -o ${rawSpv} ${source})
+        else()
+            set(compileCommand ${compiler} -V --target-env ${targetEnv} $<$<CONFIG:Debug>:-g> ${defineFlags}
+                --depfile ${depfile} -o ${rawSpv} ${source})
+        endif()
+
+        if(METAGFX_SPIRV_OPT)
+            set(optimizeCommand ${METAGFX_SPIRV_OPT} -O $<$<NOT:$<CONFIG:Debug>>:--strip-debug>
+                ${rawSpv} -o ${spv})
+        else()
+            set(optimizeCommand ${CMAKE_COMMAND} -E copy ${rawSpv} ${spv})
+        endif()
+
+        add_custom_command(
+            OUTPUT ${rawSpv} ${spv} ${inl}
+            COMMAND ${compileCommand}
+            COMMAND ${optimizeCommand}
+            COMMAND ${CMAKE_COMMAND} -DINPUT=${spv} -DOUTPUT=${inl} -P ${METAGFX_EMBED_SHADER_SCRIPT}
+            DEPENDS ${source} ${METAGFX_EMBED_SHADER_SCRIPT}
+            DEPFILE ${depfile}
+            COMMENT "Compiling shader ${shader}"
+            VERBATIM
+            COMMAND_EXPAND_LISTS
+        )
+        list(APPEND generated ${inl})
+
+        if(METAGFX_USE_METAL AND METAGFX_SPIRV_CROSS)
+            set(msl ${outputDir}/${shader}.metal)
+            add_custom_command(
+                OUTPUT ${msl}
+                COMMAND ${METAGFX_SPIRV_CROSS} --msl --msl-version ${mslVersion} --output ${msl} ${spv}
+                DEPENDS ${spv}
+                COMMENT "Translating shader ${shader} to MSL"
+                VERBATIM
+            )
+            list(APPEND generated ${msl})
+        endif()
+
+        if(METAGFX_USE_WEBGPU AND METAGFX_TINT)
+            set(wgsl ${outputDir}/${shader}.wgsl)
+            set(wgslInl ${outputDir}/${shader}.wgsl.inl)
+            set(spvHash ${outputDir}/${shader}.spv.hash)
+            add_custom_command(
+                OUTPUT ${wgsl} ${wgslInl} ${spvHash}
+                COMMAND ${METAGFX_TINT} --format wgsl -o ${wgsl} ${spv}
+                COMMAND ${CMAKE_COMMAND} -DINPUT=${wgsl} -DOUTPUT=${wgslInl} -DNULL_TERMINATE=ON
+                    -P ${METAGFX_EMBED_SHADER_SCRIPT}
+                COMMAND ${CMAKE_COMMAND} -DINPUT=${spv} -DOUTPUT=${spvHash} -P ${METAGFX_HASH_SHADER_SCRIPT}
+                DEPENDS ${spv} ${METAGFX_EMBED_SHADER_SCRIPT} ${METAGFX_HASH_SHADER_SCRIPT}
+                COMMENT "Translating shader ${shader} to WGSL"
+                VERBATIM
+            )
+            list(APPEND generated ${wgsl} ${wgslInl} ${spvHash})
+
+            string(MAKE_C_IDENTIFIER "${shader}" identifier)
+            string(APPEND wgslArrays "const char WGSL_${identifier}[] = {\n#include \"${shader}.wgsl.inl\"\n};\n")
+            string(APPEND wgslEntries "    {\n#include \"${shader}.spv.hash\"\n        , WGSL_${identifier} },\n")
+        endif()
+    endforeach()
+
+    # Table of the embedded WGSL, included by the application inside a namespace. Only
+    # rewritten when the shader list changes.
+    if(wgslEntries)
+        file(GENERATE OUTPUT ${outputDir}/precompiled_wgsl.inl CONTENT
+            "// Generated by metagfx_add_shaders(): WGSL translated by tint at build time\n${wgslArrays}\nconst metagfx::rhi::PrecompiledShader PRECOMPILED_WGSL[] = {\n${wgslEntries}};\n")
+    endif()
+
+    # Shader hot reload recompiles the sources with the same compiler at runtime. Public,
+    # as the application's config header defaults its shader directory from it.
+    target_compile_definitions(${TARGET} PUBLIC
+        METAGFX_GLSL_COMPILER="${compiler}"
+        METAGFX_SHADER_SOURCE_DIR="${CMAKE_CURRENT_SOURCE_DIR}"
+    )
+
+    add_custom_target(${TARGET}_shaders DEPENDS ${generated})
+    add_dependencies(${TARGET} ${TARGET}_shaders)
+    target_include_directories(${TARGET} BEFORE PRIVATE ${outputDir})
+endfunction()
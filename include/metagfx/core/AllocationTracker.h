@@ -0,0 +1,94 @@
+// ============================================================================
+// include/metagfx/core/AllocationTracker.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+namespace metagfx {
+
+// What a heap allocation was made for: the tag of the innermost AllocationScope on the
+// allocating thread. Jobs take the tag of the thread that submitted them.
+enum class AllocationTag : uint8 {
+    Other,   // Outside any scope
+    Render,  // Application::Render() and the jobs recording for it
+    Load,    // Model imports, decodes and uploads
+    UI       // The ImGui overlay
+};
+
+constexpr uint32 ALLOCATION_TAG_COUNT = 4;
+
+const char* GetAllocationTagName(AllocationTag tag);
+
+struct AllocationCounts {
+    uint64 allocations = 0;
+    uint64 bytes = 0;        // Requested
+};
+
+struct AllocationFrame {
+    uint64 frameNumber = 0;  // EndFrame() calls before this frame's
+    AllocationCounts total;
+    AllocationCounts tags[ALLOCATION_TAG_COUNT];
+    uint64 frees = 0;
+};
+
+/**
+ * @brief Counts the heap allocations of every thread, per frame and per AllocationTag
+ *
+ * With the CMake option METAGFX_TRACK_ALLOCATIONS (METAGFX_ALLOCATION_TRACKING defined),
+ * metagfx_core replaces the global operator new and delete with ones that count each
+ * call in relaxed atomics before forwarding to malloc and free; EndFrame() takes the
+ * counts as the frame's. Over-aligned new (std::align_val_t) is not replaced and not
+ * counted. Without the option nothing is replaced, IsAvailable() is false and the
+ * frames stay empty.
+ *
+ * Use METAGFX_ALLOCATION_SCOPE() to tag: it compiles to nothing without the option.
+ */
+class AllocationTracker {
+public:
+    static constexpr bool IsAvailable() {
+#ifdef METAGFX_ALLOCATION_TRACKING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Ends the current frame: the counts since the last call become the latest frame
+    static void EndFrame();
+
+    // Latest ended frame; safe to call from any thread
+    static AllocationFrame GetLatestFrame();
+
+    // Of the calling thread
+    static AllocationTag GetCurrentTag();
+    static void SetCurrentTag(AllocationTag tag);
+};
+
+// Tags the calling thread's allocations for the enclosing scope; see
+// METAGFX_ALLOCATION_SCOPE
+class AllocationScope {
+public:
+    explicit AllocationScope(AllocationTag tag) : m_Previous(AllocationTracker::GetCurrentTag()) {
+        AllocationTracker::SetCurrentTag(tag);
+    }
+    ~AllocationScope() { AllocationTracker::SetCurrentTag(m_Previous); }
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+private:
+    AllocationTag m_Previous;
+};
+
+} // namespace metagfx
+
+// Used as a statement, with an AllocationTag enumerator name: METAGFX_ALLOCATION_SCOPE(Render)
+#ifdef METAGFX_ALLOCATION_TRACKING
+#define METAGFX_ALLOCATION_SCOPE(tag) \
+    ::metagfx::AllocationScope METAGFX_ALLOCATION_CONCAT(metagfxAllocationScope, __LINE__)(::metagfx::AllocationTag::tag)
+#define METAGFX_ALLOCATION_CONCAT_IMPL(a, b) a##b
+#define METAGFX_ALLOCATION_CONCAT(a, b) METAGFX_ALLOCATION_CONCAT_IMPL(a, b)
+#else
+#define METAGFX_ALLOCATION_SCOPE(tag) ((void)0)
+#endif
@@ -0,0 +1,59 @@
+// ============================================================================
+// include/metagfx/core/FrameArena.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief Linear allocator for data that lives until the end of a frame
+ *
+ * A memory resource for std::pmr containers: allocation bumps a pointer through one
+ * block, deallocation does nothing, and Reset() at the start of the next frame frees
+ * everything at once. What does not fit goes to the heap for the rest of the frame,
+ * and Reset() then grows the block to the frame's total, so once frames settle they
+ * allocate nothing. Not thread-safe: allocate from the thread that owns the arena
+ * (workers may use what it allocated).
+ */
+class FrameArena : public std::pmr::memory_resource {
+public:
+    explicit FrameArena(size_t initialSize = 64 * 1024);
+    ~FrameArena() override;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // Invalidates everything allocated since the last Reset()
+    void Reset();
+
+    size_t GetUsed() const { return m_Used + m_OverflowBytes; }  // This frame
+    size_t GetCapacity() const { return m_Capacity; }             // Of the block
+
+private:
+    struct Overflow {
+        void* data;
+        size_t size;
+        size_t alignment;
+    };
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+    void do_deallocate(void*, size_t, size_t) override {}  // Reset() frees everything
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void AllocateBlock(size_t size);
+    void FreeOverflow();
+
+    std::byte* m_Block = nullptr;
+    size_t m_Capacity = 0;
+    size_t m_Used = 0;  // Bytes of the block, with alignment padding
+    std::vector<Overflow> m_Overflow;  // Heap allocations of this frame
+    size_t m_OverflowBytes = 0;
+};
+
+} // namespace metagfx
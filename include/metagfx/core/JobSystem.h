@@ -0,0 +1,97 @@
+// ============================================================================
+// include/metagfx/core/JobSystem.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace metagfx {
+
+using Job = std::function<void()>;
+
+/**
+ * @brief Dependency counter of a group of jobs
+ *
+ * Every job run with the counter holds it up until that job returns; jobs queued
+ * behind it with JobSystem::RunAfter() start once it drops to zero. Call
+ * JobSystem::Wait() on a counter before destroying or reusing it.
+ */
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    bool IsDone() const { return m_Pending.load(std::memory_order_acquire) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<uint32> m_Pending{0};
+    std::mutex m_Mutex;                // Orders RunAfter() and Wait() against the last job
+    std::vector<Job> m_Continuations;  // Scheduled when m_Pending drops to zero
+};
+
+struct JobSystemDesc {
+    uint32 workerCount = 0;   // 0: one per hardware thread besides the main thread
+    bool pinWorkers = false;  // Worker i runs on core i + 1 only; core 0 is left to the main thread
+};
+
+/**
+ * @brief Work-stealing task scheduler shared by the engine and the tools
+ *
+ * Each worker thread owns a deque: it pushes and pops its own jobs at the back and,
+ * when that is empty, steals from the front of the others. Jobs submitted from other
+ * threads land in a shared queue that every worker steals from.
+ *
+ * Jobs are plain tasks rather than fibers: a thread waiting on a counter runs other
+ * queued jobs until the counter is done, so waiting inside a job does not idle a worker.
+ *
+ * The main-thread queue carries work that must run on the thread that called Init()
+ * (SDL, swap-chain and device calls); it is drained by ProcessMainThreadJobs() and by
+ * Wait() on that thread.
+ *
+ * Without Init(), or with no worker threads (single core, Emscripten), jobs run inline
+ * on the submitting thread.
+ */
+class JobSystem {
+public:
+    static void Init(const JobSystemDesc& desc = {});
+    static void Shutdown();  // Runs whatever is still queued, then joins the workers
+
+    static uint32 GetWorkerCount();
+    static bool IsMainThread();
+
+    // Queues a job. With a counter, it holds the counter up until it returns.
+    static void Run(Job job, JobCounter* counter = nullptr);
+
+    // Queues a job once dependency is done (right away if it already is)
+    static void RunAfter(JobCounter& dependency, Job job, JobCounter* counter = nullptr);
+
+    // Returns once counter is done, running queued jobs meanwhile
+    static void Wait(JobCounter& counter);
+
+    // Hold counter up for work that is not a job, such as a file read in flight, until
+    // the matching Release()
+    static void Hold(JobCounter& counter);
+    static void Release(JobCounter& counter);
+
+    // Calls body(begin, end) over [0, count) in ranges of at least minBatchSize indices,
+    // one of them on the calling thread, and returns once all have finished
+    static void ParallelFor(uint32 count, uint32 minBatchSize,
+                            const std::function<void(uint32 begin, uint32 end)>& body);
+
+    // Queues a job for the main thread; it runs in the next ProcessMainThreadJobs()
+    static void RunOnMainThread(Job job);
+    static void ProcessMainThreadJobs();  // Main thread only
+
+private:
+    static void FinishJob(JobCounter& counter);
+};
+
+} // namespace metagfx
@@ -3,11 +3,12 @@
 // ============================================================================
 #pragma once
 
+#include <atomic>
+#include <ctime>
+#include <iomanip>
 #include <iostream>
 #include <sstream>
 #include <string>
-#include <ctime>
-#include <iomanip>
 
 namespace metagfx {
 
@@ -20,48 +21,114 @@ enum class LogLevel {
     Fatal
 };
 
+// Lowest level compiled in, as a LogLevel value (CMake option METAGFX_LOG_LEVEL). Macros
+// below it are constant-false branches: their arguments still compile but never run.
+#ifndef METAGFX_LOG_LEVEL
+#define METAGFX_LOG_LEVEL 0
+#endif
+
+/**
+ * @brief Asynchronous console logger
+ *
+ * Log() timestamps the message and pushes it onto a lock-free multi-producer queue; a
+ * writer thread started by Init() formats the lines and writes them in batches, flushing
+ * once per batch. Fatal messages wait until they are written. Before Init() and after
+ * Shutdown() messages are written on the calling thread.
+ *
+ * Use the METAGFX_* macros rather than calling Log() directly: they test the level before
+ * the message is formatted.
+ */
 class Logger {
 public:
+    // Starts the writer thread; Shutdown() runs at exit if not called before
     static void Init();
-    
-    static void Log(LogLevel level, const std::string& message);
-    
-    template<typename... Args>
-    static void LogFormatted(LogLevel level, const char* format, Args... args);
-    
+
+    // Writes what is queued and stops the writer thread. Messages logged while it runs
+    // may be lost.
+    static void Shutdown();
+
+    // Blocks until every message queued so far is written
+    static void Flush();
+
+    // Runtime filter on top of METAGFX_LOG_LEVEL
+    static void SetLevel(LogLevel level);
+    static LogLevel GetLevel() { return static_cast<LogLevel>(s_Level.load(std::memory_order_relaxed)); }
+
+    static bool IsEnabled(LogLevel level) {
+        return static_cast<int>(level) >= METAGFX_LOG_LEVEL &&
+               static_cast<int>(level) >= s_Level.load(std::memory_order_relaxed);
+    }
+
+    static void Log(LogLevel level, std::string message);
+
 private:
-    static const char* GetLevelString(LogLevel level);
-    static const char* GetLevelColor(LogLevel level);
-    static std::string GetTimestamp();
+    static std::atomic<int> s_Level;
 };
 
 // Stream-based logger helper
 class LogStream {
 public:
     LogStream(LogLevel level) : m_Level(level) {}
-    
+
     ~LogStream() {
-        Logger::Log(m_Level, m_Stream.str());
+        Logger::Log(m_Level, std::move(m_Stream).str());
     }
-    
+
     template<typename T>
     LogStream& operator<<(const T& value) {
         m_Stream << value;
         return *this;
     }
-    
+
 private:
     LogLevel m_Level;
     std::ostringstream m_Stream;
 };
 
+namespace detail {
+
+// Rate limits for the _ONCE / _EVERY_N macros; each call site owns its state
+inline bool LogFirstTime(std::atomic<bool>& logged) {
+    return !logged.load(std::memory_order_relaxed) && !logged.exchange(true, std::memory_order_relaxed);
+}
+
+inline bool LogEveryN(std::atomic<unsigned>& count, unsigned n) {
+    return count.fetch_add(1, std::memory_order_relaxed) % (n > 0 ? n : 1) == 0;
+}
+
+} // namespace detail
+
 } // namespace metagfx
 
-// Logging macros - create temporary LogStream objects
-#define METAGFX_TRACE    ::metagfx::LogStream(::metagfx::LogLevel::Trace)
-#define METAGFX_DEBUG    ::metagfx::LogStream(::metagfx::LogLevel::Debug)
-#define METAGFX_INFO     ::metagfx::LogStream(::metagfx::LogLevel::Info)
-#define METAGFX_WARN     ::metagfx::LogStream(::metagfx::LogLevel::Warning)
-#define METAGFX_ERROR    ::metagfx::LogStream(::metagfx::LogLevel::Error)
-#define METAGFX_CRITICAL ::metagfx::LogStream(::metagfx::LogLevel::Fatal)
+// Logging macros - each starts a statement streamed into with <<. The message is only
+// formatted when the level is enabled; the if/else form keeps them safe in unbraced ifs.
+#define METAGFX_LOG(level) \
+    if (!::metagfx::Logger::IsEnabled(level)) {} else ::metagfx::LogStream(level)
+
+// First call only, e.g. in per-frame code
+#define METAGFX_LOG_ONCE(level) \
+    if (static ::std::atomic<bool> metagfxLogged{false}; \
+        !::metagfx::Logger::IsEnabled(level) || !::metagfx::detail::LogFirstTime(metagfxLogged)) {} \
+    else ::metagfx::LogStream(level)
+
+// First call and every n-th after it
+#define METAGFX_LOG_EVERY_N(level, n) \
+    if (static ::std::atomic<unsigned> metagfxLogCount{0}; \
+        !::metagfx::Logger::IsEnabled(level) || !::metagfx::detail::LogEveryN(metagfxLogCount, n)) {} \
+    else ::metagfx::LogStream(level)
+
+#define METAGFX_TRACE    METAGFX_LOG(::metagfx::LogLevel::Trace)
+#define METAGFX_DEBUG    METAGFX_LOG(::metagfx::LogLevel::Debug)
+#define METAGFX_INFO     METAGFX_LOG(::metagfx::LogLevel::Info)
+#define METAGFX_WARN     METAGFX_LOG(::metagfx::LogLevel::Warning)
+#define METAGFX_ERROR    METAGFX_LOG(::metagfx::LogLevel::Error)
+#define METAGFX_CRITICAL METAGFX_LOG(::metagfx::LogLevel::Fatal)
+
+#define METAGFX_DEBUG_ONCE METAGFX_LOG_ONCE(::metagfx::LogLevel::Debug)
+#define METAGFX_INFO_ONCE  METAGFX_LOG_ONCE(::metagfx::LogLevel::Info)
+#define METAGFX_WARN_ONCE  METAGFX_LOG_ONCE(::metagfx::LogLevel::Warning)
+#define METAGFX_ERROR_ONCE METAGFX_LOG_ONCE(::metagfx::LogLevel::Error)
 
+#define METAGFX_DEBUG_EVERY_N(n) METAGFX_LOG_EVERY_N(::metagfx::LogLevel::Debug, n)
+#define METAGFX_INFO_EVERY_N(n)  METAGFX_LOG_EVERY_N(::metagfx::LogLevel::Info, n)
+#define METAGFX_WARN_EVERY_N(n)  METAGFX_LOG_EVERY_N(::metagfx::LogLevel::Warning, n)
@@ -0,0 +1,151 @@
+// ============================================================================
+// include/metagfx/core/Profiler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <string>
+#include <vector>
+
+#ifdef METAGFX_USE_TRACY
+#include <tracy/Tracy.hpp>
+#endif
+
+namespace metagfx {
+
+struct ProfileZone {
+    const char* name = nullptr;
+    uint32 depth = 0;          // Nesting level on its thread, 0 outermost
+    double startMs = 0.0;      // From the frame start; negative when the zone began in an earlier frame
+    double durationMs = 0.0;
+};
+
+struct ProfileThread {
+    uint32 id = 0;              // Order the thread first recorded in
+    std::string name;
+    std::vector<ProfileZone> zones;  // Zones that ended during the frame, by start time
+    uint32 droppedEvents = 0;   // Lost because the thread's buffer was full
+};
+
+struct ProfileCounter {
+    const char* name = nullptr;
+    double timeMs = 0.0;        // From the frame start
+    double value = 0.0;
+};
+
+struct ProfileFrame {
+    uint64 frameNumber = 0;     // EndFrame() calls before this frame's
+    double startMs = 0.0;       // From profiler start; places the frame in the trace
+    double durationMs = 0.0;
+    std::vector<ProfileThread> threads;
+    std::vector<ProfileCounter> counters;  // In recording order
+};
+
+/**
+ * @brief CPU instrumentation: scoped zones and counters per thread, collected per frame
+ *
+ * Each thread records into its own fixed-size ring buffer without locking; EndFrame(),
+ * called once per main-loop iteration, drains every ring into a ProfileFrame. Events
+ * that do not fit before the next drain are dropped and counted.
+ *
+ * Use the METAGFX_PROFILE_* macros rather than calling this directly: they compile to
+ * nothing without METAGFX_PROFILER_ENABLED (CMake option METAGFX_ENABLE_PROFILER), and
+ * with METAGFX_USE_TRACY they also feed a connected Tracy profiler. Zone and counter
+ * names are kept as pointers, so they must be string literals or otherwise outlive the
+ * profiler.
+ */
+class Profiler {
+public:
+    static constexpr uint32 EVENT_CAPACITY = 1 << 14;    // Per thread, between two EndFrame() calls
+    static constexpr uint32 MAX_HISTORY_FRAMES = 300;    // Frames kept for WriteChromeTrace()
+
+    // Recording can be paused at runtime; zones already open still end
+    static void SetEnabled(bool enabled);
+    static bool IsEnabled();
+
+    // Names the calling thread in the flame view and traces
+    static void SetThreadName(const char* name);
+
+    // Nanoseconds since the profiler started
+    static uint64 Now();
+
+    static void BeginZone();
+    static void EndZone(const char* name, uint64 startNs);
+    static void Counter(const char* name, double value);
+
+    // Ends the current frame: collects what every thread recorded since the last call
+    static void EndFrame();
+
+    // Latest collected frame; safe to call from any thread
+    static ProfileFrame GetLatestFrame();
+    // Kept frames (up to MAX_HISTORY_FRAMES) overlapping startMs to endMs, in milliseconds
+    // since the profiler started like ProfileFrame::startMs; safe to call from any thread
+    static std::vector<ProfileFrame> GetFrames(double startMs, double endMs);
+
+    // Writes the frames kept (up to MAX_HISTORY_FRAMES) as Chrome trace event JSON, for
+    // chrome://tracing or Perfetto. False when the file cannot be written.
+    static bool WriteChromeTrace(const std::string& path);
+};
+
+// Times the enclosing scope as a zone; see METAGFX_PROFILE_SCOPE
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) {
+        if (Profiler::IsEnabled()) {
+            m_Name = name;
+            m_StartNs = Profiler::Now();
+            Profiler::BeginZone();
+        }
+    }
+
+    ~ProfileScope() {
+        if (m_Name) {
+            Profiler::EndZone(m_Name, m_StartNs);
+        }
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* m_Name = nullptr;
+    uint64 m_StartNs = 0;
+};
+
+} // namespace metagfx
+
+#define METAGFX_PROFILE_CONCAT_IMPL(a, b) a##b
+#define METAGFX_PROFILE_CONCAT(a, b) METAGFX_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef METAGFX_USE_TRACY
+#define METAGFX_TRACY_ZONE(name) ZoneScopedN(name)
+#define METAGFX_TRACY_FUNCTION() ZoneScoped
+#define METAGFX_TRACY_PLOT(name, value) TracyPlot(name, static_cast<double>(value))
+#define METAGFX_TRACY_FRAME() FrameMark
+#define METAGFX_TRACY_THREAD(name) tracy::SetThreadName(name)
+#else
+#define METAGFX_TRACY_ZONE(name) ((void)0)
+#define METAGFX_TRACY_FUNCTION() ((void)0)
+#define METAGFX_TRACY_PLOT(name, value) ((void)0)
+#define METAGFX_TRACY_FRAME() ((void)0)
+#define METAGFX_TRACY_THREAD(name) ((void)0)
+#endif
+
+// Profiling macros - each used as a statement
+#ifdef METAGFX_PROFILER_ENABLED
+#define METAGFX_PROFILE_SCOPE(name) \
+    ::metagfx::ProfileScope METAGFX_PROFILE_CONCAT(metagfxProfileScope, __LINE__)(name); METAGFX_TRACY_ZONE(name)
+#define METAGFX_PROFILE_FUNCTION() \
+    ::metagfx::ProfileScope METAGFX_PROFILE_CONCAT(metagfxProfileScope, __LINE__)(__func__); METAGFX_TRACY_FUNCTION()
+#define METAGFX_PROFILE_COUNTER(name, value) \
+    ::metagfx::Profiler::Counter(name, static_cast<double>(value)); METAGFX_TRACY_PLOT(name, value)
+#define METAGFX_PROFILE_FRAME()      ::metagfx::Profiler::EndFrame(); METAGFX_TRACY_FRAME()
+#define METAGFX_PROFILE_THREAD(name) ::metagfx::Profiler::SetThreadName(name); METAGFX_TRACY_THREAD(name)
+#else
+#define METAGFX_PROFILE_SCOPE(name)          ((void)0)
+#define METAGFX_PROFILE_FUNCTION()           ((void)0)
+#define METAGFX_PROFILE_COUNTER(name, value) ((void)0)
+#define METAGFX_PROFILE_FRAME()              ((void)0)
+#define METAGFX_PROFILE_THREAD(name)         ((void)0)
+#endif
@@ -0,0 +1,84 @@
+// ============================================================================
+// include/metagfx/core/SimdMath.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <glm/glm.hpp>
+#include <cstddef>
+
+namespace metagfx {
+namespace simd {
+
+/**
+ * @brief Batch geometry kernels for the scene's hot loops
+ *
+ * Each kernel has an AVX2 (8 lanes, with METAGFX_SIMD_AVX2), SSE2 or NEON (4 lanes) and
+ * scalar path, picked at compile time; only SimdMath.cpp is built with the wider
+ * instruction set. Batches take structure-of-arrays inputs so a load fills a register
+ * with one component of consecutive elements, and tests write the indices of the
+ * elements that pass instead of a mask, so callers skip the compaction loop.
+ */
+
+// "AVX2", "SSE2", "NEON" or "scalar"
+const char* GetInstructionSet();
+
+// Structure-of-arrays boxes: box i spans (minX[i], minY[i], minZ[i]) to (maxX[i], ...)
+struct BoxArrays {
+    const float* minX = nullptr;
+    const float* minY = nullptr;
+    const float* minZ = nullptr;
+    const float* maxX = nullptr;
+    const float* maxY = nullptr;
+    const float* maxZ = nullptr;
+};
+
+// Structure-of-arrays spheres
+struct SphereArrays {
+    const float* centerX = nullptr;
+    const float* centerY = nullptr;
+    const float* centerZ = nullptr;
+    const float* radius = nullptr;
+};
+
+// Four boxes in structure-of-arrays form, as a wide BVH node keeps its children's
+struct Box4 {
+    alignas(16) float minX[4];
+    alignas(16) float minY[4];
+    alignas(16) float minZ[4];
+    alignas(16) float maxX[4];
+    alignas(16) float maxY[4];
+    alignas(16) float maxZ[4];
+};
+
+// Writes the index of every sphere not entirely outside one of the six planes (normals
+// inwards, normalized) to outIndices, which must hold count entries; returns how many
+// were written, in increasing order
+size_t CullSpheres(const glm::vec4 planes[6], const SphereArrays& spheres, size_t count, uint32* outIndices);
+
+// Writes the index of every box within radius of center to outIndices (count entries),
+// in increasing order; returns how many were written
+size_t OverlapSphereBoxes(const glm::vec3& center, float radius, const BoxArrays& boxes, size_t count,
+                          uint32* outIndices);
+
+// Slab test of one ray against four boxes at once: bit i of the result is set when the
+// ray enters box i before maxT (and not behind the origin), outT[i] its entry distance.
+// inverseDirection is 1 / direction per component (infinite for a zero component).
+uint32 IntersectRayBox4(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxT, const Box4& boxes,
+                        float outT[4]);
+
+// Box of the transformed box (Arvo: the absolute linear part scales the half extent)
+void TransformBox(const glm::mat4& matrix, const glm::vec3& boxMin, const glm::vec3& boxMax,
+                  glm::vec3& outMin, glm::vec3& outMax);
+
+// TransformBox() over arrays, box i by matrices[i]; the outputs may be the inputs
+void TransformBoxes(const glm::mat4* matrices, const glm::vec3* boxMins, const glm::vec3* boxMaxs, size_t count,
+                    glm::vec3* outMins, glm::vec3* outMaxs);
+
+// Bounds of count points, the first at points and each stride bytes after the last
+// (e.g. sizeof(Vertex) for vertex positions). Leaves the outputs untouched when count is 0.
+void ComputeBounds(const glm::vec3* points, size_t count, size_t stride, glm::vec3& outMin, glm::vec3& outMax);
+
+} // namespace simd
+} // namespace metagfx
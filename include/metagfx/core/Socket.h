@@ -0,0 +1,63 @@
+// ============================================================================
+// include/metagfx/core/Socket.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+namespace metagfx {
+
+/**
+ * @brief A TCP socket over BSD sockets or Winsock, owned and move-only
+ *
+ * Enough for a stream between two processes: a listening socket accepts without
+ * blocking, and a connected one sends in full and receives what has arrived. Send and
+ * receive may run on different threads; nothing else is thread-safe.
+ */
+class Socket {
+public:
+    Socket() = default;
+    ~Socket();
+
+    Socket(Socket&& other) noexcept;
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    // A non-blocking socket listening on port of every interface; invalid on failure (logged)
+    static Socket Listen(uint16 port);
+    // A blocking socket connected to host (name or address); invalid on failure (logged)
+    static Socket Connect(const char* host, uint16 port);
+
+    bool IsValid() const { return m_Handle != INVALID_HANDLE; }
+
+    // The next pending connection of a listening socket, or an invalid socket when none waits
+    Socket Accept();
+
+    bool SetNonBlocking(bool nonBlocking);
+    // Sends small messages at once instead of coalescing them (Nagle's algorithm off)
+    bool SetNoDelay(bool noDelay);
+
+    // Blocks until all size bytes are sent, non-blocking sockets too; false once the
+    // connection is gone
+    bool SendAll(const void* data, uint64 size);
+    // Up to size bytes: the count received, 0 when a non-blocking socket has nothing
+    // waiting, -1 once the connection is closed or failed
+    int64 Receive(void* data, uint64 size);
+
+    // Ends the connection both ways but keeps the handle: sends and receives blocked on
+    // other threads fail, without the handle being reused under them
+    void Shutdown();
+    void Close();
+
+private:
+    // SOCKET on Windows, a file descriptor elsewhere
+    using Handle = uint64;
+    static constexpr Handle INVALID_HANDLE = ~Handle(0);
+
+    explicit Socket(Handle handle) : m_Handle(handle) {}
+
+    Handle m_Handle = INVALID_HANDLE;
+};
+
+} // namespace metagfx
@@ -0,0 +1,101 @@
+// ============================================================================
+// include/metagfx/core/StreamProtocol.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+namespace metagfx {
+namespace stream {
+
+// Messages between a streaming renderer (--stream) and its client over one TCP
+// connection, each a MessageHeader followed by size bytes of payload. Fields are
+// little-endian, the byte order of every platform the renderer runs on.
+//
+//   Server -> client: Frame           FrameInfo, then the frame's bytes in its format
+//   Client -> server: Hello           ClientHello, the formats it decodes, once connected
+//                     Input           InputEvent
+//                     FrameAck        FrameAck, once the frame is on the client's screen
+//                     KeyFrameRequest no payload: the client lost its place in an H.264
+//                                     stream and waits for the next key frame
+
+constexpr uint32 MAGIC = 0x5846474D;  // "MGFX"
+constexpr uint16 DEFAULT_PORT = 7420;
+
+enum class MessageType : uint32 {
+    Frame = 1,
+    Input = 2,
+    FrameAck = 3,
+    Hello = 4,
+    KeyFrameRequest = 5
+};
+
+struct MessageHeader {
+    uint32 magic = MAGIC;
+    MessageType type = MessageType::Frame;
+    uint64 size = 0;  // Of the payload that follows
+};
+
+enum class PixelFormat : uint32 {
+    // A pitch x height plane of luma, then a pitch x height/2 plane of interleaved Cb
+    // and Cr at half resolution; BT.709, limited range (16-235, 16-240)
+    NV12 = 1,
+    // An H.264 access unit of NV12 as above, as an Annex B byte stream; key frames are IDR
+    // pictures with the sequence and picture parameter sets before them. Each frame
+    // predicts from the one before, so none may be skipped until the next key frame.
+    H264 = 2
+};
+
+// Bit of format in ClientHello::formats
+constexpr uint32 FormatBit(PixelFormat format) {
+    return 1u << static_cast<uint32>(format);
+}
+
+struct FrameInfo {
+    uint64 frameNumber = 0;
+    uint64 captureTimeNs = 0;  // Server clock, for the server's latency from FrameAck
+    uint32 width = 0;          // Of the image; the planes are padded to even sizes
+    uint32 height = 0;
+    uint32 pitch = 0;          // Bytes per row of both planes; 0 for H.264
+    PixelFormat format = PixelFormat::NV12;
+};
+
+// Clients that send none decode NV12 only
+struct ClientHello {
+    uint32 formats = FormatBit(PixelFormat::NV12);  // FormatBit()s of the formats it decodes
+    uint32 reserved = 0;
+};
+
+enum class InputKind : uint32 {
+    MouseMotion = 1,
+    MouseButtonDown = 2,
+    MouseButtonUp = 3,
+    MouseWheel = 4,
+    KeyDown = 5,
+    KeyUp = 6
+};
+
+// Pointer positions are in pixels of the frame, whatever size the client shows it at
+struct InputEvent {
+    InputKind kind = InputKind::MouseMotion;
+    uint32 code = 0;       // SDL button index, or SDL scancode
+    float x = 0.0f;        // Pointer position; wheel: scroll amount
+    float y = 0.0f;
+    float deltaX = 0.0f;   // Mouse motion only
+    float deltaY = 0.0f;
+    uint32 keycode = 0;    // SDL keycode of keys
+    uint32 modifiers = 0;  // SDL_Keymod of keys; held SDL button mask of motion
+};
+
+struct FrameAck {
+    uint64 frameNumber = 0;
+};
+
+static_assert(sizeof(MessageHeader) == 16, "MessageHeader is part of the wire format");
+static_assert(sizeof(FrameInfo) == 32, "FrameInfo is part of the wire format");
+static_assert(sizeof(InputEvent) == 32, "InputEvent is part of the wire format");
+static_assert(sizeof(FrameAck) == 8, "FrameAck is part of the wire format");
+static_assert(sizeof(ClientHello) == 8, "ClientHello is part of the wire format");
+
+} // namespace stream
+} // namespace metagfx
@@ -0,0 +1,50 @@
+// ============================================================================
+// include/metagfx/renderer/DeferredRenderer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/renderer/RasterizationRenderer.h"
+
+namespace metagfx {
+
+/**
+ * @brief Deferred renderer: the model's materials into a G-buffer, lit by a compute pass
+ *
+ * Same frame as RasterizationRenderer up to the main pass, which becomes three to seven
+ * passes of the render graph when FrameInputs::deferredLighting and toneMapper are set:
+ * - G-buffer pass: the content's model draws (with G-buffer pipelines) into one
+ *   DeferredLighting::GBUFFER_FORMAT target and the frame's depth buffer
+ * - Ambient occlusion, with FrameInputs::ambientOcclusion: AmbientOcclusion::Apply()
+ *   from the G-buffer pass's depth, for the lighting pass's ambient light
+ * - Reflections, with FrameInputs::reflections: the depth pyramid built from the
+ *   G-buffer pass's depth (the one the next frame's occlusion test reads), then
+ *   ScreenSpaceReflections::Trace() through it, for the lighting pass's specular light
+ * - Deferred lighting: DeferredLighting::Light() shades each pixel with the lights of
+ *   its screen tile into a lit color texture; with reflections, CaptureColor() then keeps
+ *   it for the next frame's trace
+ * - Main pass: the lit color and depth composited into the HDR scene color, then the
+ *   scenery drawn forward over them, all tone mapped by the pass after it
+ *
+ * The lighting cost follows the pixels and the lights touching them instead of the
+ * fragments the model's draws shade, which is what scenes of many lights and heavy
+ * overdraw pay for in the forward pass. Without either the main pass is the forward
+ * one. Shadow debug views are forward only; ambient occlusion and reflections are
+ * deferred only, since the forward depth prepass runs inside the main pass they would
+ * have to come before.
+ */
+class DeferredRenderer : public RasterizationRenderer {
+public:
+    explicit DeferredRenderer(Ref<rhi::GraphicsDevice> device);
+
+    const char* GetName() const override { return "Deferred"; }
+    RenderMode GetMode() const override { return RenderMode::Deferred; }
+    bool SupportsFeature(RenderFeature feature) const override;
+
+protected:
+    void RenderMainPass(Scene& scene, Camera& camera) override;
+    // Fills gbuffer and the frame's depth buffer with the model: its draws with G-buffer
+    // pipelines
+    virtual void RenderGBufferPass(const ModelPassPlan& plan, RenderGraphResource gbuffer);
+};
+
+} // namespace metagfx
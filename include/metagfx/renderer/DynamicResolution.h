@@ -0,0 +1,56 @@
+// ============================================================================
+// include/metagfx/renderer/DynamicResolution.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+
+namespace metagfx {
+
+/**
+ * @brief Fraction of the render size to draw, steered toward a target GPU frame time
+ *
+ * Update() takes each timed frame's GPU time as the timestamp queries return it. The
+ * frame's cost follows its pixel count, so the scale of each side moves by the square
+ * root of the wanted over the smoothed time, a limited step at a time. Between the target
+ * and its headroom below it the scale holds, and after a change it holds for a few timed
+ * frames, which were still in flight at the old size: the two keep it from oscillating.
+ *
+ * The renderer draws the scaled size into the top-left region of targets of the full
+ * render size (RasterizationRenderer::FrameInputs::renderScale), so a change of scale
+ * reallocates nothing.
+ */
+class DynamicResolution {
+public:
+    struct Settings {
+        float targetMs = 15.0f;   // GPU frame time to stay under; 60 Hz leaves 16.7
+        float headroom = 0.85f;   // Below targetMs * headroom the scale grows back
+        float minScale = 0.5f;    // Of each side of the render size
+        float maxScale = 1.0f;
+        float maxStep = 0.05f;    // Of the scale per change
+        uint32 settleFrames = 4;  // Timed frames held after a change
+    };
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // One frame's GPU time in milliseconds; frames without one are skipped
+    void Update(float gpuMs);
+    // Back to the full scale, forgetting the measured times
+    void Reset();
+
+    float GetScale() const { return m_Scale; }
+    float GetSmoothedMs() const { return m_SmoothedMs; }
+
+    // The region of a width x height target drawn at scale, at least one pixel a side
+    static glm::uvec2 ScaleSize(uint32 width, uint32 height, float scale);
+
+private:
+    Settings m_Settings;
+    float m_Scale = 1.0f;
+    float m_SmoothedMs = 0.0f;  // 0 until the first Update()
+    uint32 m_HoldFrames = 0;
+};
+
+} // namespace metagfx
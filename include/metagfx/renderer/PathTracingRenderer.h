@@ -0,0 +1,38 @@
+// ============================================================================
+// include/metagfx/renderer/PathTracingRenderer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/renderer/RasterizationRenderer.h"
+
+namespace metagfx {
+
+/**
+ * @brief Path tracing renderer: the progressive reference image of the scene
+ *
+ * Same frame as RasterizationRenderer up to the main pass, which becomes two passes of
+ * the render graph when FrameInputs::pathTracer is ready and toneMapper is set:
+ * - Path tracing: PathTracer::Trace() adds the frame's tiles of samples to the
+ *   accumulation, which the graph imports and keeps across frames
+ * - Main pass: the accumulation copied into the HDR scene color, tone mapped (and
+ *   bloomed, exposed) by the passes after it like the rasterizer's
+ * - Denoise, in place of the main pass when FrameInputs::denoiser is set: the
+ *   accumulation filtered with the tracer's guides into the scene color (Denoiser)
+ *
+ * The tracer reads the rasterizer's materials, textures, geometry pool and top level,
+ * so the modes switch without loading anything. Scenery that is no scene instance (the
+ * ground plane) is not traced. Without a ready tracer the main pass is the forward one.
+ */
+class PathTracingRenderer : public RasterizationRenderer {
+public:
+    explicit PathTracingRenderer(Ref<rhi::GraphicsDevice> device);
+
+    const char* GetName() const override { return "Path tracing"; }
+    RenderMode GetMode() const override { return RenderMode::PathTracing; }
+    bool SupportsFeature(RenderFeature feature) const override;
+
+protected:
+    void RenderMainPass(Scene& scene, Camera& camera) override;
+};
+
+} // namespace metagfx
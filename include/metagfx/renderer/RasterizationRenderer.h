@@ -4,17 +4,269 @@
 #pragma once
 
 #include "metagfx/renderer/Renderer.h"
+#include "metagfx/renderer/RenderGraph.h"
 #include "metagfx/rhi/Pipeline.h"
 #include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/scene/InstanceBuffer.h"
+#include "metagfx/scene/LightProbeVolume.h"
+#include "metagfx/scene/PathTracer.h"
 #include "metagfx/scene/Scene.h"
+#include "metagfx/scene/ShadowMap.h"
+#include "metagfx/scene/ToneMapper.h"
+#include <glm/glm.hpp>
+#include <functional>
 #include <memory>
+#include <vector>
 
 namespace metagfx {
 
-// Rasterization-based renderer with shadow mapping support
-// This is the traditional forward rendering pipeline with PBR and IBL
+namespace rhi {
+    class UniformRingBuffer;
+}
+
+class Model;
+class ShadowAtlas;
+class ShadowMoments;
+class GPUCuller;
+class LodSelector;
+class ObjectPicker;
+class StreamEncoder;
+class DeferredLighting;
+class AutoExposure;
+class AmbientOcclusion;
+class ScreenSpaceReflections;
+class Denoiser;
+class Bloom;
+class ShadingRate;
+class TemporalAA;
+class VisibilityBuffer;
+class WeightedBlendedOIT;
+
+// How the main pass draws the model's blended materials (AlphaMode::Blend)
+enum class TransparencyMode : uint32 {
+    Sorted,          // Back to front over the scene color, after the scenery
+    WeightedBlended  // In any order into weighted sums, composited over it (WeightedBlendedOIT)
+};
+
+// What RecordTransparentDraws() draws the blended materials into
+enum class TransparentTarget : uint32 {
+    SceneColor,    // TransparencyMode::Sorted: alpha blended
+    Accumulation,  // WeightedBlendedOIT::ACCUMULATION_FORMAT
+    Revealage      // WeightedBlendedOIT::REVEALAGE_FORMAT
+};
+
+// What the caller draws in the main pass besides the shadow casters the renderer draws
+// itself: the materials of the scene's model, the scenery around it and an overlay
+class RasterizationContent {
+public:
+    virtual ~RasterizationContent() = default;
+
+    // Sorts the visible batches of the scene's model for the main pass; returns how many
+    // packets RecordModelDraws() then records. The blended materials' packets are queued
+    // apart, back to front, for RecordTransparentDraws() under the given mode.
+    virtual size_t QueueModelDraws(const std::vector<DrawBatch>& drawList, bool gpuCulling,
+                                   TransparencyMode transparency) = 0;
+    // Blended packets of the last QueueModelDraws()
+    virtual size_t GetTransparentPacketCount() const = 0;
+    // Packets [firstPacket, endPacket) into cmd, which starts with no state bound. Called
+    // concurrently for disjoint ranges, each into its own secondary command buffer.
+    virtual void RecordModelDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                  size_t firstPacket, size_t endPacket, uint32& materialChanges) const = 0;
+    // The opaque packets [0, packetCount) of a GPU-culled queue into cmd, which starts
+    // with no state bound, with visibility pipelines through GPUCuller's visibility
+    // commands (VisibilityBufferRenderer)
+    virtual void RecordVisibilityDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                       size_t packetCount) const = 0;
+    // After the model, on the thread that called Render()
+    virtual void RecordSceneryDraws(rhi::CommandBuffer& cmd) = 0;
+    // The blended packets into cmd, which starts with no state bound, inside a pass over
+    // the target with the scene's depth tested but not written; after the scenery
+    virtual void RecordTransparentDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                        TransparentTarget target) const = 0;
+    // Last, inside a render pass over the back buffer without depth: the tone mapping
+    // pass, or one of its own when the frame is not tone mapped
+    virtual void RecordOverlay(rhi::CommandBuffer& cmd) = 0;
+};
+
+/**
+ * @brief Forward renderer: cascaded and atlas shadows, then the lit main pass
+ *
+ * Render() draws the scene's model through a RenderGraph it rebuilds every frame:
+ * GPU culling (or CPU culling through the scene BVH), the shadow cascades and their
+ * EVSM moments, the point and spot light faces of the shadow atlas, the light probes'
+ * updates, the main pass (recorded on several threads for large draw lists, optionally
+ * after a depth prepass of the model, with the blended materials last), weighted blended
+ * transparency, the depth pyramid of the next frame's occlusion
+ * test, the model's motion vectors and temporal anti-aliasing, the next frame's shading
+ * rate image, bloom, the tone mapping of the HDR scene color into the back buffer, and
+ * the overlay.
+ *
+ * The renderer owns no shaders: pipelines, descriptor sets and the shadow systems come
+ * with each frame's FrameInputs, set by SetFrame() before Render(), and the main pass's
+ * materials are drawn through RasterizationContent.
+ */
 class RasterizationRenderer : public Renderer {
 public:
+    // Binding 0 of the shadow set, pushed per cascade and atlas face
+    struct ShadowPassUBO {
+        glm::mat4 lightSpaceMatrix;  // ShadowMap::GetCascadeMatrix()
+        glm::mat4 model;
+        uint32 vertexFormat = 0;  // VertexFormat of the model: the pulled pipeline's layout
+    };
+
+    // Binding 0 of the depth prepass set: the prefix of the main pass's uniforms, so the
+    // prepass computes the same positions
+    struct DepthPrepassUBO {
+        glm::mat4 model;  // With the dequantization of compact models
+        glm::mat4 view;
+        glm::mat4 projection;
+        glm::mat4 viewProjection;  // projection * view, as the main pass multiplies it
+    };
+
+    // Binding 0 of the motion vector set: the depth prepass's uniforms, then the last
+    // frame's matrices (motion_vectors.vert)
+    struct MotionVectorUBO {
+        glm::mat4 model;                   // With the dequantization of compact models
+        glm::mat4 view;
+        glm::mat4 projection;              // Jittered
+        glm::mat4 viewProjection;          // Likewise
+        glm::mat4 previousModel;
+        glm::mat4 previousViewProjection;  // Unjittered
+    };
+
+    // Depth-only draws of the model use the pipeline of its vertex layout, or of its
+    // position stream when the mesh has one and that pipeline exists. A pulled pipeline
+    // fetches the vertices of a pooled model of either layout from the set's storage
+    // buffer instead (vertex pulling); it is preferred when set.
+    struct DepthOnlyPipelines {
+        Ref<rhi::Pipeline> full;
+        Ref<rhi::Pipeline> compact;
+        Ref<rhi::Pipeline> position;
+        Ref<rhi::Pipeline> compactPosition;
+        Ref<rhi::Pipeline> pulled;
+    };
+
+    // One frame: where it is recorded and what its passes use. Systems are owned by the
+    // caller; a null one skips its passes.
+    struct FrameInputs {
+        Ref<rhi::CommandBuffer> commandBuffer;  // Recording, outside any render pass
+        // FrameContext::computeCommandBuffer, recording: the graph's async compute passes
+        // (culling) go to it, and the caller submits it before commandBuffer when
+        // GetRenderGraph().GetAsyncPassCount() is not 0. Null runs them on commandBuffer.
+        Ref<rhi::CommandBuffer> computeCommandBuffer;
+        Ref<rhi::Texture> backBuffer;
+        uint32 frameIndex = 0;                  // FrameContext::frameIndex
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+        uint32 frameUniformOffset = 0;          // Binding 0 of the main sets, with the plain model matrix
+        RasterizationContent* content = nullptr;
+
+        rhi::UniformRingBuffer* uniformRing = nullptr;  // Frame slice begun
+        InstanceBuffer* instanceBuffer = nullptr;       // Frame slice begun
+        ShadowMap* shadowMap = nullptr;                 // Cascades fitted for the frame camera
+        ShadowAtlas* shadowAtlas = nullptr;             // Updated for the frame camera
+        ShadowMoments* shadowMoments = nullptr;
+        GPUCuller* gpuCuller = nullptr;
+        // Picks a level of detail per mesh instance for the camera, and a coarser one for
+        // the shadow casters; null draws the full meshes
+        LodSelector* lodSelector = nullptr;
+        // DeferredRenderer: lights the G-buffer the content's model draws fill. Null falls
+        // back to the forward main pass, with the content drawing lit materials.
+        DeferredLighting* deferredLighting = nullptr;
+        // DeferredRenderer: occludes the lighting pass's ambient light, from the G-buffer
+        // pass's depth; accumulates over frames with temporalAA
+        AmbientOcclusion* ambientOcclusion = nullptr;
+        // DeferredRenderer: reflects the G-buffer pass's depth through gpuCuller's depth
+        // pyramid, over the environment map; accumulates over frames with temporalAA
+        ScreenSpaceReflections* reflections = nullptr;
+        // VisibilityBufferRenderer: resolves the triangle ids its pass draws into the
+        // G-buffer, from the frame constants at modelUniformOffset. Null, or without GPU
+        // culling, falls back to the G-buffer pass.
+        VisibilityBuffer* visibilityBuffer = nullptr;
+        uint32 modelUniformOffset = 0;  // Binding 0 of the main sets, as the content's model draws bind it
+        // PathTracingRenderer: traces the scene into its accumulation, which replaces the
+        // main pass's draws, from pathTraceView. Null, or not ready, falls back to the
+        // forward main pass.
+        PathTracer* pathTracer = nullptr;
+        PathTracer::View pathTraceView;
+        // PathTracingRenderer: filters the accumulation while it has few samples, in place
+        // of the composite; null composites it as it is
+        Denoiser* denoiser = nullptr;
+        // Traces the frame's share of the irradiance probes ahead of the lit passes,
+        // which read them through their sets; needs a ray-traced scene (ready)
+        LightProbeVolume* lightProbes = nullptr;
+        LightProbeVolume::View lightProbeView;
+        // The main pass renders linear color into an HDR scene color, which this exposes
+        // and tone maps into the back buffer. Null renders into the back buffer, with
+        // pipelines that tone map themselves.
+        ToneMapper* toneMapper = nullptr;
+        ToneMapper::Settings toneMapping;
+        // Accumulates the jittered scene color over frames, with the model's motion
+        // vectors drawn by motionVectorPipelines. Needs a tone mapper; the caller jitters
+        // the camera (TemporalAA::GetJitter()).
+        TemporalAA* temporalAA = nullptr;
+        // Over 1, the passes up to temporal AA render at TemporalAA::GetInputSize() of the
+        // back buffer and temporal AA upscales their scene color; needs temporalAA
+        float upscale = 1.0f;
+        // Below 1, those passes draw only the top-left region of their targets, this
+        // fraction of each side (DynamicResolution), and temporal AA upscales the region;
+        // needs temporalAA
+        float renderScale = 1.0f;
+        Bloom* bloom = nullptr;                         // Blends its bloom into the scene color; needs a tone mapper
+        // The forward main pass shades by the rates the last frame generated, and this
+        // frame generates the next frame's from its scene color (and motion, with
+        // temporalAA). Needs a tone mapper.
+        ShadingRate* shadingRate = nullptr;
+        // Measures the scene color's exposure for the tone mapping pass, with
+        // toneMapping.exposure compensating it. Needs a tone mapper.
+        AutoExposure* autoExposure = nullptr;
+        float deltaTime = 0.0f;                         // Seconds since the last frame, for its adaptation
+        // Called last in the frame's graph, outside any render pass, with its final image in
+        // ResourceState::TransferRead, to copy it out (ReadbackPool::ReadTexture()):
+        // captureHDR hands over the linear scene color after bloom, at the back buffer's
+        // size, rather than the back buffer. Without a tone mapper both are the back buffer.
+        std::function<void(rhi::CommandBuffer&, const Ref<rhi::Texture>&)> capture;
+        bool captureHDR = false;
+        // Converts the final back buffer to NV12 after the overlay and reads it back for
+        // streaming; the back buffer must be sampleable (offscreen swap chains)
+        StreamEncoder* streamEncoder = nullptr;
+
+        DepthOnlyPipelines shadowPipelines;             // Shadow casters, depth-biased
+        Ref<rhi::DescriptorSet> shadowDescriptorSet;    // Binding 0: ShadowPassUBO
+        Ref<rhi::Pipeline> shadowClearPipeline;         // Writes the far plane over an atlas tile
+        Ref<rhi::Buffer> shadowClearQuad;
+        uint32 shadowClearInstance = 0;                 // Instance of an identity node
+        // Depth-only pipelines of the main pass's formats, with color writes off
+        DepthOnlyPipelines depthPrepassPipelines;
+        Ref<rhi::DescriptorSet> depthPrepassDescriptorSet;  // Binding 0: DepthPrepassUBO
+        // Position-only pipelines into a TemporalAA::MOTION_VECTOR_FORMAT target, with
+        // depth tested and written
+        DepthOnlyPipelines motionVectorPipelines;
+        Ref<rhi::DescriptorSet> motionVectorDescriptorSet;  // Binding 0: MotionVectorUBO
+        // Draws the picker's pending request into its ID target with pickPipelines
+        // (pick.vert and pick.frag, of the depth prepass's set) and reads it back
+        ObjectPicker* picker = nullptr;
+        DepthOnlyPipelines pickPipelines;
+
+        bool shadows = true;              // Cascades of the shadow light (the map needs one)
+        bool shadowAtlasActive = true;    // Point and spot light shadows
+        bool sampleShadowMoments = false; // The main pass filters with EVSM
+        bool gpuCulling = true;
+        bool occlusionCulling = true;
+        bool cpuCulling = true;           // BVH culling whenever the GPU does not cull
+        bool singleCopy = true;           // The model is placed once (GPU culling covers that copy)
+        bool parallelRecording = true;
+        bool depthPrepass = false;        // The model's depth before its lit draws
+        // Samples per pixel of the forward main pass, resolved into the scene color, so it
+        // needs a tone mapper; its pipelines (the content's, the depth prepass's) must be
+        // created with it. The deferred renderer ignores it.
+        uint32 msaaSamples = 1;
+        // How the blended materials are drawn. Weighted blended needs oit, a tone mapper
+        // and one sample per pixel; without them they are sorted.
+        TransparencyMode transparency = TransparencyMode::Sorted;
+        WeightedBlendedOIT* oit = nullptr;
+    };
+
     explicit RasterizationRenderer(Ref<rhi::GraphicsDevice> device);
     ~RasterizationRenderer() override;
 
@@ -29,36 +281,152 @@ public:
     RenderMode GetMode() const override { return RenderMode::Rasterization; }
     bool SupportsFeature(RenderFeature feature) const override;
 
-    // Shadow settings
-    void SetShadowsEnabled(bool enabled) { m_EnableShadows = enabled; }
-    bool AreShadowsEnabled() const { return m_EnableShadows; }
-    void SetShadowMapSize(uint32 size);
-    uint32 GetShadowMapSize() const { return m_ShadowMapSize; }
-    void SetShadowBias(float bias) { m_ShadowBias = bias; }
-    float GetShadowBias() const { return m_ShadowBias; }
+    // Inputs of the next Render()
+    void SetFrame(const FrameInputs& frame) { m_Frame = frame; }
+
+    // Of the last Render()
+    const RenderGraph& GetRenderGraph() const { return *m_RenderGraph; }
+    const std::vector<DrawBatch>& GetMainDrawList() const { return m_MainDrawList; }
+    uint32 GetMainInstanceCount() const { return m_MainInstanceCount; }      // Instances in the draw list
+    uint32 GetShadowInstanceCount() const { return m_ShadowInstanceCount; }  // Of all cascades
+    uint32 GetShadowDrawCount() const { return m_ShadowDrawCount; }
+    bool IsShadowMapCached() const { return m_ShadowMapCached; }  // The shadow pass was skipped
+    uint32 GetShadowAtlasFacesRendered() const { return m_ShadowAtlasFacesRendered; }
+    uint32 GetMainMaterialChanges() const { return m_MainMaterialChanges; }  // Material binds
+    uint32 GetMainRecorderCount() const { return m_MainRecorderCount; }      // Threads that recorded the model
+    bool IsDepthPrepassDrawn() const { return m_DepthPrepassDrawn; }  // Asked for, and its pipeline ready
+    bool IsShadingRateApplied() const { return m_ShadingRateApplied; }  // The main pass shaded by a rate image
+
+protected:
+    // Resources of the frame's graph; invalid for the systems that are off
+    struct FrameResources {
+        RenderGraphResource backBuffer;
+        RenderGraphResource sceneColor;  // What the main pass renders into: the back buffer without tone mapping,
+                                         // then temporal AA's output when it upscales
+        RenderGraphResource msaaColor;   // What a multisampled main pass renders into, resolved into the scene color
+        RenderGraphResource exposure;    // AutoExposure's, kept across frames
+        RenderGraphResource depth;       // Multisampled with the main pass
+        RenderGraphResource sceneDepth;  // Of everything in the scene color: the depth buffer in the forward pass
+        RenderGraphResource shadowMap;
+        RenderGraphResource shadowAtlas;
+        RenderGraphResource shadowMoments;
+        RenderGraphResource cameraDraws;
+        RenderGraphResource shadowDraws;
+        RenderGraphResource shadowDrawCount;
+        RenderGraphResource depthPyramid;
+        RenderGraphResource shadingRate;    // ShadingRate's, kept across frames
+        RenderGraphResource motionVectors;  // The model's, with temporal AA
+        RenderGraphResource motionDepth;
+        RenderGraphResource lightProbes;    // LightProbeVolume's, kept across frames
+        RenderGraphResource reflectionColor;  // ScreenSpaceReflections' color history, kept across frames
+    };
+
+    // Main pass draw lists of at least 2 * MIN_PACKETS_PER_RECORDER packets are recorded
+    // by several jobs into secondary command buffers
+    static constexpr size_t MIN_PACKETS_PER_RECORDER = 256;
+    static constexpr uint32 MAX_MODEL_RECORDERS = 8;
+
+    // How the model's draws of a pass are recorded, decided when the pass is added
+    struct ModelPassPlan {
+        bool drawModel = false;
+        size_t packetCount = 0;        // Sorted packets of the content
+        size_t transparentCount = 0;   // Blended packets, drawn after the scenery
+        TransparencyMode transparency = TransparencyMode::Sorted;
+        uint32 recorders = 1;          // Threads recording the packets
+        uint32 prepassUBOOffset = 0;   // DepthPrepassUBO, when m_DepthPrepassDrawn
+    };
 
-private:
     // Rendering passes
+    void BuildDrawLists(Scene& scene, Camera& camera);
     void RenderShadowPass(Scene& scene, Camera& camera);
-    void RenderMainPass(Scene& scene, Camera& camera);
+    void RenderLightProbePass();
+    virtual void RenderMainPass(Scene& scene, Camera& camera);
+    void RenderTemporalAAPass(Camera& camera);
+    void RenderShadingRatePass(Camera& camera);
+    void RenderBloomPass();
+    void RenderToneMapPass();
+    void RenderPickPass(Camera& camera);
+    void RenderCapturePass();
+    void RenderStreamPass();
+    // The pyramid of this frame's depth, once a frame: the next frame's occlusion test
+    // and this frame's reflections read it
+    void ImportDepthPyramid();
+    void RenderDepthPyramidPass();
+    // With TransparencyMode::WeightedBlended: the plan's blended packets into their
+    // accumulation and revealage over depth, then their composite over the scene color
+    void RenderTransparencyPasses(const ModelPassPlan& plan, RenderGraphResource depth);
+
+    // Sorts the content's packets and decides the prepass and the recorders
+    ModelPassPlan PlanModelPass(Camera& camera);
+    // Inside one render pass over target and depthBuffer (both cleared): the prepass and
+    // the model, then with drawScenery the scenery and the sorted blended packets. A
+    // multisampled target resolves into resolveTarget; shadingRate sets the pass's shading
+    // rate image.
+    void RecordModelPass(rhi::CommandBuffer& passCmd, const ModelPassPlan& plan, const Ref<rhi::Texture>& target,
+                         const Ref<rhi::Texture>& depthBuffer, const rhi::ClearValue& colorClear, bool drawScenery,
+                         const Ref<rhi::Texture>& resolveTarget = nullptr,
+                         const Ref<rhi::Texture>& shadingRate = nullptr);
+    // Of the scene color where nothing is drawn: linear when it is tone mapped
+    rhi::ClearValue GetBackgroundClear() const;
+    // Of the region drawn, which the passes before an upscale render at
+    void SetFullViewport(rhi::CommandBuffer& cmd) const;
 
-    // Pipeline management
-    void CreatePipelines();
-    void DestroyPipelines();
+    Ref<rhi::Pipeline> SelectDepthOnlyPipeline(const DepthOnlyPipelines& pipelines,
+                                               Ref<rhi::Buffer>& positionBuffer) const;
+    // Batches of drawList with depth-only pipelines; uboOffset is the view's binding 0.
+    // With cameraDraws each batch draws its mesh's command of the culling pass, and with
+    // pushMeshIndex pushes its mesh index to the fragment stage first (pick.frag).
+    uint32 RecordDepthOnly(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                           const DepthOnlyPipelines& pipelines, const Ref<rhi::DescriptorSet>& descriptorSet,
+                           uint32 uboOffset, const Ref<rhi::Buffer>& cameraDraws = nullptr,
+                           bool pushMeshIndex = false) const;
+    // The model as its main pass draws it, with depth-only pipelines
+    void RecordCameraDepthOnly(rhi::CommandBuffer& cmd, const DepthOnlyPipelines& pipelines,
+                               const Ref<rhi::DescriptorSet>& descriptorSet, uint32 uboOffset) const;
 
-    // Shadow mapping (will be added in Phase 2)
-    // std::unique_ptr<ShadowMap> m_ShadowMap;  // TODO: Add in Phase 2
-    Ref<rhi::Pipeline> m_ShadowPipeline;
-    bool m_EnableShadows = true;
-    uint32 m_ShadowMapSize = 2048;
-    float m_ShadowBias = 0.005f;
+    std::unique_ptr<RenderGraph> m_RenderGraph;  // Owns the depth buffer
+    FrameInputs m_Frame;
+    FrameResources m_Resources;
+    Model* m_Model = nullptr;  // The scene's, while it is valid
+    bool m_CompactModel = false;
+    bool m_GPUCulling = false;
+    bool m_CPUCulling = false;
+    bool m_CoarserLods = false;  // Some draw of the frame takes a coarser level of detail
+    glm::mat4 m_CullViewProjection = glm::mat4(1.0f);  // Vulkan-convention camera matrix
+    // The last frame's, for the motion vectors
+    glm::mat4 m_PreviousViewProjection = glm::mat4(1.0f);  // Unjittered
+    glm::mat4 m_PreviousView = glm::mat4(1.0f);            // For the ambient occlusion's history
+    glm::mat4 m_PreviousModelMatrix = glm::mat4(1.0f);     // With the dequantization of compact models
+    bool m_HasPreviousFrame = false;
+    uint64 m_CasterHash = 0;  // Keys the shadow map cache
 
-    // Main rendering pipeline (will be moved from Application)
-    Ref<rhi::Pipeline> m_MainPipeline;
+    // Draw lists hold instanced batches and keep their capacity
+    std::vector<DrawBatch> m_MainDrawList;
+    std::vector<DrawBatch> m_ShadowDrawLists[ShadowMap::MAX_CASCADES];  // Casters of each cascade
+    std::vector<DrawBatch> m_ShadowAtlasDrawList;  // Casters of the shadow atlas face being drawn
+    std::vector<uint32> m_VisibleInstances;        // Scene BVH query scratch
+    std::vector<uint8> m_MeshCameraLods;           // Per mesh of the model, for the culling pass
+    std::vector<uint8> m_MeshShadowLods;
+    uint32 m_MainInstanceCount = 0;
+    uint32 m_ShadowInstanceCount = 0;
+    uint32 m_ShadowDrawCount = 0;
+    bool m_ShadowMapCached = false;
+    uint32 m_ShadowAtlasFacesRendered = 0;
+    uint32 m_MainMaterialChanges = 0;
+    uint32 m_MainRecorderCount = 0;
+    bool m_DepthPrepassDrawn = false;
+    bool m_ShadingRateApplied = false;
+    bool m_DepthPyramidBuilt = false;  // The frame's pyramid pass is added
+    bool m_ToneMapped = false;  // The main pass renders into an HDR scene color
+    uint32 m_MSAASamples = 1;   // Of the main pass's attachments
 
     // Viewport dimensions
     uint32 m_Width = 0;
     uint32 m_Height = 0;
+    uint32 m_RenderWidth = 0;   // Of the frame's passes before temporal AA upscales to the viewport
+    uint32 m_RenderHeight = 0;
+    uint32 m_RegionWidth = 0;   // Of the render size, drawn in its top-left corner: dynamic resolution
+    uint32 m_RegionHeight = 0;
 };
 
 } // namespace metagfx
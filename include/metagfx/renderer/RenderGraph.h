@@ -0,0 +1,226 @@
+// ============================================================================
+// include/metagfx/renderer/RenderGraph.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/FrameArena.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+#include <functional>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+    class GraphicsDevice;
+}
+
+// Texture or buffer of a RenderGraph, valid until the graph's next Reset()
+struct RenderGraphResource {
+    uint32 index = ~0u;
+
+    bool IsValid() const { return index != ~0u; }
+};
+
+/**
+ * @brief One frame's passes, synchronized by the resources they declare
+ *
+ * Every frame the renderer imports its textures and buffers with the state they are in
+ * and the state to leave them in, then adds its passes. A pass's setup declares what it
+ * reads and writes; its execute function records the commands. Compile() then:
+ *
+ * - culls the passes nothing needs: a pass survives when it has side effects or writes
+ *   an output, or a resource a later surviving pass reads;
+ * - plans, for each surviving pass, one ResourceBarrier() with the state changes and
+ *   hazards of all its accesses, and one after the last pass back to the final states.
+ *
+ * Passes keep the order they were added in, so a read sees the writes of the passes
+ * added before it. Attachment states are entered by the pass's own BeginRendering()
+ * (see rhi::ResourceState); the graph only tracks that the resource is in it afterwards.
+ * Execute() records each pass in a GPU profiler zone named after it.
+ *
+ * Textures the frame does not keep are created by the graph (CreateTexture()) rather
+ * than imported. Compile() allocates them from a pool it keeps across frames: textures
+ * of the same description whose passes do not overlap share one allocation, and a
+ * texture only rendered to inside a single pass never leaves tile memory where the
+ * device allows it.
+ *
+ * Compute passes added with AddAsyncComputePass() run on the device's async compute
+ * queue (DeviceInfo::supportsAsyncCompute) while the graphics passes before their
+ * results are needed overlap them. Such a pass stays async only if no surviving graphics
+ * pass added before it touches its resources, since the compute queue only waits for
+ * earlier submissions, not for the frame's; otherwise it runs in its place like any
+ * other. Async passes are recorded first, and the graphics command buffer waits for them
+ * (CommandBuffer::WaitForAsyncCompute()) before the first pass or final barrier that
+ * touches a resource of theirs. Created textures of async passes are not aliased.
+ */
+class RenderGraph {
+public:
+    class PassBuilder {
+    public:
+        // One access per resource and pass: declaring a resource again merges the two,
+        // and a write's state wins over a read's. Invalid resources (features that are
+        // off and imported nothing) are ignored.
+        void Read(RenderGraphResource resource, rhi::ResourceState state);
+        void Write(RenderGraphResource resource, rhi::ResourceState state);
+        // Keep the pass although nothing reads what it writes, e.g. for the next frame
+        void SetSideEffects();
+
+    private:
+        friend class RenderGraph;
+        PassBuilder(RenderGraph& graph, uint32 pass) : m_Graph(graph), m_Pass(pass) {}
+
+        void Access(RenderGraphResource resource, rhi::ResourceState state, bool write);
+
+        RenderGraph& m_Graph;
+        uint32 m_Pass;
+    };
+
+    using SetupFunction = std::function<void(PassBuilder&)>;
+    using ExecuteFunction = std::function<void(rhi::CommandBuffer&)>;
+
+    explicit RenderGraph(Ref<rhi::GraphicsDevice> device);
+    ~RenderGraph();
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // Names are kept by pointer (string literals); a final state of Undefined leaves the
+    // resource in whatever state its last pass used it in
+    RenderGraphResource ImportTexture(const char* name, Ref<rhi::Texture> texture,
+                                      rhi::ResourceState initialState, rhi::ResourceState finalState);
+    RenderGraphResource ImportBuffer(const char* name, Ref<rhi::Buffer> buffer,
+                                     rhi::ResourceState initialState, rhi::ResourceState finalState);
+
+    // A texture whose contents start undefined at its first pass and are dropped after
+    // its last. The texture gets the usages its passes declare on top of desc.usage (the
+    // usages no pass state stands for, such as a platform upscaler's), plus
+    // TextureUsage::Transient when a single pass uses it, as attachment only.
+    RenderGraphResource CreateTexture(const char* name, const rhi::TextureDesc& desc);
+
+    // Imported, or for created textures allocated by Compile() (null while culled)
+    Ref<rhi::Texture> GetTexture(RenderGraphResource resource) const;
+    // For an attachment of the executing pass: StoreOp::DontCare when it is a created
+    // texture no later pass uses, whose contents are dropped anyway; otherwise Store
+    rhi::StoreOp GetStoreOp(RenderGraphResource resource) const;
+
+    // setup runs now, execute in Execute() unless the pass is culled
+    void AddPass(const char* name, const SetupFunction& setup, ExecuteFunction execute);
+    // A compute pass that may run on the async compute queue (see above)
+    void AddAsyncComputePass(const char* name, const SetupFunction& setup, ExecuteFunction execute);
+    // Off: async compute passes run in their place on the graphics queue. On by default;
+    // has no effect without device support.
+    void SetAsyncComputeEnabled(bool enabled);
+    bool IsAsyncComputeEnabled() const { return m_AsyncComputeEnabled; }
+
+    // Contents used after the graph (presented, or kept for later frames)
+    void MarkOutput(RenderGraphResource resource);
+
+    void Compile();
+    // Records the surviving passes and their barriers; outside any render pass. The async
+    // compute passes go to computeCmd, begun and submitted by the caller with
+    // GraphicsDevice::SubmitComputeCommandBuffer() before cmd; without one, to cmd.
+    void Execute(rhi::CommandBuffer& cmd, rhi::CommandBuffer* computeCmd = nullptr);
+
+    // Drops the passes and resources, for the next frame. Pooled textures stay until
+    // no frame in flight used them.
+    void Reset();
+    // Per-frame scratch memory for the passes, freed by Reset()
+    FrameArena& GetFrameArena() { return m_Arena; }
+    // Also drops the pooled textures; call once the GPU is idle
+    void ReleaseTextures();
+
+    // Of the last Compile(); the passes until Reset()
+    uint32 GetPassCount() const { return static_cast<uint32>(m_Passes.size()); }
+    const char* GetPassName(uint32 pass) const { return m_Passes[pass].name; }
+    bool IsPassCulled(uint32 pass) const { return m_Passes[pass].culled; }
+    uint32 GetCulledPassCount() const { return m_CulledPassCount; }
+    bool IsPassAsync(uint32 pass) const { return m_Passes[pass].async; }
+    uint32 GetAsyncPassCount() const { return m_AsyncPassCount; }  // On the async compute queue
+    uint32 GetBarrierCount() const { return m_BarrierCount; }        // ResourceBarrier() calls
+    uint32 GetTransitionCount() const { return m_TransitionCount; }  // Texture and buffer barriers in them
+    uint32 GetCreatedTextureCount() const { return m_CreatedTextureCount; }  // Allocated, of CreateTexture()
+    uint32 GetPooledTextureCount() const { return static_cast<uint32>(m_TexturePool.size()); }
+    uint32 GetMemorylessTextureCount() const { return m_MemorylessTextureCount; }  // In tile memory only
+
+private:
+    struct Resource {
+        const char* name = nullptr;
+        Ref<rhi::Texture> texture;
+        Ref<rhi::Buffer> buffer;
+        rhi::ResourceState initialState = rhi::ResourceState::Undefined;
+        rhi::ResourceState finalState = rhi::ResourceState::Undefined;
+        bool output = false;
+        bool created = false;   // By CreateTexture(); texture is set by Compile()
+        rhi::TextureDesc desc;  // Of a created texture
+        uint32 lastPass = 0;    // Of a created texture: the last surviving pass using it
+    };
+
+    // Texture of the pool; the state is where the last pass that used it left it
+    struct PooledTexture {
+        rhi::TextureDesc desc;
+        Ref<rhi::Texture> texture;
+        rhi::ResourceState state = rhi::ResourceState::Undefined;
+        uint64 lastUsedFrame = 0;
+        uint32 freeFromPass = 0;  // This frame: first pass after its last user
+    };
+
+    struct ResourceAccess {
+        uint32 resource = 0;
+        rhi::ResourceState state = rhi::ResourceState::Undefined;
+        bool write = false;
+    };
+
+    // Barriers recorded before a pass: ranges of m_TextureBarriers and m_BufferBarriers
+    struct BarrierBatch {
+        uint32 firstTexture = 0;
+        uint32 textureCount = 0;
+        uint32 firstBuffer = 0;
+        uint32 bufferCount = 0;
+    };
+
+    struct Pass {
+        const char* name = nullptr;
+        std::pmr::vector<ResourceAccess> accesses;  // From m_Arena
+        ExecuteFunction execute;
+        bool sideEffects = false;
+        bool culled = false;
+        bool asyncCompute = false;  // Added with AddAsyncComputePass()
+        bool async = false;         // Runs on the async compute queue, by Compile()
+        BarrierBatch barriers{};
+    };
+
+    void ScheduleAsyncPasses(std::pmr::vector<bool>& asyncResources);
+    void AllocateTextures(std::pmr::vector<int32>& poolIndices, const std::pmr::vector<bool>& asyncResources);
+    void AddBarrier(uint32 resource, rhi::ResourceState before, rhi::ResourceState after);
+    void RecordBarriers(rhi::CommandBuffer& cmd, const BarrierBatch& batch) const;
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    FrameArena m_Arena;  // Reset with the graph; holds the passes' accesses and Compile()'s scratch
+    // Of the pooled textures, kept apart from longer-lived resources: a resize releases
+    // whole heaps on Metal
+    rhi::ResourceGroup m_ResourceGroup = 0;
+    std::vector<Resource> m_Resources;
+    std::vector<Pass> m_Passes;
+    std::vector<PooledTexture> m_TexturePool;
+    uint64 m_FrameNumber = 0;  // Compile() calls
+    std::vector<rhi::TextureBarrier> m_TextureBarriers;
+    std::vector<rhi::BufferBarrier> m_BufferBarriers;
+    BarrierBatch m_FinalBarriers;  // Back to the final states, after the last pass
+    uint32 m_CulledPassCount = 0;
+    uint32 m_AsyncPassCount = 0;
+    // Pass the graphics command buffer waits for the async passes before; the pass count
+    // for the final barriers, NO_WAIT when nothing after them touches their resources
+    static constexpr uint32 NO_WAIT = ~0u;
+    uint32 m_AsyncWaitPass = NO_WAIT;
+    uint32 m_ExecutingPass = ~0u;  // Graphics pass Execute() is recording
+    bool m_AsyncComputeEnabled = true;
+    uint32 m_BarrierCount = 0;
+    uint32 m_TransitionCount = 0;
+    uint32 m_CreatedTextureCount = 0;
+    uint32 m_MemorylessTextureCount = 0;
+    bool m_Compiled = false;
+};
+
+} // namespace metagfx
@@ -0,0 +1,58 @@
+// ============================================================================
+// include/metagfx/renderer/RenderQueue.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <vector>
+
+namespace metagfx {
+
+// One draw of a RenderQueue. pipeline and material are caller-assigned state ids;
+// draw indexes the caller's own draw list.
+struct DrawPacket {
+    uint64 sortKey = 0;
+    uint32 pipeline = 0;
+    uint32 material = 0;
+    uint32 draw = 0;
+};
+
+/**
+ * @brief Draw packets in a contiguous array, sorted by a 64-bit key
+ *
+ * Opaque keys order by pipeline, then material, then depth front to back, so a pass
+ * walking the sorted packets changes state only when the id differs from the last
+ * bound one, and nearer surfaces reject the hidden fragments behind them. Translucent
+ * packets follow every opaque one, back to front.
+ *
+ *   opaque:      [63] 0 | [62:56] pipeline | [55:32] material | [31:0] depth
+ *   translucent: [63] 1 | [62:31] ~depth   | [30:24] pipeline | [23:0] material
+ *
+ * Depth is a non-negative view distance, clamped to zero; its float bits order like
+ * the value. Sorting is a stable LSD radix sort over the key bytes that vary.
+ */
+class RenderQueue {
+public:
+    static constexpr uint32 MAX_PIPELINES = 1u << 7;
+    static constexpr uint32 MAX_MATERIALS = 1u << 24;
+
+    void Clear() { m_Packets.clear(); }
+    void Reserve(size_t count) { m_Packets.reserve(count); }
+
+    // Ids are truncated to MAX_PIPELINES / MAX_MATERIALS
+    void Add(uint32 pipeline, uint32 material, float depth, uint32 draw, bool translucent = false);
+
+    void Sort();
+
+    const std::vector<DrawPacket>& GetPackets() const { return m_Packets; }
+    size_t GetSize() const { return m_Packets.size(); }
+    bool IsEmpty() const { return m_Packets.empty(); }
+
+    static uint64 MakeSortKey(uint32 pipeline, uint32 material, float depth, bool translucent = false);
+
+private:
+    std::vector<DrawPacket> m_Packets;
+    std::vector<DrawPacket> m_Scratch;  // Radix sort ping-pong buffer
+};
+
+} // namespace metagfx
@@ -15,6 +15,8 @@ class Camera;
 // Rendering mode enumeration
 enum class RenderMode {
     Rasterization,  // Traditional rasterization with shadow maps
+    Deferred,       // Rasterized G-buffer, lit by a compute pass
+    VisibilityBuffer,  // Rasterized triangle ids, resolved into the deferred G-buffer
     Hybrid,         // Rasterization + ray traced effects
     PathTracing     // Full path tracing
 };
@@ -27,7 +29,9 @@ enum class RenderFeature {
     RayTracedReflections, // Ray traced reflections
     GlobalIllumination,   // Path traced GI
     AmbientOcclusion,     // SSAO
-    RayTracedAO           // Ray traced AO
+    RayTracedAO,          // Ray traced AO
+    ShadowDebugViews,     // Shadow debug views drawn by the lit pass
+    VariableRateShading   // Coarse shading of flat and fast regions of the main pass
 };
 
 // Abstract renderer base class
@@ -0,0 +1,37 @@
+// ============================================================================
+// include/metagfx/renderer/VisibilityBufferRenderer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/renderer/DeferredRenderer.h"
+
+namespace metagfx {
+
+/**
+ * @brief Visibility buffer renderer: triangle ids rasterized, the G-buffer resolved from them
+ *
+ * DeferredRenderer's frame, with its G-buffer pass split in two when
+ * FrameInputs::visibilityBuffer is set and the GPU culls the model:
+ * - Visibility pass: the content's opaque packets (RecordVisibilityDraws()) write each
+ *   pixel's triangle id and the frame's depth buffer
+ * - Visibility resolve: VisibilityBuffer::Resolve() shades each covered pixel's material
+ *   once into the G-buffer, grouped by material
+ *
+ * The lighting, ambient occlusion, reflections and composite follow unchanged. Material
+ * work no longer follows the fragments the model's draws rasterize, which is what dense
+ * meshes of small triangles and heavy overdraw pay for in the G-buffer pass: a pixel's
+ * quad shades once for its visible triangle rather than for every triangle touching it.
+ * Otherwise the G-buffer pass is the deferred one.
+ */
+class VisibilityBufferRenderer : public DeferredRenderer {
+public:
+    explicit VisibilityBufferRenderer(Ref<rhi::GraphicsDevice> device);
+
+    const char* GetName() const override { return "Visibility buffer"; }
+    RenderMode GetMode() const override { return RenderMode::VisibilityBuffer; }
+
+protected:
+    void RenderGBufferPass(const ModelPassPlan& plan, RenderGraphResource gbuffer) override;
+};
+
+} // namespace metagfx
@@ -0,0 +1,120 @@
+// ============================================================================
+// include/metagfx/rhi/AccelerationStructure.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class Buffer;
+class AccelerationStructure;
+
+enum class AccelerationStructureType {
+    BottomLevel,  // Triangles, in the space of the meshes they come from
+    TopLevel      // Placed instances of bottom-level structures
+};
+
+enum class AccelerationStructureFlags : uint32 {
+    None            = 0,
+    AllowUpdate     = 1 << 0,  // Builds may refit the last build in place (AccelerationStructureBuild::update)
+    AllowCompaction = 1 << 1,  // Builds report GetCompactedSize() for CompactAccelerationStructure()
+    PreferFastBuild = 1 << 2   // Over trace speed, for structures rebuilt every frame
+};
+
+inline AccelerationStructureFlags operator|(AccelerationStructureFlags a, AccelerationStructureFlags b) {
+    return static_cast<AccelerationStructureFlags>(static_cast<uint32>(a) | static_cast<uint32>(b));
+}
+
+inline bool HasFlag(AccelerationStructureFlags flags, AccelerationStructureFlags flag) {
+    return (static_cast<uint32>(flags) & static_cast<uint32>(flag)) != 0;
+}
+
+// Indexed triangles of a bottom-level structure, read from buffers created with
+// BufferUsage::AccelerationStructureInput. Indices are 32-bit and relative to the first
+// vertex, as a mesh's draws see them.
+struct AccelerationStructureGeometry {
+    Ref<Buffer> vertexBuffer;
+    uint64 vertexOffset = 0;   // Bytes to the first vertex's position
+    uint32 vertexStride = 0;
+    uint32 vertexCount = 0;
+    // R32G32B32_SFLOAT, or the R16G16B16A16_UNORM of compact vertices where the device
+    // builds from it (CreateAccelerationStructure() returns null otherwise)
+    Format vertexFormat = Format::R32G32B32_SFLOAT;
+    Ref<Buffer> indexBuffer;
+    uint64 indexOffset = 0;    // Bytes to the first index, a multiple of 4
+    uint32 indexCount = 0;
+    bool opaque = true;        // False for alpha-tested surfaces, whose hits shaders confirm
+};
+
+struct AccelerationStructureDesc {
+    AccelerationStructureType type = AccelerationStructureType::BottomLevel;
+    AccelerationStructureFlags flags = AccelerationStructureFlags::None;
+    // Bottom level: the geometry every build reads, which sizes the structure
+    std::vector<AccelerationStructureGeometry> geometries;
+    // Top level: most instances a build may place
+    uint32 maxInstances = 0;
+    const char* debugName = nullptr;
+};
+
+// A bottom-level structure placed in a top-level build
+struct AccelerationStructureInstance {
+    const AccelerationStructure* bottomLevel = nullptr;
+    // Object to world: the top three rows of the matrix, row-major
+    float transform[3][4] = { { 1.0f, 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.0f, 0.0f } };
+    uint32 instanceID = 0;  // Low 24 bits, reported by hits on the instance
+    uint8 mask = 0xFF;      // Hit only by rays whose cull mask shares a bit
+};
+
+// One structure of a CommandBuffer::BuildAccelerationStructures() batch
+struct AccelerationStructureBuild {
+    AccelerationStructure* structure = nullptr;
+    // Refit the last build instead of building anew (AccelerationStructureFlags::AllowUpdate):
+    // the same triangles moved, or the same number of instances moved. Faster, but the
+    // structure traces slower the further things move from where they were built.
+    bool update = false;
+    // Top level: the instances, copied during the call
+    const AccelerationStructureInstance* instances = nullptr;
+    uint32 instanceCount = 0;
+};
+
+/**
+ * @brief Ray tracing acceleration structure (bottom or top level)
+ *
+ * Created by GraphicsDevice::CreateAccelerationStructure() with the storage its
+ * description needs, and built on the GPU by CommandBuffer::BuildAccelerationStructures().
+ * A top-level structure refers to the bottom levels of its last build without owning
+ * them: keep those alive, and retire them through the device, while it may be traced.
+ * A top-level structure keeps one instance region per frame in flight, so build it at
+ * most once per frame.
+ */
+class AccelerationStructure {
+public:
+    virtual ~AccelerationStructure() = default;
+
+    AccelerationStructure(const AccelerationStructure&) = delete;
+    AccelerationStructure& operator=(const AccelerationStructure&) = delete;
+
+    const AccelerationStructureDesc& GetDesc() const { return m_Desc; }
+    AccelerationStructureType GetType() const { return m_Desc.type; }
+    bool IsBuilt() const { return m_Built; }
+
+    // Bytes of the structure's storage
+    virtual uint64 GetSize() const = 0;
+    // Bytes a compacted copy would take, once the GPU has finished a build with
+    // AccelerationStructureFlags::AllowCompaction; 0 until then and without the flag.
+    // Never waits.
+    virtual uint64 GetCompactedSize() = 0;
+
+protected:
+    explicit AccelerationStructure(const AccelerationStructureDesc& desc) : m_Desc(desc) {}
+
+    AccelerationStructureDesc m_Desc;
+    bool m_Built = false;  // Set by the backend's command buffer when it records a build
+};
+
+} // namespace rhi
+} // namespace metagfx
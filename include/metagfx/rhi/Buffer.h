@@ -5,20 +5,66 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include <functional>
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
 
 class Buffer {
 public:
+    // Receives the contents of a MapAsync() read, valid only during the call; data is
+    // nullptr when the buffer could not be mapped
+    using MapCallback = std::function<void(const void* data, uint64 size)>;
+    // Stores the bytes of a WriteData() range through data
+    using WriteCallback = std::function<void(void* data)>;
+
     virtual ~Buffer() = default;
     
+    // May block until the GPU is done with the buffer (WebGPU); prefer MapAsync() to read back
     virtual void* Map() = 0;
     virtual void Unmap() = 0;
+
+    // Reads the contents of a GPUToCPU buffer without blocking. Backends that map in
+    // place call back before returning, so the GPU must already be done writing it (see
+    // ReadbackPool). WebGPU waits for the work submitted before the call and calls back
+    // from the device's event processing in GraphicsDevice::BeginFrame(); the buffer is
+    // unmapped again after the callback.
+    virtual void MapAsync(MapCallback callback) {
+        const void* data = Map();
+        callback(data, data ? GetSize() : 0);
+        if (data) {
+            Unmap();
+        }
+    }
     virtual void CopyData(const void* data, uint64 size, uint64 offset = 0) = 0;
+
+    // CopyData() of bytes the callback writes in place: into the buffer when it is
+    // mapped, into staging memory where the backend stages (Vulkan), so data encoded
+    // on the fly (e.g. quantized vertices) needs no intermediate array. Every byte of
+    // the range must be written.
+    virtual void WriteData(uint64 size, uint64 offset, const WriteCallback& write) {
+        void* mapped = GetMappedPointer();
+        if (mapped && offset + size <= GetSize()) {
+            write(static_cast<uint8*>(mapped) + offset);
+            return;
+        }
+        std::vector<uint8> data(size);
+        write(data.data());
+        CopyData(data.data(), size, offset);
+    }
+
+    // Persistent CPU pointer to the buffer contents, valid for the buffer's lifetime.
+    // Writes need no Map/Unmap or flush. Returns nullptr when the backend cannot expose
+    // one (GPU-only memory, WebGPU); use CopyData() in that case.
+    virtual void* GetMappedPointer() = 0;
     
     virtual uint64 GetSize() const = 0;
     virtual BufferUsage GetUsage() const = 0;
+
+    // True once the last CopyData() has finished on the GPU (poll, never blocks).
+    // Only staged copies into GPU-only memory can be outstanding.
+    virtual bool IsUploadComplete() const { return true; }
     
 protected:
     Buffer() = default;
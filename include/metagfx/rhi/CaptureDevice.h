@@ -0,0 +1,130 @@
+// ============================================================================
+// include/metagfx/rhi/CaptureDevice.h - RHI Command Stream Capture and Replay
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/TraceFormat.h"
+#include "metagfx/rhi/Types.h"
+
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class CommandBuffer;
+
+struct CaptureSettings {
+    std::string path;       // Trace file, overwritten
+    uint32 frameCount = 0;  // Presented frames after which the trace is closed, 0 = until the device is released
+};
+
+// Wraps device so that every call made through it, and the contents given to its buffers
+// and textures, is written to a trace (TraceFormat.h) that TraceReplayer runs on any
+// backend without the application. Created right after the device, before any resource,
+// so the trace holds everything its frames use. Writes to mapped buffers are found by
+// comparing their contents with a copy at each submit, in 256-byte blocks, and only the
+// blocks that changed are written. Contents the GPU writes (render targets, readbacks)
+// are not stored: the replay renders them again.
+//
+// The wrapped device reports the device's DeviceInfo without acceleration structures,
+// ray queries, timestamp queries, async compute and file texture loads, which the trace
+// does not record, so the application takes its paths without them. Only the command
+// buffer counters of GetFrameStats() are filled. Null when the trace cannot be written.
+Ref<GraphicsDevice> CreateCaptureDevice(Ref<GraphicsDevice> device, const CaptureSettings& settings);
+
+// TraceReplayer::ReadInfo(): what a trace was captured on
+struct TraceInfo {
+    GraphicsAPI api = GraphicsAPI::Vulkan;
+    std::string deviceName;
+    uint32 framesInFlight = 2;
+    uint32 width = 0;            // Of the swap chain at the start
+    uint32 height = 0;
+    Format format = Format::Undefined;
+    PresentMode presentMode = PresentMode::Fifo;
+    uint32 frameCount = 0;       // 0 when the capture did not close the trace
+    uint64 fileBytes = 0;
+    std::vector<std::string> features;  // GetFeatureNames() of the capturing device
+};
+
+// Time TraceReplayer::ReplayFrame() took, by kind of record
+struct TraceFrameStats {
+    double cpuMs = 0.0;        // The whole frame, Present included
+    double resourceMs = 0.0;   // Creating and releasing resources and updating descriptor sets
+    double uploadMs = 0.0;     // Buffer and texture contents
+    double recordMs = 0.0;     // Recording the commands
+    double submitMs = 0.0;     // GraphicsDevice::SubmitCommandBuffer()
+    double presentMs = 0.0;    // BeginFrame() and Present(): waiting for the GPU and the display
+    uint32 commands = 0;       // Recorded, secondaries included
+    uint32 submits = 0;
+    uint64 uploadBytes = 0;
+};
+
+// Runs a trace on a device, a frame at a time. The device is created for the trace: with
+// its frames in flight and (for the back buffers) a window of its swap chain size, and
+// should have the features it was captured with, e.g. an offscreen device on a hidden
+// window. Resources are released through GraphicsDevice::Retire() when the trace
+// destroys them and when the replayer is released.
+class TraceReplayer {
+public:
+    TraceReplayer() = default;
+    ~TraceReplayer();
+
+    TraceReplayer(const TraceReplayer&) = delete;
+    TraceReplayer& operator=(const TraceReplayer&) = delete;
+
+    // The header of the trace at path; false when it is not a trace of this version
+    static bool ReadInfo(const std::string& path, TraceInfo& info);
+
+    bool Open(const std::string& path, Ref<GraphicsDevice> device);
+
+    // Replays the records up to and including the next Present. False at the end of the
+    // trace or on a malformed record, after which IsFinished() holds.
+    bool ReplayFrame(TraceFrameStats* stats = nullptr);
+    bool IsFinished() const { return m_Finished; }
+    uint32 GetFrameIndex() const { return m_FrameIndex; }  // Frames replayed
+    const TraceInfo& GetInfo() const { return m_Info; }
+
+    // Releases the trace's resources, waiting for the GPU, and closes it
+    void Close();
+
+private:
+    // false on a malformed record
+    bool ReplayRecord(TraceOp op, TraceReader& payload, TraceFrameStats& stats, bool& present);
+    bool ReplayCommands(CommandBuffer& cmd, TraceReader& commands, TraceFrameStats& stats);
+    void Destroy(TraceObject type, uint32 id);
+
+    template <typename T>
+    Ref<T> Find(const std::unordered_map<uint32, Ref<T>>& objects, uint32 id) const {
+        auto it = objects.find(id);
+        return it != objects.end() ? it->second : nullptr;
+    }
+    DescriptorBindingDesc ReadBinding(TraceReader& reader) const;
+    // Keeps a debug name alive for as long as the replay, as descs only point at theirs
+    const char* Intern(std::string name);
+
+    Ref<GraphicsDevice> m_Device;
+    std::ifstream m_File;
+    std::vector<uint8> m_Record;
+    TraceInfo m_Info;
+    uint32 m_FrameIndex = 0;
+    bool m_Finished = true;
+
+    std::unordered_map<uint32, Ref<Buffer>> m_Buffers;
+    std::unordered_map<uint32, Ref<Texture>> m_Textures;
+    std::unordered_map<uint32, Ref<Sampler>> m_Samplers;
+    std::unordered_map<uint32, Ref<Shader>> m_Shaders;
+    std::unordered_map<uint32, Ref<Pipeline>> m_Pipelines;
+    std::unordered_map<uint32, Ref<Framebuffer>> m_Framebuffers;
+    std::unordered_map<uint32, Ref<DescriptorSet>> m_DescriptorSets;
+    std::unordered_map<uint32, Ref<CommandBuffer>> m_CommandBuffers;
+    std::unordered_set<std::string> m_Names;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -5,6 +5,10 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/rhi/FrameStats.h"
+#include <cstring>
+#include <span>
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
@@ -14,6 +18,12 @@ class Pipeline;
 class DescriptorSet;
 class Buffer;
 class Texture;
+class DrawList;
+class GpuProfiler;
+class AccelerationStructure;
+struct AccelerationStructureBuild;
+class TemporalUpscaler;
+struct TemporalUpscaleFrame;
 
 class CommandBuffer {
 public:
@@ -23,22 +33,56 @@ public:
     virtual void Begin() = 0;
     virtual void End() = 0;
     
-    // Render pass commands
-    virtual void BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                                Ref<Texture> depthAttachment,
-                                const std::vector<ClearValue>& clearValues) = 0;
+    // Render pass commands. actions sets each attachment's load and store ops (a LoadOp
+    // converts, see RenderPassActions). Loaded attachments keep their contents and their
+    // clear value is ignored; a loaded depth attachment must have been rendered before.
+    // Dropping what no later pass reads (StoreOp::DontCare) spares tile-based GPUs the
+    // write back to memory. resolveTargets, one per multisampled color attachment, are
+    // single-sampled textures of its format and size that the pass resolves it into as it
+    // ends; StoreOp::Resolve then drops the samples. A transient multisampled attachment is
+    // never stored, only resolved. Depth is not resolved.
+    // shadingRate, in ResourceState::ShadingRate, sets how coarsely each tile of the pass
+    // is shaded where the device supports it (DeviceInfo::supportsShadingRateImage); it
+    // covers the attachments' size and is ignored elsewhere. The spans are only read
+    // during the call, so callers can pass arrays on their stack.
+    virtual void BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                                const Ref<Texture>& depthAttachment,
+                                std::span<const ClearValue> clearValues,
+                                const RenderPassActions& actions = {},
+                                std::span<const Ref<Texture>> resolveTargets = {},
+                                const Ref<Texture>& shadingRate = nullptr) = 0;
     virtual void EndRendering() = 0;
+
+    // Parallel render pass recording. Begins a pass like BeginRendering() whose contents
+    // are recorded into secondaryCount secondary command buffers, typically one per worker
+    // thread. Each secondary is recorded on any one thread, concurrently with the
+    // others, between its own Begin() and End(); it starts with no state bound, and only
+    // binds, viewport/scissor, push constants and draws may be recorded into it.
+    // EndParallelRendering() then runs them in index order and ends the pass. Nothing
+    // is recorded into this command buffer in between. With
+    // DeviceInfo::supportsParallelRecording false the secondaries must be recorded on
+    // the thread that owns this command buffer.
+    virtual void BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                        const Ref<Texture>& depthAttachment,
+                                        std::span<const ClearValue> clearValues,
+                                        uint32 secondaryCount,
+                                        const RenderPassActions& actions = {},
+                                        std::span<const Ref<Texture>> resolveTargets = {},
+                                        const Ref<Texture>& shadingRate = nullptr) = 0;
+    // Valid until EndParallelRendering(); null past secondaryCount
+    virtual Ref<CommandBuffer> GetSecondaryCommandBuffer(uint32 index) = 0;
+    virtual void EndParallelRendering() = 0;
     
     // Pipeline binding
-    virtual void BindPipeline(Ref<Pipeline> pipeline) = 0;
+    virtual void BindPipeline(const Ref<Pipeline>& pipeline) = 0;
     
     // Viewport and scissor
     virtual void SetViewport(const Viewport& viewport) = 0;
     virtual void SetScissor(const Rect2D& scissor) = 0;
     
     // Vertex and index buffers
-    virtual void BindVertexBuffer(Ref<Buffer> buffer, uint64 offset = 0) = 0;
-    virtual void BindIndexBuffer(Ref<Buffer> buffer, uint64 offset = 0) = 0;
+    virtual void BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) = 0;
+    virtual void BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) = 0;
     
     // Draw commands
     virtual void Draw(uint32 vertexCount, uint32 instanceCount = 1,
@@ -46,24 +90,177 @@ public:
     virtual void DrawIndexed(uint32 indexCount, uint32 instanceCount = 1,
                             uint32 firstIndex = 0, int32 vertexOffset = 0,
                             uint32 firstInstance = 0) = 0;
+
+    // Indirect draws with the bound index buffer. argumentBuffer (BufferUsage::Indirect)
+    // holds drawCount DrawIndexedIndirectCommand records, stride bytes apart, from offset.
+    virtual void DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                                     uint32 stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+
+    // As above, with the draw count read on the GPU from a uint32 in countBuffer, clamped to
+    // maxDrawCount. Without DeviceInfo::supportsDrawIndirectCount all maxDrawCount commands
+    // are drawn, so producers must leave the unused ones at instanceCount = 0.
+    virtual void DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                          const Ref<Buffer>& countBuffer, uint64 countOffset, uint32 maxDrawCount,
+                                          uint32 stride = sizeof(DrawIndexedIndirectCommand)) = 0;
+
+    // The draw list's draws with the bound pipeline, descriptor sets, vertex and index
+    // buffers, as if by DrawIndexedIndirect() over DrawList::GetBuffer() (the default)
+    virtual void ExecuteDrawList(const Ref<DrawList>& drawList);
+
+    // Compute dispatch with the bound compute pipeline, outside BeginRendering()/EndRendering().
+    // Group counts are in work groups; the group size is declared by the shader.
+    virtual void Dispatch(uint32 groupCountX, uint32 groupCountY = 1, uint32 groupCountZ = 1) = 0;
+    // Group counts read from a DispatchIndirectCommand in argumentBuffer (BufferUsage::Indirect)
+    virtual void DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset = 0) = 0;
     
+    // Builds or refits a batch of acceleration structures, outside any render pass: the
+    // bottom levels first, then the top levels, so a batch may build the bottom levels its
+    // top levels place. Waits for earlier shader reads of the structures and makes the
+    // results visible to the shaders and builds recorded after. Structures that cannot be
+    // updated share one scratch allocation per batch, held until the command buffer is
+    // begun again. No-op on devices without acceleration structures (the default).
+    virtual void BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds);
+    // Records a copy of source, built with AccelerationStructureFlags::AllowCompaction,
+    // into a new structure of its GetCompactedSize(), and returns it; null while that size
+    // is unknown (the default). Top levels must be rebuilt to place the copy; retire
+    // source through the device once they are.
+    virtual Ref<AccelerationStructure> CompactAccelerationStructure(const Ref<AccelerationStructure>& source);
+
+    // Encodes one frame of upscaler, outside any render pass: reads frame's color, depth
+    // and motion and writes its output, ordered against the commands around it. False if
+    // nothing was encoded (the default, or textures the upscaler cannot take), which
+    // leaves the output as it was.
+    virtual bool TemporalUpscale(TemporalUpscaler& upscaler, const TemporalUpscaleFrame& frame);
+
     // Copy commands
-    virtual void CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+    virtual void CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                            uint64 size, uint64 srcOffset = 0, uint64 dstOffset = 0) = 0;
+    // Copies the first mip of the first layer of src into dst at dstOffset, rows
+    // GetReadbackRowPitch() apart, outside any render pass. src must be single-sampled,
+    // uncompressed color, with TextureUsage::TransferSrc, and in ResourceState::TransferRead;
+    // dst needs BufferUsage::TransferDst. The default, for backends without it, logs an error.
+    virtual void CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset = 0);
 
-    // Descriptor set binding
-    virtual void BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                                   uint32 frameIndex = 0) = 0;
+    // Descriptor set binding, to set setIndex (< MAX_DESCRIPTOR_SETS) of the pipeline's
+    // layout. dynamicOffsets supplies one byte offset per UniformBufferDynamic binding of
+    // the set, in increasing binding order. Sets stay bound across pipelines whose layouts
+    // agree on them, so a material change only rebinds the per-material set.
+    virtual void BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                   const Ref<DescriptorSet>& descriptorSet, uint32 frameIndex = 0,
+                                   const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0) = 0;
+    // Set 0, which single-set pipelines take
+    void BindDescriptorSet(const Ref<Pipeline>& pipeline, const Ref<DescriptorSet>& descriptorSet,
+                           uint32 frameIndex = 0, const uint32* dynamicOffsets = nullptr,
+                           uint32 dynamicOffsetCount = 0) {
+        BindDescriptorSet(pipeline, 0, descriptorSet, frameIndex, dynamicOffsets, dynamicOffsetCount);
+    }
+
+    // Writes bindings as set setIndex, whose layout in the pipeline is a push descriptor set
+    // (DescriptorSetDesc::pushDescriptors), into the command buffer. The resources are
+    // read when the command buffer is recorded. dynamicOffsets supplies one byte offset per
+    // UniformBufferDynamic binding, in the order of bindings. The default, for devices
+    // without DeviceInfo::supportsPushDescriptors, logs an error.
+    virtual void PushDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                   const std::vector<DescriptorBindingDesc>& bindings,
+                                   const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0);
 
     // Push constants (uniform data pushed directly without descriptor sets)
-    virtual void PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+    virtual void PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                                uint32 offset, uint32 size, const void* data) = 0;
 
-    // Memory barriers (for synchronization between CPU and GPU)
-    virtual void BufferMemoryBarrier(Ref<Buffer> buffer) = 0;
+    // Make GPU writes to the buffer visible to shader reads. Host writes to mapped buffers
+    // are visible at submit and need no barrier.
+    virtual void BufferMemoryBarrier(const Ref<Buffer>& buffer) = 0;
+
+    // Order compute work against other GPU work (see BarrierType)
+    virtual void PipelineBarrier(BarrierType type) = 0;
+
+    // Wait for the accesses of every barrier's before state to finish before those of its
+    // after state, and move textures to the after state's layout; recorded as one barrier
+    // outside any render pass. Backends that track hazards themselves record nothing;
+    // Vulkan takes the source accesses from each resource's tracked state and drops
+    // barriers that would change nothing.
+    virtual void ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                                 const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) = 0;
+
+    // Backends track the bound pipeline, descriptor set, vertex and index buffers,
+    // viewport, scissor and push constant bytes, and drop calls that would not change
+    // them. Call after recording through the native handle (e.g. ImGui's renderer
+    // backends) so the next binds are issued unconditionally.
+    virtual void InvalidateState() = 0;
+
+    // Commands recorded after this start once the frame's async compute work has
+    // finished (GraphicsDevice::SubmitComputeCommandBuffer()); those before run alongside
+    // it. On the frame's primary command buffer, outside any render pass, at most once
+    // per frame. Bound state is lost. The default, without async compute, does nothing.
+    virtual void WaitForAsyncCompute() {}
+
+    // Calls dropped since Begin() because they matched the bound state, including those
+    // of the secondaries this command buffer executed
+    uint32 GetFilteredCallCount() const { return m_FilteredCallCount; }
+
+    // Commands recorded since Begin(), including those of the secondaries this command
+    // buffer executed. Only the command buffer fields of FrameStats are filled.
+    const FrameStats& GetStats() const { return m_Stats; }
+
+    // GPU time of the commands between the two calls, measured by the profiler attached
+    // between GpuProfiler::BeginFrame() and EndFrame(); no-ops otherwise. Zones nest.
+    // Recorded on the primary command buffer, outside parallel render passes.
+    void BeginZone(const char* name);
+    void EndZone();
 
 protected:
     CommandBuffer() = default;
+
+    // Dynamic offsets of the last descriptor set bind
+    struct BoundDynamicOffsets {
+        static constexpr uint32 MAX_OFFSETS = 8;
+        uint32 offsets[MAX_OFFSETS] = {};
+        uint32 count = 0;
+
+        bool Matches(const uint32* values, uint32 valueCount) const {
+            return valueCount == count && (count == 0 || std::memcmp(offsets, values, count * sizeof(uint32)) == 0);
+        }
+        // False when there are too many to track; the bind is then never treated as redundant
+        bool Assign(const uint32* values, uint32 valueCount) {
+            count = valueCount <= MAX_OFFSETS ? valueCount : 0;
+            if (count > 0) {
+                std::memcpy(offsets, values, count * sizeof(uint32));
+            }
+            return valueCount <= MAX_OFFSETS;
+        }
+    };
+
+    // Direct draws; counted as triangle lists
+    void CountDraw(uint32 vertexCount, uint32 instanceCount) {
+        ++m_Stats.drawCalls;
+        m_Stats.triangles += static_cast<uint64>(vertexCount / 3) * instanceCount;
+    }
+    // Adds a secondary's commands when it is executed
+    void AddSecondaryStats(const CommandBuffer& secondary) {
+        m_FilteredCallCount += secondary.m_FilteredCallCount;
+        m_Stats += secondary.m_Stats;
+    }
+
+    uint32 m_FilteredCallCount = 0;
+    FrameStats m_Stats;  // Reset by Begin() with m_FilteredCallCount
+
+private:
+    friend class GpuProfiler;
+    GpuProfiler* m_Profiler = nullptr;
+};
+
+// GPU profiler zone spanning the enclosing scope
+class GpuZoneScope {
+public:
+    GpuZoneScope(CommandBuffer& cmd, const char* name) : m_CommandBuffer(cmd) { m_CommandBuffer.BeginZone(name); }
+    ~GpuZoneScope() { m_CommandBuffer.EndZone(); }
+
+    GpuZoneScope(const GpuZoneScope&) = delete;
+    GpuZoneScope& operator=(const GpuZoneScope&) = delete;
+
+private:
+    CommandBuffer& m_CommandBuffer;
 };
 
 } // namespace rhi
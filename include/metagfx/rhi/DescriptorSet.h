@@ -13,6 +13,7 @@ namespace rhi {
 class Buffer;
 class Texture;
 class Sampler;
+class AccelerationStructure;
 
 // Abstract base class for descriptor sets
 // Vulkan: Wraps VkDescriptorSet and VkDescriptorSetLayout
@@ -23,10 +24,23 @@ public:
     virtual ~DescriptorSet() = default;
 
     // Update a buffer binding
-    virtual void UpdateBuffer(uint32 binding, Ref<Buffer> buffer) = 0;
+    virtual void UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) = 0;
 
     // Update a texture + sampler binding
-    virtual void UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) = 0;
+    virtual void UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) = 0;
+
+    // Update one element of a texture array binding (DescriptorBindingDesc::count > 1).
+    // Passing a null texture releases the element; it must then no longer be sampled.
+    virtual void UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                           const Ref<Texture>& texture, const Ref<Sampler>& sampler) = 0;
+
+    // Update a DescriptorType::AccelerationStructure binding with a top-level structure.
+    // Keep the structure alive while frames in flight may trace it. No-op on devices
+    // without ray queries (the default).
+    virtual void UpdateAccelerationStructure(uint32 binding, const Ref<AccelerationStructure>& structure) {
+        (void)binding;
+        (void)structure;
+    }
 
     // Get the descriptor set for a specific frame (for double/triple buffering)
     // Returns backend-specific handle that can be used with command buffers
@@ -0,0 +1,40 @@
+// ============================================================================
+// include/metagfx/rhi/DrawList.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class Buffer;
+class GraphicsDevice;
+
+// Indexed draws that stay the same from frame to frame, such as one per mesh of a model,
+// replayed with CommandBuffer::ExecuteDrawList(). By default they are drawn as
+// DrawIndexedIndirect() over GetBuffer(); Metal encodes them once into an indirect
+// command buffer instead, which the encoder runs with a single call.
+class DrawList {
+public:
+    // Uploads the commands to a GPU buffer (BufferUsage::Indirect)
+    DrawList(GraphicsDevice& device, const DrawListDesc& desc);
+    virtual ~DrawList() = default;
+
+    DrawList(const DrawList&) = delete;
+    DrawList& operator=(const DrawList&) = delete;
+
+    uint32 GetDrawCount() const { return static_cast<uint32>(m_Commands.size()); }
+    const std::vector<DrawIndexedIndirectCommand>& GetCommands() const { return m_Commands; }
+    // Null when the buffer could not be created
+    const Ref<Buffer>& GetBuffer() const { return m_Buffer; }
+
+private:
+    std::vector<DrawIndexedIndirectCommand> m_Commands;
+    Ref<Buffer> m_Buffer;
+};
+
+} // namespace rhi
+} // namespace metagfx
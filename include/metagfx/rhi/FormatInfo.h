@@ -0,0 +1,50 @@
+// ============================================================================
+// include/metagfx/rhi/FormatInfo.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Storage layout of a format. Uncompressed formats are 1x1 blocks of one texel.
+struct FormatInfo {
+    uint32 blockWidth = 1;
+    uint32 blockHeight = 1;
+    uint32 blockSize = 0;   // Bytes per block (bytes per texel when uncompressed)
+    bool compressed = false;
+};
+
+FormatInfo GetFormatInfo(Format format);
+
+inline bool IsCompressedFormat(Format format) {
+    return GetFormatInfo(format).compressed;
+}
+
+// Bytes of one row of blocks, as used for buffer-to-texture copy row pitches
+uint32 GetFormatRowPitch(Format format, uint32 width);
+
+// Rows of CommandBuffer::CopyTextureToBuffer() start this many bytes apart (WebGPU's
+// bytesPerRow alignment; Vulkan and Metal need less)
+constexpr uint32 READBACK_ROW_ALIGNMENT = 256;
+
+// Bytes between the rows of a texture copied into a buffer, its row pitch aligned
+inline uint32 GetReadbackRowPitch(Format format, uint32 width) {
+    return (GetFormatRowPitch(format, width) + READBACK_ROW_ALIGNMENT - 1) / READBACK_ROW_ALIGNMENT *
+           READBACK_ROW_ALIGNMENT;
+}
+
+// Number of block rows covering 'height' texels
+uint32 GetFormatRowCount(Format format, uint32 height);
+
+// Bytes of one tightly packed 2D image (one mip of one layer)
+uint64 GetFormatImageSize(Format format, uint32 width, uint32 height);
+
+// Bytes of every mip, layer (or depth slice) and sample of a texture, tightly packed;
+// what a backend that reports no allocation sizes counts for it
+uint64 GetTextureSize(const TextureDesc& desc);
+
+} // namespace rhi
+} // namespace metagfx
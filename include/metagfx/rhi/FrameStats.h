@@ -0,0 +1,90 @@
+// ============================================================================
+// include/metagfx/rhi/FrameStats.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <atomic>
+
+namespace metagfx {
+namespace rhi {
+
+// What one frame asked of the backend, from GraphicsDevice::GetFrameStats(). A frame runs
+// from one GraphicsDevice::BeginFrame() to the next: the command buffers submitted in
+// between and the device work done meanwhile (uploads, allocations, ...).
+struct FrameStats {
+    // Recorded into command buffers, secondaries included. Binds and pushes dropped as
+    // redundant (CommandBuffer::InvalidateState()) count in filteredCalls only.
+    uint32 drawCalls = 0;            // Direct and indirect; an indirect draw counts once
+    uint64 triangles = 0;            // Of direct draws, as triangle lists; indirect counts are GPU-side
+    uint32 dispatches = 0;
+    uint32 pipelineBinds = 0;
+    uint32 descriptorSetBinds = 0;
+    uint32 pushConstantCalls = 0;
+    uint32 renderPasses = 0;         // Begun
+    uint32 pipelineBarriers = 0;     // Barrier commands; Vulkan drops transitions that change nothing
+    uint32 filteredCalls = 0;
+
+    // Device work
+    uint32 descriptorUpdates = 0;    // Descriptor writes handed to the API
+    uint64 bufferBytesUploaded = 0;  // Written from the CPU: mapped writes and staged copies
+    uint64 textureBytesUploaded = 0;
+    uint32 renderPassesCreated = 0;  // Native render pass and framebuffer objects
+    uint32 allocations = 0;          // Vulkan device memory blocks; Metal/WebGPU resources
+    uint32 pipelineCompiles = 0;     // Graphics pipelines missing from the pipeline cache, background ones included
+    uint32 uploadWaits = 0;          // Waits of the CPU for a staged upload the GPU had not finished
+
+    FrameStats& operator+=(const FrameStats& other) {
+        drawCalls += other.drawCalls;
+        triangles += other.triangles;
+        dispatches += other.dispatches;
+        pipelineBinds += other.pipelineBinds;
+        descriptorSetBinds += other.descriptorSetBinds;
+        pushConstantCalls += other.pushConstantCalls;
+        renderPasses += other.renderPasses;
+        pipelineBarriers += other.pipelineBarriers;
+        filteredCalls += other.filteredCalls;
+        descriptorUpdates += other.descriptorUpdates;
+        bufferBytesUploaded += other.bufferBytesUploaded;
+        textureBytesUploaded += other.textureBytesUploaded;
+        renderPassesCreated += other.renderPassesCreated;
+        allocations += other.allocations;
+        pipelineCompiles += other.pipelineCompiles;
+        uploadWaits += other.uploadWaits;
+        return *this;
+    }
+};
+
+// Device work counters, owned by the GraphicsDevice and reached by backend objects
+// through their context. Added to from any thread; BeginFrame() takes them.
+struct FrameStatsCounters {
+    std::atomic<uint32> descriptorUpdates{0};
+    std::atomic<uint64> bufferBytesUploaded{0};
+    std::atomic<uint64> textureBytesUploaded{0};
+    std::atomic<uint32> renderPassesCreated{0};
+    std::atomic<uint32> allocations{0};
+    std::atomic<uint32> pipelineCompiles{0};
+    std::atomic<uint32> uploadWaits{0};
+
+    void AddDescriptorUpdates(uint32 count) { descriptorUpdates.fetch_add(count, std::memory_order_relaxed); }
+    void AddBufferUpload(uint64 bytes) { bufferBytesUploaded.fetch_add(bytes, std::memory_order_relaxed); }
+    void AddTextureUpload(uint64 bytes) { textureBytesUploaded.fetch_add(bytes, std::memory_order_relaxed); }
+    void AddRenderPassCreated() { renderPassesCreated.fetch_add(1, std::memory_order_relaxed); }
+    void AddAllocation() { allocations.fetch_add(1, std::memory_order_relaxed); }
+    void AddPipelineCompile() { pipelineCompiles.fetch_add(1, std::memory_order_relaxed); }
+    void AddUploadWait() { uploadWaits.fetch_add(1, std::memory_order_relaxed); }
+
+    // Moves the counts into stats and starts over
+    void Take(FrameStats& stats) {
+        stats.descriptorUpdates += descriptorUpdates.exchange(0, std::memory_order_relaxed);
+        stats.bufferBytesUploaded += bufferBytesUploaded.exchange(0, std::memory_order_relaxed);
+        stats.textureBytesUploaded += textureBytesUploaded.exchange(0, std::memory_order_relaxed);
+        stats.renderPassesCreated += renderPassesCreated.exchange(0, std::memory_order_relaxed);
+        stats.allocations += allocations.exchange(0, std::memory_order_relaxed);
+        stats.pipelineCompiles += pipelineCompiles.exchange(0, std::memory_order_relaxed);
+        stats.uploadWaits += uploadWaits.exchange(0, std::memory_order_relaxed);
+    }
+};
+
+} // namespace rhi
+} // namespace metagfx
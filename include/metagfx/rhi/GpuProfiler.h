@@ -0,0 +1,120 @@
+// ============================================================================
+// include/metagfx/rhi/GpuProfiler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class CommandBuffer;
+
+// GPU time of named zones of the frame, from timestamps the GPU writes into the frame's
+// command buffer. Each FrameContext slot has its own timestamps, read back when the slot
+// comes around again: by then the GPU has finished with it, so reading never stalls, and
+// results lag the frame being recorded by DeviceInfo::framesInFlight frames.
+//
+// Created by GraphicsDevice::CreateGpuProfiler(). Zones are recorded with
+// CommandBuffer::BeginZone()/EndZone() on the frame's primary command buffer and nest.
+// Backends that can only sample between passes (Metal, WebGPU) drop a zone boundary
+// that falls inside a render pass, so zones there should enclose whole passes.
+class GpuProfiler {
+public:
+    static constexpr uint32 MAX_ZONES = 64;              // Per frame; later zones are not timed
+    static constexpr uint32 MAX_QUERIES = MAX_ZONES * 2; // Timestamps per frame slot
+    static constexpr uint32 MAX_HISTORY_FRAMES = 300;    // Resolved frames kept for WriteChromeTrace()
+    static constexpr uint64 INVALID_TIMESTAMP = ~0ull;
+
+    struct Zone {
+        std::string name;
+        uint32 depth = 0;         // Nesting level, 0 outermost
+        double startMs = 0.0;     // From the frame's first timestamp
+        double durationMs = 0.0;
+    };
+
+    struct FrameTimings {
+        uint64 frameNumber = 0;   // BeginFrame() calls before this frame's
+        double gpuStartMs = 0.0;  // On the GPU clock; places the frame in the trace
+        double gpuTimeMs = 0.0;   // First to last timestamp
+        std::vector<Zone> zones;  // In BeginZone() order; zones that could not be timed are left out
+    };
+
+    virtual ~GpuProfiler() = default;
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // Starts profiling the frame recorded into cmd in slot frameIndex: call after
+    // GraphicsDevice::BeginFrame() and cmd.Begin(), before anything else is recorded.
+    // Resolves the frame the slot recorded last time and attaches to cmd for its zones.
+    void BeginFrame(CommandBuffer& cmd, uint32 frameIndex);
+    // Before cmd.End(). Ends zones left open and detaches from cmd.
+    void EndFrame(CommandBuffer& cmd);
+
+    // Latest resolved frame; empty until the first one comes back
+    const FrameTimings& GetLatestFrame() const { return m_LatestFrame; }
+
+    // Writes the resolved frames kept (up to MAX_HISTORY_FRAMES) as Chrome trace event
+    // JSON, for chrome://tracing or Perfetto. False when the file cannot be written.
+    bool WriteChromeTrace(const std::string& path) const;
+
+protected:
+    explicit GpuProfiler(uint32 frameCount);
+
+    // Backend timestamps, numbered from 0 within each frame slot.
+    // Called by BeginFrame() before the slot's first timestamp of the frame
+    virtual void ResetQueries(CommandBuffer& cmd, uint32 frameIndex) = 0;
+    // False when no timestamp can be written at this point of the command buffer
+    virtual bool WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) = 0;
+    // Called by EndFrame() with the number of timestamps written. False when the slot's
+    // timestamps cannot be read back this time, which drops the frame.
+    virtual bool ResolveQueries(CommandBuffer& cmd, uint32 frameIndex, uint32 queryCount) {
+        (void)cmd;
+        (void)frameIndex;
+        (void)queryCount;
+        return true;
+    }
+    // Called by BeginFrame() before anything else, e.g. to start reads of earlier frames
+    virtual void PollReadbacks() {}
+    // The slot's last queryCount timestamps in nanoseconds, INVALID_TIMESTAMP for any the
+    // GPU did not write. False when they are not available without waiting.
+    virtual bool ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) = 0;
+
+private:
+    friend class CommandBuffer;
+
+    void BeginZone(CommandBuffer& cmd, const char* name);
+    void EndZone(CommandBuffer& cmd);
+    uint32 Timestamp(CommandBuffer& cmd);  // Query written, or MAX_QUERIES
+    void Resolve(uint32 frameIndex);
+
+    struct RecordedZone {
+        std::string name;
+        uint32 depth = 0;
+        uint32 beginQuery = MAX_QUERIES;
+        uint32 endQuery = MAX_QUERIES;
+    };
+
+    struct FrameSlot {
+        std::vector<RecordedZone> zones;
+        uint32 queryCount = 0;
+        uint64 frameNumber = 0;
+        bool pending = false;  // Recorded and resolved, not yet read back
+    };
+
+    std::vector<FrameSlot> m_Slots;
+    uint32 m_CurrentSlot = 0;
+    CommandBuffer* m_CommandBuffer = nullptr;  // Between BeginFrame() and EndFrame()
+    std::vector<uint32> m_OpenZones;           // Indices into the current slot's zones
+    uint64 m_FrameNumber = 0;
+
+    FrameTimings m_LatestFrame;
+    std::deque<FrameTimings> m_History;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -5,6 +5,17 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/rhi/FrameStats.h"
+#include "metagfx/rhi/MemoryStats.h"
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
@@ -19,6 +30,34 @@ class CommandBuffer;
 class SwapChain;
 class Framebuffer;
 class DescriptorSet;
+class DrawList;
+class PipelineFuture;
+class GpuProfiler;
+class AccelerationStructure;
+struct AccelerationStructureDesc;
+class TemporalUpscaler;
+struct TemporalUpscalerDesc;
+
+// The frame in flight being recorded. Backends keep one set of per-frame resources for
+// each of the frameCount slots (command pool and command buffer, fence, descriptor set
+// copies) and recycle a slot only once the GPU has finished with it. Rings the
+// application fills on the CPU (UniformRingBuffer, InstanceBuffer, ...) are sized with
+// frameCount and indexed with frameIndex, so their slices share that lifetime.
+struct FrameContext {
+    uint32 frameIndex = 0;              // Slot in [0, frameCount)
+    uint32 frameCount = 1;              // DeviceInfo::framesInFlight
+    Ref<CommandBuffer> commandBuffer;   // The slot's recycled command buffer, reset
+    // The slot's async compute command buffer, reset; null without
+    // DeviceInfo::supportsAsyncCompute
+    Ref<CommandBuffer> computeCommandBuffer;
+};
+
+// GraphicsDevice::GetPipelineCacheStats(), since the device was created
+struct PipelineCacheStats {
+    uint64 hits = 0;       // Requests answered with a shared pipeline or compile
+    uint64 misses = 0;     // Pipelines created
+    uint32 pipelines = 0;  // Held by the cache now
+};
 
 class GraphicsDevice {
 public:
@@ -27,34 +66,223 @@ public:
     // Device information
     virtual const DeviceInfo& GetDeviceInfo() const = 0;
     
-    // Resource creation
+    // Resource creation. Buffers, textures and samplers may be created from any thread
+    // with DeviceInfo::supportsThreadedResourceCreation.
     virtual Ref<Buffer> CreateBuffer(const BufferDesc& desc) = 0;
     virtual Ref<Texture> CreateTexture(const TextureDesc& desc) = 0;
     virtual Ref<Sampler> CreateSampler(const SamplerDesc& desc) = 0;
     virtual Ref<Shader> CreateShader(const ShaderDesc& desc) = 0;
-    virtual Ref<Pipeline> CreateGraphicsPipeline(const PipelineDesc& desc) = 0;
+    // Graphics pipelines are shared: a desc equal to an earlier one (same shader objects,
+    // vertex layout, topology, raster, depth and blend state, attachment formats, sample
+    // count, specialization constants and set layouts; debugName aside) returns the
+    // earlier pipeline. Thread-safe.
+    Ref<Pipeline> CreateGraphicsPipeline(const PipelineDesc& desc);
+    // Compiles on a job system worker and returns at once. Backends that cannot create
+    // pipelines off the calling thread (WebGPU) compile inline and return a ready future.
+    // A request equal to one still compiling gets the same future.
+    Ref<PipelineFuture> CreateGraphicsPipelineAsync(const PipelineDesc& desc);
+    PipelineCacheStats GetPipelineCacheStats() const;
+    // With the set layout of desc.descriptorSetLayout, like CreateGraphicsPipeline()
+    virtual Ref<Pipeline> CreateComputePipeline(const ComputePipelineDesc& desc) = 0;
     virtual Ref<Framebuffer> CreateFramebuffer(const FramebufferDesc& desc) = 0;
     virtual Ref<DescriptorSet> CreateDescriptorSet(const DescriptorSetDesc& desc) = 0;
+    // Draws replayed every frame with CommandBuffer::ExecuteDrawList(); the default keeps
+    // them in an indirect buffer
+    virtual Ref<DrawList> CreateDrawList(const DrawListDesc& desc);
 
-    // Descriptor set layout management (for pipeline creation)
-    // Sets the active descriptor set layout that will be used for subsequent pipeline creation
-    virtual void SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) = 0;
-
-    // Command buffer management
+    // Command buffer management. A command buffer is recorded and released on the thread
+    // that created it.
     virtual Ref<CommandBuffer> CreateCommandBuffer() = 0;
+    // Starts recording the current frame in flight: waits until the GPU is done with the
+    // slot and resets its command buffer. Record and submit that command buffer within
+    // the frame and call BeginFrame() again for the next one.
+    virtual FrameContext BeginFrame() = 0;
     virtual void SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) = 0;
+    // Submits the frame's computeCommandBuffer to the async compute queue, before the
+    // frame's SubmitCommandBuffer(). It starts once every earlier submission to the
+    // graphics queue has finished and runs alongside the frame's graphics work, which
+    // waits for it at CommandBuffer::WaitForAsyncCompute(), or at its end without one.
+    // Compute and copy commands only; the default (no async compute) logs an error.
+    virtual void SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer);
+
+    // Acceleration structure sized for desc's geometry or instances, built with
+    // CommandBuffer::BuildAccelerationStructures(); null without
+    // DeviceInfo::supportsAccelerationStructures or for geometry the device cannot build
+    virtual Ref<AccelerationStructure> CreateAccelerationStructure(const AccelerationStructureDesc& desc);
+
+    // Temporal upscaler of desc's sizes and formats, encoded by
+    // CommandBuffer::TemporalUpscale(); null without DeviceInfo::supportsTemporalUpscaler
+    // or for sizes and formats the platform's upscaler does not take
+    virtual Ref<TemporalUpscaler> CreateTemporalUpscaler(const TemporalUpscalerDesc& desc);
+
+    // GPU timestamp profiler with one set of timestamps per frame in flight; null without
+    // DeviceInfo::supportsTimestampQueries. Release it before the device.
+    virtual Ref<GpuProfiler> CreateGpuProfiler() = 0;
+
+    // Device-local memory budget and usage (see DeviceInfo::supportsMemoryBudget). Cheap
+    // enough to query once a frame; the default reports deviceMemory with no usage.
+    virtual MemoryBudget GetMemoryBudget() const;
+    // The budget with the memory of the device's buffers and textures by category
+    MemoryStats GetMemoryStats() const;
+
+    // A group no resource has joined yet; see ResourceGroupScope
+    ResourceGroup CreateResourceGroup() { return m_NextResourceGroup.fetch_add(1, std::memory_order_relaxed); }
+    // Of the buffers and textures the calling thread creates now
+    static ResourceGroup GetCurrentResourceGroup();
+
+    // Counters of the last finished frame: the command buffers submitted between the last
+    // two BeginFrame() calls and the device work done in between
+    const FrameStats& GetFrameStats() const { return m_FrameStats; }
     
     // Synchronization
     virtual void WaitIdle() = 0;
+
+    // GPU progress as one counter per device: each submission to the queue signals the
+    // next value once the GPU has finished it, and values complete in order. Work that
+    // last used a resource was submitted by the time SignalValue() returned some value,
+    // so the resource can be released once GetCompletedFrameValue() reaches it. Vulkan
+    // counts with a timeline semaphore; the defaults count SubmitCommandBuffer() calls.
+    virtual uint64 SignalValue() const { return m_SignalValue.load(std::memory_order_acquire); }
+    virtual uint64 GetCompletedFrameValue() const { return m_CompletedValue.load(std::memory_order_acquire); }
+    // Blocks until value has completed; values not submitted yet are clamped to SignalValue()
+    virtual void WaitValue(uint64 value);
+
+    // Deferred destruction: keeps the last reference to a resource (buffer, texture,
+    // pipeline, descriptor set, or anything owning them) until the GPU has finished every
+    // submission that may use it. The next BeginFrame() tags it with SignalValue(), and
+    // the first BeginFrame() to find that value completed releases it. Thread-safe.
+    void Retire(Ref<void> resource);
+    template <typename T>
+    void Retire(const std::vector<Ref<T>>& resources) {
+        for (const Ref<T>& resource : resources) {
+            Retire(resource);
+        }
+    }
+    // Releases what the GPU has finished; BeginFrame() calls it. With wait, first waits
+    // for all submitted work, so everything goes (at shutdown, in place of WaitIdle()).
+    void ReleaseRetired(bool wait = false);
     
     // Swap chain
     virtual Ref<SwapChain> GetSwapChain() = 0;
     
 protected:
     GraphicsDevice() = default;
+
+    // Backends create graphics pipelines here, behind the shared pipeline cache; the
+    // async default compiles inline
+    virtual Ref<Pipeline> CompileGraphicsPipeline(const PipelineDesc& desc) = 0;
+    virtual Ref<PipelineFuture> CompileGraphicsPipelineAsync(const PipelineDesc& desc);
+    // Appends what the desc's pipeline compiles against on this device to its cache key,
+    // e.g. the set layouts desc.descriptorSetLayout and extraSetLayouts
+    // resolve to and the swap chain format that Format::Undefined stands for
+    virtual void AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const {
+        (void)desc;
+        (void)key;
+    }
+
+    // Launches a background compile the device waits for in WaitForPipelineCompiles()
+    Ref<PipelineFuture> LaunchPipelineCompile(std::function<Ref<Pipeline>()> compile);
+    // Backend destructors call this before tearing down what the compiles use
+    void WaitForPipelineCompiles();
+    // Backend destructors call this once the GPU is idle, before ReleaseRetired(true)
+    void ReleasePipelineCache();
+
+    // Backends call AddSubmittedStats() for each submitted command buffer and
+    // EndFrameStats() at the start of BeginFrame(). Backend objects add device work to
+    // m_StatsCounters through their context.
+    void AddSubmittedStats(const CommandBuffer& commandBuffer);
+    void EndFrameStats();
+    FrameStatsCounters m_StatsCounters;
+    // Backends without a counter of their own take a value for each submitted command
+    // buffer and complete it from the GPU's completion callback (any thread)
+    uint64 NextSignalValue() { return m_SignalValue.fetch_add(1, std::memory_order_acq_rel) + 1; }
+    void CompleteValue(uint64 value);
+    // Backend buffers and textures add their memory here through their context
+    MemoryCounters m_MemoryCounters;
+
+private:
+    // Shared graphics pipelines by PipelineDesc key (GraphicsDevice.cpp). The shaders are
+    // weak: a key naming a destroyed shader is stale, as its address may be reused.
+    struct CachedPipeline {
+        Ref<PipelineFuture> future;
+        std::weak_ptr<Shader> vertexShader;
+        std::weak_ptr<Shader> fragmentShader;
+        bool hasFragmentShader = false;  // Depth-only pipelines have none
+
+        bool IsStale() const;
+    };
+    Ref<PipelineFuture> FindOrCompileGraphicsPipeline(const PipelineDesc& desc, bool async);
+    void PruneGraphicsPipelines();
+    mutable std::mutex m_GraphicsPipelineMutex;
+    std::unordered_map<std::string, CachedPipeline> m_GraphicsPipelines;
+    size_t m_GraphicsPipelinePruneSize = 64;  // Entries at which stale ones are next dropped
+    PipelineCacheStats m_PipelineCacheStats;
+
+    std::mutex m_PipelineCompileMutex;
+    std::vector<Ref<PipelineFuture>> m_PipelineCompiles;  // Not yet known to be ready
+
+    FrameStats m_PendingStats;  // Of the frame being recorded
+    FrameStats m_FrameStats;
+
+    std::atomic<ResourceGroup> m_NextResourceGroup{1};
+
+    std::atomic<uint64> m_SignalValue{0};
+    std::atomic<uint64> m_CompletedValue{0};
+
+    struct RetiredResources {
+        uint64 signalValue = 0;
+        std::vector<Ref<void>> resources;
+    };
+    std::mutex m_RetireMutex;
+    std::vector<Ref<void>> m_Retiring;          // Since the last ReleaseRetired(), not tagged yet
+    std::deque<RetiredResources> m_Retired;     // Oldest first
+};
+
+// Buffers and textures the calling thread creates while the scope lives join group
+class ResourceGroupScope {
+public:
+    explicit ResourceGroupScope(ResourceGroup group);
+    ~ResourceGroupScope();
+
+    ResourceGroupScope(const ResourceGroupScope&) = delete;
+    ResourceGroupScope& operator=(const ResourceGroupScope&) = delete;
+
+private:
+    ResourceGroup m_Previous = 0;
 };
 
-Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHandle);
+struct GraphicsDeviceDesc {
+    uint32 framesInFlight = 2;                   // Clamped to [1, MAX_FRAMES_IN_FLIGHT]
+    PresentMode presentMode = PresentMode::Fifo; // Initial swap chain mode
+    std::string pipelineCachePath;               // On-disk pipeline cache (Vulkan, Metal, WebGPU), empty = none
+    // Shaders translated at build time (WebGPU: the WGSL table metagfx_add_shaders()
+    // generates); the array must outlive the device
+    const PrecompiledShader* precompiledShaders = nullptr;
+    uint32 precompiledShaderCount = 0;
+    // Back buffers are device-owned textures sized like the window and nothing is
+    // presented, e.g. for benchmarks on a hidden window (Vulkan, Metal)
+    bool offscreen = false;
+    // Index into EnumerateAdapters() of the GPU to run on. DEFAULT_ADAPTER, or a GPU
+    // that cannot render to the window, picks the best one: a discrete GPU over an
+    // integrated over a software one, then the most memory (Vulkan; Metal: the system
+    // default device). WebGPU ignores it.
+    uint32 adapterIndex = DEFAULT_ADAPTER;
+    // Non-empty: the first GPU whose name contains this, ignoring case, in place of
+    // adapterIndex (kept when none matches)
+    std::string adapterName;
+};
+
+Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHandle,
+                                         const GraphicsDeviceDesc& desc = {});
+
+// The GPUs of an API, in the order GraphicsDeviceDesc::adapterIndex counts them. Each
+// device is independent: several may be created, one per GPU (e.g. one process each
+// for batch rendering), but they share no resources.
+std::vector<AdapterInfo> EnumerateAdapters(GraphicsAPI api);
+
+// Short names of the optional features (DeviceInfo::supports*) the device has, for logs
+// and benchmark results
+std::vector<const char*> GetFeatureNames(const DeviceInfo& info);
 
 } // namespace rhi
 } // namespace metagfx
\ No newline at end of file
@@ -0,0 +1,114 @@
+// ============================================================================
+// include/metagfx/rhi/MemoryStats.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+#include <atomic>
+
+namespace metagfx {
+namespace rhi {
+
+// What a resource's memory is for, from how it was created
+enum class MemoryCategory : uint32 {
+    Geometry,      // GPU buffers: vertex, index, storage and indirect
+    Texture,       // Sampled-only textures
+    RenderTarget,  // Attachments and storage textures
+    Staging,       // CPU-visible buffers for copies and readback, upload rings
+    Uniform,       // Uniform buffers
+    AccelerationStructure,  // Ray tracing structures, their scratch and instances
+    Count
+};
+
+inline const char* GetMemoryCategoryName(MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Geometry:     return "Geometry";
+        case MemoryCategory::Texture:      return "Textures";
+        case MemoryCategory::RenderTarget: return "Render targets";
+        case MemoryCategory::Staging:      return "Staging";
+        case MemoryCategory::Uniform:      return "Uniforms";
+        case MemoryCategory::AccelerationStructure: return "Acceleration structures";
+        default:                           return "Unknown";
+    }
+}
+
+inline MemoryCategory GetBufferMemoryCategory(const BufferDesc& desc) {
+    uint32 usage = static_cast<uint32>(desc.usage);
+    if (usage & static_cast<uint32>(BufferUsage::Uniform)) {
+        return MemoryCategory::Uniform;
+    }
+    const uint32 gpuUsages = static_cast<uint32>(BufferUsage::Vertex) | static_cast<uint32>(BufferUsage::Index) |
+                             static_cast<uint32>(BufferUsage::Storage) | static_cast<uint32>(BufferUsage::Indirect);
+    if ((usage & gpuUsages) == 0 || desc.memoryUsage == MemoryUsage::GPUToCPU ||
+        desc.memoryUsage == MemoryUsage::CPUOnly) {
+        return MemoryCategory::Staging;
+    }
+    return MemoryCategory::Geometry;
+}
+
+inline MemoryCategory GetTextureMemoryCategory(const TextureDesc& desc) {
+    const uint32 targetUsages = static_cast<uint32>(TextureUsage::ColorAttachment) |
+                                static_cast<uint32>(TextureUsage::DepthStencilAttachment) |
+                                static_cast<uint32>(TextureUsage::Storage) |
+                                static_cast<uint32>(TextureUsage::ShadingRate);
+    return (static_cast<uint32>(desc.usage) & targetUsages) ? MemoryCategory::RenderTarget : MemoryCategory::Texture;
+}
+
+// Memory of the device's resources by category, from GraphicsDevice::GetMemoryStats()
+struct MemoryStats {
+    static constexpr uint32 CATEGORY_COUNT = static_cast<uint32>(MemoryCategory::Count);
+
+    MemoryBudget budget;                   // As GraphicsDevice::GetMemoryBudget()
+    uint64 bytes[CATEGORY_COUNT] = {};     // What the backend allocated for the resources
+    uint32 resources[CATEGORY_COUNT] = {};
+
+    uint64 GetBytes(MemoryCategory category) const { return bytes[static_cast<uint32>(category)]; }
+    uint32 GetResources(MemoryCategory category) const { return resources[static_cast<uint32>(category)]; }
+
+    uint64 GetTotalBytes() const {
+        uint64 total = 0;
+        for (uint64 categoryBytes : bytes) {
+            total += categoryBytes;
+        }
+        return total;
+    }
+
+    // The driver's usage when it reports one, else the resources tracked
+    uint64 GetUsageBytes() const { return budget.usageBytes > 0 ? budget.usageBytes : GetTotalBytes(); }
+
+    // Usage past fraction of the budget: past 1 the driver starts paging resources out
+    // of device memory, or allocations fail. False with no budget known.
+    bool IsOverBudget(float fraction = 1.0f) const {
+        return budget.budgetBytes > 0 &&
+               static_cast<double>(GetUsageBytes()) > static_cast<double>(budget.budgetBytes) * fraction;
+    }
+};
+
+// Resource memory counters, owned by the GraphicsDevice and reached by backend objects
+// through their context like FrameStatsCounters. Resources add their memory when
+// created and remove it when destroyed, from any thread.
+struct MemoryCounters {
+    std::atomic<uint64> bytes[MemoryStats::CATEGORY_COUNT] = {};
+    std::atomic<uint32> resources[MemoryStats::CATEGORY_COUNT] = {};
+
+    void Add(MemoryCategory category, uint64 size) {
+        bytes[static_cast<uint32>(category)].fetch_add(size, std::memory_order_relaxed);
+        resources[static_cast<uint32>(category)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Remove(MemoryCategory category, uint64 size) {
+        bytes[static_cast<uint32>(category)].fetch_sub(size, std::memory_order_relaxed);
+        resources[static_cast<uint32>(category)].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void Read(MemoryStats& stats) const {
+        for (uint32 category = 0; category < MemoryStats::CATEGORY_COUNT; ++category) {
+            stats.bytes[category] = bytes[category].load(std::memory_order_relaxed);
+            stats.resources[category] = resources[category].load(std::memory_order_relaxed);
+        }
+    }
+};
+
+} // namespace rhi
+} // namespace metagfx
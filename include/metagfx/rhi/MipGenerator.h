@@ -0,0 +1,24 @@
+// ============================================================================
+// include/metagfx/rhi/MipGenerator.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+
+namespace metagfx {
+namespace rhi {
+
+// CPU box-filter mip chain generation. Backends use it for TextureDesc::generateMipmaps
+// when the GPU cannot blit/filter the format (or has no blit path at all).
+// Only uncompressed 8-bit UNORM/sRGB and 32-bit float formats are supported.
+bool IsCPUMipGenerationSupported(Format format);
+
+// Build the full chain from mip 0. mip0 holds arrayLayers tightly packed images.
+// outData receives mipLevels levels in UploadData() order: mip-major, layers inside
+// each mip, mip 0 included. sRGB formats are averaged in linear space.
+bool GenerateMipChainCPU(const void* mip0, uint32 width, uint32 height, uint32 arrayLayers,
+                         uint32 mipLevels, Format format, std::vector<uint8>& outData);
+
+} // namespace rhi
+} // namespace metagfx
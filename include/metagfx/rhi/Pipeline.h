@@ -3,7 +3,12 @@
 // ============================================================================
 #pragma once
 
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+
+#include <atomic>
+#include <functional>
 
 namespace metagfx {
 namespace rhi {
@@ -11,10 +16,43 @@ namespace rhi {
 class Pipeline {
 public:
     virtual ~Pipeline() = default;
+
+    virtual PipelineBindPoint GetBindPoint() const { return PipelineBindPoint::Graphics; }
     
 protected:
     Pipeline() = default;
 };
 
+/**
+ * @brief Pipeline being compiled by GraphicsDevice::CreateGraphicsPipelineAsync()
+ *
+ * Poll IsReady() from the frame loop and keep drawing with a fallback until then.
+ * A ready future whose Get() is null means compilation failed.
+ */
+class PipelineFuture {
+public:
+    // Runs compile as a job; the future is ready once it returns
+    static Ref<PipelineFuture> Launch(std::function<Ref<Pipeline>()> compile);
+    static Ref<PipelineFuture> MakeReady(Ref<Pipeline> pipeline);
+    // Completed by Resolve(), e.g. from a driver callback; Wait() calls poll meanwhile
+    // to let such callbacks run
+    static Ref<PipelineFuture> MakePending(std::function<void()> poll);
+
+    bool IsReady() const { return m_Counter.IsDone() && m_Resolved.load(std::memory_order_acquire); }
+    Ref<Pipeline> Get() const { return IsReady() ? m_Pipeline : nullptr; }
+
+    // Blocks until ready, running queued jobs meanwhile
+    Ref<Pipeline> Wait();
+
+    // Completes a MakePending() future; null for a failed compile
+    void Resolve(Ref<Pipeline> pipeline);
+
+private:
+    JobCounter m_Counter;
+    Ref<Pipeline> m_Pipeline;  // Written by the job before it releases the counter
+    std::atomic<bool> m_Resolved{true};
+    std::function<void()> m_Poll;
+};
+
 } // namespace rhi
 } // namespace metagfx
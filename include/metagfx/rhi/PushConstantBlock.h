@@ -0,0 +1,58 @@
+// ============================================================================
+// include/metagfx/rhi/PushConstantBlock.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/Types.h"
+
+namespace metagfx {
+namespace rhi {
+
+/**
+ * @brief Typed CPU copy of a push constant block, pushed whole in one call
+ *
+ * T mirrors the shader's push_constant block (4-byte scalars, vec4s 16-byte aligned)
+ * and starts at offset 0. Set() marks the block dirty only when a field changes, and
+ * Flush() records a single CommandBuffer::PushConstants of the whole block when dirty.
+ *
+ * Binding a pipeline may drop the pushed values (Metal restarts its staging, Vulkan
+ * for another layout), so call Invalidate() after each BindPipeline.
+ */
+template <typename T>
+class PushConstantBlock {
+public:
+    explicit PushConstantBlock(ShaderStage stages)
+        : m_Stages(stages) {}
+
+    const T& Get() const { return m_Data; }
+
+    template <typename Field>
+    void Set(Field T::*field, const Field& value) {
+        if (!(m_Data.*field == value)) {
+            m_Data.*field = value;
+            m_Dirty = true;
+        }
+    }
+
+    void Invalidate() { m_Dirty = true; }
+
+    // Returns true if the block was pushed
+    bool Flush(CommandBuffer& cmd, const Ref<Pipeline>& pipeline) {
+        if (!m_Dirty) {
+            return false;
+        }
+        cmd.PushConstants(pipeline, m_Stages, 0, sizeof(T), &m_Data);
+        m_Dirty = false;
+        return true;
+    }
+
+private:
+    T m_Data{};
+    ShaderStage m_Stages;
+    bool m_Dirty = true;
+};
+
+} // namespace rhi
+} // namespace metagfx
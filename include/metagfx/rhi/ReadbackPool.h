@@ -0,0 +1,72 @@
+// ============================================================================
+// include/metagfx/rhi/ReadbackPool.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class CommandBuffer;
+
+// Pooled GPUToCPU staging buffers for reading GPU results back without stalling
+// (picking, counters, query data, captured frames). Read() records a copy into a staging buffer in the
+// frame's command buffer. The next BeginFrame() tags it with the device's SignalValue(),
+// and the first BeginFrame() that finds GetCompletedFrameValue() past that value maps the
+// staging buffer with Buffer::MapAsync(). The callback sees the bytes as soon as the GPU
+// has finished the frame, later on WebGPU if the map is still pending. Staging buffers
+// return to the pool after their callback.
+class ReadbackPool {
+public:
+    static constexpr uint64 MIN_BUFFER_SIZE = 256;  // Sizes are rounded up to powers of two from here
+
+    explicit ReadbackPool(Ref<GraphicsDevice> device);
+    ~ReadbackPool() = default;
+
+    ReadbackPool(const ReadbackPool&) = delete;
+    ReadbackPool& operator=(const ReadbackPool&) = delete;
+
+    // Start a frame, after GraphicsDevice::BeginFrame(): maps the reads the GPU has finished
+    void BeginFrame();
+
+    // Copy size bytes at offset of source into a staging buffer, outside render passes.
+    // callback receives them (nullptr if the read failed). False when no staging buffer
+    // could be created; the callback is not called then.
+    bool Read(CommandBuffer& cmd, Ref<Buffer> source, uint64 offset, uint64 size,
+              Buffer::MapCallback callback);
+    // Copy the first mip of source, in ResourceState::TransferRead, into a staging buffer
+    // (CommandBuffer::CopyTextureToBuffer()); callback receives its rows
+    // GetReadbackRowPitch() apart. Same failure as Read().
+    bool ReadTexture(CommandBuffer& cmd, const Ref<Texture>& source, Buffer::MapCallback callback);
+
+    uint32 GetBufferCount() const { return m_BufferCount; }
+
+private:
+    struct Request {
+        Ref<Buffer> staging;
+        uint64 size = 0;
+        Buffer::MapCallback callback;
+        uint64 signalValue = 0;  // Of the submission that copies it, once submitted
+    };
+
+    Ref<Buffer> AcquireStaging(uint64 size);  // Null when none could be created
+
+    // Shared with pending callbacks, which may run after the pool is gone (WebGPU)
+    using FreeBuffers = std::unordered_map<uint64, std::vector<Ref<Buffer>>>;  // By size
+
+    Ref<GraphicsDevice> m_Device;
+    std::vector<Request> m_Recorded;   // Since the last BeginFrame(), not submitted yet
+    std::deque<Request> m_Submitted;   // Oldest first
+    std::shared_ptr<FreeBuffers> m_FreeBuffers;
+    uint32 m_BufferCount = 0;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -20,6 +20,20 @@ public:
     virtual uint32 GetWidth() const = 0;
     virtual uint32 GetHeight() const = 0;
     virtual Format GetFormat() const = 0;
+
+    // Recreates the swap chain with the given mode, or Fifo where it is unsupported;
+    // GetPresentMode() returns the mode in use
+    virtual void SetPresentMode(PresentMode mode) = 0;
+    virtual PresentMode GetPresentMode() const = 0;
+
+    // Blocks until at most maxPendingPresents presented frames are still waiting to reach
+    // the display, so the next frame samples input as late as possible. Returns false
+    // without waiting where the backend cannot observe presentation
+    // (DeviceInfo::supportsPresentWait).
+    virtual bool WaitForPresent(uint32 maxPendingPresents) {
+        (void)maxPendingPresents;
+        return false;
+    }
     
 protected:
     SwapChain() = default;
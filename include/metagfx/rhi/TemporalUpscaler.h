@@ -0,0 +1,74 @@
+// ============================================================================
+// include/metagfx/rhi/TemporalUpscaler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Types.h"
+
+namespace metagfx {
+namespace rhi {
+
+class Texture;
+
+struct TemporalUpscalerDesc {
+    // Of the input textures, whose top-left region of TemporalUpscaleFrame::contentWidth x
+    // contentHeight is drawn each frame, and of the output
+    uint32 inputWidth = 0;
+    uint32 inputHeight = 0;
+    uint32 outputWidth = 0;
+    uint32 outputHeight = 0;
+    Format colorFormat = Format::R16G16B16A16_SFLOAT;
+    Format depthFormat = Format::D32_SFLOAT;
+    Format motionFormat = Format::R16G16_SFLOAT;
+    Format outputFormat = Format::R16G16B16A16_SFLOAT;
+    const char* debugName = nullptr;
+};
+
+// One frame of a CommandBuffer::TemporalUpscale(). The textures are of the upscaler's
+// description; color and depth drawn with a jittered projection (reverse-Z unless
+// depthReversed is false), motion the full motion of each input pixel
+struct TemporalUpscaleFrame {
+    Texture* color = nullptr;
+    Texture* depth = nullptr;
+    Texture* motion = nullptr;
+    Texture* output = nullptr;
+    // The projection's offset this frame, in input pixels with y down as in the textures:
+    // the sample of pixel i lies at i + 0.5 - jitter in the unjittered image
+    float jitterX = 0.0f;
+    float jitterY = 0.0f;
+    // Motion times these is the offset in input pixels from where a pixel is to where it
+    // was in the last frame
+    float motionScaleX = 1.0f;
+    float motionScaleY = 1.0f;
+    // Of the input drawn, its top-left region; 0 takes all of it
+    uint32 contentWidth = 0;
+    uint32 contentHeight = 0;
+    bool depthReversed = true;
+    bool reset = false;  // Discard the history: after a cut, a new scene or a resize
+};
+
+/**
+ * @brief A platform's own temporal upscaler (Metal: MetalFX's temporal scaler)
+ *
+ * Created by GraphicsDevice::CreateTemporalUpscaler() for fixed input and output sizes
+ * and formats, and encoded by CommandBuffer::TemporalUpscale(). It keeps its history
+ * itself, so an upscaler serves one output at a time; create another for a new size.
+ */
+class TemporalUpscaler {
+public:
+    virtual ~TemporalUpscaler() = default;
+
+    TemporalUpscaler(const TemporalUpscaler&) = delete;
+    TemporalUpscaler& operator=(const TemporalUpscaler&) = delete;
+
+    const TemporalUpscalerDesc& GetDesc() const { return m_Desc; }
+
+protected:
+    explicit TemporalUpscaler(const TemporalUpscalerDesc& desc) : m_Desc(desc) {}
+
+    TemporalUpscalerDesc m_Desc;
+};
+
+} // namespace rhi
+} // namespace metagfx
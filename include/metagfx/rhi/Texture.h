@@ -5,6 +5,7 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
@@ -16,10 +17,42 @@ public:
     virtual uint32 GetWidth() const = 0;
     virtual uint32 GetHeight() const = 0;
     virtual Format GetFormat() const = 0;
+    virtual uint32 GetMipLevels() const = 0;
+    virtual uint32 GetSampleCount() const = 0;
 
-    // Upload pixel data to GPU
+    // Upload pixel data to GPU. Backends may complete the copy asynchronously;
+    // the texture can be bound right away and is sampled once the copy has landed.
+    // Data is mip-major (every layer of mip 0, then mip 1, ...), tightly packed. With
+    // TextureDesc::generateMipmaps only mip 0 is passed and the rest is generated.
     virtual void UploadData(const void* data, uint64 size) = 0;
 
+    // UploadData() of levels that lie apart, e.g. in a mapped file that stores them in
+    // another order: levels[i] is uploaded mip i. Backends that stage uploads copy each
+    // level straight into their staging memory; the default packs them for UploadData().
+    virtual void UploadLevels(const TextureLevelData* levels, uint32 levelCount) {
+        if (levelCount == 1) {
+            UploadData(levels[0].data, levels[0].size);
+            return;
+        }
+        std::vector<uint8> packed;
+        for (uint32 i = 0; i < levelCount; ++i) {
+            const uint8* level = static_cast<const uint8*>(levels[i].data);
+            packed.insert(packed.end(), level, level + levels[i].size);
+        }
+        UploadData(packed.data(), packed.size());
+    }
+
+    // Read the data UploadData() would take straight from a file into the texture,
+    // asynchronously and with the same guarantees (DeviceInfo::supportsFileTextureLoads).
+    // Returns false when the backend cannot; the caller then reads and uploads the data.
+    virtual bool LoadFromFile(const TextureFileSource& source) {
+        (void)source;
+        return false;
+    }
+
+    // True once the last UploadData() has finished on the GPU (poll, never blocks)
+    virtual bool IsUploadComplete() const { return true; }
+
 protected:
     Texture() = default;
 };
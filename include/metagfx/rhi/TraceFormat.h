@@ -0,0 +1,202 @@
+// ============================================================================
+// include/metagfx/rhi/TraceFormat.h - RHI Trace Records
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// A trace (CreateCaptureDevice(), TraceReplayer) is a header followed by records, each a
+// TraceOp, its payload size and the payload. Values are stored as they lie in memory
+// (little-endian on every supported platform); resources are named by the IDs the capture
+// gave them, 0 standing for null. A Submit record holds the command buffer's commands as
+// records of their own, and a Secondary record those of one secondary command buffer.
+constexpr uint32 TRACE_MAGIC = 0x5254474D;  // "MGTR"
+// 2: multiview (PipelineDesc and RenderPassActions::viewCount)
+// 3: pipelines name their set 0 layout; SetActiveDescriptorSetLayout records are gone
+constexpr uint32 TRACE_VERSION = 3;
+// The header: magic, version, frame count (written when the trace is closed), API,
+// frames in flight, swap chain width, height, format and present mode, then the device
+// name and the DeviceInfo feature names (GetFeatureNames()) as strings
+constexpr uint64 TRACE_FRAME_COUNT_OFFSET = 8;
+
+enum class TraceOp : uint16 {
+    // Device
+    CreateBuffer = 1,
+    CreateTexture,
+    CreateSampler,
+    CreateShader,
+    CreateGraphicsPipeline,
+    CreateComputePipeline,
+    CreateFramebuffer,
+    CreateDescriptorSet,
+    CreateCommandBuffer,
+    Destroy,
+    BufferData,              // CopyData(), WriteData() and the changed blocks of mapped buffers
+    TextureData,             // UploadData() and UploadLevels()
+    UpdateBuffer,
+    UpdateTexture,
+    UpdateTextureArrayElement,
+    BeginFrame,
+    Submit,
+    WaitIdle,
+    BackBuffer,              // SwapChain::GetCurrentBackBuffer()
+    Present,                 // Ends a frame
+    Resize,
+    SetPresentMode,
+
+    // Command buffer
+    Begin = 100,
+    End,
+    BeginRendering,
+    EndRendering,
+    BeginParallelRendering,
+    Secondary,
+    EndParallelRendering,
+    BindPipeline,
+    SetViewport,
+    SetScissor,
+    BindVertexBuffer,
+    BindIndexBuffer,
+    Draw,
+    DrawIndexed,
+    DrawIndexedIndirect,
+    DrawIndexedIndirectCount,
+    Dispatch,
+    DispatchIndirect,
+    CopyBuffer,
+    CopyTextureToBuffer,
+    BindDescriptorSet,
+    PushDescriptorSet,
+    PushConstants,
+    BufferMemoryBarrier,
+    PipelineBarrier,
+    ResourceBarrier,
+    InvalidateState
+};
+
+// Kind of resource a Destroy record releases
+enum class TraceObject : uint8 {
+    Buffer,
+    Texture,
+    Sampler,
+    Shader,
+    Pipeline,
+    Framebuffer,
+    DescriptorSet,
+    CommandBuffer
+};
+
+// Appends records to a byte stream
+class TraceWriter {
+public:
+    template <typename T>
+    void Write(const T& value) {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+    void WriteBytes(const void* data, uint64 size) {
+        const uint8* bytes = static_cast<const uint8*>(data);
+        m_Bytes.insert(m_Bytes.end(), bytes, bytes + size);
+    }
+    void WriteString(const char* text) {
+        uint32 length = text ? static_cast<uint32>(std::strlen(text)) : 0;
+        Write(length);
+        WriteBytes(text, length);
+    }
+    void WriteString(const std::string& text) { WriteString(text.c_str()); }
+    // Size-prefixed bytes
+    void WriteBlob(const void* data, uint64 size) {
+        Write(size);
+        WriteBytes(data, size);
+    }
+
+    // Starts a record whose size EndRecord() fills in
+    size_t BeginRecord(TraceOp op) {
+        Write(op);
+        size_t sizeOffset = m_Bytes.size();
+        Write(uint32(0));
+        return sizeOffset;
+    }
+    void EndRecord(size_t sizeOffset) {
+        uint32 size = static_cast<uint32>(m_Bytes.size() - sizeOffset - sizeof(uint32));
+        std::memcpy(m_Bytes.data() + sizeOffset, &size, sizeof(size));
+    }
+
+    const std::vector<uint8>& GetBytes() const { return m_Bytes; }
+    bool IsEmpty() const { return m_Bytes.empty(); }
+    void Clear() { m_Bytes.clear(); }
+
+private:
+    std::vector<uint8> m_Bytes;
+};
+
+// Reads what TraceWriter wrote; a read past the end fails the reader and returns zeros
+class TraceReader {
+public:
+    TraceReader() = default;
+    TraceReader(const uint8* data, uint64 size) : m_Data(data), m_Size(size) {}
+
+    template <typename T>
+    T Read() {
+        static_assert(std::is_trivially_copyable_v<T>);
+        T value{};
+        if (const uint8* bytes = ReadBytes(sizeof(T))) {
+            std::memcpy(&value, bytes, sizeof(T));
+        }
+        return value;
+    }
+    // Null when fewer than size bytes are left
+    const uint8* ReadBytes(uint64 size) {
+        if (!m_Valid || size > m_Size - m_Offset) {
+            m_Valid = false;
+            return nullptr;
+        }
+        const uint8* bytes = m_Data + m_Offset;
+        m_Offset += size;
+        return bytes;
+    }
+    std::string ReadString() {
+        uint32 length = Read<uint32>();
+        const uint8* bytes = ReadBytes(length);
+        return bytes ? std::string(reinterpret_cast<const char*>(bytes), length) : std::string();
+    }
+    // A size-prefixed blob; returns its bytes and stores its size
+    const uint8* ReadBlob(uint64& size) {
+        size = Read<uint64>();
+        const uint8* bytes = ReadBytes(size);
+        size = bytes ? size : 0;
+        return bytes;
+    }
+
+    // Reads the next record's op and payload into a reader of its own; false at the end
+    bool NextRecord(TraceOp& op, TraceReader& payload) {
+        if (AtEnd()) {
+            return false;
+        }
+        op = Read<TraceOp>();
+        uint32 size = Read<uint32>();
+        const uint8* bytes = ReadBytes(size);
+        payload = TraceReader(bytes, bytes ? size : 0);
+        return bytes != nullptr;
+    }
+
+    bool AtEnd() const { return !m_Valid || m_Offset >= m_Size; }
+    bool IsValid() const { return m_Valid; }
+
+private:
+    const uint8* m_Data = nullptr;
+    uint64 m_Size = 0;
+    uint64 m_Offset = 0;
+    bool m_Valid = true;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "metagfx/core/Types.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -19,6 +20,7 @@ class Texture;
 class Shader;
 class Pipeline;
 class RenderPass;
+class DescriptorSet;
 
 // ============================================================================
 // Enumerations
@@ -31,13 +33,36 @@ enum class GraphicsAPI {
     WebGPU
 };
 
+// How presented images reach the display. Modes a surface does not support fall back
+// to Fifo, which every backend has.
+enum class PresentMode {
+    Fifo,          // Wait for vblank, queue every frame (vsync)
+    FifoRelaxed,   // Fifo, but a late frame is shown immediately and may tear
+    Mailbox,       // Wait for vblank, newest frame replaces the queued one
+    Immediate      // No wait; may tear
+};
+
+inline const char* GetPresentModeName(PresentMode mode) {
+    switch (mode) {
+        case PresentMode::Fifo:        return "FIFO";
+        case PresentMode::FifoRelaxed: return "FIFO relaxed";
+        case PresentMode::Mailbox:     return "Mailbox";
+        case PresentMode::Immediate:   return "Immediate";
+    }
+    return "Unknown";
+}
+
 enum class BufferUsage {
     Vertex      = 1 << 0,
     Index       = 1 << 1,
     Uniform     = 1 << 2,
     Storage     = 1 << 3,
     TransferSrc = 1 << 4,
-    TransferDst = 1 << 5
+    TransferDst = 1 << 5,
+    Indirect    = 1 << 6,  // Argument or count buffer of indirect draws
+    // Vertices and indices read by acceleration structure builds; only on devices with
+    // DeviceInfo::supportsAccelerationStructures
+    AccelerationStructureInput = 1 << 7
 };
 
 inline BufferUsage operator|(BufferUsage a, BufferUsage b) {
@@ -75,10 +100,12 @@ inline ShaderStage operator&(ShaderStage a, ShaderStage b) {
 // Backend-agnostic descriptor types
 enum class DescriptorType {
     UniformBuffer,
+    UniformBufferDynamic,  // Uniform buffer whose offset is supplied at bind time
     StorageBuffer,
     SampledTexture,      // Texture + sampler combined
     StorageTexture,      // Read/write texture
-    Sampler              // Standalone sampler
+    Sampler,             // Standalone sampler
+    AccelerationStructure  // Top-level structure traced by ray queries (DeviceInfo::supportsRayQuery)
 };
 
 enum class PrimitiveTopology {
@@ -188,7 +215,33 @@ enum class Format {
     D16_UNORM,
     D32_SFLOAT,
     D24_UNORM_S8_UINT,
-    D32_SFLOAT_S8_UINT
+    D32_SFLOAT_S8_UINT,
+
+    // Block-compressed formats (see FormatInfo.h for block sizes)
+    // BC: desktop GPUs and Apple Silicon Macs
+    BC1_RGBA_UNORM,
+    BC1_RGBA_SRGB,
+    BC3_RGBA_UNORM,
+    BC3_RGBA_SRGB,
+    BC4_R_UNORM,
+    BC5_RG_UNORM,
+    BC6H_RGB_UFLOAT,
+    BC7_RGBA_UNORM,
+    BC7_RGBA_SRGB,
+
+    // ETC2: mobile GPUs
+    ETC2_RGB8_UNORM,
+    ETC2_RGB8_SRGB,
+    ETC2_RGBA8_UNORM,
+    ETC2_RGBA8_SRGB,
+
+    // ASTC (LDR): Apple GPUs and mobile
+    ASTC_4x4_UNORM,
+    ASTC_4x4_SRGB,
+    ASTC_6x6_UNORM,
+    ASTC_6x6_SRGB,
+    ASTC_8x8_UNORM,
+    ASTC_8x8_SRGB
 };
 
 enum class TextureType {
@@ -203,7 +256,14 @@ enum class TextureUsage {
     ColorAttachment = 1 << 2,
     DepthStencilAttachment = 1 << 3,
     TransferSrc     = 1 << 4,
-    TransferDst     = 1 << 5
+    TransferDst     = 1 << 5,
+    // With the attachment usages only: the contents live within one render pass, which
+    // clears them and does not store them. Kept in tile memory where the device can
+    // (see DeviceInfo::supportsMemorylessAttachments), an ordinary texture elsewhere.
+    Transient       = 1 << 6,
+    // The shading rate image of render passes (CommandBuffer::BeginRendering()); see
+    // DeviceInfo::supportsShadingRateImage
+    ShadingRate     = 1 << 7
 };
 
 inline TextureUsage operator|(TextureUsage a, TextureUsage b) {
@@ -226,12 +286,195 @@ enum class SamplerAddressMode {
 // Structures
 // ============================================================================
 
+// Frames the CPU may record ahead of the GPU: 1 (lowest latency) to 3 (most overlap),
+// fixed when the device is created (CreateGraphicsDevice)
+constexpr uint32 MAX_FRAMES_IN_FLIGHT = 3;
+
+// Descriptor sets a graphics pipeline takes, grouped by how often they change: set 0 per
+// frame, set 1 per pass, set 2 per material (CommandBuffer::BindDescriptorSet)
+constexpr uint32 MAX_DESCRIPTOR_SETS = 3;
+
+// GraphicsDeviceDesc::adapterIndex picking the best GPU rather than a given one
+constexpr uint32 DEFAULT_ADAPTER = ~0u;
+
+// A GPU the API can create a device on (EnumerateAdapters())
+struct AdapterInfo {
+    std::string name;
+    uint64 deviceMemory = 0;       // Device-local bytes (Metal: the recommended working set)
+    bool isIntegratedGPU = false;
+    bool isSoftware = false;       // Runs on the CPU (e.g. llvmpipe, SwiftShader)
+};
+
 struct DeviceInfo {
     std::string deviceName;
     GraphicsAPI api;
     uint32 apiVersion;
-    uint64 deviceMemory;
+    uint32 adapterIndex = 0;  // Of EnumerateAdapters(), the GPU the device runs on
+    uint64 deviceMemory = 0;  // Device-local bytes (Metal: the recommended working set)
+    bool isIntegratedGPU = false;  // Shares memory and power with the CPU; defaults scale down
+    uint32 minUniformBufferOffsetAlignment = 256;  // Required alignment of dynamic uniform offsets
+    uint32 framesInFlight = 2;                     // Number of FrameContext slots
+
+    // Large, partially bound SampledTexture arrays (DescriptorBindingDesc::count > 1)
+    // that shaders index dynamically. Vulkan: VK_EXT_descriptor_indexing / Vulkan 1.2.
+    bool supportsBindlessTextures = false;
+    uint32 maxBindlessTextures = 0;
+
+    // Block-compressed texture families that can be sampled (Format::BC*, ETC2_*, ASTC_*)
+    bool supportsBCTextures = false;
+    bool supportsETC2Textures = false;
+    bool supportsASTCTextures = false;
+
+    // Indirect draws (CommandBuffer::DrawIndexedIndirect*). Without multi-draw the
+    // backend issues one indirect draw per command; without a count buffer
+    // DrawIndexedIndirectCount() draws maxDrawCount commands. Without first-instance
+    // support DrawIndexedIndirectCommand::firstInstance must be 0.
+    bool supportsMultiDrawIndirect = false;
+    bool supportsDrawIndirectCount = false;
+    bool supportsDrawIndirectFirstInstance = false;
+
+    // Fragment shaders may read gl_PrimitiveID without a geometry stage (Vulkan: the
+    // geometryShader feature)
+    bool supportsPrimitiveId = false;
+
+    // Compute pipelines (GraphicsDevice::CreateComputePipeline). Work group sizes are
+    // declared in the shader (local_size_*); their product must not exceed this.
+    uint32 maxComputeWorkGroupInvocations = 256;
+
+    // Secondaries of CommandBuffer::BeginParallelRendering() may be recorded on worker
+    // threads (Vulkan secondary command buffers, Metal parallel render encoders)
+    bool supportsParallelRecording = false;
+
+    // GraphicsDevice::CreateBuffer(), CreateTexture() and CreateSampler(), and
+    // Buffer/Texture::UploadData() and CopyData(), may be called from any thread at once,
+    // e.g. by loader jobs. A command buffer is recorded on the thread that created it;
+    // BeginFrame(), the submits and the swap chain stay on the render thread. Without it, create and upload on the render thread only.
+    bool supportsThreadedResourceCreation = false;
+
+    // A second queue runs compute work alongside the graphics queue
+    // (FrameContext::computeCommandBuffer, GraphicsDevice::SubmitComputeCommandBuffer()).
+    // Vulkan: a second queue of the graphics family, with timeline semaphores; Metal: a
+    // second command queue ordered by shared events.
+    bool supportsAsyncCompute = false;
+
+    // SwapChain::WaitForPresent() can observe when frames reach the display
+    // (Vulkan: VK_KHR_present_id + VK_KHR_present_wait)
+    bool supportsPresentWait = false;
+
+    // GraphicsDevice::CreateGpuProfiler() (Vulkan timestamp queries, Metal counter
+    // sample buffers, WebGPU timestamp query sets)
+    bool supportsTimestampQueries = false;
+
+    // TextureUsage::Transient attachments take no memory (Metal memoryless storage on
+    // Apple GPUs, Vulkan lazily allocated memory on tile-based GPUs)
+    bool supportsMemorylessAttachments = false;
+
+    // Render passes take a shading rate image (CommandBuffer::BeginRendering()): an R8_UINT
+    // texture of one texel per shadingRateTexelSize square of pixels, each the
+    // (log2 width << 2) | log2 height of the fragments there, so 0 shades every pixel and
+    // 5 every 2x2 block once. Vulkan: VK_KHR_fragment_shading_rate with dynamic rendering.
+    // Metal's rasterization rate maps warp the render target rather than coarsen its
+    // fragments, so every pass after would have to unwarp it; Metal and WebGPU do not
+    // report it.
+    bool supportsShadingRateImage = false;
+    uint32 shadingRateTexelSize = 0;
+
+    // GraphicsDevice::GetMemoryBudget() follows what the driver grants the process as it
+    // changes (Vulkan: VK_EXT_memory_budget; Metal: the recommended working set).
+    // Without it the budget is deviceMemory and the usage unknown.
+    bool supportsMemoryBudget = false;
+
+    // Ray tracing acceleration structures (GraphicsDevice::CreateAccelerationStructure()).
+    // Vulkan: VK_KHR_acceleration_structure with buffer device addresses (Vulkan 1.2);
+    // Metal: GPUs that support ray tracing.
+    bool supportsAccelerationStructures = false;
+
+    // Shaders trace rays against a top-level acceleration structure bound as
+    // DescriptorType::AccelerationStructure (GLSL GL_EXT_ray_query). Vulkan:
+    // VK_KHR_ray_query; Metal: intersection queries on GPUs that support ray tracing.
+    bool supportsRayQuery = false;
+
+    // 16-bit float arithmetic in shaders (GLSL GL_EXT_shader_explicit_arithmetic_types_float16).
+    // Vulkan: shaderFloat16 of VK_KHR_shader_float16_int8 / Vulkan 1.2; Metal: half, on
+    // every GPU. Only arithmetic: shader interfaces and buffers stay 32-bit.
+    bool supportsShaderFloat16 = false;
+
+    // Graphics pipelines are linked from separately compiled, shared parts (vertex input,
+    // vertex shader, fragment shader, attachment output), so a new permutation compiles
+    // only the parts it does not share and is usable after a fast link; the optimized
+    // pipeline replaces it once linked in the background. Vulkan:
+    // VK_EXT_graphics_pipeline_library with fast linking.
+    bool supportsPipelineLibraries = false;
+
+    // DescriptorSetDesc::pushDescriptors and CommandBuffer::PushDescriptorSet(): small
+    // per-draw sets written straight into the command buffer, with no set to allocate or
+    // update. Vulkan: VK_KHR_push_descriptor.
+    bool supportsPushDescriptors = false;
+
+    // Texture::LoadFromFile() reads texture data from files straight into GPU memory,
+    // without a CPU copy (Metal fast resource loading, macOS 13 / iOS 16)
+    bool supportsFileTextureLoads = false;
+
+    // Depth format of the camera's depth buffers, which later passes sample: D32_SFLOAT,
+    // whose float precision reverse-Z projections keep over the whole view range, or
+    // D16_UNORM where the device cannot render and sample it
+    Format depthFormat = Format::D32_SFLOAT;
+
+    // D16_UNORM depth renders, samples and filters through comparison samplers: shadow
+    // maps at half the memory and bandwidth of D32_SFLOAT
+    bool supportsDepth16 = false;
+
+    // Multiview passes (RenderPassActions::viewCount, PipelineDesc::viewCount): each draw
+    // renders into up to maxMultiviewViews layers of array attachments, the vertex shader
+    // telling them apart by gl_ViewIndex, so stereo pairs or cube faces share one pass and
+    // one submission. Vulkan: VK_KHR_multiview (core in 1.1). Metal: layered rendering,
+    // the views drawn as extra instances. WebGPU has no multiview.
+    bool supportsMultiview = false;
+    uint32 maxMultiviewViews = 1;
+
+    // The platform's own temporal upscaler (GraphicsDevice::CreateTemporalUpscaler()).
+    // Metal: MetalFX's temporal scaler (macOS 13, iOS 16) on the GPUs it supports.
+    // Vulkan and WebGPU have none; TemporalAA upscales in its own shader there.
+    bool supportsTemporalUpscaler = false;
+};
+
+// Device-local memory the process may use and uses now
+struct MemoryBudget {
+    uint64 budgetBytes = 0;
+    uint64 usageBytes = 0;
+};
+
+// Layout of one command in an indirect argument buffer; matches
+// VkDrawIndexedIndirectCommand, MTLDrawIndexedPrimitivesIndirectArguments and WebGPU
+struct DrawIndexedIndirectCommand {
+    uint32 indexCount = 0;
+    uint32 instanceCount = 0;
+    uint32 firstIndex = 0;
+    int32 vertexOffset = 0;
+    uint32 firstInstance = 0;
+};
+static_assert(sizeof(DrawIndexedIndirectCommand) == 20, "DrawIndexedIndirectCommand must match the API layout");
+
+// Indexed draws recorded once for GraphicsDevice::CreateDrawList()
+struct DrawListDesc {
+    std::vector<DrawIndexedIndirectCommand> commands;
+    const char* debugName = nullptr;
+};
+
+// Arguments of CommandBuffer::DispatchIndirect; matches VkDispatchIndirectCommand,
+// MTLDispatchThreadgroupsIndirectArguments and WebGPU
+struct DispatchIndirectCommand {
+    uint32 groupCountX = 0;
+    uint32 groupCountY = 0;
+    uint32 groupCountZ = 0;
 };
+static_assert(sizeof(DispatchIndirectCommand) == 12, "DispatchIndirectCommand must match the API layout");
+
+// Buffers and textures that go away together, such as a model's. Backends that place
+// resources in shared memory blocks (Metal heaps) give each group blocks of its own, so
+// releasing the group's resources frees whole blocks instead of leaving holes in the
+// shared ones. 0 is the device's shared blocks.
+using ResourceGroup = uint32;
 
 struct BufferDesc {
     uint64 size = 0;
@@ -246,12 +489,41 @@ struct TextureDesc {
     uint32 height = 1;
     uint32 depth = 1;
     uint32 mipLevels = 1;
+    // Texture2D with more than one layer is an array texture (sampler2DArray); as an
+    // attachment, each view of a multiview pass renders into its own layer
     uint32 arrayLayers = 1;
     Format format = Format::R8G8B8A8_UNORM;
     TextureUsage usage;
+    // Fill mips 1..mipLevels-1 from mip 0 on upload; UploadData() then takes mip 0 only
+    bool generateMipmaps = false;
+    // Above 1: a multisampled 2D attachment (one mip and layer), resolved into a
+    // single-sampled texture at the end of its pass (see CommandBuffer::BeginRendering())
+    uint32 sampleCount = 1;
     const char* debugName = nullptr;
 };
 
+// Texture data as it lies in a file (Texture::LoadFromFile()): the layout UploadData()
+// takes, with each mip level's layers tightly packed from its own offset
+struct TextureFileSource {
+    std::string path;
+    std::vector<uint64> levelOffsets;  // Bytes into the file, one per uploaded mip level
+};
+
+// One mip level for Texture::UploadLevels(): its layers, tightly packed
+struct TextureLevelData {
+    const void* data = nullptr;
+    uint64 size = 0;
+};
+
+// Number of levels in a full mip chain down to 1x1
+inline uint32 CalculateMipLevels(uint32 width, uint32 height) {
+    uint32 levels = 1;
+    for (uint32 size = std::max(width, height); size > 1; size >>= 1) {
+        ++levels;
+    }
+    return levels;
+}
+
 struct SamplerDesc {
     Filter minFilter = Filter::Linear;
     Filter magFilter = Filter::Linear;
@@ -282,6 +554,20 @@ struct ShaderDesc {
     const char* debugName = nullptr;
 };
 
+// Backend source translated from a SPIR-V module at build time, found by the module's
+// 64-bit FNV-1a hash instead of translating it at runtime (WebGPU: WGSL)
+struct PrecompiledShader {
+    uint64 spirvHash;
+    const char* source;
+};
+
+// Value of a 32-bit specialization constant (GLSL layout(constant_id = N) const uint),
+// set per pipeline: Vulkan specialization info, Metal function constant, WGSL override
+struct SpecializationConstant {
+    uint32 id;
+    uint32 value;
+};
+
 struct VertexAttribute {
     uint32 location;
     Format format;
@@ -331,9 +617,17 @@ struct DepthStencilState {
     bool stencilTestEnable = false;
 };
 
+// How a blended attachment combines the fragment's color with what it holds
+enum class BlendMode {
+    Alpha,      // Source alpha over the destination; the destination's alpha is replaced
+    Additive,   // Source added to the destination, alpha too
+    Attenuate   // Destination scaled by one minus the source alpha, color and alpha
+};
+
 struct ColorAttachmentState {
     bool blendEnable = false;
-    // Blend operations will be added when needed
+    BlendMode blendMode = BlendMode::Alpha;
+    bool writeEnable = true;  // Off: depth-only draws inside a pass with color attachments
 };
 
 struct PipelineDesc {
@@ -346,6 +640,83 @@ struct PipelineDesc {
     std::vector<ColorAttachmentState> colorAttachments;
     const char* debugName = nullptr;
     VertexInputState vertexInputState;
+
+    // Attachment formats the pipeline renders to (Format::Undefined = swap chain format).
+    // Clear colorFormats for depth-only passes (e.g. shadow maps).
+    std::vector<Format> colorFormats = { Format::Undefined };
+    Format depthFormat = Format::D32_SFLOAT;
+    // Of those attachments; multisampled passes resolve their color attachments
+    uint32 sampleCount = 1;
+    // Views of the passes it draws in (RenderPassActions::viewCount); above 1 the vertex
+    // shader is built with GL_EXT_multiview. Needs DeviceInfo::supportsMultiview.
+    uint32 viewCount = 1;
+
+    // Applied to both stages; ids a stage does not declare are ignored, and undeclared
+    // constants keep their shader defaults
+    std::vector<SpecializationConstant> specializationConstants;
+
+    // Set 0's layout, that of this set; null for a pipeline that binds no set 0
+    Ref<DescriptorSet> descriptorSetLayout;
+    // Layouts of sets 1 and up, in set order (at most MAX_DESCRIPTOR_SETS - 1), for shaders
+    // that split their resources by update frequency. Binding numbers stay unique across
+    // a pipeline's sets, which the Metal backend relies on.
+    std::vector<Ref<DescriptorSet>> extraSetLayouts;
+};
+
+// Graphics or compute; a command buffer binds descriptor sets and push constants
+// to the point of the last bound pipeline
+enum class PipelineBindPoint {
+    Graphics,
+    Compute
+};
+
+struct ComputePipelineDesc {
+    Ref<Shader> computeShader;
+    uint32 pushConstantSize = 0;  // Bytes of push constants the shader reads (Vulkan range, max 128)
+    const char* debugName = nullptr;
+    Ref<DescriptorSet> descriptorSetLayout;  // As PipelineDesc's
+};
+
+// Execution and memory dependency recorded by CommandBuffer::PipelineBarrier. Must be
+// recorded outside BeginRendering()/EndRendering().
+enum class BarrierType {
+    ComputeToCompute,   // Storage writes of a dispatch -> reads/writes of the next one
+    ComputeToGraphics,  // Storage writes -> vertex/index fetch, uniform and shader reads
+    ComputeToIndirect,  // Storage writes -> indirect draw/dispatch arguments
+    GraphicsToCompute,  // Attachment and shader writes of a pass -> compute reads
+    GraphicsToTransfer, // Vertex shader reads of earlier draws -> transfer writes
+    TransferToGraphics  // Transfer writes (CopyBuffer) -> vertex shader and indirect reads
+};
+
+// How a pass uses a texture or buffer, for CommandBuffer::ResourceBarrier(). Attachment
+// states are entered by BeginRendering() itself: it takes color attachments from Present
+// and loaded depth attachments from ShaderRead, and EndRendering() leaves color
+// attachments in Present and depth attachments in DepthAttachment.
+enum class ResourceState {
+    Undefined,         // Contents are discarded
+    ColorAttachment,
+    DepthAttachment,
+    ShaderRead,        // Sampled, uniform and storage reads of vertex, fragment and compute shaders
+    StorageWrite,      // Storage writes (and reads) of compute shaders
+    IndirectArgument,  // Indirect draw and dispatch arguments
+    TransferWrite,     // CopyBuffer() and uploads
+    TransferRead,      // CopyBuffer() sources, e.g. results read back
+    ShadingRate,       // The shading rate image of a render pass
+    Present
+};
+
+// A texture moving from one state to another; before == after orders two accesses
+// in the same state, e.g. two storage writes
+struct TextureBarrier {
+    Ref<Texture> texture;
+    ResourceState before = ResourceState::Undefined;
+    ResourceState after = ResourceState::ShaderRead;
+};
+
+struct BufferBarrier {
+    Ref<Buffer> buffer;
+    ResourceState before = ResourceState::Undefined;
+    ResourceState after = ResourceState::ShaderRead;
 };
 
 struct Viewport {
@@ -364,6 +735,47 @@ struct Rect2D {
     uint32 height = 0;
 };
 
+// What a render pass does with the attachments' previous contents
+enum class LoadOp {
+    Clear,       // Fill with the pass's clear values
+    Load,        // Keep them, e.g. to update only part of a texture
+    ClearColor,  // Clear the color attachments and keep the depth: drawing over a finished depth buffer
+    DontCare     // Undefined: the pass writes every pixel (WebGPU clears)
+};
+
+// What a render pass does with an attachment's contents as it ends
+enum class StoreOp {
+    Store,     // Keep them for later passes
+    DontCare,  // Drop them, e.g. a depth buffer no later pass tests against or samples
+    Resolve    // Keep only the resolve target's copy; stored when there is no resolve target
+};
+
+// Per-attachment load and store actions of a render pass (CommandBuffer::BeginRendering()).
+// A LoadOp converts to the actions it stands for: ClearColor clears the color attachments
+// and loads the depth, the other ops apply to both; everything is stored. Attachments
+// with TextureUsage::Transient are never stored, whatever their store op.
+struct RenderPassActions {
+    LoadOp colorLoad = LoadOp::Clear;   // Clear, Load or DontCare
+    StoreOp colorStore = StoreOp::Store;
+    LoadOp depthLoad = LoadOp::Clear;
+    StoreOp depthStore = StoreOp::Store;
+    // Above 1, a multiview pass: every draw renders into layers 0 to viewCount - 1 of the
+    // attachments (Texture2D arrays or cube maps with at least that many layers), with
+    // pipelines of the same PipelineDesc::viewCount. Clears and load/store ops apply to
+    // every layer. Needs DeviceInfo::supportsMultiview.
+    uint32 viewCount = 1;
+
+    RenderPassActions() = default;
+    RenderPassActions(LoadOp loadOp)
+        : colorLoad(loadOp == LoadOp::ClearColor ? LoadOp::Clear : loadOp),
+          depthLoad(loadOp == LoadOp::ClearColor ? LoadOp::Load : loadOp) {}
+};
+
+// Whether an attachment's own contents are written back as its pass ends
+inline bool IsStored(StoreOp storeOp, bool transient, bool resolved) {
+    return !transient && (storeOp == StoreOp::Store || (storeOp == StoreOp::Resolve && !resolved));
+}
+
 struct ClearValue {
     struct DepthStencilValue {
         float depth;
@@ -380,6 +792,7 @@ struct ClearValue {
 class Buffer;
 class Texture;
 class Sampler;
+class AccelerationStructure;
 
 // Backend-agnostic descriptor binding description
 struct DescriptorBindingDesc {
@@ -388,15 +801,34 @@ struct DescriptorBindingDesc {
     ShaderStage stageFlags = ShaderStage::Vertex;
 
     // Resources (only set the ones relevant to the descriptor type)
-    Ref<Buffer> buffer;    // For UniformBuffer, StorageBuffer
+    Ref<Buffer> buffer;    // For UniformBuffer, UniformBufferDynamic, StorageBuffer
     Ref<Texture> texture;  // For SampledTexture, StorageTexture
     Ref<Sampler> sampler;  // For SampledTexture, Sampler
+
+    // Bytes visible to the shader (0 = whole buffer). Dynamic uniform buffers must set
+    // this to the struct size, the bind-time offset selects which slice is read.
+    uint64 range = 0;
+
+    // Array size. A SampledTexture binding with count > 1 is a texture table: elements
+    // are filled with DescriptorSet::UpdateTextureArrayElement() and may stay unwritten
+    // as long as the shader never reads them (requires supportsBindlessTextures).
+    uint32 count = 1;
+
+    // For AccelerationStructure: a built top level. Without one the binding stays
+    // unwritten until DescriptorSet::UpdateAccelerationStructure(), and shaders must not
+    // trace it before.
+    Ref<AccelerationStructure> accelerationStructure = nullptr;
 };
 
 // Descriptor set layout description
 struct DescriptorSetDesc {
     std::vector<DescriptorBindingDesc> bindings;
     const char* debugName = nullptr;
+    // Only a layout: nothing is allocated, and the bindings are written into the command
+    // buffer with CommandBuffer::PushDescriptorSet() each time the set changes. Requires
+    // DeviceInfo::supportsPushDescriptors. UniformBufferDynamic bindings are plain uniform
+    // buffers whose offset is given with the push.
+    bool pushDescriptors = false;
 };
 
 } // namespace rhi
@@ -0,0 +1,60 @@
+// ============================================================================
+// include/metagfx/rhi/UniformRingBuffer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Per-frame linear allocator for transient uniform data.
+// One CPU-visible uniform buffer is split into one region per frame in flight.
+// Each frame bump-allocates aligned slices from its own region, so data written
+// for frame N never overwrites what the GPU may still be reading for frame N-1.
+// Slices are consumed through DescriptorType::UniformBufferDynamic bindings that
+// point at GetBuffer(); the offset returned by Push() is passed to
+// CommandBuffer::BindDescriptorSet() as a dynamic offset.
+class UniformRingBuffer {
+public:
+    UniformRingBuffer(Ref<GraphicsDevice> device, uint64 bytesPerFrame, uint32 framesInFlight = 2);
+    ~UniformRingBuffer() = default;
+
+    UniformRingBuffer(const UniformRingBuffer&) = delete;
+    UniformRingBuffer& operator=(const UniformRingBuffer&) = delete;
+
+    // Start allocating from the region owned by frameIndex. The caller must have
+    // waited for the GPU to finish the previous use of that frame slot.
+    void BeginFrame(uint32 frameIndex);
+
+    // Reserve an aligned slice in the current frame's region. Returns its offset in
+    // GetBuffer(). On overflow, logs an error and returns the start of the region.
+    uint32 Allocate(uint64 size);
+
+    // Allocate a slice and copy data into it
+    uint32 Push(const void* data, uint64 size);
+
+    template<typename T>
+    uint32 Push(const T& value) { return Push(&value, sizeof(T)); }
+
+    const Ref<Buffer>& GetBuffer() const { return m_Buffer; }
+    uint32 GetAlignment() const { return m_Alignment; }
+    uint64 GetBytesPerFrame() const { return m_BytesPerFrame; }
+    uint64 GetBytesUsed() const { return m_Offset - m_FrameBase; }
+
+private:
+    Ref<Buffer> m_Buffer;
+    uint8* m_MappedData = nullptr;  // nullptr when the backend has no persistent mapping
+    uint64 m_BytesPerFrame = 0;
+    uint32 m_FramesInFlight = 0;
+    uint32 m_Alignment = 256;
+
+    uint64 m_FrameBase = 0;  // Start of the current frame's region
+    uint64 m_Offset = 0;     // Next free byte (absolute)
+    bool m_OverflowReported = false;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,72 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalAccelerationStructure.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "MetalTypes.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+/**
+ * @brief Metal primitive or instance acceleration structure
+ *
+ * Keeps the Metal descriptor of its builds. A bottom level's describes its triangles once;
+ * a top level's is pointed at the instances of each build, written as user-ID instance
+ * descriptors into one shared region per frame in flight, and at the bottom levels they
+ * place. Refits keep their scratch, as on Vulkan. A structure that allows compaction
+ * has its compacted size written to a shared buffer, read once the command buffer of the
+ * build has completed.
+ */
+class MetalAccelerationStructure : public AccelerationStructure {
+public:
+    // With storageSize 0 the storage fits a build of desc; otherwise it holds storageSize
+    // bytes, a compacted copy's
+    MetalAccelerationStructure(MetalContext& context, const AccelerationStructureDesc& desc, uint64 storageSize = 0);
+    ~MetalAccelerationStructure() override;
+
+    uint64 GetSize() const override { return m_Structure ? m_Structure->size() : 0; }
+    uint64 GetCompactedSize() override;
+
+    // Metal-specific
+    bool IsValid() const { return m_Structure != nullptr; }
+    MTL::AccelerationStructure* GetHandle() const { return m_Structure; }
+
+    // Encodes build into commandBuffer's encoder, a refit when it asks for one and can have
+    // it; false when it has nothing to do. A build without scratch of its own takes batch
+    // scratch of GetBatchScratchSize() at scratchOffset.
+    bool EncodeBuild(MTL::CommandBuffer* commandBuffer, MTL::AccelerationStructureCommandEncoder* encoder,
+                     const AccelerationStructureBuild& build, MTL::Buffer* batchScratch, uint64 scratchOffset);
+    // 0 when the structure has its own
+    uint64 GetBatchScratchSize() const { return m_Scratch ? 0 : m_BuildScratchSize; }
+    // After a copy into this structure
+    void MarkBuilt() { m_Built = true; }
+    // Top level: the bottom levels of the last build, which encoders tracing it must make
+    // resident (useResources)
+    const std::vector<const MTL::Resource*>& GetBottomLevelResources() const { return m_BottomLevelResources; }
+
+private:
+    MetalContext& m_Context;
+    MTL::AccelerationStructure* m_Structure = nullptr;
+    MTL::AccelerationStructureDescriptor* m_Descriptor = nullptr;
+    MTL::Buffer* m_Scratch = nullptr;    // AllowUpdate only
+    MTL::Buffer* m_Instances = nullptr;  // Top level: framesInFlight regions
+    uint64 m_BuildScratchSize = 0;
+    uint64 m_RefitScratchSize = 0;
+    uint64 m_AccountedSize = 0;  // Added to the memory counters
+
+    uint32 m_InstanceRegion = 0;
+    uint32 m_BuiltInstanceCount = 0;  // Of the last top-level build, which a refit must match
+    std::vector<MTL::AccelerationStructure*> m_BuiltBottomLevels;  // Likewise
+    std::vector<MTL::AccelerationStructure*> m_BottomLevels;  // EncodeBuild() scratch
+    std::vector<const MTL::Resource*> m_BottomLevelResources;  // m_BuiltBottomLevels, as resources
+
+    MTL::Buffer* m_CompactedSizeBuffer = nullptr;        // AllowCompaction only; one uint32
+    MTL::CommandBuffer* m_CompactionCommandBuffer = nullptr;  // Retained until the size is read
+    uint64 m_CompactedSize = 0;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -17,20 +17,28 @@ public:
     void* Map() override;
     void Unmap() override;
     void CopyData(const void* data, uint64 size, uint64 offset = 0) override;
+    // GPU-only buffers: written into staging memory and blitted (MetalUploadManager)
+    void WriteData(uint64 size, uint64 offset, const WriteCallback& write) override;
+    void* GetMappedPointer() override;
 
     uint64 GetSize() const override { return m_Size; }
     BufferUsage GetUsage() const override { return m_Usage; }
+    bool IsUploadComplete() const override;
 
     // Metal-specific
     MTL::Buffer* GetHandle() const { return m_Buffer; }
+    MTL::Heap* GetHeap() const { return m_Heap; }
 
 private:
     MetalContext& m_Context;
     MTL::Buffer* m_Buffer = nullptr;
+    MTL::Heap* m_Heap = nullptr;  // Placed in, or null for a buffer of its own
+    uint64 m_UploadTicket = 0;  // MetalUploadTicket of the last staged WriteData()
 
     uint64 m_Size = 0;
     BufferUsage m_Usage;
     MemoryUsage m_MemoryUsage;
+    MemoryCategory m_MemoryCategory;
 };
 
 } // namespace rhi
@@ -5,57 +5,115 @@
 
 #include "metagfx/rhi/CommandBuffer.h"
 #include "MetalTypes.h"
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
 
+class MetalPipeline;
+
 class MetalCommandBuffer : public CommandBuffer {
 public:
-    MetalCommandBuffer(MetalContext& context);
+    // With a primary, a secondary recording into one sub-encoder of that primary's
+    // parallel render passes
+    // With queue, a primary of that queue rather than the context's command queue: the
+    // async compute queue, whose command buffers start after the last graphics submission
+    MetalCommandBuffer(MetalContext& context, MetalCommandBuffer* primary = nullptr,
+                       MTL::CommandQueue* queue = nullptr);
     ~MetalCommandBuffer() override;
 
     // CommandBuffer interface
     void Begin() override;
     void End() override;
 
-    void BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                        Ref<Texture> depthAttachment,
-                        const std::vector<ClearValue>& clearValues) override;
+    void BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                        const Ref<Texture>& depthAttachment,
+                        std::span<const ClearValue> clearValues,
+                        const RenderPassActions& actions = {},
+                        std::span<const Ref<Texture>> resolveTargets = {},
+                        const Ref<Texture>& shadingRate = nullptr) override;
     void EndRendering() override;
 
-    void BindPipeline(Ref<Pipeline> pipeline) override;
+    void BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                const Ref<Texture>& depthAttachment,
+                                std::span<const ClearValue> clearValues,
+                                uint32 secondaryCount,
+                                const RenderPassActions& actions = {},
+                                std::span<const Ref<Texture>> resolveTargets = {},
+                                const Ref<Texture>& shadingRate = nullptr) override;
+    Ref<CommandBuffer> GetSecondaryCommandBuffer(uint32 index) override;
+    void EndParallelRendering() override;
+
+    void BindPipeline(const Ref<Pipeline>& pipeline) override;
 
     void SetViewport(const Viewport& viewport) override;
     void SetScissor(const Rect2D& scissor) override;
 
-    void BindVertexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
-    void BindIndexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
+    void BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
+    void BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
 
     void Draw(uint32 vertexCount, uint32 instanceCount = 1,
               uint32 firstVertex = 0, uint32 firstInstance = 0) override;
     void DrawIndexed(uint32 indexCount, uint32 instanceCount = 1,
                      uint32 firstIndex = 0, int32 vertexOffset = 0,
                      uint32 firstInstance = 0) override;
+    void DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                             uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+    void DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                  const Ref<Buffer>& countBuffer, uint64 countOffset, uint32 maxDrawCount,
+                                  uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+    void ExecuteDrawList(const Ref<DrawList>& drawList) override;
+
+    void Dispatch(uint32 groupCountX, uint32 groupCountY = 1, uint32 groupCountZ = 1) override;
+    void DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset = 0) override;
 
-    void CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+    void BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds) override;
+    Ref<AccelerationStructure> CompactAccelerationStructure(const Ref<AccelerationStructure>& source) override;
+    bool TemporalUpscale(TemporalUpscaler& upscaler, const TemporalUpscaleFrame& frame) override;
+
+    void CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                     uint64 size, uint64 srcOffset = 0, uint64 dstOffset = 0) override;
+    void CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset = 0) override;
 
     // Abstract interface implementations
-    void BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                           uint32 frameIndex = 0) override;
-    void PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+    using CommandBuffer::BindDescriptorSet;
+    void BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex, const Ref<DescriptorSet>& descriptorSet,
+                           uint32 frameIndex = 0, const uint32* dynamicOffsets = nullptr,
+                           uint32 dynamicOffsetCount = 0) override;
+    void PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                        uint32 offset, uint32 size, const void* data) override;
-    void BufferMemoryBarrier(Ref<Buffer> buffer) override;
-
-    // Metal-specific
+    void BufferMemoryBarrier(const Ref<Buffer>& buffer) override;
+    void PipelineBarrier(BarrierType type) override;
+    void ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                         const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) override;
+    void InvalidateState() override;
+    void WaitForAsyncCompute() override;
+
+    // Metal-specific. On a secondary the handle is the primary's command buffer.
     MTL::CommandBuffer* GetHandle() const { return m_CommandBuffer; }
     MTL::RenderCommandEncoder* GetRenderEncoder() const { return m_RenderEncoder; }
+    bool HasWaitedForAsyncCompute() const { return m_WaitedForAsyncCompute; }
+
+    // Timestamp of an empty blit pass, sampled when it ends: Apple GPUs sample counters
+    // only at encoder boundaries. False on a secondary and inside a render pass.
+    bool WriteTimestamp(MTL::CounterSampleBuffer* sampleBuffer, uint32 sampleIndex);
 
 private:
     MetalContext& m_Context;
+    MTL::CommandQueue* m_Queue = nullptr;  // Null: the context's command queue
     MTL::CommandBuffer* m_CommandBuffer = nullptr;
+    bool m_WaitedForAsyncCompute = false;  // Since Begin()
     MTL::RenderCommandEncoder* m_RenderEncoder = nullptr;
     MTL::BlitCommandEncoder* m_BlitEncoder = nullptr;
+    MTL::ComputeCommandEncoder* m_ComputeEncoder = nullptr;  // Open between render passes
+
+    // Open parallel pass. Its sub-encoders execute in creation order, so
+    // BeginParallelRendering() creates one per secondary, in index order, and hands it
+    // to that secondary as its render encoder.
+    MTL::ParallelRenderCommandEncoder* m_ParallelEncoder = nullptr;
+    std::vector<Ref<MetalCommandBuffer>> m_Secondaries;
+    uint32 m_ActiveSecondaryCount = 0;
+    MetalCommandBuffer* m_Primary = nullptr;  // Set on secondaries
 
     // Current pipeline state
     Ref<Pipeline> m_BoundPipeline;
@@ -63,14 +121,49 @@ private:
     uint64 m_IndexBufferOffset = 0;
     MTL::IndexType m_IndexType = MTL::IndexTypeUInt32;
 
+    // Descriptor sets last applied to the current render encoder, by set index; re-binding
+    // one unchanged only needs the dynamic offsets moved
+    struct BoundDescriptorSet {
+        const DescriptorSet* set = nullptr;
+        uint64 version = 0;
+        uint32 frame = 0;
+        const MetalPipeline* argumentPipeline = nullptr;  // Whose argument buffers it bound, if any
+        BoundDynamicOffsets offsets;
+    };
+    BoundDescriptorSet m_BoundDescriptorSets[MAX_DESCRIPTOR_SETS];
+
+    // State set on the current render encoder; a new encoder starts without any
+    const Pipeline* m_EncoderPipeline = nullptr;
+    MTL::Buffer* m_EncoderVertexBuffer = nullptr;
+    uint64 m_EncoderVertexOffset = 0;
+    Viewport m_EncoderViewport{};
+    Rect2D m_EncoderScissor{};
+    bool m_EncoderViewportSet = false;
+    bool m_EncoderScissorSet = false;
+
     // Push constants staging buffer (Metal's setBytes replaces entire buffer,
     // so we accumulate all push constant data before sending)
     static constexpr uint32 MAX_PUSH_CONSTANT_SIZE = 128;  // Typical max push constant size
     uint8 m_PushConstantBuffer[MAX_PUSH_CONSTANT_SIZE] = {};
     uint32 m_PushConstantSize = 0;  // Current size of push constant data
     ShaderStage m_PushConstantStages = static_cast<ShaderStage>(0);  // Which stages need the data
-
-    void FlushPushConstants();  // Send accumulated push constants to Metal
+    bool m_PushConstantsDirty = false;  // Staged bytes differ from what the encoder has
+
+    MTL::RenderPassDescriptor* CreateRenderPassDescriptor(std::span<const Ref<Texture>> colorAttachments,
+                                                          Ref<Texture> depthAttachment,
+                                                          std::span<const ClearValue> clearValues,
+                                                          const RenderPassActions& actions = {},
+                                                          std::span<const Ref<Texture>> resolveTargets = {});
+    void EndBlitAndComputeEncoders();  // Only one encoder may be open at a time
+
+    void FlushPushConstants();  // Send accumulated push constants to Metal, if changed
+    // Binds the view mask of a multiview pipeline's draws, views firstView on; returns the
+    // pipeline's view count, which direct draws multiply their instances by
+    uint32 SetViewMask(const MetalPipeline& pipeline, uint32 firstView, uint32 viewCount);
+    void ResetEncoderState();   // After opening an encoder
+
+    // Open compute encoder, created (ending a blit encoder) when needed; null inside a render pass
+    MTL::ComputeCommandEncoder* GetComputeEncoder();
 };
 
 } // namespace rhi
@@ -0,0 +1,30 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalComputePipeline.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/Pipeline.h"
+#include "MetalTypes.h"
+
+namespace metagfx {
+namespace rhi {
+
+class MetalComputePipeline : public Pipeline {
+public:
+    MetalComputePipeline(MetalContext& context, const ComputePipelineDesc& desc);
+    ~MetalComputePipeline() override;
+
+    PipelineBindPoint GetBindPoint() const override { return PipelineBindPoint::Compute; }
+
+    // Metal-specific
+    MTL::ComputePipelineState* GetComputePipelineState() const { return m_ComputePipelineState; }
+    MTL::Size GetThreadGroupSize() const { return m_ThreadGroupSize; }
+
+private:
+    MetalContext& m_Context;
+    MTL::ComputePipelineState* m_ComputePipelineState = nullptr;
+    MTL::Size m_ThreadGroupSize = MTL::Size::Make(1, 1, 1);
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -6,14 +6,26 @@
 #include "metagfx/rhi/DescriptorSet.h"
 #include "metagfx/rhi/Sampler.h"
 #include "MetalTypes.h"
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace metagfx {
 namespace rhi {
 
+class MetalPipeline;
+
 // Metal doesn't use descriptor sets like Vulkan.
 // Resources are bound directly to the encoder using setBuffer, setTexture, etc.
 // This class stores the bindings and applies them when rendering.
+//
+// On Tier 2 devices vertex and fragment functions read every binding but the uniform
+// buffers from an argument buffer instead (MetalContext::supportsArgumentBuffers). The set
+// encodes one per function layout it is bound with, again only once a binding changed,
+// so applying it is a buffer bind per stage plus useHeaps()/useResources() for residency.
+// Uniform buffers stay bound directly to keep per-draw dynamic offsets cheap, and so do
+// acceleration structures, with the bottom levels they place made resident. Compute
+// functions always take their resources directly.
 class MetalDescriptorSet : public DescriptorSet {
 public:
     // Constructor from backend-agnostic descriptor set description
@@ -22,20 +34,73 @@ public:
     ~MetalDescriptorSet() override;
 
     // DescriptorSet interface implementation
-    void UpdateBuffer(uint32 binding, Ref<Buffer> buffer) override;
-    void UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) override;
+    void UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) override;
+    void UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
+    void UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                   const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
+    void UpdateAccelerationStructure(uint32 binding, const Ref<AccelerationStructure>& structure) override;
     void* GetNativeHandle(uint32 frameIndex) const override;
     void* GetNativeLayout() const override;
 
-    // Metal-specific: Apply bindings to a render encoder
-    void ApplyToEncoder(MTL::RenderCommandEncoder* encoder, uint32 frameIndex) const;
+    // Metal-specific: Apply bindings to a render encoder for pipeline's functions (through
+    // their argument buffers where they take some). dynamicOffsets are consumed by
+    // UniformBufferDynamic bindings in increasing binding order.
+    void ApplyToEncoder(MTL::RenderCommandEncoder* encoder, const MetalPipeline* pipeline, uint32 frameIndex,
+                        const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0) const;
+
+    // Metal-specific: Apply the bindings visible to ShaderStage::Compute to a compute encoder
+    void ApplyToComputeEncoder(MTL::ComputeCommandEncoder* encoder,
+                               const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0) const;
+
+    // Metal-specific: Only move the dynamic uniform buffers (setVertexBufferOffset /
+    // setFragmentBufferOffset). Valid when this set is already applied to the encoder.
+    void ApplyDynamicOffsets(MTL::RenderCommandEncoder* encoder,
+                             const uint32* dynamicOffsets, uint32 dynamicOffsetCount) const;
+
+    // Incremented whenever a binding changes, so a command buffer can tell whether
+    // re-binding this set needs a full ApplyToEncoder
+    uint64 GetVersion() const { return m_Version; }
 
     // Get bindings for inspection
     const std::vector<DescriptorBindingDesc>& GetBindings() const { return m_Bindings; }
 
 private:
+    // One function layout's argument buffer
+    struct ArgumentBuffer {
+        MTL::Function* function = nullptr;  // Retained, so its address is not reused
+        MTL::Buffer* buffer = nullptr;
+        uint64 version = 0;                 // Of the bindings encoded
+    };
+
+    struct ArrayElement {
+        Ref<Texture> texture;
+        Ref<Sampler> sampler;
+    };
+
+    void ApplyDirect(MTL::RenderCommandEncoder* encoder, bool uniformBuffersOnly,
+                     const uint32* dynamicOffsets, uint32 dynamicOffsetCount) const;
+    // Encoded for the current bindings; called with m_ArgumentMutex held
+    MTL::Buffer* GetArgumentBuffer(MTL::Function* function, const std::vector<uint32>& ids) const;
+    void EncodeArguments(MTL::ArgumentEncoder* encoder, const std::vector<uint32>& ids) const;
+    // Rebuild the residency lists for the current bindings; called with m_ArgumentMutex held
+    void UpdateResidency() const;
+    void ReleaseArgumentBuffer(ArgumentBuffer& argumentBuffer) const;
+
     MetalContext& m_Context;
     std::vector<DescriptorBindingDesc> m_Bindings;
+    // Elements of texture tables by binding; element 0 is the binding's texture too
+    std::unordered_map<uint32, std::vector<ArrayElement>> m_ArrayElements;
+    uint64 m_Version = 0;
+
+    // Filled lazily as the set is applied, from the threads recording secondaries too
+    mutable std::mutex m_ArgumentMutex;
+    mutable std::vector<ArgumentBuffer> m_ArgumentBuffers;
+    // What the argument buffers reference: heaps read from, and resources of their own
+    // (or written to, which useHeap() does not cover)
+    mutable std::vector<const MTL::Heap*> m_ResidentHeaps;
+    mutable std::vector<const MTL::Resource*> m_ReadResources;
+    mutable std::vector<const MTL::Resource*> m_ReadWriteResources;
+    mutable uint64 m_ResidencyVersion = ~0ull;
 };
 
 } // namespace rhi
@@ -6,16 +6,28 @@
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "MetalTypes.h"
 
+#include <condition_variable>
+#include <mutex>
+
 struct SDL_Window;
 
 namespace metagfx {
 namespace rhi {
 
+class MetalPipelineCache;
+class MetalHeapAllocator;
+class MetalIOQueue;
+class MetalUploadManager;
+
 class MetalDevice : public GraphicsDevice {
 public:
-    MetalDevice(SDL_Window* window);
+    MetalDevice(SDL_Window* window, const GraphicsDeviceDesc& desc);
     ~MetalDevice() override;
 
+    // MTL::CopyAllDevices() on macOS, the system default device elsewhere
+    // (rhi::EnumerateAdapters())
+    static std::vector<AdapterInfo> EnumerateAdapters();
+
     // GraphicsDevice interface
     const DeviceInfo& GetDeviceInfo() const override { return m_DeviceInfo; }
 
@@ -23,26 +35,34 @@ public:
     Ref<Texture> CreateTexture(const TextureDesc& desc) override;
     Ref<Sampler> CreateSampler(const SamplerDesc& desc) override;
     Ref<Shader> CreateShader(const ShaderDesc& desc) override;
-    Ref<Pipeline> CreateGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<Pipeline> CreateComputePipeline(const ComputePipelineDesc& desc) override;
     Ref<Framebuffer> CreateFramebuffer(const FramebufferDesc& desc) override;
     Ref<DescriptorSet> CreateDescriptorSet(const DescriptorSetDesc& desc) override;
+    Ref<DrawList> CreateDrawList(const DrawListDesc& desc) override;
 
     Ref<CommandBuffer> CreateCommandBuffer() override;
+    FrameContext BeginFrame() override;
     void SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) override;
+    void SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer) override;
+    Ref<AccelerationStructure> CreateAccelerationStructure(const AccelerationStructureDesc& desc) override;
+    Ref<TemporalUpscaler> CreateTemporalUpscaler(const TemporalUpscalerDesc& desc) override;
+    Ref<GpuProfiler> CreateGpuProfiler() override;
+    MemoryBudget GetMemoryBudget() const override;
 
     void WaitIdle() override;
 
-    // Descriptor set layout management (no-op for Metal - Metal doesn't use descriptor set layouts)
-    void SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) override;
-
     Ref<SwapChain> GetSwapChain() override { return m_SwapChain; }
 
     // Metal-specific
     MetalContext& GetContext() { return m_Context; }
     const MetalContext& GetContext() const { return m_Context; }
 
+protected:
+    Ref<Pipeline> CompileGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<PipelineFuture> CompileGraphicsPipelineAsync(const PipelineDesc& desc) override;
+
 private:
-    void CreateDevice(SDL_Window* window);
+    void CreateDevice(SDL_Window* window, uint32 adapterIndex);
     void CreateCommandQueue();
 
     MetalContext m_Context;
@@ -50,6 +70,22 @@ private:
 
     Ref<SwapChain> m_SwapChain;
     SDL_Window* m_Window = nullptr;
+
+    Scope<MetalPipelineCache> m_PipelineCache;
+    Scope<MetalHeapAllocator> m_HeapAllocator;
+    Scope<MetalIOQueue> m_IOQueue;
+    Scope<MetalUploadManager> m_UploadManager;
+
+    // One command buffer wrapper per frame in flight; MTL::CommandBuffers themselves
+    // are transient and created from the queue in Begin()
+    std::vector<Ref<CommandBuffer>> m_FrameCommandBuffers;
+    // Of the async compute queue, empty without one
+    std::vector<Ref<CommandBuffer>> m_FrameComputeCommandBuffers;
+    bool m_ComputeSubmitted = false;  // This frame
+
+    // Notified by the frame completion handlers, for WaitIdle()
+    std::mutex m_CompletedMutex;
+    std::condition_variable m_CompletedCondition;
 };
 
 } // namespace rhi
@@ -0,0 +1,46 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalDrawList.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/DrawList.h"
+#include "MetalTypes.h"
+#include <mutex>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// A DrawList encoded into MTL::IndirectCommandBuffers, replayed with one
+// executeCommandsInBuffer. The commands inherit the encoder's pipeline and buffers, so
+// they follow whatever is bound when executed; the index buffer and primitive type are
+// encoded into them, so there is one indirect command buffer per pair used.
+// Textures are not inherited, so the replay needs the bound functions to read theirs
+// from argument buffers (MetalContext::supportsArgumentBuffers).
+class MetalDrawList : public DrawList {
+public:
+    MetalDrawList(GraphicsDevice& device, MetalContext& context, const DrawListDesc& desc);
+    ~MetalDrawList() override;
+
+    // Encoded on first use with this index buffer; null when it cannot be
+    MTL::IndirectCommandBuffer* GetIndirectCommandBuffer(MTL::Buffer* indexBuffer, uint64 indexBufferOffset,
+                                                         MTL::IndexType indexType,
+                                                         MTL::PrimitiveType primitiveType);
+
+private:
+    struct Encoded {
+        MTL::IndirectCommandBuffer* commands = nullptr;
+        MTL::Buffer* indexBuffer = nullptr;
+        uint64 indexBufferOffset = 0;
+        MTL::IndexType indexType = MTL::IndexTypeUInt32;
+        MTL::PrimitiveType primitiveType = MTL::PrimitiveTypeTriangle;
+        uint64 bytes = 0;
+    };
+
+    MetalContext& m_Context;
+    std::vector<Encoded> m_Encoded;
+    std::mutex m_Mutex;  // Secondaries replay the list from worker threads
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,41 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalGpuProfiler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/GpuProfiler.h"
+#include "MetalTypes.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Timestamp counter sample buffer with GpuProfiler::MAX_QUERIES samples per frame slot,
+// sampled at the end of empty blit passes (MetalCommandBuffer::WriteTimestamp)
+class MetalGpuProfiler : public GpuProfiler {
+public:
+    MetalGpuProfiler(MetalContext& context, uint32 frameCount, MTL::CounterSet* timestampCounterSet);
+    ~MetalGpuProfiler() override;
+
+    // The device's timestamp counter set, or null when it has none
+    static MTL::CounterSet* FindTimestampCounterSet(MTL::Device* device);
+
+    bool IsValid() const { return m_SampleBuffer != nullptr; }
+
+protected:
+    void ResetQueries(CommandBuffer& cmd, uint32 frameIndex) override {}  // Samples are overwritten
+    bool WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) override;
+    bool ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) override;
+
+private:
+    MetalContext& m_Context;
+    MTL::CounterSampleBuffer* m_SampleBuffer = nullptr;
+
+    // GPU ticks to nanoseconds, from the CPU/GPU timestamp pairs of
+    // MTL::Device::sampleTimestamps() at creation and at the latest read
+    MTL::Timestamp m_CalibrationCpu = 0;
+    MTL::Timestamp m_CalibrationGpu = 0;
+    double m_NanosecondsPerTick = 1.0;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,76 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalHeapAllocator.h
+// ============================================================================
+#pragma once
+
+#include "MetalTypes.h"
+#include <mutex>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned placement of buffers and textures into MTL::Heaps instead of a device
+// allocation each. Heaps are kept per ResourceGroup (see ResourceGroupScope) and
+// storage mode: a group's resources share heaps of their own, released as soon as the
+// last of them goes, while the shared group 0 keeps one empty heap per storage mode to
+// avoid churn. A group's heaps start small and double up to MAX_HEAP_SIZE; resources
+// over half of it, managed and memoryless storage get no heap and are created from the
+// device by the caller.
+//
+// Heaps track hazards like device resources do, so encoders need neither fences nor
+// useHeap() for resources bound directly. Those read through argument buffers come in
+// with one useHeaps() per descriptor set (MetalDescriptorSet).
+class MetalHeapAllocator {
+public:
+    static constexpr uint64 MIN_HEAP_SIZE = 8ull * 1024 * 1024;
+    static constexpr uint64 MAX_HEAP_SIZE = 64ull * 1024 * 1024;
+
+    struct Stats {
+        uint32 heapCount = 0;
+        uint32 resourceCount = 0;  // Placed in the heaps
+        uint64 heapBytes = 0;      // Of the heaps
+        uint64 usedBytes = 0;      // By the resources placed, alignment included
+    };
+
+    explicit MetalHeapAllocator(MetalContext& context);
+    ~MetalHeapAllocator();
+
+    MetalHeapAllocator(const MetalHeapAllocator&) = delete;
+    MetalHeapAllocator& operator=(const MetalHeapAllocator&) = delete;
+
+    // A new texture or buffer placed in a heap of group, and that heap; null when it
+    // takes no heap (see above)
+    MTL::Texture* NewTexture(MTL::TextureDescriptor* desc, ResourceGroup group, MTL::Heap*& outHeap);
+    MTL::Buffer* NewBuffer(NS::UInteger length, MTL::ResourceOptions options, ResourceGroup group,
+                           MTL::Heap*& outHeap);
+
+    // Once a resource placed in heap has been released
+    void Release(MTL::Heap* heap);
+
+    Stats GetStats() const;
+
+private:
+    struct Heap {
+        MTL::Heap* heap = nullptr;
+        ResourceGroup group = 0;
+        MTL::StorageMode storageMode = MTL::StorageModePrivate;
+        MTL::CPUCacheMode cpuCacheMode = MTL::CPUCacheModeDefaultCache;
+        uint32 resourceCount = 0;
+    };
+
+    bool CanPlace(MTL::StorageMode storageMode) const;
+    // A heap of the group and modes with room for sizeAndAlign, created when none has
+    // it or createNew is set; valid until the next heap is created or released
+    Heap* FindHeap(MTL::SizeAndAlign sizeAndAlign, ResourceGroup group, MTL::StorageMode storageMode,
+                   MTL::CPUCacheMode cpuCacheMode, bool createNew);
+    Heap* CreateHeap(uint64 size, ResourceGroup group, MTL::StorageMode storageMode,
+                     MTL::CPUCacheMode cpuCacheMode);
+
+    MetalContext& m_Context;
+    std::vector<Heap> m_Heaps;
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,51 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalIOQueue.h
+// ============================================================================
+#pragma once
+
+#include "MetalTypes.h"
+#include <functional>
+#include <mutex>
+#include <string>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned Metal fast resource loading (MTL::IOCommandQueue, macOS 13 / iOS 16):
+// loads read file ranges straight into textures, without the data passing through the
+// CPU. Each submission signals a shared event that a command buffer on the device's
+// queue waits for, so GPU work committed after it sees the loaded data, as it does
+// after MetalTexture::UploadData().
+class MetalIOQueue {
+public:
+    explicit MetalIOQueue(MetalContext& context);
+    ~MetalIOQueue();
+
+    MetalIOQueue(const MetalIOQueue&) = delete;
+    MetalIOQueue& operator=(const MetalIOQueue&) = delete;
+
+    // False before macOS 13 / iOS 16, or when the queue could not be created
+    bool IsSupported() const { return m_Queue != nullptr; }
+
+    // Handle for loads from the file, or null (logged); the caller releases it
+    MTL::IOFileHandle* OpenFile(const std::string& path);
+
+    // IO command buffer to encode loads into; pass it to Submit()
+    MTL::IOCommandBuffer* NewCommandBuffer();
+
+    // Commit the loads and, after them, a command buffer on the device's queue that
+    // waits for them. encode records GPU work on the loaded data into that command
+    // buffer (generated mips). Does not wait for the loads; returns the upload ticket
+    // of the command buffer (MetalUploadManager), complete once the data is in place.
+    uint64 Submit(MTL::IOCommandBuffer* commands, const std::function<void(MTL::CommandBuffer*)>& encode = {});
+
+private:
+    MetalContext& m_Context;
+    MTL::IOCommandQueue* m_Queue = nullptr;
+    MTL::SharedEvent* m_Event = nullptr;
+    uint64 m_EventValue = 0;  // Last value signaled
+    std::mutex m_Mutex;       // Keeps event values in commit order
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -5,6 +5,7 @@
 
 #include "metagfx/rhi/Pipeline.h"
 #include "MetalTypes.h"
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
@@ -17,21 +18,33 @@ public:
     // Metal-specific
     MTL::RenderPipelineState* GetRenderPipelineState() const { return m_RenderPipelineState; }
     MTL::DepthStencilState* GetDepthStencilState() const { return m_DepthStencilState; }
+    // A stage function reading descriptor set 0 from an argument buffer (see MetalDescriptorSet)
+    struct ArgumentLayout {
+        MTL::Function* function = nullptr;  // As specialized for this pipeline; null: no argument buffer
+        std::vector<uint32> ids;            // As MetalShader::GetArgumentIds()
+    };
+    const ArgumentLayout& GetVertexArguments() const { return m_VertexArguments; }
+    const ArgumentLayout& GetFragmentArguments() const { return m_FragmentArguments; }
+    bool TakesArgumentBuffers() const { return m_VertexArguments.function || m_FragmentArguments.function; }
 
     MTL::PrimitiveType GetPrimitiveType() const { return m_PrimitiveType; }
     MTL::CullMode GetCullMode() const { return m_CullMode; }
     MTL::Winding GetFrontFace() const { return m_FrontFace; }
     MTL::TriangleFillMode GetFillMode() const { return m_FillMode; }
+    uint32 GetViewCount() const { return m_ViewCount; }
 
 private:
     MetalContext& m_Context;
     MTL::RenderPipelineState* m_RenderPipelineState = nullptr;
     MTL::DepthStencilState* m_DepthStencilState = nullptr;
+    ArgumentLayout m_VertexArguments;
+    ArgumentLayout m_FragmentArguments;
 
     MTL::PrimitiveType m_PrimitiveType = MTL::PrimitiveTypeTriangle;
     MTL::CullMode m_CullMode = MTL::CullModeBack;
     MTL::Winding m_FrontFace = MTL::WindingCounterClockwise;
     MTL::TriangleFillMode m_FillMode = MTL::TriangleFillModeFill;
+    uint32 m_ViewCount = 1;
 };
 
 } // namespace rhi
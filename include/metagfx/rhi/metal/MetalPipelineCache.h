@@ -0,0 +1,69 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalPipelineCache.h
+// ============================================================================
+#pragma once
+
+#include "MetalTypes.h"
+#include <atomic>
+#include <mutex>
+#include <string>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned shader and pipeline caches persisted next to
+// GraphicsDeviceDesc::pipelineCachePath, the Metal counterpart of VulkanPipelineCache:
+//
+// - <path>.msl/<spirv hash>.metal: SPIRV-Cross output, so warm starts skip the translation.
+//   A <spirv hash>.metallib in the same directory (e.g. built by xcrun metal from the
+//   .metal file) is loaded instead of compiling the source.
+// - <path>.binarchive: an MTL::BinaryArchive every render and compute pipeline is looked
+//   up in and added to, so pipeline states load precompiled GPU code.
+//
+// The archive is saved at shutdown and every SAVE_INTERVAL_FRAMES frames after new
+// pipelines were added. With an empty path nothing is cached.
+class MetalPipelineCache {
+public:
+    static constexpr uint32 SAVE_INTERVAL_FRAMES = 1800;
+
+    MetalPipelineCache(MetalContext& context, const std::string& filePath);
+    ~MetalPipelineCache();  // Saves
+
+    MetalPipelineCache(const MetalPipelineCache&) = delete;
+    MetalPipelineCache& operator=(const MetalPipelineCache&) = delete;
+
+    static uint64 HashSpirv(const void* data, uint64 size);
+
+    // Translated MSL (plus the compute local size, which SPIRV-Cross would report) for a
+    // SPIR-V module
+    bool LoadMSL(uint64 spirvHash, ShaderStage stage, std::string& outSource, uint32 outThreadGroupSize[3]) const;
+    void StoreMSL(uint64 spirvHash, ShaderStage stage, const std::string& source, const uint32 threadGroupSize[3]) const;
+
+    // Precompiled library for a SPIR-V module, or nullptr (caller releases)
+    MTL::Library* LoadLibrary(uint64 spirvHash) const;
+
+    // Creates the pipeline state from the archive when it holds the pipeline's functions,
+    // otherwise compiles them into the archive first
+    MTL::RenderPipelineState* CreateRenderPipelineState(MTL::RenderPipelineDescriptor* descriptor, NS::Error** error);
+    MTL::ComputePipelineState* CreateComputePipelineState(MTL::ComputePipelineDescriptor* descriptor, NS::Error** error);
+
+    // Called once per frame; saves every SAVE_INTERVAL_FRAMES frames if anything changed
+    void Tick();
+
+    bool Save();
+
+private:
+    std::string GetShaderPath(uint64 spirvHash, const char* extension) const;
+
+    MetalContext& m_Context;
+    std::string m_ArchivePath;
+    std::string m_ShaderDirectory;
+
+    MTL::BinaryArchive* m_Archive = nullptr;
+    std::mutex m_ArchiveMutex;  // Pipelines may be created from loader threads
+    std::atomic<bool> m_Dirty{false};
+    uint32 m_FramesSinceSave = 0;
+};
+
+} // namespace rhi
+} // namespace metagfx
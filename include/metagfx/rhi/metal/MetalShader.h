@@ -5,6 +5,8 @@
 
 #include "metagfx/rhi/Shader.h"
 #include "MetalTypes.h"
+#include <string>
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
@@ -19,12 +21,27 @@ public:
     // Metal-specific
     MTL::Library* GetLibrary() const { return m_Library; }
     MTL::Function* GetFunction() const { return m_Function; }
+    // The entry point with SPIR-V specialization constants bound as function constants,
+    // or the plain function (retained) when it declares none. Caller releases.
+    MTL::Function* CreateSpecializedFunction(const std::vector<SpecializationConstant>& constants) const;
+    // Compute shaders: the SPIR-V LocalSize, passed as threadsPerThreadgroup on dispatch
+    MTL::Size GetThreadGroupSize() const {
+        return MTL::Size::Make(m_ThreadGroupSize[0], m_ThreadGroupSize[1], m_ThreadGroupSize[2]);
+    }
+    // The [[id]]s the function reads from descriptor set 0's argument buffer, ascending;
+    // empty when it takes none
+    const std::vector<uint32>& GetArgumentIds() const { return m_ArgumentIds; }
 
 private:
+    void CompileLibrary(const std::string& mslSource);
+
     MetalContext& m_Context;
     MTL::Library* m_Library = nullptr;
     MTL::Function* m_Function = nullptr;
+    std::string m_FunctionName;
     ShaderStage m_Stage;
+    uint32 m_ThreadGroupSize[3] = { 1, 1, 1 };
+    std::vector<uint32> m_ArgumentIds;
 };
 
 } // namespace rhi
@@ -7,15 +7,19 @@
 #include "MetalTypes.h"
 
 #include <dispatch/dispatch.h>
+#include <vector>
 
 struct SDL_Window;
 
 namespace metagfx {
 namespace rhi {
 
+// With offscreen set, the back buffers are framesInFlight device-owned textures sized like
+// the window instead of layer drawables, and GetCurrentDrawable() returns null
 class MetalSwapChain : public SwapChain {
 public:
-    MetalSwapChain(MetalContext& context, SDL_Window* window);
+    MetalSwapChain(MetalContext& context, SDL_Window* window, uint32 framesInFlight, PresentMode presentMode,
+                   bool offscreen = false);
     ~MetalSwapChain() override;
 
     void Present() override;
@@ -26,16 +30,23 @@ public:
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
 
+    // Metal only switches display sync: Immediate turns it off, every other mode keeps it
+    void SetPresentMode(PresentMode mode) override;
+    PresentMode GetPresentMode() const override { return m_PresentMode; }
+
     // Metal-specific
     CA::MetalDrawable* GetCurrentDrawable() const { return m_CurrentDrawable; }
     dispatch_semaphore_t GetFrameSemaphore() const { return m_FrameSemaphore; }
 
     uint32 GetCurrentFrame() const { return m_CurrentFrame; }
+    uint32 GetFramesInFlight() const { return m_FramesInFlight; }
+    bool IsOffscreen() const { return m_Offscreen; }
     void AdvanceFrame();
 
 private:
     void AcquireNextDrawable();
     void UpdateDrawableSize();
+    void CreateOffscreenTextures();
 
     MetalContext& m_Context;
     SDL_Window* m_Window;
@@ -45,12 +56,16 @@ private:
 
     Ref<Texture> m_CurrentTexture;
 
+    bool m_Offscreen = false;
+    std::vector<Ref<Texture>> m_OffscreenTextures;  // One per frame slot
+
     uint32 m_Width = 0;
     uint32 m_Height = 0;
     Format m_Format = Format::B8G8R8A8_UNORM;
+    PresentMode m_PresentMode = PresentMode::Fifo;
 
-    // Frame synchronization
-    static constexpr uint32 MAX_FRAMES_IN_FLIGHT = 2;
+    // Frame synchronization; the semaphore counts free frame slots
+    uint32 m_FramesInFlight = 2;
     uint32 m_CurrentFrame = 0;
 };
 
@@ -0,0 +1,40 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalTemporalUpscaler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/TemporalUpscaler.h"
+#include "MetalTypes.h"
+
+#include <MetalFX/MetalFX.hpp>
+
+namespace metagfx {
+namespace rhi {
+
+/**
+ * @brief MetalFX temporal scaler
+ *
+ * Created with auto exposure, since the color is the HDR scene color before tone
+ * mapping, and with input content properties, so dynamic resolution can draw any region
+ * from the input's size down to the smallest the GPU's scaler takes.
+ */
+class MetalTemporalUpscaler : public TemporalUpscaler {
+public:
+    MetalTemporalUpscaler(MetalContext& context, const TemporalUpscalerDesc& desc);
+    ~MetalTemporalUpscaler() override;
+
+    // Metal-specific
+    bool IsValid() const { return m_Scaler != nullptr; }
+    MTLFX::TemporalScaler* GetHandle() const { return m_Scaler; }
+
+    // Encodes frame into commandBuffer, outside any encoder; false for textures missing
+    // the usages the scaler needs
+    bool Encode(MTL::CommandBuffer* commandBuffer, const TemporalUpscaleFrame& frame);
+
+private:
+    MTLFX::TemporalScaler* m_Scaler = nullptr;
+    bool m_UsageReported = false;  // The missing usages are logged once
+};
+
+} // namespace rhi
+} // namespace metagfx
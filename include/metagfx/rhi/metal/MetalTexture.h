@@ -23,22 +23,45 @@ public:
     uint32 GetWidth() const override { return m_Width; }
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
+    uint32 GetMipLevels() const override { return m_MipLevels; }
+    uint32 GetSampleCount() const override { return m_SampleCount; }
 
+    // Staged and blitted into the texture (MetalUploadManager), without waiting
     void UploadData(const void* data, uint64 size) override;
+    // Stages each level from where it lies, without packing them first
+    void UploadLevels(const TextureLevelData* levels, uint32 levelCount) override;
+    // Through MetalIOQueue; false without it, or for float mips generated on the CPU
+    bool LoadFromFile(const TextureFileSource& source) override;
+    bool IsUploadComplete() const override;
 
     // Metal-specific
     MTL::Texture* GetHandle() const { return m_Texture; }
+    MTL::Heap* GetHeap() const { return m_Heap; }
+    // TextureUsage::Transient: render passes do not store it
+    bool IsTransient() const { return m_Transient; }
 
 private:
+    // The blit encoder generates the mips; 32-bit float formats are generated on the CPU
+    bool CanBlitMipmaps() const;
+    // Copies the levels, mip 0 up, into staging memory and submits their blits
+    void StageLevels(const TextureLevelData* levels, uint32 levelCount, bool blitMipmaps);
+
     MetalContext& m_Context;
     MTL::Texture* m_Texture = nullptr;
+    MTL::Heap* m_Heap = nullptr;  // Placed in, or null for a texture of its own
+    MTL::IOCommandBuffer* m_FileLoad = nullptr;  // Of the last LoadFromFile()
+    uint64 m_UploadTicket = 0;  // MetalUploadTicket of the last upload or load
 
     uint32 m_Width = 0;
     uint32 m_Height = 0;
     uint32 m_MipLevels = 1;
     uint32 m_ArrayLayers = 1;
+    uint32 m_SampleCount = 1;
     Format m_Format = Format::Undefined;
     TextureType m_Type = TextureType::Texture2D;
+    MemoryCategory m_MemoryCategory = MemoryCategory::Texture;
+    bool m_GenerateMipmaps = false;  // UploadData() receives mip 0 only
+    bool m_Transient = false;
     bool m_OwnsTexture = false;
 };
 
@@ -5,9 +5,11 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/rhi/FrameStats.h"
+#include "metagfx/rhi/MemoryStats.h"
 
 // metal-cpp headers
-// Note: NS/MTL/CA_PRIVATE_IMPLEMENTATION are defined in MetalTypes.cpp
+// Note: NS/MTL/CA/MTLFX_PRIVATE_IMPLEMENTATION are defined in MetalTypes.cpp
 #include <Foundation/Foundation.hpp>
 #include <Metal/Metal.hpp>
 #include <QuartzCore/QuartzCore.hpp>
@@ -22,16 +24,72 @@ namespace rhi {
 #define MTL_LOG_ERROR(msg) \
     METAGFX_ERROR << "Metal error: " << msg << " at " << __FILE__ << ":" << __LINE__
 
+class MetalPipelineCache;
+class MetalHeapAllocator;
+class MetalIOQueue;
+class MetalUploadManager;
+
+// Shader binding layout shared by MetalShader (SPIR-V to MSL) and MetalDescriptorSet.
+// Uniform and storage buffers bound directly take buffer index binding + BUFFER_OFFSET,
+// leaving 0-9 to vertex buffers; push constants take the last buffer index.
+constexpr uint32 METAL_BUFFER_OFFSET = 10;
+constexpr uint32 METAL_PUSH_CONSTANT_BUFFER_INDEX = 30;
+// With argument buffers, descriptor set N of a vertex or fragment function is an
+// argument buffer at buffer index ARGUMENT_BUFFER_INDEX - N. Inside it a binding's
+// buffer or texture takes [[id(binding * IDS_PER_BINDING)]] and its sampler the second
+// half, so a binding's arrays hold up to IDS_PER_BINDING / 2 elements.
+constexpr uint32 METAL_ARGUMENT_BUFFER_INDEX = 29;
+constexpr uint32 METAL_ARGUMENT_IDS_PER_BINDING = 2048;
+constexpr uint32 METAL_MAX_ARGUMENT_ARRAY_SIZE = METAL_ARGUMENT_IDS_PER_BINDING / 2;
+// Multiview vertex functions (GL_EXT_multiview) read their first view and view count from
+// this buffer index, below the argument buffers of the MAX_DESCRIPTOR_SETS sets. Each view
+// is an extra instance writing [[render_target_array_index]].
+constexpr uint32 METAL_VIEW_MASK_BUFFER_INDEX = METAL_ARGUMENT_BUFFER_INDEX - MAX_DESCRIPTOR_SETS;
+
+inline uint32 GetMetalArgumentId(uint32 binding) { return binding * METAL_ARGUMENT_IDS_PER_BINDING; }
+inline uint32 GetMetalSamplerArgumentId(uint32 binding) {
+    return binding * METAL_ARGUMENT_IDS_PER_BINDING + METAL_MAX_ARGUMENT_ARRAY_SIZE;
+}
+
 // Metal context shared across all Metal objects
 struct MetalContext {
     MTL::Device* device = nullptr;
     MTL::CommandQueue* commandQueue = nullptr;
+    // Async compute (DeviceInfo::supportsAsyncCompute): a second queue, ordered against
+    // the first by two shared events. Each graphics command buffer signals graphicsEvent
+    // with its signal value, which the next compute command buffer waits for; the frame's
+    // compute command buffer signals computeEvent with computeEventValue.
+    MTL::CommandQueue* computeQueue = nullptr;
+    MTL::SharedEvent* graphicsEvent = nullptr;
+    MTL::SharedEvent* computeEvent = nullptr;
+    uint64 graphicsEventValue = 0;  // Of the last graphics submission
+    uint64 computeEventValue = 0;   // Of the frame being recorded
     CA::MetalLayer* metalLayer = nullptr;
     SDL_MetalView metalView = nullptr;
 
+    // Frame slots (swap chain drawables, per-frame regions of CPU-written buffers)
+    uint32 framesInFlight = 2;
+
     // Device capabilities
-    bool supportsArgumentBuffers = false;
+    bool supportsArgumentBuffers = false;  // Tier 2: render functions take descriptor sets as argument buffers
     bool supportsRayTracing = false;
+    bool supportsRayQuery = false;  // Intersection queries from render functions (MSL 2.4)
+    bool supportsMemoryless = false;  // MTL::StorageModeMemoryless (Apple GPUs)
+    bool supportsIndirectCommandBuffers = false;  // Render pipelines are created to run them
+
+    // Owned by MetalDevice; shaders and pipelines are created through it
+    MetalPipelineCache* pipelineCache = nullptr;
+    // Owned by MetalDevice; buffers and textures are placed in its heaps where they can be
+    MetalHeapAllocator* heapAllocator = nullptr;
+    // Owned by MetalDevice; textures load from files through it where supported
+    MetalIOQueue* ioQueue = nullptr;
+    // Owned by MetalDevice; CPU data reaches textures and GPU-only buffers through it
+    MetalUploadManager* uploadManager = nullptr;
+
+    // Owned by MetalDevice; objects add the device work of the frame (GetFrameStats())
+    // and the memory of their resources (GetMemoryStats())
+    FrameStatsCounters* stats = nullptr;
+    MemoryCounters* memory = nullptr;
 };
 
 // Format conversion utilities
@@ -0,0 +1,60 @@
+// ============================================================================
+// include/metagfx/rhi/metal/MetalUploadManager.h
+// ============================================================================
+#pragma once
+
+#include "MetalTypes.h"
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace metagfx {
+namespace rhi {
+
+// Identifies an upload; tickets increase monotonically, 0 = nothing pending
+using MetalUploadTicket = uint64;
+
+// Device-owned uploads into private storage, the Metal counterpart of VulkanUploadManager.
+// Data is staged in a shared buffer and copied by a blit encoder in a command buffer of
+// its own, committed to the device's queue without any CPU wait; command buffers on the
+// queue run in order, so frames committed after it see the data. Each upload signals a
+// shared event with its ticket, which callers poll, and a completion handler releases the
+// staging buffer and wakes Wait(). Thread-safe.
+class MetalUploadManager {
+public:
+    explicit MetalUploadManager(MetalContext& context);
+    // Waits for the uploads still in flight, whose handlers refer to the manager
+    ~MetalUploadManager();
+
+    MetalUploadManager(const MetalUploadManager&) = delete;
+    MetalUploadManager& operator=(const MetalUploadManager&) = delete;
+
+    // Shared buffer of size bytes for the caller to fill and pass to Submit(), or null (logged)
+    MTL::Buffer* NewStagingBuffer(uint64 size);
+
+    // Commit a command buffer with the GPU work encode records (copies out of staging,
+    // generated mips). staging, which may be null, is released once it has completed.
+    // Returns its ticket; does not wait.
+    MetalUploadTicket Submit(MTL::Buffer* staging, const std::function<void(MTL::CommandBuffer*)>& encode);
+
+    // Poll, never blocks
+    bool IsComplete(MetalUploadTicket ticket) const;
+    void Wait(MetalUploadTicket ticket);
+    // Blocks until everything submitted so far has completed
+    void WaitIdle();
+
+private:
+    void Complete(MetalUploadTicket ticket);
+
+    MetalContext& m_Context;
+    MTL::SharedEvent* m_Event = nullptr;  // Signaled with each upload's ticket
+    MetalUploadTicket m_LastTicket = 0;   // Last submitted
+    std::mutex m_SubmitMutex;             // Keeps tickets in commit order
+
+    mutable std::mutex m_CompletedMutex;
+    std::condition_variable m_CompletedCondition;
+    MetalUploadTicket m_CompletedTicket = 0;  // Last whose handler has run
+};
+
+} // namespace rhi
+} // namespace metagfx
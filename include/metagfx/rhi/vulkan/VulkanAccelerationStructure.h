@@ -0,0 +1,100 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanAccelerationStructure.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "VulkanTypes.h"
+#include "VulkanMemoryAllocator.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Buffer read or written through its device address: acceleration structure storage,
+// build scratch and instances. Counted as acceleration structure memory.
+class VulkanAccelerationStructureBuffer {
+public:
+    VulkanAccelerationStructureBuffer(VulkanContext& context, VkDeviceSize size, VkBufferUsageFlags usage,
+                                      VkMemoryPropertyFlags properties);
+    ~VulkanAccelerationStructureBuffer();
+
+    VulkanAccelerationStructureBuffer(const VulkanAccelerationStructureBuffer&) = delete;
+    VulkanAccelerationStructureBuffer& operator=(const VulkanAccelerationStructureBuffer&) = delete;
+
+    bool IsValid() const { return m_Address != 0; }
+    VkBuffer GetHandle() const { return m_Buffer; }
+    VkDeviceAddress GetAddress() const { return m_Address; }
+    void* GetMappedData() const { return m_Allocation.mappedData; }
+
+private:
+    VulkanContext& m_Context;
+    VkBuffer m_Buffer = VK_NULL_HANDLE;
+    VulkanAllocation m_Allocation;
+    VkDeviceAddress m_Address = 0;
+};
+
+/**
+ * @brief VK_KHR_acceleration_structure bottom or top level
+ *
+ * Owns its storage and, when it can be updated, the scratch of its builds; a structure
+ * rebuilt from scratch each time borrows the command buffer's batch scratch instead. A
+ * top level writes its instances into one host-visible region per frame in flight. A
+ * structure that allows compaction keeps a query of its compacted size, written after
+ * each build and read without waiting.
+ */
+class VulkanAccelerationStructure : public AccelerationStructure {
+public:
+    // With storageSize 0 the storage fits a build of desc; otherwise it holds storageSize
+    // bytes, a compacted copy's
+    VulkanAccelerationStructure(VulkanContext& context, const AccelerationStructureDesc& desc,
+                                VkDeviceSize storageSize = 0);
+    ~VulkanAccelerationStructure() override;
+
+    uint64 GetSize() const override { return m_StorageSize; }
+    uint64 GetCompactedSize() override;
+
+    // Vulkan-specific
+    bool IsValid() const { return m_Handle != VK_NULL_HANDLE; }
+    VkAccelerationStructureKHR GetHandle() const { return m_Handle; }
+    VkDeviceAddress GetDeviceAddress() const { return m_DeviceAddress; }
+    VkQueryPool GetCompactionQueryPool() const { return m_CompactionQueries; }
+
+    // Fills the build info of build (without its scratch address) and its ranges, writing a
+    // top level's instances into the next region; false when the build has nothing to do.
+    // Call once per build, as the command buffer records it.
+    bool PrepareBuild(const AccelerationStructureBuild& build, VkAccelerationStructureBuildGeometryInfoKHR& outInfo,
+                      const VkAccelerationStructureBuildRangeInfoKHR*& outRanges);
+    // Scratch the prepared build needs from the batch; 0 when the structure has its own,
+    // whose address is then GetScratchAddress()
+    VkDeviceSize GetBatchScratchSize(const VkAccelerationStructureBuildGeometryInfoKHR& info) const;
+    VkDeviceAddress GetScratchAddress() const;
+    // After a copy into this structure or a recorded build
+    void MarkBuilt(bool compactionQueryWritten);
+
+private:
+    VkAccelerationStructureBuildGeometryInfoKHR GetGeometryInfo() const;
+
+    VulkanContext& m_Context;
+    VkAccelerationStructureKHR m_Handle = VK_NULL_HANDLE;
+    VkDeviceAddress m_DeviceAddress = 0;
+    Scope<VulkanAccelerationStructureBuffer> m_Storage;
+    Scope<VulkanAccelerationStructureBuffer> m_Scratch;    // AllowUpdate only
+    Scope<VulkanAccelerationStructureBuffer> m_Instances;  // Top level: framesInFlight regions
+    VkDeviceSize m_StorageSize = 0;
+    VkDeviceSize m_BuildScratchSize = 0;
+    VkDeviceSize m_UpdateScratchSize = 0;
+
+    // Bottom level: per geometry, fixed at creation. Top level: the one instance geometry.
+    std::vector<VkAccelerationStructureGeometryKHR> m_Geometries;
+    std::vector<VkAccelerationStructureBuildRangeInfoKHR> m_Ranges;
+    uint32 m_InstanceRegion = 0;
+    uint32 m_BuiltInstanceCount = 0;  // Of the last top-level build, which an update must match
+
+    VkQueryPool m_CompactionQueries = VK_NULL_HANDLE;  // One query, AllowCompaction only
+    bool m_CompactionPending = false;
+    uint64 m_CompactedSize = 0;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,62 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanBarrierBatch.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+class VulkanTexture;
+class VulkanBuffer;
+
+// A use of an image or buffer by the next commands
+struct VulkanAccess {
+    VkPipelineStageFlags2KHR stages = 0;
+    VkAccessFlags2KHR access = 0;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;  // UNDEFINED: whatever layout it is in
+};
+
+// The barriers of one transition point, planned from the state each texture subresource
+// and buffer was left in by the commands recorded before (VulkanResourceState). A use
+// needs a barrier only when it changes the layout, writes after earlier accesses, or
+// reads what an earlier write has not been made visible to yet; everything else is
+// dropped. Flush() records what is queued as one vkCmdPipelineBarrier2.
+//
+// States live in the resources, so command buffers must be submitted in the order they
+// were recorded in, from one thread at a time (the render thread).
+class VulkanBarrierBatch {
+public:
+    explicit VulkanBarrierBatch(VulkanContext& context) : m_Context(context) {}
+
+    VulkanBarrierBatch(const VulkanBarrierBatch&) = delete;
+    VulkanBarrierBatch& operator=(const VulkanBarrierBatch&) = delete;
+
+    // Mips [baseMip, baseMip + mipCount) of layers [baseLayer, baseLayer + layerCount).
+    // With discard the contents may be dropped by the layout transition.
+    void Use(VulkanTexture& texture, const VulkanAccess& access, bool discard = false,
+             uint32 baseMip = 0, uint32 mipCount = ~0u, uint32 baseLayer = 0, uint32 layerCount = ~0u);
+    void Use(VulkanBuffer& buffer, const VulkanAccess& access);
+
+    // Commands the batch does not plan for (a render pass's final layout, native recording)
+    // left the subresources in access.layout, written by access
+    void Assume(VulkanTexture& texture, const VulkanAccess& access,
+                uint32 baseMip = 0, uint32 mipCount = ~0u, uint32 baseLayer = 0, uint32 layerCount = ~0u);
+
+    // False when nothing was queued
+    bool Flush(VkCommandBuffer commandBuffer);
+
+private:
+    // Whether state needs a barrier before access, and the state after it
+    static bool Plan(VulkanResourceState& state, const VulkanAccess& access, VkImageLayout layout,
+                     VkPipelineStageFlags2KHR& srcStages, VkAccessFlags2KHR& srcAccess);
+
+    VulkanContext& m_Context;
+    std::vector<VkImageMemoryBarrier2KHR> m_ImageBarriers;
+    std::vector<VkBufferMemoryBarrier2KHR> m_BufferBarriers;
+};
+
+} // namespace rhi
+} // namespace metagfx
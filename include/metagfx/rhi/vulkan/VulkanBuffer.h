@@ -5,6 +5,7 @@
 
 #include "metagfx/rhi/Buffer.h"
 #include "VulkanTypes.h"
+#include "VulkanMemoryAllocator.h"
 
 namespace metagfx {
 namespace rhi {
@@ -17,23 +18,31 @@ public:
     void* Map() override;
     void Unmap() override;
     void CopyData(const void* data, uint64 size, uint64 offset = 0) override;
+    void WriteData(uint64 size, uint64 offset, const WriteCallback& write) override;
+    void* GetMappedPointer() override { return m_Allocation.mappedData; }
     
     uint64 GetSize() const override { return m_Size; }
     BufferUsage GetUsage() const override { return m_Usage; }
+    bool IsUploadComplete() const override;
     
     // Vulkan-specific
     VkBuffer GetHandle() const { return m_Buffer; }
+    // Of buffers created with BufferUsage::AccelerationStructureInput; 0 for others
+    VkDeviceAddress GetDeviceAddress() const;
+    // Of the commands recorded so far (VulkanBarrierBatch); host writes need no barrier
+    VulkanResourceState& GetState() { return m_State; }
 
 private:
     VulkanContext& m_Context;
     VkBuffer m_Buffer = VK_NULL_HANDLE;
-    VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+    VulkanAllocation m_Allocation;
     
     uint64 m_Size = 0;
     BufferUsage m_Usage;
     MemoryUsage m_MemoryUsage;
-    
-    void* m_MappedData = nullptr;
+    MemoryCategory m_MemoryCategory;
+    uint64 m_UploadTicket = 0;  // VulkanUploadTicket of the last staged WriteData()
+    VulkanResourceState m_State;
 };
 
 } // namespace rhi
@@ -5,64 +5,193 @@
 
 #include "metagfx/rhi/CommandBuffer.h"
 #include "VulkanTypes.h"
+#include "VulkanBarrierBatch.h"
+#include "VulkanRenderPassCache.h"
+#include "VulkanAccelerationStructure.h"
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
 
+class VulkanTexture;
+
 class VulkanCommandBuffer : public CommandBuffer {
 public:
-    VulkanCommandBuffer(VulkanContext& context, VkCommandPool commandPool);
+    // With a primary, a secondary command buffer continuing that primary's parallel
+    // render passes
+    VulkanCommandBuffer(VulkanContext& context, VkCommandPool commandPool,
+                        VulkanCommandBuffer* primary = nullptr);
     ~VulkanCommandBuffer() override;
 
     void Begin() override;
     void End() override;
     
-    void BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                       Ref<Texture> depthAttachment,
-                       const std::vector<ClearValue>& clearValues) override;
+    void BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                       const Ref<Texture>& depthAttachment,
+                       std::span<const ClearValue> clearValues,
+                       const RenderPassActions& actions = {},
+                       std::span<const Ref<Texture>> resolveTargets = {},
+                       const Ref<Texture>& shadingRate = nullptr) override;
     void EndRendering() override;
+
+    void BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                const Ref<Texture>& depthAttachment,
+                                std::span<const ClearValue> clearValues,
+                                uint32 secondaryCount,
+                                const RenderPassActions& actions = {},
+                                std::span<const Ref<Texture>> resolveTargets = {},
+                                const Ref<Texture>& shadingRate = nullptr) override;
+    Ref<CommandBuffer> GetSecondaryCommandBuffer(uint32 index) override;
+    void EndParallelRendering() override;
     
-    void BindPipeline(Ref<Pipeline> pipeline) override;
+    void BindPipeline(const Ref<Pipeline>& pipeline) override;
     void SetViewport(const Viewport& viewport) override;
     void SetScissor(const Rect2D& scissor) override;
     
-    void BindVertexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
-    void BindIndexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
+    void BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
+    void BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
     
     void Draw(uint32 vertexCount, uint32 instanceCount = 1,
              uint32 firstVertex = 0, uint32 firstInstance = 0) override;
     void DrawIndexed(uint32 indexCount, uint32 instanceCount = 1,
                     uint32 firstIndex = 0, int32 vertexOffset = 0,
                     uint32 firstInstance = 0) override;
+    void DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                             uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+    void DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                  const Ref<Buffer>& countBuffer, uint64 countOffset, uint32 maxDrawCount,
+                                  uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+
+    void Dispatch(uint32 groupCountX, uint32 groupCountY = 1, uint32 groupCountZ = 1) override;
+    void DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset = 0) override;
     
-    void CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+    void BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds) override;
+    Ref<AccelerationStructure> CompactAccelerationStructure(const Ref<AccelerationStructure>& source) override;
+
+    void CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                    uint64 size, uint64 srcOffset = 0, uint64 dstOffset = 0) override;
+    void CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset = 0) override;
 
     // Abstract interface implementations
-    void BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                           uint32 frameIndex = 0) override;
-    void PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+    using CommandBuffer::BindDescriptorSet;
+    void BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex, const Ref<DescriptorSet>& descriptorSet,
+                           uint32 frameIndex = 0, const uint32* dynamicOffsets = nullptr,
+                           uint32 dynamicOffsetCount = 0) override;
+    void PushDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                           const std::vector<DescriptorBindingDesc>& bindings,
+                           const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0) override;
+    void PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                        uint32 offset, uint32 size, const void* data) override;
-    void BufferMemoryBarrier(Ref<Buffer> buffer) override;
+    void BufferMemoryBarrier(const Ref<Buffer>& buffer) override;
+    void PipelineBarrier(BarrierType type) override;
+    void ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                         const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) override;
+    void InvalidateState() override;
+    void WaitForAsyncCompute() override;
 
     // Vulkan-specific
+    // The handle recording now: the second segment after WaitForAsyncCompute()
     VkCommandBuffer GetHandle() const { return m_CommandBuffer; }
+    // Handles recorded since Begin(), in order; the device submits each after the first
+    // as a batch waiting for the frame's async compute
+    uint32 GetSegmentCount() const { return m_SegmentCount; }
+    VkCommandBuffer GetSegment(uint32 index) const { return m_Segments[index]; }
 
-    // Vulkan-specific overloads (for backward compatibility)
-    void BindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet descriptorSet);
+    // Vulkan-specific overloads (for backward compatibility); bind to the point of the
+    // last bound pipeline
+    void BindDescriptorSet(VkPipelineLayout layout, uint32 setIndex, VkDescriptorSet descriptorSet,
+                           const uint32* dynamicOffsets = nullptr, uint32 dynamicOffsetCount = 0);
     void PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags,
                       uint32 offset, uint32 size, const void* data);
     void BufferMemoryBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
                             VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage,
                             VkAccessFlags srcAccess, VkAccessFlags dstAccess);
+    // Barriers of commands recorded through the native handle: Use() what they access,
+    // FlushBarriers() before them and Assume() the states they leave
+    VulkanBarrierBatch& GetBarriers() { return m_Barriers; }
+    void FlushBarriers();
+    // Timestamp written once the commands recorded before it have completed. False on a
+    // secondary and while a parallel render pass is open, where the primary records nothing.
+    bool WriteTimestamp(VkQueryPool queryPool, uint32 query);
 
 private:
+    // VK_KHR_dynamic_rendering path of BeginRendering()
+    void BeginDynamicRendering(const Ref<VulkanTexture>& colorTexture,
+                               const Ref<VulkanTexture>& depthTexture,
+                               const Ref<VulkanTexture>& resolveTexture,
+                               const Ref<VulkanTexture>& shadingRateTexture,
+                               uint32 width, uint32 height,
+                               const VkClearValue& colorClear,
+                               const VkClearValue& depthClear,
+                               const RenderPassActions& actions);
+    // Memory barrier around acceleration structure builds and copies
+    void AccelerationStructureBarrier(VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                                      VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
     VulkanContext& m_Context;
     VkCommandPool m_CommandPool;
-    VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;
-    VkRenderPass m_CurrentRenderPass = VK_NULL_HANDLE;
-    VkFramebuffer m_CurrentFramebuffer = VK_NULL_HANDLE;
+    VkCommandBuffer m_CommandBuffer = VK_NULL_HANDLE;  // m_Segments[m_SegmentCount - 1]
+    // The allocated handle, and the one WaitForAsyncCompute() continues in (allocated on
+    // first use, from the same pool)
+    VkCommandBuffer m_Segments[2] = {};
+    uint32 m_SegmentCount = 1;
     bool m_IsRecording = false;
+    bool m_InsideRenderPass = false;
+    VkPipelineBindPoint m_BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;  // Of the last bound pipeline
+    VulkanTexture* m_DynamicColorTexture = nullptr;  // Transitioned to PRESENT_SRC in EndRendering()
+    VulkanTexture* m_DynamicResolveTexture = nullptr;  // Likewise
+    VulkanBarrierBatch m_Barriers;
+    VulkanRenderPassKey m_RenderPassKey;  // Reused by BeginRendering() without dynamic rendering
+    VulkanFramebufferKey m_FramebufferKey;
+    // Scratch of the acceleration structure batches recorded since Begin()
+    std::vector<Scope<VulkanAccelerationStructureBuffer>> m_BuildScratch;
+
+    // Secondaries of BeginParallelRendering(), each allocated from its own pool so worker
+    // threads never share one. The pools are reset by the primary's Begin(), once the
+    // GPU is done with what it executed.
+    struct Secondary {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        Ref<VulkanCommandBuffer> commandBuffer;
+    };
+    std::vector<Secondary> m_Secondaries;
+    uint32 m_ActiveSecondaryCount = 0;
+    VulkanCommandBuffer* m_Primary = nullptr;  // Set on secondaries
+
+    // What the secondaries of the open parallel pass inherit
+    bool m_SecondaryContents = false;  // Set by BeginParallelRendering() around BeginRendering()
+    VkRenderPass m_InheritedRenderPass = VK_NULL_HANDLE;  // Null with dynamic rendering
+    VkFramebuffer m_InheritedFramebuffer = VK_NULL_HANDLE;
+    VkFormat m_InheritedColorFormat = VK_FORMAT_UNDEFINED;
+    VkFormat m_InheritedDepthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits m_InheritedSamples = VK_SAMPLE_COUNT_1_BIT;
+    uint32 m_InheritedViewMask = 0;  // Of the open pass, multiview or not
+
+    // Bound state, per bind point (0 graphics, 1 compute) where Vulkan keeps it apart.
+    // Command buffer state persists across render passes, so it is reset only by
+    // Begin() and InvalidateState().
+    static constexpr uint32 MAX_PUSH_CONSTANT_SIZE = 128;  // Guaranteed maxPushConstantsSize
+    uint32 BindPointIndex() const { return m_BindPoint == VK_PIPELINE_BIND_POINT_COMPUTE ? 1 : 0; }
+
+    VkPipeline m_BoundPipelines[2] = {};
+    // Per set, with the layout it was bound through
+    VkPipelineLayout m_BoundSetLayouts[2][MAX_DESCRIPTOR_SETS] = {};
+    VkDescriptorSet m_BoundSets[2][MAX_DESCRIPTOR_SETS] = {};
+    BoundDynamicOffsets m_BoundOffsets[2][MAX_DESCRIPTOR_SETS];
+    VkBuffer m_BoundVertexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_BoundVertexOffset = 0;
+    VkBuffer m_BoundIndexBuffer = VK_NULL_HANDLE;
+    VkDeviceSize m_BoundIndexOffset = 0;
+    Viewport m_BoundViewport{};
+    Rect2D m_BoundScissor{};
+    bool m_ViewportBound = false;
+    bool m_ScissorBound = false;
+
+    // Last pushed bytes and the stages known to hold each one, under m_PushConstantLayout.
+    // Binding a pipeline with another layout makes the values undefined.
+    VkPipelineLayout m_PushConstantLayout = VK_NULL_HANDLE;
+    uint8 m_PushConstantData[MAX_PUSH_CONSTANT_SIZE] = {};
+    VkShaderStageFlags m_PushConstantStages[MAX_PUSH_CONSTANT_SIZE] = {};
+    void ResetPushConstantState(VkPipelineLayout layout);
 };
 
 } // namespace rhi
@@ -0,0 +1,31 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanComputePipeline.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/Pipeline.h"
+#include "VulkanTypes.h"
+
+namespace metagfx {
+namespace rhi {
+
+class VulkanComputePipeline : public Pipeline {
+public:
+    VulkanComputePipeline(VulkanContext& context, const ComputePipelineDesc& desc,
+                          VkDescriptorSetLayout descriptorSetLayout);
+    ~VulkanComputePipeline() override;
+
+    PipelineBindPoint GetBindPoint() const override { return PipelineBindPoint::Compute; }
+
+    // Vulkan-specific
+    VkPipeline GetHandle() const { return m_Pipeline; }
+    VkPipelineLayout GetLayout() const { return m_Layout; }
+
+private:
+    VulkanContext& m_Context;
+    VkPipeline m_Pipeline = VK_NULL_HANDLE;
+    VkPipelineLayout m_Layout = VK_NULL_HANDLE;  // Shared, owned by VulkanDescriptorCache
+};
+
+} // namespace rhi
+} // namespace metagfx
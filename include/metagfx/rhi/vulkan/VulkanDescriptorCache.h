@@ -0,0 +1,116 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanDescriptorCache.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Binding signature of a descriptor set layout, sorted by binding number. Arrays
+// (count > 1) are partially bound texture tables. Push descriptor layouts are never
+// allocated from a pool.
+struct VulkanSetLayoutKey {
+    struct Binding {
+        uint32 binding = 0;
+        VkDescriptorType type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        uint32 count = 1;
+        VkShaderStageFlags stages = 0;
+
+        bool operator==(const Binding& other) const {
+            return binding == other.binding && type == other.type && count == other.count && stages == other.stages;
+        }
+    };
+    std::vector<Binding> bindings;
+    bool pushDescriptors = false;  // VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR
+
+    bool operator==(const VulkanSetLayoutKey& other) const {
+        return bindings == other.bindings && pushDescriptors == other.pushDescriptors;
+    }
+};
+
+// Set layouts, by set number, plus push constant range; pipelines with equal keys share a
+// VkPipelineLayout
+struct VulkanPipelineLayoutKey {
+    std::vector<VkDescriptorSetLayout> setLayouts;
+    VkShaderStageFlags pushConstantStages = 0;
+    uint32 pushConstantSize = 0;
+
+    bool operator==(const VulkanPipelineLayoutKey& other) const {
+        return setLayouts == other.setLayouts && pushConstantStages == other.pushConstantStages &&
+               pushConstantSize == other.pushConstantSize;
+    }
+};
+
+struct VulkanSetLayoutKeyHash {
+    size_t operator()(const VulkanSetLayoutKey& key) const;
+};
+
+struct VulkanPipelineLayoutKeyHash {
+    size_t operator()(const VulkanPipelineLayoutKey& key) const;
+};
+
+// Device-owned descriptor set layouts, pipeline layouts and descriptor pools.
+//
+// Layouts are deduplicated: descriptor sets with the same binding signature get the same
+// VkDescriptorSetLayout, and pipelines over it with the same push constant range the same
+// VkPipelineLayout. Both live until the device is destroyed. Since pipelines then share
+// layouts, bound descriptor sets and push constants stay valid across pipeline switches
+// and VulkanCommandBuffer filters the rebinds; pipelines whose layouts agree on sets
+// 0..n keep those bound even where their higher sets differ.
+//
+// Sets are allocated from shared pools of SETS_PER_POOL sets and more, each new pool
+// twice the size of the last, up to MAX_SETS_PER_POOL. Sets needing more descriptors of a
+// type than a shared pool holds (large texture tables) get a pool of their own, destroyed
+// with them. Thread-safe.
+class VulkanDescriptorCache {
+public:
+    static constexpr uint32 SETS_PER_POOL = 256;
+    static constexpr uint32 MAX_SETS_PER_POOL = 4096;
+
+    explicit VulkanDescriptorCache(VulkanContext& context);
+    ~VulkanDescriptorCache();
+
+    VulkanDescriptorCache(const VulkanDescriptorCache&) = delete;
+    VulkanDescriptorCache& operator=(const VulkanDescriptorCache&) = delete;
+
+    VkDescriptorSetLayout GetSetLayout(const VulkanSetLayoutKey& key);
+    VkPipelineLayout GetPipelineLayout(const VulkanPipelineLayoutKey& key);
+
+    // Allocates count sets of the layout created from key into outSets and returns the pool
+    // they came from, which FreeSets() takes back; null on failure
+    VkDescriptorPool AllocateSets(const VulkanSetLayoutKey& key, uint32 count, VkDescriptorSet* outSets);
+    void FreeSets(VkDescriptorPool pool, uint32 count, const VkDescriptorSet* sets);
+
+    size_t GetSetLayoutCount() const;
+    size_t GetPipelineLayoutCount() const;
+    size_t GetPoolCount() const;
+
+private:
+    struct Pool {
+        VkDescriptorPool pool = VK_NULL_HANDLE;
+        uint32 maxSets = 0;
+        uint32 liveSets = 0;
+        bool dedicated = false;
+    };
+
+    VkDescriptorSetLayout GetSetLayoutLocked(const VulkanSetLayoutKey& key);
+    bool TryAllocate(Pool& pool, VkDescriptorSetLayout layout, uint32 count, VkDescriptorSet* outSets);
+    VkDescriptorPool CreatePool(uint32 maxSets, const std::vector<VkDescriptorPoolSize>& sizes, bool dedicated);
+    // Descriptors of each type a shared pool of maxSets sets holds
+    std::vector<VkDescriptorPoolSize> GetSharedPoolSizes(uint32 maxSets) const;
+
+    VulkanContext& m_Context;
+    mutable std::mutex m_Mutex;
+    std::unordered_map<VulkanSetLayoutKey, VkDescriptorSetLayout, VulkanSetLayoutKeyHash> m_SetLayouts;
+    std::unordered_map<VulkanPipelineLayoutKey, VkPipelineLayout, VulkanPipelineLayoutKeyHash> m_PipelineLayouts;
+    std::vector<Pool> m_Pools;  // Shared pools in creation order, dedicated ones among them
+    uint32 m_NextPoolSize = SETS_PER_POOL;
+};
+
+} // namespace rhi
+} // namespace metagfx
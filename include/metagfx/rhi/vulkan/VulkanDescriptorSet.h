@@ -5,7 +5,9 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/DescriptorSet.h"
+#include "VulkanDescriptorCache.h"
 #include "VulkanTypes.h"
+#include <mutex>
 #include <vector>
 
 namespace metagfx {
@@ -15,6 +17,7 @@ namespace rhi {
 class Buffer;
 class Texture;
 class Sampler;
+class AccelerationStructure;
 
 // Legacy Vulkan-specific binding struct (for backward compatibility)
 struct DescriptorBinding {
@@ -26,6 +29,14 @@ struct DescriptorBinding {
     Ref<Buffer> buffer;    // For uniform/storage buffers
     Ref<Texture> texture;  // For combined image samplers
     Ref<Sampler> sampler;  // For combined image samplers
+    VkDeviceSize range = 0;  // 0 = whole buffer (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC needs the slice size)
+
+    // Texture tables (count > 1): partially bound, one texture/sampler per element
+    uint32 count = 1;
+    std::vector<Ref<Texture>> arrayTextures;
+    std::vector<Ref<Sampler>> arraySamplers;
+
+    Ref<AccelerationStructure> accelerationStructure;  // VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR
 };
 
 class VulkanDescriptorSet : public DescriptorSet {
@@ -38,32 +49,50 @@ public:
 
     ~VulkanDescriptorSet() override;
 
-    // DescriptorSet interface implementation
-    void UpdateBuffer(uint32 binding, Ref<Buffer> buffer) override;
-    void UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) override;
+    // DescriptorSet interface implementation. Updates only record the new resource and
+    // mark the binding dirty; nothing is written until FlushUpdates().
+    void UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) override;
+    void UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
+    void UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                   const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
+    void UpdateAccelerationStructure(uint32 binding, const Ref<AccelerationStructure>& structure) override;
     void* GetNativeHandle(uint32 frameIndex) const override;
     void* GetNativeLayout() const override;
 
-    // Vulkan-specific accessors (for internal use)
+    // Convert backend-agnostic types to Vulkan types
+    static VkDescriptorType ToVulkanDescriptorType(DescriptorType type);
+    static VkShaderStageFlags ToVulkanShaderStage(ShaderStage stage);
+
+    // Vulkan-specific accessors (for internal use). Push descriptor sets have no sets.
     VkDescriptorSetLayout GetLayout() const { return m_Layout; }
     VkDescriptorSet GetSet(uint32 frameIndex) const { return m_DescriptorSets[frameIndex]; }
+    bool IsPushDescriptorSet() const { return m_LayoutKey.pushDescriptors; }
+
+    // Write the bindings that changed since this frame's set was last flushed, in a single
+    // vkUpdateDescriptorSets call. Called by VulkanCommandBuffer::BindDescriptorSet, so it runs
+    // once the frame's fence has been waited on; the set must not already be bound in the
+    // command buffer being recorded (use one set per material instead of re-updating).
+    void FlushUpdates(uint32 frameIndex);
 
 private:
     void CreateLayout(const std::vector<DescriptorBinding>& bindings);
     void AllocateSets();
-    void UpdateSets(const std::vector<DescriptorBinding>& bindings);
-
-    // Convert backend-agnostic types to Vulkan types
-    static VkDescriptorType ToVulkanDescriptorType(DescriptorType type);
-    static VkShaderStageFlags ToVulkanShaderStage(ShaderStage stage);
+    void WriteAllSets();
+    void WriteBindings(uint32 frameIndex, uint64 mask);
+    void MarkDirty(uint32 binding);
 
     VulkanContext& m_Context;
-    VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;
-    VkDescriptorPool m_Pool = VK_NULL_HANDLE;
+    VulkanSetLayoutKey m_LayoutKey;
+    VkDescriptorSetLayout m_Layout = VK_NULL_HANDLE;  // Shared, owned by VulkanDescriptorCache
+    VkDescriptorPool m_Pool = VK_NULL_HANDLE;         // The cache's pool the sets came from
     std::vector<VkDescriptorSet> m_DescriptorSets;
     std::vector<DescriptorBinding> m_Bindings;
 
-    static constexpr uint32 MAX_FRAMES = 2;
+    // One set per frame in flight (VulkanContext::framesInFlight), allocated from m_Pool.
+    // Per-frame bitmask of m_Bindings indices (not binding numbers) awaiting a write.
+    // Secondary command buffers may bind (and flush) the set from several threads.
+    uint64 m_DirtyMasks[MAX_FRAMES_IN_FLIGHT] = {};
+    std::mutex m_FlushMutex;
 };
 
 } // namespace rhi
@@ -6,15 +6,29 @@
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "VulkanTypes.h"
 #include <SDL3/SDL.h>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace metagfx {
 namespace rhi {
 
+class VulkanRenderPassCache;
+class VulkanMemoryAllocator;
+class VulkanUploadManager;
+class VulkanPipelineCache;
+class VulkanPipelineLibraryCache;
+class VulkanDescriptorCache;
+class VulkanTimeline;
+
 class VulkanDevice : public GraphicsDevice {
 public:
-    VulkanDevice(SDL_Window* window);
+    VulkanDevice(SDL_Window* window, const GraphicsDeviceDesc& desc);
     ~VulkanDevice() override;
 
+    // The physical devices of a bare instance (rhi::EnumerateAdapters())
+    static std::vector<AdapterInfo> EnumerateAdapters();
+
     // GraphicsDevice interface
     const DeviceInfo& GetDeviceInfo() const override { return m_DeviceInfo; }
     
@@ -22,43 +36,82 @@ public:
     Ref<Texture> CreateTexture(const TextureDesc& desc) override;
     Ref<Sampler> CreateSampler(const SamplerDesc& desc) override;
     Ref<Shader> CreateShader(const ShaderDesc& desc) override;
-    Ref<Pipeline> CreateGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<Pipeline> CreateComputePipeline(const ComputePipelineDesc& desc) override;
     Ref<Framebuffer> CreateFramebuffer(const FramebufferDesc& desc) override;
     Ref<DescriptorSet> CreateDescriptorSet(const DescriptorSetDesc& desc) override;
 
     Ref<CommandBuffer> CreateCommandBuffer() override;
+    FrameContext BeginFrame() override;
     void SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) override;
+    void SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer) override;
+    Ref<AccelerationStructure> CreateAccelerationStructure(const AccelerationStructureDesc& desc) override;
+    Ref<GpuProfiler> CreateGpuProfiler() override;
+    MemoryBudget GetMemoryBudget() const override;
     
     void WaitIdle() override;
+    uint64 SignalValue() const override;
+    uint64 GetCompletedFrameValue() const override;
+    void WaitValue(uint64 value) override;
     
     Ref<SwapChain> GetSwapChain() override { return m_SwapChain; }
     
     // Vulkan-specific
     VulkanContext& GetContext() { return m_Context; }
+    VulkanRenderPassCache& GetRenderPassCache() { return *m_RenderPassCache; }
+    VulkanMemoryAllocator& GetMemoryAllocator() { return *m_MemoryAllocator; }
+    VulkanUploadManager& GetUploadManager() { return *m_UploadManager; }
+    VulkanPipelineCache& GetPipelineCache() { return *m_PipelineCache; }
+    VulkanDescriptorCache& GetDescriptorCache() { return *m_DescriptorCache; }
     uint32 FindMemoryType(uint32 typeFilter, VkMemoryPropertyFlags properties);
 
-    // Descriptor set layout management (abstract interface)
-    void SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) override;
-
-    // Vulkan-specific descriptor set layout access
-    void SetDescriptorSetLayout(VkDescriptorSetLayout layout) { m_DescriptorSetLayout = layout; }
-    VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+protected:
+    Ref<Pipeline> CompileGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<PipelineFuture> CompileGraphicsPipelineAsync(const PipelineDesc& desc) override;
+    void AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const override;
 
 private:
+    // Layout of the set, or the shared empty one without
+    VkDescriptorSetLayout ResolveSetLayout(const Ref<DescriptorSet>& descriptorSet) const;
+    // Set 0's, then desc.extraSetLayouts'
+    std::vector<VkDescriptorSetLayout> ResolveSetLayouts(const PipelineDesc& desc) const;
+
     void CreateInstance(SDL_Window* window);
-    void PickPhysicalDevice();
+    void PickPhysicalDevice(uint32 adapterIndex);
     void CreateLogicalDevice();
+    bool IsDeviceExtensionSupported(const char* extensionName) const;
     void CreateCommandPool();
+    // Of CreateCommandBuffer() on the calling thread; command pools are externally synchronized
+    VkCommandPool GetThreadCommandPool();
+    // Attachment formats of a pipeline and, without dynamic rendering, its compatible render pass
+    void ResolvePipelineTargets(const PipelineDesc& desc, std::vector<VkFormat>& colorFormats,
+                                VkFormat& depthFormat, VkRenderPass& renderPass);
 
     VulkanContext m_Context;
     DeviceInfo m_DeviceInfo;
     
-    VkCommandPool m_CommandPool = VK_NULL_HANDLE;
+    std::mutex m_CommandPoolMutex;
+    std::unordered_map<std::thread::id, VkCommandPool> m_ThreadCommandPools;
+    uint32 m_TimestampValidBits = 0;  // Of the graphics queue family; 0 without timestamps
+
+    // One transient pool per frame in flight, reset wholesale once the frame's timeline value signals
+    std::vector<VkCommandPool> m_FrameCommandPools;
+    std::vector<Ref<CommandBuffer>> m_FrameCommandBuffers;
+    // Async compute command buffers, from the same pools; empty without a compute queue
+    std::vector<Ref<CommandBuffer>> m_FrameComputeCommandBuffers;
+
+    Scope<VulkanTimeline> m_ComputeTimeline;  // Of the async compute queue; null without one
+    uint64 m_PendingComputeValue = 0;         // Of the frame's compute submission, until its graphics one waits for it
+
+    Scope<VulkanTimeline> m_Timeline;
+    Scope<VulkanRenderPassCache> m_RenderPassCache;
+    Scope<VulkanMemoryAllocator> m_MemoryAllocator;
+    Scope<VulkanUploadManager> m_UploadManager;
+    Scope<VulkanPipelineCache> m_PipelineCache;
+    Scope<VulkanPipelineLibraryCache> m_PipelineLibraries;  // Null without DeviceInfo::supportsPipelineLibraries
+    Scope<VulkanDescriptorCache> m_DescriptorCache;
     
     Ref<SwapChain> m_SwapChain;
     SDL_Window* m_Window = nullptr;
-
-    VkDescriptorSetLayout m_DescriptorSetLayout = VK_NULL_HANDLE;
 };
 
 } // namespace rhi
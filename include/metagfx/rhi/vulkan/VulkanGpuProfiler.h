@@ -0,0 +1,32 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanGpuProfiler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/GpuProfiler.h"
+#include "VulkanTypes.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Timestamp query pool with GpuProfiler::MAX_QUERIES queries per frame slot. Timestamps
+// are written at the bottom of the pipe and read without waiting, with availability.
+class VulkanGpuProfiler : public GpuProfiler {
+public:
+    VulkanGpuProfiler(VulkanContext& context, uint32 frameCount, uint32 timestampValidBits);
+    ~VulkanGpuProfiler() override;
+
+protected:
+    void ResetQueries(CommandBuffer& cmd, uint32 frameIndex) override;
+    bool WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) override;
+    bool ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) override;
+
+private:
+    VulkanContext& m_Context;
+    VkQueryPool m_QueryPool = VK_NULL_HANDLE;
+    uint64 m_TimestampMask = ~0ull;      // Bits the graphics queue writes
+    double m_TimestampPeriod = 1.0;      // Nanoseconds per tick
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,150 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanMemoryAllocator.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <mutex>
+#include <set>
+#include <unordered_map>
+
+namespace metagfx {
+namespace rhi {
+
+// How a block hands out memory
+enum class VulkanAllocationStrategy {
+    Buddy,   // Power-of-two nodes, fast free + coalescing; used for long-lived resources
+    Linear   // Bump pointer, whole block recycled once empty; used for short-lived staging
+};
+
+// Buffers and optimal-tiling images must not share a bufferImageGranularity page
+enum class VulkanResourceKind {
+    Buffer,
+    Image
+};
+
+class VulkanMemoryBlock;
+
+// A sub-range of a VkDeviceMemory block (or a dedicated allocation)
+struct VulkanAllocation {
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkDeviceSize offset = 0;
+    VkDeviceSize size = 0;
+    void* mappedData = nullptr;  // Already offset; only set for host-visible memory
+    uint32 memoryTypeIndex = 0;
+    VulkanMemoryBlock* block = nullptr;  // nullptr for dedicated allocations
+
+    bool IsValid() const { return memory != VK_NULL_HANDLE; }
+};
+
+struct VulkanMemoryStats {
+    uint32 blockCount = 0;
+    uint32 dedicatedAllocationCount = 0;
+    uint32 allocationCount = 0;
+    uint64 bytesReserved = 0;     // Device memory obtained from the driver
+    uint64 bytesInUse = 0;        // Sum of the requested allocation sizes
+    uint64 bytesFree = 0;         // Unused space inside blocks
+    uint64 largestFreeRange = 0;
+    float fragmentation = 0.0f;   // 0 = every block's free space is one contiguous range
+};
+
+// One large VkDeviceMemory allocation that resources are placed into
+class VulkanMemoryBlock {
+public:
+    VulkanMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32 memoryTypeIndex,
+                      VulkanAllocationStrategy strategy, VkDeviceSize minNodeSize, void* mappedData);
+
+    bool Allocate(VkDeviceSize size, VkDeviceSize alignment, VulkanResourceKind kind,
+                  VkDeviceSize granularity, VkDeviceSize& outOffset);
+    void Free(VkDeviceSize offset, VkDeviceSize size);
+
+    VkDeviceMemory GetMemory() const { return m_Memory; }
+    VkDeviceSize GetSize() const { return m_Size; }
+    uint32 GetMemoryTypeIndex() const { return m_MemoryTypeIndex; }
+    VulkanAllocationStrategy GetStrategy() const { return m_Strategy; }
+    void* GetMappedData() const { return m_MappedData; }
+
+    bool IsEmpty() const { return m_AllocationCount == 0; }
+    uint32 GetAllocationCount() const { return m_AllocationCount; }
+    VkDeviceSize GetBytesInUse() const { return m_BytesInUse; }
+    VkDeviceSize GetFreeBytes() const;
+    VkDeviceSize GetLargestFreeRange() const;
+
+private:
+    bool AllocateBuddy(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+    void FreeBuddy(VkDeviceSize offset);
+
+    VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+    VkDeviceSize m_Size = 0;
+    uint32 m_MemoryTypeIndex = 0;
+    VulkanAllocationStrategy m_Strategy;
+    void* m_MappedData = nullptr;
+
+    uint32 m_AllocationCount = 0;
+    VkDeviceSize m_BytesInUse = 0;
+
+    // Buddy state: free node offsets per order (order 0 = m_MinNodeSize)
+    VkDeviceSize m_MinNodeSize = 0;
+    uint32 m_MaxOrder = 0;
+    VkDeviceSize m_BytesReserved = 0;
+    std::vector<std::set<VkDeviceSize>> m_FreeLists;
+    std::unordered_map<VkDeviceSize, uint32> m_AllocatedOrders;
+
+    // Linear state
+    VkDeviceSize m_LinearOffset = 0;
+    VulkanResourceKind m_LastKind = VulkanResourceKind::Buffer;
+};
+
+// Device-owned sub-allocator. Resources are placed into large per-memory-type blocks
+// instead of each getting its own vkAllocateMemory (which is slow and limited by
+// maxMemoryAllocationCount). Host-visible blocks are persistently mapped.
+// Requests larger than half a block get a dedicated allocation.
+class VulkanMemoryAllocator {
+public:
+    explicit VulkanMemoryAllocator(VulkanContext& context);
+    ~VulkanMemoryAllocator();
+
+    VulkanMemoryAllocator(const VulkanMemoryAllocator&) = delete;
+    VulkanMemoryAllocator& operator=(const VulkanMemoryAllocator&) = delete;
+
+    // Allocate memory for the resource and bind it. Returns false (and logs) on failure.
+    bool AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties, VulkanAllocation& outAllocation,
+                        VulkanAllocationStrategy strategy = VulkanAllocationStrategy::Buddy);
+    bool AllocateImage(VkImage image, VkMemoryPropertyFlags properties, VulkanAllocation& outAllocation,
+                       VulkanAllocationStrategy strategy = VulkanAllocationStrategy::Buddy);
+
+    bool Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                  VulkanResourceKind kind, VulkanAllocationStrategy strategy, VulkanAllocation& outAllocation);
+    void Free(VulkanAllocation& allocation);
+
+    // Make CPU writes visible to the GPU (no-op for HOST_COHERENT memory)
+    void Flush(const VulkanAllocation& allocation, VkDeviceSize offset, VkDeviceSize size);
+
+    VulkanMemoryStats GetStats() const;
+    void LogStats() const;
+
+private:
+    struct MemoryPool {
+        std::vector<Scope<VulkanMemoryBlock>> buddyBlocks;
+        std::vector<Scope<VulkanMemoryBlock>> linearBlocks;
+    };
+
+    bool FindMemoryType(uint32 typeBits, VkMemoryPropertyFlags properties, uint32& outIndex) const;
+    VkDeviceSize GetBlockSize(uint32 memoryTypeIndex) const;
+    bool IsHostVisible(uint32 memoryTypeIndex) const;
+    VkDeviceMemory AllocateDeviceMemory(VkDeviceSize size, uint32 memoryTypeIndex, void** outMapped);
+    bool AllocateDedicated(const VkMemoryRequirements& requirements, uint32 memoryTypeIndex,
+                           VulkanAllocation& outAllocation);
+
+    VulkanContext& m_Context;
+    VkDeviceSize m_BufferImageGranularity = 1;
+    std::vector<MemoryPool> m_Pools;  // Indexed by memory type
+
+    uint32 m_DedicatedAllocationCount = 0;
+    uint64 m_DedicatedBytes = 0;
+
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -6,25 +6,86 @@
 #include "metagfx/rhi/Pipeline.h"
 #include "VulkanTypes.h"
 
+#include <atomic>
+
 namespace metagfx {
 namespace rhi {
 
+class VulkanPipelineLibrary;
+
+// The shader stages and fixed-function state of a PipelineDesc as Vulkan create infos.
+// They point into each other, so the state is neither copied nor moved. Whole pipelines
+// take all of it, pipeline libraries the part they compile.
+struct VulkanGraphicsPipelineState {
+    // renderPass may be VK_NULL_HANDLE when dynamic rendering is enabled; the
+    // attachment formats are then passed through VkPipelineRenderingCreateInfo.
+    VulkanGraphicsPipelineState(const VulkanContext& context, const PipelineDesc& desc, VkRenderPass renderPass,
+                                const std::vector<VkFormat>& colorFormats, VkFormat depthFormat);
+
+    VulkanGraphicsPipelineState(const VulkanGraphicsPipelineState&) = delete;
+    VulkanGraphicsPipelineState& operator=(const VulkanGraphicsPipelineState&) = delete;
+
+    // Chains renderingInfo (and the shading rate state) to info, and sets the render
+    // pass and the flags they need
+    void ChainRendering(VkGraphicsPipelineCreateInfo& info);
+
+    VkPipelineShaderStageCreateInfo vertexStage{};
+    VkPipelineShaderStageCreateInfo fragmentStage{};
+    bool hasFragmentShader = false;  // Depth-only pipelines have none
+    std::vector<VkSpecializationMapEntry> specializationEntries;
+    VkSpecializationInfo specializationInfo{};
+
+    std::vector<VkVertexInputAttributeDescription> attributes;
+    VkVertexInputBindingDescription binding{};
+    VkPipelineVertexInputStateCreateInfo vertexInput{};
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
+    VkPipelineViewportStateCreateInfo viewport{};
+    VkPipelineRasterizationStateCreateInfo rasterizer{};
+    VkPipelineMultisampleStateCreateInfo multisampling{};
+    VkPipelineDepthStencilStateCreateInfo depthStencil{};
+    std::vector<VkPipelineColorBlendAttachmentState> blendAttachments;
+    VkPipelineColorBlendStateCreateInfo colorBlending{};
+    VkDynamicState dynamicStates[2] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamicState{};
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    std::vector<VkFormat> colorFormats;
+    VkPipelineRenderingCreateInfoKHR renderingInfo{};
+    VkPipelineFragmentShadingRateStateCreateInfoKHR shadingRateState{};
+    bool shadingRateImage = false;
+};
+
+// The layout every graphics pipeline over setLayouts shares (VulkanDescriptorCache)
+VkPipelineLayout GetGraphicsPipelineLayout(VulkanContext& context, const std::vector<VkDescriptorSetLayout>& setLayouts);
+
 class VulkanPipeline : public Pipeline {
 public:
-    VulkanPipeline(VulkanContext& context, const PipelineDesc& desc, 
-                   VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout);
+    // Compiled whole. setLayouts are those of sets 0 and up.
+    VulkanPipeline(VulkanContext& context, const PipelineDesc& desc,
+                   VkRenderPass renderPass, const std::vector<VkDescriptorSetLayout>& setLayouts,
+                   const std::vector<VkFormat>& colorFormats, VkFormat depthFormat);
+    // Fast-linked from pipeline libraries compiled with layout, one of each part
+    // (VulkanPipelineLibraryCache); Optimize() links them again with link-time optimization
+    VulkanPipeline(VulkanContext& context, VkPipelineLayout layout, std::vector<Ref<VulkanPipelineLibrary>> libraries);
     ~VulkanPipeline() override;
 
-    // Vulkan-specific
-    VkPipeline GetHandle() const { return m_Pipeline; }
+    // Vulkan-specific. The handle changes once when Optimize() finishes; command buffers
+    // take it when they bind the pipeline.
+    VkPipeline GetHandle() const { return m_Pipeline.load(std::memory_order_acquire); }
     VkPipelineLayout GetLayout() const { return m_Layout; }
 
+    // Fast-linked pipelines only: links the libraries with link-time optimization and
+    // swaps the result in for later binds, then releases the libraries. Any thread, once.
+    void Optimize();
+
 private:
     VulkanContext& m_Context;
-    VkPipeline m_Pipeline = VK_NULL_HANDLE;
-    VkPipelineLayout m_Layout = VK_NULL_HANDLE;
+    std::atomic<VkPipeline> m_Pipeline{VK_NULL_HANDLE};
+    // Kept after Optimize(), as command buffers recorded before may still bind it
+    VkPipeline m_FastLinked = VK_NULL_HANDLE;
+    VkPipelineLayout m_Layout = VK_NULL_HANDLE;  // Shared, owned by VulkanDescriptorCache
+    std::vector<Ref<VulkanPipelineLibrary>> m_Libraries;  // Until Optimize()
 };
 
 } // namespace rhi
 } // namespace metagfx
-
@@ -0,0 +1,54 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanPipelineCache.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <atomic>
+#include <string>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned VkPipelineCache persisted to disk, so pipelines compiled by an earlier run
+// are not compiled again. Every graphics and compute pipeline is created through it.
+//
+// The file is the driver's cache blob behind a small header. It is only loaded when the
+// header matches this GPU: vendor ID, device ID, driver version and pipeline cache UUID
+// (the Vulkan cache header does not carry the driver version). Anything else starts an
+// empty cache, which overwrites the file on the next save.
+//
+// The blob is written back at shutdown and every SAVE_INTERVAL_FRAMES frames while new
+// pipelines keep being created. With an empty path the cache only lives in memory.
+class VulkanPipelineCache {
+public:
+    static constexpr uint32 SAVE_INTERVAL_FRAMES = 1800;
+
+    VulkanPipelineCache(VulkanContext& context, const std::string& filePath);
+    ~VulkanPipelineCache();  // Saves
+
+    VulkanPipelineCache(const VulkanPipelineCache&) = delete;
+    VulkanPipelineCache& operator=(const VulkanPipelineCache&) = delete;
+
+    VkPipelineCache GetHandle() const { return m_Cache; }
+
+    // Called by pipeline constructors after creating a pipeline through the cache
+    void MarkDirty() { m_Dirty.store(true, std::memory_order_relaxed); }
+
+    // Called once per frame; saves every SAVE_INTERVAL_FRAMES frames if anything changed
+    void Tick();
+
+    bool Save();
+
+private:
+    bool Load(std::vector<uint8>& outData) const;
+
+    VulkanContext& m_Context;
+    VkPipelineCache m_Cache = VK_NULL_HANDLE;
+    std::string m_FilePath;
+    std::atomic<bool> m_Dirty{false};
+    uint32 m_FramesSinceSave = 0;
+};
+
+} // namespace rhi
+} // namespace metagfx
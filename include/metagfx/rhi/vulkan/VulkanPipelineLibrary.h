@@ -0,0 +1,102 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanPipelineLibrary.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/Pipeline.h"
+#include "VulkanTypes.h"
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace metagfx {
+namespace rhi {
+
+class Shader;
+class VulkanPipeline;
+
+// The parts VK_EXT_graphics_pipeline_library splits a graphics pipeline into
+enum class VulkanPipelineLibraryPart : uint8 {
+    VertexInput,       // Vertex layout and topology
+    PreRasterization,  // Vertex shader, rasterization, viewport and dynamic state
+    FragmentShader,    // Fragment shader (none when depth-only), depth and multisample state
+    FragmentOutput,    // Attachment formats, blend and multisample state
+    Count
+};
+
+// One part of a graphics pipeline, compiled on its own and kept for link-time optimization
+class VulkanPipelineLibrary {
+public:
+    VulkanPipelineLibrary(VulkanContext& context, VkPipeline library, VkPipelineCreateFlags linkFlags)
+        : m_Context(context), m_Library(library), m_LinkFlags(linkFlags) {}
+    ~VulkanPipelineLibrary();
+
+    VulkanPipelineLibrary(const VulkanPipelineLibrary&) = delete;
+    VulkanPipelineLibrary& operator=(const VulkanPipelineLibrary&) = delete;
+
+    VkPipeline GetHandle() const { return m_Library; }
+    // Flags the linked pipeline needs too, e.g. for a shading rate attachment
+    VkPipelineCreateFlags GetLinkFlags() const { return m_LinkFlags; }
+
+private:
+    VulkanContext& m_Context;
+    VkPipeline m_Library = VK_NULL_HANDLE;
+    VkPipelineCreateFlags m_LinkFlags = 0;
+};
+
+// Links one library of each part into a pipeline: a fast link, or with optimize one as
+// fast to run as a pipeline compiled whole. VK_NULL_HANDLE on failure.
+VkPipeline LinkPipelineLibraries(VulkanContext& context, VkPipelineLayout layout,
+                                 const std::vector<Ref<VulkanPipelineLibrary>>& libraries, bool optimize);
+
+/**
+ * @brief Graphics pipelines fast-linked from shared pipeline libraries
+ *
+ * Each part of a PipelineDesc is compiled once as a library and shared by every desc
+ * equal in that part, so a permutation differing from an earlier one in its fragment
+ * shader or blend state compiles only that part and links the rest. Linking without
+ * link-time optimization takes a fraction of a whole compile, which keeps first uses of
+ * new permutations from hitching; VulkanPipeline::Optimize() relinks them in the
+ * background.
+ *
+ * Libraries are keyed by the bytes of their part, with shader modules and set layouts by
+ * handle. A shader's libraries are stale once the shader is gone, as its handle may be
+ * reused, and are replaced on the next request. Thread-safe.
+ */
+class VulkanPipelineLibraryCache {
+public:
+    explicit VulkanPipelineLibraryCache(VulkanContext& context) : m_Context(context) {}
+
+    VulkanPipelineLibraryCache(const VulkanPipelineLibraryCache&) = delete;
+    VulkanPipelineLibraryCache& operator=(const VulkanPipelineLibraryCache&) = delete;
+
+    // Fast-linked; null when a library fails to compile or the link fails
+    Ref<VulkanPipeline> CreatePipeline(const PipelineDesc& desc, VkRenderPass renderPass,
+                                       const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                       const std::vector<VkFormat>& colorFormats, VkFormat depthFormat);
+
+private:
+    struct CachedLibrary {
+        Ref<VulkanPipelineLibrary> library;
+        std::weak_ptr<Shader> shader;  // Of the shader stage parts
+        bool hasShader = false;
+
+        bool IsStale() const { return hasShader && shader.expired(); }
+    };
+
+    // The cached library of key, or one from compile (which returns VK_NULL_HANDLE on failure)
+    Ref<VulkanPipelineLibrary> FindOrCreate(const std::string& key, const Ref<Shader>& shader,
+                                            const std::function<VkPipeline(VkPipelineCreateFlags&)>& compile);
+    void PruneLibraries();
+
+    VulkanContext& m_Context;
+    mutable std::mutex m_Mutex;
+    std::unordered_map<std::string, CachedLibrary> m_Libraries;
+    size_t m_PruneSize = 64;  // Entries at which stale ones are next dropped
+};
+
+} // namespace rhi
+} // namespace metagfx
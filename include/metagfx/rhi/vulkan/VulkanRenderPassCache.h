@@ -0,0 +1,95 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanRenderPassCache.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace metagfx {
+namespace rhi {
+
+// Describes everything that makes two render passes incompatible/different
+struct VulkanRenderPassKey {
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;  // Of every attachment above
+    bool resolveColor = false;  // A single-sampled resolve attachment per color attachment
+    uint32 viewMask = 0;  // Of a multiview subpass (VkRenderPassMultiviewCreateInfo), or none
+
+    VkAttachmentLoadOp colorLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkAttachmentStoreOp colorStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    VkImageLayout colorInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout colorFinalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
+    VkAttachmentLoadOp depthLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkAttachmentStoreOp depthStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+    VkImageLayout depthInitialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    VkImageLayout depthFinalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    // Back to the defaults, keeping the storage of colorFormats
+    void Reset();
+    bool operator==(const VulkanRenderPassKey& other) const;
+};
+
+// A framebuffer is only valid for the exact render pass and image views it was created with
+struct VulkanFramebufferKey {
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    std::vector<VkImageView> attachments;  // Colors, depth, then resolve targets
+    uint32 width = 0;
+    uint32 height = 0;
+
+    void Reset();  // Likewise, keeping attachments' storage
+    bool operator==(const VulkanFramebufferKey& other) const;
+};
+
+struct VulkanRenderPassKeyHash {
+    size_t operator()(const VulkanRenderPassKey& key) const;
+};
+
+struct VulkanFramebufferKeyHash {
+    size_t operator()(const VulkanFramebufferKey& key) const;
+};
+
+// Device-owned cache of VkRenderPass and VkFramebuffer objects.
+// BeginRendering() looks up (or lazily creates) the render pass and framebuffer
+// matching its attachments instead of creating and destroying them every frame.
+// Framebuffers reference image views, so they must be evicted whenever a view
+// they use is destroyed (swap chain resize, texture destruction), which may happen on
+// any thread that releases a texture. Thread-safe.
+class VulkanRenderPassCache {
+public:
+    explicit VulkanRenderPassCache(VulkanContext& context);
+    ~VulkanRenderPassCache();
+
+    VulkanRenderPassCache(const VulkanRenderPassCache&) = delete;
+    VulkanRenderPassCache& operator=(const VulkanRenderPassCache&) = delete;
+
+    VkRenderPass GetRenderPass(const VulkanRenderPassKey& key);
+    VkFramebuffer GetFramebuffer(const VulkanFramebufferKey& key);
+
+    // Destroy every framebuffer that references the given image view
+    void InvalidateImageView(VkImageView imageView);
+
+    // Destroy all framebuffers (render passes are kept, they do not reference images)
+    void ClearFramebuffers();
+
+    // Destroy everything
+    void Clear();
+
+    size_t GetRenderPassCount() const;
+    size_t GetFramebufferCount() const;
+
+private:
+    VkRenderPass CreateRenderPass(const VulkanRenderPassKey& key);
+    void ClearFramebuffersLocked();
+
+    VulkanContext& m_Context;
+    mutable std::mutex m_Mutex;
+    std::unordered_map<VulkanRenderPassKey, VkRenderPass, VulkanRenderPassKeyHash> m_RenderPasses;
+    std::unordered_map<VulkanFramebufferKey, VkFramebuffer, VulkanFramebufferKeyHash> m_Framebuffers;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -10,9 +10,12 @@
 namespace metagfx {
 namespace rhi {
 
+// With offscreen set, the back buffers are framesInFlight device-owned images sized like
+// the window: nothing is acquired or presented, and Present() only moves to the next
+// frame slot. The semaphore getters then return VK_NULL_HANDLE.
 class VulkanSwapChain : public SwapChain {
 public:
-    VulkanSwapChain(VulkanContext& context, SDL_Window* window);
+    VulkanSwapChain(VulkanContext& context, SDL_Window* window, PresentMode presentMode, bool offscreen = false);
     ~VulkanSwapChain() override;
 
     void Present() override;
@@ -22,6 +25,10 @@ public:
     uint32 GetWidth() const override { return m_Width; }
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
+
+    void SetPresentMode(PresentMode mode) override;
+    PresentMode GetPresentMode() const override { return m_PresentMode; }
+    bool WaitForPresent(uint32 maxPendingPresents) override;
     
     // Vulkan-specific
     VkSwapchainKHR GetHandle() const { return m_SwapChain; }
@@ -29,16 +36,22 @@ public:
     uint32 GetCurrentFrame() const { return m_CurrentFrame; }
     VkSemaphore GetImageAvailableSemaphore() const { return m_ImageAvailableSemaphores[m_CurrentFrame]; }
     VkSemaphore GetRenderFinishedSemaphore() const { return m_RenderFinishedSemaphores[m_CurrentFrame]; }
-    VkFence GetInFlightFence() const { return m_InFlightFences[m_CurrentFrame]; }
+    // Timeline value (VulkanTimeline) of the current slot's submission; Present() waits
+    // for the next slot's value before reusing it
+    void SetFrameValue(uint64 value) { m_FrameValues[m_CurrentFrame] = value; }
 
 private:
     void CreateSwapChain();
     void CreateImageViews();
+    void CreateOffscreenImages();
     void CreateSyncObjects();
+    void Recreate();
+    void DestroyRetired(bool all);
     void Cleanup();
 
     VulkanContext& m_Context;
     SDL_Window* m_Window;
+    bool m_Offscreen = false;
 
     VkSwapchainKHR m_SwapChain = VK_NULL_HANDLE;
     VkSwapchainKHR m_OldSwapChain = VK_NULL_HANDLE;  // For swap chain recreation
@@ -50,14 +63,33 @@ private:
     uint32 m_Height = 0;
     Format m_Format = Format::Undefined;
     VkFormat m_VkFormat = VK_FORMAT_UNDEFINED;
+
+    PresentMode m_RequestedPresentMode = PresentMode::Fifo;
+    PresentMode m_PresentMode = PresentMode::Fifo;  // What the surface granted
+
+    // Present ids (VK_KHR_present_id) increase across swap chains; ids below
+    // m_FirstPresentId went to a retired swap chain and are never waited on
+    uint64 m_PresentId = 0;
+    uint64 m_FirstPresentId = 1;
     
     // Synchronization
-    static constexpr uint32 MAX_FRAMES_IN_FLIGHT = 2;
     std::vector<VkSemaphore> m_ImageAvailableSemaphores;
     std::vector<VkSemaphore> m_RenderFinishedSemaphores;
-    std::vector<VkFence> m_InFlightFences;
+    std::vector<uint64> m_FrameValues;  // Per slot; 0 until its first submission
     uint32 m_CurrentFrame = 0;
     uint32 m_CurrentImageIndex = 0;
+
+    // Swap chains replaced by Recreate() while frames in flight may still render to or
+    // present their images. Destroyed once every frame slot has been waited for again,
+    // i.e. framesInFlight presents later.
+    struct RetiredSwapChain {
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
+        std::vector<VkImageView> imageViews;
+        VkSemaphore acquireSemaphore = VK_NULL_HANDLE;  // Signalled by the last acquire on it
+        uint64 destroyAtFrame = 0;
+    };
+    std::vector<RetiredSwapChain> m_Retired;
+    uint64 m_FrameNumber = 0;  // Presents so far
 };
 
 } // namespace rhi
@@ -5,10 +5,15 @@
 
 #include "metagfx/rhi/Texture.h"
 #include "VulkanTypes.h"
+#include "VulkanMemoryAllocator.h"
+#include <functional>
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
 
+struct VulkanImageUpload;
+
 class VulkanTexture : public Texture {
 public:
     // For swap chain images (don't own the image)
@@ -23,31 +28,62 @@ public:
     uint32 GetWidth() const override { return m_Width; }
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
+    uint32 GetMipLevels() const override { return m_MipLevels; }
+    uint32 GetSampleCount() const override { return m_SampleCount; }
 
     // Upload pixel data to GPU
     void UploadData(const void* data, uint64 size) override;
+    // Each level is copied straight into the staging ring
+    void UploadLevels(const TextureLevelData* levels, uint32 levelCount) override;
+    bool IsUploadComplete() const override;
 
     // Vulkan-specific
     VkImage GetImage() const { return m_Image; }
     VkImageView GetImageView() const { return m_ImageView; }
+    // Of render passes: the image view, but a 2D array view of a cube map's faces
+    VkImageView GetAttachmentView() const { return m_AttachmentView ? m_AttachmentView : m_ImageView; }
+    // Layout the image is in when shaders read it (storage images stay in GENERAL)
+    VkImageLayout GetShaderReadLayout() const {
+        return m_Storage ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+    // TextureUsage::Transient: render passes do not store it
+    bool IsTransient() const { return m_Transient; }
+    uint32 GetArrayLayers() const { return m_ArrayLayers; }
+    VkImageAspectFlags GetAspectMask() const;
+
+    // Of the commands recorded so far, per mip of each layer (VulkanBarrierBatch)
+    VulkanResourceState& GetState(uint32 mip, uint32 layer) { return m_States[layer * m_MipLevels + mip]; }
 
 private:
-    void TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout);
-    uint32 FindMemoryType(uint32 typeFilter, VkMemoryPropertyFlags properties);
+    // The copy of size packed bytes into every uploaded level and layer
+    VulkanImageUpload DescribeUpload(uint64 size) const;
+    // Hands it to the upload manager, write filling the staging memory
+    void QueueUpload(const VulkanImageUpload& upload, uint64 size, const std::function<void(void*)>& write);
+
     VulkanContext& m_Context;
     VkImage m_Image = VK_NULL_HANDLE;
     VkImageView m_ImageView = VK_NULL_HANDLE;
-    VkDeviceMemory m_Memory = VK_NULL_HANDLE;
+    VkImageView m_AttachmentView = VK_NULL_HANDLE;  // Cube map attachments only
+    VulkanAllocation m_Allocation;
 
     uint32 m_Width = 0;
     uint32 m_Height = 0;
     uint32 m_MipLevels = 1;
     uint32 m_ArrayLayers = 1;
+    uint32 m_SampleCount = 1;
     TextureType m_Type = TextureType::Texture2D;
     Format m_Format = Format::Undefined;
     VkFormat m_VkFormat = VK_FORMAT_UNDEFINED;
+    MemoryCategory m_MemoryCategory = MemoryCategory::Texture;
+    uint64 m_MemoryBytes = 0;        // Counted in VulkanContext::memory
 
     bool m_OwnsImage = true;
+    bool m_Storage = false;          // TextureUsage::Storage; kept in VK_IMAGE_LAYOUT_GENERAL
+    bool m_Transient = false;        // TextureUsage::Transient
+    bool m_GenerateMipmaps = false;  // UploadData() receives mip 0 only
+    bool m_BlitMipmaps = false;      // Generated on the GPU (else on the CPU)
+    uint64 m_UploadTicket = 0;  // VulkanUploadTicket of the last UploadData()
+    std::vector<VulkanResourceState> m_States;
 };
 
 } // namespace rhi
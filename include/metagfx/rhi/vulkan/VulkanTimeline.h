@@ -0,0 +1,81 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanTimeline.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned progress counter of a queue (the graphics queue, or the async compute
+// queue with a timeline of its own). Every submission to the queue goes
+// through Submit(), whose last batch signals the next value of one timeline semaphore
+// (core in Vulkan 1.2), so frame slots, upload batches and the application's deletion
+// queue all ask "has the GPU passed value N" instead of each keeping fences. Without the
+// timelineSemaphore feature every value gets a recycled fence instead.
+//
+// Thread-safe; Submit() and Present() also serialize the graphics queue between the render
+// thread and the upload manager's submissions from any thread.
+class VulkanTimeline {
+public:
+    // A batch of Submit() waiting for a value of another timeline
+    struct Wait {
+        uint32 batch = 0;
+        VkSemaphore semaphore = VK_NULL_HANDLE;  // GetSemaphore() of the other timeline
+        uint64 value = 0;
+        VkPipelineStageFlags stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    };
+
+    VulkanTimeline(VulkanContext& context, VkQueue queue, bool timelineSemaphore);
+    ~VulkanTimeline();
+
+    VulkanTimeline(const VulkanTimeline&) = delete;
+    VulkanTimeline& operator=(const VulkanTimeline&) = delete;
+
+    // vkQueueSubmit() to the queue; returns the value signalled once the batches have
+    // finished. A failed submit signals nothing and returns the previous value. waits
+    // need timeline semaphores.
+    uint64 Submit(uint32 submitCount, const VkSubmitInfo* submits, std::span<const Wait> waits = {});
+
+    // vkQueuePresentKHR() to the queue, which must be able to present
+    VkResult Present(const VkPresentInfoKHR& presentInfo);
+
+    // Null in the fence fallback
+    VkSemaphore GetSemaphore() const { return m_Semaphore; }
+
+    // Of the last successful Submit()
+    uint64 GetSignaledValue() const { return m_SignaledValue.load(std::memory_order_acquire); }
+    uint64 GetCompletedValue();
+    // Values not submitted yet are clamped to GetSignaledValue()
+    void Wait(uint64 value);
+
+private:
+    struct PendingFence {
+        uint64 value = 0;
+        VkFence fence = VK_NULL_HANDLE;
+    };
+
+    void CollectFencesLocked();
+
+    VulkanContext& m_Context;
+    VkQueue m_Queue = VK_NULL_HANDLE;
+    VkSemaphore m_Semaphore = VK_NULL_HANDLE;  // Null in the fence fallback
+
+    std::atomic<uint64> m_SignaledValue{0};
+    std::atomic<uint64> m_CompletedValue{0};
+
+    // Fence fallback: one fence per submitted value, oldest first
+    std::deque<PendingFence> m_PendingFences;
+    std::vector<VkFence> m_FreeFences;
+
+    std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
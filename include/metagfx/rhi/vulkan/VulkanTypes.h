@@ -5,6 +5,8 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"  
+#include "metagfx/rhi/FrameStats.h"
+#include "metagfx/rhi/MemoryStats.h"
 #include <vulkan/vulkan.h>
 #include <vector>
 
@@ -20,6 +22,23 @@ namespace rhi {
         } \
     } while(0)
 
+class VulkanRenderPassCache;
+class VulkanMemoryAllocator;
+class VulkanUploadManager;
+class VulkanPipelineCache;
+class VulkanDescriptorCache;
+class VulkanTimeline;
+
+// What the commands recorded so far last did to an image subresource or a buffer, kept by
+// VulkanBarrierBatch. Stage and access flags are synchronization2's, whose low 32 bits
+// are the legacy flags.
+struct VulkanResourceState {
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;  // Images only
+    VkPipelineStageFlags2KHR writeStages = 0;  // Of the last write or layout transition
+    VkAccessFlags2KHR writeAccess = 0;         // Of the last write
+    VkPipelineStageFlags2KHR readStages = 0;   // Reading since, the write visible to them
+};
+
 // Vulkan context shared across all Vulkan objects
 struct VulkanContext {
     VkInstance instance = VK_NULL_HANDLE;
@@ -29,9 +48,113 @@ struct VulkanContext {
     VkQueue presentQueue = VK_NULL_HANDLE;
     uint32 graphicsQueueFamily = 0;
     uint32 presentQueueFamily = 0;
+
+    // Transfer-only queue for texture uploads; equals graphicsQueue/graphicsQueueFamily
+    // when the device has no suitable dedicated family
+    VkQueue transferQueue = VK_NULL_HANDLE;
+    uint32 transferQueueFamily = 0;
+
+    // Second queue of the graphics family for async compute, so resources need no queue
+    // family ownership transfers between the two; null when the family has one queue or
+    // without timeline semaphores
+    VkQueue computeQueue = VK_NULL_HANDLE;
     VkSurfaceKHR surface = VK_NULL_HANDLE;
     VkCommandPool commandPool = VK_NULL_HANDLE;
 
+    // Frame slots (swap chain sync objects, frame command pools, descriptor set copies)
+    uint32 framesInFlight = 2;
+
+    // Owned by VulkanDevice; every graphics queue submission goes through it and signals
+    // its next value
+    VulkanTimeline* timeline = nullptr;
+
+    // Owned by VulkanDevice; shared so command buffers, swap chain and textures can use/invalidate it
+    VulkanRenderPassCache* renderPassCache = nullptr;
+
+    // Owned by VulkanDevice; buffers and textures sub-allocate their memory from it
+    VulkanMemoryAllocator* allocator = nullptr;
+
+    // Owned by VulkanDevice; batches texture uploads without stalling the graphics queue
+    VulkanUploadManager* uploadManager = nullptr;
+
+    // Owned by VulkanDevice; every graphics and compute pipeline is created through it
+    VulkanPipelineCache* pipelineCache = nullptr;
+
+    // Owned by VulkanDevice; descriptor sets and pipelines take their layouts, and sets
+    // their pools, from it
+    VulkanDescriptorCache* descriptorCache = nullptr;
+
+    // Owned by VulkanDevice; objects add the device work of the frame (GetFrameStats())
+    // and the memory of their resources (GetMemoryStats())
+    FrameStatsCounters* stats = nullptr;
+    MemoryCounters* memory = nullptr;
+
+    // VK_KHR_dynamic_rendering (core in Vulkan 1.3). When false, BeginRendering() falls back
+    // to cached VkRenderPass/VkFramebuffer objects.
+    bool dynamicRendering = false;
+    PFN_vkCmdBeginRenderingKHR cmdBeginRendering = nullptr;
+    PFN_vkCmdEndRenderingKHR cmdEndRendering = nullptr;
+
+    // VK_KHR_fragment_shading_rate's attachment rate, with dynamic rendering only: graphics
+    // pipelines take the rate of BeginRendering()'s shading rate image, whose texels cover
+    // squares of shadingRateTexelSize pixels
+    bool shadingRateImage = false;
+    uint32 shadingRateTexelSize = 0;
+
+    // Descriptor indexing (core in Vulkan 1.2): partially bound, dynamically indexed
+    // combined image sampler arrays for bindless material textures
+    bool descriptorIndexing = false;
+
+    // Indirect draws: multiDrawIndirect (one vkCmdDrawIndexedIndirect for many commands)
+    // and VK_KHR_draw_indirect_count (core in Vulkan 1.2). Without the count function
+    // DrawIndexedIndirectCount() draws every command.
+    bool multiDrawIndirect = false;
+    PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount = nullptr;
+
+    // VK_KHR_present_id + VK_KHR_present_wait: presents carry an id and the CPU can wait
+    // for a given id to reach the display (VulkanSwapChain::WaitForPresent)
+    PFN_vkWaitForPresentKHR waitForPresent = nullptr;
+
+    // VK_EXT_memory_budget: vkGetPhysicalDeviceMemoryProperties2 reports each heap's
+    // current budget and usage (VulkanDevice::GetMemoryBudget)
+    bool memoryBudget = false;
+
+    // Timeline semaphores (core in Vulkan 1.2); VulkanTimeline falls back to fences without
+    bool timelineSemaphore = false;
+
+    // shaderFloat16 (VK_KHR_shader_float16_int8, core in Vulkan 1.2)
+    bool shaderFloat16 = false;
+
+    // VK_KHR_multiview (core in Vulkan 1.1): view masks of up to this many views in render
+    // passes, dynamic rendering and pipelines; 0 without multiview
+    uint32 maxMultiviewViews = 0;
+
+    // VK_EXT_graphics_pipeline_library with fast linking: graphics pipelines are linked
+    // from VulkanPipelineLibraryCache's parts, then relinked optimized in the background
+    bool graphicsPipelineLibrary = false;
+
+    // VK_KHR_push_descriptor: push descriptor set layouts and VulkanCommandBuffer::PushDescriptorSet()
+    PFN_vkCmdPushDescriptorSetKHR cmdPushDescriptorSet = nullptr;
+
+    // VK_KHR_synchronization2 (core in Vulkan 1.3): VulkanBarrierBatch records its barriers
+    // with per-barrier stages. Without it they are folded into one vkCmdPipelineBarrier.
+    PFN_vkCmdPipelineBarrier2KHR cmdPipelineBarrier2 = nullptr;
+
+    // VK_KHR_acceleration_structure with buffer device addresses, which every memory
+    // allocation then enables (VulkanAccelerationStructure). Build scratch addresses are
+    // multiples of accelerationStructureScratchAlignment.
+    bool accelerationStructure = false;
+    bool rayQuery = false;  // VK_KHR_ray_query, with acceleration structures only
+    VkDeviceSize accelerationStructureScratchAlignment = 1;
+    PFN_vkGetBufferDeviceAddress getBufferDeviceAddress = nullptr;
+    PFN_vkGetAccelerationStructureBuildSizesKHR getAccelerationStructureBuildSizes = nullptr;
+    PFN_vkCreateAccelerationStructureKHR createAccelerationStructure = nullptr;
+    PFN_vkDestroyAccelerationStructureKHR destroyAccelerationStructure = nullptr;
+    PFN_vkGetAccelerationStructureDeviceAddressKHR getAccelerationStructureDeviceAddress = nullptr;
+    PFN_vkCmdBuildAccelerationStructuresKHR cmdBuildAccelerationStructures = nullptr;
+    PFN_vkCmdWriteAccelerationStructuresPropertiesKHR cmdWriteAccelerationStructuresProperties = nullptr;
+    PFN_vkCmdCopyAccelerationStructureKHR cmdCopyAccelerationStructure = nullptr;
+
     VkPhysicalDeviceProperties deviceProperties;
     VkPhysicalDeviceFeatures deviceFeatures;
     VkPhysicalDeviceMemoryProperties memoryProperties;
@@ -50,6 +173,9 @@ VkPolygonMode ToVulkanPolygonMode(PolygonMode mode);
 VkCullModeFlags ToVulkanCullMode(CullMode mode);
 VkFrontFace ToVulkanFrontFace(FrontFace face);
 VkCompareOp ToVulkanCompareOp(CompareOp op);
+VkSampleCountFlagBits ToVulkanSampleCount(uint32 count);
+uint32 ToVulkanViewMask(uint32 viewCount);  // Views 0..viewCount-1; 0 (no multiview) for one view
+VkAttachmentLoadOp ToVulkanLoadOp(LoadOp op);  // Of one attachment: ClearColor clears
 
 } // namespace rhi
 } // namespace metagfx
@@ -0,0 +1,185 @@
+// ============================================================================
+// include/metagfx/rhi/vulkan/VulkanUploadManager.h
+// ============================================================================
+#pragma once
+
+#include "VulkanTypes.h"
+#include "VulkanMemoryAllocator.h"
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace metagfx {
+namespace rhi {
+
+// Identifies a batch of uploads; tickets increase monotonically, 0 = nothing pending
+using VulkanUploadTicket = uint64;
+
+// One staged copy into an image, recorded by VulkanTexture::UploadData
+struct VulkanImageUpload {
+    VkImage image = VK_NULL_HANDLE;
+    VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    uint32 mipLevels = 1;
+    uint32 arrayLayers = 1;
+    uint32 texelSize = 4;  // Staging offsets must be a multiple of the texel block size
+    std::vector<VkBufferImageCopy> regions;  // bufferOffset is relative to the staged data
+
+    // Regions only cover mip 0; mips 1..mipLevels-1 are filled by a vkCmdBlitImage chain.
+    // The format must support BLIT_SRC/BLIT_DST and linear filtering.
+    bool generateMipmaps = false;
+    uint32 width = 1;   // Mip 0 extent, used by the blit chain
+    uint32 height = 1;
+};
+
+// Device-owned upload queue for textures and GPU-only buffers. Copies are batched into
+// one command buffer and submitted without any CPU wait, on a transfer-only queue family
+// when the device has one (with a release/acquire queue family ownership transfer to the
+// graphics queue), otherwise on the graphics queue. Callers poll the returned ticket; the
+// graphics queue never reads a resource before its acquire barrier, so rendering keeps
+// going meanwhile.
+//
+// Staging data is sub-allocated from one persistently mapped ring buffer. A batch's ring
+// ranges are recycled once the graphics queue's timeline (VulkanTimeline) passes the value
+// of its graphics submission. When the ring is full, the oldest batches are waited for.
+// Uploads larger than the whole ring get a dedicated staging buffer.
+//
+// Thread-safe. Each calling thread records into its own open batch from its own command
+// pools (an upload context), so worker threads copy their data into staging memory and
+// record their commands alongside each other; only staging allocation and submission are
+// serialized. Flush() submits every thread's open batch.
+class VulkanUploadManager {
+public:
+    explicit VulkanUploadManager(VulkanContext& context);
+    ~VulkanUploadManager();
+
+    VulkanUploadManager(const VulkanUploadManager&) = delete;
+    VulkanUploadManager& operator=(const VulkanUploadManager&) = delete;
+
+    // Stage the data and record the copy into the open batch. The image ends up in
+    // SHADER_READ_ONLY_OPTIMAL on the graphics queue family. Returns the batch ticket.
+    // Mip generation blits need a graphics queue, so with a transfer queue they are
+    // recorded into the batch's acquire command buffer after the ownership transfer.
+    VulkanUploadTicket UploadImage(const VulkanImageUpload& upload, const void* data, uint64 size);
+    // Same, with write storing the size bytes straight into the staging memory, e.g. from
+    // levels that lie apart; it runs under the same lock as UploadBuffer()'s
+    VulkanUploadTicket UploadImage(const VulkanImageUpload& upload, uint64 size,
+                                   const std::function<void(void*)>& write);
+
+    // Copy into a (device-local) buffer. dstStage/dstAccess describe the first use on the
+    // graphics queue, e.g. VERTEX_INPUT / VERTEX_ATTRIBUTE_READ for vertex buffers.
+    // Meant for filling a buffer, not for updating parts of one the GPU is reading.
+    VulkanUploadTicket UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, uint64 size,
+                                    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+    // Same, with write storing the size bytes straight into the staging memory. It runs
+    // under the calling thread's upload context lock, which Flush() waits for, so it
+    // should only produce the data.
+    VulkanUploadTicket UploadBuffer(VkBuffer buffer, VkDeviceSize offset, uint64 size,
+                                    const std::function<void(void*)>& write,
+                                    VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+
+    // Move a freshly created image (UNDEFINED) into newLayout on the graphics queue family,
+    // e.g. GENERAL for storage images that are never uploaded to. Returns the batch ticket.
+    VulkanUploadTicket TransitionImage(VkImage image, VkImageAspectFlags aspectMask, uint32 mipLevels,
+                                       uint32 arrayLayers, VkImageLayout newLayout);
+
+    // Submit every thread's open batch (no-op when empty). Called by the device at frame start.
+    void Flush();
+
+    // Release staging memory and command buffers of finished batches
+    void CollectCompleted();
+
+    bool IsComplete(VulkanUploadTicket ticket);
+    void Wait(VulkanUploadTicket ticket);
+
+    bool UsesTransferQueue() const { return m_Context.transferQueue != m_Context.graphicsQueue; }
+    uint32 GetPendingBatchCount() const;
+    VkDeviceSize GetStagingRingSize() const { return m_RingSize; }
+    VkDeviceSize GetStagingRingBytesInUse() const;
+
+private:
+    struct StagingBuffer {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VulkanAllocation allocation;
+    };
+
+    // Where one upload's data was staged
+    struct StagingSlice {
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        void* mappedData = nullptr;
+    };
+
+    struct UploadContext;
+
+    struct Batch {
+        VulkanUploadTicket ticket = 0;
+        UploadContext* context = nullptr;              // Whose pools the command buffers are from
+        VkCommandBuffer transferCmd = VK_NULL_HANDLE;  // Copies (+ release barriers)
+        VkCommandBuffer acquireCmd = VK_NULL_HANDLE;   // Acquire barriers on the graphics queue
+        VkSemaphore semaphore = VK_NULL_HANDLE;        // Transfer -> graphics
+        uint64 timelineValue = 0;                      // Graphics queue value once the batch is usable
+        std::vector<StagingBuffer> stagingBuffers;     // Overflow uploads only
+        bool usesRing = false;
+        uint32 uploadCount = 0;
+        uint64 stagedBytes = 0;
+    };
+
+    // One per recording thread, kept until the manager is destroyed. mutex is held for a
+    // whole upload and taken before m_Mutex; the free lists are guarded by m_Mutex.
+    struct UploadContext {
+        std::mutex mutex;
+        VkCommandPool transferPool = VK_NULL_HANDLE;
+        VkCommandPool acquirePool = VK_NULL_HANDLE;  // Graphics family; only used with a transfer queue
+        Batch openBatch;
+        std::vector<VkCommandBuffer> freeTransferCmds;  // Of finished batches, re-begun as is
+        std::vector<VkCommandBuffer> freeAcquireCmds;
+    };
+
+    // A ring slice, in allocation order; the tail passes it once its batch has finished
+    struct RingRange {
+        uint64 end = 0;
+        VulkanUploadTicket ticket = 0;
+    };
+
+    UploadContext& GetThreadContext();
+    std::vector<UploadContext*> GetContexts();
+    void CreateStagingRing();
+    // Takes m_Mutex; the slice stays valid while the context's batch is open
+    bool AllocateStaging(UploadContext& context, VkDeviceSize size, VkDeviceSize alignment, StagingSlice& outSlice);
+    bool AllocateFromRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+    void EndUpload(UploadContext& context, uint64 size);
+    void RecordMipChain(VkCommandBuffer cmd, const VulkanImageUpload& upload);
+    // Both take the context lock and m_Mutex held
+    void BeginBatch(UploadContext& context);
+    void SubmitOpenBatch(UploadContext& context);
+    void CollectCompletedLocked();
+    void AdvanceRingTail();
+    void RecycleBatch(Batch& batch);
+    VkCommandBuffer AllocateCommandBuffer(VkCommandPool pool);
+
+    VulkanContext& m_Context;
+    std::unordered_map<std::thread::id, std::unique_ptr<UploadContext>> m_Contexts;
+
+    // Staging ring; head/tail are monotonically increasing byte positions (offset = pos % size)
+    VkBuffer m_RingBuffer = VK_NULL_HANDLE;
+    VulkanAllocation m_RingAllocation;
+    VkDeviceSize m_RingSize = 0;
+    uint64 m_RingHead = 0;
+    uint64 m_RingTail = 0;
+    std::deque<RingRange> m_RingRanges;
+    bool m_LoggedOverflow = false;
+
+    std::deque<Batch> m_InFlight;  // Submitted, oldest first
+    std::unordered_set<VulkanUploadTicket> m_PendingTickets;  // Open or in flight
+    uint32 m_OpenBatchCount = 0;
+    VulkanUploadTicket m_NextTicket = 1;
+
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
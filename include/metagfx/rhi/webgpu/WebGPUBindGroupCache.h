@@ -0,0 +1,96 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUBindGroupCache.h
+// ============================================================================
+#pragma once
+
+#include "WebGPUTypes.h"
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned cache of bind groups and bind group layouts. Creating a bind group is
+// among the costliest WebGPU calls (validated and allocated every time), and bind
+// groups are immutable, so a descriptor set whose bindings come back to a combination
+// seen before takes the bind group built for it then. Descriptor sets of one layout
+// description share its layout, which makes their bind groups interchangeable.
+//
+// Bind groups are keyed by layout plus each entry's buffer and range, sampler and
+// view. The key holds references to those objects, so a handle cannot be reused by a
+// new object while its entry is cached. Past MAX_BIND_GROUPS the least recently used
+// bind groups are dropped; layouts are few and kept for the device's lifetime.
+// Thread-safe.
+class WebGPUBindGroupCache {
+public:
+    static constexpr uint32 MAX_BIND_GROUPS = 1024;
+
+    struct Stats {
+        uint32 bindGroupCount = 0;
+        uint32 layoutCount = 0;
+        uint64 hits = 0;
+        uint64 misses = 0;
+        uint64 evictions = 0;
+    };
+
+    explicit WebGPUBindGroupCache(WebGPUContext& context);
+    ~WebGPUBindGroupCache() = default;
+
+    WebGPUBindGroupCache(const WebGPUBindGroupCache&) = delete;
+    WebGPUBindGroupCache& operator=(const WebGPUBindGroupCache&) = delete;
+
+    // The layout of the entries, created the first time they are asked for
+    wgpu::BindGroupLayout AcquireLayout(const std::vector<wgpu::BindGroupLayoutEntry>& entries);
+
+    // Layout of the push constant group: one dynamic-offset uniform buffer of
+    // WEBGPU_MAX_PUSH_CONSTANT_SIZE bytes at binding 0
+    wgpu::BindGroupLayout AcquirePushConstantLayout();
+
+    // The bind group of the layout and entries, created on a miss (counted as
+    // descriptor updates); null when creation fails
+    wgpu::BindGroup AcquireBindGroup(const wgpu::BindGroupLayout& layout,
+                                     const std::vector<wgpu::BindGroupEntry>& entries);
+
+    // Drop every bind group (descriptor sets keep the ones they hold)
+    void Clear();
+
+    Stats GetStats() const;
+
+private:
+    struct BindGroupKey {
+        wgpu::BindGroupLayout layout;
+        std::vector<wgpu::BindGroupEntry> entries;  // Keep the objects alive
+
+        bool operator==(const BindGroupKey& other) const;
+    };
+
+    struct BindGroupKeyHash {
+        size_t operator()(const BindGroupKey& key) const;
+    };
+
+    struct Entry {
+        wgpu::BindGroup bindGroup;
+        std::list<BindGroupKey>::iterator lruPosition;
+    };
+
+    struct Layout {
+        std::vector<wgpu::BindGroupLayoutEntry> entries;
+        wgpu::BindGroupLayout layout;
+    };
+
+    WebGPUContext& m_Context;
+    std::unordered_map<BindGroupKey, Entry, BindGroupKeyHash> m_BindGroups;
+    std::list<BindGroupKey> m_LRU;  // Most recently used first
+    std::vector<Layout> m_Layouts;
+
+    uint64 m_Hits = 0;
+    uint64 m_Misses = 0;
+    uint64 m_Evictions = 0;
+
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -14,10 +14,18 @@ public:
     WebGPUBuffer(WebGPUContext& context, const BufferDesc& desc);
     ~WebGPUBuffer() override;
 
+    // Spins on device.Tick() until mapped, and cannot wait at all on Emscripten
     void* Map() override;
     void Unmap() override;
+    // Read mapping completed by the device's Tick() in BeginFrame() (by the browser on
+    // Emscripten). Destroying the buffer first calls back with nullptr.
+    void MapAsync(MapCallback callback) override;
     void CopyData(const void* data, uint64 size, uint64 offset = 0) override;
 
+    // WebGPU buffers cannot stay mapped while the GPU uses them; CopyData() goes
+    // through queue.WriteBuffer instead
+    void* GetMappedPointer() override { return nullptr; }
+
     uint64 GetSize() const override { return m_Size; }
     BufferUsage GetUsage() const override { return m_Usage; }
 
@@ -25,15 +33,28 @@ public:
     wgpu::Buffer GetHandle() const { return m_Buffer; }
 
 private:
+    // Outlives the buffer object when it is destroyed while mapping: Dawn still calls
+    // OnMapped(), which frees it
+    struct PendingMap {
+        WebGPUBuffer* owner = nullptr;  // Null once the buffer object is gone
+        wgpu::Buffer buffer;
+        uint64 size = 0;
+        MapCallback callback;
+    };
+
+    static void OnMapped(WGPUBufferMapAsyncStatus status, void* userdata);
+
     WebGPUContext& m_Context;
     wgpu::Buffer m_Buffer = nullptr;
 
     uint64 m_Size = 0;
     BufferUsage m_Usage;
     MemoryUsage m_MemoryUsage;
+    MemoryCategory m_MemoryCategory;
 
     void* m_MappedData = nullptr;
     bool m_IsMapped = false;
+    PendingMap* m_PendingMap = nullptr;  // MapAsync() in flight
 };
 
 } // namespace rhi
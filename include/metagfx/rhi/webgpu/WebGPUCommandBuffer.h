@@ -5,71 +5,184 @@
 
 #include "metagfx/rhi/CommandBuffer.h"
 #include "WebGPUTypes.h"
+#include <vector>
 
 namespace metagfx {
 namespace rhi {
 
+class WebGPUPipeline;
+
 class WebGPUCommandBuffer : public CommandBuffer {
 public:
-    WebGPUCommandBuffer(WebGPUContext& context);
+    // With a primary, a secondary recording a render bundle for that primary's parallel
+    // render passes
+    WebGPUCommandBuffer(WebGPUContext& context, WebGPUCommandBuffer* primary = nullptr);
     ~WebGPUCommandBuffer() override;
 
     // CommandBuffer interface
     void Begin() override;
     void End() override;
 
-    void BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                        Ref<Texture> depthAttachment,
-                        const std::vector<ClearValue>& clearValues) override;
+    void BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                        const Ref<Texture>& depthAttachment,
+                        std::span<const ClearValue> clearValues,
+                        const RenderPassActions& actions = {},
+                        std::span<const Ref<Texture>> resolveTargets = {},
+                        const Ref<Texture>& shadingRate = nullptr) override;
     void EndRendering() override;
 
-    void BindPipeline(Ref<Pipeline> pipeline) override;
+    // Secondaries record render bundles, which inherit the pass viewport and scissor:
+    // their SetViewport()/SetScissor() are ignored
+    void BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                const Ref<Texture>& depthAttachment,
+                                std::span<const ClearValue> clearValues,
+                                uint32 secondaryCount,
+                                const RenderPassActions& actions = {},
+                                std::span<const Ref<Texture>> resolveTargets = {},
+                                const Ref<Texture>& shadingRate = nullptr) override;
+    Ref<CommandBuffer> GetSecondaryCommandBuffer(uint32 index) override;
+    void EndParallelRendering() override;
+
+    void BindPipeline(const Ref<Pipeline>& pipeline) override;
 
     void SetViewport(const Viewport& viewport) override;
     void SetScissor(const Rect2D& scissor) override;
 
-    void BindVertexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
-    void BindIndexBuffer(Ref<Buffer> buffer, uint64 offset = 0) override;
+    void BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
+    void BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset = 0) override;
 
     void Draw(uint32 vertexCount, uint32 instanceCount = 1,
               uint32 firstVertex = 0, uint32 firstInstance = 0) override;
     void DrawIndexed(uint32 indexCount, uint32 instanceCount = 1,
                      uint32 firstIndex = 0, int32 vertexOffset = 0,
                      uint32 firstInstance = 0) override;
-
-    void CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+    void DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                             uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+    void DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                  const Ref<Buffer>& countBuffer, uint64 countOffset, uint32 maxDrawCount,
+                                  uint32 stride = sizeof(DrawIndexedIndirectCommand)) override;
+    // Executes a render bundle of the list recorded with the bound state; secondaries,
+    // which record bundles themselves, draw it indirectly
+    void ExecuteDrawList(const Ref<DrawList>& drawList) override;
+
+    void Dispatch(uint32 groupCountX, uint32 groupCountY = 1, uint32 groupCountZ = 1) override;
+    void DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset = 0) override;
+
+    void CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                     uint64 size, uint64 srcOffset = 0, uint64 dstOffset = 0) override;
+    void CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset = 0) override;
 
-    void BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                           uint32 frameIndex = 0) override;
-    void PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+    using CommandBuffer::BindDescriptorSet;
+    void BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex, const Ref<DescriptorSet>& descriptorSet,
+                           uint32 frameIndex = 0, const uint32* dynamicOffsets = nullptr,
+                           uint32 dynamicOffsetCount = 0) override;
+    void PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                        uint32 offset, uint32 size, const void* data) override;
-    void BufferMemoryBarrier(Ref<Buffer> buffer) override;
+    void BufferMemoryBarrier(const Ref<Buffer>& buffer) override;
+    void PipelineBarrier(BarrierType type) override;
+    void ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                         const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) override;
+    void InvalidateState() override;
 
     // WebGPU-specific
     wgpu::CommandBuffer GetHandle() const { return m_CommandBuffer; }
     wgpu::RenderPassEncoder GetRenderPassEncoder() const { return m_RenderPassEncoder; }
 
+    // Timestamp written at the start of an empty compute pass: core WebGPU writes
+    // timestamps only at pass boundaries. False on a secondary and inside a render pass.
+    bool WriteTimestamp(const wgpu::QuerySet& querySet, uint32 queryIndex);
+    // Encoder for commands recorded between passes, ending the open compute pass; null on
+    // a secondary and inside a render pass
+    wgpu::CommandEncoder GetEncoderBetweenPasses();
+
 private:
     WebGPUContext& m_Context;
     wgpu::CommandEncoder m_CommandEncoder = nullptr;
     wgpu::CommandBuffer m_CommandBuffer = nullptr;
     wgpu::RenderPassEncoder m_RenderPassEncoder = nullptr;
+    wgpu::ComputePassEncoder m_ComputePassEncoder = nullptr;  // Open between render passes
+    std::vector<wgpu::RenderPassColorAttachment> m_ColorAttachDescs;  // Of the last BeginRendering()
+
+    // Parallel passes: each secondary records a bundle, executed in index order
+    wgpu::RenderBundleEncoder m_BundleEncoder = nullptr;  // Open on a recording secondary
+    wgpu::RenderBundle m_Bundle = nullptr;  // Finished by a secondary's End()
+    std::vector<Ref<WebGPUCommandBuffer>> m_Secondaries;
+    uint32 m_ActiveSecondaryCount = 0;
+    WebGPUCommandBuffer* m_Primary = nullptr;  // Set on secondaries
+    std::vector<wgpu::TextureFormat> m_BundleColorFormats;  // Of the open pass
+    wgpu::TextureFormat m_BundleDepthFormat = wgpu::TextureFormat::Undefined;
+    uint32 m_BundleSampleCount = 1;
+
+    // Render commands go to the bundle encoder on a secondary, to the pass otherwise
+    bool InRenderPass() const { return m_RenderPassEncoder || m_BundleEncoder; }
+    template <typename Record>
+    void EncodeRender(Record&& record) {
+        if (m_BundleEncoder) {
+            record(m_BundleEncoder);
+        } else {
+            record(m_RenderPassEncoder);
+        }
+    }
 
     // Current pipeline state
     Ref<Pipeline> m_BoundPipeline;
+    Ref<Buffer> m_BoundVertexBuffer;
+    uint64 m_VertexBufferOffset = 0;
     Ref<Buffer> m_BoundIndexBuffer;
     uint64 m_IndexBufferOffset = 0;
     wgpu::IndexFormat m_IndexFormat = wgpu::IndexFormat::Uint32;
+    // Render groups by set, for draw list bundles
+    wgpu::BindGroup m_BoundBindGroups[MAX_DESCRIPTOR_SETS] = {};
+    std::vector<uint32> m_BoundDynamicOffsets[MAX_DESCRIPTOR_SETS];
+
+    // State set on the open render or compute pass; a new pass starts without any
+    const Pipeline* m_PassPipeline = nullptr;
+    WGPUBindGroup m_PassBindGroups[MAX_DESCRIPTOR_SETS] = {};
+    BoundDynamicOffsets m_PassOffsets[MAX_DESCRIPTOR_SETS];
+    WGPUBuffer m_PassVertexBuffer = nullptr;
+    uint64 m_PassVertexOffset = 0;
+    WGPUBuffer m_PassIndexBuffer = nullptr;
+    uint64 m_PassIndexOffset = 0;
+    Viewport m_PassViewport{};
+    Rect2D m_PassScissor{};
+    bool m_PassViewportSet = false;
+    bool m_PassScissorSet = false;
+    void ResetPassState();
+
+    // Bound at the groups a render pipeline leaves empty (WebGPUPipeline::GetEmptyGroupMask())
+    wgpu::BindGroup m_EmptyBindGroup = nullptr;
+    void BindEmptyGroups(const WebGPUPipeline& pipeline);
 
     // Push constants staging buffer (WebGPU doesn't have native push constants)
-    static constexpr uint32 MAX_PUSH_CONSTANT_SIZE = 128;
+    static constexpr uint32 MAX_PUSH_CONSTANT_SIZE = WEBGPU_MAX_PUSH_CONSTANT_SIZE;
     uint8 m_PushConstantBuffer[MAX_PUSH_CONSTANT_SIZE] = {};
     uint32 m_PushConstantSize = 0;
     ShaderStage m_PushConstantStages = static_cast<ShaderStage>(0);
-    wgpu::Buffer m_PushConstantGPUBuffer = nullptr;
+
+    // Push constant ring: a draw with new push constants takes the next aligned slice of
+    // a chunk, bound through the dynamic offset of the chunk's bind group. The used part
+    // of each chunk is uploaded with one WriteBuffer at End(), ahead of the submit.
+    static constexpr uint32 PUSH_CONSTANT_CHUNK_SIZE = 64 * 1024;
+    struct PushConstantChunk {
+        wgpu::Buffer buffer;
+        wgpu::BindGroup bindGroup;
+        std::vector<uint8> data;  // Recorded slices
+        uint32 used = 0;          // Bytes, reset by Begin()
+    };
+    std::vector<PushConstantChunk> m_PushConstantChunks;  // Kept across recordings
+    uint32 m_PushConstantChunk = 0;                       // Being filled
+    WGPUBindGroup m_PushConstantGroup = nullptr;          // Slice of the last flush; null before one
+    uint32 m_PushConstantOffset = 0;
+    WGPUBindGroup m_PassPushConstantGroup = nullptr;      // Bound on the open pass
+    uint32 m_PassPushConstantOffset = 0;
 
     void FlushPushConstants();
+    bool AllocatePushConstantSlice(uint32& offset);
+    void UploadPushConstants();
+
+    // Open compute pass, begun when needed; null inside a render pass
+    wgpu::ComputePassEncoder GetComputePass();
+    void EndComputePass();
 };
 
 } // namespace rhi
@@ -0,0 +1,32 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUComputePipeline.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/Pipeline.h"
+#include "WebGPUTypes.h"
+
+namespace metagfx {
+namespace rhi {
+
+class WebGPUComputePipeline : public Pipeline {
+public:
+    // bindGroupLayout may be null for shaders without resources
+    WebGPUComputePipeline(WebGPUContext& context, const ComputePipelineDesc& desc,
+                          wgpu::BindGroupLayout bindGroupLayout);
+    ~WebGPUComputePipeline() override;
+
+    PipelineBindPoint GetBindPoint() const override { return PipelineBindPoint::Compute; }
+
+    // WebGPU-specific
+    wgpu::ComputePipeline GetComputePipeline() const { return m_ComputePipeline; }
+    wgpu::PipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
+
+private:
+    WebGPUContext& m_Context;
+    wgpu::ComputePipeline m_ComputePipeline = nullptr;
+    wgpu::PipelineLayout m_PipelineLayout = nullptr;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -15,8 +15,10 @@ public:
     WebGPUDescriptorSet(WebGPUContext& context, const DescriptorSetDesc& desc);
     ~WebGPUDescriptorSet() override;
 
-    void UpdateBuffer(uint32 binding, Ref<Buffer> buffer) override;
-    void UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) override;
+    void UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) override;
+    void UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
+    void UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                   const Ref<Texture>& texture, const Ref<Sampler>& sampler) override;
 
     void* GetNativeHandle(uint32 frameIndex) const override;
     void* GetNativeLayout() const override;
@@ -28,10 +30,14 @@ public:
     // Rebuild the bind group after updates
     void Update();
 
+    // True when a binding changed since the bind group was last built
+    bool IsDirty() const { return m_Dirty; }
+
 private:
     WebGPUContext& m_Context;
     wgpu::BindGroup m_BindGroup = nullptr;
     wgpu::BindGroupLayout m_BindGroupLayout = nullptr;
+    bool m_Dirty = true;
 
     // Store binding information for updates
     struct BindingInfo {
@@ -40,6 +46,7 @@ private:
         Ref<Buffer> buffer;
         Ref<Texture> texture;
         Ref<Sampler> sampler;
+        uint64 range = 0;  // 0 = whole buffer
     };
     std::vector<BindingInfo> m_Bindings;
 };
@@ -13,7 +13,7 @@ namespace rhi {
 
 class WebGPUDevice : public GraphicsDevice {
 public:
-    WebGPUDevice(SDL_Window* window);
+    WebGPUDevice(SDL_Window* window, const GraphicsDeviceDesc& desc);
     ~WebGPUDevice() override;
 
     // GraphicsDevice interface
@@ -23,17 +23,18 @@ public:
     Ref<Texture> CreateTexture(const TextureDesc& desc) override;
     Ref<Sampler> CreateSampler(const SamplerDesc& desc) override;
     Ref<Shader> CreateShader(const ShaderDesc& desc) override;
-    Ref<Pipeline> CreateGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<Pipeline> CreateComputePipeline(const ComputePipelineDesc& desc) override;
     Ref<Framebuffer> CreateFramebuffer(const FramebufferDesc& desc) override;
     Ref<DescriptorSet> CreateDescriptorSet(const DescriptorSetDesc& desc) override;
+    Ref<DrawList> CreateDrawList(const DrawListDesc& desc) override;
 
     Ref<CommandBuffer> CreateCommandBuffer() override;
+    FrameContext BeginFrame() override;
     void SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) override;
+    Ref<GpuProfiler> CreateGpuProfiler() override;
 
     void WaitIdle() override;
-
-    // Descriptor set layout management (used for pipeline creation in WebGPU)
-    void SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) override;
+    void WaitValue(uint64 value) override;
 
     Ref<SwapChain> GetSwapChain() override { return m_SwapChain; }
 
@@ -41,19 +42,43 @@ public:
     WebGPUContext& GetContext() { return m_Context; }
     const WebGPUContext& GetContext() const { return m_Context; }
 
+protected:
+    Ref<Pipeline> CompileGraphicsPipeline(const PipelineDesc& desc) override;
+    Ref<PipelineFuture> CompileGraphicsPipelineAsync(const PipelineDesc& desc) override;
+    void AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const override;
+
 private:
+    // Layout of the set; null (an empty group) without
+    wgpu::BindGroupLayout ResolveBindGroupLayout(const Ref<DescriptorSet>& descriptorSet) const;
+    // Set 0's, then desc.extraSetLayouts'
+    std::vector<wgpu::BindGroupLayout> ResolveBindGroupLayouts(const PipelineDesc& desc) const;
+
     void CreateInstance();
     void RequestAdapter();
     void RequestDevice();
     void CreateSurface(SDL_Window* window);
     void QueryDeviceCapabilities();
 
+    // Keeps the progress value of a submission until Queue::OnSubmittedWorkDone() calls back
+    struct SubmittedWork {
+        WebGPUDevice* device = nullptr;
+        uint64 value = 0;
+    };
+    static void OnSubmittedWorkDone(WGPUQueueWorkDoneStatus status, void* userdata);
+
     WebGPUContext m_Context;
     DeviceInfo m_DeviceInfo;
 
     Ref<SwapChain> m_SwapChain;
-    Ref<DescriptorSet> m_ActiveDescriptorSetLayout;  // For pipeline creation
+    Scope<WebGPUBindGroupCache> m_BindGroupCache;
+    Scope<WebGPUUploadBelt> m_UploadBelt;
+    Scope<WebGPUMipGenerator> m_MipGenerator;
+    Scope<WebGPUShaderCache> m_ShaderCache;
     SDL_Window* m_Window = nullptr;
+
+    // Recycled per-frame command buffers (each owns its push constant uniform buffer)
+    std::vector<Ref<CommandBuffer>> m_FrameCommandBuffers;
+    uint32 m_FrameIndex = 0;
 };
 
 } // namespace rhi
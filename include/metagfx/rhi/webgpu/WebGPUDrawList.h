@@ -0,0 +1,63 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUDrawList.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/DrawList.h"
+#include "WebGPUTypes.h"
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// A DrawList recorded into wgpu::RenderBundles, replayed with one ExecuteBundles. Bundles
+// inherit nothing from the pass, so each records the pipeline, bind groups (with their
+// dynamic offsets) and buffers bound at replay along with the draws, and is reused while
+// that state comes back. Per-frame ring offsets repeat from frame to frame for a steady
+// scene, so each frame slot settles on its own bundles. Past MAX_BUNDLES the least
+// recently used are dropped.
+class WebGPUDrawList : public DrawList {
+public:
+    static constexpr uint32 MAX_BUNDLES = 16;
+
+    // Everything a bundle records besides the draws; the references keep the objects,
+    // and so their handles, alive while a bundle is cached
+    struct BundleState {
+        wgpu::RenderPipeline pipeline;
+        wgpu::BindGroup bindGroups[MAX_DESCRIPTOR_SETS];  // By set, may be null
+        std::vector<uint32> dynamicOffsets[MAX_DESCRIPTOR_SETS];
+        wgpu::BindGroup pushConstantGroup;
+        uint32 pushConstantOffset = 0;
+        wgpu::Buffer vertexBuffer;
+        uint64 vertexBufferOffset = 0;
+        wgpu::Buffer indexBuffer;
+        uint64 indexBufferOffset = 0;
+        wgpu::IndexFormat indexFormat = wgpu::IndexFormat::Uint32;
+        std::vector<wgpu::TextureFormat> colorFormats;  // Of the pass executing the bundle
+        wgpu::TextureFormat depthFormat = wgpu::TextureFormat::Undefined;
+        uint32 sampleCount = 1;
+
+        bool operator==(const BundleState& other) const;
+    };
+
+    WebGPUDrawList(GraphicsDevice& device, WebGPUContext& context, const DrawListDesc& desc);
+    ~WebGPUDrawList() override = default;
+
+    // Recorded on first use with this state; null when it cannot be
+    wgpu::RenderBundle GetBundle(const BundleState& state);
+
+private:
+    struct Recorded {
+        BundleState state;
+        wgpu::RenderBundle bundle;
+    };
+
+    WebGPUContext& m_Context;
+    std::list<Recorded> m_Bundles;  // Most recently used first
+    std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
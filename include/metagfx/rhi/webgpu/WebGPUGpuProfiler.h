@@ -0,0 +1,52 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUGpuProfiler.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/rhi/GpuProfiler.h"
+#include "WebGPUTypes.h"
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Timestamp query set with GpuProfiler::MAX_QUERIES queries per frame slot, written at
+// the start of empty compute passes (WebGPUCommandBuffer::WriteTimestamp). EndFrame()
+// resolves them into the slot's readback buffer, which is mapped asynchronously from the
+// next frame on. A slot whose buffer is still mapping when it comes around drops that frame.
+class WebGPUGpuProfiler : public GpuProfiler {
+public:
+    WebGPUGpuProfiler(WebGPUContext& context, uint32 frameCount);
+    ~WebGPUGpuProfiler() override;
+
+protected:
+    void ResetQueries(CommandBuffer& cmd, uint32 frameIndex) override {}  // Queries are overwritten
+    bool WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) override;
+    bool ResolveQueries(CommandBuffer& cmd, uint32 frameIndex, uint32 queryCount) override;
+    void PollReadbacks() override;
+    bool ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) override;
+
+private:
+    enum class ReadbackState {
+        Idle,       // Free to resolve into
+        Submitted,  // Resolve recorded; mapped by the next PollReadbacks()
+        Mapping,
+        Mapped
+    };
+
+    struct Readback {
+        wgpu::Buffer buffer = nullptr;
+        ReadbackState state = ReadbackState::Idle;
+        uint32 queryCount = 0;
+    };
+
+    static void OnMapped(WGPUBufferMapAsyncStatus status, void* userdata);
+
+    WebGPUContext& m_Context;
+    wgpu::QuerySet m_QuerySet = nullptr;
+    wgpu::Buffer m_ResolveBuffer = nullptr;  // MAX_QUERIES timestamps per slot
+    std::vector<Readback> m_Readbacks;       // Per slot; stable addresses for OnMapped()
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,46 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUMipGenerator.h
+// ============================================================================
+#pragma once
+
+#include "WebGPUTypes.h"
+#include <mutex>
+#include <unordered_map>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned GPU mip generation; WebGPU has no blit. Each level is rendered from the
+// one above by a fullscreen triangle sampling it bilinearly at the new texel centers,
+// a 2x2 box filter. sRGB levels are filtered in linear space through sRGB views. One
+// render pipeline per format, created on first use.
+class WebGPUMipGenerator {
+public:
+    explicit WebGPUMipGenerator(WebGPUContext& context);
+    ~WebGPUMipGenerator() = default;
+
+    WebGPUMipGenerator(const WebGPUMipGenerator&) = delete;
+    WebGPUMipGenerator& operator=(const WebGPUMipGenerator&) = delete;
+
+    // Renderable and filterable color formats of 2D and cube textures. The texture needs
+    // TextureBinding and RenderAttachment usage.
+    static bool IsSupported(Format format, TextureType type);
+
+    // Records levels 1 to mipLevels - 1 of every layer from level 0
+    void Generate(wgpu::CommandEncoder& encoder, const wgpu::Texture& texture, Format format,
+                  uint32 mipLevels, uint32 layers);
+
+private:
+    wgpu::RenderPipeline GetPipeline(wgpu::TextureFormat format);
+
+    WebGPUContext& m_Context;
+    wgpu::ShaderModule m_Module = nullptr;
+    wgpu::Sampler m_Sampler = nullptr;
+    wgpu::BindGroupLayout m_BindGroupLayout = nullptr;
+    wgpu::PipelineLayout m_PipelineLayout = nullptr;
+    std::unordered_map<uint32, wgpu::RenderPipeline> m_Pipelines;  // By wgpu::TextureFormat
+    std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
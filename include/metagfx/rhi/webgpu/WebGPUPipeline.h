@@ -6,26 +6,49 @@
 #include "metagfx/rhi/Pipeline.h"
 #include "WebGPUTypes.h"
 
+#include <functional>
+
 namespace metagfx {
 namespace rhi {
 
 class WebGPUPipeline : public Pipeline {
 public:
-    WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc);
+    // bindGroupLayouts are those of sets 0 and up; null ones (or none, for shaders
+    // without descriptor sets) take an empty layout
+    WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc,
+                   const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts);
     ~WebGPUPipeline() override;
 
+    // Compiles with CreateRenderPipelineAsync(), so the browser compiles off the main
+    // thread; the future resolves once the driver calls back
+    static Ref<PipelineFuture> CreateAsync(WebGPUContext& context, const PipelineDesc& desc,
+                                           const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts);
+
     // WebGPU-specific
     wgpu::RenderPipeline GetRenderPipeline() const { return m_RenderPipeline; }
     wgpu::PipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
+    // Bit per group below WEBGPU_PUSH_CONSTANT_GROUP with the empty layout, which still
+    // needs an (empty) bind group bound at draws
+    uint32 GetEmptyGroupMask() const { return m_EmptyGroupMask; }
 
     wgpu::PrimitiveTopology GetPrimitiveTopology() const { return m_PrimitiveTopology; }
     wgpu::CullMode GetCullMode() const { return m_CullMode; }
     wgpu::FrontFace GetFrontFace() const { return m_FrontFace; }
 
 private:
+    explicit WebGPUPipeline(WebGPUContext& context);  // Compiled by CreateAsync()
+
+    static void OnCreated(WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline renderPipeline,
+                          char const* message, void* userdata);
+
+    // Creates the layout and hands the filled descriptor to create
+    void Build(const PipelineDesc& desc, const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts,
+               const std::function<void(const wgpu::RenderPipelineDescriptor&)>& create);
+
     WebGPUContext& m_Context;
     wgpu::RenderPipeline m_RenderPipeline = nullptr;
     wgpu::PipelineLayout m_PipelineLayout = nullptr;
+    uint32 m_EmptyGroupMask = 0;
 
     wgpu::PrimitiveTopology m_PrimitiveTopology = wgpu::PrimitiveTopology::TriangleList;
     wgpu::CullMode m_CullMode = wgpu::CullMode::Back;
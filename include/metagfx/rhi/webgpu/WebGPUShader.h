@@ -6,6 +6,9 @@
 #include "metagfx/rhi/Shader.h"
 #include "WebGPUTypes.h"
 
+#include <string>
+#include <vector>
+
 namespace metagfx {
 namespace rhi {
 
@@ -20,6 +23,9 @@ public:
     wgpu::ShaderModule GetModule() const { return m_Module; }
     const std::string& GetEntryPoint() const { return m_EntryPoint; }
     const std::string& GetWGSLSource() const { return m_WGSLSource; }
+    // Override constant entries for the specialization constants this module declares
+    // (Tint turns each constant_id into an @id(N) override); entries point into the shader
+    std::vector<wgpu::ConstantEntry> GetOverrideConstants(const std::vector<SpecializationConstant>& constants) const;
 
 private:
     WebGPUContext& m_Context;
@@ -27,6 +33,7 @@ private:
     ShaderStage m_Stage;
     std::string m_EntryPoint;
     std::string m_WGSLSource;  // Store WGSL source for debugging
+    std::vector<std::string> m_OverrideIds;  // Decimal ids of the @id(N) overrides
 };
 
 } // namespace rhi
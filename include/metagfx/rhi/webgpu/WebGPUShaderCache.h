@@ -0,0 +1,49 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUShaderCache.h
+// ============================================================================
+#pragma once
+
+#include "WebGPUTypes.h"
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned SPIR-V to WGSL translations by SPIR-V hash, so Tint (slow, and slower
+// still in WASM) only runs for modules no cache has. Looked up in order:
+//
+// - GraphicsDeviceDesc::precompiledShaders: WGSL translated by tint at build time and
+//   embedded in the application.
+// - Translations made by this device, e.g. for hot-reloaded shaders.
+// - <path>.wgsl/<spirv hash>.wgsl next to GraphicsDeviceDesc::pipelineCachePath, the
+//   fallback of warm starts. Skipped with an empty path.
+//
+// Sources are Tint's output as is; WebGPUShader rewrites push constants after the lookup.
+// Thread-safe.
+class WebGPUShaderCache {
+public:
+    WebGPUShaderCache(const std::string& filePath, const PrecompiledShader* precompiled, uint32 precompiledCount);
+    ~WebGPUShaderCache() = default;
+
+    WebGPUShaderCache(const WebGPUShaderCache&) = delete;
+    WebGPUShaderCache& operator=(const WebGPUShaderCache&) = delete;
+
+    // FNV-1a, as MetalPipelineCache and HashShader.cmake
+    static uint64 HashSpirv(const void* data, uint64 size);
+
+    bool Find(uint64 spirvHash, std::string& outSource);
+    void Store(uint64 spirvHash, const std::string& source);
+
+private:
+    std::string GetShaderPath(uint64 spirvHash) const;
+
+    std::string m_ShaderDirectory;
+    std::unordered_map<uint64, const char*> m_Precompiled;
+    std::unordered_map<uint64, std::string> m_Translated;
+    std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -13,7 +13,7 @@ namespace rhi {
 
 class WebGPUSwapChain : public SwapChain {
 public:
-    WebGPUSwapChain(WebGPUContext& context, SDL_Window* window);
+    WebGPUSwapChain(WebGPUContext& context, SDL_Window* window, PresentMode presentMode);
     ~WebGPUSwapChain() override;
 
     void Present() override;
@@ -24,6 +24,9 @@ public:
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
 
+    void SetPresentMode(PresentMode mode) override;
+    PresentMode GetPresentMode() const override { return m_PresentMode; }
+
     // WebGPU-specific
     wgpu::SwapChain GetHandle() const { return m_SwapChain; }
 
@@ -39,6 +42,7 @@ private:
     uint32 m_Width = 0;
     uint32 m_Height = 0;
     Format m_Format = Format::B8G8R8A8_UNORM;
+    PresentMode m_PresentMode = PresentMode::Fifo;
 };
 
 } // namespace rhi
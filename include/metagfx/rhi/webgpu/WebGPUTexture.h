@@ -17,12 +17,16 @@ public:
     uint32 GetWidth() const override { return m_Width; }
     uint32 GetHeight() const override { return m_Height; }
     Format GetFormat() const override { return m_Format; }
+    uint32 GetMipLevels() const override { return m_MipLevels; }
+    uint32 GetSampleCount() const override { return m_SampleCount; }
 
     void UploadData(const void* data, uint64 size) override;
 
     // WebGPU-specific
     wgpu::Texture GetHandle() const { return m_Texture; }
     wgpu::TextureView GetView() const { return m_TextureView; }
+    // TextureUsage::Transient: render passes discard it
+    bool IsTransient() const { return (static_cast<int>(m_Usage) & static_cast<int>(TextureUsage::Transient)) != 0; }
 
 private:
     void CreateTexture(const TextureDesc& desc);
@@ -36,9 +40,14 @@ private:
     uint32 m_Height = 0;
     uint32 m_Depth = 1;
     uint32 m_MipLevels = 1;
+    uint32 m_SampleCount = 1;
     Format m_Format = Format::Undefined;
     TextureType m_Type = TextureType::Texture2D;
     TextureUsage m_Usage;
+    MemoryCategory m_MemoryCategory = MemoryCategory::Texture;
+    uint64 m_MemoryBytes = 0;  // Counted in WebGPUContext::memory
+    bool m_GenerateMipmaps = false;  // UploadData() receives mip 0 only
+    bool m_GPUMipmaps = false;       // Generated by WebGPUMipGenerator, else on the CPU
 };
 
 } // namespace rhi
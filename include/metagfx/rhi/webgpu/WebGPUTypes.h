@@ -5,6 +5,8 @@
 
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/rhi/FrameStats.h"
+#include "metagfx/rhi/MemoryStats.h"
 
 // Dawn WebGPU C++ headers
 #include <webgpu/webgpu_cpp.h>
@@ -18,6 +20,18 @@ namespace rhi {
 #define WEBGPU_LOG_ERROR(msg) \
     METAGFX_ERROR << "WebGPU error: " << msg << " at " << __FILE__ << ":" << __LINE__
 
+class WebGPUBindGroupCache;
+class WebGPUUploadBelt;
+class WebGPUMipGenerator;
+class WebGPUShaderCache;
+
+// WebGPU has no push constants. WebGPUShader turns a shader's push constant block into a
+// uniform buffer at @group(PUSH_CONSTANT_GROUP) @binding(0), which WebGPUCommandBuffer
+// binds with a dynamic offset into its ring of per-draw blocks. Descriptor sets take the
+// groups below it, one per set.
+constexpr uint32 WEBGPU_PUSH_CONSTANT_GROUP = MAX_DESCRIPTOR_SETS;
+constexpr uint32 WEBGPU_MAX_PUSH_CONSTANT_SIZE = 128;
+
 // WebGPU context shared across all WebGPU objects
 struct WebGPUContext {
     wgpu::Instance instance = nullptr;
@@ -30,11 +44,29 @@ struct WebGPUContext {
     bool supportsTimestampQueries = false;
     bool supportsDepthClipControl = false;
     bool supportsBGRA8UnormStorage = false;
+    bool supportsBCTextures = false;
+    bool supportsETC2Textures = false;
+    bool supportsASTCTextures = false;
+    bool isIntegratedGPU = false;
 
     // Limits
     uint32_t maxBindGroups = 4;
     uint32_t maxUniformBufferBindingSize = 65536;
     uint32_t minUniformBufferOffsetAlignment = 256;
+
+    // Owned by WebGPUDevice; descriptor sets take their layouts and bind groups from it
+    WebGPUBindGroupCache* bindGroupCache = nullptr;
+    // Owned by WebGPUDevice; textures upload through the belt, which it flushes before
+    // submitting frame work, and generate mips with the generator in the same batch
+    WebGPUUploadBelt* uploadBelt = nullptr;
+    WebGPUMipGenerator* mipGenerator = nullptr;
+    // Owned by WebGPUDevice; shaders take their WGSL from it before translating
+    WebGPUShaderCache* shaderCache = nullptr;
+
+    // Owned by WebGPUDevice; objects add the device work of the frame (GetFrameStats())
+    // and the memory of their resources (GetMemoryStats())
+    FrameStatsCounters* stats = nullptr;
+    MemoryCounters* memory = nullptr;
 };
 
 // Format conversion utilities
@@ -0,0 +1,75 @@
+// ============================================================================
+// include/metagfx/rhi/webgpu/WebGPUUploadBelt.h
+// ============================================================================
+#pragma once
+
+#include "WebGPUTypes.h"
+#include <functional>
+#include <mutex>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+// Device-owned staging belt batching texture uploads. queue.WriteTexture is a round-trip
+// per call (in the browser a JavaScript call and a copy), so textures write their levels
+// into mapped staging chunks instead and record CopyBufferToTexture into one command
+// encoder shared by every upload until Flush(). WebGPUDevice flushes before submitting
+// frame work, which thus sees the data.
+//
+// Chunks are MapWrite | CopySrc buffers created mapped. After a flush they are mapped
+// again asynchronously and reused once the map completes (device.Tick() in BeginFrame()).
+// Thread-safe.
+class WebGPUUploadBelt {
+public:
+    static constexpr uint64 CHUNK_SIZE = 4 * 1024 * 1024;  // Larger uploads get a chunk of their own
+
+    explicit WebGPUUploadBelt(WebGPUContext& context);
+    ~WebGPUUploadBelt();
+
+    WebGPUUploadBelt(const WebGPUUploadBelt&) = delete;
+    WebGPUUploadBelt& operator=(const WebGPUUploadBelt&) = delete;
+
+    // Copies rowCount rows of rowPitch bytes (one image) into the belt and records their
+    // copy into extent of the level and layer. False when no staging memory could be had;
+    // the caller writes through the queue then.
+    bool WriteTexture(const wgpu::Texture& texture, uint32 mipLevel, uint32 layer, const void* data,
+                      uint32 rowPitch, uint32 rowCount, const wgpu::Extent3D& extent);
+
+    // Records GPU work on uploaded data into the batch, after the copies so far
+    void Record(const std::function<void(wgpu::CommandEncoder&)>& record);
+
+    // Submits the batch; nothing when it is empty
+    void Flush();
+
+private:
+    enum class ChunkState {
+        Free,     // Mapped, nothing written
+        Pending,  // Written by the open batch
+        Mapping   // Submitted, mapping again
+    };
+
+    struct Chunk {
+        WebGPUUploadBelt* belt = nullptr;
+        wgpu::Buffer buffer;
+        uint64 size = 0;
+        uint64 used = 0;
+        uint8* mapped = nullptr;  // Null while not mapped, or after a failed map
+        ChunkState state = ChunkState::Free;
+    };
+
+    static void OnMapped(WGPUBufferMapAsyncStatus status, void* userdata);
+
+    // Aligned staging range in a pending chunk; null when none could be had
+    Chunk* Allocate(uint64 size, uint64& offset);
+    wgpu::CommandEncoder& GetEncoder();
+
+    WebGPUContext& m_Context;
+    std::vector<Scope<Chunk>> m_Chunks;  // Stable addresses for OnMapped()
+    Chunk* m_Current = nullptr;          // Being filled
+    wgpu::CommandEncoder m_Encoder = nullptr;  // Open batch; null when empty
+    std::mutex m_Mutex;
+};
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,102 @@
+// ============================================================================
+// include/metagfx/scene/AmbientOcclusion.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Screen-space ambient occlusion of the scene depth, for the ambient lighting
+ *
+ * Apply() runs two passes over the depth buffer:
+ * - At half resolution, ground-truth ambient occlusion (GTAO, Jimenez et al., "Practical
+ *   Realtime Strategies for Accurate Indirect Occlusion"): each texel searches the depth
+ *   for the horizons of a few screen-space slices around it, within the radius, and
+ *   integrates the visible part of the hemisphere over its normal (from the depth)
+ * - At full resolution, each pixel takes the half-resolution texels around it weighed by
+ *   how close their depth is to its own (a bilateral upsample, so the occlusion does not
+ *   bleed across edges), and with temporal accumulation blends in its reprojected history
+ *   where the history's depth agrees
+ *
+ * The slices rotate every frame under temporal accumulation, which temporal AA's jitter
+ * goes with, so a few slices per pixel add up to many over the frames.
+ *
+ * The half-resolution texture and the two histories are owned here, sized for the depth
+ * buffer; the output is a texture of the frame's render graph, one OUTPUT_FORMAT texel
+ * per pixel with the visibility, 0 occluded to 1 open. SetSources() rebinds them when
+ * they change, keeping the replaced textures and sets until no frame in flight uses them.
+ */
+class AmbientOcclusion {
+public:
+    static constexpr rhi::Format OUTPUT_FORMAT = rhi::Format::R32_SFLOAT;
+
+    struct Settings {
+        float radius = 1.0f;         // Of the search, in world units
+        float intensity = 1.0f;      // Exponent of the visibility
+        float historyWeight = 0.9f;  // Of the history in the temporal blend
+    };
+
+    // shader runs ambient_occlusion.comp
+    AmbientOcclusion(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~AmbientOcclusion() = default;
+
+    AmbientOcclusion(const AmbientOcclusion&) = delete;
+    AmbientOcclusion& operator=(const AmbientOcclusion&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // The next Apply() starts from the current frame alone: after a cut or a new scene
+    void ResetHistory() { m_HistoryValid = false; }
+
+    // The frame's depth buffer and the output, a storage texture of OUTPUT_FORMAT of the
+    // same size; call before Apply()
+    void SetSources(Ref<rhi::Texture> depth, Ref<rhi::Texture> output);
+
+    /**
+     * @brief Record the occlusion and upsample dispatches (outside any render pass)
+     *
+     * Reads the depth and writes the output as storage; the caller orders them against
+     * the pass filling the depth and the lighting pass (see RenderGraph).
+     * @param projection   The camera's (jittered) projection the depth was drawn with
+     * @param reprojection This frame's view space to the last frame's
+     * @param temporal     Accumulate over frames, rotating the slices
+     * @param width, height Of the depth drawn, its top-left region (dynamic resolution);
+     *                      0 takes all of it
+     */
+    void Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& projection,
+               const glm::mat4& reprojection, bool temporal, uint32 width = 0, uint32 height = 0);
+
+private:
+    void Resize(uint32 width, uint32 height);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Texture> m_HalfResolution;  // Visibility and view depth, packed as halves
+    Ref<rhi::Texture> m_History[2];      // Likewise, at full resolution
+    // Set i reads history 1 - i and writes history i
+    Ref<rhi::DescriptorSet> m_DescriptorSets[2];
+    Ref<rhi::Texture> m_Depth;
+    Ref<rhi::Texture> m_Output;
+    uint32 m_Current = 0;        // History written by the next Apply()
+    uint32 m_FrameCounter = 0;   // Rotates the slices under temporal accumulation
+    glm::uvec2 m_HistorySize{ 0 };  // Of the region the history was drawn for
+    bool m_HistoryValid = false;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
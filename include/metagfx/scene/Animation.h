@@ -0,0 +1,162 @@
+// ============================================================================
+// include/metagfx/scene/Animation.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Mesh.h"
+#include <glm/glm.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+class Model;
+
+/**
+ * @brief Joints and weights of one skinned vertex, parallel to the mesh's vertices
+ *
+ * Up to four influences; joints index the mesh's Skin, weights are unorm16 summing to 1.
+ */
+struct SkinVertex {
+    uint16 joints[4] = { 0, 0, 0, 0 };
+    uint16 weights[4] = { 0, 0, 0, 0 };
+};
+
+/**
+ * @brief Offset of one vertex under one morph target at full weight
+ */
+struct MorphTargetDelta {
+    glm::vec4 position = glm::vec4(0.0f);  // w unused
+    glm::vec4 normal = glm::vec4(0.0f);
+};
+
+/**
+ * @brief Joint list of a skinned mesh
+ *
+ * joints are model nodes (ModelData::nodes); inverseBindMatrices take the mesh's space
+ * to each joint's in the bind pose.
+ */
+struct Skin {
+    std::vector<uint32> joints;
+    std::vector<glm::mat4> inverseBindMatrices;
+};
+
+enum class AnimationPath {
+    Translation,  // values: xyz
+    Rotation,     // values: quaternion xyzw
+    Scale,        // values: xyz
+    Weights       // weights: weightCount morph target weights per key
+};
+
+/**
+ * @brief Keyframes of one property of one node, sampled linearly (rotations by slerp)
+ */
+struct AnimationChannel {
+    uint32 node = 0;
+    AnimationPath path = AnimationPath::Translation;
+    std::vector<float> times;        // Seconds, increasing
+    std::vector<glm::vec4> values;   // One per key, all paths but Weights
+    std::vector<float> weights;      // weightCount per key, Weights only
+    uint32 weightCount = 0;
+};
+
+struct AnimationClip {
+    std::string name;
+    float duration = 0.0f;  // Seconds
+    std::vector<AnimationChannel> channels;
+};
+
+/**
+ * @brief Deformation of one mesh of a model, kept on the CPU for Skinning to upload
+ */
+struct DeformedMesh {
+    static constexpr uint32 NO_SKIN = ~0u;
+
+    uint32 mesh = 0;                  // Model::GetMeshes() index
+    uint32 node = 0;                  // Node the mesh hangs from
+    uint32 skin = NO_SKIN;            // Model::GetSkins() index
+    uint32 morphTargetCount = 0;
+    std::vector<Vertex> bindPose;     // The mesh's vertices as imported
+    std::vector<SkinVertex> skinVertices;        // One per vertex with a skin
+    std::vector<MorphTargetDelta> morphDeltas;   // morphTargetCount * vertices, target after target
+    std::vector<float> morphWeights;             // Default weight of each target
+};
+
+/**
+ * @brief Plays a model's animation clips and poses its skeleton
+ *
+ * Update() samples the playing clip into the local transforms of the nodes it drives
+ * (GetAnimatedNodes(); the others keep the model's), resolves the world transforms
+ * relative to the model root and from them each deformed mesh's joint palette and
+ * morph target weights, which Skinning uploads. Nothing here touches the device.
+ *
+ * A palette matrix takes a vertex from the mesh's bind pose to its posed place in the
+ * space of the mesh's node: inverse(mesh node) * joint * inverse bind. The posed mesh
+ * is then drawn with its node's transform like any other.
+ *
+ * UpdateAll() poses many animators (characters) at once, one job each on the JobSystem.
+ */
+class Animator {
+public:
+    static constexpr uint32 NO_CLIP = ~0u;
+
+    // The model must outlive the animator
+    explicit Animator(const Model& model);
+
+    Animator(const Animator&) = delete;
+    Animator& operator=(const Animator&) = delete;
+
+    // Clip index into Model::GetAnimations(), or NO_CLIP for the bind pose; restarts it
+    void Play(uint32 clip);
+    uint32 GetClip() const { return m_Clip; }
+
+    void SetPaused(bool paused) { m_Paused = paused; }
+    bool IsPaused() const { return m_Paused; }
+    void SetSpeed(float speed) { m_Speed = speed; }
+    float GetSpeed() const { return m_Speed; }
+    float GetTime() const { return m_Time; }
+
+    // Advance the clip by deltaTime seconds (looping), then pose
+    void Update(float deltaTime);
+    // Update() of every animator, in parallel on the job system when there are several
+    static void UpdateAll(std::span<Animator* const> animators, float deltaTime);
+
+    // Nodes the playing clip drives, in increasing order; empty in the bind pose
+    const std::vector<uint32>& GetAnimatedNodes() const { return m_AnimatedNodes; }
+    const glm::mat4& GetLocalTransform(uint32 node) const { return m_Local[node]; }
+
+    // Of Model::GetDeformedMeshes()[index]: one matrix per joint of its skin (empty
+    // without one) and one weight per morph target
+    std::span<const glm::mat4> GetPalette(uint32 index) const;
+    std::span<const float> GetMorphWeights(uint32 index) const;
+
+private:
+    // Translation, rotation (quaternion xyzw) and scale of a node
+    struct Pose {
+        glm::vec3 translation = glm::vec3(0.0f);
+        glm::vec4 rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        glm::vec3 scale = glm::vec3(1.0f);
+    };
+
+    void Evaluate();
+
+    const Model& m_Model;
+    uint32 m_Clip = NO_CLIP;
+    float m_Time = 0.0f;
+    float m_Speed = 1.0f;
+    bool m_Paused = false;
+
+    std::vector<Pose> m_BindPoses;       // Decomposed local transforms of the model's nodes
+    std::vector<glm::mat4> m_Local;
+    std::vector<glm::mat4> m_World;      // Relative to the model root
+    std::vector<uint32> m_AnimatedNodes;
+    std::vector<Pose> m_Poses;           // Scratch of the animated nodes
+    std::vector<glm::mat4> m_Palettes;   // Every deformed mesh's, one after the other
+    std::vector<float> m_MorphWeights;
+    std::vector<uint32> m_PaletteOffsets;  // Per deformed mesh, plus the end
+    std::vector<uint32> m_WeightOffsets;
+};
+
+} // namespace metagfx
@@ -0,0 +1,85 @@
+// ============================================================================
+// include/metagfx/scene/AutoExposure.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Exposure of the HDR scene color measured on the GPU, for the tone mapping pass
+ *
+ * Measure() histograms the log luminance of every other pixel in x and y with
+ * shared-memory atomics, then one group reduces the histogram to its mean luminance and
+ * moves the adapted luminance toward it at the adaptation rate. The exposure mapping
+ * the adapted luminance to middle grey stays in GetExposureBuffer(), which the tone
+ * mapping pass reads (ToneMapper::SetSource()): nothing is read back.
+ *
+ * The scene color is a texture of the frame's render graph: SetSource() rebinds it when
+ * it changes, keeping the replaced set until no frame in flight uses it.
+ */
+class AutoExposure {
+public:
+    static constexpr uint32 HISTOGRAM_BINS = 256;  // Must match auto_exposure.comp
+
+    struct Settings {
+        float minLogLuminance = -10.0f;  // log2 of the darkest luminance told apart
+        float maxLogLuminance = 4.0f;    // log2 of the brightest
+        float adaptationRate = 1.5f;     // Per second: 1 - e^(-rate) of the way each second
+    };
+
+    // Contents of GetExposureBuffer()
+    struct ExposureState {
+        float luminance;  // Adapted scene luminance
+        float exposure;   // Scale of the scene color
+    };
+
+    // shader runs auto_exposure.comp
+    AutoExposure(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~AutoExposure() = default;
+
+    AutoExposure(const AutoExposure&) = delete;
+    AutoExposure& operator=(const AutoExposure&) = delete;
+
+    bool IsValid() const { return m_Pipeline && m_Histogram && m_ExposureState; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // The frame's scene color; call before Measure()
+    void SetSource(Ref<rhi::Texture> sceneColor);
+
+    /**
+     * @brief Record the histogram and adaptation dispatches (outside any render pass)
+     *
+     * Reads the scene color and writes the exposure buffer as storage; the caller orders
+     * them against the main pass and the tone mapping pass (see RenderGraph).
+     * @param deltaTime Seconds since the last Measure(), for the adaptation
+     */
+    void Measure(rhi::CommandBuffer& cmd, uint32 frameIndex, float deltaTime);
+
+    const Ref<rhi::Buffer>& GetExposureBuffer() const { return m_ExposureState; }
+
+private:
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Buffer> m_Histogram;      // HISTOGRAM_BINS counts, zero between frames
+    Ref<rhi::Buffer> m_ExposureState;  // ExposureState
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_SceneColor;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
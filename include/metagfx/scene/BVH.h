@@ -0,0 +1,102 @@
+// ============================================================================
+// include/metagfx/scene/BVH.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Frustum.h"
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+namespace metagfx {
+
+struct AABB {
+    glm::vec3 min = glm::vec3(0.0f);
+    glm::vec3 max = glm::vec3(0.0f);
+
+    glm::vec3 GetCenter() const { return (min + max) * 0.5f; }
+    glm::vec3 GetExtent() const { return max - min; }
+    float GetSurfaceArea() const;
+
+    bool Contains(const AABB& other) const;
+    bool Overlaps(const AABB& other) const;
+    static AABB Union(const AABB& a, const AABB& b);
+
+    // Box of the transformed box (exact for the corners, so rotations grow it)
+    static AABB Transform(const AABB& box, const glm::mat4& matrix);
+
+    // Entry distance of the ray into the box, if it enters before maxT
+    bool IntersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxT,
+                       float& outT) const;
+};
+
+/**
+ * @brief Dynamic bounding volume hierarchy of boxes
+ *
+ * A binary tree of enlarged ("fat") leaf boxes kept balanced by rotations on insert and
+ * remove, so queries visit O(log n) nodes. Update() only reinserts a leaf when its new
+ * box leaves the fat one, so objects that move a little cost nothing to refit.
+ *
+ * Leaves are identified by proxy ids that stay valid until Remove(); each carries a
+ * caller-defined 32-bit value. Not thread-safe.
+ */
+class BVH {
+public:
+    static constexpr uint32 INVALID_PROXY = ~0u;
+
+    BVH() = default;
+
+    // Add a leaf; returns its proxy id
+    uint32 Insert(const AABB& bounds, uint32 userData);
+    void Remove(uint32 proxy);
+
+    // Move a leaf; returns true if it had to be reinserted
+    bool Update(uint32 proxy, const AABB& bounds);
+
+    void Clear();
+
+    uint32 GetUserData(uint32 proxy) const { return m_Nodes[proxy].userData; }
+    const AABB& GetFatBounds(uint32 proxy) const { return m_Nodes[proxy].bounds; }
+    uint32 GetLeafCount() const { return m_LeafCount; }
+    uint32 GetHeight() const;
+
+    // Proxies whose fat box intersects the frustum (subtrees fully inside are taken
+    // whole, without testing their leaves)
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32>& outProxies) const;
+
+    // Proxies whose fat box overlaps the box
+    void QueryBox(const AABB& box, std::vector<uint32>& outProxies) const;
+
+    // Visit proxies whose fat box the ray (direction need not be normalized) enters
+    // before maxT, nearest subtree first. The visitor returns the new maxT: the hit
+    // distance to keep only nearer candidates, or its argument to keep searching.
+    void QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxT,
+                  const std::function<float(uint32 proxy, float maxT)>& visitor) const;
+
+private:
+    struct Node {
+        AABB bounds;
+        uint32 parent = INVALID_PROXY;  // Next free node while on the free list
+        uint32 child1 = INVALID_PROXY;
+        uint32 child2 = INVALID_PROXY;
+        int32 height = 0;  // 0 for leaves, -1 for free nodes
+        uint32 userData = 0;
+
+        bool IsLeaf() const { return child1 == INVALID_PROXY; }
+    };
+
+    uint32 AllocateNode();
+    void FreeNode(uint32 node);
+    void InsertLeaf(uint32 leaf);
+    void RemoveLeaf(uint32 leaf);
+    uint32 Balance(uint32 node);              // Returns the new root of the subtree
+    void CollectLeaves(uint32 node, std::vector<uint32>& outProxies) const;
+
+    std::vector<Node> m_Nodes;
+    uint32 m_Root = INVALID_PROXY;
+    uint32 m_FreeList = INVALID_PROXY;
+    uint32 m_LeafCount = 0;
+};
+
+} // namespace metagfx
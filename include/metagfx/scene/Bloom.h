@@ -0,0 +1,79 @@
+// ============================================================================
+// include/metagfx/scene/Bloom.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Bloom of the HDR scene color, blended into it before tone mapping
+ *
+ * Apply() downsamples the scene color into a mip chain with the 13-tap filter, adds
+ * each level's tent upsample to the level above it from the smallest up, and blends the
+ * result into the scene color by the strength. Bright emissive surfaces and highlights
+ * spread light over a wide radius for the cost of a few half-resolution passes; there is
+ * no threshold, so the bloom stays proportional to the scene's energy.
+ *
+ * The chain lives in a storage buffer sized for the scene color, one level after another,
+ * like GPUCuller's depth pyramid. SetSource() resizes it when the scene color changes
+ * size, keeping the replaced buffer and set until no frame in flight uses them.
+ */
+class Bloom {
+public:
+    static constexpr uint32 MAX_LEVELS = 6;  // Level 0 is half the scene color
+
+    struct Settings {
+        float strength = 0.04f;  // Fraction of the scene color the bloom replaces
+    };
+
+    // shader runs bloom.comp
+    Bloom(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~Bloom() = default;
+
+    Bloom(const Bloom&) = delete;
+    Bloom& operator=(const Bloom&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // The frame's scene color, a storage texture; call before Apply()
+    void SetSource(Ref<rhi::Texture> sceneColor);
+
+    // Outside any render pass: reads and writes the scene color as storage
+    void Apply(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+    uint32 GetLevelCount() const { return static_cast<uint32>(m_Levels.size()); }
+
+private:
+    struct Level {
+        uint32 offset;  // In texels of the chain
+        uint32 width;
+        uint32 height;
+    };
+
+    void Resize(uint32 width, uint32 height);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Buffer> m_Chain;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_SceneColor;
+    std::vector<Level> m_Levels;
+    uint32 m_Width = 0;   // Of the scene color the chain is sized for
+    uint32 m_Height = 0;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "metagfx/core/Types.h"
+#include "metagfx/scene/Frustum.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -14,8 +15,20 @@ enum class CameraProjection {
     Orthographic
 };
 
+/**
+ * @brief The view and projection of the main camera
+ *
+ * Projections are reverse-Z in Vulkan's [0, 1] depth range: NEAR_DEPTH at the near plane,
+ * FAR_DEPTH at the far plane, which perspective projections put at infinity. The passes
+ * of the camera clear depth to FAR_DEPTH and keep nearer fragments with
+ * CompareOp::Greater or GreaterOrEqual; shaders reading their depth treat FAR_DEPTH as
+ * nothing drawn. Shadow maps keep the standard convention.
+ */
 class Camera {
 public:
+    static constexpr float NEAR_DEPTH = 1.0f;
+    static constexpr float FAR_DEPTH = 0.0f;
+
     Camera(float fov = 45.0f, float aspectRatio = 16.0f / 9.0f, 
            float nearPlane = 0.1f, float farPlane = 100.0f);
     ~Camera() = default;
@@ -25,6 +38,11 @@ public:
     void SetOrthographic(float left, float right, float bottom, float top, 
                         float nearPlane, float farPlane);
     void SetAspectRatio(float aspectRatio);
+
+    // Sub-pixel offset of the projection in NDC units (2 / the viewport size is one
+    // pixel), moved every frame by temporal anti-aliasing. Kept across projection changes.
+    void SetJitter(const glm::vec2& jitter);
+    const glm::vec2& GetJitter() const { return m_Jitter; }
     
     // Transform
     void SetPosition(const glm::vec3& position);
@@ -57,8 +75,14 @@ public:
 
     // Getters
     const glm::mat4& GetViewMatrix() const { return m_ViewMatrix; }
-    const glm::mat4& GetProjectionMatrix() const { return m_ProjectionMatrix; }
+    const glm::mat4& GetProjectionMatrix() const { return m_ProjectionMatrix; }  // Jittered
     glm::mat4 GetViewProjectionMatrix() const { return m_ProjectionMatrix * m_ViewMatrix; }
+    // Without the jitter, for motion between frames
+    const glm::mat4& GetUnjitteredProjectionMatrix() const { return m_UnjitteredProjectionMatrix; }
+    glm::mat4 GetUnjitteredViewProjectionMatrix() const { return m_UnjitteredProjectionMatrix * m_ViewMatrix; }
+
+    // World-space clip planes of the current view and projection, for CPU culling
+    Frustum GetFrustumPlanes() const { return Frustum::FromMatrix(GetViewProjectionMatrix()); }
     
     const glm::vec3& GetPosition() const { return m_Position; }
     const glm::vec3& GetFront() const { return m_Front; }
@@ -67,10 +91,13 @@ public:
     
     float GetFOV() const { return m_FOV; }
     float GetNearPlane() const { return m_NearPlane; }
+    // Of the view range the shadow cascades and light clusters cover; perspective
+    // projections reach past it
     float GetFarPlane() const { return m_FarPlane; }
 
 private:
     void UpdateViewMatrix();
+    void UpdateProjectionMatrix();
     void UpdateVectors();
 
     // Projection parameters
@@ -112,6 +139,8 @@ private:
     // Matrices
     glm::mat4 m_ViewMatrix = glm::mat4(1.0f);
     glm::mat4 m_ProjectionMatrix = glm::mat4(1.0f);
+    glm::mat4 m_UnjitteredProjectionMatrix = glm::mat4(1.0f);
+    glm::vec2 m_Jitter = glm::vec2(0.0f);
 };
 
 } // namespace metagfx
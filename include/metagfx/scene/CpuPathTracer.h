@@ -0,0 +1,187 @@
+// ============================================================================
+// include/metagfx/scene/CpuPathTracer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/SimdMath.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Light.h"
+#include <glm/glm.hpp>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+struct ModelData;
+
+/**
+ * @brief Path tracer on the CPU, for machines without ray queries (headless farm nodes)
+ *
+ * Build() flattens a ModelData, as ModelImporter returns it, into world-space triangles
+ * and decodes its material textures, then builds a four-wide BVH over the triangles:
+ * binned SAH splits, each node's four children kept as one simd::Box4 so a ray tests
+ * them in one IntersectRayBox4(). Large ranges bin in parallel and subtrees build as
+ * JobSystem jobs.
+ *
+ * Render() traces TILE_SIZE tiles as JobSystem work, the tiles handed out one at a
+ * time so threads that finish early take more. Paths follow path_trace.comp: the same
+ * PCG random numbers, next event estimation against the lights, Lambert and GGX lobes
+ * of model.frag's BRDF and Russian roulette, so the image converges to the GPU
+ * tracer's. Materials are the rasterizer's (MaterialDesc) sampled at their top level.
+ *
+ * Not thread-safe: Build() and Render() must not overlap.
+ */
+class CpuPathTracer {
+public:
+    static constexpr uint32 TILE_SIZE = 16;          // Pixels per side of a job's tile
+    static constexpr uint32 MAX_LEAF_TRIANGLES = 4;
+    static constexpr uint32 SAH_BINS = 16;           // Per axis and split
+
+    struct Settings {
+        uint32 samplesPerPixel = 64;
+        uint32 maxBounces = 4;  // Surface hits after the camera ray's
+    };
+
+    struct View {
+        glm::mat4 viewProjection = glm::mat4(1.0f);  // +Y up in NDC, as glm::perspective builds it
+        glm::vec3 cameraPosition = glm::vec3(0.0f);
+    };
+
+    struct Stats {
+        uint32 triangleCount = 0;
+        uint32 nodeCount = 0;
+        uint32 textureCount = 0;
+        double buildMs = 0.0;   // BVH only
+        double renderMs = 0.0;  // Of the last Render()
+        uint64 rayCount = 0;    // Of the last Render(), shadow rays included
+    };
+
+    CpuPathTracer() = default;
+
+    CpuPathTracer(const CpuPathTracer&) = delete;
+    CpuPathTracer& operator=(const CpuPathTracer&) = delete;
+
+    /**
+     * @brief Take the model's triangles and materials
+     *
+     * Meshes are placed by their node transforms. External textures are read relative
+     * to modelPath's directory; a texture that fails to decode (KTX2, raw embedded
+     * texels) leaves its slot on the material's constant. Returns false without triangles.
+     */
+    bool Build(const ModelData& model, const std::string& modelPath);
+
+    // Lights as the GPU light buffer holds them (Light::ToGPUData())
+    void SetLights(const std::vector<LightData>& lights) { m_Lights = lights; }
+
+    // Radiance of rays that leave the scene: a constant, or an equirectangular RGB map
+    // (width * height * 3 floats, +Y up) times intensity
+    void SetEnvironment(const glm::vec3& color);
+    void SetEnvironmentMap(std::vector<float> rgb, uint32 width, uint32 height, float intensity);
+
+    /**
+     * @brief Trace width x height pixels, blocking until the image is done
+     *
+     * outPixels receives width * height linear, unexposed RGB values, rows top to bottom.
+     */
+    void Render(const View& view, const Settings& settings, uint32 width, uint32 height,
+                std::vector<glm::vec3>& outPixels);
+
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    // Four children per node; a slot holds an inner node or a leaf's triangles
+    struct Node {
+        simd::Box4 bounds;
+        uint32 children[4];  // Node index, or the leaf's first triangle in m_Triangles
+        uint32 counts[4];    // Triangles of a leaf; 0 = inner node
+        uint32 childMask;    // Bit i set = slot i is used
+    };
+
+    // Intersection data, in leaf order
+    struct Triangle {
+        glm::vec3 v0;
+        glm::vec3 edge1;
+        glm::vec3 edge2;
+        uint32 primitive;  // Of m_Indices / m_TriangleMaterials
+    };
+
+    // World-space vertex attributes
+    struct ShadingVertex {
+        glm::vec3 normal;
+        glm::vec2 texCoord;
+        glm::vec4 tangent;
+    };
+
+    // Texture decoded to RGBA8, sampled bilinearly with wrapping
+    struct Image {
+        std::vector<uint8> texels;
+        uint32 width = 0;
+        uint32 height = 0;
+        bool srgb = false;
+
+        glm::vec4 Sample(const glm::vec2& texCoord) const;
+    };
+
+    static constexpr int32 NO_TEXTURE = -1;
+
+    struct ShadingMaterial {
+        glm::vec3 albedo = glm::vec3(0.8f);
+        float roughness = 0.5f;
+        float metallic = 0.0f;
+        glm::vec3 emissiveFactor = glm::vec3(0.0f);
+        int32 albedoMap = NO_TEXTURE;
+        int32 normalMap = NO_TEXTURE;
+        int32 metallicRoughnessMap = NO_TEXTURE;  // glTF: G = roughness, B = metallic
+        int32 roughnessMap = NO_TEXTURE;          // Without a combined map
+        int32 emissiveMap = NO_TEXTURE;
+    };
+
+    struct Hit {
+        float t = 0.0f;
+        float u = 0.0f;  // Barycentrics of the second and third vertex
+        float v = 0.0f;
+        uint32 primitive = 0;
+    };
+
+    struct Surface;
+    struct BuildContext;
+    struct BuildRange;
+    class Random;
+
+    void DecodeTextures(const ModelData& model, const std::string& modelPath);
+    void BuildBVH();
+    void BuildNode(BuildContext& context, uint32 nodeIndex, const BuildRange& range);
+    static void Split(BuildContext& context, const BuildRange& range, BuildRange& outLeft, BuildRange& outRight);
+
+    bool Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxT, Hit& outHit) const;
+    bool Occluded(const glm::vec3& origin, const glm::vec3& direction, float maxT) const;
+
+    bool LoadSurface(const Hit& hit, const glm::vec3& origin, const glm::vec3& direction, Surface& outSurface) const;
+    glm::vec3 SampleLight(const Surface& surface, const glm::vec3& V, Random& random, uint64& rays) const;
+    glm::vec3 EnvironmentRadiance(const glm::vec3& direction) const;
+    glm::vec3 TracePath(glm::vec3 origin, glm::vec3 direction, uint32 maxBounces, Random& random,
+                        uint64& rays) const;
+
+    std::vector<Node> m_Nodes;
+    std::atomic<uint32> m_NodeCount{0};  // Of m_Nodes, while building
+    std::vector<Triangle> m_Triangles;
+
+    std::vector<glm::vec3> m_Positions;
+    std::vector<ShadingVertex> m_Vertices;
+    std::vector<uint32> m_Indices;            // Three per triangle, into the vertices
+    std::vector<uint32> m_TriangleMaterials;  // Of m_Materials, per triangle
+    std::vector<ShadingMaterial> m_Materials;
+    std::vector<Image> m_Images;
+
+    std::vector<LightData> m_Lights;
+    glm::vec3 m_EnvironmentColor = glm::vec3(0.03f);  // model.frag's ambient, as path_trace.comp's
+    std::vector<float> m_EnvironmentMap;
+    uint32 m_EnvironmentWidth = 0;
+    uint32 m_EnvironmentHeight = 0;
+    float m_EnvironmentIntensity = 1.0f;
+
+    Stats m_Stats;
+};
+
+} // namespace metagfx
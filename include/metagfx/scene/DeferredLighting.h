@@ -0,0 +1,104 @@
+// ============================================================================
+// include/metagfx/scene/DeferredLighting.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Lighting of the deferred path: a tiled compute pass over a compact G-buffer
+ *
+ * The G-buffer is one GBUFFER_FORMAT texel per pixel, written by gbuffer.frag:
+ * - x: albedo and ambient occlusion, 8 bits each
+ * - y: octahedral normal, two 16-bit snorms
+ * - z: emissive red and green, halves
+ * - w: emissive blue (half), metallic and roughness (8 bits each)
+ *
+ * Light() runs one workgroup per TILE_SIZE x TILE_SIZE tile. The group reduces its
+ * depths to a view-space box and tests the frame's point and spot lights against it
+ * (a sphere of the light's range), so each pixel loops over the lights of its tile
+ * instead of the lights of its cluster; directional lights, shadows and IBL shade as
+ * in model.frag, into linear color. Composite() then copies it into the HDR scene color
+ * (see ToneMapper) and the G-buffer's depth into the pass's depth attachment, for the
+ * forward scenery after it.
+ *
+ * Both read the textures of the frame's render graph: SetTargets() rebinds them when
+ * they change, keeping the replaced sets until no frame in flight uses them.
+ */
+class DeferredLighting {
+public:
+    static constexpr rhi::Format GBUFFER_FORMAT = rhi::Format::R32G32B32A32_UINT;
+    static constexpr rhi::Format LIT_COLOR_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;  // Linear, unexposed
+    static constexpr uint32 TILE_SIZE = 16;             // Must match deferred_lighting.comp
+    static constexpr uint32 MAX_LIGHTS_PER_TILE = 256;  // Must match deferred_lighting.comp; the rest are dropped
+
+    // lightingShader runs deferred_lighting.comp, the composite shaders fullscreen.vert
+    // and deferred_composite.frag. sceneBindings are the main pass's set: the lighting
+    // pass reads its frame constants, lights, shadows and IBL maps at the same binding
+    // numbers. sceneColorFormat is the composite's target.
+    DeferredLighting(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> lightingShader,
+                     Ref<rhi::Shader> compositeVertexShader, Ref<rhi::Shader> compositeFragmentShader,
+                     const std::vector<rhi::DescriptorBindingDesc>& sceneBindings, rhi::Format sceneColorFormat);
+    ~DeferredLighting() = default;
+
+    DeferredLighting(const DeferredLighting&) = delete;
+    DeferredLighting& operator=(const DeferredLighting&) = delete;
+
+    bool IsValid() const { return m_LightingPipeline && m_CompositePipeline; }
+
+    // The frame's G-buffer, its depth and the lit color Light() writes, all of one size,
+    // and the screen-space occlusion of the ambient light and reflections if there are
+    // any (AmbientOcclusion, ScreenSpaceReflections, of the same size); call before Light()
+    void SetTargets(Ref<rhi::Texture> gbuffer, Ref<rhi::Texture> depth, Ref<rhi::Texture> litColor,
+                    Ref<rhi::Texture> ambientOcclusion = nullptr, Ref<rhi::Texture> reflections = nullptr);
+
+    // Replace a texture or buffer of the scene bindings, as the main pass's set did (the
+    // IBL maps of a new environment)
+    void SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer);
+
+    /**
+     * @brief Record the lighting dispatch (outside any render pass)
+     *
+     * Reads the G-buffer and depth and writes the lit color as storage; the caller orders
+     * them against the G-buffer pass and the composite (see RenderGraph).
+     * @param frameUniformOffset Binding 0 of the scene bindings: the frame constants
+     * @param width, height Of the G-buffer drawn, its top-left region (dynamic
+     *        resolution); 0 lights all of it
+     */
+    void Light(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset,
+               uint32 width = 0, uint32 height = 0);
+
+    // Inside a render pass over the scene color and a depth attachment: one triangle
+    // over the viewport. Pixels the G-buffer pass left empty are not written.
+    void Composite(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+private:
+    void CreateDescriptorSets();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_LightingPipeline;
+    Ref<rhi::Pipeline> m_CompositePipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    std::vector<rhi::DescriptorBindingDesc> m_LightingBindings;  // Scene bindings, then the targets
+    Ref<rhi::DescriptorSet> m_LightingDescriptorSet;
+    Ref<rhi::DescriptorSet> m_CompositeDescriptorSet;
+
+    Ref<rhi::Texture> m_GBuffer;
+    Ref<rhi::Texture> m_Depth;
+    Ref<rhi::Texture> m_LitColor;
+    Ref<rhi::Texture> m_AmbientOcclusion;
+    Ref<rhi::Texture> m_Reflections;
+};
+
+} // namespace metagfx
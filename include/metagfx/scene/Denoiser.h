@@ -0,0 +1,106 @@
+// ============================================================================
+// include/metagfx/scene/Denoiser.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include <glm/glm.hpp>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Spatiotemporal denoiser of the path tracer's low-sample image (SVGF)
+ *
+ * Apply() filters the accumulation of PathTracer with its guides, after Schied et al.,
+ * "Spatiotemporal Variance-Guided Filtering", in passes of denoise.comp:
+ * - Temporal: the image, divided by the first hits' base color so textures stay sharp,
+ *   blends into its history reprojected through the guide's depth: the camera's motion
+ *   from the last frame's view-projection, where the last frame's guide agrees on depth
+ *   and normal. The history also keeps the luminance's first two moments, whose variance
+ *   tells the filter how noisy each pixel is (a 3x3 estimate while the history is short).
+ * - Spatial: iterations of an a-trous wavelet filter (a 5x5 B3-spline kernel with holes
+ *   doubling each time), its taps weighed down across depth, normal and, scaled by the
+ *   variance, luminance edges. The first iteration's result is the next frame's history;
+ *   the last multiplies the base color back and writes the output.
+ *
+ * A camera in motion resets the tracer to one sample per pixel every frame, which the
+ * history makes up for; once the view rests the accumulation converges on its own, and
+ * the output fades to it by fadeSamples samples per pixel, past which Apply() copies it.
+ * The scene's own motion resets the tracer and, through ResetHistory(), this history.
+ *
+ * The histories and intermediate textures are owned here, sized for the accumulation.
+ */
+class Denoiser {
+public:
+    static constexpr rhi::Format HISTORY_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;
+
+    struct Settings {
+        uint32 iterations = 4;        // Of the spatial filter, 1 to MAX_ITERATIONS
+        uint32 maxHistory = 16;       // Frames the temporal blend averages at most
+        uint32 fadeSamples = 64;      // Samples per pixel the output fades out by
+        float luminanceSigma = 4.0f;  // Of the luminance weights, in standard deviations
+        float normalPower = 128.0f;   // Of the normal weights' cosine
+        float depthSigma = 1.0f;      // Of the depth weights, in depth gradients
+    };
+    static constexpr uint32 MAX_ITERATIONS = 5;
+
+    // shader runs denoise.comp
+    Denoiser(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~Denoiser() = default;
+
+    Denoiser(const Denoiser&) = delete;
+    Denoiser& operator=(const Denoiser&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // The next Apply() starts from the current frame alone: after the scene changed
+    void ResetHistory() { m_HistoryValid = false; }
+
+    // The frame's textures; call before Apply(). image, guide and albedo are
+    // PathTracer::GetAccumulation(), GetGuide() and GetAlbedo(); output a storage texture
+    // of ToneMapper::SCENE_COLOR_FORMAT at least as large.
+    void SetSources(Ref<rhi::Texture> image, Ref<rhi::Texture> guide, Ref<rhi::Texture> albedo,
+                    Ref<rhi::Texture> output);
+
+    /**
+     * @brief Record the denoising dispatches (outside any render pass)
+     *
+     * Reads the image and guides and writes the output as storage; the caller orders them
+     * against the tracer and the passes after (see RenderGraph).
+     * @param viewProjection The view-projection the guides were traced with
+     *                       (PathTracer::View)
+     * @param sampleCount    PathTracer::GetSampleCount() after the frame's tiles
+     */
+    void Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& viewProjection, uint32 sampleCount);
+
+private:
+    void Resize(uint32 width, uint32 height);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    // Illumination, moments and history length, and guide of the last frame
+    Ref<rhi::Texture> m_History[2];
+    Ref<rhi::Texture> m_Moments[2];
+    Ref<rhi::Texture> m_Guides[2];
+    Ref<rhi::Texture> m_Filter[2];  // The spatial iterations' ping-pong
+    // Set i reads histories 1 - i and writes histories i
+    Ref<rhi::DescriptorSet> m_DescriptorSets[2];
+    Ref<rhi::Texture> m_Sources[4];  // Image, guide, albedo, output
+    uint32 m_Current = 0;            // Histories written by the next Apply()
+    glm::mat4 m_HistoryViewProjection = glm::mat4(1.0f);  // Of the histories read next
+    bool m_HistoryValid = false;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
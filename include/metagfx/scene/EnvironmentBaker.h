@@ -0,0 +1,159 @@
+// ============================================================================
+// include/metagfx/scene/EnvironmentBaker.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/utils/SphericalHarmonics.h"
+#include <memory>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+    class ReadbackPool;
+}
+
+/**
+ * @brief Image-based lighting maps baked on the GPU from an HDR loaded at runtime
+ *
+ * Bake() takes an equirectangular HDR texture with its mip chain (utils::LoadHDRTexture)
+ * and queues the maps the ibl_precompute tool writes: the environment cubemap for the
+ * skybox, its diffuse irradiance as L2 spherical harmonics, its prefiltered specular chain
+ * (one roughness per mip, as the model shaders read it) and, on request, the BRDF LUT.
+ * The irradiance is projected from a coarse grid of the HDR in one dispatch; prefiltered
+ * texels read each sample from the HDR mip covering its solid angle (filtered importance
+ * sampling), so a few hundred samples leave no noise.
+ *
+ * Record() spreads the work over frames: each frame records bands of rows of one face
+ * of one map, up to Settings::samplesPerFrame texel samples, so a bake never stalls a
+ * frame. The RHI has no buffer-to-texture copy, so the maps are written to a storage
+ * buffer as half floats, read back through a ReadbackPool once the GPU has finished,
+ * and uploaded into new textures. TakeMaps() hands them over once; the caller swaps
+ * them in and retires the old ones.
+ */
+class EnvironmentBaker {
+public:
+    struct Settings {
+        uint32 environmentSize = 1024;  // Skybox cubemap
+        uint32 irradianceGridWidth = 128;  // Equirectangular samples projected across, half as many down
+        uint32 prefilteredSize = 512;
+        uint32 prefilteredMips = 6;     // Roughness 0..1 across them; MAX_REFLECTION_LOD + 1 of the model shaders
+        uint32 brdfLutSize = 512;
+        uint32 sampleCount = 256;       // Per texel of the prefiltered and LUT maps
+        uint64 samplesPerFrame = 32ull << 20;  // Texel samples recorded per frame
+    };
+
+    // Maps of a finished bake, read by the IBL shaders
+    struct Maps {
+        Ref<rhi::Texture> environment;  // RGBA16F cubemap
+        utils::IrradianceSH irradianceSH;
+        Ref<rhi::Texture> prefiltered;  // RGBA16F cubemap with Settings::prefilteredMips mips
+        Ref<rhi::Texture> brdfLut;      // RG16F; null unless the bake asked for it
+    };
+
+    // shader runs environment_bake.comp
+    EnvironmentBaker(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~EnvironmentBaker();
+
+    EnvironmentBaker(const EnvironmentBaker&) = delete;
+    EnvironmentBaker& operator=(const EnvironmentBaker&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    // Apply to the next Bake()
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Start baking an equirectangular HDR texture, replacing a bake in progress (whose
+    // maps are then dropped). With brdfLut the LUT is baked too; it does not depend on
+    // the environment, so once is enough. False when the bake could not start.
+    bool Bake(Ref<rhi::Texture> equirect, bool brdfLut);
+
+    // Recording or waiting for the read back
+    bool IsBaking() const { return m_Output != nullptr || m_ReadbackPending; }
+    // Of the texel samples recorded so far, 0..1
+    float GetProgress() const;
+
+    // After GraphicsDevice::BeginFrame(): maps a bake the GPU has finished and creates
+    // its textures
+    void BeginFrame();
+
+    /**
+     * @brief Record this frame's share of the bake (outside any render pass)
+     *
+     * Samples the HDR and writes the bake's storage buffer; the last share also copies
+     * it to a readback buffer. Nothing else reads either, so no caller ordering is needed.
+     */
+    void Record(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+    // The maps of the last finished bake, once; false while there are none
+    bool TakeMaps(Maps& maps);
+
+private:
+    // Push constants of environment_bake.comp
+    struct Constants {
+        uint32 pass = 0;
+        uint32 face = 0;
+        uint32 size = 0;
+        uint32 firstRow = 0;
+        uint32 rowCount = 0;     // Rows of the projection grid in the spherical harmonics pass
+        uint32 sampleCount = 0;
+        uint32 outputOffset = 0;  // In 32-bit words
+        float roughness = 0.0f;
+    };
+
+    struct Step {
+        Constants constants;
+        uint32 groupsX = 1;
+        uint32 groupsY = 1;
+        uint64 samples = 0;  // Texel samples of the dispatch
+    };
+
+    // Where each map lies in the output buffer, in bytes
+    struct Layout {
+        Settings settings;
+        bool brdfLut = false;
+        uint64 irradianceOffset = 0;  // RadianceSH, float vec4s
+        uint64 prefilteredOffset = 0;
+        uint64 brdfLutOffset = 0;
+        uint64 size = 0;
+    };
+
+    // Filled by the readback callback, which may run after a newer Bake() (or after the
+    // baker is gone, on WebGPU): each bake has its own
+    struct Result {
+        Maps maps;
+        bool ready = false;
+    };
+
+    void Release();
+    static void CreateMaps(rhi::GraphicsDevice& device, const Layout& layout, const uint8* data, Maps& maps);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_Sampler;  // Trilinear, repeating across the equirect seam
+    Settings m_Settings;
+
+    // Per bake
+    Layout m_Layout;
+    Ref<rhi::Texture> m_Source;
+    Ref<rhi::Buffer> m_Output;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    std::vector<Step> m_Steps;
+    size_t m_NextStep = 0;
+    uint64 m_TotalSamples = 0;
+    uint64 m_RecordedSamples = 0;
+    std::shared_ptr<Result> m_Result;
+
+    // Created for a read back and released after it, with its staging buffer
+    Scope<rhi::ReadbackPool> m_Readback;
+    bool m_ReadbackPending = false;
+};
+
+} // namespace metagfx
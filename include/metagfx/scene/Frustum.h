@@ -0,0 +1,52 @@
+// ============================================================================
+// include/metagfx/scene/Frustum.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+// Six clip planes of a view-projection matrix, normals pointing inwards and
+// normalized so plane distances are in world units: left, right, bottom, top, near, far.
+//
+// The near plane is the -w <= z one, which also contains the 0 <= z volume, so the test
+// stays conservative for both the OpenGL depth range of glm::perspective and the [0, 1]
+// range of the shadow map's projection. With the camera's reverse-Z (Camera) the two swap
+// roles: z <= w is the near plane and -w <= z bounds nothing its infinite far plane does.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+    // False only when the sphere is entirely outside one plane
+    bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+    // False only when the box is entirely outside one plane
+    bool IntersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+    // True when the box is inside every plane
+    bool ContainsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+};
+
+// Bounding spheres as structure-of-arrays, so a cull loop reads contiguous floats
+// and keeps several spheres per SIMD register (simd::CullSpheres)
+struct BoundingSphereSoA {
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> radius;
+
+    void Clear();
+    void Add(const glm::vec3& center, float sphereRadius);
+    size_t Size() const { return radius.size(); }
+};
+
+// Append the index of every sphere intersecting the frustum to outVisible, in order.
+// Returns the number appended. Spheres and frustum must share a space: pass
+// Frustum::FromMatrix(viewProjection * model) for model-space spheres.
+uint32 CullSpheres(const Frustum& frustum, const BoundingSphereSoA& spheres, std::vector<uint32>& outVisible);
+
+} // namespace metagfx
@@ -0,0 +1,50 @@
+// ============================================================================
+// include/metagfx/scene/GLTFLoader.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/utils/MappedFile.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief Native glTF 2.0 (.gltf / .glb) importer that fills ModelData without Assimp
+ *
+ * Accessors are read straight from the mapped buffers (interleaved or not) into the
+ * mesh vertex storage, and embedded images are views into the mapped GLB, so the only
+ * per-model allocations are the final vertex and index arrays.
+ *
+ * Supports KHR_mesh_quantization, EXT_meshopt_compression and KHR_texture_basisu.
+ * Files needing anything else (Draco, sparse accessors, other required extensions,
+ * skins, morph targets or animations) are rejected, and the caller falls back to Assimp.
+ *
+ * Unlike the Assimp path, node transforms are baked into the vertices (quantized
+ * positions are only meaningful after the node's dequantization transform).
+ */
+class GLTFLoader {
+public:
+    // Changes whenever the output for the same file changes (part of the mesh cache key)
+    static constexpr uint32 VERSION = 1;
+
+    static bool IsGLTFFile(const std::string& filepath);
+
+    // Import the default scene. The returned data may point into this loader, which
+    // must outlive it (or until Close()). Returns false, logging why, when the file is
+    // malformed or uses unsupported features; outData is then left empty.
+    bool Load(const std::string& filepath, ModelData& outData, const std::atomic<bool>* cancelled = nullptr);
+
+    // Release the mapped files and decoded buffers
+    void Close();
+
+private:
+    utils::MappedFile m_File;
+    std::vector<utils::MappedFile> m_ExternalBuffers;
+    std::vector<std::vector<uint8>> m_OwnedData;  // Data URIs and meshopt-decoded buffer views
+};
+
+} // namespace metagfx
@@ -0,0 +1,223 @@
+// ============================================================================
+// include/metagfx/scene/GPUCuller.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/UniformRingBuffer.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+class Model;
+
+/**
+ * @brief Compute culling of a pooled model's meshes for the camera and the shadow light
+ *
+ * The culled unit is a draw record: a meshlet of a mesh that has them (Mesh::GetMeshlets)
+ * on a device with multi-draw indirect, the whole mesh otherwise. One dispatch tests
+ * every record's bounding sphere against the camera and light frusta and, for the
+ * camera, its normal cone against the eye and the sphere against a hierarchical-Z
+ * pyramid of the previous frame's depth. It writes indirect draw arguments that the
+ * passes consume with no CPU readback:
+ * - Camera: one command per record, in mesh order, with instanceCount 0 when culled, so
+ *   the main pass keeps binding materials per mesh and draws each mesh's records with a
+ *   DrawIndexedIndirect of GetMeshDrawCount(i) commands at GetCameraDrawOffset(i)
+ * - Shadow: compacted to the visible records plus a count, drawn with a single
+ *   DrawIndexedIndirectCount (in record order like the camera when the device has no
+ *   indirect count, since then every command is drawn). The cone is not tested: the
+ *   back faces cast shadows too.
+ *
+ * The pyramid is a chain of max-depth levels in one storage buffer; the occlusion test
+ * projects a sphere with the camera of the frame the pyramid was built from and
+ * compares its nearest depth to the level where it covers at most 2x2 texels. Objects
+ * uncovered by camera motion can therefore stay culled for a single frame. A chain of
+ * min-depth levels follows it in the same buffer (GetMinDepthOffset()), built by the
+ * same dispatches, for the hierarchical-Z trace of ScreenSpaceReflections: a frame that
+ * reflects builds the pyramid right after its depth, and the next frame's test reads
+ * that one build.
+ *
+ * Meshlets are drawn as index ranges of the pool, so no mesh shader is needed.
+ *
+ * A mesh with coarser levels of detail (Mesh::GetLodCount) also has one whole-mesh record
+ * per coarser level. Cull() takes each mesh's camera and shadow level for the frame
+ * (LodSelector), and only the records of the selected level draw. With multi-draw the
+ * other levels' commands draw no instance; without it all levels of a mesh share its one
+ * command, which only the selected level's record writes.
+ *
+ * The camera commands are written twice: the copy after them (GetVisibilityDrawOffset)
+ * passes the record's index as firstInstance instead of its node, for the visibility
+ * buffer's pass (VisibilityBuffer), which reads the node and the record's triangles back
+ * through it. Every record's triangles are numbered in clusters of CLUSTER_TRIANGLES, so
+ * one 32-bit id names any triangle of the model: GetClusterRecordBuffer() maps a cluster
+ * back to its record.
+ */
+class GPUCuller {
+public:
+    // std430 draw record in the cull shader (64 bytes)
+    struct MeshCullData {
+        glm::vec4 sphere;  // Model-space center, radius
+        glm::vec4 cone;    // Model-space axis, cutoff (Meshlet; 1 never rejects)
+        uint32 indexCount;
+        uint32 firstIndex;
+        int32 vertexOffset;
+        uint32 firstInstance;  // Node of the mesh (Model::GetMeshNode)
+        uint32 mesh;           // Index of the mesh in its model
+        uint32 lod;            // Level of detail the record draws at
+        uint32 drawSlot;       // Command the record writes
+        uint32 firstCluster;   // Of the record's triangles, CLUSTER_TRIANGLES each
+    };
+
+    static constexpr uint32 MAX_PYRAMID_LEVELS = 16;  // Must match cull.comp
+    static constexpr uint32 CLUSTER_TRIANGLES = 128;  // Must match visibility.frag and visibility_resolve.comp
+
+    // cullShader runs cull.comp, pyramidShader depth_pyramid.comp. Cull uniforms are
+    // pushed to the ring, which must outlive the culler.
+    GPUCuller(Ref<rhi::GraphicsDevice> device, rhi::UniformRingBuffer& uniforms,
+              Ref<rhi::Shader> cullShader, Ref<rhi::Shader> pyramidShader);
+    ~GPUCuller();
+
+    GPUCuller(const GPUCuller&) = delete;
+    GPUCuller& operator=(const GPUCuller&) = delete;
+
+    bool IsValid() const { return m_CullPipeline != nullptr && m_PyramidPipeline != nullptr; }
+
+    // Upload the draw records of a pooled model (one indirect draw covers it); returns
+    // false and culls nothing for other models
+    bool SetModel(const Model* model);
+    bool HasModel() const { return m_MeshCount > 0; }
+    uint32 GetMeshCount() const { return m_MeshCount; }
+    uint32 GetDrawCount() const { return m_DrawCount; }  // Commands of each draw buffer
+
+    // Size of the depth buffer the pyramid is built from; reallocates the pyramid when
+    // it changes, so call before the frame's Cull() records
+    void SetDepthSize(uint32 width, uint32 height);
+    // Depth texture of that size to build the pyramid from. May change every frame (a
+    // render graph's transient texture) and only rebinds then; call before
+    // BuildDepthPyramid().
+    void SetDepthSource(Ref<rhi::Texture> depthTexture);
+
+    /**
+     * @brief Record the culling dispatch (outside any render pass)
+     *
+     * Writes the draw buffers as storage and reads the depth pyramid. The caller orders
+     * them against the draws and the pyramid build (see RenderGraph).
+     * @param modelMatrix Model matrix of the float vertices (without dequantization)
+     * @param cameraViewProjection Camera projection * view, in the Vulkan convention of
+     *        Camera::GetProjectionMatrix() (the pyramid is addressed through it)
+     * @param cameraPosition World-space eye the normal cones are tested against
+     * @param lightViewProjection Light-space matrix of the shadow map
+     * @param occlusion Test against the pyramid (ignored until one has been built)
+     * @param cameraLods, shadowLods Level of detail of each mesh for the camera and the
+     *        shadow casters; null draws the full meshes
+     */
+    void Cull(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& modelMatrix,
+              const glm::mat4& cameraViewProjection, const glm::vec3& cameraPosition,
+              const glm::mat4& lightViewProjection, bool occlusion,
+              const uint8* cameraLods = nullptr, const uint8* shadowLods = nullptr);
+
+    /**
+     * @brief Rebuild the pyramid from this frame's depth, for the next frame's test
+     *
+     * Records outside any render pass, after the depth buffer is readable by compute
+     * shaders (on Vulkan, in SHADER_READ_ONLY_OPTIMAL). Writes the pyramid buffer as
+     * storage; the next frame's Cull() reads it.
+     * @param regionWidth, regionHeight Of the depth buffer drawn, its top-left region
+     *        (dynamic resolution); 0 takes all of it
+     */
+    void BuildDepthPyramid(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& cameraViewProjection,
+                           uint32 regionWidth = 0, uint32 regionHeight = 0);
+
+    const Ref<rhi::Buffer>& GetCameraDrawBuffer() const { return m_CameraDraws; }
+    uint64 GetCameraDrawOffset(uint32 meshIndex) const {
+        return static_cast<uint64>(m_MeshFirstDraw[meshIndex]) * sizeof(rhi::DrawIndexedIndirectCommand);
+    }
+    uint32 GetMeshDrawCount(uint32 meshIndex) const {
+        return m_MeshFirstDraw[meshIndex + 1] - m_MeshFirstDraw[meshIndex];
+    }
+    // The same commands with firstInstance = the index of the record drawn, in the camera
+    // draw buffer after the others (needs DeviceInfo::supportsDrawIndirectFirstInstance)
+    uint64 GetVisibilityDrawOffset(uint32 meshIndex) const {
+        return static_cast<uint64>(m_DrawCount + m_MeshFirstDraw[meshIndex]) * sizeof(rhi::DrawIndexedIndirectCommand);
+    }
+    const Ref<rhi::Buffer>& GetRecordBuffer() const { return m_MeshData; }  // MeshCullData per record
+    const Ref<rhi::Buffer>& GetClusterRecordBuffer() const { return m_ClusterRecords; }  // Record per cluster
+    uint32 GetClusterCount() const { return m_ClusterCount; }
+    const Ref<rhi::Buffer>& GetShadowDrawBuffer() const { return m_ShadowDraws; }
+    const Ref<rhi::Buffer>& GetShadowDrawCountBuffer() const { return m_ShadowDrawCount; }
+    const Ref<rhi::Buffer>& GetDepthPyramidBuffer() const { return m_Pyramid; }
+    // In floats: where the min-depth chain starts. Level i of either chain is at the
+    // chain's start plus the sum of the sizes of the levels before it; level 0 halves the
+    // depth buffer (rounding up), each further level halves the previous one down to 1x1.
+    uint32 GetMinDepthOffset() const { return m_MinDepthOffset; }
+    bool IsShadowCompacted() const { return m_CompactShadows; }
+
+private:
+    // std140 layout of CullUniforms in cull.comp
+    // Planes and matrices act on model-space bounds, so the model matrix is folded in
+    struct CullUniforms {
+        glm::mat4 occlusionMatrix;  // Pyramid's camera view-projection * model
+        glm::vec4 cameraPlanes[6];
+        glm::vec4 lightPlanes[6];
+        glm::vec4 cameraPosition;  // xyz = model-space eye
+        uint32 drawCount;
+        uint32 occlusionEnabled;
+        uint32 compactShadows;
+        uint32 pyramidLevelCount;
+        uint32 lodOffset;    // This frame's region of the mesh levels
+        uint32 sharedSlots;  // The levels of a mesh share its command
+        uint32 visibilityDrawBase;  // First command of the visibility copies
+        uint32 padding;
+        glm::vec4 depthSize;                          // xy = depth buffer extent
+        glm::uvec4 pyramidLevels[MAX_PYRAMID_LEVELS];  // x = offset, y = width, z = height
+    };
+
+    struct PyramidLevel {
+        uint32 offset;  // In floats
+        uint32 width;
+        uint32 height;
+    };
+
+    void CreateCullDescriptorSet();
+    void CreatePyramidDescriptorSet();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    rhi::UniformRingBuffer& m_Uniforms;
+    Ref<rhi::Pipeline> m_CullPipeline;
+    Ref<rhi::Pipeline> m_PyramidPipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    bool m_CompactShadows = false;  // Device has DrawIndexedIndirectCount
+    bool m_MeshletDraws = false;    // Device has multi-draw indirect, so a mesh may take many commands
+    uint32 m_FramesInFlight = 1;
+
+    // Per model
+    uint32 m_MeshCount = 0;
+    uint32 m_DrawCount = 0;
+    uint32 m_RecordCount = 0;             // Over the commands by the levels sharing one
+    std::vector<uint32> m_MeshFirstDraw;  // Per mesh, plus the end of the last
+    Ref<rhi::Buffer> m_MeshData;
+    Ref<rhi::Buffer> m_ClusterRecords;
+    uint32 m_ClusterCount = 0;
+    Ref<rhi::Buffer> m_MeshLods;          // Camera | shadow << 8 level of each mesh, a region per frame in flight
+    uint32* m_MappedMeshLods = nullptr;   // nullptr when the backend has no persistent mapping
+    std::vector<uint32> m_MeshLodScratch;
+    Ref<rhi::Buffer> m_CameraDraws;  // Then their visibility copies
+    Ref<rhi::Buffer> m_ShadowDraws;
+    Ref<rhi::Buffer> m_ShadowDrawCount;
+    Ref<rhi::DescriptorSet> m_CullDescriptorSet;
+
+    // Per depth buffer size
+    uint32 m_DepthWidth = 0;
+    uint32 m_DepthHeight = 0;
+    Ref<rhi::Texture> m_DepthTexture;
+    Ref<rhi::Buffer> m_Pyramid;  // Placeholder until a depth size is set
+    Ref<rhi::DescriptorSet> m_PyramidDescriptorSet;
+    std::vector<PyramidLevel> m_PyramidLevels;
+    uint32 m_MinDepthOffset = 0;
+    bool m_PyramidValid = false;  // Built at least once for the current depth size
+    glm::mat4 m_PyramidViewProjection = glm::mat4(1.0f);
+};
+
+} // namespace metagfx
@@ -0,0 +1,74 @@
+// ============================================================================
+// include/metagfx/scene/GeometryPool.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Mesh.h"
+
+namespace metagfx {
+
+namespace rhi {
+    class GraphicsDevice;
+    class Buffer;
+}
+
+/**
+ * @brief Shared vertex, index and position buffers sub-allocated by many meshes
+ *
+ * Sized once for a known set of meshes (a model) and filled front to back; nothing is
+ * freed individually, the buffers go away with the last mesh referencing them. Meshes
+ * in a pool record where their data lives (Mesh::GetFirstIndex, GetVertexOffset), so a
+ * whole model draws with one vertex + index buffer bind, and the ranges are what
+ * indirect draws need.
+ */
+class GeometryPool {
+public:
+    struct Allocation {
+        uint32 firstVertex = 0;
+        uint32 firstIndex = 0;
+    };
+
+    GeometryPool() = default;
+
+    GeometryPool(const GeometryPool&) = delete;
+    GeometryPool& operator=(const GeometryPool&) = delete;
+
+    /**
+     * @brief Create device-local buffers for the given capacity, also usable as storage
+     * @param positionStream Also create a packed position buffer (Mesh::CreatePositionStream)
+     * @param deformable Compute shaders write the vertex and position buffers (Skinning)
+     */
+    bool Initialize(rhi::GraphicsDevice* device, VertexFormat format,
+                    uint32 vertexCapacity, uint32 indexCapacity, bool positionStream, bool deformable = false);
+
+    /**
+     * @brief Reserve space for one mesh; fails when the pool is full
+     */
+    bool Allocate(uint32 vertexCount, uint32 indexCount, Allocation& outAllocation);
+
+    const Ref<rhi::Buffer>& GetVertexBuffer() const { return m_VertexBuffer; }
+    const Ref<rhi::Buffer>& GetIndexBuffer() const { return m_IndexBuffer; }
+    const Ref<rhi::Buffer>& GetPositionBuffer() const { return m_PositionBuffer; }  // Null without a position stream
+    VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+    bool IsDeformable() const { return m_Deformable; }
+
+    uint32 GetVertexCount() const { return m_VertexCount; }
+    uint32 GetIndexCount() const { return m_IndexCount; }
+    uint32 GetVertexCapacity() const { return m_VertexCapacity; }
+    uint32 GetIndexCapacity() const { return m_IndexCapacity; }
+
+private:
+    Ref<rhi::Buffer> m_VertexBuffer;
+    Ref<rhi::Buffer> m_IndexBuffer;
+    Ref<rhi::Buffer> m_PositionBuffer;
+    VertexFormat m_VertexFormat = VertexFormat::Float;
+    bool m_Deformable = false;
+
+    uint32 m_VertexCount = 0;
+    uint32 m_IndexCount = 0;
+    uint32 m_VertexCapacity = 0;
+    uint32 m_IndexCapacity = 0;
+};
+
+} // namespace metagfx
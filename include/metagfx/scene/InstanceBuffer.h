@@ -0,0 +1,86 @@
+// ============================================================================
+// include/metagfx/scene/InstanceBuffer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include <utility>
+#include <vector>
+
+namespace metagfx {
+
+class Scene;
+
+// One instanced draw: instanceCount copies of a mesh, whose nodes are read from
+// InstanceBuffer entries [firstInstance, firstInstance + instanceCount)
+struct DrawBatch {
+    uint32 mesh = 0;           // MeshInstance::userData (the mesh index in its model)
+    uint32 firstInstance = 0;
+    uint32 instanceCount = 1;
+    uint32 lod = 0;            // Level of detail of the mesh (Mesh::GetLodFirstIndex)
+};
+
+/**
+ * @brief Per-instance data of instanced draws: the scene graph node of each instance
+ *
+ * Vertex shaders read the node of an instance from this buffer with gl_InstanceIndex,
+ * then its world matrix from the TransformBuffer. The buffer starts with an identity
+ * table (entry i = node i), so a single draw, direct or indirect, still passes its node
+ * as firstInstance. After it, one region per frame in flight holds the node lists of
+ * that frame's batches, written by BuildBatches().
+ *
+ * Mapped and rewritten every frame like the uniform ring: the caller must have waited
+ * for the GPU to finish the previous use of a frame slot before BeginFrame().
+ */
+class InstanceBuffer {
+public:
+    static constexpr uint32 INVALID_OFFSET = ~0u;
+
+    InstanceBuffer(Ref<rhi::GraphicsDevice> device, uint32 nodeCapacity, uint32 instancesPerFrame,
+                   uint32 framesInFlight = 2);
+    ~InstanceBuffer() = default;
+
+    InstanceBuffer(const InstanceBuffer&) = delete;
+    InstanceBuffer& operator=(const InstanceBuffer&) = delete;
+
+    bool IsValid() const { return m_Buffer != nullptr; }
+    const Ref<rhi::Buffer>& GetBuffer() const { return m_Buffer; }
+
+    // Start writing the region owned by frameIndex
+    void BeginFrame(uint32 frameIndex);
+
+    /**
+     * @brief Group scene instances that draw the same mesh into instanced batches
+     *
+     * A mesh owns its material, so one batch is one (mesh, material) pair, and with lods
+     * (a level per scene instance, LodSelector) one level of it. Batches come out in mesh
+     * order. A mesh drawn once references the identity table; larger groups get their
+     * node list in this frame's region, or one batch per instance when the region is
+     * full. Instances must be attached to a scene graph node.
+     */
+    void BuildBatches(const Scene& scene, const std::vector<uint32>& instances, std::vector<DrawBatch>& outBatches,
+                      const std::vector<uint8>* lods = nullptr);
+
+    // Instances written to the current frame's region
+    uint32 GetInstancesUsed() const { return m_Offset - m_FrameBase; }
+
+private:
+    // Copy a node list into the current frame's region; INVALID_OFFSET when it is full
+    uint32 Push(const uint32* nodes, uint32 count);
+
+    Ref<rhi::Buffer> m_Buffer;
+    uint32* m_MappedData = nullptr;  // nullptr when the backend has no persistent mapping
+    uint32 m_NodeCapacity = 0;
+    uint32 m_InstancesPerFrame = 0;
+    uint32 m_FramesInFlight = 0;
+
+    uint32 m_FrameBase = 0;  // First entry of the current frame's region
+    uint32 m_Offset = 0;     // Next free entry
+    bool m_OverflowReported = false;
+
+    std::vector<std::pair<uint64, uint32>> m_Sorted;  // (mesh << 32 | lod, node) scratch
+    std::vector<uint32> m_Nodes;
+};
+
+} // namespace metagfx
@@ -21,25 +21,19 @@ struct LightData {
     glm::vec4 spotAngles;        // x = inner cone (rad), y = outer cone (rad), z = att constant, w = att linear
 };
 
-// Complete light buffer structure for GPU
-struct LightBuffer {
+// Header of the GPU light buffer; lightCount LightData entries follow it, directional
+// lights first (std430 runtime array at offset 16)
+struct LightBufferHeader {
     uint32 lightCount;           // Number of active lights
-    uint32 padding[3];           // Align to 16 bytes
-    LightData lights[16];        // Maximum 16 lights
+    uint32 directionalCount;     // Lights [0, directionalCount) are directional
+    uint32 padding[2];           // Align to 16 bytes
 };
 
-// Abstract base class for all light types
+// Common part of all light types. Lights are plain values: Scene stores each type in
+// its own array and converts them with the type's ToGPUData(), without virtual calls.
+// Setters mark a light dirty; Scene::UpdateLightBuffer() uploads only dirty lights.
 class Light {
 public:
-    Light(LightType type, const glm::vec3& color, float intensity);
-    virtual ~Light() = default;
-
-    // Non-copyable, movable
-    Light(const Light&) = delete;
-    Light& operator=(const Light&) = delete;
-    Light(Light&&) = default;
-    Light& operator=(Light&&) = default;
-
     // Common properties
     void SetColor(const glm::vec3& color);
     void SetIntensity(float intensity);
@@ -48,13 +42,28 @@ public:
     float GetIntensity() const { return m_Intensity; }
     LightType GetType() const { return m_Type; }
 
-    // Each subclass implements this to fill GPU data
-    virtual LightData ToGPUData() const = 0;
+    // Point and spot lights that cast shadows get tiles in the ShadowAtlas; directional
+    // lights ignore it (the key light has the cascaded shadow map). Not uploaded.
+    void SetCastsShadows(bool castsShadows) { m_CastsShadows = castsShadows; }
+    bool CastsShadows() const { return m_CastsShadows; }
+
+    // Changed since the scene last uploaded it
+    bool IsDirty() const { return m_Dirty; }
 
 protected:
+    Light(LightType type, const glm::vec3& color, float intensity);
+
+    void MarkDirty() { m_Dirty = true; }
+
     LightType m_Type;
     glm::vec3 m_Color;
     float m_Intensity;
+
+private:
+    friend class Scene;  // Clears the flag once uploaded
+
+    bool m_Dirty = true;
+    bool m_CastsShadows = false;
 };
 
 // Directional Light (parallel rays, like sun/moon)
@@ -67,7 +76,7 @@ public:
     void SetDirection(const glm::vec3& direction);
     const glm::vec3& GetDirection() const { return m_Direction; }
 
-    LightData ToGPUData() const override;
+    LightData ToGPUData() const;
 
 private:
     glm::vec3 m_Direction;
@@ -88,7 +97,7 @@ public:
     const glm::vec3& GetPosition() const { return m_Position; }
     float GetRange() const { return m_Range; }
 
-    LightData ToGPUData() const override;
+    LightData ToGPUData() const;
 
 private:
     glm::vec3 m_Position;
@@ -118,8 +127,9 @@ public:
     const glm::vec3& GetDirection() const { return m_Direction; }
     float GetInnerConeAngle() const { return glm::degrees(m_InnerConeAngle); }
     float GetOuterConeAngle() const { return glm::degrees(m_OuterConeAngle); }
+    float GetRange() const { return m_Range; }
 
-    LightData ToGPUData() const override;
+    LightData ToGPUData() const;
 
 private:
     glm::vec3 m_Position;
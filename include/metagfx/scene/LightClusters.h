@@ -0,0 +1,108 @@
+// ============================================================================
+// include/metagfx/scene/LightClusters.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/scene/Light.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+class Camera;
+
+// Where the fragment shader finds a frame's clusters; copied into the frame constants
+struct LightClusterParams {
+    uint32 base = 0;                              // First entry of the frame's region
+    glm::vec2 tileScale = glm::vec2(0.0f);        // Clusters per pixel in x and y
+    glm::vec2 depthScaleBias = glm::vec2(0.0f);   // Slice = log(view depth) * x + y
+};
+
+/**
+ * @brief Clustered forward lighting: the point and spot lights of each view froxel
+ *
+ * The view frustum is cut into GRID_X x GRID_Y screen tiles and GRID_Z depth slices,
+ * spaced exponentially from the camera's near to its far plane. Build() bins the local
+ * lights of the uploaded light array (LightData range and cone) into the froxels they
+ * can reach. The fragment shader finds its froxel from gl_FragCoord and its view depth,
+ * and shades only the lights listed there.
+ *
+ * Binning runs on the CPU, light by light. Froxel bounds are view-space boxes,
+ * recomputed only when the projection changes. A light is tested against the froxels
+ * under its screen rectangle and within its depth range: a sphere-box test, plus a cone
+ * test for spot lights.
+ *
+ * The buffer is mapped and rewritten every frame like InstanceBuffer. It holds one
+ * region per frame in flight, with entries in uints: a (first, count) pair per froxel,
+ * then the light indices the pairs point at. First is an absolute entry index.
+ */
+class LightClusters {
+public:
+    // Must match model.frag and model_bindless.frag
+    static constexpr uint32 GRID_X = 16;
+    static constexpr uint32 GRID_Y = 9;
+    static constexpr uint32 GRID_Z = 24;
+    static constexpr uint32 CLUSTER_COUNT = GRID_X * GRID_Y * GRID_Z;
+
+    LightClusters(Ref<rhi::GraphicsDevice> device, uint32 indicesPerFrame, uint32 framesInFlight = 2);
+    ~LightClusters() = default;
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+    bool IsValid() const { return m_Buffer != nullptr; }
+    const Ref<rhi::Buffer>& GetBuffer() const { return m_Buffer; }
+
+    /**
+     * @brief Bin lights[firstLocal..] into frameIndex's region for a camera and viewport
+     *
+     * The caller must have waited for the GPU to finish the previous use of the frame
+     * slot. Lights past the region's index capacity are dropped (logged once).
+     */
+    LightClusterParams Build(uint32 frameIndex, const std::vector<LightData>& lights, uint32 firstLocal,
+                             const Camera& camera, uint32 width, uint32 height);
+
+    // Of the last Build()
+    uint32 GetVisibleLightCount() const { return m_VisibleLights; }  // Local lights in at least one froxel
+    uint32 GetIndexCount() const { return m_IndexCount; }
+    uint32 GetMaxLightsPerCluster() const { return m_MaxLightsPerCluster; }
+
+private:
+    struct ClusterBounds {
+        glm::vec3 min;
+        glm::vec3 max;
+    };
+
+    void UpdateClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane);
+    uint32 GetSlice(float depth) const;
+
+    Ref<rhi::Buffer> m_Buffer;
+    uint32* m_MappedData = nullptr;  // nullptr when the backend has no persistent mapping
+    uint32 m_IndicesPerFrame = 0;
+    uint32 m_FramesInFlight = 0;
+
+    // View-space froxel boxes of the projection they were computed for, and their
+    // structure-of-arrays copy (runs of CLUSTER_COUNT minX, minY, minZ, maxX, maxY, maxZ)
+    // for the batched sphere test
+    std::vector<ClusterBounds> m_ClusterBounds;
+    std::vector<float> m_ClusterBoxes;
+    std::vector<uint32> m_RowHits;  // Build() scratch
+    glm::mat4 m_BoundsProjection = glm::mat4(0.0f);
+    float m_NearPlane = 0.0f;
+    float m_FarPlane = 0.0f;
+    float m_SliceScale = 0.0f;
+    float m_SliceBias = 0.0f;
+
+    std::vector<uint32> m_PairClusters;  // (cluster, light) pairs in light order
+    std::vector<uint32> m_PairLights;
+    std::vector<uint32> m_Counts;
+    std::vector<uint32> m_Region;        // Staging when the buffer is not mapped
+
+    uint32 m_VisibleLights = 0;
+    uint32 m_IndexCount = 0;
+    uint32 m_MaxLightsPerCluster = 0;
+};
+
+} // namespace metagfx
@@ -0,0 +1,186 @@
+// ============================================================================
+// include/metagfx/scene/LightProbeVolume.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/utils/SphericalHarmonics.h"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class GeometryPool;
+class Material;
+class Scene;
+
+/**
+ * @brief Grid of irradiance probes over the scene, ray traced a few at a time
+ *
+ * The probes sit on a regular grid over the scene's bounds, each holding the irradiance
+ * around it as L2 spherical harmonics in the convention of the environment's
+ * (utils::IrradianceSH). The lit passes blend the eight probes around a point by their
+ * distance, their side of the surface and their validity, so rooms the sky cannot see
+ * are lit by what their walls bounce instead of by the environment, which takes over
+ * where no probe counts: outside the grid, or while the volume is off.
+ *
+ * Update() runs probe_update.comp: one workgroup per probe traces RAY_COUNT rays on a
+ * spherical Fibonacci pattern, rotated at random each update, against the scene's top
+ * level (RayTracingScene). Hits shade with the bindless material table like the path
+ * tracer's, lit by one of the frame's lights through a shadow ray and by the volume
+ * itself, so light bounces further with every update; misses see the environment. The
+ * rays project into the probe's coefficients, which blend into the last ones by
+ * hysteresis. A probe whose rays mostly hit back faces is inside geometry and is left
+ * out of the blend.
+ *
+ * The first Update() after a reset traces every probe; later ones trace probesPerFrame
+ * probes in turn, which bounds every frame's cost whatever the grid's size. Moving
+ * geometry and lights are picked up as their probes come round again.
+ *
+ * The probes live in one buffer for the application's life (CreateProbeBuffer()), bound
+ * to the lit sets at PROBE_BINDING: a header (GridHeader) then COEFFICIENTS_PER_PROBE
+ * vec4 per probe, the first's w the probe's validity. A zeroed header turns the volume
+ * off, so the buffer can be bound before any volume exists.
+ *
+ * Needs DeviceInfo::supportsRayQuery and bindless textures, like PathTracer.
+ */
+class LightProbeVolume {
+public:
+    static constexpr uint32 PROBE_BINDING = 29;
+    static constexpr uint32 MAX_PROBES_PER_AXIS = 16;
+    static constexpr uint32 MAX_PROBES = MAX_PROBES_PER_AXIS * MAX_PROBES_PER_AXIS * MAX_PROBES_PER_AXIS;
+    static constexpr uint32 COEFFICIENTS_PER_PROBE = utils::SH_COEFFICIENT_COUNT;
+    static constexpr uint32 RAY_COUNT = 128;   // Per probe and update; must match probe_update.comp
+    static constexpr uint32 GROUP_SIZE = 64;   // Must match probe_update.comp
+
+    // Start of the probe buffer, as the shaders read it
+    struct GridHeader {
+        glm::vec4 origin;   // xyz: position of the first probe; w: 1 while the volume is on
+        glm::vec4 spacing;  // xyz: between neighbouring probes
+        glm::uvec4 counts;  // xyz: probes along each axis
+    };
+    static constexpr uint64 PROBE_BUFFER_SIZE =
+        sizeof(GridHeader) + uint64(MAX_PROBES) * COEFFICIENTS_PER_PROBE * sizeof(glm::vec4);
+
+    struct Settings {
+        uint32 probesPerFrame = 64;     // After the first update
+        uint32 probesPerAxis = 12;      // Along the bounds' longest side, 2 to MAX_PROBES_PER_AXIS
+        float hysteresis = 0.85f;       // Of the last coefficients kept at each update
+    };
+
+    // What lights the probes' rays; not a reset, the probes follow it as they update
+    struct View {
+        bool environment = false;  // The environment lights the scene (IBL)
+        float environmentIntensity = 1.0f;
+    };
+
+    // The buffer of PROBE_BINDING, zeroed (the volume off); null if it cannot be created
+    static Ref<rhi::Buffer> CreateProbeBuffer(rhi::GraphicsDevice& device);
+
+    // shader runs probe_update.comp. sceneBindings are the main pass's set: the volume
+    // reads its frame constants, lights, prefiltered map, top level and probe buffer at the
+    // same binding numbers. textureCapacity is the size of the bindless texture table.
+    LightProbeVolume(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader,
+                     const std::vector<rhi::DescriptorBindingDesc>& sceneBindings, uint32 textureCapacity);
+    ~LightProbeVolume() = default;
+
+    LightProbeVolume(const LightProbeVolume&) = delete;
+    LightProbeVolume& operator=(const LightProbeVolume&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+    // Every input is set: Update() has something to trace
+    bool IsReady() const { return m_DescriptorSet && m_TopLevel && m_ProbeCount > 0; }
+    // Update() records work: probes to trace, or a header that still says the volume is on
+    bool NeedsUpdate() const { return m_Enabled ? IsReady() : m_HeaderOn; }
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Off, the next Update() copies a zeroed header over the buffer's (a transfer, where
+    // it is otherwise written as storage) and the lit passes fall back to the environment's
+    // irradiance; on again, every probe is traced anew. The caller turns the volume off
+    // while it has no scene to trace, so the probes of the last one go dark.
+    void SetEnabled(bool enabled);
+    bool IsEnabled() const { return m_Enabled; }
+
+    // Replace a texture or buffer of the scene bindings, as the main pass's set did
+    void SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer);
+    // RayTracingScene::GetTopLevel() after the frame's Update()
+    void SetTopLevel(Ref<rhi::AccelerationStructure> topLevel);
+
+    // The bindless material table, as PathTracer::SetMaterials(). Resets the probes.
+    void SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                      Ref<rhi::Sampler> sampler);
+    // The scene's mesh instances, as PathTracer::SetGeometry(); the grid covers their
+    // bounds. Resets the probes.
+    void SetGeometry(const Scene& scene, const GeometryPool& pool,
+                     const std::unordered_map<const Material*, uint32>& materialIndices);
+
+    const Ref<rhi::Buffer>& GetProbeBuffer() const { return m_ProbeBuffer; }
+    uint32 GetProbeCount() const { return m_ProbeCount; }
+    const glm::uvec3& GetProbeCounts() const { return m_Counts; }
+
+    // Every probe is traced again at the next Update()
+    void Reset() { m_ResetPending = true; }
+
+    /**
+     * @brief Record the frame's probe updates (outside any render pass)
+     *
+     * Writes the probe buffer as storage, or by transfer while the volume is off; the
+     * caller orders it against the lit passes (see RenderGraph).
+     * @param frameUniformOffset Binding 0 of the scene bindings: the frame constants
+     */
+    void Update(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset, const View& view);
+
+private:
+    // Of the instance buffer, as PathTracer::InstanceData
+    struct InstanceData {
+        uint32 firstIndex;
+        int32 vertexOffset;
+        uint32 materialIndex;  // NO_MATERIAL: the mesh is not in the pool
+        uint32 compact;        // 1 = VertexFormat::Compact
+    };
+    static constexpr uint32 NO_MATERIAL = 0xFFFFFFFFu;
+
+    void SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void CreateDescriptorSet();
+    // Lays the grid over m_BoundsMin/Max with the settings' probes per axis
+    void PlaceProbes();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    std::vector<rhi::DescriptorBindingDesc> m_Bindings;  // Scene bindings, then the volume's own
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    uint32 m_TextureCapacity = 0;
+
+    Ref<rhi::AccelerationStructure> m_TopLevel;
+    Ref<rhi::Buffer> m_ProbeBuffer;
+    Ref<rhi::Buffer> m_OffHeader;  // A zeroed GridHeader
+    std::vector<Ref<rhi::Texture>> m_Textures;  // Of the table; the set's elements past them are cleared
+    uint32 m_WrittenTextures = 0;                // Elements of the set's table written
+    Ref<rhi::Sampler> m_TextureSampler;
+
+    Settings m_Settings;
+    glm::vec3 m_BoundsMin = glm::vec3(0.0f);
+    glm::vec3 m_BoundsMax = glm::vec3(0.0f);
+    glm::vec3 m_Origin = glm::vec3(0.0f);
+    float m_Spacing = 1.0f;
+    glm::uvec3 m_Counts = glm::uvec3(0);
+    uint32 m_ProbeCount = 0;
+    bool m_Enabled = true;
+    bool m_HeaderOn = false;  // As the buffer's header was last written
+    bool m_ResetPending = true;
+    uint32 m_NextProbe = 0;
+    uint32 m_UpdateIndex = 0;  // Rotates the rays
+};
+
+} // namespace metagfx
@@ -0,0 +1,65 @@
+// ============================================================================
+// include/metagfx/scene/LodSelector.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+class Scene;
+
+/**
+ * @brief Level of detail of every mesh instance, from its projected size on screen
+ *
+ * Update() projects each level's error (MeshLod::error, scaled by the instance's
+ * transform) to pixels at the nearest point of the instance's bounding sphere, and picks
+ * the coarsest level whose error stays within the threshold. A level coarser than the
+ * instance's current one must stay further under it, by the hysteresis fraction, so an
+ * instance at the boundary does not switch back and forth as the camera moves. Shadow
+ * casters take a level shadowBias steps coarser: the shadow map's texels are larger than
+ * the error, and its filtering hides the rest.
+ *
+ * The levels are indexed like the scene's mesh instances and kept between frames;
+ * instances with no coarser level stay at 0.
+ */
+class LodSelector {
+public:
+    struct Settings {
+        float pixelThreshold = 1.0f;  // Largest projected error of the level drawn
+        float hysteresis = 0.25f;     // Fraction further under the threshold a coarser level needs
+        uint32 shadowBias = 1;        // Levels coarser for the shadow casters
+    };
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    /**
+     * @brief Pick the levels of every instance for this frame's camera
+     * @param modelMatrix    Applied on top of the instances' transforms
+     * @param projection     Camera projection; a perspective one divides by the distance
+     * @param eye            World-space camera position
+     * @param viewportHeight Pixels the projection spans vertically
+     */
+    void Update(const Scene& scene, const glm::mat4& modelMatrix, const glm::mat4& projection,
+                const glm::vec3& eye, float viewportHeight);
+
+    // Back to the full meshes and no history, e.g. for a new scene
+    void Reset();
+
+    // Per scene mesh instance, as of the last Update()
+    const std::vector<uint8>& GetCameraLods() const { return m_CameraLods; }
+    const std::vector<uint8>& GetShadowLods() const { return m_ShadowLods; }
+    // Some instance draws a coarser level than its full mesh, for the camera or a shadow
+    bool HasCoarserLods() const { return m_HasCoarserLods; }
+
+private:
+    Settings m_Settings;
+    std::vector<uint8> m_CameraLods;
+    std::vector<uint8> m_ShadowLods;
+    bool m_HasCoarserLods = false;
+};
+
+} // namespace metagfx
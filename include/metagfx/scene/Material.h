@@ -22,7 +22,16 @@ enum class MaterialTextureFlags : uint32 {
     HasRoughnessMap = 1 << 3,           // Bit 3: Roughness texture (grayscale)
     HasMetallicRoughnessMap = 1 << 4,   // Bit 4: Combined metallic-roughness (glTF: G=roughness, B=metallic)
     HasAOMap = 1 << 5,                  // Bit 5: Ambient occlusion map (grayscale)
-    HasEmissiveMap = 1 << 6             // Bit 6: Emissive texture (RGB)
+    HasEmissiveMap = 1 << 6,            // Bit 6: Emissive texture (RGB)
+    AlphaMask = 1 << 7,                 // Bit 7: Discard below the alpha cutoff (glTF MASK)
+    AlphaBlend = 1 << 8                 // Bit 8: Blended over what is behind (glTF BLEND)
+};
+
+// How a material's alpha covers what is behind it (glTF alphaMode)
+enum class AlphaMode : uint32 {
+    Opaque,  // Alpha is ignored
+    Mask,    // Fully opaque at or above the cutoff, absent below it
+    Blend    // Drawn after the opaque surfaces, blended over them
 };
 
 // GPU-side structure (std140 layout compatible)
@@ -31,9 +40,11 @@ struct MaterialProperties {
     glm::vec3 albedo;      // 12 bytes (offset 0)  - Base color
     float roughness;       // 4 bytes  (offset 12) - Surface roughness [0,1]
     float metallic;        // 4 bytes  (offset 16) - Metallic property [0,1]
-    float padding1[2];     // 8 bytes  (offset 20) - Padding for alignment
-    glm::vec3 emissiveFactor; // 12 bytes (offset 28) - Emissive color multiplier
-    float padding2;        // 4 bytes  (offset 40) - Padding to 48 bytes
+    float alpha = 1.0f;    // 4 bytes  (offset 20) - Base color alpha [0,1]
+    float alphaCutoff = 0.5f;  // 4 bytes (offset 24) - Mask threshold
+    float padding1;        // 4 bytes  (offset 28) - Padding to the vec3's 16-byte alignment
+    glm::vec3 emissiveFactor; // 12 bytes (offset 32) - Emissive color multiplier
+    float padding2;        // 4 bytes  (offset 44) - Padding to 48 bytes
 };
 
 class Material {
@@ -48,6 +59,10 @@ public:
     void SetRoughness(float roughness);
     void SetMetallic(float metallic);
     void SetEmissiveFactor(const glm::vec3& emissive);
+    // Alpha of the base color, multiplied by the albedo map's
+    void SetAlpha(float alpha);
+    void SetAlphaMode(AlphaMode mode);
+    void SetAlphaCutoff(float cutoff);
 
     // Getters
     const MaterialProperties& GetProperties() const { return m_Properties; }
@@ -55,34 +70,38 @@ public:
     float GetRoughness() const { return m_Properties.roughness; }
     float GetMetallic() const { return m_Properties.metallic; }
     const glm::vec3& GetEmissiveFactor() const { return m_Properties.emissiveFactor; }
+    float GetAlpha() const { return m_Properties.alpha; }
+    AlphaMode GetAlphaMode() const { return m_AlphaMode; }
+    float GetAlphaCutoff() const { return m_Properties.alphaCutoff; }
+    bool IsBlended() const { return m_AlphaMode == AlphaMode::Blend; }
 
     // Texture management
     void SetAlbedoMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetAlbedoMap() const { return m_AlbedoMap; }
+    const Ref<rhi::Texture>& GetAlbedoMap() const { return m_AlbedoMap; }
     bool HasAlbedoMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasAlbedoMap)) != 0; }
 
     void SetNormalMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetNormalMap() const { return m_NormalMap; }
+    const Ref<rhi::Texture>& GetNormalMap() const { return m_NormalMap; }
     bool HasNormalMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasNormalMap)) != 0; }
 
     void SetMetallicMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetMetallicMap() const { return m_MetallicMap; }
+    const Ref<rhi::Texture>& GetMetallicMap() const { return m_MetallicMap; }
     bool HasMetallicMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasMetallicMap)) != 0; }
 
     void SetRoughnessMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetRoughnessMap() const { return m_RoughnessMap; }
+    const Ref<rhi::Texture>& GetRoughnessMap() const { return m_RoughnessMap; }
     bool HasRoughnessMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasRoughnessMap)) != 0; }
 
     void SetMetallicRoughnessMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetMetallicRoughnessMap() const { return m_MetallicRoughnessMap; }
+    const Ref<rhi::Texture>& GetMetallicRoughnessMap() const { return m_MetallicRoughnessMap; }
     bool HasMetallicRoughnessMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasMetallicRoughnessMap)) != 0; }
 
     void SetAOMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetAOMap() const { return m_AOMap; }
+    const Ref<rhi::Texture>& GetAOMap() const { return m_AOMap; }
     bool HasAOMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasAOMap)) != 0; }
 
     void SetEmissiveMap(Ref<rhi::Texture> texture);
-    Ref<rhi::Texture> GetEmissiveMap() const { return m_EmissiveMap; }
+    const Ref<rhi::Texture>& GetEmissiveMap() const { return m_EmissiveMap; }
     bool HasEmissiveMap() const { return (m_TextureFlags & static_cast<uint32>(MaterialTextureFlags::HasEmissiveMap)) != 0; }
 
     uint32 GetTextureFlags() const { return m_TextureFlags; }
@@ -100,6 +119,7 @@ private:
     Ref<rhi::Texture> m_EmissiveMap;
 
     uint32 m_TextureFlags = 0;
+    AlphaMode m_AlphaMode = AlphaMode::Opaque;
 };
 
 } // namespace metagfx
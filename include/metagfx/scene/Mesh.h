@@ -19,14 +19,37 @@ namespace rhi {
 }
 
 class Material;
+class GeometryPool;
 
 /**
- * @brief Vertex structure containing position, normal, and texture coordinates
+ * @brief Layout of a mesh's GPU vertex buffer
+ */
+enum class VertexFormat {
+    Float,    // Vertex: 48 bytes of full-float position, normal, UV and tangent
+    Compact   // CompactVertex: 20 bytes, quantized (see VertexQuantization)
+};
+
+/**
+ * @brief What a mesh keeps of its geometry in RAM once uploaded
+ */
+enum class MeshCPUData {
+    Full,        // The Vertex and index arrays (Mesh::GetVertices(), GetIndices())
+    Compressed,  // Positions as 16-bit unorm within the mesh bounds, indices in 16 bits
+                 // when they fit: 6 bytes per vertex instead of 48, enough for picking
+    None         // Only the GPU buffers and the bounds
+};
+
+/**
+ * @brief Vertex structure containing position, normal, texture coordinates and tangent
+ *
+ * The tangent points along +U in xyz; w is the handedness (+1 or -1), so the bitangent
+ * is cross(normal, tangent.xyz) * w. Loaders fill it from the source or ComputeTangents().
  */
 struct Vertex {
     glm::vec3 position;
     glm::vec3 normal;
     glm::vec2 texCoord;
+    glm::vec4 tangent = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 
     Vertex() = default;
     Vertex(const glm::vec3& pos, const glm::vec3& norm, const glm::vec2& uv)
@@ -35,10 +58,105 @@ struct Vertex {
     bool operator==(const Vertex& other) const {
         return position == other.position && 
                normal == other.normal && 
-               texCoord == other.texCoord;
+               texCoord == other.texCoord &&
+               tangent == other.tangent;
     }
 };
 
+/**
+ * @brief Quantized vertex for VertexFormat::Compact
+ *
+ * Position is 16-bit unorm inside the quantization cube (the fourth component pads
+ * the attribute to 8 bytes), the normal is octahedral-encoded 16-bit snorm and the
+ * UV is half-float and the tangent 8-bit snorm with the handedness in w. The vertex
+ * shader reads all but the UV through normalized formats, so only the octahedral normal
+ * needs decoding.
+ */
+struct CompactVertex {
+    uint16 position[4];  // R16G16B16A16_UNORM
+    int16 normal[2];     // R16G16_SNORM, octahedral
+    uint16 texCoord[2];  // R16G16_SFLOAT
+    int8 tangent[4];     // R8G8B8A8_SNORM, w = handedness
+};
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex must stay 20 bytes");
+
+/**
+ * @brief Cube the compact positions are quantized to
+ *
+ * Shared by every mesh of a model so a single dequantization matrix, folded into the
+ * model matrix, serves the whole draw. The scale is uniform (the largest extent of the
+ * bounds), which keeps the normal matrix derived from the combined matrix correct.
+ */
+struct VertexQuantization {
+    glm::vec3 offset = glm::vec3(0.0f);  // Cube minimum
+    float scale = 1.0f;                  // Cube edge length (never zero)
+
+    // Cube covering [boundsMin, boundsMax]
+    static VertexQuantization FromBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax);
+
+    // Maps unorm positions in [0, 1] back to model space
+    glm::mat4 GetDequantizeMatrix() const;
+};
+
+// Bytes per vertex of a format
+uint32 GetVertexStride(VertexFormat format);
+
+// Vertex input for pipelines drawing meshes of a format: position at location 0,
+// normal at 1, texcoord at 2, tangent at 3. Position-only passes keep the first attribute.
+rhi::VertexInputLayout GetVertexInputLayout(VertexFormat format, bool positionOnly = false);
+
+// Vertex input for depth-only pipelines reading Mesh::GetPositionBuffer() of a
+// format: tightly packed positions at location 0 (12 bytes Float, 8 bytes Compact)
+rhi::VertexInputLayout GetPositionInputLayout(VertexFormat format);
+
+// Per-vertex tangents from the UV gradients of the indexed triangles, orthogonalized
+// against the normals. Vertices whose triangles have degenerate UVs get an arbitrary
+// tangent perpendicular to the normal.
+void ComputeTangents(Vertex* vertices, uint32 vertexCount, const uint32* indices, uint32 indexCount);
+
+// Quantize full-float vertices into the compact layout
+void EncodeCompactVertices(const Vertex* vertices, uint32 count, const VertexQuantization& quantization,
+                           CompactVertex* outVertices);
+
+/**
+ * @brief Run of a mesh's triangles small enough for one mesh shader work group
+ *
+ * Meshlets are consecutive ranges of the index buffer (BuildMeshlets() orders the
+ * triangles so), so each one also draws as an indexed draw of its range. The bounds cull it like a
+ * mesh; the normal cone rejects it when every triangle faces away from the viewer:
+ * dot(center - eye, coneAxis) >= coneCutoff * length(center - eye) + radius.
+ */
+struct Meshlet {
+    static constexpr uint32 MAX_VERTICES = 64;
+    static constexpr uint32 MAX_TRIANGLES = 124;
+
+    glm::vec3 center = glm::vec3(0.0f);  // Bounding sphere, in the mesh's space
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);  // Mean facing of the triangles
+    float coneCutoff = 1.0f;             // Sine of the cone's spread; 1 never rejects
+    uint32 firstIndex = 0;               // Relative to the mesh's indices
+    uint32 indexCount = 0;
+    uint32 vertexCount = 0;              // Distinct vertices, at most MAX_VERTICES
+    uint32 padding = 0;
+};
+static_assert(sizeof(Meshlet) == 48, "Meshlet is stored as is in the mesh cache");
+
+/**
+ * @brief Coarser level of detail of a mesh: a range of indices over the same vertices
+ *
+ * Levels come from SimplifyMesh() at import and share the mesh's vertices, so only
+ * their indices take memory. The index data of all levels follows the mesh's own
+ * indices. error is how far the level's surface strays from the full mesh, in the
+ * mesh's units; LOD selection projects it to pixels.
+ */
+struct MeshLod {
+    static constexpr uint32 MAX_LEVELS = 4;  // Beyond the full mesh
+
+    uint32 firstIndex = 0;  // Into the index data of the levels
+    uint32 indexCount = 0;
+    float error = 0.0f;
+};
+
 /**
  * @brief Mesh class holding geometry data and GPU buffers
  * 
@@ -59,13 +177,58 @@ public:
     /**
      * @brief Initialize mesh with vertex and index data
      * @param device Graphics device to create buffers
-     * @param vertices Vector of vertex data
-     * @param indices Vector of index data
+     * @param vertices Vector of vertex data, moved in as the CPU copy
+     * @param indices Vector of index data, likewise
+     * @param dynamic Keep the buffers in host-visible memory for geometry rewritten
+     *                from the CPU; static meshes go to device-local memory
+     * @param format GPU vertex layout; the CPU copy always keeps full-float vertices
+     * @param quantization Cube for VertexFormat::Compact positions
      * @return true if successful, false otherwise
      */
     bool Initialize(rhi::GraphicsDevice* device,
-                   const std::vector<Vertex>& vertices,
-                   const std::vector<uint32_t>& indices);
+                   std::vector<Vertex> vertices,
+                   std::vector<uint32_t> indices,
+                   bool dynamic = false,
+                   VertexFormat format = VertexFormat::Float,
+                   const VertexQuantization& quantization = {});
+
+    /**
+     * @brief Initialize mesh from raw vertex and index arrays
+     *
+     * Same as above, but uploads straight from the caller's memory (e.g. a mapped
+     * mesh cache file) instead of requiring std::vector storage.
+     */
+    bool Initialize(rhi::GraphicsDevice* device,
+                   const Vertex* vertices, uint32_t vertexCount,
+                   const uint32_t* indices, uint32_t indexCount,
+                   bool dynamic = false,
+                   VertexFormat format = VertexFormat::Float,
+                   const VertexQuantization& quantization = {});
+
+    /**
+     * @brief Initialize mesh inside a shared GeometryPool
+     *
+     * The mesh's buffers are the pool's; draws must pass GetFirstIndex() and
+     * GetVertexOffset() to DrawIndexed. Indices stay relative to the mesh. When the pool
+     * has a position stream the mesh's positions are written to it as well.
+     * @return false if the pool is full
+     */
+    bool Initialize(GeometryPool& pool,
+                   const Vertex* vertices, uint32_t vertexCount,
+                   const uint32_t* indices, uint32_t indexCount,
+                   const VertexQuantization& quantization = {});
+
+    /**
+     * @brief Upload a separate, tightly packed position stream for depth-only passes
+     *
+     * Shadow (and other depth-only) pipelines bind it through GetPositionInputLayout()
+     * so they fetch only positions instead of whole interleaved vertices. Costs the
+     * extra buffer; only for static meshes, since it is built from the CPU copy once
+     * (release that afterwards if nothing else needs it).
+     * Pooled meshes get theirs from the pool instead.
+     * @return true if the stream was created
+     */
+    bool CreatePositionStream(rhi::GraphicsDevice* device);
 
     /**
      * @brief Clean up GPU resources
@@ -78,27 +241,95 @@ public:
     bool IsValid() const { return m_VertexBuffer != nullptr && m_IndexBuffer != nullptr; }
 
     // Getters
-    Ref<rhi::Buffer> GetVertexBuffer() const { return m_VertexBuffer; }
-    Ref<rhi::Buffer> GetIndexBuffer() const { return m_IndexBuffer; }
+    const Ref<rhi::Buffer>& GetVertexBuffer() const { return m_VertexBuffer; }
+    const Ref<rhi::Buffer>& GetIndexBuffer() const { return m_IndexBuffer; }
+    const Ref<rhi::Buffer>& GetPositionBuffer() const { return m_PositionBuffer; }  // Null without a position stream
     uint32_t GetVertexCount() const { return m_VertexCount; }
     uint32_t GetIndexCount() const { return m_IndexCount; }
+    uint32_t GetFirstIndex() const { return m_FirstIndex; }     // Into GetIndexBuffer() (0 unless pooled)
+    int32_t GetVertexOffset() const { return m_VertexOffset; }  // Added to every index (0 unless pooled)
+    bool IsPooled() const { return m_Pooled; }
+    VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+    // Cube of the compact positions (VertexFormat::Compact only)
+    const VertexQuantization& GetQuantization() const { return m_Quantization; }
+
+    // Bounds in model space (full-float positions), computed once when the mesh is
+    // initialized so visibility tests and Model::GetBoundingBox never rescan vertices
+    const glm::vec3& GetBoundsMin() const { return m_BoundsMin; }
+    const glm::vec3& GetBoundsMax() const { return m_BoundsMax; }
+    const glm::vec3& GetBoundsCenter() const { return m_BoundsCenter; }
+    float GetBoundsRadius() const { return m_BoundsRadius; }
 
+    // Full CPU copy of the geometry, for CreatePositionStream(); empty unless the CPU
+    // data mode is MeshCPUData::Full. Initialize() copies the arrays it uploads, unless
+    // SetCPUData() already handed it these arrays.
     const std::vector<Vertex>& GetVertices() const { return m_Vertices; }
     const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+    // Moves in the full CPU copy; pass its data() to Initialize() to upload without copying
+    void SetCPUData(std::vector<Vertex> vertices, std::vector<uint32_t> indices);
+
+    // What the mesh keeps in RAM (Full by default). Set before Initialize(), or after
+    // it to compress or drop the full copy; nothing dropped comes back.
+    void SetCPUDataMode(MeshCPUData mode);
+    MeshCPUData GetCPUDataMode() const { return m_CPUDataMode; }
+
+    // Triangles of the CPU copy, full or compressed, for picking; 0 without one
+    uint32 GetCPUTriangleCount() const;
+    bool HasCPUData() const { return GetCPUTriangleCount() > 0; }
+    // Model-space corners of a triangle of the CPU copy
+    void GetCPUTriangle(uint32 triangle, glm::vec3& outA, glm::vec3& outB, glm::vec3& outC) const;
+
+    // Meshlets covering the indices in order (BuildMeshlets()); empty when the import
+    // built none, in which case the mesh culls as a whole
+    void SetMeshlets(const Meshlet* meshlets, uint32 count) { m_Meshlets.assign(meshlets, meshlets + count); }
+    const std::vector<Meshlet>& GetMeshlets() const { return m_Meshlets; }
+
+    // Coarser levels of detail (BuildLodData()) and their index data. Call before
+    // Initialize(), which uploads the indices of the levels after the mesh's own.
+    void SetLods(const MeshLod* lods, uint32 lodCount, const uint32* lodIndices, uint32 lodIndexCount);
+    // Levels of detail, the full mesh being level 0
+    uint32 GetLodCount() const { return 1 + static_cast<uint32>(m_Lods.size()); }
+    uint32_t GetLodFirstIndex(uint32 lod) const {  // Into GetIndexBuffer()
+        return lod == 0 ? m_FirstIndex : m_FirstIndex + m_IndexCount + m_Lods[lod - 1].firstIndex;
+    }
+    uint32_t GetLodIndexCount(uint32 lod) const { return lod == 0 ? m_IndexCount : m_Lods[lod - 1].indexCount; }
+    float GetLodError(uint32 lod) const { return lod == 0 ? 0.0f : m_Lods[lod - 1].error; }
 
     // Material access
     void SetMaterial(std::unique_ptr<Material> material);
     Material* GetMaterial() const { return m_Material.get(); }
 
 private:
+    void StoreCPUData(const Vertex* vertices, const uint32_t* indices);
+    void CompressCPUData(const Vertex* vertices, const uint32_t* indices);
+    void ReleaseFullCPUData();
+    glm::vec3 GetCPUPosition(uint32_t index) const;
+
     std::vector<Vertex> m_Vertices;
     std::vector<uint32_t> m_Indices;
+    std::vector<uint16> m_CompressedPositions;  // xyz per vertex (MeshCPUData::Compressed)
+    std::vector<uint16> m_CompressedIndices16;  // When every index fits
+    std::vector<uint32_t> m_CompressedIndices32;
+    std::vector<Meshlet> m_Meshlets;
+    std::vector<MeshLod> m_Lods;
+    std::vector<uint32_t> m_LodIndices;
 
     Ref<rhi::Buffer> m_VertexBuffer;
     Ref<rhi::Buffer> m_IndexBuffer;
+    Ref<rhi::Buffer> m_PositionBuffer;
 
     uint32_t m_VertexCount = 0;
     uint32_t m_IndexCount = 0;
+    uint32_t m_FirstIndex = 0;
+    int32_t m_VertexOffset = 0;
+    bool m_Pooled = false;
+    MeshCPUData m_CPUDataMode = MeshCPUData::Full;
+    VertexFormat m_VertexFormat = VertexFormat::Float;
+    VertexQuantization m_Quantization;
+    glm::vec3 m_BoundsMin = glm::vec3(0.0f);
+    glm::vec3 m_BoundsMax = glm::vec3(0.0f);
+    glm::vec3 m_BoundsCenter = glm::vec3(0.0f);
+    float m_BoundsRadius = 0.0f;
 
     std::unique_ptr<Material> m_Material;
 };
@@ -0,0 +1,71 @@
+// ============================================================================
+// include/metagfx/scene/MeshOptimizer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Mesh.h"
+#include <cstddef>
+#include <vector>
+
+namespace metagfx {
+
+struct MeshData;
+
+// Import-time index and vertex reordering. The passes run in this order, since each
+// one keeps most of what the previous one achieved:
+//
+// 1. OptimizeVertexCache  - triangle order for the post-transform vertex cache
+// 2. OptimizeOverdraw     - reorder cache-friendly clusters of triangles so outward
+//                           facing surfaces draw first (early-Z rejects more)
+// 3. OptimizeVertexFetch  - vertex order by first use, for vertex fetch locality
+//
+// None of them changes the rendered result.
+
+// Reorder triangles for a post-transform cache (Forsyth's linear-speed algorithm)
+void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount);
+
+// Reorder triangle clusters of a cache-optimized index buffer by occlusion potential.
+// A cluster ends where the cache would restart anyway, or where its cache efficiency
+// is within threshold of the whole mesh (1.05 = at most 5% more vertex transforms).
+void OptimizeOverdraw(uint32* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+                      float threshold = 1.05f);
+
+// Reorder vertices by first use and remap the indices. Unreferenced vertices are
+// dropped; returns the new vertex count.
+size_t OptimizeVertexFetch(Vertex* vertices, uint32* indices, size_t indexCount, size_t vertexCount);
+
+// Average vertex transforms per triangle for a FIFO cache (1/3 is ideal, 3 is worst)
+float ComputeACMR(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize = 16);
+
+// All three passes on a mesh with owned storage; views, counts and bounds are updated.
+// A deformed mesh (MeshData::IsDeformed) skips the vertex fetch pass.
+void OptimizeMeshData(MeshData& mesh);
+
+// Split the triangles into meshlets of at most maxVertices distinct vertices and
+// maxTriangles triangles, with bounds and normal cones, reordering them so each meshlet
+// is a contiguous range. Each meshlet grows from the first triangle left in the current
+// order, so after the passes above it keeps most of their cache and overdraw order.
+std::vector<Meshlet> BuildMeshlets(uint32* indices, size_t indexCount, const Vertex* vertices,
+                                   size_t vertexCount, uint32 maxVertices = Meshlet::MAX_VERTICES,
+                                   uint32 maxTriangles = Meshlet::MAX_TRIANGLES);
+
+// BuildMeshlets() on the mesh's own indices, into its meshlet storage and view; does
+// nothing for a mapped (cached) mesh, which comes with its meshlets, or a deformed one
+void BuildMeshletData(MeshData& mesh);
+
+// Simplify a mesh toward targetIndexCount indices by quadric-error edge collapses,
+// moving vertices onto neighbours so the result indexes the same vertex array. Vertices
+// on borders and attribute seams (a position shared by several vertices) stay, as does
+// any collapse that would flip a triangle or stray further than maxError (mesh units)
+// from the surface. Writes the indices to destination (room for indexCount) and
+// returns their count; outError receives the largest error of a collapse made.
+size_t SimplifyMesh(uint32* destination, const uint32* indices, size_t indexCount, const Vertex* vertices,
+                    size_t vertexCount, size_t targetIndexCount, float maxError, float* outError = nullptr);
+
+// Up to MeshLod::MAX_LEVELS coarser levels into the mesh's LOD storage and views, each
+// simplified from the full mesh to half the indices of the one before. Stops at a level
+// that would save too little or stray more than a few percent of the mesh's size.
+void BuildLodData(MeshData& mesh);
+
+} // namespace metagfx
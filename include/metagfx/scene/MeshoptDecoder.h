@@ -0,0 +1,38 @@
+// ============================================================================
+// include/metagfx/scene/MeshoptDecoder.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <cstddef>
+
+namespace metagfx {
+
+// Decoders for the bitstreams of the glTF EXT_meshopt_compression extension (the
+// meshoptimizer vertex codec v0 and index codecs v0/v1). Every decoder validates its
+// input and returns false on malformed or truncated data instead of reading past it.
+
+// Filters applied by the extension after vertex decoding
+enum class MeshoptFilter {
+    None,
+    Octahedral,   // Normals/tangents: 4 x int8 (stride 4) or 4 x int16 (stride 8)
+    Quaternion,   // Rotations: 4 x int16 (stride 8)
+    Exponential   // Floats stored as 8-bit exponent + 24-bit mantissa (stride multiple of 4)
+};
+
+// "ATTRIBUTES" mode: count elements of stride bytes (multiple of 4, at most 256)
+bool DecodeMeshoptVertexBuffer(void* destination, size_t count, size_t stride,
+                               const uint8* buffer, size_t size);
+
+// "TRIANGLES" mode: count indices (multiple of 3) of indexSize bytes (2 or 4)
+bool DecodeMeshoptIndexBuffer(void* destination, size_t count, size_t indexSize,
+                              const uint8* buffer, size_t size);
+
+// "INDICES" mode: count indices of indexSize bytes (2 or 4) without triangle structure
+bool DecodeMeshoptIndexSequence(void* destination, size_t count, size_t indexSize,
+                                const uint8* buffer, size_t size);
+
+// Undo a filter in place on count decoded elements of stride bytes
+bool ApplyMeshoptFilter(void* data, size_t count, size_t stride, MeshoptFilter filter);
+
+} // namespace metagfx
@@ -3,6 +3,10 @@
 // ============================================================================
 #pragma once
 
+#include "metagfx/rhi/DrawList.h"
+#include "metagfx/scene/Animation.h"
+#include "metagfx/scene/Frustum.h"
+#include "metagfx/scene/GeometryPool.h"
 #include "metagfx/scene/Mesh.h"
 #include <string>
 #include <vector>
@@ -13,7 +17,82 @@ namespace metagfx {
 // Forward declarations
 namespace rhi {
     class GraphicsDevice;
+    class Texture;
 }
+namespace utils {
+    class TextureCache;
+}
+
+class ModelLoadHandle;
+struct ModelData;
+struct NodeData;
+
+/**
+ * @brief Import-time processing, selectable per load
+ *
+ * The result is stored in the mesh cache; a cache built with other settings is
+ * ignored and rewritten.
+ */
+struct ModelImportSettings {
+    // Reorder triangles for the post-transform vertex cache and overdraw, then vertices
+    // for fetch locality (MeshOptimizer.h). Costs import time, never changes the image.
+    bool optimizeGeometry = true;
+
+    // Split each mesh into meshlets with bounds and normal cones (BuildMeshlets) that
+    // GPUCuller tests one by one. Costs import time and 48 bytes per meshlet.
+    bool buildMeshlets = true;
+
+    // Simplify each mesh into up to MeshLod::MAX_LEVELS coarser levels (BuildLodData)
+    // sharing its vertices; the renderers pick one per draw by its projected error.
+    // Costs import time and the levels' indices, under the mesh's own count again.
+    bool buildLods = true;
+
+    // GPU vertex layout. Compact quantizes positions to the model's bounds, so drawing
+    // needs a pipeline built for it and GetDequantizeMatrix() in the model matrix. The
+    // mesh cache keeps full-float vertices; the layout is applied when buffers are made.
+    VertexFormat vertexFormat = VertexFormat::Compact;
+
+    // Also upload a position-only stream per mesh (Mesh::CreatePositionStream) so the
+    // shadow pass fetches 12 (Float) or 8 (Compact) bytes per vertex. Costs that much
+    // extra VRAM per vertex.
+    bool positionStream = true;
+
+    // What each mesh keeps of its geometry in RAM after upload, for Scene::Pick():
+    // Compressed costs under a fifth of Full, None only keeps the bounds. ObjectPicker
+    // needs none of it. Not part of the mesh cache.
+    MeshCPUData cpuGeometry = MeshCPUData::Full;
+
+    // Over 0, KTX2 and DDS material textures (cooked or external) load only their mips
+    // of at most this many texels per side, and are listed in GetStreamableTextures()
+    // for TextureStreamer to read the larger ones on demand. Not part of the mesh cache.
+    uint32 textureStreamingExtent = 0;
+};
+
+/**
+ * @brief Material texture loaded without its largest mips (textureStreamingExtent)
+ */
+struct StreamableTexture {
+    Ref<rhi::Texture> texture;  // As loaded, which the model's materials hold
+    std::string path;           // KTX2 or DDS file the larger mips are read from
+};
+
+/**
+ * @brief Where Model::LoadFromFile spent its time, stage by stage, in milliseconds
+ *
+ * The stages run one after another, except that each texture is uploaded as soon as its
+ * decode finishes: decodeMs is the time spent waiting for decodes, and the uploads made
+ * meanwhile count towards uploadMs. LoadFromFile returns before the uploads have landed
+ * on the GPU; Model::IsResident() tells when they have.
+ */
+struct ModelLoadTimings {
+    double readMs = 0.0;     // Reading and hashing the source file (the mesh cache key)
+    double importMs = 0.0;   // Mapping the mesh cache, or the native glTF or Assimp import
+    double processMs = 0.0;  // Geometry optimization, meshlets and LODs; none from the cache
+    double decodeMs = 0.0;   // Parallel stb_image decodes (JobSystem)
+    double uploadMs = 0.0;   // Creating buffers, textures and materials and staging their data
+    bool fromMeshCache = false;
+    uint32 texturesDecoded = 0;  // Not found in the texture cache
+};
 
 /**
  * @brief Model class representing a 3D model with one or more meshes
@@ -34,11 +113,37 @@ public:
 
     /**
      * @brief Load a model from file
+     *
+     * The first load writes a binary mesh cache next to the file (ModelCache); later
+     * loads of the unchanged file map it instead of running Assimp.
      * @param device Graphics device for creating GPU buffers
      * @param filepath Path to the model file (OBJ, FBX, glTF, etc.)
+     * @param textureCache Optional device-wide cache; textures already in it (from other
+     *        materials or an earlier load of the same model) are reused instead of decoded
+     * @param settings Import-time processing
+     * @param timings Optional; receives the time spent in each stage of the load
      * @return true if loaded successfully, false otherwise
      */
-    bool LoadFromFile(rhi::GraphicsDevice* device, const std::string& filepath);
+    bool LoadFromFile(rhi::GraphicsDevice* device, const std::string& filepath,
+                      utils::TextureCache* textureCache = nullptr,
+                      const ModelImportSettings& settings = {},
+                      ModelLoadTimings* timings = nullptr);
+
+    /**
+     * @brief Start loading a model from file without blocking the caller
+     *
+     * The Assimp import, geometry extraction and texture decoding run on a worker thread.
+     * GPU resources are created, a few at a time, by ModelLoadHandle::Update(), which the
+     * render thread must call once per frame; the device is never touched off that thread.
+     * @param device Graphics device for creating GPU buffers
+     * @param filepath Path to the model file (OBJ, FBX, glTF, etc.)
+     * @param textureCache Optional device-wide cache (see LoadFromFile); must outlive the load
+     * @param settings Import-time processing (see LoadFromFile)
+     * @return Handle to poll; the model is available once it reports Ready
+     */
+    static Ref<ModelLoadHandle> LoadFromFileAsync(rhi::GraphicsDevice* device, const std::string& filepath,
+                                                  utils::TextureCache* textureCache = nullptr,
+                                                  const ModelImportSettings& settings = {});
 
     /**
      * @brief Create a simple procedural cube
@@ -67,13 +172,46 @@ public:
      */
     bool IsValid() const { return !m_Meshes.empty(); }
 
+    /**
+     * @brief True once every buffer and texture of the model has landed on the GPU
+     */
+    bool IsResident() const;
+
     // Getters
     const std::vector<std::unique_ptr<Mesh>>& GetMeshes() const { return m_Meshes; }
     size_t GetMeshCount() const { return m_Meshes.size(); }
     const std::string& GetFilePath() const { return m_FilePath; }
 
     /**
-     * @brief Calculate the bounding box of the entire model
+     * @brief GPU vertex layout shared by every mesh of the model
+     */
+    VertexFormat GetVertexFormat() const { return m_VertexFormat; }
+
+    /**
+     * @brief Matrix to apply before the model matrix (identity unless the format is Compact)
+     */
+    glm::mat4 GetDequantizeMatrix() const;
+
+    /**
+     * @brief Buffers shared by the meshes of a loaded model (null for procedural models)
+     *
+     * Every mesh of a loaded model is a range of this pool, so consecutive draws only
+     * rebind buffers when they actually change.
+     */
+    const Ref<GeometryPool>& GetGeometryPool() const { return m_GeometryPool; }
+
+    /**
+     * @brief One DrawIndexedIndirectCommand per mesh, in mesh order (null without a pool)
+     *
+     * Lets passes that need no per-mesh state (shadows, depth-only) draw the whole
+     * model with a single CommandBuffer::ExecuteDrawList over the pool's buffers.
+     * firstInstance is the mesh's node. Null as well when the device cannot read
+     * firstInstance from indirect commands and the model has node transforms.
+     */
+    const Ref<rhi::DrawList>& GetDrawList() const { return m_DrawList; }
+
+    /**
+     * @brief Bounding box of the entire model, combined from the meshes' cached bounds
      * @param outMin Output parameter for minimum corner
      * @param outMax Output parameter for maximum corner
      * @return true if bounding box was calculated, false if model is empty
@@ -95,14 +233,190 @@ public:
      */
     float GetBoundingSphereRadius() const;
 
+    /**
+     * @brief Model-space bounding sphere of every mesh, in mesh order, for CullSpheres
+     *
+     * Includes each mesh's node transform, as does the model bounding box.
+     */
+    const BoundingSphereSoA& GetMeshBounds() const { return m_MeshBounds; }
+
+    /**
+     * @brief Transform hierarchy of the file (a single identity node when it has none)
+     *
+     * Parents precede their children. World matrices are relative to the model root;
+     * meshes are drawn with the world matrix of their node (GetMeshNode).
+     */
+    uint32 GetNodeCount() const { return static_cast<uint32>(m_NodeParents.size()); }
+    const glm::mat4& GetNodeLocalTransform(uint32 node) const { return m_NodeLocal[node]; }
+    const glm::mat4& GetNodeWorldTransform(uint32 node) const { return m_NodeWorld[node]; }
+    uint32 GetNodeParent(uint32 node) const { return m_NodeParents[node]; }
+    uint32 GetMeshNode(size_t meshIndex) const { return m_MeshNodes[meshIndex]; }
+
+    // True if some mesh's node world matrix is not the identity
+    bool HasNodeTransforms() const;
+
+    /**
+     * @brief Skeletal and morph target animation of the file (Animator, Skinning)
+     *
+     * Deformed meshes force VertexFormat::Float and a deformable pool, which Skinning
+     * writes the posed vertices over. Their bounds, meshlets, picking geometry and
+     * ray-tracing bottom levels stay those of the bind pose.
+     */
+    const std::vector<Skin>& GetSkins() const { return m_Skins; }
+    const std::vector<AnimationClip>& GetAnimations() const { return m_Animations; }
+    const std::vector<DeformedMesh>& GetDeformedMeshes() const { return m_DeformedMeshes; }
+
+    /**
+     * @brief Material textures that have larger mips in their files, each listed once
+     */
+    const std::vector<StreamableTexture>& GetStreamableTextures() const { return m_StreamableTextures; }
+
+    /**
+     * @brief Group of the loaded buffers and textures (0 for procedural models)
+     *
+     * Textures created for the model later, such as streamed mips, join it too.
+     */
+    rhi::ResourceGroup GetResourceGroup() const { return m_ResourceGroup; }
+
     /**
      * @brief Add a mesh to the model (for procedural geometry)
+     *
+     * The mesh must use the model's vertex format. node is the node it hangs from.
      */
-    void AddMesh(std::unique_ptr<Mesh> mesh);
+    void AddMesh(std::unique_ptr<Mesh> mesh, uint32 node = 0);
 
 private:
+    friend class ModelLoadHandle;
+
     std::vector<std::unique_ptr<Mesh>> m_Meshes;
     std::string m_FilePath;
+    VertexFormat m_VertexFormat = VertexFormat::Float;
+    VertexQuantization m_Quantization;
+    Ref<GeometryPool> m_GeometryPool;
+    Ref<rhi::DrawList> m_DrawList;
+    BoundingSphereSoA m_MeshBounds;
+    glm::vec3 m_BoundsMin = glm::vec3(0.0f);
+    glm::vec3 m_BoundsMax = glm::vec3(0.0f);
+
+    // Node hierarchy, one entry per node in each array
+    std::vector<glm::mat4> m_NodeLocal;
+    std::vector<glm::mat4> m_NodeWorld;
+    std::vector<uint32> m_NodeParents;
+    std::vector<uint32> m_MeshNodes;  // Node of each mesh
+    std::vector<StreamableTexture> m_StreamableTextures;
+    rhi::ResourceGroup m_ResourceGroup = 0;
+
+    std::vector<Skin> m_Skins;
+    std::vector<AnimationClip> m_Animations;
+    std::vector<DeformedMesh> m_DeformedMeshes;
+
+    // Build m_DrawList once every mesh lives in the pool
+    void CreateDrawList(rhi::GraphicsDevice* device);
+
+    // Replace the hierarchy (empty = one identity node); call before adding meshes
+    void SetNodes(const std::vector<NodeData>& nodes);
+
+    // Add a mesh's bounds, moved into model space, to m_MeshBounds and the model box
+    void AccumulateBounds(const Mesh& mesh, const glm::mat4& world);
+
+    // AddMesh() with the deformation taken from its data (bindPose empty: it has none)
+    void AddMesh(std::unique_ptr<Mesh> mesh, uint32 node, DeformedMesh deformation);
+};
+
+enum class ModelLoadState {
+    Loading,    // Importing and decoding on the worker thread
+    Uploading,  // Creating GPU resources and waiting for their uploads
+    Ready,      // Every buffer and texture is resident; TakeModel() returns the model
+    Failed,
+    Cancelled
+};
+
+/**
+ * @brief GPU resources the loads advanced in one frame may create in it, between them
+ *
+ * Each load imports on a worker thread of its own (its own Assimp importer or glTF
+ * loader), so several models import at once. Their uploads all go out through the
+ * device's staging ring; one budget per frame, handed to every ModelLoadHandle::Update()
+ * of that frame, keeps a dozen loads from creating a dozen frames' worth of buffers and
+ * textures in one.
+ */
+struct ModelUploadBudget {
+    uint32 meshes = 16;
+    uint32 textures = 32;
+};
+
+/**
+ * @brief In-flight Model::LoadFromFileAsync
+ *
+ * Destroying the handle cancels the load. The destructor waits for the worker thread,
+ * which may be inside the Assimp import, so to drop a load without stalling call
+ * Cancel() and keep updating the handle until it reports Cancelled.
+ */
+class ModelLoadHandle {
+public:
+    ~ModelLoadHandle();
+
+    ModelLoadHandle(const ModelLoadHandle&) = delete;
+    ModelLoadHandle& operator=(const ModelLoadHandle&) = delete;
+
+    /**
+     * @brief Advance the load; call once per frame from the render thread
+     *
+     * Uploads textures decoded since the last call and creates meshes, as many of each
+     * as the budget has left (a budget of its own without one), attaches materials once
+     * every texture is uploaded and finally polls the uploads. Never waits on the worker
+     * or the GPU.
+     */
+    ModelLoadState Update(ModelUploadBudget* budget = nullptr);
+
+    ModelLoadState GetState() const { return m_State; }
+    bool IsFinished() const { return m_State == ModelLoadState::Ready || m_State == ModelLoadState::Failed ||
+                                     m_State == ModelLoadState::Cancelled; }
+
+    /**
+     * @brief Stop the load as soon as the worker reaches its next step
+     */
+    void Cancel();
+
+    /**
+     * @brief Take ownership of the loaded model (nullptr unless the state is Ready)
+     */
+    std::unique_ptr<Model> TakeModel();
+
+    const std::string& GetFilePath() const;
+
+private:
+    friend class Model;
+    struct Job;  // Defined in Model.cpp
+
+    ModelLoadHandle();
+
+    std::unique_ptr<Job> m_Job;
+    ModelLoadState m_State = ModelLoadState::Loading;
+};
+
+/**
+ * @brief Device-free import of a model file, for tools that want its data rather than a Model
+ *
+ * Runs the import of Model::LoadFromFile (mesh cache, native glTF or Assimp, then the
+ * settings' processing) without a device and without decoding textures. The data may
+ * point into the importer, which must outlive it.
+ */
+class ModelImporter {
+public:
+    ModelImporter();
+    ~ModelImporter();
+
+    ModelImporter(const ModelImporter&) = delete;
+    ModelImporter& operator=(const ModelImporter&) = delete;
+
+    // False, logging why, when the file cannot be imported
+    bool Import(const std::string& filepath, ModelData& outData, const ModelImportSettings& settings = {});
+
+private:
+    struct Source;  // Defined in Model.cpp
+
+    std::unique_ptr<Source> m_Source;
 };
 
-} // namespace metagfx
\ No newline at end of file
+} // namespace metagfx
@@ -0,0 +1,173 @@
+// ============================================================================
+// include/metagfx/scene/ModelCache.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Animation.h"
+#include "metagfx/scene/Material.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/utils/MappedFile.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief Geometry of one mesh, ready for Mesh::Initialize
+ *
+ * The pointers reference either the owned storage (filled by an Assimp import) or a
+ * mapped cache file, so mapped geometry is uploaded without an intermediate copy.
+ * Move-only: moving keeps the storage, and with it the pointers, valid.
+ */
+struct MeshData {
+    const Vertex* vertices = nullptr;
+    uint32 vertexCount = 0;
+    const uint32* indices = nullptr;
+    uint32 indexCount = 0;
+    const Meshlet* meshlets = nullptr;  // Over the indices in order; none without MODEL_PROCESS_BUILD_MESHLETS
+    uint32 meshletCount = 0;
+    const MeshLod* lods = nullptr;      // Coarser levels, indexing lodIndices; none without MODEL_PROCESS_BUILD_LODS
+    uint32 lodCount = 0;
+    const uint32* lodIndices = nullptr;
+    uint32 lodIndexCount = 0;
+    uint32 materialIndex = 0;
+    uint32 node = 0;                    // ModelData::nodes entry the mesh hangs from
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+
+    std::vector<Vertex> vertexStorage;  // Empty when the data is mapped
+    std::vector<uint32> indexStorage;
+    std::vector<Meshlet> meshletStorage;
+    std::vector<MeshLod> lodStorage;
+    std::vector<uint32> lodIndexStorage;
+
+    // Deformation, parallel to the vertices; never mapped (a deformed model is not cached)
+    uint32 skin = DeformedMesh::NO_SKIN;        // ModelData::skins entry
+    std::vector<SkinVertex> skinStorage;        // Empty without a skin
+    uint32 morphTargetCount = 0;
+    std::vector<MorphTargetDelta> morphDeltaStorage;  // morphTargetCount * vertexCount, target after target
+    std::vector<float> morphWeights;            // Default weight of each target
+
+    bool IsDeformed() const { return !skinStorage.empty() || morphTargetCount > 0; }
+
+    MeshData() = default;
+    MeshData(MeshData&&) = default;
+    MeshData& operator=(MeshData&&) = default;
+    MeshData(const MeshData&) = delete;
+    MeshData& operator=(const MeshData&) = delete;
+};
+
+/**
+ * @brief Material parameters and texture references as read from the model file
+ *
+ * Texture references are spelled as the file spells them ("*N" = embedded texture N);
+ * empty means the slot has no texture.
+ */
+struct MaterialDesc {
+    glm::vec3 albedo = glm::vec3(0.8f);
+    float roughness = 0.5f;
+    float metallic = 0.0f;
+    glm::vec3 emissiveFactor = glm::vec3(0.0f);
+    bool hasEmissiveFactor = false;
+    AlphaMode alphaMode = AlphaMode::Opaque;
+    float alpha = 1.0f;         // Of the base color
+    float alphaCutoff = 0.5f;   // With AlphaMode::Mask
+
+    std::string albedoMap;
+    std::string normalMap;
+    std::string metallicRoughnessMap;        // glTF combined map (aiTextureType_METALNESS)
+    std::string roughnessMap;                // Separate roughness, used without a combined map
+    std::string aoMap;
+    std::string emissiveMap;
+    std::string packedMetallicRoughnessMap;  // UNKNOWN-type texture guessed as metallic-roughness
+};
+
+/**
+ * @brief Texture stored inside the model file
+ */
+struct EmbeddedTexture {
+    const uint8* data = nullptr;
+    uint64 size = 0;    // Bytes
+    uint32 width = 0;   // Raw texels only; 0 = encoded image (PNG, JPG, KTX2) of size bytes
+    uint32 height = 0;
+};
+
+/**
+ * @brief Node of the model's transform hierarchy
+ *
+ * Parents precede their children; the root has parent NO_PARENT.
+ */
+struct NodeData {
+    static constexpr uint32 NO_PARENT = ~0u;
+
+    glm::mat4 localTransform = glm::mat4(1.0f);
+    uint32 parent = NO_PARENT;
+};
+
+/**
+ * @brief CPU-side contents of a model, independent of whether Assimp or a cache produced it
+ */
+struct ModelData {
+    std::vector<MeshData> meshes;
+    std::vector<MaterialDesc> materials;
+    std::vector<EmbeddedTexture> embeddedTextures;
+    std::vector<NodeData> nodes;  // Empty = every mesh at the model origin
+    std::vector<Skin> skins;
+    std::vector<AnimationClip> animations;
+
+    // Something moves: a skinned or morphed mesh, or a clip
+    bool IsAnimated() const;
+};
+
+// Processing Model.cpp applies after the import (part of the cache key)
+enum ModelProcessFlags : uint32 {
+    MODEL_PROCESS_NONE = 0,
+    MODEL_PROCESS_OPTIMIZE_GEOMETRY = 1 << 0,  // MeshOptimizer: vertex cache, overdraw, vertex fetch
+    MODEL_PROCESS_BUILD_MESHLETS = 1 << 1,     // MeshOptimizer: BuildMeshlets
+    MODEL_PROCESS_BUILD_LODS = 1 << 2          // MeshOptimizer: BuildLodData
+};
+
+/**
+ * @brief Binary cache of an imported model, written next to the model file
+ *
+ * Holds interleaved vertex, index, meshlet and LOD blobs, material descriptors, texture references,
+ * embedded texture data, bounds and the node hierarchy, so a later load skips Assimp and its post-processing.
+ * The cache is memory-mapped and ModelData points straight into the mapped pages.
+ *
+ * A cache is valid only for the source file content (hashed), import flags and
+ * processing flags it was built from, and for the Vertex layout of the build that wrote it. The layout is the
+ * native one of the writing machine - it is a local cache, not an interchange format.
+ *
+ * Skins, morph targets and animation clips are not stored: Write() refuses an animated
+ * model (ModelData::IsAnimated()), which is imported again on every load.
+ */
+class ModelCache {
+public:
+    static constexpr uint32 VERSION = 8;
+
+    // Cache path for a model file, e.g. "DamagedHelmet.glb" -> "DamagedHelmet.glb.meshcache"
+    static std::string GetPathForModel(const std::string& modelPath);
+
+    // Content hash of the source model file; false when it cannot be read
+    static bool HashSourceFile(const std::string& modelPath, uint64& outHash);
+
+    // Serialize a model. Written to a temporary file and renamed, so readers never see
+    // a partial cache.
+    static bool Write(const std::string& cachePath, const ModelData& data, uint64 sourceHash,
+                      uint32 importFlags, uint32 processFlags);
+
+    // Map a cache and fill outData with views into it. Fails, leaving the cache closed,
+    // when the file is missing, truncated, of another version or built from another
+    // source or flag set. The views stay valid until Close() or destruction.
+    bool Open(const std::string& cachePath, uint64 sourceHash, uint32 importFlags, uint32 processFlags,
+              ModelData& outData);
+    void Close() { m_File.Close(); }
+    bool IsOpen() const { return m_File.IsOpen(); }
+
+private:
+    utils::MappedFile m_File;
+};
+
+} // namespace metagfx
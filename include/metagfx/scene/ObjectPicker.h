@@ -0,0 +1,96 @@
+// ============================================================================
+// include/metagfx/scene/ObjectPicker.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/ReadbackPool.h"
+#include <glm/glm.hpp>
+#include <memory>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Mesh picking on the GPU, read back without stalling the frame
+ *
+ * A request has the renderer draw the model's meshes with pick.frag into a small ID
+ * target of the frame's graph, covering the REGION_SIZE pixels around the cursor: each
+ * texel holds the world position of the nearest surface and its mesh index plus one (0
+ * where nothing was drawn). ReadBack() copies the target into a staging buffer in the
+ * same frame (ReadbackPool), resolved to the texel nearest the cursor once the GPU has
+ * finished it, a frame or two later. No CPU geometry is needed, so models can drop it
+ * (ModelImportSettings::cpuGeometry).
+ *
+ * One pick is in flight at a time; a new request replaces one not drawn yet, and a
+ * result arriving after a newer request was drawn is dropped.
+ */
+class ObjectPicker {
+public:
+    static constexpr uint32 REGION_SIZE = 9;  // Pixels on a side, odd so the cursor is the center
+    static constexpr rhi::Format ID_FORMAT = rhi::Format::R32G32B32A32_SFLOAT;  // pick.frag's output
+    static constexpr rhi::Format DEPTH_FORMAT = rhi::Format::D32_SFLOAT;
+
+    struct Result {
+        bool hit = false;
+        uint32 mesh = 0;  // MeshInstance::userData of the surface under the cursor
+        glm::vec3 position = glm::vec3(0.0f);  // World space
+    };
+
+    explicit ObjectPicker(Ref<rhi::GraphicsDevice> device);
+    ~ObjectPicker() = default;
+
+    ObjectPicker(const ObjectPicker&) = delete;
+    ObjectPicker& operator=(const ObjectPicker&) = delete;
+
+    bool IsValid() const { return m_Readback != nullptr; }
+
+    // Pick at ndc of the camera's projection (the top of the viewport is y = -1)
+    void Request(const glm::vec2& ndc);
+    bool HasRequest() const { return m_Requested; }
+    // A request waits to be drawn or its result to arrive
+    bool IsPicking() const { return m_Requested || m_Pending->resolved < m_Serial; }
+
+    /**
+     * @brief Take the request for this frame's pick pass
+     *
+     * Returns the matrix to apply after the camera's view-projection so that the region
+     * of viewportSize pixels around the request fills the ID target. The request counts
+     * as drawn from here.
+     */
+    glm::mat4 BeginPick(const glm::vec2& viewportSize);
+
+    // Copy the pick pass's ID target (ID_FORMAT, REGION_SIZE on a side), in
+    // ResourceState::TransferRead, out of the frame, outside any render pass
+    void ReadBack(rhi::CommandBuffer& cmd, const Ref<rhi::Texture>& ids);
+
+    // Call after GraphicsDevice::BeginFrame(): resolves the picks the GPU has finished
+    void BeginFrame();
+    // The latest resolved pick, once; false while none has arrived since the last call
+    bool TakeResult(Result& result);
+
+private:
+    // Shared with the readback callback, which may run after the picker is gone (WebGPU)
+    struct Pending {
+        uint64 serial = 0;    // Of the newest pick drawn
+        uint64 resolved = 0;  // Of the newest pick resolved, or whose readback failed
+        bool ready = false;
+        Result result;
+    };
+
+    static Result Resolve(const void* data, uint64 size);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    std::unique_ptr<rhi::ReadbackPool> m_Readback;
+    std::shared_ptr<Pending> m_Pending;
+
+    glm::vec2 m_RequestNdc = glm::vec2(0.0f);
+    bool m_Requested = false;
+    uint64 m_Serial = 0;  // Picks drawn so far
+};
+
+} // namespace metagfx
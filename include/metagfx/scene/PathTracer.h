@@ -0,0 +1,176 @@
+// ============================================================================
+// include/metagfx/scene/PathTracer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/Light.h"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class GeometryPool;
+class Material;
+class Scene;
+
+/**
+ * @brief Progressive path tracer over the rasterizer's scene, for ground-truth look-dev
+ *
+ * Trace() runs path_trace.comp: camera paths through each pixel against the scene's top
+ * level (RayTracingScene), shaded with the bindless material table and its textures, the
+ * model's geometry pool, the frame's lights and the environment, so nothing is uploaded
+ * twice. Each sample is averaged into a float accumulation texture owned here, which
+ * Composite() copies into the HDR scene color.
+ *
+ * The image is cut into TILE_SIZE tiles. The first pass after a reset traces all of them,
+ * so a moving view always shows a whole (noisy) image; later frames trace tilesPerFrame
+ * tiles each, one sample per pixel, in turn, which bounds the work of every frame's
+ * submission whatever the bounces cost. Accumulation resets by itself when the camera,
+ * the size or the lights change; the caller resets it when the scene's geometry or
+ * materials do (Reset()).
+ *
+ * The first pass also writes two guide textures of the camera rays' first hits, which
+ * Denoiser filters the accumulation with while it has few samples: their normal and
+ * depths (GUIDE_FORMAT), and their base color (ALBEDO_FORMAT).
+ *
+ * Needs DeviceInfo::supportsRayQuery and bindless textures; the geometry pool's buffers
+ * are readable as storage on such devices (GeometryPool).
+ */
+class PathTracer {
+public:
+    static constexpr rhi::Format ACCUMULATION_FORMAT = rhi::Format::R32G32B32A32_SFLOAT;
+    // Octahedral normal, view depth and NDC depth; all 0 where the ray left the scene
+    static constexpr rhi::Format GUIDE_FORMAT = rhi::Format::R32G32B32A32_SFLOAT;
+    static constexpr rhi::Format ALBEDO_FORMAT = rhi::Format::R8G8B8A8_UNORM;
+    static constexpr uint32 TILE_SIZE = 256;  // Pixels per side
+    static constexpr uint32 GROUP_SIZE = 8;   // Must match path_trace.comp
+
+    struct Settings {
+        uint32 tilesPerFrame = 4;   // After the first pass
+        uint32 maxBounces = 4;      // Surface hits after the camera ray's
+        uint32 maxSamples = 1024;   // Per pixel; the image then stays as it is
+    };
+
+    // What the frame's view looks like; a change resets the accumulation
+    struct View {
+        glm::mat4 viewProjection = glm::mat4(1.0f);  // As the frame constants' (unjittered)
+        bool environment = false;                    // The environment lights the scene (IBL)
+        float environmentIntensity = 1.0f;
+    };
+
+    // traceShader runs path_trace.comp, the composite shaders fullscreen.vert and
+    // path_trace_composite.frag. sceneBindings are the main pass's set: the tracer reads its
+    // frame constants, lights, prefiltered map and top level at the same binding numbers.
+    // textureCapacity is the size of the bindless texture table.
+    PathTracer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> traceShader,
+               Ref<rhi::Shader> compositeVertexShader, Ref<rhi::Shader> compositeFragmentShader,
+               const std::vector<rhi::DescriptorBindingDesc>& sceneBindings, uint32 textureCapacity,
+               rhi::Format sceneColorFormat);
+    ~PathTracer() = default;
+
+    PathTracer(const PathTracer&) = delete;
+    PathTracer& operator=(const PathTracer&) = delete;
+
+    bool IsValid() const { return m_TracePipeline && m_CompositePipeline; }
+    // Every input is set: Trace() has something to trace
+    bool IsReady() const { return m_DescriptorSet && m_TopLevel; }
+
+    void SetSettings(const Settings& settings);
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Replace a texture or buffer of the scene bindings, as the main pass's set did
+    void SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer);
+    // RayTracingScene::GetTopLevel() after the frame's Update()
+    void SetTopLevel(Ref<rhi::AccelerationStructure> topLevel);
+
+    // The bindless material table: its buffer and the textures its indices name, as
+    // written to the main pass's table. Resets the accumulation.
+    void SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                      Ref<rhi::Sampler> sampler);
+    // The scene's mesh instances, which the top level's instance indices name, drawn from
+    // pool with the table's materialIndices. Resets the accumulation.
+    void SetGeometry(const Scene& scene, const GeometryPool& pool,
+                     const std::unordered_map<const Material*, uint32>& materialIndices);
+
+    // Sizes the accumulation and guides for a width x height scene color, once a frame
+    // before they are used; they rest between frames in ResourceState::StorageWrite
+    void Resize(uint32 width, uint32 height);
+    const Ref<rhi::Texture>& GetAccumulation() const { return m_Accumulation; }
+    const Ref<rhi::Texture>& GetGuide() const { return m_Guide; }
+    const Ref<rhi::Texture>& GetAlbedo() const { return m_Albedo; }
+
+    // The samples gathered so far are dropped at the next Trace()
+    void Reset() { m_ResetPending = true; }
+
+    /**
+     * @brief Record the frame's tiles (outside any render pass)
+     *
+     * Writes the accumulation and guides as storage; the caller orders them against the
+     * composite or the denoiser.
+     * @param frameUniformOffset Binding 0 of the scene bindings: the frame constants
+     */
+    void Trace(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset, const View& view,
+               const Scene& scene);
+
+    // Inside a render pass over the scene color: one triangle over the viewport
+    void Composite(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+    // Samples every pixel has; the tiles of the current pass have one more
+    uint32 GetSampleCount() const { return m_Pass; }
+    // Of the current pass, in [0, 1)
+    float GetPassProgress() const;
+    bool IsConverged() const { return m_Pass >= m_Settings.maxSamples; }
+
+private:
+    // Of the instance buffer, as path_trace.comp reads it
+    struct InstanceData {
+        uint32 firstIndex;
+        int32 vertexOffset;
+        uint32 materialIndex;  // NO_MATERIAL: the mesh is not in the pool
+        uint32 compact;        // 1 = VertexFormat::Compact
+    };
+    static constexpr uint32 NO_MATERIAL = 0xFFFFFFFFu;
+
+    void SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void CreateDescriptorSets();
+    uint32 GetTileCount() const;
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_TracePipeline;
+    Ref<rhi::Pipeline> m_CompositePipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    std::vector<rhi::DescriptorBindingDesc> m_Bindings;  // Scene bindings, then the tracer's own
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::DescriptorSet> m_CompositeDescriptorSet;
+    uint32 m_TextureCapacity = 0;
+
+    Ref<rhi::AccelerationStructure> m_TopLevel;
+    std::vector<Ref<rhi::Texture>> m_Textures;  // Of the table; the set's elements past them are cleared
+    uint32 m_WrittenTextures = 0;                // Elements of the set's table written
+    Ref<rhi::Sampler> m_TextureSampler;
+    Ref<rhi::Texture> m_Accumulation;
+    Ref<rhi::Texture> m_Guide;
+    Ref<rhi::Texture> m_Albedo;
+    uint32 m_Width = 0;
+    uint32 m_Height = 0;
+
+    Settings m_Settings;
+    View m_View;
+    std::vector<LightData> m_Lights;  // Of the last Trace()
+    bool m_ResetPending = true;
+    uint32 m_Pass = 0;      // Samples of the pixels of tiles before m_NextTile
+    uint32 m_NextTile = 0;  // Of the current pass
+};
+
+} // namespace metagfx
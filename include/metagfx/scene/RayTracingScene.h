@@ -0,0 +1,90 @@
+// ============================================================================
+// include/metagfx/scene/RayTracingScene.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class Mesh;
+class Scene;
+
+/**
+ * @brief Acceleration structures of a scene's meshes, for ray traced passes
+ *
+ * One bottom level per mesh, built the first frame an instance places it and compacted
+ * once the GPU reports its compacted size, and one top level over the scene's mesh
+ * instances. The top level is refit while only transforms change and rebuilt when
+ * instances are added or removed or a bottom level is replaced by its compacted copy.
+ * Meshes need BufferUsage::AccelerationStructureInput on their buffers, which Mesh and
+ * GeometryPool add on devices that support acceleration structures.
+ *
+ * Bottom levels are keyed by mesh: call Clear() when the meshes they were built from
+ * go away (a new model), before the next Update().
+ */
+class RayTracingScene {
+public:
+    struct Stats {
+        uint32 bottomLevels = 0;
+        uint32 compacted = 0;          // Of bottomLevels
+        uint64 bottomLevelBytes = 0;
+        uint64 topLevelBytes = 0;
+        uint32 instances = 0;          // Placed by the last top-level build
+        bool refit = false;            // The last top-level build was a refit
+    };
+
+    explicit RayTracingScene(Ref<rhi::GraphicsDevice> device);
+    ~RayTracingScene();
+
+    RayTracingScene(const RayTracingScene&) = delete;
+    RayTracingScene& operator=(const RayTracingScene&) = delete;
+
+    bool IsSupported() const { return m_Device && m_Device->GetDeviceInfo().supportsAccelerationStructures; }
+
+    // Records this frame's builds, outside any render pass: bottom levels of meshes new
+    // to the scene, compactions, and the top level when anything moved. The top level
+    // places instance.transform after modelMatrix (and, for compact meshes, after their
+    // dequantization); hits report the scene's instance index. Call at most once per frame.
+    void Update(rhi::CommandBuffer& cmd, const Scene& scene, const glm::mat4& modelMatrix);
+
+    // Retires every structure; the next Update() builds them anew
+    void Clear();
+
+    // Null until the first Update() that places an instance
+    const Ref<rhi::AccelerationStructure>& GetTopLevel() const { return m_TopLevel; }
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    struct BottomLevel {
+        Ref<rhi::AccelerationStructure> structure;
+        bool compacted = false;  // Or compaction would not shrink it
+    };
+
+    // Null when the mesh cannot be traced (no buffers, or a vertex format the device cannot build from)
+    BottomLevel* GetBottomLevel(const Mesh& mesh, std::vector<rhi::AccelerationStructureBuild>& builds);
+    void CompactBottomLevels(rhi::CommandBuffer& cmd);
+    bool EnsureTopLevel(uint32 instanceCount);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    std::unordered_map<const Mesh*, BottomLevel> m_BottomLevels;
+    std::unordered_set<const Mesh*> m_Untraceable;  // Reported once
+    Ref<rhi::AccelerationStructure> m_TopLevel;
+
+    std::vector<rhi::AccelerationStructureInstance> m_Instances;       // Of the last top-level build
+    std::vector<rhi::AccelerationStructureInstance> m_NextInstances;   // Update() scratch
+    std::vector<rhi::AccelerationStructureBuild> m_Builds;
+    Stats m_Stats;
+};
+
+} // namespace metagfx
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "metagfx/core/Types.h"
+#include "metagfx/scene/BVH.h"
 #include "metagfx/scene/Light.h"
+#include "metagfx/scene/SceneGraph.h"
 #include "metagfx/rhi/Buffer.h"
 #include <vector>
 #include <memory>
@@ -14,31 +16,170 @@ namespace rhi {
     class Buffer;
 }
 
+class Mesh;
+class Model;
+
+// A mesh placed in the world; the mesh is owned elsewhere (by its Model)
+struct MeshInstance {
+    const Mesh* mesh = nullptr;
+    glm::mat4 transform = glm::mat4(1.0f);
+    uint32 userData = 0;                  // Caller-defined, e.g. the mesh's index in its model
+    uint32 proxy = BVH::INVALID_PROXY;    // Leaf in the scene BVH
+    uint32 node = SceneGraph::INVALID_NODE;  // Scene graph node the transform follows, if any
+};
+
+struct ScenePickResult {
+    uint32 instance = 0;
+    float distance = 0.0f;                // Along the ray, in units of its direction
+    glm::vec3 position = glm::vec3(0.0f); // World space
+};
+
 class Scene {
 public:
     Scene();
     ~Scene();
 
-    // Light management
-    Light* AddLight(std::unique_ptr<Light> light);
-    void RemoveLight(Light* light);
+    // Light management. Lights are stored contiguously by type and addressed by handles,
+    // which stay valid until removed. Pointers from Get*Light() are valid until the next
+    // AddLight() or RemoveLight(); their setters mark the light for upload.
+    using LightHandle = uint32;
+    static constexpr LightHandle INVALID_LIGHT = ~0u;
+
+    LightHandle AddLight(const DirectionalLight& light);
+    LightHandle AddLight(const PointLight& light);
+    LightHandle AddLight(const SpotLight& light);
+    void RemoveLight(LightHandle light);
     void ClearLights();
 
-    const std::vector<std::unique_ptr<Light>>& GetLights() const { return m_Lights; }
-    size_t GetLightCount() const { return m_Lights.size(); }
+    // nullptr for a removed handle or one of another type
+    Light* GetLight(LightHandle light);
+    const Light* GetLight(LightHandle light) const { return FindLight(light); }
+    DirectionalLight* GetDirectionalLight(LightHandle light);
+    PointLight* GetPointLight(LightHandle light);
+    SpotLight* GetSpotLight(LightHandle light);
+
+    const std::vector<DirectionalLight>& GetDirectionalLights() const { return m_DirectionalLights; }
+    const std::vector<PointLight>& GetPointLights() const { return m_PointLights; }
+    const std::vector<SpotLight>& GetSpotLights() const { return m_SpotLights; }
+    size_t GetLightCount() const { return m_DirectionalLights.size() + m_PointLights.size() + m_SpotLights.size(); }
+    bool HasLights() const { return GetLightCount() > 0; }
+
+    // GPU buffer management. The light buffer holds a LightBufferHeader and then one
+    // region of MAX_LIGHTS entries per frame in flight; a frame's lights start at entry
+    // GetLightBufferBase() of the array after the header.
+    void InitializeLightBuffer(rhi::GraphicsDevice* device, uint32 framesInFlight = 2);
+    const Ref<rhi::Buffer>& GetLightBuffer() const { return m_LightBuffer; }
+    uint32 GetLightBufferBase(uint32 frameIndex) const { return (frameIndex % m_LightRegionCount) * MAX_LIGHTS; }
+
+    // Copies the lights changed since the last call into the frame's region, the whole
+    // array after lights were added or removed. Call per frame once the GPU is done with
+    // the frame slot.
+    void UpdateLightBuffer(uint32 frameIndex);
+
+    // The light array as uploaded: directional, then point, then spot lights, each type
+    // in its array's order
+    const std::vector<LightData>& GetGPULights() const { return m_GPULights; }
+    uint32 GetDirectionalLightCount() const { return static_cast<uint32>(m_DirectionalLights.size()); }
+    // Index of a light in that array, or INVALID_LIGHT for a removed handle
+    uint32 GetGPULightIndex(LightHandle light) const;
+
+    static constexpr uint32 MAX_LIGHTS = 4096;  // Shaded through LightClusters, not all per fragment
+    static constexpr uint32 INVALID_INSTANCE = ~0u;
 
-    // GPU buffer management
-    void InitializeLightBuffer(rhi::GraphicsDevice* device);
-    void UpdateLightBuffer();  // Call per frame before rendering
-    Ref<rhi::Buffer> GetLightBuffer() const { return m_LightBuffer; }
+    // The model the renderer draws, owned by the scene; its meshes are placed by mesh
+    // instances. Returns the previous model, which frames in flight may still reference.
+    std::unique_ptr<Model> SetModel(std::unique_ptr<Model> model);
+    Model* GetModel() const { return m_Model.get(); }
 
-    bool HasLights() const { return !m_Lights.empty(); }
+    // Mesh instances, indexed with point and spot lights in one BVH. Instance ids stay
+    // valid until removed; moving an instance refits its leaf only when it leaves the
+    // leaf's margin.
+    uint32 AddMeshInstance(const Mesh* mesh, const glm::mat4& transform, uint32 userData = 0);
+    void SetMeshInstanceTransform(uint32 instance, const glm::mat4& transform);
+    void RemoveMeshInstance(uint32 instance);
+    void ClearMeshInstances();
+    const MeshInstance& GetMeshInstance(uint32 instance) const { return m_Instances[instance]; }
+    uint32 GetMeshInstanceCount() const { return static_cast<uint32>(m_Instances.size()); }  // Including removed slots
 
-    static constexpr uint32 MAX_LIGHTS = 16;
+    // Transform hierarchy. An instance attached to a node takes the node's world matrix
+    // on every UpdateTransforms() that changes it.
+    SceneGraph& GetSceneGraph() { return m_SceneGraph; }
+    const SceneGraph& GetSceneGraph() const { return m_SceneGraph; }
+    void SetMeshInstanceNode(uint32 instance, uint32 node);
+
+    // Propagate scene graph changes and refit the attached instances; call per frame
+    // before culling. Returns true if any world matrix changed.
+    bool UpdateTransforms();
+
+    // Instances whose bounds may intersect a world-space frustum (ids, in no particular order)
+    void QueryInstances(const Frustum& frustum, std::vector<uint32>& outInstances) const;
+
+    // Lights that may affect a world-space frustum (directional lights always do)
+    void QueryLights(const Frustum& frustum, std::vector<LightHandle>& outLights) const;
+
+    // Instances within a point or spot light's range, which are the only ones that can
+    // cast its shadows. A directional light returns every instance; cull those against
+    // its shadow frustum with QueryInstances instead.
+    void QueryShadowCasters(const Light& light, std::vector<uint32>& outInstances) const;
+
+    // Nearest triangle of any instance hit by the ray; false when nothing is hit. Meshes
+    // without a CPU copy (Mesh::HasCPUData()) are never hit; compressed copies hit
+    // within 1/65535 of the mesh's extent.
+    bool Pick(const glm::vec3& origin, const glm::vec3& direction, ScenePickResult& outResult) const;
+
+    const BVH& GetBVH() const { return m_BVH; }
 
 private:
-    std::vector<std::unique_ptr<Light>> m_Lights;
+    // BVH user data of a light leaf: flag | light handle
+    static constexpr uint32 LIGHT_FLAG = 0x80000000u;
+
+    // Where a handle's light lives: its type's array and index there
+    struct LightSlot {
+        LightType type = LightType::Directional;
+        uint32 index = 0;
+        uint32 proxy = BVH::INVALID_PROXY;  // Leaf of point and spot lights
+        bool used = false;
+    };
+
+    // Lights changed since the last upload that a frame region still lacks, as a range of
+    // the GPU light array
+    struct LightRange {
+        uint32 begin = 0;
+        uint32 end = 0;
+    };
+
+    template<typename T>
+    LightHandle AddLightOfType(std::vector<T>& lights, std::vector<LightHandle>& handles, const T& light);
+    template<typename T>
+    void UpdateLights(std::vector<T>& lights, const std::vector<LightHandle>& handles, uint32 base, bool all);
+    const Light* FindLight(LightHandle light) const;
+    static bool GetLightBounds(const Light& light, AABB& outBounds);
+    static AABB GetInstanceBounds(const MeshInstance& instance);
+
+    std::vector<DirectionalLight> m_DirectionalLights;
+    std::vector<PointLight> m_PointLights;
+    std::vector<SpotLight> m_SpotLights;
+    std::vector<LightHandle> m_DirectionalHandles;  // Parallel to the arrays above
+    std::vector<LightHandle> m_PointHandles;
+    std::vector<LightHandle> m_SpotHandles;
+    std::vector<LightSlot> m_LightSlots;  // Indexed by handle
+    std::vector<LightHandle> m_FreeLightSlots;
+    bool m_LightsMoved = true;  // Added or removed since the last upload, which moves GPU indices
+
+    std::unique_ptr<Model> m_Model;
+    std::vector<MeshInstance> m_Instances;
+    std::vector<uint32> m_FreeInstances;
+    std::vector<uint32> m_RefitInstances;  // UpdateTransforms() scratch
+    std::vector<glm::mat4> m_RefitMatrices;
+    std::vector<glm::vec3> m_RefitMins;
+    std::vector<glm::vec3> m_RefitMaxs;
+    BVH m_BVH;
+    SceneGraph m_SceneGraph;
     Ref<rhi::Buffer> m_LightBuffer;
+    uint8* m_MappedLights = nullptr;  // nullptr when the backend has no persistent mapping
+    uint32 m_LightRegionCount = 1;
+    std::vector<LightData> m_GPULights;  // CPU copy of the GPU light array
+    std::vector<LightRange> m_DirtyLightRanges;  // Per region
     rhi::GraphicsDevice* m_Device = nullptr;
 };
 
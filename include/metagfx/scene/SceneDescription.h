@@ -0,0 +1,96 @@
+// ============================================================================
+// include/metagfx/scene/SceneDescription.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/Light.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+namespace utils {
+class JsonValue;
+}
+
+/**
+ * @brief A scene file: what to place, how to light it and where to look from
+ *
+ * JSON, paths relative to the file:
+ *
+ *   {
+ *     "model": "../models/DamagedHelmet.glb",
+ *     "instances": [{ "translation": [x, y, z], "rotation": [x, y, z], "scale": s }],
+ *     "lights": [{ "type": "directional", "direction": [x, y, z], "color": [r, g, b],
+ *                 "intensity": 5 },
+ *                { "type": "point", "position": [x, y, z], "range": 10, "shadows": true },
+ *                { "type": "spot", "position": [...], "direction": [...], "range": 10,
+ *                  "innerCone": 12.5, "outerCone": 17.5 }],
+ *     "environment": "../hdris/sky.hdr",
+ *     "ground": true,
+ *     "camera": { "position": [x, y, z], "target": [x, y, z], "fov": 45 },
+ *     "cameraPath": [{ "name": "front", "position": [...], "target": [...], "fov": 45 }],
+ *     "cells": [{ "model": "cells/tile_03_07.glb", "min": [x, y, z], "max": [x, y, z] }]
+ *   }
+ *
+ * Every member is optional. Rotations are Euler angles in degrees (yaw about Y, then
+ * pitch about X, then roll about Z) and scales a number or one per axis; no instances
+ * place the model once at the origin. The first directional light is the key light,
+ * which casts the cascaded shadows.
+ *
+ * Cells split a scene too large to load at once (WorldPartition): each is a model file
+ * already in world space, loaded only while the camera is near its bounds, which must
+ * cover it.
+ */
+struct SceneDescription {
+    struct LightDesc {
+        LightType type = LightType::Directional;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+        glm::vec3 color = glm::vec3(1.0f);
+        float intensity = 1.0f;
+        float range = 10.0f;
+        float innerCone = 12.5f;  // Degrees
+        float outerCone = 17.5f;
+        bool castsShadows = false;
+    };
+
+    // A camera placement; without a target the camera looks at the scene's center
+    struct CameraKey {
+        std::string name;
+        glm::vec3 position = glm::vec3(0.0f);
+        glm::vec3 target = glm::vec3(0.0f);
+        bool hasTarget = false;
+        float fov = 45.0f;  // Vertical, in degrees
+    };
+
+    // A world partition cell: its model, placed as the file has it, and the box it fills
+    struct CellDesc {
+        std::string modelPath;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+    };
+
+    std::string filePath;
+    std::string modelPath;                // Empty: the application's default model
+    std::vector<glm::mat4> instances;     // Empty: once, untransformed
+    std::vector<LightDesc> lights;
+    bool hasLights = false;               // "lights" given, even empty: replaces the default rig
+    std::string environmentPath;          // Empty: the application's environment
+    bool ground = true;
+    CameraKey camera;
+    bool hasCamera = false;               // Otherwise the camera frames the model
+    std::vector<CameraKey> cameraPath;    // Benchmark path and batch views, in order
+    std::vector<CellDesc> cells;          // Streamed around the camera, besides the model
+
+    // Reads a scene file; on failure returns false and, when error is given, says why
+    static bool Load(const std::string& path, SceneDescription& out, std::string* error = nullptr);
+
+    // A list of camera placements, as cameraPath; unnamed keys are named prefix_NNNN
+    static bool ParseCameraKeys(const utils::JsonValue& keys, const char* prefix,
+                                std::vector<CameraKey>& out, std::string* error = nullptr);
+};
+
+} // namespace metagfx
@@ -0,0 +1,70 @@
+// ============================================================================
+// include/metagfx/scene/SceneGraph.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief Transform hierarchy stored as parallel arrays
+ *
+ * Node i has a local matrix, a world matrix (parent world * local), a parent index and
+ * first-child / next-sibling links, each in its own contiguous array. Parents always
+ * precede their children, so a node index is also a valid propagation order.
+ *
+ * Changing a local matrix only marks the node; Update() recomputes the world matrices
+ * of marked subtrees and nothing else, so a static hierarchy costs nothing per frame.
+ * Independent subtrees are propagated as JobSystem jobs when there is enough work.
+ */
+class SceneGraph {
+public:
+    static constexpr uint32 INVALID_NODE = ~0u;
+
+    SceneGraph() = default;
+
+    // Append a node; the parent must already exist (or be INVALID_NODE for a root)
+    uint32 AddNode(const glm::mat4& localTransform, uint32 parent = INVALID_NODE);
+    void Clear();
+
+    void SetLocalTransform(uint32 node, const glm::mat4& localTransform);
+
+    /**
+     * @brief Recompute the world matrices of every subtree changed since the last call
+     * @return true if any world matrix changed (listed by GetUpdatedNodes())
+     */
+    bool Update();
+
+    uint32 GetNodeCount() const { return static_cast<uint32>(m_Parent.size()); }
+    uint32 GetParent(uint32 node) const { return m_Parent[node]; }
+    const glm::mat4& GetLocalTransform(uint32 node) const { return m_Local[node]; }
+    const glm::mat4& GetWorldTransform(uint32 node) const { return m_World[node]; }
+    const glm::mat4* GetWorldTransforms() const { return m_World.data(); }
+
+    // Nodes whose world matrix the last Update() rewrote, in no particular order
+    const std::vector<uint32>& GetUpdatedNodes() const { return m_Updated; }
+    bool WasUpdated(uint32 node) const { return m_UpdatedFlags[node] != 0; }
+
+private:
+    // Nodes below which a parallel Update() is not worth the jobs
+    static constexpr uint32 PARALLEL_THRESHOLD = 4096;
+
+    // World matrices of a subtree, appending the nodes it touched
+    void PropagateSubtree(uint32 root, std::vector<uint32>& outUpdated);
+
+    std::vector<glm::mat4> m_Local;
+    std::vector<glm::mat4> m_World;
+    std::vector<uint32> m_Parent;
+    std::vector<uint32> m_FirstChild;
+    std::vector<uint32> m_NextSibling;
+    std::vector<uint8> m_Dirty;          // Local matrix changed since the last Update()
+    std::vector<uint8> m_UpdatedFlags;   // World matrix rewritten by the last Update()
+
+    std::vector<uint32> m_DirtyNodes;    // Marked nodes, possibly nested
+    std::vector<uint32> m_Updated;
+};
+
+} // namespace metagfx
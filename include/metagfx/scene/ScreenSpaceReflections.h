@@ -0,0 +1,132 @@
+// ============================================================================
+// include/metagfx/scene/ScreenSpaceReflections.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/UniformRingBuffer.h"
+#include <glm/glm.hpp>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Screen-space reflections of the deferred path, traced through the depth pyramid
+ *
+ * Trace() runs two passes over the G-buffer pass's depth and G-buffer:
+ * - At half resolution, each texel reflects a ray off its normal, importance sampled
+ *   from its roughness's GGX lobe, and traces it through the min-depth chain of
+ *   GPUCuller's pyramid (hierarchical Z: empty cells are skipped a level up, so a ray
+ *   across the screen takes tens of steps, not hundreds). A hit reads the last frame's
+ *   lit color where the hit point was then, with a confidence that fades out toward the
+ *   screen's edges, the roughness limit and rays hitting back faces.
+ * - At full resolution, each pixel takes the half-resolution texels around it weighed by
+ *   how close their depth is to its own, and with temporal accumulation blends in its
+ *   reprojected history, clamped to the colors around it, where the history's depth
+ *   agrees. The ray samples change every frame then, so the glossy lobe fills in over
+ *   the frames.
+ *
+ * The output, a texture of the frame's render graph of OUTPUT_FORMAT, holds the reflected
+ * radiance and the confidence; DeferredLighting blends it over the prefiltered
+ * environment map by the confidence, so rays that leave the screen or miss fall back
+ * to the probe. CaptureColor() then keeps the lighting pass's lit color at half
+ * resolution for the next frame's trace (GetColorHistory(), which the caller imports
+ * into its graph).
+ *
+ * The pyramid is the one the culling pass tests against, built by the frame right after
+ * the G-buffer pass, so both take one build. The half-resolution texture and the
+ * histories are owned here; SetSources() rebinds the graph's textures when they change,
+ * keeping the replaced sets until no frame in flight uses them.
+ */
+class ScreenSpaceReflections {
+public:
+    static constexpr rhi::Format OUTPUT_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;  // Radiance, confidence
+
+    struct Settings {
+        float maxRoughness = 0.6f;   // Rougher surfaces keep the environment map alone
+        float historyWeight = 0.9f;  // Of the history in the temporal blend
+    };
+
+    // shader runs ssr.comp. Its uniforms are pushed to the ring, which must outlive the
+    // reflections.
+    ScreenSpaceReflections(Ref<rhi::GraphicsDevice> device, rhi::UniformRingBuffer& uniforms, Ref<rhi::Shader> shader);
+    ~ScreenSpaceReflections() = default;
+
+    ScreenSpaceReflections(const ScreenSpaceReflections&) = delete;
+    ScreenSpaceReflections& operator=(const ScreenSpaceReflections&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // The next Trace() starts from the current frame alone and reflects nothing until a
+    // lit color has been captured: after a cut or a new scene
+    void ResetHistory() { m_HistoryValid = false; m_ColorValid = false; }
+
+    // Size of the depth buffer; reallocates the textures owned here when it changes, so
+    // call while the frame's graph is built, before importing GetColorHistory()
+    void Resize(uint32 width, uint32 height);
+    // Half-resolution lit color of the last CaptureColor(), rests as storage
+    const Ref<rhi::Texture>& GetColorHistory() const { return m_ColorHistory; }
+
+    // The frame's depth buffer and G-buffer (DeferredLighting), GPUCuller's pyramid built
+    // from that depth, the lit color of the lighting pass and the output, a storage
+    // texture of OUTPUT_FORMAT the size of the depth; call before Trace()
+    void SetSources(Ref<rhi::Texture> depth, Ref<rhi::Texture> gbuffer, Ref<rhi::Buffer> pyramid,
+                    Ref<rhi::Texture> litColor, Ref<rhi::Texture> output);
+
+    /**
+     * @brief Record the trace and resolve dispatches (outside any render pass)
+     *
+     * Reads the depth, G-buffer, pyramid and color history and writes the output as
+     * storage; the caller orders them against the G-buffer pass, the pyramid build and
+     * the lighting pass (see RenderGraph).
+     * @param view         The camera's view matrix (the G-buffer's normals are in world space)
+     * @param projection   The camera's (jittered) projection the depth was drawn with
+     * @param reprojection This frame's view space to the last frame's
+     * @param minDepthOffset GPUCuller::GetMinDepthOffset() of the pyramid
+     * @param temporal     Accumulate over frames, drawing new ray samples each frame
+     * @param width, height Of the depth drawn, its top-left region (dynamic resolution);
+     *                      0 takes all of it
+     */
+    void Trace(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& view, const glm::mat4& projection,
+               const glm::mat4& reprojection, uint32 minDepthOffset, bool temporal,
+               uint32 width = 0, uint32 height = 0);
+
+    // After the lighting pass: its lit color into the color history, for the next frame's
+    // Trace(). Reads the lit color and writes the history as storage.
+    void CaptureColor(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+private:
+    Ref<rhi::GraphicsDevice> m_Device;
+    rhi::UniformRingBuffer& m_Uniforms;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Sampler> m_LinearSampler;
+    Ref<rhi::Texture> m_HalfResolution;  // Radiance and confidence of the trace
+    Ref<rhi::Texture> m_History[2];      // Radiance, confidence and view depth, packed
+    Ref<rhi::Texture> m_ColorHistory;    // The last frame's lit color, at half resolution
+    // Set i reads history 1 - i and writes history i
+    Ref<rhi::DescriptorSet> m_DescriptorSets[2];
+    Ref<rhi::Texture> m_Depth;
+    Ref<rhi::Texture> m_GBuffer;
+    Ref<rhi::Buffer> m_Pyramid;
+    Ref<rhi::Texture> m_LitColor;
+    Ref<rhi::Texture> m_Output;
+    uint32 m_Current = 0;        // History written by the next Trace()
+    uint32 m_FrameCounter = 0;   // Draws the ray samples under temporal accumulation
+    uint32 m_UniformOffset = 0;  // Of the last Trace(), which CaptureColor() reuses
+    glm::uvec2 m_HistorySize{ 0 };  // Of the region the last Trace() drew
+    bool m_HistoryValid = false;
+    bool m_ColorValid = false;   // The color history holds a lit color
+    Settings m_Settings;
+};
+
+} // namespace metagfx
@@ -0,0 +1,101 @@
+// ============================================================================
+// include/metagfx/scene/ShadingRate.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Shading rate image of the forward main pass, from the last frame's image
+ *
+ * Generate() looks at each tile of DeviceInfo::shadingRateTexelSize pixels of the frame
+ * and marks it for 2x2 shading when either
+ * - its luminance is flat: no step between neighbouring pixels exceeds the contrast
+ *   threshold, relative to the tile's mean (sky, untextured walls), or
+ * - it moves fast: the camera's reprojection of the scene depth, plus the model's own
+ *   motion vectors, carries it further than the motion threshold in one frame, where
+ *   temporal AA blurs the detail anyway
+ * and for full rate otherwise. The next frame's main pass shades by these rates, a frame
+ * behind the image, which the thresholds leave room for.
+ *
+ * The rate image is owned here, sized for the render target by Resize(); it rests
+ * between frames in ResourceState::StorageWrite. Without the device's support
+ * (DeviceInfo::supportsShadingRateImage) IsValid() is false.
+ */
+class ShadingRate {
+public:
+    static constexpr rhi::Format RATE_FORMAT = rhi::Format::R8_UINT;
+
+    struct Settings {
+        float contrastThreshold = 0.08f;  // Largest luminance step of a flat tile, over its mean
+        float motionThreshold = 8.0f;     // Pixels per frame beyond which a tile is fast
+    };
+
+    // shader runs shading_rate.comp
+    ShadingRate(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader);
+    ~ShadingRate() = default;
+
+    ShadingRate(const ShadingRate&) = delete;
+    ShadingRate& operator=(const ShadingRate&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Sizes the rate image for a width x height render target, once a frame before it is
+    // used; a new size drops the rates until the next Generate()
+    void Resize(uint32 width, uint32 height);
+    const Ref<rhi::Texture>& GetRateImage() const { return m_Rates; }
+    // A Generate() wrote the rate image at its current size
+    bool HasRates() const { return m_HasRates; }
+    // Full rate until the next Generate(): after a cut or a new scene
+    void ResetRates() { m_HasRates = false; }
+
+    // The frame's scene color, and with temporal AA its scene depth, the model's motion
+    // vectors and their depth (TemporalAA::SetSources()); null skips the motion. Call
+    // before Generate().
+    void SetSources(Ref<rhi::Texture> sceneColor, Ref<rhi::Texture> sceneDepth = nullptr,
+                    Ref<rhi::Texture> motionVectors = nullptr, Ref<rhi::Texture> motionDepth = nullptr);
+
+    /**
+     * @brief Record the dispatch writing the rate image (outside any render pass)
+     *
+     * Reads the sources and writes the rate image as storage; the caller orders them
+     * against the passes around (see RenderGraph).
+     * @param reprojection This frame's (jittered) NDC to the last frame's clip space, as
+     *                     TemporalAA::Resolve() takes it
+     * @param region       Of the render target drawn, its top-left region (dynamic resolution)
+     * @param colorRegion  Of the scene color, the region standing for the same image: the
+     *                     region, or all of an upscaled scene color
+     */
+    void Generate(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& reprojection,
+                  const glm::uvec2& region, const glm::uvec2& colorRegion);
+
+private:
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Texture> m_Rates;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_Sources[4];  // Scene color, scene depth, motion vectors, motion depth
+    uint32 m_TexelSize = 0;          // Pixels per side of a rate texel
+    uint32 m_Width = 0;              // Of the render target the rate image covers
+    uint32 m_Height = 0;
+    bool m_HasRates = false;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
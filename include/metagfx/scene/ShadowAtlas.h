@@ -0,0 +1,186 @@
+// ============================================================================
+// include/metagfx/scene/ShadowAtlas.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/scene/Scene.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace metagfx {
+
+class Camera;
+
+/**
+ * @brief Shadow maps of point and spot lights, packed as tiles of one depth texture
+ *
+ * Point and spot lights with CastsShadows() that the camera sees get one tile per face:
+ * six 90 degree perspective faces for a point light (+X, -X, +Y, -Y, +Z, -Z), one
+ * frustum around the cone for a spot light. All faces of a light share one power of two
+ * tile size, picked from the light's projected size on screen; the tiles are blocks of
+ * a quadtree allocator, from MAX_TILE_SIZE down to MIN_TILE_SIZE, whose freed siblings
+ * merge back. A tile only shrinks once it is four times too large, so lights hovering
+ * at a size boundary do not keep moving. When the atlas is full, lights out of view and
+ * then the least important visible ones give up their tiles, and what still does not fit
+ * is drawn at a smaller size or unshadowed.
+ *
+ * The texture keeps its contents across frames (the atlas pass loads it). Update()
+ * queues at most the face budget of stale faces, those whose tile is new or whose light
+ * moved, plus every face after Invalidate(), most important first; the rest keep their
+ * last rendering until a later frame. A light is shadowed once all of its faces have
+ * been rendered, each with the matrix it was rendered with.
+ *
+ * The GPU buffer holds one region per frame in flight, in vec4 units: MAX_LIGHTS / 4
+ * vec4s of uint bits mapping a light's index in the frame's light array to the vec4
+ * index of its first face (NO_FACE without shadows), then five vec4s per face, its
+ * world to light clip matrix and its tile rect.
+ */
+class ShadowAtlas {
+public:
+    static constexpr uint32 MAX_TILE_SIZE = 1024;
+    static constexpr uint32 MIN_TILE_SIZE = 128;
+    static constexpr uint32 MAX_FACES = 256;        // Faces in the GPU region
+    static constexpr uint32 NO_FACE = ~0u;          // Must match model.frag and model_bindless.frag
+    static constexpr uint32 FACE_VEC4S = 5;         // Matrix and rect
+
+    // A face queued for rendering: where and from where
+    struct Face {
+        glm::mat4 matrix;               // World to light clip space, Vulkan depth [0, 1]
+        uint32 x = 0;                   // Tile in texels
+        uint32 y = 0;
+        uint32 size = 0;
+        Scene::LightHandle light = Scene::INVALID_LIGHT;
+    };
+
+    // depthFormat as ShadowMap's: the two share their pipelines
+    ShadowAtlas(Ref<rhi::GraphicsDevice> device, uint32 size, uint32 framesInFlight = 2,
+                rhi::Format depthFormat = rhi::Format::D32_SFLOAT);
+    ~ShadowAtlas() = default;
+
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+    bool IsValid() const { return m_DepthTexture && m_Buffer; }
+
+    /**
+     * @brief Pick and size the shadowed lights for a camera, then queue the stale faces
+     *
+     * viewportHeight converts projected sizes to pixels. The queued faces count as
+     * rendered from now on, so the caller must render all of GetRenderQueue() this frame.
+     */
+    void Update(const Scene& scene, const Camera& camera, uint32 viewportHeight);
+
+    // Release every tile, e.g. while the atlas pass is off; lights start over unshadowed
+    void Clear();
+
+    // Mark every rendered face stale, for changes the face matrices do not see: moved
+    // or replaced casters, rebuilt shadow pipelines. They are re-rendered over the
+    // following frames, keeping their old contents meanwhile.
+    void Invalidate() { ++m_Generation; }
+
+    // Write the light map and faces of the shadowed lights into frameIndex's region, with
+    // the light indices of the scene's current GPU light array. Returns the region's first
+    // vec4. The caller must have waited for the GPU to finish the previous use of the slot.
+    uint32 Upload(uint32 frameIndex, const Scene& scene);
+
+    // Of the last Update(): faces to render this frame, most important first. The first
+    // render of the texture must clear all of it: see NeedsFullClear().
+    const std::vector<Face>& GetRenderQueue() const { return m_RenderQueue; }
+    bool NeedsFullClear() const { return !m_Initialized; }
+    void MarkCleared() { m_Initialized = true; }
+
+    // Settings
+    void SetFaceBudget(uint32 faces) { m_FaceBudget = std::max(faces, 1u); }     // Faces rendered per frame
+    void SetQualityScale(float scale) { m_QualityScale = std::max(scale, 0.0f); } // Tile texels per screen pixel
+    uint32 GetFaceBudget() const { return m_FaceBudget; }
+    float GetQualityScale() const { return m_QualityScale; }
+
+    // Statistics of the last Update()
+    uint32 GetShadowedLightCount() const { return static_cast<uint32>(m_Entries.size()); }
+    uint32 GetFaceCount() const { return m_FaceCount; }
+    uint32 GetStaleFaceCount() const { return m_StaleFaces; }   // Still waiting after this frame's queue
+    float GetOccupancy() const { return m_Occupancy; }          // Fraction of the texture in tiles
+
+    uint32 GetSize() const { return m_Size; }
+    const Ref<rhi::Texture>& GetDepthTexture() const { return m_DepthTexture; }
+    const Ref<rhi::Sampler>& GetSampler() const { return m_Sampler; }
+    const Ref<rhi::Buffer>& GetBuffer() const { return m_Buffer; }
+
+private:
+    static constexpr uint32 LEVEL_COUNT = 4;        // MAX_TILE_SIZE >> level, down to MIN_TILE_SIZE
+    static constexpr uint32 MAX_LIGHT_FACES = 6;
+    static constexpr uint32 NO_LEVEL = ~0u;
+
+    struct Tile {
+        uint32 x = 0;
+        uint32 y = 0;
+        uint32 level = NO_LEVEL;
+    };
+
+    // A shadowed light and its faces
+    struct Entry {
+        Scene::LightHandle light = Scene::INVALID_LIGHT;
+        uint32 faceCount = 0;
+        uint32 level = NO_LEVEL;                          // Of every tile
+        Tile tiles[MAX_LIGHT_FACES];
+        glm::mat4 matrices[MAX_LIGHT_FACES];              // Current face matrices
+        glm::mat4 renderedMatrices[MAX_LIGHT_FACES];      // What the tiles hold
+        bool rendered[MAX_LIGHT_FACES] = {};
+        uint64 renderedGeneration[MAX_LIGHT_FACES] = {};
+        float importance = 0.0f;
+        uint64 lastSeen = 0;                              // Update() count
+    };
+
+    // A candidate light of this frame
+    struct Candidate {
+        Scene::LightHandle light = Scene::INVALID_LIGHT;
+        const Light* source = nullptr;
+        float importance = 0.0f;
+        uint32 level = 0;
+    };
+
+    uint32 GetTileSize(uint32 level) const { return MAX_TILE_SIZE >> level; }
+    // Quadtree allocator: a free block of the level, split from a larger one if needed
+    bool AllocateTile(uint32 level, Tile& outTile);
+    void FreeTile(const Tile& tile);
+    // count tiles of one level, or none
+    bool AllocateTiles(uint32 count, uint32 level, Tile* outTiles);
+    // Give an entry tiles of a level, or of a smaller one when the atlas is full
+    void Place(Entry& entry, uint32 level);
+    // Free the tiles of an entry less deserving than importance; false when there is none
+    bool EvictFor(float importance, const Entry* keep);
+    void ReleaseEntry(Entry& entry);
+    // World to light clip matrices of a point or spot light's faces; returns their count
+    static uint32 ComputeFaces(const Light& light, glm::mat4* outMatrices);
+
+    Ref<rhi::Texture> m_DepthTexture;
+    Ref<rhi::Sampler> m_Sampler;  // Comparison sampler for PCF
+    Ref<rhi::Buffer> m_Buffer;
+    glm::vec4* m_MappedData = nullptr;  // nullptr when the backend has no persistent mapping
+    uint32 m_Size = 0;
+    uint32 m_FramesInFlight = 0;
+    bool m_Initialized = false;
+
+    std::vector<Tile> m_FreeTiles[LEVEL_COUNT];
+    std::vector<Entry> m_Entries;
+    std::vector<Candidate> m_Candidates;
+    std::vector<Scene::LightHandle> m_VisibleLights;  // Update() scratch
+    std::vector<Face> m_RenderQueue;
+    std::vector<glm::vec4> m_Region;  // Staging when the buffer is not mapped
+
+    uint32 m_FaceBudget = 6;
+    float m_QualityScale = 1.0f;
+    uint64 m_Generation = 0;
+    uint64 m_UpdateCount = 0;
+
+    uint32 m_FaceCount = 0;
+    uint32 m_StaleFaces = 0;
+    float m_Occupancy = 0.0f;
+};
+
+} // namespace metagfx
@@ -13,38 +13,106 @@
 
 namespace metagfx {
 
-// Shadow map for directional light shadow rendering
-// Creates a depth-only framebuffer and manages light-space transformation matrices
+/**
+ * @brief Cascaded shadow map of the directional key light
+ *
+ * The camera's view range up to the shadow distance is split into up to MAX_CASCADES
+ * slices with the practical split scheme: a blend of logarithmic and uniform splits
+ * weighted by the split lambda. Each cascade is an orthographic light projection fitted
+ * to the bounding sphere of its slice, so its size does not change as the camera turns,
+ * and its origin is snapped to whole shadow map texels so the edges do not shimmer as
+ * the camera moves.
+ *
+ * The cascades are tiles of one depth texture, two by two, each rendered with its own
+ * viewport. Sample a cascade through GetCascadeRect(): light clip-space xy mapped to
+ * [0, 1] lands in the tile at rect.xy + uv * rect.zw.
+ *
+ * The texture keeps its contents across frames, so the shadow pass can be skipped while
+ * nothing it renders changes: UpdateCache() compares a key of the cascades and the
+ * caller's caster hash with the one the map was last rendered for.
+ */
 class ShadowMap {
 public:
-    ShadowMap(Ref<rhi::GraphicsDevice> device, uint32 width, uint32 height);
+    static constexpr uint32 MAX_CASCADES = 4;  // Must match model.frag and model_bindless.frag
+
+    // depthFormat: D32_SFLOAT, or D16_UNORM at half the memory and bandwidth where the
+    // device supports it (DeviceInfo::supportsDepth16)
+    ShadowMap(Ref<rhi::GraphicsDevice> device, uint32 width, uint32 height,
+              rhi::Format depthFormat = rhi::Format::D32_SFLOAT);
     ~ShadowMap();
 
-    // Update light-space transformation matrix for directional light
-    void UpdateLightMatrix(const glm::vec3& lightDir, const Camera& camera);
+    // Refit the cascades to the camera's view range for a light shining along lightDir
+    void UpdateCascades(const glm::vec3& lightDir, const Camera& camera);
+
+    // Cascade settings; they take effect on the next UpdateCascades()
+    void SetCascadeCount(uint32 count);
+    void SetSplitLambda(float lambda) { m_SplitLambda = glm::clamp(lambda, 0.0f, 1.0f); }  // 0 = uniform, 1 = logarithmic
+    void SetShadowDistance(float distance) { m_ShadowDistance = distance; }  // Capped by the camera's far plane
+    uint32 GetCascadeCount() const { return m_CascadeCount; }
+    float GetSplitLambda() const { return m_SplitLambda; }
+    float GetShadowDistance() const { return m_ShadowDistance; }
+
+    // World to light clip space of a cascade, Vulkan depth [0, 1]
+    const glm::mat4& GetCascadeMatrix(uint32 cascade) const { return m_CascadeMatrices[cascade]; }
+    // View depth where a cascade ends; a fragment uses the first cascade whose split is beyond it
+    float GetCascadeSplit(uint32 cascade) const { return m_CascadeSplits[cascade]; }
+    // Tile of a cascade in the texture: xy offset, zw size, in texture coordinates
+    glm::vec4 GetCascadeRect(uint32 cascade) const;
+    // Tile of a cascade in texels, for the viewport of its pass
+    void GetCascadeViewport(uint32 cascade, uint32& outX, uint32& outY, uint32& outWidth, uint32& outHeight) const;
+    // Light clip space enclosing every cascade, to cull the casters of all of them at once
+    const glm::mat4& GetCullMatrix() const { return m_CullMatrix; }
+    // Penumbra width of a cascade in its tile's texture coordinates per unit of light clip
+    // depth between blocker and receiver, for a light of angular radius lightRadius (radians)
+    float GetCascadePenumbraScale(uint32 cascade, float lightRadius) const;
+
+    // Shadow caching. casterHash covers what the caller draws (the caster sets of the
+    // cascades); the cascades are added here. Returns true if the map must be rendered,
+    // and records the key as the map's contents. With caching disabled, always true.
+    bool UpdateCache(uint64 casterHash);
+    // Re-render on the next UpdateCache(), for changes the key does not see: moved or
+    // replaced geometry, rebuilt shadow pipelines
+    void InvalidateCache() { m_CacheValid = false; }
+    void SetCachingEnabled(bool enabled) { m_CachingEnabled = enabled; }
+    bool IsCachingEnabled() const { return m_CachingEnabled; }
 
     // Getters
     uint32 GetWidth() const { return m_Width; }
     uint32 GetHeight() const { return m_Height; }
-    Ref<rhi::Texture> GetDepthTexture() const { return m_DepthTexture; }
-    Ref<rhi::Framebuffer> GetFramebuffer() const { return m_Framebuffer; }
-    Ref<rhi::Sampler> GetSampler() const { return m_Sampler; }
-    const glm::mat4& GetLightSpaceMatrix() const { return m_LightSpaceMatrix; }
+    const Ref<rhi::Texture>& GetDepthTexture() const { return m_DepthTexture; }
+    const Ref<rhi::Framebuffer>& GetFramebuffer() const { return m_Framebuffer; }
+    const Ref<rhi::Sampler>& GetSampler() const { return m_Sampler; }
+    const Ref<rhi::Sampler>& GetDepthSampler() const { return m_DepthSampler; }  // Plain depth reads
 
 private:
+    // Light view and Vulkan-depth ortho projection around a world-space sphere. Casters up
+    // to CASTER_DISTANCE in front of the sphere, towards the light, are kept.
+    glm::mat4 FitSphere(const glm::vec3& lightDir, const glm::vec3& center, float radius) const;
+
     Ref<rhi::GraphicsDevice> m_Device;
 
     // Shadow map resources
     Ref<rhi::Texture> m_DepthTexture;
     Ref<rhi::Framebuffer> m_Framebuffer;
     Ref<rhi::Sampler> m_Sampler;  // Comparison sampler for PCF
+    Ref<rhi::Sampler> m_DepthSampler;  // Nearest, no comparison: PCSS blocker search
 
     // Dimensions
     uint32 m_Width;
     uint32 m_Height;
 
-    // Light-space transformation matrix
-    glm::mat4 m_LightSpaceMatrix;
+    // Cascades
+    uint32 m_CascadeCount = MAX_CASCADES;
+    float m_SplitLambda = 0.75f;
+    float m_ShadowDistance = 60.0f;
+    glm::mat4 m_CascadeMatrices[MAX_CASCADES];
+    float m_CascadeSplits[MAX_CASCADES] = {};
+    glm::mat4 m_CullMatrix;
+
+    // Cache key of the current contents
+    bool m_CachingEnabled = true;
+    bool m_CacheValid = false;
+    uint64 m_CacheKey = 0;
 };
 
 } // namespace metagfx
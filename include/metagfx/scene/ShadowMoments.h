@@ -0,0 +1,80 @@
+// ============================================================================
+// include/metagfx/scene/ShadowMoments.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class ShadowMap;
+
+/**
+ * @brief Exponential variance shadow map (EVSM) of the cascaded shadow map
+ *
+ * Build() warps the shadow map's depth d (in [-1, 1]) into the moments
+ * (e^(c d), e^(2c d), -e^(-c d), e^(-2c d)) at half its resolution, then box-blurs them
+ * with two separable passes that stay inside each cascade's tile. Blurred moments filter
+ * like colour, so a lookup is one bilinear tap however wide the blur; the cost moves to
+ * Build(), which runs only when the shadow map was re-rendered. RGBA16F limits the
+ * exponent c to EXPONENT.
+ *
+ * The moments follow the shadow map: Invalidate() after rendering it, and Build() before
+ * sampling while IsCurrent() is false.
+ */
+class ShadowMoments {
+public:
+    static constexpr float EXPONENT = 5.54f;  // Largest whose squares fit RGBA16F; must match model.frag
+    static constexpr uint32 MAX_BLUR_RADIUS = 8;
+
+    // shader runs shadow_evsm.comp
+    ShadowMoments(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, const ShadowMap& shadowMap);
+    ~ShadowMoments() = default;
+
+    ShadowMoments(const ShadowMoments&) = delete;
+    ShadowMoments& operator=(const ShadowMoments&) = delete;
+
+    bool IsValid() const { return m_Pipeline && m_Moments && m_Scratch; }
+
+    /**
+     * @brief Record the warp and blur dispatches (outside any render pass)
+     *
+     * Reads the shadow map's depth and writes the moments as storage; the caller orders
+     * them against the shadow pass and the passes sampling the moments (see RenderGraph).
+     */
+    void Build(rhi::CommandBuffer& cmd, uint32 frameIndex);
+    void Invalidate() { m_Current = false; }
+    bool IsCurrent() const { return m_Current; }
+
+    // Blur half-width in moment texels, 0 to MAX_BLUR_RADIUS; 0 only warps
+    void SetBlurRadius(uint32 radius);
+    uint32 GetBlurRadius() const { return m_BlurRadius; }
+
+    const Ref<rhi::Texture>& GetTexture() const { return m_Moments; }
+    const Ref<rhi::Sampler>& GetSampler() const { return m_Sampler; }  // Bilinear, clamped
+
+private:
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Texture> m_Moments;  // Result
+    Ref<rhi::Texture> m_Scratch;  // Between the horizontal and the vertical blur
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Sampler> m_Sampler;
+    // Source and destination of each pass: depth -> moments, moments -> scratch, scratch -> moments
+    Ref<rhi::DescriptorSet> m_PassDescriptorSets[3];
+
+    uint32 m_Width = 0;
+    uint32 m_Height = 0;
+    uint32 m_TileSize = 0;  // Cascade tiles in moment texels
+    uint32 m_BlurRadius = 2;
+    bool m_Current = false;
+};
+
+} // namespace metagfx
@@ -0,0 +1,96 @@
+// ============================================================================
+// include/metagfx/scene/Skinning.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class Animator;
+class Model;
+
+/**
+ * @brief Compute pre-pass posing a model's deformed meshes on the GPU once per frame
+ *
+ * SetModel() uploads the bind pose, skin and morph targets of each of the model's
+ * deformed meshes (Model::GetDeformedMeshes()) to buffers of their own. Apply() copies
+ * the Animator's joint palettes and morph weights to the frame's host-visible buffer and
+ * runs skinning.comp, one thread per vertex: the morph targets by their weights, then
+ * the four joints by theirs, positions, normals and tangents alike.
+ *
+ * The posed vertices go over the mesh's range of the model's GeometryPool, in its vertex
+ * buffer and position stream, so every pass drawing the pool afterwards (shadows, depth
+ * prepass, main and G-buffer passes, the per-frame shadow draw list) sees the pose
+ * without a pass of its own knowing about skinning; the bind pose is never lost, as each
+ * frame starts again from the uploaded copy. The pool must be deformable and Float
+ * (Model forces both for models with deformed meshes).
+ */
+class Skinning {
+public:
+    static constexpr uint32 GROUP_SIZE = 64;  // Must match skinning.comp
+
+    // shader runs skinning.comp. One palette buffer per frame in flight.
+    Skinning(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, uint32 framesInFlight);
+    ~Skinning() = default;
+
+    Skinning(const Skinning&) = delete;
+    Skinning& operator=(const Skinning&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    // Upload the model's deformed meshes; false, with nothing to apply, when it has none or
+    // its pool cannot be written. Null clears. Retires the last model's buffers.
+    bool SetModel(const Model* model);
+    bool HasWork() const { return !m_Dispatches.empty(); }
+    uint32 GetVertexCount() const { return m_VertexCount; }
+
+    /**
+     * @brief Record the frame's skinning dispatches (outside any render pass)
+     *
+     * Waits for earlier reads of the pool's vertex buffer and position stream, writes them
+     * as storage and makes them visible to vertex fetch and shader reads after.
+     * @param animator Posed for the model given to SetModel()
+     */
+    void Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const Animator& animator);
+
+private:
+    // One deformed mesh
+    struct Dispatch {
+        uint32 deformedMesh;      // Model::GetDeformedMeshes() index
+        uint32 sourceVertex;      // Of its bind pose and skin in the uploaded buffers
+        uint32 vertexCount;
+        uint32 targetVertex;      // Of its range in the pool
+        uint32 jointCount;        // 0 without a skin
+        uint32 paletteOffset;     // Float of the frame data its palette starts at
+        uint32 morphTargetCount;
+        uint32 morphOffset;       // MorphTargetDelta its first target starts at
+        uint32 weightOffset;      // Float of the frame data its weights start at
+    };
+
+    void Release();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    uint32 m_FramesInFlight = 1;
+
+    Ref<rhi::Buffer> m_BindPose;      // Vertex (Float layout) of every deformed mesh
+    Ref<rhi::Buffer> m_SkinVertices;  // SkinVertex, parallel to the bind pose
+    Ref<rhi::Buffer> m_MorphDeltas;   // MorphTargetDelta
+    std::vector<Ref<rhi::Buffer>> m_FrameData;  // Palettes and weights, per frame in flight
+    std::vector<Ref<rhi::DescriptorSet>> m_DescriptorSets;
+    Ref<rhi::Buffer> m_VertexBuffer;    // The pool's
+    Ref<rhi::Buffer> m_PositionBuffer;  // The pool's, null without a position stream
+    std::vector<Dispatch> m_Dispatches;
+    std::vector<float> m_Staging;       // Of the frame data
+    uint32 m_VertexCount = 0;
+};
+
+} // namespace metagfx
@@ -0,0 +1,135 @@
+// ============================================================================
+// include/metagfx/scene/StreamEncoder.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/StreamProtocol.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/ReadbackPool.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/VideoEncoder.h"
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief The frame's final image, compressed to H.264 by the platform's hardware encoder
+ * where it has one, for streaming it out
+ *
+ * Encode() runs stream_encode.comp over the back buffer, which writes BT.709 luma and
+ * half-resolution chroma into a storage buffer a quarter of the size of the RGBA
+ * pixels, and ReadBack() copies that buffer out in the same frame (ReadbackPool). Once
+ * the GPU has finished the frame, a frame or two later and without stalling it, the
+ * NV12 planes go to the hardware H.264 encoder (VideoEncoder: VideoToolbox on Apple),
+ * which takes them as they are, and the frame callback receives the compressed frame.
+ * SetFormat(NV12), or a platform without a hardware encoder, sends the raw planes instead:
+ * the explicit fallback, at some 30 times the default bitrate at 720p.
+ *
+ * The back buffer rotates between a few images: a descriptor set is kept for each
+ * until the size changes.
+ */
+class StreamEncoder {
+public:
+    struct Frame {
+        uint64 frameNumber = 0;   // Counts the frames encoded, from 1
+        uint64 encodeTimeNs = 0;  // Profiler::Now() when Encode() was recorded
+        uint32 width = 0;
+        uint32 height = 0;
+        uint32 pitch = 0;         // Bytes per row of both planes; 0 for H.264
+        stream::PixelFormat format = stream::PixelFormat::NV12;
+        bool keyFrame = true;     // H.264: an IDR picture the frames after it predict from
+        // NV12: pitch x height (rounded up to 2) luma bytes, then half as many of Cb Cr
+        // pairs. H.264: an Annex B access unit.
+        std::vector<uint8> data;
+    };
+    using FrameCallback = std::function<void(Frame&& frame)>;
+
+    // shader runs stream_encode.comp; videoSettings are the H.264 encoder's, whose size
+    // comes from the back buffer
+    StreamEncoder(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader,
+                  const VideoEncoder::Settings& videoSettings = {});
+    ~StreamEncoder() = default;
+
+    StreamEncoder(const StreamEncoder&) = delete;
+    StreamEncoder& operator=(const StreamEncoder&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    // Called with each frame: raw NV12 from BeginFrame(), on its thread, and H.264 from
+    // the video encoder's thread. Set it before the first frame.
+    void SetFrameCallback(FrameCallback callback) { m_FrameCallback = std::move(callback); }
+
+    // The format of the frames from the next read back on: H.264 falls back to NV12
+    // where the platform has no hardware encoder for the size (GetFormat() tells), and
+    // starts with a key frame
+    void SetFormat(stream::PixelFormat format);
+    stream::PixelFormat GetFormat() const {
+        return m_VideoEncoder ? stream::PixelFormat::H264 : stream::PixelFormat::NV12;
+    }
+    // The next H.264 frame is a key frame: for a client that joined or lost frames
+    void RequestKeyFrame() { m_KeyFrameRequested = true; }
+
+    /**
+     * @brief Bind the frame's back buffer, sizing the output for it
+     *
+     * Call before the frame's graph imports GetOutput(). The back buffer needs
+     * TextureUsage::Sampled, which offscreen swap chains have.
+     */
+    void SetSource(const Ref<rhi::Texture>& backBuffer);
+    const Ref<rhi::Buffer>& GetOutput() const { return m_Output; }
+
+    // Record the conversion, outside any render pass: the source in ShaderRead, the
+    // output in StorageWrite
+    void Encode(rhi::CommandBuffer& cmd, uint32 frameIndex);
+    // Copy the output, in TransferRead, out of the frame
+    void ReadBack(rhi::CommandBuffer& cmd);
+
+    // Call after GraphicsDevice::BeginFrame(): hands the frames the GPU has finished to
+    // the video encoder, or as NV12 to the frame callback
+    void BeginFrame();
+
+    // Bytes of a frame of this size
+    static uint64 GetFrameSize(uint32 width, uint32 height);
+
+private:
+    void CreateVideoEncoder();
+
+    struct SourceBinding {
+        Ref<rhi::Texture> texture;
+        Ref<rhi::DescriptorSet> descriptorSet;
+    };
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Buffer> m_Output;
+    std::vector<SourceBinding> m_Sources;  // One per back buffer seen at this size
+    uint32 m_SourceIndex = 0;              // This frame's, when m_Sources has it
+    std::unique_ptr<rhi::ReadbackPool> m_Readback;
+    FrameCallback m_FrameCallback;
+
+    // With SetFormat(H264), of the current size; destroyed first, since the packets it
+    // has in flight still go to the frame callback
+    VideoEncoder::Settings m_VideoSettings;
+    stream::PixelFormat m_Format = stream::PixelFormat::NV12;
+    bool m_VideoUnavailable = false;  // No hardware encoder takes the current size
+    std::atomic<bool> m_KeyFrameRequested{ true };
+    std::unique_ptr<VideoEncoder> m_VideoEncoder;
+
+    uint32 m_Width = 0;
+    uint32 m_Height = 0;
+    uint64 m_FrameNumber = 0;    // Of the last Encode()
+    uint64 m_EncodeTimeNs = 0;
+};
+
+} // namespace metagfx
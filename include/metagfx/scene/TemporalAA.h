@@ -0,0 +1,137 @@
+// ============================================================================
+// include/metagfx/scene/TemporalAA.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/TemporalUpscaler.h"
+#include "metagfx/rhi/Texture.h"
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Temporal anti-aliasing of the HDR scene color, before bloom and tone mapping
+ *
+ * The camera's projection moves by a sub-pixel jitter every frame (GetJitter(), through
+ * Camera::SetJitter()), so successive frames sample each pixel at different points.
+ * Resolve() reprojects the accumulated history onto the current frame, clips it to the
+ * color range of each pixel's neighbourhood, blends the current frame in, and writes a
+ * sharpened copy back into the scene color.
+ *
+ * The reprojection covers the camera's motion through the scene depth; the model's own
+ * motion comes from a motion vector texture that holds, where the model is the visible
+ * surface, how far it moved in the last frame's texture coordinates (motion_vectors.vert
+ * with TransformBuffer::GetPreviousBuffer()).
+ *
+ * It also upscales: given an output texture larger than the scene color, the history is
+ * kept at the output's size and each output pixel gathers the current frame's samples
+ * around it, weighed by their distance once the jitter is taken out, in the manner of
+ * FSR 2. Over GetJitterPhases() frames every output pixel gets samples close to it.
+ * Where the device has a temporal upscaler of its own (DeviceInfo::supportsTemporalUpscaler,
+ * MetalFX on Metal) and a motion shader is given, the upscaling goes to it instead: a
+ * compute pass turns the depth and motion vectors into the full motion of each pixel,
+ * which the platform's upscaler takes with the jitter. Its own history replaces the two
+ * here, and the compute resolve stays the fallback for textures it cannot take.
+ *
+ * The two history textures are owned here and alternate every frame. ResetHistory()
+ * drops their contents for the next frame, as does a change of size.
+ */
+class TemporalAA {
+public:
+    static constexpr rhi::Format MOTION_VECTOR_FORMAT = rhi::Format::R16G16_SFLOAT;
+    static constexpr rhi::Format HISTORY_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;
+    static constexpr uint32 JITTER_PHASES = 8;  // Frames before the jitter repeats
+
+    struct Settings {
+        float currentWeight = 0.1f;  // Of the current frame in the history; lower is smoother
+        float sharpness = 0.25f;     // Of the sharpening pass, 0 to 1
+    };
+
+    static constexpr rhi::Format MOTION_FORMAT = rhi::Format::R16G16_SFLOAT;  // Of the full motion
+
+    // shader runs taa.comp; motionShader, taa_motion.comp, lets upscaling use the device's
+    // temporal upscaler
+    TemporalAA(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, Ref<rhi::Shader> motionShader = nullptr);
+    ~TemporalAA() = default;
+
+    TemporalAA(const TemporalAA&) = delete;
+    TemporalAA& operator=(const TemporalAA&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Offset of the projection for frame, in NDC: the Halton (2, 3) sequence over phases
+    // frames, within one pixel of a width x height target (the scene color's)
+    static glm::vec2 GetJitter(uint64 frame, uint32 width, uint32 height, uint32 phases = JITTER_PHASES);
+
+    // Of a scene color rendered upscale times smaller than a width x height output, and
+    // its jitter phases: enough for each output pixel to see samples near it
+    static glm::uvec2 GetInputSize(uint32 width, uint32 height, float upscale);
+    static uint32 GetJitterPhases(float upscale);
+
+    // The next Resolve() starts from the current frame alone: after a cut or a new scene
+    void ResetHistory() { m_HistoryValid = false; }
+
+    // Usages the output needs beyond storage: those the device's temporal upscaler writes
+    // it with, when it may take over the upscaling
+    rhi::TextureUsage GetOutputUsage() const;
+    bool UsesTemporalUpscaler() const { return m_Upscaler != nullptr; }
+
+    // The frame's textures; call before Resolve(). sceneColor is a storage texture,
+    // motionVectors of MOTION_VECTOR_FORMAT with motionDepth its depth buffer, all of one
+    // size. output, a storage texture of HISTORY_FORMAT with GetOutputUsage(), is where
+    // the result goes when it upscales; null writes it back into the scene color.
+    void SetSources(Ref<rhi::Texture> sceneColor, Ref<rhi::Texture> sceneDepth,
+                    Ref<rhi::Texture> motionVectors, Ref<rhi::Texture> motionDepth,
+                    Ref<rhi::Texture> output = nullptr);
+
+    /**
+     * @brief Record the resolve and sharpening dispatches (outside any render pass)
+     *
+     * Reads the depths and motion vectors, and reads and writes the scene color (and the
+     * output) as storage; the caller orders them against the passes around (see RenderGraph).
+     * @param reprojection The last frame's unjittered view-projection times the inverse
+     *                     of this frame's jittered one
+     * @param jitter       This frame's GetJitter(), which upscaling takes out of the samples
+     * @param inputSize    Of the scene color drawn, its top-left region (dynamic resolution,
+     *                     which needs an output); 0 takes all of it
+     */
+    void Resolve(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& reprojection,
+                 const glm::vec2& jitter, const glm::uvec2& inputSize = glm::uvec2(0));
+
+private:
+    void Resize(uint32 width, uint32 height);
+    // The device's upscaler for the sources, or none; false if it cannot have one
+    bool CreateUpscaler();
+    void ReleaseUpscaler();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Sampler> m_LinearSampler;
+    Ref<rhi::Texture> m_History[2];
+    // Set i reads history 1 - i and writes history i
+    Ref<rhi::DescriptorSet> m_DescriptorSets[2];
+    Ref<rhi::Texture> m_Sources[5];  // Scene color, scene depth, motion vectors, motion depth, output
+    uint32 m_Current = 0;            // History written by the next Resolve()
+
+    // With the device's temporal upscaler
+    Ref<rhi::Pipeline> m_MotionPipeline;
+    Ref<rhi::DescriptorSet> m_MotionDescriptorSet;
+    Ref<rhi::Texture> m_Motion;  // MOTION_FORMAT, of the scene color's size
+    Ref<rhi::TemporalUpscaler> m_Upscaler;
+    bool m_HistoryValid = false;
+    Settings m_Settings;
+};
+
+} // namespace metagfx
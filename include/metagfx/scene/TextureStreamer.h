@@ -0,0 +1,137 @@
+// ============================================================================
+// include/metagfx/scene/TextureStreamer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/utils/TextureUtils.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+
+class Material;
+class Model;
+class Scene;
+
+/**
+ * @brief Larger mips of a model's material textures, read on demand under a memory budget
+ *
+ * A model loaded with ModelImportSettings::textureStreamingExtent holds its KTX2 and DDS
+ * textures only from the mips that fit the extent (Model::GetStreamableTextures()).
+ * Update() estimates how many texels each of them needs from the meshes using it: the
+ * pixels the mesh's bounding sphere spans on screen, as if the texture covered the mesh
+ * once. A texture needing more than it holds is read again from its file, on the job
+ * system, down from the mip that covers the need, and once loaded it replaces the
+ * smaller texture in the model's materials.
+ *
+ * The streamed textures are kept within a budget: the settings' own, or a fraction of
+ * what GraphicsDevice::GetMemoryBudget() leaves free. A load that would exceed it evicts
+ * the textures least recently seen on screen, back to their loaded mips; one that still
+ * does not fit is dropped and tried again later. Everything here runs on the device's
+ * thread; replaced textures are released frames-in-flight frames later.
+ *
+ * This is whole-texture residency: the RHI has no sparse textures, so a larger mip
+ * chain is a new texture rather than pages bound into the old one.
+ */
+class TextureStreamer {
+public:
+    // Budget when neither the settings nor the device give one
+    static constexpr uint64 FALLBACK_BUDGET_BYTES = 256ull * 1024 * 1024;
+
+    struct Settings {
+        uint64 budgetBytes = 0;           // Of streamed textures; 0: from the device's memory budget
+        float deviceBudgetFraction = 0.5f;  // Of the device's free budget (plus the streamed textures)
+        float texelsPerPixel = 1.0f;      // Texels wanted across a mesh per pixel it spans
+        uint32 maxLoadsInFlight = 2;      // File reads on the job system at once
+        uint32 retryFrames = 60;          // Before a load dropped for the budget is tried again
+    };
+
+    struct Stats {
+        uint32 textureCount = 0;   // Streamable textures of the model
+        uint32 streamedCount = 0;  // Holding more mips than they were loaded with
+        uint32 loadsInFlight = 0;
+        uint64 streamedBytes = 0;
+        uint64 budgetBytes = 0;
+        uint64 loads = 0;          // Since the model was set
+        uint64 evictions = 0;
+    };
+
+    explicit TextureStreamer(Ref<rhi::GraphicsDevice> device);
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Stream the model's textures (null stops). Waits for the loads of the previous
+    // model, which keeps the textures its materials hold.
+    void SetModel(Model* model);
+
+    /**
+     * @brief Take finished loads into the materials and start the loads this frame needs
+     * @param modelMatrix    Applied on top of the instances' transforms
+     * @param viewProjection Camera's; instances outside its frustum need nothing
+     * @param projection     Camera projection; a perspective one divides by the distance
+     * @param eye            World-space camera position
+     * @param viewportHeight Pixels the projection spans vertically
+     * @return Whether some material's textures changed; the caller rebuilds what binds them
+     */
+    bool Update(const Scene& scene, const glm::mat4& modelMatrix, const glm::mat4& viewProjection,
+                const glm::mat4& projection, const glm::vec3& eye, float viewportHeight);
+
+    const Stats& GetStats() const { return m_Stats; }
+
+private:
+    struct Entry {
+        Ref<rhi::Texture> base;      // As the model loaded it
+        Ref<rhi::Texture> streamed;  // Larger mips read since, or null
+        std::string path;
+        std::vector<Material*> materials;  // Holding base or streamed
+        uint64 streamedBytes = 0;
+        uint32 fullExtent = 0;       // Of the file's level 0 once read; 0 until then
+        uint32 wantedExtent = 0;     // This frame's need, in texels per side
+        uint64 lastSeenFrame = 0;
+        uint64 retryFrame = 0;       // No load before this frame
+        bool loading = false;
+    };
+
+    // One file read on the job system
+    struct Load {
+        uint32 entry = 0;
+        uint32 maxExtent = 0;
+        std::string path;
+        utils::TextureMipChain chain;
+        bool loaded = false;
+        JobCounter done;
+    };
+
+    uint64 ComputeBudget() const;
+    uint32 GetResidentExtent(const Entry& entry) const;
+    // Point the entry's materials at texture (streamed, or base when null)
+    void Replace(Entry& entry, Ref<rhi::Texture> texture, uint64 bytes);
+    // Evict the least recently seen textures not seen this frame until bytes more fit
+    bool MakeRoom(uint64 bytes, uint64 budget, const Entry* keep);
+    bool FinishLoads(uint64 budget);
+    void StartLoads();
+    void WaitForLoads();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Settings m_Settings;
+    Stats m_Stats;
+    const Model* m_Model = nullptr;
+    std::vector<Entry> m_Entries;
+    std::unordered_map<const Material*, std::vector<uint32>> m_MaterialEntries;
+    std::vector<std::unique_ptr<Load>> m_Loads;
+    uint64 m_Frame = 0;
+};
+
+} // namespace metagfx
@@ -0,0 +1,78 @@
+// ============================================================================
+// include/metagfx/scene/ToneMapper.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/Sampler.h"
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+// Curve from the exposed scene color to the back buffer's [0, 1]
+enum class ToneMapOperator : uint32 {
+    Clamp,  // What the lit shaders did before the HDR target
+    ACES    // Filmic curve; highlights roll off instead of clipping
+};
+
+/**
+ * @brief The frame's HDR scene color to the back buffer: exposure, tone mapping, gamma
+ *
+ * With a tone mapper the main pass renders linear, unexposed color into a
+ * SCENE_COLOR_FORMAT texture of the render graph (the lit pipelines specialized with
+ * HDR_OUTPUT), and Apply() draws one triangle over the back buffer that exposes, tone
+ * maps and gamma corrects it. That costs one shader invocation per pixel whatever the
+ * scene's overdraw, and leaves the linear color for post-processing between the two.
+ * With autoExposure the exposure is AutoExposure's, measured on the GPU, and the
+ * settings' exposure compensates it.
+ *
+ * The scene color is a texture of the frame's render graph: SetSource() rebinds it when
+ * it changes, keeping the replaced set until no frame in flight uses it.
+ */
+class ToneMapper {
+public:
+    static constexpr rhi::Format SCENE_COLOR_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;
+
+    // Push constants of tonemap.frag
+    struct Settings {
+        float exposure = 1.0f;  // Multiplies the measured exposure with autoExposure
+        ToneMapOperator toneMapOperator = ToneMapOperator::Clamp;
+        bool autoExposure = false;  // Read the exposure buffer given to SetSource()
+    };
+
+    // vertexShader runs fullscreen.vert, fragmentShader tonemap.frag
+    ToneMapper(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader, Ref<rhi::Shader> fragmentShader);
+    ~ToneMapper() = default;
+
+    ToneMapper(const ToneMapper&) = delete;
+    ToneMapper& operator=(const ToneMapper&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    // The frame's scene color and AutoExposure's exposure buffer (null when the frame
+    // has none); call before Apply()
+    void SetSource(Ref<rhi::Texture> sceneColor, Ref<rhi::Buffer> exposureBuffer = nullptr);
+
+    // Inside a render pass over the back buffer, without depth: one triangle over the
+    // viewport, reading the scene color pixel for pixel
+    void Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const Settings& settings);
+
+private:
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::Buffer> m_DefaultExposure;  // Bound without an exposure buffer: exposure 1
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_SceneColor;
+    Ref<rhi::Buffer> m_ExposureBuffer;
+};
+
+} // namespace metagfx
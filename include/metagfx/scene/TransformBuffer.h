@@ -0,0 +1,96 @@
+// ============================================================================
+// include/metagfx/scene/TransformBuffer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/scene/SceneGraph.h"
+#include <glm/glm.hpp>
+#include <functional>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief One node of the TransformBuffer, std430 (the shaders' NodeTransform)
+ *
+ * The normal matrix is the inverse transpose of the world matrix's upper 3x3, stored
+ * as three vec4 columns (GLSL mat3x4) so vertex shaders read it instead of inverting
+ * per vertex.
+ */
+struct NodeTransform {
+    glm::mat4 world = glm::mat4(1.0f);
+    glm::mat3x4 normal = glm::mat3x4(1.0f);
+};
+static_assert(sizeof(NodeTransform) == 112, "NodeTransform must match the std430 layout");
+
+/**
+ * @brief GPU copy of a SceneGraph's world matrices, one NodeTransform per node
+ *
+ * A device-local storage buffer that vertex shaders index with the node InstanceBuffer
+ * holds for gl_InstanceIndex, so a single draw selects its node through firstInstance. Each frame only the matrices the graph's
+ * last Update() rewrote are staged (in a per-frame-in-flight staging buffer) and copied,
+ * coalesced into contiguous ranges; a frame with no changes records nothing.
+ *
+ * Matrices are stored in a basis B as B^-1 * world * B. With B = the model's
+ * dequantization matrix D and D already folded into the model matrix M (as the
+ * Compact vertex format does), M * D * (D^-1 * W * D) = M * W * D. Nodes left at the
+ * identity stay the identity in any basis. The normal matrix is of the stored matrix,
+ * which for the uniform scale of D equals the world one.
+ *
+ * GetPreviousBuffer() holds the matrices of the upload before, for motion vectors: the
+ * nodes changed by this upload or the one before are copied there from a CPU mirror of
+ * the current buffer, so a node at rest costs nothing after its second frame.
+ */
+class TransformBuffer {
+public:
+    TransformBuffer(Ref<rhi::GraphicsDevice> device, uint32 capacity, uint32 framesInFlight = 2);
+    ~TransformBuffer() = default;
+
+    TransformBuffer(const TransformBuffer&) = delete;
+    TransformBuffer& operator=(const TransformBuffer&) = delete;
+
+    bool IsValid() const { return m_Buffer != nullptr; }
+    const Ref<rhi::Buffer>& GetBuffer() const { return m_Buffer; }
+    const Ref<rhi::Buffer>& GetPreviousBuffer() const { return m_PreviousBuffer; }
+    uint32 GetCapacity() const { return m_Capacity; }
+
+    // Make the next Upload() copy every node
+    void Invalidate() { m_Invalid = true; }
+
+    /**
+     * @brief Record the copy of the matrices changed by graph.Update(), outside any pass
+     *
+     * Call once after every Update(). Nodes past the capacity are not uploaded (logged
+     * once). Changing the basis uploads every node. Returns the number of matrices copied
+     * to the current buffer.
+     */
+    uint32 Upload(rhi::CommandBuffer& cmd, uint32 frameIndex, const SceneGraph& graph,
+                  const glm::mat4& basis = glm::mat4(1.0f));
+
+private:
+    // Stage transform(node) for each of nodes at stagingBase + its offset, and copy the runs
+    void CopyRuns(rhi::CommandBuffer& cmd, const Ref<rhi::Buffer>& staging, uint64 stagingBase,
+                  const Ref<rhi::Buffer>& dst, const std::vector<uint32>& nodes,
+                  const std::function<NodeTransform(uint32)>& transform);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Buffer> m_Buffer;
+    Ref<rhi::Buffer> m_PreviousBuffer;
+    std::vector<Ref<rhi::Buffer>> m_Staging;  // One per frame in flight: current, then previous
+    uint32 m_Capacity = 0;
+
+    glm::mat4 m_Basis = glm::mat4(1.0f);
+    bool m_Invalid = true;
+    bool m_OverflowReported = false;
+
+    std::vector<NodeTransform> m_Uploaded;  // Contents of m_Buffer
+    std::vector<uint32> m_LastNodes;     // Nodes copied by the last upload, sorted
+
+    std::vector<uint32> m_Nodes;         // Upload scratch, sorted
+    std::vector<uint32> m_PreviousNodes;
+    std::vector<NodeTransform> m_Transforms;
+};
+
+} // namespace metagfx
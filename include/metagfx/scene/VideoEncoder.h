@@ -0,0 +1,66 @@
+// ============================================================================
+// include/metagfx/scene/VideoEncoder.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief The platform's hardware H.264 encoder, fed StreamEncoder's NV12 frames
+ *
+ * Apple: a VideoToolbox compression session that requires the hardware encoder, set up
+ * for real time: no frame reordering, so each frame comes out before the next goes in,
+ * and a key frame only every keyFrameInterval frames or on request. Other platforms
+ * have none (CreateH264() returns null), and the stream stays raw NV12.
+ *
+ * Encode() returns before the frame is compressed; the packet callback receives it on
+ * the encoder's own thread.
+ */
+class VideoEncoder {
+public:
+    struct Settings {
+        uint32 width = 0;              // Of the image
+        uint32 height = 0;
+        uint32 frameRate = 60;         // Expected; rate control spreads the bitrate over it
+        uint32 bitrateKbps = 20000;    // Average
+        uint32 keyFrameInterval = 240; // Frames between key frames, besides requested ones
+    };
+
+    // An Annex B access unit, key frames with their parameter sets before them
+    struct Packet {
+        uint64 frameNumber = 0;
+        uint64 encodeTimeNs = 0;
+        bool keyFrame = false;
+        std::vector<uint8> data;
+    };
+    using PacketCallback = std::function<void(Packet&& packet)>;
+
+    // Null where the platform has no hardware encoder, or it refuses settings
+    static std::unique_ptr<VideoEncoder> CreateH264(const Settings& settings, PacketCallback callback);
+
+    // Waits for the frames being compressed, whose packets still reach the callback
+    virtual ~VideoEncoder() = default;
+
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Queue a frame of StreamEncoder's layout: pitch x height (rounded up to 2) luma
+    // bytes, then half as many of Cb Cr pairs. keyFrame forces an IDR picture. False
+    // if the encoder could not take it.
+    virtual bool Encode(const uint8* nv12, uint32 pitch, uint64 frameNumber, uint64 encodeTimeNs,
+                        bool keyFrame) = 0;
+
+protected:
+    explicit VideoEncoder(const Settings& settings) : m_Settings(settings) {}
+
+    Settings m_Settings;
+};
+
+} // namespace metagfx
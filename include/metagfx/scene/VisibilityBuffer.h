@@ -0,0 +1,113 @@
+// ============================================================================
+// include/metagfx/scene/VisibilityBuffer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+class GPUCuller;
+class Material;
+class Model;
+
+/**
+ * @brief Visibility buffer: triangle ids rasterized, materials resolved in compute
+ *
+ * The visibility pass (visibility.vert and visibility.frag, drawn through the culler's
+ * visibility commands) writes one VISIBILITY_FORMAT id per pixel: the triangle's cluster
+ * (GPUCuller::CLUSTER_TRIANGLES) above its index in the cluster, plus one, so the pass's
+ * clear to EMPTY marks where nothing was drawn. Its fragments only test alpha masks, so
+ * overdraw costs next to nothing.
+ *
+ * Resolve() then shades each covered pixel once, in visibility_resolve.comp: the pixels
+ * are counted per material, the counts scanned, and the pixels scattered into one run per
+ * material, so the threads of a group mostly run one material's branches and textures.
+ * Each thread fetches its triangle again from the geometry pool, interpolates its
+ * attributes with perspective-correct barycentrics and their screen derivatives (for
+ * the textures' gradients), and writes the texel gbuffer.frag would have written. The
+ * deferred lighting then runs unchanged.
+ *
+ * Needs bindless textures, a pooled model culled by GPUCuller, and
+ * DeviceInfo::supportsDrawIndirectFirstInstance and supportsPrimitiveId for the pass.
+ */
+class VisibilityBuffer {
+public:
+    static constexpr rhi::Format VISIBILITY_FORMAT = rhi::Format::R32_UINT;
+    static constexpr uint32 EMPTY = 0;        // The pass's clear value
+    static constexpr uint32 GROUP_SIZE = 64;  // Must match visibility_resolve.comp
+    // Resolve groups per row of its indirect dispatch; must match visibility_resolve.comp
+    static constexpr uint32 RESOLVE_GROUPS_X = 4096;
+
+    // resolveShader runs visibility_resolve.comp. sceneBindings are the main pass's set:
+    // the resolve reads its frame constants and node transforms at the same binding
+    // numbers. textureCapacity is the size of the bindless texture table.
+    VisibilityBuffer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> resolveShader,
+                     const std::vector<rhi::DescriptorBindingDesc>& sceneBindings, uint32 textureCapacity);
+    ~VisibilityBuffer() = default;
+
+    VisibilityBuffer(const VisibilityBuffer&) = delete;
+    VisibilityBuffer& operator=(const VisibilityBuffer&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+    // The materials, geometry and targets are set: Resolve() has something to shade
+    bool IsReady() const { return m_DescriptorSet != nullptr; }
+
+    // Replace a buffer of the scene bindings, as the main pass's set did
+    void SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer);
+
+    // The bindless material table: its buffer and the textures its indices name, as
+    // written to the main pass's table
+    void SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                      Ref<rhi::Sampler> sampler);
+    // The model's meshes, drawn from its geometry pool with the table's materialIndices,
+    // and culler's records for it (after GPUCuller::SetModel())
+    void SetGeometry(const Model& model, const GPUCuller& culler,
+                     const std::unordered_map<const Material*, uint32>& materialIndices);
+
+    // The visibility pass's target (VISIBILITY_FORMAT) and the G-buffer of the same size
+    // (DeferredLighting::GBUFFER_FORMAT) Resolve() writes; a change recreates the set
+    void SetTargets(Ref<rhi::Texture> visibility, Ref<rhi::Texture> gbuffer);
+
+    /**
+     * @brief Record the resolve of the visibility target into the G-buffer (outside any render pass)
+     *
+     * Reads the visibility target as a sampled texture and writes the G-buffer as
+     * storage; the caller orders them against the pass before and the lighting after.
+     * @param modelUniformOffset Binding 0 of the scene bindings: the frame constants the
+     *        model was drawn with, whose model matrix carries a compact mesh's dequantization
+     */
+    void Resolve(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 modelUniformOffset);
+
+private:
+    void SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler);
+    void CreateDescriptorSet();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    std::vector<rhi::DescriptorBindingDesc> m_Bindings;  // Scene bindings, then the resolve's own
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    uint32 m_TextureCapacity = 0;
+
+    std::vector<Ref<rhi::Texture>> m_Textures;  // Of the table; the set's elements past them are cleared
+    uint32 m_WrittenTextures = 0;                // Elements of the set's table written
+    Ref<rhi::Sampler> m_TextureSampler;
+    uint32 m_MaterialCount = 0;  // Bins of the material counters
+    Ref<rhi::Buffer> m_MaterialBins;
+    Ref<rhi::Buffer> m_Pixels;
+    uint32 m_PixelCapacity = 0;
+    Ref<rhi::Texture> m_Visibility;
+    Ref<rhi::Texture> m_GBuffer;
+};
+
+} // namespace metagfx
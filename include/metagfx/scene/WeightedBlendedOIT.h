@@ -0,0 +1,69 @@
+// ============================================================================
+// include/metagfx/scene/WeightedBlendedOIT.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Composite of weighted blended order-independent transparency (McGuire and Bavoil)
+ *
+ * The blended materials are drawn twice over the scene's depth, tested but not written,
+ * in any order:
+ * - into an ACCUMULATION_FORMAT target cleared to zero, adding up each fragment's
+ *   premultiplied color and alpha scaled by a weight that falls off with its distance
+ * - into a REVEALAGE_FORMAT target cleared to one, multiplying in one minus each
+ *   fragment's alpha: how much of the surface behind still shows
+ * The second draw stops after the alpha, so it costs little more than a depth pass; the
+ * two are separate passes because the backends begin passes with one color attachment.
+ *
+ * Composite() then blends the average color over the scene color by one minus the
+ * revealage. Where transparent surfaces overlap the average is an approximation, exact
+ * for one layer and close for similar ones, but nothing needs sorting, so dense stacks
+ * of glass or foliage cost their fragments alone.
+ *
+ * Both targets are textures of the frame's render graph: SetSources() rebinds them when
+ * they change, keeping the replaced set until no frame in flight uses it.
+ */
+class WeightedBlendedOIT {
+public:
+    static constexpr rhi::Format ACCUMULATION_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;
+    static constexpr rhi::Format REVEALAGE_FORMAT = rhi::Format::R16_SFLOAT;
+
+    // The composite shaders are fullscreen.vert and oit_composite.frag; sceneColorFormat
+    // is the composite's target
+    WeightedBlendedOIT(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader,
+                       Ref<rhi::Shader> fragmentShader, rhi::Format sceneColorFormat);
+    ~WeightedBlendedOIT() = default;
+
+    WeightedBlendedOIT(const WeightedBlendedOIT&) = delete;
+    WeightedBlendedOIT& operator=(const WeightedBlendedOIT&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    // The frame's accumulation and revealage, of the scene color's size; call before Composite()
+    void SetSources(Ref<rhi::Texture> accumulation, Ref<rhi::Texture> revealage);
+
+    // Inside a render pass over the scene color, loaded, without depth: one triangle over
+    // the viewport. Pixels without transparent fragments are not written.
+    void Composite(rhi::CommandBuffer& cmd, uint32 frameIndex);
+
+private:
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Sampler> m_PointSampler;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_Accumulation;
+    Ref<rhi::Texture> m_Revealage;
+};
+
+} // namespace metagfx
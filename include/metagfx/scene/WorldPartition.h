@@ -0,0 +1,140 @@
+// ============================================================================
+// include/metagfx/scene/WorldPartition.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/scene/SceneDescription.h"
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+namespace utils {
+class TextureCache;
+}
+
+/**
+ * @brief Spatial cells of a scene too large to hold at once, resident around the camera
+ *
+ * Each cell is a model file of its own, in world space, with bounds the scene file gives
+ * (SceneDescription::cells), so where a cell is is known before it loads. Its geometry
+ * maps from its mesh cache and its textures come through the shared TextureCache, so a
+ * cell loaded again, or textures shared by several cells, cost neither Assimp nor a decode.
+ *
+ * Update() loads, through Model::LoadFromFileAsync, the cells within loadDistance of the
+ * camera, nearest first, and at a lower priority those within loadDistance of where the
+ * camera will be prefetchSeconds ahead at its current velocity. Up to maxLoadsInFlight
+ * cells import at once, each on its own thread; their uploads take from the frame's
+ * ModelUploadBudget. Cells past unloadDistance from both are unloaded, and their loads
+ * still in flight cancelled.
+ *
+ * The resident cells are kept within a budget: the settings' own, or a fraction of what
+ * GraphicsDevice::GetMemoryBudget() leaves free. A cell that finishes loading over it
+ * unloads the resident cells farther away than itself; one that still does not fit is
+ * dropped and tried again later, so memory stays bounded however large the scene.
+ * Everything here runs on the device's thread; unloaded models are released
+ * frames-in-flight frames later.
+ */
+class WorldPartition {
+public:
+    // Budget when neither the settings nor the device give one
+    static constexpr uint64 FALLBACK_BUDGET_BYTES = 1024ull * 1024 * 1024;
+
+    struct Settings {
+        float loadDistance = 100.0f;        // From the camera to a cell's bounds
+        float unloadDistance = 125.0f;      // Past loadDistance, so a cell at the edge does not flip
+        float prefetchSeconds = 2.0f;       // Of camera motion ahead; 0: no prefetch
+        uint64 budgetBytes = 0;             // Of resident cells; 0: from the device's memory budget
+        float deviceBudgetFraction = 0.5f;  // Of the device's free budget (plus the resident cells)
+        uint32 maxLoadsInFlight = 0;        // Imports at once; 0: one per JobSystem worker
+        uint32 retryFrames = 60;            // Before a cell dropped for the budget is tried again
+    };
+
+    struct Stats {
+        uint32 cellCount = 0;
+        uint32 residentCount = 0;
+        uint32 loadsInFlight = 0;
+        uint32 failedCount = 0;      // Cells whose model cannot be loaded, never tried again
+        uint64 residentBytes = 0;
+        uint64 budgetBytes = 0;
+        uint64 loads = 0;            // Since the cells were set
+        uint64 unloads = 0;
+        glm::vec3 velocity = glm::vec3(0.0f);  // Camera's, smoothed, that prefetching follows
+    };
+
+    enum class CellState {
+        Unloaded,
+        Loading,    // Its load in flight, or being cancelled
+        Resident,
+        Failed
+    };
+
+    struct Cell {
+        std::string modelPath;
+        glm::vec3 boundsMin = glm::vec3(0.0f);
+        glm::vec3 boundsMax = glm::vec3(0.0f);
+        CellState state = CellState::Unloaded;
+        std::unique_ptr<Model> model;     // While resident
+        Ref<ModelLoadHandle> load;        // While loading
+        uint64 bytes = 0;                 // Estimated device memory of the model, while resident
+        float distance = 0.0f;            // This update's, from the camera to the bounds
+        float priority = 0.0f;            // Lower loads first; the distance, or past loadDistance when prefetched
+        bool wanted = false;              // Within loadDistance now or prefetchSeconds ahead
+        uint64 retryFrame = 0;            // No load before this update
+    };
+
+    WorldPartition(Ref<rhi::GraphicsDevice> device, utils::TextureCache* textureCache,
+                   const ModelImportSettings& importSettings);
+    ~WorldPartition();
+
+    WorldPartition(const WorldPartition&) = delete;
+    WorldPartition& operator=(const WorldPartition&) = delete;
+
+    void SetSettings(const Settings& settings) { m_Settings = settings; }
+    const Settings& GetSettings() const { return m_Settings; }
+
+    // Replace the cells; the previous ones are unloaded
+    void SetCells(const std::vector<SceneDescription::CellDesc>& cells);
+    void Clear();
+
+    /**
+     * @brief Take finished loads in and start and cancel loads for the camera's position
+     * @param eye World-space camera position; its motion between calls gives the velocity
+     * @param uploads This frame's, shared with the other loads advanced in it; nullptr: each
+     *                load in flight gets a budget of its own
+     * @return Whether a cell became resident or was unloaded; the caller rebuilds what draws them
+     */
+    bool Update(const glm::vec3& eye, ModelUploadBudget* uploads = nullptr);
+
+    const std::vector<Cell>& GetCells() const { return m_Cells; }
+    const Stats& GetStats() const { return m_Stats; }
+
+    // Device memory of a model's buffers and textures, each counted once
+    static uint64 EstimateModelBytes(const Model& model);
+
+private:
+    uint64 ComputeBudget() const;
+    // Unload resident cells of a larger priority value, farthest first, until bytes more fit
+    bool MakeRoom(uint64 bytes, uint64 budget, float priority);
+    void Unload(Cell& cell);
+    bool FinishLoads(uint64 budget, ModelUploadBudget* uploads);
+    void StartLoads(uint64 budget);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    utils::TextureCache* m_TextureCache = nullptr;
+    ModelImportSettings m_ImportSettings;
+    Settings m_Settings;
+    Stats m_Stats;
+    std::vector<Cell> m_Cells;
+    std::vector<uint32> m_Order;  // StartLoads() scratch
+    glm::vec3 m_LastEye = glm::vec3(0.0f);
+    uint64 m_LastUpdateNs = 0;    // 0: no position yet
+    uint64 m_Frame = 0;
+};
+
+} // namespace metagfx
@@ -0,0 +1,142 @@
+// ============================================================================
+// include/metagfx/utils/AssetArchive.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace metagfx {
+namespace utils {
+
+class AsyncFile;
+class MappedFile;
+
+// ============================================================================
+// File format (little-endian), written by tools/asset_pack:
+//
+//   AssetArchiveHeader
+//   Entry data: each stored entry, and each chunk of a compressed one, starts on a
+//               multiple of the header's alignment, so it can be read with direct I/O
+//   Table of contents, at tocOffset: AssetArchiveEntry[entryCount],
+//               AssetArchiveChunk[chunkCount], then the entry paths (not terminated)
+// ============================================================================
+
+constexpr uint32 ASSET_ARCHIVE_MAGIC = 0x4B50474D;  // "MGPK"
+constexpr uint32 ASSET_ARCHIVE_VERSION = 1;
+
+enum class ArchiveCompression : uint32 {
+    None = 0,  // Stored as is, in one range; served straight from the mapping
+    Zstd = 1   // Independently compressed chunks of chunkSize bytes
+};
+
+struct AssetArchiveHeader {
+    uint32 magic = ASSET_ARCHIVE_MAGIC;
+    uint32 version = ASSET_ARCHIVE_VERSION;
+    uint32 entryCount = 0;
+    uint32 chunkCount = 0;
+    uint64 tocOffset = 0;
+    uint64 tocSize = 0;
+    uint32 chunkSize = 0;  // Uncompressed bytes per chunk; an entry's last chunk may be shorter
+    uint32 alignment = 0;
+};
+
+struct AssetArchiveEntry {
+    uint64 pathOffset = 0;  // Into the path block
+    uint64 offset = 0;      // Stored entries: their data
+    uint64 size = 0;        // Uncompressed
+    uint64 hash = 0;        // TextureCache::HashBytes of the contents
+    uint32 pathLength = 0;  // Relative to the packed directory, '/'-separated
+    uint32 compression = 0; // ArchiveCompression
+    uint32 firstChunk = 0;  // Compressed entries: their chunks, in order
+    uint32 chunkCount = 0;
+};
+
+struct AssetArchiveChunk {
+    uint64 offset = 0;
+    uint32 storedSize = 0;  // Equal to the chunk's size when it did not compress and is stored raw
+    uint32 reserved = 0;
+};
+
+static_assert(sizeof(AssetArchiveHeader) == 40, "AssetArchiveHeader layout");
+static_assert(sizeof(AssetArchiveEntry) == 48, "AssetArchiveEntry layout");
+static_assert(sizeof(AssetArchiveChunk) == 16, "AssetArchiveChunk layout");
+
+/**
+ * @brief A pak of asset files behind one file handle and one mapping
+ *
+ * Opening an archive maps it and reads its table of contents; entries are never opened
+ * on their own, which is what deployments on network file systems pay for per loose
+ * file. Stored entries are views of the mapping. The chunks of compressed ones are read
+ * with AsyncFileReader (io_uring on Linux), each decompressed by a job as soon as it
+ * lands, straight into the caller's memory, which may be mapped staging memory; Zstd
+ * entries need a build with METAGFX_USE_BASISU or a system libzstd.
+ *
+ * Mounted archives are searched, in mount order, before the file system by
+ * MappedFile::Open() and with it by every loader that maps its files (DDS/KTX2, stb
+ * images, glTF and its buffers, mesh caches, Assimp imports). Thread-safe once open.
+ */
+class AssetArchive {
+public:
+    struct EntryInfo {
+        uint64 size = 0;
+        uint64 hash = 0;
+        ArchiveCompression compression = ArchiveCompression::None;
+    };
+
+    AssetArchive() = default;
+    ~AssetArchive();
+
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    // Maps the archive and checks its table of contents; on failure says why when asked
+    bool Open(const std::string& filepath, std::string* error = nullptr);
+
+    const std::string& GetPath() const { return m_Path; }
+    uint32 GetEntryCount() const { return static_cast<uint32>(m_Index.size()); }
+
+    // Entry paths are as packed: relative, '/'-separated, no "." or ".." components
+    bool Find(const std::string& entryPath, EntryInfo* out = nullptr) const;
+
+    // Copies or decompresses the entry into dst, which must hold its size
+    bool Read(const std::string& entryPath, void* dst, uint64 dstSize) const;
+
+    // Stored entries become views of the archive's mapping (no copy); compressed ones
+    // are decompressed into memory the MappedFile owns
+    bool OpenEntry(const std::string& entryPath, MappedFile& out) const;
+
+    // Mounts an archive under mountPoint (relative to the working directory, "" for the
+    // working directory itself), so that <mountPoint>/<entry path> opens the entry
+    static bool Mount(const std::string& filepath, const std::string& mountPoint = "");
+    static void UnmountAll();
+    static bool HasMounts();
+
+    // Look a file path up in the mounted archives
+    static bool FindMounted(const std::string& filepath, EntryInfo* out = nullptr);
+    static bool OpenMounted(const std::string& filepath, MappedFile& out);
+
+    // Lexically normal, '/'-separated, relative to the working directory when under it
+    static std::string NormalizePath(const std::string& path);
+
+private:
+    const AssetArchiveEntry* FindEntry(const std::string& entryPath) const;
+    bool ReadEntry(const AssetArchiveEntry& entry, uint8* dst) const;
+    bool DecodeChunk(const AssetArchiveEntry& entry, uint32 chunk, const uint8* src, uint8* dst) const;
+
+    // The archive and entry path a file path resolves to, or null
+    static std::shared_ptr<const AssetArchive> ResolveMounted(const std::string& filepath, std::string& entryPath);
+
+    std::string m_Path;
+    std::shared_ptr<const MappedFile> m_File;
+    std::unique_ptr<AsyncFile> m_Reads;  // The archive on disk; null when it is itself packed
+    AssetArchiveHeader m_Header;
+    const AssetArchiveEntry* m_Entries = nullptr;  // In the mapping
+    const AssetArchiveChunk* m_Chunks = nullptr;
+    std::unordered_map<std::string, uint32> m_Index;
+};
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,79 @@
+// ============================================================================
+// include/metagfx/utils/AsyncFileReader.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <functional>
+#include <string>
+
+namespace metagfx {
+
+class JobCounter;
+
+namespace utils {
+
+// A file on disk opened for positional reads, which may run concurrently. Asset
+// archives are not searched: this is the file the archive itself lies in.
+class AsyncFile {
+public:
+    AsyncFile() = default;
+    ~AsyncFile();
+
+    AsyncFile(const AsyncFile&) = delete;
+    AsyncFile& operator=(const AsyncFile&) = delete;
+
+    bool Open(const std::string& filepath);
+    void Close();
+
+    bool IsOpen() const;
+    uint64 GetSize() const { return m_Size; }
+
+    // Blocking; false on errors and short reads
+    bool ReadAt(uint64 offset, void* dst, uint64 size) const;
+
+private:
+    friend class AsyncFileReader;
+
+#ifdef _WIN32
+    void* m_Handle = nullptr;
+#else
+    int m_Handle = -1;
+#endif
+    uint64 m_Size = 0;
+};
+
+// Runs as a job once the read has landed. data lives in the reader's buffer until the
+// callback returns; it is null when the read failed.
+using FileReadCallback = std::function<void(const uint8* data, uint64 size)>;
+
+/**
+ * @brief Asynchronous file reads whose completions feed jobs directly
+ *
+ * On Linux, reads go through an io_uring of QUEUE_DEPTH entries into registered staging
+ * buffers (IORING_OP_READ_FIXED). A completion thread reaps them and hands each landed
+ * read to the job system, so decoding starts as soon as its bytes arrive while the
+ * device keeps a deep queue. Reads beyond the queue depth, or with every buffer still
+ * held by its callback, wait in a queue of their own; Read() never blocks.
+ *
+ * Elsewhere, and where io_uring is unavailable (kernels before 5.1, sandboxes that
+ * filter it), each read is a job doing a blocking positional read.
+ *
+ * Reads larger than BUFFER_SIZE get a buffer of their own. Thread-safe.
+ */
+class AsyncFileReader {
+public:
+    static constexpr uint32 QUEUE_DEPTH = 32;
+    static constexpr uint64 BUFFER_SIZE = 256 * 1024;  // A default AssetArchive chunk
+
+    // Queues a read of size bytes at offset. The callback holds counter up until it
+    // returns; file must stay open until then.
+    static void Read(const AsyncFile& file, uint64 offset, uint64 size, FileReadCallback callback,
+                     JobCounter* counter = nullptr);
+
+    // Whether reads go through io_uring; sets the backend up on first use
+    static bool UsesIoUring();
+};
+
+} // namespace utils
+} // namespace metagfx
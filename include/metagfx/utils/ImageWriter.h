@@ -0,0 +1,36 @@
+// ============================================================================
+// include/metagfx/utils/ImageWriter.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+// Images read back from the GPU, as encoded by the writers below: rows rowPitch bytes
+// apart, alpha ignored (render targets' alpha is not coverage)
+struct ImageView {
+    const uint8* data = nullptr;
+    uint32 width = 0;
+    uint32 height = 0;
+    uint32 rowPitch = 0;
+};
+
+// 8-bit RGB PNG of RGBA8 texels, or BGRA8 with swapRedBlue, taken as already sRGB
+// encoded. Each row gets the PNG filter with the smallest residuals, then one
+// fixed-Huffman deflate block with greedy LZ77 matching: a fraction of zlib's speed cost
+// for most of its ratio on rendered images.
+std::vector<uint8> EncodePNG(const ImageView& image, bool swapRedBlue);
+
+// OpenEXR of RGBA16F texels (linear), as half-float R, G and B channels in uncompressed
+// scanlines, the layout every EXR reader takes
+std::vector<uint8> EncodeEXR(const ImageView& image);
+
+// Writes bytes to path, replacing it; false on failure
+bool WriteFileBytes(const std::string& path, const std::vector<uint8>& bytes);
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,64 @@
+// ============================================================================
+// include/metagfx/utils/Json.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+// Minimal read-only JSON DOM (RFC 8259) for asset metadata such as glTF.
+// Lookups never fail: a missing key or index yields a Null value, so optional
+// fields read as `value["key"].AsNumber(defaultValue)`.
+class JsonValue {
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    using Member = std::pair<std::string, JsonValue>;
+
+    // Parse a complete document. On failure returns false and, when error is given,
+    // describes the problem and its byte offset.
+    static bool Parse(const char* text, size_t length, JsonValue& out, std::string* error = nullptr);
+
+    Type GetType() const { return m_Type; }
+    bool IsNull() const { return m_Type == Type::Null; }
+    bool IsBool() const { return m_Type == Type::Bool; }
+    bool IsNumber() const { return m_Type == Type::Number; }
+    bool IsString() const { return m_Type == Type::String; }
+    bool IsArray() const { return m_Type == Type::Array; }
+    bool IsObject() const { return m_Type == Type::Object; }
+
+    bool AsBool(bool fallback = false) const { return IsBool() ? m_Bool : fallback; }
+    double AsNumber(double fallback = 0.0) const { return IsNumber() ? m_Number : fallback; }
+    float AsFloat(float fallback = 0.0f) const { return IsNumber() ? static_cast<float>(m_Number) : fallback; }
+    int64 AsInt(int64 fallback = 0) const { return IsNumber() ? static_cast<int64>(m_Number) : fallback; }
+    const std::string& AsString() const;  // Empty unless a string
+
+    // Elements of an array or members of an object; 0 otherwise
+    size_t Size() const;
+
+    const JsonValue& operator[](size_t index) const;           // Array element
+    const JsonValue& operator[](std::string_view key) const;   // Object member
+    bool Has(std::string_view key) const;
+
+    const std::vector<JsonValue>& GetArray() const { return m_Array; }
+    const std::vector<Member>& GetMembers() const { return m_Members; }
+
+private:
+    friend class JsonParser;
+
+    Type m_Type = Type::Null;
+    bool m_Bool = false;
+    double m_Number = 0.0;
+    std::string m_String;
+    std::vector<JsonValue> m_Array;
+    std::vector<Member> m_Members;
+};
+
+} // namespace utils
+} // namespace metagfx
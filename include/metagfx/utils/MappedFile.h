@@ -0,0 +1,67 @@
+// ============================================================================
+// include/metagfx/utils/MappedFile.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+// Read-only memory mapping of a whole file. Pages are faulted in on first access, so
+// opening is cheap and data that is never touched is never read from disk.
+//
+// Files in a mounted AssetArchive open from it instead: stored entries are views of the
+// archive's mapping, compressed ones are decompressed into memory the MappedFile owns.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    // Returns false when the file cannot be opened or mapped (empty files included)
+    bool Open(const std::string& filepath);
+    void Close();
+
+    bool IsOpen() const { return m_Data != nullptr; }
+    const uint8* GetData() const { return m_Data; }
+    uint64 GetSize() const { return m_Size; }
+
+    // File the data lies in, at GetSourceOffset(): the file itself, or the archive of a
+    // stored entry. Empty for decompressed entries, whose data is on disk nowhere.
+    const std::string& GetSourcePath() const { return m_SourcePath; }
+    uint64 GetSourceOffset() const { return m_SourceOffset; }
+
+    // Asks the OS to start reading the range in the background, so a later copy out of
+    // it does not wait on disk page by page. A hint; clamped to the file.
+    void Prefetch(uint64 offset, uint64 size) const;
+
+private:
+    friend class AssetArchive;
+
+    // The OS mapping of a file on disk
+    bool Map(const std::string& filepath);
+    void Unmap();
+    void PrefetchMapped(uint64 offset, uint64 size) const;
+
+    const uint8* m_Data = nullptr;
+    uint64 m_Size = 0;
+    std::string m_SourcePath;
+    uint64 m_SourceOffset = 0;
+    std::shared_ptr<const MappedFile> m_Archive;  // Stored archive entries: the mapping m_Data points into
+    std::vector<uint8> m_Buffer;                  // Compressed archive entries: their decompressed data
+#ifdef _WIN32
+    void* m_FileHandle = nullptr;
+    void* m_MappingHandle = nullptr;
+#endif
+};
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,78 @@
+// ============================================================================
+// include/metagfx/utils/ShaderWatcher.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Types.h"
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+// Shader hot reload: polls GLSL sources and the files they #include for modification and
+// recompiles changed ones to SPIR-V as JobSystem jobs, running the offline compiler the
+// build uses (glslc or glslangValidator). The owner takes finished compiles with
+// TakeResults() at a frame boundary and rebuilds its pipelines from them.
+//
+// A file saved again while it compiles is compiled once more after that compile
+// finishes. Failed compiles return the compiler output and no code.
+class ShaderWatcher {
+public:
+    static constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+    struct Result {
+        std::string name;          // File name relative to the source directory
+        bool success = false;
+        std::vector<uint8> spirv;
+        std::string log;           // Compiler output
+    };
+
+    // Watches sourceDirectory/name for every name; starts from the files' current state
+    ShaderWatcher(const std::string& sourceDirectory, const std::string& compiler,
+                  const std::vector<std::string>& names);
+    ~ShaderWatcher();  // Waits for compiles in flight
+
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // Checks modification times, at most once per POLL_INTERVAL, and starts compiles
+    // of the files that changed
+    void Poll();
+
+    // Compiles finished since the last call
+    std::vector<Result> TakeResults();
+
+    // Also watches sourceDirectory/source and compiles it with the macro define set,
+    // delivering the results as name (metagfx_add_shaders() VARIANTS). Before the first
+    // Poll() only.
+    void AddVariant(const std::string& name, const std::string& source, const std::string& define);
+
+private:
+    struct WatchedFile {
+        std::string name;
+        std::string source;  // Relative to the source directory; name but for variants
+        std::string define;  // Variants only
+        std::filesystem::file_time_type writeTime;
+        bool compiling = false;  // Guarded by m_Mutex
+    };
+
+    void Compile(size_t fileIndex);
+
+    std::string m_SourceDirectory;
+    std::string m_Compiler;
+    std::string m_TempDirectory;
+    std::vector<WatchedFile> m_Files;
+    std::chrono::steady_clock::time_point m_LastPoll;
+
+    std::mutex m_Mutex;
+    std::vector<Result> m_Results;
+    JobCounter m_Jobs;
+};
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,46 @@
+// ============================================================================
+// include/metagfx/utils/SphericalHarmonics.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+#include <string>
+
+namespace metagfx {
+namespace utils {
+
+constexpr uint32 SH_COEFFICIENT_COUNT = 9;  // Bands 0 to 2
+
+// Radiance projected onto the L2 spherical harmonics basis, one sample at a time
+struct RadianceSH {
+    glm::vec3 coefficients[SH_COEFFICIENT_COUNT] = {};
+
+    // Radiance arriving from a unit direction over solidAngle steradians
+    void Add(const glm::vec3& direction, const glm::vec3& radiance, float solidAngle);
+    RadianceSH& operator+=(const RadianceSH& other);
+};
+
+// Diffuse irradiance of an environment as nine RGB coefficients, with the cosine lobe
+// convolution and the basis constants folded in: the irradiance at a unit normal n is
+//     c0 + c1 n.y + c2 n.z + c3 n.x + c4 n.x n.y + c5 n.y n.z + c6 (3 n.z^2 - 1)
+//        + c7 n.x n.z + c8 (n.x^2 - n.y^2)
+// Laid out as binding 8 of the lit shaders reads it (IrradianceSHUBO, std140 vec4s).
+//
+// File format (ibl_precompute's irradiance_sh.txt): UTF-8 text, one coefficient per
+// line as "r g b", in order. Empty lines and lines starting with '#' are ignored.
+struct IrradianceSH {
+    glm::vec4 coefficients[SH_COEFFICIENT_COUNT] = {};
+
+    static IrradianceSH FromRadiance(const RadianceSH& radiance);
+
+    // Never negative; the clamp hides the ringing of very bright, small lights
+    glm::vec3 Evaluate(const glm::vec3& normal) const;
+
+    // Returns false when the file does not exist or does not hold nine coefficients
+    bool Load(const std::string& filepath);
+    bool Save(const std::string& filepath) const;
+};
+
+} // namespace utils
+} // namespace metagfx
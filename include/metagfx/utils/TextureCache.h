@@ -0,0 +1,111 @@
+// ============================================================================
+// include/metagfx/utils/TextureCache.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Texture.h"
+#include <functional>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace metagfx {
+namespace utils {
+
+// Identifies one decoded + uploaded texture. The source alone is not enough: a
+// reloaded model may have changed on disk, and one image cooks to different formats
+// for sRGB and linear material slots.
+struct TextureCacheKey {
+    std::string source;      // Absolute file path, or "<model path>*N" for embedded textures
+    uint64 contentHash = 0;  // TextureCache::HashBytes of the encoded source data
+    rhi::Format format = rhi::Format::Undefined;  // Format the caller asked for
+
+    bool operator==(const TextureCacheKey& other) const {
+        return contentHash == other.contentHash && format == other.format && source == other.source;
+    }
+};
+
+struct TextureCacheKeyHash {
+    size_t operator()(const TextureCacheKey& key) const;
+};
+
+struct TextureCacheStats {
+    uint32 entryCount = 0;
+    uint32 entriesInUse = 0;   // Still referenced outside the cache
+    uint64 bytes = 0;          // Estimated GPU memory of all cached textures
+    uint64 budgetBytes = 0;
+    uint64 hits = 0;
+    uint64 misses = 0;
+    uint64 evictions = 0;
+};
+
+// Device-wide cache of textures created from files, shared across materials and model
+// reloads so a texture referenced N times is decoded and uploaded once.
+//
+// Entries are reference-counted through their Ref<rhi::Texture>: an entry is in use
+// while anything outside the cache (a material) holds it. When the estimated memory
+// of all entries exceeds the budget, unused entries are evicted, least recently used
+// first. In-use entries are never evicted - dropping them would not free anything.
+//
+// The owner must destroy (or Clear()) the cache before the device. Thread-safe; the
+// create callback runs without the lock held.
+class TextureCache {
+public:
+    static constexpr uint64 DEFAULT_BUDGET_BYTES = 512ull * 1024 * 1024;
+
+    explicit TextureCache(uint64 budgetBytes = DEFAULT_BUDGET_BYTES);
+    ~TextureCache() = default;
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Return the cached texture for the key, or call create() and cache its result.
+    // Returns nullptr (and caches nothing) when create() fails.
+    Ref<rhi::Texture> Acquire(const TextureCacheKey& key, const std::function<Ref<rhi::Texture>()>& create);
+
+    // Cached texture for the key, or nullptr; never creates (safe from decode threads)
+    Ref<rhi::Texture> Find(const TextureCacheKey& key);
+
+    // Evict unused entries until the cache fits its budget
+    void Trim();
+
+    // Drop every entry (textures still referenced elsewhere stay alive)
+    void Clear();
+
+    void SetBudget(uint64 budgetBytes);
+    uint64 GetBudget() const;
+
+    TextureCacheStats GetStats() const;
+    void LogStats() const;
+
+    // Fast 64-bit hash of encoded texture data (not cryptographic)
+    static uint64 HashBytes(const void* data, uint64 size);
+
+    // GPU memory of a texture's mip chain (one layer), from its format and extent
+    static uint64 EstimateSize(const rhi::Texture& texture);
+
+private:
+    struct Entry {
+        Ref<rhi::Texture> texture;
+        uint64 bytes = 0;
+        std::list<TextureCacheKey>::iterator lruPosition;
+    };
+
+    void TrimLocked();
+
+    std::unordered_map<TextureCacheKey, Entry, TextureCacheKeyHash> m_Entries;
+    std::list<TextureCacheKey> m_LRU;  // Most recently used first
+    uint64 m_Bytes = 0;
+    uint64 m_BudgetBytes = 0;
+
+    uint64 m_Hits = 0;
+    uint64 m_Misses = 0;
+    uint64 m_Evictions = 0;
+
+    mutable std::mutex m_Mutex;
+};
+
+} // namespace utils
+} // namespace metagfx
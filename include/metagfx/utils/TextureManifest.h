@@ -0,0 +1,51 @@
+// ============================================================================
+// include/metagfx/utils/TextureManifest.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <string>
+#include <unordered_map>
+
+namespace metagfx {
+namespace utils {
+
+// Extension appended to a model's file name for its cooked texture manifest,
+// e.g. "DamagedHelmet.glb" -> "DamagedHelmet.glb.texcook"
+constexpr const char* TEXTURE_MANIFEST_EXTENSION = ".texcook";
+
+// Maps a model's texture references to files produced by tools/texture_cook.
+// Sources are keyed exactly as the material references them (relative path, or "*N"
+// for embedded textures) plus the color space the slot wants, since the same image
+// cooks to different formats for sRGB and linear slots. Cooked paths are relative to
+// the manifest's directory.
+//
+// File format: UTF-8 text, one entry per line, tab-separated:
+//     <srgb|linear> <source> <cooked file>
+// Empty lines and lines starting with '#' are ignored.
+class TextureManifest {
+public:
+    // Manifest path for a model file
+    static std::string GetPathForModel(const std::string& modelPath);
+
+    // Returns false when the file does not exist or cannot be read
+    bool Load(const std::string& filepath);
+    bool Save(const std::string& filepath) const;
+
+    void Add(const std::string& source, bool srgb, const std::string& cookedFile);
+
+    // Cooked file for the source, resolved against the manifest directory; empty if none
+    std::string Find(const std::string& source, bool srgb) const;
+
+    bool IsEmpty() const { return m_Entries.empty(); }
+    size_t GetEntryCount() const { return m_Entries.size(); }
+
+private:
+    static std::string MakeKey(const std::string& source, bool srgb);
+
+    std::string m_BaseDir;  // Directory of the loaded manifest
+    std::unordered_map<std::string, std::string> m_Entries;  // Key -> cooked path (relative)
+};
+
+} // namespace utils
+} // namespace metagfx
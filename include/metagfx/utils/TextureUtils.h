@@ -6,11 +6,15 @@
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Texture.h"
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace metagfx {
 namespace utils {
 
+class MappedFile;
+
 struct ImageData {
     uint8* pixels = nullptr;
     uint32 width = 0;
@@ -36,20 +40,24 @@ HDRImageData LoadHDRImage(const std::string& filepath, int desiredChannels = 4);
 // Load image from memory buffer (for embedded textures)
 ImageData LoadImageFromMemory(const uint8* buffer, uint32 bufferSize, int desiredChannels = 4);
 
+// Keep the first channels (1 for R8, 2 for RG8) of each texel, packed in place; the
+// buffer is still freed by FreeImage()
+void KeepImageChannels(ImageData& data, uint32 channels);
+
 // Free stb_image data
 void FreeImage(ImageData& data);
 
 // Free stb_image HDR data
 void FreeHDRImage(HDRImageData& data);
 
-// Create texture from image data (loads to GPU)
+// Create texture from image data (loads to GPU, with a generated mip chain)
 Ref<rhi::Texture> CreateTextureFromImage(
     rhi::GraphicsDevice* device,
     const ImageData& imageData,
     rhi::Format format = rhi::Format::R8G8B8A8_SRGB
 );
 
-// Create texture from HDR image data (floating-point format)
+// Create texture from HDR image data (floating-point format, with a generated mip chain)
 Ref<rhi::Texture> CreateTextureFromHDRImage(
     rhi::GraphicsDevice* device,
     const HDRImageData& imageData,
@@ -82,5 +90,74 @@ Ref<rhi::Texture> LoadDDSCubemap(
     const std::string& filepath
 );
 
+// KTX2 texture loading (2D textures and cubemaps with their stored mip chain)
+// Raw payloads may be Zstd-supercompressed. Basis Universal payloads (ETC1S/UASTC) are
+// transcoded to the best format the device samples: ASTC 4x4, BC7/BC1, ETC2, else RGBA8.
+// Basis and Zstd need a build with METAGFX_USE_BASISU.
+Ref<rhi::Texture> LoadKTX2Texture(
+    rhi::GraphicsDevice* device,
+    const std::string& filepath
+);
+
+// KTX2 from memory (e.g. KHR_texture_basisu images embedded in a GLB)
+Ref<rhi::Texture> LoadKTX2TextureFromMemory(
+    rhi::GraphicsDevice* device,
+    const uint8* data,
+    uint64 size,
+    const char* debugName = nullptr
+);
+
+// True if the buffer starts with the KTX2 file identifier
+bool IsKTX2Data(const uint8* data, uint64 size);
+
+// Stored mip chain of a KTX2 or DDS 2D texture, read without touching the GPU so it can
+// be loaded on any thread; CreateTextureFromMipChain() uploads it on the device's thread
+struct TextureMipChain {
+    rhi::Format format = rhi::Format::Undefined;
+    uint32 width = 0;              // Of the first level held
+    uint32 height = 0;
+    uint32 faceCount = 1;
+    uint32 mipLevels = 1;          // Levels held
+    bool generateMipmaps = false;  // The file stores only its base level; generate the rest
+    uint32 firstMip = 0;           // Of the file's levels, the one the data starts at
+    uint32 baseWidth = 0;          // Of the file's level 0
+    uint32 baseHeight = 0;
+    std::vector<uint8> data;       // Mip-major, faces inside each mip
+    // Set instead of data for raw levels of a file: a mapping of it and each held level's
+    // offset in it, its faces packed as in data. CreateTextureFromMipChain() copies them
+    // straight from the mapped pages into the upload, with no copy in between.
+    std::shared_ptr<const MappedFile> mapping;
+    std::vector<uint64> mappedLevels;
+    // Set instead of data when the device loads the levels from the file itself
+    // (DeviceInfo::supportsFileTextureLoads); only raw, uncompressed payloads qualify
+    rhi::TextureFileSource file;
+};
+
+// Read a KTX2 or DDS (by extension) 2D texture file. With maxExtent, the levels larger
+// than maxExtent on either side are left out, keeping at least the smallest one; a file
+// storing only its base level keeps it. Returns false (and logs) on failure.
+bool LoadTextureMipChain(
+    rhi::GraphicsDevice* device,
+    const std::string& filepath,
+    TextureMipChain& out,
+    uint32 maxExtent = 0
+);
+
+// Read a DDS 2D texture or, with cubemap, a DDS cubemap without a device, so it can be
+// loaded before the device exists. The levels are always held in a mapping of the file,
+// which starts reading them in the background. Returns false (and logs) on failure.
+bool LoadDDSMipChain(
+    const std::string& filepath,
+    bool cubemap,
+    TextureMipChain& out
+);
+
+// Fails (and logs) when the device does not sample the chain's format
+Ref<rhi::Texture> CreateTextureFromMipChain(
+    rhi::GraphicsDevice* device,
+    const TextureMipChain& chain,
+    const char* debugName = nullptr
+);
+
 } // namespace utils
 } // namespace metagfx
@@ -2,9 +2,17 @@
 // src/app/Application.cpp
 // ============================================================================
 #include "Application.h"
+#include "ImGuiRenderer.h"
+#include "StreamServer.h"
+#include "metagfx/core/AllocationTracker.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
 #include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CaptureDevice.h"
 #include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/FormatInfo.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Pipeline.h"
 #include "metagfx/rhi/Sampler.h"
@@ -12,39 +20,211 @@
 #include "metagfx/rhi/SwapChain.h"
 #include "metagfx/rhi/Texture.h"
 #include "metagfx/rhi/Types.h"
-#ifdef METAGFX_USE_VULKAN
-#include "metagfx/rhi/vulkan/VulkanBuffer.h"
-#include "metagfx/rhi/vulkan/VulkanCommandBuffer.h"
-#include "metagfx/rhi/vulkan/VulkanDevice.h"
-#include "metagfx/rhi/DescriptorSet.h"
-#include "metagfx/rhi/vulkan/VulkanPipeline.h"
-#include "metagfx/rhi/vulkan/VulkanSwapChain.h"
-#include "metagfx/rhi/vulkan/VulkanTexture.h"
-#endif
-#ifdef METAGFX_USE_METAL
-#include "metagfx/rhi/metal/MetalCommandBuffer.h"
-#include "metagfx/rhi/metal/MetalDevice.h"
-#include "metagfx/rhi/metal/MetalTexture.h"
-#endif
+#include "metagfx/renderer/DeferredRenderer.h"
+#include "metagfx/renderer/PathTracingRenderer.h"
+#include "metagfx/renderer/VisibilityBufferRenderer.h"
+#include "metagfx/scene/AmbientOcclusion.h"
+#include "metagfx/scene/AutoExposure.h"
+#include "metagfx/scene/Bloom.h"
 #include "metagfx/scene/Camera.h"
+#include "metagfx/scene/DeferredLighting.h"
+#include "metagfx/scene/Denoiser.h"
+#include "metagfx/scene/EnvironmentBaker.h"
+#include "metagfx/scene/GPUCuller.h"
+#include "metagfx/scene/LightProbeVolume.h"
 #include "metagfx/scene/Material.h"
 #include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/scene/ObjectPicker.h"
+#include "metagfx/scene/PathTracer.h"
+#include "metagfx/scene/RayTracingScene.h"
+#include "metagfx/scene/ScreenSpaceReflections.h"
+#include "metagfx/scene/ShadingRate.h"
 #include "metagfx/scene/ShadowMap.h"
+#include "metagfx/scene/Skinning.h"
+#include "metagfx/scene/StreamEncoder.h"
+#include "metagfx/scene/TemporalAA.h"
+#include "metagfx/scene/ToneMapper.h"
+#include "metagfx/scene/TransformBuffer.h"
+#include "metagfx/scene/VisibilityBuffer.h"
+#include "metagfx/scene/WeightedBlendedOIT.h"
+#include "metagfx/utils/ImageWriter.h"
+#include "metagfx/utils/Json.h"
 #include "metagfx/utils/TextureUtils.h"
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 #include <imgui.h>
 #include <imgui_impl_sdl3.h>
-#ifdef METAGFX_USE_VULKAN
-#include <imgui_impl_vulkan.h>
-#endif
-#ifdef METAGFX_USE_METAL
-#include <imgui_impl_metal.h>
-#endif
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <string_view>
+#include <thread>
 
 namespace metagfx {
 
+namespace {
+
+// WGSL tint translated at build time (WebGPU and tint enabled), so the WebGPU backend
+// starts without translating the SPIR-V
+#if __has_include("precompiled_wgsl.inl")
+#include "precompiled_wgsl.inl"
+#define METAGFX_HAS_PRECOMPILED_WGSL 1
+#else
+#define METAGFX_HAS_PRECOMPILED_WGSL 0
+#endif
+
+// Temporal AA upscaling: the viewport's size over the render size, FSR 2's quality modes
+struct UpscaleMode {
+    const char* name;
+    float upscale;
+};
+
+constexpr UpscaleMode UPSCALE_MODES[] = {
+    { "Native", 1.0f },
+    { "Ultra quality (1.3x)", 1.3f },
+    { "Quality (1.5x)", 1.5f },
+    { "Balanced (1.7x)", 1.7f },
+    { "Performance (2x)", 2.0f },
+    { "Ultra performance (3x)", 3.0f }
+};
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+// Mean, extremes and nearest-rank percentiles of a set of frame times
+void WriteFrameTimes(std::ofstream& out, std::vector<double> times) {
+    if (times.empty()) {
+        out << "null";
+        return;
+    }
+    std::sort(times.begin(), times.end());
+    auto percentile = [&](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * static_cast<double>(times.size())));
+        return times[std::clamp<size_t>(rank, 1, times.size()) - 1];
+    };
+    double sum = 0.0;
+    for (double time : times) {
+        sum += time;
+    }
+    out << "{\"samples\": " << times.size()
+        << ", \"mean\": " << sum / static_cast<double>(times.size())
+        << ", \"min\": " << times.front()
+        << ", \"p50\": " << percentile(50.0)
+        << ", \"p90\": " << percentile(90.0)
+        << ", \"p95\": " << percentile(95.0)
+        << ", \"p99\": " << percentile(99.0)
+        << ", \"max\": " << times.back() << "}";
+}
+
+// Descriptor set of the model shaders a main binding belongs to (model.frag): 0 per frame,
+// 1 per pass (the shadows), 2 per material
+enum ModelSet : uint32 {
+    ModelSetFrame = 0,
+    ModelSetPass = 1,
+    ModelSetMaterial = 2
+};
+
+ModelSet GetModelSet(uint32 binding) {
+    switch (binding) {
+        case 1: case 2: case 4: case 5: case 6: case 7: case 11:
+            return ModelSetMaterial;
+        case 12: case 13: case 18: case 19: case 20: case 21:
+            return ModelSetPass;
+        default:
+            return ModelSetFrame;
+    }
+}
+
+std::vector<rhi::DescriptorBindingDesc> SelectModelSetBindings(const std::vector<rhi::DescriptorBindingDesc>& bindings,
+                                                               ModelSet set) {
+    std::vector<rhi::DescriptorBindingDesc> selected;
+    for (const rhi::DescriptorBindingDesc& binding : bindings) {
+        if (GetModelSet(binding.binding) == set) {
+            selected.push_back(binding);
+        }
+    }
+    return selected;
+}
+
+// Points the material set's binding at the texture, the default when null
+void SetMaterialTexture(std::vector<rhi::DescriptorBindingDesc>& bindings, uint32 binding,
+                        const Ref<rhi::Texture>& texture, const Ref<rhi::Texture>& fallback) {
+    for (rhi::DescriptorBindingDesc& desc : bindings) {
+        if (desc.binding == binding) {
+            desc.texture = texture ? texture : fallback;
+        }
+    }
+}
+
+// BatchConfig::viewsPath's views; without a target they look at the scene's center
+bool LoadBatchViews(const std::string& path, std::vector<SceneDescription::CameraKey>& outViews) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        METAGFX_ERROR << "Failed to open batch views: " << path;
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    utils::JsonValue root;
+    std::string error;
+    if (!utils::JsonValue::Parse(text.data(), text.size(), root, &error)) {
+        METAGFX_ERROR << "Failed to parse batch views " << path << ": " << error;
+        return false;
+    }
+
+    if (!SceneDescription::ParseCameraKeys(root.IsArray() ? root : root["views"], "view", outViews, &error)) {
+        METAGFX_ERROR << "Batch views " << path << ": " << error;
+        return false;
+    }
+    if (outViews.empty()) {
+        METAGFX_ERROR << "No views in " << path;
+        return false;
+    }
+    return true;
+}
+
+// The precomputed IBL maps (ibl_precompute) read at startup
+const char* const STARTUP_ENVIRONMENT_DIRECTORY = "/Users/Borja/dev/borja-munoz/metagfx/assets/envmaps/";
+
+} // namespace
+
+// The startup IBL maps, read on the job system from the start of Init(), before the device
+// exists; UpdateStartupEnvironment() uploads them once every read has finished
+struct StartupEnvironment {
+    utils::IrradianceSH irradianceSH;
+    utils::TextureMipChain prefiltered;
+    utils::TextureMipChain brdfLut;
+    utils::TextureMipChain environment;
+    bool irradianceLoaded = false;
+    bool prefilteredLoaded = false;
+    bool brdfLutLoaded = false;
+    bool environmentLoaded = false;
+    JobCounter reads;
+};
+
 Application::Application(const ApplicationConfig& config)
     : m_Config(config) {
     Init();
@@ -56,7 +236,29 @@ Application::~Application() {
 
 void Application::Init() {
     METAGFX_INFO << "Initializing application...";
-    
+    m_InitStartTime = std::chrono::steady_clock::now();
+
+    // Read the IBL maps while SDL, the device and the pipelines come up; the first frames
+    // light with black placeholders until UpdateStartupEnvironment() swaps them in
+    METAGFX_INFO << "Loading IBL textures...";
+    m_StartupEnvironment = std::make_unique<StartupEnvironment>();
+    {
+        StartupEnvironment* startup = m_StartupEnvironment.get();
+        std::string directory = STARTUP_ENVIRONMENT_DIRECTORY;
+        JobSystem::Run([startup, directory]() {
+            startup->irradianceLoaded = startup->irradianceSH.Load(directory + "irradiance_sh.txt");
+        }, &startup->reads);
+        JobSystem::Run([startup, directory]() {
+            startup->prefilteredLoaded = utils::LoadDDSMipChain(directory + "prefiltered.dds", true, startup->prefiltered);
+        }, &startup->reads);
+        JobSystem::Run([startup, directory]() {
+            startup->brdfLutLoaded = utils::LoadDDSMipChain(directory + "brdf_lut.dds", false, startup->brdfLut);
+        }, &startup->reads);
+        JobSystem::Run([startup, directory]() {
+            startup->environmentLoaded = utils::LoadDDSMipChain(directory + "environment.dds", true, startup->environment);
+        }, &startup->reads);
+    }
+
     // Initialize SDL
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
         METAGFX_CRITICAL << "Failed to initialize SDL: " << SDL_GetError();
@@ -66,7 +268,7 @@ void Application::Init() {
     METAGFX_INFO << "SDL initialized successfully";
 
     // Create window with appropriate flags for selected graphics API
-    uint32_t windowFlags = SDL_WINDOW_RESIZABLE;
+    uint32_t windowFlags = IsOffscreen() ? SDL_WINDOW_HIDDEN : SDL_WINDOW_RESIZABLE;
 
     // Log requested backend
     const char* apiName = "Unknown";
@@ -107,13 +309,48 @@ void Application::Init() {
     METAGFX_INFO << "Window created: " << m_Config.width << "x" << m_Config.height;
 
     // Create graphics device with configured API
-    m_Device = rhi::CreateGraphicsDevice(m_Config.graphicsAPI, m_Window);
+    rhi::GraphicsDeviceDesc deviceDesc{};
+    deviceDesc.framesInFlight = m_Config.framesInFlight;
+    deviceDesc.presentMode = m_Config.presentMode;
+    deviceDesc.pipelineCachePath = m_Config.pipelineCachePath;
+    deviceDesc.offscreen = IsOffscreen();
+    deviceDesc.adapterIndex = m_Config.adapterIndex;
+    deviceDesc.adapterName = m_Config.adapterName;
+#if METAGFX_HAS_PRECOMPILED_WGSL
+    deviceDesc.precompiledShaders = PRECOMPILED_WGSL;
+    deviceDesc.precompiledShaderCount = static_cast<uint32>(std::size(PRECOMPILED_WGSL));
+#endif
+    m_Device = rhi::CreateGraphicsDevice(m_Config.graphicsAPI, m_Window, deviceDesc);
     if (!m_Device) {
         METAGFX_ERROR << "Failed to create graphics device for " << apiName;
         return;
     }
+    if (!m_Config.capturePath.empty()) {
+        // Before any resource, so the trace holds everything its frames use
+        rhi::CaptureSettings capture;
+        capture.path = m_Config.capturePath;
+        capture.frameCount = m_Config.captureFrames;
+        if (Ref<rhi::GraphicsDevice> captureDevice = rhi::CreateCaptureDevice(m_Device, capture)) {
+            m_Device = captureDevice;
+        }
+    }
 
     METAGFX_INFO << "Graphics device created: " << m_Device->GetDeviceInfo().deviceName;
+    {
+        std::string features;
+        for (const char* feature : rhi::GetFeatureNames(m_Device->GetDeviceInfo())) {
+            features += features.empty() ? feature : std::string(", ") + feature;
+        }
+        METAGFX_INFO << "  Features: " << (features.empty() ? "none" : features);
+    }
+
+    m_GpuProfiler = m_Device->CreateGpuProfiler();
+    if (!m_GpuProfiler) {
+        METAGFX_INFO << "GPU timestamp queries unsupported: GPU profiler disabled";
+    }
+    if (m_Config.hitchDetection && !IsHeadless()) {
+        m_HitchDetector = std::make_unique<HitchDetector>(m_Config.hitchDetector);
+    }
 
     // Create camera
     m_Camera = std::make_unique<Camera>(
@@ -125,41 +362,34 @@ void Application::Init() {
     // Set up orbital camera centered on origin
     m_Camera->SetPosition(glm::vec3(0.0f, 1.0f, 8.0f));
     m_Camera->SetOrbitTarget(glm::vec3(0.0f, 0.0f, 0.0f));  // Orbit around model center
+    m_FrameCamera = std::make_unique<Camera>(*m_Camera);
 
     // Don't enable relative mouse mode - we use click-and-drag instead
     // SDL_SetWindowRelativeMouseMode(m_Window, false);
     
-    // Create uniform buffers (before creating pipeline)
+    // Create uniform ring (before creating pipeline). The MVP block and every draw's
+    // material are sub-allocated from the current frame's region each frame and
+    // selected with dynamic offsets, so draws no longer overwrite each other's data.
     using namespace rhi;
-    BufferDesc uniformBufferDesc{};
-    uniformBufferDesc.size = sizeof(UniformBufferObject);
-    uniformBufferDesc.usage = BufferUsage::Uniform;
-    uniformBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
-
-    m_UniformBuffers[0] = m_Device->CreateBuffer(uniformBufferDesc);
-    m_UniformBuffers[1] = m_Device->CreateBuffer(uniformBufferDesc);
+    constexpr uint64 UNIFORM_RING_BYTES_PER_FRAME = 1024 * 1024;  // ~4096 draws at 256-byte alignment
+    m_UniformRing = std::make_unique<UniformRingBuffer>(m_Device, UNIFORM_RING_BYTES_PER_FRAME,
+                                                        m_Device->GetDeviceInfo().framesInFlight);
 
-    // Create material buffers (double-buffered)
-    BufferDesc materialBufferDesc{};
-    materialBufferDesc.size = sizeof(MaterialProperties);
-    materialBufferDesc.usage = BufferUsage::Uniform;
-    materialBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    // Records the frame's passes; its render graph allocates the depth buffer
+    SetRenderMode(m_Config.renderMode);
 
-    m_MaterialBuffers[0] = m_Device->CreateBuffer(materialBufferDesc);
-    m_MaterialBuffers[1] = m_Device->CreateBuffer(materialBufferDesc);
+    // Model textures are shared across materials and reloads of the same model
+    m_TextureCache = std::make_unique<utils::TextureCache>(m_Config.textureCacheBudgetMB * 1024 * 1024);
 
-    // Create ground plane material buffer (dedicated to avoid conflicts)
-    m_GroundPlaneMaterialBuffer = m_Device->CreateBuffer(materialBufferDesc);
+    // Their larger mips are read on demand, by their meshes' size on screen
+    m_TextureStreamer = std::make_unique<TextureStreamer>(m_Device);
+    TextureStreamer::Settings streamingSettings;
+    streamingSettings.budgetBytes = m_Config.textureStreamingBudgetMB * 1024 * 1024;
+    m_TextureStreamer->SetSettings(streamingSettings);
 
-    // Create shadow uniform buffer
-    struct ShadowUBO {
-        glm::mat4 lightSpaceMatrix;
-        glm::mat4 model;  // Model matrix
-        float shadowBias;
-        float padding[3];
-    };
+    // Create shadow uniform buffer (cascades read by the main pass)
     BufferDesc shadowBufferDesc{};
-    shadowBufferDesc.size = sizeof(ShadowUBO);
+    shadowBufferDesc.size = sizeof(ShadowUniforms);
     shadowBufferDesc.usage = BufferUsage::Uniform;
     shadowBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
     m_ShadowUniformBuffer = m_Device->CreateBuffer(shadowBufferDesc);
@@ -224,16 +454,6 @@ void Application::Init() {
         m_Device.get(), blackImage, rhi::Format::R8G8B8A8_UNORM
     );
 
-    // Create depth buffer for 3D rendering
-    auto swapChain = m_Device->GetSwapChain();
-    rhi::TextureDesc depthDesc{};
-    depthDesc.width = swapChain->GetWidth();
-    depthDesc.height = swapChain->GetHeight();
-    depthDesc.format = rhi::Format::D32_SFLOAT;
-    depthDesc.usage = rhi::TextureUsage::DepthStencilAttachment;
-    depthDesc.debugName = "DepthBuffer";
-    m_DepthBuffer = m_Device->CreateTexture(depthDesc);
-
     // Create cubemap sampler for IBL textures
     rhi::SamplerDesc cubemapSamplerDesc{};
     cubemapSamplerDesc.minFilter = rhi::Filter::Linear;
@@ -244,130 +464,203 @@ void Application::Init() {
     cubemapSamplerDesc.addressModeW = rhi::SamplerAddressMode::ClampToEdge;
     m_CubemapSampler = m_Device->CreateSampler(cubemapSamplerDesc);
 
-    // Load IBL textures (Image-Based Lighting)
-    // These textures are pre-computed using the ibl_precompute tool
-    METAGFX_INFO << "Loading IBL textures...";
-    m_IrradianceMap = utils::LoadDDSCubemap(m_Device.get(),
-        "/Users/Borja/dev/borja-munoz/metagfx/assets/envmaps/irradiance.dds");
-    m_PrefilteredMap = utils::LoadDDSCubemap(m_Device.get(),
-        "/Users/Borja/dev/borja-munoz/metagfx/assets/envmaps/prefiltered.dds");
-    m_BRDF_LUT = utils::LoadDDS2DTexture(m_Device.get(),
-        "/Users/Borja/dev/borja-munoz/metagfx/assets/envmaps/brdf_lut.dds");
-    m_EnvironmentMap = utils::LoadDDSCubemap(m_Device.get(),
-        "/Users/Borja/dev/borja-munoz/metagfx/assets/envmaps/environment.dds");
-
-    if (!m_IrradianceMap || !m_PrefilteredMap || !m_BRDF_LUT) {
-        METAGFX_WARN << "Failed to load IBL textures! Using fallback textures.";
-        METAGFX_WARN << "IBL will be disabled. Generate textures using: ./bin/tools/ibl_precompute <input.hdr> assets/envmaps/studio/";
-
-        // Create fallback 1x1 black cubemap for irradiance and prefiltered
-        rhi::TextureDesc cubemapDesc{};
-        cubemapDesc.type = rhi::TextureType::TextureCube;
-        cubemapDesc.width = 1;
-        cubemapDesc.height = 1;
-        cubemapDesc.arrayLayers = 6;
-        cubemapDesc.format = rhi::Format::R8G8B8A8_UNORM;
-        cubemapDesc.usage = rhi::TextureUsage::Sampled;
-
-        if (!m_IrradianceMap) {
-            m_IrradianceMap = m_Device->CreateTexture(cubemapDesc);
-            uint8_t blackPixels[6 * 4] = {0}; // 6 faces, RGBA black
-            m_IrradianceMap->UploadData(blackPixels, sizeof(blackPixels));
-        }
-
-        if (!m_PrefilteredMap) {
-            m_PrefilteredMap = m_Device->CreateTexture(cubemapDesc);
-            uint8_t blackPixels[6 * 4] = {0};
-            m_PrefilteredMap->UploadData(blackPixels, sizeof(blackPixels));
-        }
-
-        // Use white texture for BRDF LUT fallback
-        if (!m_BRDF_LUT) {
-            m_BRDF_LUT = m_DefaultWhiteTexture;
-        }
-
-        // Disable IBL by default if textures failed to load
-        m_EnableIBL = false;
-    } else {
-        METAGFX_INFO << "IBL textures loaded successfully";
+    // Placeholders for the IBL maps read in the background: no irradiance, a black
+    // cubemap for the prefiltered and environment maps and a white BRDF LUT
+    rhi::TextureDesc cubemapDesc{};
+    cubemapDesc.type = rhi::TextureType::TextureCube;
+    cubemapDesc.width = 1;
+    cubemapDesc.height = 1;
+    cubemapDesc.arrayLayers = 6;
+    cubemapDesc.format = rhi::Format::R8G8B8A8_UNORM;
+    cubemapDesc.usage = rhi::TextureUsage::Sampled;
+    cubemapDesc.debugName = "DefaultBlackCubemap";
+    m_DefaultBlackCubemap = m_Device->CreateTexture(cubemapDesc);
+    uint8_t blackCubePixels[6 * 4] = {0};
+    m_DefaultBlackCubemap->UploadData(blackCubePixels, sizeof(blackCubePixels));
+    m_IrradianceSHBuffer = CreateIrradianceSHBuffer(utils::IrradianceSH{});
+    m_PrefilteredMap = m_DefaultBlackCubemap;
+    m_BRDF_LUT = m_DefaultWhiteTexture;
+    m_EnvironmentMap = m_DefaultBlackCubemap;
+
+    // The scene file's lights, environment and model replace the defaults below
+    if (!m_Config.scenePath.empty()) {
+        ReadSceneFile(m_Config.scenePath);
     }
 
     // Create scene and initialize light buffer
     m_Scene = std::make_unique<Scene>();
-    m_Scene->InitializeLightBuffer(m_Device.get());
-
-    // Create test lights
-    CreateTestLights();
-
-    // Upload light data to GPU before creating descriptor sets
-    m_Scene->UpdateLightBuffer();
+    m_Scene->InitializeLightBuffer(m_Device.get(), m_Device->GetDeviceInfo().framesInFlight);
+
+    // Node transforms; until a model is loaded the graph only has the ground plane's node
+    constexpr uint32 MAX_SCENE_NODES = 16384;  // 1 MiB of matrices
+    constexpr uint32 MAX_INSTANCES_PER_FRAME = 65536;  // Batched instances, camera and shadow lists together
+    uint32 framesInFlight = m_Device->GetDeviceInfo().framesInFlight;
+    m_TransformBuffer = std::make_unique<TransformBuffer>(m_Device, MAX_SCENE_NODES, framesInFlight);
+    m_InstanceBuffer = std::make_unique<InstanceBuffer>(m_Device, MAX_SCENE_NODES, MAX_INSTANCES_PER_FRAME,
+                                                        framesInFlight);
+    constexpr uint32 MAX_CLUSTER_LIGHT_INDICES = 1u << 18;  // Per frame, 1 MiB
+    m_LightClusters = std::make_unique<LightClusters>(m_Device, MAX_CLUSTER_LIGHT_INDICES, framesInFlight);
+    m_GroundNode = m_Scene->GetSceneGraph().AddNode(glm::mat4(1.0f));
+
+    // Create the scene file's lights, or test lights
+    if (m_SceneDescription && m_SceneDescription->hasLights) {
+        ApplySceneLights(*m_SceneDescription);
+    } else {
+        CreateTestLights();
+    }
 
-    // Create shadow map (2048x2048 default resolution)
-    m_ShadowMap = std::make_unique<ShadowMap>(m_Device, 2048, 2048);
+    // Create shadow map: four 2048x2048 cascade tiles
+    if (m_Config.shadowDepth16 && !m_Device->GetDeviceInfo().supportsDepth16) {
+        METAGFX_WARN << "16-bit shadow depth is not supported by this device; using 32-bit";
+    }
+    m_ShadowDepthFormat = m_Config.shadowDepth16 && m_Device->GetDeviceInfo().supportsDepth16
+                              ? Format::D16_UNORM : Format::D32_SFLOAT;
+    m_ShadowMap = std::make_unique<ShadowMap>(m_Device, 4096, 4096, m_ShadowDepthFormat);
+    CreateShadowMoments();
+    SetShadowFilter(m_Config.shadowFilter);
+    m_DepthPrepassMode = m_Config.depthPrepass;
+    if (m_Config.targetGpuFrameMs > 0.0f) {
+        DynamicResolution::Settings dynamicSettings = m_DynamicResolution.GetSettings();
+        dynamicSettings.targetMs = m_Config.targetGpuFrameMs;
+        m_DynamicResolution.SetSettings(dynamicSettings);
+        m_EnableDynamicResolution = true;
+    }
 
-    // Create descriptor set with 14 bindings (added shadow map sampler and shadow UBO)
+    // Point and spot light shadows: 4096x4096 atlas of 128 to 1024 texel tiles, cleared
+    // tile by tile with a quad at the far plane
+    m_ShadowAtlas = std::make_unique<ShadowAtlas>(m_Device, 4096, framesInFlight, m_ShadowDepthFormat);
+    const glm::vec3 clearQuad[6] = {
+        { -1.0f, -1.0f, 0.0f }, { 1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 0.0f },
+        { -1.0f, -1.0f, 0.0f }, { 1.0f, 1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f } };
+    BufferDesc clearQuadDesc{};
+    clearQuadDesc.size = sizeof(clearQuad);
+    clearQuadDesc.usage = BufferUsage::Vertex | BufferUsage::TransferDst;
+    clearQuadDesc.memoryUsage = MemoryUsage::GPUOnly;
+    clearQuadDesc.debugName = "ShadowClearQuad";
+    m_ShadowClearQuad = m_Device->CreateBuffer(clearQuadDesc);
+    m_ShadowClearQuad->CopyData(clearQuad, sizeof(clearQuad));
+
+    // Bound before any light probe volume exists: a zeroed one leaves the environment's
+    // irradiance alone
+    m_LightProbeBuffer = LightProbeVolume::CreateProbeBuffer(*m_Device);
+
+    // Create descriptor set with 15 bindings (added shadow map sampler, shadow UBO and node transforms)
     using rhi::DescriptorType;
     using rhi::ShaderStage;
     using rhi::DescriptorBindingDesc;
 
     std::vector<DescriptorBindingDesc> bindings = {
-        { 0, DescriptorType::UniformBuffer, ShaderStage::Vertex, m_UniformBuffers[0], nullptr, nullptr },  // MVP matrices
-        { 1, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_MaterialBuffers[0], nullptr, nullptr },  // Material
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Vertex | ShaderStage::Fragment, m_UniformRing->GetBuffer(), nullptr, nullptr, sizeof(UniformBufferObject) },  // MVP matrices + frame constants
+        { 1, DescriptorType::UniformBufferDynamic, ShaderStage::Fragment, m_UniformRing->GetBuffer(), nullptr, nullptr, sizeof(MaterialProperties) },  // Material
         { 2, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultTexture, m_LinearRepeatSampler },  // Albedo
         { 3, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_Scene->GetLightBuffer(), nullptr, nullptr },  // Lights
         { 4, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultNormalMap, m_LinearRepeatSampler },  // Normal
         { 5, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultWhiteTexture, m_LinearRepeatSampler },  // Metallic
         { 6, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultWhiteTexture, m_LinearRepeatSampler },  // Roughness
         { 7, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultWhiteTexture, m_LinearRepeatSampler },  // AO
-        { 8, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_IrradianceMap, m_CubemapSampler },  // Irradiance
+        { 8, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_IrradianceSHBuffer, nullptr, nullptr },  // Irradiance SH
         { 9, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_PrefilteredMap, m_CubemapSampler },  // Prefiltered
         { 10, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_BRDF_LUT, m_LinearRepeatSampler },  // BRDF LUT
         { 11, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_DefaultBlackTexture, m_LinearRepeatSampler },  // Emissive
         { 12, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowMap->GetDepthTexture(), m_ShadowMap->GetSampler() },  // Shadow map
-        { 13, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_ShadowUniformBuffer, nullptr, nullptr }  // Shadow UBO
+        { 13, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_ShadowUniformBuffer, nullptr, nullptr },  // Shadow UBO
+        { 15, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_TransformBuffer->GetBuffer(), nullptr, nullptr },  // Node transforms (14 is the bindless texture table)
+        { 16, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_InstanceBuffer->GetBuffer(), nullptr, nullptr },  // Instance nodes
+        { 17, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_LightClusters->GetBuffer(), nullptr, nullptr },  // Light clusters
+        { 18, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowAtlas->GetDepthTexture(), m_ShadowAtlas->GetSampler() },  // Shadow atlas
+        { 19, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_ShadowAtlas->GetBuffer(), nullptr, nullptr },  // Shadow atlas faces
+        { 20, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowMap->GetDepthTexture(), m_ShadowMap->GetDepthSampler() },  // Shadow map depth (PCSS)
+        { 21, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr,
+          m_ShadowMoments ? m_ShadowMoments->GetTexture() : m_DefaultWhiteTexture,
+          m_ShadowMoments ? m_ShadowMoments->GetSampler() : m_LinearRepeatSampler },  // Shadow moments (EVSM)
+        { 29, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_LightProbeBuffer, nullptr, nullptr }  // Light probes
     };
 
+    // The scene's top level for ray-traced shadows; written once the first frame builds it
+    if (m_Device->GetDeviceInfo().supportsRayQuery) {
+        m_RayTracingScene = std::make_unique<RayTracingScene>(m_Device);
+        bindings.push_back({ 22, DescriptorType::AccelerationStructure, ShaderStage::Fragment, nullptr, nullptr, nullptr });  // Scene top level
+    }
+
+    // Split by update frequency: the frame set is bound once per pass with the view's
+    // offset, the pass set with it, and a material change only rebinds its material set
+    m_MainBindings = bindings;
     rhi::DescriptorSetDesc descriptorSetDesc;
-    descriptorSetDesc.bindings = bindings;
+    descriptorSetDesc.bindings = SelectModelSetBindings(bindings, ModelSetFrame);
     descriptorSetDesc.debugName = "MainDescriptorSet";
     m_DescriptorSet = m_Device->CreateDescriptorSet(descriptorSetDesc);
 
-    // Create ground plane descriptor set (same layout as model, but separate instance)
-    // We MUST use the same layout because they share the same pipeline
-    std::vector<DescriptorBindingDesc> groundPlaneBindings = bindings;  // Copy all bindings
-
-    // CRITICAL: Array index corresponds to binding number!
-    // Index 0 = binding 0 (MVP), Index 1 = binding 1 (Material), Index 2 = binding 2 (Albedo), etc.
-
-    // Use dedicated material buffer for ground plane (binding 1 = index 1)
-    groundPlaneBindings[1].buffer = m_GroundPlaneMaterialBuffer;  // Dedicated material buffer
-
-    // Set default textures for ground plane
-    groundPlaneBindings[2].texture = m_DefaultWhiteTexture;   // binding 2: Albedo
-    groundPlaneBindings[4].texture = m_DefaultNormalMap;      // binding 4: Normal
-    groundPlaneBindings[5].texture = m_DefaultWhiteTexture;   // binding 5: Metallic
-    groundPlaneBindings[6].texture = m_DefaultWhiteTexture;   // binding 6: Roughness
-    groundPlaneBindings[7].texture = m_DefaultWhiteTexture;   // binding 7: AO
-    groundPlaneBindings[11].texture = m_DefaultBlackTexture;  // binding 11: Emissive (black = no glow)
+    rhi::DescriptorSetDesc passDescriptorSetDesc;
+    passDescriptorSetDesc.bindings = SelectModelSetBindings(bindings, ModelSetPass);
+    passDescriptorSetDesc.debugName = "PassDescriptorSet";
+    m_PassDescriptorSet = m_Device->CreateDescriptorSet(passDescriptorSetDesc);
+
+    // Material changes push set 2 where the device can, instead of binding a prebuilt set:
+    // nothing to allocate or keep per material, and no set to update when one changes.
+    // Decided here, as set 2's layout is that of every model pipeline.
+    m_PushMaterialDescriptors = m_Device->GetDeviceInfo().supportsPushDescriptors;
+
+    // Material set of meshes without one, with the default textures
+    std::vector<DescriptorBindingDesc> materialBindings = SelectModelSetBindings(bindings, ModelSetMaterial);
+    rhi::DescriptorSetDesc defaultMaterialDescriptorSetDesc;
+    defaultMaterialDescriptorSetDesc.bindings = materialBindings;
+    defaultMaterialDescriptorSetDesc.pushDescriptors = m_PushMaterialDescriptors;
+    defaultMaterialDescriptorSetDesc.debugName = "DefaultMaterialDescriptorSet";
+    m_DefaultMaterialSet.set = m_Device->CreateDescriptorSet(defaultMaterialDescriptorSetDesc);
+    m_DefaultMaterialSet.bindings = materialBindings;
+
+    // The ground plane's material set: binding 1 stays on the uniform ring, where the
+    // ground plane pushes its own material slice
+    std::vector<DescriptorBindingDesc> groundPlaneBindings = materialBindings;
+    SetMaterialTexture(groundPlaneBindings, 2, m_DefaultWhiteTexture, nullptr);   // Albedo
+    SetMaterialTexture(groundPlaneBindings, 4, m_DefaultNormalMap, nullptr);      // Normal
+    SetMaterialTexture(groundPlaneBindings, 5, m_DefaultWhiteTexture, nullptr);   // Metallic
+    SetMaterialTexture(groundPlaneBindings, 6, m_DefaultWhiteTexture, nullptr);   // Roughness
+    SetMaterialTexture(groundPlaneBindings, 7, m_DefaultWhiteTexture, nullptr);   // AO
+    SetMaterialTexture(groundPlaneBindings, 11, m_DefaultBlackTexture, nullptr);  // Emissive (black = no glow)
 
     rhi::DescriptorSetDesc groundPlaneDescriptorSetDesc;
     groundPlaneDescriptorSetDesc.bindings = groundPlaneBindings;
+    groundPlaneDescriptorSetDesc.pushDescriptors = m_PushMaterialDescriptors;
     groundPlaneDescriptorSetDesc.debugName = "GroundPlaneDescriptorSet";
-    m_GroundPlaneDescriptorSet = m_Device->CreateDescriptorSet(groundPlaneDescriptorSetDesc);
+    m_GroundPlaneMaterialSet.set = m_Device->CreateDescriptorSet(groundPlaneDescriptorSetDesc);
+    m_GroundPlaneMaterialSet.bindings = groundPlaneBindings;
 
     // Create shadow descriptor set (for shadow pass rendering)
     std::vector<DescriptorBindingDesc> shadowBindings = {
-        { 0, DescriptorType::UniformBuffer, ShaderStage::Vertex, m_ShadowUniformBuffer, nullptr, nullptr }  // Shadow UBO
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Vertex, m_UniformRing->GetBuffer(), nullptr, nullptr, sizeof(RasterizationRenderer::ShadowPassUBO) },  // Cascade matrix
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_TransformBuffer->GetBuffer(), nullptr, nullptr },  // Node transforms
+        { 2, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_InstanceBuffer->GetBuffer(), nullptr, nullptr }  // Instance nodes
     };
 
+    // The shadow set alone has the model's vertices at binding 3, for the pulled pipeline
+    // (a placeholder until a pooled model is loaded)
     rhi::DescriptorSetDesc shadowDescriptorSetDesc;
     shadowDescriptorSetDesc.bindings = shadowBindings;
+    shadowDescriptorSetDesc.bindings.push_back({ 3, DescriptorType::StorageBuffer, ShaderStage::Vertex,
+                                                 m_InstanceBuffer->GetBuffer(), nullptr, nullptr });  // Pooled vertices
     shadowDescriptorSetDesc.debugName = "ShadowDescriptorSet";
     m_ShadowDescriptorSet = m_Device->CreateDescriptorSet(shadowDescriptorSetDesc);
 
+    // Depth prepass descriptor set: the shadow set's bindings, with the camera's
+    // matrices at binding 0
+    shadowBindings[0].range = sizeof(RasterizationRenderer::DepthPrepassUBO);
+    shadowDescriptorSetDesc.bindings = shadowBindings;
+    shadowDescriptorSetDesc.debugName = "DepthPrepassDescriptorSet";
+    m_DepthPrepassDescriptorSet = m_Device->CreateDescriptorSet(shadowDescriptorSetDesc);
+
+    // Motion vector descriptor set: the depth prepass set's bindings, with the last
+    // frame's matrices at binding 0 too and the last frame's node transforms at binding 3
+    shadowBindings[0].range = sizeof(RasterizationRenderer::MotionVectorUBO);
+    shadowBindings.push_back({ 3, DescriptorType::StorageBuffer, ShaderStage::Vertex,
+                               m_TransformBuffer->GetPreviousBuffer(), nullptr, nullptr });
+    shadowDescriptorSetDesc.bindings = shadowBindings;
+    shadowDescriptorSetDesc.debugName = "MotionVectorDescriptorSet";
+    m_MotionVectorDescriptorSet = m_Device->CreateDescriptorSet(shadowDescriptorSetDesc);
+
     // Create skybox descriptor set with 2 bindings
     std::vector<DescriptorBindingDesc> skyboxBindings = {
-        { 0, DescriptorType::UniformBuffer, ShaderStage::Vertex, m_UniformBuffers[0], nullptr, nullptr },  // MVP matrices
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Vertex, m_UniformRing->GetBuffer(), nullptr, nullptr, sizeof(UniformBufferObject) },  // MVP matrices
         { 1, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_EnvironmentMap, m_CubemapSampler }  // Environment cubemap
     };
 
@@ -376,8 +669,20 @@ void Application::Init() {
     skyboxDescriptorSetDesc.debugName = "SkyboxDescriptorSet";
     m_SkyboxDescriptorSet = m_Device->CreateDescriptorSet(skyboxDescriptorSetDesc);
 
-    // Set descriptor set layout on device before creating pipeline
-    m_Device->SetActiveDescriptorSetLayout(m_DescriptorSet);
+    // Create bindless material descriptor set (when the device supports texture tables)
+    CreateBindlessDescriptorSet();
+
+    // The tone mapper decides what the lit pipelines render into (it and the systems on
+    // its scene color set their own layouts)
+    CreateToneMapper();
+    CreateAutoExposure();
+    CreateBloom();
+    CreateTemporalAA();
+    CreateEnvironmentBaker();
+    CreateStreaming();
+    if (m_SceneDescription && !m_SceneDescription->environmentPath.empty()) {
+        RequestEnvironmentLoad(m_SceneDescription->environmentPath);  // Baked over the first frames
+    }
 
     // Create triangle resources
     CreateTriangle();
@@ -385,20 +690,6 @@ void Application::Init() {
     // Create model pipeline
     CreateModelPipeline();
 
-    // Create skybox pipeline with skybox descriptor set layout
-    m_Device->SetActiveDescriptorSetLayout(m_SkyboxDescriptorSet);
-    CreateSkyboxPipeline();
-
-    // Create shadow pipeline with shadow descriptor set layout
-    m_Device->SetActiveDescriptorSetLayout(m_ShadowDescriptorSet);
-    CreateShadowPipeline();
-
-    // Restore main descriptor set layout
-    m_Device->SetActiveDescriptorSetLayout(m_DescriptorSet);
-
-    // Create skybox cube geometry
-    CreateSkyboxCube();
-
     // Initialize available models list
     m_AvailableModels = {
         "/Users/Borja/dev/borja-munoz/metagfx/assets/models/AntiqueCamera.glb",
@@ -408,8 +699,94 @@ void Application::Init() {
     };
     m_CurrentModelIndex = 2;  
 
-    // Load initial model
-    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
+    // Start importing the initial model, the scene file's or the default one, so it loads
+    // while the other pipelines and systems are created. Not before CreateModelPipeline(),
+    // which turns compact vertices off without their pipeline. The benchmark's model
+    // loads below.
+    if (m_SceneDescription && !m_SceneDescription->modelPath.empty()) {
+        RequestModelLoad(m_SceneDescription->modelPath);
+    } else if (!IsHeadless()) {
+        RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+    }
+    UpdateModelLoad();
+
+    // The scene file's cells stream in around the camera from the first frame. The scenery
+    // pipeline draws them, so their vertices stay full-float; nothing picks them, and their
+    // textures load whole (the texture streamer follows the model only) within the budget.
+    if (m_SceneDescription && !m_SceneDescription->cells.empty()) {
+        ModelImportSettings cellImport = m_Config.modelImport;
+        cellImport.vertexFormat = VertexFormat::Float;
+        cellImport.positionStream = false;
+        cellImport.cpuGeometry = MeshCPUData::None;
+        cellImport.textureStreamingExtent = 0;
+        m_WorldPartition = std::make_unique<WorldPartition>(m_Device, m_TextureCache.get(), cellImport);
+        m_WorldPartition->SetSettings(m_Config.worldPartition);
+        m_WorldPartition->SetCells(m_SceneDescription->cells);
+    }
+
+    // Create skybox pipeline with skybox descriptor set layout
+    CreateSkyboxPipeline();
+
+    // Create shadow pipeline with shadow descriptor set layout
+    CreateShadowPipeline();
+
+    // Create depth prepass pipelines with their descriptor set layout; the pick pass's
+    // share it
+    CreateDepthPrepassPipeline();
+    m_ObjectPicker = std::make_unique<ObjectPicker>(m_Device);
+    CreatePickPipelines();
+    CreateMotionVectorPipelines();
+
+    // G-buffer pipelines share the model's layout
+    CreateGBufferPipelines();
+
+    // Create GPU culling and deferred lighting pipelines (with their own layouts)
+    CreateGPUCuller();
+    CreateDeferredLighting();
+    CreateVisibilityBuffer();
+    CreateAmbientOcclusion();
+    CreateScreenSpaceReflections();
+    CreateShadingRate();
+    CreateWeightedBlendedOIT();
+    CreateSkinning();
+    CreatePathTracer();
+    CreateLightProbes();
+
+    // Watch the shaders of the model, skybox and shadow pipelines
+    if (m_Config.shaderHotReload) {
+#ifdef METAGFX_GLSL_COMPILER
+        m_ShaderWatcher = std::make_unique<utils::ShaderWatcher>(m_Config.shaderSourceDirectory, METAGFX_GLSL_COMPILER,
+            std::vector<std::string>{ "model.vert", "model.frag", "model_bindless.frag", "model_raytraced.frag",
+                                      "model_compact.vert",
+                                      "skybox.vert", "skybox.frag", "shadowmap.vert", "shadowmap.frag",
+                                      "depth_prepass.vert", "gbuffer.frag", "motion_vectors.vert",
+                                      "motion_vectors.frag" });
+        if (m_HalfPrecisionShading) {
+            m_ShaderWatcher->AddVariant("model_half.frag", "model.frag", "MODEL_HALF_PRECISION");
+        }
+        m_ShaderWatcher->AddVariant("model_pulled.vert", "model.vert", "VERTEX_PULLING");
+        m_ShaderWatcher->AddVariant("shadowmap_pulled.vert", "shadowmap.vert", "VERTEX_PULLING");
+#else
+        METAGFX_WARN << "Shader hot reload needs glslc or glslangValidator when the build is configured";
+#endif
+    }
+
+    if (m_SceneDescription) {
+        m_ShowGroundPlane = m_SceneDescription->ground;
+    }
+
+    // A cube stands in until the initial model started above is resident
+    if (m_ModelLoad) {
+        if (m_SceneDescription && !m_SceneDescription->modelPath.empty()) {
+            m_InstanceGrid = IsHeadless() ? static_cast<int>(std::max(1u, m_Config.benchmark.instanceGrid)) : 1;
+        }
+        auto placeholder = std::make_unique<Model>();
+        if (placeholder->CreateCube(m_Device.get(), 1.0f)) {
+            SetModel(std::move(placeholder));
+        }
+    } else if (IsHeadless()) {
+        LoadBenchmarkScene();
+    }
 
     // Create ground plane for shadow visualization
     CreateGroundPlane();
@@ -428,234 +805,2264 @@ void Application::Init() {
     m_Running = true;
 }
 
+// Synchronous load, used for the benchmark's model
 void Application::LoadModel(const std::string& path) {
     METAGFX_INFO << "Loading model: " << path;
 
-    m_Model = std::make_unique<Model>();
-    if (!m_Model->LoadFromFile(m_Device.get(), path)) {
+    auto model = std::make_unique<Model>();
+    if (!model->LoadFromFile(m_Device.get(), path, m_TextureCache.get(), m_Config.modelImport)) {
         METAGFX_WARN << "Failed to load " << path << ", creating fallback cube";
-        if (!m_Model->CreateCube(m_Device.get(), 1.0f)) {
+        if (!model->CreateCube(m_Device.get(), 1.0f)) {
             METAGFX_ERROR << "Failed to create fallback cube model";
-            m_Model = nullptr;
             return;
         }
     }
 
-    // Extract model name from path for display
-    size_t lastSlash = path.find_last_of("/\\");
-    std::string modelName = (lastSlash != std::string::npos) ? path.substr(lastSlash + 1) : path;
-    METAGFX_INFO << "Model loaded: " << modelName;
+    SetModel(std::move(model));
+}
 
-    // Automatically frame camera to view the entire model
-    glm::vec3 center = m_Model->GetCenter();
-    glm::vec3 size = m_Model->GetSize();
-    float radius = m_Model->GetBoundingSphereRadius();
+// Load a model in the background; the current one stays on screen until it is resident
+void Application::RequestModelLoad(const std::string& path) {
+    m_PendingModelPath = path;
+    m_HasPendingModel = true;
+}
 
-    METAGFX_INFO << "Model bounds - Center: (" << center.x << ", " << center.y << ", " << center.z << ")";
-    METAGFX_INFO << "Model bounds - Size: (" << size.x << ", " << size.y << ", " << size.z << ")";
-    METAGFX_INFO << "Model bounds - Bounding sphere radius: " << radius;
+// Called at the start of each frame: advances the background load and starts pending ones
+void Application::UpdateModelLoad() {
+    METAGFX_PROFILE_FUNCTION();
+    if (m_ModelLoad) {
+        // A newer request supersedes the load in flight
+        if (m_HasPendingModel && m_ModelLoad->GetState() != ModelLoadState::Cancelled) {
+            m_ModelLoad->Cancel();
+        }
 
-    // Frame the camera to view the model with 30% margin
-    m_Camera->FrameBoundingBox(center, size, 1.3f);
+        switch (m_ModelLoad->Update(&m_FrameUploads)) {
+            case ModelLoadState::Ready:
+                SetModel(m_ModelLoad->TakeModel());
+                m_ModelLoad.reset();
+                break;
+            case ModelLoadState::Failed:
+                METAGFX_WARN << "Failed to load " << m_ModelLoad->GetFilePath() << ", keeping the current model";
+                m_ModelLoad.reset();
+                break;
+            case ModelLoadState::Cancelled:
+                m_ModelLoad.reset();
+                break;
+            default:
+                break;
+        }
+    }
 
-    // Update ground plane position based on model bounds
-    UpdateGroundPlanePosition();
+    if (!m_ModelLoad && m_HasPendingModel) {
+        m_HasPendingModel = false;
+        m_ModelLoad = Model::LoadFromFileAsync(m_Device.get(), m_PendingModelPath, m_TextureCache.get(),
+                                                m_Config.modelImport);
+    }
+}
 
-    METAGFX_INFO << "Camera framed at position: ("
-                 << m_Camera->GetPosition().x << ", "
-                 << m_Camera->GetPosition().y << ", "
-                 << m_Camera->GetPosition().z << ")";
+void Application::UpdateWorldCells() {
+    if (!m_WorldPartition || !m_WorldPartition->Update(m_FrameCamera->GetPosition(), &m_FrameUploads)) {
+        return;
+    }
+    AssignCellNodes();
+    CreateCellMaterialSets();
 }
 
-void Application::LoadNextModel() {
-    m_CurrentModelIndex = (m_CurrentModelIndex + 1) % m_AvailableModels.size();
-    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
+// The resident cells' model nodes in the scene graph nodes after the scene's, as world
+// matrices: a cell is in world space already, and flat nodes can be handed to any cell
+void Application::AssignCellNodes() {
+    m_CellNodeBases.clear();
+    if (!m_WorldPartition) {
+        return;
+    }
+
+    SceneGraph& sceneGraph = m_Scene->GetSceneGraph();
+    const std::vector<WorldPartition::Cell>& cells = m_WorldPartition->GetCells();
+    m_CellNodeBases.resize(cells.size(), SceneGraph::INVALID_NODE);
+    uint32 next = 0;
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const Model* model = cells[i].model.get();
+        if (cells[i].state != WorldPartition::CellState::Resident || !model) {
+            continue;
+        }
+        m_CellNodeBases[i] = m_CellNodeBase + next;
+        for (uint32 node = 0; node < model->GetNodeCount(); ++node, ++next) {
+            if (next < m_CellNodeCount) {
+                sceneGraph.SetLocalTransform(m_CellNodeBase + next, model->GetNodeWorldTransform(node));
+            } else {
+                sceneGraph.AddNode(model->GetNodeWorldTransform(node));
+                ++m_CellNodeCount;
+            }
+        }
+    }
+    if (m_CellNodeBase + next > m_TransformBuffer->GetCapacity()) {
+        METAGFX_WARN_ONCE << "World cells need " << m_CellNodeBase + next << " transform nodes, over the "
+                          << m_TransformBuffer->GetCapacity() << " of the transform buffer; the rest are not drawn";
+    }
 }
 
-void Application::LoadPreviousModel() {
-    m_CurrentModelIndex = (m_CurrentModelIndex - 1 + m_AvailableModels.size()) % m_AvailableModels.size();
-    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
+// A set per material of the resident cells, kept while some resident cell uses it
+void Application::CreateCellMaterialSets() {
+    std::unordered_map<const Material*, MaterialSet> previous;
+    previous.swap(m_CellMaterialSets);
+    if (m_WorldPartition && !m_MainBindings.empty()) {
+        for (const WorldPartition::Cell& cell : m_WorldPartition->GetCells()) {
+            if (cell.state != WorldPartition::CellState::Resident || !cell.model) {
+                continue;
+            }
+            for (const auto& mesh : cell.model->GetMeshes()) {
+                const Material* material = mesh ? mesh->GetMaterial() : nullptr;
+                if (!material || m_CellMaterialSets.count(material)) {
+                    continue;
+                }
+                auto it = previous.find(material);
+                if (it != previous.end()) {
+                    m_CellMaterialSets[material] = std::move(it->second);
+                    previous.erase(it);
+                } else {
+                    m_CellMaterialSets[material] = CreateMaterialSet(*material);
+                }
+            }
+        }
+    }
+
+    // The unloaded cells' sets may still be bound by frames in flight
+    for (auto& [material, materialSet] : previous) {
+        if (materialSet.set) {
+            m_Device->Retire(materialSet.set);
+        }
+    }
 }
 
-void Application::CreateTestLights() {
-    // Key light: Front-top directional light (main illumination)
-    // Modified to cast more obvious shadows - light comes from above-left-front
-    // This is the shadow-casting light, direction controlled by m_LightDirection
-    auto keyLight = std::make_unique<DirectionalLight>(
-        m_LightDirection,                  // Direction: controlled via UI
-        glm::vec3(1.0f, 1.0f, 1.0f),      // Pure white for neutral lighting
-        5.0f                               // High intensity for main light
-    );
-    m_Scene->AddLight(std::move(keyLight));
+// The meshes of resident cells in view, each with this frame's slice of its material;
+// pushed on the render thread, so recording the scenery only reads them
+void Application::PrepareCellDraws(const glm::mat4& viewProjection) {
+    m_CellDraws.clear();
+    if (!m_WorldPartition || !m_ShowWorldCells) {
+        return;
+    }
 
-    // Fill light: Side-back light for fill
-    auto fillLight = std::make_unique<DirectionalLight>(
-        glm::vec3(-0.7f, 0.0f, 0.5f),     // Direction: from side-back
-        glm::vec3(0.8f, 0.9f, 1.0f),      // Slight cool tint
-        2.5f                               // Medium intensity for fill
-    );
-    m_Scene->AddLight(std::move(fillLight));
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    const std::vector<WorldPartition::Cell>& cells = m_WorldPartition->GetCells();
+    const SceneGraph& sceneGraph = m_Scene->GetSceneGraph();
+    uint32 capacity = m_TransformBuffer->GetCapacity();
+    std::unordered_map<const Material*, uint32> materialOffsets;
+    for (size_t i = 0; i < cells.size() && i < m_CellNodeBases.size(); ++i) {
+        const WorldPartition::Cell& cell = cells[i];
+        if (cell.state != WorldPartition::CellState::Resident || !cell.model ||
+            m_CellNodeBases[i] == SceneGraph::INVALID_NODE ||
+            !frustum.IntersectsBox(cell.boundsMin, cell.boundsMax)) {
+            continue;
+        }
 
-    // Rim light: Back-top light for edge definition
-    auto rimLight = std::make_unique<DirectionalLight>(
-        glm::vec3(0.0f, -0.3f, 1.0f),     // Direction: from behind
-        glm::vec3(1.0f, 0.95f, 0.85f),    // Warm tint for rim
-        2.0f                               // Medium intensity
-    );
-    m_Scene->AddLight(std::move(rimLight));
+        const auto& meshes = cell.model->GetMeshes();
+        for (size_t m = 0; m < meshes.size(); ++m) {
+            const Mesh* mesh = meshes[m].get();
+            if (!mesh || !mesh->IsValid()) {
+                continue;
+            }
+            uint32 node = m_CellNodeBases[i] + cell.model->GetMeshNode(m);
+            const glm::mat4& world = sceneGraph.GetWorldTransform(node);
+            glm::vec3 center = glm::vec3(world * glm::vec4(mesh->GetBoundsCenter(), 1.0f));
+            float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                                     glm::length(glm::vec3(world[2])) });
+            if (node >= capacity || !frustum.IntersectsSphere(center, mesh->GetBoundsRadius() * scale)) {
+                continue;
+            }
 
-    // Point light: Close to model for local highlights
-    auto pointLight = std::make_unique<PointLight>(
-        glm::vec3(1.0f, 0.5f, -1.5f),     // Position: front-right of model
-        10.0f,                             // Range
-        glm::vec3(1.0f, 1.0f, 1.0f),      // White color
-        8.0f                               // High intensity
-    );
-    m_Scene->AddLight(std::move(pointLight));
+            CellDraw draw;
+            draw.mesh = mesh;
+            draw.node = node;
+            draw.materialSet = &m_DefaultMaterialSet;
+            if (const Material* material = mesh->GetMaterial()) {
+                auto setIt = m_CellMaterialSets.find(material);
+                if (setIt != m_CellMaterialSets.end()) {
+                    draw.materialSet = &setIt->second;
+                }
+                auto offset = materialOffsets.try_emplace(material, 0u);
+                if (offset.second) {
+                    offset.first->second = m_UniformRing->Push(material->GetProperties());
+                }
+                draw.materialOffset = offset.first->second;
+                draw.materialFlags = material->GetTextureFlags();
+            } else {
+                draw.materialOffset = m_UniformRing->Push(MaterialProperties{});
+            }
+            m_CellDraws.push_back(draw);
+        }
+    }
 
-    METAGFX_INFO << "Created " << m_Scene->GetLightCount() << " test lights";
+    // Material by material, so each set is bound once
+    std::sort(m_CellDraws.begin(), m_CellDraws.end(), [](const CellDraw& a, const CellDraw& b) {
+        return std::less<const MaterialSet*>()(a.materialSet, b.materialSet);
+    });
 }
 
-void Application::CreateGroundPlane() {
-    // Ground plane will be created/updated dynamically when a model is loaded
-    // See UpdateGroundPlanePosition()
+// Binding 8 of the lit sets: the environment's irradiance, fixed until the next environment
+Ref<rhi::Buffer> Application::CreateIrradianceSHBuffer(const utils::IrradianceSH& irradianceSH) {
+    rhi::BufferDesc desc{};
+    desc.size = sizeof(utils::IrradianceSH);
+    desc.usage = rhi::BufferUsage::Uniform;
+    desc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    desc.debugName = "IrradianceSH";
+    Ref<rhi::Buffer> buffer = m_Device->CreateBuffer(desc);
+    if (buffer) {
+        buffer->CopyData(&irradianceSH, sizeof(irradianceSH));
+    }
+    return buffer;
 }
 
-void Application::UpdateGroundPlanePosition() {
-    using namespace rhi;
+// Load and bake an HDR environment at the start of the next frame; the current maps stay
+// in use until the bake has finished
+void Application::RequestEnvironmentLoad(const std::string& path) {
+    if (!m_EnvironmentBaker) {
+        METAGFX_WARN << "Cannot bake " << path << ": runtime IBL baking is unavailable";
+        return;
+    }
+    m_PendingEnvironmentPath = path;
+}
 
-    if (!m_Model || !m_Model->IsValid()) {
+// Called after BeginFrame(): starts a requested bake and swaps in a finished one
+void Application::UpdateEnvironmentBake() {
+    if (!m_EnvironmentBaker) {
         return;
     }
+    METAGFX_PROFILE_FUNCTION();
+
+    // A requested bake starts once the startup maps are in, which it replaces
+    if (!m_PendingEnvironmentPath.empty() && !m_StartupEnvironment) {
+        std::string path = std::move(m_PendingEnvironmentPath);
+        m_PendingEnvironmentPath.clear();
+        Ref<rhi::Texture> equirect = utils::LoadHDRTexture(m_Device.get(), path);
+        if (!equirect) {
+            METAGFX_WARN << "Failed to load " << path << ", keeping the current environment";
+        } else if (m_EnvironmentBaker->Bake(equirect, m_BRDF_LUT == m_DefaultWhiteTexture)) {
+            METAGFX_INFO << "Baking environment " << path;
+        }
+    }
 
-    // Get model bounding box
-    glm::vec3 minBounds, maxBounds;
-    if (!m_Model->GetBoundingBox(minBounds, maxBounds)) {
+    m_EnvironmentBaker->BeginFrame();
+    EnvironmentBaker::Maps maps;
+    if (m_EnvironmentBaker->TakeMaps(maps)) {
+        SetEnvironmentMaps(maps.environment, maps.irradianceSH, maps.prefiltered,
+                           maps.brdfLut ? maps.brdfLut : m_BRDF_LUT);
+    }
+}
+
+// Called after BeginFrame(): uploads the startup IBL maps once the jobs reading them have
+// finished. IBL stays as the user set it; without all of the maps it stays off.
+void Application::UpdateStartupEnvironment() {
+    if (!m_StartupEnvironment || !m_StartupEnvironment->reads.IsDone()) {
         return;
     }
+    METAGFX_PROFILE_FUNCTION();
+    std::unique_ptr<StartupEnvironment> startup = std::move(m_StartupEnvironment);
 
-    // Position ground plane below the model's lowest point
-    // Add offset to ensure it's clearly below and avoid shadow acne
-    float modelHeight = maxBounds.y - minBounds.y;
-    float offset = glm::max(modelHeight * 0.3f, 0.5f);  // 30% of model height OR minimum 0.5 units
-    float groundY = minBounds.y - offset;
+    Ref<rhi::Texture> prefiltered = startup->prefilteredLoaded
+        ? utils::CreateTextureFromMipChain(m_Device.get(), startup->prefiltered, "prefiltered.dds") : nullptr;
+    Ref<rhi::Texture> brdfLut = startup->brdfLutLoaded
+        ? utils::CreateTextureFromMipChain(m_Device.get(), startup->brdfLut, "brdf_lut.dds") : nullptr;
+    Ref<rhi::Texture> environment = startup->environmentLoaded
+        ? utils::CreateTextureFromMipChain(m_Device.get(), startup->environment, "environment.dds") : nullptr;
 
-    METAGFX_INFO << "Model Y bounds: min=" << minBounds.y << ", max=" << maxBounds.y
-                 << ", ground plane Y=" << groundY;
+    if (!startup->irradianceLoaded || !prefiltered || !brdfLut) {
+        METAGFX_WARN << "Failed to load IBL textures! Using fallback textures.";
+        METAGFX_WARN << "IBL will be disabled. Generate textures using: ./bin/tools/ibl_precompute <input.hdr> assets/envmaps/studio/,"
+                     << " or drop an .hdr file on the window to bake them";
+        m_EnableIBL = false;
+        // The skybox still shows the environment when it loaded
+        if (environment && m_SkyboxDescriptorSet) {
+            m_EnvironmentMap = environment;
+            m_SkyboxDescriptorSet->UpdateTexture(1, m_EnvironmentMap, m_CubemapSampler);
+        }
+        return;
+    }
 
-    // Make ground plane large enough to show shadows
-    float planeSize = glm::max(maxBounds.x - minBounds.x, maxBounds.z - minBounds.z) * 2.0f;
-    planeSize = glm::max(planeSize, 15.0f);  // Minimum 15 units
+    bool enableIBL = m_EnableIBL;
+    SetEnvironmentMaps(environment ? environment : m_DefaultBlackCubemap, startup->irradianceSH, prefiltered, brdfLut);
+    m_EnableIBL = enableIBL;
+    METAGFX_INFO << "IBL textures loaded successfully";
+}
 
-    // Create a simple quad (two triangles) for the ground plane
-    std::vector<Vertex> vertices = {
-        // Position                                    Normal              TexCoord
-        { { -planeSize, groundY, -planeSize }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
-        { {  planeSize, groundY, -planeSize }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 0.0f } },
-        { {  planeSize, groundY,  planeSize }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 10.0f } },
-        { { -planeSize, groundY,  planeSize }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 10.0f } }
-    };
+// Point every set that samples the IBL maps or the skybox at new ones. The sets rewrite
+// their descriptors as each frame slot comes around, so the old maps are retired.
+void Application::SetEnvironmentMaps(Ref<rhi::Texture> environment, const utils::IrradianceSH& irradianceSH,
+                                     Ref<rhi::Texture> prefiltered, Ref<rhi::Texture> brdfLut) {
+    // Frames in flight still read the old coefficients, so they get a new buffer
+    Ref<rhi::Buffer> irradianceSHBuffer = CreateIrradianceSHBuffer(irradianceSH);
+    if (!irradianceSHBuffer) {
+        return;
+    }
+    m_Device->Retire(m_IrradianceSHBuffer);
+    for (const Ref<rhi::Texture>& old : { m_EnvironmentMap, m_PrefilteredMap, m_BRDF_LUT }) {
+        if (old && old != m_DefaultWhiteTexture && old != m_DefaultBlackCubemap) {
+            m_Device->Retire(old);
+        }
+    }
+    m_EnvironmentMap = environment;
+    m_IrradianceSHBuffer = irradianceSHBuffer;
+    m_PrefilteredMap = prefiltered;
+    m_BRDF_LUT = brdfLut;
+
+    for (rhi::DescriptorBindingDesc& mainBinding : m_MainBindings) {
+        if (mainBinding.binding == 8) {
+            mainBinding.buffer = m_IrradianceSHBuffer;
+        }
+    }
+    // The environment is in the frame set; material sets do not repeat it
+    m_DescriptorSet->UpdateBuffer(8, m_IrradianceSHBuffer);
+    if (m_BindlessDescriptorSet) {
+        m_BindlessDescriptorSet->UpdateBuffer(8, m_IrradianceSHBuffer);
+    }
+    if (m_DeferredLighting) {
+        m_DeferredLighting->SetSceneBuffer(8, m_IrradianceSHBuffer);
+    }
 
-    std::vector<uint32> indices = {
-        0, 2, 1,  // First triangle (clockwise from above = front face visible from below/side)
-        2, 0, 3   // Second triangle (clockwise from above = front face visible from below/side)
+    const std::pair<uint32, Ref<rhi::Texture>> iblBindings[] = {
+        { 9, m_PrefilteredMap }, { 10, m_BRDF_LUT }
     };
-
-    // Log vertex coordinates for debugging
-    METAGFX_INFO << "Ground plane vertices:";
+    for (const auto& [binding, texture] : iblBindings) {
+        Ref<rhi::Sampler> sampler = binding == 10 ? m_LinearRepeatSampler : m_CubemapSampler;
+        for (rhi::DescriptorBindingDesc& mainBinding : m_MainBindings) {
+            if (mainBinding.binding == binding) {
+                mainBinding.texture = texture;
+            }
+        }
+        m_DescriptorSet->UpdateTexture(binding, texture, sampler);
+        if (m_BindlessDescriptorSet) {
+            m_BindlessDescriptorSet->UpdateTexture(binding, texture, sampler);
+        }
+        if (m_DeferredLighting) {
+            m_DeferredLighting->SetSceneTexture(binding, texture, sampler);
+        }
+        if (m_PathTracer && binding == 9) {
+            m_PathTracer->SetSceneTexture(binding, texture, sampler);
+        }
+        if (m_LightProbes && binding == 9) {
+            m_LightProbes->SetSceneTexture(binding, texture, sampler);
+        }
+    }
+    if (m_SkyboxDescriptorSet) {
+        m_SkyboxDescriptorSet->UpdateTexture(1, m_EnvironmentMap, m_CubemapSampler);
+    }
+    m_EnableIBL = true;
+}
+
+// Make a loaded model current. The old one (and its material sets) may still be
+// referenced by frames in flight, so it goes through the deletion queue.
+void Application::SetModel(std::unique_ptr<Model> model) {
+    ReleaseMaterialDescriptorSets();
+    m_BindlessActive = false;
+    if (m_RayTracingScene) {
+        m_RayTracingScene->Clear();  // Its bottom levels are the old model's meshes
+    }
+
+    std::unique_ptr<Model> previous = m_Scene->SetModel(std::move(model));
+    if (previous) {
+        m_Device->Retire(Ref<Model>(std::move(previous)));
+    }
+    m_Model = m_Scene->GetModel();
+    const std::string& path = m_Model->GetFilePath();
+    m_TextureStreamer->SetModel(m_Model);
+
+    // Extract model name from path for display
+    size_t lastSlash = path.find_last_of("/\\");
+    std::string modelName = (lastSlash != std::string::npos) ? path.substr(lastSlash + 1) : path;
+    METAGFX_INFO << "Model loaded: " << modelName;
+
+    // Prefer the bindless table; per-material sets are the fallback
+    if (!BuildBindlessMaterialTable()) {
+        CreateMaterialDescriptorSets();
+    }
+
+    // Only pooled models are culled on the GPU (the draws index the pool's buffers)
+    if (m_GPUCuller) {
+        m_GPUCuller->SetModel(m_Model);
+        if (m_BindlessDescriptorSet && m_GPUCuller->GetRecordBuffer()) {
+            m_BindlessDescriptorSet->UpdateBuffer(30, m_GPUCuller->GetRecordBuffer());
+        }
+    }
+    // Pulled vertices are fetched from the pool the model is drawn from
+    if (const Ref<GeometryPool>& pool = m_Model->GetGeometryPool()) {
+        if (m_BindlessDescriptorSet) {
+            m_BindlessDescriptorSet->UpdateBuffer(23, pool->GetVertexBuffer());
+        }
+        m_ShadowDescriptorSet->UpdateBuffer(3, pool->GetVertexBuffer());
+    }
+    // The visibility resolve reads the same records, and the pool the model is drawn from
+    if (m_VisibilityBuffer && m_GPUCuller && m_BindlessActive && m_Model->GetGeometryPool()) {
+        m_VisibilityBuffer->SetGeometry(*m_Model, *m_GPUCuller, m_BindlessMaterialIndices);
+    }
+
+    // Dense material ids for the main pass's sort keys
+    m_MeshMaterialIds.clear();
+    std::unordered_map<const Material*, uint32> materialIds;
+    for (const auto& mesh : m_Model->GetMeshes()) {
+        const Material* material = mesh ? mesh->GetMaterial() : nullptr;
+        auto inserted = materialIds.emplace(material, static_cast<uint32>(materialIds.size()));
+        m_MeshMaterialIds.push_back(inserted.first->second);
+    }
+
+    // The first clip plays from the start; deformed meshes are posed from the first frame
+    m_Animator.reset();
+    if (!m_Model->GetAnimations().empty() || !m_Model->GetDeformedMeshes().empty()) {
+        m_Animator = std::make_unique<Animator>(*m_Model);
+        m_AnimationClip = m_Model->GetAnimations().empty() ? -1 : 0;
+        m_Animator->Play(m_AnimationClip < 0 ? Animator::NO_CLIP : 0);
+    }
+    if (m_Skinning) {
+        m_Skinning->SetModel(m_Model);
+    }
+
+    m_PickedMesh = -1;
+    RebuildSceneInstances();
+
+    // Automatically frame camera to view the entire model
+    glm::vec3 center = m_Model->GetCenter();
+    glm::vec3 size = m_Model->GetSize();
+    float radius = m_Model->GetBoundingSphereRadius();
+
+    METAGFX_INFO << "Model bounds - Center: (" << center.x << ", " << center.y << ", " << center.z << ")";
+    METAGFX_INFO << "Model bounds - Size: (" << size.x << ", " << size.y << ", " << size.z << ")";
+    METAGFX_INFO << "Model bounds - Bounding sphere radius: " << radius;
+
+    // Update ground plane position based on model bounds
+    UpdateGroundPlanePosition();
+
+    // Frame the camera to view the model with 30% margin, or place it where the scene file
+    // says. In pipelined mode this runs on the render thread, while the main thread may be
+    // moving the camera.
+    glm::vec3 minBounds, maxBounds;
+    if (GetSceneInstances() && GetPlacedBounds(minBounds, maxBounds)) {
+        center = (minBounds + maxBounds) * 0.5f;
+        size = maxBounds - minBounds;
+    }
+    std::lock_guard<std::mutex> lock(m_CameraMutex);
+    m_Camera->FrameBoundingBox(center, size, 1.3f);
+    if (m_SceneDescription && m_SceneDescription->hasCamera && m_Model->GetFilePath() == m_SceneDescription->modelPath) {
+        const SceneDescription::CameraKey& camera = m_SceneDescription->camera;
+        auto swapChain = m_Device->GetSwapChain();
+        float aspect = static_cast<float>(swapChain->GetWidth()) / static_cast<float>(std::max(1u, swapChain->GetHeight()));
+        m_Camera->SetPerspective(camera.fov, aspect, m_Camera->GetNearPlane(), m_Camera->GetFarPlane());
+        m_Camera->SetPosition(camera.position);
+        m_Camera->SetOrbitTarget(camera.hasTarget ? camera.target : center);
+    }
+
+    METAGFX_INFO << "Camera framed at position: ("
+                 << m_Camera->GetPosition().x << ", "
+                 << m_Camera->GetPosition().y << ", "
+                 << m_Camera->GetPosition().z << ")";
+}
+
+void Application::RebuildSceneInstances() {
+    // Mirror the model's hierarchy in the scene graph, node for node, then the ground
+    // plane's node. The model matrix is the identity, so node world matrices place the
+    // meshes, which are indexed in the scene BVH (user data = mesh index). Further grid
+    // copies get a root node each, with the model's nodes below it; so do the scene file's
+    // instances, but for a first one at the identity, which keeps the mirrored nodes.
+    m_Scene->ClearMeshInstances();
+    SceneGraph& sceneGraph = m_Scene->GetSceneGraph();
+    sceneGraph.Clear();
+    if (m_ShadowMap) {
+        m_ShadowMap->InvalidateCache();
+    }
+    if (m_ShadowAtlas) {
+        m_ShadowAtlas->Invalidate();
+    }
+    RestartDepthPrepassProbe();  // Overdraw is the new scene's
+    if (m_TemporalAA) {
+        m_TemporalAA->ResetHistory();
+    }
+    if (m_AmbientOcclusion) {
+        m_AmbientOcclusion->ResetHistory();
+    }
+    if (m_Reflections) {
+        m_Reflections->ResetHistory();
+    }
+    if (m_ShadingRate) {
+        m_ShadingRate->ResetRates();  // The last scene's rates
+    }
+    m_LodSelector.Reset();  // Instance ids start over
+    m_ModelNodeBases.clear();
+    m_CellNodeCount = 0;
+    if (!m_Model || !m_Model->IsValid()) {
+        m_GroundNode = sceneGraph.AddNode(glm::mat4(1.0f));
+        m_CellNodeBase = sceneGraph.GetNodeCount();
+        AssignCellNodes();
+        return;
+    }
+
+    uint32 modelNodes = m_Model->GetNodeCount();
+    for (uint32 node = 0; node < modelNodes; ++node) {
+        uint32 parent = m_Model->GetNodeParent(node);
+        sceneGraph.AddNode(m_Model->GetNodeLocalTransform(node),
+                           parent == NodeData::NO_PARENT ? SceneGraph::INVALID_NODE : parent);
+    }
+    m_GroundNode = sceneGraph.AddNode(glm::mat4(1.0f));
+
+    // Every node must fit the transform buffer
+    const std::vector<glm::mat4>* instances = GetSceneInstances();
+    uint32 copies = instances ? static_cast<uint32>(instances->size()) : static_cast<uint32>(m_InstanceGrid * m_InstanceGrid);
+    uint32 capacity = m_TransformBuffer->GetCapacity();
+    uint32 maxCopies = modelNodes + 1 < capacity ? 1 + (capacity - modelNodes - 1) / (modelNodes + 1) : 1;
+    if (instances && maxCopies > 1 && (*instances)[0] != glm::mat4(1.0f)) {
+        --maxCopies;  // The first instance has nodes of its own too
+    }
+    if (copies > maxCopies) {
+        METAGFX_WARN << (instances ? "Scene instances" : "Instance grid") << " limited to " << maxCopies
+                     << " copies of " << modelNodes << " nodes";
+        copies = maxCopies;
+    }
+
+    float spacing = GetInstanceGridSpacing();
+    const auto& meshes = m_Model->GetMeshes();
+    for (uint32 copy = 0; copy < copies; ++copy) {
+        uint32 nodeBase = 0;
+        glm::mat4 placement(1.0f);
+        if (instances) {
+            placement = (*instances)[copy];
+        } else if (copy > 0) {
+            glm::vec3 offset(static_cast<float>(copy % m_InstanceGrid) * spacing, 0.0f,
+                             static_cast<float>(copy / m_InstanceGrid) * spacing);
+            placement = glm::translate(glm::mat4(1.0f), offset);
+        }
+        if (copy > 0 || placement != glm::mat4(1.0f)) {
+            uint32 root = sceneGraph.AddNode(placement);
+            nodeBase = sceneGraph.GetNodeCount();
+            for (uint32 node = 0; node < modelNodes; ++node) {
+                uint32 parent = m_Model->GetNodeParent(node);
+                sceneGraph.AddNode(m_Model->GetNodeLocalTransform(node),
+                                   parent == NodeData::NO_PARENT ? root : nodeBase + parent);
+            }
+        }
+        m_ModelNodeBases.push_back(nodeBase);
+
+        for (uint32 i = 0; i < static_cast<uint32>(meshes.size()); ++i) {
+            if (meshes[i] && meshes[i]->IsValid()) {
+                uint32 node = nodeBase + m_Model->GetMeshNode(i);
+                uint32 instance = m_Scene->AddMeshInstance(meshes[i].get(), sceneGraph.GetWorldTransform(node), i);
+                m_Scene->SetMeshInstanceNode(instance, node);
+            }
+        }
+    }
+    m_CellNodeBase = sceneGraph.GetNodeCount();
+    AssignCellNodes();
+
+    // The top level names these instances by their index
+    if (m_PathTracer && m_BindlessActive && m_Model->GetGeometryPool()) {
+        m_PathTracer->SetGeometry(*m_Scene, *m_Model->GetGeometryPool(), m_BindlessMaterialIndices);
+    }
+    if (m_LightProbes && m_BindlessActive && m_Model->GetGeometryPool()) {
+        m_LightProbes->SetGeometry(*m_Scene, *m_Model->GetGeometryPool(), m_BindlessMaterialIndices);
+    }
+}
+
+// Copy the animator's local transforms into the scene graph, for every grid copy: the
+// nodes its clip drives, or with allNodes every model node (after a clip change)
+void Application::ApplyAnimatedNodes(bool allNodes) {
+    SceneGraph& sceneGraph = m_Scene->GetSceneGraph();
+    uint32 nodeCount = m_Model->GetNodeCount();
+    for (uint32 nodeBase : m_ModelNodeBases) {
+        if (allNodes) {
+            for (uint32 node = 0; node < nodeCount; ++node) {
+                sceneGraph.SetLocalTransform(nodeBase + node, m_Animator->GetLocalTransform(node));
+            }
+        } else {
+            for (uint32 node : m_Animator->GetAnimatedNodes()) {
+                sceneGraph.SetLocalTransform(nodeBase + node, m_Animator->GetLocalTransform(node));
+            }
+        }
+    }
+}
+
+// Auto times both depth prepass modes again from the next frame on
+void Application::RestartDepthPrepassProbe() {
+    m_DepthPrepassProbeFrame = 0;
+    m_DepthPrepassGpuMs[0] = m_DepthPrepassGpuMs[1] = 0.0;
+    m_DepthPrepassSamples[0] = m_DepthPrepassSamples[1] = 0;
+}
+
+// Distance between neighbouring copies of the instance grid
+float Application::GetInstanceGridSpacing() const {
+    glm::vec3 size = m_Model->GetSize();
+    return std::max(size.x, size.z) * 1.25f;
+}
+
+void Application::GetSceneOrbit(glm::vec3& outTarget, float& outRadius) const {
+    glm::vec3 minBounds, maxBounds;
+    if (GetSceneInstances() && GetPlacedBounds(minBounds, maxBounds)) {
+        outTarget = (minBounds + maxBounds) * 0.5f;
+        outRadius = glm::length(maxBounds - minBounds) * 0.5f * 2.5f;
+        return;
+    }
+    float gridExtent = GetInstanceGridSpacing() * static_cast<float>(m_InstanceGrid - 1);
+    outTarget = m_Model->GetCenter() + glm::vec3(gridExtent * 0.5f, 0.0f, gridExtent * 0.5f);
+    outRadius = std::max(m_Model->GetBoundingSphereRadius(), gridExtent * 0.75f) * 2.5f;
+}
+
+const std::vector<glm::mat4>* Application::GetSceneInstances() const {
+    if (!m_SceneDescription || m_SceneDescription->instances.empty() || !m_Model ||
+        m_Model->GetFilePath() != m_SceneDescription->modelPath) {
+        return nullptr;
+    }
+    return &m_SceneDescription->instances;
+}
+
+bool Application::GetPlacedBounds(glm::vec3& outMin, glm::vec3& outMax) const {
+    glm::vec3 minBounds, maxBounds;
+    if (!m_Model || !m_Model->GetBoundingBox(minBounds, maxBounds)) {
+        return false;
+    }
+    const std::vector<glm::mat4>* instances = GetSceneInstances();
+    if (!instances) {
+        outMin = minBounds;
+        outMax = maxBounds;
+        return true;
+    }
+
+    // The box of each instance's transformed corners
+    outMin = glm::vec3(std::numeric_limits<float>::max());
+    outMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const glm::mat4& instance : *instances) {
+        for (uint32 corner = 0; corner < 8; ++corner) {
+            glm::vec3 point((corner & 1) ? maxBounds.x : minBounds.x, (corner & 2) ? maxBounds.y : minBounds.y,
+                            (corner & 4) ? maxBounds.z : minBounds.z);
+            glm::vec3 placed = glm::vec3(instance * glm::vec4(point, 1.0f));
+            outMin = glm::min(outMin, placed);
+            outMax = glm::max(outMax, placed);
+        }
+    }
+    return true;
+}
+
+bool Application::IsSceneModelShown() const {
+    return !m_SceneDescription || m_SceneDescription->modelPath.empty() ||
+           (m_Model && m_Model->GetFilePath() == m_SceneDescription->modelPath);
+}
+
+bool Application::IsSceneLoading() const {
+    return m_StartupEnvironment || m_ModelLoad || m_HasPendingModel || !m_PendingEnvironmentPath.empty() ||
+           (m_EnvironmentBaker && m_EnvironmentBaker->IsBaking()) ||
+           (m_WorldPartition && m_WorldPartition->GetStats().loadsInFlight > 0);
+}
+
+// ApplicationConfig::scenePath; Init() applies its parts as the systems they replace
+// are created
+bool Application::ReadSceneFile(const std::string& path) {
+    auto description = std::make_unique<SceneDescription>();
+    std::string error;
+    if (!SceneDescription::Load(path, *description, &error)) {
+        METAGFX_ERROR << "Failed to load scene " << path << ": " << error;
+        return false;
+    }
+    METAGFX_INFO << "Scene " << path << ": "
+                 << (description->modelPath.empty() ? "default model" : description->modelPath) << ", "
+                 << std::max<size_t>(1, description->instances.size()) << " instances, "
+                 << (description->hasLights ? std::to_string(description->lights.size()) : "default") << " lights, "
+                 << description->cameraPath.size() << " camera path keys, " << description->cells.size() << " cells";
+    m_SceneDescription = std::move(description);
+    return true;
+}
+
+// The first directional light is the key light, aimed by m_LightDirection
+void Application::ApplySceneLights(const SceneDescription& description) {
+    m_KeyLight = Scene::INVALID_LIGHT;
+    for (const SceneDescription::LightDesc& desc : description.lights) {
+        Scene::LightHandle light = Scene::INVALID_LIGHT;
+        switch (desc.type) {
+            case LightType::Directional:
+                light = m_Scene->AddLight(DirectionalLight(desc.direction, desc.color, desc.intensity));
+                if (m_KeyLight == Scene::INVALID_LIGHT) {
+                    m_KeyLight = light;
+                    m_LightDirection = desc.direction;
+                }
+                break;
+            case LightType::Point: {
+                PointLight pointLight(desc.position, desc.range, desc.color, desc.intensity);
+                pointLight.SetCastsShadows(desc.castsShadows);
+                light = m_Scene->AddLight(pointLight);
+                break;
+            }
+            case LightType::Spot: {
+                SpotLight spotLight(desc.position, desc.direction, desc.innerCone, desc.outerCone, desc.range,
+                                    desc.color, desc.intensity);
+                spotLight.SetCastsShadows(desc.castsShadows);
+                light = m_Scene->AddLight(spotLight);
+                break;
+            }
+        }
+        if (light == Scene::INVALID_LIGHT) {
+            METAGFX_WARN << "Scene light limit reached, " << m_Scene->GetLightCount() << " lights created";
+            break;
+        }
+    }
+    if (m_KeyLight == Scene::INVALID_LIGHT) {
+        METAGFX_INFO << "Scene has no directional light: no cascaded shadows";
+    }
+}
+
+// Linear between neighbouring keys: the path is sampled at a fixed rate, so its speed
+// follows the keys' spacing
+SceneDescription::CameraKey Application::GetCameraPathKey(float t, const glm::vec3& center) const {
+    const std::vector<SceneDescription::CameraKey>& path = m_SceneDescription->cameraPath;
+    auto targetOf = [&](const SceneDescription::CameraKey& key) { return key.hasTarget ? key.target : center; };
+
+    float position = (t - std::floor(t)) * static_cast<float>(path.size());
+    size_t first = std::min(static_cast<size_t>(position), path.size() - 1);
+    const SceneDescription::CameraKey& from = path[first];
+    const SceneDescription::CameraKey& to = path[(first + 1) % path.size()];
+    float blend = position - static_cast<float>(first);
+
+    SceneDescription::CameraKey key = from;
+    key.position = glm::mix(from.position, to.position, blend);
+    key.target = glm::mix(targetOf(from), targetOf(to), blend);
+    key.hasTarget = true;
+    key.fov = glm::mix(from.fov, to.fov, blend);
+    return key;
+}
+
+void Application::LoadBenchmarkScene() {
+    m_InstanceGrid = static_cast<int>(std::max(1u, m_Config.benchmark.instanceGrid));
+    if (!m_Config.benchmark.modelPath.empty()) {
+        LoadModel(m_Config.benchmark.modelPath);
+        return;
+    }
+
+    auto model = std::make_unique<Model>();
+    if (!model->CreateCube(m_Device.get(), 1.0f)) {
+        METAGFX_ERROR << "Failed to create benchmark cube model";
+        return;
+    }
+    SetModel(std::move(model));
+}
+
+void Application::CreateMaterialDescriptorSets() {
+    if (!m_Model || m_MainBindings.empty()) {
+        return;
+    }
+
+    for (const auto& mesh : m_Model->GetMeshes()) {
+        if (!mesh || !mesh->GetMaterial()) {
+            continue;
+        }
+
+        const Material* material = mesh->GetMaterial();
+        if (m_MaterialDescriptorSets.count(material)) {
+            continue;  // Shared by several meshes
+        }
+        m_MaterialDescriptorSets[material] = CreateMaterialSet(*material);
+    }
+
+    METAGFX_INFO << "Created " << m_MaterialDescriptorSets.size()
+                 << (m_PushMaterialDescriptors ? " pushed" : "") << " material descriptor sets";
+}
+
+// Set 2 of the model pipelines: the material's PBR textures or the defaults
+Application::MaterialSet Application::CreateMaterialSet(const Material& material) {
+    std::vector<rhi::DescriptorBindingDesc> bindings = SelectModelSetBindings(m_MainBindings, ModelSetMaterial);
+    SetMaterialTexture(bindings, 2, material.GetAlbedoMap(), m_DefaultTexture);
+    SetMaterialTexture(bindings, 4, material.GetNormalMap(), m_DefaultNormalMap);
+
+    Ref<rhi::Texture> metallicRoughnessMap = material.GetMetallicRoughnessMap();
+    if (metallicRoughnessMap) {
+        // Use combined texture for both metallic (binding 5) and roughness (binding 6)
+        SetMaterialTexture(bindings, 5, metallicRoughnessMap, nullptr);
+        SetMaterialTexture(bindings, 6, metallicRoughnessMap, nullptr);
+    } else {
+        SetMaterialTexture(bindings, 5, material.GetMetallicMap(), m_DefaultWhiteTexture);
+        SetMaterialTexture(bindings, 6, material.GetRoughnessMap(), m_DefaultWhiteTexture);
+    }
+
+    SetMaterialTexture(bindings, 7, material.GetAOMap(), m_DefaultWhiteTexture);
+    SetMaterialTexture(bindings, 11, material.GetEmissiveMap(), m_DefaultBlackTexture);
+
+    MaterialSet materialSet;
+    if (!m_PushMaterialDescriptors) {
+        rhi::DescriptorSetDesc desc;
+        desc.bindings = bindings;
+        desc.debugName = "MaterialDescriptorSet";
+        materialSet.set = m_Device->CreateDescriptorSet(desc);
+    }
+    materialSet.bindings = std::move(bindings);
+    return materialSet;
+}
+
+void Application::BindMaterialSet(rhi::CommandBuffer& cmd, const Ref<rhi::Pipeline>& pipeline,
+                                  const MaterialSet& materialSet, uint32 materialOffset) const {
+    if (m_PushMaterialDescriptors) {
+        cmd.PushDescriptorSet(pipeline, 2, materialSet.bindings, &materialOffset, 1);
+    } else {
+        cmd.BindDescriptorSet(pipeline, 2, materialSet.set, m_CurrentFrame, &materialOffset, 1);
+    }
+}
+
+void Application::BindSceneTopLevel(const Ref<rhi::AccelerationStructure>& topLevel) {
+    for (rhi::DescriptorBindingDesc& mainBinding : m_MainBindings) {
+        if (mainBinding.binding == 22) {
+            if (mainBinding.accelerationStructure == topLevel) {
+                return;
+            }
+            mainBinding.accelerationStructure = topLevel;
+        }
+    }
+    m_DescriptorSet->UpdateAccelerationStructure(22, topLevel);
+}
+
+void Application::ReleaseMaterialDescriptorSets() {
+    if (m_MaterialDescriptorSets.empty()) {
+        return;
+    }
+
+    // The sets may still be referenced by frames in flight
+    for (auto& [material, materialSet] : m_MaterialDescriptorSets) {
+        if (materialSet.set) {
+            m_Device->Retire(materialSet.set);
+        }
+    }
+    m_MaterialDescriptorSets.clear();
+}
+
+// Warn once each time device memory use climbs past the warning fraction of its budget,
+// before the driver starts paging resources out of device memory. Back under a little
+// lower, so usage at the threshold does not warn every frame.
+void Application::CheckMemoryBudget() {
+    rhi::MemoryStats memory = m_Device->GetMemoryStats();
+    float fraction = m_Config.memoryWarningFraction;
+    if (!m_MemoryNearBudget && memory.IsOverBudget(fraction)) {
+        m_MemoryNearBudget = true;
+        METAGFX_WARN << "Device memory: " << memory.GetUsageBytes() / (1024 * 1024) << " of "
+                     << memory.budget.budgetBytes / (1024 * 1024) << " MB budget in use ("
+                     << memory.GetBytes(rhi::MemoryCategory::Texture) / (1024 * 1024) << " MB textures, "
+                     << memory.GetBytes(rhi::MemoryCategory::RenderTarget) / (1024 * 1024) << " MB render targets, "
+                     << memory.GetBytes(rhi::MemoryCategory::Geometry) / (1024 * 1024) << " MB geometry)";
+    } else if (m_MemoryNearBudget && !memory.IsOverBudget(fraction - 0.05f)) {
+        m_MemoryNearBudget = false;
+        METAGFX_INFO << "Device memory back under " << static_cast<int>((fraction - 0.05f) * 100.0f)
+                     << "% of its budget";
+    }
+}
+
+// Rebind the model's material textures after some were replaced (texture streaming)
+void Application::RefreshMaterialBindings() {
+    ReleaseMaterialDescriptorSets();
+    if (!BuildBindlessMaterialTable()) {
+        CreateMaterialDescriptorSets();
+    }
+}
+
+void Application::CreateBindlessDescriptorSet() {
+    using rhi::DescriptorType;
+    using rhi::ShaderStage;
+    using rhi::DescriptorBindingDesc;
+
+    const rhi::DeviceInfo& info = m_Device->GetDeviceInfo();
+    if (!info.supportsBindlessTextures || info.maxBindlessTextures < BINDLESS_TEXTURE_CAPACITY) {
+        METAGFX_INFO << "Bindless materials unavailable (device supports " << info.maxBindlessTextures
+                     << " table textures, need " << BINDLESS_TEXTURE_CAPACITY << "); using per-material sets";
+        return;
+    }
+
+    // Placeholder material buffer so binding 1 is valid before the first model is loaded
+    rhi::BufferDesc materialBufferDesc{};
+    materialBufferDesc.size = sizeof(BindlessMaterialData);
+    materialBufferDesc.usage = rhi::BufferUsage::Storage;
+    materialBufferDesc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    materialBufferDesc.debugName = "BindlessMaterialBuffer";
+    m_BindlessMaterialBuffer = m_Device->CreateBuffer(materialBufferDesc);
+
+    // Matches model_bindless.frag: material textures come from binding 14, everything
+    // else keeps the binding numbers of the main set
+    std::vector<DescriptorBindingDesc> bindings = {
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Vertex | ShaderStage::Fragment, m_UniformRing->GetBuffer(), nullptr, nullptr, sizeof(UniformBufferObject) },  // MVP matrices + frame constants
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_BindlessMaterialBuffer, nullptr, nullptr },  // Material table
+        { 3, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_Scene->GetLightBuffer(), nullptr, nullptr },  // Lights
+        { 8, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_IrradianceSHBuffer, nullptr, nullptr },  // Irradiance SH
+        { 9, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_PrefilteredMap, m_CubemapSampler },  // Prefiltered
+        { 10, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_BRDF_LUT, m_LinearRepeatSampler },  // BRDF LUT
+        { 12, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowMap->GetDepthTexture(), m_ShadowMap->GetSampler() },  // Shadow map
+        { 13, DescriptorType::UniformBuffer, ShaderStage::Fragment, m_ShadowUniformBuffer, nullptr, nullptr },  // Shadow UBO
+        { 14, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, nullptr, 0, BINDLESS_TEXTURE_CAPACITY },  // Texture table
+        { 15, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_TransformBuffer->GetBuffer(), nullptr, nullptr },  // Node transforms
+        { 16, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_InstanceBuffer->GetBuffer(), nullptr, nullptr },  // Instance nodes
+        { 17, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_LightClusters->GetBuffer(), nullptr, nullptr },  // Light clusters
+        { 18, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowAtlas->GetDepthTexture(), m_ShadowAtlas->GetSampler() },  // Shadow atlas
+        { 19, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_ShadowAtlas->GetBuffer(), nullptr, nullptr },  // Shadow atlas faces
+        { 20, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_ShadowMap->GetDepthTexture(), m_ShadowMap->GetDepthSampler() },  // Shadow map depth (PCSS)
+        { 21, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr,
+          m_ShadowMoments ? m_ShadowMoments->GetTexture() : m_DefaultWhiteTexture,
+          m_ShadowMoments ? m_ShadowMoments->GetSampler() : m_LinearRepeatSampler },  // Shadow moments (EVSM)
+        { 29, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_LightProbeBuffer, nullptr, nullptr },  // Light probes
+        { 23, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_InstanceBuffer->GetBuffer(), nullptr, nullptr },  // Pooled vertices (vertex pulling; the model's once it has a pool)
+        { 30, DescriptorType::StorageBuffer, ShaderStage::Vertex, m_InstanceBuffer->GetBuffer(), nullptr, nullptr }  // Draw records (visibility pass; the culler's once a model is culled)
+    };
+
+    rhi::DescriptorSetDesc desc;
+    desc.bindings = bindings;
+    desc.debugName = "BindlessDescriptorSet";
+    m_BindlessDescriptorSet = m_Device->CreateDescriptorSet(desc);
+    m_BindlessSupported = m_BindlessDescriptorSet != nullptr;
+}
+
+bool Application::BuildBindlessMaterialTable() {
+    m_BindlessMaterialIndices.clear();
+    m_BindlessActive = false;
+
+    if (!m_BindlessSupported || !m_Model) {
+        return false;
+    }
+
+    // Each unique texture gets one table element; materials store element indices
+    std::vector<Ref<rhi::Texture>> textures;
+    std::unordered_map<const rhi::Texture*, uint32> textureIndices;
+    auto addTexture = [&](const Ref<rhi::Texture>& texture) -> uint32 {
+        auto it = textureIndices.find(texture.get());
+        if (it != textureIndices.end()) {
+            return it->second;
+        }
+        uint32 index = static_cast<uint32>(textures.size());
+        textures.push_back(texture);
+        textureIndices[texture.get()] = index;
+        return index;
+    };
+
+    std::vector<BindlessMaterialData> materials;
+    for (const auto& mesh : m_Model->GetMeshes()) {
+        if (!mesh || !mesh->GetMaterial()) {
+            continue;
+        }
+
+        const Material* material = mesh->GetMaterial();
+        if (m_BindlessMaterialIndices.count(material)) {
+            continue;  // Shared by several meshes
+        }
+
+        const MaterialProperties& props = material->GetProperties();
+        BindlessMaterialData data{};
+        data.albedo = props.albedo;
+        data.roughness = props.roughness;
+        data.emissiveFactor = props.emissiveFactor;
+        data.metallic = props.metallic;
+
+        Ref<rhi::Texture> albedoMap = material->GetAlbedoMap();
+        data.albedoIndex = addTexture(albedoMap ? albedoMap : m_DefaultTexture);
+
+        Ref<rhi::Texture> normalMap = material->GetNormalMap();
+        data.normalIndex = addTexture(normalMap ? normalMap : m_DefaultNormalMap);
+
+        Ref<rhi::Texture> metallicRoughnessMap = material->GetMetallicRoughnessMap();
+        if (metallicRoughnessMap) {
+            // Combined texture serves both metallic and roughness lookups
+            data.metallicIndex = addTexture(metallicRoughnessMap);
+            data.roughnessIndex = data.metallicIndex;
+        } else {
+            Ref<rhi::Texture> metallicMap = material->GetMetallicMap();
+            Ref<rhi::Texture> roughnessMap = material->GetRoughnessMap();
+            data.metallicIndex = addTexture(metallicMap ? metallicMap : m_DefaultWhiteTexture);
+            data.roughnessIndex = addTexture(roughnessMap ? roughnessMap : m_DefaultWhiteTexture);
+        }
+
+        Ref<rhi::Texture> aoMap = material->GetAOMap();
+        data.aoIndex = addTexture(aoMap ? aoMap : m_DefaultWhiteTexture);
+
+        Ref<rhi::Texture> emissiveMap = material->GetEmissiveMap();
+        data.emissiveIndex = addTexture(emissiveMap ? emissiveMap : m_DefaultBlackTexture);
+        data.textureFlags = material->GetTextureFlags();
+        data.alphaParams = glm::packHalf2x16(glm::vec2(props.alpha, props.alphaCutoff));
+
+        m_BindlessMaterialIndices[material] = static_cast<uint32>(materials.size());
+        materials.push_back(data);
+    }
+
+    if (materials.empty()) {
+        return false;
+    }
+
+    if (textures.size() > BINDLESS_TEXTURE_CAPACITY) {
+        METAGFX_WARN << "Model uses " << textures.size() << " textures, bindless table holds "
+                     << BINDLESS_TEXTURE_CAPACITY << "; falling back to per-material sets";
+        m_BindlessMaterialIndices.clear();
+        return false;
+    }
+
+    // A fresh buffer per model: the previous one may still be read by frames in flight
+    rhi::BufferDesc bufferDesc{};
+    bufferDesc.size = materials.size() * sizeof(BindlessMaterialData);
+    bufferDesc.usage = rhi::BufferUsage::Storage;
+    bufferDesc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    bufferDesc.debugName = "BindlessMaterialBuffer";
+    Ref<rhi::Buffer> materialBuffer = m_Device->CreateBuffer(bufferDesc);
+    if (!materialBuffer) {
+        METAGFX_ERROR << "Failed to create bindless material buffer";
+        m_BindlessMaterialIndices.clear();
+        return false;
+    }
+    materialBuffer->CopyData(materials.data(), bufferDesc.size);
+
+    m_Device->Retire(m_BindlessMaterialBuffer);
+    m_BindlessMaterialBuffer = materialBuffer;
+    m_BindlessDescriptorSet->UpdateBuffer(1, m_BindlessMaterialBuffer);
+
+    // Only elements that changed are rewritten; leftovers of the previous model are cleared
+    uint32 textureCount = static_cast<uint32>(textures.size());
+    uint32 elementCount = std::max(textureCount, m_BindlessTextureCount);
+    for (uint32 i = 0; i < elementCount; ++i) {
+        if (i < textureCount) {
+            m_BindlessDescriptorSet->UpdateTextureArrayElement(14, i, textures[i], m_LinearRepeatSampler);
+        } else {
+            m_BindlessDescriptorSet->UpdateTextureArrayElement(14, i, nullptr, nullptr);
+        }
+    }
+    m_BindlessTextureCount = textureCount;
+    m_BindlessActive = true;
+    if (m_PathTracer) {
+        m_PathTracer->SetMaterials(m_BindlessMaterialBuffer, textures, m_LinearRepeatSampler);
+    }
+    if (m_LightProbes) {
+        m_LightProbes->SetMaterials(m_BindlessMaterialBuffer, textures, m_LinearRepeatSampler);
+    }
+    if (m_VisibilityBuffer) {
+        m_VisibilityBuffer->SetMaterials(m_BindlessMaterialBuffer, textures, m_LinearRepeatSampler);
+    }
+
+    METAGFX_INFO << "Bindless material table: " << materials.size() << " materials, "
+                 << textureCount << " textures";
+    return true;
+}
+
+void Application::LoadNextModel() {
+    m_CurrentModelIndex = (m_CurrentModelIndex + 1) % m_AvailableModels.size();
+    RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+}
+
+void Application::LoadPreviousModel() {
+    m_CurrentModelIndex = (m_CurrentModelIndex - 1 + m_AvailableModels.size()) % m_AvailableModels.size();
+    RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+}
+
+void Application::CreateTestLights() {
+    // Key light: Front-top directional light (main illumination)
+    // Modified to cast more obvious shadows - light comes from above-left-front
+    // This is the shadow-casting light, direction controlled by m_LightDirection
+    // Added first, so it is the first directional light model.frag shadows
+    m_KeyLight = m_Scene->AddLight(DirectionalLight(
+        m_LightDirection,                  // Direction: controlled via UI
+        glm::vec3(1.0f, 1.0f, 1.0f),      // Pure white for neutral lighting
+        5.0f                               // High intensity for main light
+    ));
+
+    // Fill light: Side-back light for fill
+    m_Scene->AddLight(DirectionalLight(
+        glm::vec3(-0.7f, 0.0f, 0.5f),     // Direction: from side-back
+        glm::vec3(0.8f, 0.9f, 1.0f),      // Slight cool tint
+        2.5f                               // Medium intensity for fill
+    ));
+
+    // Rim light: Back-top light for edge definition
+    m_Scene->AddLight(DirectionalLight(
+        glm::vec3(0.0f, -0.3f, 1.0f),     // Direction: from behind
+        glm::vec3(1.0f, 0.95f, 0.85f),    // Warm tint for rim
+        2.0f                               // Medium intensity
+    ));
+
+    // Point light: Close to model for local highlights, shadowed through the atlas
+    PointLight pointLight(
+        glm::vec3(1.0f, 0.5f, -1.5f),     // Position: front-right of model
+        10.0f,                             // Range
+        glm::vec3(1.0f, 1.0f, 1.0f),      // White color
+        8.0f                               // High intensity
+    );
+    pointLight.SetCastsShadows(true);
+    m_Scene->AddLight(pointLight);
+
+    METAGFX_INFO << "Created " << m_Scene->GetLightCount() << " test lights";
+}
+
+// Replaces the UI's random point lights: scattered over the model's bounds (or around
+// the origin), each reaching a fraction of them
+void Application::UpdateClusterTestLights() {
+    for (Scene::LightHandle light : m_ClusterTestLights) {
+        m_Scene->RemoveLight(light);
+    }
+    m_ClusterTestLights.clear();
+
+    glm::vec3 minBounds, maxBounds;
+    if (!m_Model || !m_Model->IsValid() || !m_Model->GetBoundingBox(minBounds, maxBounds)) {
+        minBounds = glm::vec3(-5.0f);
+        maxBounds = glm::vec3(5.0f);
+    }
+    glm::vec3 extent = glm::max(maxBounds - minBounds, glm::vec3(0.1f));
+    float range = glm::max(glm::length(extent) * 0.1f, 0.5f);
+
+    std::mt19937 random(1234);  // Same lights for the same count
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < m_ClusterTestLightCount; ++i) {
+        glm::vec3 position = minBounds + extent * glm::vec3(unit(random), unit(random), unit(random));
+        glm::vec3 color = glm::vec3(unit(random), unit(random), unit(random)) * 0.8f + 0.2f;
+        PointLight pointLight(position, range, color, 2.0f);
+        pointLight.SetCastsShadows(m_ClusterTestLightShadows);
+        Scene::LightHandle light = m_Scene->AddLight(pointLight);
+        if (light == Scene::INVALID_LIGHT) {
+            break;
+        }
+        m_ClusterTestLights.push_back(light);
+    }
+}
+
+void Application::CreateGroundPlane() {
+    // Ground plane will be created/updated dynamically when a model is loaded
+    // See UpdateGroundPlanePosition()
+}
+
+void Application::UpdateGroundPlanePosition() {
+    using namespace rhi;
+
+    if (!m_Model || !m_Model->IsValid()) {
+        return;
+    }
+
+    // Get the bounding box of the model as placed
+    glm::vec3 minBounds, maxBounds;
+    if (!GetPlacedBounds(minBounds, maxBounds)) {
+        return;
+    }
+
+    // Position ground plane below the model's lowest point
+    // Add offset to ensure it's clearly below and avoid shadow acne
+    float modelHeight = maxBounds.y - minBounds.y;
+    float offset = glm::max(modelHeight * 0.3f, 0.5f);  // 30% of model height OR minimum 0.5 units
+    float groundY = minBounds.y - offset;
+
+    METAGFX_INFO << "Model Y bounds: min=" << minBounds.y << ", max=" << maxBounds.y
+                 << ", ground plane Y=" << groundY;
+
+    // Make ground plane large enough to show shadows
+    float planeSize = glm::max(maxBounds.x - minBounds.x, maxBounds.z - minBounds.z) * 2.0f;
+    planeSize = glm::max(planeSize, 15.0f);  // Minimum 15 units
+
+    // Create a simple quad (two triangles) for the ground plane
+    std::vector<Vertex> vertices = {
+        // Position                                    Normal              TexCoord
+        { { -planeSize, groundY, -planeSize }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f } },
+        { {  planeSize, groundY, -planeSize }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 0.0f } },
+        { {  planeSize, groundY,  planeSize }, { 0.0f, 1.0f, 0.0f }, { 10.0f, 10.0f } },
+        { { -planeSize, groundY,  planeSize }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 10.0f } }
+    };
+
+    std::vector<uint32> indices = {
+        0, 2, 1,  // First triangle (clockwise from above = front face visible from below/side)
+        2, 0, 3   // Second triangle (clockwise from above = front face visible from below/side)
+    };
+    ComputeTangents(vertices.data(), static_cast<uint32>(vertices.size()),
+                    indices.data(), static_cast<uint32>(indices.size()));
+
+    // Log vertex coordinates for debugging
+    METAGFX_INFO << "Ground plane vertices:";
     METAGFX_INFO << "  Vertex 0: (" << vertices[0].position.x << ", " << vertices[0].position.y << ", " << vertices[0].position.z << ")";
     METAGFX_INFO << "  Vertex 1: (" << vertices[1].position.x << ", " << vertices[1].position.y << ", " << vertices[1].position.z << ")";
     METAGFX_INFO << "  Vertex 2: (" << vertices[2].position.x << ", " << vertices[2].position.y << ", " << vertices[2].position.z << ")";
     METAGFX_INFO << "  Vertex 3: (" << vertices[3].position.x << ", " << vertices[3].position.y << ", " << vertices[3].position.z << ")";
     METAGFX_INFO << "  Indices: [" << indices[0] << "," << indices[1] << "," << indices[2] << "], [" << indices[3] << "," << indices[4] << "," << indices[5] << "]";
 
-    // Recreate ground plane
-    if (m_GroundPlane) {
-        m_GroundPlane->Cleanup();
+    // Recreate ground plane
+    if (m_GroundPlane) {
+        m_GroundPlane->Cleanup();
+    }
+    m_GroundPlane = std::make_unique<Model>();
+    auto mesh = std::make_unique<Mesh>();
+    if (mesh->Initialize(m_Device.get(), std::move(vertices), std::move(indices))) {
+        m_GroundPlane->AddMesh(std::move(mesh));
+        METAGFX_INFO << "Ground plane positioned at Y=" << groundY
+                     << ", size=" << (planeSize * 2.0f) << "x" << (planeSize * 2.0f);
+    } else {
+        METAGFX_ERROR << "Failed to initialize ground plane mesh";
+    }
+}
+
+void Application::CreateTriangle() {
+    using namespace rhi;
+    
+    // Vertex data: position (vec3) + color (vec3)
+    float vertices[] = {
+         0.0f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,  // Top (red)
+        -0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,  // Bottom-left (green)
+         0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f   // Bottom-right (blue)
+    };
+    
+    // Create vertex buffer
+    BufferDesc vertexBufferDesc{};
+    vertexBufferDesc.size = sizeof(vertices);
+    vertexBufferDesc.usage = BufferUsage::Vertex;
+    vertexBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    
+    m_VertexBuffer = m_Device->CreateBuffer(vertexBufferDesc);
+    m_VertexBuffer->CopyData(vertices, sizeof(vertices));
+    
+    // Create shaders (SPIR-V bytecode)
+    // Vertex shader
+    std::vector<uint8> vertShaderCode = {
+        // This is a minimal SPIR-V bytecode for a simple pass-through vertex shader
+        // In practice, you'd compile from GLSL using glslangValidator or similar
+        #include "triangle.vert.spv.inl"
+    };
+    
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+    
+    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+    
+    // Fragment shader
+    std::vector<uint8> fragShaderCode = {
+        #include "triangle.frag.spv.inl"
+    };
+    
+    rhi::ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = rhi::ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+
+    // Create pipeline
+    rhi::PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertShader;
+    pipelineDesc.fragmentShader = fragShader;
+
+    // Vertex input: position and color
+    pipelineDesc.vertexInput.stride = sizeof(float) * 6;
+    pipelineDesc.vertexInput.attributes = {
+        { 0, rhi::Format::R32G32B32_SFLOAT, 0, 0 },                // position at location 0, binding 0
+        { 1, rhi::Format::R32G32B32_SFLOAT, sizeof(float) * 3, 0 } // color at location 1, binding 0
+    };
+
+    pipelineDesc.topology = rhi::PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = rhi::CullMode::None;
+    pipelineDesc.descriptorSetLayout = m_DescriptorSet;
+    
+    m_Pipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
+    
+    METAGFX_INFO << "Triangle resources created";
+}
+
+void Application::CreateModelPipeline() {
+    using namespace rhi;
+
+    // Load model shaders (SPIR-V bytecode)
+    std::vector<uint8> vertShaderCode = {
+        #include "model.vert.spv.inl"
+    };
+    UseReloadedShader("model.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+
+    std::vector<uint8> fragShaderCode = {
+        #include "model.frag.spv.inl"
+    };
+    UseReloadedShader("model.frag", fragShaderCode);
+
+    // Or its fp16 build, for every pipeline below using it
+    const DeviceInfo& deviceInfo = m_Device->GetDeviceInfo();
+    ShadingPrecision precision = m_Config.shadingPrecision;
+    if (precision == ShadingPrecision::Auto) {
+        precision = deviceInfo.isIntegratedGPU ? ShadingPrecision::Half : ShadingPrecision::Full;
+    }
+    m_HalfPrecisionShading = false;
+    if (precision == ShadingPrecision::Half && deviceInfo.supportsShaderFloat16) {
+        fragShaderCode = {
+            #include "model_half.frag.spv.inl"
+        };
+        UseReloadedShader("model_half.frag", fragShaderCode);
+        m_HalfPrecisionShading = true;
+    }
+    if (m_Config.shadingPrecision == ShadingPrecision::Half && !m_HalfPrecisionShading) {
+        METAGFX_WARN << "Half-precision shading unavailable (no fp16 shader arithmetic); using fp32";
+    }
+
+    rhi::ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = rhi::ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+
+    // Create pipeline for models
+    rhi::PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertShader;
+    pipelineDesc.fragmentShader = fragShader;
+
+    // Vertex input: position (vec3), normal (vec3), texcoord (vec2)
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Float);
+
+    pipelineDesc.topology = rhi::PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = rhi::CullMode::Back;
+    pipelineDesc.rasterization.frontFace = rhi::FrontFace::CounterClockwise;  // glTF uses CCW winding order
+
+    // Enable depth testing for proper 3D rendering, reverse-Z (see Camera). GreaterOrEqual
+    // passes the fragments whose depth the depth prepass already wrote (the vertex stages
+    // are invariant).
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = true;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::GreaterOrEqual;
+    pipelineDesc.depthFormat = m_Device->GetDeviceInfo().depthFormat;
+    UseSceneColorTarget(pipelineDesc);
+
+    // Set 0 is the frame's, sets 1 and 2 the pass's shadows and the material
+    pipelineDesc.descriptorSetLayout = m_DescriptorSet;
+    pipelineDesc.extraSetLayouts = { m_PassDescriptorSet, m_DefaultMaterialSet.set };
+
+    // Created up front: it is the fallback for every model and ground plane draw
+    CreatePipeline(pipelineDesc, m_ModelPipeline, "Model");
+    m_ModelVariantDescs[ModelVariantFloat] = pipelineDesc;
+
+    METAGFX_INFO << "Model pipeline created (" << (m_HalfPrecisionShading ? "fp16" : "fp32") << " shading)";
+
+    bool bindlessVariants = false;
+
+    if (m_BindlessSupported) {
+        // Same vertex stage; the fragment stage indexes the bindless texture table
+        std::vector<uint8> bindlessFragShaderCode = {
+            #include "model_bindless.frag.spv.inl"
+        };
+        UseReloadedShader("model_bindless.frag", bindlessFragShaderCode);
+
+        rhi::ShaderDesc bindlessFragShaderDesc{};
+        bindlessFragShaderDesc.stage = rhi::ShaderStage::Fragment;
+        bindlessFragShaderDesc.code = bindlessFragShaderCode;
+        bindlessFragShaderDesc.entryPoint = "main";
+
+        // The bindless set holds every binding, the texture table included
+        pipelineDesc.fragmentShader = m_Device->CreateShader(bindlessFragShaderDesc);
+        pipelineDesc.descriptorSetLayout = m_BindlessDescriptorSet;
+        pipelineDesc.extraSetLayouts.clear();
+        m_ModelVariantDescs[ModelVariantBindless] = pipelineDesc;
+
+        // Compiled in the background; models draw with the per-material pipeline until then
+        CreatePipelineAsync(pipelineDesc, m_BindlessModelPipeline, "Bindless model");
+        bindlessVariants = true;
+
+        // Vertex pulling: no vertex input state, the vertex stage fetches either layout
+        // from the bindless set's pool vertices
+        std::vector<uint8> pulledVertShaderCode = {
+            #include "model_pulled.vert.spv.inl"
+        };
+        UseReloadedShader("model_pulled.vert", pulledVertShaderCode);
+
+        rhi::ShaderDesc pulledVertShaderDesc{};
+        pulledVertShaderDesc.stage = rhi::ShaderStage::Vertex;
+        pulledVertShaderDesc.code = pulledVertShaderCode;
+        pulledVertShaderDesc.entryPoint = "main";
+
+        rhi::PipelineDesc pulledDesc = pipelineDesc;
+        pulledDesc.vertexShader = m_Device->CreateShader(pulledVertShaderDesc);
+        pulledDesc.vertexInput.attributes.clear();
+        pulledDesc.vertexInput.stride = 0;
+        m_ModelVariantDescs[ModelVariantPulled] = pulledDesc;
+        CreatePipelineAsync(pulledDesc, m_PulledModelPipeline, "Pulled model");
+    }
+
+    // Variants for VertexFormat::Compact: the vertex stage decodes the quantized layout
+    std::vector<uint8> compactVertShaderCode = {
+        #include "model_compact.vert.spv.inl"
+    };
+    UseReloadedShader("model_compact.vert", compactVertShaderCode);
+
+    rhi::ShaderDesc compactVertShaderDesc{};
+    compactVertShaderDesc.stage = rhi::ShaderStage::Vertex;
+    compactVertShaderDesc.code = compactVertShaderCode;
+    compactVertShaderDesc.entryPoint = "main";
+
+    pipelineDesc.vertexShader = m_Device->CreateShader(compactVertShaderDesc);
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Compact);
+
+    if (bindlessVariants) {
+        m_ModelVariantDescs[ModelVariantBindlessCompact] = pipelineDesc;
+        CreatePipelineAsync(pipelineDesc, m_BindlessCompactModelPipeline, "Bindless compact model");
+    }
+
+    // Created up front like the full-float one: compact models have no other fallback,
+    // and the vertex format chosen below depends on it
+    pipelineDesc.fragmentShader = fragShader;
+    pipelineDesc.descriptorSetLayout = m_DescriptorSet;
+    pipelineDesc.extraSetLayouts = { m_PassDescriptorSet, m_DefaultMaterialSet.set };
+    CreatePipeline(pipelineDesc, m_CompactModelPipeline, "Compact model");
+    m_ModelVariantDescs[ModelVariantCompact] = pipelineDesc;
+    if (m_CompactModelPipeline) {
+        METAGFX_INFO << "Compact vertex model pipeline created";
+    }
+
+    if (m_RayTracingScene) {
+        // Same vertex stages and per-material sets; the fragment stage traces its shadows
+        std::vector<uint8> rayTracedFragShaderCode = {
+            #include "model_raytraced.frag.spv.inl"
+        };
+        UseReloadedShader("model_raytraced.frag", rayTracedFragShaderCode);
+
+        rhi::ShaderDesc rayTracedFragShaderDesc{};
+        rayTracedFragShaderDesc.stage = rhi::ShaderStage::Fragment;
+        rayTracedFragShaderDesc.code = rayTracedFragShaderCode;
+        rayTracedFragShaderDesc.entryPoint = "main";
+        auto rayTracedFragShader = m_Device->CreateShader(rayTracedFragShaderDesc);
+
+        // Compiled in the background; frames keep the shadow maps until then
+        rhi::PipelineDesc rayTracedDesc = m_ModelVariantDescs[ModelVariantFloat];
+        rayTracedDesc.fragmentShader = rayTracedFragShader;
+        m_ModelVariantDescs[ModelVariantRayTraced] = rayTracedDesc;
+        CreatePipelineAsync(rayTracedDesc, m_RayTracedModelPipeline, "Ray-traced model");
+        if (m_ModelVariantDescs[ModelVariantCompact].fragmentShader) {
+            rayTracedDesc = m_ModelVariantDescs[ModelVariantCompact];
+            rayTracedDesc.fragmentShader = rayTracedFragShader;
+            m_ModelVariantDescs[ModelVariantRayTracedCompact] = rayTracedDesc;
+            CreatePipelineAsync(rayTracedDesc, m_RayTracedCompactModelPipeline, "Ray-traced compact model");
+        }
+    }
+
+    if (!m_CompactModelPipeline && m_Config.modelImport.vertexFormat == VertexFormat::Compact) {
+        METAGFX_INFO << "Compact vertex pipeline unavailable; models use full-float vertices";
+        m_Config.modelImport.vertexFormat = VertexFormat::Float;
+    }
+}
+
+void Application::CreateSkyboxPipeline() {
+    using namespace rhi;
+
+    // Load skybox shaders (SPIR-V bytecode)
+    std::vector<uint8> vertShaderCode = {
+        #include "skybox.vert.spv.inl"
+    };
+    UseReloadedShader("skybox.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+
+    std::vector<uint8> fragShaderCode = {
+        #include "skybox.frag.spv.inl"
+    };
+    UseReloadedShader("skybox.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+
+    // Create pipeline for skybox
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertShader;
+    pipelineDesc.fragmentShader = fragShader;
+
+    // A triangle over the viewport, made by the vertex shader at the far plane
+    pipelineDesc.vertexInput.stride = 0;
+    pipelineDesc.topology = PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+
+    // GreaterOrEqual without writing depth: only pixels still at the cleared FAR_DEPTH
+    // pass, and the fragment shader neither discards nor writes depth, so the test runs
+    // before it
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = false;  // Don't write depth
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::GreaterOrEqual;
+    pipelineDesc.depthFormat = m_Device->GetDeviceInfo().depthFormat;
+    UseSceneColorTarget(pipelineDesc);
+    pipelineDesc.descriptorSetLayout = m_SkyboxDescriptorSet;
+
+    // The skybox is skipped until the pipeline is ready
+    CreatePipelineAsync(pipelineDesc, m_SkyboxPipeline, "Skybox");
+}
+
+void Application::CreateShadowPipeline() {
+    using namespace rhi;
+
+    // Load shadow map shaders (SPIR-V bytecode)
+    std::vector<uint8> vertShaderCode = {
+        #include "shadowmap.vert.spv.inl"
+    };
+    UseReloadedShader("shadowmap.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+
+    std::vector<uint8> fragShaderCode = {
+        #include "shadowmap.frag.spv.inl"
+    };
+    UseReloadedShader("shadowmap.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+
+    // Create pipeline for shadow map rendering (depth-only)
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertShader;
+    pipelineDesc.fragmentShader = fragShader;
+
+    // Vertex input: position (vec3) only
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Float, true);
+
+    pipelineDesc.topology = PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = CullMode::Back;
+    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
+    pipelineDesc.rasterization.depthBiasEnable = true;  // Enable depth bias to reduce shadow acne
+    pipelineDesc.rasterization.depthBiasConstantFactor = 1.25f;
+    pipelineDesc.rasterization.depthBiasSlopeFactor = 1.75f;
+
+    // Enable depth testing and writing for shadow map
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = true;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Less;  // Standard: closer fragments win
+    pipelineDesc.depthFormat = m_ShadowDepthFormat;
+
+    // Depth-only: no color attachments
+    pipelineDesc.colorFormats.clear();
+    pipelineDesc.descriptorSetLayout = m_ShadowDescriptorSet;
+
+    CreatePipeline(pipelineDesc, m_ShadowPipeline, "Shadow");
+
+    // Compact models: the unorm position reads as a vec3 in [0, 1], so the same shader
+    // works with the dequantization in the UBO's model matrix
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Compact, true);
+    CreatePipeline(pipelineDesc, m_CompactShadowPipeline, "Compact shadow");
+
+    // Meshes with a position stream: only the packed positions are fetched. Until these
+    // are ready, the shadow pass reads positions from the full vertex buffer instead.
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Float);
+    CreatePipelineAsync(pipelineDesc, m_ShadowPositionPipeline, "Shadow position");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Compact);
+    CreatePipelineAsync(pipelineDesc, m_CompactShadowPositionPipeline, "Compact shadow position");
+
+    // Vertex pulling: one pipeline for both layouts, fetching from the set's pool vertices
+    std::vector<uint8> pulledVertShaderCode = {
+        #include "shadowmap_pulled.vert.spv.inl"
+    };
+    UseReloadedShader("shadowmap_pulled.vert", pulledVertShaderCode);
+
+    ShaderDesc pulledVertShaderDesc{};
+    pulledVertShaderDesc.stage = ShaderStage::Vertex;
+    pulledVertShaderDesc.code = pulledVertShaderCode;
+    pulledVertShaderDesc.entryPoint = "main";
+
+    PipelineDesc pulledDesc = pipelineDesc;
+    pulledDesc.vertexShader = m_Device->CreateShader(pulledVertShaderDesc);
+    pulledDesc.vertexInput.attributes.clear();
+    pulledDesc.vertexInput.stride = 0;
+    CreatePipelineAsync(pulledDesc, m_PulledShadowPipeline, "Pulled shadow");
+
+    // Shadow atlas tile clears: m_ShadowClearQuad at the far plane, replacing whatever
+    // depth the tile held
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Float);
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+    pipelineDesc.rasterization.depthBiasEnable = false;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Always;
+    CreatePipeline(pipelineDesc, m_ShadowClearPipeline, "Shadow clear");
+
+    METAGFX_INFO << "Shadow pipeline created";
+}
+
+void Application::CreateDepthPrepassPipeline() {
+    using namespace rhi;
+
+    std::vector<uint8> vertShaderCode = {
+        #include "depth_prepass.vert.spv.inl"
+    };
+    UseReloadedShader("depth_prepass.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    // The shadow map's empty fragment stage
+    std::vector<uint8> fragShaderCode = {
+        #include "shadowmap.frag.spv.inl"
+    };
+    UseReloadedShader("shadowmap.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = m_Device->CreateShader(vertShaderDesc);
+    pipelineDesc.fragmentShader = m_Device->CreateShader(fragShaderDesc);
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Float, true);
+    pipelineDesc.topology = PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = CullMode::Back;
+    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
+
+    // No bias: the model pipelines test against this depth with GreaterOrEqual
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = true;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Greater;
+    pipelineDesc.depthFormat = m_Device->GetDeviceInfo().depthFormat;
+
+    // Drawn inside the main pass, so with its color format, never written
+    ColorAttachmentState colorAttachment{};
+    colorAttachment.writeEnable = false;
+    pipelineDesc.colorAttachments = { colorAttachment };
+    UseSceneColorTarget(pipelineDesc);
+    pipelineDesc.descriptorSetLayout = m_DepthPrepassDescriptorSet;
+
+    // The main pass draws without a prepass until these are ready
+    CreatePipelineAsync(pipelineDesc, m_DepthPrepassPipelines.full, "Depth prepass");
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Compact, true);
+    CreatePipelineAsync(pipelineDesc, m_DepthPrepassPipelines.compact, "Compact depth prepass");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Float);
+    CreatePipelineAsync(pipelineDesc, m_DepthPrepassPipelines.position, "Depth prepass position");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Compact);
+    CreatePipelineAsync(pipelineDesc, m_DepthPrepassPipelines.compactPosition, "Compact depth prepass position");
+}
+
+// The depth prepass's draws into ObjectPicker's ID target, with their mesh index and
+// world position (pick.vert and pick.frag)
+void Application::CreatePickPipelines() {
+    using namespace rhi;
+
+    std::vector<uint8> vertShaderCode = {
+        #include "pick.vert.spv.inl"
+    };
+    UseReloadedShader("pick.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    std::vector<uint8> fragShaderCode = {
+        #include "pick.frag.spv.inl"
+    };
+    UseReloadedShader("pick.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = m_Device->CreateShader(vertShaderDesc);
+    pipelineDesc.fragmentShader = m_Device->CreateShader(fragShaderDesc);
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Float, true);
+    pipelineDesc.topology = PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = CullMode::Back;
+    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
+
+    // The nearest surface under each texel (reverse-Z, like the main pass)
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = true;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Greater;
+    pipelineDesc.colorFormats = { ObjectPicker::ID_FORMAT };
+    pipelineDesc.depthFormat = ObjectPicker::DEPTH_FORMAT;
+    pipelineDesc.descriptorSetLayout = m_DepthPrepassDescriptorSet;  // The depth prepass's
+
+    // Picks go through the scene BVH until these are ready
+    CreatePipelineAsync(pipelineDesc, m_PickPipelines.full, "Pick");
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Compact, true);
+    CreatePipelineAsync(pipelineDesc, m_PickPipelines.compact, "Compact pick");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Float);
+    CreatePipelineAsync(pipelineDesc, m_PickPipelines.position, "Pick position");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Compact);
+    CreatePipelineAsync(pipelineDesc, m_PickPipelines.compactPosition, "Compact pick position");
+}
+
+// The depth prepass's draws into the motion vector target of temporal AA
+void Application::CreateMotionVectorPipelines() {
+    using namespace rhi;
+
+    if (!m_TemporalAA) {
+        return;
+    }
+
+    std::vector<uint8> vertShaderCode = {
+        #include "motion_vectors.vert.spv.inl"
+    };
+    UseReloadedShader("motion_vectors.vert", vertShaderCode);
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    std::vector<uint8> fragShaderCode = {
+        #include "motion_vectors.frag.spv.inl"
+    };
+    UseReloadedShader("motion_vectors.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = m_Device->CreateShader(vertShaderDesc);
+    pipelineDesc.fragmentShader = m_Device->CreateShader(fragShaderDesc);
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Float, true);
+    pipelineDesc.topology = PrimitiveTopology::TriangleList;
+    pipelineDesc.rasterization.cullMode = CullMode::Back;
+    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
+
+    // The nearest surface's motion, at the main pass's depth
+    pipelineDesc.depthStencil.depthTestEnable = true;
+    pipelineDesc.depthStencil.depthWriteEnable = true;
+    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Greater;
+    pipelineDesc.colorFormats = { TemporalAA::MOTION_VECTOR_FORMAT };
+    pipelineDesc.depthFormat = m_Device->GetDeviceInfo().depthFormat;
+    pipelineDesc.descriptorSetLayout = m_MotionVectorDescriptorSet;
+
+    // The model keeps zero motion until these are ready
+    CreatePipelineAsync(pipelineDesc, m_MotionVectorPipelines.full, "Motion vectors");
+    pipelineDesc.vertexInput = GetVertexInputLayout(VertexFormat::Compact, true);
+    CreatePipelineAsync(pipelineDesc, m_MotionVectorPipelines.compact, "Compact motion vectors");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Float);
+    CreatePipelineAsync(pipelineDesc, m_MotionVectorPipelines.position, "Motion vectors position");
+    pipelineDesc.vertexInput = GetPositionInputLayout(VertexFormat::Compact);
+    CreatePipelineAsync(pipelineDesc, m_MotionVectorPipelines.compactPosition, "Compact motion vectors position");
+}
+
+// The model pipelines' vertex stages and states, with gbuffer.frag writing the deferred
+// G-buffer instead of lit color. Uses the model variants' descriptions, so it runs after
+// CreateModelPipeline().
+void Application::CreateGBufferPipelines() {
+    using namespace rhi;
+
+    std::vector<uint8> fragShaderCode = {
+        #include "gbuffer.frag.spv.inl"
+    };
+    UseReloadedShader("gbuffer.frag", fragShaderCode);
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+    Ref<Shader> fragShader = m_Device->CreateShader(fragShaderDesc);
+
+    // Deferred frames render forward until these are ready
+    // The G-buffer is never multisampled
+    PipelineDesc pipelineDesc = m_ModelVariantDescs[ModelVariantFloat];
+    pipelineDesc.fragmentShader = fragShader;
+    pipelineDesc.colorFormats = { DeferredLighting::GBUFFER_FORMAT };
+    pipelineDesc.sampleCount = 1;
+    CreatePipelineAsync(pipelineDesc, m_GBufferPipeline, "G-buffer");
+    if (m_ModelVariantDescs[ModelVariantCompact].fragmentShader) {
+        pipelineDesc = m_ModelVariantDescs[ModelVariantCompact];
+        pipelineDesc.fragmentShader = fragShader;
+        pipelineDesc.colorFormats = { DeferredLighting::GBUFFER_FORMAT };
+        pipelineDesc.sampleCount = 1;
+        CreatePipelineAsync(pipelineDesc, m_CompactGBufferPipeline, "Compact G-buffer");
     }
-    m_GroundPlane = std::make_unique<Model>();
-    auto mesh = std::make_unique<Mesh>();
-    if (mesh->Initialize(m_Device.get(), vertices, indices)) {
-        m_GroundPlane->AddMesh(std::move(mesh));
-        METAGFX_INFO << "Ground plane positioned at Y=" << groundY
-                     << ", size=" << (planeSize * 2.0f) << "x" << (planeSize * 2.0f);
-    } else {
-        METAGFX_ERROR << "Failed to initialize ground plane mesh";
+}
+
+// With the tone mapping pass the main pass renders into the HDR scene color, and the lit
+// shaders leave exposure, tone mapping and gamma to it (their HDR_OUTPUT constant). Only
+// then is it multisampled.
+void Application::UseSceneColorTarget(rhi::PipelineDesc& desc) const {
+    if (m_ToneMapper) {
+        desc.colorFormats = { ToneMapper::SCENE_COLOR_FORMAT };
+        desc.specializationConstants.push_back({ 2, 1 });  // HDR_OUTPUT
+        desc.sampleCount = m_MSAASamples;
     }
 }
 
-void Application::CreateTriangle() {
+void Application::CreatePipelineAsync(const rhi::PipelineDesc& desc, Ref<rhi::Pipeline>& target, const char* name) {
+    m_PendingPipelines.push_back({ m_Device->CreateGraphicsPipelineAsync(desc), &target, name });
+}
+
+// Pipelines without a substitute compile synchronously at startup. On a shader reload
+// the current pipeline is the substitute, so they compile in the background instead.
+void Application::CreatePipeline(const rhi::PipelineDesc& desc, Ref<rhi::Pipeline>& target, const char* name) {
+    if (m_ReloadingShaders && target) {
+        CreatePipelineAsync(desc, target, name);
+        return;
+    }
+    target = m_Device->CreateGraphicsPipeline(desc);
+}
+
+// Replaces embedded SPIR-V with the last successful hot-reload build of the file
+void Application::UseReloadedShader(const char* name, std::vector<uint8>& code) const {
+    auto it = m_ReloadedShaders.find(name);
+    if (it != m_ReloadedShaders.end()) {
+        code = it->second;
+    }
+}
+
+// Takes the shader watcher's finished compiles and, when any succeeded, rebuilds the
+// model, skybox and shadow pipelines from the current sources. The old pipelines keep
+// drawing until their replacements land, then retire through the deletion queue.
+void Application::UpdateShaderReload() {
+    if (!m_ShaderWatcher) {
+        return;
+    }
+    m_ShaderWatcher->Poll();
+
+    bool reload = false;
+    for (utils::ShaderWatcher::Result& result : m_ShaderWatcher->TakeResults()) {
+        if (!result.success) {
+            METAGFX_ERROR << "Shader " << result.name << " failed to compile; keeping the running version\n" << result.log;
+            continue;
+        }
+        METAGFX_INFO << "Shader recompiled: " << result.name;
+        m_ReloadedShaders[result.name] = std::move(result.spirv);
+        reload = true;
+    }
+    if (!reload) {
+        return;
+    }
+
+    // Outstanding compiles land first: their targets, permutations included, are
+    // replaced below
+    for (PendingPipeline& pending : m_PendingPipelines) {
+        pending.future->Wait();
+    }
+    CollectPendingPipelines();
+
+    for (auto& [key, pipeline] : m_ModelPermutations) {
+        m_Device->Retire(std::move(pipeline));
+    }
+    m_ModelPermutations.clear();
+
+    m_ReloadingShaders = true;
+    CreateModelPipeline();
+    CreateSkyboxPipeline();
+    CreateShadowPipeline();
+    CreateDepthPrepassPipeline();
+    CreatePickPipelines();
+    CreateMotionVectorPipelines();
+    CreateGBufferPipelines();
+    m_ReloadingShaders = false;
+    if (m_ShadowMap) {
+        m_ShadowMap->InvalidateCache();  // The cached map was drawn by the old shaders
+    }
+    if (m_ShadowAtlas) {
+        m_ShadowAtlas->Invalidate();
+    }
+}
+
+void Application::CollectPendingPipelines() {
+    for (auto it = m_PendingPipelines.begin(); it != m_PendingPipelines.end(); ) {
+        if (!it->future->IsReady()) {
+            ++it;
+            continue;
+        }
+        Ref<rhi::Pipeline> pipeline = it->future->Get();
+        if (pipeline) {
+            // A shader reload replaces a pipeline that frames in flight may still use
+            m_Device->Retire(std::move(*it->target));
+            *it->target = std::move(pipeline);
+            METAGFX_INFO << it->name << " pipeline created";
+        } else {
+            METAGFX_WARN << it->name << " pipeline failed to compile; keeping the fallback";
+        }
+        it = m_PendingPipelines.erase(it);
+    }
+}
+
+// Permutation of a model pipeline variant for a ModelFeatures mask (MODEL_FEATURES_UBER:
+// the uber shader) and a ModelTransparency output, or null while it compiles (or when it
+// failed to); the first request starts the compile
+Ref<rhi::Pipeline> Application::RequestModelPermutation(uint32 variant, uint32 features, uint32 transparency) {
+    uint32 key = (transparency << 24) | (variant << 16) | features;
+    auto it = m_ModelPermutations.find(key);
+    if (it != m_ModelPermutations.end()) {
+        return it->second;
+    }
+
+    Ref<rhi::Pipeline>& target = m_ModelPermutations[key];
+    rhi::PipelineDesc desc = m_ModelVariantDescs[variant];
+    if (!desc.fragmentShader) {
+        return nullptr;
+    }
+    if (features != MODEL_FEATURES_UBER) {
+        desc.specializationConstants.push_back({ 0, 1 });         // SPECIALIZED
+        desc.specializationConstants.push_back({ 1, features });  // FEATURE_MASK
+    }
+    if (transparency != ModelTransparencyOpaque) {
+        desc.specializationConstants.push_back({ 3, transparency });  // TRANSPARENCY
+        desc.depthStencil.depthWriteEnable = false;
+        if (desc.colorAttachments.empty()) {
+            desc.colorAttachments.resize(1);
+        }
+        desc.colorAttachments[0].blendEnable = true;
+        if (transparency != ModelTransparencyBlend) {
+            // The weighted blended targets take one sample per pixel
+            bool accumulate = transparency == ModelTransparencyAccumulate;
+            desc.sampleCount = 1;
+            desc.colorFormats = { accumulate ? WeightedBlendedOIT::ACCUMULATION_FORMAT
+                                             : WeightedBlendedOIT::REVEALAGE_FORMAT };
+            desc.colorAttachments[0].blendMode = accumulate ? rhi::BlendMode::Additive : rhi::BlendMode::Attenuate;
+        }
+    }
+
+    CreatePipelineAsync(desc, target, "Model permutation");
+    return nullptr;
+}
+
+void Application::CreateGPUCuller() {
     using namespace rhi;
-    
-    // Vertex data: position (vec3) + color (vec3)
-    float vertices[] = {
-         0.0f,  0.5f, 0.0f,   1.0f, 0.0f, 0.0f,  // Top (red)
-        -0.5f, -0.5f, 0.0f,   0.0f, 1.0f, 0.0f,  // Bottom-left (green)
-         0.5f, -0.5f, 0.0f,   0.0f, 0.0f, 1.0f   // Bottom-right (blue)
+
+    std::vector<uint8> cullShaderCode = {
+        #include "cull.comp.spv.inl"
     };
-    
-    // Create vertex buffer
-    BufferDesc vertexBufferDesc{};
-    vertexBufferDesc.size = sizeof(vertices);
-    vertexBufferDesc.usage = BufferUsage::Vertex;
-    vertexBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
-    
-    m_VertexBuffer = m_Device->CreateBuffer(vertexBufferDesc);
-    m_VertexBuffer->CopyData(vertices, sizeof(vertices));
-    
-    // Create shaders (SPIR-V bytecode)
-    // Vertex shader
+
+    ShaderDesc cullShaderDesc{};
+    cullShaderDesc.stage = ShaderStage::Compute;
+    cullShaderDesc.code = cullShaderCode;
+    cullShaderDesc.entryPoint = "main";
+
+    std::vector<uint8> pyramidShaderCode = {
+        #include "depth_pyramid.comp.spv.inl"
+    };
+
+    ShaderDesc pyramidShaderDesc{};
+    pyramidShaderDesc.stage = ShaderStage::Compute;
+    pyramidShaderDesc.code = pyramidShaderCode;
+    pyramidShaderDesc.entryPoint = "main";
+
+    m_GPUCuller = std::make_unique<GPUCuller>(m_Device, *m_UniformRing,
+                                              m_Device->CreateShader(cullShaderDesc),
+                                              m_Device->CreateShader(pyramidShaderDesc));
+    if (!m_GPUCuller->IsValid()) {
+        m_GPUCuller.reset();
+        return;
+    }
+    auto swapChain = m_Device->GetSwapChain();
+    m_GPUCuller->SetDepthSize(swapChain->GetWidth(), swapChain->GetHeight());
+}
+
+void Application::CreateShadowMoments() {
+    using namespace rhi;
+
+    std::vector<uint8> momentsShaderCode = {
+        #include "shadow_evsm.comp.spv.inl"
+    };
+
+    ShaderDesc momentsShaderDesc{};
+    momentsShaderDesc.stage = ShaderStage::Compute;
+    momentsShaderDesc.code = momentsShaderCode;
+    momentsShaderDesc.entryPoint = "main";
+
+    m_ShadowMoments = std::make_unique<ShadowMoments>(m_Device, m_Device->CreateShader(momentsShaderDesc), *m_ShadowMap);
+    if (!m_ShadowMoments->IsValid()) {
+        m_ShadowMoments.reset();
+        return;
+    }
+    m_ShadowMoments->SetBlurRadius(static_cast<uint32>(m_EVSMBlurRadius));
+}
+
+void Application::CreateDeferredLighting() {
+    using namespace rhi;
+
+    // The lit color is linear, so the deferred path needs the tone mapping pass
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Deferred shading disabled: it needs the tone mapping pass";
+        return;
+    }
+
+    std::vector<uint8> lightingShaderCode = {
+        #include "deferred_lighting.comp.spv.inl"
+    };
+    std::vector<uint8> compositeVertShaderCode = {
+        #include "fullscreen.vert.spv.inl"
+    };
+    std::vector<uint8> compositeFragShaderCode = {
+        #include "deferred_composite.frag.spv.inl"
+    };
+
+    ShaderDesc lightingShaderDesc{};
+    lightingShaderDesc.stage = ShaderStage::Compute;
+    lightingShaderDesc.code = lightingShaderCode;
+    lightingShaderDesc.entryPoint = "main";
+
+    ShaderDesc compositeVertShaderDesc{};
+    compositeVertShaderDesc.stage = ShaderStage::Vertex;
+    compositeVertShaderDesc.code = compositeVertShaderCode;
+    compositeVertShaderDesc.entryPoint = "main";
+
+    ShaderDesc compositeFragShaderDesc{};
+    compositeFragShaderDesc.stage = ShaderStage::Fragment;
+    compositeFragShaderDesc.code = compositeFragShaderCode;
+    compositeFragShaderDesc.entryPoint = "main";
+
+    // Reads the main set's lights, shadows and IBL maps at their binding numbers
+    m_DeferredLighting = std::make_unique<DeferredLighting>(
+        m_Device, m_Device->CreateShader(lightingShaderDesc), m_Device->CreateShader(compositeVertShaderDesc),
+        m_Device->CreateShader(compositeFragShaderDesc), m_MainBindings, ToneMapper::SCENE_COLOR_FORMAT);
+    if (!m_DeferredLighting->IsValid()) {
+        m_DeferredLighting.reset();
+    }
+}
+
+void Application::CreateVisibilityBuffer() {
+    using namespace rhi;
+
+    // Resolves into the deferred G-buffer, reads the bindless table and draws the
+    // culler's commands
+    if (!m_DeferredLighting || !m_GPUCuller || !m_ModelVariantDescs[ModelVariantBindless].fragmentShader) {
+        METAGFX_INFO << "Visibility buffer disabled: it needs deferred shading, GPU culling and bindless materials";
+        return;
+    }
+
     std::vector<uint8> vertShaderCode = {
-        // This is a minimal SPIR-V bytecode for a simple pass-through vertex shader
-        // In practice, you'd compile from GLSL using glslangValidator or similar
-        #include "triangle.vert.spv.inl"
+        #include "visibility.vert.spv.inl"
     };
-    
+    std::vector<uint8> fragShaderCode = {
+        #include "visibility.frag.spv.inl"
+    };
+    std::vector<uint8> resolveShaderCode = {
+        #include "visibility_resolve.comp.spv.inl"
+    };
+
     ShaderDesc vertShaderDesc{};
     vertShaderDesc.stage = ShaderStage::Vertex;
     vertShaderDesc.code = vertShaderCode;
     vertShaderDesc.entryPoint = "main";
-    
-    auto vertShader = m_Device->CreateShader(vertShaderDesc);
-    
-    // Fragment shader
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
+
+    ShaderDesc resolveShaderDesc{};
+    resolveShaderDesc.stage = ShaderStage::Compute;
+    resolveShaderDesc.code = resolveShaderCode;
+    resolveShaderDesc.entryPoint = "main";
+
+    // Reads the main set's frame constants and node transforms at their binding numbers
+    m_VisibilityBuffer = std::make_unique<VisibilityBuffer>(m_Device, m_Device->CreateShader(resolveShaderDesc),
+                                                            m_MainBindings, BINDLESS_TEXTURE_CAPACITY);
+    if (!m_VisibilityBuffer->IsValid()) {
+        m_VisibilityBuffer.reset();
+        return;
+    }
+
+    // The bindless model pipelines with the ids as their one output; one shader pair reads
+    // both vertex layouts. Visibility frames fill the G-buffer with its pass until ready.
+    Ref<Shader> vertShader = m_Device->CreateShader(vertShaderDesc);
+    Ref<Shader> fragShader = m_Device->CreateShader(fragShaderDesc);
+    for (uint32 variant : { ModelVariantBindless, ModelVariantBindlessCompact }) {
+        if (!m_ModelVariantDescs[variant].fragmentShader) {
+            continue;
+        }
+        PipelineDesc pipelineDesc = m_ModelVariantDescs[variant];
+        pipelineDesc.vertexShader = vertShader;
+        pipelineDesc.fragmentShader = fragShader;
+        pipelineDesc.colorFormats = { VisibilityBuffer::VISIBILITY_FORMAT };
+        pipelineDesc.specializationConstants.clear();
+        pipelineDesc.sampleCount = 1;
+        if (variant == ModelVariantBindless) {
+            CreatePipelineAsync(pipelineDesc, m_VisibilityPipeline, "Visibility");
+        } else {
+            CreatePipelineAsync(pipelineDesc, m_CompactVisibilityPipeline, "Compact visibility");
+        }
+    }
+}
+
+void Application::CreateToneMapper() {
+    using namespace rhi;
+
+    std::vector<uint8> vertShaderCode = {
+        #include "fullscreen.vert.spv.inl"
+    };
     std::vector<uint8> fragShaderCode = {
-        #include "triangle.frag.spv.inl"
+        #include "tonemap.frag.spv.inl"
     };
-    
-    rhi::ShaderDesc fragShaderDesc{};
-    fragShaderDesc.stage = rhi::ShaderStage::Fragment;
+
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
+
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
     fragShaderDesc.code = fragShaderCode;
     fragShaderDesc.entryPoint = "main";
 
-    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+    m_ToneMapper = std::make_unique<ToneMapper>(m_Device, m_Device->CreateShader(vertShaderDesc),
+                                                m_Device->CreateShader(fragShaderDesc));
+    if (!m_ToneMapper->IsValid()) {
+        m_ToneMapper.reset();
+    }
+}
 
-    // Create pipeline
-    rhi::PipelineDesc pipelineDesc{};
-    pipelineDesc.vertexShader = vertShader;
-    pipelineDesc.fragmentShader = fragShader;
+void Application::CreateAutoExposure() {
+    using namespace rhi;
 
-    // Vertex input: position and color
-    pipelineDesc.vertexInput.stride = sizeof(float) * 6;
-    pipelineDesc.vertexInput.attributes = {
-        { 0, rhi::Format::R32G32B32_SFLOAT, 0, 0 },                // position at location 0, binding 0
-        { 1, rhi::Format::R32G32B32_SFLOAT, sizeof(float) * 3, 0 } // color at location 1, binding 0
+    // The histogram measures the HDR scene color, which only the tone mapper has
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Auto exposure disabled: it needs the tone mapping pass";
+        return;
+    }
+
+    std::vector<uint8> exposureShaderCode = {
+        #include "auto_exposure.comp.spv.inl"
+    };
+
+    ShaderDesc exposureShaderDesc{};
+    exposureShaderDesc.stage = ShaderStage::Compute;
+    exposureShaderDesc.code = exposureShaderCode;
+    exposureShaderDesc.entryPoint = "main";
+
+    m_AutoExposure = std::make_unique<AutoExposure>(m_Device, m_Device->CreateShader(exposureShaderDesc));
+    if (!m_AutoExposure->IsValid()) {
+        m_AutoExposure.reset();
+    }
+}
+
+void Application::CreateStreaming() {
+    if (!m_Config.stream.enabled) {
+        return;
+    }
+    using namespace rhi;
+
+    m_StreamServer = std::make_unique<StreamServer>(m_Config.stream.port, m_Config.stream.maxQueuedFrames);
+    if (!m_StreamServer->IsListening()) {
+        m_StreamServer.reset();
+        return;
+    }
+
+    std::vector<uint8> streamShaderCode = {
+        #include "stream_encode.comp.spv.inl"
+    };
+
+    ShaderDesc streamShaderDesc{};
+    streamShaderDesc.stage = ShaderStage::Compute;
+    streamShaderDesc.code = streamShaderCode;
+    streamShaderDesc.entryPoint = "main";
+
+    VideoEncoder::Settings videoSettings;
+    videoSettings.bitrateKbps = std::max(100u, m_Config.stream.bitrateKbps);
+    m_StreamEncoder =
+        std::make_unique<StreamEncoder>(m_Device, m_Device->CreateShader(streamShaderDesc), videoSettings);
+    if (!m_StreamEncoder->IsValid()) {
+        m_StreamEncoder.reset();
+        return;
+    }
+    StreamServer* server = m_StreamServer.get();
+    m_StreamEncoder->SetFrameCallback([server](StreamEncoder::Frame&& frame) {
+        server->SubmitFrame(std::move(frame));
+    });
+}
+
+void Application::CreateEnvironmentBaker() {
+    using namespace rhi;
+
+    std::vector<uint8> bakeShaderCode = {
+        #include "environment_bake.comp.spv.inl"
+    };
+
+    ShaderDesc bakeShaderDesc{};
+    bakeShaderDesc.stage = ShaderStage::Compute;
+    bakeShaderDesc.code = bakeShaderCode;
+    bakeShaderDesc.entryPoint = "main";
+
+    m_EnvironmentBaker = std::make_unique<EnvironmentBaker>(m_Device, m_Device->CreateShader(bakeShaderDesc));
+    if (!m_EnvironmentBaker->IsValid()) {
+        m_EnvironmentBaker.reset();
+    }
+}
+
+void Application::CreateBloom() {
+    using namespace rhi;
+
+    // The bloom spreads the HDR scene color, which only the tone mapper has
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Bloom disabled: it needs the tone mapping pass";
+        return;
+    }
+
+    std::vector<uint8> bloomShaderCode = {
+        #include "bloom.comp.spv.inl"
+    };
+
+    ShaderDesc bloomShaderDesc{};
+    bloomShaderDesc.stage = ShaderStage::Compute;
+    bloomShaderDesc.code = bloomShaderCode;
+    bloomShaderDesc.entryPoint = "main";
+
+    m_Bloom = std::make_unique<Bloom>(m_Device, m_Device->CreateShader(bloomShaderDesc));
+    if (!m_Bloom->IsValid()) {
+        m_Bloom.reset();
+    }
+}
+
+void Application::CreateAmbientOcclusion() {
+    using namespace rhi;
+
+    // Only the deferred lighting pass has the depth before it shades
+    if (!m_DeferredLighting) {
+        METAGFX_INFO << "Ambient occlusion disabled: it needs deferred lighting";
+        return;
+    }
+
+    std::vector<uint8> aoShaderCode = {
+        #include "ambient_occlusion.comp.spv.inl"
+    };
+
+    ShaderDesc aoShaderDesc{};
+    aoShaderDesc.stage = ShaderStage::Compute;
+    aoShaderDesc.code = aoShaderCode;
+    aoShaderDesc.entryPoint = "main";
+
+    m_AmbientOcclusion = std::make_unique<AmbientOcclusion>(m_Device, m_Device->CreateShader(aoShaderDesc));
+    if (!m_AmbientOcclusion->IsValid()) {
+        m_AmbientOcclusion.reset();
+    }
+}
+
+void Application::CreateScreenSpaceReflections() {
+    using namespace rhi;
+
+    // They trace the G-buffer pass's depth through the culler's depth pyramid
+    if (!m_DeferredLighting || !m_GPUCuller) {
+        METAGFX_INFO << "Screen-space reflections disabled: they need deferred lighting and the depth pyramid";
+        return;
+    }
+
+    std::vector<uint8> ssrShaderCode = {
+        #include "ssr.comp.spv.inl"
     };
 
-    pipelineDesc.topology = rhi::PrimitiveTopology::TriangleList;
-    pipelineDesc.rasterization.cullMode = rhi::CullMode::None;
-    
-    m_Pipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
-    
-    METAGFX_INFO << "Triangle resources created";
+    ShaderDesc ssrShaderDesc{};
+    ssrShaderDesc.stage = ShaderStage::Compute;
+    ssrShaderDesc.code = ssrShaderCode;
+    ssrShaderDesc.entryPoint = "main";
+
+    m_Reflections = std::make_unique<ScreenSpaceReflections>(m_Device, *m_UniformRing,
+                                                             m_Device->CreateShader(ssrShaderDesc));
+    if (!m_Reflections->IsValid()) {
+        m_Reflections.reset();
+    }
 }
 
-void Application::CreateModelPipeline() {
+void Application::CreateWeightedBlendedOIT() {
     using namespace rhi;
 
-    // Load model shaders (SPIR-V bytecode)
+    // Its sums composite over the HDR scene color, which only the tone mapper has
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Weighted blended transparency disabled: it needs the tone mapper";
+        return;
+    }
+
     std::vector<uint8> vertShaderCode = {
-        #include "model.vert.spv.inl"
+        #include "fullscreen.vert.spv.inl"
+    };
+    std::vector<uint8> fragShaderCode = {
+        #include "oit_composite.frag.spv.inl"
     };
 
     ShaderDesc vertShaderDesc{};
@@ -663,230 +3070,898 @@ void Application::CreateModelPipeline() {
     vertShaderDesc.code = vertShaderCode;
     vertShaderDesc.entryPoint = "main";
 
-    auto vertShader = m_Device->CreateShader(vertShaderDesc);
-
-    std::vector<uint8> fragShaderCode = {
-        #include "model.frag.spv.inl"
-    };
-
-    rhi::ShaderDesc fragShaderDesc{};
-    fragShaderDesc.stage = rhi::ShaderStage::Fragment;
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
     fragShaderDesc.code = fragShaderCode;
     fragShaderDesc.entryPoint = "main";
 
-    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+    m_OIT = std::make_unique<WeightedBlendedOIT>(m_Device, m_Device->CreateShader(vertShaderDesc),
+                                                 m_Device->CreateShader(fragShaderDesc),
+                                                 ToneMapper::SCENE_COLOR_FORMAT);
+    if (!m_OIT->IsValid()) {
+        m_OIT.reset();
+    }
+}
 
-    // Create pipeline for models
-    rhi::PipelineDesc pipelineDesc{};
-    pipelineDesc.vertexShader = vertShader;
-    pipelineDesc.fragmentShader = fragShader;
+void Application::CreateSkinning() {
+    using namespace rhi;
 
-    // Vertex input: position (vec3), normal (vec3), texcoord (vec2)
-    pipelineDesc.vertexInput.stride = sizeof(Vertex);
-    pipelineDesc.vertexInput.attributes = {
-        { 0, rhi::Format::R32G32B32_SFLOAT, 0, 0 },                          // position at location 0, binding 0
-        { 1, rhi::Format::R32G32B32_SFLOAT, sizeof(float) * 3, 0 },          // normal at location 1, binding 0
-        { 2, rhi::Format::R32G32_SFLOAT, sizeof(float) * 6, 0 }              // texcoord at location 2, binding 0
+    std::vector<uint8> compShaderCode = {
+        #include "skinning.comp.spv.inl"
     };
 
-    pipelineDesc.topology = rhi::PrimitiveTopology::TriangleList;
-    pipelineDesc.rasterization.cullMode = rhi::CullMode::Back;
-    pipelineDesc.rasterization.frontFace = rhi::FrontFace::CounterClockwise;  // glTF uses CCW winding order
+    ShaderDesc compShaderDesc{};
+    compShaderDesc.stage = ShaderStage::Compute;
+    compShaderDesc.code = compShaderCode;
+    compShaderDesc.entryPoint = "main";
 
-    // Enable depth testing for proper 3D rendering
-    pipelineDesc.depthStencil.depthTestEnable = true;
-    pipelineDesc.depthStencil.depthWriteEnable = true;
+    m_Skinning = std::make_unique<Skinning>(m_Device, m_Device->CreateShader(compShaderDesc),
+                                            m_Device->GetDeviceInfo().framesInFlight);
+    if (!m_Skinning->IsValid()) {
+        m_Skinning.reset();
+    }
+}
+
+void Application::CreateShadingRate() {
+    using namespace rhi;
+
+    // The rate image needs the device to take it in the main pass
+    if (!m_Device->GetDeviceInfo().supportsShadingRateImage) {
+        METAGFX_INFO << "Variable rate shading disabled: the device takes no shading rate image";
+        return;
+    }
+
+    std::vector<uint8> rateShaderCode = {
+        #include "shading_rate.comp.spv.inl"
+    };
 
-    m_ModelPipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
+    ShaderDesc rateShaderDesc{};
+    rateShaderDesc.stage = ShaderStage::Compute;
+    rateShaderDesc.code = rateShaderCode;
+    rateShaderDesc.entryPoint = "main";
 
-    METAGFX_INFO << "Model pipeline created";
+    m_ShadingRate = std::make_unique<ShadingRate>(m_Device, m_Device->CreateShader(rateShaderDesc));
+    if (!m_ShadingRate->IsValid()) {
+        m_ShadingRate.reset();
+    }
 }
 
-void Application::CreateSkyboxPipeline() {
+void Application::CreatePathTracer() {
     using namespace rhi;
 
-    // Load skybox shaders (SPIR-V bytecode)
-    std::vector<uint8> vertShaderCode = {
-        #include "skybox.vert.spv.inl"
+    // Shares the bindless table's materials and the ray-traced shadows' top level, and
+    // its accumulation is linear
+    if (!m_Device->GetDeviceInfo().supportsRayQuery || !m_RayTracingScene || !m_BindlessSupported) {
+        METAGFX_INFO << "Path tracing disabled: it needs ray queries and bindless textures";
+        return;
+    }
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Path tracing disabled: it needs the tone mapping pass";
+        return;
+    }
+
+    std::vector<uint8> traceShaderCode = {
+        #include "path_trace.comp.spv.inl"
+    };
+    std::vector<uint8> compositeVertShaderCode = {
+        #include "fullscreen.vert.spv.inl"
+    };
+    std::vector<uint8> compositeFragShaderCode = {
+        #include "path_trace_composite.frag.spv.inl"
     };
 
-    ShaderDesc vertShaderDesc{};
-    vertShaderDesc.stage = ShaderStage::Vertex;
-    vertShaderDesc.code = vertShaderCode;
-    vertShaderDesc.entryPoint = "main";
+    ShaderDesc traceShaderDesc{};
+    traceShaderDesc.stage = ShaderStage::Compute;
+    traceShaderDesc.code = traceShaderCode;
+    traceShaderDesc.entryPoint = "main";
+
+    ShaderDesc compositeVertShaderDesc{};
+    compositeVertShaderDesc.stage = ShaderStage::Vertex;
+    compositeVertShaderDesc.code = compositeVertShaderCode;
+    compositeVertShaderDesc.entryPoint = "main";
+
+    ShaderDesc compositeFragShaderDesc{};
+    compositeFragShaderDesc.stage = ShaderStage::Fragment;
+    compositeFragShaderDesc.code = compositeFragShaderCode;
+    compositeFragShaderDesc.entryPoint = "main";
+
+    // Reads the main set's frame constants, lights, prefiltered map and top level
+    m_PathTracer = std::make_unique<PathTracer>(
+        m_Device, m_Device->CreateShader(traceShaderDesc), m_Device->CreateShader(compositeVertShaderDesc),
+        m_Device->CreateShader(compositeFragShaderDesc), m_MainBindings, BINDLESS_TEXTURE_CAPACITY,
+        ToneMapper::SCENE_COLOR_FORMAT);
+    if (!m_PathTracer->IsValid()) {
+        m_PathTracer.reset();
+        return;
+    }
 
-    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+    std::vector<uint8> denoiseShaderCode = {
+        #include "denoise.comp.spv.inl"
+    };
 
-    std::vector<uint8> fragShaderCode = {
-        #include "skybox.frag.spv.inl"
+    ShaderDesc denoiseShaderDesc{};
+    denoiseShaderDesc.stage = ShaderStage::Compute;
+    denoiseShaderDesc.code = denoiseShaderCode;
+    denoiseShaderDesc.entryPoint = "main";
+
+    m_Denoiser = std::make_unique<Denoiser>(m_Device, m_Device->CreateShader(denoiseShaderDesc));
+    if (!m_Denoiser->IsValid()) {
+        m_Denoiser.reset();
+    }
+}
+
+void Application::CreateLightProbes() {
+    using namespace rhi;
+
+    // Traces the ray-traced shadows' top level and shades with the bindless table
+    if (!m_Device->GetDeviceInfo().supportsRayQuery || !m_RayTracingScene || !m_BindlessSupported) {
+        METAGFX_INFO << "Light probes disabled: they need ray queries and bindless textures";
+        return;
+    }
+
+    std::vector<uint8> shaderCode = {
+        #include "probe_update.comp.spv.inl"
     };
 
-    ShaderDesc fragShaderDesc{};
-    fragShaderDesc.stage = ShaderStage::Fragment;
-    fragShaderDesc.code = fragShaderCode;
-    fragShaderDesc.entryPoint = "main";
+    ShaderDesc shaderDesc{};
+    shaderDesc.stage = ShaderStage::Compute;
+    shaderDesc.code = shaderCode;
+    shaderDesc.entryPoint = "main";
 
-    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+    // Reads the main set's frame constants, lights, prefiltered map, top level and probes
+    m_LightProbes = std::make_unique<LightProbeVolume>(
+        m_Device, m_Device->CreateShader(shaderDesc), m_MainBindings, BINDLESS_TEXTURE_CAPACITY);
+    if (!m_LightProbes->IsValid()) {
+        m_LightProbes.reset();
+    }
+}
 
-    // Create pipeline for skybox
-    PipelineDesc pipelineDesc{};
-    pipelineDesc.vertexShader = vertShader;
-    pipelineDesc.fragmentShader = fragShader;
+void Application::CreateTemporalAA() {
+    using namespace rhi;
 
-    // Vertex input: position (vec3) only - used as cubemap direction
-    pipelineDesc.vertexInput.stride = sizeof(Vertex);
-    pipelineDesc.vertexInput.attributes = {
-        { 0, Format::R32G32B32_SFLOAT, 0, 0 }  // position at location 0, binding 0
+    // The history accumulates the HDR scene color, which only the tone mapper has
+    if (!m_ToneMapper) {
+        METAGFX_INFO << "Temporal AA disabled: it needs the tone mapping pass";
+        return;
+    }
+
+    std::vector<uint8> taaShaderCode = {
+        #include "taa.comp.spv.inl"
     };
 
-    pipelineDesc.topology = PrimitiveTopology::TriangleList;
-    pipelineDesc.rasterization.cullMode = CullMode::None;  // No culling for debugging
-    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
+    ShaderDesc taaShaderDesc{};
+    taaShaderDesc.stage = ShaderStage::Compute;
+    taaShaderDesc.code = taaShaderCode;
+    taaShaderDesc.entryPoint = "main";
 
-    // Depth testing: LessOrEqual without writing depth (render where depth == 1.0 cleared value)
-    pipelineDesc.depthStencil.depthTestEnable = true;
-    pipelineDesc.depthStencil.depthWriteEnable = false;  // Don't write depth
-    pipelineDesc.depthStencil.depthCompareOp = CompareOp::LessOrEqual;
+    // Upscaling goes to the device's own temporal upscaler where it has one
+    Ref<Shader> motionShader;
+    if (m_Device->GetDeviceInfo().supportsTemporalUpscaler) {
+        std::vector<uint8> motionShaderCode = {
+            #include "taa_motion.comp.spv.inl"
+        };
+        ShaderDesc motionShaderDesc{};
+        motionShaderDesc.stage = ShaderStage::Compute;
+        motionShaderDesc.code = motionShaderCode;
+        motionShaderDesc.entryPoint = "main";
+        motionShader = m_Device->CreateShader(motionShaderDesc);
+    }
+
+    m_TemporalAA = std::make_unique<TemporalAA>(m_Device, m_Device->CreateShader(taaShaderDesc), motionShader);
+    if (!m_TemporalAA->IsValid()) {
+        m_TemporalAA.reset();
+    }
+}
 
-    m_SkyboxPipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
+// The renderer's passes and pooled textures are replaced; the old ones are retired
+void Application::SetRenderMode(RenderMode mode) {
+    if (mode != RenderMode::Deferred && mode != RenderMode::VisibilityBuffer && mode != RenderMode::PathTracing) {
+        mode = RenderMode::Rasterization;
+    }
+    if (m_Renderer && m_Renderer->GetMode() == mode) {
+        return;
+    }
 
-    METAGFX_INFO << "Skybox pipeline created";
+    // Frames in flight may still use the old renderer's textures (it holds the device
+    // until BeginFrame() releases it)
+    if (m_Renderer) {
+        m_Device->Retire(Ref<RasterizationRenderer>(std::move(m_Renderer)));
+    }
+    if (mode == RenderMode::Deferred) {
+        m_Renderer = std::make_unique<DeferredRenderer>(m_Device);
+    } else if (mode == RenderMode::VisibilityBuffer) {
+        m_Renderer = std::make_unique<VisibilityBufferRenderer>(m_Device);
+    } else if (mode == RenderMode::PathTracing) {
+        m_Renderer = std::make_unique<PathTracingRenderer>(m_Device);
+    } else {
+        m_Renderer = std::make_unique<RasterizationRenderer>(m_Device);
+    }
+    m_Renderer->Initialize();  // Sized by the next frame's OnResize()
+    m_Config.renderMode = mode;
+    METAGFX_INFO << "Render mode: " << m_Renderer->GetName();
 }
 
-void Application::CreateShadowPipeline() {
-    using namespace rhi;
+// The forward main pass is multisampled when it resolves into the HDR scene color. Its
+// pipelines are created for the sample count, so they are rebuilt when it changes, with
+// no frame in flight: the replaced ones could not draw into the new attachments.
+void Application::UpdateMSAA() {
+    uint32 samples = m_EnableMSAA && m_ToneMapper && m_Renderer->GetMode() == RenderMode::Rasterization
+                         ? MSAA_SAMPLES : 1;
+    if (samples == m_MSAASamples) {
+        return;
+    }
 
-    // Load shadow map shaders (SPIR-V bytecode)
-    std::vector<uint8> vertShaderCode = {
-        #include "shadowmap.vert.spv.inl"
-    };
+    // Outstanding compiles land first: they are for the old sample count
+    for (PendingPipeline& pending : m_PendingPipelines) {
+        pending.future->Wait();
+    }
+    CollectPendingPipelines();
+    m_Device->WaitIdle();
+
+    // The background-compiled ones draw nothing (or fall back) until they are ready
+    m_MSAASamples = samples;
+    m_ModelPermutations.clear();
+    m_BindlessModelPipeline.reset();
+    m_BindlessCompactModelPipeline.reset();
+    m_PulledModelPipeline.reset();
+    m_RayTracedModelPipeline.reset();
+    m_RayTracedCompactModelPipeline.reset();
+    m_SkyboxPipeline.reset();
+    m_DepthPrepassPipelines = {};
+    CreateModelPipeline();
+    CreateSkyboxPipeline();
+    CreateDepthPrepassPipeline();
+    METAGFX_INFO << "Main pass: " << m_MSAASamples << " sample(s) per pixel";
+}
 
-    ShaderDesc vertShaderDesc{};
-    vertShaderDesc.stage = ShaderStage::Vertex;
-    vertShaderDesc.code = vertShaderCode;
-    vertShaderDesc.entryPoint = "main";
+void Application::SetShadowFilter(ShadowFilter filter) {
+    if (filter == ShadowFilter::Auto) {
+        // Integrated GPUs share their bandwidth with the CPU: one tap per pixel there
+        filter = m_Device->GetDeviceInfo().isIntegratedGPU ? ShadowFilter::Hardware : ShadowFilter::PCF;
+    }
+    if (filter == ShadowFilter::EVSM && !m_ShadowMoments) {
+        METAGFX_WARN << "EVSM shadows unavailable, filtering with PCF";
+        filter = ShadowFilter::PCF;
+    }
+    m_ShadowFilter = filter;
+}
 
-    auto vertShader = m_Device->CreateShader(vertShaderDesc);
+void Application::Run() {
+    if (m_Config.pipelinedRendering) {
+        RunPipelined();
+        return;
+    }
 
-    std::vector<uint8> fragShaderCode = {
-        #include "shadowmap.frag.spv.inl"
+    METAGFX_INFO << "Starting main loop...";
+    METAGFX_PROFILE_THREAD("Main");
+    
+    uint64_t lastTime = SDL_GetTicksNS();
+    
+    while (m_Running) {
+        // On demand, a still image that has finished refining sleeps until an event (left
+        // queued for ProcessEvents()) or the timeout, and the time asleep moves nothing
+        bool onDemand = m_Config.onDemandRendering;
+        if (onDemand && m_StillFrames >= m_Config.idleRefineFrames && !HasBackgroundWork()) {
+            METAGFX_PROFILE_SCOPE("Wait for events");
+            SDL_WaitEventTimeout(nullptr, static_cast<Sint32>(m_Config.idleWaitMs));
+            lastTime = SDL_GetTicksNS();
+            if (m_HitchDetector) {
+                m_HitchDetector->Restart();
+            }
+        }
+
+        // Let the last frame reach the display first, so the input polled below is as
+        // fresh as possible when this frame is shown
+        if (m_Config.justInTimeInput) {
+            METAGFX_PROFILE_SCOPE("Wait for present");
+            m_Device->GetSwapChain()->WaitForPresent(m_Config.maxPendingPresents);
+        }
+
+        // Calculate delta time
+        uint64_t currentTime = SDL_GetTicksNS();
+        float deltaTime = (currentTime - lastTime) / 1000000000.0f;
+        lastTime = currentTime;
+        
+        JobSystem::ProcessMainThreadJobs();
+        bool input = ProcessEvents();
+        Update(deltaTime);
+        if (onDemand) {
+            bool moved = m_Camera->GetViewMatrix() != m_FrameCamera->GetViewMatrix() ||
+                         m_Camera->GetUnjitteredProjectionMatrix() != m_FrameCamera->GetUnjitteredProjectionMatrix();
+            if (input || moved || HasBackgroundWork()) {
+                m_StillFrames = 0;
+            } else if (m_StillFrames >= m_Config.idleRefineFrames) {
+                continue;  // Woken by the timeout with nothing to draw
+            } else {
+                ++m_StillFrames;
+            }
+        }
+        *m_FrameCamera = *m_Camera;
+        Render();
+        METAGFX_PROFILE_FRAME();
+    }
+
+    METAGFX_INFO << "Main loop ended";
+}
+
+// The main thread polls events and moves the camera for frame N+1 while the render
+// thread records frame N. Frames pass between them as packets: a snapshot of the camera
+// and the events the render thread handles. The queue holds at most maxQueuedFrames
+// packets, so the main thread runs at most that many frames ahead.
+void Application::RunPipelined() {
+    uint32 maxQueuedFrames = std::max(1u, m_Config.maxQueuedFrames);
+    METAGFX_INFO << "Starting pipelined main loop (up to " << maxQueuedFrames << " queued frames)...";
+
+    METAGFX_PROFILE_THREAD("Main");
+    std::thread renderThread([this]() { RenderThreadMain(); });
+
+    uint64_t lastTime = SDL_GetTicksNS();
+    while (m_Running) {
+        uint64_t currentTime = SDL_GetTicksNS();
+        float deltaTime = (currentTime - lastTime) / 1000000000.0f;
+        lastTime = currentTime;
+
+        JobSystem::ProcessMainThreadJobs();
+
+        std::unique_lock<std::mutex> cameraLock(m_CameraMutex);
+        ProcessEvents();
+        Update(deltaTime);
+        FramePacket packet{ *m_Camera, std::move(m_ForwardedEvents) };
+        cameraLock.unlock();
+        m_ForwardedEvents.clear();
+
+        {
+            METAGFX_PROFILE_SCOPE("Wait for render thread");
+            std::unique_lock<std::mutex> lock(m_FramePacketMutex);
+            m_FramePacketPopped.wait(lock, [&]() { return m_FramePackets.size() < maxQueuedFrames; });
+            m_FramePackets.push_back(std::move(packet));
+        }
+        m_FramePacketPushed.notify_one();
+        METAGFX_PROFILE_FRAME();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_FramePacketMutex);
+        m_FramePacketsClosed = true;
+    }
+    m_FramePacketPushed.notify_one();
+    renderThread.join();
+
+    METAGFX_INFO << "Main loop ended";
+}
+
+void Application::RenderThreadMain() {
+    METAGFX_PROFILE_THREAD("Render");
+    while (true) {
+        std::unique_lock<std::mutex> lock(m_FramePacketMutex);
+        m_FramePacketPushed.wait(lock, [&]() { return !m_FramePackets.empty() || m_FramePacketsClosed; });
+        if (m_FramePackets.empty()) {
+            break;  // Closed, and every packet has been rendered
+        }
+        FramePacket packet = std::move(m_FramePackets.front());
+        m_FramePackets.pop_front();
+        lock.unlock();
+        m_FramePacketPopped.notify_one();
+
+        for (ForwardedEvent& forwarded : packet.events) {
+            if (forwarded.event.type == SDL_EVENT_TEXT_INPUT) {
+                forwarded.event.text.text = forwarded.text.c_str();
+            } else if (forwarded.event.type == SDL_EVENT_TEXT_EDITING) {
+                forwarded.event.edit.text = forwarded.text.c_str();
+            } else if (forwarded.event.type == SDL_EVENT_DROP_FILE) {
+                forwarded.event.drop.data = forwarded.text.c_str();
+            }
+            HandleRenderEvent(forwarded.event);
+        }
+        *m_FrameCamera = packet.camera;
+        Render();
+    }
+}
+
+// Renders warmup frames, then the measured ones, each from a camera position that depends
+// only on the frame index, so every run draws the same views. CPU time is the whole loop
+// iteration; GPU time is first to last timestamp of the frame, read back framesInFlight
+// frames later, which is why a few unmeasured frames follow.
+bool Application::RunBenchmark() {
+    if (!m_Running || !m_Device || !m_Model) {
+        METAGFX_ERROR << "Benchmark not started: initialization failed";
+        return false;
+    }
+    const BenchmarkConfig& bench = m_Config.benchmark;
+    METAGFX_PROFILE_THREAD("Main");
+    bool checkAllocations = bench.maxFrameAllocations >= 0;
+    if (checkAllocations && !AllocationTracker::IsAvailable()) {
+        METAGFX_ERROR << "Benchmark not started: allocation checks need METAGFX_TRACK_ALLOCATIONS";
+        return false;
+    }
+
+    auto swapChain = m_Device->GetSwapChain();
+    float aspect = static_cast<float>(swapChain->GetWidth()) / static_cast<float>(std::max(1u, swapChain->GetHeight()));
+    glm::vec3 target;
+    float radius;
+    GetSceneOrbit(target, radius);
+    bool cameraPath = m_SceneDescription && !m_SceneDescription->cameraPath.empty();
+
+    uint32 frameCount = std::max(1u, bench.frames);
+    uint64 renderedFrames = 0;
+    uint64 firstMeasured = UINT64_MAX;  // GPU profiler frame number of the first measured frame
+    std::vector<double> cpuTimes;
+    std::vector<double> gpuTimes;
+    uint64 drawCalls = 0;
+    uint64 triangles = 0;
+    uint64 lastGpuFrame = UINT64_MAX;
+    // Heap allocations of the measured frames, from one Render() to the next
+    uint64 allocations = 0;
+    uint64 allocationBytes = 0;
+    uint64 renderAllocations = 0;
+    uint64 maxRenderAllocations = 0;
+    uint32 allocatingFrames = 0;  // With render allocations
+
+    auto renderFrame = [&](uint32 pathFrame) {
+        float t = static_cast<float>(pathFrame) / static_cast<float>(frameCount);
+        if (cameraPath) {
+            SceneDescription::CameraKey key = GetCameraPathKey(t, target);
+            float farPlane = std::max(100.0f, (glm::length(key.position - target) + radius) * 2.0f);
+            m_Camera->SetPerspective(key.fov, aspect, 0.1f, farPlane);
+            m_Camera->SetPosition(key.position);
+            m_Camera->LookAt(key.target);
+        } else {
+            float angle = 2.0f * glm::pi<float>() * t;
+            glm::vec3 offset(std::sin(angle), 0.35f + 0.15f * std::sin(2.0f * angle), std::cos(angle));
+            m_Camera->SetPerspective(45.0f, aspect, 0.1f, std::max(100.0f, radius * 4.0f));
+            m_Camera->SetPosition(target + offset * radius);
+            m_Camera->LookAt(target);
+        }
+        *m_FrameCamera = *m_Camera;
+
+        JobSystem::ProcessMainThreadJobs();
+        ProcessEvents();
+        Render();
+        ++renderedFrames;
+        METAGFX_PROFILE_FRAME();
+
+        if (m_GpuProfiler) {
+            const rhi::GpuProfiler::FrameTimings& timings = m_GpuProfiler->GetLatestFrame();
+            if (timings.frameNumber != lastGpuFrame && timings.frameNumber >= firstMeasured &&
+                timings.frameNumber - firstMeasured < frameCount && timings.gpuTimeMs > 0.0) {
+                gpuTimes.push_back(timings.gpuTimeMs);
+            }
+            lastGpuFrame = timings.frameNumber;
+        }
     };
 
-    ShaderDesc fragShaderDesc{};
-    fragShaderDesc.stage = ShaderStage::Fragment;
-    fragShaderDesc.code = fragShaderCode;
-    fragShaderDesc.entryPoint = "main";
+    METAGFX_INFO << "Benchmark: " << bench.warmupFrames << " warmup frames, then " << frameCount << " measured";
+    uint32 warmupFrames = 0;
+    while (m_Running && (warmupFrames < bench.warmupFrames || !m_PendingPipelines.empty() || IsSceneLoading())) {
+        renderFrame(0);
+        ++warmupFrames;
+    }
+    if (m_Running && !IsSceneModelShown()) {
+        METAGFX_ERROR << "Benchmark not run: the scene's model failed to load";
+        return false;
+    }
+    GetSceneOrbit(target, radius);  // Of the scene file's model, now resident
+
+    firstMeasured = renderedFrames;
+    cpuTimes.reserve(frameCount);
+    for (uint32 i = 0; i < frameCount && m_Running; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        renderFrame(i);
+        cpuTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+
+        // The previous frame's counters, complete once this frame began
+        const rhi::FrameStats& stats = m_Device->GetFrameStats();
+        drawCalls += stats.drawCalls;
+        triangles += stats.triangles;
+
+        AllocationFrame frameAllocations = AllocationTracker::GetLatestFrame();
+        const AllocationCounts& render = frameAllocations.tags[static_cast<uint32>(AllocationTag::Render)];
+        allocations += frameAllocations.total.allocations;
+        allocationBytes += frameAllocations.total.bytes;
+        renderAllocations += render.allocations;
+        maxRenderAllocations = std::max(maxRenderAllocations, render.allocations);
+        allocatingFrames += render.allocations > 0 ? 1 : 0;
+    }
+    for (uint32 i = 0; i < m_Device->GetDeviceInfo().framesInFlight && m_Running; ++i) {
+        renderFrame(frameCount - 1);
+    }
+    m_Device->WaitIdle();
 
-    auto fragShader = m_Device->CreateShader(fragShaderDesc);
+    if (!m_Running) {
+        METAGFX_ERROR << "Benchmark interrupted";
+        return false;
+    }
 
-    // Create pipeline for shadow map rendering (depth-only)
-    PipelineDesc pipelineDesc{};
-    pipelineDesc.vertexShader = vertShader;
-    pipelineDesc.fragmentShader = fragShader;
+    std::ofstream out(bench.outputPath);
+    if (!out.is_open()) {
+        METAGFX_ERROR << "Failed to write benchmark results: " << bench.outputPath;
+        return false;
+    }
+    const rhi::DeviceInfo& deviceInfo = m_Device->GetDeviceInfo();
+    const char* apiName = "Unknown";
+    switch (deviceInfo.api) {
+        case rhi::GraphicsAPI::Vulkan: apiName = "Vulkan"; break;
+        case rhi::GraphicsAPI::Direct3D12: apiName = "D3D12"; break;
+        case rhi::GraphicsAPI::Metal: apiName = "Metal"; break;
+        case rhi::GraphicsAPI::WebGPU: apiName = "WebGPU"; break;
+    }
+    double frames = static_cast<double>(cpuTimes.size());
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"backend\": \"" << apiName << "\",\n  \"device\": ";
+    WriteJsonString(out, deviceInfo.deviceName);
+    out << ",\n  \"adapter\": " << deviceInfo.adapterIndex << ",\n  \"features\": [";
+    std::vector<const char*> features = rhi::GetFeatureNames(deviceInfo);
+    for (size_t i = 0; i < features.size(); ++i) {
+        out << (i ? ", \"" : "\"") << features[i] << '"';
+    }
+    out << "]";
+    out << ",\n  \"width\": " << swapChain->GetWidth() << ",\n  \"height\": " << swapChain->GetHeight()
+        << ",\n  \"framesInFlight\": " << deviceInfo.framesInFlight << ",\n  \"scene\": ";
+    WriteJsonString(out, m_SceneDescription ? m_SceneDescription->filePath
+                         : bench.modelPath.empty() ? std::string("cube") : bench.modelPath);
+    static const char* filterNames[] = { "hardware", "pcf", "poisson", "pcss", "evsm" };
+    out << ",\n  \"instanceGrid\": " << (GetSceneInstances() ? 1 : m_InstanceGrid)
+        << ",\n  \"instances\": " << m_ModelNodeBases.size()
+        << ",\n  \"shadowFilter\": \"" << filterNames[static_cast<uint32>(m_ShadowFilter)] << '"'
+        << ",\n  \"shadowDepthBits\": " << (m_ShadowDepthFormat == rhi::Format::D16_UNORM ? 16 : 32)
+        << ",\n  \"renderMode\": \""
+        << (m_VisibilityBufferActive ? "visibility"
+            : (m_Renderer->GetMode() == RenderMode::Deferred || m_Renderer->GetMode() == RenderMode::VisibilityBuffer) &&
+                      m_DeferredLighting ? "deferred"
+            : m_PathTracingActive        ? "pathtraced"
+                                         : "forward") << '"'
+        << ",\n  \"depthPrepass\": " << (m_Renderer->IsDepthPrepassDrawn() ? "true" : "false")
+        << ",\n  \"shadingPrecision\": \"" << (m_HalfPrecisionShading ? "half" : "full") << '"'
+        << ",\n  \"vertexPulling\": " << (m_ModelPass.variant == ModelVariantPulled ? "true" : "false")
+        << ",\n  \"hdrSceneColor\": " << (m_ToneMapper ? "true" : "false")
+        << ",\n  \"autoExposure\": " << (m_AutoExposure && m_EnableAutoExposure ? "true" : "false")
+        << ",\n  \"ambientOcclusion\": " << (m_AmbientOcclusionActive ? "true" : "false")
+        << ",\n  \"reflections\": " << (m_ReflectionsActive ? "true" : "false")
+        << ",\n  \"lods\": " << (m_EnableLods ? "true" : "false")
+        << ",\n  \"textureStreamingExtent\": " << m_Config.modelImport.textureStreamingExtent
+        << ",\n  \"variableRateShading\": " << (m_Renderer->IsShadingRateApplied() ? "true" : "false")
+        << ",\n  \"bloom\": " << (m_Bloom && m_EnableBloom ? "true" : "false")
+        << ",\n  \"taa\": " << (m_TemporalAAActive ? "true" : "false")
+        << ",\n  \"upscale\": " << (m_TemporalAAActive ? UPSCALE_MODES[m_UpscaleMode].upscale : 1.0f)
+        << ",\n  \"renderScale\": " << m_RenderScale
+        << ",\n  \"msaaSamples\": " << m_MSAASamples
+        << ",\n  \"timeToFirstFrameMs\": " << m_TimeToFirstFrameMs
+        << ",\n  \"timeToResidentMs\": " << m_TimeToResidentMs
+        << ",\n  \"warmupFrames\": " << warmupFrames
+        << ",\n  \"frames\": " << cpuTimes.size()
+        << ",\n  \"cpuFrameMs\": ";
+    WriteFrameTimes(out, cpuTimes);
+    out << ",\n  \"gpuFrameMs\": ";
+    WriteFrameTimes(out, gpuTimes);
+    out << ",\n  \"drawCallsPerFrame\": " << static_cast<double>(drawCalls) / frames
+        << ",\n  \"trianglesPerFrame\": " << static_cast<double>(triangles) / frames
+        << ",\n  \"cpuAllocations\": ";
+    if (AllocationTracker::IsAvailable()) {
+        out << "{ \"perFrame\": " << static_cast<double>(allocations) / frames
+            << ", \"bytesPerFrame\": " << static_cast<double>(allocationBytes) / frames
+            << ", \"renderPerFrame\": " << static_cast<double>(renderAllocations) / frames
+            << ", \"renderMax\": " << maxRenderAllocations << ", \"allocatingFrames\": " << allocatingFrames << " }";
+    } else {
+        out << "null";
+    }
+    out << ",\n  \"memoryMB\": {";
+    rhi::MemoryStats memory = m_Device->GetMemoryStats();
+    for (uint32 category = 0; category < rhi::MemoryStats::CATEGORY_COUNT; ++category) {
+        out << (category > 0 ? ", " : "") << "\"" << rhi::GetMemoryCategoryName(static_cast<rhi::MemoryCategory>(category))
+            << "\": " << static_cast<double>(memory.bytes[category]) / (1024.0 * 1024.0);
+    }
+    out << "},\n  \"memoryUsageMB\": " << static_cast<double>(memory.GetUsageBytes()) / (1024.0 * 1024.0)
+        << ",\n  \"memoryBudgetMB\": " << static_cast<double>(memory.budget.budgetBytes) / (1024.0 * 1024.0) << "\n}\n";
+    if (!out.good()) {
+        METAGFX_ERROR << "Failed to write benchmark results: " << bench.outputPath;
+        return false;
+    }
 
-    // Vertex input: position (vec3) only
-    pipelineDesc.vertexInput.stride = sizeof(Vertex);
-    pipelineDesc.vertexInput.attributes = {
-        { 0, Format::R32G32B32_SFLOAT, 0, 0 }  // position at location 0, binding 0
+    METAGFX_INFO << "Wrote benchmark results of " << cpuTimes.size() << " frames to " << bench.outputPath;
+    if (checkAllocations && maxRenderAllocations > static_cast<uint64>(bench.maxFrameAllocations)) {
+        METAGFX_ERROR << "Benchmark failed: " << allocatingFrames << " of " << cpuTimes.size()
+                      << " measured frames allocated while rendering, up to " << maxRenderAllocations
+                      << " times (allowed: " << bench.maxFrameAllocations << ")";
+        return false;
+    }
+    return true;
+}
+
+// Renders each view a few frames in a row, the camera cut to it, and captures the last:
+// its readback completes framesInFlight frames later while the next views render, and its
+// encode and write run on the job system's workers meanwhile. Once maxPendingWrites
+// images wait to be written, the next capture waits for them, which bounds the memory
+// they hold.
+bool Application::RunBatch() {
+    if (!m_Running || !m_Device || !m_Model) {
+        METAGFX_ERROR << "Batch render not started: initialization failed";
+        return false;
+    }
+    const BatchConfig& batch = m_Config.batch;
+    METAGFX_PROFILE_THREAD("Main");
+
+    bool exr = batch.format == BatchConfig::ImageFormat::EXR;
+    if (exr && !m_ToneMapper) {
+        METAGFX_ERROR << "EXR batch renders need the HDR scene color, which needs tone mapping";
+        return false;
+    }
+
+    // Views around the scene are placed once its model is resident, below
+    std::vector<SceneDescription::CameraKey> views;
+    if (!batch.viewsPath.empty()) {
+        if (!LoadBatchViews(batch.viewsPath, views)) {
+            return false;
+        }
+    } else if (m_SceneDescription) {
+        views = m_SceneDescription->cameraPath;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(batch.outputDirectory, error);
+    if (error) {
+        METAGFX_ERROR << "Failed to create " << batch.outputDirectory << ": " << error.message();
+        return false;
+    }
+
+    // Shared with the readback callbacks and write jobs, which may outlive the run when
+    // it is interrupted
+    struct Progress {
+        std::atomic<uint32> pendingReadbacks{ 0 };
+        std::atomic<uint32> pendingWrites{ 0 };
+        std::atomic<uint32> written{ 0 };
+        std::atomic<uint32> failed{ 0 };
+        JobCounter writes;
     };
+    auto progress = std::make_shared<Progress>();
+    uint32 maxPendingWrites =
+        batch.maxPendingWrites > 0 ? batch.maxPendingWrites : std::max(2u, 2 * JobSystem::GetWorkerCount());
+    m_CaptureReadback = std::make_unique<rhi::ReadbackPool>(m_Device);
 
-    pipelineDesc.topology = PrimitiveTopology::TriangleList;
-    pipelineDesc.rasterization.cullMode = CullMode::Back;
-    pipelineDesc.rasterization.frontFace = FrontFace::CounterClockwise;
-    pipelineDesc.rasterization.depthBiasEnable = true;  // Enable depth bias to reduce shadow acne
-    pipelineDesc.rasterization.depthBiasConstantFactor = 1.25f;
-    pipelineDesc.rasterization.depthBiasSlopeFactor = 1.75f;
+    auto swapChain = m_Device->GetSwapChain();
+    float aspect = static_cast<float>(swapChain->GetWidth()) / static_cast<float>(std::max(1u, swapChain->GetHeight()));
+    glm::vec3 center;
+    float radius;
+    auto setView = [&](const SceneDescription::CameraKey& view) {
+        float farPlane = std::max(100.0f, (glm::length(view.position - center) + radius) * 2.0f);
+        m_Camera->SetPerspective(view.fov, aspect, 0.1f, farPlane);
+        m_Camera->SetPosition(view.position);
+        m_Camera->LookAt(view.hasTarget ? view.target : center);
+        *m_FrameCamera = *m_Camera;
+    };
+    auto renderFrame = [&]() {
+        JobSystem::ProcessMainThreadJobs();
+        ProcessEvents();
+        Render();
+        METAGFX_PROFILE_FRAME();
+    };
 
-    // Enable depth testing and writing for shadow map
-    pipelineDesc.depthStencil.depthTestEnable = true;
-    pipelineDesc.depthStencil.depthWriteEnable = true;
-    pipelineDesc.depthStencil.depthCompareOp = CompareOp::Less;  // Standard: closer fragments win
+    // Copies the frame's final image into a staging buffer; once read back, a job
+    // encodes and writes it
+    auto captureTo = [this, progress](const std::string& path) {
+        return [this, progress, path](rhi::CommandBuffer& cmd, const Ref<rhi::Texture>& image) {
+            rhi::Format format = image->GetFormat();
+            utils::ImageView layout;
+            layout.width = image->GetWidth();
+            layout.height = image->GetHeight();
+            layout.rowPitch = rhi::GetReadbackRowPitch(format, layout.width);
+            ++progress->pendingReadbacks;
+            bool read = m_CaptureReadback->ReadTexture(cmd, image, [progress, path, format, layout]
+                                                       (const void* data, uint64 size) {
+                --progress->pendingReadbacks;
+                if (!data || size < static_cast<uint64>(layout.rowPitch) * layout.height) {
+                    METAGFX_ERROR << "Batch render: failed to read back " << path;
+                    ++progress->failed;
+                    return;
+                }
+                // The staging buffer returns to the pool after this call
+                const uint8* bytes = static_cast<const uint8*>(data);
+                auto pixels = std::make_shared<std::vector<uint8>>(bytes, bytes + size);
+                ++progress->pendingWrites;
+                JobSystem::Run([progress, path, format, layout, pixels]() {
+                    utils::ImageView image = layout;
+                    image.data = pixels->data();
+                    std::vector<uint8> encoded;
+                    switch (format) {
+                        case rhi::Format::R8G8B8A8_UNORM:
+                        case rhi::Format::R8G8B8A8_SRGB:     encoded = utils::EncodePNG(image, false); break;
+                        case rhi::Format::B8G8R8A8_UNORM:
+                        case rhi::Format::B8G8R8A8_SRGB:     encoded = utils::EncodePNG(image, true); break;
+                        case rhi::Format::R16G16B16A16_SFLOAT: encoded = utils::EncodeEXR(image); break;
+                        default: break;
+                    }
+                    if (encoded.empty() || !utils::WriteFileBytes(path, encoded)) {
+                        METAGFX_ERROR << "Batch render: failed to write " << path
+                                      << (encoded.empty() ? " (unsupported image format)" : "");
+                        ++progress->failed;
+                    } else {
+                        ++progress->written;
+                    }
+                    --progress->pendingWrites;
+                }, &progress->writes);
+            });
+            if (!read) {
+                --progress->pendingReadbacks;
+                ++progress->failed;
+            }
+        };
+    };
 
-    m_ShadowPipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
+    // The scene loads and the pipelines compile before the first view
+    uint32 warmupFrames = 0;
+    while (m_Running && (warmupFrames < batch.warmupFrames || !m_PendingPipelines.empty() || IsSceneLoading())) {
+        renderFrame();
+        ++warmupFrames;
+    }
+    if (m_Running && !IsSceneModelShown()) {
+        METAGFX_ERROR << "Batch render not run: the scene's model failed to load";
+        return false;
+    }
 
-    METAGFX_INFO << "Shadow pipeline created";
-}
+    GetSceneOrbit(center, radius);
+    if (views.empty()) {
+        uint32 count = std::max(1u, batch.turntableViews);
+        for (uint32 i = 0; i < count; ++i) {
+            float angle = 2.0f * glm::pi<float>() * static_cast<float>(i) / static_cast<float>(count);
+            SceneDescription::CameraKey view;
+            char name[32];
+            std::snprintf(name, sizeof(name), "turntable_%04u", i);
+            view.name = name;
+            view.position = center + glm::vec3(std::sin(angle), 0.35f, std::cos(angle)) * radius;
+            views.push_back(std::move(view));
+        }
+    }
+    // Interleaved, so each shard gets views from all around the scene
+    if (batch.shardCount > 1) {
+        METAGFX_INFO << "Batch render: shard " << batch.shardIndex + 1 << " of " << batch.shardCount;
+        std::vector<SceneDescription::CameraKey> shardViews;
+        for (size_t i = batch.shardIndex; i < views.size(); i += batch.shardCount) {
+            shardViews.push_back(std::move(views[i]));
+        }
+        views = std::move(shardViews);
+    }
 
-void Application::CreateSkyboxCube() {
-    using namespace rhi;
+    // Temporal AA's history converges over its jitter phases; path traced views settle
+    // once the tracer has converged
+    constexpr uint32 TEMPORAL_SETTLE_FRAMES = 16;
+    constexpr uint32 MAX_SETTLE_FRAMES = 4096;
+    uint32 settleFrames = batch.settleFrames > 0 ? batch.settleFrames : m_TemporalAAActive ? TEMPORAL_SETTLE_FRAMES : 1;
+    METAGFX_INFO << "Batch render: " << views.size() << " views to " << batch.outputDirectory << " as "
+                 << (exr ? "EXR" : "PNG") << ", " << (batch.settleFrames > 0 ? "" : "at least ") << settleFrames
+                 << " frames each";
+
+    auto start = std::chrono::steady_clock::now();
+    uint64 renderedFrames = 0;
+    for (const SceneDescription::CameraKey& view : views) {
+        if (!m_Running) {
+            break;
+        }
+        setView(view);
 
-    // Skybox cube vertices (positions only)
-    // We use a unit cube centered at origin
-    Vertex vertices[] = {
-        // Back face
-        {{-1.0f, -1.0f, -1.0f}, {}, {}},
-        {{ 1.0f, -1.0f, -1.0f}, {}, {}},
-        {{ 1.0f,  1.0f, -1.0f}, {}, {}},
-        {{-1.0f,  1.0f, -1.0f}, {}, {}},
-        // Front face
-        {{-1.0f, -1.0f,  1.0f}, {}, {}},
-        {{ 1.0f, -1.0f,  1.0f}, {}, {}},
-        {{ 1.0f,  1.0f,  1.0f}, {}, {}},
-        {{-1.0f,  1.0f,  1.0f}, {}, {}},
-    };
-
-    // Cube indices (36 indices for 12 triangles, 6 faces)
-    uint32_t indices[] = {
-        // Back face
-        0, 1, 2, 2, 3, 0,
-        // Front face
-        4, 6, 5, 6, 4, 7,
-        // Left face
-        4, 0, 3, 3, 7, 4,
-        // Right face
-        1, 5, 6, 6, 2, 1,
-        // Bottom face
-        4, 5, 1, 1, 0, 4,
-        // Top face
-        3, 2, 6, 6, 7, 3
-    };
+        // A cut: the last view's history would ghost into this one
+        if (m_TemporalAA) {
+            m_TemporalAA->ResetHistory();
+        }
+        if (m_AmbientOcclusion) {
+            m_AmbientOcclusion->ResetHistory();
+        }
+        if (m_Reflections) {
+            m_Reflections->ResetHistory();
+        }
+        if (m_Denoiser) {
+            m_Denoiser->ResetHistory();
+        }
 
-    // Create vertex buffer
-    BufferDesc vertexBufferDesc{};
-    vertexBufferDesc.size = sizeof(vertices);
-    vertexBufferDesc.usage = BufferUsage::Vertex;
-    vertexBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+        std::string path = (std::filesystem::path(batch.outputDirectory) / (view.name + (exr ? ".exr" : ".png"))).string();
+        for (uint32 frame = 1; m_Running; ++frame) {
+            // Background work is asked about once a frame of the view has started the path
+            // tracer over
+            bool last = frame >= MAX_SETTLE_FRAMES ||
+                        (frame >= settleFrames &&
+                         (batch.settleFrames > 0 || ((frame > 1 || !m_PathTracingActive) && !HasBackgroundWork())));
+            if (last) {
+                if (progress->pendingWrites >= maxPendingWrites) {
+                    JobSystem::Wait(progress->writes);
+                }
+                m_FrameCapture = captureTo(path);
+                m_FrameCaptureHDR = exr;
+            }
+            renderFrame();
+            m_FrameCapture = nullptr;
+            ++renderedFrames;
+            if (last) {
+                break;
+            }
+        }
+    }
 
-    m_SkyboxVertexBuffer = m_Device->CreateBuffer(vertexBufferDesc);
-    m_SkyboxVertexBuffer->CopyData(vertices, sizeof(vertices));
+    // Frames without captures until the last readbacks arrive
+    while (m_Running && progress->pendingReadbacks > 0) {
+        renderFrame();
+    }
+    m_Device->WaitIdle();
+    JobSystem::Wait(progress->writes);
+    m_CaptureReadback.reset();
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    METAGFX_INFO << "Batch render: wrote " << progress->written.load() << " of " << views.size() << " images in "
+                 << seconds << " s (" << renderedFrames << " frames, "
+                 << static_cast<double>(progress->written.load()) / std::max(seconds, 1e-6) << " images/s)";
+    if (!m_Running) {
+        METAGFX_ERROR << "Batch render interrupted";
+        return false;
+    }
+    return progress->failed == 0 && progress->written == views.size();
+}
 
-    // Create index buffer
-    BufferDesc indexBufferDesc{};
-    indexBufferDesc.size = sizeof(indices);
-    indexBufferDesc.usage = BufferUsage::Index;
-    indexBufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+// Select the mesh under a window position: with the GPU picker, in a frame or two
+// (UpdatePick()), else by casting a ray into the scene BVH
+void Application::PickAt(float x, float y) {
+    int width = 0;
+    int height = 0;
+    SDL_GetWindowSize(m_Window, &width, &height);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
 
-    m_SkyboxIndexBuffer = m_Device->CreateBuffer(indexBufferDesc);
-    m_SkyboxIndexBuffer->CopyData(indices, sizeof(indices));
+    // The camera's projection flips Y, so the top of the window is NDC y = -1; depth is
+    // reverse-Z, Camera::NEAR_DEPTH at the near plane and 0 at infinity, so the ray's
+    // second point is halfway there
+    glm::vec2 ndc(2.0f * x / static_cast<float>(width) - 1.0f, 2.0f * y / static_cast<float>(height) - 1.0f);
+    bool compactModel = m_Model && m_Model->GetVertexFormat() == VertexFormat::Compact;
+    if (m_ObjectPicker && m_ObjectPicker->IsValid() && m_Model &&
+        (compactModel ? m_PickPipelines.compact : m_PickPipelines.full)) {
+        m_ObjectPicker->Request(ndc);
+        return;
+    }
 
-    METAGFX_INFO << "Skybox cube created (8 vertices, 36 indices)";
+    glm::mat4 inverseViewProjection = glm::inverse(m_FrameCamera->GetViewProjectionMatrix());
+    glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, Camera::NEAR_DEPTH, 1.0f);
+    glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndc.x, ndc.y, 0.5f, 1.0f);
+    glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+    glm::vec3 direction = glm::vec3(farPoint) / farPoint.w - origin;
+
+    ScenePickResult result;
+    if (m_Scene->Pick(origin, direction, result)) {
+        m_PickedMesh = static_cast<int32>(m_Scene->GetMeshInstance(result.instance).userData);
+        m_PickedPosition = result.position;
+        METAGFX_INFO << "Picked mesh " << m_PickedMesh << " at (" << result.position.x << ", "
+                     << result.position.y << ", " << result.position.z << ")";
+    } else {
+        m_PickedMesh = -1;
+    }
 }
 
-void Application::Run() {
-    METAGFX_INFO << "Starting main loop...";
-    
-    uint64_t lastTime = SDL_GetTicksNS();
-    
-    while (m_Running) {
-        // Calculate delta time
-        uint64_t currentTime = SDL_GetTicksNS();
-        float deltaTime = (currentTime - lastTime) / 1000000000.0f;
-        lastTime = currentTime;
-        
-        ProcessEvents();
-        Update(deltaTime);
-        Render();
+void Application::UpdatePick() {
+    if (!m_ObjectPicker) {
+        return;
+    }
+    m_ObjectPicker->BeginFrame();
+    ObjectPicker::Result result;
+    if (!m_ObjectPicker->TakeResult(result)) {
+        return;
+    }
+    if (result.hit) {
+        m_PickedMesh = static_cast<int32>(result.mesh);
+        m_PickedPosition = result.position;
+        METAGFX_INFO << "Picked mesh " << m_PickedMesh << " at (" << result.position.x << ", "
+                     << result.position.y << ", " << result.position.z << ")";
+    } else {
+        m_PickedMesh = -1;
     }
-
-    METAGFX_INFO << "Main loop ended";
 }
 
-void Application::ProcessEvents() {
+bool Application::ProcessEvents() {
+    METAGFX_PROFILE_FUNCTION();
+    bool polled = false;
+    // The stream client's input joins SDL's queue, handled below like local input
+    if (m_StreamServer) {
+        m_StreamServer->Poll(m_Window);
+    }
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
-        // Let ImGui handle events first
-        ImGui_ImplSDL3_ProcessEvent(&event);
-
+        polled = true;
+        // Quit and camera input are handled here, on the main thread
         switch (event.type) {
             case SDL_EVENT_QUIT:
                 METAGFX_INFO << "Quit event received";
@@ -898,32 +3973,6 @@ void Application::ProcessEvents() {
                     METAGFX_INFO << "Escape key pressed";
                     m_Running = false;
                 }
-                // Model switching shortcuts
-                else if (event.key.key == SDLK_N) {
-                    METAGFX_INFO << "Loading next model...";
-                    LoadNextModel();
-                }
-                else if (event.key.key == SDLK_P) {
-                    METAGFX_INFO << "Loading previous model...";
-                    LoadPreviousModel();
-                }
-                // Direct model selection (1-4)
-                else if (event.key.key == SDLK_1 && m_AvailableModels.size() > 0) {
-                    m_CurrentModelIndex = 0;
-                    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
-                }
-                else if (event.key.key == SDLK_2 && m_AvailableModels.size() > 1) {
-                    m_CurrentModelIndex = 1;
-                    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
-                }
-                else if (event.key.key == SDLK_3 && m_AvailableModels.size() > 2) {
-                    m_CurrentModelIndex = 2;
-                    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
-                }
-                else if (event.key.key == SDLK_4 && m_AvailableModels.size() > 3) {
-                    m_CurrentModelIndex = 3;
-                    LoadModel(m_AvailableModels[m_CurrentModelIndex]);
-                }
                 break;
 
             case SDL_EVENT_MOUSE_BUTTON_DOWN:
@@ -965,491 +4014,1035 @@ void Application::ProcessEvents() {
                 break;
                 
             case SDL_EVENT_WINDOW_RESIZED:
-                METAGFX_INFO << "Window resized: " << event.window.data1 << "x" << event.window.data2;
-                if (m_Device) {
-                    // Destroy old ImGui framebuffers before resizing swap chain
-                    auto vkDevice = std::static_pointer_cast<rhi::VulkanDevice>(m_Device);
-                    auto& context = vkDevice->GetContext();
-                    for (auto framebuffer : m_ImGuiFramebuffers) {
-                        if (framebuffer != VK_NULL_HANDLE) {
-                            vkDestroyFramebuffer(context.device, framebuffer, nullptr);
-                        }
-                    }
-                    m_ImGuiFramebuffers.clear();
-
-                    m_Device->GetSwapChain()->Resize(event.window.data1, event.window.data2);
-                    m_Camera->SetAspectRatio(
-                        static_cast<float>(event.window.data1) /
-                        static_cast<float>(event.window.data2)
-                    );
-
-                    // Recreate depth buffer with new dimensions
-                    m_DepthBuffer.reset();
-                    rhi::TextureDesc depthDesc{};
-                    depthDesc.width = event.window.data1;
-                    depthDesc.height = event.window.data2;
-                    depthDesc.format = rhi::Format::D32_SFLOAT;
-                    depthDesc.usage = rhi::TextureUsage::DepthStencilAttachment;
-                    depthDesc.debugName = "DepthBuffer";
-                    m_DepthBuffer = m_Device->CreateTexture(depthDesc);
-                }
+                m_Camera->SetAspectRatio(
+                    static_cast<float>(event.window.data1) /
+                    static_cast<float>(event.window.data2)
+                );
                 break;
         }
+
+        // The rest reaches render-owned state: in pipelined mode it goes to the render
+        // thread with the frame packet
+        if (!m_Config.pipelinedRendering) {
+            HandleRenderEvent(event);
+            continue;
+        }
+        ForwardedEvent forwarded{ event, {} };
+        if (event.type == SDL_EVENT_TEXT_INPUT && event.text.text) {
+            forwarded.text = event.text.text;
+        } else if (event.type == SDL_EVENT_TEXT_EDITING && event.edit.text) {
+            forwarded.text = event.edit.text;
+        } else if (event.type == SDL_EVENT_DROP_FILE && event.drop.data) {
+            forwarded.text = event.drop.data;
+        }
+        m_ForwardedEvents.push_back(std::move(forwarded));
+    }
+    return polled;
+}
+
+// Loads, compiles, bakes and streaming that Render() advances; an on-demand loop keeps
+// drawing until they are done
+bool Application::HasBackgroundWork() const {
+    return m_StartupEnvironment || m_ModelLoad || m_HasPendingModel || !m_PendingPipelines.empty() || m_ReloadingShaders ||
+           !m_PendingEnvironmentPath.empty() || (m_EnvironmentBaker && m_EnvironmentBaker->IsBaking()) ||
+           (m_TextureStreamer && m_TextureStreamer->GetStats().loadsInFlight > 0) || m_ResizePending ||
+           (m_WorldPartition && m_WorldPartition->GetStats().loadsInFlight > 0) ||
+           (m_PathTracingActive && !m_PathTracer->IsConverged()) ||
+           (m_ObjectPicker && m_ObjectPicker->IsPicking());
+}
+
+// ImGui input, model switching, environment drops, picking and swap chain resizes; runs
+// on the thread that renders
+void Application::HandleRenderEvent(const SDL_Event& event) {
+    // Let ImGui handle events first
+    ImGui_ImplSDL3_ProcessEvent(&event);
+
+    switch (event.type) {
+        case SDL_EVENT_KEY_DOWN:
+            // Model switching shortcuts
+            if (event.key.key == SDLK_N) {
+                METAGFX_INFO << "Loading next model...";
+                LoadNextModel();
+            }
+            else if (event.key.key == SDLK_P) {
+                METAGFX_INFO << "Loading previous model...";
+                LoadPreviousModel();
+            }
+            // Direct model selection (1-4)
+            else if (event.key.key == SDLK_1 && m_AvailableModels.size() > 0) {
+                m_CurrentModelIndex = 0;
+                RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+            }
+            else if (event.key.key == SDLK_2 && m_AvailableModels.size() > 1) {
+                m_CurrentModelIndex = 1;
+                RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+            }
+            else if (event.key.key == SDLK_3 && m_AvailableModels.size() > 2) {
+                m_CurrentModelIndex = 2;
+                RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+            }
+            else if (event.key.key == SDLK_4 && m_AvailableModels.size() > 3) {
+                m_CurrentModelIndex = 3;
+                RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+            }
+            break;
+
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            if (event.button.button == SDL_BUTTON_RIGHT && !ImGui::GetIO().WantCaptureMouse) {
+                PickAt(event.button.x, event.button.y);
+            }
+            break;
+
+        case SDL_EVENT_WINDOW_RESIZED:
+            // Applied at the start of the next frame, so a drag's burst of resize
+            // events costs one swap chain rebuild per frame
+            METAGFX_INFO << "Window resized: " << event.window.data1 << "x" << event.window.data2;
+            m_PendingResizeWidth = static_cast<uint32>(event.window.data1);
+            m_PendingResizeHeight = static_cast<uint32>(event.window.data2);
+            m_ResizePending = true;
+            break;
+
+        case SDL_EVENT_DROP_FILE:
+            if (event.drop.data) {
+                std::string path = event.drop.data;
+                std::string extension = std::filesystem::path(path).extension().string();
+                std::transform(extension.begin(), extension.end(), extension.begin(),
+                               [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                if (extension == ".hdr") {
+                    RequestEnvironmentLoad(path);
+                } else {
+                    METAGFX_WARN << "Ignoring dropped file " << path << ": only .hdr environments can be dropped";
+                }
+            }
+            break;
     }
 }
 
 // In Update():
 void Application::Update(float deltaTime) {
-    // Process keyboard input for camera movement (WASD + QE)
+    METAGFX_PROFILE_FUNCTION();
+    // Process keyboard input for camera movement (WASD + QE), local or the stream client's
     const bool* keyState = SDL_GetKeyboardState(nullptr);
+    auto isKeyDown = [&](SDL_Scancode scancode) {
+        return keyState[scancode] || (m_StreamServer && m_StreamServer->IsKeyDown(scancode));
+    };
 
-    if (keyState[SDL_SCANCODE_W])
+    if (isKeyDown(SDL_SCANCODE_W))
         m_Camera->ProcessKeyboard(SDLK_W, deltaTime);
-    if (keyState[SDL_SCANCODE_S])
+    if (isKeyDown(SDL_SCANCODE_S))
         m_Camera->ProcessKeyboard(SDLK_S, deltaTime);
-    if (keyState[SDL_SCANCODE_A])
+    if (isKeyDown(SDL_SCANCODE_A))
         m_Camera->ProcessKeyboard(SDLK_A, deltaTime);
-    if (keyState[SDL_SCANCODE_D])
+    if (isKeyDown(SDL_SCANCODE_D))
         m_Camera->ProcessKeyboard(SDLK_D, deltaTime);
-    if (keyState[SDL_SCANCODE_Q])
+    if (isKeyDown(SDL_SCANCODE_Q))
         m_Camera->ProcessKeyboard(SDLK_Q, deltaTime);
-    if (keyState[SDL_SCANCODE_E])
+    if (isKeyDown(SDL_SCANCODE_E))
         m_Camera->ProcessKeyboard(SDLK_E, deltaTime);
 }
 
 // In Render():
 void Application::Render() {
+    METAGFX_PROFILE_FUNCTION();
+    METAGFX_ALLOCATION_SCOPE(Render);
     using namespace rhi;
 
     if (!m_Device) return;
 
-    // Process pending model load (deferred from ImGui UI)
-    if (m_HasPendingModel) {
-        m_HasPendingModel = false;
+    // Advance the background model load; swaps the model in once it is resident. The
+    // cells' loads upload from what it leaves of the frame's budget.
+    m_FrameUploads = ModelUploadBudget{};
+    UpdateModelLoad();
+    UpdateWorldCells();
 
-        // Queue old model for deletion after 2 frames
-        if (m_Model) {
-            m_DeletionQueue.push_back({std::move(m_Model), 2});
-        }
+    // Background pipeline compiles that finished replace their fallbacks from this frame on
+    CollectPendingPipelines();
 
-        // Load new model
-        LoadModel(m_PendingModelPath);
-    }
+    CheckMemoryBudget();
 
-    // Process deletion queue
-    for (auto it = m_DeletionQueue.begin(); it != m_DeletionQueue.end(); ) {
-        it->frameCount--;
-        if (it->frameCount == 0) {
-            it = m_DeletionQueue.erase(it);
-        } else {
-            ++it;
-        }
-    }
+    // Shader hot reload: recompiled sources start a rebuild of the pipelines using them
+    UpdateShaderReload();
+
+    // A render mode picked in last frame's overlay, which the renderer itself recorded
+    SetRenderMode(m_Config.renderMode);
+    UpdateMSAA();
 
+    // Swap chain changes retire the old images to the backend instead of waiting for
+    // the GPU; the depth buffer (a render graph texture) follows the swap chain size
     auto swapChain = m_Device->GetSwapChain();
+    if (m_ResizePending) {
+        METAGFX_PROFILE_SCOPE("Swap chain resize");
+        swapChain->Resize(m_PendingResizeWidth, m_PendingResizeHeight);
+        m_ResizePending = false;
+        if (m_HitchDetector) {
+            m_HitchDetector->AddEvent("Swap chain resize");
+        }
+    }
+    if (m_PresentModeChanged) {
+        swapChain->SetPresentMode(m_Config.presentMode);
+        m_PresentModeChanged = false;
+        if (m_HitchDetector) {
+            m_HitchDetector->AddEvent("Present mode change");
+        }
+    }
+    m_Renderer->OnResize(swapChain->GetWidth(), swapChain->GetHeight());
     auto backBuffer = swapChain->GetCurrentBackBuffer();
 
+    // Path traced frames replace the main pass once the model's materials are in the
+    // bindless table and its meshes in a geometry pool, which the tracer reads
+    bool pathTraced = m_Renderer->GetMode() == RenderMode::PathTracing && m_PathTracer && m_BindlessActive &&
+                      m_Model && m_Model->IsValid() && m_Model->GetGeometryPool();
+    m_PathTracingActive = pathTraced;
+
+    // Temporal AA samples another point of each pixel every frame; its history starts
+    // over when it is turned on. A multisampled main pass replaces it. Upscaling, the
+    // jitter is of the drawn region's pixels, over more phases. The path tracer jitters
+    // its own samples and accumulates them at full resolution.
+    bool temporalAA = m_TemporalAA && m_EnableTemporalAA && m_MSAASamples == 1 && !pathTraced;
+    if (temporalAA && !m_TemporalAAActive) {
+        m_TemporalAA->ResetHistory();
+    }
+    m_TemporalAAActive = temporalAA;
+    float upscale = temporalAA ? UPSCALE_MODES[m_UpscaleMode].upscale : 1.0f;
+
+    // Dynamic resolution scales the region drawn by the GPU time of the frames timed so
+    // far; temporal AA upscales the region
+    bool dynamicResolution = temporalAA && m_EnableDynamicResolution && m_GpuProfiler;
+    if (!dynamicResolution) {
+        m_DynamicResolution.Reset();
+    }
+    m_RenderScale = dynamicResolution ? m_DynamicResolution.GetScale() : 1.0f;
+    glm::uvec2 renderSize = TemporalAA::GetInputSize(swapChain->GetWidth(), swapChain->GetHeight(), upscale);
+    glm::uvec2 regionSize = DynamicResolution::ScaleSize(renderSize.x, renderSize.y, m_RenderScale);
+    m_FrameCamera->SetJitter(temporalAA ? TemporalAA::GetJitter(m_TemporalAAFrame++, regionSize.x, regionSize.y,
+                                                                TemporalAA::GetJitterPhases(upscale / m_RenderScale))
+                                        : glm::vec2(0.0f));
+
     // Update uniform buffer
     UniformBufferObject ubo{};
     // Model matrix: identity (no transformation)
     glm::mat4 modelMatrix = glm::mat4(1.0f);
     ubo.model = modelMatrix;
-    ubo.view = m_Camera->GetViewMatrix();
-    ubo.projection = m_Camera->GetProjectionMatrix();
+    ubo.view = m_FrameCamera->GetViewMatrix();
+    ubo.projection = m_FrameCamera->GetProjectionMatrix();
+    ubo.cameraPosition = glm::vec4(m_FrameCamera->GetPosition(), 1.0f);
+    ubo.exposure = m_Exposure;
+    ubo.enableIBL = m_EnableIBL ? 1u : 0u;
+    ubo.iblIntensity = m_IBLIntensity;
+    ubo.shadowDebugMode = static_cast<uint32>(m_ShadowDebugMode);
+    ubo.enableShadows = m_EnableShadows ? 1u : 0u;
+    ubo.shadowFilter = static_cast<uint32>(m_ShadowFilter);
+
+    METAGFX_DEBUG_ONCE << "Shadow debug mode in frame constants: " << ubo.shadowDebugMode
+                       << ", shadows enabled: " << ubo.enableShadows;
 
     // Metal uses OpenGL clip space convention (Y-up), while Vulkan requires Y-flip.
     // The Camera flips Y for Vulkan, so we undo it for Metal.
     if (m_Device->GetDeviceInfo().api == rhi::GraphicsAPI::Metal) {
         ubo.projection[1][1] *= -1.0f;
     }
+    ubo.viewProjection = ubo.projection * ubo.view;
+    ubo.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(ubo.model))));
+    ubo.inverseSkyViewProjection = glm::inverse(ubo.projection * glm::mat4(glm::mat3(ubo.view)));
+
+    // Claim this frame's slot. BeginFrame() returns once the GPU is done with the slot's
+    // previous frame, so its ring slices and descriptor set copies can be rewritten.
+    rhi::FrameContext frame;
+    {
+        METAGFX_PROFILE_SCOPE("Begin frame");
+        frame = m_Device->BeginFrame();
+    }
+    m_CurrentFrame = frame.frameIndex;
+    auto cmd = frame.commandBuffer;
 
-    // FIXME: Descriptor sets all point to buffer[0], so always update buffer[0]
-    // TODO: Properly configure double buffering in descriptor sets
-    m_UniformBuffers[0]->CopyData(&ubo, sizeof(ubo));
-
-    // Update light buffer before rendering
-    m_Scene->UpdateLightBuffer();
-
-    // Create command buffer
-    auto cmd = m_Device->CreateCommandBuffer();
-
-    cmd->Begin();
-
-    // Advanced features now working on Metal - all features enabled
-    bool debugDisableAdvancedFeatures = false;  // All features enabled: shadows, ground plane, skybox
-
-    // Add buffer memory barrier to ensure light buffer writes are visible to GPU
-    auto lightBuffer = m_Scene->GetLightBuffer();
-    if (lightBuffer && !debugDisableAdvancedFeatures) {
-        cmd->BufferMemoryBarrier(lightBuffer);
+    m_UniformRing->BeginFrame(m_CurrentFrame);
+    m_InstanceBuffer->BeginFrame(m_CurrentFrame);
+    if (m_CaptureReadback) {
+        m_CaptureReadback->BeginFrame();
+    }
+    if (m_StreamEncoder) {
+        // H.264 for a client that decodes it, from a key frame whenever the server lost one
+        bool h264 = !m_Config.stream.rawNV12 && m_StreamServer->ClientDecodes(stream::PixelFormat::H264);
+        m_StreamEncoder->SetFormat(h264 ? stream::PixelFormat::H264 : stream::PixelFormat::NV12);
+        if (m_StreamServer->TakeKeyFrameRequest()) {
+            m_StreamEncoder->RequestKeyFrame();
+        }
+        m_StreamEncoder->BeginFrame();  // Hands the frames read back to the encoder or the server
+    }
+    UpdatePick();
+    UpdateStartupEnvironment();
+    UpdateEnvironmentBake();
+
+    // Aim the shadow-casting light from the UI; an unchanged direction keeps it clean
+    DirectionalLight* shadowLight = m_Scene->GetDirectionalLight(m_KeyLight);
+    if (shadowLight && shadowLight->GetDirection() != glm::normalize(m_LightDirection)) {
+        shadowLight->SetDirection(m_LightDirection);
     }
 
-    // =============================================================================
-    // Shadow Pass: Render scene from light's perspective to shadow map
-    // =============================================================================
+    // Upload the changed lights and bin the local ones for the frame camera; the slot's
+    // previous light and cluster regions are free once BeginFrame() returned
+    m_Scene->UpdateLightBuffer(m_CurrentFrame);
+    ubo.lightBase = m_Scene->GetLightBufferBase(m_CurrentFrame);
+    ubo.directionalLightCount = m_Scene->GetDirectionalLightCount();
+    {
+        METAGFX_PROFILE_SCOPE("Light clusters");
+        LightClusterParams clusters = m_LightClusters->Build(
+            m_CurrentFrame, m_Scene->GetGPULights(), m_Scene->GetDirectionalLightCount(), *m_FrameCamera,
+            regionSize.x, regionSize.y);
+        ubo.clusterBase = clusters.base;
+        ubo.clusterTileScale = clusters.tileScale;
+        ubo.clusterDepthScaleBias = clusters.depthScaleBias;
+    }
 
-    // Debug: Log shadow pass conditions
-    static bool loggedConditions = false;
-    if (!loggedConditions) {
-        METAGFX_INFO << "Shadow pass conditions: EnableShadows=" << m_EnableShadows
-                     << ", ShadowMap=" << (m_ShadowMap ? "valid" : "null")
-                     << ", Model=" << (m_Model ? "valid" : "null")
-                     << ", ModelIsValid=" << (m_Model && m_Model->IsValid() ? "true" : "false");
-        if (debugDisableAdvancedFeatures) {
-            METAGFX_INFO << "DEBUG: Advanced features DISABLED for Metal debugging";
+    // Ray-traced shadows replace both shadow maps in forward frames once the traced
+    // pipelines have compiled (the full-float one also draws the ground plane). Switching
+    // drops what the maps hold: they are not drawn while traced, and the atlas starts its
+    // lights over.
+    bool compactModel = m_Model && m_Model->GetVertexFormat() == VertexFormat::Compact;
+    const Ref<rhi::Pipeline>& gbufferPipeline = compactModel ? m_CompactGBufferPipeline : m_GBufferPipeline;
+    bool deferred = (m_Renderer->GetMode() == RenderMode::Deferred || m_Renderer->GetMode() == RenderMode::VisibilityBuffer) &&
+                    m_DeferredLighting && gbufferPipeline;
+    const Ref<rhi::Pipeline>& rayTracedPipeline =
+        compactModel ? m_RayTracedCompactModelPipeline : m_RayTracedModelPipeline;
+    bool rayTracedShadows = m_RayTracingScene && m_EnableRayTracedShadows && m_EnableShadows && rayTracedPipeline &&
+                            m_RayTracedModelPipeline && !deferred && !pathTraced && m_Model && m_Model->IsValid();
+    if (rayTracedShadows != m_RayTracedShadowsActive) {
+        if (m_ShadowMap) {
+            m_ShadowMap->InvalidateCache();
+        }
+        if (m_ShadowAtlas) {
+            m_ShadowAtlas->Clear();
         }
-        loggedConditions = true;
+        m_RayTracedShadowsActive = rayTracedShadows;
     }
 
-    if (!debugDisableAdvancedFeatures && m_EnableShadows && m_ShadowMap && m_Model && m_Model->IsValid()) {
-        // Debug: Log shadow pass execution
-        static bool loggedShadowPass = false;
-        if (!loggedShadowPass) {
-            METAGFX_INFO << "Executing shadow pass - rendering " << m_Model->GetMeshes().size() << " meshes";
-            loggedShadowPass = true;
+    // Size the point and spot light shadows for the frame camera and queue their stale
+    // faces; the map of this frame's region follows the light array just uploaded. Traced
+    // frames keep the atlas's choice of shadowed lights but do not render its faces.
+    bool shadowAtlasActive = m_EnableShadowAtlas && m_EnableShadows && m_ShadowAtlas && !pathTraced && m_Model &&
+                             m_Model->IsValid();
+    if (m_ShadowAtlas) {
+        if (shadowAtlasActive) {
+            m_ShadowAtlas->Update(*m_Scene, *m_FrameCamera, swapChain->GetHeight());
+        } else {
+            m_ShadowAtlas->Clear();
         }
+        ubo.shadowAtlasBase = m_ShadowAtlas->Upload(m_CurrentFrame, *m_Scene);
+    }
 
-        // Get the first directional light for shadow casting
-        DirectionalLight* shadowLight = nullptr;
-        for (const auto& light : m_Scene->GetLights()) {
-            if (auto* dirLight = dynamic_cast<DirectionalLight*>(light.get())) {
-                shadowLight = dirLight;
-                break;
-            }
-        }
+    uint32 mvpOffset = m_UniformRing->Push(ubo);
+
+    // Compact models carry their dequantization in the model matrix; everything else
+    // (ground plane, skybox) keeps the plain one
+    uint32 modelMvpOffset = mvpOffset;
+    if (compactModel) {
+        UniformBufferObject modelUbo = ubo;
+        modelUbo.model = modelMatrix * m_Model->GetDequantizeMatrix();
+        modelUbo.normalMatrix = glm::mat4(glm::transpose(glm::inverse(glm::mat3(modelUbo.model))));
+        modelUbo.vertexFormat = static_cast<uint32>(VertexFormat::Compact);
+        modelMvpOffset = m_UniformRing->Push(modelUbo);
+    }
 
-        if (shadowLight) {
-            // Update the light direction from UI control
-            shadowLight->SetDirection(m_LightDirection);
-
-            // Update shadow map light matrix
-            m_ShadowMap->UpdateLightMatrix(shadowLight->GetDirection(), *m_Camera);
-
-            // Update shadow uniform buffer
-            struct ShadowUBO {
-                glm::mat4 lightSpaceMatrix;
-                glm::mat4 model;  // Model matrix (identity for now)
-                float shadowBias;
-                float padding[3];
-            };
-            ShadowUBO shadowUBO{};
-            shadowUBO.lightSpaceMatrix = m_ShadowMap->GetLightSpaceMatrix();
-            shadowUBO.model = glm::mat4(1.0f);  // Identity matrix
-            shadowUBO.shadowBias = m_ShadowBias;
-
-            // Debug: Log light space matrix (ALL rows)
-            static bool loggedMatrix = false;
-            if (!loggedMatrix) {
-                const auto& m = shadowUBO.lightSpaceMatrix;
-                METAGFX_INFO << "LightSpaceMatrix row 0: (" << m[0][0] << ", " << m[1][0] << ", " << m[2][0] << ", " << m[3][0] << ")";
-                METAGFX_INFO << "LightSpaceMatrix row 1: (" << m[0][1] << ", " << m[1][1] << ", " << m[2][1] << ", " << m[3][1] << ")";
-                METAGFX_INFO << "LightSpaceMatrix row 2: (" << m[0][2] << ", " << m[1][2] << ", " << m[2][2] << ", " << m[3][2] << ")";
-                METAGFX_INFO << "LightSpaceMatrix row 3: (" << m[0][3] << ", " << m[1][3] << ", " << m[2][3] << ", " << m[3][3] << ")";
-                loggedMatrix = true;
-            }
-
-            m_ShadowUniformBuffer->CopyData(&shadowUBO, sizeof(shadowUBO));
-
-            // Begin shadow rendering pass (depth-only)
-            // Note: BeginRendering will handle layout transitions via the render pass
-            ClearValue shadowDepthClear{};
-            shadowDepthClear.depthStencil.depth = 1.0f;  // Standard: far plane
-            shadowDepthClear.depthStencil.stencil = 0;
-
-            cmd->BeginRendering({}, m_ShadowMap->GetDepthTexture(), { shadowDepthClear });
-
-            // Set viewport and scissor for shadow map
-            Viewport shadowViewport{};
-            shadowViewport.width = static_cast<float>(m_ShadowMap->GetWidth());
-            shadowViewport.height = static_cast<float>(m_ShadowMap->GetHeight());
-            shadowViewport.minDepth = 0.0f;
-            shadowViewport.maxDepth = 1.0f;
-            cmd->SetViewport(shadowViewport);
-
-            Rect2D shadowScissor{};
-            shadowScissor.width = m_ShadowMap->GetWidth();
-            shadowScissor.height = m_ShadowMap->GetHeight();
-            cmd->SetScissor(shadowScissor);
-
-            // Bind shadow pipeline
-            cmd->BindPipeline(m_ShadowPipeline);
-
-            // Bind shadow descriptor set
-            cmd->BindDescriptorSet(m_ShadowPipeline, m_ShadowDescriptorSet, 0);
-
-            // Render all meshes from light's perspective
-            uint32 meshesRendered = 0;
-            for (const auto& mesh : m_Model->GetMeshes()) {
-                if (mesh && mesh->IsValid()) {
-                    // Draw mesh (model matrix is in the uniform buffer)
-                    cmd->BindVertexBuffer(mesh->GetVertexBuffer());
-                    cmd->BindIndexBuffer(mesh->GetIndexBuffer());
-                    cmd->DrawIndexed(mesh->GetIndexCount());
-                    meshesRendered++;
-
-                    // Debug: Log draw call details
-                    static bool loggedDrawCall = false;
-                    if (!loggedDrawCall) {
-                        METAGFX_INFO << "Shadow pass draw call: " << mesh->GetIndexCount()
-                                     << " indices, vertex buffer valid: " << (mesh->GetVertexBuffer() ? "yes" : "no")
-                                     << ", index buffer valid: " << (mesh->GetIndexBuffer() ? "yes" : "no");
-                        loggedDrawCall = true;
-                    }
-                }
+    cmd->Begin();
+    if (m_GpuProfiler) {
+        m_GpuProfiler->BeginFrame(*cmd, m_CurrentFrame);
+
+        const rhi::GpuProfiler::FrameTimings& timings = m_GpuProfiler->GetLatestFrame();
+        if (timings.frameNumber != m_GpuTimedFrame) {
+            if (dynamicResolution) {
+                m_DynamicResolution.Update(static_cast<float>(timings.gpuTimeMs));
             }
 
-            // NOTE: Do NOT render ground plane in shadow pass!
-            // The ground plane should RECEIVE shadows, not CAST them.
-            // Rendering it here would write its depth to the shadow map and interfere
-            // with shadow calculations.
-
-            // Debug: Log model info once per model load (using frame counter to rate-limit)
-            static int lastLoggedFrame = -100;
-            static int frameCounter = 0;
-            frameCounter++;
-
-            if (frameCounter - lastLoggedFrame > 60) {  // Log every 60 frames (once per second at 60fps)
-                METAGFX_INFO << "Shadow pass rendered " << meshesRendered << " meshes";
-
-                // Log model bounding box to verify it's within shadow frustum
-                glm::vec3 minBounds, maxBounds;
-                if (m_Model->GetBoundingBox(minBounds, maxBounds)) {
-                    METAGFX_INFO << "Model bounds: min(" << minBounds.x << ", " << minBounds.y
-                                 << ", " << minBounds.z << "), max(" << maxBounds.x << ", "
-                                 << maxBounds.y << ", " << maxBounds.z << ")";
-                    glm::vec3 center = (minBounds + maxBounds) * 0.5f;
-                    glm::vec3 size = maxBounds - minBounds;
-                    METAGFX_INFO << "Model center: (" << center.x << ", " << center.y << ", "
-                                 << center.z << "), size: (" << size.x << ", " << size.y
-                                 << ", " << size.z << ")";
+            double mainPassMs = 0.0;
+            double momentsMs = 0.0;
+            for (const rhi::GpuProfiler::Zone& zone : timings.zones) {
+                if (zone.name == "Main pass" || zone.name == "G-buffer pass" || zone.name == "Deferred lighting") {
+                    mainPassMs += zone.durationMs;
+                } else if (zone.name == "Shadow moments") {
+                    momentsMs += zone.durationMs;
                 }
-
-                lastLoggedFrame = frameCounter;
             }
 
-            cmd->EndRendering();
+            // Cost of the shadow filter: the newest timed frame's main pass and moment
+            // build, credited to the current filter. A switch shows frames late; the
+            // smoothing absorbs it.
+            if (m_EnableShadows && !m_RayTracedShadowsActive) {
+                float filterMs = static_cast<float>(mainPassMs + momentsMs);
+                float& cost = m_ShadowFilterGpuMs[static_cast<uint32>(m_ShadowFilter)];
+                cost = cost > 0.0f ? cost * 0.95f + filterMs * 0.05f : filterMs;
+            }
 
-            // Add pipeline barrier to ensure shadow map writes complete before sampling
-#ifdef METAGFX_USE_VULKAN
-            // Only execute Vulkan barrier if Vulkan is the active backend
-            if (m_Device->GetDeviceInfo().api == GraphicsAPI::Vulkan) {
-                auto vkCmd = std::static_pointer_cast<VulkanCommandBuffer>(cmd);
-                auto vkShadowTexture = std::static_pointer_cast<VulkanTexture>(m_ShadowMap->GetDepthTexture());
-                VkImageMemoryBarrier shadowBarrier{};
-                shadowBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-                shadowBarrier.oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-                shadowBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                shadowBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                shadowBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-                shadowBarrier.image = vkShadowTexture->GetImage();
-                shadowBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
-                shadowBarrier.subresourceRange.baseMipLevel = 0;
-                shadowBarrier.subresourceRange.levelCount = 1;
-                shadowBarrier.subresourceRange.baseArrayLayer = 0;
-                shadowBarrier.subresourceRange.layerCount = 1;
-                shadowBarrier.srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-                shadowBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-                vkCmdPipelineBarrier(vkCmd->GetHandle(),
-                                    VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
-                                    VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                                    0, 0, nullptr, 0, nullptr, 1, &shadowBarrier);
+            // Cost of the main pass in the depth prepass probe's current half
+            uint32 probeFrame = m_DepthPrepassProbeFrame;
+            if (probeFrame < 2 * DEPTH_PREPASS_PROBE_FRAMES &&
+                probeFrame % DEPTH_PREPASS_PROBE_FRAMES >= DEPTH_PREPASS_SETTLE_FRAMES) {
+                uint32 half = probeFrame / DEPTH_PREPASS_PROBE_FRAMES;
+                m_DepthPrepassGpuMs[half] += mainPassMs;
+                ++m_DepthPrepassSamples[half];
             }
-#endif
-            // Note: Metal handles image layout transitions automatically
+        }
+        m_GpuTimedFrame = timings.frameNumber;
+    }
+
+    // Auto probes while the profiler times frames, then keeps the cheaper main pass
+    bool depthPrepass = m_DepthPrepassMode == DepthPrepassMode::On;
+    if (m_DepthPrepassMode == DepthPrepassMode::Auto && m_GpuProfiler) {
+        if (m_DepthPrepassProbeFrame < 2 * DEPTH_PREPASS_PROBE_FRAMES) {
+            depthPrepass = m_DepthPrepassProbeFrame >= DEPTH_PREPASS_PROBE_FRAMES;
+            ++m_DepthPrepassProbeFrame;
+        } else if (m_DepthPrepassSamples[0] > 0 && m_DepthPrepassSamples[1] > 0) {
+            depthPrepass = m_DepthPrepassGpuMs[1] / m_DepthPrepassSamples[1] <
+                           m_DepthPrepassGpuMs[0] / m_DepthPrepassSamples[0];
+        }
+    }
+    cmd->BeginZone("Frame");
+
+    // The model's clip poses the nodes it drives, in every grid copy
+    if (m_Animator) {
+        float animationTime = m_LastRenderTicks ? (SDL_GetTicksNS() - m_LastRenderTicks) / 1000000000.0f : 0.0f;
+        Animator* animators[] = { m_Animator.get() };
+        Animator::UpdateAll(animators, animationTime);
+        if (!m_Animator->IsPaused()) {
+            ApplyAnimatedNodes(false);
         }
     }
 
-    // =============================================================================
-    // Main Pass: Render scene with shadow sampling
-    // =============================================================================
+    // Propagate node changes, refit their instances and copy the changed matrices. Node
+    // matrices are stored in the dequantization basis so they compose with the compact
+    // model matrix; identity nodes (the ground plane) are unaffected.
+    if (m_Scene->UpdateTransforms()) {
+        if (m_ShadowMap) {
+            m_ShadowMap->InvalidateCache();
+        }
+        if (m_ShadowAtlas) {
+            m_ShadowAtlas->Invalidate();
+        }
+        if (m_PathTracer) {
+            m_PathTracer->Reset();
+        }
+        if (m_Denoiser) {
+            m_Denoiser->ResetHistory();
+        }
+    }
+    m_TransformBuffer->Upload(*cmd, m_CurrentFrame, m_Scene->GetSceneGraph(),
+                              compactModel ? m_Model->GetDequantizeMatrix() : glm::mat4(1.0f));
+    if (m_EnvironmentBaker) {
+        m_EnvironmentBaker->Record(*cmd, m_CurrentFrame);
+    }
 
-    // Begin rendering
-    ClearValue colorClear{};
-    colorClear.color[0] = 0.1f;
-    colorClear.color[1] = 0.1f;
-    colorClear.color[2] = 0.15f;
-    colorClear.color[3] = 1.0f;
+    // Pose the deformed meshes over the pool once, before any pass of the frame draws it
+    if (m_Skinning && m_Animator && m_Skinning->HasWork()) {
+        m_Skinning->Apply(*cmd, m_CurrentFrame, *m_Animator);
+        // Morph targets move geometry without moving a node
+        if (m_Animator->GetClip() != Animator::NO_CLIP && !m_Animator->IsPaused()) {
+            if (m_ShadowMap) {
+                m_ShadowMap->InvalidateCache();
+            }
+            if (m_ShadowAtlas) {
+                m_ShadowAtlas->Invalidate();
+            }
+        }
+    }
 
-    ClearValue depthClear{};
-    depthClear.depthStencil.depth = 1.0f;
-    depthClear.depthStencil.stencil = 0;
+    // Refit the shadow cascades before anything reads them: the culling pass tests
+    // shadow casters against them. The main pass picks from the cascades in the shadow
+    // uniforms.
+    if (shadowLight && m_ShadowMap) {
+        m_ShadowMap->UpdateCascades(shadowLight->GetDirection(), *m_FrameCamera);
+
+        uint32 cascadeCount = m_ShadowMap->GetCascadeCount();
+        ShadowUniforms shadowUniforms{};
+        for (uint32 cascade = 0; cascade < ShadowMap::MAX_CASCADES; ++cascade) {
+            shadowUniforms.cascadeMatrices[cascade] = m_ShadowMap->GetCascadeMatrix(cascade);
+            shadowUniforms.cascadeRects[cascade] = m_ShadowMap->GetCascadeRect(cascade);
+            shadowUniforms.cascadeSplits[cascade] = m_ShadowMap->GetCascadeSplit(cascade);
+        }
+        for (uint32 cascade = 0; cascade < ShadowMap::MAX_CASCADES; ++cascade) {
+            shadowUniforms.cascadePenumbraScales[cascade] =
+                m_ShadowMap->GetCascadePenumbraScale(cascade, glm::radians(m_ShadowLightRadius));
+        }
+        shadowUniforms.shadowBias = m_ShadowBias;
+        shadowUniforms.cascadeCount = cascadeCount;
+        shadowUniforms.filterRadius = m_ShadowFilterRadius;
+        shadowUniforms.evsmBleedReduction = m_EVSMBleedReduction;
+        shadowUniforms.lightAngularRadius = glm::radians(m_ShadowLightRadius);
+        shadowUniforms.lightSourceRadius = m_RayTracedLightRadius;
+        shadowUniforms.noiseFrame = static_cast<uint32>(m_TemporalAAFrame);
+        m_ShadowUniformBuffer->CopyData(&shadowUniforms, sizeof(shadowUniforms));
+    }
 
-    // Re-enabled depth buffer for Metal testing (Step 2)
-    cmd->BeginRendering({ backBuffer }, m_DepthBuffer, { colorClear, depthClear });
-    
-    // Set viewport and scissor
-    Viewport viewport{};
-    viewport.width = static_cast<float>(swapChain->GetWidth());
-    viewport.height = static_cast<float>(swapChain->GetHeight());
-    viewport.minDepth = 0.0f;
-    viewport.maxDepth = 1.0f;
-    cmd->SetViewport(viewport);
-    
-    Rect2D scissor{};
-    scissor.width = swapChain->GetWidth();
-    scissor.height = swapChain->GetHeight();
-    cmd->SetScissor(scissor);
+    // Streamed mips replace the smaller textures in the model's materials
+    if (m_Model && m_TextureStreamer->Update(*m_Scene, modelMatrix, ubo.projection * ubo.view, ubo.projection,
+                                             m_FrameCamera->GetPosition(), static_cast<float>(regionSize.y))) {
+        RefreshMaterialBindings();
+    }
+    PrepareCellDraws(ubo.projection * ubo.view);
+
+    // Model pipeline: the bindless variant when the model's materials fit the table.
+    // Bindless variants compile in the background; until then the per-material one draws.
+    const Ref<rhi::Pipeline>& bindlessPipeline = compactModel ? m_BindlessCompactModelPipeline : m_BindlessModelPipeline;
+    m_ModelPass = ModelPass{};
+    m_ModelPass.bindless = m_BindlessActive && bindlessPipeline;
+    m_ModelPass.pipeline = m_ModelPass.bindless ? bindlessPipeline : (compactModel ? m_CompactModelPipeline : m_ModelPipeline);
+    m_ModelPass.variant = m_ModelPass.bindless ? (compactModel ? ModelVariantBindlessCompact : ModelVariantBindless)
+                                               : (compactModel ? ModelVariantCompact : ModelVariantFloat);
+    m_ModelPass.permutations = m_EnableShaderPermutations && m_ShadowDebugMode == 0;
+    // Vertex pulling replaces the bindless variant of either layout for a pooled model
+    if (m_ModelPass.bindless && m_Config.vertexPulling && m_PulledModelPipeline && m_Model &&
+        m_Model->GetGeometryPool()) {
+        m_ModelPass.pipeline = m_PulledModelPipeline;
+        m_ModelPass.variant = ModelVariantPulled;
+    }
 
-    // DEBUG: Model rendering test (Step 3)
-    static bool loggedModelTest = false;
-    if (debugDisableAdvancedFeatures && !loggedModelTest) {
-        METAGFX_INFO << "DEBUG: Testing model rendering (shadows/skybox/ground still disabled)";
-        loggedModelTest = true;
+    // Deferred frames draw the model's materials into the G-buffer once its pipeline is
+    // ready, with per-material sets: the G-buffer stage has no bindless or permutation variant
+    if (deferred) {
+        m_ModelPass.pipeline = gbufferPipeline;
+        m_ModelPass.variant = compactModel ? ModelVariantCompact : ModelVariantFloat;
+        m_ModelPass.bindless = false;
+        m_ModelPass.permutations = false;
+        if (m_MaterialDescriptorSets.empty()) {
+            CreateMaterialDescriptorSets();
+        }
     }
 
-    // Draw the model FIRST - now enabled for Metal testing
-    if (m_Model && m_Model->IsValid()) {
-        // Bind model pipeline
-        cmd->BindPipeline(m_ModelPipeline);
+    // Ray-traced shadows: the scene's acceleration structures are built ahead of the
+    // main pass, which then draws with model_raytraced.frag and per-material sets. A
+    // scene without instances has no top level, and nothing to cast shadows.
+    if (rayTracedShadows) {
+        m_RayTracingScene->Update(*cmd, *m_Scene, modelMatrix);
+        BindSceneTopLevel(m_RayTracingScene->GetTopLevel());
+        if (m_RayTracingScene->GetTopLevel()) {
+            m_ModelPass.pipeline = rayTracedPipeline;
+            m_ModelPass.variant = compactModel ? ModelVariantRayTracedCompact : ModelVariantRayTraced;
+            m_ModelPass.bindless = false;
+            if (m_MaterialDescriptorSets.empty()) {
+                CreateMaterialDescriptorSets();
+            }
+        }
+    }
+    // Path tracing: the same acceleration structures, traced by the tracer's compute pass
+    // in place of the main pass's draws
+    if (pathTraced) {
+        m_RayTracingScene->Update(*cmd, *m_Scene, modelMatrix);
+        BindSceneTopLevel(m_RayTracingScene->GetTopLevel());
+        m_PathTracer->SetTopLevel(m_RayTracingScene->GetTopLevel());
+        m_PathTracer->SetSettings(m_PathTraceSettings);
+    }
+    // Light probes: traced against the same top level ahead of the lit passes. Off, or
+    // without a pooled model to trace, the volume still clears its header once.
+    bool lightProbes = m_LightProbes && !pathTraced;
+    if (lightProbes) {
+        m_LightProbes->SetEnabled(m_EnableLightProbes && m_BindlessActive && m_Model && m_Model->GetGeometryPool());
+        LightProbeVolume::Settings probeSettings = m_LightProbes->GetSettings();
+        probeSettings.probesPerFrame = static_cast<uint32>(m_LightProbesPerFrame);
+        m_LightProbes->SetSettings(probeSettings);
+        if (m_LightProbes->IsEnabled()) {
+            if (!rayTracedShadows) {
+                m_RayTracingScene->Update(*cmd, *m_Scene, modelMatrix);
+                BindSceneTopLevel(m_RayTracingScene->GetTopLevel());
+            }
+            m_LightProbes->SetTopLevel(m_RayTracingScene->GetTopLevel());
+        }
+    }
+    m_ModelPass.mvpOffset = modelMvpOffset;
+    m_ModelPass.sceneryMvpOffset = mvpOffset;
+    m_ModelPass.modelMatrix = modelMatrix;
+
+    // The renderer records the frame's passes into cmd through its render graph; the
+    // main pass's materials, scenery and ImGui come back through RasterizationContent
+    RasterizationRenderer::FrameInputs inputs;
+    inputs.commandBuffer = cmd;
+    inputs.backBuffer = backBuffer;
+    inputs.frameIndex = m_CurrentFrame;
+    inputs.modelMatrix = modelMatrix;
+    inputs.content = this;
+    inputs.uniformRing = m_UniformRing.get();
+    inputs.instanceBuffer = m_InstanceBuffer.get();
+    inputs.shadowMap = m_ShadowMap.get();
+    inputs.shadowAtlas = m_ShadowAtlas.get();
+    inputs.shadowMoments = m_ShadowMoments.get();
+    inputs.gpuCuller = m_GPUCuller.get();
+    if (m_EnableLods) {
+        LodSelector::Settings lodSettings = m_LodSelector.GetSettings();
+        lodSettings.pixelThreshold = m_LodPixelThreshold;
+        m_LodSelector.SetSettings(lodSettings);
+        inputs.lodSelector = &m_LodSelector;
+    }
+    inputs.deferredLighting = deferred ? m_DeferredLighting.get() : nullptr;
+    // The visibility buffer resolves the GPU-culled model into the same G-buffer; without
+    // its pipeline, the bindless table or the culled draws the G-buffer pass draws instead
+    const Ref<rhi::Pipeline>& visibilityPipeline = compactModel ? m_CompactVisibilityPipeline : m_VisibilityPipeline;
+    m_VisibilityBufferActive = deferred && m_Renderer->GetMode() == RenderMode::VisibilityBuffer && m_VisibilityBuffer &&
+                               m_BindlessActive && visibilityPipeline && m_EnableGPUCulling && m_GPUCuller->HasModel() &&
+                               IsSingleCopy();
+    if (m_VisibilityBufferActive) {
+        inputs.visibilityBuffer = m_VisibilityBuffer.get();
+        inputs.modelUniformOffset = modelMvpOffset;
+    }
+    if (lightProbes) {
+        inputs.lightProbes = m_LightProbes.get();
+        inputs.lightProbeView.environment = m_EnableIBL;
+        inputs.lightProbeView.environmentIntensity = m_IBLIntensity;
+    }
+    // Like temporal AA's, the occlusion's history starts over when it is turned on
+    bool ambientOcclusion = deferred && m_AmbientOcclusion && m_EnableAmbientOcclusion;
+    if (ambientOcclusion && !m_AmbientOcclusionActive) {
+        m_AmbientOcclusion->ResetHistory();
+    }
+    m_AmbientOcclusionActive = ambientOcclusion;
+    if (ambientOcclusion) {
+        AmbientOcclusion::Settings aoSettings = m_AmbientOcclusion->GetSettings();
+        aoSettings.radius = m_AmbientOcclusionRadius;
+        m_AmbientOcclusion->SetSettings(aoSettings);
+        inputs.ambientOcclusion = m_AmbientOcclusion.get();
+    }
+    bool reflections = deferred && m_Reflections && m_EnableReflections;
+    if (reflections && !m_ReflectionsActive) {
+        m_Reflections->ResetHistory();
+    }
+    m_ReflectionsActive = reflections;
+    if (reflections) {
+        inputs.reflections = m_Reflections.get();
+    }
+    if (m_ShadingRate && m_EnableShadingRate && m_Renderer->SupportsFeature(RenderFeature::VariableRateShading)) {
+        inputs.shadingRate = m_ShadingRate.get();
+    }
+    if (pathTraced) {
+        inputs.pathTracer = m_PathTracer.get();
+        inputs.pathTraceView.viewProjection = ubo.viewProjection;
+        inputs.pathTraceView.environment = m_EnableIBL;
+        inputs.pathTraceView.environmentIntensity = m_IBLIntensity;
+        if (m_Denoiser && m_EnableDenoiser) {
+            Denoiser::Settings denoiseSettings = m_Denoiser->GetSettings();
+            denoiseSettings.iterations = static_cast<uint32>(m_DenoiseIterations);
+            m_Denoiser->SetSettings(denoiseSettings);
+            inputs.denoiser = m_Denoiser.get();
+        }
+    }
+    inputs.frameUniformOffset = mvpOffset;
+    inputs.toneMapper = m_ToneMapper.get();
+    inputs.toneMapping.exposure = m_Exposure;
+    inputs.toneMapping.toneMapOperator = m_ToneMapOperator;
+    if (m_AutoExposure && m_EnableAutoExposure) {
+        AutoExposure::Settings exposureSettings = m_AutoExposure->GetSettings();
+        exposureSettings.adaptationRate = m_ExposureAdaptationRate;
+        m_AutoExposure->SetSettings(exposureSettings);
+        inputs.autoExposure = m_AutoExposure.get();
+    }
+    if (m_Bloom && m_EnableBloom) {
+        m_Bloom->SetSettings({ m_BloomStrength });
+        inputs.bloom = m_Bloom.get();
+    }
+    if (temporalAA) {
+        TemporalAA::Settings taaSettings = m_TemporalAA->GetSettings();
+        taaSettings.sharpness = m_TemporalAASharpness;
+        // On demand, still frames continue the history as a running average, from the
+        // samples the default weight amounts to, so the image keeps converging instead
+        // of settling at the moving frames' blend
+        float movingWeight = TemporalAA::Settings{}.currentWeight;
+        taaSettings.currentWeight = m_Config.onDemandRendering
+                                        ? 1.0f / (1.0f / movingWeight + static_cast<float>(m_StillFrames))
+                                        : movingWeight;
+        m_TemporalAA->SetSettings(taaSettings);
+        inputs.temporalAA = m_TemporalAA.get();
+        inputs.upscale = upscale;
+        inputs.renderScale = m_RenderScale;
+    }
+    // Render() runs on the render thread when pipelined, so it keeps its own clock for
+    // the adaptation; the first frame starts from an exposure of 1
+    uint64 renderTicks = SDL_GetTicksNS();
+    inputs.deltaTime = m_LastRenderTicks ? (renderTicks - m_LastRenderTicks) / 1000000000.0f : 0.0f;
+    m_LastRenderTicks = renderTicks;
+    inputs.shadowPipelines = { m_ShadowPipeline, m_CompactShadowPipeline, m_ShadowPositionPipeline,
+                               m_CompactShadowPositionPipeline, m_Config.vertexPulling ? m_PulledShadowPipeline : nullptr };
+    inputs.shadowDescriptorSet = m_ShadowDescriptorSet;
+    inputs.shadowClearPipeline = m_ShadowClearPipeline;
+    inputs.shadowClearQuad = m_ShadowClearQuad;
+    inputs.shadowClearInstance = m_GroundNode;  // The ground node's transform is identity
+    inputs.depthPrepassPipelines = m_DepthPrepassPipelines;
+    inputs.depthPrepassDescriptorSet = m_DepthPrepassDescriptorSet;
+    inputs.motionVectorPipelines = m_MotionVectorPipelines;
+    inputs.motionVectorDescriptorSet = m_MotionVectorDescriptorSet;
+    inputs.picker = m_ObjectPicker.get();
+    inputs.pickPipelines = m_PickPipelines;
+    inputs.streamEncoder = m_StreamEncoder.get();
+    inputs.shadows = m_EnableShadows && shadowLight && !rayTracedShadows && !pathTraced;
+    // The atlas still picks the shadowed local lights when traced; its faces are not rendered
+    inputs.shadowAtlasActive = shadowAtlasActive && !rayTracedShadows;
+    inputs.sampleShadowMoments = m_EnableShadows && m_ShadowFilter == ShadowFilter::EVSM;
+    inputs.gpuCulling = m_EnableGPUCulling;
+    inputs.occlusionCulling = m_EnableOcclusionCulling;
+    inputs.cpuCulling = m_EnableCPUCulling;
+    inputs.singleCopy = IsSingleCopy();
+    inputs.parallelRecording = m_EnableParallelRecording;
+    Ref<rhi::CommandBuffer> computeCmd = m_EnableAsyncCompute ? frame.computeCommandBuffer : nullptr;
+    if (computeCmd) {
+        computeCmd->Begin();
+        inputs.computeCommandBuffer = computeCmd;
+    }
+    inputs.depthPrepass = depthPrepass;
+    inputs.msaaSamples = m_MSAASamples;
+    inputs.transparency = m_Transparency;
+    inputs.oit = m_OIT.get();
+    inputs.capture = m_FrameCapture;
+    inputs.captureHDR = m_FrameCaptureHDR;
+    m_Renderer->SetFrame(inputs);
+    m_Renderer->Render(*m_Scene, *m_FrameCamera);
+
+    cmd->EndZone();
+    if (m_GpuProfiler) {
+        m_GpuProfiler->EndFrame(*cmd);
+    }
+    m_FilteredCallCount = cmd->GetFilteredCallCount();
+    cmd->End();
 
-        // Bind descriptor set (use current frame index for double buffering)
-        cmd->BindDescriptorSet(m_ModelPipeline, m_DescriptorSet, m_CurrentFrame);
+    // Submit command buffer (contains both main rendering and ImGui), after the async
+    // compute work its wait refers to
+    METAGFX_PROFILE_SCOPE("Submit and present");
+    if (computeCmd) {
+        computeCmd->End();
+        if (m_Renderer->GetRenderGraph().GetAsyncPassCount() > 0) {
+            m_Device->SubmitComputeCommandBuffer(computeCmd);
+        }
+    }
+    m_Device->SubmitCommandBuffer(cmd);
 
-        // Push camera position for specular lighting
-        glm::vec4 cameraPos(m_Camera->GetPosition(), 1.0f);
-        cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                           0, sizeof(glm::vec4), &cameraPos);
+    // Present
+    swapChain->Present();
+    RecordStartupTimes();
+    AllocationTracker::EndFrame();
+    if (m_HitchDetector) {
+        m_HitchDetector->EndFrame(*m_Device, m_GpuProfiler.get());
+    }
+}
 
-        // Draw all meshes in the model
-        for (const auto& mesh : m_Model->GetMeshes()) {
-            if (mesh && mesh->IsValid() && mesh->GetMaterial()) {
-                Material* material = mesh->GetMaterial();
+// Time to first frame: Init() to the first present. Time to resident: Init() to the first
+// frame with the startup IBL maps and the initial model in and the pipeline compiles
+// begun in Init() finished.
+void Application::RecordStartupTimes() {
+    if (m_TimeToResidentMs >= 0.0) {
+        return;
+    }
+    double elapsedMs =
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_InitStartTime).count();
+    if (m_TimeToFirstFrameMs < 0.0) {
+        m_TimeToFirstFrameMs = elapsedMs;
+        METAGFX_INFO << "Time to first frame: " << elapsedMs << " ms";
+    }
+    if (!m_StartupEnvironment && !m_ModelLoad && !m_HasPendingModel && m_PendingPipelines.empty()) {
+        m_TimeToResidentMs = elapsedMs;
+        METAGFX_INFO << "Startup resources resident after " << elapsedMs << " ms";
+    }
+}
 
-                // Update material buffer for this mesh
-                MaterialProperties matProps = material->GetProperties();
-                m_MaterialBuffers[0]->CopyData(&matProps, sizeof(matProps));
+// Sorts the renderer's draw list into m_MainQueue and, without bindless materials, gives
+// every queued material its uniform ring slice for this frame. Blended materials sort
+// after the others, back to front, once their pipelines are ready; returns the others'
+// packet count.
+size_t Application::QueueModelDraws(const std::vector<DrawBatch>& drawList, bool gpuCulling,
+                                    TransparencyMode transparency) {
+    m_ModelPass.gpuCulling = gpuCulling;
+    const ModelPass& pass = m_ModelPass;
+
+    // Queue the draw list by pipeline and material, then front to back by the view depth
+    // of each mesh's bounds center. An instanced batch takes the depth of the mesh in the
+    // model's own placement.
+    const auto& meshes = m_Model->GetMeshes();
+    const SceneGraph& sceneGraph = m_Scene->GetSceneGraph();
+    glm::mat4 view = m_FrameCamera->GetViewMatrix() * pass.modelMatrix;
+    m_MainQueue.Clear();
+    m_MainPipelines.assign(1, pass.pipeline);
+    m_TransparentPipelines[0].clear();
+    m_TransparentPipelines[1].clear();
+    m_TransparentPacketCount = 0;
+    m_MaterialPipelineIds.assign(m_MeshMaterialIds.size(), ~0u);
+    for (uint32 i = 0; i < static_cast<uint32>(drawList.size()); ++i) {
+        const DrawBatch& batch = drawList[i];
+        const auto& mesh = meshes[batch.mesh];
+        if (!mesh || !mesh->IsValid() || !mesh->GetMaterial()) {
+            continue;
+        }
+        uint32 node = batch.instanceCount == 1 ? batch.firstInstance : m_Model->GetMeshNode(batch.mesh);
+        glm::vec4 center(mesh->GetBoundsCenter(), 1.0f);
+        if (node < sceneGraph.GetNodeCount()) {
+            center = sceneGraph.GetWorldTransform(node) * center;
+        }
+        uint32 materialId = m_MeshMaterialIds[batch.mesh];
+        const Material& material = *mesh->GetMaterial();
+        if (m_MaterialPipelineIds[materialId] == ~0u) {
+            m_MaterialPipelineIds[materialId] = material.IsBlended() ? SelectTransparentPipeline(material, transparency)
+                                                                     : SelectModelPipeline(material);
+        }
+        if (!material.IsBlended()) {
+            m_MainQueue.Add(m_MaterialPipelineIds[materialId], materialId, -(view * center).z, i);
+        } else if (m_MaterialPipelineIds[materialId] != TRANSPARENT_PIPELINE_PENDING) {
+            m_MainQueue.Add(m_MaterialPipelineIds[materialId], materialId, -(view * center).z, i, true);
+            ++m_TransparentPacketCount;
+        }
+    }
+    m_MainQueue.Sort();
+
+    // The slices are pushed here, on the render thread, so recording only reads them.
+    // A material's packets are contiguous once sorted, so each is pushed once.
+    uint32 lastMaterial = ~0u;
+    m_MaterialRingOffsets.resize(m_MeshMaterialIds.size());
+    for (const DrawPacket& packet : m_MainQueue.GetPackets()) {
+        if (packet.material == lastMaterial) {
+            continue;
+        }
+        lastMaterial = packet.material;
 
-                // Bind all PBR textures (or defaults)
+        Material* material = meshes[drawList[packet.draw].mesh]->GetMaterial();
+        if (!pass.bindless) {
+            MaterialProperties matProps = material->GetProperties();
+            m_MaterialRingOffsets[packet.material] = m_UniformRing->Push(matProps);
+        }
 
-                // Binding 2: Albedo map
-                Ref<rhi::Texture> albedoMap = material->GetAlbedoMap();
-                if (albedoMap) {
-                    m_DescriptorSet->UpdateTexture(2, albedoMap, m_LinearRepeatSampler);
-                } else {
-                    m_DescriptorSet->UpdateTexture(2, m_DefaultTexture, m_LinearRepeatSampler);
-                }
+        // Flags of the first material drawn
+        uint32 flags = material->GetTextureFlags();
+        METAGFX_DEBUG_ONCE << "Material texture flags: 0x" << std::hex << flags << std::dec
+                           << " (HasAlbedo=" << ((flags & 0x1) != 0)
+                           << ", HasNormal=" << ((flags & 0x2) != 0)
+                           << ", HasMetallic=" << ((flags & 0x4) != 0)
+                           << ", HasRoughness=" << ((flags & 0x8) != 0)
+                           << ", HasMetallicRoughness=" << ((flags & 0x10) != 0)
+                           << ", HasAO=" << ((flags & 0x20) != 0)
+                           << ", HasEmissive=" << ((flags & 0x40) != 0) << ")";
+    }
+    return m_MainQueue.GetSize() - m_TransparentPacketCount;
+}
 
-                // Binding 4: Normal map
-                Ref<rhi::Texture> normalMap = material->GetNormalMap();
-                if (normalMap) {
-                    m_DescriptorSet->UpdateTexture(4, normalMap, m_LinearRepeatSampler);
-                } else {
-                    m_DescriptorSet->UpdateTexture(4, m_DefaultNormalMap, m_LinearRepeatSampler);
-                }
+// ModelFeatures of the material in this frame; must match the switches model.frag
+// derives from the frame and material flags
+uint32 Application::GetModelFeatures(const Material& material) const {
+    uint32 features = material.GetTextureFlags() & ModelFeatureTextures;
+    if (m_EnableIBL) {
+        features |= ModelFeatureIBL;
+    }
+    if (m_EnableShadows) {
+        features |= ModelFeatureShadows | (static_cast<uint32>(m_ShadowFilter) << MODEL_FEATURE_SHADOW_FILTER_SHIFT);
+    }
+    if (material.GetAlphaMode() == AlphaMode::Mask) {
+        features |= ModelFeatureAlphaMask;
+    }
+    return features;
+}
 
-                // Binding 5: Metallic map
-                Ref<rhi::Texture> metallicMap = material->GetMetallicMap();
-                Ref<rhi::Texture> metallicRoughnessMap = material->GetMetallicRoughnessMap();
-                if (metallicRoughnessMap) {
-                    // Use combined texture for both metallic (binding 5) and roughness (binding 6)
-                    m_DescriptorSet->UpdateTexture(5, metallicRoughnessMap, m_LinearRepeatSampler);
-                    m_DescriptorSet->UpdateTexture(6, metallicRoughnessMap, m_LinearRepeatSampler);
-                } else {
-                    if (metallicMap) {
-                        m_DescriptorSet->UpdateTexture(5, metallicMap, m_LinearRepeatSampler);
-                    } else {
-                        m_DescriptorSet->UpdateTexture(5, m_DefaultWhiteTexture, m_LinearRepeatSampler);
-                    }
+// m_MainPipelines id the material draws with: its feature permutation once compiled,
+// otherwise 0, the pass's uber pipeline
+uint32 Application::SelectModelPipeline(const Material& material) {
+    const ModelPass& pass = m_ModelPass;
+    if (!pass.permutations) {
+        return 0;
+    }
 
-                    // Binding 6: Roughness map
-                    Ref<rhi::Texture> roughnessMap = material->GetRoughnessMap();
-                    if (roughnessMap) {
-                        m_DescriptorSet->UpdateTexture(6, roughnessMap, m_LinearRepeatSampler);
-                    } else {
-                        m_DescriptorSet->UpdateTexture(6, m_DefaultWhiteTexture, m_LinearRepeatSampler);
-                    }
-                }
+    Ref<rhi::Pipeline> pipeline = RequestModelPermutation(pass.variant, GetModelFeatures(material));
+    if (!pipeline) {
+        return 0;
+    }
+    for (uint32 id = 1; id < static_cast<uint32>(m_MainPipelines.size()); ++id) {
+        if (m_MainPipelines[id] == pipeline) {
+            return id;
+        }
+    }
+    if (m_MainPipelines.size() >= RenderQueue::MAX_PIPELINES) {
+        return 0;
+    }
+    m_MainPipelines.push_back(pipeline);
+    return static_cast<uint32>(m_MainPipelines.size() - 1);
+}
 
-                // Binding 7: AO map
-                Ref<rhi::Texture> aoMap = material->GetAOMap();
-                if (aoMap) {
-                    m_DescriptorSet->UpdateTexture(7, aoMap, m_LinearRepeatSampler);
-                } else {
-                    m_DescriptorSet->UpdateTexture(7, m_DefaultWhiteTexture, m_LinearRepeatSampler);
-                }
+// m_TransparentPipelines id of a blended material, or TRANSPARENT_PIPELINE_PENDING while
+// its pipelines compile: there is no opaque fallback to draw it with. Its permutation,
+// or the uber shader when the pass has none, with the mode's outputs.
+uint32 Application::SelectTransparentPipeline(const Material& material, TransparencyMode transparency) {
+    const ModelPass& pass = m_ModelPass;
+    uint32 features = pass.permutations ? GetModelFeatures(material) : MODEL_FEATURES_UBER;
+    bool weighted = transparency == TransparencyMode::WeightedBlended;
+
+    Ref<rhi::Pipeline> color = RequestModelPermutation(
+        pass.variant, features, weighted ? ModelTransparencyAccumulate : ModelTransparencyBlend);
+    Ref<rhi::Pipeline> revealage =
+        weighted ? RequestModelPermutation(pass.variant, features, ModelTransparencyRevealage) : nullptr;
+    if (!color || (weighted && !revealage)) {
+        return TRANSPARENT_PIPELINE_PENDING;
+    }
+    for (uint32 id = 0; id < static_cast<uint32>(m_TransparentPipelines[0].size()); ++id) {
+        if (m_TransparentPipelines[0][id] == color && m_TransparentPipelines[1][id] == revealage) {
+            return id;
+        }
+    }
+    if (m_TransparentPipelines[0].size() >= RenderQueue::MAX_PIPELINES) {
+        return TRANSPARENT_PIPELINE_PENDING;
+    }
+    m_TransparentPipelines[0].push_back(color);
+    m_TransparentPipelines[1].push_back(revealage);
+    return static_cast<uint32>(m_TransparentPipelines[0].size() - 1);
+}
 
-                // Binding 11: Emissive map
-                Ref<rhi::Texture> emissiveMap = material->GetEmissiveMap();
-                if (emissiveMap) {
-                    m_DescriptorSet->UpdateTexture(11, emissiveMap, m_LinearRepeatSampler);
-                } else {
-                    m_DescriptorSet->UpdateTexture(11, m_DefaultBlackTexture, m_LinearRepeatSampler);
-                }
+// Records packets [firstPacket, endPacket) of m_MainQueue into cmd, which starts with no
+// state bound. Only reads Application state, so ranges are recorded concurrently.
+void Application::RecordModelDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                   size_t firstPacket, size_t endPacket, uint32& materialChanges) const {
+    RecordQueuedDraws(cmd, drawList, firstPacket, endPacket, m_MainPipelines, materialChanges);
+}
 
-                // Re-bind descriptor set after texture updates
-                cmd->BindDescriptorSet(m_ModelPipeline, m_DescriptorSet, m_CurrentFrame);
-
-                // Push material flags and exposure (offset 16 bytes after cameraPosition vec4)
-                uint32_t flags = material->GetTextureFlags();
-
-                // Debug: Log flags on first frame
-                static bool loggedOnce = false;
-                if (!loggedOnce) {
-                    METAGFX_INFO << "Material texture flags: 0x" << std::hex << flags << std::dec
-                                 << " (HasAlbedo=" << ((flags & 0x1) != 0)
-                                 << ", HasNormal=" << ((flags & 0x2) != 0)
-                                 << ", HasMetallic=" << ((flags & 0x4) != 0)
-                                 << ", HasRoughness=" << ((flags & 0x8) != 0)
-                                 << ", HasMetallicRoughness=" << ((flags & 0x10) != 0)
-                                 << ", HasAO=" << ((flags & 0x20) != 0)
-                                 << ", HasEmissive=" << ((flags & 0x40) != 0) << ")";
-                    loggedOnce = true;
-                }
+// The blended packets at the end of m_MainQueue, with the pipelines of the target
+void Application::RecordTransparentDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                         TransparentTarget target) const {
+    uint32 materialChanges = 0;
+    size_t endPacket = m_MainQueue.GetSize();
+    RecordQueuedDraws(cmd, drawList, endPacket - m_TransparentPacketCount, endPacket,
+                      m_TransparentPipelines[target == TransparentTarget::Revealage ? 1 : 0], materialChanges);
+}
 
-                // Push flags (offset 16, size 4)
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   16, sizeof(uint32_t), &flags);
+// Packets [firstPacket, endPacket) of m_MainQueue, whose pipeline ids index pipelines
+void Application::RecordQueuedDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                    size_t firstPacket, size_t endPacket,
+                                    const std::vector<Ref<rhi::Pipeline>>& pipelines,
+                                    uint32& materialChanges) const {
+    using namespace rhi;
 
-                // Push exposure (offset 20, size 4)
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   20, sizeof(float), &m_Exposure);
+    const ModelPass& pass = m_ModelPass;
+
+    // Camera position, exposure, IBL and shadow settings are frame constants of
+    // binding 0; the push constant block only carries what changes per material
+    PushConstantBlock<ModelPushConstants> pushConstants(ShaderStage::Fragment);
+
+    // Draw the queued batches (pooled meshes share their buffers). With GPU culling
+    // the list is every mesh and each draws its own culled command, so hidden ones
+    // draw nothing; with CPU culling hidden meshes are not in the list. Material state
+    // is bound only when the sorted packets move on to another material.
+    const auto& meshes = m_Model->GetMeshes();
+    const auto& packets = m_MainQueue.GetPackets();
+    Ref<rhi::Buffer> boundVertexBuffer;
+    Ref<rhi::Buffer> boundIndexBuffer;
+    uint32 boundPipeline = ~0u;
+    uint32 boundMaterial = ~0u;
+    for (size_t p = firstPacket; p < endPacket; ++p) {
+        const DrawPacket& packet = packets[p];
+        const DrawBatch& batch = drawList[packet.draw];
+        const auto& mesh = meshes[batch.mesh];
+        Material* material = mesh->GetMaterial();
+
+        // Sorted packets switch between the uber pipeline and feature permutations only a
+        // few times per pass; material state is bound again after each switch
+        if (packet.pipeline != boundPipeline) {
+            const Ref<rhi::Pipeline>& pipeline = pipelines[packet.pipeline];
+            cmd.BindPipeline(pipeline);
+
+            // Bindless: one set for every mesh, materials are selected by push constant.
+            // Otherwise the frame and pass sets are bound here and set 2 per material below
+            if (pass.bindless) {
+                cmd.BindDescriptorSet(pipeline, m_BindlessDescriptorSet, m_CurrentFrame, &pass.mvpOffset, 1);
+            } else {
+                cmd.BindDescriptorSet(pipeline, 0, m_DescriptorSet, m_CurrentFrame, &pass.mvpOffset, 1);
+                cmd.BindDescriptorSet(pipeline, 1, m_PassDescriptorSet, m_CurrentFrame);
+            }
+            pushConstants.Invalidate();
+            boundPipeline = packet.pipeline;
+            boundMaterial = ~0u;
+        }
+        const Ref<rhi::Pipeline>& pipeline = pipelines[boundPipeline];
 
-                // Push IBL enable flag (offset 24, size 4)
-                uint32_t enableIBL = m_EnableIBL ? 1u : 0u;
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   24, sizeof(uint32_t), &enableIBL);
+        if (packet.material != boundMaterial) {
+            if (pass.bindless) {
+                auto indexIt = m_BindlessMaterialIndices.find(material);
+                uint32 materialIndex = indexIt != m_BindlessMaterialIndices.end() ? indexIt->second : 0;
+                pushConstants.Set(&ModelPushConstants::materialIndex, materialIndex);
+            } else {
+                // Rebind only set 2, the material's prebuilt (or pushed) set with its material offset
+                auto setIt = m_MaterialDescriptorSets.find(material);
+                const MaterialSet& materialSet =
+                    setIt != m_MaterialDescriptorSets.end() ? setIt->second : m_DefaultMaterialSet;
+                BindMaterialSet(cmd, pipeline, materialSet, m_MaterialRingOffsets[packet.material]);
+            }
 
-                // Push IBL intensity (offset 28, size 4)
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   28, sizeof(float), &m_IBLIntensity);
+            // One push of the whole block, when a field changed
+            pushConstants.Set(&ModelPushConstants::materialFlags, material->GetTextureFlags());
+            pushConstants.Flush(cmd, pipeline);
 
-                // Push shadow debug mode (offset 32, size 4)
-                uint32_t shadowDebugMode = static_cast<uint32_t>(m_ShadowDebugMode);
+            boundMaterial = packet.material;
+            ++materialChanges;
+        }
 
-                // Debug: Log shadow debug mode on first frame
-                static bool loggedDebugMode = false;
-                if (!loggedDebugMode) {
-                    METAGFX_INFO << "Shadow debug mode being pushed to shader: " << shadowDebugMode;
-                    loggedDebugMode = true;
-                }
+        // Bind and draw
+        if (mesh->GetVertexBuffer() != boundVertexBuffer) {
+            cmd.BindVertexBuffer(mesh->GetVertexBuffer());
+            boundVertexBuffer = mesh->GetVertexBuffer();
+        }
+        if (mesh->GetIndexBuffer() != boundIndexBuffer) {
+            cmd.BindIndexBuffer(mesh->GetIndexBuffer());
+            boundIndexBuffer = mesh->GetIndexBuffer();
+        }
+        if (pass.gpuCulling) {
+            cmd.DrawIndexedIndirect(m_GPUCuller->GetCameraDrawBuffer(), m_GPUCuller->GetCameraDrawOffset(batch.mesh),
+                                    m_GPUCuller->GetMeshDrawCount(batch.mesh));
+        } else {
+            cmd.DrawIndexed(mesh->GetLodIndexCount(batch.lod), batch.instanceCount, mesh->GetLodFirstIndex(batch.lod),
+                            mesh->GetVertexOffset(), batch.firstInstance);
+        }
+    }
+}
 
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   32, sizeof(uint32_t), &shadowDebugMode);
+// Visibility pass of the model's opaque packets: every mesh draws the culler's second
+// copy of its commands, whose first instance is the cull record the pass writes ids of
+void Application::RecordVisibilityDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                        size_t packetCount) const {
+    using namespace rhi;
 
-                // Push shadow enable flag (offset 36, size 4)
-                uint32_t enableShadows = m_EnableShadows ? 1u : 0u;
+    bool compactModel = m_Model->GetVertexFormat() == VertexFormat::Compact;
+    const Ref<rhi::Pipeline>& pipeline = compactModel ? m_CompactVisibilityPipeline : m_VisibilityPipeline;
+    cmd.BindPipeline(pipeline);
+    cmd.BindDescriptorSet(pipeline, m_BindlessDescriptorSet, m_CurrentFrame, &m_ModelPass.mvpOffset, 1);
+
+    // Only masked materials read anything of theirs, their alpha: the ids are the output
+    PushConstantBlock<ModelPushConstants> pushConstants(ShaderStage::Fragment);
+    const auto& meshes = m_Model->GetMeshes();
+    const auto& packets = m_MainQueue.GetPackets();
+    Ref<rhi::Buffer> boundVertexBuffer;
+    Ref<rhi::Buffer> boundIndexBuffer;
+    for (size_t p = 0; p < packetCount; ++p) {
+        const DrawBatch& batch = drawList[packets[p].draw];
+        const auto& mesh = meshes[batch.mesh];
+        Material* material = mesh->GetMaterial();
+
+        auto indexIt = m_BindlessMaterialIndices.find(material);
+        pushConstants.Set(&ModelPushConstants::materialIndex,
+                          indexIt != m_BindlessMaterialIndices.end() ? indexIt->second : 0);
+        pushConstants.Set(&ModelPushConstants::materialFlags, material->GetTextureFlags());
+        pushConstants.Flush(cmd, pipeline);
+
+        if (mesh->GetVertexBuffer() != boundVertexBuffer) {
+            cmd.BindVertexBuffer(mesh->GetVertexBuffer());
+            boundVertexBuffer = mesh->GetVertexBuffer();
+        }
+        if (mesh->GetIndexBuffer() != boundIndexBuffer) {
+            cmd.BindIndexBuffer(mesh->GetIndexBuffer());
+            boundIndexBuffer = mesh->GetIndexBuffer();
+        }
+        cmd.DrawIndexedIndirect(m_GPUCuller->GetCameraDrawBuffer(), m_GPUCuller->GetVisibilityDrawOffset(batch.mesh),
+                                m_GPUCuller->GetMeshDrawCount(batch.mesh));
+    }
+}
 
-                // Debug: Log shadow enable state on first frame
-                static bool loggedShadowState = false;
-                if (!loggedShadowState) {
-                    METAGFX_INFO << "Shadow enable flag being pushed to shader: " << enableShadows;
-                    loggedShadowState = true;
-                }
+// Ground plane and skybox of the main pass, after the model
+void Application::RecordSceneryDraws(rhi::CommandBuffer& cmd) {
+    using namespace rhi;
 
-                cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment,
-                                   36, sizeof(uint32_t), &enableShadows);
+    uint32 mvpOffset = m_ModelPass.sceneryMvpOffset;
 
-                // Bind and draw
-                cmd->BindVertexBuffer(mesh->GetVertexBuffer());
-                cmd->BindIndexBuffer(mesh->GetIndexBuffer());
-                cmd->DrawIndexed(mesh->GetIndexCount());
-            }
-        }
-    }
+    // The scenery always uses the per-material, full-float pipeline (a no-op bind when
+    // the model drew with it); its traced variant when the model's shadows are traced, as
+    // the shadow maps are not drawn then
+    bool rayTraced = m_ModelPass.variant == ModelVariantRayTraced ||
+                     m_ModelPass.variant == ModelVariantRayTracedCompact;
+    const Ref<rhi::Pipeline>& sceneryPipeline =
+        rayTraced && m_RayTracedModelPipeline ? m_RayTracedModelPipeline : m_ModelPipeline;
 
     // Render ground plane with simple grey material (if enabled)
-    if (!debugDisableAdvancedFeatures && m_ShowGroundPlane && m_GroundPlane && m_GroundPlane->IsValid()) {
+    if (m_ShowGroundPlane && m_GroundPlane && m_GroundPlane->IsValid()) {
         // Create a simple grey material for the ground
         // Use darker grey to make shadows more visible
         MaterialProperties groundMat{};
@@ -1457,39 +5050,77 @@ void Application::Render() {
         groundMat.roughness = 0.9f;  // Very rough (increased from 0.8)
         groundMat.metallic = 0.0f;   // Not metallic
         groundMat.emissiveFactor = glm::vec3(0.0f);
-        m_GroundPlaneMaterialBuffer->CopyData(&groundMat, sizeof(groundMat));
+        uint32 groundMaterialOffset = m_UniformRing->Push(groundMat);
 
         // DO NOT call UpdateTexture here! The ground plane descriptor set was initialized
         // with default textures during setup, and calling UpdateTexture during rendering
         // causes issues. Just bind the pre-configured descriptor set.
 
-        // Bind ground plane's dedicated descriptor set (use current frame for double buffering)
-        cmd->BindDescriptorSet(m_ModelPipeline, m_GroundPlaneDescriptorSet, m_CurrentFrame);
+        cmd.BindPipeline(sceneryPipeline);
+
+        // The scenery's view offset, then the ground plane's dedicated material set
+        cmd.BindDescriptorSet(sceneryPipeline, 0, m_DescriptorSet, m_CurrentFrame, &mvpOffset, 1);
+        cmd.BindDescriptorSet(sceneryPipeline, 1, m_PassDescriptorSet, m_CurrentFrame);
+        BindMaterialSet(cmd, sceneryPipeline, m_GroundPlaneMaterialSet, groundMaterialOffset);
 
-        // Push material flags (no textures)
-        uint32_t flags = 0;
-        cmd->PushConstants(m_ModelPipeline, ShaderStage::Fragment, 16, sizeof(uint32_t), &flags);
+        // No textures
+        ModelPushConstants groundPushConstants{};
+        cmd.PushConstants(sceneryPipeline, ShaderStage::Fragment, 0, sizeof(ModelPushConstants), &groundPushConstants);
 
         // Draw ground plane
         for (const auto& mesh : m_GroundPlane->GetMeshes()) {
             if (mesh && mesh->IsValid()) {
-                cmd->BindVertexBuffer(mesh->GetVertexBuffer());
-                cmd->BindIndexBuffer(mesh->GetIndexBuffer());
-                cmd->DrawIndexed(mesh->GetIndexCount());
+                cmd.BindVertexBuffer(mesh->GetVertexBuffer());
+                cmd.BindIndexBuffer(mesh->GetIndexBuffer());
+                cmd.DrawIndexed(mesh->GetIndexCount(), 1, mesh->GetFirstIndex(), mesh->GetVertexOffset(), m_GroundNode);
             }
         }
     }
 
-    // Render skybox LAST (only where depth >= model depth)
-    if (!debugDisableAdvancedFeatures && m_ShowSkybox && m_EnvironmentMap && m_SkyboxPipeline && m_SkyboxVertexBuffer && m_SkyboxIndexBuffer && m_SkyboxDescriptorSet) {
-        cmd->BindPipeline(m_SkyboxPipeline);
+    // World cells in view (PrepareCellDraws), each mesh with its material's set and slice
+    if (!m_CellDraws.empty()) {
+        cmd.BindPipeline(sceneryPipeline);
+        cmd.BindDescriptorSet(sceneryPipeline, 0, m_DescriptorSet, m_CurrentFrame, &mvpOffset, 1);
+        cmd.BindDescriptorSet(sceneryPipeline, 1, m_PassDescriptorSet, m_CurrentFrame);
+
+        const MaterialSet* boundSet = nullptr;
+        uint32 boundOffset = ~0u;
+        uint32 boundFlags = ~0u;
+        Ref<rhi::Buffer> boundVertexBuffer;
+        Ref<rhi::Buffer> boundIndexBuffer;
+        for (const CellDraw& draw : m_CellDraws) {
+            if (draw.materialSet != boundSet || draw.materialOffset != boundOffset) {
+                BindMaterialSet(cmd, sceneryPipeline, *draw.materialSet, draw.materialOffset);
+                boundSet = draw.materialSet;
+                boundOffset = draw.materialOffset;
+            }
+            if (draw.materialFlags != boundFlags) {
+                ModelPushConstants cellPushConstants{};
+                cellPushConstants.materialFlags = draw.materialFlags;
+                cmd.PushConstants(sceneryPipeline, ShaderStage::Fragment, 0, sizeof(ModelPushConstants),
+                                  &cellPushConstants);
+                boundFlags = draw.materialFlags;
+            }
+
+            const Mesh* mesh = draw.mesh;
+            if (mesh->GetVertexBuffer() != boundVertexBuffer) {
+                cmd.BindVertexBuffer(mesh->GetVertexBuffer());
+                boundVertexBuffer = mesh->GetVertexBuffer();
+            }
+            if (mesh->GetIndexBuffer() != boundIndexBuffer) {
+                cmd.BindIndexBuffer(mesh->GetIndexBuffer());
+                boundIndexBuffer = mesh->GetIndexBuffer();
+            }
+            cmd.DrawIndexed(mesh->GetIndexCount(), 1, mesh->GetFirstIndex(), mesh->GetVertexOffset(), draw.node);
+        }
+    }
 
-        // Update skybox descriptor set with uniform buffer (always use buffer[0])
-        // FIXME: Matches main renderer which always updates buffer[0]
-        m_SkyboxDescriptorSet->UpdateBuffer(0, m_UniformBuffers[0]);
+    // Render skybox LAST (only where depth >= model depth)
+    if (m_ShowSkybox && m_EnvironmentMap && m_SkyboxPipeline && m_SkyboxDescriptorSet) {
+        cmd.BindPipeline(m_SkyboxPipeline);
 
-        // Bind skybox descriptor set (binding 0: MVP, binding 1: environment cubemap)
-        cmd->BindDescriptorSet(m_SkyboxPipeline, m_SkyboxDescriptorSet, m_CurrentFrame);
+        // Bind skybox descriptor set (binding 0: MVP from the uniform ring, binding 1: environment cubemap)
+        cmd.BindDescriptorSet(m_SkyboxPipeline, m_SkyboxDescriptorSet, m_CurrentFrame, &mvpOffset, 1);
 
         // Push constants: exposure and LOD
         struct SkyboxPushConstants {
@@ -1500,93 +5131,152 @@ void Application::Render() {
         skyboxPushConstants.exposure = m_Exposure;
         skyboxPushConstants.lod = m_SkyboxLOD;
 
-        cmd->PushConstants(m_SkyboxPipeline, ShaderStage::Fragment,
-                           0, sizeof(SkyboxPushConstants), &skyboxPushConstants);
+        cmd.PushConstants(m_SkyboxPipeline, ShaderStage::Fragment,
+                          0, sizeof(SkyboxPushConstants), &skyboxPushConstants);
 
-        // Draw the skybox cube
-        cmd->BindVertexBuffer(m_SkyboxVertexBuffer);
-        cmd->BindIndexBuffer(m_SkyboxIndexBuffer);
-        cmd->DrawIndexed(36);  // 36 indices for the cube
+        cmd.Draw(3);
     }
+}
 
-    // Render ImGui overlay BEFORE EndRendering (Metal needs active encoder)
-    RenderImGui(cmd, backBuffer);
-
-    cmd->EndRendering();
-
-    cmd->End();
-
-    // Submit command buffer (contains both main rendering and ImGui)
-    m_Device->SubmitCommandBuffer(cmd);
-
-    // Present
-    swapChain->Present();
-    
-    // Advance frame
-    m_CurrentFrame = (m_CurrentFrame + 1) % 2;
+// ImGui, last, over the back buffer
+void Application::RecordOverlay(rhi::CommandBuffer& cmd) {
+    RenderImGui(cmd);
 }
 
 void Application::Shutdown() {
+    // Waits for the GPU and releases everything retired (the old renderer holds the device)
     if (m_Device) {
-        m_Device->WaitIdle();
+        m_Device->ReleaseRetired(true);
     }
 
     // Shutdown ImGui
     ShutdownImGui();
 
-    // Clean up scene and model
-    m_Scene.reset();
+    // Clean up scene and model; the GPU is idle. A background load is dropped first: it
+    // may still be importing on its thread. The startup IBL reads are waited out.
+    m_ModelLoad.reset();
+    m_WorldPartition.reset();  // Waits for its loads in flight
+    m_CellDraws.clear();
+    if (m_StartupEnvironment) {
+        JobSystem::Wait(m_StartupEnvironment->reads);
+        m_StartupEnvironment.reset();
+    }
     if (m_Model) {
         m_Model->Cleanup();
-        m_Model.reset();
+        m_Model = nullptr;
     }
+    m_Scene.reset();  // And the model with it
     if (m_GroundPlane) {
         m_GroundPlane->Cleanup();
         m_GroundPlane.reset();
     }
-
-    // Clean up pipelines
+    m_TextureStreamer.reset();
+    m_TextureCache.reset();
+    m_Renderer.reset();
+    m_GPUCuller.reset();
+    m_RayTracingScene.reset();
+    m_AmbientOcclusion.reset();
+    m_Reflections.reset();
+    m_ShadingRate.reset();
+    m_OIT.reset();
+    m_Animator.reset();
+    m_Skinning.reset();
+    m_Denoiser.reset();
+    m_PathTracer.reset();
+    m_LightProbes.reset();
+    m_DeferredLighting.reset();
+    m_AutoExposure.reset();
+    m_ObjectPicker.reset();
+    m_StreamEncoder.reset();
+    m_StreamServer.reset();
+    m_EnvironmentBaker.reset();
+    m_Bloom.reset();
+    m_TemporalAA.reset();
+    m_ToneMapper.reset();
+    m_TransformBuffer.reset();
+    m_InstanceBuffer.reset();
+    m_LightClusters.reset();
+
+    // Timestamp queries belong to the device
+    m_HitchDetector.reset();
+    m_GpuProfiler.reset();
+
+    // Stop shader hot reload (waits for recompiles in flight)
+    m_ShaderWatcher.reset();
+    m_ReloadedShaders.clear();
+
+    // Clean up pipelines (background compiles first, so none lands after this)
+    for (PendingPipeline& pending : m_PendingPipelines) {
+        pending.future->Wait();
+    }
+    m_PendingPipelines.clear();
+    m_ModelPermutations.clear();
+    m_MainPipelines.clear();
+    m_TransparentPipelines[0].clear();
+    m_TransparentPipelines[1].clear();
+    for (rhi::PipelineDesc& desc : m_ModelVariantDescs) {
+        desc = rhi::PipelineDesc{};
+    }
     m_ModelPipeline.reset();
+    m_BindlessModelPipeline.reset();
+    m_CompactModelPipeline.reset();
+    m_BindlessCompactModelPipeline.reset();
+    m_PulledModelPipeline.reset();
+    m_RayTracedModelPipeline.reset();
+    m_RayTracedCompactModelPipeline.reset();
     m_SkyboxPipeline.reset();
     m_ShadowPipeline.reset();
+    m_CompactShadowPipeline.reset();
+    m_ShadowPositionPipeline.reset();
+    m_CompactShadowPositionPipeline.reset();
+    m_ShadowClearPipeline.reset();
+    m_PulledShadowPipeline.reset();
+    m_DepthPrepassPipelines = RasterizationRenderer::DepthOnlyPipelines{};
+    m_MotionVectorPipelines = RasterizationRenderer::DepthOnlyPipelines{};
+    m_PickPipelines = RasterizationRenderer::DepthOnlyPipelines{};
     m_Pipeline.reset();
 
     // Clean up buffers
     m_VertexBuffer.reset();
-    m_SkyboxVertexBuffer.reset();
-    m_SkyboxIndexBuffer.reset();
-    m_UniformBuffers[0].reset();
-    m_UniformBuffers[1].reset();
-    m_MaterialBuffers[0].reset();
-    m_MaterialBuffers[1].reset();
-    m_GroundPlaneMaterialBuffer.reset();
+    m_ShadowClearQuad.reset();
+    m_UniformRing.reset();
     m_ShadowUniformBuffer.reset();
+    m_BindlessMaterialBuffer.reset();
 
     // Clean up descriptor sets
+    m_MaterialDescriptorSets.clear();
+    m_CellMaterialSets.clear();
+    m_BindlessDescriptorSet.reset();
     m_DescriptorSet.reset();
+    m_PassDescriptorSet.reset();
+    m_DefaultMaterialSet = MaterialSet{};
     m_SkyboxDescriptorSet.reset();
     m_ShadowDescriptorSet.reset();
-    m_GroundPlaneDescriptorSet.reset();
+    m_DepthPrepassDescriptorSet.reset();
+    m_MotionVectorDescriptorSet.reset();
+    m_GroundPlaneMaterialSet = MaterialSet{};
 
     // Clean up textures (must be before device destruction)
     m_DefaultTexture.reset();
     m_DefaultNormalMap.reset();
     m_DefaultWhiteTexture.reset();
     m_DefaultBlackTexture.reset();
-    m_DepthBuffer.reset();
 
     // Clean up IBL textures
-    m_IrradianceMap.reset();
+    m_IrradianceSHBuffer.reset();
     m_PrefilteredMap.reset();
     m_BRDF_LUT.reset();
     m_EnvironmentMap.reset();
+    m_DefaultBlackCubemap.reset();
 
     // Clean up samplers
     m_LinearRepeatSampler.reset();
     m_CubemapSampler.reset();
 
     // Clean up shadow map
+    m_ShadowMoments.reset();
     m_ShadowMap.reset();
+    m_ShadowAtlas.reset();
 
     // Finally destroy the device
     m_Device.reset();
@@ -1602,219 +5292,135 @@ void Application::Shutdown() {
 }
 
 void Application::InitImGui() {
-    auto api = m_Device->GetDeviceInfo().api;
-
-    // Setup ImGui context (common for all backends)
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     ImGuiIO& io = ImGui::GetIO();
     io.ConfigFlags |= ImGuiConfigFlags_NavEnableKeyboard;
     ImGui::StyleColorsDark();
 
-    if (api == rhi::GraphicsAPI::Metal) {
-        // Initialize ImGui for Metal backend
-        auto metalDevice = std::static_pointer_cast<rhi::MetalDevice>(m_Device);
-        auto& context = metalDevice->GetContext();
+    // SDL3 for input on every backend; drawing goes through the RHI
+    ImGui_ImplSDL3_InitForOther(m_Window);
 
-        ImGui_ImplSDL3_InitForMetal(m_Window);
-        ImGui_ImplMetal_Init(context.device);
-
-        // Create fonts texture for Metal
-        ImGui_ImplMetal_CreateFontsTexture(context.device);
+    using namespace rhi;
 
-        METAGFX_INFO << "ImGui initialized for Metal backend";
-        return;
-    }
+    std::vector<uint8> vertShaderCode = {
+        #include "imgui.vert.spv.inl"
+    };
+    std::vector<uint8> fragShaderCode = {
+        #include "imgui.frag.spv.inl"
+    };
 
-    if (api != rhi::GraphicsAPI::Vulkan) {
-        METAGFX_INFO << "ImGui not supported for this backend yet";
-        ImGui::DestroyContext();
-        return;
-    }
+    ShaderDesc vertShaderDesc{};
+    vertShaderDesc.stage = ShaderStage::Vertex;
+    vertShaderDesc.code = vertShaderCode;
+    vertShaderDesc.entryPoint = "main";
 
-    auto vkDevice = std::static_pointer_cast<rhi::VulkanDevice>(m_Device);
-    auto& context = vkDevice->GetContext();
-    auto swapChain = m_Device->GetSwapChain();
+    ShaderDesc fragShaderDesc{};
+    fragShaderDesc.stage = ShaderStage::Fragment;
+    fragShaderDesc.code = fragShaderCode;
+    fragShaderDesc.entryPoint = "main";
 
-    // Create descriptor pool for ImGui
-    VkDescriptorPoolSize poolSizes[] = {
-        { VK_DESCRIPTOR_TYPE_SAMPLER, 1000 },
-        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000 },
-        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1000 },
-        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1000 },
-        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1000 },
-        { VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 1000 }
-    };
-
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-    poolInfo.maxSets = 1000;
-    poolInfo.poolSizeCount = 11;
-    poolInfo.pPoolSizes = poolSizes;
-
-    vkCreateDescriptorPool(context.device, &poolInfo, nullptr, &m_ImGuiDescriptorPool);
-
-    // Create ImGui render pass
-    VkAttachmentDescription attachment{};
-    attachment.format = VK_FORMAT_B8G8R8A8_SRGB;
-    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;  // Load existing content
-    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    attachment.initialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-
-    VkSubpassDependency dependency{};
-    dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dependency.dstSubpass = 0;
-    dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dependency.srcAccessMask = 0;
-    dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = 1;
-    renderPassInfo.pAttachments = &attachment;
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    renderPassInfo.dependencyCount = 1;
-    renderPassInfo.pDependencies = &dependency;
-
-    vkCreateRenderPass(context.device, &renderPassInfo, nullptr, &m_ImGuiRenderPass);
-
-    // Initialize ImGui backends
-    ImGui_ImplSDL3_InitForVulkan(m_Window);
-
-    // Get the actual swap chain image count by querying Vulkan
-    auto vkSwapChain = std::static_pointer_cast<rhi::VulkanSwapChain>(swapChain);
-    uint32_t imageCount = 0;
-    vkGetSwapchainImagesKHR(context.device, vkSwapChain->GetHandle(), &imageCount, nullptr);
-    METAGFX_INFO << "InitImGui: Swap chain has " << imageCount << " images";
-
-    ImGui_ImplVulkan_InitInfo initInfo{};
-    initInfo.Instance = context.instance;
-    initInfo.PhysicalDevice = context.physicalDevice;
-    initInfo.Device = context.device;
-    initInfo.QueueFamily = context.graphicsQueueFamily;
-    initInfo.Queue = context.graphicsQueue;
-    initInfo.DescriptorPool = m_ImGuiDescriptorPool;
-    initInfo.RenderPass = m_ImGuiRenderPass;
-    initInfo.MinImageCount = imageCount;
-    initInfo.ImageCount = imageCount;
-    initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-
-    ImGui_ImplVulkan_Init(&initInfo);
-
-    // Upload fonts
-    ImGui_ImplVulkan_CreateFontsTexture();
-
-    // Wait for font upload to complete
-    vkDeviceWaitIdle(context.device);
-
-    // Initialize framebuffers vector (created lazily during rendering)
-    // Need to match the swap chain image count (typically 2 or 3)
-    m_ImGuiFramebuffers.resize(imageCount, VK_NULL_HANDLE);
+    m_ImGuiRenderer = std::make_unique<ImGuiRenderer>(m_Device, m_Device->CreateShader(vertShaderDesc),
+                                                      m_Device->CreateShader(fragShaderDesc),
+                                                      m_Device->GetDeviceInfo().framesInFlight);
+    if (!m_ImGuiRenderer->IsValid()) {
+        m_ImGuiRenderer.reset();
+    }
 }
 
 void Application::ShutdownImGui() {
-    if (!m_Device) return;
-
-    auto api = m_Device->GetDeviceInfo().api;
-
-    if (api == rhi::GraphicsAPI::Metal) {
-        ImGui_ImplMetal_Shutdown();
-        ImGui_ImplSDL3_Shutdown();
-        ImGui::DestroyContext();
-        return;
-    }
-
-    if (api != rhi::GraphicsAPI::Vulkan) {
+    if (!ImGui::GetCurrentContext()) {
         return;
     }
+    m_ImGuiRenderer.reset();
+    ImGui_ImplSDL3_Shutdown();
+    ImGui::DestroyContext();
+}
 
-    auto vkDevice = std::static_pointer_cast<rhi::VulkanDevice>(m_Device);
-    auto& context = vkDevice->GetContext();
+// Flame view of the last CPU frame: one lane per thread, zones stacked by nesting depth
+// over the main loop's frame interval. Zones that began in an earlier frame are clipped.
+void Application::RenderCpuProfiler() {
+    ProfileFrame frame = Profiler::GetLatestFrame();
+    ImGui::Text("CPU frame: %.3f ms", frame.durationMs);
+
+    const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+    const float labelWidth = 90.0f;
+    const float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 50.0f);
+    const double scale = frame.durationMs > 0.0 ? width / frame.durationMs : 0.0;
+    ImDrawList* drawList = ImGui::GetWindowDrawList();
+    ImVec2 mouse = ImGui::GetIO().MousePos;
+    const ProfileZone* hovered = nullptr;
+
+    for (const ProfileThread& thread : frame.threads) {
+        uint32 depthCount = 1;
+        for (const ProfileZone& zone : thread.zones) {
+            depthCount = std::max(depthCount, zone.depth + 1);
+        }
 
-    // Destroy ImGui framebuffers
-    for (auto framebuffer : m_ImGuiFramebuffers) {
-        if (framebuffer != VK_NULL_HANDLE) {
-            vkDestroyFramebuffer(context.device, framebuffer, nullptr);
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        drawList->AddText(origin, ImGui::GetColorU32(ImGuiCol_Text), thread.name.c_str());
+        origin.x += labelWidth;
+        for (const ProfileZone& zone : thread.zones) {
+            float x0 = origin.x + static_cast<float>(std::max(zone.startMs, 0.0) * scale);
+            float x1 = origin.x + static_cast<float>(std::min(zone.startMs + zone.durationMs, frame.durationMs) * scale);
+            if (x1 - x0 < 1.0f) {
+                continue;
+            }
+            float y0 = origin.y + zone.depth * rowHeight;
+            ImVec2 min(x0, y0);
+            ImVec2 max(x1, y0 + rowHeight - 1.0f);
+
+            // Color by name, so a zone keeps its color from frame to frame
+            uint32 hash = static_cast<uint32>(std::hash<std::string_view>()(zone.name));
+            ImU32 color = IM_COL32(80 + (hash & 0x7F), 80 + ((hash >> 8) & 0x7F), 80 + ((hash >> 16) & 0x7F), 255);
+            drawList->AddRectFilled(min, max, color);
+            drawList->PushClipRect(min, max, true);
+            drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32(255, 255, 255, 255), zone.name);
+            drawList->PopClipRect();
+
+            if (mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y) {
+                hovered = &zone;
+            }
+        }
+        ImGui::Dummy(ImVec2(labelWidth + width, depthCount * rowHeight));
+        if (thread.droppedEvents > 0) {
+            ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.2f, 1.0f), "%s: %u events dropped", thread.name.c_str(),
+                               thread.droppedEvents);
         }
     }
-    m_ImGuiFramebuffers.clear();
-
-    // Shutdown ImGui backends
-    ImGui_ImplVulkan_Shutdown();
-    ImGui_ImplSDL3_Shutdown();
-    ImGui::DestroyContext();
+    if (hovered) {
+        ImGui::SetTooltip("%s: %.3f ms", hovered->name, hovered->durationMs);
+    }
 
-    // Destroy ImGui resources
-    if (m_ImGuiRenderPass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(context.device, m_ImGuiRenderPass, nullptr);
-        m_ImGuiRenderPass = VK_NULL_HANDLE;
+    // Latest value of each counter
+    std::vector<const ProfileCounter*> counters;
+    for (const ProfileCounter& counter : frame.counters) {
+        auto it = std::find_if(counters.begin(), counters.end(),
+                               [&](const ProfileCounter* c) { return std::strcmp(c->name, counter.name) == 0; });
+        if (it != counters.end()) {
+            *it = &counter;
+        } else {
+            counters.push_back(&counter);
+        }
+    }
+    for (const ProfileCounter* counter : counters) {
+        ImGui::Text("%s: %.0f", counter->name, counter->value);
     }
 
-    if (m_ImGuiDescriptorPool != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(context.device, m_ImGuiDescriptorPool, nullptr);
-        m_ImGuiDescriptorPool = VK_NULL_HANDLE;
+    if (ImGui::Button("Export CPU Trace")) {
+        Profiler::WriteChromeTrace("metagfx_cpu_trace.json");
     }
 }
 
-void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> backBuffer) {
-    if (!m_Device || !cmd || !backBuffer) {
+void Application::RenderImGui(rhi::CommandBuffer& cmd) {
+    // Benchmarks measure the scene alone, and batch renders show it alone
+    if (!m_ImGuiRenderer || IsHeadless()) {
         return;
     }
-
-    auto api = m_Device->GetDeviceInfo().api;
+    METAGFX_ALLOCATION_SCOPE(UI);
 
     // Start ImGui frame
     ImGui_ImplSDL3_NewFrame();
-
-    if (api == rhi::GraphicsAPI::Metal) {
-        // Metal backend needs NewFrame with render pass descriptor
-        auto metalCmd = std::static_pointer_cast<rhi::MetalCommandBuffer>(cmd);
-        auto encoder = metalCmd->GetRenderEncoder();
-        if (!encoder) {
-            return;  // No active render encoder
-        }
-
-        // Create render pass descriptor matching our current render target
-        MTL::RenderPassDescriptor* renderPassDesc = MTL::RenderPassDescriptor::alloc()->init();
-
-        // Set up color attachment
-        auto colorAttachment = renderPassDesc->colorAttachments()->object(0);
-        auto metalTexture = std::static_pointer_cast<rhi::MetalTexture>(backBuffer);
-        colorAttachment->setTexture(metalTexture->GetHandle());
-        colorAttachment->setLoadAction(MTL::LoadActionLoad);  // Keep existing content
-        colorAttachment->setStoreAction(MTL::StoreActionStore);
-
-        ImGui_ImplMetal_NewFrame(renderPassDesc);
-        renderPassDesc->release();
-
-        static bool logged = false;
-        if (!logged) {
-            METAGFX_INFO << "ImGui Metal NewFrame called";
-            logged = true;
-        }
-    }
-
     ImGui::NewFrame();
 
     // Define UI
@@ -1837,6 +5443,16 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
     }
     ImGui::Text("API: %s", currentApiName);
     ImGui::Text("Device: %s", deviceInfo.deviceName.c_str());
+    if (m_StreamServer) {
+        StreamServer::Stats stream = m_StreamServer->GetStats();
+        ImGui::Text("Stream: %s", m_StreamServer->IsConnected() ? "client connected" : "waiting for a client");
+        if (m_StreamEncoder) {
+            ImGui::Text("Format: %s", m_StreamEncoder->GetFormat() == stream::PixelFormat::H264 ? "H.264" : "raw NV12");
+        }
+        ImGui::Text("Latency %.1f ms, send %.1f ms", stream.latencyMs, stream.sendMs);
+        ImGui::Text("Frames sent %llu, dropped %llu", static_cast<unsigned long long>(stream.framesSent),
+                    static_cast<unsigned long long>(stream.framesDropped));
+    }
 
     // Backend selection combo (for next launch)
     static int selectedBackend = static_cast<int>(m_Config.graphicsAPI);
@@ -1914,15 +5530,98 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
     if (ImGui::Combo("Model", &currentModel, modelNames, IM_ARRAYSIZE(modelNames))) {
         if (currentModel != m_CurrentModelIndex) {
             m_CurrentModelIndex = currentModel;
-            m_PendingModelPath = m_AvailableModels[m_CurrentModelIndex];
-            m_HasPendingModel = true;
+            RequestModelLoad(m_AvailableModels[m_CurrentModelIndex]);
+        }
+    }
+    if (m_ModelLoad) {
+        ImGui::TextDisabled("Loading in the background...");
+    }
+    ImGui::Checkbox("Optimize geometry on import", &m_Config.modelImport.optimizeGeometry);
+    if (m_CompactModelPipeline) {
+        bool compactVertices = m_Config.modelImport.vertexFormat == VertexFormat::Compact;
+        if (ImGui::Checkbox("Compact vertices (20 bytes)", &compactVertices)) {
+            m_Config.modelImport.vertexFormat = compactVertices ? VertexFormat::Compact : VertexFormat::Float;
+        }
+    }
+    const TextureStreamer::Stats& streaming = m_TextureStreamer->GetStats();
+    if (streaming.textureCount > 0) {
+        ImGui::Text("Streamed textures: %u of %u, %.0f of %.0f MB", streaming.streamedCount, streaming.textureCount,
+                    streaming.streamedBytes / (1024.0 * 1024.0), streaming.budgetBytes / (1024.0 * 1024.0));
+    }
+    if (m_WorldPartition) {
+        const WorldPartition::Stats& world = m_WorldPartition->GetStats();
+        ImGui::Checkbox("World cells", &m_ShowWorldCells);
+        ImGui::Text("Cells: %u of %u resident, %u loading, %.0f of %.0f MB", world.residentCount, world.cellCount,
+                    world.loadsInFlight, world.residentBytes / (1024.0 * 1024.0), world.budgetBytes / (1024.0 * 1024.0));
+        WorldPartition::Settings worldSettings = m_WorldPartition->GetSettings();
+        if (ImGui::SliderFloat("Cell load distance", &worldSettings.loadDistance, 10.0f, 2000.0f, "%.0f",
+                               ImGuiSliderFlags_Logarithmic)) {
+            // The unload distance keeps its margin
+            worldSettings.unloadDistance = worldSettings.loadDistance * 1.25f;
+            m_WorldPartition->SetSettings(worldSettings);
+        }
+        if (world.failedCount > 0) {
+            ImGui::TextDisabled("%u cells failed to load", world.failedCount);
         }
     }
 
     ImGui::Spacing();
 
-    // Exposure slider
-    ImGui::SliderFloat("Exposure", &m_Exposure, 0.1f, 5.0f);
+    // Exposure slider: compensation of the measured exposure with auto exposure
+    if (m_AutoExposure) {
+        ImGui::Checkbox("Auto Exposure", &m_EnableAutoExposure);
+    }
+    bool autoExposure = m_AutoExposure && m_EnableAutoExposure;
+    ImGui::SliderFloat(autoExposure ? "Exposure Compensation" : "Exposure", &m_Exposure, 0.1f, 5.0f);
+    if (autoExposure) {
+        ImGui::SliderFloat("Adaptation Rate", &m_ExposureAdaptationRate, 0.1f, 10.0f);
+    }
+    if (m_ToneMapper) {
+        static const char* toneMapOperators[] = { "Clamp", "ACES" };
+        int toneMapOperator = static_cast<int>(m_ToneMapOperator);
+        if (ImGui::Combo("Tone Mapping", &toneMapOperator, toneMapOperators, IM_ARRAYSIZE(toneMapOperators))) {
+            m_ToneMapOperator = static_cast<ToneMapOperator>(toneMapOperator);
+        }
+    } else {
+        ImGui::TextDisabled("Tone Mapping: in the lit shaders (no HDR target)");
+    }
+    if (m_Bloom) {
+        ImGui::Checkbox("Bloom", &m_EnableBloom);
+        if (m_EnableBloom) {
+            ImGui::SliderFloat("Bloom Strength", &m_BloomStrength, 0.0f, 0.3f);
+        }
+    }
+    if (m_TemporalAA) {
+        ImGui::Checkbox("Temporal AA", &m_EnableTemporalAA);
+        if (m_EnableTemporalAA) {
+            ImGui::SliderFloat("TAA Sharpness", &m_TemporalAASharpness, 0.0f, 1.0f);
+            if (ImGui::BeginCombo("Upscaling", UPSCALE_MODES[m_UpscaleMode].name)) {
+                for (uint32 mode = 0; mode < std::size(UPSCALE_MODES); ++mode) {
+                    if (ImGui::Selectable(UPSCALE_MODES[mode].name, mode == m_UpscaleMode)) {
+                        m_UpscaleMode = mode;
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            ImGui::Checkbox("Dynamic Resolution", &m_EnableDynamicResolution);
+            if (m_EnableDynamicResolution && !m_GpuProfiler) {
+                ImGui::TextDisabled("Dynamic resolution needs timestamp queries");
+            } else if (m_EnableDynamicResolution) {
+                DynamicResolution::Settings dynamicSettings = m_DynamicResolution.GetSettings();
+                if (ImGui::SliderFloat("Target GPU ms", &dynamicSettings.targetMs, 4.0f, 33.3f, "%.1f")) {
+                    m_DynamicResolution.SetSettings(dynamicSettings);
+                }
+                ImGui::Text("Render scale: %.0f%% (GPU %.2f ms)", m_RenderScale * 100.0f,
+                            m_DynamicResolution.GetSmoothedMs());
+            }
+        }
+    }
+    if (m_ToneMapper) {
+        ImGui::Checkbox("MSAA 4x (forward)", &m_EnableMSAA);
+        if (m_MSAASamples > 1 && m_EnableTemporalAA) {
+            ImGui::TextDisabled("Temporal AA is off while MSAA is on");
+        }
+    }
 
     ImGui::Spacing();
     ImGui::Separator();
@@ -1942,6 +5641,24 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
         ImGui::Text("Using simple ambient (3%%)");
     }
 
+    if (m_EnvironmentBaker && m_EnvironmentBaker->IsBaking()) {
+        ImGui::ProgressBar(m_EnvironmentBaker->GetProgress(), ImVec2(-1.0f, 0.0f), "Baking environment...");
+    } else if (m_EnvironmentBaker) {
+        ImGui::TextDisabled("Drop an .hdr file on the window to bake it");
+    }
+
+    ImGui::Spacing();
+    if (m_LightProbes) {
+        ImGui::Checkbox("Light Probes", &m_EnableLightProbes);
+        if (m_EnableLightProbes) {
+            ImGui::SliderInt("Probes per Frame", &m_LightProbesPerFrame, 1, 512);
+            glm::uvec3 counts = m_LightProbes->GetProbeCounts();
+            ImGui::Text("Grid: %u x %u x %u probes", counts.x, counts.y, counts.z);
+        }
+    } else {
+        ImGui::TextDisabled("Light probes need ray queries and bindless textures");
+    }
+
     ImGui::Spacing();
     ImGui::Text("Tip: Toggle to see the difference!");
 
@@ -1975,6 +5692,7 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
 
     // Ground plane toggle
     ImGui::Checkbox("Show Ground Plane", &m_ShowGroundPlane);
+    }
 
     // Shadow controls (only show when shadows are enabled)
     if (m_EnableShadows) {
@@ -2000,9 +5718,12 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
             "Depth & Factor",
             "Depth Color",
             "Shadow Grayscale",
-            "Depth vs Sample"
+            "Depth vs Sample",
+            "Cascades"
         };
-        if (ImGui::Combo("Debug Mode", &m_ShadowDebugMode, debugModes, 7)) {
+        if (!m_Renderer->SupportsFeature(RenderFeature::ShadowDebugViews)) {
+            ImGui::TextDisabled("Debug Mode: forward rendering only");
+        } else if (ImGui::Combo("Debug Mode", &m_ShadowDebugMode, debugModes, 8)) {
             m_VisualizeShadowMap = (m_ShadowDebugMode > 0);
         }
 
@@ -2018,12 +5739,95 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
             ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "  Grayscale shadow factor");
         } else if (m_ShadowDebugMode == 6) {
             ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "  R = depth, G = comparison result");
+        } else if (m_ShadowDebugMode == 7) {
+            ImGui::TextColored(ImVec4(1.0f, 1.0f, 0.0f, 1.0f), "  Red, green, blue, yellow = cascade 0-3");
         }
 
         ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Status: Active");
         if (m_ShadowMap) {
-            ImGui::Text("Shadow Map: %ux%u", m_ShadowMap->GetWidth(), m_ShadowMap->GetHeight());
-            ImGui::Text("Using PCF (3x3 kernel)");
+            // Cascade settings apply on the next frame's refit
+            int cascadeCount = static_cast<int>(m_ShadowMap->GetCascadeCount());
+            if (ImGui::SliderInt("Cascades", &cascadeCount, 1, static_cast<int>(ShadowMap::MAX_CASCADES))) {
+                m_ShadowMap->SetCascadeCount(static_cast<uint32>(cascadeCount));
+            }
+            float splitLambda = m_ShadowMap->GetSplitLambda();
+            if (ImGui::SliderFloat("Split Lambda", &splitLambda, 0.0f, 1.0f, "%.2f")) {
+                m_ShadowMap->SetSplitLambda(splitLambda);
+            }
+            float shadowDistance = m_ShadowMap->GetShadowDistance();
+            if (ImGui::SliderFloat("Shadow Distance", &shadowDistance, 5.0f, 200.0f, "%.0f")) {
+                m_ShadowMap->SetShadowDistance(shadowDistance);
+            }
+            ImGui::Text("Splits: %.1f / %.1f / %.1f / %.1f", m_ShadowMap->GetCascadeSplit(0), m_ShadowMap->GetCascadeSplit(1),
+                        m_ShadowMap->GetCascadeSplit(2), m_ShadowMap->GetCascadeSplit(3));
+            ImGui::Text("Shadow Map: %ux%u (%ux%u per cascade)", m_ShadowMap->GetWidth(), m_ShadowMap->GetHeight(),
+                        m_ShadowMap->GetWidth() / 2, m_ShadowMap->GetHeight() / 2);
+            bool shadowCaching = m_ShadowMap->IsCachingEnabled();
+            if (ImGui::Checkbox("Cache Shadow Map", &shadowCaching)) {
+                m_ShadowMap->SetCachingEnabled(shadowCaching);
+            }
+            ImGui::Text("Shadow pass: %s", m_Renderer->IsShadowMapCached() ? "skipped (cached)" : "rendered");
+
+            // Filtering tier; each one draws with its own model permutations
+            static const char* filterNames[] = { "Hardware 2x2", "PCF 3x3", "Poisson PCF", "PCSS", "EVSM" };
+            int filter = static_cast<int>(m_ShadowFilter);
+            if (ImGui::Combo("Shadow Filter", &filter, filterNames, IM_ARRAYSIZE(filterNames))) {
+                SetShadowFilter(static_cast<ShadowFilter>(filter));
+            }
+            if (m_ShadowFilter == ShadowFilter::Poisson || m_ShadowFilter == ShadowFilter::PCSS) {
+                ImGui::SliderFloat("Filter Radius (texels)", &m_ShadowFilterRadius, 0.5f, 4.0f, "%.1f");
+            }
+            if (m_ShadowFilter == ShadowFilter::PCSS) {
+                ImGui::SliderFloat("Light Radius (deg)", &m_ShadowLightRadius, 0.05f, 3.0f, "%.2f");
+            }
+            if (m_ShadowFilter == ShadowFilter::EVSM && m_ShadowMoments) {
+                if (ImGui::SliderInt("EVSM Blur Radius", &m_EVSMBlurRadius, 0, static_cast<int>(ShadowMoments::MAX_BLUR_RADIUS))) {
+                    m_ShadowMoments->SetBlurRadius(static_cast<uint32>(m_EVSMBlurRadius));
+                }
+                ImGui::SliderFloat("EVSM Bleed Reduction", &m_EVSMBleedReduction, 0.0f, 0.9f, "%.2f");
+            }
+            if (m_GpuProfiler) {
+                // Measured on this GPU while each filter was selected
+                ImGui::Text("Main pass GPU ms by filter:");
+                for (uint32 i = 0; i < SHADOW_FILTER_COUNT; ++i) {
+                    if (m_ShadowFilterGpuMs[i] > 0.0f) {
+                        ImGui::BulletText("%s: %.3f ms", filterNames[i], m_ShadowFilterGpuMs[i]);
+                    } else {
+                        ImGui::BulletText("%s: not measured", filterNames[i]);
+                    }
+                }
+            }
+        }
+
+        // Point and spot light shadows
+        if (m_ShadowAtlas) {
+            ImGui::Spacing();
+            ImGui::Checkbox("Local Light Shadows", &m_EnableShadowAtlas);
+            if (ImGui::SliderInt("Atlas Faces / Frame", &m_ShadowAtlasBudget, 1, 36)) {
+                m_ShadowAtlas->SetFaceBudget(static_cast<uint32>(m_ShadowAtlasBudget));
+            }
+            if (ImGui::SliderFloat("Atlas Quality", &m_ShadowAtlasQuality, 0.25f, 2.0f, "%.2f")) {
+                m_ShadowAtlas->SetQualityScale(m_ShadowAtlasQuality);
+            }
+            ImGui::Text("Atlas: %u lights, %u faces, %.0f%% used", m_ShadowAtlas->GetShadowedLightCount(),
+                        m_ShadowAtlas->GetFaceCount(), m_ShadowAtlas->GetOccupancy() * 100.0f);
+            ImGui::Text("Atlas faces rendered: %u, %u stale", m_Renderer->GetShadowAtlasFacesRendered(),
+                        m_ShadowAtlas->GetStaleFaceCount());
+        }
+
+        // Ray queries in place of both shadow maps, forward frames only
+        if (m_RayTracingScene && m_Renderer->SupportsFeature(RenderFeature::RayTracedShadows)) {
+            ImGui::Spacing();
+            ImGui::Checkbox("Ray-Traced Shadows", &m_EnableRayTracedShadows);
+            if (m_EnableRayTracedShadows) {
+                ImGui::SliderFloat("Key Light Radius (deg)", &m_ShadowLightRadius, 0.05f, 3.0f, "%.2f");
+                ImGui::SliderFloat("Local Light Radius", &m_RayTracedLightRadius, 0.0f, 0.5f, "%.2f");
+                const RayTracingScene::Stats& stats = m_RayTracingScene->GetStats();
+                ImGui::Text("Traced: %s, %u instances (last %s)", m_RayTracedShadowsActive ? "yes" : "waiting",
+                            stats.instances, stats.refit ? "refit" : "build");
+                ImGui::Text("BLAS: %u (%u compacted), %.1f MB; TLAS: %.1f MB", stats.bottomLevels, stats.compacted,
+                            stats.bottomLevelBytes / (1024.0 * 1024.0), stats.topLevelBytes / (1024.0 * 1024.0));
+            }
         }
 
         ImGui::Spacing();
@@ -2033,131 +5837,388 @@ void Application::RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> bac
         ImGui::Text("No shadow rendering");
     }
 
-    // Demo window toggle
     ImGui::Spacing();
     ImGui::Separator();
-    ImGui::Checkbox("Show Demo Window", &m_ShowDemoWindow);
-
-    ImGui::End();
-
-    // Show demo window if enabled
-    if (m_ShowDemoWindow) {
-        ImGui::ShowDemoWindow(&m_ShowDemoWindow);
+    ImGui::Text("Clustered Lighting");
+    ImGui::Separator();
+    ImGui::SliderInt("Test Point Lights", &m_ClusterTestLightCount, 0, 2048);
+    if (ImGui::IsItemDeactivatedAfterEdit()) {
+        UpdateClusterTestLights();
+    }
+    if (ImGui::Checkbox("Test Lights Cast Shadows", &m_ClusterTestLightShadows)) {
+        UpdateClusterTestLights();
+    }
+    ImGui::Text("Grid: %ux%ux%u clusters", LightClusters::GRID_X, LightClusters::GRID_Y, LightClusters::GRID_Z);
+    ImGui::Text("Local lights: %u visible of %zu", m_LightClusters->GetVisibleLightCount(),
+                m_Scene->GetGPULights().size() - m_Scene->GetDirectionalLightCount());
+    ImGui::Text("Light indices: %u, at most %u per cluster", m_LightClusters->GetIndexCount(),
+                m_LightClusters->GetMaxLightsPerCluster());
+
+    // Culling. GPU culling needs a pooled model and the compute shaders; the CPU frustum
+    // test covers every other case.
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("Culling");
+    ImGui::Separator();
+    bool gpuCullingActive = false;
+    if (m_GPUCuller) {
+        ImGui::Checkbox("GPU Culling", &m_EnableGPUCulling);
+        if (m_EnableGPUCulling) {
+            ImGui::Checkbox("Occlusion Culling (Hi-Z)", &m_EnableOcclusionCulling);
+            if (!m_GPUCuller->HasModel()) {
+                ImGui::TextDisabled("Current model is not pooled; using CPU culling");
+            }
+        }
+        gpuCullingActive = m_EnableGPUCulling && m_GPUCuller->HasModel() && IsSingleCopy();
+    }
+    if (!gpuCullingActive) {
+        ImGui::Checkbox("CPU Frustum Culling (BVH)", &m_EnableCPUCulling);
+        if (m_Model && m_Model->IsValid()) {
+            ImGui::Text("Camera: %u instances in %zu draws", m_Renderer->GetMainInstanceCount(),
+                        m_Renderer->GetMainDrawList().size());
+            ImGui::Text("Shadow: %u instances in %u draws", m_Renderer->GetShadowInstanceCount(),
+                        m_Renderer->GetShadowDrawCount());
+        }
+    }
+    ImGui::Checkbox("Levels of Detail", &m_EnableLods);
+    if (m_EnableLods) {
+        ImGui::SliderFloat("LOD Error (px)", &m_LodPixelThreshold, 0.25f, 8.0f, "%.2f");
+    }
+    if (m_Model && m_Model->IsValid()) {
+        ImGui::Text("Main pass: %u material binds for %zu draws", m_Renderer->GetMainMaterialChanges(), m_MainQueue.GetSize());
+    }
+    ImGui::Checkbox("Shader Permutations", &m_EnableShaderPermutations);
+    if (m_EnableShaderPermutations && !m_ModelPermutations.empty()) {
+        ImGui::Text("Material permutations: %zu", m_ModelPermutations.size());
+    }
+    // Bindless, pooled models only: the pulled vertex stages read the pool's buffer
+    ImGui::Checkbox("Vertex Pulling", &m_Config.vertexPulling);
+    if (m_Config.vertexPulling && (!m_PulledModelPipeline || !m_Model || !m_Model->GetGeometryPool())) {
+        ImGui::TextDisabled("Needs the pulled shaders and a pooled, bindless model");
+    }
+    {
+        // Applied at the start of the next frame (SetRenderMode())
+        static const char* renderModes[] = { "Forward", "Deferred", "Visibility buffer", "Path traced" };
+        static const RenderMode renderModeValues[] = { RenderMode::Rasterization, RenderMode::Deferred,
+                                                       RenderMode::VisibilityBuffer, RenderMode::PathTracing };
+        int renderMode = m_Config.renderMode == RenderMode::Deferred           ? 1
+                         : m_Config.renderMode == RenderMode::VisibilityBuffer ? 2
+                         : m_Config.renderMode == RenderMode::PathTracing      ? 3
+                                                                               : 0;
+        if (ImGui::Combo("Render Mode", &renderMode, renderModes, IM_ARRAYSIZE(renderModes))) {
+            m_Config.renderMode = renderModeValues[renderMode];
+        }
+        if ((m_Renderer->GetMode() == RenderMode::Deferred || m_Renderer->GetMode() == RenderMode::VisibilityBuffer) &&
+            !m_DeferredLighting) {
+            ImGui::TextDisabled("Deferred shaders unavailable; rendering forward");
+        } else if (m_Renderer->GetMode() == RenderMode::VisibilityBuffer && !m_VisibilityBufferActive) {
+            ImGui::TextDisabled("Visibility buffer unavailable for this model; drawing the G-buffer");
+        }
+        if (m_Renderer->GetMode() == RenderMode::PathTracing) {
+            if (!m_PathTracer) {
+                ImGui::TextDisabled("Path tracing unavailable; rendering forward");
+            } else if (!m_PathTracingActive) {
+                ImGui::TextDisabled("Model not in the bindless table and a geometry pool; rendering forward");
+            } else {
+                ImGui::Text("Samples: %u / %u (pass %.0f%%)", m_PathTracer->GetSampleCount(),
+                            m_PathTraceSettings.maxSamples, m_PathTracer->GetPassProgress() * 100.0f);
+                int tiles = static_cast<int>(m_PathTraceSettings.tilesPerFrame);
+                if (ImGui::SliderInt("Tiles per Frame", &tiles, 1, 64)) {
+                    m_PathTraceSettings.tilesPerFrame = static_cast<uint32>(tiles);
+                }
+                int bounces = static_cast<int>(m_PathTraceSettings.maxBounces);
+                if (ImGui::SliderInt("Max Bounces", &bounces, 0, 16)) {
+                    m_PathTraceSettings.maxBounces = static_cast<uint32>(bounces);
+                }
+                int samples = static_cast<int>(m_PathTraceSettings.maxSamples);
+                if (ImGui::SliderInt("Max Samples", &samples, 1, 4096)) {
+                    m_PathTraceSettings.maxSamples = static_cast<uint32>(samples);
+                }
+                if (m_Denoiser) {
+                    ImGui::Checkbox("Denoise", &m_EnableDenoiser);
+                    if (m_EnableDenoiser) {
+                        ImGui::SliderInt("Denoise Iterations", &m_DenoiseIterations, 1,
+                                         static_cast<int>(Denoiser::MAX_ITERATIONS));
+                    }
+                }
+            }
+        }
+        if (m_AmbientOcclusion && m_Renderer->SupportsFeature(RenderFeature::AmbientOcclusion)) {
+            ImGui::Checkbox("Ambient Occlusion", &m_EnableAmbientOcclusion);
+            if (m_EnableAmbientOcclusion) {
+                ImGui::SliderFloat("AO Radius", &m_AmbientOcclusionRadius, 0.1f, 5.0f, "%.2f");
+            }
+        }
+        if (m_Reflections && m_Renderer->SupportsFeature(RenderFeature::Reflections)) {
+            ImGui::Checkbox("Screen-Space Reflections", &m_EnableReflections);
+        }
+        if (m_ShadingRate && m_Renderer->SupportsFeature(RenderFeature::VariableRateShading)) {
+            ImGui::Checkbox("Variable Rate Shading", &m_EnableShadingRate);
+        }
+        if (m_OIT) {
+            static const char* transparencyModes[] = { "Sorted", "Weighted Blended OIT" };
+            int transparency = static_cast<int>(m_Transparency);
+            if (ImGui::Combo("Transparency", &transparency, transparencyModes, IM_ARRAYSIZE(transparencyModes))) {
+                m_Transparency = static_cast<TransparencyMode>(transparency);
+            }
+        }
+    }
+    {
+        static const char* prepassModes[] = { "Off", "On", "Auto" };
+        int prepassMode = static_cast<int>(m_DepthPrepassMode);
+        if (ImGui::Combo("Depth Prepass", &prepassMode, prepassModes, IM_ARRAYSIZE(prepassModes))) {
+            m_DepthPrepassMode = static_cast<DepthPrepassMode>(prepassMode);
+            RestartDepthPrepassProbe();
+        }
+        if (m_DepthPrepassMode == DepthPrepassMode::Auto) {
+            if (!m_GpuProfiler) {
+                ImGui::TextDisabled("Needs GPU timestamps; prepass off");
+            } else if (m_DepthPrepassProbeFrame < 2 * DEPTH_PREPASS_PROBE_FRAMES) {
+                ImGui::TextDisabled("Timing the main pass without and with it...");
+            } else if (m_DepthPrepassSamples[0] > 0 && m_DepthPrepassSamples[1] > 0) {
+                ImGui::Text("Main pass: %.3f ms without, %.3f ms with",
+                            m_DepthPrepassGpuMs[0] / m_DepthPrepassSamples[0],
+                            m_DepthPrepassGpuMs[1] / m_DepthPrepassSamples[1]);
+            }
+        }
+        if (m_Renderer->IsDepthPrepassDrawn()) {
+            ImGui::Text("Main pass: depth prepass drawn");
+        }
+    }
+    if (m_Device->GetDeviceInfo().supportsParallelRecording) {
+        ImGui::Checkbox("Parallel Command Recording", &m_EnableParallelRecording);
+        if (m_Renderer->GetMainRecorderCount() > 1) {
+            ImGui::Text("Main pass recorded on %u threads", m_Renderer->GetMainRecorderCount());
+        }
+    }
+    if (m_Device->GetDeviceInfo().supportsAsyncCompute) {
+        ImGui::Checkbox("Async Compute", &m_EnableAsyncCompute);
+    }
+    ImGui::Text("Redundant RHI calls filtered: %u", m_FilteredCallCount);
+
+    // Animation of the model (every grid copy moves alike)
+    if (m_Animator) {
+        const auto& clips = m_Model->GetAnimations();
+        if (!clips.empty()) {
+            std::string preview = m_AnimationClip < 0 ? "Bind pose" : clips[m_AnimationClip].name;
+            if (ImGui::BeginCombo("Animation", preview.c_str())) {
+                for (int clip = -1; clip < static_cast<int>(clips.size()); ++clip) {
+                    const char* name = clip < 0 ? "Bind pose" : clips[clip].name.c_str();
+                    if (ImGui::Selectable(name, clip == m_AnimationClip) && clip != m_AnimationClip) {
+                        m_AnimationClip = clip;
+                        m_Animator->Play(clip < 0 ? Animator::NO_CLIP : static_cast<uint32>(clip));
+                        ApplyAnimatedNodes(true);
+                    }
+                }
+                ImGui::EndCombo();
+            }
+            bool paused = m_Animator->IsPaused();
+            if (ImGui::Checkbox("Pause Animation", &paused)) {
+                m_Animator->SetPaused(paused);
+            }
+            float speed = m_Animator->GetSpeed();
+            if (ImGui::SliderFloat("Animation Speed", &speed, 0.0f, 2.0f, "%.2f")) {
+                m_Animator->SetSpeed(speed);
+            }
+        }
+        if (m_Skinning && m_Skinning->HasWork()) {
+            ImGui::Text("Skinning: %u vertices per frame", m_Skinning->GetVertexCount());
+        } else if (!m_Model->GetDeformedMeshes().empty()) {
+            ImGui::TextDisabled("Deformed meshes stay in their bind pose (no skinning shader)");
+        }
     }
 
-    // Render ImGui
-    ImGui::Render();
+    // Copies of the model on a grid, drawn instanced (GPU culling covers only the first)
+    if (const std::vector<glm::mat4>* instances = GetSceneInstances()) {
+        ImGui::Text("Scene instances: %zu", instances->size());
+    } else if (ImGui::SliderInt("Instance Grid", &m_InstanceGrid, 1, 32)) {
+        RebuildSceneInstances();
+    }
+    ImGui::Text("BVH: %u leaves, height %u", m_Scene->GetBVH().GetLeafCount(), m_Scene->GetBVH().GetHeight());
+    if (m_PickedMesh >= 0) {
+        ImGui::Text("Picked mesh %d at (%.2f, %.2f, %.2f)", m_PickedMesh,
+                    m_PickedPosition.x, m_PickedPosition.y, m_PickedPosition.z);
+    } else {
+        ImGui::TextDisabled("Right-click the model to pick a mesh");
+    }
 
-    // Check if there's anything to draw
-    ImDrawData* drawData = ImGui::GetDrawData();
-    if (!drawData || drawData->TotalVtxCount == 0) {
-        return;  // Nothing to draw
+    // What the backend was asked for last frame; steady uploads or render pass creation
+    // point at per-frame work that should have been cached
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("Frame Stats");
+    ImGui::Separator();
+    {
+        const rhi::FrameStats& stats = m_Device->GetFrameStats();
+        ImGui::Text("Draws: %u (%llu triangles)", stats.drawCalls, static_cast<unsigned long long>(stats.triangles));
+        ImGui::Text("Dispatches: %u", stats.dispatches);
+        ImGui::Text("Render passes: %u", stats.renderPasses);
+        ImGui::Text("Pipeline barriers: %u", stats.pipelineBarriers);
+        ImGui::Text("Pipeline binds: %u", stats.pipelineBinds);
+        ImGui::Text("Descriptor set binds: %u", stats.descriptorSetBinds);
+        ImGui::Text("Push constant calls: %u", stats.pushConstantCalls);
+        ImGui::Text("Filtered calls: %u", stats.filteredCalls);
+        ImGui::Text("Descriptor updates: %u", stats.descriptorUpdates);
+        ImGui::Text("Buffer uploads: %.1f KB", static_cast<double>(stats.bufferBytesUploaded) / 1024.0);
+        ImGui::Text("Texture uploads: %.1f KB", static_cast<double>(stats.textureBytesUploaded) / 1024.0);
+        ImGui::Text("Render passes created: %u", stats.renderPassesCreated);
+        ImGui::Text("Allocations: %u", stats.allocations);
+        ImGui::Text("Pipeline compiles: %u", stats.pipelineCompiles);
+        ImGui::Text("Upload waits: %u", stats.uploadWaits);
+        if (m_HitchDetector) {
+            ImGui::Text("Hitches: %u (%u written)", m_HitchDetector->GetHitchCount(), m_HitchDetector->GetDumpCount());
+            if (!m_HitchDetector->GetLastDump().empty()) {
+                ImGui::TextWrapped("Last: %s", m_HitchDetector->GetLastDump().c_str());
+            }
+        }
     }
 
-    // Backend-specific rendering
-    if (api == rhi::GraphicsAPI::Metal) {
-        // Metal: Render directly to the current render encoder
-        auto metalCmd = std::static_pointer_cast<rhi::MetalCommandBuffer>(cmd);
+    // Heap allocations of the last frame on every thread, by the scope that made them
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("CPU Allocations");
+    ImGui::Separator();
+    if (AllocationTracker::IsAvailable()) {
+        AllocationFrame allocations = AllocationTracker::GetLatestFrame();
+        ImGui::Text("Total: %llu (%.1f KB), %llu frees", static_cast<unsigned long long>(allocations.total.allocations),
+                    static_cast<double>(allocations.total.bytes) / 1024.0,
+                    static_cast<unsigned long long>(allocations.frees));
+        for (uint32 tag = 0; tag < ALLOCATION_TAG_COUNT; ++tag) {
+            ImGui::Text("%s: %llu (%.1f KB)", GetAllocationTagName(static_cast<AllocationTag>(tag)),
+                        static_cast<unsigned long long>(allocations.tags[tag].allocations),
+                        static_cast<double>(allocations.tags[tag].bytes) / 1024.0);
+        }
+    } else {
+        ImGui::TextDisabled("Not tracked (CMake option METAGFX_TRACK_ALLOCATIONS)");
+    }
 
-        static bool logged = false;
-        if (!logged) {
-            METAGFX_INFO << "ImGui Metal RenderDrawData: vertices=" << drawData->TotalVtxCount;
-            logged = true;
+    // Device memory of the backend's buffers and textures; the usage counts everything
+    // the driver holds for the process when it reports it (pipelines, swap chain, ...)
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("GPU Memory");
+    ImGui::Separator();
+    {
+        const double MB = 1024.0 * 1024.0;
+        rhi::MemoryStats memory = m_Device->GetMemoryStats();
+        for (uint32 category = 0; category < rhi::MemoryStats::CATEGORY_COUNT; ++category) {
+            ImGui::Text("%s: %.1f MB (%u)", rhi::GetMemoryCategoryName(static_cast<rhi::MemoryCategory>(category)),
+                        static_cast<double>(memory.bytes[category]) / MB, memory.resources[category]);
+        }
+        if (memory.budget.budgetBytes > 0) {
+            float used = static_cast<float>(static_cast<double>(memory.GetUsageBytes()) /
+                                            static_cast<double>(memory.budget.budgetBytes));
+            char overlay[64];
+            snprintf(overlay, sizeof(overlay), "%.0f of %.0f MB", static_cast<double>(memory.GetUsageBytes()) / MB,
+                     static_cast<double>(memory.budget.budgetBytes) / MB);
+            ImGui::ProgressBar(std::min(used, 1.0f), ImVec2(-1.0f, 0.0f), overlay);
+            if (memory.IsOverBudget()) {
+                ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Over budget: resources page out of device memory");
+            } else if (memory.IsOverBudget(m_Config.memoryWarningFraction)) {
+                ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Near budget");
+            }
+        } else {
+            ImGui::Text("Total: %.1f MB", static_cast<double>(memory.GetTotalBytes()) / MB);
+            ImGui::TextDisabled("No device memory budget reported");
         }
+        rhi::PipelineCacheStats pipelines = m_Device->GetPipelineCacheStats();
+        ImGui::Text("Pipelines: %u (%llu shared, %llu compiled)", pipelines.pipelines,
+                    static_cast<unsigned long long>(pipelines.hits),
+                    static_cast<unsigned long long>(pipelines.misses));
+    }
 
-        ImGui_ImplMetal_RenderDrawData(drawData,
-                                       metalCmd->GetHandle(),
-                                       metalCmd->GetRenderEncoder());
-        return;
+    // This frame's passes in recording order; the graph compiled before the UI is drawn
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("Render Graph");
+    ImGui::Separator();
+    const RenderGraph& renderGraph = m_Renderer->GetRenderGraph();
+    ImGui::Text("Passes: %u (%u culled)", renderGraph.GetPassCount(), renderGraph.GetCulledPassCount());
+    ImGui::Text("Barriers: %u (%u transitions)", renderGraph.GetBarrierCount(), renderGraph.GetTransitionCount());
+    ImGui::Text("Textures: %u in %u allocations (%u memoryless)", renderGraph.GetCreatedTextureCount(),
+                renderGraph.GetPooledTextureCount(), renderGraph.GetMemorylessTextureCount());
+    for (uint32 pass = 0; pass < renderGraph.GetPassCount(); ++pass) {
+        if (renderGraph.IsPassCulled(pass)) {
+            ImGui::TextDisabled("  %s (culled)", renderGraph.GetPassName(pass));
+        } else if (renderGraph.IsPassAsync(pass)) {
+            ImGui::Text("  %s (async compute)", renderGraph.GetPassName(pass));
+        } else {
+            ImGui::Text("  %s", renderGraph.GetPassName(pass));
+        }
     }
 
-    if (api != rhi::GraphicsAPI::Vulkan) {
-        return;
+    // CPU zones of the last frame per thread, from the METAGFX_PROFILE_* instrumentation
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("CPU Profiler");
+    ImGui::Separator();
+#ifdef METAGFX_PROFILER_ENABLED
+    RenderCpuProfiler();
+#else
+    ImGui::TextDisabled("Compiled out (METAGFX_ENABLE_PROFILER=OFF)");
+#endif
+
+    // GPU time per pass, from the latest frame whose timestamps came back
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("GPU Profiler");
+    ImGui::Separator();
+    if (m_GpuProfiler) {
+        const rhi::GpuProfiler::FrameTimings& timings = m_GpuProfiler->GetLatestFrame();
+        ImGui::Text("GPU frame: %.3f ms", timings.gpuTimeMs);
+        for (const rhi::GpuProfiler::Zone& zone : timings.zones) {
+            ImGui::Text("%*s%s: %.3f ms", static_cast<int>(zone.depth * 2), "", zone.name.c_str(), zone.durationMs);
+        }
+        if (ImGui::Button("Export Chrome Trace")) {
+            m_GpuProfiler->WriteChromeTrace("metagfx_gpu_trace.json");
+        }
+    } else {
+        ImGui::TextDisabled("Timestamp queries unsupported on this device");
     }
 
-    // Vulkan rendering
-    auto vkDevice = std::static_pointer_cast<rhi::VulkanDevice>(m_Device);
-    auto& context = vkDevice->GetContext();
-    auto swapChain = m_Device->GetSwapChain();
-    auto vkSwapChain = std::static_pointer_cast<rhi::VulkanSwapChain>(swapChain);
-    if (!vkSwapChain) {
-        return;
+    // Presentation. Mode changes recreate the swap chain at the start of the next frame.
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Text("Presentation");
+    ImGui::Separator();
+    const rhi::PresentMode presentModes[] = { rhi::PresentMode::Fifo, rhi::PresentMode::FifoRelaxed,
+                                              rhi::PresentMode::Mailbox, rhi::PresentMode::Immediate };
+    if (ImGui::BeginCombo("Present Mode", rhi::GetPresentModeName(m_Config.presentMode))) {
+        for (rhi::PresentMode mode : presentModes) {
+            if (ImGui::Selectable(rhi::GetPresentModeName(mode), mode == m_Config.presentMode)) {
+                m_PresentModeChanged = mode != m_Config.presentMode;
+                m_Config.presentMode = mode;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    rhi::PresentMode activeMode = m_Device->GetSwapChain()->GetPresentMode();
+    if (activeMode != m_Config.presentMode) {
+        ImGui::TextDisabled("Unsupported here; presenting with %s", rhi::GetPresentModeName(activeMode));
+    }
+    ImGui::Text("Frames in flight: %u", m_Device->GetDeviceInfo().framesInFlight);
+    if (m_Device->GetDeviceInfo().supportsPresentWait && !m_Config.pipelinedRendering) {
+        ImGui::Checkbox("Just-in-Time Input", &m_Config.justInTimeInput);
+    } else {
+        ImGui::TextDisabled("Just-in-time input needs present wait and the single-threaded loop");
     }
-    uint32_t imageIndex = vkSwapChain->GetCurrentImageIndex();
 
-    auto vkTexture = std::static_pointer_cast<rhi::VulkanTexture>(backBuffer);
-    if (!vkTexture) {
-        // METAGFX_INFO << "RenderImGui: vkTexture is null";
-        return;
+    // Demo window toggle
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Checkbox("Show Demo Window", &m_ShowDemoWindow);
+
+    ImGui::End();
+
+    // Show demo window if enabled
+    if (m_ShowDemoWindow) {
+        ImGui::ShowDemoWindow(&m_ShowDemoWindow);
     }
 
-    // Create framebuffer if needed (lazy creation)
-    // METAGFX_INFO << "RenderImGui: Checking framebuffer[" << imageIndex << "]";
-    if (m_ImGuiFramebuffers[imageIndex] == VK_NULL_HANDLE) {
-        // METAGFX_INFO << "RenderImGui: Creating framebuffer";
-        VkImageView attachments[] = { vkTexture->GetImageView() };
-
-        VkFramebufferCreateInfo framebufferInfo{};
-        framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-        framebufferInfo.renderPass = m_ImGuiRenderPass;
-        framebufferInfo.attachmentCount = 1;
-        framebufferInfo.pAttachments = attachments;
-        framebufferInfo.width = swapChain->GetWidth();
-        framebufferInfo.height = swapChain->GetHeight();
-        framebufferInfo.layers = 1;
-
-        vkCreateFramebuffer(context.device, &framebufferInfo, nullptr, &m_ImGuiFramebuffers[imageIndex]);
-        // METAGFX_INFO << "RenderImGui: Framebuffer created";
-    }
-
-    // Use the provided command buffer (already recording)
-    // METAGFX_INFO << "RenderImGui: Getting command buffer handle";
-    auto vkCmd = std::static_pointer_cast<rhi::VulkanCommandBuffer>(cmd);
-    VkCommandBuffer commandBuffer = vkCmd->GetHandle();
-
-    // Transition image from PRESENT_SRC_KHR to COLOR_ATTACHMENT_OPTIMAL for ImGui render pass
-    // METAGFX_INFO << "RenderImGui: Setting up image barrier";
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-    barrier.newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = vkTexture->GetImage();
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = 1;
-    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-    // METAGFX_INFO << "RenderImGui: Recording pipeline barrier";
-    vkCmdPipelineBarrier(commandBuffer,
-                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                         VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
-                         0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    // METAGFX_INFO << "RenderImGui: Setting up render pass";
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = m_ImGuiRenderPass;
-    renderPassInfo.framebuffer = m_ImGuiFramebuffers[imageIndex];
-    renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = {swapChain->GetWidth(), swapChain->GetHeight()};
-
-    // METAGFX_INFO << "RenderImGui: Beginning render pass";
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    // Record ImGui draw data
-    // METAGFX_INFO << "RenderImGui: Recording ImGui draw data";
-    ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), commandBuffer);
-
-    // METAGFX_INFO << "RenderImGui: Ending render pass";
-    vkCmdEndRenderPass(commandBuffer);
-
-    // METAGFX_INFO << "RenderImGui: EXIT";
-    // Note: Command buffer will be ended and submitted by Render() after this function returns
+    // Render ImGui
+    ImGui::Render();
+
+    m_ImGuiRenderer->Render(cmd, ImGui::GetDrawData(), m_CurrentFrame);
 }
 
 } // namespace metagfx
@@ -3,20 +3,45 @@
 // ============================================================================
 #pragma once
 
+#include "HitchDetector.h"
+#include "metagfx/core/StreamProtocol.h"
 #include "metagfx/core/Types.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GpuProfiler.h"
 #include "metagfx/rhi/Pipeline.h"
+#include "metagfx/rhi/PushConstantBlock.h"
+#include "metagfx/rhi/ReadbackPool.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/rhi/UniformRingBuffer.h"
+#include "metagfx/renderer/DynamicResolution.h"
+#include "metagfx/renderer/RasterizationRenderer.h"
+#include "metagfx/renderer/RenderQueue.h"
 #include "metagfx/scene/Camera.h"
+#include "metagfx/scene/InstanceBuffer.h"
+#include "metagfx/scene/LightClusters.h"
+#include "metagfx/scene/LodSelector.h"
+#include "metagfx/scene/TextureStreamer.h"
+#include "metagfx/scene/WorldPartition.h"
 #include "metagfx/scene/Model.h"
 #include "metagfx/scene/Scene.h"
+#include "metagfx/scene/SceneDescription.h"
+#include "metagfx/scene/ShadowAtlas.h"
+#include "metagfx/scene/ShadowMap.h"
+#include "metagfx/scene/ShadowMoments.h"
+#include "metagfx/utils/ShaderWatcher.h"
+#include "metagfx/utils/SphericalHarmonics.h"
+#include "metagfx/utils/TextureCache.h"
 #include <SDL3/SDL.h>
 #include <glm/glm.hpp>
-#ifdef METAGFX_USE_VULKAN
-#include <vulkan/vulkan.h>
-#endif
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace metagfx {
@@ -29,24 +54,219 @@ namespace rhi {
     class Texture;
     class Sampler;
     class DescriptorSet;
+    class AccelerationStructure;
 }
 
-class ShadowMap;
+class AmbientOcclusion;
+struct StartupEnvironment;
+class ScreenSpaceReflections;
+class ShadingRate;
+class Skinning;
+class StreamEncoder;
+class StreamServer;
+class AutoExposure;
+class Bloom;
+class TemporalAA;
+class DeferredLighting;
+class EnvironmentBaker;
+class GPUCuller;
+class ImGuiRenderer;
+class ObjectPicker;
+class RayTracingScene;
+class TransformBuffer;
+class VisibilityBuffer;
+class WeightedBlendedOIT;
+
+// Filtering of the key light's cascaded shadow map, cheapest first; per-pixel cost in
+// texture taps. Applied per pipeline: materials draw with permutations specialized for it.
+enum class ShadowFilter : uint32 {
+    Hardware,  // 1 bilinear comparison tap (2x2 hardware PCF)
+    PCF,       // 9 comparison taps on a 3x3 grid
+    Poisson,   // 16 comparison taps on a Poisson disc, rotated per pixel
+    PCSS,      // 16 depth taps of blocker search, then 16 Poisson taps over the penumbra
+    EVSM,      // 1 bilinear moment tap of a blurred exponential variance map, plus its build
+    Auto       // ApplicationConfig only: Hardware on integrated GPUs, PCF otherwise
+};
+constexpr uint32 SHADOW_FILTER_COUNT = static_cast<uint32>(ShadowFilter::Auto);
+
+// Whether the main pass draws the model's depth before its lit draws. Pays off with
+// overdraw, which the lit draws then no longer shade, at the cost of a second transform
+// of the model.
+enum class DepthPrepassMode : uint32 {
+    Off,
+    On,
+    Auto  // Per scene: both timed after the scene changes, the cheaper main pass kept
+};
+
+// Precision of the forward pass's color and BRDF math: model.frag, or its fp16 build
+// model_half.frag. Positions, depth, shadows and the light sums are fp32 in both.
+enum class ShadingPrecision : uint32 {
+    Full,
+    Half,  // Where DeviceInfo::supportsShaderFloat16, else Full
+    Auto   // Half on integrated GPUs, whose fp16 math runs at twice the rate; Full otherwise
+};
+
+// A scripted, fixed-length run on a hidden window (metagfx_bench): the camera orbits the
+// scene once over the measured frames, or follows the scene file's camera path, and the
+// frame-time percentiles go to a JSON file
+struct BenchmarkConfig {
+    bool enabled = false;
+    std::string modelPath;          // Empty: a unit cube; ApplicationConfig::scenePath replaces it
+    uint32 instanceGrid = 1;        // Copies of the model per side of the grid, unless the scene places them
+    uint32 warmupFrames = 60;       // Not measured; also waits out background pipeline compiles
+    uint32 frames = 600;
+    std::string outputPath = "metagfx_bench.json";
+    // Steady state allocates nothing: a measured frame with more heap allocations than
+    // this in Render() and its jobs (AllocationTag::Render) fails the run. Negative: not
+    // checked. Needs the CMake option METAGFX_TRACK_ALLOCATIONS.
+    int64 maxFrameAllocations = -1;
+};
+
+// Offscreen renders to image files for render farms (metagfx_bench --batch): the
+// benchmark's scene (scenePath, or modelPath and instanceGrid) on a hidden window, from
+// each view of viewsPath, each written to outputDirectory. Several frames stay in flight: a view's
+// image is read back while the next views render, and encoded and written on the job
+// system's workers.
+struct BatchConfig {
+    enum class ImageFormat : uint32 {
+        PNG,  // The tone-mapped back buffer, 8-bit sRGB
+        EXR   // The linear HDR scene color, half floats; needs tone mapping on
+    };
+
+    bool enabled = false;
+    // JSON: {"views": [{"name": "front", "position": [x, y, z], "target": [x, y, z],
+    // "fov": 45}, ...]}; names default to view_NNNN, targets to the scene's center and
+    // fields of view to 45 degrees. Empty: the scene file's camera path, or without one
+    // turntableViews views around the scene.
+    std::string viewsPath;
+    uint32 turntableViews = 36;
+    std::string outputDirectory = "metagfx_batch";
+    ImageFormat format = ImageFormat::PNG;
+    // Frames rendered per view, the last one captured; 0 picks them: enough for temporal
+    // AA to converge, and path traced views until the tracer has converged
+    uint32 settleFrames = 0;
+    uint32 warmupFrames = 8;     // Before the first view; also waits out pipeline compiles and loads
+    uint32 maxPendingWrites = 0; // Images read back but not yet written; 0: two per worker
+    // This run renders views shardIndex, shardIndex + shardCount, ... and leaves the rest
+    // to the other shards' runs: metagfx_bench --gpus starts one per GPU
+    uint32 shardIndex = 0;
+    uint32 shardCount = 1;
+};
+
+// Remote rendering (metagfx --stream): the device renders into offscreen back buffers on
+// a hidden window, each final frame, overlay included, is converted to NV12 on the GPU
+// and read back without a stall, then compressed by the hardware H.264 encoder where the
+// platform has one and the client decodes it (StreamEncoder), and StreamServer sends it
+// over TCP to one client (tools/stream_client), whose input returns as SDL events.
+// Latency and throughput go to the profiler's counters; the conversion is the "Stream
+// encode" GPU zone.
+struct StreamConfig {
+    bool enabled = false;
+    uint16 port = stream::DEFAULT_PORT;
+    uint32 maxQueuedFrames = 2;  // Read back but not sent yet; the oldest is dropped beyond this
+    uint32 bitrateKbps = 20000;  // Of H.264
+    bool rawNV12 = false;        // Send the NV12 planes uncompressed, even where H.264 is encoded
+};
 
 struct ApplicationConfig {
     std::string title = "MetaGFX";
     uint32 width = 1280;
     uint32 height = 720;
-    bool vsync = true;
+    rhi::PresentMode presentMode = rhi::PresentMode::Mailbox;  // Falls back to FIFO where unsupported
     rhi::GraphicsAPI graphicsAPI = rhi::GraphicsAPI::Vulkan;  // Default to Vulkan
+    // rhi::EnumerateAdapters() index of the GPU; the default picks the best one. Machines
+    // with several GPUs run one process per GPU, e.g. batch renders split between them.
+    uint32 adapterIndex = rhi::DEFAULT_ADAPTER;
+    std::string adapterName;  // Non-empty: the first GPU whose name contains it, over adapterIndex
+    uint64 textureCacheBudgetMB = 512;  // Unused cached textures are evicted beyond this
+    // Applied to every model load; KTX2/DDS textures stream their mips above 256 texels
+    ModelImportSettings modelImport{ .textureStreamingExtent = 256 };
+    uint64 textureStreamingBudgetMB = 0;  // Of streamed mips; 0: half of the device's free memory budget
+    // Loading of the scene file's cells (SceneDescription::cells) around the camera
+    WorldPartition::Settings worldPartition;
+    float memoryWarningFraction = 0.9f;   // Of the device memory budget; using more logs a warning
+    uint32 framesInFlight = 2;          // 1-3; fewer trades GPU/CPU overlap for input latency
+    ShadowFilter shadowFilter = ShadowFilter::Auto;  // Changeable at runtime (UI)
+    // 16-bit shadow map and atlas depth (DeviceInfo::supportsDepth16): half the memory and
+    // bandwidth of 32-bit, with coarser depth steps for the bias to cover
+    bool shadowDepth16 = false;
+    DepthPrepassMode depthPrepass = DepthPrepassMode::Auto;  // Changeable at runtime (UI)
+    ShadingPrecision shadingPrecision = ShadingPrecision::Auto;
+    // Pooled models fetch their vertices from the pool's storage buffer by vertex index
+    // (model_pulled.vert, shadowmap_pulled.vert) instead of through vertex input state,
+    // one pipeline for every vertex layout; changeable at runtime (UI)
+    bool vertexPulling = false;
+    RenderMode renderMode = RenderMode::Rasterization;  // Or Deferred, VisibilityBuffer, PathTracing; changeable at runtime (UI)
+    // Over 0, dynamic resolution holds the GPU frame time under this many milliseconds by
+    // drawing less of the render size (needs temporal AA and timestamp queries; UI)
+    float targetGpuFrameMs = 0.0f;
+    std::string pipelineCachePath = "metagfx_pipelines.cache";  // Compiled Vulkan pipelines across runs
+    // SceneDescription file: its model, instances, lights, environment and camera replace
+    // the defaults, and its camera path drives the benchmark and batch renders. The
+    // model streams in like any other; its instances appear once it is resident.
+    std::string scenePath;
+    // Non-empty: every RHI call is written to this trace (rhi::CreateCaptureDevice()) for
+    // tools/rhi_replay, for captureFrames presented frames (0: until the application exits)
+    std::string capturePath;
+    uint32 captureFrames = 0;
+
+    // Frame-time watchdog: frames that take much longer than the median write their
+    // surroundings (CPU and GPU traces, frame statistics, suspected causes) to
+    // hitchDetector.directory (HitchDetector). Not used by benchmark and batch runs.
+    bool hitchDetection = false;
+    HitchDetector::Settings hitchDetector;
+
+    // Just-in-time input: before polling events, wait until at most maxPendingPresents
+    // presented frames have yet to reach the display (DeviceInfo::supportsPresentWait).
+    // Not used by the pipelined loop, whose render thread presents.
+    bool justInTimeInput = false;
+    uint32 maxPendingPresents = 1;
+
+    // Event-driven rendering: a frame is drawn only after input, a camera move or while
+    // background work (model loads, pipeline compiles, environment bakes, texture
+    // streaming) runs, then idleRefineFrames more while temporal AA accumulates the still
+    // image; in between the loop sleeps in SDL_WaitEventTimeout, waking every idleWaitMs
+    // to check for background work. Not used by the pipelined loop.
+    bool onDemandRendering = false;
+    uint32 idleRefineFrames = 32;
+    uint32 idleWaitMs = 250;
+
+    // Simulate frame N+1 on the main thread while a render thread records frame N
+    bool pipelinedRendering = false;
+    uint32 maxQueuedFrames = 1;  // Frame packets the main thread may run ahead by
+
+    // Recompile the model, skybox and shadow shaders when their GLSL in
+    // shaderSourceDirectory changes, and rebuild the pipelines using them. Needs the GLSL
+    // compiler found when the build was configured.
+    bool shaderHotReload = false;
+#ifdef METAGFX_SHADER_SOURCE_DIR
+    std::string shaderSourceDirectory = METAGFX_SHADER_SOURCE_DIR;
+#else
+    std::string shaderSourceDirectory;
+#endif
+
+    // With benchmark.enabled the window stays hidden, the device renders into offscreen
+    // back buffers, the overlay is not drawn and RunBenchmark() replaces Run()
+    BenchmarkConfig benchmark;
+    // Likewise with batch.enabled, RunBatch() replacing Run(); the scene is benchmark's
+    BatchConfig batch;
+    // With stream.enabled the window stays hidden and the device renders offscreen, but
+    // Run() runs as usual, its frames and input going through the stream
+    StreamConfig stream;
 };
 
-class Application {
+class Application : private RasterizationContent {
 public:
     Application(const ApplicationConfig& config);
     ~Application();
 
     void Run();
+    // False when the device could not be created, the run was interrupted or the results
+    // could not be written
+    bool RunBenchmark();
+    // False when the device could not be created, the views could not be read, the run
+    // was interrupted or an image could not be written
+    bool RunBatch();
     void Shutdown();
 
 private:
@@ -55,38 +275,208 @@ private:
     void CreateModelPipeline();
     void CreateSkyboxPipeline();
     void CreateShadowPipeline();
-    void CreateSkyboxCube();
+    void CreateDepthPrepassPipeline();
+    void CreatePickPipelines();
+    void CreateMotionVectorPipelines();  // After CreateTemporalAA()
+    void CreateGBufferPipelines();
+    void UseSceneColorTarget(rhi::PipelineDesc& desc) const;  // HDR scene color when tone mapped
+    void CreatePipelineAsync(const rhi::PipelineDesc& desc, Ref<rhi::Pipeline>& target, const char* name);
+    void CreatePipeline(const rhi::PipelineDesc& desc, Ref<rhi::Pipeline>& target, const char* name);
+    void UseReloadedShader(const char* name, std::vector<uint8>& code) const;
+    void UpdateShaderReload();
+    void CollectPendingPipelines();
+    void CreateGPUCuller();
+    void CreateShadowMoments();
+    void CreateDeferredLighting();
+    void CreateVisibilityBuffer();  // With its pipelines; after CreateDeferredLighting()
+    void CreateAmbientOcclusion();
+    void CreateScreenSpaceReflections();
+    void CreateShadingRate();
+    void CreateWeightedBlendedOIT();
+    void CreateSkinning();
+    void CreatePathTracer();
+    void CreateLightProbes();
+    void CreateToneMapper();
+    void CreateAutoExposure();
+    void CreateBloom();
+    void CreateTemporalAA();
+    void CreateEnvironmentBaker();
+    void CreateStreaming();  // With StreamConfig::enabled
+    void SetRenderMode(RenderMode mode);  // Rasterization, Deferred, VisibilityBuffer or PathTracing; recreates the renderer
+    void UpdateMSAA();  // After SetRenderMode(); rebuilds the main pass pipelines for a new sample count
+    void SetShadowFilter(ShadowFilter filter);  // Auto and unavailable filters fall back
     void CreateTestLights();
+    void UpdateClusterTestLights();
     void CreateGroundPlane();
     void UpdateGroundPlanePosition();
     void LoadModel(const std::string& path);
+    void RequestModelLoad(const std::string& path);
+    void UpdateModelLoad();
+    void UpdateWorldCells();   // Streams the scene file's cells; their nodes and sets follow
+    void AssignCellNodes();    // After the resident cells or the scene graph changed
+    void CreateCellMaterialSets();
+    void PrepareCellDraws(const glm::mat4& viewProjection);
+    void SetModel(std::unique_ptr<Model> model);
+    void RequestEnvironmentLoad(const std::string& path);
+    void UpdateEnvironmentBake();
+    void UpdateStartupEnvironment();
+    void RecordStartupTimes();  // After each present until the startup loads are resident
+    Ref<rhi::Buffer> CreateIrradianceSHBuffer(const utils::IrradianceSH& irradianceSH);
+    void SetEnvironmentMaps(Ref<rhi::Texture> environment, const utils::IrradianceSH& irradianceSH,
+                            Ref<rhi::Texture> prefiltered, Ref<rhi::Texture> brdfLut);
+    void RebuildSceneInstances();
+    void RestartDepthPrepassProbe();
+    void ApplyAnimatedNodes(bool allNodes);
+    float GetInstanceGridSpacing() const;
+    void LoadBenchmarkScene();
+    bool ReadSceneFile(const std::string& path);
+    void ApplySceneLights(const SceneDescription& description);
+    // The scene file's instance transforms while its model is the one shown; null otherwise
+    const std::vector<glm::mat4>* GetSceneInstances() const;
+    // The model's bounds as the scene file places it, or the model's own
+    bool GetPlacedBounds(glm::vec3& outMin, glm::vec3& outMax) const;
+    // The model is placed once, at the identity: its nodes are the scene graph's first
+    bool IsSingleCopy() const { return m_ModelNodeBases.size() <= 1 && (m_ModelNodeBases.empty() || m_ModelNodeBases[0] == 0); }
+    // The scene's model or environment is still loading (headless runs wait for both)
+    bool IsSceneLoading() const;
+    bool IsSceneModelShown() const;  // No scene file model, or it has loaded
+    // The scene file's camera path at t in [0, 1), a closed loop through its keys; targets
+    // default to center
+    SceneDescription::CameraKey GetCameraPathKey(float t, const glm::vec3& center) const;
+    bool IsHeadless() const { return m_Config.benchmark.enabled || m_Config.batch.enabled; }
+    // No window is shown: headless runs, and streamed ones
+    bool IsOffscreen() const { return IsHeadless() || m_Config.stream.enabled; }
+    // Middle of the instance grid, and an orbit radius that keeps all of it in view
+    void GetSceneOrbit(glm::vec3& outTarget, float& outRadius) const;
+    // One material set (set 2) per material of the current model, built at load time so
+    // the render loop only binds (no per-mesh descriptor updates). With push descriptors
+    // set 2 is a push set: the bindings are kept instead, and pushed with each material change.
+    struct MaterialSet {
+        Ref<rhi::DescriptorSet> set;  // Only a layout when pushed; per material then null
+        std::vector<rhi::DescriptorBindingDesc> bindings;
+    };
+    void CreateMaterialDescriptorSets();
+    void ReleaseMaterialDescriptorSets();
+    // Binds or pushes material set 2, with its slice of the uniform ring
+    void BindMaterialSet(rhi::CommandBuffer& cmd, const Ref<rhi::Pipeline>& pipeline,
+                         const MaterialSet& materialSet, uint32 materialOffset) const;
+    // Points binding 22 of the main, ground plane and material sets at the scene's top level
+    void BindSceneTopLevel(const Ref<rhi::AccelerationStructure>& topLevel);
+    void RefreshMaterialBindings();
+    void CreateBindlessDescriptorSet();
+    bool BuildBindlessMaterialTable();
     void LoadNextModel();
     void LoadPreviousModel();
-    void ProcessEvents();
+    bool ProcessEvents();  // True if any event arrived
+    bool HasBackgroundWork() const;  // Work that finishes over frames without input
+    void HandleRenderEvent(const SDL_Event& event);
+    void RunPipelined();
+    void RenderThreadMain();
+    void PickAt(float x, float y);
+    void UpdatePick();  // After BeginFrame(): takes a pick the GPU has resolved
     void Update(float deltaTime);
     void Render();
+    void CheckMemoryBudget();
+    uint32 GetModelFeatures(const Material& material) const;
+    uint32 SelectModelPipeline(const Material& material);
+    uint32 SelectTransparentPipeline(const Material& material, TransparencyMode transparency);
+    Ref<rhi::Pipeline> RequestModelPermutation(uint32 variant, uint32 features, uint32 transparency = 0);
+    void RecordQueuedDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList, size_t firstPacket,
+                           size_t endPacket, const std::vector<Ref<rhi::Pipeline>>& pipelines,
+                           uint32& materialChanges) const;
+
+    // RasterizationContent: the model's materials, ground plane, skybox and ImGui
+    size_t QueueModelDraws(const std::vector<DrawBatch>& drawList, bool gpuCulling,
+                           TransparencyMode transparency) override;
+    size_t GetTransparentPacketCount() const override { return m_TransparentPacketCount; }
+    void RecordModelDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                          size_t firstPacket, size_t endPacket, uint32& materialChanges) const override;
+    void RecordVisibilityDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                               size_t packetCount) const override;
+    void RecordSceneryDraws(rhi::CommandBuffer& cmd) override;
+    void RecordTransparentDraws(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                TransparentTarget target) const override;
+    void RecordOverlay(rhi::CommandBuffer& cmd) override;
 
     // ImGui
     void InitImGui();
     void ShutdownImGui();
-    void RenderImGui(Ref<rhi::CommandBuffer> cmd, Ref<rhi::Texture> backBuffer);
+    void RenderImGui(rhi::CommandBuffer& cmd);
+    void RenderCpuProfiler();
 
     ApplicationConfig m_Config;
     SDL_Window* m_Window = nullptr;
     bool m_Running = false;
+    // Startup times from the start of Init(), in the benchmark results; negative until reached
+    std::chrono::steady_clock::time_point m_InitStartTime;
+    double m_TimeToFirstFrameMs = -1.0;
+    double m_TimeToResidentMs = -1.0;
+
+    // Pipelined mode: what the render thread needs from one simulated frame. Events that
+    // reach render-owned state (ImGui, model keys, picking, resize) are handled there.
+    struct ForwardedEvent {
+        SDL_Event event;
+        std::string text;  // Copy of the text of text input and drop events, which SDL reclaims
+    };
+    struct FramePacket {
+        Camera camera;
+        std::vector<ForwardedEvent> events;
+    };
+    std::vector<ForwardedEvent> m_ForwardedEvents;  // Of the frame being simulated
+    std::deque<FramePacket> m_FramePackets;         // Bounded by m_Config.maxQueuedFrames
+    std::mutex m_FramePacketMutex;
+    std::condition_variable m_FramePacketPushed;
+    std::condition_variable m_FramePacketPopped;
+    bool m_FramePacketsClosed = false;  // No more packets: the render thread exits
     
     // Graphics resources
     Ref<rhi::GraphicsDevice> m_Device;
     Ref<rhi::Buffer> m_VertexBuffer;
     Ref<rhi::Pipeline> m_Pipeline;
     Ref<rhi::Pipeline> m_ModelPipeline;
+    Ref<rhi::Pipeline> m_CompactModelPipeline;  // VertexFormat::Compact models (null without its shader)
+    // Whether those two and their permutations run model_half.frag
+    // (ApplicationConfig::shadingPrecision, resolved)
+    bool m_HalfPrecisionShading = false;
+    // The model's materials into the deferred G-buffer (null without gbuffer.frag)
+    Ref<rhi::Pipeline> m_GBufferPipeline;
+    Ref<rhi::Pipeline> m_CompactGBufferPipeline;
+    // The triangle ids of the visibility buffer's pass, bindless (null without its shaders)
+    Ref<rhi::Pipeline> m_VisibilityPipeline;
+    Ref<rhi::Pipeline> m_CompactVisibilityPipeline;
     Ref<rhi::Pipeline> m_SkyboxPipeline;  // Pipeline for skybox rendering
     Ref<rhi::Pipeline> m_ShadowPipeline;  // Pipeline for shadow map rendering
-    Ref<rhi::Buffer> m_SkyboxVertexBuffer;  // Cube vertices for skybox
-    Ref<rhi::Buffer> m_SkyboxIndexBuffer;   // Cube indices for skybox
+    Ref<rhi::Pipeline> m_CompactShadowPipeline;  // Shadow pipeline for VertexFormat::Compact models
+    Ref<rhi::Pipeline> m_ShadowPositionPipeline;         // Shadow pipelines reading Mesh::GetPositionBuffer()
+    Ref<rhi::Pipeline> m_CompactShadowPositionPipeline;
+    Ref<rhi::Pipeline> m_ShadowClearPipeline;  // Writes the far plane over a shadow atlas tile
+    Ref<rhi::Pipeline> m_PulledShadowPipeline;  // Either vertex layout of a pooled model (vertex pulling)
+    RasterizationRenderer::DepthOnlyPipelines m_DepthPrepassPipelines;  // Null without depth_prepass.vert
+    RasterizationRenderer::DepthOnlyPipelines m_MotionVectorPipelines;  // Null without temporal AA
+    RasterizationRenderer::DepthOnlyPipelines m_PickPipelines;          // Null without the pick shaders
 
-    // Camera
+    // Pipelines compiling in the background (bindless and position-stream variants,
+    // skybox). Each lands in its member once ready; until then draws use a fallback or,
+    // for the skybox, are skipped.
+    struct PendingPipeline {
+        Ref<rhi::PipelineFuture> future;
+        Ref<rhi::Pipeline>* target;
+        const char* name;
+    };
+    std::vector<PendingPipeline> m_PendingPipelines;
+
+    // Shader hot reload: SPIR-V of the sources recompiled since startup, by file name,
+    // used instead of the embedded code when pipelines are created
+    std::unique_ptr<utils::ShaderWatcher> m_ShaderWatcher;
+    std::unordered_map<std::string, std::vector<uint8>> m_ReloadedShaders;
+    bool m_ReloadingShaders = false;  // Pipelines being created replace running ones
+
+    // Camera. The main thread moves m_Camera; Render() draws from m_FrameCamera, its
+    // copy taken when the frame was simulated.
     std::unique_ptr<Camera> m_Camera;
+    std::unique_ptr<Camera> m_FrameCamera;
+    std::mutex m_CameraMutex;  // Held by the main thread while it moves m_Camera in pipelined mode
+    uint32 m_StillFrames = 0;  // On demand: frames drawn since the last change
     bool m_FirstMouse = true;
     float m_LastX = 640.0f;
     float m_LastY = 360.0f;
@@ -94,21 +484,154 @@ private:
     bool m_MouseButtonPressed = false;  // Track mouse button state for click-and-drag
     
     // Uniform buffers
+    // Binding 0 of the main sets, pushed once per frame. The model fragment shaders
+    // also read the frame constants after the matrices.
     struct UniformBufferObject {
         glm::mat4 model;
         glm::mat4 view;
         glm::mat4 projection;
+        glm::mat4 viewProjection;         // projection * view
+        glm::mat4 normalMatrix;           // Inverse transpose of mat3(model)
+        glm::mat4 inverseSkyViewProjection;  // Inverse of projection * mat3(view): clip to sky direction
+        glm::vec4 cameraPosition;
+        float exposure;
+        uint32 enableIBL;
+        float iblIntensity;
+        uint32 shadowDebugMode;  // 0=normal, 1=shadow factor, 2=depth coords, ...
+        uint32 enableShadows;
+        uint32 clusterBase;               // LightClusterParams
+        glm::vec2 clusterTileScale;
+        glm::vec2 clusterDepthScaleBias;
+        uint32 lightBase;                 // Scene::GetLightBufferBase()
+        uint32 directionalLightCount;
+        uint32 shadowAtlasBase;           // ShadowAtlas::Upload()
+        uint32 shadowFilter;              // ShadowFilter of the uber pipelines
+        uint32 vertexFormat;              // VertexFormat of the pulled vertices (model_pulled.vert)
+    };
+
+    // Binding 13 of the main sets: the cascades model.frag picks from (std140)
+    struct ShadowUniforms {
+        glm::mat4 cascadeMatrices[ShadowMap::MAX_CASCADES];
+        glm::vec4 cascadeRects[ShadowMap::MAX_CASCADES];  // Tile of each cascade in the shadow map
+        float cascadeSplits[ShadowMap::MAX_CASCADES];     // View depth where each cascade ends
+        float cascadePenumbraScales[ShadowMap::MAX_CASCADES];  // ShadowMap::GetCascadePenumbraScale()
+        float shadowBias;
+        uint32 cascadeCount;
+        float filterRadius;                               // Poisson disc radius in texels
+        float evsmBleedReduction;                         // EVSM light bleeding cut-off, 0 to 1
+        float lightAngularRadius;                         // Ray-traced: key light's angular radius in radians
+        float lightSourceRadius;                          // Ray-traced: point and spot light radius
+        uint32 noiseFrame;                                // Ray-traced: sampling noise phase
+        float padding;
+    };
+
+    // push_constant block of model.frag and model_bindless.frag: what changes per material
+    struct ModelPushConstants {
+        uint32 materialFlags = 0;  // MaterialTextureFlags
+        uint32 materialIndex = 0;  // Bindless material table entry
     };
+
+    // Model state of the main pass, shared by the threads recording it
+    struct ModelPass {
+        Ref<rhi::Pipeline> pipeline;  // Uber pipeline, which draws any material
+        uint32 variant = 0;           // ModelVariant of pipeline
+        bool permutations = false;    // Materials draw with their feature permutation when compiled
+        bool bindless = false;
+        bool gpuCulling = false;
+        uint32 mvpOffset = 0;
+        uint32 sceneryMvpOffset = 0;  // Plain model matrix, for the ground plane and skybox
+        glm::mat4 modelMatrix = glm::mat4(1.0f);
+    };
+    ModelPass m_ModelPass;  // Of the frame being recorded
+
+    // Model shader permutations: model.frag and model_bindless.frag specialized for one
+    // ModelFeatures mask (constant_id 0 and 1), so a material runs without the branches
+    // of features it lacks. A permutation is compiled in the background the first time a
+    // material needs it; until then, and while a shadow debug view is shown, the uber
+    // pipeline of the variant draws.
+    enum ModelFeatures : uint32 {
+        ModelFeatureTextures = 0x7F,  // MaterialTextureFlags
+        ModelFeatureIBL = 1u << 7,
+        ModelFeatureShadows = 1u << 8,
+        ModelFeatureShadowFilter = 7u << 9,  // ShadowFilter, with shadows only
+        ModelFeatureAlphaMask = 1u << 12     // AlphaMode::Mask
+    };
+    static constexpr uint32 MODEL_FEATURE_SHADOW_FILTER_SHIFT = 9;
+    static constexpr uint32 MODEL_FEATURES_UBER = 0xFFFF;  // Not specialized: the material flags decide
+    // Output of a model pipeline (constant_id 3, TRANSPARENCY): blended materials draw
+    // with depth writes off, alpha blended or into the weighted blended targets
+    enum ModelTransparency : uint32 {
+        ModelTransparencyOpaque,
+        ModelTransparencyBlend,
+        ModelTransparencyAccumulate,  // WeightedBlendedOIT::ACCUMULATION_FORMAT, additive
+        ModelTransparencyRevealage    // WeightedBlendedOIT::REVEALAGE_FORMAT, alpha only
+    };
+    enum ModelVariant : uint32 {
+        ModelVariantFloat,
+        ModelVariantCompact,
+        ModelVariantBindless,
+        ModelVariantBindlessCompact,
+        ModelVariantPulled,            // Bindless, model_pulled.vert: either vertex layout of a pooled model
+        ModelVariantRayTraced,         // model_raytraced.frag, with per-material sets
+        ModelVariantRayTracedCompact,
+        ModelVariantCount
+    };
+    rhi::PipelineDesc m_ModelVariantDescs[ModelVariantCount];  // Uber descs; no fragment shader = unavailable
+    // transparency << 24 | variant << 16 | features; null while compiling
+    std::unordered_map<uint32, Ref<rhi::Pipeline>> m_ModelPermutations;
+    bool m_EnableShaderPermutations = true;
     
-    Ref<rhi::Buffer> m_UniformBuffers[2];  // Double buffering for MVP
-    Ref<rhi::Buffer> m_MaterialBuffers[2];  // Double buffering for material
-    Ref<rhi::Buffer> m_GroundPlaneMaterialBuffer;  // Dedicated material buffer for ground plane
-    Ref<rhi::Buffer> m_ShadowUniformBuffer;  // Shadow UBO (light space matrix + bias)
+    std::unique_ptr<rhi::UniformRingBuffer> m_UniformRing;  // Per-frame MVP + per-draw material slices
+    Ref<rhi::Buffer> m_ShadowUniformBuffer;  // ShadowUniforms
+    // The model pipelines' sets by update frequency (model.frag): per frame, per pass (shadows)
+    // and, in m_MaterialDescriptorSets, per material
     Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::DescriptorSet> m_PassDescriptorSet;
     Ref<rhi::DescriptorSet> m_SkyboxDescriptorSet;  // Separate descriptor set for skybox
     Ref<rhi::DescriptorSet> m_ShadowDescriptorSet;  // Descriptor set for shadow pass
-    Ref<rhi::DescriptorSet> m_GroundPlaneDescriptorSet;  // Separate descriptor set for ground plane
-    uint32 m_CurrentFrame = 0;
+    Ref<rhi::DescriptorSet> m_DepthPrepassDescriptorSet;  // Like the shadow set, with the camera at binding 0
+    Ref<rhi::DescriptorSet> m_MotionVectorDescriptorSet;  // The prepass set, with the last frame's transforms
+    // Every binding of the three sets, for the passes that read them as one set (deferred
+    // lighting, path tracing, probes) and as the template of the material sets
+    std::vector<rhi::DescriptorBindingDesc> m_MainBindings;
+
+    // Material sets (MaterialSet), one per material of the current model
+    std::unordered_map<const Material*, MaterialSet> m_MaterialDescriptorSets;
+    MaterialSet m_DefaultMaterialSet;  // Default textures, of meshes without a material; set 2's layout
+    MaterialSet m_GroundPlaneMaterialSet;  // The ground plane's material set
+    MaterialSet CreateMaterialSet(const Material& material);
+    bool m_PushMaterialDescriptors = false;  // Set 2 is pushed (DeviceInfo::supportsPushDescriptors)
+    uint32 m_CurrentFrame = 0;  // FrameContext::frameIndex of the frame being recorded
+
+    // Bindless materials (Vulkan with descriptor indexing): all textures of the model live in
+    // one table, material parameters in a storage buffer, and each draw only pushes its index
+    static constexpr uint32 BINDLESS_TEXTURE_CAPACITY = 1024;  // Must match model_bindless.frag
+
+    // std430 layout of BindlessMaterial in model_bindless.frag (64 bytes)
+    struct BindlessMaterialData {
+        glm::vec3 albedo;
+        float roughness;
+        glm::vec3 emissiveFactor;
+        float metallic;
+        uint32 albedoIndex;
+        uint32 normalIndex;
+        uint32 metallicIndex;
+        uint32 roughnessIndex;
+        uint32 aoIndex;
+        uint32 emissiveIndex;
+        uint32 textureFlags;  // Material::GetTextureFlags(), for the path tracer
+        uint32 alphaParams;   // packHalf2x16(alpha, alphaCutoff)
+    };
+
+    bool m_BindlessSupported = false;  // Device + shader support, decided at init
+    bool m_BindlessActive = false;     // Current model fits the table
+    Ref<rhi::Pipeline> m_BindlessModelPipeline;
+    Ref<rhi::Pipeline> m_BindlessCompactModelPipeline;
+    Ref<rhi::Pipeline> m_PulledModelPipeline;  // Null without model_pulled.vert
+    Ref<rhi::DescriptorSet> m_BindlessDescriptorSet;
+    Ref<rhi::Buffer> m_BindlessMaterialBuffer;
+    uint32 m_BindlessTextureCount = 0;  // Table elements written for the current model
+    std::unordered_map<const Material*, uint32> m_BindlessMaterialIndices;
 
     // Texture resources
     Ref<rhi::Sampler> m_LinearRepeatSampler;
@@ -116,49 +639,260 @@ private:
     Ref<rhi::Texture> m_DefaultNormalMap;  // Flat normal map (128,128,255)
     Ref<rhi::Texture> m_DefaultWhiteTexture;  // White 1x1 for metallic/roughness/AO
     Ref<rhi::Texture> m_DefaultBlackTexture;  // Black 1x1 for emissive (no emission)
-    Ref<rhi::Texture> m_DepthBuffer;  // Depth buffer for 3D rendering
 
     // IBL (Image-Based Lighting) resources
     Ref<rhi::Sampler> m_CubemapSampler;  // Linear filtering for cubemaps
-    Ref<rhi::Texture> m_IrradianceMap;   // Diffuse irradiance cubemap
+    Ref<rhi::Buffer> m_IrradianceSHBuffer;  // utils::IrradianceSH, diffuse irradiance
+    Ref<rhi::Buffer> m_LightProbeBuffer;    // LightProbeVolume's, zeroed without one
     Ref<rhi::Texture> m_PrefilteredMap;  // Specular prefiltered cubemap
     Ref<rhi::Texture> m_BRDF_LUT;        // BRDF integration lookup table
     Ref<rhi::Texture> m_EnvironmentMap;  // Full-resolution environment map for skybox
+    Ref<rhi::Texture> m_DefaultBlackCubemap;  // 1x1, until the maps above are loaded
+    // The precomputed maps read on the job system during Init(); null once applied
+    std::unique_ptr<StartupEnvironment> m_StartupEnvironment;
+    // Bakes the maps above from a dropped HDR; null without its shader
+    std::unique_ptr<EnvironmentBaker> m_EnvironmentBaker;
+    std::string m_PendingEnvironmentPath;  // HDR to load and bake at the start of the next frame
 
     // Scene and model
     std::unique_ptr<Scene> m_Scene;
-    std::unique_ptr<Model> m_Model;
+    Model* m_Model = nullptr;  // The scene's (Scene::GetModel())
+    std::unique_ptr<utils::TextureCache> m_TextureCache;  // Shared by all model loads
+    std::unique_ptr<TextureStreamer> m_TextureStreamer;   // Larger mips of the model's textures
     std::unique_ptr<Model> m_GroundPlane;  // Ground plane to visualize shadows
 
+    // World partition: the scene file's cells load and unload around the camera and are
+    // drawn with the scenery, mesh by mesh, through per-material sets. Each resident
+    // cell's model nodes take scene graph nodes past the scene's own, flattened to their
+    // world matrices; the nodes are reused as cells come and go, as the graph only grows.
+    std::unique_ptr<WorldPartition> m_WorldPartition;  // Null without cells
+    uint32 m_CellNodeBase = 0;           // First scene graph node of the cells
+    uint32 m_CellNodeCount = 0;          // Added for them since the graph was rebuilt
+    std::vector<uint32> m_CellNodeBases; // Per cell, scene graph node of its model node 0; resident cells only
+    std::unordered_map<const Material*, MaterialSet> m_CellMaterialSets;
+    struct CellDraw {
+        const Mesh* mesh = nullptr;
+        uint32 node = 0;
+        const MaterialSet* materialSet = nullptr;
+        uint32 materialOffset = 0;       // This frame's uniform ring slice
+        uint32 materialFlags = 0;
+    };
+    std::vector<CellDraw> m_CellDraws;   // This frame's, of the meshes in view
+    bool m_ShowWorldCells = true;        // UI; they stream either way
+
+    // Node world matrices of the scene graph, read by the vertex shaders through the
+    // instance buffer. Model node i is scene graph node i; the ground plane follows.
+    std::unique_ptr<TransformBuffer> m_TransformBuffer;
+    uint32 m_GroundNode = 0;
+    std::vector<uint32> m_ModelNodeBases;  // Scene graph node of model node 0, per grid copy or scene instance
+
+    // Animation of the model: the nodes its clip drives move in every grid copy, and
+    // m_Skinning poses its deformed meshes in the pool, which the copies share
+    std::unique_ptr<Animator> m_Animator;    // Null unless the model has clips or deformed meshes
+    std::unique_ptr<Skinning> m_Skinning;    // Null without its shader
+    int m_AnimationClip = 0;                 // UI; -1 = bind pose
+
+    // Instanced drawing: the model is placed m_InstanceGrid x m_InstanceGrid times, and
+    // draws of the same mesh are merged into one batch whose nodes the instance buffer holds
+    std::unique_ptr<InstanceBuffer> m_InstanceBuffer;
+    int m_InstanceGrid = 1;
+
+    // Clustered forward lighting: the point and spot lights each view froxel shades,
+    // binned per frame for the frame camera
+    std::unique_ptr<LightClusters> m_LightClusters;
+    int m_ClusterTestLightCount = 0;           // Random point lights around the model (UI)
+    std::vector<Scene::LightHandle> m_ClusterTestLights;
+
     // Shadow mapping
     std::unique_ptr<ShadowMap> m_ShadowMap;
+    rhi::Format m_ShadowDepthFormat = rhi::Format::D32_SFLOAT;  // Of the map and the atlas
     bool m_EnableShadows = true;
     float m_ShadowBias = 0.005f;
+    ShadowFilter m_ShadowFilter = ShadowFilter::PCF;  // ApplicationConfig::shadowFilter, resolved
+    float m_ShadowFilterRadius = 1.5f;    // Poisson: disc radius in texels (UI)
+    float m_ShadowLightRadius = 0.5f;     // PCSS: key light's angular radius in degrees (UI)
+    int m_EVSMBlurRadius = 2;             // EVSM: blur half-width in moment texels (UI)
+    float m_EVSMBleedReduction = 0.3f;    // EVSM (UI)
+    std::unique_ptr<ShadowMoments> m_ShadowMoments;  // EVSM; null without shadow_evsm.comp
+    // Main pass plus moment build GPU time while each filter was selected, smoothed; 0 = not measured
+    float m_ShadowFilterGpuMs[SHADOW_FILTER_COUNT] = {};
+    uint64 m_GpuTimedFrame = 0;  // GpuProfiler frame last credited to the filter and prepass costs
     bool m_VisualizeShadowMap = false;  // Debug: Show shadow map directly
     int m_ShadowDebugMode = 0;  // 0=normal, 1=shadow factor, 2=depth coords
     bool m_ShowGroundPlane = true;  // Show/hide ground plane
     glm::vec3 m_LightDirection = glm::vec3(0.5f, -1.0f, -0.3f);  // Direction for main shadow-casting light
+    Scene::LightHandle m_KeyLight = Scene::INVALID_LIGHT;  // The shadow-casting light
+
+    // Point and spot light shadows: tiles of the shadow atlas, a few faces per frame
+    std::unique_ptr<ShadowAtlas> m_ShadowAtlas;
+    Ref<rhi::Buffer> m_ShadowClearQuad;  // Full-tile quad drawn by m_ShadowClearPipeline
+    bool m_EnableShadowAtlas = true;
+    int m_ShadowAtlasBudget = 6;               // Faces rendered per frame (UI)
+    float m_ShadowAtlasQuality = 1.0f;         // Tile texels per screen pixel (UI)
+    bool m_ClusterTestLightShadows = false;    // Random point lights cast shadows (UI)
+
+    // Ray-traced shadows (devices with ray queries, forward only): model_raytraced.frag
+    // traces the key light and the local lights the shadow atlas picked against the
+    // scene's acceleration structures, and neither shadow map is rendered
+    std::unique_ptr<RayTracingScene> m_RayTracingScene;  // Null without ray queries or the shader
+    Ref<rhi::Pipeline> m_RayTracedModelPipeline;
+    Ref<rhi::Pipeline> m_RayTracedCompactModelPipeline;
+    bool m_EnableRayTracedShadows = true;
+    bool m_RayTracedShadowsActive = false;     // Last frame traced its shadows
+    float m_RayTracedLightRadius = 0.05f;      // Point and spot light radius in world units (UI)
+
+    // GPU culling of the model's meshes (null without the compute shaders)
+    std::unique_ptr<GPUCuller> m_GPUCuller;
+    std::unique_ptr<DeferredLighting> m_DeferredLighting;  // Null without the deferred shaders
+    // Null without its shaders, deferred lighting, the GPU culler or bindless materials
+    std::unique_ptr<VisibilityBuffer> m_VisibilityBuffer;
+    bool m_VisibilityBufferActive = false;  // Last frame's inputs had it
+    std::unique_ptr<AmbientOcclusion> m_AmbientOcclusion;  // Null without its shader or deferred lighting
+    // Null without its shader, deferred lighting or the GPU culler's depth pyramid
+    std::unique_ptr<ScreenSpaceReflections> m_Reflections;
+    std::unique_ptr<ShadingRate> m_ShadingRate;  // Null without its shader or the device's support
+    std::unique_ptr<WeightedBlendedOIT> m_OIT;   // Null without its shaders or the tone mapper
+    // Null without its shaders, ray queries, bindless textures or the tone mapper; traces
+    // only pooled models with the bindless table
+    std::unique_ptr<PathTracer> m_PathTracer;
+    PathTracer::Settings m_PathTraceSettings;  // UI
+    bool m_PathTracingActive = false;          // Last frame was traced
+    std::unique_ptr<Denoiser> m_Denoiser;      // Null without its shader or the path tracer
+    bool m_EnableDenoiser = true;              // UI
+    int m_DenoiseIterations = 4;               // UI
+    // Null without its shader, ray queries or bindless textures; traces only pooled models
+    // with the bindless table, like the path tracer
+    std::unique_ptr<LightProbeVolume> m_LightProbes;
+    bool m_EnableLightProbes = true;           // UI
+    int m_LightProbesPerFrame = 64;            // UI
+    // HDR scene color and its tone mapping pass; null without the shaders, and then the
+    // lit pipelines tone map into the back buffer themselves
+    std::unique_ptr<ToneMapper> m_ToneMapper;
+    std::unique_ptr<AutoExposure> m_AutoExposure;  // Null without its shader or the tone mapper
+    std::unique_ptr<Bloom> m_Bloom;                // Null without its shader or the tone mapper
+    std::unique_ptr<TemporalAA> m_TemporalAA;      // Null without its shaders or the tone mapper
+    bool m_EnableGPUCulling = true;
+    bool m_EnableOcclusionCulling = true;
+
+    // CPU frustum culling through the scene BVH, used whenever GPU culling is not
+    bool m_EnableCPUCulling = true;
+
+    // Levels of detail of the model's meshes (ModelImportSettings::buildLods), picked per
+    // instance from its projected error; its hysteresis state follows the scene's instances
+    LodSelector m_LodSelector;
+    bool m_EnableLods = true;
+    float m_LodPixelThreshold = 1.0f;  // LodSelector::Settings::pixelThreshold (UI)
+
+    // Records the frame's passes: culling, shadows, the main pass (whose content this
+    // class draws) and the depth pyramid; a DeferredRenderer in RenderMode::Deferred,
+    // a VisibilityBufferRenderer in RenderMode::VisibilityBuffer
+    std::unique_ptr<RasterizationRenderer> m_Renderer;
+
+    // The main pass draws the renderer's draw list in sort key order (pipeline, material, then
+    // front to back), binding pipeline and material state only when they change
+    RenderQueue m_MainQueue;
+    std::vector<uint32> m_MeshMaterialIds;  // Per mesh of the model, in first-use order
+    std::vector<uint32> m_MaterialRingOffsets;  // Per material id, this frame's uniform ring slice
+    std::vector<uint32> m_MaterialPipelineIds;  // Per material id, this frame's m_MainPipelines entry
+    std::vector<Ref<rhi::Pipeline>> m_MainPipelines;  // Pipeline ids of m_MainQueue; 0 = the uber pipeline
+    // Blended materials sort last in m_MainQueue, by ids of these: [0] draws into the
+    // scene color or the accumulation, [1] into the revealage
+    std::vector<Ref<rhi::Pipeline>> m_TransparentPipelines[2];
+    size_t m_TransparentPacketCount = 0;    // Of m_MainQueue, at its end
+    static constexpr uint32 TRANSPARENT_PIPELINE_PENDING = ~1u;  // Of m_MaterialPipelineIds: not queued
+    uint32 m_FilteredCallCount = 0;         // Binds and pushes the backend dropped last frame
+
+    // GPU time per pass, shown with a lag of framesInFlight frames; null without
+    // timestamp queries
+    Ref<rhi::GpuProfiler> m_GpuProfiler;
+
+    // Batch renders: the next Render() hands its final image to m_FrameCapture
+    // (FrameInputs::capture), which reads it back through m_CaptureReadback
+    std::unique_ptr<rhi::ReadbackPool> m_CaptureReadback;
+    std::function<void(rhi::CommandBuffer&, const Ref<rhi::Texture>&)> m_FrameCapture;
+    bool m_FrameCaptureHDR = false;
+
+    // Remote rendering (StreamConfig): the encoder's frames go to the server, which
+    // outlives it; both null unless streaming, the encoder also without its shader
+    std::unique_ptr<StreamServer> m_StreamServer;
+    std::unique_ptr<StreamEncoder> m_StreamEncoder;
+
+    // With ApplicationConfig::hitchDetection; told of each frame after its Present()
+    std::unique_ptr<HitchDetector> m_HitchDetector;
+
+    // Large main pass draw lists are recorded by several jobs
+    bool m_EnableParallelRecording = true;
+    // The render graph's async compute passes go to the device's compute queue
+    bool m_EnableAsyncCompute = true;
+
+    // Depth prepass. Auto runs the first DEPTH_PREPASS_PROBE_FRAMES frames of a scene
+    // without it and as many with it, timing the main pass (the prepass included) past
+    // each half's settle frames, which the profiler still reports from the other half.
+    static constexpr uint32 DEPTH_PREPASS_PROBE_FRAMES = 60;
+    static constexpr uint32 DEPTH_PREPASS_SETTLE_FRAMES = 8;
+    DepthPrepassMode m_DepthPrepassMode = DepthPrepassMode::Auto;  // ApplicationConfig::depthPrepass
+    uint32 m_DepthPrepassProbeFrame = 0;  // Frames since the scene changed, up to the end of the probe
+    double m_DepthPrepassGpuMs[2] = {};   // Summed main pass GPU time without and with the prepass
+    uint32 m_DepthPrepassSamples[2] = {};
+
+    // Present mode picked in the UI and the last window size, applied at the start of
+    // the next frame
+    bool m_PresentModeChanged = false;
+    bool m_ResizePending = false;
+    uint32 m_PendingResizeWidth = 0;
+    uint32 m_PendingResizeHeight = 0;
+
+    // Device memory past ApplicationConfig::memoryWarningFraction of its budget, as of
+    // the last CheckMemoryBudget()
+    bool m_MemoryNearBudget = false;
+
+    // Right-click picking: on the GPU, resolved a frame or two after the click, or through
+    // the scene BVH while the picker is missing (no pick shaders) or its pipelines compile
+    std::unique_ptr<ObjectPicker> m_ObjectPicker;
+    int32 m_PickedMesh = -1;
+    glm::vec3 m_PickedPosition = glm::vec3(0.0f);
 
     // Model management
     std::vector<std::string> m_AvailableModels;
+    // ApplicationConfig::scenePath; its instances replace the grid while its model is shown
+    std::unique_ptr<SceneDescription> m_SceneDescription;
     int m_CurrentModelIndex = 0;
-    std::string m_PendingModelPath;  // Model to load at start of next frame
+    std::string m_PendingModelPath;  // Model to load in the background once no other load is in flight
     bool m_HasPendingModel = false;
+    Ref<ModelLoadHandle> m_ModelLoad;  // Background load in flight; swapped in once resident
+    ModelUploadBudget m_FrameUploads;  // Left this frame to the model load and the cells' loads
 
-    // Deferred deletion queue for old models
-    struct PendingDeletion {
-        std::unique_ptr<Model> model;
-        uint32 frameCount;  // Frames to wait before deletion
-    };
-    std::vector<PendingDeletion> m_DeletionQueue;
-
-    // ImGui state
-    VkDescriptorPool m_ImGuiDescriptorPool = VK_NULL_HANDLE;
-    VkRenderPass m_ImGuiRenderPass = VK_NULL_HANDLE;
-    std::vector<VkFramebuffer> m_ImGuiFramebuffers;  // One per swap chain image
+    // ImGui state: the context exists from InitImGui(); without the renderer nothing is shown
+    std::unique_ptr<ImGuiRenderer> m_ImGuiRenderer;
 
     // GUI parameters
-    float m_Exposure = 1.0f;
+    float m_Exposure = 1.0f;  // Compensation of the measured exposure with auto exposure
+    ToneMapOperator m_ToneMapOperator = ToneMapOperator::Clamp;  // With m_ToneMapper
+    bool m_EnableAutoExposure = true;
+    float m_ExposureAdaptationRate = 1.5f;  // AutoExposure::Settings::adaptationRate
+    uint64 m_LastRenderTicks = 0;           // SDL_GetTicksNS() of the last Render(), for the adaptation
+    bool m_EnableAmbientOcclusion = true;   // Deferred only
+    float m_AmbientOcclusionRadius = 1.0f;  // AmbientOcclusion::Settings::radius
+    bool m_AmbientOcclusionActive = false;  // Last frame was occluded
+    bool m_EnableReflections = true;        // Deferred only
+    bool m_ReflectionsActive = false;       // Last frame reflected
+    bool m_EnableShadingRate = true;        // Forward only
+    TransparencyMode m_Transparency = TransparencyMode::WeightedBlended;  // Sorted without m_OIT
+    bool m_EnableBloom = true;
+    float m_BloomStrength = 0.04f;          // Bloom::Settings::strength
+    bool m_EnableTemporalAA = true;
+    float m_TemporalAASharpness = 0.25f;    // TemporalAA::Settings::sharpness
+    bool m_TemporalAAActive = false;        // Last frame was jittered
+    uint64 m_TemporalAAFrame = 0;           // Jitter phase
+    uint32 m_UpscaleMode = 0;               // Of UPSCALE_MODES: native, or temporal AA upscales
+    // Dynamic resolution: the drawn fraction of the render size follows the GPU frame time
+    DynamicResolution m_DynamicResolution;
+    bool m_EnableDynamicResolution = false;
+    float m_RenderScale = 1.0f;             // Of the last frame
+    // MSAA of the forward main pass, in place of temporal AA, resolved into the HDR scene color
+    static constexpr uint32 MSAA_SAMPLES = 4;  // The one count WebGPU guarantees besides 1
+    bool m_EnableMSAA = false;
+    uint32 m_MSAASamples = 1;               // Of the main pass pipelines
     bool m_EnableIBL = false;  // Disable IBL by default for shadow visualization
     float m_IBLIntensity = 0.05f;  // IBL contribution multiplier (default: very subtle)
     bool m_ShowSkybox = false;  // Hide skybox by default for shadow visualization
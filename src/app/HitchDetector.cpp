@@ -0,0 +1,274 @@
+// ============================================================================
+// src/app/HitchDetector.cpp
+// ============================================================================
+#include "HitchDetector.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/GpuProfiler.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <algorithm>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+
+namespace metagfx {
+
+namespace {
+
+// The zones the engine times around known hitch sources, and the cause each points at
+struct KnownCause {
+    const char* zone;
+    const char* cause;
+};
+
+constexpr KnownCause KNOWN_CAUSES[] = {
+    { "Load model", "Synchronous model load" },
+    { "Import model", "Synchronous model load" },
+    { "Compile pipeline", "Pipeline compile" },
+    { "Upload wait", "Upload wait" },
+    { "Upload flush", "Upload wait" },
+    { "Swap chain resize", "Swap chain resize" },
+};
+
+constexpr double MIN_REPORTED_ZONE_MS = 1.0;
+
+struct Suspect {
+    const char* cause = nullptr;
+    double zoneMs = 0.0;   // In the zones of the cause that ended during the hitch
+    uint32 zones = 0;
+    uint32 counted = 0;    // Pipeline compiles, upload waits or events of the frame
+};
+
+double ToMs(uint64 ns) {
+    return static_cast<double>(ns) / 1000000.0;
+}
+
+void WriteJsonString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; c && *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+Suspect& FindSuspect(std::vector<Suspect>& suspects, const char* cause) {
+    for (Suspect& suspect : suspects) {
+        if (std::strcmp(suspect.cause, cause) == 0) {
+            return suspect;
+        }
+    }
+    suspects.push_back({ cause });
+    return suspects.back();
+}
+
+} // anonymous namespace
+
+HitchDetector::HitchDetector(const Settings& settings)
+    : m_Settings(settings) {
+    m_Settings.historyFrames = std::max(m_Settings.historyFrames, 8u);
+    METAGFX_INFO << "Hitch detector: frames over " << m_Settings.medianMultiple << "x the median and "
+                 << m_Settings.minimumMs << " ms over it are written to " << m_Settings.directory;
+}
+
+void HitchDetector::EndFrame(rhi::GraphicsDevice& device, rhi::GpuProfiler* gpuProfiler) {
+    uint64 now = Profiler::Now();
+    if (m_DeviceName.empty()) {
+        m_DeviceName = device.GetDeviceInfo().deviceName;
+    }
+
+    Frame frame;
+    frame.number = m_FrameNumber++;
+    frame.endMs = ToMs(now);
+    frame.cpuMs = m_LastEndNs != 0 ? ToMs(now - m_LastEndNs) : 0.0;
+    frame.stats = device.GetFrameStats();
+    frame.events = std::move(m_Events);
+    m_Events.clear();
+    if (gpuProfiler) {
+        const rhi::GpuProfiler::FrameTimings& timings = gpuProfiler->GetLatestFrame();
+        frame.gpuMs = timings.gpuTimeMs;
+        frame.gpuFrameNumber = timings.frameNumber;
+    }
+
+    // Judged against the frames before it, once there are enough of them
+    double medianMs = GetMedianMs();
+    double thresholdMs = std::max(medianMs * m_Settings.medianMultiple, medianMs + m_Settings.minimumMs);
+    frame.hitch = medianMs > 0.0 && frame.cpuMs > thresholdMs;
+    if (frame.hitch) {
+        ++m_HitchCount;
+        bool cooledDown = m_DumpCount == 0 || ToMs(now - m_LastDumpNs) >= m_Settings.cooldownSeconds * 1000.0;
+        if (!m_HasPendingDump && cooledDown && m_DumpCount < m_Settings.maxDumps) {
+            m_HasPendingDump = true;
+            m_PendingDump = { frame.number, medianMs, thresholdMs, m_Settings.framesAfter };
+        }
+    }
+
+    m_Frames.push_back(std::move(frame));
+    while (m_Frames.size() > m_Settings.historyFrames + m_Settings.framesAfter + 1) {
+        m_Frames.pop_front();
+    }
+
+    m_LastEndNs = now;
+    if (m_HasPendingDump && m_PendingDump.framesLeft-- == 0) {
+        m_HasPendingDump = false;
+        WriteDump(m_PendingDump, gpuProfiler);
+        // Writing the traces takes a while: the next frame is not timed
+        m_LastDumpNs = Profiler::Now();
+        m_LastEndNs = 0;
+    }
+}
+
+double HitchDetector::GetMedianMs() const {
+    std::vector<double> times;
+    times.reserve(m_Settings.historyFrames);
+    for (auto it = m_Frames.rbegin(); it != m_Frames.rend() && times.size() < m_Settings.historyFrames; ++it) {
+        if (it->cpuMs > 0.0) {
+            times.push_back(it->cpuMs);
+        }
+    }
+    if (times.size() < m_Settings.historyFrames / 2) {
+        return 0.0;
+    }
+    std::nth_element(times.begin(), times.begin() + times.size() / 2, times.end());
+    return times[times.size() / 2];
+}
+
+void HitchDetector::WriteDump(const PendingDump& dump, rhi::GpuProfiler* gpuProfiler) {
+    std::time_t now = std::time(nullptr);
+    char stamp[32] = {};
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+    std::filesystem::path directory =
+        std::filesystem::path(m_Settings.directory) / (std::string("hitch_") + stamp + "_frame" + std::to_string(dump.frame));
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error) {
+        METAGFX_ERROR << "Cannot create the hitch directory " << directory.string() << ": " << error.message();
+        m_DumpCount = m_Settings.maxDumps;  // Later dumps would fail alike
+        return;
+    }
+
+    ++m_DumpCount;
+    m_LastDump = directory.string();
+    bool written = WriteReport((directory / "report.json").string(), dump);
+    if (Profiler::IsEnabled()) {
+        written = Profiler::WriteChromeTrace((directory / "cpu_trace.json").string()) && written;
+    }
+    if (gpuProfiler) {
+        written = gpuProfiler->WriteChromeTrace((directory / "gpu_trace.json").string()) && written;
+    }
+    if (!written) {
+        METAGFX_WARN << "Hitch dump " << m_LastDump << " is incomplete";
+    }
+}
+
+bool HitchDetector::WriteReport(const std::string& path, const PendingDump& dump) const {
+    auto hitch = std::find_if(m_Frames.begin(), m_Frames.end(), [&](const Frame& f) { return f.number == dump.frame; });
+    if (hitch == m_Frames.end()) {
+        return false;
+    }
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        METAGFX_ERROR << "Failed to write hitch report: " << path;
+        return false;
+    }
+
+    // Zones that ended during the hitch, on any thread
+    struct HitchZone {
+        const char* name;
+        std::string thread;
+        double ms;
+    };
+    std::vector<HitchZone> zones;
+    std::vector<Suspect> suspects;
+    double hitchStartMs = hitch->endMs - hitch->cpuMs;
+    for (const ProfileFrame& profileFrame : Profiler::GetFrames(hitchStartMs, hitch->endMs)) {
+        for (const ProfileThread& thread : profileFrame.threads) {
+            for (const ProfileZone& zone : thread.zones) {
+                double endMs = profileFrame.startMs + zone.startMs + zone.durationMs;
+                if (endMs < hitchStartMs || endMs > hitch->endMs || zone.durationMs < MIN_REPORTED_ZONE_MS) {
+                    continue;
+                }
+                zones.push_back({ zone.name, thread.name, zone.durationMs });
+                for (const KnownCause& known : KNOWN_CAUSES) {
+                    if (std::strcmp(zone.name, known.zone) == 0) {
+                        Suspect& suspect = FindSuspect(suspects, known.cause);
+                        suspect.zoneMs += zone.durationMs;
+                        ++suspect.zones;
+                    }
+                }
+            }
+        }
+    }
+    std::sort(zones.begin(), zones.end(), [](const HitchZone& a, const HitchZone& b) { return a.ms > b.ms; });
+
+    // The hitch's device work shows in its own statistics and the next frame's
+    for (auto it = hitch; it != m_Frames.end() && it <= hitch + 1; ++it) {
+        if (it->stats.pipelineCompiles > 0) {
+            FindSuspect(suspects, "Pipeline compile").counted += it->stats.pipelineCompiles;
+        }
+        if (it->stats.uploadWaits > 0) {
+            FindSuspect(suspects, "Upload wait").counted += it->stats.uploadWaits;
+        }
+    }
+    for (const char* event : hitch->events) {
+        ++FindSuspect(suspects, event).counted;
+    }
+    std::stable_sort(suspects.begin(), suspects.end(),
+                     [](const Suspect& a, const Suspect& b) { return a.zoneMs > b.zoneMs; });
+
+    std::time_t now = std::time(nullptr);
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"timestamp\": \"" << timestamp << "\",\n  \"device\": ";
+    WriteJsonString(out, m_DeviceName.c_str());
+    out << ",\n  \"frame\": " << hitch->number << ",\n  \"frameMs\": " << hitch->cpuMs << ",\n  \"medianMs\": "
+        << dump.medianMs << ",\n  \"thresholdMs\": " << dump.thresholdMs << ",\n  \"hitchesSoFar\": " << m_HitchCount
+        << ",\n  \"cpuZones\": " << (Profiler::IsEnabled() ? "true" : "false") << ",\n  \"suspects\": [";
+    for (size_t i = 0; i < suspects.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ") << "{ \"cause\": ";
+        WriteJsonString(out, suspects[i].cause);
+        out << ", \"zoneMs\": " << suspects[i].zoneMs << ", \"zones\": " << suspects[i].zones
+            << ", \"counted\": " << suspects[i].counted << " }";
+    }
+    out << (suspects.empty() ? "" : "\n  ") << "],\n  \"zones\": [";
+    for (size_t i = 0; i < zones.size(); ++i) {
+        out << (i ? ",\n    " : "\n    ") << "{ \"name\": ";
+        WriteJsonString(out, zones[i].name);
+        out << ", \"thread\": ";
+        WriteJsonString(out, zones[i].thread.c_str());
+        out << ", \"ms\": " << zones[i].ms << " }";
+    }
+    out << (zones.empty() ? "" : "\n  ") << "],\n  \"frames\": [";
+    for (auto it = m_Frames.begin(); it != m_Frames.end(); ++it) {
+        const rhi::FrameStats& stats = it->stats;
+        out << (it != m_Frames.begin() ? ",\n    " : "\n    ") << "{ \"frame\": " << it->number
+            << ", \"cpuMs\": " << it->cpuMs << ", \"gpuMs\": " << it->gpuMs << ", \"gpuFrame\": "
+            << it->gpuFrameNumber << ", \"hitch\": " << (it->hitch ? "true" : "false")
+            << ", \"allocations\": " << stats.allocations << ", \"bufferBytesUploaded\": " << stats.bufferBytesUploaded
+            << ", \"textureBytesUploaded\": " << stats.textureBytesUploaded << ", \"pipelineCompiles\": "
+            << stats.pipelineCompiles << ", \"uploadWaits\": " << stats.uploadWaits << ", \"descriptorUpdates\": "
+            << stats.descriptorUpdates << ", \"renderPassesCreated\": " << stats.renderPassesCreated
+            << ", \"drawCalls\": " << stats.drawCalls << ", \"events\": [";
+        for (size_t e = 0; e < it->events.size(); ++e) {
+            out << (e ? ", " : "");
+            WriteJsonString(out, it->events[e]);
+        }
+        out << "] }";
+    }
+    out << "\n  ]\n}\n";
+
+    METAGFX_WARN << "Hitch: frame " << hitch->number << " took " << hitch->cpuMs << " ms (median " << dump.medianMs
+                 << " ms)" << (suspects.empty() ? "" : std::string(", suspect: ") + suspects.front().cause)
+                 << "; wrote " << m_LastDump;
+    return out.good();
+}
+
+} // namespace metagfx
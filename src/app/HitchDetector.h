@@ -0,0 +1,111 @@
+// ============================================================================
+// src/app/HitchDetector.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/FrameStats.h"
+
+#include <deque>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+
+namespace rhi {
+class GraphicsDevice;
+class GpuProfiler;
+}
+
+/**
+ * @brief Frame-time watchdog that writes what surrounded a hitch to disk
+ *
+ * EndFrame(), once per rendered frame after Present(), times the frame against the
+ * median of the last historyFrames. A frame over both medianMultiple times the median
+ * and the median plus minimumMs is a hitch. framesAfter frames later, so that the
+ * traces hold what followed it and the GPU timings have come back, a directory of
+ * settings.directory receives:
+ *
+ * - report.json: the hitch, the CPU zones of at least a millisecond that ended during
+ *   it, the suspects among the known causes, and every frame kept around it with its
+ *   CPU and GPU time, GetFrameStats() (allocations, uploads, pipeline compiles, upload
+ *   waits) and the events AddEvent() noted
+ * - cpu_trace.json and gpu_trace.json: the profilers' Chrome traces, which keep their
+ *   last 300 frames
+ *
+ * The known causes are zones the engine times: synchronous model loads ("Load model",
+ * "Import model"), pipeline compiles the caller waits for ("Compile pipeline"), waits
+ * for staged uploads ("Upload wait", "Upload flush") and swap chain resizes ("Swap chain
+ * resize"). CPU zones and the CPU trace need the profiler (METAGFX_ENABLE_PROFILER);
+ * without it the report has the times, statistics and events only.
+ *
+ * At most maxDumps are written per run, cooldownSeconds apart; hitches in between are
+ * counted. The dump is written on the rendering thread, and the frame it is written in
+ * is not timed. Not thread-safe: call everything from the thread that renders.
+ */
+class HitchDetector {
+public:
+    struct Settings {
+        std::string directory = "hitches";
+        float medianMultiple = 2.0f;
+        float minimumMs = 4.0f;         // Over the median, so that fast frames do not hitch on noise
+        uint32 historyFrames = 120;     // Of the median, and kept before the hitch
+        uint32 framesAfter = 30;        // Rendered after the hitch before it is written
+        float cooldownSeconds = 10.0f;
+        uint32 maxDumps = 20;
+    };
+
+    explicit HitchDetector(const Settings& settings);
+
+    // After the frame's Present(). The frame time runs from the previous call.
+    void EndFrame(rhi::GraphicsDevice& device, rhi::GpuProfiler* gpuProfiler);
+    // The next frame is not timed, e.g. after waiting for events
+    void Restart() { m_LastEndNs = 0; }
+    // Notes something the frame did for the report, e.g. "Swap chain resize"; name must
+    // be a string literal
+    void AddEvent(const char* name) { m_Events.push_back(name); }
+
+    uint32 GetHitchCount() const { return m_HitchCount; }
+    uint32 GetDumpCount() const { return m_DumpCount; }
+    const std::string& GetLastDump() const { return m_LastDump; }  // Directory, empty before the first
+
+private:
+    struct Frame {
+        uint64 number = 0;        // EndFrame() calls before this one
+        double endMs = 0.0;       // On the CPU profiler's clock (Profiler::Now())
+        double cpuMs = 0.0;       // 0 when not timed
+        double gpuMs = 0.0;       // GpuProfiler's latest frame at the time, framesInFlight behind
+        uint64 gpuFrameNumber = 0;
+        // GetFrameStats() after the frame: the previous frame's commands and the device
+        // work up to this frame's BeginFrame()
+        rhi::FrameStats stats;
+        std::vector<const char*> events;
+        bool hitch = false;
+    };
+
+    struct PendingDump {
+        uint64 frame = 0;
+        double medianMs = 0.0;
+        double thresholdMs = 0.0;
+        uint32 framesLeft = 0;
+    };
+
+    double GetMedianMs() const;
+    void WriteDump(const PendingDump& dump, rhi::GpuProfiler* gpuProfiler);
+    bool WriteReport(const std::string& path, const PendingDump& dump) const;
+
+    Settings m_Settings;
+    std::deque<Frame> m_Frames;        // historyFrames + framesAfter + 1 at most
+    std::vector<const char*> m_Events; // Of the frame being rendered
+    uint64 m_LastEndNs = 0;
+    uint64 m_FrameNumber = 0;
+    uint64 m_LastDumpNs = 0;
+    bool m_HasPendingDump = false;
+    PendingDump m_PendingDump;
+    uint32 m_HitchCount = 0;
+    uint32 m_DumpCount = 0;
+    std::string m_LastDump;
+    std::string m_DeviceName;
+};
+
+} // namespace metagfx
@@ -0,0 +1,289 @@
+// ============================================================================
+// src/app/ImGuiRenderer.cpp
+// ============================================================================
+#include "ImGuiRenderer.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/Pipeline.h"
+#include <imgui.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace metagfx {
+
+namespace {
+
+// Regions start large enough for a few windows of controls
+constexpr size_t INITIAL_VERTEX_CAPACITY = 16 * 1024;
+constexpr size_t INITIAL_INDEX_CAPACITY = 32 * 1024;
+
+} // namespace
+
+ImGuiRenderer::ImGuiRenderer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader,
+                             Ref<rhi::Shader> fragmentShader, uint32 framesInFlight)
+    : m_Device(device)
+    , m_FramesInFlight(std::max(framesInFlight, 1u))
+    , m_SlotGenerations(m_FramesInFlight, 0) {
+    using namespace rhi;
+
+    m_FlipY = device->GetDeviceInfo().api == GraphicsAPI::Metal;
+
+    // Font atlas, sampled by every draw: the application shows no other textures
+    ImGuiIO& io = ImGui::GetIO();
+    unsigned char* pixels = nullptr;
+    int width = 0;
+    int height = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+
+    TextureDesc atlasDesc{};
+    atlasDesc.width = static_cast<uint32>(width);
+    atlasDesc.height = static_cast<uint32>(height);
+    atlasDesc.format = Format::R8G8B8A8_UNORM;
+    atlasDesc.usage = TextureUsage::Sampled | TextureUsage::TransferDst;
+    atlasDesc.debugName = "ImGuiFontAtlas";
+    m_FontAtlas = device->CreateTexture(atlasDesc);
+    if (!m_FontAtlas) {
+        METAGFX_ERROR << "ImGui unavailable: failed to create the font atlas";
+        return;
+    }
+    m_FontAtlas->UploadData(pixels, static_cast<uint64>(width) * height * 4);
+    io.Fonts->SetTexID((ImTextureID)(intptr_t)m_FontAtlas.get());
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_Sampler = device->CreateSampler(samplerDesc);
+
+    // Written once: the atlas never changes
+    DescriptorSetDesc setDesc;
+    setDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_FontAtlas, m_Sampler }
+    };
+    setDesc.debugName = "ImGuiDescriptorSet";
+    m_DescriptorSet = device->CreateDescriptorSet(setDesc);
+    if (!m_DescriptorSet) {
+        METAGFX_ERROR << "ImGui unavailable: failed to create its descriptor set";
+        return;
+    }
+
+    // Alpha blended over the back buffer, without depth
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertexShader;
+    pipelineDesc.fragmentShader = fragmentShader;
+    pipelineDesc.vertexInput.stride = sizeof(Vertex);
+    pipelineDesc.vertexInput.attributes = {
+        { 0, Format::R32G32_SFLOAT, static_cast<uint32>(offsetof(Vertex, position)), 0 },
+        { 1, Format::R32G32_SFLOAT, static_cast<uint32>(offsetof(Vertex, uv)), 0 },
+        { 2, Format::R8G8B8A8_UNORM, static_cast<uint32>(offsetof(Vertex, color)), 0 }
+    };
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+    pipelineDesc.depthStencil.depthTestEnable = false;
+    pipelineDesc.depthStencil.depthWriteEnable = false;
+    pipelineDesc.depthFormat = Format::Undefined;
+    ColorAttachmentState blended{};
+    blended.blendEnable = true;
+    pipelineDesc.colorAttachments = { blended };
+    pipelineDesc.debugName = "ImGuiPipeline";
+    pipelineDesc.descriptorSetLayout = m_DescriptorSet;
+    m_Pipeline = device->CreateGraphicsPipeline(pipelineDesc);
+    if (!m_Pipeline) {
+        METAGFX_ERROR << "ImGui unavailable: failed to create its pipeline";
+        return;
+    }
+
+    io.BackendRendererName = "metagfx_rhi";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    METAGFX_INFO << "ImGui renderer created: " << width << "x" << height << " font atlas";
+}
+
+ImGuiRenderer::~ImGuiRenderer() {
+    if (ImGui::GetCurrentContext()) {
+        ImGuiIO& io = ImGui::GetIO();
+        io.BackendRendererName = nullptr;
+        io.BackendFlags &= ~ImGuiBackendFlags_RendererHasVtxOffset;
+        io.Fonts->SetTexID(ImTextureID{});
+    }
+}
+
+void ImGuiRenderer::Render(rhi::CommandBuffer& cmd, const ImDrawData* drawData, uint32 frameIndex) {
+    if (!IsValid() || !drawData || drawData->TotalVtxCount == 0) {
+        return;
+    }
+    float width = drawData->DisplaySize.x * drawData->FramebufferScale.x;
+    float height = drawData->DisplaySize.y * drawData->FramebufferScale.y;
+    if (width <= 0.0f || height <= 0.0f) {
+        return;
+    }
+
+    Stage(*drawData);
+
+    // Copy into this frame's region only when it holds older geometry; the GPU is done
+    // with the region once the frame slot comes round again
+    uint32 slot = frameIndex % m_FramesInFlight;
+    uint64 uploadedBytes = 0;
+    if (m_SlotGenerations[slot] != m_Generation) {
+        if (!Reserve(m_Vertices.size(), m_Indices.size())) {
+            return;
+        }
+        uint64 vertexBytes = m_Vertices.size() * sizeof(Vertex);
+        uint64 indexBytes = m_Indices.size() * sizeof(uint32);
+        uint64 vertexOffset = static_cast<uint64>(slot) * m_VertexCapacity * sizeof(Vertex);
+        uint64 indexOffset = static_cast<uint64>(slot) * m_IndexCapacity * sizeof(uint32);
+        if (m_MappedVertices && m_MappedIndices) {
+            std::memcpy(m_MappedVertices + vertexOffset, m_Vertices.data(), vertexBytes);
+            std::memcpy(m_MappedIndices + indexOffset, m_Indices.data(), indexBytes);
+        } else {
+            m_VertexBuffer->CopyData(m_Vertices.data(), vertexBytes, vertexOffset);
+            m_IndexBuffer->CopyData(m_Indices.data(), indexBytes, indexOffset);
+        }
+        m_SlotGenerations[slot] = m_Generation;
+        uploadedBytes = vertexBytes + indexBytes;
+    }
+    METAGFX_PROFILE_COUNTER("ImGui upload bytes", static_cast<double>(uploadedBytes));
+
+    BindState(cmd, frameIndex, width, height);
+
+    // Clip rectangles from display to framebuffer pixels
+    ImVec2 clipOffset = drawData->DisplayPos;
+    ImVec2 clipScale = drawData->FramebufferScale;
+    int32 firstVertex = 0;
+    uint32 firstIndex = 0;
+    for (int n = 0; n < drawData->CmdListsCount; ++n) {
+        const ImDrawList* list = drawData->CmdLists[n];
+        for (const ImDrawCmd& drawCmd : list->CmdBuffer) {
+            if (drawCmd.UserCallback) {
+                if (drawCmd.UserCallback == ImDrawCallback_ResetRenderState) {
+                    BindState(cmd, frameIndex, width, height);
+                } else {
+                    drawCmd.UserCallback(list, &drawCmd);
+                }
+                continue;
+            }
+
+            float minX = std::max((drawCmd.ClipRect.x - clipOffset.x) * clipScale.x, 0.0f);
+            float minY = std::max((drawCmd.ClipRect.y - clipOffset.y) * clipScale.y, 0.0f);
+            float maxX = std::min((drawCmd.ClipRect.z - clipOffset.x) * clipScale.x, width);
+            float maxY = std::min((drawCmd.ClipRect.w - clipOffset.y) * clipScale.y, height);
+            if (maxX <= minX || maxY <= minY) {
+                continue;
+            }
+
+            rhi::Rect2D scissor{};
+            scissor.x = static_cast<int32>(minX);
+            scissor.y = static_cast<int32>(minY);
+            scissor.width = static_cast<uint32>(maxX - minX);
+            scissor.height = static_cast<uint32>(maxY - minY);
+            cmd.SetScissor(scissor);
+            cmd.DrawIndexed(drawCmd.ElemCount, 1, firstIndex + drawCmd.IdxOffset,
+                            firstVertex + static_cast<int32>(drawCmd.VtxOffset));
+        }
+        firstVertex += list->VtxBuffer.Size;
+        firstIndex += static_cast<uint32>(list->IdxBuffer.Size);
+    }
+
+    rhi::Rect2D fullScissor{};
+    fullScissor.width = static_cast<uint32>(width);
+    fullScissor.height = static_cast<uint32>(height);
+    cmd.SetScissor(fullScissor);
+}
+
+void ImGuiRenderer::Stage(const ImDrawData& drawData) {
+    float scaleX = 2.0f / drawData.DisplaySize.x;
+    float scaleY = 2.0f / drawData.DisplaySize.y;
+    float ySign = m_FlipY ? -1.0f : 1.0f;
+
+    m_NextVertices.resize(static_cast<size_t>(drawData.TotalVtxCount));
+    m_NextIndices.resize(static_cast<size_t>(drawData.TotalIdxCount));
+    Vertex* vertex = m_NextVertices.data();
+    uint32* index = m_NextIndices.data();
+    for (int n = 0; n < drawData.CmdListsCount; ++n) {
+        const ImDrawList* list = drawData.CmdLists[n];
+        for (const ImDrawVert& source : list->VtxBuffer) {
+            vertex->position[0] = (source.pos.x - drawData.DisplayPos.x) * scaleX - 1.0f;
+            vertex->position[1] = ((source.pos.y - drawData.DisplayPos.y) * scaleY - 1.0f) * ySign;
+            vertex->uv[0] = source.uv.x;
+            vertex->uv[1] = source.uv.y;
+            vertex->color = source.col;
+            ++vertex;
+        }
+        // ImDrawIdx is 16-bit unless imconfig.h says otherwise; the RHI binds 32-bit indices
+        for (ImDrawIdx source : list->IdxBuffer) {
+            *index++ = source;
+        }
+    }
+
+    bool same = m_NextVertices.size() == m_Vertices.size() && m_NextIndices.size() == m_Indices.size() &&
+                std::memcmp(m_NextVertices.data(), m_Vertices.data(), m_Vertices.size() * sizeof(Vertex)) == 0 &&
+                std::memcmp(m_NextIndices.data(), m_Indices.data(), m_Indices.size() * sizeof(uint32)) == 0;
+    if (!same) {
+        m_Vertices.swap(m_NextVertices);
+        m_Indices.swap(m_NextIndices);
+        ++m_Generation;
+    }
+}
+
+bool ImGuiRenderer::Reserve(size_t vertexCount, size_t indexCount) {
+    using namespace rhi;
+
+    if (m_VertexBuffer && m_IndexBuffer && vertexCount <= m_VertexCapacity && indexCount <= m_IndexCapacity) {
+        return true;
+    }
+
+    // Frames in flight may still draw from the old buffers
+    if (m_VertexBuffer) {
+        m_Device->Retire(m_VertexBuffer);
+    }
+    if (m_IndexBuffer) {
+        m_Device->Retire(m_IndexBuffer);
+    }
+    m_VertexCapacity = std::max({ vertexCount, m_VertexCapacity * 2, INITIAL_VERTEX_CAPACITY });
+    m_IndexCapacity = std::max({ indexCount, m_IndexCapacity * 2, INITIAL_INDEX_CAPACITY });
+    std::fill(m_SlotGenerations.begin(), m_SlotGenerations.end(), 0);
+
+    BufferDesc vertexDesc{};
+    vertexDesc.size = static_cast<uint64>(m_VertexCapacity) * sizeof(Vertex) * m_FramesInFlight;
+    vertexDesc.usage = BufferUsage::Vertex;
+    vertexDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    vertexDesc.debugName = "ImGuiVertices";
+    m_VertexBuffer = m_Device->CreateBuffer(vertexDesc);
+
+    BufferDesc indexDesc{};
+    indexDesc.size = static_cast<uint64>(m_IndexCapacity) * sizeof(uint32) * m_FramesInFlight;
+    indexDesc.usage = BufferUsage::Index;
+    indexDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    indexDesc.debugName = "ImGuiIndices";
+    m_IndexBuffer = m_Device->CreateBuffer(indexDesc);
+
+    if (!m_VertexBuffer || !m_IndexBuffer) {
+        METAGFX_ERROR << "ImGuiRenderer: failed to create " << vertexDesc.size << " + " << indexDesc.size
+                      << " byte geometry buffers";
+        m_VertexBuffer.reset();
+        m_IndexBuffer.reset();
+        m_VertexCapacity = 0;
+        m_IndexCapacity = 0;
+        return false;
+    }
+    m_MappedVertices = static_cast<uint8*>(m_VertexBuffer->GetMappedPointer());
+    m_MappedIndices = static_cast<uint8*>(m_IndexBuffer->GetMappedPointer());
+    return true;
+}
+
+void ImGuiRenderer::BindState(rhi::CommandBuffer& cmd, uint32 frameIndex, float width, float height) {
+    uint32 slot = frameIndex % m_FramesInFlight;
+    rhi::Viewport viewport{};
+    viewport.width = width;
+    viewport.height = height;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+    cmd.SetViewport(viewport);
+    cmd.BindVertexBuffer(m_VertexBuffer, static_cast<uint64>(slot) * m_VertexCapacity * sizeof(Vertex));
+    cmd.BindIndexBuffer(m_IndexBuffer, static_cast<uint64>(slot) * m_IndexCapacity * sizeof(uint32));
+}
+
+} // namespace metagfx
@@ -0,0 +1,88 @@
+// ============================================================================
+// src/app/ImGuiRenderer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Texture.h"
+#include <vector>
+
+struct ImDrawData;
+
+namespace metagfx {
+
+namespace rhi {
+    class CommandBuffer;
+}
+
+/**
+ * @brief Dear ImGui's draw data through the RHI, on every backend
+ *
+ * Replaces the per-API ImGui renderers: one pipeline, the font atlas and one vertex and
+ * index region per frame in flight in two CPU-visible buffers. Positions are converted
+ * to clip space on the CPU, so the shaders need no push constants, and the regions only
+ * grow, retiring the old buffers through the device when a frame outgrows them.
+ *
+ * A frame whose geometry matches the last one copied into its region records the draws
+ * without uploading anything, which is every frame while the UI stands still (the
+ * "ImGui upload bytes" profiler counter stays at 0).
+ */
+class ImGuiRenderer {
+public:
+    // vertexShader runs imgui.vert, fragmentShader imgui.frag. Needs the ImGui context,
+    // whose font atlas it uploads.
+    ImGuiRenderer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader,
+                  Ref<rhi::Shader> fragmentShader, uint32 framesInFlight = 2);
+    ~ImGuiRenderer();
+
+    ImGuiRenderer(const ImGuiRenderer&) = delete;
+    ImGuiRenderer& operator=(const ImGuiRenderer&) = delete;
+
+    bool IsValid() const { return m_Pipeline != nullptr && m_DescriptorSet != nullptr; }
+
+    // Inside a render pass over the back buffer, without depth. Sets the viewport to the
+    // draw data's framebuffer and leaves the scissor covering it.
+    void Render(rhi::CommandBuffer& cmd, const ImDrawData* drawData, uint32 frameIndex);
+
+private:
+    // imgui.vert's vertex: ImDrawVert with the position in clip space
+    struct Vertex {
+        float position[2];
+        float uv[2];
+        uint32 color;  // RGBA8
+    };
+
+    // Converts the draw data into m_NextVertices / m_NextIndices and makes them current,
+    // bumping m_Generation, when they differ from the current geometry
+    void Stage(const ImDrawData& drawData);
+    // Grows the regions to hold vertexCount vertices and indexCount indices
+    bool Reserve(size_t vertexCount, size_t indexCount);
+    void BindState(rhi::CommandBuffer& cmd, uint32 frameIndex, float width, float height);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+    Ref<rhi::Texture> m_FontAtlas;
+    Ref<rhi::Sampler> m_Sampler;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    bool m_FlipY = false;  // Y-up clip space, as the camera's projection on Metal
+
+    uint32 m_FramesInFlight = 2;
+    Ref<rhi::Buffer> m_VertexBuffer;  // m_FramesInFlight regions of m_VertexCapacity
+    Ref<rhi::Buffer> m_IndexBuffer;   // And of m_IndexCapacity 32-bit indices
+    uint8* m_MappedVertices = nullptr;  // nullptr when the backend has no persistent mapping
+    uint8* m_MappedIndices = nullptr;
+    size_t m_VertexCapacity = 0;
+    size_t m_IndexCapacity = 0;
+
+    std::vector<Vertex> m_Vertices;  // Current geometry
+    std::vector<uint32> m_Indices;
+    std::vector<Vertex> m_NextVertices;  // Stage() scratch
+    std::vector<uint32> m_NextIndices;
+    uint64 m_Generation = 1;               // Of the current geometry
+    std::vector<uint64> m_SlotGenerations;  // Held by each region; 0 = nothing
+};
+
+} // namespace metagfx
@@ -0,0 +1,351 @@
+// ============================================================================
+// src/app/StreamServer.cpp
+// ============================================================================
+#include "StreamServer.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+
+// Frames are acknowledged within a few frames; older entries are from frames the client
+// never showed
+constexpr size_t MAX_UNACKNOWLEDGED_FRAMES = 64;
+// A client sends small messages only; one larger than this is a different protocol
+constexpr uint64 MAX_CLIENT_MESSAGE_SIZE = 4096;
+
+StreamServer::StreamServer(uint16 port, uint32 maxQueuedFrames)
+    : m_MaxQueuedFrames(std::max(1u, maxQueuedFrames))
+    , m_KeysDown(SDL_SCANCODE_COUNT, false) {
+    m_Listener = Socket::Listen(port);
+    if (!m_Listener.IsValid()) {
+        METAGFX_ERROR << "Stream server unavailable: cannot listen on port " << port;
+        return;
+    }
+    m_SendThread = std::thread([this]() { SendThreadMain(); });
+    METAGFX_INFO << "Stream server listening on port " << port;
+}
+
+StreamServer::~StreamServer() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+        // A send waiting on a stalled client fails once its connection is shut down
+        if (m_Client) {
+            m_Client->Shutdown();
+        }
+    }
+    m_FrameQueued.notify_one();
+    if (m_SendThread.joinable()) {
+        m_SendThread.join();
+    }
+}
+
+void StreamServer::Poll(SDL_Window* window) {
+    METAGFX_PROFILE_FUNCTION();
+    if (!m_Listener.IsValid()) {
+        return;
+    }
+
+    if (m_SendFailed.exchange(false)) {
+        Disconnect();
+    }
+
+    if (!m_Connected) {
+        Socket client = m_Listener.Accept();
+        if (!client.IsValid()) {
+            return;
+        }
+        // Input arrives a few bytes at a time and should not wait for more
+        client.SetNoDelay(true);
+        client.SetNonBlocking(true);
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Client = std::make_shared<Socket>(std::move(client));
+            m_Queue.clear();
+            m_Sent.clear();
+        }
+        m_Received.clear();
+        m_ClientFormats = stream::FormatBit(stream::PixelFormat::NV12);
+        AwaitKeyFrame();
+        m_Connected = true;
+        METAGFX_INFO << "Stream client connected";
+    }
+
+    std::shared_ptr<Socket> client;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        client = m_Client;
+    }
+    uint8 buffer[4096];
+    while (true) {
+        int64 received = client->Receive(buffer, sizeof(buffer));
+        if (received < 0) {
+            Disconnect();
+            return;
+        }
+        if (received == 0) {
+            break;
+        }
+        m_Received.insert(m_Received.end(), buffer, buffer + received);
+    }
+
+    // Whole messages only; a partial one waits for the rest
+    size_t offset = 0;
+    while (m_Received.size() - offset >= sizeof(stream::MessageHeader)) {
+        stream::MessageHeader header;
+        std::memcpy(&header, m_Received.data() + offset, sizeof(header));
+        if (header.magic != stream::MAGIC || header.size > MAX_CLIENT_MESSAGE_SIZE) {
+            METAGFX_WARN << "Stream client sent an invalid message; disconnecting";
+            Disconnect();
+            return;
+        }
+        if (m_Received.size() - offset - sizeof(header) < header.size) {
+            break;
+        }
+        const uint8* payload = m_Received.data() + offset + sizeof(header);
+        if (header.type == stream::MessageType::Input && header.size >= sizeof(stream::InputEvent)) {
+            stream::InputEvent input;
+            std::memcpy(&input, payload, sizeof(input));
+            HandleInput(input, window);
+        } else if (header.type == stream::MessageType::FrameAck && header.size >= sizeof(stream::FrameAck)) {
+            stream::FrameAck ack;
+            std::memcpy(&ack, payload, sizeof(ack));
+            HandleAck(ack);
+        } else if (header.type == stream::MessageType::Hello && header.size >= sizeof(stream::ClientHello)) {
+            stream::ClientHello hello;
+            std::memcpy(&hello, payload, sizeof(hello));
+            m_ClientFormats = hello.formats | stream::FormatBit(stream::PixelFormat::NV12);
+        } else if (header.type == stream::MessageType::KeyFrameRequest) {
+            AwaitKeyFrame();
+        }
+        offset += sizeof(header) + header.size;
+    }
+    m_Received.erase(m_Received.begin(), m_Received.begin() + offset);
+}
+
+void StreamServer::Disconnect() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        // The sender thread may hold the socket still; it closes with the last reference
+        if (m_Client) {
+            m_Client->Shutdown();
+            m_Client.reset();
+        }
+        m_Queue.clear();
+        m_Sent.clear();
+    }
+    m_Received.clear();
+    m_ClientFormats = stream::FormatBit(stream::PixelFormat::NV12);
+    if (m_Connected.exchange(false)) {
+        METAGFX_INFO << "Stream client disconnected";
+    }
+
+    // Keys the client held would otherwise stay down
+    SDL_Event event{};
+    for (size_t scancode = 0; scancode < m_KeysDown.size(); ++scancode) {
+        if (!m_KeysDown[scancode]) {
+            continue;
+        }
+        m_KeysDown[scancode] = false;
+        event.type = SDL_EVENT_KEY_UP;
+        event.key.timestamp = SDL_GetTicksNS();
+        event.key.scancode = static_cast<SDL_Scancode>(scancode);
+        event.key.key = SDL_GetKeyFromScancode(event.key.scancode, SDL_KMOD_NONE, false);
+        event.key.down = false;
+        SDL_PushEvent(&event);
+    }
+}
+
+void StreamServer::HandleInput(const stream::InputEvent& input, SDL_Window* window) {
+    SDL_WindowID windowID = window ? SDL_GetWindowID(window) : 0;
+    SDL_Event event{};
+    switch (input.kind) {
+        case stream::InputKind::MouseMotion:
+            event.type = SDL_EVENT_MOUSE_MOTION;
+            event.motion.windowID = windowID;
+            event.motion.state = static_cast<SDL_MouseButtonFlags>(input.modifiers);
+            event.motion.x = input.x;
+            event.motion.y = input.y;
+            event.motion.xrel = input.deltaX;
+            event.motion.yrel = input.deltaY;
+            break;
+
+        case stream::InputKind::MouseButtonDown:
+        case stream::InputKind::MouseButtonUp:
+            event.type = input.kind == stream::InputKind::MouseButtonDown ? SDL_EVENT_MOUSE_BUTTON_DOWN
+                                                                          : SDL_EVENT_MOUSE_BUTTON_UP;
+            event.button.windowID = windowID;
+            event.button.button = static_cast<Uint8>(input.code);
+            event.button.down = input.kind == stream::InputKind::MouseButtonDown;
+            event.button.clicks = 1;
+            event.button.x = input.x;
+            event.button.y = input.y;
+            break;
+
+        case stream::InputKind::MouseWheel:
+            event.type = SDL_EVENT_MOUSE_WHEEL;
+            event.wheel.windowID = windowID;
+            event.wheel.x = input.x;
+            event.wheel.y = input.y;
+            event.wheel.direction = SDL_MOUSEWHEEL_NORMAL;
+            break;
+
+        case stream::InputKind::KeyDown:
+        case stream::InputKind::KeyUp:
+            if (input.code >= m_KeysDown.size()) {
+                return;
+            }
+            event.type = input.kind == stream::InputKind::KeyDown ? SDL_EVENT_KEY_DOWN : SDL_EVENT_KEY_UP;
+            event.key.windowID = windowID;
+            event.key.scancode = static_cast<SDL_Scancode>(input.code);
+            event.key.key = static_cast<SDL_Keycode>(input.keycode);
+            event.key.mod = static_cast<SDL_Keymod>(input.modifiers);
+            event.key.down = input.kind == stream::InputKind::KeyDown;
+            event.key.repeat = event.key.down && m_KeysDown[input.code];
+            m_KeysDown[input.code] = event.key.down;
+            break;
+
+        default:
+            return;
+    }
+    event.common.timestamp = SDL_GetTicksNS();
+    SDL_PushEvent(&event);
+}
+
+void StreamServer::HandleAck(const stream::FrameAck& ack) {
+    uint64 now = Profiler::Now();
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Frames sent before the acknowledged one were never shown
+    while (!m_Sent.empty() && m_Sent.front().frameNumber < ack.frameNumber) {
+        m_Sent.pop_front();
+    }
+    if (m_Sent.empty() || m_Sent.front().frameNumber != ack.frameNumber) {
+        return;
+    }
+    m_Stats.latencyMs = static_cast<float>(now - m_Sent.front().encodeTimeNs) / 1000000.0f;
+    m_Sent.pop_front();
+    METAGFX_PROFILE_COUNTER("Stream latency ms", m_Stats.latencyMs);
+}
+
+void StreamServer::AwaitKeyFrame() {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_AwaitingKeyFrame = true;
+    }
+    m_KeyFrameRequested = true;
+}
+
+void StreamServer::SubmitFrame(StreamEncoder::Frame&& frame) {
+    // From encode until the CPU has the bytes: the rest of the frame on the GPU, plus up
+    // to a frame until BeginFrame() finds it finished
+    METAGFX_PROFILE_COUNTER("Stream readback ms",
+                            static_cast<double>(Profiler::Now() - frame.encodeTimeNs) / 1000000.0);
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (!m_Client) {
+            return;
+        }
+        if (frame.format == stream::PixelFormat::H264) {
+            // The client cannot decode a frame without the ones it predicts from
+            if (frame.keyFrame) {
+                m_AwaitingKeyFrame = false;
+            } else if (m_AwaitingKeyFrame) {
+                ++m_Stats.framesDropped;
+                return;
+            }
+            if (m_Queue.size() >= m_MaxQueuedFrames) {
+                m_Stats.framesDropped += m_Queue.size();
+                m_Queue.clear();
+                if (!frame.keyFrame) {
+                    ++m_Stats.framesDropped;
+                    m_AwaitingKeyFrame = true;
+                    m_KeyFrameRequested = true;
+                    return;
+                }
+            }
+        }
+        while (m_Queue.size() >= m_MaxQueuedFrames) {
+            m_Queue.pop_front();
+            ++m_Stats.framesDropped;
+        }
+        m_Queue.push_back(std::move(frame));
+    }
+    m_FrameQueued.notify_one();
+}
+
+bool StreamServer::IsKeyDown(SDL_Scancode scancode) const {
+    return static_cast<size_t>(scancode) < m_KeysDown.size() && m_KeysDown[scancode];
+}
+
+bool StreamServer::ClientDecodes(stream::PixelFormat format) const {
+    return m_Connected && (m_ClientFormats & stream::FormatBit(format)) != 0;
+}
+
+StreamServer::Stats StreamServer::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Stats;
+}
+
+void StreamServer::SendThreadMain() {
+    METAGFX_PROFILE_THREAD("Stream");
+    while (true) {
+        StreamEncoder::Frame frame;
+        std::shared_ptr<Socket> client;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_FrameQueued.wait(lock, [this]() { return m_Stopping || !m_Queue.empty(); });
+            if (m_Stopping) {
+                return;
+            }
+            frame = std::move(m_Queue.front());
+            m_Queue.pop_front();
+            client = m_Client;
+            if (client) {
+                m_Sent.push_back({ frame.frameNumber, frame.encodeTimeNs });
+                if (m_Sent.size() > MAX_UNACKNOWLEDGED_FRAMES) {
+                    m_Sent.pop_front();
+                }
+            }
+        }
+        if (!client) {
+            continue;
+        }
+
+        uint64 start = Profiler::Now();
+        stream::FrameInfo info;
+        info.frameNumber = frame.frameNumber;
+        info.captureTimeNs = frame.encodeTimeNs;
+        info.width = frame.width;
+        info.height = frame.height;
+        info.pitch = frame.pitch;
+        info.format = frame.format;
+        stream::MessageHeader header;
+        header.type = stream::MessageType::Frame;
+        header.size = sizeof(info) + frame.data.size();
+
+        // Waits while the send buffer is full, which the dropped frames absorb
+        bool sent = [&]() {
+            METAGFX_PROFILE_SCOPE("Send frame");
+            return client->SendAll(&header, sizeof(header)) && client->SendAll(&info, sizeof(info)) &&
+                   client->SendAll(frame.data.data(), frame.data.size());
+        }();
+        if (!sent) {
+            m_SendFailed = true;
+            continue;
+        }
+
+        float sendMs = static_cast<float>(Profiler::Now() - start) / 1000000.0f;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Stats.sendMs = sendMs;
+            ++m_Stats.framesSent;
+        }
+        METAGFX_PROFILE_COUNTER("Stream send ms", sendMs);
+        METAGFX_PROFILE_COUNTER("Stream frame KB", static_cast<double>(frame.data.size()) / 1024.0);
+    }
+}
+
+} // namespace metagfx
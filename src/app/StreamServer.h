@@ -0,0 +1,109 @@
+// ============================================================================
+// src/app/StreamServer.h
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Socket.h"
+#include "metagfx/core/StreamProtocol.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/StreamEncoder.h"
+
+#include <SDL3/SDL.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace metagfx {
+
+/**
+ * @brief Sends StreamEncoder's frames to one remote client over TCP and takes its input
+ *
+ * Poll(), on the main thread from ProcessEvents(), accepts a client while none is
+ * connected and reads what it sent: input events are pushed onto SDL's queue, where the
+ * same poll handles them like local input, and held keys are kept for IsKeyDown()
+ * (SDL_GetKeyboardState() sees only the local keyboard). The client acknowledges each
+ * frame once it shows it, which gives the latency from encode to display.
+ *
+ * Frames are sent on a thread of the server's own, so a slow link never holds up a
+ * frame: at most maxQueuedFrames wait to be sent, the oldest dropped for a newer one.
+ * H.264 frames predict from the one before, so a drop discards the frames up to the next
+ * key frame instead and asks for one (TakeKeyFrameRequest()), as does a client that
+ * joins or reports it lost its place. The client's Hello names the formats it decodes
+ * (ClientDecodes()); one that sends none gets NV12.
+ */
+class StreamServer {
+public:
+    struct Stats {
+        float latencyMs = 0.0f;   // Encode to the client's acknowledgement, of the last acknowledged frame
+        float sendMs = 0.0f;      // Of the last frame sent
+        uint64 framesSent = 0;
+        uint64 framesDropped = 0; // Replaced in the queue before they were sent, or H.264 up to a key frame
+    };
+
+    StreamServer(uint16 port, uint32 maxQueuedFrames);
+    ~StreamServer();
+
+    StreamServer(const StreamServer&) = delete;
+    StreamServer& operator=(const StreamServer&) = delete;
+
+    bool IsListening() const { return m_Listener.IsValid(); }
+    bool IsConnected() const { return m_Connected; }
+
+    // Main thread: accepts a client, reads its messages and pushes its input as events
+    // of window
+    void Poll(SDL_Window* window);
+
+    // Queue a frame for the client; dropped when none is connected. Any thread.
+    void SubmitFrame(StreamEncoder::Frame&& frame);
+
+    // The client holds the key down
+    bool IsKeyDown(SDL_Scancode scancode) const;
+
+    // A client is connected and decodes format
+    bool ClientDecodes(stream::PixelFormat format) const;
+    // The stream needs a key frame, since the last call: a client joined, frames were
+    // dropped or the client asked for one. Any thread.
+    bool TakeKeyFrameRequest() { return m_KeyFrameRequested.exchange(false); }
+
+    Stats GetStats() const;
+
+private:
+    struct SentFrame {
+        uint64 frameNumber = 0;
+        uint64 encodeTimeNs = 0;
+    };
+
+    void SendThreadMain();
+    void Disconnect();
+    void HandleInput(const stream::InputEvent& input, SDL_Window* window);
+    void HandleAck(const stream::FrameAck& ack);
+    void AwaitKeyFrame();
+
+    Socket m_Listener;
+    uint32 m_MaxQueuedFrames = 2;
+
+    // Shared with the sender thread, which sends outside the lock
+    mutable std::mutex m_Mutex;
+    std::condition_variable m_FrameQueued;
+    std::shared_ptr<Socket> m_Client;
+    std::deque<StreamEncoder::Frame> m_Queue;
+    std::deque<SentFrame> m_Sent;     // Awaiting acknowledgement, oldest first
+    Stats m_Stats;
+    bool m_Stopping = false;
+    bool m_AwaitingKeyFrame = false;  // H.264 frames are dropped until a key frame
+    std::atomic<bool> m_Connected{ false };
+    std::atomic<bool> m_SendFailed{ false };
+    std::atomic<bool> m_KeyFrameRequested{ false };
+    std::atomic<uint32> m_ClientFormats{ stream::FormatBit(stream::PixelFormat::NV12) };
+    std::thread m_SendThread;
+
+    // Main thread
+    std::vector<uint8> m_Received;    // Bytes of messages not complete yet
+    std::vector<bool> m_KeysDown;     // By SDL_Scancode
+};
+
+} // namespace metagfx
@@ -0,0 +1,372 @@
+// ============================================================================
+// src/app/bench_main.cpp
+// ============================================================================
+#include "Application.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Platform.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Types.h"
+#include "metagfx/scene/SceneDescription.h"
+#include "metagfx/utils/AssetArchive.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void PrintUsage() {
+    METAGFX_INFO << "Usage: metagfx_bench [options]";
+    METAGFX_INFO << "  --backend vulkan|metal|webgpu  Graphics API (default: vulkan)";
+    METAGFX_INFO << "  --gpu N|NAME                   GPU to run on: index of --list-gpus, or part of its name (default: the best one)";
+    METAGFX_INFO << "  --list-gpus                    Print the backend's GPUs and exit";
+    METAGFX_INFO << "  --scene PATH                   Scene file: model, instances, lights, environment, camera path";
+    METAGFX_INFO << "  --model PATH                   Model to render without a scene file (default: a unit cube)";
+    METAGFX_INFO << "  --archive PATH                 Asset archive (tools/asset_pack) to load files from first; repeatable";
+    METAGFX_INFO << "  --grid N                       N x N copies of the model, drawn instanced (default: 1)";
+    METAGFX_INFO << "  --frames N                     Measured frames, one orbit or camera path loop (default: 600)";
+    METAGFX_INFO << "  --warmup N                     Unmeasured frames first (default: 60)";
+    METAGFX_INFO << "  --width W --height H           Render target size (default: 1280x720)";
+    METAGFX_INFO << "  --frames-in-flight N           1-3 (default: 2)";
+    METAGFX_INFO << "  --shadow-filter MODE           hardware|pcf|poisson|pcss|evsm (default: by GPU)";
+    METAGFX_INFO << "  --depth-prepass MODE           off|on|auto (default: auto, timed over the first 120 frames)";
+    METAGFX_INFO << "  --render-mode MODE             forward|deferred|visibility|pathtraced (default: forward)";
+    METAGFX_INFO << "  --shading-precision MODE       full|half|auto: fp32 or fp16 forward shading (default: auto, by GPU)";
+    METAGFX_INFO << "  --vertex-pulling               Pooled models fetch vertices from storage buffers";
+    METAGFX_INFO << "  --shadow-depth 16|32           Bits of the shadow map and atlas depth (default: 32)";
+    METAGFX_INFO << "  --output PATH                  Results file (default: metagfx_bench.json)";
+    METAGFX_INFO << "  --max-frame-allocations N      Fail when a measured frame allocates more than N times while";
+    METAGFX_INFO << "                                 rendering (needs METAGFX_TRACK_ALLOCATIONS; 0: none allowed)";
+    METAGFX_INFO << "Batch rendering (instead of the benchmark):";
+    METAGFX_INFO << "  --batch DIR                    Render the scene's views into image files in DIR";
+    METAGFX_INFO << "  --views PATH                   Views to render, as JSON (default: the scene's camera path or a turntable)";
+    METAGFX_INFO << "  --turntable N                  Views of the turntable around the scene (default: 36)";
+    METAGFX_INFO << "  --format png|exr               Tone-mapped 8-bit PNG or linear half-float EXR (default: png)";
+    METAGFX_INFO << "  --settle N                     Frames rendered per view, the last one written (default: by renderer)";
+    METAGFX_INFO << "  --gpus all|N,M,...             Split the views between these GPUs, one process each on its own device";
+    METAGFX_INFO << "  --shard K/N                    Render only views K, K + N, ... (0-based), e.g. one node's share";
+}
+
+void PrintAdapters(metagfx::rhi::GraphicsAPI api) {
+    std::vector<metagfx::rhi::AdapterInfo> adapters = metagfx::rhi::EnumerateAdapters(api);
+    if (adapters.empty()) {
+        METAGFX_INFO << "No GPUs listed for this backend";
+    }
+    for (size_t i = 0; i < adapters.size(); ++i) {
+        const metagfx::rhi::AdapterInfo& adapter = adapters[i];
+        METAGFX_INFO << "  " << i << ": " << adapter.name << " (" << (adapter.deviceMemory >> 20) << " MB"
+                     << (adapter.isSoftware ? ", software" : adapter.isIntegratedGPU ? ", integrated" : "") << ")";
+    }
+}
+
+std::string Quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// --gpus: runs this executable once per GPU at the same time, each on its own device with
+// a shard of the views. The devices share nothing; each run writes its images to the
+// output directory itself and its log next to them.
+bool RunBatchOnGpus(const std::string& executable, const std::vector<std::string>& args,
+                    const std::vector<metagfx::uint32>& gpus, const std::string& outputDirectory) {
+    std::error_code error;
+    std::filesystem::create_directories(outputDirectory, error);
+    if (error) {
+        METAGFX_ERROR << "Failed to create " << outputDirectory << ": " << error.message();
+        return false;
+    }
+
+    METAGFX_INFO << "Batch render on " << gpus.size() << " GPUs";
+    std::atomic<size_t> failed{ 0 };
+    std::vector<std::thread> runs;
+    for (size_t shard = 0; shard < gpus.size(); ++shard) {
+        std::string log = (std::filesystem::path(outputDirectory) /
+                           ("gpu_" + std::to_string(gpus[shard]) + ".log")).string();
+        std::string command = Quote(executable);
+        for (const std::string& arg : args) {
+            command += " " + Quote(arg);
+        }
+        command += " --gpu " + std::to_string(gpus[shard]) + " --shard " + std::to_string(shard) + "/" +
+                   std::to_string(gpus.size()) + " > " + Quote(log) + " 2>&1";
+#ifdef _WIN32
+        // cmd.exe strips the outer quotes of a command line that starts with one
+        command = "\"" + command + "\"";
+#endif
+        runs.emplace_back([command, log, gpu = gpus[shard], &failed]() {
+            int status = std::system(command.c_str());
+            if (status != 0) {
+                METAGFX_ERROR << "Batch render on GPU " << gpu << " failed (status " << status << "), see " << log;
+                ++failed;
+            } else {
+                METAGFX_INFO << "Batch render on GPU " << gpu << " done";
+            }
+        });
+    }
+    for (std::thread& run : runs) {
+        run.join();
+    }
+    return failed == 0;
+}
+
+} // anonymous namespace
+
+// Renders a fixed camera path on a hidden window into offscreen targets and writes CPU
+// and GPU frame-time percentiles as JSON; with --batch, renders views into image files
+// instead. Exits with 1 when the run could not complete.
+int main(int argc, char* argv[]) {
+    metagfx::Logger::Init();
+
+    METAGFX_INFO << "MetaGFX benchmark - Platform: " << metagfx::PlatformUtils::GetPlatformName();
+
+    metagfx::ApplicationConfig config;
+    config.title = "MetaGFX Benchmark";
+    config.benchmark.enabled = true;
+    config.pipelineCachePath.clear();  // Every run compiles its pipelines alike
+    bool listAdapters = false;
+    bool gpuGiven = false;
+    std::string gpuList;                // --gpus
+    std::vector<std::string> shardArgs; // The arguments for each GPU's run: all but --gpus
+
+    for (int i = 1; i < argc; ++i) {
+        int first = i;
+        std::string arg = argv[i];
+        if (arg == "--gpus" && i + 1 < argc) {
+            gpuList = argv[++i];
+            continue;
+        }
+        if (arg == "--backend" && i + 1 < argc) {
+            std::string backend = argv[++i];
+            if (backend == "vulkan") {
+                config.graphicsAPI = metagfx::rhi::GraphicsAPI::Vulkan;
+            } else if (backend == "metal") {
+                config.graphicsAPI = metagfx::rhi::GraphicsAPI::Metal;
+            } else if (backend == "webgpu") {
+                config.graphicsAPI = metagfx::rhi::GraphicsAPI::WebGPU;
+            } else {
+                METAGFX_ERROR << "Unknown backend '" << backend << "'";
+                return 1;
+            }
+        } else if (arg == "--gpu" && i + 1 < argc) {
+            gpuGiven = true;
+            std::string gpu = argv[++i];
+            if (!gpu.empty() && gpu.find_first_not_of("0123456789") == std::string::npos) {
+                config.adapterIndex = static_cast<metagfx::uint32>(std::atoi(gpu.c_str()));
+            } else {
+                config.adapterName = gpu;
+            }
+        } else if (arg == "--list-gpus") {
+            listAdapters = true;
+        } else if (arg == "--scene" && i + 1 < argc) {
+            config.scenePath = argv[++i];
+        } else if (arg == "--archive" && i + 1 < argc) {
+            if (!metagfx::utils::AssetArchive::Mount(argv[++i])) {
+                return 1;
+            }
+        } else if (arg == "--model" && i + 1 < argc) {
+            config.benchmark.modelPath = argv[++i];
+        } else if (arg == "--grid" && i + 1 < argc) {
+            config.benchmark.instanceGrid = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            config.benchmark.frames = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            config.benchmark.warmupFrames = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--width" && i + 1 < argc) {
+            config.width = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--height" && i + 1 < argc) {
+            config.height = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--frames-in-flight" && i + 1 < argc) {
+            config.framesInFlight = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--shadow-filter" && i + 1 < argc) {
+            std::string filter = argv[++i];
+            if (filter == "hardware") {
+                config.shadowFilter = metagfx::ShadowFilter::Hardware;
+            } else if (filter == "pcf") {
+                config.shadowFilter = metagfx::ShadowFilter::PCF;
+            } else if (filter == "poisson") {
+                config.shadowFilter = metagfx::ShadowFilter::Poisson;
+            } else if (filter == "pcss") {
+                config.shadowFilter = metagfx::ShadowFilter::PCSS;
+            } else if (filter == "evsm") {
+                config.shadowFilter = metagfx::ShadowFilter::EVSM;
+            } else {
+                METAGFX_ERROR << "Unknown shadow filter '" << filter << "'";
+                return 1;
+            }
+        } else if (arg == "--depth-prepass" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "off") {
+                config.depthPrepass = metagfx::DepthPrepassMode::Off;
+            } else if (mode == "on") {
+                config.depthPrepass = metagfx::DepthPrepassMode::On;
+            } else if (mode == "auto") {
+                config.depthPrepass = metagfx::DepthPrepassMode::Auto;
+            } else {
+                METAGFX_ERROR << "Unknown depth prepass mode '" << mode << "'";
+                return 1;
+            }
+        } else if (arg == "--render-mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode == "forward") {
+                config.renderMode = metagfx::RenderMode::Rasterization;
+            } else if (mode == "deferred") {
+                config.renderMode = metagfx::RenderMode::Deferred;
+            } else if (mode == "visibility") {
+                config.renderMode = metagfx::RenderMode::VisibilityBuffer;
+            } else if (mode == "pathtraced") {
+                config.renderMode = metagfx::RenderMode::PathTracing;
+            } else {
+                METAGFX_ERROR << "Unknown render mode '" << mode << "'";
+                return 1;
+            }
+        } else if (arg == "--shading-precision" && i + 1 < argc) {
+            std::string precision = argv[++i];
+            if (precision == "full") {
+                config.shadingPrecision = metagfx::ShadingPrecision::Full;
+            } else if (precision == "half") {
+                config.shadingPrecision = metagfx::ShadingPrecision::Half;
+            } else if (precision == "auto") {
+                config.shadingPrecision = metagfx::ShadingPrecision::Auto;
+            } else {
+                METAGFX_ERROR << "Unknown shading precision '" << precision << "'";
+                return 1;
+            }
+        } else if (arg == "--vertex-pulling") {
+            config.vertexPulling = true;
+        } else if (arg == "--shadow-depth" && i + 1 < argc) {
+            std::string bits = argv[++i];
+            if (bits == "16" || bits == "32") {
+                config.shadowDepth16 = bits == "16";
+            } else {
+                METAGFX_ERROR << "Unknown shadow depth '" << bits << "'";
+                return 1;
+            }
+        } else if (arg == "--output" && i + 1 < argc) {
+            config.benchmark.outputPath = argv[++i];
+        } else if (arg == "--max-frame-allocations" && i + 1 < argc) {
+            config.benchmark.maxFrameAllocations = std::atoll(argv[++i]);
+        } else if (arg == "--batch" && i + 1 < argc) {
+            config.batch.enabled = true;
+            config.batch.outputDirectory = argv[++i];
+        } else if (arg == "--views" && i + 1 < argc) {
+            config.batch.viewsPath = argv[++i];
+        } else if (arg == "--turntable" && i + 1 < argc) {
+            config.batch.turntableViews = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--format" && i + 1 < argc) {
+            std::string format = argv[++i];
+            if (format == "png") {
+                config.batch.format = metagfx::BatchConfig::ImageFormat::PNG;
+            } else if (format == "exr") {
+                config.batch.format = metagfx::BatchConfig::ImageFormat::EXR;
+            } else {
+                METAGFX_ERROR << "Unknown image format '" << format << "'";
+                return 1;
+            }
+        } else if (arg == "--settle" && i + 1 < argc) {
+            config.batch.settleFrames = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--shard" && i + 1 < argc) {
+            std::string shard = argv[++i];
+            size_t slash = shard.find('/');
+            int index = std::atoi(shard.substr(0, slash).c_str());
+            int count = slash == std::string::npos ? 0 : std::atoi(shard.substr(slash + 1).c_str());
+            if (count < 1 || index < 0 || index >= count) {
+                METAGFX_ERROR << "Invalid shard '" << shard << "': expected K/N with 0 <= K < N";
+                return 1;
+            }
+            config.batch.shardIndex = static_cast<metagfx::uint32>(index);
+            config.batch.shardCount = static_cast<metagfx::uint32>(count);
+        } else {
+            PrintUsage();
+            return arg == "--help" ? 0 : 1;
+        }
+        shardArgs.insert(shardArgs.end(), argv + first, argv + i + 1);
+    }
+
+    if (config.batch.enabled) {
+        config.title = "MetaGFX Batch";
+        config.benchmark.enabled = false;
+    }
+
+    if (listAdapters) {
+        PrintAdapters(config.graphicsAPI);
+        metagfx::Logger::Shutdown();
+        return 0;
+    }
+
+    if (!gpuList.empty()) {
+        if (!config.batch.enabled || gpuGiven || config.batch.shardCount > 1) {
+            METAGFX_ERROR << "--gpus splits a --batch render, and takes the place of --gpu and --shard";
+            return 1;
+        }
+        std::vector<metagfx::uint32> gpus;
+        size_t adapterCount = metagfx::rhi::EnumerateAdapters(config.graphicsAPI).size();
+        if (gpuList == "all") {
+            for (size_t i = 0; i < adapterCount; ++i) {
+                gpus.push_back(static_cast<metagfx::uint32>(i));
+            }
+        } else {
+            for (size_t start = 0; start < gpuList.size();) {
+                size_t end = std::min(gpuList.find(',', start), gpuList.size());
+                std::string gpu = gpuList.substr(start, end - start);
+                if (gpu.empty() || gpu.find_first_not_of("0123456789") != std::string::npos ||
+                    static_cast<size_t>(std::atoi(gpu.c_str())) >= adapterCount) {
+                    METAGFX_ERROR << "Unknown GPU '" << gpu << "' (--list-gpus lists them)";
+                    return 1;
+                }
+                gpus.push_back(static_cast<metagfx::uint32>(std::atoi(gpu.c_str())));
+                start = end + 1;
+            }
+        }
+        if (gpus.empty()) {
+            METAGFX_ERROR << "No GPUs to render on";
+            return 1;
+        }
+        bool completed = RunBatchOnGpus(argv[0], shardArgs, gpus, config.batch.outputDirectory);
+        metagfx::utils::AssetArchive::UnmountAll();
+        metagfx::Logger::Shutdown();
+        return completed ? 0 : 1;
+    }
+
+    // The viewer falls back to a cube when a model fails to load; a benchmark must not
+    auto modelExists = [](const std::string& path) {
+        return metagfx::utils::AssetArchive::FindMounted(path) || std::filesystem::exists(path);
+    };
+    if (!config.scenePath.empty()) {
+        metagfx::SceneDescription scene;
+        std::string error;
+        if (!metagfx::SceneDescription::Load(config.scenePath, scene, &error)) {
+            METAGFX_ERROR << "Failed to load scene " << config.scenePath << ": " << error;
+            return 1;
+        }
+        if (!scene.modelPath.empty() && !modelExists(scene.modelPath)) {
+            METAGFX_ERROR << "Model of " << config.scenePath << " not found: " << scene.modelPath;
+            return 1;
+        }
+    } else if (!config.benchmark.modelPath.empty() && !modelExists(config.benchmark.modelPath)) {
+        METAGFX_ERROR << "Model not found: " << config.benchmark.modelPath;
+        return 1;
+    }
+
+    metagfx::JobSystem::Init();
+
+    bool completed = false;
+    {
+        metagfx::Application app(config);
+        completed = config.batch.enabled ? app.RunBatch() : app.RunBenchmark();
+    }
+
+    metagfx::utils::AssetArchive::UnmountAll();
+    metagfx::JobSystem::Shutdown();
+    metagfx::Logger::Shutdown();
+
+    return completed ? 0 : 1;
+}
@@ -0,0 +1,20 @@
+#version 450
+
+// Deferred composite (DeferredLighting): the lit color into the HDR scene color and the
+// G-buffer pass's depth into the pass's depth attachment, pixel for pixel, so forward
+// draws after it are depth tested against the model. Sky pixels keep the clear.
+
+layout(binding = 0) uniform sampler2D litColorSampler;
+layout(binding = 1) uniform sampler2D depthSampler;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(depthSampler, pixel, 0).r;
+    if (depth <= 0.0) {  // Reverse-Z: nothing drawn
+        discard;
+    }
+    gl_FragDepth = depth;
+    outColor = texelFetch(litColorSampler, pixel, 0);
+}
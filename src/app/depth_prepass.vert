@@ -0,0 +1,47 @@
+#version 450
+
+// Depth prepass vertex shader - the camera's depth of the model before the lit pass.
+// Built again as pick.vert with OBJECT_PICKING, passing the world position to pick.frag.
+
+// Same prefix as the model pass's UniformBufferObject
+layout(binding = 0) uniform DepthPrepassUBO {
+    mat4 model;       // Model matrix (with the dequantization of compact models)
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+} ubo;
+
+// World and normal matrix of each scene graph node (same buffer as the model pass)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;  // Inverse transpose of mat3(world), as vec4 columns
+};
+layout(binding = 1) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// Node of each instance (same buffer as the model pass)
+layout(binding = 2) readonly buffer InstanceNodes {
+    uint instanceNodes[];
+};
+
+// Input vertex attributes: the position only, full-float or compact unorm
+layout(location = 0) in vec3 inPosition;
+
+#ifdef OBJECT_PICKING
+layout(location = 0) out vec3 fragWorldPos;
+#endif
+
+// Must match model.vert and model_compact.vert bit for bit: the lit pass tests its
+// fragments against this depth with LessOrEqual
+invariant gl_Position;
+
+void main() {
+    // The model pass's expressions, in its order
+    mat4 model = ubo.model * nodeTransforms[instanceNodes[gl_InstanceIndex]].world;
+    vec4 worldPos = model * vec4(inPosition, 1.0);
+    gl_Position = ubo.viewProjection * worldPos;
+#ifdef OBJECT_PICKING
+    fragWorldPos = worldPos.xyz;
+#endif
+}
@@ -0,0 +1,10 @@
+#version 450
+
+// One triangle over the viewport, made from the vertex index: no vertex buffer is bound.
+// The vertex stage of the deferred composite (DeferredLighting) and the tone mapping pass
+// (ToneMapper).
+
+void main() {
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+    gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,120 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// G-buffer of the deferred path: model.frag's material inputs, packed into one texel for
+// deferred_lighting.comp (DeferredLighting on the CPU describes the layout). Sets as
+// model.frag's; this stage only reads the per-material set 2.
+
+// Inputs from vertex shader
+layout(location = 0) in vec3 fragPosition;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec2 fragTexCoord;
+layout(location = 3) in vec4 fragTangent;  // World space; w is the bitangent's sign
+
+// Material uniform (48 bytes for std140 alignment)
+layout(set = 2, binding = 1) uniform MaterialUBO {
+    vec3 albedo;       // 12 bytes (offset 0)
+    float roughness;   // 4 bytes  (offset 12)
+    float metallic;    // 4 bytes  (offset 16)
+    float alpha;       // 4 bytes  (offset 20)
+    float alphaCutoff; // 4 bytes  (offset 24)
+    float padding1;    // 4 bytes  (offset 28)
+    vec3 emissiveFactor; // 12 bytes (offset 32)
+    float padding2;    // 4 bytes  (offset 44)
+} material;
+
+// PBR texture samplers
+layout(set = 2, binding = 2) uniform sampler2D albedoSampler;
+layout(set = 2, binding = 4) uniform sampler2D normalSampler;
+layout(set = 2, binding = 5) uniform sampler2D metallicSampler;
+layout(set = 2, binding = 6) uniform sampler2D roughnessSampler;
+layout(set = 2, binding = 7) uniform sampler2D aoSampler;
+layout(set = 2, binding = 11) uniform sampler2D emissiveSampler;
+
+// Per-material push constants (ModelPushConstants on the CPU)
+layout(push_constant) uniform PushConstants {
+    uint materialFlags;
+} pushConstants;
+
+// x: albedo and AO, y: octahedral normal, z: emissive rg, w: emissive b, metallic, roughness
+layout(location = 0) out uvec4 outGBuffer;
+
+#include "normal_mapping.glsl"
+
+// Unit vector to the [-1, 1] square: the octahedron's upper half in the middle, the lower
+// half folded over the corners
+vec2 encodeOctahedral(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return e;
+}
+
+void main() {
+    uint materialFlags = pushConstants.materialFlags;
+
+    vec3 albedo;
+    float alpha = material.alpha;
+    if ((materialFlags & (1u << 0)) != 0u) {  // HasAlbedoMap
+        vec4 albedoSample = texture(albedoSampler, fragTexCoord);
+        albedo = albedoSample.rgb;
+        alpha *= albedoSample.a;
+    } else {
+        albedo = material.albedo;
+    }
+
+    // Masked materials drop their fragments below the cutoff; blended ones are drawn
+    // forward after the lighting, not into the G-buffer
+    if ((materialFlags & (1u << 7)) != 0u && alpha < material.alphaCutoff) {
+        discard;
+    }
+
+    vec3 N;
+    if ((materialFlags & (1u << 1)) != 0u) {  // HasNormalMap
+        N = getNormalFromMap(fragTexCoord, fragNormal, fragTangent);
+    } else {
+        N = normalize(fragNormal);
+    }
+
+    float metallic;
+    float roughness;
+    float ao;
+    if ((materialFlags & (1u << 4)) != 0u) {  // HasMetallicRoughnessMap (glTF: R=AO, G=roughness, B=metallic)
+        vec3 mrSample = texture(metallicSampler, fragTexCoord).rgb;
+        ao = mrSample.r;
+        roughness = mrSample.g;
+        metallic = mrSample.b;
+    } else {
+        if ((materialFlags & (1u << 2)) != 0u) {  // HasMetallicMap
+            metallic = texture(metallicSampler, fragTexCoord).r;
+        } else {
+            metallic = material.metallic;
+        }
+        if ((materialFlags & (1u << 3)) != 0u) {  // HasRoughnessMap
+            roughness = texture(roughnessSampler, fragTexCoord).r;
+        } else {
+            roughness = material.roughness;
+        }
+        if ((materialFlags & (1u << 5)) != 0u) {  // HasAOMap
+            ao = texture(aoSampler, fragTexCoord).r;
+        } else {
+            ao = 1.0;
+        }
+    }
+    roughness = max(roughness, 0.04);
+
+    vec3 emissive;
+    if ((materialFlags & (1u << 6)) != 0u) {  // HasEmissiveMap
+        emissive = texture(emissiveSampler, fragTexCoord).rgb * material.emissiveFactor;
+    } else {
+        emissive = material.emissiveFactor;
+    }
+
+    outGBuffer.x = packUnorm4x8(vec4(albedo, ao));
+    outGBuffer.y = packSnorm2x16(encodeOctahedral(N));
+    outGBuffer.z = packHalf2x16(emissive.rg);
+    outGBuffer.w = (packHalf2x16(vec2(emissive.b, 0.0)) & 0xFFFFu) |
+                   (packUnorm4x8(vec4(0.0, 0.0, metallic, roughness)) & 0xFFFF0000u);
+}
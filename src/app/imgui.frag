@@ -0,0 +1,14 @@
+#version 450
+
+// Dear ImGui's vertex color, modulated by the font atlas (white where there is no glyph)
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) in vec4 fragColor;
+
+layout(location = 0) out vec4 outColor;
+
+layout(binding = 0) uniform sampler2D fontAtlas;
+
+void main() {
+    outColor = fragColor * texture(fontAtlas, fragTexCoord);
+}
@@ -0,0 +1,16 @@
+#version 450
+
+// Dear ImGui's vertices, positioned in clip space by ImGuiRenderer on the CPU
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec4 inColor;  // RGBA8 unorm
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) out vec4 fragColor;
+
+void main() {
+    fragTexCoord = inTexCoord;
+    fragColor = inColor;
+    gl_Position = vec4(inPosition, 0.0, 1.0);
+}
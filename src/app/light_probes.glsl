@@ -0,0 +1,79 @@
+// Diffuse irradiance as L2 spherical harmonics: the environment's (irradianceSH) and the
+// scene's light probes (lightProbes), whose bindings the includer declares.
+
+// The irradiance at a unit normal, never negative (the clamp hides ringing)
+vec3 EvaluateIrradianceSH(vec3 n) {
+    vec3 irradiance = irradianceSH.coefficients[0].rgb
+                    + irradianceSH.coefficients[1].rgb * n.y
+                    + irradianceSH.coefficients[2].rgb * n.z
+                    + irradianceSH.coefficients[3].rgb * n.x
+                    + irradianceSH.coefficients[4].rgb * (n.x * n.y)
+                    + irradianceSH.coefficients[5].rgb * (n.y * n.z)
+                    + irradianceSH.coefficients[6].rgb * (3.0 * n.z * n.z - 1.0)
+                    + irradianceSH.coefficients[7].rgb * (n.x * n.z)
+                    + irradianceSH.coefficients[8].rgb * (n.x * n.x - n.y * n.y);
+    return max(irradiance, vec3(0.0));
+}
+
+// The irradiance probes around position blended into one set of coefficients: the eight
+// of its grid cell by distance, by their side of the surface and by their validity.
+// Returns how much of the blend valid probes make up, 0 outside the grid, with the volume
+// off or among probes inside geometry, where the environment's irradiance stays.
+float BlendLightProbes(vec3 position, vec3 N, out vec3 coefficients[9]) {
+    for (int c = 0; c < 9; c++) {
+        coefficients[c] = vec3(0.0);
+    }
+    if (lightProbes.gridOrigin.w == 0.0) {
+        return 0.0;
+    }
+    uvec3 counts = lightProbes.gridCounts.xyz;
+    vec3 gridPosition = (position - lightProbes.gridOrigin.xyz) / lightProbes.gridSpacing.xyz;
+    if (any(lessThan(gridPosition, vec3(0.0))) || any(greaterThan(gridPosition, vec3(counts - 1u)))) {
+        return 0.0;
+    }
+    ivec3 cell = min(ivec3(gridPosition), ivec3(counts) - 2);
+    vec3 t = gridPosition - vec3(cell);
+
+    float coverage = 0.0;
+    float totalWeight = 0.0;
+    for (int i = 0; i < 8; i++) {
+        ivec3 offset = ivec3(i & 1, (i >> 1) & 1, i >> 2);
+        uvec3 probeCoords = uvec3(cell + offset);
+        uint probe = probeCoords.x + counts.x * (probeCoords.y + counts.y * probeCoords.z);
+        vec3 trilinear = mix(1.0 - t, t, vec3(offset));
+        float weight = trilinear.x * trilinear.y * trilinear.z * max(lightProbes.probes[probe * 9u].w, 0.0);
+        coverage += weight;
+
+        // Probes behind the surface see its other side; a little of them stays, so thin
+        // walls leave no holes (Majercik et al., "Dynamic Diffuse Global Illumination with
+        // Ray-Traced Irradiance Fields")
+        vec3 toProbe = lightProbes.gridOrigin.xyz + vec3(probeCoords) * lightProbes.gridSpacing.xyz - position;
+        float facing = dot(normalize(toProbe + N * 1.0e-4), N) * 0.5 + 0.5;
+        weight *= facing * facing + 0.2;
+        for (uint c = 0u; c < 9u; c++) {
+            coefficients[c] += lightProbes.probes[probe * 9u + c].rgb * weight;
+        }
+        totalWeight += weight;
+    }
+    if (totalWeight <= 1.0e-4) {
+        return 0.0;
+    }
+    for (int c = 0; c < 9; c++) {
+        coefficients[c] /= totalWeight;
+    }
+    return coverage;
+}
+
+// BlendLightProbes()'s irradiance at a unit normal, as EvaluateIrradianceSH()
+vec3 EvaluateLightProbes(vec3 coefficients[9], vec3 n) {
+    vec3 irradiance = coefficients[0]
+                    + coefficients[1] * n.y
+                    + coefficients[2] * n.z
+                    + coefficients[3] * n.x
+                    + coefficients[4] * (n.x * n.y)
+                    + coefficients[5] * (n.y * n.z)
+                    + coefficients[6] * (3.0 * n.z * n.z - 1.0)
+                    + coefficients[7] * (n.x * n.z)
+                    + coefficients[8] * (n.x * n.x - n.y * n.y);
+    return max(irradiance, vec3(0.0));
+}
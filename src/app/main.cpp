@@ -2,9 +2,12 @@
 // src/app/main.cpp
 // ============================================================================
 #include "Application.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Logger.h"
 #include "metagfx/core/Platform.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/utils/AssetArchive.h"
+#include <cstdlib>
 #include <fstream>
 #include <string>
 
@@ -45,8 +48,6 @@ metagfx::rhi::GraphicsAPI LoadBackendPreference() {
 } // anonymous namespace
 
 int main(int argc, char* argv[]) {
-    (void)argc;
-    (void)argv;
 
     // Initialize logger
     metagfx::Logger::Init();
@@ -57,20 +58,147 @@ int main(int argc, char* argv[]) {
     METAGFX_INFO << "  Platform: " << metagfx::PlatformUtils::GetPlatformName();
     METAGFX_INFO << "===========================================";
 
+    // Worker threads for loading, transform propagation and command recording
+    metagfx::JobSystem::Init();
+
     // Create and run application
     {
         metagfx::ApplicationConfig config;
         config.title = "MetaGFX";
         config.width = 1280;
         config.height = 720;
-        config.vsync = true;
         config.graphicsAPI = LoadBackendPreference();
 
+        // --pipelined: simulate the next frame while a render thread records this one
+        // --frames-in-flight N: frames the CPU may record ahead of the GPU (1-3)
+        // --present-mode fifo|fifo-relaxed|mailbox|immediate
+        // --jit-input: poll input only once the previous frame has been displayed
+        // --on-demand: draw only when something changed, refining the still image, and sleep otherwise
+        // --pipeline-cache PATH: Vulkan pipeline cache file ("" keeps it in memory)
+        // --hot-reload-shaders: recompile and swap in shaders when their GLSL is saved
+        // --shader-dir DIR: GLSL sources to watch (default: src/app of the build's source tree)
+        // --target-gpu-ms MS: dynamic resolution holds the GPU frame time under MS (with temporal AA)
+        // --texture-streaming N: load KTX2/DDS textures up to N texels per side, stream the rest (0: off)
+        // --scene PATH: scene file of the model, its instances, lights, environment and camera
+        // --world-distance D: load the scene file's cells within D of the camera (default 100)
+        // --world-budget MB: memory of resident cells (default: half of the device's free budget)
+        // --archive PATH: asset archive (tools/asset_pack) whose files are read before loose ones; repeatable
+        // --gpu N|NAME: run on GPU N of the backend, or the first whose name contains NAME
+        //   (default: the best one; metagfx_bench --list-gpus lists them)
+        // --shading-precision full|half|auto: fp32 or fp16 color and BRDF math (default: auto, by GPU)
+        // --vertex-pulling: pooled models fetch their vertices from storage buffers, not vertex input
+        // --shadow-depth 16|32: bits of the shadow map and atlas depth (default 32)
+        // --stream [PORT]: render offscreen and stream the frames to tools/stream_client
+        //   over TCP (default port 7420), taking its input
+        // --stream-bitrate KBPS: of the stream's H.264 (default 20000)
+        // --stream-raw: stream uncompressed NV12, even where the platform encodes H.264
+        // --capture PATH: write every RHI call to a trace for tools/rhi_replay
+        // --capture-frames N: close the trace after N presented frames (default: at exit)
+        // --hitch-dumps [DIR]: write the traces and statistics around frames over twice the
+        //   median frame time to DIR (default: hitches)
+        // --hitch-threshold X: a hitch is a frame over X times the median (default 2)
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            if (arg == "--pipelined") {
+                config.pipelinedRendering = true;
+            } else if (arg == "--frames-in-flight" && i + 1 < argc) {
+                config.framesInFlight = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+            } else if (arg == "--present-mode" && i + 1 < argc) {
+                std::string mode = argv[++i];
+                if (mode == "fifo") {
+                    config.presentMode = metagfx::rhi::PresentMode::Fifo;
+                } else if (mode == "fifo-relaxed") {
+                    config.presentMode = metagfx::rhi::PresentMode::FifoRelaxed;
+                } else if (mode == "mailbox") {
+                    config.presentMode = metagfx::rhi::PresentMode::Mailbox;
+                } else if (mode == "immediate") {
+                    config.presentMode = metagfx::rhi::PresentMode::Immediate;
+                } else {
+                    METAGFX_WARN << "Unknown present mode '" << mode << "'";
+                }
+            } else if (arg == "--jit-input") {
+                config.justInTimeInput = true;
+            } else if (arg == "--on-demand") {
+                config.onDemandRendering = true;
+            } else if (arg == "--pipeline-cache" && i + 1 < argc) {
+                config.pipelineCachePath = argv[++i];
+            } else if (arg == "--hot-reload-shaders") {
+                config.shaderHotReload = true;
+            } else if (arg == "--shader-dir" && i + 1 < argc) {
+                config.shaderSourceDirectory = argv[++i];
+            } else if (arg == "--target-gpu-ms" && i + 1 < argc) {
+                config.targetGpuFrameMs = static_cast<float>(std::atof(argv[++i]));
+            } else if (arg == "--texture-streaming" && i + 1 < argc) {
+                config.modelImport.textureStreamingExtent = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+            } else if (arg == "--scene" && i + 1 < argc) {
+                config.scenePath = argv[++i];
+            } else if (arg == "--world-distance" && i + 1 < argc) {
+                config.worldPartition.loadDistance = static_cast<float>(std::atof(argv[++i]));
+                config.worldPartition.unloadDistance = config.worldPartition.loadDistance * 1.25f;
+            } else if (arg == "--world-budget" && i + 1 < argc) {
+                config.worldPartition.budgetBytes =
+                    static_cast<metagfx::uint64>(std::atoll(argv[++i])) * 1024 * 1024;
+            } else if (arg == "--archive" && i + 1 < argc) {
+                metagfx::utils::AssetArchive::Mount(argv[++i]);
+            } else if (arg == "--gpu" && i + 1 < argc) {
+                std::string gpu = argv[++i];
+                if (!gpu.empty() && gpu.find_first_not_of("0123456789") == std::string::npos) {
+                    config.adapterIndex = static_cast<metagfx::uint32>(std::atoi(gpu.c_str()));
+                } else {
+                    config.adapterName = gpu;
+                }
+            } else if (arg == "--shading-precision" && i + 1 < argc) {
+                std::string precision = argv[++i];
+                if (precision == "full") {
+                    config.shadingPrecision = metagfx::ShadingPrecision::Full;
+                } else if (precision == "half") {
+                    config.shadingPrecision = metagfx::ShadingPrecision::Half;
+                } else if (precision == "auto") {
+                    config.shadingPrecision = metagfx::ShadingPrecision::Auto;
+                } else {
+                    METAGFX_WARN << "Unknown shading precision '" << precision << "'";
+                }
+            } else if (arg == "--vertex-pulling") {
+                config.vertexPulling = true;
+            } else if (arg == "--shadow-depth" && i + 1 < argc) {
+                std::string bits = argv[++i];
+                if (bits == "16" || bits == "32") {
+                    config.shadowDepth16 = bits == "16";
+                } else {
+                    METAGFX_WARN << "Unknown shadow depth '" << bits << "'";
+                }
+            } else if (arg == "--stream") {
+                config.stream.enabled = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    config.stream.port = static_cast<metagfx::uint16>(std::atoi(argv[++i]));
+                }
+            } else if (arg == "--stream-bitrate" && i + 1 < argc) {
+                config.stream.bitrateKbps = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+            } else if (arg == "--stream-raw") {
+                config.stream.rawNV12 = true;
+            } else if (arg == "--capture" && i + 1 < argc) {
+                config.capturePath = argv[++i];
+            } else if (arg == "--capture-frames" && i + 1 < argc) {
+                config.captureFrames = static_cast<metagfx::uint32>(std::atoi(argv[++i]));
+            } else if (arg == "--hitch-dumps") {
+                config.hitchDetection = true;
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    config.hitchDetector.directory = argv[++i];
+                }
+            } else if (arg == "--hitch-threshold" && i + 1 < argc) {
+                config.hitchDetector.medianMultiple = static_cast<float>(std::atof(argv[++i]));
+            }
+        }
+
         metagfx::Application app(config);
         app.Run();
     }
 
+    metagfx::utils::AssetArchive::UnmountAll();
+    metagfx::JobSystem::Shutdown();
+
     METAGFX_INFO << "Application terminated successfully";
+    metagfx::Logger::Shutdown();
 
     return 0;
 }
@@ -1,34 +1,128 @@
 #version 450
 
+#ifdef VERTEX_PULLING
+// model_pulled.vert: no vertex input state. Each vertex is fetched by gl_VertexIndex
+// (which includes the draw's vertex offset) from the geometry pool the model is drawn
+// from, in either layout, so one pipeline draws Float and Compact models alike.
+
+// The geometry pool's vertices as 32-bit words: 12 per VertexFormat::Float vertex,
+// 5 per VertexFormat::Compact one (see Mesh.h)
+layout(std430, binding = 23) readonly buffer VertexBuffer {
+    uint words[];
+} vertexBuffer;
+#else
 // Vertex attributes
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inNormal;
 layout(location = 2) in vec2 inTexCoord;
+layout(location = 3) in vec4 inTangent;  // w: bitangent sign (handedness)
+#endif
 
 // Uniform buffer (MVP matrices)
 layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 projection;
+    mat4 viewProjection;
+    mat4 normalMatrix;  // Inverse transpose of mat3(model)
+#ifdef VERTEX_PULLING
+    // The rest of the frame constants, up to the layout of the pool's vertices
+    mat4 inverseSkyViewProjection;
+    vec4 cameraPosition;
+    float exposure;
+    uint enableIBL;
+    float iblIntensity;
+    uint shadowDebugMode;
+    uint enableShadows;
+    uint clusterBase;
+    vec2 clusterTileScale;
+    vec2 clusterDepthScaleBias;
+    uint lightBase;
+    uint directionalLightCount;
+    uint shadowAtlasBase;
+    uint shadowFilter;
+    uint vertexFormat;  // VertexFormat: 0 = Float, 1 = Compact (the model matrix dequantizes)
+#endif
 } ubo;
 
+// World and normal matrix of each scene graph node (NodeTransform on the CPU)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;  // Inverse transpose of mat3(world), as vec4 columns
+};
+layout(binding = 15) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// Node of each instance. Entries below the node count map node i to itself, so a
+// single draw passes its node as firstInstance; instanced batches list their nodes.
+layout(binding = 16) readonly buffer InstanceNodes {
+    uint instanceNodes[];
+};
+
 // Outputs to fragment shader
 layout(location = 0) out vec3 fragPosition;
 layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec2 fragTexCoord;
+layout(location = 3) out vec4 fragTangent;
+
+// The depth prepass (depth_prepass.vert) computes the same position with the same
+// expressions, so the depth it leaves passes this pass's LessOrEqual test exactly
+invariant gl_Position;
+
+#ifdef VERTEX_PULLING
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
 
 void main() {
+#ifdef VERTEX_PULLING
+    // The attributes the vertex input state would have decoded, as model_compact.vert
+    // reads the compact ones
+    vec3 inPosition;
+    vec3 inNormal;
+    vec2 inTexCoord;
+    vec4 inTangent;
+    if (ubo.vertexFormat == 1u) {
+        uint base = uint(gl_VertexIndex) * 5u;
+        inPosition = vec3(unpackUnorm2x16(vertexBuffer.words[base]), unpackUnorm2x16(vertexBuffer.words[base + 1u]).x);
+        inNormal = DecodeOctahedral(unpackSnorm2x16(vertexBuffer.words[base + 2u]));
+        inTexCoord = unpackHalf2x16(vertexBuffer.words[base + 3u]);
+        inTangent = unpackSnorm4x8(vertexBuffer.words[base + 4u]);
+    } else {
+        uint base = uint(gl_VertexIndex) * 12u;
+        inPosition = uintBitsToFloat(uvec3(vertexBuffer.words[base], vertexBuffer.words[base + 1u],
+                                           vertexBuffer.words[base + 2u]));
+        inNormal = uintBitsToFloat(uvec3(vertexBuffer.words[base + 3u], vertexBuffer.words[base + 4u],
+                                         vertexBuffer.words[base + 5u]));
+        inTexCoord = uintBitsToFloat(uvec2(vertexBuffer.words[base + 6u], vertexBuffer.words[base + 7u]));
+        inTangent = uintBitsToFloat(uvec4(vertexBuffer.words[base + 8u], vertexBuffer.words[base + 9u],
+                                          vertexBuffer.words[base + 10u], vertexBuffer.words[base + 11u]));
+    }
+#endif
+
     // Transform vertex position
-    vec4 worldPos = ubo.model * vec4(inPosition, 1.0);
+    NodeTransform node = nodeTransforms[instanceNodes[gl_InstanceIndex]];
+    mat4 model = ubo.model * node.world;
+    vec4 worldPos = model * vec4(inPosition, 1.0);
     fragPosition = worldPos.xyz;
     
-    // Transform normal (using normal matrix to handle non-uniform scaling)
-    mat3 normalMatrix = transpose(inverse(mat3(ubo.model)));
+    // Transform normal (using normal matrix to handle non-uniform scaling); the inverse
+    // transpose of a product is the product of the factors' inverse transposes
+    mat3 normalMatrix = mat3(ubo.normalMatrix) * mat3(node.normal);
     fragNormal = normalize(normalMatrix * inNormal);
+
+    // Tangents lie in the surface, so they transform like positions
+    fragTangent = vec4(normalize(mat3(model) * inTangent.xyz), inTangent.w);
     
     // Pass through texture coordinates
     fragTexCoord = inTexCoord;
     
     // Final position
-    gl_Position = ubo.projection * ubo.view * worldPos;
+    gl_Position = ubo.viewProjection * worldPos;
 }
\ No newline at end of file
@@ -0,0 +1,187 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+// Bindless variant of model.frag: identical shading, but material parameters come from a
+// per-model storage buffer and textures from one table indexed by the material, so a whole
+// model is drawn with a single descriptor set bind. Only pushConstants.materialIndex changes
+// per draw.
+//
+// Compiled by metagfx_add_shaders() (cmake/MetagfxShaders.cmake) into
+// model_bindless.frag.spv.inl, which is rebuilt whenever this file or an #include changes.
+
+// Shaded in fp32: the hfloat/hvec3 types of model.frag's half-precision build are floats
+#define hfloat float
+#define hvec3 vec3
+#define HFLOAT_MAX 3.402823e38
+
+// Inputs from vertex shader
+layout(location = 0) in vec3 fragPosition;
+layout(location = 1) in vec3 fragNormal;
+layout(location = 2) in vec2 fragTexCoord;
+layout(location = 3) in vec4 fragTangent;  // World space; w is the bitangent's sign
+
+// Must match BINDLESS_TEXTURE_CAPACITY in Application.h
+#define BINDLESS_TEXTURE_CAPACITY 1024
+
+// Per-material data (64 bytes, matches BindlessMaterialData on the CPU)
+struct BindlessMaterial {
+    vec3 albedo;
+    float roughness;
+    vec3 emissiveFactor;
+    float metallic;
+    uint albedoIndex;
+    uint normalIndex;
+    uint metallicIndex;
+    uint roughnessIndex;
+    uint aoIndex;
+    uint emissiveIndex;
+    uint textureFlags;  // Read by path_trace.comp only
+    uint alphaParams;   // packHalf2x16(alpha, alphaCutoff)
+};
+
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    BindlessMaterial materials[];
+} materialBuffer;
+
+// Texture table (partially bound: only the entries used by materials are written).
+// The index comes from a push constant, so it is dynamically uniform.
+layout(binding = 14) uniform sampler2D textures[BINDLESS_TEXTURE_CAPACITY];
+
+// model_shading.glsl uses model.frag's names
+#define material materialBuffer.materials[pushConstants.materialIndex]
+#define MATERIAL_ALPHA_PARAMS unpackHalf2x16(material.alphaParams)
+#define albedoSampler textures[material.albedoIndex]
+#define normalSampler textures[material.normalIndex]
+#define metallicSampler textures[material.metallicIndex]
+#define roughnessSampler textures[material.roughnessIndex]
+#define aoSampler textures[material.aoIndex]
+#define emissiveSampler textures[material.emissiveIndex]
+
+// Diffuse irradiance of the environment as L2 spherical harmonics (utils::IrradianceSH on
+// the CPU): rgb per coefficient, cosine convolution and basis constants folded in
+layout(binding = 8) uniform IrradianceSHUBO {
+    vec4 coefficients[9];
+} irradianceSH;
+
+// Irradiance probes of the scene (LightProbeVolume): a header, then 9 coefficients per
+// probe in the convention of irradianceSH's, the first's w the probe's validity (1 valid,
+// 0 inside geometry, -1 not traced yet). A zeroed header means there is no volume.
+layout(binding = 29, std430) readonly buffer LightProbeBuffer {
+    vec4 gridOrigin;   // xyz: position of the first probe; w: 1 while the volume is on
+    vec4 gridSpacing;  // xyz: between neighbouring probes
+    uvec4 gridCounts;  // xyz: probes along each axis
+    vec4 probes[];
+} lightProbes;
+
+// IBL texture samplers
+layout(binding = 9) uniform samplerCube prefilteredMap;
+layout(binding = 10) uniform sampler2D brdfLUT;
+
+// Shadow map sampler (comparison sampler for PCF)
+layout(binding = 12) uniform sampler2DShadow shadowMapSampler;
+// The same depth without comparison, for the PCSS blocker search
+layout(binding = 20) uniform sampler2D shadowDepthSampler;
+// Blurred exponential moments of the shadow map at half resolution (ShadowMoments)
+layout(binding = 21) uniform sampler2D shadowMomentsSampler;
+
+// Shadow cascades of the key light (ShadowUniforms on the CPU). Each cascade is a tile
+// of the shadow map and covers the view depths up to its split.
+#define MAX_SHADOW_CASCADES 4
+layout(binding = 13) uniform ShadowUBO {
+    mat4 cascadeMatrices[MAX_SHADOW_CASCADES];  // World to light clip space
+    vec4 cascadeRects[MAX_SHADOW_CASCADES];     // Tile in the shadow map: xy offset, zw size
+    vec4 cascadeSplits;                         // View depth where each cascade ends
+    vec4 cascadePenumbraScales;                 // Tile coordinates of penumbra per unit of depth
+    float shadowBias;                           // Bias to prevent shadow acne
+    uint cascadeCount;
+    float filterRadius;                         // Poisson disc radius in texels
+    float evsmBleedReduction;                   // EVSM visibility below this counts as shadowed
+} shadow;
+
+// Light data structure (64 bytes, matches CPU struct)
+struct LightData {
+    vec4 positionAndType;    // xyz=position, w=type (0=dir, 1=point, 2=spot)
+    vec4 directionAndRange;  // xyz=direction, w=range
+    vec4 colorAndIntensity;  // rgb=color, w=intensity
+    vec4 spotAngles;         // x=innerAngle, y=outerAngle, z=attConst, w=attLinear
+};
+
+// Light buffer storage (set 0, binding = 3). Must match LightBufferHeader + LightData[]
+// on the CPU: one region of lights per frame in flight, directional lights first. The
+// header is only rewritten when lights are added or removed; shading reads the frame's
+// region and directional count from the frame constants.
+layout(set = 0, binding = 3, std430) readonly buffer LightBuffer {
+    uint lightCount;
+    uint directionalCount;
+    uint padding[2];
+    LightData lights[];
+} lightBuffer;
+
+// Clustered point and spot lights (LightClusters on the CPU; the grid must match). The
+// frame's region starts at frame.clusterBase: a (first, count) pair per cluster, x
+// fastest, then the light indices the pairs point at.
+#define CLUSTER_GRID_X 16u
+#define CLUSTER_GRID_Y 9u
+#define CLUSTER_GRID_Z 24u
+layout(set = 0, binding = 17, std430) readonly buffer ClusterBuffer {
+    uint values[];
+} clusterBuffer;
+
+// Point and spot light shadows (ShadowAtlas on the CPU). The frame's region starts at
+// frame.shadowAtlasBase: a uint per light of the frame's light array, packed in vec4s,
+// holding the vec4 index of the light's first face or SHADOW_ATLAS_NO_FACE; then five
+// vec4s per face, its world to light clip matrix and its tile rect (xy offset, zw size).
+// A point light's six faces follow each other in the order +X, -X, +Y, -Y, +Z, -Z.
+#define SHADOW_ATLAS_NO_FACE 0xFFFFFFFFu
+layout(binding = 18) uniform sampler2DShadow shadowAtlasSampler;
+layout(set = 0, binding = 19, std430) readonly buffer ShadowAtlasBuffer {
+    vec4 values[];
+} shadowAtlas;
+
+// Frame constants after the MVP matrices of binding 0 (UniformBufferObject on the CPU)
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    mat4 normalMatrix;
+    mat4 inverseSkyViewProjection;
+    vec4 cameraPosition;
+    float exposure;
+    uint enableIBL;  // 0 = disabled, 1 = enabled
+    float iblIntensity;  // IBL contribution multiplier
+    uint shadowDebugMode;  // 0 = normal, 1 = shadow factor, 2 = depth coords
+    uint enableShadows;  // 0 = disabled, 1 = enabled
+    uint clusterBase;            // First entry of this frame's cluster region
+    vec2 clusterTileScale;       // Clusters per pixel in x and y
+    vec2 clusterDepthScaleBias;  // Slice = log(view depth) * x + y
+    uint lightBase;              // First light of this frame's region
+    uint directionalLightCount;
+    uint shadowAtlasBase;        // First vec4 of this frame's shadow atlas region
+    uint shadowFilter;           // SHADOW_FILTER_* of the unspecialized pipeline
+} frame;
+
+// Per-material push constants (ModelPushConstants on the CPU)
+layout(push_constant) uniform PushConstants {
+    uint materialFlags;
+    uint materialIndex;  // Index into materialBuffer.materials
+} pushConstants;
+
+// Permutation constants (Application::ModelFeatures). With the defaults the runtime
+// flags above pick the paths, so the unspecialized pipeline draws every material and
+// debug view; a pipeline specialized for one feature mask has the other paths folded away.
+layout(constant_id = 0) const uint SPECIALIZED = 0u;    // 1 = FEATURE_MASK replaces the flags
+layout(constant_id = 1) const uint FEATURE_MASK = 0u;   // Bits 0-6 texture flags, 7 IBL, 8 shadows, 9-11 shadow filter, 12 alpha mask
+// 1 = linear, unexposed color into the HDR scene color, exposed and tone mapped by the
+// tone mapping pass (ToneMapper) instead of here
+layout(constant_id = 2) const uint HDR_OUTPUT = 0u;
+// What a blended material's pipeline writes (Application::ModelTransparency): 0 opaque
+// color, 1 color and alpha over the scene color, 2 the weighted sums of weighted blended
+// order-independent transparency, 3 its alpha alone, which attenuates the revealage
+layout(constant_id = 3) const uint TRANSPARENCY = 0u;
+
+// Output color
+layout(location = 0) out vec4 outColor;
+
+// Shading, shared with the other model.frag variants
+#include "model_shading.glsl"
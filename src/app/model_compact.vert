@@ -0,0 +1,72 @@
+#version 450
+
+// Vertex attributes (VertexFormat::Compact). Position and texcoord arrive through
+// normalized / half formats; the model matrix already contains the dequantization.
+layout(location = 0) in vec3 inPosition;   // R16G16B16A16_UNORM, [0, 1] in the quantization cube
+layout(location = 1) in vec2 inNormalOct;  // R16G16_SNORM, octahedral
+layout(location = 2) in vec2 inTexCoord;   // R16G16_SFLOAT
+layout(location = 3) in vec4 inTangent;    // R8G8B8A8_SNORM, w: bitangent sign
+
+// Uniform buffer (MVP matrices)
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    mat4 normalMatrix;  // Inverse transpose of mat3(model)
+} ubo;
+
+// World and normal matrix of each scene graph node (NodeTransform on the CPU)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;  // Inverse transpose of mat3(world), as vec4 columns
+};
+layout(binding = 15) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// Node of each instance. Entries below the node count map node i to itself, so a
+// single draw passes its node as firstInstance; instanced batches list their nodes.
+layout(binding = 16) readonly buffer InstanceNodes {
+    uint instanceNodes[];
+};
+
+// Outputs to fragment shader
+layout(location = 0) out vec3 fragPosition;
+layout(location = 1) out vec3 fragNormal;
+layout(location = 2) out vec2 fragTexCoord;
+layout(location = 3) out vec4 fragTangent;
+
+// The depth prepass (depth_prepass.vert) computes the same position with the same
+// expressions, so the depth it leaves passes this pass's LessOrEqual test exactly
+invariant gl_Position;
+
+vec3 DecodeOctahedral(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    // Transform vertex position
+    NodeTransform node = nodeTransforms[instanceNodes[gl_InstanceIndex]];
+    mat4 model = ubo.model * node.world;
+    vec4 worldPos = model * vec4(inPosition, 1.0);
+    fragPosition = worldPos.xyz;
+
+    // Both normal matrices come from the CPU. The dequantization scale is uniform, so it
+    // only scales the normal, which is renormalized.
+    mat3 normalMatrix = mat3(ubo.normalMatrix) * mat3(node.normal);
+    fragNormal = normalize(normalMatrix * DecodeOctahedral(inNormalOct));
+
+    // Tangents lie in the surface, so they transform like positions
+    fragTangent = vec4(normalize(mat3(model) * inTangent.xyz), inTangent.w);
+
+    // Pass through texture coordinates
+    fragTexCoord = inTexCoord;
+
+    // Final position
+    gl_Position = ubo.viewProjection * worldPos;
+}
@@ -0,0 +1,423 @@
+// Forward shading of model.frag and its variants (model_bindless.frag,
+// model_raytraced.frag): everything below the bindings, which the entry point declares
+// under model.frag's names along with the hfloat/hvec3 preamble, the permutation
+// constants and outColor. An entry point whose material is not model.frag's MaterialUBO
+// defines MATERIAL_ALPHA_PARAMS, the material's (alpha, cutoff).
+
+#ifndef MATERIAL_ALPHA_PARAMS
+#define MATERIAL_ALPHA_PARAMS vec2(material.alpha, material.alphaCutoff)
+#endif
+
+// A specialized pipeline has its shadow filter in FEATURE_MASK, folded at compile time
+#define SHADOW_FILTER (SPECIALIZED != 0u ? (FEATURE_MASK >> 9u) & 7u : frame.shadowFilter)
+
+#include "pbr_lighting.glsl"
+#include "light_probes.glsl"
+#include "normal_mapping.glsl"
+#include "shadow_maps.glsl"
+#ifdef RAY_TRACED_SHADOWS
+#include "ray_traced_shadows.glsl"
+#endif
+
+// ============================================================================
+// Tone Mapping
+// ============================================================================
+
+// ACES Filmic Tone Mapping
+// High-quality tone mapping curve used in film production
+// Handles HDR values gracefully and provides better color reproduction
+vec3 toneMapACES(vec3 color) {
+    const float a = 2.51;
+    const float b = 0.03;
+    const float c = 2.43;
+    const float d = 0.59;
+    const float e = 0.14;
+    return clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0, 1.0);
+}
+
+// The fragment's output for the pipeline's TRANSPARENCY. The weighted sums weigh nearer
+// and more opaque fragments more (McGuire and Bavoil's view depth weight), capped so
+// that bright HDR colors do not overflow the half-float accumulation.
+vec4 transparencyOutput(vec3 color, float alpha) {
+    if (TRANSPARENCY == 1u) {
+        return vec4(color, alpha);
+    }
+    if (TRANSPARENCY == 2u) {
+        float z = length(frame.cameraPosition.xyz - fragPosition);
+        float w = alpha * clamp(10.0 / (1e-5 + pow(z / 5.0, 2.0) + pow(z / 200.0, 6.0)), 1e-2, 3e2);
+        return vec4(color * alpha, alpha) * w;
+    }
+    return vec4(color, 1.0);
+}
+
+void main() {
+    // Feature switches: specialization constants, or the frame and material flags
+    bool specialized = SPECIALIZED != 0u;
+    uint materialFlags = specialized ? (FEATURE_MASK & 0x7Fu) : pushConstants.materialFlags;
+    bool enableIBL = specialized ? (FEATURE_MASK & (1u << 7)) != 0u : frame.enableIBL != 0u;
+    bool enableShadows = specialized ? (FEATURE_MASK & (1u << 8)) != 0u : frame.enableShadows != 0u;
+    uint shadowDebugMode = specialized ? 0u : frame.shadowDebugMode;  // Debug views use the uber shader
+
+    // Sample albedo (texture or material property); alpha multiplies the map's
+    vec2 alphaParams = MATERIAL_ALPHA_PARAMS;  // Alpha, cutoff
+    vec3 albedo;
+    float alpha = alphaParams.x;
+    if ((materialFlags & (1u << 0)) != 0u) {  // HasAlbedoMap
+        vec4 albedoSample = texture(albedoSampler, fragTexCoord);
+        albedo = albedoSample.rgb;
+        alpha *= albedoSample.a;
+    } else {
+        albedo = material.albedo;
+    }
+
+    // Masked materials drop their fragments below the cutoff; only the uber pipeline and
+    // alpha-mask permutations carry the discard, so opaque ones keep early depth testing
+    bool alphaMask = specialized ? (FEATURE_MASK & (1u << 12)) != 0u : (pushConstants.materialFlags & (1u << 7)) != 0u;
+    if (alphaMask && alpha < alphaParams.y) {
+        discard;
+    }
+    if (TRANSPARENCY == 3u) {
+        outColor = vec4(0.0, 0.0, 0.0, alpha);
+        return;
+    }
+
+    // Sample normal map (texture or vertex normal)
+    vec3 N;
+    if ((materialFlags & (1u << 1)) != 0u) {  // HasNormalMap
+        N = getNormalFromMap(fragTexCoord, fragNormal, fragTangent);
+    } else {
+        N = normalize(fragNormal);
+    }
+
+    // Sample metallic, roughness, and AO based on texture flags
+    float metallic;
+    float roughness;
+    float ao;
+
+    if ((materialFlags & (1u << 4)) != 0u) {  // HasMetallicRoughnessMap (glTF)
+        // glTF 2.0 standard: R=AO, G=roughness, B=metallic
+        vec3 mrSample = texture(metallicSampler, fragTexCoord).rgb;
+        ao = mrSample.r;
+        roughness = mrSample.g;
+        metallic = mrSample.b;
+    } else {
+        // Separate textures or material properties
+        if ((materialFlags & (1u << 2)) != 0u) {  // HasMetallicMap
+            metallic = texture(metallicSampler, fragTexCoord).r;
+        } else {
+            metallic = material.metallic;
+        }
+
+        if ((materialFlags & (1u << 3)) != 0u) {  // HasRoughnessMap
+            roughness = texture(roughnessSampler, fragTexCoord).r;
+        } else {
+            roughness = material.roughness;
+        }
+
+        if ((materialFlags & (1u << 5)) != 0u) {  // HasAOMap
+            ao = texture(aoSampler, fragTexCoord).r;
+        } else {
+            ao = 1.0;
+        }
+    }
+
+    // Clamp roughness to prevent artifacts from infinitely sharp specular highlights
+    // Minimum value of 0.04 provides reasonable results for smooth surfaces
+    roughness = max(roughness, 0.04);
+
+    // Prepare view direction and calculate base reflectivity
+    vec3 V = normalize(frame.cameraPosition.xyz - fragPosition);
+    float NdotV = max(dot(N, V), 0.0);
+
+    // Calculate F0 (surface reflection at zero incidence)
+    // For dielectrics, F0 is typically 0.04
+    // For metals, F0 is the albedo color
+    hvec3 F0 = mix(hvec3(0.04), hvec3(albedo), hfloat(metallic));
+
+    // Calculate shadow factor (for directional light shadows)
+    // If shadows are disabled, use 1.0 (fully lit)
+    float shadowFactor = enableShadows ? calculateShadow(fragPosition) : 1.0;
+
+    // Directional lights reach every fragment; shadows apply ONLY to the first one (the
+    // shadow casting light)
+    vec3 Lo = vec3(0.0);
+    for (uint i = 0u; i < frame.directionalLightCount; i++) {
+        Lo += calculatePBRLighting(
+            lightBuffer.lights[frame.lightBase + i],
+            fragPosition,
+            N,
+            V,
+            hvec3(albedo),
+            roughness,
+            hfloat(metallic),
+            i == 0u ? shadowFactor : 1.0
+        );
+    }
+
+    // Point and spot lights: only those binned into this fragment's cluster
+    float viewDepth = -(frame.view * vec4(fragPosition, 1.0)).z;
+    uvec2 clusterTile = min(uvec2(gl_FragCoord.xy * frame.clusterTileScale), uvec2(CLUSTER_GRID_X - 1u, CLUSTER_GRID_Y - 1u));
+    float clusterSlice = log(max(viewDepth, 1e-4)) * frame.clusterDepthScaleBias.x + frame.clusterDepthScaleBias.y;
+    uint clusterZ = uint(clamp(clusterSlice, 0.0, float(CLUSTER_GRID_Z - 1u)));
+    uint cluster = clusterTile.x + clusterTile.y * CLUSTER_GRID_X + clusterZ * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+    uint clusterFirst = clusterBuffer.values[frame.clusterBase + cluster * 2u];
+    uint clusterCount = clusterBuffer.values[frame.clusterBase + cluster * 2u + 1u];
+    for (uint i = 0u; i < clusterCount; i++) {
+        uint lightIndex = clusterBuffer.values[clusterFirst + i];
+        LightData light = lightBuffer.lights[frame.lightBase + lightIndex];
+        Lo += calculatePBRLighting(
+            light,
+            fragPosition,
+            N,
+            V,
+            hvec3(albedo),
+            roughness,
+            hfloat(metallic),
+            enableShadows ? calculateLocalShadow(lightIndex, light, fragPosition, N) : 1.0
+        );
+    }
+
+    // ============================================================================
+    // Image-Based Lighting (IBL)
+    // ============================================================================
+
+    // Declare IBL variables for debug visualization
+    vec3 ambient;
+    vec3 diffuseIBL = vec3(0.0);
+    vec3 specularIBL = vec3(0.0);
+    vec3 irradiance = vec3(0.0);
+    vec3 prefilteredColor = vec3(0.0);
+    vec2 brdf = vec2(0.0);
+
+    if (enableIBL) {
+        // IBL enabled: use environment maps for realistic ambient lighting
+
+        // Reflection vector for specular IBL
+        vec3 R = reflect(-V, N);
+
+        // --- Diffuse IBL (Irradiance) ---
+        // Irradiance arriving around the normal: the light probes' where they cover the
+        // surface, else the environment's. The probes' sky is scaled by the intensity
+        // already, which the sum below applies again.
+        vec3 probeSH[9];
+        float probeWeight = BlendLightProbes(fragPosition, N, probeSH);
+        irradiance = EvaluateIrradianceSH(N);
+        if (probeWeight > 0.0) {
+            irradiance = mix(irradiance, EvaluateLightProbes(probeSH, N) / max(frame.iblIntensity, 0.0001),
+                             probeWeight);
+        }
+
+        // Calculate diffuse component
+        // kD represents the refracted light (diffuse)
+        // For energy conservation: kD = 1 - kS (where kS is Fresnel)
+        hvec3 F = FresnelSchlickRoughness(hfloat(NdotV), F0, hfloat(roughness));
+        hvec3 kD = (hfloat(1.0) - F) * (hfloat(1.0) - hfloat(metallic)); // Metals have no diffuse
+
+        diffuseIBL = vec3(kD * hvec3(min(irradiance, vec3(HFLOAT_MAX))) * hvec3(albedo));
+
+        // --- Specular IBL (Prefiltered Environment + BRDF LUT) ---
+        // Sample prefiltered environment map based on roughness
+        const float MAX_REFLECTION_LOD = 5.0; // Number of mip levels - 1
+        float lod = roughness * MAX_REFLECTION_LOD;
+        prefilteredColor = textureLod(prefilteredMap, R, lod).rgb;
+
+        // Sample BRDF integration map (split-sum approximation)
+        brdf = texture(brdfLUT, vec2(NdotV, roughness)).rg;
+
+        // Combine prefiltered color with BRDF
+        specularIBL = vec3(hvec3(prefilteredColor) * (F * hfloat(brdf.x) + hfloat(brdf.y)));
+
+        // The probes capture no reflections: where they receive less light around the
+        // reflection than the environment gives, indoors, its reflections dim as much
+        if (probeWeight > 0.0) {
+            const vec3 LUMINANCE = vec3(0.2126, 0.7152, 0.0722);
+            float local = dot(EvaluateLightProbes(probeSH, R), LUMINANCE) / max(frame.iblIntensity, 0.0001);
+            float environment = dot(EvaluateIrradianceSH(R), LUMINANCE);
+            specularIBL *= mix(1.0, clamp(local / max(environment, 0.0001), 0.0, 1.0), probeWeight);
+        }
+
+        // Combine diffuse and specular IBL
+        // Scale by user-controlled intensity
+        ambient = (diffuseIBL + specularIBL) * frame.iblIntensity;
+    } else {
+        // IBL disabled: use simple constant ambient lighting, or the light probes' where
+        // they cover the surface (their sky gives the same constant)
+        vec3 probeSH[9];
+        float probeWeight = BlendLightProbes(fragPosition, N, probeSH);
+        vec3 ambientIrradiance = vec3(0.03);
+        if (probeWeight > 0.0) {
+            ambientIrradiance = mix(ambientIrradiance, EvaluateLightProbes(probeSH, N), probeWeight);
+        }
+        ambient = ambientIrradiance * albedo * ao;
+    }
+
+    // Final color: IBL ambient + direct lighting
+    vec3 color = ambient + Lo;
+
+    // ============================================================================
+    // EMISSIVE CONTRIBUTION
+    // ============================================================================
+    // Emissive light is self-illumination and is added AFTER lighting but BEFORE tone mapping
+    // This ensures emissive materials can "bloom" in HDR and appear to glow
+    vec3 emissive = vec3(0.0);
+    if ((materialFlags & (1u << 6)) != 0u) {  // HasEmissiveMap
+        emissive = texture(emissiveSampler, fragTexCoord).rgb * material.emissiveFactor;
+    } else {
+        emissive = material.emissiveFactor;
+    }
+    color += emissive;
+
+    if (HDR_OUTPUT == 0u) {
+        // Apply exposure control
+        color = color * frame.exposure;
+
+        // Apply tone mapping (HDR to LDR)
+        // NOTE: Using simple clamp instead of ACES - ACES was causing black artifacts with IBL
+        color = clamp(color, 0.0, 1.0);
+
+        // Gamma correction (convert from linear to sRGB)
+        color = pow(color, vec3(1.0/2.2));
+    }
+
+    // ============================================================================
+    // DEBUG VISUALIZATION MODES
+    // Uncomment ONE of these lines to visualize different PBR properties
+    // ============================================================================
+
+    // Material properties (DEBUG - uncomment to visualize)
+    // outColor = vec4(albedo, 1.0);                // Albedo color (base color)
+    // outColor = vec4(vec3(metallic), 1.0);        // Metallic map (grayscale)
+    // outColor = vec4(vec3(roughness), 1.0);       // Roughness map (grayscale)
+    // outColor = vec4(vec3(ao), 1.0);              // Ambient Occlusion (grayscale)
+
+    // Normals (DEBUG - uncomment to visualize)
+    // outColor = vec4(N * 0.5 + 0.5, 1.0); return;         // World-space normals as RGB
+    // outColor = vec4(normalize(fragNormal) * 0.5 + 0.5, 1.0);  // Vertex normals (before normal map)
+
+    // Lighting components (DEBUG - uncomment to visualize)
+    // outColor = vec4(ambient, 1.0); return;       // IBL ambient contribution only
+    // outColor = vec4(Lo, 1.0); return;            // Direct lighting only
+    // outColor = vec4(color, 1.0); return;         // Color before tone mapping
+
+    // IBL components (DEBUG - uncomment to visualize IBL)
+    // outColor = vec4(diffuseIBL * 2.0, 1.0); return;    // Diffuse IBL only (scaled 2x for viewing)
+    // outColor = vec4(specularIBL, 1.0); return;   // Specular IBL only (prefiltered + BRDF)
+    // outColor = vec4(irradiance * 0.5, 1.0); return;    // Raw spherical harmonics irradiance (scaled for viewing)
+    // outColor = vec4(prefilteredColor * 0.5, 1.0); return; // Raw prefiltered map sample (scaled for viewing)
+    // outColor = vec4(vec3(brdf, 0.0), 1.0); return;  // BRDF LUT (RG only)
+
+    // DEBUG: Visualize lights per cluster
+    // outColor = vec4(vec3(float(clusterCount) / 16.0), 1.0); return;
+
+    // Advanced visualization (DEBUG - uncomment to visualize)
+    // outColor = vec4(vec3(max(dot(N, V), 0.0)), 1.0);  // N·V (fresnel term)
+    // float avgLight = (Lo.r + Lo.g + Lo.b) / 3.0;
+    // outColor = vec4(vec3(avgLight), 1.0);        // Grayscale lighting intensity
+
+    // Shadow map visualization modes (for debugging)
+    if (shadowDebugMode == 1u) {
+        // Mode 1: Show shadow factor (white = lit, black = shadowed)
+        outColor = vec4(vec3(shadowFactor), 1.0);
+        return;
+    } else if (shadowDebugMode == 2u) {
+        // Mode 2: Show vertex normal as color (normals should definitely vary!)
+        // Normals are in -1 to 1 range, remap to 0-1 for visualization
+        vec3 normalColor = fragNormal * 0.5 + 0.5;
+        outColor = vec4(normalColor, 1.0);
+        return;
+    } else if (shadowDebugMode == 3u) {
+        // Mode 3: Show light-space depth coordinates
+        vec4 fragPosLightSpace = shadow.cascadeMatrices[debugCascade(fragPosition)] * vec4(fragPosition, 1.0);
+        vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+
+        // DIAGNOSTIC: Show if matrix is working
+        // If fragPosition varies but fragPosLightSpace doesn't, the matrix is identity/broken
+        // Visualize world-space position (should show gradients)
+        vec3 worldViz = abs(fragPosition) / 10.0;  // Normalize by 10 units
+
+        // Show NDC coordinates after light transform
+        // IMPORTANT: In Vulkan, depth (Z) is already in [0,1], only X/Y need transformation
+        vec3 ndcViz;
+        ndcViz.x = projCoords.x * 0.5 + 0.5;
+        ndcViz.y = projCoords.y * 0.5 + 0.5;
+        ndcViz.z = projCoords.z;  // Already in [0,1] for Vulkan
+
+        // Split screen: left half = world position, right half = light-space position
+        if (fragTexCoord.x < 0.5) {
+            // Left: world position (should show color gradients)
+            outColor = vec4(worldViz, 1.0);
+        } else {
+            // Right: light-space position
+            if (ndcViz.x < 0.0 || ndcViz.x > 1.0 || ndcViz.y < 0.0 || ndcViz.y > 1.0) {
+                outColor = vec4(1.0, 0.0, 1.0, 1.0);  // Magenta = out of XY bounds
+            } else if (ndcViz.z < 0.0 || ndcViz.z > 1.0) {
+                outColor = vec4(1.0, 1.0, 0.0, 1.0);  // Yellow = out of depth bounds
+            } else {
+                outColor = vec4(ndcViz, 1.0);
+            }
+        }
+        return;
+    } else if (shadowDebugMode == 4u) {
+        // Mode 4: Sample shadow map depth directly and visualize
+        vec4 fragPosLightSpace = shadow.cascadeMatrices[debugCascade(fragPosition)] * vec4(fragPosition, 1.0);
+        vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+        // Transform X/Y to [0,1], Z is already in [0,1] for Vulkan
+        projCoords.xy = projCoords.xy * 0.5 + 0.5;
+
+        // Check bounds
+        if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0) {
+            outColor = vec4(1.0, 0.0, 0.0, 1.0);  // Red = out of bounds
+            return;
+        }
+
+        // Sample the shadow map depth (note: can't directly read depth from sampler2DShadow)
+        // Instead, let's visualize the projected coordinates and current fragment depth
+        float currentDepth = projCoords.z;
+
+        // Visualize: R = projected X, G = projected Y, B = current depth
+        outColor = vec4(projCoords.x, projCoords.y, currentDepth, 1.0);
+        return;
+    } else if (shadowDebugMode == 5u) {
+        // Mode 5: Show just the shadow factor as grayscale (simpler than mode 1)
+        // This helps see if ANY shadowing is happening
+        float sf = enableShadows ? calculateShadow(fragPosition) : 1.0;
+        outColor = vec4(vec3(sf), 1.0);
+        return;
+    } else if (shadowDebugMode == 6u) {
+        // Mode 6: Show detailed shadow sampling debug info
+        vec4 fragPosLightSpace = shadow.cascadeMatrices[debugCascade(fragPosition)] * vec4(fragPosition, 1.0);
+        vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+        projCoords.xy = projCoords.xy * 0.5 + 0.5;
+
+        // Check if in bounds
+        if (projCoords.x < 0.0 || projCoords.x > 1.0 || projCoords.y < 0.0 || projCoords.y > 1.0) {
+            outColor = vec4(1.0, 0.0, 0.0, 1.0);  // Red = out of XY bounds
+            return;
+        }
+        if (projCoords.z < 0.0 || projCoords.z > 1.0) {
+            outColor = vec4(1.0, 1.0, 0.0, 1.0);  // Yellow = out of Z bounds
+            return;
+        }
+
+        // Sample shadow map at center (no PCF)
+        float currentDepth = projCoords.z - shadow.shadowBias;
+        currentDepth = clamp(currentDepth, 0.0, 1.0);
+        vec4 rect = shadow.cascadeRects[debugCascade(fragPosition)];
+        float shadowSample = texture(shadowMapSampler, vec3(rect.xy + projCoords.xy * rect.zw, currentDepth));
+
+        // Show: R = current depth, G = shadow sample result, B = 0
+        outColor = vec4(currentDepth, shadowSample, 0.0, 1.0);
+        return;
+    } else if (shadowDebugMode == 7u) {
+        // Mode 7: Tint by cascade (red, green, blue, yellow; grey past the shadow distance)
+        const vec3 cascadeColors[MAX_SHADOW_CASCADES] = vec3[](
+            vec3(1.0, 0.2, 0.2), vec3(0.2, 1.0, 0.2), vec3(0.2, 0.2, 1.0), vec3(1.0, 1.0, 0.2));
+        uint cascade = selectCascade(fragPosition);
+        vec3 tint = cascade < shadow.cascadeCount ? cascadeColors[cascade] : vec3(0.5);
+        outColor = vec4(color * tint, 1.0);
+        return;
+    }
+
+    // Final output (default)
+    outColor = transparencyOutput(color, alpha);
+}
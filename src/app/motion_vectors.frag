@@ -0,0 +1,18 @@
+#version 450
+
+// Motion vector fragment shader - the model's own motion since the last frame, in the
+// last frame's texture coordinates. The camera's motion is left out: the temporal AA
+// pass reprojects every pixel with the scene depth, and subtracts this where the model
+// is the visible surface.
+
+layout(location = 0) in vec4 inCameraClip;
+layout(location = 1) in vec4 inPreviousClip;
+
+layout(location = 0) out vec2 outMotion;
+
+void main() {
+    // Divided per fragment: interpolating the divided positions would bend them
+    vec2 cameraUV = inCameraClip.xy / inCameraClip.w * 0.5;
+    vec2 previousUV = inPreviousClip.xy / inPreviousClip.w * 0.5;
+    outMotion = cameraUV - previousUV;
+}
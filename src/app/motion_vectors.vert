@@ -0,0 +1,57 @@
+#version 450
+
+// Motion vector vertex shader - where the model's surfaces were in the last frame, for
+// temporal anti-aliasing
+
+// Same prefix as the depth prepass's uniforms, then the last frame's matrices
+layout(binding = 0) uniform MotionVectorUBO {
+    mat4 model;                   // Model matrix (with the dequantization of compact models)
+    mat4 view;
+    mat4 projection;              // Jittered, like the main pass's
+    mat4 viewProjection;          // Likewise
+    mat4 previousModel;           // The last frame's model matrix
+    mat4 previousViewProjection;  // The last frame's, without its jitter
+} ubo;
+
+// World and normal matrix of each scene graph node (same buffer as the model pass)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;  // Inverse transpose of mat3(world), as vec4 columns
+};
+layout(binding = 1) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// Node of each instance (same buffer as the model pass)
+layout(binding = 2) readonly buffer InstanceNodes {
+    uint instanceNodes[];
+};
+
+// The nodes' world matrices of the last frame
+layout(binding = 3) readonly buffer PreviousNodeTransforms {
+    NodeTransform previousNodeTransforms[];
+};
+
+// Input vertex attributes: the position only, full-float or compact unorm
+layout(location = 0) in vec3 inPosition;
+
+// The last frame's clip positions of this frame's surface point, and of where the
+// surface point was
+layout(location = 0) out vec4 outCameraClip;
+layout(location = 1) out vec4 outPreviousClip;
+
+// Must match model.vert and model_compact.vert bit for bit, so the temporal AA pass can
+// tell the model's pixels of the scene depth by their equal depth
+invariant gl_Position;
+
+void main() {
+    // The model pass's expressions, in its order
+    uint node = instanceNodes[gl_InstanceIndex];
+    mat4 model = ubo.model * nodeTransforms[node].world;
+    vec4 worldPos = model * vec4(inPosition, 1.0);
+    gl_Position = ubo.viewProjection * worldPos;
+
+    vec4 previousWorldPos = ubo.previousModel * previousNodeTransforms[node].world * vec4(inPosition, 1.0);
+    outCameraClip = ubo.previousViewProjection * worldPos;
+    outPreviousClip = ubo.previousViewProjection * previousWorldPos;
+}
@@ -0,0 +1,23 @@
+// Tangent-space normal maps, shared by model.frag, its variants and gbuffer.frag. The
+// includer declares normalSampler.
+
+// Convert tangent-space normal from map to world-space
+vec3 getNormalFromMap(vec2 texCoord, vec3 worldNormal, vec4 worldTangent) {
+    // Tangent-space XY from the texture, transformed from [0,1] to [-1,1]; Z is rebuilt,
+    // since normal maps may be two-channel (RG8, BC5)
+    vec3 tangentNormal;
+    tangentNormal.xy = texture(normalSampler, texCoord).rg * 2.0 - 1.0;
+    tangentNormal.z = sqrt(max(1.0 - dot(tangentNormal.xy, tangentNormal.xy), 0.0));
+
+    // glTF uses OpenGL convention (Y-up), so no flip needed
+    // tangentNormal.y = -tangentNormal.y;  // Uncomment for DirectX-style normal maps
+
+    // TBN from the vertex tangent; interpolation leaves it slightly off perpendicular
+    // to the normal, so it is re-orthogonalized
+    vec3 N = normalize(worldNormal);
+    vec3 T = normalize(worldTangent.xyz - N * dot(N, worldTangent.xyz));
+    vec3 B = cross(N, T) * worldTangent.w;
+    mat3 TBN = mat3(T, B, N);
+
+    return normalize(TBN * tangentNormal);
+}
@@ -0,0 +1,20 @@
+#version 450
+
+// Weighted blended transparency composite (WeightedBlendedOIT): the average color of the
+// transparent fragments over the scene color, blended by their total coverage
+
+layout(binding = 0) uniform sampler2D accumulationSampler;  // Weighted premultiplied color, weighted alpha
+layout(binding = 1) uniform sampler2D revealageSampler;     // Product of one minus the alphas
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    float revealage = texelFetch(revealageSampler, pixel, 0).r;
+    if (revealage >= 1.0) {
+        discard;  // Nothing transparent in front of the scene here
+    }
+    vec4 accumulation = texelFetch(accumulationSampler, pixel, 0);
+    vec3 average = accumulation.rgb / max(accumulation.a, 1e-5);
+    outColor = vec4(average, 1.0 - revealage);
+}
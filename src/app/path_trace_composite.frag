@@ -0,0 +1,12 @@
+#version 450
+
+// Path trace composite (PathTracer): the accumulated mean into the HDR scene color, pixel
+// for pixel. It is linear and unexposed, like the lit color of the deferred path.
+
+layout(binding = 0) uniform sampler2D accumulationSampler;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = vec4(texelFetch(accumulationSampler, ivec2(gl_FragCoord.xy), 0).rgb, 1.0);
+}
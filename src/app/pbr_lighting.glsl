@@ -0,0 +1,155 @@
+// Cook-Torrance lighting shared by model.frag, its variants and deferred_lighting.comp.
+// The includer declares LightData and defines hfloat, hvec3 and HFLOAT_MAX first: fp16
+// types for model_half.frag (see model.frag), float elsewhere.
+
+// Constants
+const int LIGHT_TYPE_DIRECTIONAL = 0;
+const int LIGHT_TYPE_POINT = 1;
+const int LIGHT_TYPE_SPOT = 2;
+const float PI = 3.14159265359;
+
+// ============================================================================
+// PBR Utility Functions
+// ============================================================================
+
+// Normal Distribution Function (GGX/Trowbridge-Reitz)
+// Describes the distribution of microfacet normals. Full precision in both builds: a2
+// of smooth surfaces lies below fp16's normal range.
+float DistributionGGX(vec3 N, vec3 H, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float NdotH = max(dot(N, H), 0.0);
+    float NdotH2 = NdotH * NdotH;
+
+    float denom = (NdotH2 * (a2 - 1.0) + 1.0);
+    denom = PI * denom * denom;
+
+    return a2 / max(denom, 0.0001);
+}
+
+// Geometry Function (Smith's Schlick-GGX)
+// Describes self-shadowing of microfacets
+float GeometrySchlickGGX(float NdotV, float roughness) {
+    float r = (roughness + 1.0);
+    float k = (r * r) / 8.0;  // Direct lighting
+
+    float denom = NdotV * (1.0 - k) + k;
+    return NdotV / max(denom, 0.0001);
+}
+
+float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness) {
+    float NdotV = max(dot(N, V), 0.0);
+    float NdotL = max(dot(N, L), 0.0);
+    float ggx1 = GeometrySchlickGGX(NdotV, roughness);
+    float ggx2 = GeometrySchlickGGX(NdotL, roughness);
+
+    return ggx1 * ggx2;
+}
+
+// Fresnel Function (Fresnel-Schlick approximation)
+// Describes how much light is reflected vs. refracted
+hvec3 FresnelSchlick(hfloat cosTheta, hvec3 F0) {
+    return F0 + (hfloat(1.0) - F0) * pow(clamp(hfloat(1.0) - cosTheta, hfloat(0.0), hfloat(1.0)), hfloat(5.0));
+}
+
+// Fresnel-Schlick with roughness for IBL
+hvec3 FresnelSchlickRoughness(hfloat cosTheta, hvec3 F0, hfloat roughness) {
+    return F0 + (max(hvec3(hfloat(1.0) - roughness), F0) - F0) *
+           pow(clamp(hfloat(1.0) - cosTheta, hfloat(0.0), hfloat(1.0)), hfloat(5.0));
+}
+
+// ============================================================================
+// PBR Lighting Calculation
+// ============================================================================
+
+// Calculate PBR lighting contribution from a single light using Cook-Torrance BRDF
+vec3 calculatePBRLighting(LightData light, vec3 fragPos, vec3 normal, vec3 viewDir,
+                          hvec3 albedo, float roughness, hfloat metallic, float shadowFactor) {
+    int lightType = int(light.positionAndType.w);
+    vec3 lightColor = light.colorAndIntensity.rgb * light.colorAndIntensity.w;
+
+    // Compute light direction and attenuation
+    vec3 lightDir;
+    float attenuation = 1.0;
+
+    if (lightType == LIGHT_TYPE_DIRECTIONAL) {
+        // Directional light (parallel rays)
+        lightDir = normalize(-light.directionAndRange.xyz);
+        // No attenuation for directional lights
+
+    } else if (lightType == LIGHT_TYPE_POINT) {
+        // Point light (omnidirectional)
+        vec3 lightPos = light.positionAndType.xyz;
+        vec3 lightToFrag = fragPos - lightPos;
+        float distance = length(lightToFrag);
+        lightDir = normalize(-lightToFrag);
+
+        // Attenuation: 1 / (constant + linear * d + quadratic * d^2)
+        float range = light.directionAndRange.w;
+        float attConst = light.spotAngles.z;
+        float attLinear = light.spotAngles.w;
+        float attQuadratic = 1.0 / (range * range);
+        attenuation = 1.0 / (attConst + attLinear * distance + attQuadratic * distance * distance);
+
+    } else if (lightType == LIGHT_TYPE_SPOT) {
+        // Spot light (cone)
+        vec3 lightPos = light.positionAndType.xyz;
+        vec3 lightToFrag = fragPos - lightPos;
+        float distance = length(lightToFrag);
+        lightDir = normalize(-lightToFrag);
+
+        // Distance attenuation (same as point light)
+        float range = light.directionAndRange.w;
+        float attConst = light.spotAngles.z;
+        float attLinear = light.spotAngles.w;
+        float attQuadratic = 1.0 / (range * range);
+        float distAttenuation = 1.0 / (attConst + attLinear * distance + attQuadratic * distance * distance);
+
+        // Cone attenuation (smooth falloff between inner and outer angles)
+        vec3 spotDir = normalize(light.directionAndRange.xyz);
+        float theta = dot(lightDir, -spotDir);
+        float innerCutoff = cos(light.spotAngles.x);
+        float outerCutoff = cos(light.spotAngles.y);
+        float epsilon = innerCutoff - outerCutoff;
+        float coneAttenuation = clamp((theta - outerCutoff) / epsilon, 0.0, 1.0);
+
+        attenuation = distAttenuation * coneAttenuation;
+    }
+
+    // Calculate radiance
+    vec3 radiance = lightColor * attenuation;
+
+    // Cook-Torrance BRDF
+    vec3 N = normal;
+    vec3 V = viewDir;
+    vec3 L = lightDir;
+    vec3 H = normalize(V + L);
+
+    // Calculate F0 (surface reflection at zero incidence)
+    // Dielectrics (non-metals): ~0.04 (4% reflection)
+    // Metals: use albedo color (absorb diffuse, reflect albedo as specular)
+    hvec3 F0 = hvec3(0.04);
+    F0 = mix(F0, albedo, metallic);
+
+    // Cook-Torrance BRDF components
+    float NDF = DistributionGGX(N, H, roughness);   // Normal Distribution
+    float G = GeometrySmith(N, V, L, roughness);    // Geometry shadowing/masking
+    hvec3 F = FresnelSchlick(hfloat(max(dot(H, V), 0.0)), F0); // Fresnel reflection
+
+    // Specular component (Cook-Torrance). The scalar part divides by a denominator that
+    // vanishes at grazing angles, so it is formed at full precision and saturated.
+    float denominator = 4.0 * max(dot(N, V), 0.0) * max(dot(N, L), 0.0) + 0.0001;
+    hvec3 specular = F * hfloat(min(NDF * G / denominator, HFLOAT_MAX));
+
+    // Energy conservation: kS + kD = 1.0
+    hvec3 kS = F;  // Specular reflection ratio (Fresnel)
+    hvec3 kD = hvec3(1.0) - kS;  // Diffuse reflection ratio
+    kD *= hfloat(1.0) - metallic;  // Metallic surfaces have no diffuse reflection
+
+    // Lambert diffuse BRDF
+    float NdotL = max(dot(N, L), 0.0);
+
+    // Final lighting contribution: (diffuse + specular) * radiance * NdotL * shadow. The
+    // radiance is unbounded, so the product and the sum over lights are fp32.
+    return vec3(kD * albedo / hfloat(PI) + specular) * radiance * NdotL * shadowFactor;
+}
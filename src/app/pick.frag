@@ -0,0 +1,18 @@
+#version 450
+
+// Object picking fragment shader (ObjectPicker): the world position of the nearest
+// surface and its mesh index plus one, 0 being the clear value (nothing drawn). The
+// index is a float, exact up to 2^24 meshes, so the target needs no integer format.
+
+layout(location = 0) in vec3 fragWorldPos;
+
+// Per-draw push constants: the mesh of the draw (MeshInstance::userData)
+layout(push_constant) uniform PushConstants {
+    uint meshIndex;
+} pushConstants;
+
+layout(location = 0) out vec4 outPick;
+
+void main() {
+    outPick = vec4(fragWorldPos, float(pushConstants.meshIndex + 1u));
+}
@@ -0,0 +1,33 @@
+// Ray query helpers shared by model_raytraced.frag, path_trace.comp and probe_update.comp.
+// The includer enables GL_EXT_ray_query and declares sceneTopLevel.
+
+// Moves a ray origin off the surface by a few ulps of its coordinates along the normal
+// on the ray's side, instead of a world-space bias: the offset scales with the position's
+// magnitude, so it clears rounding errors at any distance from the origin (Wachter and
+// Binder, "A Fast and Robust Method for Avoiding Self-Intersection")
+vec3 offsetRayOrigin(vec3 position, vec3 normal, vec3 direction) {
+    const float ORIGIN = 1.0 / 32.0;
+    const float FLOAT_SCALE = 1.0 / 65536.0;
+    const float INT_SCALE = 256.0;
+
+    normal = dot(normal, direction) < 0.0 ? -normal : normal;
+    ivec3 intOffset = ivec3(INT_SCALE * normal);
+    vec3 intPosition = vec3(
+        intBitsToFloat(floatBitsToInt(position.x) + (position.x < 0.0 ? -intOffset.x : intOffset.x)),
+        intBitsToFloat(floatBitsToInt(position.y) + (position.y < 0.0 ? -intOffset.y : intOffset.y)),
+        intBitsToFloat(floatBitsToInt(position.z) + (position.z < 0.0 ? -intOffset.z : intOffset.z)));
+    return vec3(abs(position.x) < ORIGIN ? position.x + FLOAT_SCALE * normal.x : intPosition.x,
+                abs(position.y) < ORIGIN ? position.y + FLOAT_SCALE * normal.y : intPosition.y,
+                abs(position.z) < ORIGIN ? position.z + FLOAT_SCALE * normal.z : intPosition.z);
+}
+
+// 1.0 when nothing in the scene lies on the ray before tMax, 0.0 otherwise. Any hit
+// ends the query: the closest one does not matter, and every instance is opaque.
+float traceShadowRay(vec3 origin, vec3 direction, float tMax) {
+    rayQueryEXT rayQuery;
+    rayQueryInitializeEXT(rayQuery, sceneTopLevel, gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsOpaqueEXT,
+                          0xFFu, origin, 0.0, direction, tMax);
+    while (rayQueryProceedEXT(rayQuery)) {
+    }
+    return rayQueryGetIntersectionTypeEXT(rayQuery, true) == gl_RayQueryCommittedIntersectionNoneEXT ? 1.0 : 0.0;
+}
@@ -0,0 +1,64 @@
+// Ray-traced shadows of model_raytraced.frag, which defines RAY_TRACED_SHADOWS so that
+// these replace shadow_maps.glsl's calculateShadow() and calculateLocalShadow(). The
+// includer declares sceneTopLevel and the noise and light radii of ShadowUBO.
+
+#include "ray_queries.glsl"
+
+// ============================================================================
+// Ray-Traced Shadows
+// ============================================================================
+
+// Per-pixel noise in [0, 1) (interleaved gradient noise), advanced by the golden ratio
+// each jittered frame so temporal AA averages the samples of neighbouring frames
+float shadowNoise(vec2 pixelOffset) {
+    float noise = fract(52.9829189 * fract(dot(gl_FragCoord.xy + pixelOffset, vec2(0.06711056, 0.00583715))));
+    return fract(noise + float(shadow.noiseFrame) * 0.61803399);
+}
+
+// A point on the unit disc, uniform over its area
+vec2 sampleDisc() {
+    float radius = sqrt(shadowNoise(vec2(0.0)));
+    float angle = 6.2831853 * shadowNoise(vec2(5.588238));
+    return radius * vec2(cos(angle), sin(angle));
+}
+
+// Offset of disc, a sampleDisc() point, in the plane perpendicular to axis
+vec3 discOffset(vec3 axis, vec2 disc) {
+    vec3 tangent = normalize(cross(abs(axis.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0), axis));
+    vec3 bitangent = cross(axis, tangent);
+    return tangent * disc.x + bitangent * disc.y;
+}
+
+// Shadow of the key light (the frame's first directional light): one ray towards a
+// point of its disc, lightAngularRadius wide
+// Returns 0.0 for fully shadowed, 1.0 for fully lit
+float calculateShadow(vec3 fragPos) {
+    if (frame.directionalLightCount == 0u) {
+        return 1.0;
+    }
+    vec3 toLight = normalize(-lightBuffer.lights[frame.lightBase].directionAndRange.xyz);
+    vec3 direction = normalize(toLight + discOffset(toLight, sampleDisc() * tan(shadow.lightAngularRadius)));
+    return traceShadowRay(offsetRayOrigin(fragPos, normalize(fragNormal), direction), direction, 1.0e6);
+}
+
+// Shadow of a point or spot light: one ray to a point of a disc of lightSourceRadius
+// facing the fragment, ending there. The lights that cast shadows are those ShadowAtlas
+// picked (a first face); their faces are not rendered.
+// Returns 1.0 for lights without shadows
+float calculateLocalShadow(uint lightIndex, LightData light, vec3 fragPos, vec3 normal) {
+    uint first = floatBitsToUint(shadowAtlas.values[frame.shadowAtlasBase + lightIndex / 4u][lightIndex % 4u]);
+    if (first == SHADOW_ATLAS_NO_FACE) {
+        return 1.0;
+    }
+
+    vec3 lightPos = light.positionAndType.xyz;
+    vec3 axis = normalize(lightPos - fragPos);
+    vec3 target = lightPos + discOffset(axis, sampleDisc() * shadow.lightSourceRadius);
+    vec3 origin = offsetRayOrigin(fragPos, normalize(fragNormal), target - fragPos);
+    vec3 toTarget = target - origin;
+    float distance = length(toTarget);
+    if (distance <= 0.0) {
+        return 1.0;
+    }
+    return traceShadowRay(origin, toTarget / distance, distance);
+}
@@ -0,0 +1,267 @@
+// Shadow maps of the key light's cascades and of the point and spot lights' ShadowAtlas
+// tiles, shared by model.frag, its variants and deferred_lighting.comp. The includer
+// declares the shadow bindings, frame and LightData, and may define:
+//   SHADOW_FILTER       the ShadowFilter in use (default: frame.shadowFilter)
+//   SHADOW_NOISE_PIXEL  the pixel the Poisson disc's rotation hashes (default: gl_FragCoord.xy)
+//   RAY_TRACED_SHADOWS  leaves calculateShadow() and calculateLocalShadow() to
+//                       ray_traced_shadows.glsl; the cascades stay for the debug views
+// The depth and moments maps have a single level and are read with textureLod, which
+// compute shaders need.
+
+// ============================================================================
+// Shadow Mapping with PCF
+// ============================================================================
+
+// Cascade of a world position: the first whose split is beyond its view depth, or
+// cascadeCount past the shadow distance
+uint selectCascade(vec3 fragPos) {
+    float viewDepth = -(frame.view * vec4(fragPos, 1.0)).z;
+    for (uint i = 0u; i < shadow.cascadeCount; i++) {
+        if (viewDepth < shadow.cascadeSplits[i]) {
+            return i;
+        }
+    }
+    return shadow.cascadeCount;
+}
+
+// The cascade the debug views show; past the shadow distance, the last one
+uint debugCascade(vec3 fragPos) {
+    return min(selectCascade(fragPos), uint(MAX_SHADOW_CASCADES - 1));
+}
+
+// Shadow filters (ShadowFilter on the CPU), cheapest first
+#define SHADOW_FILTER_HARDWARE 0u  // One bilinear comparison tap
+#define SHADOW_FILTER_PCF 1u       // 3x3 comparison taps
+#define SHADOW_FILTER_POISSON 2u   // 16 comparison taps on a rotated Poisson disc
+#define SHADOW_FILTER_PCSS 3u      // Blocker search, then Poisson taps over the penumbra
+#define SHADOW_FILTER_EVSM 4u      // One filtered tap of the exponential moments
+#define EVSM_EXPONENT 5.54         // ShadowMoments::EXPONENT
+#define MAX_FILTER_TEXELS 32.0     // Widest Poisson disc and blocker search, in texels
+
+#ifndef SHADOW_NOISE_PIXEL
+#define SHADOW_NOISE_PIXEL gl_FragCoord.xy
+#endif
+
+#ifndef SHADOW_FILTER
+#define SHADOW_FILTER frame.shadowFilter
+#endif
+
+uint shadowFilter() {
+    return SHADOW_FILTER;
+}
+
+const vec2 POISSON_DISC[16] = vec2[](
+    vec2(-0.94201624, -0.39906216), vec2(0.94558609, -0.76890725),
+    vec2(-0.09418410, -0.92938870), vec2(0.34495938, 0.29387760),
+    vec2(-0.91588581, 0.45771432), vec2(-0.81544232, -0.87912464),
+    vec2(-0.38277543, 0.27676845), vec2(0.97484398, 0.75648379),
+    vec2(0.44323325, -0.97511554), vec2(0.53742981, -0.47373420),
+    vec2(-0.26496911, -0.41893023), vec2(0.79197514, 0.19090188),
+    vec2(-0.24188840, 0.99706507), vec2(-0.81409955, 0.91437590),
+    vec2(0.19984126, 0.78641367), vec2(0.14383161, -0.14100790)
+);
+
+// Per-pixel rotation of the Poisson disc (interleaved gradient noise): neighbouring
+// pixels take different offsets, which turns banding into fine noise
+mat2 poissonRotation() {
+    float angle = 6.2831853 * fract(52.9829189 * fract(dot(SHADOW_NOISE_PIXEL, vec2(0.06711056, 0.00583715))));
+    float s = sin(angle);
+    float c = cos(angle);
+    return mat2(c, s, -s, c);
+}
+
+// Average of 16 comparison taps on a disc of radius (texture coordinates) around coord
+float poissonShadow(vec2 coord, vec2 tileMin, vec2 tileMax, float depth, float radius) {
+    mat2 rotation = poissonRotation();
+    float shadowFactor = 0.0;
+    for (int i = 0; i < 16; i++) {
+        vec2 sampleCoord = clamp(coord + rotation * POISSON_DISC[i] * radius, tileMin, tileMax);
+        shadowFactor += texture(shadowMapSampler, vec3(sampleCoord, depth));
+    }
+    return shadowFactor / 16.0;
+}
+
+// Percentage-closer soft shadows: the blockers' average depth sets the penumbra width,
+// which grows with the distance from blocker to receiver
+float pcssShadow(uint cascade, vec2 coord, vec2 tileMin, vec2 tileMax, float depth, float texel) {
+    // In texture coordinates per unit of depth between blocker and receiver
+    float penumbraScale = shadow.cascadePenumbraScales[cascade] * shadow.cascadeRects[cascade].z;
+    float minRadius = shadow.filterRadius * texel;
+    float maxRadius = MAX_FILTER_TEXELS * texel;
+
+    // Search as wide as the penumbra of a blocker at the near plane
+    mat2 rotation = poissonRotation();
+    float searchRadius = clamp(depth * penumbraScale, minRadius, maxRadius);
+    float blockerDepth = 0.0;
+    float blockerCount = 0.0;
+    for (int i = 0; i < 16; i++) {
+        vec2 sampleCoord = clamp(coord + rotation * POISSON_DISC[i] * searchRadius, tileMin, tileMax);
+        float sampleDepth = textureLod(shadowDepthSampler, sampleCoord, 0.0).r;
+        if (sampleDepth < depth) {
+            blockerDepth += sampleDepth;
+            blockerCount += 1.0;
+        }
+    }
+    if (blockerCount == 0.0) {
+        return 1.0;  // No blockers, fully lit
+    }
+    blockerDepth /= blockerCount;
+
+    float penumbra = clamp((depth - blockerDepth) * penumbraScale, minRadius, maxRadius);
+    return poissonShadow(coord, tileMin, tileMax, depth, penumbra);
+}
+
+// One-sided Chebyshev bound on the fraction of the filtered depths at or beyond depth
+float chebyshevUpperBound(vec2 moments, float depth) {
+    if (depth <= moments.x) {
+        return 1.0;
+    }
+    float variance = max(moments.y - moments.x * moments.x, 1e-4 * depth * depth);
+    float delta = depth - moments.x;
+    return variance / (variance + delta * delta);
+}
+
+// Exponential variance shadow maps: the bound of both warps, the tighter one wins
+float evsmShadow(vec4 rect, vec2 coord, float depth) {
+    // Keep the bilinear footprint of the half-resolution moments inside the tile
+    vec2 momentTexel = 1.0 / textureSize(shadowMomentsSampler, 0);
+    vec4 moments = textureLod(shadowMomentsSampler, clamp(coord, rect.xy + momentTexel * 0.5,
+                                                          rect.xy + rect.zw - momentTexel * 0.5), 0.0);
+    float d = depth * 2.0 - 1.0;
+    float positive = chebyshevUpperBound(moments.xy, exp(EVSM_EXPONENT * d));
+    float negative = chebyshevUpperBound(moments.zw, -exp(-EVSM_EXPONENT * d));
+    float visibility = min(positive, negative);
+
+    // Light bleeding reduction: the bound's low tail counts as shadowed
+    return clamp((visibility - shadow.evsmBleedReduction) / (1.0 - shadow.evsmBleedReduction), 0.0, 1.0);
+}
+
+#ifndef RAY_TRACED_SHADOWS
+
+// Calculate shadow factor with the pipeline's shadow filter
+// Returns 0.0 for fully shadowed, 1.0 for fully lit
+float calculateShadow(vec3 fragPos) {
+    uint cascade = selectCascade(fragPos);
+    if (cascade >= shadow.cascadeCount) {
+        return 1.0;  // Beyond the shadow distance = fully lit
+    }
+
+    // Transform fragment position to the cascade's light space
+    vec4 fragPosLightSpace = shadow.cascadeMatrices[cascade] * vec4(fragPos, 1.0);
+
+    // Perform perspective divide (for orthographic this doesn't change anything, but we keep it for consistency)
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+
+    // Transform to [0,1] range across the cascade
+    // IMPORTANT: In Vulkan, depth is already in [0,1] range, only X/Y need transformation
+    projCoords.xy = projCoords.xy * 0.5 + 0.5;
+    // projCoords.z is already in [0,1] for Vulkan (no transformation needed)
+
+    // Check if fragment is outside shadow map bounds
+    if (projCoords.z > 1.0 || projCoords.x < 0.0 || projCoords.x > 1.0 ||
+        projCoords.y < 0.0 || projCoords.y > 1.0) {
+        return 1.0;  // Outside shadow map = fully lit
+    }
+
+    // Apply depth bias to prevent shadow acne
+    float currentDepth = projCoords.z - shadow.shadowBias;
+
+    // Clamp depth to [0, 1] range
+    currentDepth = clamp(currentDepth, 0.0, 1.0);
+
+    // Every filter clamps its taps to the cascade's tile so no sample reads a
+    // neighbouring cascade
+    vec2 texelSize = 1.0 / textureSize(shadowMapSampler, 0);
+    vec4 rect = shadow.cascadeRects[cascade];
+    vec2 tileCoord = rect.xy + projCoords.xy * rect.zw;
+    vec2 tileMin = rect.xy + texelSize * 0.5;
+    vec2 tileMax = rect.xy + rect.zw - texelSize * 0.5;
+
+    uint filterMode = shadowFilter();
+    if (filterMode == SHADOW_FILTER_HARDWARE) {
+        // The comparison sampler's bilinear filter blends the 2x2 nearest results
+        return texture(shadowMapSampler, vec3(clamp(tileCoord, tileMin, tileMax), currentDepth));
+    } else if (filterMode == SHADOW_FILTER_POISSON) {
+        return poissonShadow(tileCoord, tileMin, tileMax, currentDepth, shadow.filterRadius * texelSize.x);
+    } else if (filterMode == SHADOW_FILTER_PCSS) {
+        return pcssShadow(cascade, tileCoord, tileMin, tileMax, currentDepth, texelSize.x);
+    } else if (filterMode == SHADOW_FILTER_EVSM) {
+        return evsmShadow(rect, tileCoord, currentDepth);
+    }
+
+    // PCF with 3x3 kernel for soft shadows
+    float shadowFactor = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            vec2 offset = vec2(x, y) * texelSize;
+            vec3 sampleCoord = vec3(clamp(tileCoord + offset, tileMin, tileMax), currentDepth);
+            // texture() with sampler2DShadow performs hardware PCF comparison
+            shadowFactor += texture(shadowMapSampler, sampleCoord);
+        }
+    }
+    shadowFactor /= 9.0;  // Average the 9 samples
+
+    return shadowFactor;
+}
+
+// Shadow of a point or spot light from its ShadowAtlas faces: 3x3 PCF, or one tap with
+// the hardware filter
+// Returns 1.0 for lights without shadows
+float calculateLocalShadow(uint lightIndex, LightData light, vec3 fragPos, vec3 normal) {
+    uint first = floatBitsToUint(shadowAtlas.values[frame.shadowAtlasBase + lightIndex / 4u][lightIndex % 4u]);
+    if (first == SHADOW_ATLAS_NO_FACE) {
+        return 1.0;
+    }
+
+    // A point light's face is the one its major axis towards the fragment points through
+    vec3 toFrag = fragPos - light.positionAndType.xyz;
+    if (int(light.positionAndType.w) == LIGHT_TYPE_POINT) {
+        vec3 axis = abs(toFrag);
+        uint face;
+        if (axis.x >= axis.y && axis.x >= axis.z) {
+            face = toFrag.x >= 0.0 ? 0u : 1u;
+        } else if (axis.y >= axis.z) {
+            face = toFrag.y >= 0.0 ? 2u : 3u;
+        } else {
+            face = toFrag.z >= 0.0 ? 4u : 5u;
+        }
+        first += face * 5u;
+    }
+    mat4 faceMatrix = mat4(shadowAtlas.values[first], shadowAtlas.values[first + 1u],
+                           shadowAtlas.values[first + 2u], shadowAtlas.values[first + 3u]);
+    vec4 rect = shadowAtlas.values[first + 4u];
+
+    // Perspective depth has no usable constant bias: push the position along the normal by
+    // about two texels of the tile at the fragment's distance instead
+    vec2 texelSize = 1.0 / textureSize(shadowAtlasSampler, 0);
+    float tileTexels = rect.z / texelSize.x;
+    vec3 offsetPos = fragPos + normal * (length(toFrag) * 2.0 / tileTexels);
+
+    vec4 fragPosLightSpace = faceMatrix * vec4(offsetPos, 1.0);
+    if (fragPosLightSpace.w <= 0.0) {
+        return 1.0;  // Behind a spot light
+    }
+    vec3 projCoords = fragPosLightSpace.xyz / fragPosLightSpace.w;
+    projCoords.xy = projCoords.xy * 0.5 + 0.5;
+    if (projCoords.z > 1.0 || any(lessThan(projCoords.xy, vec2(0.0))) || any(greaterThan(projCoords.xy, vec2(1.0)))) {
+        return 1.0;  // Outside the spot cone or beyond the range
+    }
+
+    vec2 tileCoord = rect.xy + projCoords.xy * rect.zw;
+    vec2 tileMin = rect.xy + texelSize * 0.5;
+    vec2 tileMax = rect.xy + rect.zw - texelSize * 0.5;
+    if (shadowFilter() == SHADOW_FILTER_HARDWARE) {
+        return texture(shadowAtlasSampler, vec3(clamp(tileCoord, tileMin, tileMax), projCoords.z));
+    }
+
+    float shadowFactor = 0.0;
+    for (int x = -1; x <= 1; x++) {
+        for (int y = -1; y <= 1; y++) {
+            vec2 offset = vec2(x, y) * texelSize;
+            shadowFactor += texture(shadowAtlasSampler, vec3(clamp(tileCoord + offset, tileMin, tileMax), projCoords.z));
+        }
+    }
+    return shadowFactor / 9.0;
+}
+
+#endif // RAY_TRACED_SHADOWS
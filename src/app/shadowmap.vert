@@ -2,19 +2,53 @@
 
 // Shadow map vertex shader - depth-only rendering from light's perspective
 
-// Uniform buffer with light space matrix and model matrix
+// Light space matrix of the cascade being rendered, and the model matrix
 layout(binding = 0) uniform ShadowUBO {
-    mat4 lightSpaceMatrix;  // Light's view-projection matrix
-    mat4 model;             // Model matrix (identity for now)
-    float shadowBias;       // Padding to match fragment shader UBO
-    float padding[3];
+    mat4 lightSpaceMatrix;  // Cascade's view-projection matrix
+    mat4 model;             // Model matrix (with the dequantization of compact models)
+    uint vertexFormat;      // Pulled vertices: VertexFormat, 0 = Float, 1 = Compact
 } ubo;
 
+// World and normal matrix of each scene graph node (same buffer as the model pass)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;  // Inverse transpose of mat3(world), as vec4 columns
+};
+layout(binding = 1) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// Node of each instance (same buffer as the model pass)
+layout(binding = 2) readonly buffer InstanceNodes {
+    uint instanceNodes[];
+};
+
+#ifdef VERTEX_PULLING
+// shadowmap_pulled.vert: the position is fetched by gl_VertexIndex from the model's
+// geometry pool, as 32-bit words: 12 per VertexFormat::Float vertex, 5 per Compact one
+layout(std430, binding = 3) readonly buffer VertexBuffer {
+    uint words[];
+} vertexBuffer;
+#else
 // Input vertex attributes
 layout(location = 0) in vec3 inPosition;
+#endif
 // Note: We don't need normals or UVs for depth-only shadow pass
 
 void main() {
+#ifdef VERTEX_PULLING
+    // Compact positions are unorm in the quantization cube, dequantized by ubo.model
+    vec3 inPosition;
+    if (ubo.vertexFormat == 1u) {
+        uint base = uint(gl_VertexIndex) * 5u;
+        inPosition = vec3(unpackUnorm2x16(vertexBuffer.words[base]), unpackUnorm2x16(vertexBuffer.words[base + 1u]).x);
+    } else {
+        uint base = uint(gl_VertexIndex) * 12u;
+        inPosition = uintBitsToFloat(uvec3(vertexBuffer.words[base], vertexBuffer.words[base + 1u],
+                                           vertexBuffer.words[base + 2u]));
+    }
+#endif
+
     // Transform vertex to light space (NDC)
-    gl_Position = ubo.lightSpaceMatrix * ubo.model * vec4(inPosition, 1.0);
+    gl_Position = ubo.lightSpaceMatrix * ubo.model * nodeTransforms[instanceNodes[gl_InstanceIndex]].world * vec4(inPosition, 1.0);
 }
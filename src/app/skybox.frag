@@ -15,18 +15,23 @@ layout(push_constant) uniform PushConstants {
     float lod;          // Mipmap level (0 = sharp, higher = blurred)
 } pushConstants;
 
+// 1 = linear, unexposed color for the tone mapping pass (ToneMapper), as model.frag
+layout(constant_id = 2) const uint HDR_OUTPUT = 0u;
+
 void main() {
     // Sample environment cubemap with specified LOD
     vec3 color = textureLod(environmentMap, fragTexCoord, pushConstants.lod).rgb;
 
-    // Apply exposure
-    color = color * pushConstants.exposure;
+    if (HDR_OUTPUT == 0u) {
+        // Apply exposure
+        color = color * pushConstants.exposure;
 
-    // Tone mapping (simple clamp)
-    color = clamp(color, 0.0, 1.0);
+        // Tone mapping (simple clamp)
+        color = clamp(color, 0.0, 1.0);
 
-    // Gamma correction (linear to sRGB)
-    color = pow(color, vec3(1.0/2.2));
+        // Gamma correction (linear to sRGB)
+        color = pow(color, vec3(1.0/2.2));
+    }
 
     outColor = vec4(color, 1.0);
 }
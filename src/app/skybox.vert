@@ -1,30 +1,31 @@
 #version 450
 
-// Vertex positions for a cube (will be used as directions)
-layout(location = 0) in vec3 inPosition;
+// One triangle over the viewport at the far plane, made from the vertex index: no vertex
+// buffer is bound. Each corner carries the world direction through it, which the
+// rasterizer interpolates linearly across the screen.
 
 // Output texture coordinates (3D direction vector)
 layout(location = 0) out vec3 fragTexCoord;
 
-// Uniform buffer with view and projection matrices
+// The main frame constants, up to the matrix the skybox needs
 layout(binding = 0) uniform UniformBufferObject {
     mat4 model;
     mat4 view;
     mat4 projection;
+    mat4 viewProjection;
+    mat4 normalMatrix;
+    mat4 inverseSkyViewProjection;  // Inverse of projection * mat3(view)
 } ubo;
 
 void main() {
-    // Remove translation from view matrix (keep only rotation)
-    // This makes the skybox follow the camera rotation but not position
-    mat4 viewNoTranslation = mat4(mat3(ubo.view));
+    vec2 position = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2) * 2.0 - 1.0;
 
-    // Transform position
-    vec4 pos = ubo.projection * viewNoTranslation * vec4(inPosition, 1.0);
+    // z = 0: depth 0.0, infinitely far with reverse-Z, so only pixels nothing was drawn
+    // over pass GreaterOrEqual
+    gl_Position = vec4(position, 0.0, 1.0);
 
-    // Set z = w to ensure depth is always 1.0 (farthest possible)
-    // This ensures skybox is always behind everything else
-    gl_Position = pos.xyww;
-
-    // Use vertex position as texture coordinate direction
-    fragTexCoord = inPosition;
+    // Without the view's translation, the near plane point (z = 1, finite unlike the
+    // infinite far plane) is the direction from the camera
+    vec4 direction = ubo.inverseSkyViewProjection * vec4(position, 1.0, 1.0);
+    fragTexCoord = direction.xyz / direction.w;
 }
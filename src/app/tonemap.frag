@@ -0,0 +1,51 @@
+#version 450
+
+// Tone mapping pass (ToneMapper): the linear HDR scene color, exposed, tone mapped and
+// gamma corrected into the back buffer, once per pixel instead of once per shaded
+// fragment of the scene's draws
+
+layout(binding = 0) uniform sampler2D sceneColor;
+
+// AutoExposure::ExposureState, written by auto_exposure.comp
+layout(std430, binding = 1) readonly buffer ExposureState {
+    float luminance;
+    float exposure;
+} state;
+
+// ToneMapper::Settings
+layout(push_constant) uniform PushConstants {
+    float exposure;        // With autoExposure, compensation on top of the measured one
+    uint toneMapOperator;  // ToneMapOperator: 0 = clamp, 1 = ACES
+    uint autoExposure;
+} pushConstants;
+
+layout(location = 0) out vec4 outColor;
+
+// ACES filmic curve (Narkowicz's fit), as the one model.frag carries
+vec3 toneMapACES(vec3 color) {
+    const float a = 2.51;
+    const float b = 0.03;
+    const float c = 2.43;
+    const float d = 0.59;
+    const float e = 0.14;
+    return clamp((color * (a * color + b)) / (color * (c * color + d) + e), 0.0, 1.0);
+}
+
+void main() {
+    float exposure = pushConstants.exposure;
+    if (pushConstants.autoExposure != 0u) {
+        exposure *= state.exposure;
+    }
+    vec3 color = texelFetch(sceneColor, ivec2(gl_FragCoord.xy), 0).rgb * exposure;
+
+    if (pushConstants.toneMapOperator == 1u) {
+        color = toneMapACES(color);
+    } else {
+        color = clamp(color, 0.0, 1.0);
+    }
+
+    // Gamma correction (linear to sRGB)
+    color = pow(color, vec3(1.0 / 2.2));
+
+    outColor = vec4(color, 1.0);
+}
@@ -0,0 +1,64 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Visibility buffer pass (VisibilityBuffer): one 32-bit id per pixel, the triangle's
+// cluster above its index in the cluster, plus one (0 is the clear value: nothing drawn),
+// for visibility_resolve.comp to shade. Reads
+// the bindless material table only to drop alpha-masked texels, as gbuffer.frag does.
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragFirstCluster;
+
+// Per-material data (BindlessMaterialData on the CPU, as model_bindless.frag)
+struct BindlessMaterial {
+    vec3 albedo;
+    float roughness;
+    vec3 emissiveFactor;
+    float metallic;
+    uint albedoIndex;
+    uint normalIndex;
+    uint metallicIndex;
+    uint roughnessIndex;
+    uint aoIndex;
+    uint emissiveIndex;
+    uint textureFlags;  // MaterialTextureFlags
+    uint alphaParams;   // packHalf2x16(alpha, alphaCutoff)
+};
+
+layout(std430, binding = 1) readonly buffer MaterialBuffer {
+    BindlessMaterial materials[];
+} materialBuffer;
+
+// Must match BINDLESS_TEXTURE_CAPACITY in Application.h
+#define BINDLESS_TEXTURE_CAPACITY 1024
+layout(binding = 14) uniform sampler2D textures[BINDLESS_TEXTURE_CAPACITY];
+
+// Per-draw push constants (ModelPushConstants on the CPU)
+layout(push_constant) uniform PushConstants {
+    uint materialFlags;
+    uint materialIndex;
+} pushConstants;
+
+layout(location = 0) out uint outVisibility;
+
+const uint CLUSTER_TRIANGLES = 128u;  // GPUCuller::CLUSTER_TRIANGLES
+
+void main() {
+    // Masked materials drop their texels below the cutoff; blended ones are drawn
+    // forward after the lighting, not here
+    if ((pushConstants.materialFlags & (1u << 7)) != 0u) {
+        BindlessMaterial material = materialBuffer.materials[pushConstants.materialIndex];
+        vec2 alphaParams = unpackHalf2x16(material.alphaParams);
+        float alpha = alphaParams.x;
+        if ((pushConstants.materialFlags & (1u << 0)) != 0u) {  // HasAlbedoMap
+            alpha *= texture(textures[material.albedoIndex], fragTexCoord).a;
+        }
+        if (alpha < alphaParams.y) {
+            discard;
+        }
+    }
+
+    uint triangle = uint(gl_PrimitiveID);
+    outVisibility = (fragFirstCluster + triangle / CLUSTER_TRIANGLES) * CLUSTER_TRIANGLES +
+                    triangle % CLUSTER_TRIANGLES + 1u;
+}
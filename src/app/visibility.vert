@@ -0,0 +1,55 @@
+#version 450
+
+// Visibility buffer pass (VisibilityBuffer): positions only, through the culler's
+// visibility commands, whose first instance is the draw record rather than its node.
+// Locations 0 and 2 are the same types in the Float and Compact vertex layouts, so one
+// shader reads both; compact positions arrive normalized and the model matrix carries
+// their dequantization.
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 2) in vec2 inTexCoord;
+
+// Uniform buffer (MVP matrices)
+layout(binding = 0) uniform UniformBufferObject {
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+} ubo;
+
+// World and normal matrix of each scene graph node (NodeTransform on the CPU)
+struct NodeTransform {
+    mat4 world;
+    mat3x4 normal;
+};
+layout(binding = 15) readonly buffer NodeTransforms {
+    NodeTransform nodeTransforms[];
+};
+
+// GPUCuller::MeshCullData, one per draw record
+struct DrawRecord {
+    vec4 sphere;
+    vec4 cone;
+    uint indexCount;
+    uint firstIndex;
+    int vertexOffset;
+    uint firstInstance;  // Node transform the draw uses
+    uint mesh;
+    uint lod;
+    uint drawSlot;
+    uint firstCluster;   // Of the record's triangles, CLUSTER_TRIANGLES each
+};
+layout(std430, binding = 30) readonly buffer DrawRecords {
+    DrawRecord records[];
+};
+
+layout(location = 0) out vec2 fragTexCoord;  // For alpha-masked materials
+layout(location = 1) flat out uint fragFirstCluster;
+
+void main() {
+    uint record = gl_InstanceIndex;
+    mat4 model = ubo.model * nodeTransforms[records[record].firstInstance].world;
+    fragTexCoord = inTexCoord;
+    fragFirstCluster = records[record].firstCluster;
+    gl_Position = ubo.viewProjection * (model * vec4(inPosition, 1.0));
+}
@@ -0,0 +1,151 @@
+// ============================================================================
+// src/core/AllocationTracker.cpp
+// ============================================================================
+#include "metagfx/core/AllocationTracker.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace metagfx {
+
+namespace {
+
+// Constant-initialized: operator new runs before any dynamic initializer
+struct AllocationCounters {
+    std::atomic<uint64> allocations[ALLOCATION_TAG_COUNT];
+    std::atomic<uint64> bytes[ALLOCATION_TAG_COUNT];
+    std::atomic<uint64> frees;
+};
+
+AllocationCounters s_Counters;
+thread_local AllocationTag t_Tag = AllocationTag::Other;
+
+std::mutex s_FrameMutex;
+AllocationFrame s_LatestFrame;
+uint64 s_FrameNumber = 0;
+
+#ifdef METAGFX_ALLOCATION_TRACKING
+void* Allocate(std::size_t size) {
+    uint32 tag = static_cast<uint32>(t_Tag);
+    s_Counters.allocations[tag].fetch_add(1, std::memory_order_relaxed);
+    s_Counters.bytes[tag].fetch_add(size, std::memory_order_relaxed);
+    // As the default operator new: a unique pointer for size 0, the new-handler on failure
+    while (true) {
+        if (void* memory = std::malloc(size ? size : 1)) {
+            return memory;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+void Free(void* memory) {
+    if (memory) {
+        s_Counters.frees.fetch_add(1, std::memory_order_relaxed);
+        std::free(memory);
+    }
+}
+#endif
+
+} // anonymous namespace
+
+const char* GetAllocationTagName(AllocationTag tag) {
+    switch (tag) {
+        case AllocationTag::Other: return "Other";
+        case AllocationTag::Render: return "Render";
+        case AllocationTag::Load: return "Load";
+        case AllocationTag::UI: return "UI";
+    }
+    return "Unknown";
+}
+
+void AllocationTracker::EndFrame() {
+    if (!IsAvailable()) {
+        return;
+    }
+    AllocationFrame frame;
+    for (uint32 tag = 0; tag < ALLOCATION_TAG_COUNT; ++tag) {
+        frame.tags[tag].allocations = s_Counters.allocations[tag].exchange(0, std::memory_order_relaxed);
+        frame.tags[tag].bytes = s_Counters.bytes[tag].exchange(0, std::memory_order_relaxed);
+        frame.total.allocations += frame.tags[tag].allocations;
+        frame.total.bytes += frame.tags[tag].bytes;
+    }
+    frame.frees = s_Counters.frees.exchange(0, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> lock(s_FrameMutex);
+    frame.frameNumber = s_FrameNumber++;
+    s_LatestFrame = frame;
+}
+
+AllocationFrame AllocationTracker::GetLatestFrame() {
+    std::lock_guard<std::mutex> lock(s_FrameMutex);
+    return s_LatestFrame;
+}
+
+AllocationTag AllocationTracker::GetCurrentTag() {
+    return t_Tag;
+}
+
+void AllocationTracker::SetCurrentTag(AllocationTag tag) {
+    t_Tag = tag;
+}
+
+} // namespace metagfx
+
+#ifdef METAGFX_ALLOCATION_TRACKING
+// Replacements of the global allocation functions. The nothrow forms and the sized and
+// nothrow deletes are replaced too, so that every allocation is freed by the matching
+// function; the std::align_val_t forms keep their defaults, which pair among themselves.
+void* operator new(std::size_t size) {
+    return metagfx::Allocate(size);
+}
+
+void* operator new[](std::size_t size) {
+    return metagfx::Allocate(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return metagfx::Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return metagfx::Allocate(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* memory) noexcept {
+    metagfx::Free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    metagfx::Free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    metagfx::Free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    metagfx::Free(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    metagfx::Free(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    metagfx::Free(memory);
+}
+#endif
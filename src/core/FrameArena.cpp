@@ -0,0 +1,61 @@
+// ============================================================================
+// src/core/FrameArena.cpp
+// ============================================================================
+#include "metagfx/core/FrameArena.h"
+
+#include <memory>
+#include <new>
+
+namespace metagfx {
+
+// Of the block; more aligned allocations are padded inside it
+static constexpr size_t BLOCK_ALIGNMENT = 64;
+
+FrameArena::FrameArena(size_t initialSize) {
+    AllocateBlock(initialSize);
+}
+
+FrameArena::~FrameArena() {
+    FreeOverflow();
+    ::operator delete(m_Block, std::align_val_t(BLOCK_ALIGNMENT));
+}
+
+void FrameArena::Reset() {
+    if (m_OverflowBytes > 0) {
+        size_t peak = m_Used + m_OverflowBytes;
+        FreeOverflow();
+        ::operator delete(m_Block, std::align_val_t(BLOCK_ALIGNMENT));
+        AllocateBlock(peak + peak / 2);
+    }
+    m_Used = 0;
+}
+
+void* FrameArena::do_allocate(size_t bytes, size_t alignment) {
+    void* data = m_Block + m_Used;
+    size_t space = m_Capacity - m_Used;
+    if (std::align(alignment, bytes, data, space)) {
+        m_Used = m_Capacity - space + bytes;
+        return data;
+    }
+
+    // Out of space until Reset() grows the block
+    data = ::operator new(bytes, std::align_val_t(alignment));
+    m_Overflow.push_back({ data, bytes, alignment });
+    m_OverflowBytes += bytes + alignment;
+    return data;
+}
+
+void FrameArena::AllocateBlock(size_t size) {
+    m_Block = static_cast<std::byte*>(::operator new(size, std::align_val_t(BLOCK_ALIGNMENT)));
+    m_Capacity = size;
+}
+
+void FrameArena::FreeOverflow() {
+    for (const Overflow& overflow : m_Overflow) {
+        ::operator delete(overflow.data, overflow.size, std::align_val_t(overflow.alignment));
+    }
+    m_Overflow.clear();
+    m_OverflowBytes = 0;
+}
+
+} // namespace metagfx
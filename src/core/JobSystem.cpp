@@ -0,0 +1,320 @@
+// ============================================================================
+// src/core/JobSystem.cpp
+// ============================================================================
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/AllocationTracker.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <thread>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace metagfx {
+
+// Worker deque: the owner pushes and pops at the back, thieves take the front
+struct JobQueue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+// Queue 0..workerCount-1 belong to the workers, the last one takes submissions from
+// every other thread
+static std::vector<std::unique_ptr<JobQueue>> s_Queues;
+static std::vector<std::thread> s_Workers;
+static std::atomic<bool> s_Running{false};
+
+// Jobs pushed and not yet popped; idle workers sleep while it is zero
+static std::atomic<int32> s_QueuedJobs{0};
+static std::mutex s_SleepMutex;
+static std::condition_variable s_WakeCondition;
+
+static std::thread::id s_MainThread;
+static std::mutex s_MainThreadMutex;
+static std::vector<Job> s_MainThreadJobs;
+
+static thread_local int32 t_WorkerIndex = -1;  // Own queue of a worker thread
+
+static void PinThread(std::thread& thread, uint32 core) {
+#if defined(_WIN32)
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << core);
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+    (void)thread;
+    (void)core;  // macOS has affinity hints only; the scheduler places the threads
+#endif
+}
+
+static void Schedule(Job job) {
+    if (!s_Running) {
+        job();
+        return;
+    }
+#ifdef METAGFX_ALLOCATION_TRACKING
+    // The job's allocations count for the scope that submitted it
+    AllocationTag tag = AllocationTracker::GetCurrentTag();
+    if (tag != AllocationTag::Other) {
+        job = [tag, inner = std::move(job)]() {
+            AllocationScope scope(tag);
+            inner();
+        };
+    }
+#endif
+
+    size_t queue = t_WorkerIndex >= 0 ? static_cast<size_t>(t_WorkerIndex) : s_Queues.size() - 1;
+    s_QueuedJobs.fetch_add(1, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(s_Queues[queue]->mutex);
+        s_Queues[queue]->jobs.push_back(std::move(job));
+    }
+
+    // Taking the lock orders this against a worker between its check and its wait
+    { std::lock_guard<std::mutex> lock(s_SleepMutex); }
+    s_WakeCondition.notify_one();
+}
+
+// Pops a job from this thread's own queue, or steals one; runs it and returns true
+static bool TryRunJob() {
+    if (s_Queues.empty()) {
+        return false;
+    }
+
+    Job job;
+    if (t_WorkerIndex >= 0) {
+        JobQueue& own = *s_Queues[t_WorkerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+        }
+    }
+
+    // Steal starting past our own queue, so thieves spread over the victims
+    size_t queueCount = s_Queues.size();
+    size_t first = t_WorkerIndex >= 0 ? static_cast<size_t>(t_WorkerIndex) + 1 : 0;
+    for (size_t i = 0; !job && i < queueCount; ++i) {
+        JobQueue& victim = *s_Queues[(first + i) % queueCount];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+        }
+    }
+
+    if (!job) {
+        return false;
+    }
+    s_QueuedJobs.fetch_sub(1, std::memory_order_relaxed);
+    job();
+    return true;
+}
+
+static void WorkerMain(uint32 index) {
+    t_WorkerIndex = static_cast<int32>(index);
+#ifdef METAGFX_PROFILER_ENABLED
+    std::string name = "Worker " + std::to_string(index);
+    METAGFX_PROFILE_THREAD(name.c_str());
+#endif
+
+    while (s_Running) {
+        if (TryRunJob()) {
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(s_SleepMutex);
+        s_WakeCondition.wait(lock, []() { return s_QueuedJobs.load(std::memory_order_acquire) > 0 || !s_Running; });
+    }
+}
+
+void JobSystem::Init(const JobSystemDesc& desc) {
+    if (s_Running) {
+        METAGFX_WARN << "JobSystem::Init - Already initialized";
+        return;
+    }
+
+    s_MainThread = std::this_thread::get_id();
+
+    uint32 hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint32 workerCount = desc.workerCount > 0 ? desc.workerCount : hardwareThreads - 1;
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    workerCount = 0;  // No threads without SharedArrayBuffer builds (METAGFX_WEB_THREADS)
+#endif
+    if (workerCount == 0) {
+        METAGFX_INFO << "JobSystem initialized without worker threads (jobs run inline)";
+        return;
+    }
+
+    for (uint32 i = 0; i <= workerCount; ++i) {
+        s_Queues.push_back(std::make_unique<JobQueue>());
+    }
+    s_Running = true;
+
+    s_Workers.reserve(workerCount);
+    for (uint32 i = 0; i < workerCount; ++i) {
+        s_Workers.emplace_back(WorkerMain, i);
+        if (desc.pinWorkers) {
+            PinThread(s_Workers.back(), (i + 1) % hardwareThreads);
+        }
+    }
+
+    METAGFX_INFO << "JobSystem initialized with " << workerCount << " worker threads"
+                 << (desc.pinWorkers ? " (pinned)" : "");
+}
+
+void JobSystem::Shutdown() {
+    if (!s_Running) {
+        return;
+    }
+
+    // Whatever is still queued runs here, so every counter completes
+    while (TryRunJob()) {
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(s_SleepMutex);
+        s_Running = false;
+    }
+    s_WakeCondition.notify_all();
+    for (std::thread& worker : s_Workers) {
+        worker.join();
+    }
+    s_Workers.clear();
+
+    // Jobs queued by the last running ones
+    while (TryRunJob()) {
+    }
+    s_Queues.clear();
+    s_QueuedJobs = 0;
+}
+
+uint32 JobSystem::GetWorkerCount() {
+    return static_cast<uint32>(s_Workers.size());
+}
+
+bool JobSystem::IsMainThread() {
+    return std::this_thread::get_id() == s_MainThread;
+}
+
+void JobSystem::Run(Job job, JobCounter* counter) {
+    if (counter) {
+        counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        job = [job = std::move(job), counter]() {
+            job();
+            FinishJob(*counter);
+        };
+    }
+    Schedule(std::move(job));
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, Job job, JobCounter* counter) {
+    // Holds counter up from now, not only once the dependency is done
+    if (counter) {
+        counter->m_Pending.fetch_add(1, std::memory_order_relaxed);
+        job = [job = std::move(job), counter]() {
+            job();
+            FinishJob(*counter);
+        };
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+        if (!dependency.IsDone()) {
+            dependency.m_Continuations.push_back(std::move(job));
+            return;
+        }
+    }
+    Schedule(std::move(job));
+}
+
+void JobSystem::FinishJob(JobCounter& counter) {
+    // The last job out schedules what waited on the counter. Wait() takes the mutex
+    // before returning, so the counter outlives this unlock.
+    std::vector<Job> continuations;
+    {
+        std::lock_guard<std::mutex> lock(counter.m_Mutex);
+        if (counter.m_Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            continuations.swap(counter.m_Continuations);
+        }
+    }
+    for (Job& continuation : continuations) {
+        Schedule(std::move(continuation));
+    }
+}
+
+void JobSystem::Hold(JobCounter& counter) {
+    counter.m_Pending.fetch_add(1, std::memory_order_relaxed);
+}
+
+void JobSystem::Release(JobCounter& counter) {
+    FinishJob(counter);
+}
+
+void JobSystem::Wait(JobCounter& counter) {
+    while (!counter.IsDone()) {
+        if (IsMainThread()) {
+            ProcessMainThreadJobs();  // A job may be waiting on the main thread
+        }
+        if (!TryRunJob()) {
+            std::this_thread::yield();
+        }
+    }
+    std::lock_guard<std::mutex> lock(counter.m_Mutex);  // The last job has let go of it
+}
+
+void JobSystem::ParallelFor(uint32 count, uint32 minBatchSize,
+                            const std::function<void(uint32 begin, uint32 end)>& body) {
+    if (count == 0) {
+        return;
+    }
+
+    // A few ranges per thread, so stealing evens out uneven ranges
+    uint32 threadCount = GetWorkerCount() + 1;
+    uint32 batchSize = std::max(1u, minBatchSize);
+    uint32 batchCount = std::min((count + batchSize - 1) / batchSize, threadCount * 4);
+    if (threadCount == 1 || batchCount <= 1) {
+        body(0, count);
+        return;
+    }
+
+    auto rangeBegin = [count, batchCount](uint32 batch) {
+        return static_cast<uint32>(static_cast<uint64>(count) * batch / batchCount);
+    };
+
+    JobCounter counter;
+    for (uint32 batch = 1; batch < batchCount; ++batch) {
+        Run([&body, &rangeBegin, batch]() { body(rangeBegin(batch), rangeBegin(batch + 1)); }, &counter);
+    }
+    body(0, rangeBegin(1));
+    Wait(counter);
+}
+
+void JobSystem::RunOnMainThread(Job job) {
+    std::lock_guard<std::mutex> lock(s_MainThreadMutex);
+    s_MainThreadJobs.push_back(std::move(job));
+}
+
+void JobSystem::ProcessMainThreadJobs() {
+    std::vector<Job> jobs;
+    {
+        std::lock_guard<std::mutex> lock(s_MainThreadMutex);
+        jobs.swap(s_MainThreadJobs);
+    }
+    for (Job& job : jobs) {
+        job();
+    }
+}
+
+} // namespace metagfx
@@ -2,25 +2,53 @@
 // src/core/Logger.cpp
 // ============================================================================
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Types.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
 
 namespace metagfx {
 
-void Logger::Init() {
-    Log(LogLevel::Info, "Logger initialized");
-}
+namespace {
 
-void Logger::Log(LogLevel level, const std::string& message) {
-    const char* color = GetLevelColor(level);
-    const char* levelStr = GetLevelString(level);
-    const char* reset = "\033[0m";
-    
-    // Print: [timestamp] [LEVEL]: message
-    std::cout << color << "[" << GetTimestamp() << "] "
-              << "[" << levelStr << "]: " << reset
-              << message << std::endl;
-}
+struct Record {
+    LogLevel level = LogLevel::Info;
+    std::time_t time = 0;
+    std::string message;
+};
+
+struct Node {
+    std::atomic<Node*> next{nullptr};
+    Record record;
+};
+
+// Intrusive MPSC queue: producers swap themselves in at s_Head and then link the node
+// they replaced to theirs; the writer follows next pointers from s_Tail. The node last
+// popped stays as the queue's front, so the queue is never empty of nodes. A producer
+// between its swap and its link hides the nodes after it until it links.
+Node s_Stub;
+std::atomic<Node*> s_Head{&s_Stub};
+Node* s_Tail = &s_Stub;  // Writer thread, or the caller of Shutdown() once it has joined
 
-const char* Logger::GetLevelString(LogLevel level) {
+std::atomic<uint64> s_Queued{0};
+std::atomic<uint64> s_Written{0};
+std::atomic<uint32> s_Wake{0};  // Bumped after each push and by Shutdown(); the writer waits on it
+std::atomic<bool> s_Running{false};
+std::atomic<bool> s_Stop{false};
+std::thread* s_Writer = nullptr;
+
+// Keeps lines whole between the writer and messages written synchronously
+std::mutex s_OutputMutex;
+
+// Seconds formatted last; log lines within a second share the string
+struct TimestampCache {
+    std::time_t time = -1;
+    char text[16] = {};
+};
+
+const char* GetLevelString(LogLevel level) {
     switch (level) {
         case LogLevel::Trace:   return "TRACE";
         case LogLevel::Debug:   return "DEBUG";
@@ -32,7 +60,7 @@ const char* Logger::GetLevelString(LogLevel level) {
     }
 }
 
-const char* Logger::GetLevelColor(LogLevel level) {
+const char* GetLevelColor(LogLevel level) {
     switch (level) {
         case LogLevel::Trace:   return "\033[37m";  // White
         case LogLevel::Debug:   return "\033[36m";  // Cyan
@@ -44,13 +72,156 @@ const char* Logger::GetLevelColor(LogLevel level) {
     }
 }
 
-std::string Logger::GetTimestamp() {
-    auto now = std::time(nullptr);
-    auto tm = *std::localtime(&now);
-    
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%H:%M:%S");
-    return oss.str();
+const char* GetTimestamp(TimestampCache& cache, std::time_t time) {
+    if (time != cache.time) {
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &time);
+#else
+        localtime_r(&time, &tm);
+#endif
+        std::strftime(cache.text, sizeof(cache.text), "%H:%M:%S", &tm);
+        cache.time = time;
+    }
+    return cache.text;
+}
+
+// Appends: [timestamp] [LEVEL]: message
+void AppendLine(std::string& out, const Record& record, TimestampCache& cache) {
+    out += GetLevelColor(record.level);
+    out += '[';
+    out += GetTimestamp(cache, record.time);
+    out += "] [";
+    out += GetLevelString(record.level);
+    out += "]: \033[0m";
+    out += record.message;
+    out += '\n';
+}
+
+void WriteOutput(const std::string& text) {
+    std::lock_guard<std::mutex> lock(s_OutputMutex);
+    std::cout.write(text.data(), static_cast<std::streamsize>(text.size()));
+    std::cout.flush();
+}
+
+Node* Pop() {
+    Node* tail = s_Tail;
+    Node* next = tail->next.load(std::memory_order_acquire);
+    if (!next) {
+        return nullptr;
+    }
+    s_Tail = next;
+    if (tail != &s_Stub) {
+        delete tail;
+    }
+    return next;
+}
+
+// Writes everything reachable in the queue as one batch
+void Drain(TimestampCache& cache) {
+    std::string batch;
+    uint64 count = 0;
+    while (Node* node = Pop()) {
+        AppendLine(batch, node->record, cache);
+        node->record.message = std::string();
+        ++count;
+    }
+    if (count > 0) {
+        WriteOutput(batch);
+        s_Written.fetch_add(count, std::memory_order_release);
+        s_Written.notify_all();
+    }
+}
+
+void WriterMain() {
+    TimestampCache cache;
+    for (;;) {
+        uint32 wake = s_Wake.load(std::memory_order_acquire);
+        Drain(cache);
+        if (s_Stop.load(std::memory_order_acquire)) {
+            return;
+        }
+        s_Wake.wait(wake, std::memory_order_acquire);
+    }
+}
+
+} // namespace
+
+std::atomic<int> Logger::s_Level{static_cast<int>(LogLevel::Trace)};
+
+void Logger::Init() {
+    if (!s_Running.load(std::memory_order_acquire)) {
+        static bool registered = false;
+        if (!registered) {
+            std::atexit(Shutdown);
+            registered = true;
+        }
+        s_Stop.store(false, std::memory_order_relaxed);
+        s_Writer = new std::thread(WriterMain);
+        s_Running.store(true, std::memory_order_release);
+    }
+    Log(LogLevel::Info, "Logger initialized");
+}
+
+void Logger::Shutdown() {
+    if (!s_Running.exchange(false, std::memory_order_acq_rel)) {
+        return;
+    }
+    s_Stop.store(true, std::memory_order_release);
+    s_Wake.fetch_add(1, std::memory_order_release);
+    s_Wake.notify_one();
+    s_Writer->join();
+    delete s_Writer;
+    s_Writer = nullptr;
+
+    // What was pushed while the writer stopped
+    TimestampCache cache;
+    Drain(cache);
+}
+
+void Logger::Flush() {
+    if (!s_Running.load(std::memory_order_acquire)) {
+        return;
+    }
+    uint64 target = s_Queued.load(std::memory_order_acquire);
+    uint64 written = s_Written.load(std::memory_order_acquire);
+    while (written < target) {
+        s_Written.wait(written, std::memory_order_acquire);
+        written = s_Written.load(std::memory_order_acquire);
+    }
+}
+
+void Logger::SetLevel(LogLevel level) {
+    s_Level.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+void Logger::Log(LogLevel level, std::string message) {
+    std::time_t time = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+
+    if (!s_Running.load(std::memory_order_acquire)) {
+        static TimestampCache cache;  // Guarded by s_OutputMutex
+        Record record{ level, time, std::move(message) };
+        std::lock_guard<std::mutex> lock(s_OutputMutex);
+        std::string line;
+        AppendLine(line, record, cache);
+        std::cout.write(line.data(), static_cast<std::streamsize>(line.size()));
+        std::cout.flush();
+        return;
+    }
+
+    Node* node = new Node();
+    node->record = Record{ level, time, std::move(message) };
+    Node* prev = s_Head.exchange(node, std::memory_order_acq_rel);
+    prev->next.store(node, std::memory_order_release);
+
+    s_Queued.fetch_add(1, std::memory_order_release);
+    s_Wake.fetch_add(1, std::memory_order_release);
+    s_Wake.notify_one();
+
+    // The process may be about to end
+    if (level == LogLevel::Fatal) {
+        Flush();
+    }
 }
 
 } // namespace metagfx
@@ -0,0 +1,262 @@
+// ============================================================================
+// src/core/Profiler.cpp
+// ============================================================================
+#include "metagfx/core/Profiler.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+namespace metagfx {
+
+namespace {
+
+enum class EventType : uint32 {
+    Zone,
+    Counter
+};
+
+struct Event {
+    const char* name = nullptr;
+    uint64 startNs = 0;   // Counters: the time the value was recorded
+    uint64 endNs = 0;
+    double value = 0.0;
+    uint32 depth = 0;
+    EventType type = EventType::Zone;
+};
+
+// Single-producer ring of one thread's events: the owning thread pushes at head,
+// EndFrame() drains from tail. Buffers of threads that exit are kept and stay empty.
+struct ThreadBuffer {
+    uint32 id = 0;
+    std::string name;                  // Guarded by s_Mutex
+    uint32 depth = 0;                  // Open zones; owning thread only
+    std::atomic<uint32> head{0};
+    std::atomic<uint32> tail{0};
+    std::atomic<uint32> dropped{0};
+    Event events[Profiler::EVENT_CAPACITY];
+};
+
+static_assert((Profiler::EVENT_CAPACITY & (Profiler::EVENT_CAPACITY - 1)) == 0, "Ring capacity must be a power of two");
+
+const std::chrono::steady_clock::time_point s_Epoch = std::chrono::steady_clock::now();
+std::atomic<bool> s_Enabled{true};
+
+std::mutex s_Mutex;  // Thread registry, frame collection and history
+std::vector<std::unique_ptr<ThreadBuffer>> s_Threads;
+uint64 s_FrameStartNs = 0;
+uint64 s_FrameNumber = 0;
+ProfileFrame s_LatestFrame;
+std::deque<ProfileFrame> s_History;
+
+thread_local ThreadBuffer* t_Buffer = nullptr;
+
+ThreadBuffer& GetThreadBuffer() {
+    if (!t_Buffer) {
+        auto buffer = std::make_unique<ThreadBuffer>();
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        buffer->id = static_cast<uint32>(s_Threads.size());
+        buffer->name = "Thread " + std::to_string(buffer->id);
+        t_Buffer = buffer.get();
+        s_Threads.push_back(std::move(buffer));
+    }
+    return *t_Buffer;
+}
+
+void Push(ThreadBuffer& buffer, const Event& event) {
+    uint32 head = buffer.head.load(std::memory_order_relaxed);
+    if (head - buffer.tail.load(std::memory_order_acquire) >= Profiler::EVENT_CAPACITY) {
+        buffer.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    buffer.events[head & (Profiler::EVENT_CAPACITY - 1)] = event;
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+double ToMs(uint64 ns, uint64 originNs) {
+    return (static_cast<double>(ns) - static_cast<double>(originNs)) * 1e-6;
+}
+
+void WriteJsonString(std::ofstream& out, const char* text) {
+    out << '"';
+    for (const char* c = text; *c; ++c) {
+        if (*c == '"' || *c == '\\') {
+            out << '\\' << *c;
+        } else if (static_cast<unsigned char>(*c) >= 0x20) {
+            out << *c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+void Profiler::SetEnabled(bool enabled) {
+    s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::IsEnabled() {
+    return s_Enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    buffer.name = name;
+}
+
+uint64 Profiler::Now() {
+    return static_cast<uint64>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - s_Epoch).count());
+}
+
+void Profiler::BeginZone() {
+    GetThreadBuffer().depth++;
+}
+
+void Profiler::EndZone(const char* name, uint64 startNs) {
+    ThreadBuffer& buffer = GetThreadBuffer();
+    buffer.depth = buffer.depth > 0 ? buffer.depth - 1 : 0;
+
+    Event event;
+    event.name = name;
+    event.startNs = startNs;
+    event.endNs = Now();
+    event.depth = buffer.depth;
+    event.type = EventType::Zone;
+    Push(buffer, event);
+}
+
+void Profiler::Counter(const char* name, double value) {
+    if (!IsEnabled()) {
+        return;
+    }
+    Event event;
+    event.name = name;
+    event.startNs = Now();
+    event.value = value;
+    event.type = EventType::Counter;
+    Push(GetThreadBuffer(), event);
+}
+
+void Profiler::EndFrame() {
+    uint64 now = Now();
+    std::lock_guard<std::mutex> lock(s_Mutex);
+
+    ProfileFrame frame;
+    frame.frameNumber = s_FrameNumber++;
+    frame.startMs = ToMs(s_FrameStartNs, 0);
+    frame.durationMs = ToMs(now, s_FrameStartNs);
+
+    for (const auto& buffer : s_Threads) {
+        uint32 head = buffer->head.load(std::memory_order_acquire);
+        uint32 tail = buffer->tail.load(std::memory_order_relaxed);
+
+        ProfileThread thread;
+        thread.id = buffer->id;
+        thread.name = buffer->name;
+        thread.droppedEvents = buffer->dropped.exchange(0, std::memory_order_relaxed);
+
+        // Zones are pushed when they end, so children come before their parent
+        std::vector<const Event*> zones;
+        for (uint32 i = tail; i != head; ++i) {
+            const Event& event = buffer->events[i & (EVENT_CAPACITY - 1)];
+            if (event.type == EventType::Counter) {
+                frame.counters.push_back({ event.name, ToMs(event.startNs, s_FrameStartNs), event.value });
+            } else {
+                zones.push_back(&event);
+            }
+        }
+        std::stable_sort(zones.begin(), zones.end(), [](const Event* a, const Event* b) {
+            return a->startNs != b->startNs ? a->startNs < b->startNs : a->depth < b->depth;
+        });
+        for (const Event* event : zones) {
+            thread.zones.push_back({ event->name, event->depth, ToMs(event->startNs, s_FrameStartNs),
+                                     ToMs(event->endNs, event->startNs) });
+        }
+        buffer->tail.store(head, std::memory_order_release);
+
+        if (!thread.zones.empty() || thread.droppedEvents > 0) {
+            frame.threads.push_back(std::move(thread));
+        }
+    }
+    std::stable_sort(frame.counters.begin(), frame.counters.end(),
+                     [](const ProfileCounter& a, const ProfileCounter& b) { return a.timeMs < b.timeMs; });
+
+    s_FrameStartNs = now;
+    s_LatestFrame = frame;
+    s_History.push_back(std::move(frame));
+    if (s_History.size() > MAX_HISTORY_FRAMES) {
+        s_History.pop_front();
+    }
+}
+
+ProfileFrame Profiler::GetLatestFrame() {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    return s_LatestFrame;
+}
+
+std::vector<ProfileFrame> Profiler::GetFrames(double startMs, double endMs) {
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    std::vector<ProfileFrame> frames;
+    for (const ProfileFrame& frame : s_History) {
+        if (frame.startMs <= endMs && frame.startMs + frame.durationMs >= startMs) {
+            frames.push_back(frame);
+        }
+    }
+    return frames;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        METAGFX_ERROR << "Failed to write CPU trace: " << path;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+
+    // Complete ("X") events in microseconds, one track per thread plus one for frames;
+    // counters as "C" events. The first frame kept starts at 0.
+    double origin = s_History.empty() ? 0.0 : s_History.front().startMs;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":0,\"args\":{\"name\":\"Frames\"}}";
+    for (const auto& buffer : s_Threads) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->id + 1 << ",\"args\":{\"name\":";
+        WriteJsonString(out, buffer->name.c_str());
+        out << "}}";
+    }
+
+    for (const ProfileFrame& frame : s_History) {
+        double frameStart = (frame.startMs - origin) * 1000.0;
+        out << ",\n{\"name\":\"Frame " << frame.frameNumber << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0"
+            << ",\"ts\":" << frameStart << ",\"dur\":" << frame.durationMs * 1000.0 << "}";
+        for (const ProfileThread& thread : frame.threads) {
+            for (const ProfileZone& zone : thread.zones) {
+                out << ",\n{\"name\":";
+                WriteJsonString(out, zone.name);
+                out << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread.id + 1
+                    << ",\"ts\":" << frameStart + zone.startMs * 1000.0 << ",\"dur\":" << zone.durationMs * 1000.0
+                    << ",\"args\":{\"frame\":" << frame.frameNumber << "}}";
+            }
+        }
+        for (const ProfileCounter& counter : frame.counters) {
+            out << ",\n{\"name\":";
+            WriteJsonString(out, counter.name);
+            out << ",\"ph\":\"C\",\"pid\":0,\"ts\":" << frameStart + counter.timeMs * 1000.0
+                << ",\"args\":{\"value\":" << counter.value << "}}";
+        }
+    }
+    out << "\n]}\n";
+
+    METAGFX_INFO << "Wrote CPU trace of " << s_History.size() << " frames to " << path;
+    return out.good();
+}
+
+} // namespace metagfx
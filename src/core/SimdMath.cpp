@@ -0,0 +1,389 @@
+// ============================================================================
+// src/core/SimdMath.cpp
+// ============================================================================
+#include "metagfx/core/SimdMath.h"
+
+#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+
+#if defined(METAGFX_SIMD_DISABLED)
+// Scalar paths only
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define METAGFX_SIMD_AVX2_PATH 1
+#define METAGFX_SIMD_SSE2_PATH 1
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define METAGFX_SIMD_SSE2_PATH 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define METAGFX_SIMD_NEON_PATH 1
+#endif
+
+namespace metagfx {
+namespace simd {
+
+namespace {
+
+// Append base + the index of every set bit of mask
+inline size_t EmitIndices(uint32 mask, size_t base, uint32* outIndices, size_t written) {
+    while (mask) {
+        outIndices[written++] = static_cast<uint32>(base + std::countr_zero(mask));
+        mask &= mask - 1;
+    }
+    return written;
+}
+
+inline bool SphereVisible(const glm::vec4 planes[6], float x, float y, float z, float r) {
+    for (int p = 0; p < 6; ++p) {
+        if (planes[p].x * x + planes[p].y * y + planes[p].z * z + planes[p].w < -r) {
+            return false;
+        }
+    }
+    return true;
+}
+
+inline bool SphereOverlapsBox(const glm::vec3& c, float radiusSquared, const BoxArrays& boxes, size_t i) {
+    float dx = std::clamp(c.x, boxes.minX[i], boxes.maxX[i]) - c.x;
+    float dy = std::clamp(c.y, boxes.minY[i], boxes.maxY[i]) - c.y;
+    float dz = std::clamp(c.z, boxes.minZ[i], boxes.maxZ[i]) - c.z;
+    return dx * dx + dy * dy + dz * dz <= radiusSquared;
+}
+
+#if defined(METAGFX_SIMD_NEON_PATH)
+inline uint32 MoveMask(uint32x4_t mask) {
+    return (vgetq_lane_u32(mask, 0) & 1u) | (vgetq_lane_u32(mask, 1) & 2u) |
+           (vgetq_lane_u32(mask, 2) & 4u) | (vgetq_lane_u32(mask, 3) & 8u);
+}
+#endif
+
+} // namespace
+
+const char* GetInstructionSet() {
+#if defined(METAGFX_SIMD_AVX2_PATH)
+    return "AVX2";
+#elif defined(METAGFX_SIMD_SSE2_PATH)
+    return "SSE2";
+#elif defined(METAGFX_SIMD_NEON_PATH)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+size_t CullSpheres(const glm::vec4 planes[6], const SphereArrays& spheres, size_t count, uint32* outIndices) {
+    const float* cx = spheres.centerX;
+    const float* cy = spheres.centerY;
+    const float* cz = spheres.centerZ;
+    const float* r = spheres.radius;
+    size_t written = 0;
+    size_t i = 0;
+
+#if defined(METAGFX_SIMD_AVX2_PATH)
+    __m256 px[6], py[6], pz[6], pw[6];
+    for (int p = 0; p < 6; ++p) {
+        px[p] = _mm256_set1_ps(planes[p].x);
+        py[p] = _mm256_set1_ps(planes[p].y);
+        pz[p] = _mm256_set1_ps(planes[p].z);
+        pw[p] = _mm256_set1_ps(planes[p].w);
+    }
+    const __m256 sign = _mm256_set1_ps(-0.0f);
+    for (; i + 8 <= count; i += 8) {
+        __m256 x = _mm256_loadu_ps(cx + i);
+        __m256 y = _mm256_loadu_ps(cy + i);
+        __m256 z = _mm256_loadu_ps(cz + i);
+        __m256 negativeRadius = _mm256_xor_ps(_mm256_loadu_ps(r + i), sign);
+        __m256 visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(px[p], x), _mm256_mul_ps(py[p], y)),
+                                            _mm256_add_ps(_mm256_mul_ps(pz[p], z), pw[p]));
+            visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+        }
+        written = EmitIndices(static_cast<uint32>(_mm256_movemask_ps(visible)), i, outIndices, written);
+    }
+#elif defined(METAGFX_SIMD_SSE2_PATH)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    for (; i + 4 <= count; i += 4) {
+        __m128 x = _mm_loadu_ps(cx + i);
+        __m128 y = _mm_loadu_ps(cy + i);
+        __m128 z = _mm_loadu_ps(cz + i);
+        __m128 negativeRadius = _mm_xor_ps(_mm_loadu_ps(r + i), sign);
+        __m128 visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].x), x),
+                                                    _mm_mul_ps(_mm_set1_ps(planes[p].y), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p].z), z),
+                                                    _mm_set1_ps(planes[p].w)));
+            visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+        }
+        written = EmitIndices(static_cast<uint32>(_mm_movemask_ps(visible)), i, outIndices, written);
+    }
+#elif defined(METAGFX_SIMD_NEON_PATH)
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t x = vld1q_f32(cx + i);
+        float32x4_t y = vld1q_f32(cy + i);
+        float32x4_t z = vld1q_f32(cz + i);
+        float32x4_t negativeRadius = vnegq_f32(vld1q_f32(r + i));
+        uint32x4_t visible = vdupq_n_u32(~0u);
+        for (int p = 0; p < 6; ++p) {
+            float32x4_t distance = vdupq_n_f32(planes[p].w);
+            distance = vmlaq_n_f32(distance, x, planes[p].x);
+            distance = vmlaq_n_f32(distance, y, planes[p].y);
+            distance = vmlaq_n_f32(distance, z, planes[p].z);
+            visible = vandq_u32(visible, vcgeq_f32(distance, negativeRadius));
+        }
+        written = EmitIndices(MoveMask(visible), i, outIndices, written);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (SphereVisible(planes, cx[i], cy[i], cz[i], r[i])) {
+            outIndices[written++] = static_cast<uint32>(i);
+        }
+    }
+    return written;
+}
+
+size_t OverlapSphereBoxes(const glm::vec3& center, float radius, const BoxArrays& boxes, size_t count,
+                          uint32* outIndices) {
+    const float radiusSquared = radius * radius;
+    size_t written = 0;
+    size_t i = 0;
+
+#if defined(METAGFX_SIMD_AVX2_PATH)
+    const __m256 cx = _mm256_set1_ps(center.x);
+    const __m256 cy = _mm256_set1_ps(center.y);
+    const __m256 cz = _mm256_set1_ps(center.z);
+    const __m256 r2 = _mm256_set1_ps(radiusSquared);
+    for (; i + 8 <= count; i += 8) {
+        __m256 dx = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cx, _mm256_loadu_ps(boxes.minX + i)),
+                                                _mm256_loadu_ps(boxes.maxX + i)), cx);
+        __m256 dy = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cy, _mm256_loadu_ps(boxes.minY + i)),
+                                                _mm256_loadu_ps(boxes.maxY + i)), cy);
+        __m256 dz = _mm256_sub_ps(_mm256_min_ps(_mm256_max_ps(cz, _mm256_loadu_ps(boxes.minZ + i)),
+                                                _mm256_loadu_ps(boxes.maxZ + i)), cz);
+        __m256 distance2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)),
+                                         _mm256_mul_ps(dz, dz));
+        uint32 mask = static_cast<uint32>(_mm256_movemask_ps(_mm256_cmp_ps(distance2, r2, _CMP_LE_OQ)));
+        written = EmitIndices(mask, i, outIndices, written);
+    }
+#elif defined(METAGFX_SIMD_SSE2_PATH)
+    const __m128 cx = _mm_set1_ps(center.x);
+    const __m128 cy = _mm_set1_ps(center.y);
+    const __m128 cz = _mm_set1_ps(center.z);
+    const __m128 r2 = _mm_set1_ps(radiusSquared);
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cx, _mm_loadu_ps(boxes.minX + i)), _mm_loadu_ps(boxes.maxX + i)), cx);
+        __m128 dy = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cy, _mm_loadu_ps(boxes.minY + i)), _mm_loadu_ps(boxes.maxY + i)), cy);
+        __m128 dz = _mm_sub_ps(_mm_min_ps(_mm_max_ps(cz, _mm_loadu_ps(boxes.minZ + i)), _mm_loadu_ps(boxes.maxZ + i)), cz);
+        __m128 distance2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        written = EmitIndices(static_cast<uint32>(_mm_movemask_ps(_mm_cmple_ps(distance2, r2))), i, outIndices,
+                              written);
+    }
+#elif defined(METAGFX_SIMD_NEON_PATH)
+    const float32x4_t cx = vdupq_n_f32(center.x);
+    const float32x4_t cy = vdupq_n_f32(center.y);
+    const float32x4_t cz = vdupq_n_f32(center.z);
+    const float32x4_t r2 = vdupq_n_f32(radiusSquared);
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t dx = vsubq_f32(vminq_f32(vmaxq_f32(cx, vld1q_f32(boxes.minX + i)), vld1q_f32(boxes.maxX + i)), cx);
+        float32x4_t dy = vsubq_f32(vminq_f32(vmaxq_f32(cy, vld1q_f32(boxes.minY + i)), vld1q_f32(boxes.maxY + i)), cy);
+        float32x4_t dz = vsubq_f32(vminq_f32(vmaxq_f32(cz, vld1q_f32(boxes.minZ + i)), vld1q_f32(boxes.maxZ + i)), cz);
+        float32x4_t distance2 = vmlaq_f32(vmlaq_f32(vmulq_f32(dz, dz), dy, dy), dx, dx);
+        written = EmitIndices(MoveMask(vcleq_f32(distance2, r2)), i, outIndices, written);
+    }
+#endif
+
+    for (; i < count; ++i) {
+        if (SphereOverlapsBox(center, radiusSquared, boxes, i)) {
+            outIndices[written++] = static_cast<uint32>(i);
+        }
+    }
+    return written;
+}
+
+uint32 IntersectRayBox4(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxT, const Box4& boxes,
+                        float outT[4]) {
+    // One node per call, so the wider AVX2 registers would sit half empty: the AVX2 build
+    // takes the SSE2 path. min/max return their second operand when the first is NaN
+    // (0 * infinity on a slab plane), which keeps the running interval instead.
+#if defined(METAGFX_SIMD_SSE2_PATH)
+    const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+    const __m128 ix = _mm_set1_ps(inverseDirection.x), iy = _mm_set1_ps(inverseDirection.y),
+                 iz = _mm_set1_ps(inverseDirection.z);
+    __m128 x0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minX), ox), ix);
+    __m128 x1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxX), ox), ix);
+    __m128 y0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minY), oy), iy);
+    __m128 y1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxY), oy), iy);
+    __m128 z0 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.minZ), oz), iz);
+    __m128 z1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(boxes.maxZ), oz), iz);
+    __m128 tNear = _mm_max_ps(_mm_min_ps(x0, x1), _mm_setzero_ps());
+    __m128 tFar = _mm_min_ps(_mm_max_ps(x0, x1), _mm_set1_ps(maxT));
+    tNear = _mm_max_ps(_mm_min_ps(y0, y1), tNear);
+    tFar = _mm_min_ps(_mm_max_ps(y0, y1), tFar);
+    tNear = _mm_max_ps(_mm_min_ps(z0, z1), tNear);
+    tFar = _mm_min_ps(_mm_max_ps(z0, z1), tFar);
+    _mm_storeu_ps(outT, tNear);
+    return static_cast<uint32>(_mm_movemask_ps(_mm_cmple_ps(tNear, tFar)));
+#elif defined(METAGFX_SIMD_NEON_PATH)
+    const float32x4_t ox = vdupq_n_f32(origin.x), oy = vdupq_n_f32(origin.y), oz = vdupq_n_f32(origin.z);
+    float32x4_t x0 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.minX), ox), inverseDirection.x);
+    float32x4_t x1 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.maxX), ox), inverseDirection.x);
+    float32x4_t y0 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.minY), oy), inverseDirection.y);
+    float32x4_t y1 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.maxY), oy), inverseDirection.y);
+    float32x4_t z0 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.minZ), oz), inverseDirection.z);
+    float32x4_t z1 = vmulq_n_f32(vsubq_f32(vld1q_f32(boxes.maxZ), oz), inverseDirection.z);
+    // vminnmq/vmaxnmq drop a NaN operand like the SSE2 ordering above
+    float32x4_t tNear = vmaxnmq_f32(vminnmq_f32(x0, x1), vdupq_n_f32(0.0f));
+    float32x4_t tFar = vminnmq_f32(vmaxnmq_f32(x0, x1), vdupq_n_f32(maxT));
+    tNear = vmaxnmq_f32(vminnmq_f32(y0, y1), tNear);
+    tFar = vminnmq_f32(vmaxnmq_f32(y0, y1), tFar);
+    tNear = vmaxnmq_f32(vminnmq_f32(z0, z1), tNear);
+    tFar = vminnmq_f32(vmaxnmq_f32(z0, z1), tFar);
+    vst1q_f32(outT, tNear);
+    return MoveMask(vcleq_f32(tNear, tFar));
+#else
+    uint32 mask = 0;
+    const float* mins[3] = { boxes.minX, boxes.minY, boxes.minZ };
+    const float* maxs[3] = { boxes.maxX, boxes.maxY, boxes.maxZ };
+    for (int i = 0; i < 4; ++i) {
+        float tNear = 0.0f;
+        float tFar = maxT;
+        for (int axis = 0; axis < 3; ++axis) {
+            float t0 = (mins[axis][i] - origin[axis]) * inverseDirection[axis];
+            float t1 = (maxs[axis][i] - origin[axis]) * inverseDirection[axis];
+            // Comparisons with NaN fail, which keeps the running interval as above
+            float lo = t0 < t1 ? t0 : t1;
+            float hi = t0 < t1 ? t1 : t0;
+            tNear = lo > tNear ? lo : tNear;
+            tFar = hi < tFar ? hi : tFar;
+        }
+        outT[i] = tNear;
+        mask |= tNear <= tFar ? 1u << i : 0u;
+    }
+    return mask;
+#endif
+}
+
+void TransformBox(const glm::mat4& matrix, const glm::vec3& boxMin, const glm::vec3& boxMax,
+                  glm::vec3& outMin, glm::vec3& outMax) {
+    glm::vec3 center = (boxMin + boxMax) * 0.5f;
+    glm::vec3 halfExtent = (boxMax - boxMin) * 0.5f;
+
+#if defined(METAGFX_SIMD_SSE2_PATH) || defined(METAGFX_SIMD_NEON_PATH)
+    // One matrix column per register: the fourth lane of each result is ignored
+    const float* m = glm::value_ptr(matrix);
+    float lo[4], hi[4];
+#if defined(METAGFX_SIMD_SSE2_PATH)
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8), c3 = _mm_loadu_ps(m + 12);
+    __m128 newCenter = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(center.x)), _mm_mul_ps(c1, _mm_set1_ps(center.y))),
+                                  _mm_add_ps(_mm_mul_ps(c2, _mm_set1_ps(center.z)), c3));
+    __m128 newHalf = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign, c0), _mm_set1_ps(halfExtent.x)),
+                                           _mm_mul_ps(_mm_andnot_ps(sign, c1), _mm_set1_ps(halfExtent.y))),
+                                _mm_mul_ps(_mm_andnot_ps(sign, c2), _mm_set1_ps(halfExtent.z)));
+    _mm_storeu_ps(lo, _mm_sub_ps(newCenter, newHalf));
+    _mm_storeu_ps(hi, _mm_add_ps(newCenter, newHalf));
+#else
+    float32x4_t c0 = vld1q_f32(m), c1 = vld1q_f32(m + 4), c2 = vld1q_f32(m + 8), c3 = vld1q_f32(m + 12);
+    float32x4_t newCenter = vmlaq_n_f32(vmlaq_n_f32(vmlaq_n_f32(c3, c0, center.x), c1, center.y), c2, center.z);
+    float32x4_t newHalf = vmulq_n_f32(vabsq_f32(c0), halfExtent.x);
+    newHalf = vmlaq_n_f32(newHalf, vabsq_f32(c1), halfExtent.y);
+    newHalf = vmlaq_n_f32(newHalf, vabsq_f32(c2), halfExtent.z);
+    vst1q_f32(lo, vsubq_f32(newCenter, newHalf));
+    vst1q_f32(hi, vaddq_f32(newCenter, newHalf));
+#endif
+    outMin = glm::vec3(lo[0], lo[1], lo[2]);
+    outMax = glm::vec3(hi[0], hi[1], hi[2]);
+#else
+    glm::vec3 newCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+    glm::vec3 newHalfExtent(0.0f);
+    for (int column = 0; column < 3; ++column) {
+        for (int row = 0; row < 3; ++row) {
+            newHalfExtent[row] += std::abs(matrix[column][row]) * halfExtent[column];
+        }
+    }
+    outMin = newCenter - newHalfExtent;
+    outMax = newCenter + newHalfExtent;
+#endif
+}
+
+void TransformBoxes(const glm::mat4* matrices, const glm::vec3* boxMins, const glm::vec3* boxMaxs, size_t count,
+                    glm::vec3* outMins, glm::vec3* outMaxs) {
+    for (size_t i = 0; i < count; ++i) {
+        TransformBox(matrices[i], boxMins[i], boxMaxs[i], outMins[i], outMaxs[i]);
+    }
+}
+
+void ComputeBounds(const glm::vec3* points, size_t count, size_t stride, glm::vec3& outMin, glm::vec3& outMax) {
+    if (count == 0) {
+        return;
+    }
+    const uint8* bytes = reinterpret_cast<const uint8*>(points);
+
+#if defined(METAGFX_SIMD_SSE2_PATH) || defined(METAGFX_SIMD_NEON_PATH)
+    // xyz in the low three lanes, loaded without reading past the point; two
+    // accumulator pairs hide the min/max latency
+    auto load = [&](size_t i) {
+        const float* p = reinterpret_cast<const float*>(bytes + i * stride);
+#if defined(METAGFX_SIMD_SSE2_PATH)
+        return _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(p))), _mm_load_ss(p + 2));
+#else
+        return vcombine_f32(vld1_f32(p), vset_lane_f32(p[2], vdup_n_f32(0.0f), 0));
+#endif
+    };
+    auto lo0 = load(0), hi0 = lo0, lo1 = lo0, hi1 = lo0;
+    size_t i = 1;
+#if defined(METAGFX_SIMD_SSE2_PATH)
+    for (; i + 2 <= count; i += 2) {
+        auto a = load(i), b = load(i + 1);
+        lo0 = _mm_min_ps(lo0, a);
+        hi0 = _mm_max_ps(hi0, a);
+        lo1 = _mm_min_ps(lo1, b);
+        hi1 = _mm_max_ps(hi1, b);
+    }
+    for (; i < count; ++i) {
+        auto a = load(i);
+        lo0 = _mm_min_ps(lo0, a);
+        hi0 = _mm_max_ps(hi0, a);
+    }
+    float lo[4], hi[4];
+    _mm_storeu_ps(lo, _mm_min_ps(lo0, lo1));
+    _mm_storeu_ps(hi, _mm_max_ps(hi0, hi1));
+#else
+    for (; i + 2 <= count; i += 2) {
+        auto a = load(i), b = load(i + 1);
+        lo0 = vminq_f32(lo0, a);
+        hi0 = vmaxq_f32(hi0, a);
+        lo1 = vminq_f32(lo1, b);
+        hi1 = vmaxq_f32(hi1, b);
+    }
+    for (; i < count; ++i) {
+        auto a = load(i);
+        lo0 = vminq_f32(lo0, a);
+        hi0 = vmaxq_f32(hi0, a);
+    }
+    float lo[4], hi[4];
+    vst1q_f32(lo, vminq_f32(lo0, lo1));
+    vst1q_f32(hi, vmaxq_f32(hi0, hi1));
+#endif
+    outMin = glm::vec3(lo[0], lo[1], lo[2]);
+    outMax = glm::vec3(hi[0], hi[1], hi[2]);
+#else
+    glm::vec3 lo = points[0];
+    glm::vec3 hi = lo;
+    for (size_t i = 1; i < count; ++i) {
+        const glm::vec3& p = *reinterpret_cast<const glm::vec3*>(bytes + i * stride);
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+    outMin = lo;
+    outMax = hi;
+#endif
+}
+
+} // namespace simd
+} // namespace metagfx
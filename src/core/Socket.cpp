@@ -0,0 +1,294 @@
+// ============================================================================
+// src/core/Socket.cpp
+// ============================================================================
+#include "metagfx/core/Socket.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <string>
+
+#if defined(_WIN32)
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #include <winsock2.h>
+    #include <ws2tcpip.h>
+#else
+    #include <arpa/inet.h>
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <netdb.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+    #include <sys/socket.h>
+    #include <unistd.h>
+#endif
+
+namespace metagfx {
+
+namespace {
+
+#if defined(_WIN32)
+using NativeSocket = SOCKET;
+
+bool InitializeSockets() {
+    // Once per process; WSACleanup at exit is left to the system
+    static bool initialized = []() {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return initialized;
+}
+
+bool IsValidNative(NativeSocket socket) {
+    return socket != INVALID_SOCKET;
+}
+
+bool WouldBlock() {
+    return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+void CloseNative(NativeSocket socket) {
+    closesocket(socket);
+}
+
+void ShutdownNative(NativeSocket socket) {
+    shutdown(socket, SD_BOTH);
+}
+#else
+using NativeSocket = int;
+
+bool InitializeSockets() {
+    return true;
+}
+
+bool IsValidNative(NativeSocket socket) {
+    return socket >= 0;
+}
+
+bool WouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK;
+}
+
+void CloseNative(NativeSocket socket) {
+    close(socket);
+}
+
+void ShutdownNative(NativeSocket socket) {
+    shutdown(socket, SHUT_RDWR);
+}
+#endif
+
+// Until socket can take more bytes, or timeoutMs passes
+void WaitWritable(NativeSocket socket, int32 timeoutMs) {
+    fd_set writable;
+    FD_ZERO(&writable);
+    FD_SET(socket, &writable);
+    timeval timeout{};
+    timeout.tv_sec = timeoutMs / 1000;
+    timeout.tv_usec = (timeoutMs % 1000) * 1000;
+    select(static_cast<int>(socket) + 1, nullptr, &writable, nullptr, &timeout);
+}
+
+// Sends to a closed peer fail instead of raising SIGPIPE: MSG_NOSIGNAL per send where
+// it exists, SO_NOSIGPIPE per socket on macOS
+#if defined(MSG_NOSIGNAL)
+constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = 0;
+#endif
+
+void DisableSigPipe([[maybe_unused]] NativeSocket socket) {
+#if defined(SO_NOSIGPIPE)
+    int value = 1;
+    setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, &value, sizeof(value));
+#endif
+}
+
+// Largest single send()/recv(), whose length is an int on Windows
+constexpr uint64 MAX_TRANSFER = 1u << 30;
+
+} // namespace
+
+Socket::~Socket() {
+    Close();
+}
+
+Socket::Socket(Socket&& other) noexcept
+    : m_Handle(other.m_Handle) {
+    other.m_Handle = INVALID_HANDLE;
+}
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        Close();
+        m_Handle = other.m_Handle;
+        other.m_Handle = INVALID_HANDLE;
+    }
+    return *this;
+}
+
+Socket Socket::Listen(uint16 port) {
+    if (!InitializeSockets()) {
+        METAGFX_ERROR << "Socket: failed to initialize sockets";
+        return Socket();
+    }
+
+    NativeSocket native = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (!IsValidNative(native)) {
+        METAGFX_ERROR << "Socket: failed to create a socket";
+        return Socket();
+    }
+    Socket socket(static_cast<Handle>(native));
+
+    // A restarted server can take its port back while the last connection times out
+    int reuse = 1;
+    setsockopt(native, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(native, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+        listen(native, 1) != 0) {
+        METAGFX_ERROR << "Socket: failed to listen on port " << port;
+        return Socket();
+    }
+    if (!socket.SetNonBlocking(true)) {
+        METAGFX_ERROR << "Socket: failed to make the listening socket non-blocking";
+        return Socket();
+    }
+    return socket;
+}
+
+Socket Socket::Connect(const char* host, uint16 port) {
+    if (!InitializeSockets()) {
+        METAGFX_ERROR << "Socket: failed to initialize sockets";
+        return Socket();
+    }
+
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    addrinfo* addresses = nullptr;
+    std::string service = std::to_string(port);
+    if (getaddrinfo(host, service.c_str(), &hints, &addresses) != 0 || !addresses) {
+        METAGFX_ERROR << "Socket: failed to resolve " << host;
+        return Socket();
+    }
+
+    // The first address that accepts the connection
+    Socket socket;
+    for (addrinfo* address = addresses; address && !socket.IsValid(); address = address->ai_next) {
+        NativeSocket native = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+        if (!IsValidNative(native)) {
+            continue;
+        }
+        if (connect(native, address->ai_addr, static_cast<int>(address->ai_addrlen)) != 0) {
+            CloseNative(native);
+            continue;
+        }
+        DisableSigPipe(native);
+        socket.m_Handle = static_cast<Handle>(native);
+    }
+    freeaddrinfo(addresses);
+
+    if (!socket.IsValid()) {
+        METAGFX_ERROR << "Socket: failed to connect to " << host << ":" << port;
+    }
+    return socket;
+}
+
+Socket Socket::Accept() {
+    if (!IsValid()) {
+        return Socket();
+    }
+    NativeSocket native = accept(static_cast<NativeSocket>(m_Handle), nullptr, nullptr);
+    if (!IsValidNative(native)) {
+        return Socket();
+    }
+    DisableSigPipe(native);
+    Socket client(static_cast<Handle>(native));
+    // Accepted sockets inherit non-blocking mode on some systems but not others
+    client.SetNonBlocking(false);
+    return client;
+}
+
+bool Socket::SetNonBlocking(bool nonBlocking) {
+    if (!IsValid()) {
+        return false;
+    }
+#if defined(_WIN32)
+    u_long mode = nonBlocking ? 1 : 0;
+    return ioctlsocket(static_cast<NativeSocket>(m_Handle), FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(static_cast<NativeSocket>(m_Handle), F_GETFL, 0);
+    if (flags < 0) {
+        return false;
+    }
+    flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(static_cast<NativeSocket>(m_Handle), F_SETFL, flags) == 0;
+#endif
+}
+
+bool Socket::SetNoDelay(bool noDelay) {
+    if (!IsValid()) {
+        return false;
+    }
+    int value = noDelay ? 1 : 0;
+    return setsockopt(static_cast<NativeSocket>(m_Handle), IPPROTO_TCP, TCP_NODELAY,
+                      reinterpret_cast<const char*>(&value), sizeof(value)) == 0;
+}
+
+bool Socket::SendAll(const void* data, uint64 size) {
+    if (!IsValid()) {
+        return false;
+    }
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        auto sent = send(static_cast<NativeSocket>(m_Handle), bytes,
+                         static_cast<int>(std::min(size, MAX_TRANSFER)), SEND_FLAGS);
+        if (sent < 0 && WouldBlock()) {
+            // A non-blocking socket's send buffer is full: wait for the peer to drain it
+            WaitWritable(static_cast<NativeSocket>(m_Handle), 100);
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        bytes += sent;
+        size -= static_cast<uint64>(sent);
+    }
+    return true;
+}
+
+int64 Socket::Receive(void* data, uint64 size) {
+    if (!IsValid()) {
+        return -1;
+    }
+    auto received = recv(static_cast<NativeSocket>(m_Handle), static_cast<char*>(data),
+                         static_cast<int>(std::min(size, MAX_TRANSFER)), 0);
+    if (received > 0) {
+        return static_cast<int64>(received);
+    }
+    if (received < 0 && WouldBlock()) {
+        return 0;
+    }
+    return -1;
+}
+
+void Socket::Shutdown() {
+    if (IsValid()) {
+        ShutdownNative(static_cast<NativeSocket>(m_Handle));
+    }
+}
+
+void Socket::Close() {
+    if (IsValid()) {
+        CloseNative(static_cast<NativeSocket>(m_Handle));
+        m_Handle = INVALID_HANDLE;
+    }
+}
+
+} // namespace metagfx
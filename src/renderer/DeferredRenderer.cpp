@@ -0,0 +1,228 @@
+// ============================================================================
+// src/renderer/DeferredRenderer.cpp
+// ============================================================================
+#include "metagfx/renderer/DeferredRenderer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/AmbientOcclusion.h"
+#include "metagfx/scene/Camera.h"
+#include "metagfx/scene/DeferredLighting.h"
+#include "metagfx/scene/GPUCuller.h"
+#include "metagfx/scene/ScreenSpaceReflections.h"
+#include "metagfx/scene/TemporalAA.h"
+#include "metagfx/scene/WeightedBlendedOIT.h"
+
+namespace metagfx {
+
+DeferredRenderer::DeferredRenderer(Ref<rhi::GraphicsDevice> device)
+    : RasterizationRenderer(device) {
+}
+
+bool DeferredRenderer::SupportsFeature(RenderFeature feature) const {
+    switch (feature) {
+        case RenderFeature::ShadowDebugViews:
+            return false;  // The lighting pass shades, not the materials' fragment shader
+        case RenderFeature::AmbientOcclusion:
+            return true;   // From the G-buffer pass's depth, before the lighting pass
+        case RenderFeature::Reflections:
+            return true;   // Screen space, through the depth pyramid of the G-buffer pass's depth
+        case RenderFeature::VariableRateShading:
+            return false;  // The lighting pass shades in compute, out of a shading rate's reach
+        case RenderFeature::RayTracedShadows:
+            return false;  // The lighting pass samples the shadow maps
+        default:
+            return RasterizationRenderer::SupportsFeature(feature);
+    }
+}
+
+// =============================================================================
+// G-buffer, lighting and composite passes in place of the forward main pass
+// =============================================================================
+void DeferredRenderer::RenderMainPass(Scene& scene, Camera& camera) {
+    using namespace rhi;
+
+    // The lit color is linear: it needs the tone mapping pass after it
+    if (!m_Frame.deferredLighting || !m_Frame.deferredLighting->IsValid() || !m_ToneMapped) {
+        RasterizationRenderer::RenderMainPass(scene, camera);
+        return;
+    }
+
+    // The prepass pipelines render to the back buffer's format, not the G-buffer's, and
+    // the G-buffer's fragments are cheap enough not to need one
+    m_Frame.depthPrepass = false;
+    ModelPassPlan plan = PlanModelPass(camera);
+
+    TextureDesc gbufferDesc{};
+    gbufferDesc.width = m_RenderWidth;
+    gbufferDesc.height = m_RenderHeight;
+    gbufferDesc.format = DeferredLighting::GBUFFER_FORMAT;
+    gbufferDesc.debugName = "GBuffer";
+    RenderGraphResource gbuffer = m_RenderGraph->CreateTexture("G-buffer", gbufferDesc);
+
+    TextureDesc litColorDesc = gbufferDesc;
+    litColorDesc.format = DeferredLighting::LIT_COLOR_FORMAT;
+    litColorDesc.debugName = "LitColor";
+    RenderGraphResource litColor = m_RenderGraph->CreateTexture("Lit color", litColorDesc);
+
+    // The composite writes the G-buffer pass's depth again, for the scenery's depth test;
+    // with the scenery in it, it is the scene depth temporal AA reprojects
+    TextureDesc compositeDepthDesc = gbufferDesc;
+    compositeDepthDesc.format = m_Device->GetDeviceInfo().depthFormat;
+    compositeDepthDesc.debugName = "CompositeDepth";
+    RenderGraphResource compositeDepth = m_RenderGraph->CreateTexture("Composite depth", compositeDepthDesc);
+    m_Resources.sceneDepth = compositeDepth;
+
+    RenderGBufferPass(plan, gbuffer);
+
+    // Screen-space occlusion of the ambient light, from the G-buffer pass's depth; it
+    // accumulates over frames when temporal AA jitters them
+    bool temporal = m_Frame.temporalAA && m_Frame.temporalAA->IsValid() && m_Frame.motionVectorDescriptorSet;
+    glm::mat4 projection = camera.GetProjectionMatrix();
+    glm::mat4 reprojection = (m_HasPreviousFrame ? m_PreviousView : camera.GetViewMatrix()) *
+                             glm::inverse(camera.GetViewMatrix());
+    RenderGraphResource ambientOcclusion;
+    if (m_Frame.ambientOcclusion && m_Frame.ambientOcclusion->IsValid()) {
+        TextureDesc occlusionDesc = gbufferDesc;
+        occlusionDesc.format = AmbientOcclusion::OUTPUT_FORMAT;
+        occlusionDesc.debugName = "AmbientOcclusion";
+        ambientOcclusion = m_RenderGraph->CreateTexture("Ambient occlusion", occlusionDesc);
+
+        m_RenderGraph->AddPass("Ambient occlusion", [this, ambientOcclusion](RenderGraph::PassBuilder& pass) {
+            pass.Read(m_Resources.depth, ResourceState::ShaderRead);
+            pass.Write(ambientOcclusion, ResourceState::StorageWrite);
+        }, [this, ambientOcclusion, projection, reprojection, temporal](CommandBuffer& passCmd) {
+            m_Frame.ambientOcclusion->SetSources(m_RenderGraph->GetTexture(m_Resources.depth),
+                                                 m_RenderGraph->GetTexture(ambientOcclusion));
+            m_Frame.ambientOcclusion->Apply(passCmd, m_Frame.frameIndex, projection, reprojection, temporal,
+                                            m_RegionWidth, m_RegionHeight);
+        });
+    }
+
+    // Screen-space reflections, traced through the pyramid of the G-buffer pass's depth,
+    // which the next frame's occlusion test then reads too. They read the last frame's
+    // lit color, which the capture after the lighting pass keeps.
+    RenderGraphResource reflections;
+    if (m_Frame.reflections && m_Frame.reflections->IsValid() && m_Frame.gpuCuller) {
+        RenderDepthPyramidPass();
+        m_Frame.reflections->Resize(m_RenderWidth, m_RenderHeight);
+        if (m_Resources.depthPyramid.IsValid() && m_Frame.reflections->GetColorHistory()) {
+            m_Resources.reflectionColor = m_RenderGraph->ImportTexture("Reflection color",
+                                                                       m_Frame.reflections->GetColorHistory(),
+                                                                       ResourceState::StorageWrite,
+                                                                       ResourceState::StorageWrite);
+            m_RenderGraph->MarkOutput(m_Resources.reflectionColor);
+
+            TextureDesc reflectionDesc = gbufferDesc;
+            reflectionDesc.format = ScreenSpaceReflections::OUTPUT_FORMAT;
+            reflectionDesc.debugName = "Reflections";
+            reflections = m_RenderGraph->CreateTexture("Reflections", reflectionDesc);
+        }
+    }
+    if (reflections.IsValid()) {
+        m_RenderGraph->AddPass("Reflections", [this, gbuffer, reflections](RenderGraph::PassBuilder& pass) {
+            pass.Read(m_Resources.depth, ResourceState::ShaderRead);
+            pass.Read(gbuffer, ResourceState::ShaderRead);
+            pass.Read(m_Resources.depthPyramid, ResourceState::ShaderRead);
+            pass.Read(m_Resources.reflectionColor, ResourceState::ShaderRead);
+            pass.Write(reflections, ResourceState::StorageWrite);
+        }, [this, gbuffer, litColor, reflections, view = camera.GetViewMatrix(), projection, reprojection,
+            temporal](CommandBuffer& passCmd) {
+            m_Frame.reflections->SetSources(m_RenderGraph->GetTexture(m_Resources.depth),
+                                            m_RenderGraph->GetTexture(gbuffer),
+                                            m_Frame.gpuCuller->GetDepthPyramidBuffer(),
+                                            m_RenderGraph->GetTexture(litColor),
+                                            m_RenderGraph->GetTexture(reflections));
+            m_Frame.reflections->Trace(passCmd, m_Frame.frameIndex, view, projection, reprojection,
+                                       m_Frame.gpuCuller->GetMinDepthOffset(), temporal,
+                                       m_RegionWidth, m_RegionHeight);
+        });
+    }
+
+    m_RenderGraph->AddPass("Deferred lighting", [this, gbuffer, litColor, ambientOcclusion, reflections](RenderGraph::PassBuilder& pass) {
+        pass.Read(gbuffer, ResourceState::ShaderRead);
+        pass.Read(m_Resources.depth, ResourceState::ShaderRead);
+        pass.Read(ambientOcclusion, ResourceState::ShaderRead);
+        pass.Read(reflections, ResourceState::ShaderRead);
+        pass.Read(m_Resources.shadowMap, ResourceState::ShaderRead);
+        pass.Read(m_Resources.shadowAtlas, ResourceState::ShaderRead);
+        if (m_Frame.sampleShadowMoments) {
+            pass.Read(m_Resources.shadowMoments, ResourceState::ShaderRead);
+        }
+        pass.Read(m_Resources.lightProbes, ResourceState::ShaderRead);
+        pass.Write(litColor, ResourceState::StorageWrite);
+    }, [this, gbuffer, litColor, ambientOcclusion, reflections](CommandBuffer& passCmd) {
+        m_Frame.deferredLighting->SetTargets(m_RenderGraph->GetTexture(gbuffer),
+                                             m_RenderGraph->GetTexture(m_Resources.depth),
+                                             m_RenderGraph->GetTexture(litColor),
+                                             ambientOcclusion.IsValid() ? m_RenderGraph->GetTexture(ambientOcclusion)
+                                                                        : nullptr,
+                                             reflections.IsValid() ? m_RenderGraph->GetTexture(reflections) : nullptr);
+        m_Frame.deferredLighting->Light(passCmd, m_Frame.frameIndex, m_Frame.frameUniformOffset,
+                                        m_RegionWidth, m_RegionHeight);
+    });
+
+    if (reflections.IsValid()) {
+        m_RenderGraph->AddPass("Reflection capture", [this, litColor](RenderGraph::PassBuilder& pass) {
+            pass.Read(litColor, ResourceState::ShaderRead);
+            pass.Write(m_Resources.reflectionColor, ResourceState::StorageWrite);
+        }, [this](CommandBuffer& passCmd) {
+            m_Frame.reflections->CaptureColor(passCmd, m_Frame.frameIndex);
+        });
+    }
+
+    // The blended materials are shaded forward over the composite, sorted here or in the
+    // weighted blended passes after it
+    bool sortedTransparency = plan.transparency == TransparencyMode::Sorted && plan.transparentCount > 0;
+    m_RenderGraph->AddPass("Main pass", [this, litColor, compositeDepth, sortedTransparency](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.sceneColor, ResourceState::ColorAttachment);
+        pass.Write(compositeDepth, ResourceState::DepthAttachment);
+        pass.Read(litColor, ResourceState::ShaderRead);
+        pass.Read(m_Resources.depth, ResourceState::ShaderRead);
+        if (sortedTransparency) {
+            pass.Read(m_Resources.shadowMap, ResourceState::ShaderRead);
+            pass.Read(m_Resources.shadowAtlas, ResourceState::ShaderRead);
+            if (m_Frame.sampleShadowMoments) {
+                pass.Read(m_Resources.shadowMoments, ResourceState::ShaderRead);
+            }
+            pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+            pass.Read(m_Resources.lightProbes, ResourceState::ShaderRead);
+        }
+    }, [this, compositeDepth, sortedTransparency](CommandBuffer& passCmd) {
+        ClearValue depthClear{};
+        depthClear.depthStencil.depth = Camera::FAR_DEPTH;
+        depthClear.depthStencil.stencil = 0;
+
+        // The overlay follows in the tone mapping pass
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(m_Resources.sceneColor) };
+        const ClearValue clearValues[] = { GetBackgroundClear(), depthClear };
+        RenderPassActions actions;
+        actions.depthStore = m_RenderGraph->GetStoreOp(compositeDepth);
+        passCmd.BeginRendering(colorAttachments, m_RenderGraph->GetTexture(compositeDepth), clearValues, actions);
+        SetFullViewport(passCmd);
+        m_Frame.deferredLighting->Composite(passCmd, m_Frame.frameIndex);
+        if (m_Frame.content) {
+            m_Frame.content->RecordSceneryDraws(passCmd);
+            if (sortedTransparency) {
+                m_Frame.content->RecordTransparentDraws(passCmd, m_MainDrawList, TransparentTarget::SceneColor);
+            }
+        }
+        passCmd.EndRendering();
+    });
+
+    RenderTransparencyPasses(plan, compositeDepth);
+}
+
+void DeferredRenderer::RenderGBufferPass(const ModelPassPlan& plan, RenderGraphResource gbuffer) {
+    using namespace rhi;
+
+    m_RenderGraph->AddPass("G-buffer pass", [this, gbuffer](RenderGraph::PassBuilder& pass) {
+        pass.Write(gbuffer, ResourceState::ColorAttachment);
+        pass.Write(m_Resources.depth, ResourceState::DepthAttachment);
+        pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+    }, [this, plan, gbuffer](CommandBuffer& passCmd) {
+        RecordModelPass(passCmd, plan, m_RenderGraph->GetTexture(gbuffer), m_RenderGraph->GetTexture(m_Resources.depth),
+                        ClearValue{}, false);
+    });
+}
+
+} // namespace metagfx
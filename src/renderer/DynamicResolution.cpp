@@ -0,0 +1,50 @@
+// ============================================================================
+// src/renderer/DynamicResolution.cpp
+// ============================================================================
+#include "metagfx/renderer/DynamicResolution.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metagfx {
+
+void DynamicResolution::Update(float gpuMs) {
+    if (!(gpuMs > 0.0f)) {
+        return;
+    }
+    m_SmoothedMs = m_SmoothedMs > 0.0f ? m_SmoothedMs * 0.8f + gpuMs * 0.2f : gpuMs;
+    if (m_HoldFrames > 0) {
+        --m_HoldFrames;
+        return;
+    }
+
+    float upper = std::max(m_Settings.targetMs, 0.1f);
+    float lower = upper * std::clamp(m_Settings.headroom, 0.1f, 1.0f);
+    if (m_SmoothedMs >= lower && m_SmoothedMs <= upper) {
+        return;
+    }
+
+    // Aim at the middle of the band; the time goes with the square of the scale
+    float wanted = m_Scale * std::sqrt(0.5f * (lower + upper) / m_SmoothedMs);
+    float minScale = std::clamp(m_Settings.minScale, 0.1f, 1.0f);
+    float scale = std::clamp(wanted, m_Scale - m_Settings.maxStep, m_Scale + m_Settings.maxStep);
+    scale = std::clamp(scale, minScale, std::clamp(m_Settings.maxScale, minScale, 1.0f));
+    if (scale != m_Scale) {
+        m_Scale = scale;
+        m_HoldFrames = m_Settings.settleFrames;
+    }
+}
+
+void DynamicResolution::Reset() {
+    m_Scale = std::clamp(m_Settings.maxScale, 0.1f, 1.0f);
+    m_SmoothedMs = 0.0f;
+    m_HoldFrames = 0;
+}
+
+glm::uvec2 DynamicResolution::ScaleSize(uint32 width, uint32 height, float scale) {
+    scale = std::clamp(scale, 0.0f, 1.0f);
+    return glm::uvec2(std::max(static_cast<uint32>(std::lround(width * scale)), 1u),
+                      std::max(static_cast<uint32>(std::lround(height * scale)), 1u));
+}
+
+} // namespace metagfx
@@ -0,0 +1,103 @@
+// ============================================================================
+// src/renderer/PathTracingRenderer.cpp
+// ============================================================================
+#include "metagfx/renderer/PathTracingRenderer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/Denoiser.h"
+#include "metagfx/scene/PathTracer.h"
+
+namespace metagfx {
+
+PathTracingRenderer::PathTracingRenderer(Ref<rhi::GraphicsDevice> device)
+    : RasterizationRenderer(device) {
+}
+
+bool PathTracingRenderer::SupportsFeature(RenderFeature feature) const {
+    switch (feature) {
+        case RenderFeature::GlobalIllumination:
+            return true;   // The paths bounce between surfaces
+        case RenderFeature::ShadowDebugViews:
+        case RenderFeature::AmbientOcclusion:
+        case RenderFeature::VariableRateShading:
+        case RenderFeature::RayTracedShadows:
+            return false;  // The tracer shades every pixel itself, with its own shadow rays
+        default:
+            return RasterizationRenderer::SupportsFeature(feature);
+    }
+}
+
+// =============================================================================
+// Path tracing and composite passes in place of the forward main pass
+// =============================================================================
+void PathTracingRenderer::RenderMainPass(Scene& scene, Camera& camera) {
+    using namespace rhi;
+
+    // The accumulation is linear: it needs the tone mapping pass after it
+    PathTracer* tracer = m_Frame.pathTracer;
+    if (!tracer || !tracer->IsReady() || !m_ToneMapped) {
+        RasterizationRenderer::RenderMainPass(scene, camera);
+        return;
+    }
+
+    tracer->Resize(m_RenderWidth, m_RenderHeight);
+    if (!tracer->GetAccumulation()) {
+        RasterizationRenderer::RenderMainPass(scene, camera);
+        return;
+    }
+
+    // Kept across frames: each adds samples to the last one's
+    RenderGraphResource accumulation =
+        m_RenderGraph->ImportTexture("Path trace accumulation", tracer->GetAccumulation(), ResourceState::StorageWrite,
+                                     ResourceState::StorageWrite);
+    m_RenderGraph->MarkOutput(accumulation);
+
+    RenderGraphResource guide = m_RenderGraph->ImportTexture("Path trace guide", tracer->GetGuide(),
+                                                             ResourceState::StorageWrite, ResourceState::StorageWrite);
+    RenderGraphResource albedo = m_RenderGraph->ImportTexture("Path trace albedo", tracer->GetAlbedo(),
+                                                              ResourceState::StorageWrite, ResourceState::StorageWrite);
+    m_RenderGraph->MarkOutput(guide);
+    m_RenderGraph->MarkOutput(albedo);
+
+    Scene* tracedScene = &scene;
+    m_RenderGraph->AddPass("Path tracing", [accumulation, guide, albedo](RenderGraph::PassBuilder& pass) {
+        pass.Write(accumulation, ResourceState::StorageWrite);
+        pass.Write(guide, ResourceState::StorageWrite);
+        pass.Write(albedo, ResourceState::StorageWrite);
+    }, [this, tracer, tracedScene](CommandBuffer& passCmd) {
+        tracer->Trace(passCmd, m_Frame.frameIndex, m_Frame.frameUniformOffset, m_Frame.pathTraceView, *tracedScene);
+    });
+
+    // The denoiser writes every pixel of the scene color itself; it reads the sample count
+    // once the frame's tiles are recorded, after any reset
+    Denoiser* denoiser = m_Frame.denoiser;
+    if (denoiser && denoiser->IsValid()) {
+        m_RenderGraph->AddPass("Denoise", [this, accumulation, guide, albedo](RenderGraph::PassBuilder& pass) {
+            pass.Read(accumulation, ResourceState::ShaderRead);
+            pass.Read(guide, ResourceState::ShaderRead);
+            pass.Read(albedo, ResourceState::ShaderRead);
+            pass.Write(m_Resources.sceneColor, ResourceState::StorageWrite);
+        }, [this, tracer, denoiser](CommandBuffer& passCmd) {
+            denoiser->SetSources(tracer->GetAccumulation(), tracer->GetGuide(), tracer->GetAlbedo(),
+                                 m_RenderGraph->GetTexture(m_Resources.sceneColor));
+            denoiser->Apply(passCmd, m_Frame.frameIndex, m_Frame.pathTraceView.viewProjection,
+                            tracer->GetSampleCount());
+        });
+        return;
+    }
+
+    m_RenderGraph->AddPass("Main pass", [this, accumulation](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.sceneColor, ResourceState::ColorAttachment);
+        pass.Read(accumulation, ResourceState::ShaderRead);
+    }, [this, tracer](CommandBuffer& passCmd) {
+        // The overlay follows in the tone mapping pass
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(m_Resources.sceneColor) };
+        const ClearValue clearValues[] = { GetBackgroundClear() };
+        passCmd.BeginRendering(colorAttachments, nullptr, clearValues);
+        SetFullViewport(passCmd);
+        tracer->Composite(passCmd, m_Frame.frameIndex);
+        passCmd.EndRendering();
+    });
+}
+
+} // namespace metagfx
@@ -2,12 +2,78 @@
 // src/renderer/RasterizationRenderer.cpp
 // ============================================================================
 #include "metagfx/renderer/RasterizationRenderer.h"
-#include "metagfx/scene/Scene.h"
-#include "metagfx/scene/Camera.h"
+#include "metagfx/renderer/DynamicResolution.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/rhi/UniformRingBuffer.h"
+#include "metagfx/scene/AutoExposure.h"
+#include "metagfx/scene/Bloom.h"
+#include "metagfx/scene/Camera.h"
+#include "metagfx/scene/GPUCuller.h"
+#include "metagfx/scene/GeometryPool.h"
+#include "metagfx/scene/LodSelector.h"
+#include "metagfx/scene/Material.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/scene/ObjectPicker.h"
+#include "metagfx/scene/Scene.h"
+#include "metagfx/scene/ShadingRate.h"
+#include "metagfx/scene/ShadowAtlas.h"
+#include "metagfx/scene/ShadowMoments.h"
+#include "metagfx/scene/StreamEncoder.h"
+#include "metagfx/scene/TemporalAA.h"
+#include "metagfx/scene/WeightedBlendedOIT.h"
+#include <algorithm>
+#include <cmath>
 
 namespace metagfx {
 
+namespace {
+
+// Order-independent hash of a set of instance ids, with their levels of detail when
+// given: BVH queries return them in no particular order
+uint64 HashInstanceSet(const std::vector<uint32>& instances, const std::vector<uint8>* lods = nullptr) {
+    uint64 hash = instances.size();
+    for (uint32 instance : instances) {
+        uint64 lod = lods ? (*lods)[instance] : 0;
+        uint64 mixed = (static_cast<uint64>(instance) + 1 + (lod << 32)) * 0x9e3779b97f4a7c15ull;
+        hash += mixed ^ (mixed >> 29);
+    }
+    return hash;
+}
+
+uint32 CountInstances(const std::vector<DrawBatch>& drawList) {
+    uint32 count = 0;
+    for (const DrawBatch& batch : drawList) {
+        count += batch.instanceCount;
+    }
+    return count;
+}
+
+// Viewport and scissor of a square or rectangular tile of a target
+void SetTileViewport(rhi::CommandBuffer& cmd, uint32 x, uint32 y, uint32 width, uint32 height) {
+    rhi::Viewport viewport{};
+    viewport.x = static_cast<float>(x);
+    viewport.y = static_cast<float>(y);
+    viewport.width = static_cast<float>(width);
+    viewport.height = static_cast<float>(height);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    cmd.SetViewport(viewport);
+
+    rhi::Rect2D scissor{};
+    scissor.x = static_cast<int32>(x);
+    scissor.y = static_cast<int32>(y);
+    scissor.width = width;
+    scissor.height = height;
+    cmd.SetScissor(scissor);
+}
+
+} // namespace
+
 RasterizationRenderer::RasterizationRenderer(Ref<rhi::GraphicsDevice> device)
     : Renderer(device) {
 }
@@ -19,35 +85,25 @@ RasterizationRenderer::~RasterizationRenderer() {
 void RasterizationRenderer::Initialize() {
     METAGFX_INFO << "Initializing Rasterization Renderer";
 
-    // TODO: Create pipelines in Phase 0
-    // TODO: Initialize shadow map in Phase 2
+    // Allocates the frame's transient textures, the depth buffer among them
+    m_RenderGraph = std::make_unique<RenderGraph>(m_Device);
 }
 
 void RasterizationRenderer::Shutdown() {
+    if (!m_RenderGraph) {
+        return;
+    }
     METAGFX_INFO << "Shutting down Rasterization Renderer";
 
-    DestroyPipelines();
-    // m_ShadowMap.reset();  // TODO: Uncomment when ShadowMap is implemented in Phase 2
-}
-
-void RasterizationRenderer::Render(Scene& scene, Camera& camera) {
-    // TODO: This will be implemented in phases:
-    // Phase 2: Shadow pass
-    // Phase 4: Main pass with shadow sampling
-
-    // if (m_EnableShadows && m_ShadowMap) {
-    //     RenderShadowPass(scene, camera);
-    // }
-
-    RenderMainPass(scene, camera);
+    m_RenderGraph.reset();
+    m_Frame = FrameInputs{};
+    m_Model = nullptr;
 }
 
 void RasterizationRenderer::OnResize(uint32 width, uint32 height) {
+    // The depth buffer (a render graph texture) follows from the next frame on
     m_Width = width;
     m_Height = height;
-
-    // Recreate pipelines if necessary
-    // Shadow map size is independent of viewport size
 }
 
 bool RasterizationRenderer::SupportsFeature(RenderFeature feature) const {
@@ -55,50 +111,1282 @@ bool RasterizationRenderer::SupportsFeature(RenderFeature feature) const {
         case RenderFeature::Shadows:
             return true;  // Shadow mapping is supported
         case RenderFeature::AmbientOcclusion:
-            return false;  // SSAO not implemented yet
+            return false;  // Deferred only: the forward prepass leaves no depth before shading
+        case RenderFeature::ShadowDebugViews:
+            return true;   // model.frag draws them
+        case RenderFeature::VariableRateShading:
+            return true;   // Where the device takes a shading rate image
+        case RenderFeature::RayTracedShadows:
+            return m_Device->GetDeviceInfo().supportsRayQuery;  // model_raytraced.frag's ray queries
         default:
-            return false;  // No ray tracing features in rasterization mode
+            return false;  // No other ray tracing features in rasterization mode
     }
 }
 
-void RasterizationRenderer::SetShadowMapSize(uint32 size) {
-    if (size < 512 || size > 8192) {
-        METAGFX_WARN << "Shadow map size must be between 512 and 8192. Clamping.";
-        size = std::clamp(size, 512u, 8192u);
+void RasterizationRenderer::Render(Scene& scene, Camera& camera) {
+    METAGFX_PROFILE_FUNCTION();
+    using namespace rhi;
+
+    const FrameInputs& frame = m_Frame;
+    if (!m_RenderGraph || !frame.commandBuffer || !frame.backBuffer || !frame.uniformRing) {
+        return;
+    }
+
+    Model* model = scene.GetModel();
+    m_Model = model && model->IsValid() ? model : nullptr;
+    m_CompactModel = m_Model && m_Model->GetVertexFormat() == VertexFormat::Compact;
+
+    // =============================================================================
+    // Render graph: the passes below declare what they read and write, and record
+    // when the graph executes at the end of the frame. The graph culls the passes
+    // nothing uses and records the barriers and layout transitions between them.
+    // =============================================================================
+
+    m_RenderGraph->Reset();
+    m_Resources = FrameResources{};
+    m_Resources.backBuffer =
+        m_RenderGraph->ImportTexture("Back buffer", frame.backBuffer, ResourceState::Undefined, ResourceState::Present);
+    m_RenderGraph->MarkOutput(m_Resources.backBuffer);
+
+    // With a tone mapper the main pass renders linear color into an HDR texture of the
+    // graph, and the tone mapping pass reads it into the back buffer
+    m_ToneMapped = frame.toneMapper && frame.toneMapper->IsValid();
+
+    // A multisampled forward main pass resolves into the scene color. Its depth is not
+    // resolved, so nothing can sample it: the depth pyramid of the occlusion test and
+    // temporal AA sit out.
+    m_MSAASamples = m_ToneMapped && GetMode() == RenderMode::Rasterization ? std::max(frame.msaaSamples, 1u) : 1;
+    if (m_MSAASamples > 1) {
+        m_Frame.occlusionCulling = false;
+        m_Frame.temporalAA = nullptr;
+    }
+
+    // Temporal AA upscaling: everything up to it renders at a reduced size, bloom and tone
+    // mapping at the viewport's
+    m_RenderWidth = m_Width;
+    m_RenderHeight = m_Height;
+    m_RegionWidth = m_Width;
+    m_RegionHeight = m_Height;
+    if (m_ToneMapped && frame.temporalAA && frame.temporalAA->IsValid() && frame.motionVectorDescriptorSet) {
+        glm::uvec2 renderSize = TemporalAA::GetInputSize(m_Width, m_Height, frame.upscale);
+        m_RenderWidth = renderSize.x;
+        m_RenderHeight = renderSize.y;
+
+        // Dynamic resolution draws a region of targets of that size, so they are not
+        // reallocated as it changes
+        glm::uvec2 regionSize = DynamicResolution::ScaleSize(m_RenderWidth, m_RenderHeight, frame.renderScale);
+        m_RegionWidth = regionSize.x;
+        m_RegionHeight = regionSize.y;
     }
+    if (frame.gpuCuller) {
+        frame.gpuCuller->SetDepthSize(m_RenderWidth, m_RenderHeight);
+    }
+
+    // The depth buffer only lives through the frame. Unless the depth pyramid samples
+    // it, the main pass is its only user and it stays in tile memory where it can.
+    TextureDesc depthDesc{};
+    depthDesc.width = m_RenderWidth;
+    depthDesc.height = m_RenderHeight;
+    depthDesc.format = m_Device->GetDeviceInfo().depthFormat;
+    depthDesc.sampleCount = m_MSAASamples;
+    depthDesc.debugName = "DepthBuffer";
+    m_Resources.depth = m_RenderGraph->CreateTexture("Depth buffer", depthDesc);
+    m_Resources.sceneDepth = m_Resources.depth;
 
-    m_ShadowMapSize = size;
+    if (m_ToneMapped) {
+        TextureDesc sceneColorDesc = depthDesc;
+        sceneColorDesc.format = ToneMapper::SCENE_COLOR_FORMAT;
+        sceneColorDesc.sampleCount = 1;
+        sceneColorDesc.debugName = "SceneColor";
+        m_Resources.sceneColor = m_RenderGraph->CreateTexture("Scene color", sceneColorDesc);
+
+        // Like the depth buffer, only ever an attachment of the main pass: it is never
+        // stored, only resolved (memoryless on tiled GPUs)
+        if (m_MSAASamples > 1) {
+            TextureDesc msaaColorDesc = depthDesc;
+            msaaColorDesc.format = ToneMapper::SCENE_COLOR_FORMAT;
+            msaaColorDesc.debugName = "MSAAColor";
+            m_Resources.msaaColor = m_RenderGraph->CreateTexture("MSAA color", msaaColorDesc);
+        }
+    } else {
+        m_Resources.sceneColor = m_Resources.backBuffer;
+    }
+
+    // Shadow maps keep their contents for later frames (cached cascades, atlas tiles) and
+    // rest readable by the main pass. The moments are rebuilt while they are not current,
+    // so they are no output: their pass is culled unless the main pass samples them.
+    if (frame.shadowMap) {
+        m_Resources.shadowMap = m_RenderGraph->ImportTexture("Shadow map", frame.shadowMap->GetDepthTexture(),
+                                                             ResourceState::ShaderRead, ResourceState::ShaderRead);
+        m_RenderGraph->MarkOutput(m_Resources.shadowMap);
+    }
+    if (frame.shadowAtlas) {
+        m_Resources.shadowAtlas = m_RenderGraph->ImportTexture("Shadow atlas", frame.shadowAtlas->GetDepthTexture(),
+                                                               ResourceState::ShaderRead, ResourceState::ShaderRead);
+        m_RenderGraph->MarkOutput(m_Resources.shadowAtlas);
+    }
+    if (frame.shadowMoments && frame.shadowMoments->IsValid()) {
+        m_Resources.shadowMoments = m_RenderGraph->ImportTexture("Shadow moments", frame.shadowMoments->GetTexture(),
+                                                                 ResourceState::ShaderRead, ResourceState::ShaderRead);
+    }
+
+    // The rate image rests as storage between frames: the main pass shades by the last
+    // frame's rates, then the shading rate pass writes the next frame's
+    m_ShadingRateApplied = false;
+    m_DepthPyramidBuilt = false;
+    if (m_ToneMapped && frame.shadingRate && frame.shadingRate->IsValid() &&
+        SupportsFeature(RenderFeature::VariableRateShading)) {
+        frame.shadingRate->Resize(m_RenderWidth, m_RenderHeight);
+        if (frame.shadingRate->GetRateImage()) {
+            m_Resources.shadingRate = m_RenderGraph->ImportTexture("Shading rate", frame.shadingRate->GetRateImage(),
+                                                                   ResourceState::StorageWrite, ResourceState::StorageWrite);
+            m_RenderGraph->MarkOutput(m_Resources.shadingRate);
+        }
+    }
+
+    // The probes rest readable by the lit passes; each frame traces a few of them again
+    if (frame.lightProbes && frame.lightProbes->NeedsUpdate()) {
+        m_Resources.lightProbes = m_RenderGraph->ImportBuffer("Light probes", frame.lightProbes->GetProbeBuffer(),
+                                                              ResourceState::ShaderRead, ResourceState::ShaderRead);
+        m_RenderGraph->MarkOutput(m_Resources.lightProbes);
+    }
+
+    BuildDrawLists(scene, camera);
+    RenderShadowPass(scene, camera);
+    RenderLightProbePass();
+    RenderMainPass(scene, camera);
+    RenderTemporalAAPass(camera);
+    RenderShadingRatePass(camera);
+    RenderBloomPass();
+    RenderToneMapPass();
+
+    // Next frame's occlusion test reads this frame's depth through the pyramid, unless
+    // the reflections built it already
+    if (m_GPUCulling && frame.occlusionCulling) {
+        RenderDepthPyramidPass();
+    }
+
+    // The tone mapping pass draws the overlay over the back buffer it writes; without
+    // it the overlay loads the back buffer in a pass of its own
+    if (frame.content && !m_ToneMapped) {
+        m_RenderGraph->AddPass("Overlay", [this](RenderGraph::PassBuilder& pass) {
+            pass.Write(m_Resources.backBuffer, ResourceState::ColorAttachment);
+        }, [this](CommandBuffer& passCmd) {
+            const Ref<Texture> colorAttachments[] = { m_Frame.backBuffer };
+            const ClearValue clearValues[] = { ClearValue{} };
+            passCmd.BeginRendering(colorAttachments, nullptr, clearValues, LoadOp::Load);
+            m_Frame.content->RecordOverlay(passCmd);
+            passCmd.EndRendering();
+        });
+    }
+    RenderPickPass(camera);
+    RenderCapturePass();
+    RenderStreamPass();
+
+    {
+        METAGFX_PROFILE_SCOPE("Render graph");
+        m_RenderGraph->SetAsyncComputeEnabled(frame.computeCommandBuffer != nullptr);
+        m_RenderGraph->Compile();
+        m_RenderGraph->Execute(*frame.commandBuffer, frame.computeCommandBuffer.get());
+    }
 
-    // Recreate shadow map if it already exists
-    // if (m_ShadowMap) {
-    //     // TODO: Recreate shadow map in Phase 2
-    // }
+    // The next frame's motion vectors start from this frame
+    m_PreviousViewProjection = camera.GetUnjitteredViewProjectionMatrix();
+    m_PreviousView = camera.GetViewMatrix();
+    m_PreviousModelMatrix = m_CompactModel ? frame.modelMatrix * m_Model->GetDequantizeMatrix() : frame.modelMatrix;
+    m_HasPreviousFrame = true;
 }
 
+// =============================================================================
+// Culling Pass: GPU visibility of the model's meshes for the camera and the light
+// =============================================================================
+void RasterizationRenderer::BuildDrawLists(Scene& scene, Camera& camera) {
+    using namespace rhi;
+
+    const FrameInputs& frame = m_Frame;
+
+    // The Vulkan-convention camera matrix addresses the depth pyramid on every backend
+    m_CullViewProjection = camera.GetProjectionMatrix() * camera.GetViewMatrix();
+    // The culling pass covers the model's own meshes, so not the copies of an instance grid
+    m_GPUCulling = frame.gpuCulling && frame.gpuCuller && frame.gpuCuller->HasModel() && m_Model && frame.singleCopy;
+
+    // Levels of detail of every instance, from its size in the region drawn
+    const std::vector<uint8>* cameraLods = nullptr;
+    const std::vector<uint8>* shadowLods = nullptr;
+    m_CoarserLods = false;
+    if (frame.lodSelector && m_Model) {
+        frame.lodSelector->Update(scene, frame.modelMatrix, camera.GetProjectionMatrix(), camera.GetPosition(),
+                                  static_cast<float>(m_RegionHeight));
+        m_CoarserLods = frame.lodSelector->HasCoarserLods();
+        if (m_CoarserLods) {
+            cameraLods = &frame.lodSelector->GetCameraLods();
+            shadowLods = &frame.lodSelector->GetShadowLods();
+        }
+    }
+
+    if (m_GPUCulling) {
+        // The argument buffers rest as the draws' arguments; the pyramid rests readable by
+        // the next frame's cull, which tests against it
+        GPUCuller& culler = *frame.gpuCuller;
+        m_Resources.cameraDraws = m_RenderGraph->ImportBuffer("Camera draws", culler.GetCameraDrawBuffer(),
+                                                              ResourceState::IndirectArgument, ResourceState::IndirectArgument);
+        m_Resources.shadowDraws = m_RenderGraph->ImportBuffer("Shadow draws", culler.GetShadowDrawBuffer(),
+                                                              ResourceState::IndirectArgument, ResourceState::IndirectArgument);
+        m_Resources.shadowDrawCount = m_RenderGraph->ImportBuffer("Shadow draw count", culler.GetShadowDrawCountBuffer(),
+                                                                  ResourceState::IndirectArgument, ResourceState::IndirectArgument);
+        ImportDepthPyramid();
+
+        // The single copy's instances are the model's meshes
+        m_MeshCameraLods.assign(m_Model->GetMeshCount(), 0);
+        m_MeshShadowLods.assign(m_Model->GetMeshCount(), 0);
+        for (uint32 instance = 0; cameraLods && instance < scene.GetMeshInstanceCount(); ++instance) {
+            uint32 mesh = scene.GetMeshInstance(instance).userData;
+            if (scene.GetMeshInstance(instance).mesh && mesh < m_MeshCameraLods.size()) {
+                m_MeshCameraLods[mesh] = (*cameraLods)[instance];
+                m_MeshShadowLods[mesh] = (*shadowLods)[instance];
+            }
+        }
+
+        // One caster list for all cascades, culled against the volume enclosing them.
+        // Its inputs are the CPU's and the last frame's pyramid, so it runs on the async
+        // compute queue, alongside the graphics work up to the first pass drawing its lists.
+        glm::mat4 lightViewProjection = frame.shadowMap ? frame.shadowMap->GetCullMatrix() : m_CullViewProjection;
+        m_RenderGraph->AddAsyncComputePass("Culling", [this](RenderGraph::PassBuilder& pass) {
+            pass.Read(m_Resources.depthPyramid, ResourceState::ShaderRead);
+            pass.Write(m_Resources.cameraDraws, ResourceState::StorageWrite);
+            pass.Write(m_Resources.shadowDraws, ResourceState::StorageWrite);
+            pass.Write(m_Resources.shadowDrawCount, ResourceState::StorageWrite);
+        }, [this, lightViewProjection, cameraPosition = camera.GetPosition()](CommandBuffer& passCmd) {
+            m_Frame.gpuCuller->Cull(passCmd, m_Frame.frameIndex, m_Frame.modelMatrix, m_CullViewProjection,
+                                    cameraPosition, lightViewProjection, m_Frame.occlusionCulling,
+                                    m_MeshCameraLods.data(), m_MeshShadowLods.data());
+        });
+    }
+
+    // Otherwise the draw lists are filtered here by a walk of the scene BVH, where the
+    // model's meshes are instances. Visible instances of the same mesh become one
+    // instanced batch; batches are in mesh order.
+    m_CPUCulling = !m_GPUCulling && frame.cpuCulling && m_Model;
+    uint32 cascadeCount = frame.shadowMap ? frame.shadowMap->GetCascadeCount() : 0;
+    m_CasterHash = (m_GPUCulling ? 1u : 0u) | (m_CPUCulling ? 2u : 0u);
+    for (uint32 mesh = 0; m_GPUCulling && mesh < m_MeshShadowLods.size(); ++mesh) {
+        m_CasterHash = m_CasterHash * 31 + m_MeshShadowLods[mesh];
+    }
+    m_MainDrawList.clear();
+    for (std::vector<DrawBatch>& shadowDrawList : m_ShadowDrawLists) {
+        shadowDrawList.clear();
+    }
+    if (m_GPUCulling) {
+        for (uint32 i = 0; i < static_cast<uint32>(m_Model->GetMeshCount()); ++i) {
+            m_MainDrawList.push_back({ i, m_Model->GetMeshNode(i), 1 });
+        }
+        for (uint32 cascade = 0; cascade < cascadeCount; ++cascade) {
+            m_ShadowDrawLists[cascade] = m_MainDrawList;
+        }
+    } else if (m_Model && frame.instanceBuffer) {
+        auto buildDrawList = [this, &scene](const Frustum& frustum, std::vector<DrawBatch>& drawList,
+                                            const std::vector<uint8>* lods) {
+            m_VisibleInstances.clear();
+            if (m_CPUCulling) {
+                scene.QueryInstances(frustum, m_VisibleInstances);
+            } else {
+                for (uint32 instance = 0; instance < scene.GetMeshInstanceCount(); ++instance) {
+                    if (scene.GetMeshInstance(instance).mesh) {
+                        m_VisibleInstances.push_back(instance);
+                    }
+                }
+            }
+            m_Frame.instanceBuffer->BuildBatches(scene, m_VisibleInstances, drawList, lods);
+        };
+        buildDrawList(camera.GetFrustumPlanes(), m_MainDrawList, cameraLods);
+        // Each cascade only draws the casters inside its own light volume. The caster sets
+        // key the shadow map cache; GPU-culled casters follow from the cascades alone.
+        for (uint32 cascade = 0; cascade < cascadeCount; ++cascade) {
+            buildDrawList(Frustum::FromMatrix(frame.shadowMap->GetCascadeMatrix(cascade)), m_ShadowDrawLists[cascade],
+                          shadowLods);
+            m_CasterHash = m_CasterHash * 31 + HashInstanceSet(m_VisibleInstances, shadowLods);
+        }
+    }
+    m_MainInstanceCount = CountInstances(m_MainDrawList);
+    m_ShadowInstanceCount = 0;
+    m_ShadowDrawCount = 0;
+    for (uint32 cascade = 0; cascade < cascadeCount; ++cascade) {
+        m_ShadowInstanceCount += CountInstances(m_ShadowDrawLists[cascade]);
+        m_ShadowDrawCount += static_cast<uint32>(m_ShadowDrawLists[cascade].size());
+    }
+}
+
+// =============================================================================
+// Shadow Pass: the cascades of the shadow light, their EVSM moments, and the queued
+// point and spot light faces of the shadow atlas
+// =============================================================================
 void RasterizationRenderer::RenderShadowPass(Scene& scene, Camera& camera) {
-    // TODO: Implement in Phase 2
-    // 1. Set up light-space transformation matrices
-    // 2. Bind shadow pipeline
-    // 3. Render scene from light's perspective to shadow map
+    using namespace rhi;
+
+    const FrameInputs& frame = m_Frame;
+    m_ShadowMapCached = false;
+
+    METAGFX_DEBUG_ONCE << "Shadow pass conditions: shadows=" << frame.shadows
+                       << ", ShadowMap=" << (frame.shadowMap ? "valid" : "null")
+                       << ", Model=" << (m_Model ? "valid" : "null");
+
+    if (frame.shadows && frame.shadowMap && m_Model) {
+        METAGFX_DEBUG_ONCE << "Executing shadow pass - rendering " << m_Model->GetMeshes().size() << " meshes";
+
+        // Skip the pass while the map still holds these cascades and casters; the
+        // texture keeps its contents and stays in its sampling layout
+        m_ShadowMapCached = !frame.shadowMap->UpdateCache(m_CasterHash);
+        if (!m_ShadowMapCached) {
+            // The moments of the previous map are stale from here on
+            if (frame.shadowMoments) {
+                frame.shadowMoments->Invalidate();
+            }
+
+            m_RenderGraph->AddPass("Shadow pass", [this](RenderGraph::PassBuilder& pass) {
+                pass.Write(m_Resources.shadowMap, ResourceState::DepthAttachment);
+                pass.Read(m_Resources.shadowDraws, ResourceState::IndirectArgument);
+                pass.Read(m_Resources.shadowDrawCount, ResourceState::IndirectArgument);
+            }, [this](CommandBuffer& passCmd) {
+                ShadowMap& shadowMap = *m_Frame.shadowMap;
+                uint32 cascadeCount = shadowMap.GetCascadeCount();
+
+                // Depth-only; all cascades are tiles of one texture, cleared together
+                ClearValue shadowDepthClear{};
+                shadowDepthClear.depthStencil.depth = 1.0f;  // Standard: far plane
+                shadowDepthClear.depthStencil.stencil = 0;
+                const ClearValue clearValues[] = { shadowDepthClear };
+                passCmd.BeginRendering({}, shadowMap.GetDepthTexture(), clearValues);
+
+                uint32 meshesRendered = 0;
+                const Ref<GeometryPool>& pool = m_Model->GetGeometryPool();
+                for (uint32 cascade = 0; cascade < cascadeCount; ++cascade) {
+                    uint32 tileX = 0;
+                    uint32 tileY = 0;
+                    uint32 tileWidth = 0;
+                    uint32 tileHeight = 0;
+                    shadowMap.GetCascadeViewport(cascade, tileX, tileY, tileWidth, tileHeight);
+                    SetTileViewport(passCmd, tileX, tileY, tileWidth, tileHeight);
+
+                    ShadowPassUBO shadowUBO{};
+                    shadowUBO.lightSpaceMatrix = shadowMap.GetCascadeMatrix(cascade);
+                    shadowUBO.model = m_Frame.modelMatrix * m_Model->GetDequantizeMatrix();
+                    shadowUBO.vertexFormat = static_cast<uint32>(m_Model->GetVertexFormat());
+                    uint32 shadowUBOOffset = m_Frame.uniformRing->Push(shadowUBO);
+
+                    // Render all meshes from light's perspective. A pooled model needs no per-mesh
+                    // state here, so it is a single indirect draw over the pool's buffers, unless the
+                    // CPU culled the list, there are grid copies or the CPU picked coarser levels of
+                    // detail: then the batches are drawn one by one.
+                    if (pool && m_Model->GetDrawList() && !m_CPUCulling && m_Frame.singleCopy &&
+                        (m_GPUCulling || !m_CoarserLods)) {
+                        Ref<Buffer> positionBuffer = pool->GetPositionBuffer();
+                        Ref<Pipeline> shadowPipeline = SelectDepthOnlyPipeline(m_Frame.shadowPipelines, positionBuffer);
+                        passCmd.BindPipeline(shadowPipeline);
+                        passCmd.BindDescriptorSet(shadowPipeline, m_Frame.shadowDescriptorSet, m_Frame.frameIndex,
+                                                  &shadowUBOOffset, 1);
+                        passCmd.BindVertexBuffer(positionBuffer ? positionBuffer : pool->GetVertexBuffer());
+                        passCmd.BindIndexBuffer(pool->GetIndexBuffer());
+                        uint32 meshCount = static_cast<uint32>(m_Model->GetMeshCount());
+                        meshesRendered += meshCount;
+                        if (m_GPUCulling) {
+                            // Meshes or meshlets the culling pass found inside the volume of all cascades
+                            passCmd.DrawIndexedIndirectCount(m_Frame.gpuCuller->GetShadowDrawBuffer(), 0,
+                                                             m_Frame.gpuCuller->GetShadowDrawCountBuffer(), 0,
+                                                             m_Frame.gpuCuller->GetDrawCount());
+                        } else {
+                            passCmd.ExecuteDrawList(m_Model->GetDrawList());
+                        }
+                        continue;
+                    }
+
+                    meshesRendered += RecordDepthOnly(passCmd, m_ShadowDrawLists[cascade], m_Frame.shadowPipelines,
+                                                      m_Frame.shadowDescriptorSet, shadowUBOOffset);
+                }
+
+                // NOTE: Do NOT render ground plane in shadow pass!
+                // The ground plane should RECEIVE shadows, not CAST them.
+                // Rendering it here would write its depth to the shadow map and interfere
+                // with shadow calculations.
+
+                // Once a second at 60 fps
+                METAGFX_DEBUG_EVERY_N(60) << "Shadow pass rendered " << meshesRendered << " meshes in "
+                                          << cascadeCount << " cascades";
+
+                passCmd.EndRendering();
+            });
+        }
+
+        // EVSM: the moments of a re-rendered map, once per change of the map; culled
+        // while the main pass does not sample them
+        if (m_Resources.shadowMoments.IsValid() && !frame.shadowMoments->IsCurrent()) {
+            m_RenderGraph->AddPass("Shadow moments", [this](RenderGraph::PassBuilder& pass) {
+                pass.Read(m_Resources.shadowMap, ResourceState::ShaderRead);
+                pass.Write(m_Resources.shadowMoments, ResourceState::StorageWrite);
+            }, [this](CommandBuffer& passCmd) {
+                m_Frame.shadowMoments->Build(passCmd, m_Frame.frameIndex);
+            });
+        }
+    }
+
+    // The atlas texture keeps its contents, so only the queued tiles are cleared and
+    // redrawn. The first pass clears all of it, also while the atlas is off, so it is
+    // never sampled before it was written.
+    m_ShadowAtlasFacesRendered = 0;
+    ShadowAtlas* shadowAtlas = frame.shadowAtlas;
+    bool drawFaces = shadowAtlas && frame.shadowAtlasActive && m_Model && frame.instanceBuffer &&
+                     !shadowAtlas->GetRenderQueue().empty();
+    if (shadowAtlas && (shadowAtlas->NeedsFullClear() || drawFaces)) {
+        m_RenderGraph->AddPass("Shadow atlas pass", [this](RenderGraph::PassBuilder& pass) {
+            pass.Write(m_Resources.shadowAtlas, ResourceState::DepthAttachment);
+        }, [this, &scene, drawFaces](CommandBuffer& passCmd) {
+            ShadowAtlas& atlas = *m_Frame.shadowAtlas;
+
+            ClearValue atlasClear{};
+            atlasClear.depthStencil.depth = 1.0f;
+            atlasClear.depthStencil.stencil = 0;
+            const ClearValue clearValues[] = { atlasClear };
+
+            passCmd.BeginRendering({}, atlas.GetDepthTexture(), clearValues,
+                                   atlas.NeedsFullClear() ? LoadOp::Clear : LoadOp::Load);
+            atlas.MarkCleared();
+
+            // The clear quad's vertices are already in clip space at the far plane
+            ShadowPassUBO clearUBO{};
+            clearUBO.lightSpaceMatrix = glm::mat4(1.0f);
+            clearUBO.lightSpaceMatrix[3][2] = 1.0f;
+            clearUBO.model = glm::mat4(1.0f);
+            uint32 clearUBOOffset = m_Frame.uniformRing->Push(clearUBO);
+
+            // Nothing is queued while the atlas is off
+            const std::vector<ShadowAtlas::Face>& faces = atlas.GetRenderQueue();
+            for (size_t i = 0; drawFaces && i < faces.size(); ++i) {
+                const ShadowAtlas::Face& face = faces[i];
+                SetTileViewport(passCmd, face.x, face.y, face.size, face.size);
+
+                // Wipe the tile's previous face. The clear instance's identity transform
+                // leaves the quad where it is.
+                passCmd.BindPipeline(m_Frame.shadowClearPipeline);
+                passCmd.BindDescriptorSet(m_Frame.shadowClearPipeline, m_Frame.shadowDescriptorSet,
+                                          m_Frame.frameIndex, &clearUBOOffset, 1);
+                passCmd.BindVertexBuffer(m_Frame.shadowClearQuad);
+                passCmd.Draw(6, 1, 0, m_Frame.shadowClearInstance);
+
+                // Casters inside the face's frustum
+                m_VisibleInstances.clear();
+                scene.QueryInstances(Frustum::FromMatrix(face.matrix), m_VisibleInstances);
+                const std::vector<uint8>* lods =
+                    m_CoarserLods ? &m_Frame.lodSelector->GetShadowLods() : nullptr;
+                m_Frame.instanceBuffer->BuildBatches(scene, m_VisibleInstances, m_ShadowAtlasDrawList, lods);
+                if (!m_ShadowAtlasDrawList.empty()) {
+                    ShadowPassUBO faceUBO{};
+                    faceUBO.lightSpaceMatrix = face.matrix;
+                    faceUBO.model = m_Frame.modelMatrix * m_Model->GetDequantizeMatrix();
+                    faceUBO.vertexFormat = static_cast<uint32>(m_Model->GetVertexFormat());
+                    RecordDepthOnly(passCmd, m_ShadowAtlasDrawList, m_Frame.shadowPipelines,
+                                    m_Frame.shadowDescriptorSet, m_Frame.uniformRing->Push(faceUBO));
+                }
+                ++m_ShadowAtlasFacesRendered;
+            }
+
+            passCmd.EndRendering();
+        });
+    }
+}
+
+// =============================================================================
+// Light Probe Pass: the frame's share of the irradiance probes, traced against the
+// scene's top level ahead of the passes that light with them
+// =============================================================================
+void RasterizationRenderer::RenderLightProbePass() {
+    using namespace rhi;
+
+    if (!m_Resources.lightProbes.IsValid()) {
+        return;
+    }
+
+    // Off, the volume only copies a header that turns it off into the buffer
+    ResourceState state = m_Frame.lightProbes->IsEnabled() ? ResourceState::StorageWrite : ResourceState::TransferWrite;
+    m_RenderGraph->AddPass("Light probes", [this, state](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.lightProbes, state);
+    }, [this](CommandBuffer& passCmd) {
+        m_Frame.lightProbes->Update(passCmd, m_Frame.frameIndex, m_Frame.frameUniformOffset, m_Frame.lightProbeView);
+    });
 }
 
+// =============================================================================
+// Main Pass: Render scene with shadow sampling
+// =============================================================================
 void RasterizationRenderer::RenderMainPass(Scene& scene, Camera& camera) {
-    // TODO: Implement in Phase 4
-    // This will eventually replace the rendering logic currently in Application::Render()
-    // 1. Bind main pipeline
-    // 2. Bind shadow map texture (if shadows enabled)
-    // 3. Render scene with PBR + IBL + shadows
+    using namespace rhi;
+
+    ModelPassPlan plan = PlanModelPass(camera);
+
+    // Until the first shading rate pass at the image's size there are no rates to shade by
+    m_ShadingRateApplied = m_Resources.shadingRate.IsValid() && m_Frame.shadingRate->HasRates();
+
+    m_RenderGraph->AddPass("Main pass", [this](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.msaaColor, ResourceState::ColorAttachment);
+        pass.Write(m_Resources.sceneColor, ResourceState::ColorAttachment);  // Or its resolve target
+        pass.Write(m_Resources.depth, ResourceState::DepthAttachment);
+        pass.Read(m_Resources.shadowMap, ResourceState::ShaderRead);
+        pass.Read(m_Resources.shadowAtlas, ResourceState::ShaderRead);
+        if (m_Frame.sampleShadowMoments) {
+            pass.Read(m_Resources.shadowMoments, ResourceState::ShaderRead);
+        }
+        pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+        pass.Read(m_Resources.lightProbes, ResourceState::ShaderRead);
+        if (m_ShadingRateApplied) {
+            pass.Read(m_Resources.shadingRate, ResourceState::ShadingRate);
+        }
+    }, [this, plan](CommandBuffer& passCmd) {
+        Ref<Texture> sceneColor = m_RenderGraph->GetTexture(m_Resources.sceneColor);
+        Ref<Texture> depth = m_RenderGraph->GetTexture(m_Resources.depth);
+        Ref<Texture> shadingRate = m_ShadingRateApplied ? m_RenderGraph->GetTexture(m_Resources.shadingRate) : nullptr;
+        if (m_Resources.msaaColor.IsValid()) {
+            RecordModelPass(passCmd, plan, m_RenderGraph->GetTexture(m_Resources.msaaColor), depth,
+                            GetBackgroundClear(), true, sceneColor, shadingRate);
+        } else {
+            RecordModelPass(passCmd, plan, sceneColor, depth, GetBackgroundClear(), true, nullptr, shadingRate);
+        }
+    });
+
+    RenderTransparencyPasses(plan, m_Resources.depth);
+}
+
+// =============================================================================
+// Transparency Passes: weighted blended order-independent transparency
+// =============================================================================
+void RasterizationRenderer::RenderTransparencyPasses(const ModelPassPlan& plan, RenderGraphResource depth) {
+    using namespace rhi;
+
+    if (plan.transparency != TransparencyMode::WeightedBlended || plan.transparentCount == 0) {
+        return;
+    }
+
+    TextureDesc targetDesc{};
+    targetDesc.width = m_RenderWidth;
+    targetDesc.height = m_RenderHeight;
+    targetDesc.format = WeightedBlendedOIT::ACCUMULATION_FORMAT;
+    targetDesc.debugName = "TransparencyAccumulation";
+    RenderGraphResource accumulation = m_RenderGraph->CreateTexture("Transparency accumulation", targetDesc);
+    targetDesc.format = WeightedBlendedOIT::REVEALAGE_FORMAT;
+    targetDesc.debugName = "TransparencyRevealage";
+    RenderGraphResource revealage = m_RenderGraph->CreateTexture("Transparency revealage", targetDesc);
+
+    // The blended packets again for each target, tested against the opaque depth without
+    // writing it (the backends render to one color attachment at a time). The
+    // accumulation clears to zero sums, the revealage to nothing covered.
+    auto addTargetPass = [this, depth](const char* name, RenderGraphResource target, float clear,
+                                       TransparentTarget drawn) {
+        m_RenderGraph->AddPass(name, [this, depth, target](RenderGraph::PassBuilder& pass) {
+            pass.Write(target, ResourceState::ColorAttachment);
+            pass.Read(depth, ResourceState::DepthAttachment);
+            pass.Read(m_Resources.shadowMap, ResourceState::ShaderRead);
+            pass.Read(m_Resources.shadowAtlas, ResourceState::ShaderRead);
+            if (m_Frame.sampleShadowMoments) {
+                pass.Read(m_Resources.shadowMoments, ResourceState::ShaderRead);
+            }
+            pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+            pass.Read(m_Resources.lightProbes, ResourceState::ShaderRead);
+        }, [this, depth, target, clear, drawn](CommandBuffer& passCmd) {
+            ClearValue colorClear{};
+            colorClear.color[0] = clear;
+            colorClear.color[1] = clear;
+            colorClear.color[2] = clear;
+            colorClear.color[3] = clear;
+            ClearValue depthClear{};
+            depthClear.depthStencil.depth = Camera::FAR_DEPTH;
+            const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(target) };
+            const ClearValue clearValues[] = { colorClear, depthClear };
+            RenderPassActions actions = LoadOp::ClearColor;
+            actions.depthStore = m_RenderGraph->GetStoreOp(depth);  // Dropped after the revealage
+            passCmd.BeginRendering(colorAttachments, m_RenderGraph->GetTexture(depth), clearValues, actions);
+            SetFullViewport(passCmd);
+            m_Frame.content->RecordTransparentDraws(passCmd, m_MainDrawList, drawn);
+            passCmd.EndRendering();
+        });
+    };
+    addTargetPass("Transparency", accumulation, 0.0f, TransparentTarget::Accumulation);
+    addTargetPass("Transparency revealage", revealage, 1.0f, TransparentTarget::Revealage);
+
+    m_RenderGraph->AddPass("Transparency composite", [this, accumulation, revealage](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.sceneColor, ResourceState::ColorAttachment);
+        pass.Read(accumulation, ResourceState::ShaderRead);
+        pass.Read(revealage, ResourceState::ShaderRead);
+    }, [this, accumulation, revealage](CommandBuffer& passCmd) {
+        m_Frame.oit->SetSources(m_RenderGraph->GetTexture(accumulation), m_RenderGraph->GetTexture(revealage));
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(m_Resources.sceneColor) };
+        const ClearValue clearValues[] = { ClearValue{} };
+        passCmd.BeginRendering(colorAttachments, nullptr, clearValues, LoadOp::Load);
+        SetFullViewport(passCmd);
+        m_Frame.oit->Composite(passCmd, m_Frame.frameIndex);
+        passCmd.EndRendering();
+    });
+}
+
+// =============================================================================
+// Temporal AA Pass: the model's motion vectors, then the jittered scene color
+// accumulated into the history and sharpened back
+// =============================================================================
+void RasterizationRenderer::RenderTemporalAAPass(Camera& camera) {
+    using namespace rhi;
+
+    const FrameInputs& frame = m_Frame;
+    if (!m_ToneMapped || !frame.temporalAA || !frame.temporalAA->IsValid() || !frame.motionVectorDescriptorSet) {
+        return;
+    }
+
+    TextureDesc motionDesc{};
+    motionDesc.width = m_RenderWidth;
+    motionDesc.height = m_RenderHeight;
+    motionDesc.format = TemporalAA::MOTION_VECTOR_FORMAT;
+    motionDesc.debugName = "MotionVectors";
+    RenderGraphResource motionVectors = m_RenderGraph->CreateTexture("Motion vectors", motionDesc);
+    motionDesc.format = m_Device->GetDeviceInfo().depthFormat;
+    motionDesc.debugName = "MotionDepth";
+    RenderGraphResource motionDepth = m_RenderGraph->CreateTexture("Motion depth", motionDesc);
+    m_Resources.motionVectors = motionVectors;
+    m_Resources.motionDepth = motionDepth;
+
+    glm::mat4 previousViewProjection =
+        m_HasPreviousFrame ? m_PreviousViewProjection : camera.GetUnjitteredViewProjectionMatrix();
+
+    // Only the model moves on its own: the scenery's pixels keep the cleared zero motion,
+    // and the camera's motion is the resolve's to reproject. Until the pipeline of the
+    // model's layout is ready the model keeps zero motion too.
+    const Ref<Pipeline>& motionPipeline =
+        m_CompactModel ? frame.motionVectorPipelines.compact : frame.motionVectorPipelines.full;
+    bool drawModel = m_Model && motionPipeline;
+    uint32 motionUBOOffset = 0;
+    if (drawModel) {
+        MotionVectorUBO motionUBO{};
+        motionUBO.model = m_CompactModel ? frame.modelMatrix * m_Model->GetDequantizeMatrix() : frame.modelMatrix;
+        motionUBO.view = camera.GetViewMatrix();
+        motionUBO.projection = camera.GetProjectionMatrix();
+        motionUBO.viewProjection = motionUBO.projection * motionUBO.view;
+        motionUBO.previousModel = m_HasPreviousFrame ? m_PreviousModelMatrix : motionUBO.model;
+        motionUBO.previousViewProjection = previousViewProjection;
+        motionUBOOffset = frame.uniformRing->Push(motionUBO);
+    }
+
+    m_RenderGraph->AddPass("Motion vectors", [this, motionVectors, motionDepth](RenderGraph::PassBuilder& pass) {
+        pass.Write(motionVectors, ResourceState::ColorAttachment);
+        pass.Write(motionDepth, ResourceState::DepthAttachment);
+        pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+    }, [this, motionVectors, motionDepth, drawModel, motionUBOOffset](CommandBuffer& passCmd) {
+        ClearValue depthClear{};
+        depthClear.depthStencil.depth = Camera::FAR_DEPTH;
+        depthClear.depthStencil.stencil = 0;
+
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(motionVectors) };
+        const ClearValue clearValues[] = { ClearValue{}, depthClear };
+        RenderPassActions actions;
+        actions.depthStore = m_RenderGraph->GetStoreOp(motionDepth);
+        passCmd.BeginRendering(colorAttachments, m_RenderGraph->GetTexture(motionDepth), clearValues, actions);
+        SetFullViewport(passCmd);
+        if (drawModel) {
+            RecordCameraDepthOnly(passCmd, m_Frame.motionVectorPipelines, m_Frame.motionVectorDescriptorSet,
+                                  motionUBOOffset);
+        }
+        passCmd.EndRendering();
+    });
+
+    // Upscaling, the resolve writes a scene color of the viewport's size, which bloom and
+    // tone mapping take from there
+    RenderGraphResource upscaledColor;
+    if (m_RegionWidth != m_Width || m_RegionHeight != m_Height) {
+        TextureDesc upscaledDesc{};
+        upscaledDesc.width = m_Width;
+        upscaledDesc.height = m_Height;
+        upscaledDesc.format = ToneMapper::SCENE_COLOR_FORMAT;
+        upscaledDesc.usage = m_Frame.temporalAA->GetOutputUsage();
+        upscaledDesc.debugName = "UpscaledColor";
+        upscaledColor = m_RenderGraph->CreateTexture("Upscaled color", upscaledDesc);
+    }
+
+    // From this frame's jittered NDC, which the scene depth is in, to the last frame's
+    // unjittered clip space, which the history is in
+    glm::mat4 reprojection = previousViewProjection * glm::inverse(camera.GetViewProjectionMatrix());
+    glm::vec2 jitter = camera.GetJitter();
+    m_RenderGraph->AddPass("Temporal AA", [this, motionVectors, motionDepth, upscaledColor](RenderGraph::PassBuilder& pass) {
+        pass.Read(m_Resources.sceneDepth, ResourceState::ShaderRead);
+        pass.Read(motionVectors, ResourceState::ShaderRead);
+        pass.Read(motionDepth, ResourceState::ShaderRead);
+        pass.Write(m_Resources.sceneColor, ResourceState::StorageWrite);
+        pass.Write(upscaledColor, ResourceState::StorageWrite);
+    }, [this, motionVectors, motionDepth, upscaledColor, reprojection, jitter](CommandBuffer& passCmd) {
+        m_Frame.temporalAA->SetSources(m_RenderGraph->GetTexture(m_Resources.sceneColor),
+                                       m_RenderGraph->GetTexture(m_Resources.sceneDepth),
+                                       m_RenderGraph->GetTexture(motionVectors),
+                                       m_RenderGraph->GetTexture(motionDepth),
+                                       upscaledColor.IsValid() ? m_RenderGraph->GetTexture(upscaledColor) : nullptr);
+        m_Frame.temporalAA->Resolve(passCmd, m_Frame.frameIndex, reprojection, jitter,
+                                    glm::uvec2(m_RegionWidth, m_RegionHeight));
+    });
+    if (upscaledColor.IsValid()) {
+        m_Resources.sceneColor = upscaledColor;
+    }
+}
+
+// =============================================================================
+// Shading Rate Pass: the next frame's shading rate image, from the scene color and,
+// with temporal AA, the motion of its pixels
+// =============================================================================
+void RasterizationRenderer::RenderShadingRatePass(Camera& camera) {
+    using namespace rhi;
+
+    if (!m_Resources.shadingRate.IsValid()) {
+        return;
+    }
+
+    // Temporal AA's resolve has left the scene color without jitter and aliasing, which
+    // would count as detail. Upscaled, all of it stands for the region.
+    bool upscaled = m_RegionWidth != m_Width || m_RegionHeight != m_Height;
+    bool motion = m_Resources.motionVectors.IsValid();
+    glm::uvec2 region(m_RegionWidth, m_RegionHeight);
+    glm::uvec2 colorRegion = upscaled ? glm::uvec2(m_Width, m_Height) : region;
+    glm::mat4 previousViewProjection =
+        m_HasPreviousFrame ? m_PreviousViewProjection : camera.GetUnjitteredViewProjectionMatrix();
+    glm::mat4 reprojection = previousViewProjection * glm::inverse(camera.GetViewProjectionMatrix());
+
+    m_RenderGraph->AddPass("Shading rate", [this, motion](RenderGraph::PassBuilder& pass) {
+        pass.Read(m_Resources.sceneColor, ResourceState::ShaderRead);
+        if (motion) {
+            pass.Read(m_Resources.sceneDepth, ResourceState::ShaderRead);
+            pass.Read(m_Resources.motionVectors, ResourceState::ShaderRead);
+            pass.Read(m_Resources.motionDepth, ResourceState::ShaderRead);
+        }
+        pass.Write(m_Resources.shadingRate, ResourceState::StorageWrite);
+    }, [this, motion, reprojection, region, colorRegion](CommandBuffer& passCmd) {
+        ShadingRate& shadingRate = *m_Frame.shadingRate;
+        if (motion) {
+            shadingRate.SetSources(m_RenderGraph->GetTexture(m_Resources.sceneColor),
+                                   m_RenderGraph->GetTexture(m_Resources.sceneDepth),
+                                   m_RenderGraph->GetTexture(m_Resources.motionVectors),
+                                   m_RenderGraph->GetTexture(m_Resources.motionDepth));
+        } else {
+            shadingRate.SetSources(m_RenderGraph->GetTexture(m_Resources.sceneColor));
+        }
+        shadingRate.Generate(passCmd, m_Frame.frameIndex, reprojection, region, colorRegion);
+    });
+}
+
+// =============================================================================
+// Bloom Pass: the HDR scene color's mip chain, blended back into it
+// =============================================================================
+void RasterizationRenderer::RenderBloomPass() {
+    using namespace rhi;
+
+    if (!m_ToneMapped || !m_Frame.bloom || !m_Frame.bloom->IsValid()) {
+        return;
+    }
+
+    // Auto exposure measures the scene color after it, as the tone mapping pass sees it
+    m_RenderGraph->AddPass("Bloom", [this](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.sceneColor, ResourceState::StorageWrite);
+    }, [this](CommandBuffer& passCmd) {
+        m_Frame.bloom->SetSource(m_RenderGraph->GetTexture(m_Resources.sceneColor));
+        m_Frame.bloom->Apply(passCmd, m_Frame.frameIndex);
+    });
 }
 
-void RasterizationRenderer::CreatePipelines() {
-    // TODO: Implement in Phase 0/1
-    // - Create main PBR pipeline (moved from Application)
-    // - Create shadow pipeline (Phase 2)
+// =============================================================================
+// Tone Mapping Pass: the HDR scene color, exposed and tone mapped, into the back buffer
+// =============================================================================
+void RasterizationRenderer::RenderToneMapPass() {
+    using namespace rhi;
+
+    if (!m_ToneMapped) {
+        return;
+    }
+
+    // The exposure adapts from frame to frame in its buffer, read by the tone mapping
+    // pass on the GPU without a round trip through the CPU
+    bool autoExposure = m_Frame.autoExposure && m_Frame.autoExposure->IsValid();
+    Ref<Buffer> exposureBuffer;
+    if (autoExposure) {
+        exposureBuffer = m_Frame.autoExposure->GetExposureBuffer();
+        m_Resources.exposure = m_RenderGraph->ImportBuffer("Exposure", exposureBuffer,
+                                                           ResourceState::ShaderRead, ResourceState::ShaderRead);
+        m_RenderGraph->AddPass("Auto exposure", [this](RenderGraph::PassBuilder& pass) {
+            pass.Read(m_Resources.sceneColor, ResourceState::ShaderRead);
+            pass.Write(m_Resources.exposure, ResourceState::StorageWrite);
+        }, [this](CommandBuffer& passCmd) {
+            m_Frame.autoExposure->SetSource(m_RenderGraph->GetTexture(m_Resources.sceneColor));
+            m_Frame.autoExposure->Measure(passCmd, m_Frame.frameIndex, m_Frame.deltaTime);
+        });
+    }
+    m_Frame.toneMapping.autoExposure = autoExposure;
+
+    m_RenderGraph->AddPass("Tone mapping", [this](RenderGraph::PassBuilder& pass) {
+        pass.Write(m_Resources.backBuffer, ResourceState::ColorAttachment);
+        pass.Read(m_Resources.sceneColor, ResourceState::ShaderRead);
+        pass.Read(m_Resources.exposure, ResourceState::ShaderRead);
+    }, [this, exposureBuffer](CommandBuffer& passCmd) {
+        // Every pixel is written, so the old contents are neither loaded nor cleared
+        m_Frame.toneMapper->SetSource(m_RenderGraph->GetTexture(m_Resources.sceneColor), exposureBuffer);
+        const Ref<Texture> colorAttachments[] = { m_Frame.backBuffer };
+        const ClearValue clearValues[] = { ClearValue{} };
+        passCmd.BeginRendering(colorAttachments, nullptr, clearValues, LoadOp::DontCare);
+        SetTileViewport(passCmd, 0, 0, m_Width, m_Height);
+        m_Frame.toneMapper->Apply(passCmd, m_Frame.frameIndex, m_Frame.toneMapping);
+        if (m_Frame.content) {
+            m_Frame.content->RecordOverlay(passCmd);
+        }
+        passCmd.EndRendering();
+    });
+}
+
+// =============================================================================
+// Capture Pass: hands the frame's final image to FrameInputs::capture, e.g. to read it
+// back for offscreen batch renders
+// =============================================================================
+void RasterizationRenderer::RenderCapturePass() {
+    using namespace rhi;
+
+    if (!m_Frame.capture) {
+        return;
+    }
+    RenderGraphResource image = m_Frame.captureHDR && m_ToneMapped ? m_Resources.sceneColor : m_Resources.backBuffer;
+    m_RenderGraph->AddPass("Capture", [image](RenderGraph::PassBuilder& pass) {
+        pass.Read(image, ResourceState::TransferRead);
+        pass.SetSideEffects();
+    }, [this, image](CommandBuffer& passCmd) {
+        m_Frame.capture(passCmd, m_RenderGraph->GetTexture(image));
+    });
+}
+
+// =============================================================================
+// Stream Pass: the frame's final image as NV12 on the GPU, a quarter of its RGBA
+// bytes, copied out for StreamEncoder to hand to the stream
+// =============================================================================
+void RasterizationRenderer::RenderStreamPass() {
+    using namespace rhi;
+
+    StreamEncoder* encoder = m_Frame.streamEncoder;
+    if (!encoder || !encoder->IsValid()) {
+        return;
+    }
+    // Sizes the output before the graph imports it
+    encoder->SetSource(m_Frame.backBuffer);
+    if (!encoder->GetOutput()) {
+        return;
+    }
+    RenderGraphResource output = m_RenderGraph->ImportBuffer("Stream frame", encoder->GetOutput(),
+                                                             ResourceState::TransferRead, ResourceState::TransferRead);
+
+    m_RenderGraph->AddPass("Stream encode", [this, output](RenderGraph::PassBuilder& pass) {
+        pass.Read(m_Resources.backBuffer, ResourceState::ShaderRead);
+        pass.Write(output, ResourceState::StorageWrite);
+    }, [this](CommandBuffer& passCmd) {
+        m_Frame.streamEncoder->Encode(passCmd, m_Frame.frameIndex);
+    });
+
+    m_RenderGraph->AddPass("Stream readback", [output](RenderGraph::PassBuilder& pass) {
+        pass.Read(output, ResourceState::TransferRead);
+        pass.SetSideEffects();
+    }, [this](CommandBuffer& passCmd) {
+        m_Frame.streamEncoder->ReadBack(passCmd);
+    });
+}
+
+// =============================================================================
+// Pick Pass: the model's meshes in the few pixels around a pick request, with their
+// mesh index and world position, copied out for ObjectPicker to resolve later
+// =============================================================================
+void RasterizationRenderer::RenderPickPass(Camera& camera) {
+    using namespace rhi;
+
+    const FrameInputs& frame = m_Frame;
+    ObjectPicker* picker = frame.picker;
+    const Ref<Pipeline>& pickPipeline = m_CompactModel ? frame.pickPipelines.compact : frame.pickPipelines.full;
+    // A request waits for the model and the pipeline of its layout
+    if (!picker || !picker->HasRequest() || !m_Model || !pickPipeline || !frame.depthPrepassDescriptorSet) {
+        return;
+    }
+
+    // The unjittered camera, so a still cursor picks the same surface every frame
+    glm::mat4 region = picker->BeginPick(glm::vec2(static_cast<float>(m_RegionWidth),
+                                                   static_cast<float>(m_RegionHeight)));
+    DepthPrepassUBO pickUBO{};
+    pickUBO.model = m_CompactModel ? frame.modelMatrix * m_Model->GetDequantizeMatrix() : frame.modelMatrix;
+    pickUBO.view = camera.GetViewMatrix();
+    pickUBO.projection = camera.GetProjectionMatrix();
+    pickUBO.viewProjection = region * camera.GetUnjitteredViewProjectionMatrix();
+    uint32 pickUBOOffset = frame.uniformRing->Push(pickUBO);
+
+    TextureDesc pickDesc{};
+    pickDesc.width = ObjectPicker::REGION_SIZE;
+    pickDesc.height = ObjectPicker::REGION_SIZE;
+    pickDesc.format = ObjectPicker::ID_FORMAT;
+    pickDesc.debugName = "PickIds";
+    RenderGraphResource ids = m_RenderGraph->CreateTexture("Pick ids", pickDesc);
+    pickDesc.format = ObjectPicker::DEPTH_FORMAT;
+    pickDesc.debugName = "PickDepth";
+    RenderGraphResource pickDepth = m_RenderGraph->CreateTexture("Pick depth", pickDesc);
+
+    m_RenderGraph->AddPass("Pick", [this, ids, pickDepth](RenderGraph::PassBuilder& pass) {
+        pass.Write(ids, ResourceState::ColorAttachment);
+        pass.Write(pickDepth, ResourceState::DepthAttachment);
+        pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+    }, [this, ids, pickDepth, pickUBOOffset](CommandBuffer& passCmd) {
+        ClearValue depthClear{};
+        depthClear.depthStencil.depth = Camera::FAR_DEPTH;
+        depthClear.depthStencil.stencil = 0;
+
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(ids) };
+        const ClearValue clearValues[] = { ClearValue{}, depthClear };
+        RenderPassActions actions;
+        actions.depthStore = m_RenderGraph->GetStoreOp(pickDepth);
+        passCmd.BeginRendering(colorAttachments, m_RenderGraph->GetTexture(pickDepth), clearValues, actions);
+
+        Viewport viewport{};
+        viewport.width = static_cast<float>(ObjectPicker::REGION_SIZE);
+        viewport.height = static_cast<float>(ObjectPicker::REGION_SIZE);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        passCmd.SetViewport(viewport);
+        Rect2D scissor{};
+        scissor.width = ObjectPicker::REGION_SIZE;
+        scissor.height = ObjectPicker::REGION_SIZE;
+        passCmd.SetScissor(scissor);
+
+        // Mesh by mesh, each pushing its index, even where the main pass draws the pool
+        // at once; with GPU culling each mesh draws its commands of the culling pass
+        Ref<Buffer> cameraDraws = m_GPUCulling ? m_Frame.gpuCuller->GetCameraDrawBuffer() : nullptr;
+        RecordDepthOnly(passCmd, m_MainDrawList, m_Frame.pickPipelines, m_Frame.depthPrepassDescriptorSet,
+                        pickUBOOffset, cameraDraws, true);
+        passCmd.EndRendering();
+    });
+
+    m_RenderGraph->AddPass("Pick readback", [ids](RenderGraph::PassBuilder& pass) {
+        pass.Read(ids, ResourceState::TransferRead);
+        pass.SetSideEffects();
+    }, [this, ids](CommandBuffer& passCmd) {
+        m_Frame.picker->ReadBack(passCmd, m_RenderGraph->GetTexture(ids));
+    });
 }
 
-void RasterizationRenderer::DestroyPipelines() {
-    m_MainPipeline.reset();
-    m_ShadowPipeline.reset();
+// =============================================================================
+// Depth Pyramid Pass: the farthest and nearest depth of the frame's depth buffer, at
+// every level (GPUCuller)
+// =============================================================================
+void RasterizationRenderer::ImportDepthPyramid() {
+    using namespace rhi;
+
+    // Rests readable by the next frame's cull, which tests against it
+    if (!m_Resources.depthPyramid.IsValid() && m_Frame.gpuCuller && m_Frame.gpuCuller->GetDepthPyramidBuffer()) {
+        m_Resources.depthPyramid = m_RenderGraph->ImportBuffer("Depth pyramid", m_Frame.gpuCuller->GetDepthPyramidBuffer(),
+                                                               ResourceState::ShaderRead, ResourceState::ShaderRead);
+        m_RenderGraph->MarkOutput(m_Resources.depthPyramid);
+    }
+}
+
+void RasterizationRenderer::RenderDepthPyramidPass() {
+    using namespace rhi;
+
+    ImportDepthPyramid();
+    if (m_DepthPyramidBuilt || !m_Resources.depthPyramid.IsValid()) {
+        return;
+    }
+    m_DepthPyramidBuilt = true;
+
+    m_RenderGraph->AddPass("Depth pyramid", [this](RenderGraph::PassBuilder& pass) {
+        pass.Read(m_Resources.depth, ResourceState::ShaderRead);
+        pass.Write(m_Resources.depthPyramid, ResourceState::StorageWrite);
+    }, [this](CommandBuffer& passCmd) {
+        m_Frame.gpuCuller->SetDepthSource(m_RenderGraph->GetTexture(m_Resources.depth));
+        m_Frame.gpuCuller->BuildDepthPyramid(passCmd, m_Frame.frameIndex, m_CullViewProjection,
+                                             m_RegionWidth, m_RegionHeight);
+    });
+}
+
+RasterizationRenderer::ModelPassPlan RasterizationRenderer::PlanModelPass(Camera& camera) {
+    const FrameInputs& frame = m_Frame;
+    ModelPassPlan plan;
+
+    // Weighted blended transparency composites over the HDR scene color, one sample per
+    // pixel; anything else sorts the blended materials
+    bool weightedBlended = frame.transparency == TransparencyMode::WeightedBlended && frame.oit &&
+                           frame.oit->IsValid() && m_ToneMapped && m_MSAASamples == 1;
+    plan.transparency = weightedBlended ? TransparencyMode::WeightedBlended : TransparencyMode::Sorted;
+
+    // Sorted packets of the model's draw list, from the content
+    plan.drawModel = m_Model && frame.content;
+    if (plan.drawModel) {
+        plan.packetCount = frame.content->QueueModelDraws(m_MainDrawList, m_GPUCulling, plan.transparency);
+        plan.transparentCount = frame.content->GetTransparentPacketCount();
+    }
+
+    // Depth prepass: the model's depth first, inside the pass so the depth buffer stays
+    // where it is, then its lit draws, whose LessOrEqual test leaves one shaded fragment
+    // per pixel. Skipped until the pipeline of the model's layout is ready.
+    const Ref<rhi::Pipeline>& prepassPipeline =
+        m_CompactModel ? frame.depthPrepassPipelines.compact : frame.depthPrepassPipelines.full;
+    m_DepthPrepassDrawn = plan.drawModel && frame.depthPrepass && prepassPipeline && frame.depthPrepassDescriptorSet;
+    if (m_DepthPrepassDrawn) {
+        // The prepass draws every texel of a mesh: masked and blended materials would
+        // leave depth where their lit draws discard or show through
+        const auto& meshes = m_Model->GetMeshes();
+        for (const DrawBatch& batch : m_MainDrawList) {
+            const Material* material = batch.mesh < meshes.size() ? meshes[batch.mesh]->GetMaterial() : nullptr;
+            if (material && material->GetAlphaMode() != AlphaMode::Opaque) {
+                m_DepthPrepassDrawn = false;
+                break;
+            }
+        }
+    }
+    if (m_DepthPrepassDrawn) {
+        DepthPrepassUBO prepassUBO{};
+        prepassUBO.model = m_CompactModel ? frame.modelMatrix * m_Model->GetDequantizeMatrix() : frame.modelMatrix;
+        prepassUBO.view = camera.GetViewMatrix();
+        prepassUBO.projection = camera.GetProjectionMatrix();
+        prepassUBO.viewProjection = prepassUBO.projection * prepassUBO.view;
+        plan.prepassUBOOffset = frame.uniformRing->Push(prepassUBO);
+    }
+
+    // Large draw lists are split into contiguous ranges of the sorted packets, each
+    // recorded into its own secondary command buffer by a job, while this thread
+    // records the prepass into the first one and the scenery into the last
+    if (plan.drawModel && frame.parallelRecording && m_Device->GetDeviceInfo().supportsParallelRecording) {
+        uint32 threadCount = JobSystem::GetWorkerCount();
+        uint32 rangeCount = static_cast<uint32>(plan.packetCount / MIN_PACKETS_PER_RECORDER);
+        plan.recorders = std::max(1u, std::min({ threadCount, rangeCount, MAX_MODEL_RECORDERS }));
+    }
+
+    m_MainRecorderCount = plan.drawModel ? plan.recorders : 0;
+    METAGFX_PROFILE_COUNTER("Main pass draws", plan.packetCount);
+    return plan;
+}
+
+void RasterizationRenderer::RecordModelPass(rhi::CommandBuffer& passCmd, const ModelPassPlan& plan,
+                                            const Ref<rhi::Texture>& target, const Ref<rhi::Texture>& depthBuffer,
+                                            const rhi::ClearValue& colorClear, bool drawScenery,
+                                            const Ref<rhi::Texture>& resolveTarget,
+                                            const Ref<rhi::Texture>& shadingRate) {
+    using namespace rhi;
+
+    RasterizationContent* content = m_Frame.content;
+
+    ClearValue depthClear{};
+    depthClear.depthStencil.depth = Camera::FAR_DEPTH;
+    depthClear.depthStencil.stencil = 0;
+
+    // On the stack: the pass's attachment lists cost no allocation
+    const Ref<Texture> colorAttachments[] = { target };
+    const ClearValue clearValues[] = { colorClear, depthClear };
+    std::span<const Ref<Texture>> resolveTargets;
+    if (resolveTarget) {
+        resolveTargets = { &resolveTarget, 1 };
+    }
+
+    // Only the resolved scene color is read on; the depth is dropped unless a later pass
+    // tests against or samples it
+    RenderPassActions actions;
+    actions.colorStore = resolveTarget ? StoreOp::Resolve : StoreOp::Store;
+    actions.depthStore = m_RenderGraph->GetStoreOp(m_Resources.depth);
+
+    // Blended over everything else, back to front; WeightedBlended draws them in passes
+    // of their own (RenderTransparencyPasses)
+    bool sortedTransparency = drawScenery && plan.transparency == TransparencyMode::Sorted && plan.transparentCount > 0;
+
+    m_MainMaterialChanges = 0;
+    if (plan.recorders > 1) {
+        uint32 firstModelRecorder = m_DepthPrepassDrawn ? 1 : 0;
+        uint32 sceneryRecorders = drawScenery ? 1 : 0;
+        passCmd.BeginParallelRendering(colorAttachments, depthBuffer, clearValues,
+                                       firstModelRecorder + plan.recorders + sceneryRecorders, actions,
+                                       resolveTargets, shadingRate);
+
+        // Per-frame, from the graph's arena
+        std::pmr::vector<uint32> materialChanges(plan.recorders, 0, &m_RenderGraph->GetFrameArena());
+        JobCounter recorders;
+        for (uint32 r = 0; r < plan.recorders; ++r) {
+            JobSystem::Run([&, r]() {
+                METAGFX_PROFILE_SCOPE("Record model draws");
+                Ref<CommandBuffer> secondary = passCmd.GetSecondaryCommandBuffer(firstModelRecorder + r);
+                secondary->Begin();
+                SetFullViewport(*secondary);
+                content->RecordModelDraws(*secondary, m_MainDrawList, plan.packetCount * r / plan.recorders,
+                                          plan.packetCount * (r + 1) / plan.recorders, materialChanges[r]);
+                secondary->End();
+            }, &recorders);
+        }
+
+        if (m_DepthPrepassDrawn) {
+            Ref<CommandBuffer> prepass = passCmd.GetSecondaryCommandBuffer(0);
+            prepass->Begin();
+            SetFullViewport(*prepass);
+            RecordCameraDepthOnly(*prepass, m_Frame.depthPrepassPipelines, m_Frame.depthPrepassDescriptorSet,
+                                  plan.prepassUBOOffset);
+            prepass->End();
+        }
+
+        if (drawScenery) {
+            Ref<CommandBuffer> scenery = passCmd.GetSecondaryCommandBuffer(firstModelRecorder + plan.recorders);
+            scenery->Begin();
+            SetFullViewport(*scenery);
+            content->RecordSceneryDraws(*scenery);
+            if (sortedTransparency) {
+                content->RecordTransparentDraws(*scenery, m_MainDrawList, TransparentTarget::SceneColor);
+            }
+            scenery->End();
+        }
+
+        JobSystem::Wait(recorders);
+        for (uint32 changes : materialChanges) {
+            m_MainMaterialChanges += changes;
+        }
+
+        passCmd.EndParallelRendering();
+    } else {
+        passCmd.BeginRendering(colorAttachments, depthBuffer, clearValues, actions, resolveTargets, shadingRate);
+        SetFullViewport(passCmd);
+
+        // Draw the model FIRST
+        if (content) {
+            if (m_DepthPrepassDrawn) {
+                RecordCameraDepthOnly(passCmd, m_Frame.depthPrepassPipelines, m_Frame.depthPrepassDescriptorSet,
+                                      plan.prepassUBOOffset);
+            }
+            if (plan.drawModel) {
+                content->RecordModelDraws(passCmd, m_MainDrawList, 0, plan.packetCount, m_MainMaterialChanges);
+            }
+            if (drawScenery) {
+                content->RecordSceneryDraws(passCmd);
+            }
+            if (sortedTransparency) {
+                content->RecordTransparentDraws(passCmd, m_MainDrawList, TransparentTarget::SceneColor);
+            }
+        }
+
+        passCmd.EndRendering();
+    }
+}
+
+rhi::ClearValue RasterizationRenderer::GetBackgroundClear() const {
+    rhi::ClearValue clear{};
+    clear.color[0] = 0.1f;
+    clear.color[1] = 0.1f;
+    clear.color[2] = 0.15f;
+    clear.color[3] = 1.0f;
+    if (m_ToneMapped) {
+        // The same color after the tone mapping pass's gamma (at an exposure of 1)
+        for (int c = 0; c < 3; ++c) {
+            clear.color[c] = std::pow(clear.color[c], 2.2f);
+        }
+    }
+    return clear;
+}
+
+void RasterizationRenderer::SetFullViewport(rhi::CommandBuffer& cmd) const {
+    rhi::Viewport viewport{};
+    viewport.width = static_cast<float>(m_RegionWidth);
+    viewport.height = static_cast<float>(m_RegionHeight);
+    viewport.minDepth = 0.0f;
+    viewport.maxDepth = 1.0f;
+    cmd.SetViewport(viewport);
+
+    rhi::Rect2D scissor{};
+    scissor.width = m_RegionWidth;
+    scissor.height = m_RegionHeight;
+    cmd.SetScissor(scissor);
+}
+
+// Clears positionBuffer when its pipeline is still compiling, so the caller binds the
+// full vertex buffer, whose positions the full-vertex depth-only pipelines read
+Ref<rhi::Pipeline> RasterizationRenderer::SelectDepthOnlyPipeline(const DepthOnlyPipelines& pipelines,
+                                                                  Ref<rhi::Buffer>& positionBuffer) const {
+    // The pulled pipeline reads the pool's full vertices, whichever buffer is bound
+    if (pipelines.pulled && m_Model->GetGeometryPool()) {
+        positionBuffer.reset();
+        return pipelines.pulled;
+    }
+    if (positionBuffer) {
+        const Ref<rhi::Pipeline>& positionPipeline = m_CompactModel ? pipelines.compactPosition : pipelines.position;
+        if (positionPipeline) {
+            return positionPipeline;
+        }
+        positionBuffer.reset();
+    }
+    return m_CompactModel ? pipelines.compact : pipelines.full;
+}
+
+// Depth-only pipeline per mesh: vertex layout of the model, and the position stream when
+// the mesh has one. The descriptor set is shared by all of them; the view's offset is
+// rebound with each pipeline. Returns the instances drawn.
+uint32 RasterizationRenderer::RecordDepthOnly(rhi::CommandBuffer& cmd, const std::vector<DrawBatch>& drawList,
+                                              const DepthOnlyPipelines& pipelines,
+                                              const Ref<rhi::DescriptorSet>& descriptorSet, uint32 uboOffset,
+                                              const Ref<rhi::Buffer>& cameraDraws, bool pushMeshIndex) const {
+    Ref<rhi::Pipeline> boundPipeline;
+    Ref<rhi::Buffer> boundVertexBuffer;
+    Ref<rhi::Buffer> boundIndexBuffer;
+    uint32 instancesDrawn = 0;
+
+    const auto& meshes = m_Model->GetMeshes();
+    for (const DrawBatch& batch : drawList) {
+        const auto& mesh = meshes[batch.mesh];
+        if (!mesh || !mesh->IsValid()) {
+            continue;
+        }
+        Ref<rhi::Buffer> positionBuffer = mesh->GetPositionBuffer();
+        Ref<rhi::Pipeline> pipeline = SelectDepthOnlyPipeline(pipelines, positionBuffer);
+        if (pipeline != boundPipeline) {
+            cmd.BindPipeline(pipeline);
+            cmd.BindDescriptorSet(pipeline, descriptorSet, m_Frame.frameIndex, &uboOffset, 1);
+            boundPipeline = pipeline;
+        }
+
+        // Meshes of a geometry pool share buffers, so those are only bound when they change
+        Ref<rhi::Buffer> vertexBuffer = positionBuffer ? positionBuffer : mesh->GetVertexBuffer();
+        if (vertexBuffer != boundVertexBuffer) {
+            cmd.BindVertexBuffer(vertexBuffer);
+            boundVertexBuffer = vertexBuffer;
+        }
+        if (mesh->GetIndexBuffer() != boundIndexBuffer) {
+            cmd.BindIndexBuffer(mesh->GetIndexBuffer());
+            boundIndexBuffer = mesh->GetIndexBuffer();
+        }
+        if (pushMeshIndex) {
+            cmd.PushConstants(pipeline, rhi::ShaderStage::Fragment, 0, sizeof(uint32), &batch.mesh);
+        }
+        if (cameraDraws) {
+            cmd.DrawIndexedIndirect(cameraDraws, m_Frame.gpuCuller->GetCameraDrawOffset(batch.mesh),
+                                    m_Frame.gpuCuller->GetMeshDrawCount(batch.mesh));
+        } else {
+            cmd.DrawIndexed(mesh->GetLodIndexCount(batch.lod), batch.instanceCount, mesh->GetLodFirstIndex(batch.lod),
+                            mesh->GetVertexOffset(), batch.firstInstance);
+        }
+        instancesDrawn += batch.instanceCount;
+    }
+    return instancesDrawn;
+}
+
+// The camera's view of the model, drawing what its lit draws will: a pooled model is one
+// indirect draw over the pool's buffers, of the culling pass's camera commands or of all
+// meshes, unless the CPU culled the list, there are grid copies or coarser levels of detail
+void RasterizationRenderer::RecordCameraDepthOnly(rhi::CommandBuffer& cmd, const DepthOnlyPipelines& pipelines,
+                                                  const Ref<rhi::DescriptorSet>& descriptorSet,
+                                                  uint32 uboOffset) const {
+    Ref<rhi::Buffer> cameraDraws = m_GPUCulling ? m_Frame.gpuCuller->GetCameraDrawBuffer() : nullptr;
+    const Ref<GeometryPool>& pool = m_Model->GetGeometryPool();
+    if (pool && m_Model->GetDrawList() && !m_CPUCulling && m_Frame.singleCopy &&
+        (m_GPUCulling || !m_CoarserLods)) {
+        Ref<rhi::Buffer> positionBuffer = pool->GetPositionBuffer();
+        Ref<rhi::Pipeline> pipeline = SelectDepthOnlyPipeline(pipelines, positionBuffer);
+        cmd.BindPipeline(pipeline);
+        cmd.BindDescriptorSet(pipeline, descriptorSet, m_Frame.frameIndex, &uboOffset, 1);
+        cmd.BindVertexBuffer(positionBuffer ? positionBuffer : pool->GetVertexBuffer());
+        cmd.BindIndexBuffer(pool->GetIndexBuffer());
+        if (cameraDraws) {
+            cmd.DrawIndexedIndirect(cameraDraws, 0, m_Frame.gpuCuller->GetDrawCount());
+        } else {
+            cmd.ExecuteDrawList(m_Model->GetDrawList());
+        }
+        return;
+    }
+    RecordDepthOnly(cmd, m_MainDrawList, pipelines, descriptorSet, uboOffset, cameraDraws);
 }
 
 } // namespace metagfx
@@ -0,0 +1,491 @@
+// ============================================================================
+// src/renderer/RenderGraph.cpp
+// ============================================================================
+#include "metagfx/renderer/RenderGraph.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/Texture.h"
+
+namespace metagfx {
+
+using rhi::ResourceState;
+
+// States whose accesses write: a second access in the same state still waits for the first
+static bool IsWriteState(ResourceState state) {
+    return state == ResourceState::StorageWrite || state == ResourceState::TransferWrite;
+}
+
+static bool IsAttachmentState(ResourceState state) {
+    return state == ResourceState::ColorAttachment || state == ResourceState::DepthAttachment;
+}
+
+// Usage a created texture needs for an access in this state
+static rhi::TextureUsage GetStateUsage(ResourceState state) {
+    switch (state) {
+        case ResourceState::ColorAttachment: return rhi::TextureUsage::ColorAttachment;
+        case ResourceState::DepthAttachment: return rhi::TextureUsage::DepthStencilAttachment;
+        case ResourceState::ShaderRead:      return rhi::TextureUsage::Sampled;
+        case ResourceState::StorageWrite:    return rhi::TextureUsage::Storage;
+        case ResourceState::TransferWrite:   return rhi::TextureUsage::TransferDst;
+        case ResourceState::TransferRead:    return rhi::TextureUsage::TransferSrc;
+        case ResourceState::ShadingRate:     return rhi::TextureUsage::ShadingRate;
+        default:                             return static_cast<rhi::TextureUsage>(0);
+    }
+}
+
+// Pooled textures are shared by descriptions that match except for the debug name
+static bool IsSameTexture(const rhi::TextureDesc& a, const rhi::TextureDesc& b) {
+    return a.type == b.type && a.width == b.width && a.height == b.height && a.depth == b.depth &&
+           a.mipLevels == b.mipLevels && a.arrayLayers == b.arrayLayers && a.format == b.format &&
+           a.usage == b.usage && a.generateMipmaps == b.generateMipmaps && a.sampleCount == b.sampleCount;
+}
+
+RenderGraph::RenderGraph(Ref<rhi::GraphicsDevice> device)
+    : m_Device(std::move(device)), m_ResourceGroup(m_Device->CreateResourceGroup()) {}
+
+RenderGraph::~RenderGraph() = default;
+
+void RenderGraph::PassBuilder::Read(RenderGraphResource resource, ResourceState state) {
+    Access(resource, state, false);
+}
+
+void RenderGraph::PassBuilder::Write(RenderGraphResource resource, ResourceState state) {
+    Access(resource, state, true);
+}
+
+void RenderGraph::PassBuilder::SetSideEffects() {
+    m_Graph.m_Passes[m_Pass].sideEffects = true;
+}
+
+void RenderGraph::PassBuilder::Access(RenderGraphResource resource, ResourceState state, bool write) {
+    if (!resource.IsValid()) {
+        return;
+    }
+    if (resource.index >= m_Graph.m_Resources.size()) {
+        METAGFX_WARN << "Render graph pass '" << m_Graph.m_Passes[m_Pass].name << "' uses an invalid resource";
+        return;
+    }
+
+    std::pmr::vector<ResourceAccess>& accesses = m_Graph.m_Passes[m_Pass].accesses;
+    for (ResourceAccess& access : accesses) {
+        if (access.resource == resource.index) {
+            if (write || !access.write) {
+                access.state = state;
+            }
+            access.write = access.write || write;
+            return;
+        }
+    }
+    accesses.push_back({ resource.index, state, write });
+}
+
+RenderGraphResource RenderGraph::ImportTexture(const char* name, Ref<rhi::Texture> texture,
+                                               ResourceState initialState, ResourceState finalState) {
+    Resource resource;
+    resource.name = name;
+    resource.texture = std::move(texture);
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+    m_Resources.push_back(std::move(resource));
+    m_Compiled = false;
+    return { static_cast<uint32>(m_Resources.size() - 1) };
+}
+
+RenderGraphResource RenderGraph::ImportBuffer(const char* name, Ref<rhi::Buffer> buffer,
+                                              ResourceState initialState, ResourceState finalState) {
+    Resource resource;
+    resource.name = name;
+    resource.buffer = std::move(buffer);
+    resource.initialState = initialState;
+    resource.finalState = finalState;
+    m_Resources.push_back(std::move(resource));
+    m_Compiled = false;
+    return { static_cast<uint32>(m_Resources.size() - 1) };
+}
+
+RenderGraphResource RenderGraph::CreateTexture(const char* name, const rhi::TextureDesc& desc) {
+    Resource resource;
+    resource.name = name;
+    resource.created = true;
+    resource.desc = desc;
+    m_Resources.push_back(std::move(resource));
+    m_Compiled = false;
+    return { static_cast<uint32>(m_Resources.size() - 1) };
+}
+
+Ref<rhi::Texture> RenderGraph::GetTexture(RenderGraphResource resource) const {
+    if (!resource.IsValid() || resource.index >= m_Resources.size()) {
+        return nullptr;
+    }
+    return m_Resources[resource.index].texture;
+}
+
+rhi::StoreOp RenderGraph::GetStoreOp(RenderGraphResource resource) const {
+    if (!resource.IsValid() || resource.index >= m_Resources.size()) {
+        return rhi::StoreOp::Store;
+    }
+    const Resource& target = m_Resources[resource.index];
+    bool lastUse = target.created && !target.output && target.lastPass == m_ExecutingPass;
+    return lastUse ? rhi::StoreOp::DontCare : rhi::StoreOp::Store;
+}
+
+void RenderGraph::AddPass(const char* name, const SetupFunction& setup, ExecuteFunction execute) {
+    Pass pass{ name, std::pmr::vector<ResourceAccess>(&m_Arena), std::move(execute) };
+    m_Passes.push_back(std::move(pass));
+    m_Compiled = false;
+
+    PassBuilder builder(*this, static_cast<uint32>(m_Passes.size() - 1));
+    setup(builder);
+}
+
+void RenderGraph::AddAsyncComputePass(const char* name, const SetupFunction& setup, ExecuteFunction execute) {
+    AddPass(name, setup, std::move(execute));
+    m_Passes.back().asyncCompute = true;
+}
+
+void RenderGraph::SetAsyncComputeEnabled(bool enabled) {
+    if (m_AsyncComputeEnabled != enabled) {
+        m_AsyncComputeEnabled = enabled;
+        m_Compiled = false;
+    }
+}
+
+void RenderGraph::MarkOutput(RenderGraphResource resource) {
+    if (resource.IsValid() && resource.index < m_Resources.size()) {
+        m_Resources[resource.index].output = true;
+        m_Compiled = false;
+    }
+}
+
+void RenderGraph::ScheduleAsyncPasses(std::pmr::vector<bool>& asyncResources) {
+    m_AsyncPassCount = 0;
+    m_AsyncWaitPass = NO_WAIT;
+    bool enabled = m_AsyncComputeEnabled && m_Device->GetDeviceInfo().supportsAsyncCompute;
+
+    // A pass is async when no surviving graphics pass before it touched its resources
+    std::pmr::vector<bool> graphicsResources(m_Resources.size(), false, &m_Arena);
+    for (Pass& pass : m_Passes) {
+        pass.async = false;
+        if (pass.culled) {
+            continue;
+        }
+        if (enabled && pass.asyncCompute) {
+            pass.async = true;
+            for (const ResourceAccess& access : pass.accesses) {
+                pass.async = pass.async && !graphicsResources[access.resource];
+            }
+        }
+        for (const ResourceAccess& access : pass.accesses) {
+            (pass.async ? asyncResources : graphicsResources)[access.resource] = true;
+        }
+        if (pass.async) {
+            ++m_AsyncPassCount;
+        }
+    }
+    if (m_AsyncPassCount == 0) {
+        return;
+    }
+
+    // The first graphics pass after them that touches their resources waits
+    for (uint32 p = 0; p < static_cast<uint32>(m_Passes.size()) && m_AsyncWaitPass == NO_WAIT; ++p) {
+        if (m_Passes[p].culled || m_Passes[p].async) {
+            continue;
+        }
+        for (const ResourceAccess& access : m_Passes[p].accesses) {
+            if (asyncResources[access.resource]) {
+                m_AsyncWaitPass = p;
+                break;
+            }
+        }
+    }
+    if (m_AsyncWaitPass == NO_WAIT) {
+        for (size_t r = 0; r < m_Resources.size(); ++r) {
+            if (asyncResources[r] && m_Resources[r].finalState != ResourceState::Undefined) {
+                m_AsyncWaitPass = static_cast<uint32>(m_Passes.size());
+                break;
+            }
+        }
+    }
+}
+
+void RenderGraph::AllocateTextures(std::pmr::vector<int32>& poolIndices, const std::pmr::vector<bool>& asyncResources) {
+    using rhi::TextureUsage;
+
+    ++m_FrameNumber;
+    m_CreatedTextureCount = 0;
+    m_MemorylessTextureCount = 0;
+
+    // Pooled textures no frame in flight uses any more are released
+    uint32 framesInFlight = m_Device->GetDeviceInfo().framesInFlight;
+    for (size_t i = m_TexturePool.size(); i-- > 0; ) {
+        if (m_FrameNumber - m_TexturePool[i].lastUsedFrame > framesInFlight) {
+            m_TexturePool.erase(m_TexturePool.begin() + i);
+        }
+    }
+    for (PooledTexture& pooled : m_TexturePool) {
+        pooled.freeFromPass = 0;
+    }
+
+    // Lifetime and usages of each created texture over the surviving passes, in the
+    // order of their first pass
+    struct Lifetime {
+        uint32 resource;
+        uint32 firstPass;
+        uint32 lastPass;
+        uint32 passCount;
+        bool attachmentOnly;
+        uint32 usage;
+    };
+    std::pmr::vector<Lifetime> lifetimes(&m_Arena);
+    std::pmr::vector<int32> lifetimeIndices(m_Resources.size(), -1, &m_Arena);
+    for (uint32 p = 0; p < static_cast<uint32>(m_Passes.size()); ++p) {
+        if (m_Passes[p].culled) {
+            continue;
+        }
+        for (const ResourceAccess& access : m_Passes[p].accesses) {
+            if (!m_Resources[access.resource].created) {
+                continue;
+            }
+            int32& index = lifetimeIndices[access.resource];
+            if (index < 0) {
+                index = static_cast<int32>(lifetimes.size());
+                lifetimes.push_back({ access.resource, p, p, 0, true,
+                                      static_cast<uint32>(m_Resources[access.resource].desc.usage) });
+            }
+            Lifetime& lifetime = lifetimes[index];
+            lifetime.lastPass = p;
+            ++lifetime.passCount;  // Accesses are merged per pass
+            lifetime.attachmentOnly = lifetime.attachmentOnly && IsAttachmentState(access.state);
+            lifetime.usage |= static_cast<uint32>(GetStateUsage(access.state));
+        }
+    }
+
+    // Async passes overlap the graphics passes before their wait: their textures are
+    // held over the whole frame
+    for (Lifetime& lifetime : lifetimes) {
+        if (asyncResources[lifetime.resource]) {
+            lifetime.firstPass = 0;
+            lifetime.lastPass = static_cast<uint32>(m_Passes.size() - 1);
+        }
+    }
+
+    // First fit: a pooled texture of the same description that is free by the first
+    // pass, else a new one
+    bool memoryless = m_Device->GetDeviceInfo().supportsMemorylessAttachments;
+    for (const Lifetime& lifetime : lifetimes) {
+        Resource& resource = m_Resources[lifetime.resource];
+        rhi::TextureDesc desc = resource.desc;
+        desc.usage = static_cast<TextureUsage>(lifetime.usage);
+        bool transient = lifetime.passCount == 1 && lifetime.attachmentOnly;
+        if (transient) {
+            desc.usage = desc.usage | TextureUsage::Transient;
+        }
+        if (!desc.debugName) {
+            desc.debugName = resource.name;
+        }
+
+        int32 poolIndex = -1;
+        for (size_t i = 0; i < m_TexturePool.size(); ++i) {
+            if (m_TexturePool[i].freeFromPass <= lifetime.firstPass && IsSameTexture(m_TexturePool[i].desc, desc)) {
+                poolIndex = static_cast<int32>(i);
+                break;
+            }
+        }
+        if (poolIndex < 0) {
+            rhi::ResourceGroupScope groupScope(m_ResourceGroup);
+            Ref<rhi::Texture> texture = m_Device->CreateTexture(desc);
+            if (!texture) {
+                METAGFX_ERROR << "Render graph: failed to create texture '" << resource.name << "'";
+                continue;
+            }
+            PooledTexture pooled;
+            pooled.desc = desc;
+            pooled.texture = std::move(texture);
+            m_TexturePool.push_back(std::move(pooled));
+            poolIndex = static_cast<int32>(m_TexturePool.size() - 1);
+        }
+
+        PooledTexture& pooled = m_TexturePool[poolIndex];
+        pooled.freeFromPass = lifetime.lastPass + 1;
+        pooled.lastUsedFrame = m_FrameNumber;
+        resource.texture = pooled.texture;
+        resource.lastPass = lifetime.lastPass;
+        poolIndices[lifetime.resource] = poolIndex;
+        ++m_CreatedTextureCount;
+        if (transient && memoryless) {
+            ++m_MemorylessTextureCount;
+        }
+    }
+}
+
+void RenderGraph::AddBarrier(uint32 resource, ResourceState before, ResourceState after) {
+    const Resource& target = m_Resources[resource];
+    if (target.texture) {
+        m_TextureBarriers.push_back({ target.texture, before, after });
+    } else if (target.buffer) {
+        m_BufferBarriers.push_back({ target.buffer, before, after });
+    }
+}
+
+void RenderGraph::Compile() {
+    m_TextureBarriers.clear();
+    m_BufferBarriers.clear();
+    m_CulledPassCount = 0;
+    m_BarrierCount = 0;
+
+    // Cull back to front: a pass is needed when it writes something needed, and then
+    // everything it reads is needed too. Writes do not end the need, as a write may
+    // cover only part of a resource (or load it as an attachment).
+    std::pmr::vector<bool> needed(m_Resources.size(), false, &m_Arena);
+    for (size_t r = 0; r < m_Resources.size(); ++r) {
+        needed[r] = m_Resources[r].output;
+    }
+    for (size_t p = m_Passes.size(); p-- > 0; ) {
+        Pass& pass = m_Passes[p];
+        bool live = pass.sideEffects;
+        for (const ResourceAccess& access : pass.accesses) {
+            live = live || (access.write && needed[access.resource]);
+        }
+        pass.culled = !live;
+        if (!live) {
+            ++m_CulledPassCount;
+            continue;
+        }
+        for (const ResourceAccess& access : pass.accesses) {
+            if (!access.write) {
+                needed[access.resource] = true;
+            }
+        }
+    }
+
+    std::pmr::vector<bool> asyncResources(m_Resources.size(), false, &m_Arena);
+    ScheduleAsyncPasses(asyncResources);
+
+    std::pmr::vector<int32> poolIndices(m_Resources.size(), -1, &m_Arena);
+    AllocateTextures(poolIndices, asyncResources);
+
+    // Walk the surviving passes with the state of every resource. Created textures are
+    // in the state of their pooled texture, which carries it to the next texture that
+    // aliases it, this frame or a later one.
+    std::pmr::vector<ResourceState> states(m_Resources.size(), ResourceState::Undefined, &m_Arena);
+    for (size_t r = 0; r < m_Resources.size(); ++r) {
+        states[r] = m_Resources[r].initialState;
+    }
+    auto stateOf = [&](uint32 resource) -> ResourceState& {
+        return poolIndices[resource] >= 0 ? m_TexturePool[poolIndices[resource]].state : states[resource];
+    };
+    auto beginBatch = [this](BarrierBatch& batch) {
+        batch.firstTexture = static_cast<uint32>(m_TextureBarriers.size());
+        batch.firstBuffer = static_cast<uint32>(m_BufferBarriers.size());
+    };
+    auto endBatch = [this](BarrierBatch& batch) {
+        batch.textureCount = static_cast<uint32>(m_TextureBarriers.size()) - batch.firstTexture;
+        batch.bufferCount = static_cast<uint32>(m_BufferBarriers.size()) - batch.firstBuffer;
+        if (batch.textureCount + batch.bufferCount > 0) {
+            ++m_BarrierCount;
+        }
+    };
+
+    // In recording order: the async passes first
+    auto planPass = [&](Pass& pass) {
+        beginBatch(pass.barriers);
+        for (const ResourceAccess& access : pass.accesses) {
+            ResourceState& state = stateOf(access.resource);
+            if (IsAttachmentState(access.state)) {
+                // BeginRendering() transitions attachments; EndRendering() leaves color
+                // attachments ready to present
+                state = access.state == ResourceState::ColorAttachment ? ResourceState::Present : access.state;
+                continue;
+            }
+            if (state != access.state || IsWriteState(access.state)) {
+                AddBarrier(access.resource, state, access.state);
+            }
+            state = access.state;
+        }
+        endBatch(pass.barriers);
+    };
+    for (Pass& pass : m_Passes) {
+        pass.barriers = {};
+        if (!pass.culled && pass.async) {
+            planPass(pass);
+        }
+    }
+    for (Pass& pass : m_Passes) {
+        if (!pass.culled && !pass.async) {
+            planPass(pass);
+        }
+    }
+
+    beginBatch(m_FinalBarriers);
+    for (size_t r = 0; r < m_Resources.size(); ++r) {
+        ResourceState finalState = m_Resources[r].finalState;
+        if (finalState != ResourceState::Undefined && states[r] != finalState) {
+            AddBarrier(static_cast<uint32>(r), states[r], finalState);
+        }
+    }
+    endBatch(m_FinalBarriers);
+
+    m_TransitionCount = static_cast<uint32>(m_TextureBarriers.size() + m_BufferBarriers.size());
+    m_Compiled = true;
+}
+
+void RenderGraph::RecordBarriers(rhi::CommandBuffer& cmd, const BarrierBatch& batch) const {
+    if (batch.textureCount + batch.bufferCount == 0) {
+        return;
+    }
+    cmd.ResourceBarrier(m_TextureBarriers.data() + batch.firstTexture, batch.textureCount,
+                        m_BufferBarriers.data() + batch.firstBuffer, batch.bufferCount);
+}
+
+void RenderGraph::Execute(rhi::CommandBuffer& cmd, rhi::CommandBuffer* computeCmd) {
+    if (!m_Compiled) {
+        Compile();
+    }
+
+    rhi::CommandBuffer& asyncCmd = computeCmd ? *computeCmd : cmd;
+    for (const Pass& pass : m_Passes) {
+        if (pass.culled || !pass.async) {
+            continue;
+        }
+        RecordBarriers(asyncCmd, pass.barriers);
+        rhi::GpuZoneScope zone(asyncCmd, pass.name);
+        pass.execute(asyncCmd);
+    }
+
+    bool wait = computeCmd && m_AsyncPassCount > 0;
+    for (uint32 p = 0; p < static_cast<uint32>(m_Passes.size()); ++p) {
+        const Pass& pass = m_Passes[p];
+        if (pass.culled || pass.async) {
+            continue;
+        }
+        if (wait && p == m_AsyncWaitPass) {
+            cmd.WaitForAsyncCompute();
+        }
+        RecordBarriers(cmd, pass.barriers);
+        rhi::GpuZoneScope zone(cmd, pass.name);
+        m_ExecutingPass = p;
+        pass.execute(cmd);
+    }
+    m_ExecutingPass = ~0u;
+    if (wait && m_AsyncWaitPass == m_Passes.size()) {
+        cmd.WaitForAsyncCompute();
+    }
+    RecordBarriers(cmd, m_FinalBarriers);
+}
+
+void RenderGraph::Reset() {
+    m_Resources.clear();
+    m_Passes.clear();
+    m_TextureBarriers.clear();  // Release the textures and buffers they hold
+    m_BufferBarriers.clear();
+    m_Arena.Reset();  // After the passes, whose accesses it held
+    m_Compiled = false;
+}
+
+void RenderGraph::ReleaseTextures() {
+    Reset();
+    m_TexturePool.clear();
+}
+
+} // namespace metagfx
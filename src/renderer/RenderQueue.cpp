@@ -0,0 +1,71 @@
+// ============================================================================
+// src/renderer/RenderQueue.cpp
+// ============================================================================
+#include "metagfx/renderer/RenderQueue.h"
+
+#include <cstring>
+
+namespace metagfx {
+
+uint64 RenderQueue::MakeSortKey(uint32 pipeline, uint32 material, float depth, bool translucent) {
+    // NaN fails the comparison as well
+    if (!(depth > 0.0f)) {
+        depth = 0.0f;
+    }
+    uint32 depthBits;
+    std::memcpy(&depthBits, &depth, sizeof(depthBits));
+
+    uint64 pipelineBits = pipeline & (MAX_PIPELINES - 1);
+    uint64 materialBits = material & (MAX_MATERIALS - 1);
+    if (translucent) {
+        return (1ull << 63) | (static_cast<uint64>(~depthBits) << 31) | (pipelineBits << 24) | materialBits;
+    }
+    return (pipelineBits << 56) | (materialBits << 32) | depthBits;
+}
+
+void RenderQueue::Add(uint32 pipeline, uint32 material, float depth, uint32 draw, bool translucent) {
+    DrawPacket packet;
+    packet.sortKey = MakeSortKey(pipeline, material, depth, translucent);
+    packet.pipeline = pipeline;
+    packet.material = material;
+    packet.draw = draw;
+    m_Packets.push_back(packet);
+}
+
+void RenderQueue::Sort() {
+    size_t count = m_Packets.size();
+    if (count < 2) {
+        return;
+    }
+
+    // Histograms of all eight key bytes in one pass
+    uint32 histograms[8][256] = {};
+    for (const DrawPacket& packet : m_Packets) {
+        for (uint32 byte = 0; byte < 8; ++byte) {
+            ++histograms[byte][(packet.sortKey >> (byte * 8)) & 0xFF];
+        }
+    }
+
+    m_Scratch.resize(count);
+    for (uint32 byte = 0; byte < 8; ++byte) {
+        uint32* histogram = histograms[byte];
+
+        // All packets share this byte: the pass would not move anything
+        if (histogram[(m_Packets[0].sortKey >> (byte * 8)) & 0xFF] == count) {
+            continue;
+        }
+
+        uint32 offset = 0;
+        for (uint32 bucket = 0; bucket < 256; ++bucket) {
+            uint32 bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (const DrawPacket& packet : m_Packets) {
+            m_Scratch[histogram[(packet.sortKey >> (byte * 8)) & 0xFF]++] = packet;
+        }
+        m_Packets.swap(m_Scratch);
+    }
+}
+
+} // namespace metagfx
@@ -0,0 +1,67 @@
+// ============================================================================
+// src/renderer/VisibilityBufferRenderer.cpp
+// ============================================================================
+#include "metagfx/renderer/VisibilityBufferRenderer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/Camera.h"
+#include "metagfx/scene/VisibilityBuffer.h"
+
+namespace metagfx {
+
+VisibilityBufferRenderer::VisibilityBufferRenderer(Ref<rhi::GraphicsDevice> device)
+    : DeferredRenderer(device) {
+}
+
+// =============================================================================
+// Visibility and resolve passes in place of the G-buffer pass
+// =============================================================================
+void VisibilityBufferRenderer::RenderGBufferPass(const ModelPassPlan& plan, RenderGraphResource gbuffer) {
+    using namespace rhi;
+
+    // The visibility commands are the culler's, and only the content can draw them
+    VisibilityBuffer* visibilityBuffer = m_Frame.visibilityBuffer;
+    if (!visibilityBuffer || !visibilityBuffer->IsValid() || !m_GPUCulling || !m_Frame.content) {
+        DeferredRenderer::RenderGBufferPass(plan, gbuffer);
+        return;
+    }
+
+    TextureDesc visibilityDesc{};
+    visibilityDesc.width = m_RenderWidth;
+    visibilityDesc.height = m_RenderHeight;
+    visibilityDesc.format = VisibilityBuffer::VISIBILITY_FORMAT;
+    visibilityDesc.debugName = "Visibility";
+    RenderGraphResource visibility = m_RenderGraph->CreateTexture("Visibility", visibilityDesc);
+
+    m_RenderGraph->AddPass("Visibility pass", [this, visibility](RenderGraph::PassBuilder& pass) {
+        pass.Write(visibility, ResourceState::ColorAttachment);
+        pass.Write(m_Resources.depth, ResourceState::DepthAttachment);
+        pass.Read(m_Resources.cameraDraws, ResourceState::IndirectArgument);
+    }, [this, plan, visibility](CommandBuffer& passCmd) {
+        // The clears: EMPTY, and the far plane
+        ClearValue clearValues[2] = {};
+        clearValues[1].depthStencil.depth = Camera::FAR_DEPTH;
+        clearValues[1].depthStencil.stencil = 0;
+
+        const Ref<Texture> colorAttachments[] = { m_RenderGraph->GetTexture(visibility) };
+        RenderPassActions actions;
+        actions.depthStore = m_RenderGraph->GetStoreOp(m_Resources.depth);
+        passCmd.BeginRendering(colorAttachments, m_RenderGraph->GetTexture(m_Resources.depth), clearValues, actions);
+        SetFullViewport(passCmd);
+        if (plan.drawModel) {
+            m_Frame.content->RecordVisibilityDraws(passCmd, m_MainDrawList, plan.packetCount);
+        }
+        passCmd.EndRendering();
+    });
+
+    m_RenderGraph->AddPass("Visibility resolve", [visibility, gbuffer](RenderGraph::PassBuilder& pass) {
+        pass.Read(visibility, ResourceState::ShaderRead);
+        pass.Write(gbuffer, ResourceState::StorageWrite);
+    }, [this, visibility, gbuffer](CommandBuffer& passCmd) {
+        VisibilityBuffer* visibilityBuffer = m_Frame.visibilityBuffer;
+        visibilityBuffer->SetTargets(m_RenderGraph->GetTexture(visibility), m_RenderGraph->GetTexture(gbuffer));
+        visibilityBuffer->Resolve(passCmd, m_Frame.frameIndex, m_Frame.modelUniformOffset);
+    });
+}
+
+} // namespace metagfx
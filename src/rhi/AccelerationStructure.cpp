@@ -0,0 +1,21 @@
+// ============================================================================
+// src/rhi/AccelerationStructure.cpp
+// ============================================================================
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "metagfx/rhi/CommandBuffer.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Devices without acceleration structures never create any, so there is nothing to build
+void CommandBuffer::BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds) {
+    (void)builds;
+}
+
+Ref<AccelerationStructure> CommandBuffer::CompactAccelerationStructure(const Ref<AccelerationStructure>& source) {
+    (void)source;
+    return nullptr;
+}
+
+} // namespace rhi
+} // namespace metagfx
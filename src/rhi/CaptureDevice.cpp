@@ -0,0 +1,1213 @@
+// ============================================================================
+// src/rhi/CaptureDevice.cpp - RHI Command Stream Capture
+// ============================================================================
+#include "metagfx/rhi/CaptureDevice.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/Framebuffer.h"
+#include "metagfx/rhi/GpuProfiler.h"
+#include "metagfx/rhi/Pipeline.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Shader.h"
+#include "metagfx/rhi/SwapChain.h"
+#include "metagfx/rhi/Texture.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+// Granularity at which writes to mapped buffers are found
+constexpr uint64 SHADOW_BLOCK_SIZE = 256;
+
+class CaptureBuffer;
+
+// The trace file, shared by the device and every object it created, which may outlive it
+class CaptureContext {
+public:
+    bool Open(const CaptureSettings& settings, const DeviceInfo& info, SwapChain* swapChain) {
+        m_File.open(settings.path, std::ios::binary | std::ios::trunc);
+        if (!m_File.is_open()) {
+            return false;
+        }
+        m_Path = settings.path;
+        m_FrameLimit = settings.frameCount;
+
+        TraceWriter header;
+        header.Write(TRACE_MAGIC);
+        header.Write(TRACE_VERSION);
+        header.Write(uint32(0));  // Frame count, at TRACE_FRAME_COUNT_OFFSET
+        header.Write(info.api);
+        header.Write(info.framesInFlight);
+        header.Write(swapChain ? swapChain->GetWidth() : 0u);
+        header.Write(swapChain ? swapChain->GetHeight() : 0u);
+        header.Write(swapChain ? swapChain->GetFormat() : Format::Undefined);
+        header.Write(swapChain ? swapChain->GetPresentMode() : PresentMode::Fifo);
+        header.WriteString(info.deviceName);
+        std::vector<const char*> features = GetFeatureNames(info);
+        header.Write(static_cast<uint32>(features.size()));
+        for (const char* feature : features) {
+            header.WriteString(feature);
+        }
+        m_File.write(reinterpret_cast<const char*>(header.GetBytes().data()),
+                     static_cast<std::streamsize>(header.GetBytes().size()));
+        m_Recording.store(m_File.good(), std::memory_order_release);
+        return m_File.good();
+    }
+
+    // Writes the frame count and closes the file; later records are dropped
+    void Close() {
+        std::lock_guard<std::mutex> lock(m_FileMutex);
+        if (!m_File.is_open()) {
+            return;
+        }
+        m_Recording.store(false, std::memory_order_release);
+        m_File.seekp(static_cast<std::streamoff>(TRACE_FRAME_COUNT_OFFSET));
+        m_File.write(reinterpret_cast<const char*>(&m_Frames), sizeof(m_Frames));
+        m_File.close();
+        METAGFX_INFO << "Captured " << m_Frames << " frames to " << m_Path;
+    }
+
+    bool IsRecording() const { return m_Recording.load(std::memory_order_acquire); }
+    uint32 NextId() { return m_NextId.fetch_add(1, std::memory_order_relaxed); }
+
+    // One record whose payload fill writes
+    template <typename Fill>
+    void Record(TraceOp op, Fill&& fill) {
+        if (!IsRecording()) {
+            return;
+        }
+        TraceWriter writer;
+        size_t record = writer.BeginRecord(op);
+        fill(writer);
+        writer.EndRecord(record);
+        Write(writer);
+    }
+    void Record(TraceOp op) {
+        Record(op, [](TraceWriter&) {});
+    }
+
+    void Write(const TraceWriter& writer) {
+        std::lock_guard<std::mutex> lock(m_FileMutex);
+        if (m_File.is_open()) {
+            m_File.write(reinterpret_cast<const char*>(writer.GetBytes().data()),
+                         static_cast<std::streamsize>(writer.GetBytes().size()));
+        }
+    }
+
+    // A Present was recorded; closes the trace at the frame limit
+    void EndFrame() {
+        bool limitReached = false;
+        {
+            std::lock_guard<std::mutex> lock(m_FileMutex);
+            if (!m_File.is_open()) {
+                return;
+            }
+            ++m_Frames;
+            limitReached = m_FrameLimit > 0 && m_Frames >= m_FrameLimit;
+        }
+        if (limitReached) {
+            Close();
+        }
+    }
+
+    // Buffers the CPU writes through a pointer, compared with their copies at each submit
+    void AddMappedBuffer(CaptureBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(m_MappedMutex);
+        if (std::find(m_MappedBuffers.begin(), m_MappedBuffers.end(), buffer) == m_MappedBuffers.end()) {
+            m_MappedBuffers.push_back(buffer);
+        }
+    }
+    void RemoveMappedBuffer(CaptureBuffer* buffer) {
+        std::lock_guard<std::mutex> lock(m_MappedMutex);
+        m_MappedBuffers.erase(std::remove(m_MappedBuffers.begin(), m_MappedBuffers.end(), buffer),
+                              m_MappedBuffers.end());
+    }
+    void FlushMappedBuffers();
+
+private:
+    std::mutex m_FileMutex;
+    std::ofstream m_File;
+    std::string m_Path;
+    uint32 m_Frames = 0;
+    uint32 m_FrameLimit = 0;
+    std::atomic<bool> m_Recording{false};
+    std::atomic<uint32> m_NextId{1};  // 0 is null
+
+    std::mutex m_MappedMutex;  // Taken before m_FileMutex
+    std::vector<CaptureBuffer*> m_MappedBuffers;
+};
+
+// An object of the wrapped device, named in the trace by its ID. The Destroy record is
+// written when the last reference goes, which deferred destruction
+// (GraphicsDevice::Retire()) puts after the GPU's last use.
+template <typename T>
+class Captured : public T {
+public:
+    ~Captured() override {
+        if (m_Id != 0) {
+            m_Context->Record(TraceOp::Destroy, [this](TraceWriter& writer) {
+                writer.Write(m_Type);
+                writer.Write(m_Id);
+            });
+        }
+    }
+
+    uint32 GetId() const { return m_Id; }
+    const Ref<T>& GetInner() const { return m_Inner; }
+
+protected:
+    Captured(Ref<CaptureContext> context, Ref<T> inner, uint32 id, TraceObject type)
+        : m_Context(std::move(context))
+        , m_Inner(std::move(inner))
+        , m_Id(id)
+        , m_Type(type) {}
+
+    Ref<CaptureContext> m_Context;
+    Ref<T> m_Inner;
+    uint32 m_Id = 0;  // 0: not in the trace (secondary command buffers)
+    TraceObject m_Type;
+};
+
+template <typename T>
+uint32 IdOf(const Ref<T>& object) {
+    return object ? static_cast<const Captured<T>*>(object.get())->GetId() : 0;
+}
+
+template <typename T>
+Ref<T> Unwrap(const Ref<T>& object) {
+    return object ? static_cast<const Captured<T>*>(object.get())->GetInner() : nullptr;
+}
+
+template <typename T>
+void WriteIds(TraceWriter& writer, std::span<const Ref<T>> objects) {
+    writer.Write(static_cast<uint32>(objects.size()));
+    for (const Ref<T>& object : objects) {
+        writer.Write(IdOf(object));
+    }
+}
+
+template <typename T>
+std::vector<Ref<T>> UnwrapAll(std::span<const Ref<T>> objects) {
+    std::vector<Ref<T>> inner;
+    inner.reserve(objects.size());
+    for (const Ref<T>& object : objects) {
+        inner.push_back(Unwrap(object));
+    }
+    return inner;
+}
+
+// Acceleration structures are not captured; their bindings go out empty
+void WriteBinding(TraceWriter& writer, const DescriptorBindingDesc& binding) {
+    writer.Write(binding.binding);
+    writer.Write(binding.type);
+    writer.Write(binding.stageFlags);
+    writer.Write(IdOf(binding.buffer));
+    writer.Write(IdOf(binding.texture));
+    writer.Write(IdOf(binding.sampler));
+    writer.Write(binding.range);
+    writer.Write(binding.count);
+}
+
+DescriptorBindingDesc UnwrapBinding(const DescriptorBindingDesc& binding) {
+    DescriptorBindingDesc inner = binding;
+    inner.buffer = Unwrap(binding.buffer);
+    inner.texture = Unwrap(binding.texture);
+    inner.sampler = Unwrap(binding.sampler);
+    return inner;
+}
+
+void WriteAttributes(TraceWriter& writer, const std::vector<VertexAttribute>& attributes) {
+    writer.Write(static_cast<uint32>(attributes.size()));
+    for (const VertexAttribute& attribute : attributes) {
+        writer.Write(attribute);
+    }
+}
+
+template <typename T>
+void WriteVector(TraceWriter& writer, const std::vector<T>& values) {
+    writer.Write(static_cast<uint32>(values.size()));
+    for (const T& value : values) {
+        writer.Write(value);
+    }
+}
+
+void WriteDynamicOffsets(TraceWriter& writer, const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    writer.Write(dynamicOffsets ? dynamicOffsetCount : 0u);
+    if (dynamicOffsets && dynamicOffsetCount > 0) {
+        writer.WriteBytes(dynamicOffsets, dynamicOffsetCount * sizeof(uint32));
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Resources
+// ----------------------------------------------------------------------------
+
+class CaptureBuffer final : public Captured<Buffer> {
+public:
+    CaptureBuffer(Ref<CaptureContext> context, Ref<Buffer> inner, uint32 id, const BufferDesc& desc)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Buffer)
+        , m_Readback(desc.memoryUsage == MemoryUsage::GPUToCPU) {}
+
+    ~CaptureBuffer() override {
+        if (m_Tracked) {
+            m_Context->RemoveMappedBuffer(this);
+        }
+    }
+
+    void* Map() override {
+        void* data = m_Inner->Map();
+        {
+            std::lock_guard<std::mutex> lock(m_ShadowMutex);
+            m_Mapped = static_cast<uint8*>(data);
+        }
+        Track(data);
+        return data;
+    }
+
+    void Unmap() override {
+        bool untrack = false;
+        {
+            std::lock_guard<std::mutex> lock(m_ShadowMutex);
+            if (m_Mapped && !m_Readback) {
+                RecordWrites(m_Mapped);
+            }
+            m_Mapped = nullptr;
+            untrack = !m_Persistent;
+        }
+        if (untrack && m_Tracked.exchange(false)) {
+            m_Context->RemoveMappedBuffer(this);
+        }
+        m_Inner->Unmap();
+    }
+
+    void MapAsync(MapCallback callback) override { m_Inner->MapAsync(std::move(callback)); }
+
+    void CopyData(const void* data, uint64 size, uint64 offset) override {
+        RecordData(data, size, offset);
+        m_Inner->CopyData(data, size, offset);
+    }
+
+    void WriteData(uint64 size, uint64 offset, const WriteCallback& write) override {
+        // The bytes are taken from wherever the backend had them written
+        m_Inner->WriteData(size, offset, [&](void* data) {
+            write(data);
+            RecordData(data, size, offset);
+        });
+    }
+
+    void* GetMappedPointer() override {
+        void* data = m_Inner->GetMappedPointer();
+        if (data) {
+            {
+                std::lock_guard<std::mutex> lock(m_ShadowMutex);
+                m_Persistent = static_cast<uint8*>(data);
+            }
+            Track(data);
+        }
+        return data;
+    }
+
+    uint64 GetSize() const override { return m_Inner->GetSize(); }
+    BufferUsage GetUsage() const override { return m_Inner->GetUsage(); }
+    bool IsUploadComplete() const override { return m_Inner->IsUploadComplete(); }
+
+    // Records the blocks the CPU changed through its pointer since the last call; all of
+    // them the first time
+    void FlushWrites() {
+        std::lock_guard<std::mutex> lock(m_ShadowMutex);
+        if (uint8* data = m_Persistent ? m_Persistent : m_Mapped) {
+            RecordWrites(data);
+        }
+    }
+
+private:
+    // Not under m_ShadowMutex, which the context's flush takes after its own
+    void Track(void* data) {
+        if (data && !m_Readback && !m_Tracked.exchange(true)) {
+            m_Context->AddMappedBuffer(this);
+        }
+    }
+
+    void RecordData(const void* data, uint64 size, uint64 offset) {
+        m_Context->Record(TraceOp::BufferData, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(offset);
+            writer.WriteBlob(data, size);
+        });
+        // The bytes land in the mapped memory too, so they are not found again as a change
+        std::lock_guard<std::mutex> lock(m_ShadowMutex);
+        if (!m_Shadow.empty() && offset + size <= m_Shadow.size()) {
+            std::memcpy(m_Shadow.data() + offset, data, size);
+        }
+    }
+
+    // m_ShadowMutex held
+    void RecordWrites(const uint8* data) {
+        if (!m_Context->IsRecording()) {
+            return;
+        }
+        uint64 size = m_Inner->GetSize();
+        if (m_Shadow.size() != size) {
+            m_Shadow.assign(data, data + size);
+            m_Context->Record(TraceOp::BufferData, [&](TraceWriter& writer) {
+                writer.Write(m_Id);
+                writer.Write(uint64(0));
+                writer.WriteBlob(data, size);
+            });
+            return;
+        }
+        // Runs of changed blocks, one record each
+        for (uint64 block = 0; block < size;) {
+            uint64 blockSize = std::min(SHADOW_BLOCK_SIZE, size - block);
+            if (std::memcmp(m_Shadow.data() + block, data + block, blockSize) == 0) {
+                block += blockSize;
+                continue;
+            }
+            uint64 end = block + blockSize;
+            while (end < size) {
+                uint64 nextSize = std::min(SHADOW_BLOCK_SIZE, size - end);
+                if (std::memcmp(m_Shadow.data() + end, data + end, nextSize) == 0) {
+                    break;
+                }
+                end += nextSize;
+            }
+            std::memcpy(m_Shadow.data() + block, data + block, end - block);
+            m_Context->Record(TraceOp::BufferData, [&](TraceWriter& writer) {
+                writer.Write(m_Id);
+                writer.Write(block);
+                writer.WriteBlob(m_Shadow.data() + block, end - block);
+            });
+            block = end;
+        }
+    }
+
+    bool m_Readback = false;  // GPUToCPU: the CPU only reads it
+
+    std::mutex m_ShadowMutex;
+    uint8* m_Persistent = nullptr;  // GetMappedPointer()
+    uint8* m_Mapped = nullptr;      // Map() until Unmap()
+    std::atomic<bool> m_Tracked{false};  // In the context's mapped buffers
+    std::vector<uint8> m_Shadow;    // Contents as last recorded
+};
+
+void CaptureContext::FlushMappedBuffers() {
+    std::lock_guard<std::mutex> lock(m_MappedMutex);
+    for (CaptureBuffer* buffer : m_MappedBuffers) {
+        buffer->FlushWrites();
+    }
+}
+
+class CaptureTexture final : public Captured<Texture> {
+public:
+    CaptureTexture(Ref<CaptureContext> context, Ref<Texture> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Texture) {}
+
+    uint32 GetWidth() const override { return m_Inner->GetWidth(); }
+    uint32 GetHeight() const override { return m_Inner->GetHeight(); }
+    Format GetFormat() const override { return m_Inner->GetFormat(); }
+    uint32 GetMipLevels() const override { return m_Inner->GetMipLevels(); }
+    uint32 GetSampleCount() const override { return m_Inner->GetSampleCount(); }
+
+    void UploadData(const void* data, uint64 size) override {
+        m_Context->Record(TraceOp::TextureData, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(uint32(1));
+            writer.WriteBlob(data, size);
+        });
+        m_Inner->UploadData(data, size);
+    }
+
+    void UploadLevels(const TextureLevelData* levels, uint32 levelCount) override {
+        m_Context->Record(TraceOp::TextureData, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(levelCount);
+            for (uint32 i = 0; i < levelCount; ++i) {
+                writer.WriteBlob(levels[i].data, levels[i].size);
+            }
+        });
+        m_Inner->UploadLevels(levels, levelCount);
+    }
+
+    // LoadFromFile() keeps the default: the application reads and uploads the data
+    bool IsUploadComplete() const override { return m_Inner->IsUploadComplete(); }
+};
+
+class CaptureSampler final : public Captured<Sampler> {
+public:
+    CaptureSampler(Ref<CaptureContext> context, Ref<Sampler> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Sampler) {}
+};
+
+class CaptureShader final : public Captured<Shader> {
+public:
+    CaptureShader(Ref<CaptureContext> context, Ref<Shader> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Shader) {}
+
+    ShaderStage GetStage() const override { return m_Inner->GetStage(); }
+};
+
+class CapturePipeline final : public Captured<Pipeline> {
+public:
+    CapturePipeline(Ref<CaptureContext> context, Ref<Pipeline> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Pipeline) {}
+
+    PipelineBindPoint GetBindPoint() const override { return m_Inner->GetBindPoint(); }
+};
+
+class CaptureDescriptorSet final : public Captured<DescriptorSet> {
+public:
+    CaptureDescriptorSet(Ref<CaptureContext> context, Ref<DescriptorSet> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::DescriptorSet) {}
+
+    void UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) override {
+        m_Context->Record(TraceOp::UpdateBuffer, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(binding);
+            writer.Write(IdOf(buffer));
+        });
+        m_Inner->UpdateBuffer(binding, Unwrap(buffer));
+    }
+
+    void UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) override {
+        m_Context->Record(TraceOp::UpdateTexture, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(binding);
+            writer.Write(IdOf(texture));
+            writer.Write(IdOf(sampler));
+        });
+        m_Inner->UpdateTexture(binding, Unwrap(texture), Unwrap(sampler));
+    }
+
+    void UpdateTextureArrayElement(uint32 binding, uint32 arrayElement, const Ref<Texture>& texture,
+                                   const Ref<Sampler>& sampler) override {
+        m_Context->Record(TraceOp::UpdateTextureArrayElement, [&](TraceWriter& writer) {
+            writer.Write(m_Id);
+            writer.Write(binding);
+            writer.Write(arrayElement);
+            writer.Write(IdOf(texture));
+            writer.Write(IdOf(sampler));
+        });
+        m_Inner->UpdateTextureArrayElement(binding, arrayElement, Unwrap(texture), Unwrap(sampler));
+    }
+
+    void* GetNativeHandle(uint32 frameIndex) const override { return m_Inner->GetNativeHandle(frameIndex); }
+    void* GetNativeLayout() const override { return m_Inner->GetNativeLayout(); }
+};
+
+class CaptureFramebuffer final : public Captured<Framebuffer> {
+public:
+    CaptureFramebuffer(Ref<CaptureContext> context, Ref<Framebuffer> inner, uint32 id, const FramebufferDesc& desc)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::Framebuffer)
+        , m_Desc(desc) {}
+
+    uint32 GetWidth() const override { return m_Inner->GetWidth(); }
+    uint32 GetHeight() const override { return m_Inner->GetHeight(); }
+    Ref<Texture> GetDepthAttachment() const override { return m_Desc.depthAttachment; }
+    const std::vector<Ref<Texture>>& GetColorAttachments() const override { return m_Desc.colorAttachments; }
+
+private:
+    FramebufferDesc m_Desc;  // The wrapped textures
+};
+
+// ----------------------------------------------------------------------------
+// Command buffers
+// ----------------------------------------------------------------------------
+
+// Records into a stream of its own, on whichever thread records it; the device appends
+// the stream to the trace at submit, and a primary those of its secondaries as its
+// parallel render pass ends
+class CaptureCommandBuffer final : public Captured<CommandBuffer> {
+public:
+    CaptureCommandBuffer(Ref<CaptureContext> context, Ref<CommandBuffer> inner, uint32 id)
+        : Captured(std::move(context), std::move(inner), id, TraceObject::CommandBuffer) {}
+
+    // Takes the commands recorded since Begin()
+    void TakeCommands(TraceWriter& commands) {
+        commands = std::move(m_Commands);
+        m_Commands.Clear();
+    }
+
+    void Begin() override {
+        m_Commands.Clear();
+        Command(TraceOp::Begin);
+        m_Inner->Begin();
+        m_FilteredCallCount = 0;
+        m_Stats = FrameStats{};
+    }
+
+    void End() override {
+        Command(TraceOp::End);
+        m_Inner->End();
+        m_FilteredCallCount = m_Inner->GetFilteredCallCount();
+        m_Stats = m_Inner->GetStats();
+    }
+
+    void BeginRendering(std::span<const Ref<Texture>> colorAttachments, const Ref<Texture>& depthAttachment,
+                        std::span<const ClearValue> clearValues, const RenderPassActions& actions,
+                        std::span<const Ref<Texture>> resolveTargets, const Ref<Texture>& shadingRate) override {
+        Command(TraceOp::BeginRendering, [&](TraceWriter& writer) {
+            WritePass(writer, colorAttachments, depthAttachment, clearValues, actions, resolveTargets, shadingRate);
+        });
+        std::vector<Ref<Texture>> colors = UnwrapAll(colorAttachments);
+        std::vector<Ref<Texture>> resolves = UnwrapAll(resolveTargets);
+        m_Inner->BeginRendering(colors, Unwrap(depthAttachment), clearValues, actions, resolves,
+                                Unwrap(shadingRate));
+    }
+
+    void EndRendering() override {
+        Command(TraceOp::EndRendering);
+        m_Inner->EndRendering();
+    }
+
+    void BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments, const Ref<Texture>& depthAttachment,
+                                std::span<const ClearValue> clearValues, uint32 secondaryCount,
+                                const RenderPassActions& actions, std::span<const Ref<Texture>> resolveTargets,
+                                const Ref<Texture>& shadingRate) override {
+        Command(TraceOp::BeginParallelRendering, [&](TraceWriter& writer) {
+            WritePass(writer, colorAttachments, depthAttachment, clearValues, actions, resolveTargets, shadingRate);
+            writer.Write(secondaryCount);
+        });
+        std::vector<Ref<Texture>> colors = UnwrapAll(colorAttachments);
+        std::vector<Ref<Texture>> resolves = UnwrapAll(resolveTargets);
+        m_Inner->BeginParallelRendering(colors, Unwrap(depthAttachment), clearValues, secondaryCount, actions,
+                                        resolves, Unwrap(shadingRate));
+        // Wrapped up front: the secondaries are fetched from the recording threads
+        m_Secondaries.clear();
+        for (uint32 i = 0; i < secondaryCount; ++i) {
+            Ref<CommandBuffer> secondary = m_Inner->GetSecondaryCommandBuffer(i);
+            m_Secondaries.push_back(secondary ? CreateRef<CaptureCommandBuffer>(m_Context, secondary, 0) : nullptr);
+        }
+    }
+
+    Ref<CommandBuffer> GetSecondaryCommandBuffer(uint32 index) override {
+        return index < m_Secondaries.size() ? m_Secondaries[index] : nullptr;
+    }
+
+    void EndParallelRendering() override {
+        for (uint32 i = 0; i < m_Secondaries.size(); ++i) {
+            if (!m_Secondaries[i]) {
+                continue;
+            }
+            TraceWriter secondary;
+            m_Secondaries[i]->TakeCommands(secondary);
+            Command(TraceOp::Secondary, [&](TraceWriter& writer) {
+                writer.Write(i);
+                writer.WriteBlob(secondary.GetBytes().data(), secondary.GetBytes().size());
+            });
+        }
+        m_Secondaries.clear();
+        Command(TraceOp::EndParallelRendering);
+        m_Inner->EndParallelRendering();
+    }
+
+    void BindPipeline(const Ref<Pipeline>& pipeline) override {
+        Command(TraceOp::BindPipeline, [&](TraceWriter& writer) { writer.Write(IdOf(pipeline)); });
+        m_Inner->BindPipeline(Unwrap(pipeline));
+    }
+
+    void SetViewport(const Viewport& viewport) override {
+        Command(TraceOp::SetViewport, [&](TraceWriter& writer) { writer.Write(viewport); });
+        m_Inner->SetViewport(viewport);
+    }
+
+    void SetScissor(const Rect2D& scissor) override {
+        Command(TraceOp::SetScissor, [&](TraceWriter& writer) { writer.Write(scissor); });
+        m_Inner->SetScissor(scissor);
+    }
+
+    void BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset) override {
+        Command(TraceOp::BindVertexBuffer, [&](TraceWriter& writer) {
+            writer.Write(IdOf(buffer));
+            writer.Write(offset);
+        });
+        m_Inner->BindVertexBuffer(Unwrap(buffer), offset);
+    }
+
+    void BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset) override {
+        Command(TraceOp::BindIndexBuffer, [&](TraceWriter& writer) {
+            writer.Write(IdOf(buffer));
+            writer.Write(offset);
+        });
+        m_Inner->BindIndexBuffer(Unwrap(buffer), offset);
+    }
+
+    void Draw(uint32 vertexCount, uint32 instanceCount, uint32 firstVertex, uint32 firstInstance) override {
+        Command(TraceOp::Draw, [&](TraceWriter& writer) {
+            writer.Write(vertexCount);
+            writer.Write(instanceCount);
+            writer.Write(firstVertex);
+            writer.Write(firstInstance);
+        });
+        m_Inner->Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    }
+
+    void DrawIndexed(uint32 indexCount, uint32 instanceCount, uint32 firstIndex, int32 vertexOffset,
+                     uint32 firstInstance) override {
+        Command(TraceOp::DrawIndexed, [&](TraceWriter& writer) {
+            writer.Write(indexCount);
+            writer.Write(instanceCount);
+            writer.Write(firstIndex);
+            writer.Write(vertexOffset);
+            writer.Write(firstInstance);
+        });
+        m_Inner->DrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    }
+
+    void DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                             uint32 stride) override {
+        Command(TraceOp::DrawIndexedIndirect, [&](TraceWriter& writer) {
+            writer.Write(IdOf(argumentBuffer));
+            writer.Write(offset);
+            writer.Write(drawCount);
+            writer.Write(stride);
+        });
+        m_Inner->DrawIndexedIndirect(Unwrap(argumentBuffer), offset, drawCount, stride);
+    }
+
+    void DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset, const Ref<Buffer>& countBuffer,
+                                  uint64 countOffset, uint32 maxDrawCount, uint32 stride) override {
+        Command(TraceOp::DrawIndexedIndirectCount, [&](TraceWriter& writer) {
+            writer.Write(IdOf(argumentBuffer));
+            writer.Write(offset);
+            writer.Write(IdOf(countBuffer));
+            writer.Write(countOffset);
+            writer.Write(maxDrawCount);
+            writer.Write(stride);
+        });
+        m_Inner->DrawIndexedIndirectCount(Unwrap(argumentBuffer), offset, Unwrap(countBuffer), countOffset,
+                                          maxDrawCount, stride);
+    }
+
+    // ExecuteDrawList() keeps the default, so its draws are recorded as DrawIndexedIndirect()
+
+    void Dispatch(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ) override {
+        Command(TraceOp::Dispatch, [&](TraceWriter& writer) {
+            writer.Write(groupCountX);
+            writer.Write(groupCountY);
+            writer.Write(groupCountZ);
+        });
+        m_Inner->Dispatch(groupCountX, groupCountY, groupCountZ);
+    }
+
+    void DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset) override {
+        Command(TraceOp::DispatchIndirect, [&](TraceWriter& writer) {
+            writer.Write(IdOf(argumentBuffer));
+            writer.Write(offset);
+        });
+        m_Inner->DispatchIndirect(Unwrap(argumentBuffer), offset);
+    }
+
+    void CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst, uint64 size, uint64 srcOffset,
+                    uint64 dstOffset) override {
+        Command(TraceOp::CopyBuffer, [&](TraceWriter& writer) {
+            writer.Write(IdOf(src));
+            writer.Write(IdOf(dst));
+            writer.Write(size);
+            writer.Write(srcOffset);
+            writer.Write(dstOffset);
+        });
+        m_Inner->CopyBuffer(Unwrap(src), Unwrap(dst), size, srcOffset, dstOffset);
+    }
+
+    void CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset) override {
+        Command(TraceOp::CopyTextureToBuffer, [&](TraceWriter& writer) {
+            writer.Write(IdOf(src));
+            writer.Write(IdOf(dst));
+            writer.Write(dstOffset);
+        });
+        m_Inner->CopyTextureToBuffer(Unwrap(src), Unwrap(dst), dstOffset);
+    }
+
+    void BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex, const Ref<DescriptorSet>& descriptorSet,
+                           uint32 frameIndex, const uint32* dynamicOffsets, uint32 dynamicOffsetCount) override {
+        Command(TraceOp::BindDescriptorSet, [&](TraceWriter& writer) {
+            writer.Write(IdOf(pipeline));
+            writer.Write(setIndex);
+            writer.Write(IdOf(descriptorSet));
+            writer.Write(frameIndex);
+            WriteDynamicOffsets(writer, dynamicOffsets, dynamicOffsetCount);
+        });
+        m_Inner->BindDescriptorSet(Unwrap(pipeline), setIndex, Unwrap(descriptorSet), frameIndex, dynamicOffsets,
+                                   dynamicOffsetCount);
+    }
+
+    void PushDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                           const std::vector<DescriptorBindingDesc>& bindings, const uint32* dynamicOffsets,
+                           uint32 dynamicOffsetCount) override {
+        Command(TraceOp::PushDescriptorSet, [&](TraceWriter& writer) {
+            writer.Write(IdOf(pipeline));
+            writer.Write(setIndex);
+            writer.Write(static_cast<uint32>(bindings.size()));
+            for (const DescriptorBindingDesc& binding : bindings) {
+                WriteBinding(writer, binding);
+            }
+            WriteDynamicOffsets(writer, dynamicOffsets, dynamicOffsetCount);
+        });
+        std::vector<DescriptorBindingDesc> inner;
+        inner.reserve(bindings.size());
+        for (const DescriptorBindingDesc& binding : bindings) {
+            inner.push_back(UnwrapBinding(binding));
+        }
+        m_Inner->PushDescriptorSet(Unwrap(pipeline), setIndex, inner, dynamicOffsets, dynamicOffsetCount);
+    }
+
+    void PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages, uint32 offset, uint32 size,
+                       const void* data) override {
+        Command(TraceOp::PushConstants, [&](TraceWriter& writer) {
+            writer.Write(IdOf(pipeline));
+            writer.Write(stages);
+            writer.Write(offset);
+            writer.WriteBlob(data, size);
+        });
+        m_Inner->PushConstants(Unwrap(pipeline), stages, offset, size, data);
+    }
+
+    void BufferMemoryBarrier(const Ref<Buffer>& buffer) override {
+        Command(TraceOp::BufferMemoryBarrier, [&](TraceWriter& writer) { writer.Write(IdOf(buffer)); });
+        m_Inner->BufferMemoryBarrier(Unwrap(buffer));
+    }
+
+    void PipelineBarrier(BarrierType type) override {
+        Command(TraceOp::PipelineBarrier, [&](TraceWriter& writer) { writer.Write(type); });
+        m_Inner->PipelineBarrier(type);
+    }
+
+    void ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                         const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) override {
+        Command(TraceOp::ResourceBarrier, [&](TraceWriter& writer) {
+            writer.Write(textureBarrierCount);
+            for (uint32 i = 0; i < textureBarrierCount; ++i) {
+                writer.Write(IdOf(textureBarriers[i].texture));
+                writer.Write(textureBarriers[i].before);
+                writer.Write(textureBarriers[i].after);
+            }
+            writer.Write(bufferBarrierCount);
+            for (uint32 i = 0; i < bufferBarrierCount; ++i) {
+                writer.Write(IdOf(bufferBarriers[i].buffer));
+                writer.Write(bufferBarriers[i].before);
+                writer.Write(bufferBarriers[i].after);
+            }
+        });
+        std::vector<TextureBarrier> textures(textureBarriers, textureBarriers + textureBarrierCount);
+        for (TextureBarrier& barrier : textures) {
+            barrier.texture = Unwrap(barrier.texture);
+        }
+        std::vector<BufferBarrier> buffers(bufferBarriers, bufferBarriers + bufferBarrierCount);
+        for (BufferBarrier& barrier : buffers) {
+            barrier.buffer = Unwrap(barrier.buffer);
+        }
+        m_Inner->ResourceBarrier(textures.data(), textureBarrierCount, buffers.data(), bufferBarrierCount);
+    }
+
+    void InvalidateState() override {
+        Command(TraceOp::InvalidateState);
+        m_Inner->InvalidateState();
+    }
+
+private:
+    template <typename Fill>
+    void Command(TraceOp op, Fill&& fill) {
+        if (!m_Context->IsRecording()) {
+            return;
+        }
+        size_t record = m_Commands.BeginRecord(op);
+        fill(m_Commands);
+        m_Commands.EndRecord(record);
+    }
+    void Command(TraceOp op) {
+        Command(op, [](TraceWriter&) {});
+    }
+
+    static void WritePass(TraceWriter& writer, std::span<const Ref<Texture>> colorAttachments,
+                          const Ref<Texture>& depthAttachment, std::span<const ClearValue> clearValues,
+                          const RenderPassActions& actions, std::span<const Ref<Texture>> resolveTargets,
+                          const Ref<Texture>& shadingRate) {
+        WriteIds(writer, colorAttachments);
+        writer.Write(IdOf(depthAttachment));
+        writer.Write(static_cast<uint32>(clearValues.size()));
+        for (const ClearValue& clearValue : clearValues) {
+            writer.Write(clearValue);
+        }
+        writer.Write(actions);
+        WriteIds(writer, resolveTargets);
+        writer.Write(IdOf(shadingRate));
+    }
+
+    TraceWriter m_Commands;
+    std::vector<Ref<CaptureCommandBuffer>> m_Secondaries;  // Of the parallel render pass being recorded
+};
+
+// ----------------------------------------------------------------------------
+// Swap chain
+// ----------------------------------------------------------------------------
+
+class CaptureSwapChain final : public SwapChain {
+public:
+    CaptureSwapChain(Ref<CaptureContext> context, Ref<SwapChain> inner)
+        : m_Context(std::move(context))
+        , m_Inner(std::move(inner)) {}
+
+    SwapChain* GetInner() const { return m_Inner.get(); }
+
+    void Present() override {
+        m_Context->Record(TraceOp::Present);
+        m_Inner->Present();
+        m_Context->EndFrame();
+    }
+
+    void Resize(uint32 width, uint32 height) override {
+        m_Context->Record(TraceOp::Resize, [&](TraceWriter& writer) {
+            writer.Write(width);
+            writer.Write(height);
+        });
+        m_BackBuffers.clear();
+        m_Inner->Resize(width, height);
+    }
+
+    // The same wrapper for each of the swap chain's textures until it is recreated; the
+    // replay binds the ID to its own back buffer of the moment
+    Ref<Texture> GetCurrentBackBuffer() override {
+        Ref<Texture> backBuffer = m_Inner->GetCurrentBackBuffer();
+        if (!backBuffer) {
+            return nullptr;
+        }
+        Ref<CaptureTexture>& wrapper = m_BackBuffers[backBuffer.get()];
+        if (!wrapper) {
+            wrapper = CreateRef<CaptureTexture>(m_Context, backBuffer, m_Context->NextId());
+        }
+        m_Context->Record(TraceOp::BackBuffer, [&](TraceWriter& writer) { writer.Write(wrapper->GetId()); });
+        return wrapper;
+    }
+
+    uint32 GetWidth() const override { return m_Inner->GetWidth(); }
+    uint32 GetHeight() const override { return m_Inner->GetHeight(); }
+    Format GetFormat() const override { return m_Inner->GetFormat(); }
+
+    void SetPresentMode(PresentMode mode) override {
+        m_Context->Record(TraceOp::SetPresentMode, [&](TraceWriter& writer) { writer.Write(mode); });
+        m_BackBuffers.clear();
+        m_Inner->SetPresentMode(mode);
+    }
+    PresentMode GetPresentMode() const override { return m_Inner->GetPresentMode(); }
+
+    bool WaitForPresent(uint32 maxPendingPresents) override { return m_Inner->WaitForPresent(maxPendingPresents); }
+
+private:
+    Ref<CaptureContext> m_Context;
+    Ref<SwapChain> m_Inner;
+    std::unordered_map<Texture*, Ref<CaptureTexture>> m_BackBuffers;
+};
+
+// ----------------------------------------------------------------------------
+// Device
+// ----------------------------------------------------------------------------
+
+class CaptureDevice final : public GraphicsDevice {
+public:
+    CaptureDevice(Ref<GraphicsDevice> inner, Ref<CaptureContext> context)
+        : m_Inner(std::move(inner))
+        , m_Context(std::move(context))
+        , m_Info(m_Inner->GetDeviceInfo()) {
+        m_Info.supportsAccelerationStructures = false;
+        m_Info.supportsRayQuery = false;
+        m_Info.supportsTimestampQueries = false;
+        m_Info.supportsAsyncCompute = false;
+        m_Info.supportsFileTextureLoads = false;
+        m_Info.supportsTemporalUpscaler = false;
+    }
+
+    ~CaptureDevice() override {
+        m_Inner->WaitIdle();
+        WaitForPipelineCompiles();
+        ReleasePipelineCache();
+        ReleaseRetired(true);
+        m_FrameCommandBuffers.clear();
+        m_SwapChain.reset();
+        m_Context->Close();
+    }
+
+    const DeviceInfo& GetDeviceInfo() const override { return m_Info; }
+
+    Ref<Buffer> CreateBuffer(const BufferDesc& desc) override {
+        Ref<Buffer> buffer = m_Inner->CreateBuffer(desc);
+        if (!buffer) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateBuffer, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(desc.size);
+            writer.Write(desc.usage);
+            writer.Write(desc.memoryUsage);
+            writer.WriteString(desc.debugName);
+        });
+        return CreateRef<CaptureBuffer>(m_Context, buffer, id, desc);
+    }
+
+    Ref<Texture> CreateTexture(const TextureDesc& desc) override {
+        Ref<Texture> texture = m_Inner->CreateTexture(desc);
+        if (!texture) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateTexture, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(desc.type);
+            writer.Write(desc.width);
+            writer.Write(desc.height);
+            writer.Write(desc.depth);
+            writer.Write(desc.mipLevels);
+            writer.Write(desc.arrayLayers);
+            writer.Write(desc.format);
+            writer.Write(desc.usage);
+            writer.Write(desc.generateMipmaps);
+            writer.Write(desc.sampleCount);
+            writer.WriteString(desc.debugName);
+        });
+        return CreateRef<CaptureTexture>(m_Context, texture, id);
+    }
+
+    Ref<Sampler> CreateSampler(const SamplerDesc& desc) override {
+        Ref<Sampler> sampler = m_Inner->CreateSampler(desc);
+        if (!sampler) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateSampler, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(desc);
+        });
+        return CreateRef<CaptureSampler>(m_Context, sampler, id);
+    }
+
+    Ref<Shader> CreateShader(const ShaderDesc& desc) override {
+        Ref<Shader> shader = m_Inner->CreateShader(desc);
+        if (!shader) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateShader, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(desc.stage);
+            writer.WriteBlob(desc.code.data(), desc.code.size());
+            writer.WriteString(desc.entryPoint);
+            writer.WriteString(desc.debugName);
+        });
+        return CreateRef<CaptureShader>(m_Context, shader, id);
+    }
+
+    Ref<Pipeline> CreateComputePipeline(const ComputePipelineDesc& desc) override {
+        ComputePipelineDesc inner = desc;
+        inner.computeShader = Unwrap(desc.computeShader);
+        inner.descriptorSetLayout = Unwrap(desc.descriptorSetLayout);
+        Ref<Pipeline> pipeline = m_Inner->CreateComputePipeline(inner);
+        if (!pipeline) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateComputePipeline, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(IdOf(desc.computeShader));
+            writer.Write(desc.pushConstantSize);
+            writer.WriteString(desc.debugName);
+            writer.Write(IdOf(desc.descriptorSetLayout));
+        });
+        return CreateRef<CapturePipeline>(m_Context, pipeline, id);
+    }
+
+    Ref<Framebuffer> CreateFramebuffer(const FramebufferDesc& desc) override {
+        FramebufferDesc inner = desc;
+        inner.depthAttachment = Unwrap(desc.depthAttachment);
+        inner.colorAttachments = UnwrapAll<Texture>(desc.colorAttachments);
+        Ref<Framebuffer> framebuffer = m_Inner->CreateFramebuffer(inner);
+        if (!framebuffer) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateFramebuffer, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(IdOf(desc.depthAttachment));
+            WriteIds<Texture>(writer, desc.colorAttachments);
+            writer.WriteString(desc.debugName);
+        });
+        return CreateRef<CaptureFramebuffer>(m_Context, framebuffer, id, desc);
+    }
+
+    Ref<DescriptorSet> CreateDescriptorSet(const DescriptorSetDesc& desc) override {
+        DescriptorSetDesc inner = desc;
+        for (DescriptorBindingDesc& binding : inner.bindings) {
+            binding = UnwrapBinding(binding);
+        }
+        Ref<DescriptorSet> descriptorSet = m_Inner->CreateDescriptorSet(inner);
+        if (!descriptorSet) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateDescriptorSet, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(static_cast<uint32>(desc.bindings.size()));
+            for (const DescriptorBindingDesc& binding : desc.bindings) {
+                WriteBinding(writer, binding);
+            }
+            writer.WriteString(desc.debugName);
+            writer.Write(desc.pushDescriptors);
+        });
+        return CreateRef<CaptureDescriptorSet>(m_Context, descriptorSet, id);
+    }
+
+    Ref<CommandBuffer> CreateCommandBuffer() override {
+        Ref<CommandBuffer> commandBuffer = m_Inner->CreateCommandBuffer();
+        if (!commandBuffer) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateCommandBuffer, [&](TraceWriter& writer) { writer.Write(id); });
+        return CreateRef<CaptureCommandBuffer>(m_Context, commandBuffer, id);
+    }
+
+    FrameContext BeginFrame() override {
+        FrameContext frame = m_Inner->BeginFrame();
+        EndFrameStats();
+        ReleaseRetired();
+
+        // The slots' command buffers are recycled, so each keeps its wrapper
+        Ref<CaptureCommandBuffer>& commandBuffer = m_FrameCommandBuffers[frame.commandBuffer.get()];
+        if (!commandBuffer && frame.commandBuffer) {
+            commandBuffer = CreateRef<CaptureCommandBuffer>(m_Context, frame.commandBuffer, m_Context->NextId());
+        }
+        m_Context->Record(TraceOp::BeginFrame, [&](TraceWriter& writer) {
+            writer.Write(frame.frameIndex);
+            writer.Write(IdOf<CommandBuffer>(commandBuffer));
+        });
+        frame.commandBuffer = commandBuffer;
+        frame.computeCommandBuffer = nullptr;
+        return frame;
+    }
+
+    void SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) override {
+        auto* capture = static_cast<CaptureCommandBuffer*>(commandBuffer.get());
+        // What the CPU wrote into mapped buffers is visible at submit
+        m_Context->FlushMappedBuffers();
+        TraceWriter commands;
+        capture->TakeCommands(commands);
+        m_Context->Record(TraceOp::Submit, [&](TraceWriter& writer) {
+            writer.Write(capture->GetId());
+            writer.WriteBytes(commands.GetBytes().data(), commands.GetBytes().size());
+        });
+        m_Inner->SubmitCommandBuffer(capture->GetInner());
+        AddSubmittedStats(*capture->GetInner());
+    }
+
+    Ref<GpuProfiler> CreateGpuProfiler() override { return nullptr; }
+
+    MemoryBudget GetMemoryBudget() const override { return m_Inner->GetMemoryBudget(); }
+
+    void WaitIdle() override {
+        m_Context->Record(TraceOp::WaitIdle);
+        m_Inner->WaitIdle();
+    }
+
+    uint64 SignalValue() const override { return m_Inner->SignalValue(); }
+    uint64 GetCompletedFrameValue() const override { return m_Inner->GetCompletedFrameValue(); }
+    void WaitValue(uint64 value) override { m_Inner->WaitValue(value); }
+
+    Ref<SwapChain> GetSwapChain() override {
+        Ref<SwapChain> swapChain = m_Inner->GetSwapChain();
+        if (!swapChain) {
+            return nullptr;
+        }
+        if (!m_SwapChain || m_SwapChain->GetInner() != swapChain.get()) {
+            m_SwapChain = CreateRef<CaptureSwapChain>(m_Context, swapChain);
+        }
+        return m_SwapChain;
+    }
+
+protected:
+    // Behind the shared pipeline cache, keyed by the wrapped shaders and layouts
+    Ref<Pipeline> CompileGraphicsPipeline(const PipelineDesc& desc) override {
+        PipelineDesc inner = desc;
+        inner.vertexShader = Unwrap(desc.vertexShader);
+        inner.fragmentShader = Unwrap(desc.fragmentShader);
+        inner.descriptorSetLayout = Unwrap(desc.descriptorSetLayout);
+        for (Ref<DescriptorSet>& extraLayout : inner.extraSetLayouts) {
+            extraLayout = Unwrap(extraLayout);
+        }
+        Ref<Pipeline> pipeline = m_Inner->CreateGraphicsPipeline(inner);
+        if (!pipeline) {
+            return nullptr;
+        }
+        uint32 id = m_Context->NextId();
+        m_Context->Record(TraceOp::CreateGraphicsPipeline, [&](TraceWriter& writer) {
+            writer.Write(id);
+            writer.Write(IdOf(desc.vertexShader));
+            writer.Write(IdOf(desc.fragmentShader));
+            WriteAttributes(writer, desc.vertexInput.attributes);
+            writer.Write(desc.vertexInput.stride);
+            writer.Write(desc.topology);
+            writer.Write(desc.rasterization);
+            writer.Write(desc.depthStencil);
+            WriteVector(writer, desc.colorAttachments);
+            writer.WriteString(desc.debugName);
+            WriteVector(writer, desc.vertexInputState.bindings);
+            WriteAttributes(writer, desc.vertexInputState.attributes);
+            WriteVector(writer, desc.colorFormats);
+            writer.Write(desc.depthFormat);
+            writer.Write(desc.sampleCount);
+            writer.Write(desc.viewCount);
+            WriteVector(writer, desc.specializationConstants);
+            writer.Write(IdOf(desc.descriptorSetLayout));
+            WriteIds<DescriptorSet>(writer, desc.extraSetLayouts);
+        });
+        return CreateRef<CapturePipeline>(m_Context, pipeline, id);
+    }
+
+    void AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const override {
+        auto append = [&key](const DescriptorSet* layout) {
+            key.append(reinterpret_cast<const char*>(&layout), sizeof(layout));
+        };
+        append(desc.descriptorSetLayout.get());
+        for (const Ref<DescriptorSet>& extraLayout : desc.extraSetLayouts) {
+            append(extraLayout.get());
+        }
+    }
+
+private:
+    Ref<GraphicsDevice> m_Inner;
+    Ref<CaptureContext> m_Context;
+    DeviceInfo m_Info;
+
+    std::unordered_map<CommandBuffer*, Ref<CaptureCommandBuffer>> m_FrameCommandBuffers;
+    Ref<CaptureSwapChain> m_SwapChain;
+};
+
+} // anonymous namespace
+
+Ref<GraphicsDevice> CreateCaptureDevice(Ref<GraphicsDevice> device, const CaptureSettings& settings) {
+    if (!device) {
+        return nullptr;
+    }
+    auto context = CreateRef<CaptureContext>();
+    auto capture = CreateRef<CaptureDevice>(device, context);
+    if (!context->Open(settings, capture->GetDeviceInfo(), device->GetSwapChain().get())) {
+        METAGFX_ERROR << "Cannot write the RHI trace " << settings.path;
+        return nullptr;
+    }
+    METAGFX_INFO << "Capturing RHI calls to " << settings.path
+                 << (settings.frameCount > 0 ? " for " + std::to_string(settings.frameCount) + " frames" : "");
+    return capture;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,36 @@
+// ============================================================================
+// src/rhi/DrawList.cpp
+// ============================================================================
+#include "metagfx/rhi/DrawList.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+namespace metagfx {
+namespace rhi {
+
+DrawList::DrawList(GraphicsDevice& device, const DrawListDesc& desc)
+    : m_Commands(desc.commands) {
+    if (m_Commands.empty()) {
+        return;
+    }
+
+    BufferDesc bufferDesc = {};
+    bufferDesc.size = m_Commands.size() * sizeof(DrawIndexedIndirectCommand);
+    bufferDesc.usage = BufferUsage::Indirect | BufferUsage::TransferDst;
+    bufferDesc.memoryUsage = MemoryUsage::GPUOnly;
+    bufferDesc.debugName = desc.debugName;
+    m_Buffer = device.CreateBuffer(bufferDesc);
+    if (m_Buffer) {
+        m_Buffer->CopyData(m_Commands.data(), bufferDesc.size);
+    }
+}
+
+void CommandBuffer::ExecuteDrawList(const Ref<DrawList>& drawList) {
+    if (drawList && drawList->GetBuffer()) {
+        DrawIndexedIndirect(drawList->GetBuffer(), 0, drawList->GetDrawCount());
+    }
+}
+
+} // namespace rhi
+} // namespace metagfx
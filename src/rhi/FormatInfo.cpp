@@ -0,0 +1,131 @@
+// ============================================================================
+// src/rhi/FormatInfo.cpp
+// ============================================================================
+#include "metagfx/rhi/FormatInfo.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+FormatInfo GetFormatInfo(Format format) {
+    switch (format) {
+        case Format::R8_UNORM:
+        case Format::R8_SNORM:
+        case Format::R8_UINT:
+        case Format::R8_SINT:
+            return { 1, 1, 1, false };
+
+        case Format::R8G8_UNORM:
+        case Format::R8G8_SNORM:
+        case Format::R8G8_UINT:
+        case Format::R8G8_SINT:
+        case Format::R16_UNORM:
+        case Format::R16_SNORM:
+        case Format::R16_UINT:
+        case Format::R16_SINT:
+        case Format::R16_SFLOAT:
+        case Format::D16_UNORM:
+            return { 1, 1, 2, false };
+
+        case Format::R8G8B8A8_UNORM:
+        case Format::R8G8B8A8_SNORM:
+        case Format::R8G8B8A8_UINT:
+        case Format::R8G8B8A8_SINT:
+        case Format::R8G8B8A8_SRGB:
+        case Format::B8G8R8A8_UNORM:
+        case Format::B8G8R8A8_SRGB:
+        case Format::R16G16_UNORM:
+        case Format::R16G16_SNORM:
+        case Format::R16G16_UINT:
+        case Format::R16G16_SINT:
+        case Format::R16G16_SFLOAT:
+        case Format::R32_UINT:
+        case Format::R32_SINT:
+        case Format::R32_SFLOAT:
+        case Format::D32_SFLOAT:
+        case Format::D24_UNORM_S8_UINT:
+            return { 1, 1, 4, false };
+
+        case Format::R16G16B16A16_UNORM:
+        case Format::R16G16B16A16_SNORM:
+        case Format::R16G16B16A16_UINT:
+        case Format::R16G16B16A16_SINT:
+        case Format::R16G16B16A16_SFLOAT:
+        case Format::R32G32_UINT:
+        case Format::R32G32_SINT:
+        case Format::R32G32_SFLOAT:
+        case Format::D32_SFLOAT_S8_UINT:
+            return { 1, 1, 8, false };
+
+        case Format::R32G32B32_UINT:
+        case Format::R32G32B32_SINT:
+        case Format::R32G32B32_SFLOAT:
+            return { 1, 1, 12, false };
+
+        case Format::R32G32B32A32_UINT:
+        case Format::R32G32B32A32_SINT:
+        case Format::R32G32B32A32_SFLOAT:
+            return { 1, 1, 16, false };
+
+        // 8 bytes per 4x4 block
+        case Format::BC1_RGBA_UNORM:
+        case Format::BC1_RGBA_SRGB:
+        case Format::BC4_R_UNORM:
+        case Format::ETC2_RGB8_UNORM:
+        case Format::ETC2_RGB8_SRGB:
+            return { 4, 4, 8, true };
+
+        // 16 bytes per 4x4 block
+        case Format::BC3_RGBA_UNORM:
+        case Format::BC3_RGBA_SRGB:
+        case Format::BC5_RG_UNORM:
+        case Format::BC6H_RGB_UFLOAT:
+        case Format::BC7_RGBA_UNORM:
+        case Format::BC7_RGBA_SRGB:
+        case Format::ETC2_RGBA8_UNORM:
+        case Format::ETC2_RGBA8_SRGB:
+        case Format::ASTC_4x4_UNORM:
+        case Format::ASTC_4x4_SRGB:
+            return { 4, 4, 16, true };
+
+        // ASTC blocks are always 16 bytes; larger footprints mean fewer bits per texel
+        case Format::ASTC_6x6_UNORM:
+        case Format::ASTC_6x6_SRGB:
+            return { 6, 6, 16, true };
+        case Format::ASTC_8x8_UNORM:
+        case Format::ASTC_8x8_SRGB:
+            return { 8, 8, 16, true };
+
+        case Format::Undefined:
+        default:
+            return {};
+    }
+}
+
+uint32 GetFormatRowPitch(Format format, uint32 width) {
+    FormatInfo info = GetFormatInfo(format);
+    return ((width + info.blockWidth - 1) / info.blockWidth) * info.blockSize;
+}
+
+uint32 GetFormatRowCount(Format format, uint32 height) {
+    FormatInfo info = GetFormatInfo(format);
+    return (height + info.blockHeight - 1) / info.blockHeight;
+}
+
+uint64 GetFormatImageSize(Format format, uint32 width, uint32 height) {
+    return static_cast<uint64>(GetFormatRowPitch(format, width)) * GetFormatRowCount(format, height);
+}
+
+uint64 GetTextureSize(const TextureDesc& desc) {
+    uint64 size = 0;
+    for (uint32 mip = 0; mip < std::max(desc.mipLevels, 1u); ++mip) {
+        uint32 depth = desc.type == TextureType::Texture3D ? std::max(desc.depth >> mip, 1u) : 1;
+        size += GetFormatImageSize(desc.format, std::max(desc.width >> mip, 1u), std::max(desc.height >> mip, 1u)) *
+                depth;
+    }
+    return size * std::max(desc.arrayLayers, 1u) * std::max(desc.sampleCount, 1u);
+}
+
+} // namespace rhi
+} // namespace metagfx
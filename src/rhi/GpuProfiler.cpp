@@ -0,0 +1,197 @@
+// ============================================================================
+// src/rhi/GpuProfiler.cpp
+// ============================================================================
+#include "metagfx/rhi/GpuProfiler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+GpuProfiler::GpuProfiler(uint32 frameCount) : m_Slots(std::max(frameCount, 1u)) {
+}
+
+void GpuProfiler::BeginFrame(CommandBuffer& cmd, uint32 frameIndex) {
+    PollReadbacks();
+
+    // The GPU finished the slot's previous frame before GraphicsDevice::BeginFrame() returned
+    m_CurrentSlot = frameIndex % static_cast<uint32>(m_Slots.size());
+    Resolve(m_CurrentSlot);
+
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    slot.zones.clear();
+    slot.queryCount = 0;
+    slot.frameNumber = m_FrameNumber++;
+    m_OpenZones.clear();
+
+    ResetQueries(cmd, m_CurrentSlot);
+    m_CommandBuffer = &cmd;
+    cmd.m_Profiler = this;
+}
+
+void GpuProfiler::EndFrame(CommandBuffer& cmd) {
+    if (m_CommandBuffer != &cmd) {
+        return;
+    }
+    while (!m_OpenZones.empty()) {
+        EndZone(cmd);
+    }
+
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    slot.pending = slot.queryCount > 0 && ResolveQueries(cmd, m_CurrentSlot, slot.queryCount);
+
+    cmd.m_Profiler = nullptr;
+    m_CommandBuffer = nullptr;
+}
+
+void GpuProfiler::BeginZone(CommandBuffer& cmd, const char* name) {
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    if (slot.zones.size() >= MAX_ZONES) {
+        m_OpenZones.push_back(MAX_ZONES);  // Keeps EndZone() paired
+        return;
+    }
+    RecordedZone zone;
+    zone.name = name;
+    zone.depth = static_cast<uint32>(m_OpenZones.size());
+    zone.beginQuery = Timestamp(cmd);
+    m_OpenZones.push_back(static_cast<uint32>(slot.zones.size()));
+    slot.zones.push_back(std::move(zone));
+}
+
+void GpuProfiler::EndZone(CommandBuffer& cmd) {
+    if (m_OpenZones.empty()) {
+        return;
+    }
+    uint32 zoneIndex = m_OpenZones.back();
+    m_OpenZones.pop_back();
+    if (zoneIndex < MAX_ZONES) {
+        m_Slots[m_CurrentSlot].zones[zoneIndex].endQuery = Timestamp(cmd);
+    }
+}
+
+uint32 GpuProfiler::Timestamp(CommandBuffer& cmd) {
+    FrameSlot& slot = m_Slots[m_CurrentSlot];
+    if (slot.queryCount >= MAX_QUERIES || !WriteTimestamp(cmd, m_CurrentSlot, slot.queryCount)) {
+        return MAX_QUERIES;
+    }
+    return slot.queryCount++;
+}
+
+void GpuProfiler::Resolve(uint32 frameIndex) {
+    FrameSlot& slot = m_Slots[frameIndex];
+    if (!slot.pending) {
+        return;
+    }
+    slot.pending = false;
+
+    uint64 timestamps[MAX_QUERIES];
+    if (!ReadTimestamps(frameIndex, slot.queryCount, timestamps)) {
+        return;
+    }
+
+    uint64 first = INVALID_TIMESTAMP;
+    uint64 last = 0;
+    for (uint32 i = 0; i < slot.queryCount; ++i) {
+        if (timestamps[i] != INVALID_TIMESTAMP) {
+            first = std::min(first, timestamps[i]);
+            last = std::max(last, timestamps[i]);
+        }
+    }
+    if (first == INVALID_TIMESTAMP) {
+        return;
+    }
+
+    FrameTimings frame;
+    frame.frameNumber = slot.frameNumber;
+    frame.gpuStartMs = static_cast<double>(first) * 1e-6;
+    frame.gpuTimeMs = static_cast<double>(last - first) * 1e-6;
+    for (const RecordedZone& recorded : slot.zones) {
+        if (recorded.beginQuery >= slot.queryCount || recorded.endQuery >= slot.queryCount) {
+            continue;
+        }
+        uint64 begin = timestamps[recorded.beginQuery];
+        uint64 end = timestamps[recorded.endQuery];
+        if (begin == INVALID_TIMESTAMP || end == INVALID_TIMESTAMP) {
+            continue;
+        }
+        Zone zone;
+        zone.name = recorded.name;
+        zone.depth = recorded.depth;
+        zone.startMs = static_cast<double>(begin - first) * 1e-6;
+        // Passes may overlap on the GPU, so the end can be sampled before the begin
+        zone.durationMs = end > begin ? static_cast<double>(end - begin) * 1e-6 : 0.0;
+        frame.zones.push_back(std::move(zone));
+    }
+
+    m_LatestFrame = frame;
+    m_History.push_back(std::move(frame));
+    if (m_History.size() > MAX_HISTORY_FRAMES) {
+        m_History.pop_front();
+    }
+}
+
+bool GpuProfiler::WriteChromeTrace(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        METAGFX_ERROR << "Failed to write GPU trace: " << path;
+        return false;
+    }
+
+    // Complete ("X") events in microseconds on one GPU track; the first frame starts at 0
+    double origin = m_History.empty() ? 0.0 : m_History.front().gpuStartMs;
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+    for (const FrameTimings& frame : m_History) {
+        double frameStart = (frame.gpuStartMs - origin) * 1000.0;
+        out << ",\n{\"name\":\"Frame " << frame.frameNumber << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+            << ",\"ts\":" << frameStart << ",\"dur\":" << frame.gpuTimeMs * 1000.0 << "}";
+        for (const Zone& zone : frame.zones) {
+            out << ",\n{\"name\":";
+            WriteJsonString(out, zone.name);
+            out << ",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1"
+                << ",\"ts\":" << frameStart + zone.startMs * 1000.0 << ",\"dur\":" << zone.durationMs * 1000.0
+                << ",\"args\":{\"frame\":" << frame.frameNumber << "}}";
+        }
+    }
+    out << "\n]}\n";
+
+    METAGFX_INFO << "Wrote GPU trace of " << m_History.size() << " frames to " << path;
+    return out.good();
+}
+
+// CommandBuffer zones forward to the profiler attached by GpuProfiler::BeginFrame()
+void CommandBuffer::BeginZone(const char* name) {
+    if (m_Profiler) {
+        m_Profiler->BeginZone(*this, name);
+    }
+}
+
+void CommandBuffer::EndZone() {
+    if (m_Profiler) {
+        m_Profiler->EndZone(*this);
+    }
+}
+
+} // namespace rhi
+} // namespace metagfx
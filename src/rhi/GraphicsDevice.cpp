@@ -2,7 +2,20 @@
 // src/rhi/GraphicsDevice.cpp 
 // ============================================================================
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
 #include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/AccelerationStructure.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DrawList.h"
+#include "metagfx/rhi/Pipeline.h"
+#include "metagfx/rhi/TemporalUpscaler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+#include <type_traits>
 
 #ifdef METAGFX_USE_VULKAN
 #include "metagfx/rhi/vulkan/VulkanDevice.h"
@@ -19,12 +32,385 @@
 namespace metagfx {
 namespace rhi {
 
-Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHandle) {
+static thread_local ResourceGroup t_ResourceGroup = 0;
+
+ResourceGroup GraphicsDevice::GetCurrentResourceGroup() {
+    return t_ResourceGroup;
+}
+
+ResourceGroupScope::ResourceGroupScope(ResourceGroup group)
+    : m_Previous(t_ResourceGroup) {
+    t_ResourceGroup = group;
+}
+
+ResourceGroupScope::~ResourceGroupScope() {
+    t_ResourceGroup = m_Previous;
+}
+
+Ref<PipelineFuture> PipelineFuture::Launch(std::function<Ref<Pipeline>()> compile) {
+    auto future = CreateRef<PipelineFuture>();
+    // The job holds the future, so the counter outlives the job's release of it
+    JobSystem::Run([future, compile = std::move(compile)]() { future->m_Pipeline = compile(); },
+                   &future->m_Counter);
+    return future;
+}
+
+Ref<PipelineFuture> PipelineFuture::MakeReady(Ref<Pipeline> pipeline) {
+    auto future = CreateRef<PipelineFuture>();
+    future->m_Pipeline = std::move(pipeline);
+    return future;
+}
+
+Ref<PipelineFuture> PipelineFuture::MakePending(std::function<void()> poll) {
+    auto future = CreateRef<PipelineFuture>();
+    future->m_Resolved.store(false, std::memory_order_relaxed);
+    future->m_Poll = std::move(poll);
+    return future;
+}
+
+Ref<Pipeline> PipelineFuture::Wait() {
+    JobSystem::Wait(m_Counter);
+    while (!m_Resolved.load(std::memory_order_acquire)) {
+        if (m_Poll) {
+            m_Poll();
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return m_Pipeline;
+}
+
+void PipelineFuture::Resolve(Ref<Pipeline> pipeline) {
+    m_Pipeline = std::move(pipeline);
+    m_Resolved.store(true, std::memory_order_release);
+}
+
+Ref<PipelineFuture> GraphicsDevice::CompileGraphicsPipelineAsync(const PipelineDesc& desc) {
+    return PipelineFuture::MakeReady(CompileGraphicsPipeline(desc));
+}
+
+namespace {
+
+template <typename T>
+void AppendKey(std::string& key, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>);
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void AppendAttributes(std::string& key, const std::vector<VertexAttribute>& attributes) {
+    AppendKey(key, static_cast<uint32>(attributes.size()));
+    for (const VertexAttribute& attribute : attributes) {
+        AppendKey(key, attribute.location);
+        AppendKey(key, attribute.format);
+        AppendKey(key, attribute.offset);
+        AppendKey(key, attribute.binding);
+    }
+}
+
+// The bytes of everything a PipelineDesc compiles from, debugName aside: the shader
+// objects by address, then each state field in declaration order. The backend appends
+// the layouts descriptorSetLayout and extraSetLayouts stand for.
+void AppendPipelineKey(std::string& key, const PipelineDesc& desc) {
+    AppendKey(key, reinterpret_cast<uintptr_t>(desc.vertexShader.get()));
+    AppendKey(key, reinterpret_cast<uintptr_t>(desc.fragmentShader.get()));
+    AppendAttributes(key, desc.vertexInput.attributes);
+    AppendKey(key, desc.vertexInput.stride);
+    AppendKey(key, static_cast<uint32>(desc.vertexInputState.bindings.size()));
+    for (const VertexInputBinding& binding : desc.vertexInputState.bindings) {
+        AppendKey(key, binding.binding);
+        AppendKey(key, binding.stride);
+        AppendKey(key, binding.inputRate);
+    }
+    AppendAttributes(key, desc.vertexInputState.attributes);
+    AppendKey(key, desc.topology);
+
+    const RasterizationState& raster = desc.rasterization;
+    AppendKey(key, raster.polygonMode);
+    AppendKey(key, raster.cullMode);
+    AppendKey(key, raster.frontFace);
+    AppendKey(key, raster.depthClampEnable);
+    AppendKey(key, raster.depthBiasEnable);
+    AppendKey(key, raster.depthBiasConstantFactor);
+    AppendKey(key, raster.depthBiasSlopeFactor);
+    AppendKey(key, raster.lineWidth);
+
+    const DepthStencilState& depth = desc.depthStencil;
+    AppendKey(key, depth.depthTestEnable);
+    AppendKey(key, depth.depthWriteEnable);
+    AppendKey(key, depth.depthCompareOp);
+    AppendKey(key, depth.stencilTestEnable);
+
+    AppendKey(key, static_cast<uint32>(desc.colorAttachments.size()));
+    for (const ColorAttachmentState& attachment : desc.colorAttachments) {
+        AppendKey(key, attachment.blendEnable);
+        AppendKey(key, attachment.blendMode);
+        AppendKey(key, attachment.writeEnable);
+    }
+    AppendKey(key, static_cast<uint32>(desc.colorFormats.size()));
+    for (Format format : desc.colorFormats) {
+        AppendKey(key, format);
+    }
+    AppendKey(key, desc.depthFormat);
+    AppendKey(key, desc.sampleCount);
+    AppendKey(key, desc.viewCount);
+    AppendKey(key, static_cast<uint32>(desc.specializationConstants.size()));
+    for (const SpecializationConstant& constant : desc.specializationConstants) {
+        AppendKey(key, constant.id);
+        AppendKey(key, constant.value);
+    }
+}
+
+} // anonymous namespace
+
+Ref<Pipeline> GraphicsDevice::CreateGraphicsPipeline(const PipelineDesc& desc) {
+    return FindOrCompileGraphicsPipeline(desc, false)->Wait();
+}
+
+Ref<PipelineFuture> GraphicsDevice::CreateGraphicsPipelineAsync(const PipelineDesc& desc) {
+    return FindOrCompileGraphicsPipeline(desc, true);
+}
+
+PipelineCacheStats GraphicsDevice::GetPipelineCacheStats() const {
+    std::lock_guard<std::mutex> lock(m_GraphicsPipelineMutex);
+    PipelineCacheStats stats = m_PipelineCacheStats;
+    stats.pipelines = static_cast<uint32>(m_GraphicsPipelines.size());
+    return stats;
+}
+
+// The lock is held over the compile call, so equal requests racing each other compile
+// once; async calls only launch the job under it
+Ref<PipelineFuture> GraphicsDevice::FindOrCompileGraphicsPipeline(const PipelineDesc& desc, bool async) {
+    std::string key;
+    key.reserve(256);
+    AppendPipelineKey(key, desc);
+    AppendPipelineStateKey(desc, key);
+
+    std::lock_guard<std::mutex> lock(m_GraphicsPipelineMutex);
+    auto found = m_GraphicsPipelines.find(key);
+    if (found != m_GraphicsPipelines.end()) {
+        // A failed compile is tried again; so is one whose shader address was reused
+        if (!found->second.IsStale()) {
+            ++m_PipelineCacheStats.hits;
+            return found->second.future;
+        }
+    }
+
+    ++m_PipelineCacheStats.misses;
+    m_StatsCounters.AddPipelineCompile();
+    CachedPipeline cached;
+    if (async) {
+        cached.future = CompileGraphicsPipelineAsync(desc);
+    } else {
+        // The caller waits for it: a hitch when that is the frame
+        METAGFX_PROFILE_SCOPE("Compile pipeline");
+        cached.future = PipelineFuture::MakeReady(CompileGraphicsPipeline(desc));
+    }
+    cached.vertexShader = desc.vertexShader;
+    cached.fragmentShader = desc.fragmentShader;
+    cached.hasFragmentShader = desc.fragmentShader != nullptr;
+    Ref<PipelineFuture> future = cached.future;
+    if (found != m_GraphicsPipelines.end()) {
+        if (Ref<Pipeline> replaced = found->second.future->Get()) {
+            Retire(std::move(replaced));
+        }
+        found->second = std::move(cached);
+    } else {
+        m_GraphicsPipelines.emplace(std::move(key), std::move(cached));
+        if (m_GraphicsPipelines.size() >= m_GraphicsPipelinePruneSize) {
+            PruneGraphicsPipelines();
+        }
+    }
+    return future;
+}
+
+// A compile still running holds its desc, and with it the shaders
+bool GraphicsDevice::CachedPipeline::IsStale() const {
+    return future->IsReady() &&
+           (!future->Get() || vertexShader.expired() || (hasFragmentShader && fragmentShader.expired()));
+}
+
+// Drops the entries no request can hit again: their shaders are gone or their compile
+// failed. The next sweep waits until the cache has doubled, so sweeps stay amortized.
+void GraphicsDevice::PruneGraphicsPipelines() {
+    for (auto it = m_GraphicsPipelines.begin(); it != m_GraphicsPipelines.end();) {
+        if (it->second.IsStale()) {
+            if (Ref<Pipeline> pipeline = it->second.future->Get()) {
+                Retire(std::move(pipeline));
+            }
+            it = m_GraphicsPipelines.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    m_GraphicsPipelinePruneSize = std::max<size_t>(64, m_GraphicsPipelines.size() * 2);
+}
+
+void GraphicsDevice::ReleasePipelineCache() {
+    std::lock_guard<std::mutex> lock(m_GraphicsPipelineMutex);
+    for (auto& entry : m_GraphicsPipelines) {
+        if (Ref<Pipeline> pipeline = entry.second.future->Get()) {
+            Retire(std::move(pipeline));
+        }
+    }
+    m_GraphicsPipelines.clear();
+}
+
+void GraphicsDevice::SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer) {
+    (void)commandBuffer;  // No async compute queue (DeviceInfo::supportsAsyncCompute)
+    METAGFX_ERROR << "SubmitComputeCommandBuffer: the device has no async compute queue";
+}
+
+void CommandBuffer::PushDescriptorSet(const Ref<Pipeline>&, uint32 setIndex, const std::vector<DescriptorBindingDesc>&,
+                                      const uint32*, uint32) {
+    // No push descriptors (DeviceInfo::supportsPushDescriptors)
+    METAGFX_ERROR << "PushDescriptorSet: the device cannot push set " << setIndex;
+}
+
+Ref<DrawList> GraphicsDevice::CreateDrawList(const DrawListDesc& desc) {
+    return CreateRef<DrawList>(*this, desc);
+}
+
+Ref<AccelerationStructure> GraphicsDevice::CreateAccelerationStructure(const AccelerationStructureDesc& desc) {
+    (void)desc;  // No acceleration structures (DeviceInfo::supportsAccelerationStructures)
+    return nullptr;
+}
+
+Ref<TemporalUpscaler> GraphicsDevice::CreateTemporalUpscaler(const TemporalUpscalerDesc& desc) {
+    (void)desc;  // No temporal upscaler (DeviceInfo::supportsTemporalUpscaler)
+    return nullptr;
+}
+
+MemoryBudget GraphicsDevice::GetMemoryBudget() const {
+    MemoryBudget budget;
+    budget.budgetBytes = GetDeviceInfo().deviceMemory;
+    return budget;
+}
+
+MemoryStats GraphicsDevice::GetMemoryStats() const {
+    MemoryStats stats;
+    stats.budget = GetMemoryBudget();
+    m_MemoryCounters.Read(stats);
+    return stats;
+}
+
+Ref<PipelineFuture> GraphicsDevice::LaunchPipelineCompile(std::function<Ref<Pipeline>()> compile) {
+    Ref<PipelineFuture> future = PipelineFuture::Launch(std::move(compile));
+
+    std::lock_guard<std::mutex> lock(m_PipelineCompileMutex);
+    m_PipelineCompiles.erase(std::remove_if(m_PipelineCompiles.begin(), m_PipelineCompiles.end(),
+                                            [](const Ref<PipelineFuture>& pending) { return pending->IsReady(); }),
+                             m_PipelineCompiles.end());
+    m_PipelineCompiles.push_back(future);
+    return future;
+}
+
+void GraphicsDevice::WaitForPipelineCompiles() {
+    std::vector<Ref<PipelineFuture>> pending;
+    {
+        std::lock_guard<std::mutex> lock(m_PipelineCompileMutex);
+        pending.swap(m_PipelineCompiles);
+    }
+    for (const Ref<PipelineFuture>& future : pending) {
+        future->Wait();
+    }
+}
+
+void GraphicsDevice::AddSubmittedStats(const CommandBuffer& commandBuffer) {
+    m_PendingStats += commandBuffer.GetStats();
+    m_PendingStats.filteredCalls += commandBuffer.GetFilteredCallCount();
+}
+
+void GraphicsDevice::WaitValue(uint64 value) {
+    value = std::min(value, SignalValue());
+    if (GetCompletedFrameValue() >= value) {
+        return;
+    }
+    WaitIdle();
+    // Completion callbacks may still be on their way
+    while (GetCompletedFrameValue() < value) {
+        std::this_thread::yield();
+    }
+}
+
+void GraphicsDevice::Retire(Ref<void> resource) {
+    if (!resource) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_RetireMutex);
+    m_Retiring.push_back(std::move(resource));
+}
+
+void GraphicsDevice::ReleaseRetired(bool wait) {
+    if (wait) {
+        WaitValue(SignalValue());
+    }
+
+    std::vector<Ref<void>> released;
+    {
+        std::lock_guard<std::mutex> lock(m_RetireMutex);
+        // Everything retired since the last call may be used by anything submitted so far
+        if (!m_Retiring.empty()) {
+            m_Retired.push_back({ SignalValue(), std::move(m_Retiring) });
+            m_Retiring.clear();
+        }
+
+        uint64 completedValue = GetCompletedFrameValue();
+        while (!m_Retired.empty() && m_Retired.front().signalValue <= completedValue) {
+            std::vector<Ref<void>>& resources = m_Retired.front().resources;
+            std::move(resources.begin(), resources.end(), std::back_inserter(released));
+            m_Retired.pop_front();
+        }
+    }
+    // Destroyed outside the lock: destructors may retire what they own
+    released.clear();
+}
+
+void GraphicsDevice::CompleteValue(uint64 value) {
+    // Callbacks of consecutive submissions may race; the counter only moves forward
+    uint64 completed = m_CompletedValue.load(std::memory_order_relaxed);
+    while (completed < value &&
+           !m_CompletedValue.compare_exchange_weak(completed, value, std::memory_order_acq_rel)) {
+    }
+}
+
+void GraphicsDevice::EndFrameStats() {
+    m_StatsCounters.Take(m_PendingStats);
+    m_FrameStats = m_PendingStats;
+    m_PendingStats = FrameStats{};
+}
+
+Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHandle,
+                                         const GraphicsDeviceDesc& desc) {
+    GraphicsDeviceDesc deviceDesc = desc;
+    deviceDesc.framesInFlight = std::clamp(desc.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+    if (deviceDesc.framesInFlight != desc.framesInFlight) {
+        METAGFX_WARN << "Frames in flight must be 1-" << MAX_FRAMES_IN_FLIGHT
+                     << ", using " << deviceDesc.framesInFlight;
+    }
+
+    if (!desc.adapterName.empty()) {
+        auto lower = [](std::string text) {
+            std::transform(text.begin(), text.end(), text.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        };
+        std::vector<AdapterInfo> adapters = EnumerateAdapters(api);
+        std::string name = lower(desc.adapterName);
+        auto match = std::find_if(adapters.begin(), adapters.end(), [&](const AdapterInfo& adapter) {
+            return lower(adapter.name).find(name) != std::string::npos;
+        });
+        if (match != adapters.end()) {
+            deviceDesc.adapterIndex = static_cast<uint32>(match - adapters.begin());
+        } else {
+            METAGFX_WARN << "No GPU named like '" << desc.adapterName << "'";
+        }
+    }
+
     switch (api) {
 #ifdef METAGFX_USE_VULKAN
         case GraphicsAPI::Vulkan:
             METAGFX_INFO << "Creating Vulkan graphics device...";
-            return CreateRef<VulkanDevice>(static_cast<SDL_Window*>(nativeWindowHandle));
+            return CreateRef<VulkanDevice>(static_cast<SDL_Window*>(nativeWindowHandle), deviceDesc);
 #endif
 
 #ifdef METAGFX_USE_D3D12
@@ -36,13 +422,16 @@ Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHand
 #ifdef METAGFX_USE_METAL
         case GraphicsAPI::Metal:
             METAGFX_INFO << "Creating Metal graphics device...";
-            return CreateRef<MetalDevice>(static_cast<SDL_Window*>(nativeWindowHandle));
+            return CreateRef<MetalDevice>(static_cast<SDL_Window*>(nativeWindowHandle), deviceDesc);
 #endif
 
 #ifdef METAGFX_USE_WEBGPU
         case GraphicsAPI::WebGPU:
             METAGFX_INFO << "Creating WebGPU graphics device...";
-            return CreateRef<WebGPUDevice>(static_cast<SDL_Window*>(nativeWindowHandle));
+            if (deviceDesc.offscreen) {
+                METAGFX_WARN << "WebGPU has no offscreen swap chain, presenting to the window";
+            }
+            return CreateRef<WebGPUDevice>(static_cast<SDL_Window*>(nativeWindowHandle), deviceDesc);
 #endif
             
         default:
@@ -51,6 +440,58 @@ Ref<GraphicsDevice> CreateGraphicsDevice(GraphicsAPI api, void* nativeWindowHand
     }
 }
 
+std::vector<AdapterInfo> EnumerateAdapters(GraphicsAPI api) {
+    switch (api) {
+#ifdef METAGFX_USE_VULKAN
+        case GraphicsAPI::Vulkan:
+            return VulkanDevice::EnumerateAdapters();
+#endif
+
+#ifdef METAGFX_USE_METAL
+        case GraphicsAPI::Metal:
+            return MetalDevice::EnumerateAdapters();
+#endif
+
+        default:
+            return {};
+    }
+}
+
+std::vector<const char*> GetFeatureNames(const DeviceInfo& info) {
+    std::vector<const char*> names;
+    auto add = [&names](bool supported, const char* name) {
+        if (supported) {
+            names.push_back(name);
+        }
+    };
+    add(info.supportsBindlessTextures, "bindless");
+    add(info.supportsBCTextures, "bc");
+    add(info.supportsETC2Textures, "etc2");
+    add(info.supportsASTCTextures, "astc");
+    add(info.supportsMultiDrawIndirect, "multiDrawIndirect");
+    add(info.supportsDrawIndirectCount, "drawIndirectCount");
+    add(info.supportsDrawIndirectFirstInstance, "drawIndirectFirstInstance");
+    add(info.supportsParallelRecording, "parallelRecording");
+    add(info.supportsThreadedResourceCreation, "threadedResourceCreation");
+    add(info.supportsAsyncCompute, "asyncCompute");
+    add(info.supportsPresentWait, "presentWait");
+    add(info.supportsTimestampQueries, "timestamps");
+    add(info.supportsMemorylessAttachments, "memoryless");
+    add(info.supportsShadingRateImage, "shadingRate");
+    add(info.supportsMemoryBudget, "memoryBudget");
+    add(info.supportsAccelerationStructures, "accelerationStructures");
+    add(info.supportsRayQuery, "rayQuery");
+    add(info.supportsShaderFloat16, "shaderFloat16");
+    add(info.supportsPipelineLibraries, "pipelineLibraries");
+    add(info.supportsPushDescriptors, "pushDescriptors");
+    add(info.supportsFileTextureLoads, "fileTextureLoads");
+    add(info.depthFormat == Format::D32_SFLOAT, "depth32");
+    add(info.supportsDepth16, "depth16");
+    add(info.supportsMultiview, "multiview");
+    add(info.supportsTemporalUpscaler, "temporalUpscaler");
+    return names;
+}
+
 } // namespace rhi
 } // namespace metagfx
 
@@ -0,0 +1,200 @@
+// ============================================================================
+// src/rhi/MipGenerator.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/MipGenerator.h"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define METAGFX_MIP_SSE2 1
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define METAGFX_MIP_NEON 1
+#endif
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+struct MipFormatInfo {
+    uint32 channels = 0;
+    uint32 texelSize = 0;
+    bool isFloat = false;
+    bool isSRGB = false;
+};
+
+MipFormatInfo GetMipFormatInfo(Format format) {
+    switch (format) {
+        case Format::R8_UNORM:              return { 1, 1, false, false };
+        case Format::R8G8_UNORM:            return { 2, 2, false, false };
+        case Format::R8G8B8A8_UNORM:
+        case Format::B8G8R8A8_UNORM:        return { 4, 4, false, false };
+        case Format::R8G8B8A8_SRGB:
+        case Format::B8G8R8A8_SRGB:         return { 4, 4, false, true };
+        case Format::R32_SFLOAT:            return { 1, 4, true, false };
+        case Format::R32G32_SFLOAT:         return { 2, 8, true, false };
+        case Format::R32G32B32_SFLOAT:      return { 3, 12, true, false };
+        case Format::R32G32B32A32_SFLOAT:   return { 4, 16, true, false };
+        default:                            return {};
+    }
+}
+
+// sRGB <-> linear tables: 256 entries in, 4096 entries out (12-bit linear precision)
+struct SRGBTables {
+    std::array<float, 256> toLinear;
+    std::array<uint8, 4096> fromLinear;
+
+    SRGBTables() {
+        for (uint32 i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        for (uint32 i = 0; i < 4096; ++i) {
+            float l = i / 4095.0f;
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            fromLinear[i] = static_cast<uint8>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+    }
+};
+
+const SRGBTables& GetSRGBTables() {
+    static const SRGBTables tables;
+    return tables;
+}
+
+// Average 2x2 texels of an RGBA8 row pair into 'count' destination texels.
+// Requires the source row to hold 2 * count texels.
+uint32 DownsampleRowRGBA8Fast(const uint8* row0, const uint8* row1, uint8* dst, uint32 count) {
+    uint32 x = 0;
+#if defined(METAGFX_MIP_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    for (; x + 2 <= count; x += 2) {
+        // 4 source texels -> 2 destination texels
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + x * 8));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + x * 8));
+        __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+        hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+        __m128i sum = _mm_unpacklo_epi64(lo, hi);
+        sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + x * 4), _mm_packus_epi16(sum, sum));
+    }
+#elif defined(METAGFX_MIP_NEON)
+    for (; x + 2 <= count; x += 2) {
+        uint8x16_t a = vld1q_u8(row0 + x * 8);
+        uint8x16_t b = vld1q_u8(row1 + x * 8);
+        uint16x8_t lo = vaddl_u8(vget_low_u8(a), vget_low_u8(b));
+        uint16x8_t hi = vaddl_u8(vget_high_u8(a), vget_high_u8(b));
+        uint16x8_t sum = vcombine_u16(vadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+                                      vadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+        vst1_u8(dst + x * 4, vmovn_u16(vrshrq_n_u16(sum, 2)));
+    }
+#endif
+    return x;
+}
+
+// One level of a 2x2 box filter. Odd source sizes clamp the last column/row.
+void DownsampleUNorm8(const uint8* src, uint32 srcWidth, uint32 srcHeight,
+                      uint8* dst, uint32 dstWidth, uint32 dstHeight, const MipFormatInfo& info) {
+    const uint32 c = info.channels;
+    const SRGBTables* srgb = info.isSRGB ? &GetSRGBTables() : nullptr;
+    const bool fastRows = !srgb && c == 4 && (srcWidth & 1) == 0;
+
+    for (uint32 y = 0; y < dstHeight; ++y) {
+        const uint8* row0 = src + static_cast<uint64>(std::min(2 * y, srcHeight - 1)) * srcWidth * c;
+        const uint8* row1 = src + static_cast<uint64>(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * c;
+        uint8* out = dst + static_cast<uint64>(y) * dstWidth * c;
+
+        uint32 x = fastRows ? DownsampleRowRGBA8Fast(row0, row1, out, dstWidth) : 0;
+        for (; x < dstWidth; ++x) {
+            uint32 x0 = std::min(2 * x, srcWidth - 1) * c;
+            uint32 x1 = std::min(2 * x + 1, srcWidth - 1) * c;
+            for (uint32 ch = 0; ch < c; ++ch) {
+                if (srgb && ch < 3) {
+                    float l = srgb->toLinear[row0[x0 + ch]] + srgb->toLinear[row0[x1 + ch]] +
+                              srgb->toLinear[row1[x0 + ch]] + srgb->toLinear[row1[x1 + ch]];
+                    out[x * c + ch] = srgb->fromLinear[static_cast<uint32>(l * 0.25f * 4095.0f + 0.5f)];
+                } else {
+                    uint32 sum = row0[x0 + ch] + row0[x1 + ch] + row1[x0 + ch] + row1[x1 + ch];
+                    out[x * c + ch] = static_cast<uint8>((sum + 2) >> 2);
+                }
+            }
+        }
+    }
+}
+
+void DownsampleFloat(const float* src, uint32 srcWidth, uint32 srcHeight,
+                     float* dst, uint32 dstWidth, uint32 dstHeight, uint32 c) {
+    for (uint32 y = 0; y < dstHeight; ++y) {
+        const float* row0 = src + static_cast<uint64>(std::min(2 * y, srcHeight - 1)) * srcWidth * c;
+        const float* row1 = src + static_cast<uint64>(std::min(2 * y + 1, srcHeight - 1)) * srcWidth * c;
+        float* out = dst + static_cast<uint64>(y) * dstWidth * c;
+
+        for (uint32 x = 0; x < dstWidth; ++x) {
+            uint32 x0 = std::min(2 * x, srcWidth - 1) * c;
+            uint32 x1 = std::min(2 * x + 1, srcWidth - 1) * c;
+            for (uint32 ch = 0; ch < c; ++ch) {
+                out[x * c + ch] = (row0[x0 + ch] + row0[x1 + ch] + row1[x0 + ch] + row1[x1 + ch]) * 0.25f;
+            }
+        }
+    }
+}
+
+} // namespace
+
+bool IsCPUMipGenerationSupported(Format format) {
+    return GetMipFormatInfo(format).channels != 0;
+}
+
+bool GenerateMipChainCPU(const void* mip0, uint32 width, uint32 height, uint32 arrayLayers,
+                         uint32 mipLevels, Format format, std::vector<uint8>& outData) {
+    MipFormatInfo info = GetMipFormatInfo(format);
+    if (info.channels == 0 || width == 0 || height == 0 || mipLevels == 0) {
+        METAGFX_ERROR << "CPU mip generation: unsupported format or empty image";
+        return false;
+    }
+
+    // Level offsets (per level, layers are contiguous)
+    std::vector<uint64> levelOffsets(mipLevels);
+    uint64 totalSize = 0;
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        levelOffsets[mip] = totalSize;
+        uint64 layerSize = static_cast<uint64>(std::max(1u, width >> mip)) * std::max(1u, height >> mip) * info.texelSize;
+        totalSize += layerSize * arrayLayers;
+    }
+
+    outData.resize(totalSize);
+    memcpy(outData.data(), mip0, levelOffsets.size() > 1 ? levelOffsets[1] : totalSize);
+
+    for (uint32 mip = 1; mip < mipLevels; ++mip) {
+        uint32 srcWidth = std::max(1u, width >> (mip - 1));
+        uint32 srcHeight = std::max(1u, height >> (mip - 1));
+        uint32 dstWidth = std::max(1u, width >> mip);
+        uint32 dstHeight = std::max(1u, height >> mip);
+        uint64 srcLayerSize = static_cast<uint64>(srcWidth) * srcHeight * info.texelSize;
+        uint64 dstLayerSize = static_cast<uint64>(dstWidth) * dstHeight * info.texelSize;
+
+        for (uint32 layer = 0; layer < arrayLayers; ++layer) {
+            const uint8* src = outData.data() + levelOffsets[mip - 1] + layer * srcLayerSize;
+            uint8* dst = outData.data() + levelOffsets[mip] + layer * dstLayerSize;
+            if (info.isFloat) {
+                DownsampleFloat(reinterpret_cast<const float*>(src), srcWidth, srcHeight,
+                                reinterpret_cast<float*>(dst), dstWidth, dstHeight, info.channels);
+            } else {
+                DownsampleUNorm8(src, srcWidth, srcHeight, dst, dstWidth, dstHeight, info);
+            }
+        }
+    }
+
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,104 @@
+// ============================================================================
+// src/rhi/ReadbackPool.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/ReadbackPool.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/Texture.h"
+
+namespace metagfx {
+namespace rhi {
+
+ReadbackPool::ReadbackPool(Ref<GraphicsDevice> device)
+    : m_Device(device)
+    , m_FreeBuffers(std::make_shared<FreeBuffers>()) {
+}
+
+void ReadbackPool::BeginFrame() {
+    // The frame that recorded these has been submitted by now
+    uint64 signalValue = m_Device->SignalValue();
+    for (Request& request : m_Recorded) {
+        request.signalValue = signalValue;
+        m_Submitted.push_back(std::move(request));
+    }
+    m_Recorded.clear();
+
+    // Values complete in order (WebGPU's maps still wait for the GPU themselves)
+    uint64 completedValue = m_Device->GetCompletedFrameValue();
+    std::vector<Request> requests;
+    while (!m_Submitted.empty() && m_Submitted.front().signalValue <= completedValue) {
+        requests.push_back(std::move(m_Submitted.front()));
+        m_Submitted.pop_front();
+    }
+
+    for (Request& request : requests) {
+        std::weak_ptr<FreeBuffers> freeBuffers = m_FreeBuffers;
+        Ref<Buffer> staging = request.staging;
+        staging->MapAsync([freeBuffers, staging, size = request.size, callback = std::move(request.callback)]
+                          (const void* data, uint64 mappedSize) {
+            callback(data, data && mappedSize >= size ? size : 0);
+            if (auto buffers = freeBuffers.lock()) {
+                (*buffers)[staging->GetSize()].push_back(staging);
+            }
+        });
+    }
+}
+
+bool ReadbackPool::Read(CommandBuffer& cmd, Ref<Buffer> source, uint64 offset, uint64 size,
+                        Buffer::MapCallback callback) {
+    Ref<Buffer> staging = AcquireStaging(size);
+    if (!staging) {
+        return false;
+    }
+    cmd.CopyBuffer(source, staging, size, offset, 0);
+    m_Recorded.push_back({ staging, size, std::move(callback) });
+    return true;
+}
+
+bool ReadbackPool::ReadTexture(CommandBuffer& cmd, const Ref<Texture>& source, Buffer::MapCallback callback) {
+    uint64 size = static_cast<uint64>(GetReadbackRowPitch(source->GetFormat(), source->GetWidth())) *
+                  GetFormatRowCount(source->GetFormat(), source->GetHeight());
+    Ref<Buffer> staging = AcquireStaging(size);
+    if (!staging) {
+        return false;
+    }
+    cmd.CopyTextureToBuffer(source, staging, 0);
+    m_Recorded.push_back({ staging, size, std::move(callback) });
+    return true;
+}
+
+Ref<Buffer> ReadbackPool::AcquireStaging(uint64 size) {
+    uint64 bufferSize = MIN_BUFFER_SIZE;
+    while (bufferSize < size) {
+        bufferSize *= 2;
+    }
+
+    std::vector<Ref<Buffer>>& freeBuffers = (*m_FreeBuffers)[bufferSize];
+    if (!freeBuffers.empty()) {
+        Ref<Buffer> staging = std::move(freeBuffers.back());
+        freeBuffers.pop_back();
+        return staging;
+    }
+
+    BufferDesc desc{};
+    desc.size = bufferSize;
+    desc.usage = BufferUsage::TransferDst;
+    desc.memoryUsage = MemoryUsage::GPUToCPU;
+    desc.debugName = "Readback Staging";
+    Ref<Buffer> staging = m_Device->CreateBuffer(desc);
+    if (!staging) {
+        METAGFX_ERROR << "ReadbackPool: failed to create " << bufferSize << " byte staging buffer";
+        return nullptr;
+    }
+    ++m_BufferCount;
+    return staging;
+}
+
+// Backends without texture readback
+void CommandBuffer::CopyTextureToBuffer(const Ref<Texture>&, const Ref<Buffer>&, uint64) {
+    METAGFX_ERROR << "CopyTextureToBuffer() is not supported by this backend";
+}
+
+} // namespace rhi
+} // namespace metagfx
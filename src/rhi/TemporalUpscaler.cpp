@@ -0,0 +1,18 @@
+// ============================================================================
+// src/rhi/TemporalUpscaler.cpp
+// ============================================================================
+#include "metagfx/rhi/TemporalUpscaler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+
+namespace metagfx {
+namespace rhi {
+
+// Devices without a temporal upscaler never create one; callers upscale themselves
+bool CommandBuffer::TemporalUpscale(TemporalUpscaler& upscaler, const TemporalUpscaleFrame& frame) {
+    (void)upscaler;
+    (void)frame;
+    return false;
+}
+
+} // namespace rhi
+} // namespace metagfx
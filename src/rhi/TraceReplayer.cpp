@@ -0,0 +1,729 @@
+// ============================================================================
+// src/rhi/TraceReplayer.cpp - RHI Trace Replay
+// ============================================================================
+#include "metagfx/rhi/CaptureDevice.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/Framebuffer.h"
+#include "metagfx/rhi/Pipeline.h"
+#include "metagfx/rhi/Sampler.h"
+#include "metagfx/rhi/Shader.h"
+#include "metagfx/rhi/SwapChain.h"
+#include "metagfx/rhi/Texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+template <typename T>
+bool ReadValue(std::istream& in, T& value) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+bool ReadString(std::istream& in, std::string& text) {
+    uint32 length = 0;
+    if (!ReadValue(in, length) || length > (1u << 16)) {
+        return false;
+    }
+    text.resize(length);
+    return length == 0 || static_cast<bool>(in.read(text.data(), length));
+}
+
+// Leaves in at the first record
+bool ReadHeader(std::istream& in, TraceInfo& info) {
+    uint32 magic = 0;
+    uint32 version = 0;
+    if (!ReadValue(in, magic) || magic != TRACE_MAGIC || !ReadValue(in, version) || version != TRACE_VERSION) {
+        return false;
+    }
+    uint32 featureCount = 0;
+    bool valid = ReadValue(in, info.frameCount) && ReadValue(in, info.api) && ReadValue(in, info.framesInFlight) &&
+                 ReadValue(in, info.width) && ReadValue(in, info.height) && ReadValue(in, info.format) &&
+                 ReadValue(in, info.presentMode) && ReadString(in, info.deviceName) &&
+                 ReadValue(in, featureCount);
+    info.features.clear();
+    for (uint32 i = 0; valid && i < featureCount; ++i) {
+        std::string feature;
+        valid = ReadString(in, feature);
+        info.features.push_back(std::move(feature));
+    }
+    return valid;
+}
+
+// Where the time of a record goes in TraceFrameStats; Submit splits its own
+enum class RecordKind {
+    Resource,
+    Upload,
+    Present,
+    Submit
+};
+
+RecordKind GetRecordKind(TraceOp op) {
+    switch (op) {
+        case TraceOp::BufferData:
+        case TraceOp::TextureData:
+            return RecordKind::Upload;
+        case TraceOp::BeginFrame:
+        case TraceOp::WaitIdle:
+        case TraceOp::BackBuffer:
+        case TraceOp::Present:
+        case TraceOp::Resize:
+        case TraceOp::SetPresentMode:
+            return RecordKind::Present;
+        case TraceOp::Submit:
+            return RecordKind::Submit;
+        default:
+            return RecordKind::Resource;
+    }
+}
+
+std::vector<uint32> ReadDynamicOffsets(TraceReader& reader) {
+    uint32 count = reader.Read<uint32>();
+    std::vector<uint32> offsets;
+    if (const uint8* bytes = reader.ReadBytes(static_cast<uint64>(count) * sizeof(uint32))) {
+        offsets.resize(count);
+        std::memcpy(offsets.data(), bytes, offsets.size() * sizeof(uint32));
+    }
+    return offsets;
+}
+
+template <typename T>
+std::vector<T> ReadVector(TraceReader& reader) {
+    uint32 count = reader.Read<uint32>();
+    std::vector<T> values;
+    for (uint32 i = 0; i < count && reader.IsValid(); ++i) {
+        values.push_back(reader.Read<T>());
+    }
+    return values;
+}
+
+} // anonymous namespace
+
+TraceReplayer::~TraceReplayer() {
+    Close();
+}
+
+bool TraceReplayer::ReadInfo(const std::string& path, TraceInfo& info) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open() || !ReadHeader(file, info)) {
+        return false;
+    }
+    std::error_code error;
+    info.fileBytes = std::filesystem::file_size(path, error);
+    return true;
+}
+
+bool TraceReplayer::Open(const std::string& path, Ref<GraphicsDevice> device) {
+    Close();
+    m_File.open(path, std::ios::binary);
+    if (!device || !m_File.is_open() || !ReadHeader(m_File, m_Info)) {
+        METAGFX_ERROR << "Cannot read the RHI trace " << path;
+        m_File.close();
+        return false;
+    }
+    std::error_code error;
+    m_Info.fileBytes = std::filesystem::file_size(path, error);
+    m_Device = std::move(device);
+    m_FrameIndex = 0;
+    m_Finished = false;
+
+    std::vector<const char*> features = GetFeatureNames(m_Device->GetDeviceInfo());
+    for (const std::string& feature : m_Info.features) {
+        if (std::none_of(features.begin(), features.end(), [&](const char* name) { return feature == name; })) {
+            METAGFX_WARN << "The trace was captured with " << feature << ", which "
+                         << m_Device->GetDeviceInfo().deviceName << " lacks; the replay may fail";
+        }
+    }
+    return true;
+}
+
+void TraceReplayer::Close() {
+    if (m_Device) {
+        m_Device->WaitIdle();
+        auto retire = [this](auto& objects) {
+            for (auto& [id, object] : objects) {
+                m_Device->Retire(object);
+            }
+            objects.clear();
+        };
+        retire(m_CommandBuffers);
+        retire(m_Framebuffers);
+        retire(m_DescriptorSets);
+        retire(m_Pipelines);
+        retire(m_Shaders);
+        retire(m_Samplers);
+        retire(m_Textures);
+        retire(m_Buffers);
+        m_Device->ReleaseRetired(true);
+        m_Device.reset();
+    }
+    m_File.close();
+    m_Record.clear();
+    m_Record.shrink_to_fit();
+    m_Names.clear();
+    m_Finished = true;
+}
+
+bool TraceReplayer::ReplayFrame(TraceFrameStats* stats) {
+    if (m_Finished) {
+        return false;
+    }
+
+    TraceFrameStats frame;
+    Clock::time_point frameStart = Clock::now();
+    bool present = false;
+    while (!present) {
+        TraceOp op{};
+        uint32 size = 0;
+        if (!ReadValue(m_File, op)) {
+            m_Finished = true;  // The end of the trace
+            break;
+        }
+        m_Record.resize(0);
+        if (ReadValue(m_File, size)) {
+            m_Record.resize(size);
+        }
+        if (m_Record.size() != size ||
+            (size > 0 && !m_File.read(reinterpret_cast<char*>(m_Record.data()), size))) {
+            METAGFX_ERROR << "The RHI trace is cut short in frame " << m_FrameIndex;
+            m_Finished = true;
+            break;
+        }
+
+        TraceReader payload(m_Record.data(), size);
+        Clock::time_point start = Clock::now();
+        if (!ReplayRecord(op, payload, frame, present) || !payload.IsValid()) {
+            METAGFX_ERROR << "Malformed RHI trace record " << static_cast<uint32>(op) << " in frame "
+                          << m_FrameIndex;
+            m_Finished = true;
+            break;
+        }
+        double ms = ElapsedMs(start);
+        switch (GetRecordKind(op)) {
+            case RecordKind::Resource: frame.resourceMs += ms; break;
+            case RecordKind::Upload: frame.uploadMs += ms; break;
+            case RecordKind::Present: frame.presentMs += ms; break;
+            case RecordKind::Submit: break;
+        }
+    }
+
+    frame.cpuMs = ElapsedMs(frameStart);
+    if (stats) {
+        *stats = frame;
+    }
+    if (present) {
+        ++m_FrameIndex;
+    }
+    return present;
+}
+
+const char* TraceReplayer::Intern(std::string name) {
+    return name.empty() ? nullptr : m_Names.insert(std::move(name)).first->c_str();
+}
+
+DescriptorBindingDesc TraceReplayer::ReadBinding(TraceReader& reader) const {
+    DescriptorBindingDesc binding;
+    binding.binding = reader.Read<uint32>();
+    binding.type = reader.Read<DescriptorType>();
+    binding.stageFlags = reader.Read<ShaderStage>();
+    binding.buffer = Find(m_Buffers, reader.Read<uint32>());
+    binding.texture = Find(m_Textures, reader.Read<uint32>());
+    binding.sampler = Find(m_Samplers, reader.Read<uint32>());
+    binding.range = reader.Read<uint64>();
+    binding.count = reader.Read<uint32>();
+    return binding;
+}
+
+void TraceReplayer::Destroy(TraceObject type, uint32 id) {
+    auto release = [this, id](auto& objects) {
+        auto it = objects.find(id);
+        if (it != objects.end()) {
+            m_Device->Retire(it->second);
+            objects.erase(it);
+        }
+    };
+    switch (type) {
+        case TraceObject::Buffer: release(m_Buffers); break;
+        case TraceObject::Texture: release(m_Textures); break;
+        case TraceObject::Sampler: release(m_Samplers); break;
+        case TraceObject::Shader: release(m_Shaders); break;
+        case TraceObject::Pipeline: release(m_Pipelines); break;
+        case TraceObject::Framebuffer: release(m_Framebuffers); break;
+        case TraceObject::DescriptorSet: release(m_DescriptorSets); break;
+        case TraceObject::CommandBuffer: release(m_CommandBuffers); break;
+    }
+}
+
+bool TraceReplayer::ReplayRecord(TraceOp op, TraceReader& payload, TraceFrameStats& stats, bool& present) {
+    // A resource the trace created that the device could not
+    auto created = [](const auto& object, const char* kind) {
+        if (!object) {
+            METAGFX_ERROR << "Replaying the RHI trace: failed to create a " << kind;
+        }
+        return object != nullptr;
+    };
+
+    switch (op) {
+        case TraceOp::CreateBuffer: {
+            uint32 id = payload.Read<uint32>();
+            BufferDesc desc;
+            desc.size = payload.Read<uint64>();
+            desc.usage = payload.Read<BufferUsage>();
+            desc.memoryUsage = payload.Read<MemoryUsage>();
+            desc.debugName = Intern(payload.ReadString());
+            Ref<Buffer> buffer = m_Device->CreateBuffer(desc);
+            m_Buffers[id] = buffer;
+            return created(buffer, "buffer");
+        }
+        case TraceOp::CreateTexture: {
+            uint32 id = payload.Read<uint32>();
+            TextureDesc desc;
+            desc.type = payload.Read<TextureType>();
+            desc.width = payload.Read<uint32>();
+            desc.height = payload.Read<uint32>();
+            desc.depth = payload.Read<uint32>();
+            desc.mipLevels = payload.Read<uint32>();
+            desc.arrayLayers = payload.Read<uint32>();
+            desc.format = payload.Read<Format>();
+            desc.usage = payload.Read<TextureUsage>();
+            desc.generateMipmaps = payload.Read<bool>();
+            desc.sampleCount = payload.Read<uint32>();
+            desc.debugName = Intern(payload.ReadString());
+            Ref<Texture> texture = m_Device->CreateTexture(desc);
+            m_Textures[id] = texture;
+            return created(texture, "texture");
+        }
+        case TraceOp::CreateSampler: {
+            uint32 id = payload.Read<uint32>();
+            Ref<Sampler> sampler = m_Device->CreateSampler(payload.Read<SamplerDesc>());
+            m_Samplers[id] = sampler;
+            return created(sampler, "sampler");
+        }
+        case TraceOp::CreateShader: {
+            uint32 id = payload.Read<uint32>();
+            ShaderDesc desc;
+            desc.stage = payload.Read<ShaderStage>();
+            uint64 size = 0;
+            const uint8* code = payload.ReadBlob(size);
+            desc.code.assign(code, code + size);
+            desc.entryPoint = payload.ReadString();
+            desc.debugName = Intern(payload.ReadString());
+            Ref<Shader> shader = m_Device->CreateShader(desc);
+            m_Shaders[id] = shader;
+            return created(shader, "shader");
+        }
+        case TraceOp::CreateGraphicsPipeline: {
+            uint32 id = payload.Read<uint32>();
+            PipelineDesc desc;
+            desc.vertexShader = Find(m_Shaders, payload.Read<uint32>());
+            desc.fragmentShader = Find(m_Shaders, payload.Read<uint32>());
+            desc.vertexInput.attributes = ReadVector<VertexAttribute>(payload);
+            desc.vertexInput.stride = payload.Read<uint32>();
+            desc.topology = payload.Read<PrimitiveTopology>();
+            desc.rasterization = payload.Read<RasterizationState>();
+            desc.depthStencil = payload.Read<DepthStencilState>();
+            desc.colorAttachments = ReadVector<ColorAttachmentState>(payload);
+            desc.debugName = Intern(payload.ReadString());
+            desc.vertexInputState.bindings = ReadVector<VertexInputBinding>(payload);
+            desc.vertexInputState.attributes = ReadVector<VertexAttribute>(payload);
+            desc.colorFormats = ReadVector<Format>(payload);
+            desc.depthFormat = payload.Read<Format>();
+            desc.sampleCount = payload.Read<uint32>();
+            desc.viewCount = payload.Read<uint32>();
+            desc.specializationConstants = ReadVector<SpecializationConstant>(payload);
+            desc.descriptorSetLayout = Find(m_DescriptorSets, payload.Read<uint32>());
+            for (uint32 layout : ReadVector<uint32>(payload)) {
+                desc.extraSetLayouts.push_back(Find(m_DescriptorSets, layout));
+            }
+            Ref<Pipeline> pipeline = m_Device->CreateGraphicsPipeline(desc);
+            m_Pipelines[id] = pipeline;
+            return created(pipeline, "graphics pipeline");
+        }
+        case TraceOp::CreateComputePipeline: {
+            uint32 id = payload.Read<uint32>();
+            ComputePipelineDesc desc;
+            desc.computeShader = Find(m_Shaders, payload.Read<uint32>());
+            desc.pushConstantSize = payload.Read<uint32>();
+            desc.debugName = Intern(payload.ReadString());
+            desc.descriptorSetLayout = Find(m_DescriptorSets, payload.Read<uint32>());
+            Ref<Pipeline> pipeline = m_Device->CreateComputePipeline(desc);
+            m_Pipelines[id] = pipeline;
+            return created(pipeline, "compute pipeline");
+        }
+        case TraceOp::CreateFramebuffer: {
+            uint32 id = payload.Read<uint32>();
+            FramebufferDesc desc;
+            desc.depthAttachment = Find(m_Textures, payload.Read<uint32>());
+            for (uint32 texture : ReadVector<uint32>(payload)) {
+                desc.colorAttachments.push_back(Find(m_Textures, texture));
+            }
+            desc.debugName = Intern(payload.ReadString());
+            Ref<Framebuffer> framebuffer = m_Device->CreateFramebuffer(desc);
+            m_Framebuffers[id] = framebuffer;
+            return created(framebuffer, "framebuffer");
+        }
+        case TraceOp::CreateDescriptorSet: {
+            uint32 id = payload.Read<uint32>();
+            DescriptorSetDesc desc;
+            uint32 bindingCount = payload.Read<uint32>();
+            for (uint32 i = 0; i < bindingCount && payload.IsValid(); ++i) {
+                desc.bindings.push_back(ReadBinding(payload));
+            }
+            desc.debugName = Intern(payload.ReadString());
+            desc.pushDescriptors = payload.Read<bool>();
+            Ref<DescriptorSet> descriptorSet = m_Device->CreateDescriptorSet(desc);
+            m_DescriptorSets[id] = descriptorSet;
+            return created(descriptorSet, "descriptor set");
+        }
+        case TraceOp::CreateCommandBuffer: {
+            uint32 id = payload.Read<uint32>();
+            Ref<CommandBuffer> commandBuffer = m_Device->CreateCommandBuffer();
+            m_CommandBuffers[id] = commandBuffer;
+            return created(commandBuffer, "command buffer");
+        }
+        case TraceOp::Destroy: {
+            TraceObject type = payload.Read<TraceObject>();
+            Destroy(type, payload.Read<uint32>());
+            return true;
+        }
+        case TraceOp::BufferData: {
+            Ref<Buffer> buffer = Find(m_Buffers, payload.Read<uint32>());
+            uint64 offset = payload.Read<uint64>();
+            uint64 size = 0;
+            const uint8* data = payload.ReadBlob(size);
+            if (!buffer || !data) {
+                return false;
+            }
+            buffer->CopyData(data, size, offset);
+            stats.uploadBytes += size;
+            return true;
+        }
+        case TraceOp::TextureData: {
+            Ref<Texture> texture = Find(m_Textures, payload.Read<uint32>());
+            uint32 levelCount = payload.Read<uint32>();
+            std::vector<TextureLevelData> levels;
+            for (uint32 i = 0; i < levelCount && payload.IsValid(); ++i) {
+                TextureLevelData level;
+                level.data = payload.ReadBlob(level.size);
+                levels.push_back(level);
+                stats.uploadBytes += level.size;
+            }
+            if (!texture || !payload.IsValid() || levels.empty()) {
+                return false;
+            }
+            if (levels.size() == 1) {
+                texture->UploadData(levels[0].data, levels[0].size);
+            } else {
+                texture->UploadLevels(levels.data(), levelCount);
+            }
+            return true;
+        }
+        case TraceOp::UpdateBuffer: {
+            Ref<DescriptorSet> descriptorSet = Find(m_DescriptorSets, payload.Read<uint32>());
+            uint32 binding = payload.Read<uint32>();
+            Ref<Buffer> buffer = Find(m_Buffers, payload.Read<uint32>());
+            if (!descriptorSet) {
+                return false;
+            }
+            descriptorSet->UpdateBuffer(binding, buffer);
+            return true;
+        }
+        case TraceOp::UpdateTexture: {
+            Ref<DescriptorSet> descriptorSet = Find(m_DescriptorSets, payload.Read<uint32>());
+            uint32 binding = payload.Read<uint32>();
+            Ref<Texture> texture = Find(m_Textures, payload.Read<uint32>());
+            Ref<Sampler> sampler = Find(m_Samplers, payload.Read<uint32>());
+            if (!descriptorSet) {
+                return false;
+            }
+            descriptorSet->UpdateTexture(binding, texture, sampler);
+            return true;
+        }
+        case TraceOp::UpdateTextureArrayElement: {
+            Ref<DescriptorSet> descriptorSet = Find(m_DescriptorSets, payload.Read<uint32>());
+            uint32 binding = payload.Read<uint32>();
+            uint32 arrayElement = payload.Read<uint32>();
+            Ref<Texture> texture = Find(m_Textures, payload.Read<uint32>());
+            Ref<Sampler> sampler = Find(m_Samplers, payload.Read<uint32>());
+            if (!descriptorSet) {
+                return false;
+            }
+            descriptorSet->UpdateTextureArrayElement(binding, arrayElement, texture, sampler);
+            return true;
+        }
+        case TraceOp::BeginFrame: {
+            payload.Read<uint32>();  // The capture's frame index; the device has its own
+            uint32 id = payload.Read<uint32>();
+            m_CommandBuffers[id] = m_Device->BeginFrame().commandBuffer;
+            return true;
+        }
+        case TraceOp::Submit: {
+            Ref<CommandBuffer> commandBuffer = Find(m_CommandBuffers, payload.Read<uint32>());
+            if (!commandBuffer) {
+                return false;
+            }
+            Clock::time_point start = Clock::now();
+            if (!ReplayCommands(*commandBuffer, payload, stats)) {
+                return false;
+            }
+            stats.recordMs += ElapsedMs(start);
+            start = Clock::now();
+            m_Device->SubmitCommandBuffer(commandBuffer);
+            stats.submitMs += ElapsedMs(start);
+            ++stats.submits;
+            return true;
+        }
+        case TraceOp::WaitIdle:
+            m_Device->WaitIdle();
+            return true;
+        case TraceOp::BackBuffer: {
+            uint32 id = payload.Read<uint32>();
+            Ref<SwapChain> swapChain = m_Device->GetSwapChain();
+            m_Textures[id] = swapChain ? swapChain->GetCurrentBackBuffer() : nullptr;
+            return swapChain != nullptr;
+        }
+        case TraceOp::Present:
+            if (Ref<SwapChain> swapChain = m_Device->GetSwapChain()) {
+                swapChain->Present();
+            }
+            present = true;
+            return true;
+        case TraceOp::Resize: {
+            uint32 width = payload.Read<uint32>();
+            uint32 height = payload.Read<uint32>();
+            if (Ref<SwapChain> swapChain = m_Device->GetSwapChain()) {
+                swapChain->Resize(width, height);
+            }
+            return true;
+        }
+        case TraceOp::SetPresentMode:
+            if (Ref<SwapChain> swapChain = m_Device->GetSwapChain()) {
+                swapChain->SetPresentMode(payload.Read<PresentMode>());
+            }
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool TraceReplayer::ReplayCommands(CommandBuffer& cmd, TraceReader& commands, TraceFrameStats& stats) {
+    std::vector<Ref<Texture>> colors;
+    std::vector<Ref<Texture>> resolves;
+    std::vector<ClearValue> clearValues;
+    auto readTextures = [this](TraceReader& reader, std::vector<Ref<Texture>>& textures) {
+        textures.clear();
+        for (uint32 id : ReadVector<uint32>(reader)) {
+            textures.push_back(Find(m_Textures, id));
+        }
+    };
+    uint32 frameCount = m_Device->GetDeviceInfo().framesInFlight;
+
+    TraceOp op{};
+    TraceReader args;
+    while (commands.NextRecord(op, args)) {
+        ++stats.commands;
+        switch (op) {
+            case TraceOp::Begin:
+                cmd.Begin();
+                break;
+            case TraceOp::End:
+                cmd.End();
+                break;
+            case TraceOp::BeginRendering:
+            case TraceOp::BeginParallelRendering: {
+                readTextures(args, colors);
+                Ref<Texture> depth = Find(m_Textures, args.Read<uint32>());
+                clearValues = ReadVector<ClearValue>(args);
+                RenderPassActions actions = args.Read<RenderPassActions>();
+                readTextures(args, resolves);
+                Ref<Texture> shadingRate = Find(m_Textures, args.Read<uint32>());
+                if (op == TraceOp::BeginRendering) {
+                    cmd.BeginRendering(colors, depth, clearValues, actions, resolves, shadingRate);
+                } else {
+                    uint32 secondaryCount = args.Read<uint32>();
+                    cmd.BeginParallelRendering(colors, depth, clearValues, secondaryCount, actions, resolves,
+                                               shadingRate);
+                }
+                break;
+            }
+            case TraceOp::EndRendering:
+                cmd.EndRendering();
+                break;
+            case TraceOp::Secondary: {
+                Ref<CommandBuffer> secondary = cmd.GetSecondaryCommandBuffer(args.Read<uint32>());
+                uint64 size = 0;
+                const uint8* bytes = args.ReadBlob(size);
+                TraceReader secondaryCommands(bytes, size);
+                if (!secondary || !bytes || !ReplayCommands(*secondary, secondaryCommands, stats)) {
+                    return false;
+                }
+                break;
+            }
+            case TraceOp::EndParallelRendering:
+                cmd.EndParallelRendering();
+                break;
+            case TraceOp::BindPipeline:
+                cmd.BindPipeline(Find(m_Pipelines, args.Read<uint32>()));
+                break;
+            case TraceOp::SetViewport:
+                cmd.SetViewport(args.Read<Viewport>());
+                break;
+            case TraceOp::SetScissor:
+                cmd.SetScissor(args.Read<Rect2D>());
+                break;
+            case TraceOp::BindVertexBuffer: {
+                Ref<Buffer> buffer = Find(m_Buffers, args.Read<uint32>());
+                cmd.BindVertexBuffer(buffer, args.Read<uint64>());
+                break;
+            }
+            case TraceOp::BindIndexBuffer: {
+                Ref<Buffer> buffer = Find(m_Buffers, args.Read<uint32>());
+                cmd.BindIndexBuffer(buffer, args.Read<uint64>());
+                break;
+            }
+            case TraceOp::Draw: {
+                uint32 vertexCount = args.Read<uint32>();
+                uint32 instanceCount = args.Read<uint32>();
+                uint32 firstVertex = args.Read<uint32>();
+                cmd.Draw(vertexCount, instanceCount, firstVertex, args.Read<uint32>());
+                break;
+            }
+            case TraceOp::DrawIndexed: {
+                uint32 indexCount = args.Read<uint32>();
+                uint32 instanceCount = args.Read<uint32>();
+                uint32 firstIndex = args.Read<uint32>();
+                int32 vertexOffset = args.Read<int32>();
+                cmd.DrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, args.Read<uint32>());
+                break;
+            }
+            case TraceOp::DrawIndexedIndirect: {
+                Ref<Buffer> argumentBuffer = Find(m_Buffers, args.Read<uint32>());
+                uint64 offset = args.Read<uint64>();
+                uint32 drawCount = args.Read<uint32>();
+                cmd.DrawIndexedIndirect(argumentBuffer, offset, drawCount, args.Read<uint32>());
+                break;
+            }
+            case TraceOp::DrawIndexedIndirectCount: {
+                Ref<Buffer> argumentBuffer = Find(m_Buffers, args.Read<uint32>());
+                uint64 offset = args.Read<uint64>();
+                Ref<Buffer> countBuffer = Find(m_Buffers, args.Read<uint32>());
+                uint64 countOffset = args.Read<uint64>();
+                uint32 maxDrawCount = args.Read<uint32>();
+                cmd.DrawIndexedIndirectCount(argumentBuffer, offset, countBuffer, countOffset, maxDrawCount,
+                                             args.Read<uint32>());
+                break;
+            }
+            case TraceOp::Dispatch: {
+                uint32 groupCountX = args.Read<uint32>();
+                uint32 groupCountY = args.Read<uint32>();
+                cmd.Dispatch(groupCountX, groupCountY, args.Read<uint32>());
+                break;
+            }
+            case TraceOp::DispatchIndirect: {
+                Ref<Buffer> argumentBuffer = Find(m_Buffers, args.Read<uint32>());
+                cmd.DispatchIndirect(argumentBuffer, args.Read<uint64>());
+                break;
+            }
+            case TraceOp::CopyBuffer: {
+                Ref<Buffer> src = Find(m_Buffers, args.Read<uint32>());
+                Ref<Buffer> dst = Find(m_Buffers, args.Read<uint32>());
+                uint64 size = args.Read<uint64>();
+                uint64 srcOffset = args.Read<uint64>();
+                cmd.CopyBuffer(src, dst, size, srcOffset, args.Read<uint64>());
+                break;
+            }
+            case TraceOp::CopyTextureToBuffer: {
+                Ref<Texture> src = Find(m_Textures, args.Read<uint32>());
+                Ref<Buffer> dst = Find(m_Buffers, args.Read<uint32>());
+                cmd.CopyTextureToBuffer(src, dst, args.Read<uint64>());
+                break;
+            }
+            case TraceOp::BindDescriptorSet: {
+                Ref<Pipeline> pipeline = Find(m_Pipelines, args.Read<uint32>());
+                uint32 setIndex = args.Read<uint32>();
+                Ref<DescriptorSet> descriptorSet = Find(m_DescriptorSets, args.Read<uint32>());
+                // Within the device's slots, should it have fewer than the capture
+                uint32 frameIndex = args.Read<uint32>() % frameCount;
+                std::vector<uint32> offsets = ReadDynamicOffsets(args);
+                cmd.BindDescriptorSet(pipeline, setIndex, descriptorSet, frameIndex,
+                                      offsets.empty() ? nullptr : offsets.data(), static_cast<uint32>(offsets.size()));
+                break;
+            }
+            case TraceOp::PushDescriptorSet: {
+                Ref<Pipeline> pipeline = Find(m_Pipelines, args.Read<uint32>());
+                uint32 setIndex = args.Read<uint32>();
+                std::vector<DescriptorBindingDesc> bindings;
+                uint32 bindingCount = args.Read<uint32>();
+                for (uint32 i = 0; i < bindingCount && args.IsValid(); ++i) {
+                    bindings.push_back(ReadBinding(args));
+                }
+                std::vector<uint32> offsets = ReadDynamicOffsets(args);
+                cmd.PushDescriptorSet(pipeline, setIndex, bindings, offsets.empty() ? nullptr : offsets.data(),
+                                      static_cast<uint32>(offsets.size()));
+                break;
+            }
+            case TraceOp::PushConstants: {
+                Ref<Pipeline> pipeline = Find(m_Pipelines, args.Read<uint32>());
+                ShaderStage stages = args.Read<ShaderStage>();
+                uint32 offset = args.Read<uint32>();
+                uint64 size = 0;
+                const uint8* data = args.ReadBlob(size);
+                cmd.PushConstants(pipeline, stages, offset, static_cast<uint32>(size), data);
+                break;
+            }
+            case TraceOp::BufferMemoryBarrier:
+                cmd.BufferMemoryBarrier(Find(m_Buffers, args.Read<uint32>()));
+                break;
+            case TraceOp::PipelineBarrier:
+                cmd.PipelineBarrier(args.Read<BarrierType>());
+                break;
+            case TraceOp::ResourceBarrier: {
+                std::vector<TextureBarrier> textureBarriers;
+                uint32 textureBarrierCount = args.Read<uint32>();
+                for (uint32 i = 0; i < textureBarrierCount && args.IsValid(); ++i) {
+                    TextureBarrier& barrier = textureBarriers.emplace_back();
+                    barrier.texture = Find(m_Textures, args.Read<uint32>());
+                    barrier.before = args.Read<ResourceState>();
+                    barrier.after = args.Read<ResourceState>();
+                }
+                std::vector<BufferBarrier> bufferBarriers;
+                uint32 bufferBarrierCount = args.Read<uint32>();
+                for (uint32 i = 0; i < bufferBarrierCount && args.IsValid(); ++i) {
+                    BufferBarrier& barrier = bufferBarriers.emplace_back();
+                    barrier.buffer = Find(m_Buffers, args.Read<uint32>());
+                    barrier.before = args.Read<ResourceState>();
+                    barrier.after = args.Read<ResourceState>();
+                }
+                cmd.ResourceBarrier(textureBarriers.data(), static_cast<uint32>(textureBarriers.size()),
+                                    bufferBarriers.data(), static_cast<uint32>(bufferBarriers.size()));
+                break;
+            }
+            case TraceOp::InvalidateState:
+                cmd.InvalidateState();
+                break;
+            default:
+                return false;
+        }
+        if (!args.IsValid()) {
+            return false;
+        }
+    }
+    return commands.IsValid();
+}
+
+} // namespace rhi
+} // namespace metagfx
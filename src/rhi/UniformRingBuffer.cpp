@@ -0,0 +1,79 @@
+// ============================================================================
+// src/rhi/UniformRingBuffer.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/UniformRingBuffer.h"
+
+#include <cstring>
+
+namespace metagfx {
+namespace rhi {
+
+static uint64 AlignUp(uint64 value, uint64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+UniformRingBuffer::UniformRingBuffer(Ref<GraphicsDevice> device, uint64 bytesPerFrame, uint32 framesInFlight)
+    : m_FramesInFlight(framesInFlight) {
+
+    m_Alignment = device->GetDeviceInfo().minUniformBufferOffsetAlignment;
+    if (m_Alignment == 0) {
+        m_Alignment = 256;
+    }
+
+    // Each region must start on an aligned boundary so offsets stay aligned
+    m_BytesPerFrame = AlignUp(bytesPerFrame, m_Alignment);
+
+    BufferDesc desc{};
+    desc.size = m_BytesPerFrame * m_FramesInFlight;
+    desc.usage = BufferUsage::Uniform;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    m_Buffer = device->CreateBuffer(desc);
+
+    if (!m_Buffer) {
+        METAGFX_ERROR << "UniformRingBuffer: failed to create " << desc.size << " byte buffer";
+        return;
+    }
+
+    m_MappedData = static_cast<uint8*>(m_Buffer->GetMappedPointer());
+
+    METAGFX_INFO << "Uniform ring buffer: " << m_FramesInFlight << " x " << m_BytesPerFrame
+                 << " bytes (alignment " << m_Alignment << ")";
+}
+
+void UniformRingBuffer::BeginFrame(uint32 frameIndex) {
+    m_FrameBase = static_cast<uint64>(frameIndex % m_FramesInFlight) * m_BytesPerFrame;
+    m_Offset = m_FrameBase;
+}
+
+uint32 UniformRingBuffer::Allocate(uint64 size) {
+    uint64 offset = AlignUp(m_Offset, m_Alignment);
+    if (offset + size > m_FrameBase + m_BytesPerFrame) {
+        if (!m_OverflowReported) {
+            METAGFX_ERROR << "UniformRingBuffer: frame region of " << m_BytesPerFrame
+                          << " bytes exhausted, increase bytesPerFrame";
+            m_OverflowReported = true;
+        }
+        return static_cast<uint32>(m_FrameBase);
+    }
+
+    m_Offset = offset + size;
+    return static_cast<uint32>(offset);
+}
+
+uint32 UniformRingBuffer::Push(const void* data, uint64 size) {
+    uint32 offset = Allocate(size);
+    if (!m_Buffer) {
+        return offset;
+    }
+
+    if (m_MappedData) {
+        std::memcpy(m_MappedData + offset, data, size);
+    } else {
+        m_Buffer->CopyData(data, size, offset);
+    }
+    return offset;
+}
+
+} // namespace rhi
+} // namespace metagfx
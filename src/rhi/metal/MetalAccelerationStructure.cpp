@@ -0,0 +1,246 @@
+// ============================================================================
+// src/rhi/metal/MetalAccelerationStructure.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalAccelerationStructure.h"
+#include "metagfx/rhi/metal/MetalBuffer.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+static bool ToMetalVertexFormat(Format format, MTL::AttributeFormat& outFormat) {
+    switch (format) {
+        case Format::R32G32B32_SFLOAT:   outFormat = MTL::AttributeFormatFloat3; return true;
+        case Format::R16G16B16A16_UNORM: outFormat = MTL::AttributeFormatUShort4Normalized; return true;
+        default:                         return false;
+    }
+}
+
+static void Release(MTL::Buffer*& buffer, MetalContext& context) {
+    if (buffer) {
+        context.memory->Remove(MemoryCategory::AccelerationStructure, buffer->allocatedSize());
+        buffer->release();
+        buffer = nullptr;
+    }
+}
+
+static MTL::Buffer* NewBuffer(MetalContext& context, uint64 size, MTL::ResourceOptions options) {
+    MTL::Buffer* buffer = context.device->newBuffer(std::max<uint64>(size, 4), options);
+    if (buffer) {
+        context.stats->AddAllocation();
+        context.memory->Add(MemoryCategory::AccelerationStructure, buffer->allocatedSize());
+    }
+    return buffer;
+}
+
+MetalAccelerationStructure::MetalAccelerationStructure(MetalContext& context, const AccelerationStructureDesc& desc,
+                                                       uint64 storageSize)
+    : AccelerationStructure(desc), m_Context(context) {
+    MTL::AccelerationStructureUsage usage = MTL::AccelerationStructureUsageNone;
+    if (HasFlag(desc.flags, AccelerationStructureFlags::AllowUpdate)) {
+        usage |= MTL::AccelerationStructureUsageRefit;
+    }
+    if (HasFlag(desc.flags, AccelerationStructureFlags::PreferFastBuild)) {
+        usage |= MTL::AccelerationStructureUsagePreferFastBuild;
+    }
+
+    if (desc.type == AccelerationStructureType::TopLevel) {
+        if (desc.maxInstances == 0) {
+            METAGFX_ERROR << "Top-level acceleration structure without instances";
+            return;
+        }
+        uint64 regionSize = uint64(desc.maxInstances) * sizeof(MTL::AccelerationStructureUserIDInstanceDescriptor);
+        m_Instances = NewBuffer(m_Context, regionSize * m_Context.framesInFlight, MTL::ResourceStorageModeShared);
+        if (!m_Instances) {
+            return;
+        }
+
+        // Sized for maxInstances; each build sets its own count and bottom levels
+        auto* instanceDesc = MTL::InstanceAccelerationStructureDescriptor::descriptor();
+        instanceDesc->setInstanceDescriptorType(MTL::AccelerationStructureInstanceDescriptorTypeUserID);
+        instanceDesc->setInstanceDescriptorBuffer(m_Instances);
+        instanceDesc->setInstanceDescriptorStride(sizeof(MTL::AccelerationStructureUserIDInstanceDescriptor));
+        instanceDesc->setInstanceCount(desc.maxInstances);
+        instanceDesc->setUsage(usage);
+        m_Descriptor = instanceDesc->retain();
+    } else {
+        std::vector<NS::Object*> geometries;
+        for (const AccelerationStructureGeometry& input : desc.geometries) {
+            auto* vertexBuffer = static_cast<MetalBuffer*>(input.vertexBuffer.get());
+            auto* indexBuffer = static_cast<MetalBuffer*>(input.indexBuffer.get());
+            MTL::AttributeFormat vertexFormat;
+            if (!ToMetalVertexFormat(input.vertexFormat, vertexFormat)) {
+                METAGFX_WARN << "Acceleration structure vertex format " << static_cast<int>(input.vertexFormat)
+                             << " is not supported";
+                return;
+            }
+            if (!vertexBuffer || !indexBuffer || input.vertexCount == 0 || input.indexCount < 3) {
+                METAGFX_ERROR << "Acceleration structure geometry needs vertices and indices";
+                return;
+            }
+
+            auto* triangles = MTL::AccelerationStructureTriangleGeometryDescriptor::descriptor();
+            triangles->setVertexBuffer(vertexBuffer->GetHandle());
+            triangles->setVertexBufferOffset(input.vertexOffset);
+            triangles->setVertexFormat(vertexFormat);
+            triangles->setVertexStride(input.vertexStride);
+            triangles->setIndexBuffer(indexBuffer->GetHandle());
+            triangles->setIndexBufferOffset(input.indexOffset);
+            triangles->setIndexType(MTL::IndexTypeUInt32);
+            triangles->setTriangleCount(input.indexCount / 3);
+            triangles->setOpaque(input.opaque);
+            geometries.push_back(triangles);
+        }
+        if (geometries.empty()) {
+            METAGFX_ERROR << "Bottom-level acceleration structure without geometry";
+            return;
+        }
+
+        auto* primitiveDesc = MTL::PrimitiveAccelerationStructureDescriptor::descriptor();
+        primitiveDesc->setGeometryDescriptors(NS::Array::array(geometries.data(), geometries.size()));
+        primitiveDesc->setUsage(usage);
+        m_Descriptor = primitiveDesc->retain();
+    }
+
+    MTL::AccelerationStructureSizes sizes = m_Context.device->accelerationStructureSizes(m_Descriptor);
+    m_BuildScratchSize = sizes.buildScratchBufferSize;
+    m_RefitScratchSize = sizes.refitScratchBufferSize;
+
+    m_Structure = m_Context.device->newAccelerationStructure(storageSize != 0 ? storageSize
+                                                                              : sizes.accelerationStructureSize);
+    if (!m_Structure) {
+        MTL_LOG_ERROR("Failed to create acceleration structure");
+        return;
+    }
+    m_Context.stats->AddAllocation();
+    m_AccountedSize = m_Structure->allocatedSize();
+    m_Context.memory->Add(MemoryCategory::AccelerationStructure, m_AccountedSize);
+
+    if (desc.debugName) {
+        NS::String* label = NS::String::string(desc.debugName, NS::UTF8StringEncoding);
+        m_Structure->setLabel(label);
+        label->release();
+    }
+
+    // Refits happen every frame, so they keep their scratch rather than allocating a batch's
+    if (HasFlag(desc.flags, AccelerationStructureFlags::AllowUpdate)) {
+        m_Scratch = NewBuffer(m_Context, std::max(m_BuildScratchSize, m_RefitScratchSize),
+                              MTL::ResourceStorageModePrivate);
+    }
+    if (HasFlag(desc.flags, AccelerationStructureFlags::AllowCompaction)) {
+        m_CompactedSizeBuffer = NewBuffer(m_Context, sizeof(uint32), MTL::ResourceStorageModeShared);
+    }
+}
+
+MetalAccelerationStructure::~MetalAccelerationStructure() {
+    if (m_CompactionCommandBuffer) {
+        m_CompactionCommandBuffer->release();
+    }
+    Release(m_CompactedSizeBuffer, m_Context);
+    Release(m_Scratch, m_Context);
+    Release(m_Instances, m_Context);
+    if (m_Structure) {
+        m_Context.memory->Remove(MemoryCategory::AccelerationStructure, m_AccountedSize);
+        m_Structure->release();
+    }
+    if (m_Descriptor) {
+        m_Descriptor->release();
+    }
+}
+
+bool MetalAccelerationStructure::EncodeBuild(MTL::CommandBuffer* commandBuffer,
+                                             MTL::AccelerationStructureCommandEncoder* encoder,
+                                             const AccelerationStructureBuild& build, MTL::Buffer* batchScratch,
+                                             uint64 scratchOffset) {
+    if (!IsValid()) {
+        return false;
+    }
+    bool refit = build.update && m_Built && HasFlag(m_Desc.flags, AccelerationStructureFlags::AllowUpdate);
+
+    if (m_Desc.type == AccelerationStructureType::TopLevel) {
+        uint32 count = std::min(build.instanceCount, m_Desc.maxInstances);
+        if (build.instanceCount > m_Desc.maxInstances) {
+            METAGFX_WARN << "Acceleration structure build of " << build.instanceCount << " instances, "
+                         << m_Desc.maxInstances << " fit";
+        }
+
+        // The region of the build encoded framesInFlight builds ago, which the GPU is done with
+        m_InstanceRegion = (m_InstanceRegion + 1) % m_Context.framesInFlight;
+        uint64 regionOffset =
+            uint64(m_InstanceRegion) * m_Desc.maxInstances * sizeof(MTL::AccelerationStructureUserIDInstanceDescriptor);
+        auto* instances = reinterpret_cast<MTL::AccelerationStructureUserIDInstanceDescriptor*>(
+            static_cast<uint8*>(m_Instances->contents()) + regionOffset);
+
+        // Instances name their bottom level by its index in the descriptor's array
+        m_BottomLevels.clear();
+        for (uint32 i = 0; i < count; ++i) {
+            const AccelerationStructureInstance& source = build.instances[i];
+            const auto* bottomLevel = static_cast<const MetalAccelerationStructure*>(source.bottomLevel);
+            MTL::AccelerationStructure* handle = bottomLevel ? bottomLevel->GetHandle() : nullptr;
+            auto found = std::find(m_BottomLevels.begin(), m_BottomLevels.end(), handle);
+            uint32 index = static_cast<uint32>(found - m_BottomLevels.begin());
+            if (found == m_BottomLevels.end()) {
+                m_BottomLevels.push_back(handle);
+            }
+
+            MTL::AccelerationStructureUserIDInstanceDescriptor& instance = instances[i];
+            const float (&t)[3][4] = source.transform;
+            instance.transformationMatrix = MTL::PackedFloat4x3(
+                MTL::PackedFloat3(t[0][0], t[1][0], t[2][0]), MTL::PackedFloat3(t[0][1], t[1][1], t[2][1]),
+                MTL::PackedFloat3(t[0][2], t[1][2], t[2][2]), MTL::PackedFloat3(t[0][3], t[1][3], t[2][3]));
+            instance.options = MTL::AccelerationStructureInstanceOptionNone;
+            instance.mask = source.mask;
+            instance.intersectionFunctionTableOffset = 0;
+            instance.accelerationStructureIndex = index;
+            instance.userID = source.instanceID & 0xFFFFFF;
+        }
+        // A refit keeps the instances' bottom levels
+        refit = refit && count == m_BuiltInstanceCount && m_BottomLevels == m_BuiltBottomLevels;
+        m_BuiltInstanceCount = count;
+        m_BuiltBottomLevels = m_BottomLevels;
+        m_BottomLevelResources.assign(m_BottomLevels.begin(), m_BottomLevels.end());
+
+        std::vector<NS::Object*> bottomLevels(m_BottomLevels.begin(), m_BottomLevels.end());
+        auto* instanceDesc = static_cast<MTL::InstanceAccelerationStructureDescriptor*>(m_Descriptor);
+        instanceDesc->setInstancedAccelerationStructures(NS::Array::array(bottomLevels.data(), bottomLevels.size()));
+        instanceDesc->setInstanceDescriptorBufferOffset(regionOffset);
+        instanceDesc->setInstanceCount(count);
+    }
+
+    MTL::Buffer* scratch = m_Scratch ? m_Scratch : batchScratch;
+    uint64 offset = m_Scratch ? 0 : scratchOffset;
+    if (refit) {
+        encoder->refitAccelerationStructure(m_Structure, m_Descriptor, m_Structure, scratch, offset);
+    } else {
+        encoder->buildAccelerationStructure(m_Structure, m_Descriptor, scratch, offset);
+    }
+    m_Built = true;
+    m_CompactedSize = 0;
+
+    if (m_CompactedSizeBuffer) {
+        encoder->writeCompactedAccelerationStructureSize(m_Structure, m_CompactedSizeBuffer, 0);
+        if (m_CompactionCommandBuffer) {
+            m_CompactionCommandBuffer->release();
+        }
+        m_CompactionCommandBuffer = commandBuffer->retain();
+    }
+    return true;
+}
+
+uint64 MetalAccelerationStructure::GetCompactedSize() {
+    if (m_CompactedSize != 0 || !m_CompactionCommandBuffer) {
+        return m_CompactedSize;
+    }
+    if (m_CompactionCommandBuffer->status() != MTL::CommandBufferStatusCompleted) {
+        return 0;
+    }
+    m_CompactedSize = *static_cast<const uint32*>(m_CompactedSizeBuffer->contents());
+    m_CompactionCommandBuffer->release();
+    m_CompactionCommandBuffer = nullptr;
+    return m_CompactedSize;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -3,6 +3,9 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/metal/MetalBuffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/metal/MetalHeapAllocator.h"
+#include "metagfx/rhi/metal/MetalUploadManager.h"
 
 #include <cstring>
 
@@ -13,15 +16,23 @@ MetalBuffer::MetalBuffer(MetalContext& context, const BufferDesc& desc)
     : m_Context(context)
     , m_Size(desc.size)
     , m_Usage(desc.usage)
-    , m_MemoryUsage(desc.memoryUsage) {
+    , m_MemoryUsage(desc.memoryUsage)
+    , m_MemoryCategory(GetBufferMemoryCategory(desc)) {
 
     MTL::ResourceOptions options = ToMetalResourceOptions(desc.memoryUsage);
 
-    m_Buffer = m_Context.device->newBuffer(desc.size, options);
+    m_Buffer = m_Context.heapAllocator->NewBuffer(desc.size, options, GraphicsDevice::GetCurrentResourceGroup(),
+                                                  m_Heap);
+    if (!m_Buffer) {
+        m_Buffer = m_Context.device->newBuffer(desc.size, options);
+        m_Context.stats->AddAllocation();
+    }
 
     if (!m_Buffer) {
         MTL_LOG_ERROR("Failed to create buffer");
+        return;
     }
+    m_Context.memory->Add(m_MemoryCategory, m_Buffer->allocatedSize());
 
     if (desc.debugName) {
         NS::String* label = NS::String::string(desc.debugName, NS::UTF8StringEncoding);
@@ -32,8 +43,10 @@ MetalBuffer::MetalBuffer(MetalContext& context, const BufferDesc& desc)
 
 MetalBuffer::~MetalBuffer() {
     if (m_Buffer) {
+        m_Context.memory->Remove(m_MemoryCategory, m_Buffer->allocatedSize());
         m_Buffer->release();
         m_Buffer = nullptr;
+        m_Context.heapAllocator->Release(m_Heap);
     }
 }
 
@@ -48,31 +61,64 @@ void* MetalBuffer::Map() {
 }
 
 void MetalBuffer::Unmap() {
-    // Metal shared buffers don't need explicit unmap
-    // For managed buffers on macOS, we would call didModifyRange:
-#if TARGET_OS_OSX
-    if (m_MemoryUsage == MemoryUsage::CPUToGPU) {
-        m_Buffer->didModifyRange(NS::Range::Make(0, m_Size));
-    }
-#endif
+    // CPU-visible buffers use StorageModeShared, which needs no unmap or
+    // didModifyRange (that is only valid for StorageModeManaged)
 }
 
 void MetalBuffer::CopyData(const void* data, uint64 size, uint64 offset) {
+    if (!data) {
+        return;
+    }
+    WriteData(size, offset, [data, size](void* destination) {
+        memcpy(destination, data, size);
+    });
+}
+
+void MetalBuffer::WriteData(uint64 size, uint64 offset, const WriteCallback& write) {
+    if (!m_Buffer || size == 0) {
+        return;
+    }
+
+    if (offset + size > m_Size) {
+        MTL_LOG_ERROR("Buffer copy out of bounds: offset=" << offset << ", size=" << size
+                      << ", buffer size=" << m_Size);
+        return;
+    }
+    m_Context.stats->AddBufferUpload(size);
+
     if (m_MemoryUsage == MemoryUsage::GPUOnly) {
-        MTL_LOG_ERROR("Cannot copy data to GPU-only buffer directly");
+        // Private storage has no CPU address: the data is written into staging memory and
+        // blitted. The blit is committed ahead of the next frame on the same queue, so no
+        // CPU wait is needed; IsUploadComplete() polls its ticket.
+        MTL::Buffer* staging = m_Context.uploadManager->NewStagingBuffer(size);
+        if (!staging) {
+            return;
+        }
+        write(staging->contents());
+        m_UploadTicket = m_Context.uploadManager->Submit(staging, [&](MTL::CommandBuffer* cmdBuffer) {
+            MTL::BlitCommandEncoder* blit = cmdBuffer->blitCommandEncoder();
+            blit->copyFromBuffer(staging, 0, m_Buffer, offset, size);
+            blit->endEncoding();
+        });
         return;
     }
 
     void* contents = m_Buffer->contents();
     if (contents) {
-        memcpy(static_cast<uint8*>(contents) + offset, data, size);
+        write(static_cast<uint8*>(contents) + offset);
+    }
+}
 
-#if TARGET_OS_OSX
-        if (m_MemoryUsage == MemoryUsage::CPUToGPU) {
-            m_Buffer->didModifyRange(NS::Range::Make(offset, size));
-        }
-#endif
+bool MetalBuffer::IsUploadComplete() const {
+    return m_Context.uploadManager->IsComplete(m_UploadTicket);
+}
+
+void* MetalBuffer::GetMappedPointer() {
+    // Shared storage is always CPU-visible; private storage has no CPU address
+    if (m_MemoryUsage == MemoryUsage::GPUOnly || !m_Buffer) {
+        return nullptr;
     }
+    return m_Buffer->contents();
 }
 
 } // namespace rhi
@@ -4,18 +4,25 @@
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/metal/MetalCommandBuffer.h"
 #include "metagfx/rhi/metal/MetalPipeline.h"
+#include "metagfx/rhi/metal/MetalComputePipeline.h"
 #include "metagfx/rhi/metal/MetalBuffer.h"
 #include "metagfx/rhi/metal/MetalTexture.h"
 #include "metagfx/rhi/metal/MetalDescriptorSet.h"
+#include "metagfx/rhi/metal/MetalDrawList.h"
+#include "metagfx/rhi/metal/MetalAccelerationStructure.h"
+#include "metagfx/rhi/metal/MetalTemporalUpscaler.h"
 #include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/FormatInfo.h"
 
+#include <atomic>
 #include <cstring>
 
 namespace metagfx {
 namespace rhi {
 
-MetalCommandBuffer::MetalCommandBuffer(MetalContext& context)
-    : m_Context(context) {
+MetalCommandBuffer::MetalCommandBuffer(MetalContext& context, MetalCommandBuffer* primary,
+                                       MTL::CommandQueue* queue)
+    : m_Context(context), m_Queue(queue), m_Primary(primary) {
 }
 
 MetalCommandBuffer::~MetalCommandBuffer() {
@@ -23,28 +30,98 @@ MetalCommandBuffer::~MetalCommandBuffer() {
 }
 
 void MetalCommandBuffer::Begin() {
-    m_CommandBuffer = m_Context.commandQueue->commandBuffer();
+    // Frame command buffers are recycled, so drop state from the previous recording
+    m_BoundPipeline.reset();
+    m_BoundIndexBuffer.reset();
+    m_IndexBufferOffset = 0;
+    m_PushConstantSize = 0;
+    m_PushConstantStages = static_cast<ShaderStage>(0);
+    m_FilteredCallCount = 0;
+    m_Stats = FrameStats{};
+    ResetEncoderState();
+
+    // Secondaries record into the sub-encoder their primary created for them
+    if (m_Primary) {
+        return;
+    }
+
+    m_ActiveSecondaryCount = 0;
+    m_WaitedForAsyncCompute = false;
+    m_CommandBuffer = (m_Queue ? m_Queue : m_Context.commandQueue)->commandBuffer();
     if (!m_CommandBuffer) {
         MTL_LOG_ERROR("Failed to create command buffer");
+        return;
+    }
+    // Async compute starts once the graphics queue has finished what it was given so far
+    if (m_Queue && m_Context.graphicsEvent) {
+        m_CommandBuffer->encodeWait(m_Context.graphicsEvent, m_Context.graphicsEventValue);
     }
 }
 
+void MetalCommandBuffer::WaitForAsyncCompute() {
+    if (m_Primary || !m_CommandBuffer || m_RenderEncoder || m_ParallelEncoder || m_WaitedForAsyncCompute) {
+        METAGFX_WARN << "WaitForAsyncCompute() ignored: needs a recording primary outside any render pass, once";
+        return;
+    }
+    if (!m_Context.computeEvent) {
+        return;
+    }
+    // Waits sit between encoders
+    EndBlitAndComputeEncoders();
+    m_CommandBuffer->encodeWait(m_Context.computeEvent, m_Context.computeEventValue);
+    m_WaitedForAsyncCompute = true;
+}
+
+void MetalCommandBuffer::InvalidateState() {
+    ResetEncoderState();
+}
+
+void MetalCommandBuffer::ResetEncoderState() {
+    for (BoundDescriptorSet& bound : m_BoundDescriptorSets) {
+        bound.set = nullptr;
+    }
+    m_EncoderPipeline = nullptr;
+    m_EncoderVertexBuffer = nullptr;
+    m_EncoderViewportSet = false;
+    m_EncoderScissorSet = false;
+    m_PushConstantsDirty = m_PushConstantSize > 0;
+}
+
 void MetalCommandBuffer::End() {
     // End any active encoders
     if (m_RenderEncoder) {
         m_RenderEncoder->endEncoding();
         m_RenderEncoder = nullptr;
     }
+    if (m_ParallelEncoder) {
+        m_ParallelEncoder->endEncoding();
+        m_ParallelEncoder = nullptr;
+    }
     if (m_BlitEncoder) {
         m_BlitEncoder->endEncoding();
         m_BlitEncoder = nullptr;
     }
+    if (m_ComputeEncoder) {
+        m_ComputeEncoder->endEncoding();
+        m_ComputeEncoder = nullptr;
+    }
 }
 
-void MetalCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                                         Ref<Texture> depthAttachment,
-                                         const std::vector<ClearValue>& clearValues) {
+MTL::RenderPassDescriptor* MetalCommandBuffer::CreateRenderPassDescriptor(std::span<const Ref<Texture>> colorAttachments,
+                                                                          Ref<Texture> depthAttachment,
+                                                                          std::span<const ClearValue> clearValues,
+                                                                          const RenderPassActions& actions,
+                                                                          std::span<const Ref<Texture>> resolveTargets) {
     MTL::RenderPassDescriptor* passDesc = MTL::RenderPassDescriptor::alloc()->init();
+    auto toLoadAction = [](LoadOp op) {
+        switch (op) {
+            case LoadOp::Load: return MTL::LoadActionLoad;
+            case LoadOp::DontCare: return MTL::LoadActionDontCare;
+            default: return MTL::LoadActionClear;
+        }
+    };
+    MTL::LoadAction loadAction = toLoadAction(actions.colorLoad);
+    MTL::LoadAction depthLoadAction = toLoadAction(actions.depthLoad);
 
     // DEBUG: Log rendering setup
     static int frameCount = 0;
@@ -83,8 +160,18 @@ void MetalCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAt
             colorAttach->setTexture(metalTexture->GetHandle());
         }
 
-        colorAttach->setLoadAction(MTL::LoadActionClear);
-        colorAttach->setStoreAction(MTL::StoreActionStore);
+        // Memoryless attachments must not be stored, nor dropped ones; multisampled ones
+        // resolve into their target as the pass ends
+        bool transient = colorAttachments[i] && static_cast<MetalTexture*>(colorAttachments[i].get())->IsTransient();
+        bool resolved = i < resolveTargets.size() && resolveTargets[i];
+        bool stored = IsStored(actions.colorStore, transient, resolved);
+        colorAttach->setLoadAction(loadAction);
+        colorAttach->setStoreAction(stored ? MTL::StoreActionStore : MTL::StoreActionDontCare);
+        if (resolved) {
+            colorAttach->setResolveTexture(static_cast<MetalTexture*>(resolveTargets[i].get())->GetHandle());
+            colorAttach->setStoreAction(stored ? MTL::StoreActionStoreAndMultisampleResolve
+                                               : MTL::StoreActionMultisampleResolve);
+        }
 
         // Set clear color from clearValues if available
         if (i < clearValues.size()) {
@@ -99,13 +186,19 @@ void MetalCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAt
         }
     }
 
+    // A multiview pass renders layers 0..viewCount-1, each view drawn as its own instances
+    if (actions.viewCount > 1) {
+        passDesc->setRenderTargetArrayLength(actions.viewCount);
+    }
+
     // Set up depth attachment
     if (depthAttachment) {
         auto metalTexture = static_cast<MetalTexture*>(depthAttachment.get());
         auto* depthAttach = passDesc->depthAttachment();
         depthAttach->setTexture(metalTexture->GetHandle());
-        depthAttach->setLoadAction(MTL::LoadActionClear);
-        depthAttach->setStoreAction(MTL::StoreActionStore);
+        depthAttach->setLoadAction(depthLoadAction);
+        depthAttach->setStoreAction(IsStored(actions.depthStore, metalTexture->IsTransient(), false)
+                                        ? MTL::StoreActionStore : MTL::StoreActionDontCare);
 
         // Use clear value from last entry if available (depth clear value convention)
         double clearDepth = 1.0;
@@ -129,17 +222,61 @@ void MetalCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAt
         }
     }
 
+    return passDesc;
+}
+
+void MetalCommandBuffer::EndBlitAndComputeEncoders() {
+    if (m_BlitEncoder) {
+        m_BlitEncoder->endEncoding();
+        m_BlitEncoder = nullptr;
+    }
+    if (m_ComputeEncoder) {
+        m_ComputeEncoder->endEncoding();
+        m_ComputeEncoder = nullptr;
+    }
+}
+
+bool MetalCommandBuffer::WriteTimestamp(MTL::CounterSampleBuffer* sampleBuffer, uint32 sampleIndex) {
+    if (m_Primary || m_RenderEncoder || m_ParallelEncoder || !m_CommandBuffer) {
+        return false;
+    }
+    EndBlitAndComputeEncoders();
+
+    MTL::BlitPassDescriptor* passDesc = MTL::BlitPassDescriptor::alloc()->init();
+    MTL::BlitPassSampleBufferAttachmentDescriptor* attachment = passDesc->sampleBufferAttachments()->object(0);
+    attachment->setSampleBuffer(sampleBuffer);
+    attachment->setStartOfEncoderSampleIndex(MTL::CounterDontSample);
+    attachment->setEndOfEncoderSampleIndex(sampleIndex);
+
+    MTL::BlitCommandEncoder* encoder = m_CommandBuffer->blitCommandEncoder(passDesc);
+    passDesc->release();
+    if (!encoder) {
+        return false;
+    }
+    encoder->endEncoding();
+    return true;
+}
+
+void MetalCommandBuffer::BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                                         const Ref<Texture>& depthAttachment,
+                                         std::span<const ClearValue> clearValues,
+                                         const RenderPassActions& actions,
+                                         std::span<const Ref<Texture>> resolveTargets,
+                                         const Ref<Texture>& shadingRate) {
+    (void)shadingRate;  // Not supported (DeviceInfo::supportsShadingRateImage)
+    MTL::RenderPassDescriptor* passDesc = CreateRenderPassDescriptor(colorAttachments, depthAttachment, clearValues,
+                                                                     actions, resolveTargets);
+
+    EndBlitAndComputeEncoders();
     m_RenderEncoder = m_CommandBuffer->renderCommandEncoder(passDesc);
+    ResetEncoderState();  // A new encoder starts with no state or resources bound
     passDesc->release();
 
     if (!m_RenderEncoder) {
         MTL_LOG_ERROR("Failed to create render command encoder");
     } else {
-        static bool loggedEncoder = false;
-        if (!loggedEncoder) {
-            METAGFX_INFO << "Metal render encoder created successfully";
-            loggedEncoder = true;
-        }
+        ++m_Stats.renderPasses;
+        METAGFX_DEBUG_ONCE << "Metal render encoder created successfully";
     }
 }
 
@@ -150,7 +287,62 @@ void MetalCommandBuffer::EndRendering() {
     }
 }
 
-void MetalCommandBuffer::BindPipeline(Ref<Pipeline> pipeline) {
+void MetalCommandBuffer::BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                                const Ref<Texture>& depthAttachment,
+                                                std::span<const ClearValue> clearValues,
+                                                uint32 secondaryCount,
+                                                const RenderPassActions& actions,
+                                                std::span<const Ref<Texture>> resolveTargets,
+                                                const Ref<Texture>& shadingRate) {
+    (void)shadingRate;  // Not supported (DeviceInfo::supportsShadingRateImage)
+    MTL::RenderPassDescriptor* passDesc = CreateRenderPassDescriptor(colorAttachments, depthAttachment, clearValues,
+                                                                     actions, resolveTargets);
+
+    EndBlitAndComputeEncoders();
+    m_ParallelEncoder = m_CommandBuffer->parallelRenderCommandEncoder(passDesc);
+    passDesc->release();
+    if (!m_ParallelEncoder) {
+        MTL_LOG_ERROR("Failed to create parallel render command encoder");
+    } else {
+        ++m_Stats.renderPasses;
+    }
+
+    while (m_Secondaries.size() < secondaryCount) {
+        m_Secondaries.push_back(CreateRef<MetalCommandBuffer>(m_Context, this));
+    }
+    for (uint32 i = 0; i < secondaryCount; ++i) {
+        MetalCommandBuffer& secondary = *m_Secondaries[i];
+        secondary.m_CommandBuffer = m_CommandBuffer;
+        secondary.m_RenderEncoder = m_ParallelEncoder ? m_ParallelEncoder->renderCommandEncoder() : nullptr;
+    }
+    m_ActiveSecondaryCount = secondaryCount;
+}
+
+Ref<CommandBuffer> MetalCommandBuffer::GetSecondaryCommandBuffer(uint32 index) {
+    return index < m_ActiveSecondaryCount ? m_Secondaries[index] : nullptr;
+}
+
+void MetalCommandBuffer::EndParallelRendering() {
+    // Each secondary's End() ended its sub-encoder
+    for (uint32 i = 0; i < m_ActiveSecondaryCount; ++i) {
+        AddSecondaryStats(*m_Secondaries[i]);
+    }
+    m_ActiveSecondaryCount = 0;
+
+    if (m_ParallelEncoder) {
+        m_ParallelEncoder->endEncoding();
+        m_ParallelEncoder = nullptr;
+    }
+}
+
+void MetalCommandBuffer::BindPipeline(const Ref<Pipeline>& pipeline) {
+    // Already set on the open encoder: keep the staged push constants as well
+    bool compute = pipeline->GetBindPoint() == PipelineBindPoint::Compute;
+    if (pipeline == m_BoundPipeline &&
+        (compute ? m_ComputeEncoder != nullptr : m_EncoderPipeline == pipeline.get())) {
+        ++m_FilteredCallCount;
+        return;
+    }
     m_BoundPipeline = pipeline;
 
     // Reset push constant staging when binding new pipeline
@@ -158,16 +350,27 @@ void MetalCommandBuffer::BindPipeline(Ref<Pipeline> pipeline) {
     m_PushConstantStages = static_cast<ShaderStage>(0);
     memset(m_PushConstantBuffer, 0, sizeof(m_PushConstantBuffer));
 
+    if (compute) {
+        auto computePipeline = static_cast<MetalComputePipeline*>(pipeline.get());
+        if (MTL::ComputeCommandEncoder* encoder = GetComputeEncoder()) {
+            encoder->setComputePipelineState(computePipeline->GetComputePipelineState());
+            ++m_Stats.pipelineBinds;
+        }
+        return;
+    }
+
     auto metalPipeline = static_cast<MetalPipeline*>(pipeline.get());
 
     if (m_RenderEncoder) {
         m_RenderEncoder->setRenderPipelineState(metalPipeline->GetRenderPipelineState());
-
-        // DEBUG: Log depth state binding
-        static int bindCount = 0;
-        bindCount++;
-        if (bindCount <= 10) {
-            METAGFX_INFO << "BindPipeline " << bindCount << ": depthStencilState="
+        m_EncoderPipeline = pipeline.get();
+        ++m_Stats.pipelineBinds;
+
+        // DEBUG: Log depth state binding (secondaries bind from worker threads)
+        static std::atomic<int> bindCount{0};
+        int bindIndex = ++bindCount;
+        if (bindIndex <= 10) {
+            METAGFX_INFO << "BindPipeline " << bindIndex << ": depthStencilState="
                          << (metalPipeline->GetDepthStencilState() ? "valid" : "NULL");
         }
 
@@ -181,14 +384,24 @@ void MetalCommandBuffer::BindPipeline(Ref<Pipeline> pipeline) {
     }
 }
 
-void MetalCommandBuffer::BindVertexBuffer(Ref<Buffer> buffer, uint64 offset) {
+void MetalCommandBuffer::BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
     if (m_RenderEncoder) {
-        auto metalBuffer = static_cast<MetalBuffer*>(buffer.get());
-        m_RenderEncoder->setVertexBuffer(metalBuffer->GetHandle(), offset, 0);
+        MTL::Buffer* handle = static_cast<MetalBuffer*>(buffer.get())->GetHandle();
+        if (handle == m_EncoderVertexBuffer) {
+            if (offset == m_EncoderVertexOffset) {
+                ++m_FilteredCallCount;
+                return;
+            }
+            m_RenderEncoder->setVertexBufferOffset(offset, 0);
+        } else {
+            m_RenderEncoder->setVertexBuffer(handle, offset, 0);
+            m_EncoderVertexBuffer = handle;
+        }
+        m_EncoderVertexOffset = offset;
     }
 }
 
-void MetalCommandBuffer::BindIndexBuffer(Ref<Buffer> buffer, uint64 offset) {
+void MetalCommandBuffer::BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
     // Metal handles index buffer binding at draw time
     // Store the buffer for use in DrawIndexed
     m_BoundIndexBuffer = buffer;
@@ -196,6 +409,10 @@ void MetalCommandBuffer::BindIndexBuffer(Ref<Buffer> buffer, uint64 offset) {
 }
 
 void MetalCommandBuffer::SetViewport(const Viewport& viewport) {
+    if (m_RenderEncoder && m_EncoderViewportSet && std::memcmp(&m_EncoderViewport, &viewport, sizeof(Viewport)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
     if (m_RenderEncoder) {
         MTL::Viewport mtlViewport;
         mtlViewport.originX = viewport.x;
@@ -205,10 +422,16 @@ void MetalCommandBuffer::SetViewport(const Viewport& viewport) {
         mtlViewport.znear = viewport.minDepth;
         mtlViewport.zfar = viewport.maxDepth;
         m_RenderEncoder->setViewport(mtlViewport);
+        m_EncoderViewport = viewport;
+        m_EncoderViewportSet = true;
     }
 }
 
 void MetalCommandBuffer::SetScissor(const Rect2D& scissor) {
+    if (m_RenderEncoder && m_EncoderScissorSet && std::memcmp(&m_EncoderScissor, &scissor, sizeof(Rect2D)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
     if (m_RenderEncoder) {
         MTL::ScissorRect mtlScissor;
         mtlScissor.x = static_cast<NS::UInteger>(scissor.x);
@@ -216,6 +439,8 @@ void MetalCommandBuffer::SetScissor(const Rect2D& scissor) {
         mtlScissor.width = static_cast<NS::UInteger>(scissor.width);
         mtlScissor.height = static_cast<NS::UInteger>(scissor.height);
         m_RenderEncoder->setScissorRect(mtlScissor);
+        m_EncoderScissor = scissor;
+        m_EncoderScissorSet = true;
     }
 }
 
@@ -226,13 +451,15 @@ void MetalCommandBuffer::Draw(uint32 vertexCount, uint32 instanceCount,
         FlushPushConstants();
 
         auto metalPipeline = static_cast<MetalPipeline*>(m_BoundPipeline.get());
+        uint32 viewCount = SetViewMask(*metalPipeline, 0, metalPipeline->GetViewCount());
         m_RenderEncoder->drawPrimitives(
             metalPipeline->GetPrimitiveType(),
             firstVertex,
             vertexCount,
-            instanceCount,
+            instanceCount * viewCount,
             firstInstance
         );
+        CountDraw(vertexCount, instanceCount * viewCount);
     }
 }
 
@@ -245,6 +472,7 @@ void MetalCommandBuffer::DrawIndexed(uint32 indexCount, uint32 instanceCount,
 
         auto metalPipeline = static_cast<MetalPipeline*>(m_BoundPipeline.get());
         auto metalBuffer = static_cast<MetalBuffer*>(m_BoundIndexBuffer.get());
+        uint32 viewCount = SetViewMask(*metalPipeline, 0, metalPipeline->GetViewCount());
 
         m_RenderEncoder->drawIndexedPrimitives(
             metalPipeline->GetPrimitiveType(),
@@ -252,20 +480,163 @@ void MetalCommandBuffer::DrawIndexed(uint32 indexCount, uint32 instanceCount,
             m_IndexType,
             metalBuffer->GetHandle(),
             m_IndexBufferOffset + firstIndex * (m_IndexType == MTL::IndexTypeUInt32 ? 4 : 2),
-            instanceCount,
+            instanceCount * viewCount,
             vertexOffset,
             firstInstance
         );
+        CountDraw(indexCount, instanceCount * viewCount);
+    }
+}
+
+void MetalCommandBuffer::DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                                             uint32 stride) {
+    if (m_RenderEncoder && m_BoundPipeline && m_BoundIndexBuffer) {
+        FlushPushConstants();
+
+        // One encoder call per command: each reads MTLDrawIndexedPrimitivesIndirectArguments,
+        // which has the DrawIndexedIndirectCommand layout
+        auto metalPipeline = static_cast<MetalPipeline*>(m_BoundPipeline.get());
+        auto indexBuffer = static_cast<MetalBuffer*>(m_BoundIndexBuffer.get());
+        auto indirectBuffer = static_cast<MetalBuffer*>(argumentBuffer.get());
+        // The commands' instance counts cannot be multiplied: a multiview pipeline replays
+        // them once per view instead
+        for (uint32 view = 0; view < metalPipeline->GetViewCount(); ++view) {
+            SetViewMask(*metalPipeline, view, 1);
+            for (uint32 i = 0; i < drawCount; ++i) {
+                m_RenderEncoder->drawIndexedPrimitives(
+                    metalPipeline->GetPrimitiveType(),
+                    m_IndexType,
+                    indexBuffer->GetHandle(),
+                    m_IndexBufferOffset,
+                    indirectBuffer->GetHandle(),
+                    offset + static_cast<uint64>(i) * stride
+                );
+            }
+        }
+        ++m_Stats.drawCalls;
+    }
+}
+
+void MetalCommandBuffer::ExecuteDrawList(const Ref<DrawList>& drawList) {
+    if (!m_RenderEncoder || !m_BoundPipeline || !m_BoundIndexBuffer || !drawList) {
+        return;
+    }
+
+    // Indirect commands inherit no textures: with the pipeline's read directly, draw
+    // the list as indirect draws; likewise for multiview pipelines, which draw it per view
+    auto metalPipeline = static_cast<MetalPipeline*>(m_BoundPipeline.get());
+    auto indexBuffer = static_cast<MetalBuffer*>(m_BoundIndexBuffer.get());
+    MTL::IndirectCommandBuffer* commands = nullptr;
+    if (m_Context.supportsArgumentBuffers && metalPipeline->GetViewCount() == 1) {
+        commands = static_cast<MetalDrawList*>(drawList.get())->GetIndirectCommandBuffer(
+            indexBuffer->GetHandle(), m_IndexBufferOffset, m_IndexType, metalPipeline->GetPrimitiveType());
+    }
+    if (!commands) {
+        CommandBuffer::ExecuteDrawList(drawList);
+        return;
+    }
+
+    FlushPushConstants();
+    // The index buffer is reached through the commands, not bound
+    m_RenderEncoder->useResource(indexBuffer->GetHandle(), MTL::ResourceUsageRead, MTL::RenderStageVertex);
+    m_RenderEncoder->executeCommandsInBuffer(commands, NS::Range::Make(0, drawList->GetDrawCount()));
+    ++m_Stats.drawCalls;
+}
+
+void MetalCommandBuffer::DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                                  const Ref<Buffer>& countBuffer, uint64 countOffset,
+                                                  uint32 maxDrawCount, uint32 stride) {
+    // Render encoders cannot read a draw count; unused commands draw zero instances
+    (void)countBuffer;
+    (void)countOffset;
+    DrawIndexedIndirect(argumentBuffer, offset, maxDrawCount, stride);
+}
+
+uint32 MetalCommandBuffer::SetViewMask(const MetalPipeline& pipeline, uint32 firstView, uint32 viewCount) {
+    if (pipeline.GetViewCount() > 1) {
+        uint32 viewMask[2] = { firstView, viewCount };
+        m_RenderEncoder->setVertexBytes(viewMask, sizeof(viewMask), METAL_VIEW_MASK_BUFFER_INDEX);
+    }
+    return pipeline.GetViewCount();
+}
+
+MTL::ComputeCommandEncoder* MetalCommandBuffer::GetComputeEncoder() {
+    if (m_ComputeEncoder) {
+        return m_ComputeEncoder;
+    }
+
+    if (m_RenderEncoder) {
+        MTL_LOG_ERROR("Compute work recorded inside a render pass");
+        return nullptr;
     }
+    if (m_BlitEncoder) {
+        m_BlitEncoder->endEncoding();
+        m_BlitEncoder = nullptr;
+    }
+
+    // Serial dispatch: Metal orders dispatches that touch the same tracked resources
+    m_ComputeEncoder = m_CommandBuffer->computeCommandEncoder();
+    if (!m_ComputeEncoder) {
+        MTL_LOG_ERROR("Failed to create compute command encoder");
+        return nullptr;
+    }
+
+    // A new encoder starts without state; restore the bound compute pipeline and resend
+    // the staged push constants
+    m_PushConstantsDirty = m_PushConstantSize > 0;
+    if (m_BoundPipeline && m_BoundPipeline->GetBindPoint() == PipelineBindPoint::Compute) {
+        auto computePipeline = static_cast<MetalComputePipeline*>(m_BoundPipeline.get());
+        m_ComputeEncoder->setComputePipelineState(computePipeline->GetComputePipelineState());
+    }
+    return m_ComputeEncoder;
 }
 
-void MetalCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+void MetalCommandBuffer::Dispatch(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ) {
+    if (!m_BoundPipeline || m_BoundPipeline->GetBindPoint() != PipelineBindPoint::Compute) {
+        MTL_LOG_ERROR("Dispatch called without a bound compute pipeline");
+        return;
+    }
+
+    MTL::ComputeCommandEncoder* encoder = GetComputeEncoder();
+    if (encoder) {
+        FlushPushConstants();
+
+        auto computePipeline = static_cast<MetalComputePipeline*>(m_BoundPipeline.get());
+        encoder->dispatchThreadgroups(MTL::Size::Make(groupCountX, groupCountY, groupCountZ),
+                                      computePipeline->GetThreadGroupSize());
+        ++m_Stats.dispatches;
+    }
+}
+
+void MetalCommandBuffer::DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset) {
+    if (!m_BoundPipeline || m_BoundPipeline->GetBindPoint() != PipelineBindPoint::Compute) {
+        MTL_LOG_ERROR("DispatchIndirect called without a bound compute pipeline");
+        return;
+    }
+
+    MTL::ComputeCommandEncoder* encoder = GetComputeEncoder();
+    if (encoder) {
+        FlushPushConstants();
+
+        // Reads MTLDispatchThreadgroupsIndirectArguments (DispatchIndirectCommand layout)
+        auto computePipeline = static_cast<MetalComputePipeline*>(m_BoundPipeline.get());
+        auto indirectBuffer = static_cast<MetalBuffer*>(argumentBuffer.get());
+        encoder->dispatchThreadgroups(indirectBuffer->GetHandle(), offset, computePipeline->GetThreadGroupSize());
+        ++m_Stats.dispatches;
+    }
+}
+
+void MetalCommandBuffer::CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                                     uint64 size, uint64 srcOffset, uint64 dstOffset) {
-    // End render encoder if active
+    // End render or compute encoder if active
     if (m_RenderEncoder) {
         m_RenderEncoder->endEncoding();
         m_RenderEncoder = nullptr;
     }
+    if (m_ComputeEncoder) {
+        m_ComputeEncoder->endEncoding();
+        m_ComputeEncoder = nullptr;
+    }
 
     // Create blit encoder if not active
     if (!m_BlitEncoder) {
@@ -284,21 +655,180 @@ void MetalCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
     }
 }
 
-// Abstract interface implementations
-void MetalCommandBuffer::BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                                           uint32 frameIndex) {
-    (void)pipeline;  // Metal doesn't need pipeline layout for binding
+void MetalCommandBuffer::CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset) {
+    if (m_RenderEncoder) {
+        m_RenderEncoder->endEncoding();
+        m_RenderEncoder = nullptr;
+    }
+    if (m_ComputeEncoder) {
+        m_ComputeEncoder->endEncoding();
+        m_ComputeEncoder = nullptr;
+    }
+    if (!m_BlitEncoder) {
+        m_BlitEncoder = m_CommandBuffer->blitCommandEncoder();
+    }
+
+    if (m_BlitEncoder) {
+        // GPUToCPU buffers are shared: the bytes are visible once the command buffer completes
+        uint32 rowPitch = GetReadbackRowPitch(src->GetFormat(), src->GetWidth());
+        m_BlitEncoder->copyFromTexture(static_cast<MetalTexture*>(src.get())->GetHandle(), 0, 0,
+                                       MTL::Origin(0, 0, 0), MTL::Size(src->GetWidth(), src->GetHeight(), 1),
+                                       static_cast<MetalBuffer*>(dst.get())->GetHandle(), dstOffset, rowPitch,
+                                       static_cast<NS::UInteger>(rowPitch) * src->GetHeight());
+    }
+}
+
+void MetalCommandBuffer::BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds) {
+    if (!m_Context.supportsRayTracing || builds.empty() || m_Primary || m_RenderEncoder || m_ParallelEncoder) {
+        return;
+    }
+    EndBlitAndComputeEncoders();
+
+    // One scratch buffer for the batch, released once encoded: the command buffer retains it
+    constexpr uint64 SCRATCH_ALIGNMENT = 256;
+    uint64 scratchSize = 0;
+    for (const AccelerationStructureBuild& build : builds) {
+        if (auto* structure = static_cast<MetalAccelerationStructure*>(build.structure)) {
+            scratchSize += (structure->GetBatchScratchSize() + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT *
+                           SCRATCH_ALIGNMENT;
+        }
+    }
+    MTL::Buffer* scratch = nullptr;
+    if (scratchSize > 0) {
+        scratch = m_Context.device->newBuffer(scratchSize, MTL::ResourceStorageModePrivate);
+        if (!scratch) {
+            MTL_LOG_ERROR("Failed to create acceleration structure scratch of " << scratchSize << " bytes");
+            return;
+        }
+        m_Context.stats->AddAllocation();
+    }
+
+    // Bottom levels, then top levels in an encoder of their own, which orders them after
+    // the bottom levels they place
+    uint64 scratchOffset = 0;
+    for (AccelerationStructureType level : { AccelerationStructureType::BottomLevel,
+                                             AccelerationStructureType::TopLevel }) {
+        MTL::AccelerationStructureCommandEncoder* encoder = nullptr;
+        for (const AccelerationStructureBuild& build : builds) {
+            auto* structure = static_cast<MetalAccelerationStructure*>(build.structure);
+            if (!structure || structure->GetType() != level) {
+                continue;
+            }
+            if (!encoder) {
+                encoder = m_CommandBuffer->accelerationStructureCommandEncoder();
+            }
+            if (structure->EncodeBuild(m_CommandBuffer, encoder, build, scratch, scratchOffset)) {
+                scratchOffset += (structure->GetBatchScratchSize() + SCRATCH_ALIGNMENT - 1) / SCRATCH_ALIGNMENT *
+                                 SCRATCH_ALIGNMENT;
+            }
+        }
+        if (encoder) {
+            encoder->endEncoding();
+        }
+    }
+    if (scratch) {
+        scratch->release();
+    }
+}
+
+Ref<AccelerationStructure> MetalCommandBuffer::CompactAccelerationStructure(const Ref<AccelerationStructure>& source) {
+    auto metalSource = std::static_pointer_cast<MetalAccelerationStructure>(source);
+    if (!metalSource || !metalSource->IsBuilt() || m_Primary || m_RenderEncoder || m_ParallelEncoder) {
+        return nullptr;
+    }
+    uint64 compactedSize = metalSource->GetCompactedSize();
+    if (compactedSize == 0) {
+        return nullptr;
+    }
+    auto target = CreateRef<MetalAccelerationStructure>(m_Context, source->GetDesc(), compactedSize);
+    if (!target->IsValid()) {
+        return nullptr;
+    }
+
+    EndBlitAndComputeEncoders();
+    MTL::AccelerationStructureCommandEncoder* encoder = m_CommandBuffer->accelerationStructureCommandEncoder();
+    encoder->copyAndCompactAccelerationStructure(metalSource->GetHandle(), target->GetHandle());
+    encoder->endEncoding();
+    target->MarkBuilt();
+    return target;
+}
 
-    if (!m_RenderEncoder || !descriptorSet) {
+// MetalFX encodes its own passes into the command buffer, ordered by hazard tracking
+// against the encoders before and after
+bool MetalCommandBuffer::TemporalUpscale(TemporalUpscaler& upscaler, const TemporalUpscaleFrame& frame) {
+    if (m_Primary || m_RenderEncoder || m_ParallelEncoder) {
+        return false;
+    }
+    EndBlitAndComputeEncoders();
+    return static_cast<MetalTemporalUpscaler&>(upscaler).Encode(m_CommandBuffer, frame);
+}
+
+// Abstract interface implementations
+// Binding numbers are unique across a pipeline's sets, so each set's resources take their
+// own indices and sets never displace each other. Sets past 0 are bound directly: shaders
+// only read set 0 through argument buffers (MetalShader).
+void MetalCommandBuffer::BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                           const Ref<DescriptorSet>& descriptorSet, uint32 frameIndex,
+                                           const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    if (!descriptorSet) {
+        return;
+    }
+    if (setIndex >= MAX_DESCRIPTOR_SETS) {
+        MTL_LOG_ERROR("Descriptor set " << setIndex << " is beyond MAX_DESCRIPTOR_SETS");
         return;
     }
 
     // Cast to MetalDescriptorSet and apply bindings directly to encoder
     auto metalDescSet = std::static_pointer_cast<MetalDescriptorSet>(descriptorSet);
-    metalDescSet->ApplyToEncoder(m_RenderEncoder, frameIndex);
+
+    // Compute encoders are short-lived and rarely see the same set twice, so always apply fully
+    if (pipeline && pipeline->GetBindPoint() == PipelineBindPoint::Compute) {
+        if (MTL::ComputeCommandEncoder* encoder = GetComputeEncoder()) {
+            metalDescSet->ApplyToComputeEncoder(encoder, dynamicOffsets, dynamicOffsetCount);
+            ++m_Stats.descriptorSetBinds;
+        }
+        return;
+    }
+
+    if (!m_RenderEncoder) {
+        return;
+    }
+
+    // Argument buffers are encoded for the functions of the pipeline the set is bound with
+    const Pipeline* renderPipeline = pipeline ? pipeline.get() : m_BoundPipeline.get();
+    auto metalPipeline = renderPipeline && renderPipeline->GetBindPoint() == PipelineBindPoint::Graphics &&
+                                 setIndex == 0
+        ? static_cast<const MetalPipeline*>(renderPipeline) : nullptr;
+    const MetalPipeline* argumentPipeline =
+        metalPipeline && metalPipeline->TakesArgumentBuffers() ? metalPipeline : nullptr;
+
+    // Same set, nothing rebound since: per-draw rebinds only move the buffer offsets,
+    // and nothing at all when those are unchanged too
+    BoundDescriptorSet& bound = m_BoundDescriptorSets[setIndex];
+    bool sameSet = bound.set == descriptorSet.get() &&
+                   bound.version == metalDescSet->GetVersion() &&
+                   bound.frame == frameIndex &&
+                   bound.argumentPipeline == argumentPipeline;
+    if (sameSet && bound.offsets.Matches(dynamicOffsets, dynamicOffsetCount)) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    if (sameSet && dynamicOffsetCount > 0) {
+        metalDescSet->ApplyDynamicOffsets(m_RenderEncoder, dynamicOffsets, dynamicOffsetCount);
+        bound.offsets.Assign(dynamicOffsets, dynamicOffsetCount);
+        ++m_Stats.descriptorSetBinds;
+        return;
+    }
+
+    metalDescSet->ApplyToEncoder(m_RenderEncoder, metalPipeline, frameIndex, dynamicOffsets, dynamicOffsetCount);
+    ++m_Stats.descriptorSetBinds;
+    bound.set = bound.offsets.Assign(dynamicOffsets, dynamicOffsetCount) ? descriptorSet.get() : nullptr;
+    bound.version = metalDescSet->GetVersion();
+    bound.frame = frameIndex;
+    bound.argumentPipeline = argumentPipeline;
 }
 
-void MetalCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+void MetalCommandBuffer::PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                                        uint32 offset, uint32 size, const void* data) {
     (void)pipeline;  // Metal uses buffer binding index for push constants
 
@@ -316,8 +846,17 @@ void MetalCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stage
         return;
     }
 
+    // Bytes already staged with these stages change nothing
+    ShaderStage mergedStages = static_cast<ShaderStage>(static_cast<int>(m_PushConstantStages) | static_cast<int>(stages));
+    if (offset + size <= m_PushConstantSize && mergedStages == m_PushConstantStages &&
+        memcmp(m_PushConstantBuffer + offset, data, size) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
+
     // Copy data to staging buffer
     memcpy(m_PushConstantBuffer + offset, data, size);
+    m_PushConstantsDirty = true;
 
     // Track the total size (high water mark)
     if (offset + size > m_PushConstantSize) {
@@ -331,11 +870,25 @@ void MetalCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stage
 }
 
 void MetalCommandBuffer::FlushPushConstants() {
-    if (!m_RenderEncoder || m_PushConstantSize == 0) {
+    const uint32 pushConstantBufferIndex = METAL_PUSH_CONSTANT_BUFFER_INDEX;
+
+    // The encoder already has the staged bytes
+    if (!m_PushConstantsDirty) {
+        return;
+    }
+
+    if (m_ComputeEncoder && m_PushConstantSize > 0) {
+        if (static_cast<int>(m_PushConstantStages) & static_cast<int>(ShaderStage::Compute)) {
+            m_ComputeEncoder->setBytes(m_PushConstantBuffer, m_PushConstantSize, pushConstantBufferIndex);
+            ++m_Stats.pushConstantCalls;
+        }
+        m_PushConstantsDirty = false;
         return;
     }
 
-    const uint32 pushConstantBufferIndex = 30;
+    if (!m_RenderEncoder || m_PushConstantSize == 0) {
+        return;
+    }
 
     // Send accumulated push constants to Metal
     if (static_cast<int>(m_PushConstantStages) & static_cast<int>(ShaderStage::Vertex)) {
@@ -344,17 +897,34 @@ void MetalCommandBuffer::FlushPushConstants() {
     if (static_cast<int>(m_PushConstantStages) & static_cast<int>(ShaderStage::Fragment)) {
         m_RenderEncoder->setFragmentBytes(m_PushConstantBuffer, m_PushConstantSize, pushConstantBufferIndex);
     }
+    m_PushConstantsDirty = false;
+    ++m_Stats.pushConstantCalls;
 
     // Don't reset here - the push constants should remain valid for subsequent draws
     // until new data is pushed. Reset happens when pipeline is bound or render pass ends.
 }
 
-void MetalCommandBuffer::BufferMemoryBarrier(Ref<Buffer> buffer) {
+void MetalCommandBuffer::BufferMemoryBarrier(const Ref<Buffer>& buffer) {
     // Metal handles memory coherence automatically for managed and shared storage modes
     // For private storage, explicit synchronization would be needed through MTL::BlitCommandEncoder
     // In most cases, this is a no-op for Metal
     (void)buffer;
 }
 
+void MetalCommandBuffer::PipelineBarrier(BarrierType type) {
+    // Resources are hazard-tracked: Metal orders serial dispatches and encoders that
+    // touch the same buffers and textures, so no explicit barrier is needed
+    (void)type;
+}
+
+void MetalCommandBuffer::ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                                         const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) {
+    // Hazard tracking orders the encoders, and textures have no layouts to transition
+    (void)textureBarriers;
+    (void)textureBarrierCount;
+    (void)bufferBarriers;
+    (void)bufferBarrierCount;
+}
+
 } // namespace rhi
 } // namespace metagfx
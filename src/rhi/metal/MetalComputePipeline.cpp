@@ -0,0 +1,58 @@
+// ============================================================================
+// src/rhi/metal/MetalComputePipeline.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalComputePipeline.h"
+#include "metagfx/rhi/metal/MetalPipelineCache.h"
+#include "metagfx/rhi/metal/MetalShader.h"
+
+namespace metagfx {
+namespace rhi {
+
+MetalComputePipeline::MetalComputePipeline(MetalContext& context, const ComputePipelineDesc& desc)
+    : m_Context(context) {
+
+    auto metalShader = static_cast<MetalShader*>(desc.computeShader.get());
+    if (!metalShader || !metalShader->GetFunction()) {
+        MTL_LOG_ERROR("Compute pipeline needs a compiled compute shader");
+        return;
+    }
+    m_ThreadGroupSize = metalShader->GetThreadGroupSize();
+
+    NS::Error* error = nullptr;
+    if (m_Context.pipelineCache) {
+        // A descriptor, so the binary archive can be attached
+        MTL::ComputePipelineDescriptor* pipelineDesc = MTL::ComputePipelineDescriptor::alloc()->init();
+        pipelineDesc->setComputeFunction(metalShader->GetFunction());
+        m_ComputePipelineState = m_Context.pipelineCache->CreateComputePipelineState(pipelineDesc, &error);
+        pipelineDesc->release();
+    } else {
+        m_ComputePipelineState = m_Context.device->newComputePipelineState(metalShader->GetFunction(), &error);
+    }
+
+    if (error || !m_ComputePipelineState) {
+        if (error) {
+            MTL_LOG_ERROR("Failed to create compute pipeline state: " << error->localizedDescription()->utf8String());
+            error->release();
+        } else {
+            MTL_LOG_ERROR("Failed to create compute pipeline state");
+        }
+        return;
+    }
+
+    NS::UInteger threads = m_ThreadGroupSize.width * m_ThreadGroupSize.height * m_ThreadGroupSize.depth;
+    if (threads > m_ComputePipelineState->maxTotalThreadsPerThreadgroup()) {
+        MTL_LOG_ERROR("Compute shader group size " << threads << " exceeds the pipeline maximum of "
+                      << m_ComputePipelineState->maxTotalThreadsPerThreadgroup());
+    }
+}
+
+MetalComputePipeline::~MetalComputePipeline() {
+    if (m_ComputePipelineState) {
+        m_ComputePipelineState->release();
+        m_ComputePipelineState = nullptr;
+    }
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -6,6 +6,11 @@
 #include "metagfx/rhi/metal/MetalBuffer.h"
 #include "metagfx/rhi/metal/MetalTexture.h"
 #include "metagfx/rhi/metal/MetalSampler.h"
+#include "metagfx/rhi/metal/MetalPipeline.h"
+#include "metagfx/rhi/metal/MetalAccelerationStructure.h"
+
+#include <algorithm>
+#include <atomic>
 
 namespace metagfx {
 namespace rhi {
@@ -17,23 +22,78 @@ MetalDescriptorSet::MetalDescriptorSet(MetalContext& context, const DescriptorSe
 }
 
 MetalDescriptorSet::~MetalDescriptorSet() {
-    // Nothing to release - Metal doesn't have descriptor set objects
+    // Metal doesn't have descriptor set objects, only the argument buffers encoded
+    for (ArgumentBuffer& argumentBuffer : m_ArgumentBuffers) {
+        ReleaseArgumentBuffer(argumentBuffer);
+        argumentBuffer.function->release();
+    }
+    m_ArgumentBuffers.clear();
 }
 
-void MetalDescriptorSet::UpdateBuffer(uint32 binding, Ref<Buffer> buffer) {
+void MetalDescriptorSet::UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) {
     for (auto& b : m_Bindings) {
         if (b.binding == binding) {
             b.buffer = buffer;
+            m_Version++;
+            m_Context.stats->AddDescriptorUpdates(1);
             return;
         }
     }
 }
 
-void MetalDescriptorSet::UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) {
+void MetalDescriptorSet::UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
     for (auto& b : m_Bindings) {
         if (b.binding == binding) {
             b.texture = texture;
             b.sampler = sampler;
+            m_Version++;
+            m_Context.stats->AddDescriptorUpdates(1);
+            return;
+        }
+    }
+}
+
+void MetalDescriptorSet::UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                                   const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
+    // Texture tables need argument buffers (SPIRV-Cross cannot emit texture arrays with
+    // plain slot bindings), so without them DeviceInfo::supportsBindlessTextures is false
+    // and only the first element maps onto the regular texture slot.
+    if (arrayElement == 0) {
+        UpdateTexture(binding, texture, sampler);
+        return;
+    }
+    if (!m_Context.supportsArgumentBuffers) {
+        METAGFX_WARN_ONCE << "MetalDescriptorSet: texture arrays are not supported, element "
+                          << arrayElement << " of binding " << binding << " ignored";
+        return;
+    }
+
+    for (const auto& b : m_Bindings) {
+        if (b.binding != binding) {
+            continue;
+        }
+        uint32 count = std::min(b.count, METAL_MAX_ARGUMENT_ARRAY_SIZE);
+        if (arrayElement >= count) {
+            METAGFX_WARN_ONCE << "MetalDescriptorSet: element " << arrayElement << " of binding " << binding
+                              << " is past its " << count << " elements, ignored";
+            return;
+        }
+        std::vector<ArrayElement>& elements = m_ArrayElements[binding];
+        elements.resize(count);
+        elements[arrayElement].texture = texture;
+        elements[arrayElement].sampler = sampler;
+        m_Version++;
+        m_Context.stats->AddDescriptorUpdates(1);
+        return;
+    }
+}
+
+void MetalDescriptorSet::UpdateAccelerationStructure(uint32 binding, const Ref<AccelerationStructure>& structure) {
+    for (auto& b : m_Bindings) {
+        if (b.binding == binding) {
+            b.accelerationStructure = structure;
+            m_Version++;
+            m_Context.stats->AddDescriptorUpdates(1);
             return;
         }
     }
@@ -51,43 +111,92 @@ void* MetalDescriptorSet::GetNativeLayout() const {
     return nullptr;
 }
 
-void MetalDescriptorSet::ApplyToEncoder(MTL::RenderCommandEncoder* encoder, uint32 frameIndex) const {
+void MetalDescriptorSet::ApplyToEncoder(MTL::RenderCommandEncoder* encoder, const MetalPipeline* pipeline,
+                                        uint32 frameIndex, const uint32* dynamicOffsets,
+                                        uint32 dynamicOffsetCount) const {
     if (!encoder) return;
 
     (void)frameIndex;  // Metal doesn't need frame index for binding
 
-    // IMPORTANT: Buffer offset must match what's used in MetalShader.cpp for SPIRV-Cross binding remapping
-    // This offset separates uniform/storage buffers from vertex buffers which share the same namespace
-    const uint32 BUFFER_OFFSET = 10;
+    bool argumentBuffers = pipeline && pipeline->TakesArgumentBuffers();
+    ApplyDirect(encoder, argumentBuffers, dynamicOffsets, dynamicOffsetCount);
+    if (!argumentBuffers) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ArgumentMutex);
+    const MetalPipeline::ArgumentLayout& vertexArguments = pipeline->GetVertexArguments();
+    if (vertexArguments.function) {
+        encoder->setVertexBuffer(GetArgumentBuffer(vertexArguments.function, vertexArguments.ids), 0,
+                                 METAL_ARGUMENT_BUFFER_INDEX);
+    }
+    const MetalPipeline::ArgumentLayout& fragmentArguments = pipeline->GetFragmentArguments();
+    if (fragmentArguments.function) {
+        encoder->setFragmentBuffer(GetArgumentBuffer(fragmentArguments.function, fragmentArguments.ids), 0,
+                                   METAL_ARGUMENT_BUFFER_INDEX);
+    }
+
+    // Resources reached through an argument buffer are not made resident by binding it
+    UpdateResidency();
+    const MTL::RenderStages stages = MTL::RenderStageVertex | MTL::RenderStageFragment;
+    if (!m_ResidentHeaps.empty()) {
+        encoder->useHeaps(m_ResidentHeaps.data(), m_ResidentHeaps.size(), stages);
+    }
+    if (!m_ReadResources.empty()) {
+        encoder->useResources(m_ReadResources.data(), m_ReadResources.size(), MTL::ResourceUsageRead, stages);
+    }
+    if (!m_ReadWriteResources.empty()) {
+        encoder->useResources(m_ReadWriteResources.data(), m_ReadWriteResources.size(),
+                              MTL::ResourceUsageRead | MTL::ResourceUsageWrite, stages);
+    }
+}
 
+void MetalDescriptorSet::ApplyDirect(MTL::RenderCommandEncoder* encoder, bool uniformBuffersOnly,
+                                     const uint32* dynamicOffsets, uint32 dynamicOffsetCount) const {
     // DEBUG: Log bindings for first few frames
-    static int applyCount = 0;
-    applyCount++;
-    bool logThis = (applyCount <= 3);
+    static std::atomic<int> applyCount{0};  // Secondaries apply sets from worker threads
+    bool logThis = (++applyCount <= 3);
     if (logThis) {
         METAGFX_INFO << "MetalDescriptorSet::ApplyToEncoder - " << m_Bindings.size() << " bindings";
     }
 
+    uint32 dynamicIndex = 0;
+
     for (const auto& binding : m_Bindings) {
+        // The rest is in the argument buffers
+        if (uniformBuffersOnly && binding.type != DescriptorType::UniformBuffer &&
+            binding.type != DescriptorType::UniformBufferDynamic &&
+            binding.type != DescriptorType::AccelerationStructure) {
+            continue;
+        }
+
         switch (binding.type) {
             case DescriptorType::UniformBuffer:
+            case DescriptorType::UniformBufferDynamic:
             case DescriptorType::StorageBuffer:
                 if (binding.buffer) {
                     auto metalBuffer = std::static_pointer_cast<MetalBuffer>(binding.buffer);
-                    // Apply BUFFER_OFFSET to avoid conflict with vertex buffers
-                    uint32 metalBufferIndex = binding.binding + BUFFER_OFFSET;
+                    NS::UInteger offset = 0;
+                    if (binding.type == DescriptorType::UniformBufferDynamic) {
+                        if (dynamicOffsets && dynamicIndex < dynamicOffsetCount) {
+                            offset = dynamicOffsets[dynamicIndex];
+                        }
+                        dynamicIndex++;
+                    }
+                    // Apply METAL_BUFFER_OFFSET to avoid conflict with vertex buffers
+                    uint32 metalBufferIndex = binding.binding + METAL_BUFFER_OFFSET;
                     if (logThis) {
                         METAGFX_INFO << "  Binding " << binding.binding << " -> Metal buffer " << metalBufferIndex
                                      << ": Buffer (type="
-                                     << (binding.type == DescriptorType::UniformBuffer ? "UBO" : "Storage")
-                                     << ", size=" << metalBuffer->GetSize() << ")";
+                                     << (binding.type == DescriptorType::StorageBuffer ? "Storage" : "UBO")
+                                     << ", size=" << metalBuffer->GetSize() << ", offset=" << offset << ")";
                     }
                     // Bind to both vertex and fragment stages based on stageFlags
                     if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Vertex)) {
-                        encoder->setVertexBuffer(metalBuffer->GetHandle(), 0, metalBufferIndex);
+                        encoder->setVertexBuffer(metalBuffer->GetHandle(), offset, metalBufferIndex);
                     }
                     if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Fragment)) {
-                        encoder->setFragmentBuffer(metalBuffer->GetHandle(), 0, metalBufferIndex);
+                        encoder->setFragmentBuffer(metalBuffer->GetHandle(), offset, metalBufferIndex);
                     }
                 }
                 break;
@@ -138,9 +247,269 @@ void MetalDescriptorSet::ApplyToEncoder(MTL::RenderCommandEncoder* encoder, uint
                     }
                 }
                 break;
+
+            case DescriptorType::AccelerationStructure: {
+                auto* structure = static_cast<MetalAccelerationStructure*>(binding.accelerationStructure.get());
+                if (!structure || !structure->IsValid()) {
+                    break;
+                }
+                uint32 metalBufferIndex = binding.binding + METAL_BUFFER_OFFSET;
+                MTL::RenderStages stages = 0;
+                if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Vertex)) {
+                    encoder->setVertexAccelerationStructure(structure->GetHandle(), metalBufferIndex);
+                    stages |= MTL::RenderStageVertex;
+                }
+                if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Fragment)) {
+                    encoder->setFragmentAccelerationStructure(structure->GetHandle(), metalBufferIndex);
+                    stages |= MTL::RenderStageFragment;
+                }
+                // The bottom levels are reached through the top level only
+                const std::vector<const MTL::Resource*>& bottomLevels = structure->GetBottomLevelResources();
+                if (stages != 0 && !bottomLevels.empty()) {
+                    encoder->useResources(bottomLevels.data(), bottomLevels.size(), MTL::ResourceUsageRead, stages);
+                }
+                break;
+            }
+        }
+    }
+}
+
+void MetalDescriptorSet::ApplyToComputeEncoder(MTL::ComputeCommandEncoder* encoder,
+                                               const uint32* dynamicOffsets, uint32 dynamicOffsetCount) const {
+    if (!encoder) return;
+
+    uint32 dynamicIndex = 0;
+    for (const auto& binding : m_Bindings) {
+        // Keep dynamic offsets in step even for bindings the compute stage does not see
+        NS::UInteger offset = 0;
+        if (binding.type == DescriptorType::UniformBufferDynamic) {
+            if (dynamicOffsets && dynamicIndex < dynamicOffsetCount) {
+                offset = dynamicOffsets[dynamicIndex];
+            }
+            dynamicIndex++;
+        }
+
+        if (!(static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Compute))) {
+            continue;
+        }
+
+        switch (binding.type) {
+            case DescriptorType::UniformBuffer:
+            case DescriptorType::UniformBufferDynamic:
+            case DescriptorType::StorageBuffer:
+                if (binding.buffer) {
+                    auto metalBuffer = std::static_pointer_cast<MetalBuffer>(binding.buffer);
+                    encoder->setBuffer(metalBuffer->GetHandle(), offset, binding.binding + METAL_BUFFER_OFFSET);
+                }
+                break;
+
+            case DescriptorType::SampledTexture:
+            case DescriptorType::StorageTexture:
+                if (binding.texture) {
+                    auto metalTexture = std::static_pointer_cast<MetalTexture>(binding.texture);
+                    encoder->setTexture(metalTexture->GetHandle(), binding.binding);
+                }
+                if (binding.sampler) {
+                    auto metalSampler = std::static_pointer_cast<MetalSampler>(binding.sampler);
+                    encoder->setSamplerState(metalSampler->GetHandle(), binding.binding);
+                }
+                break;
+
+            case DescriptorType::Sampler:
+                if (binding.sampler) {
+                    auto metalSampler = std::static_pointer_cast<MetalSampler>(binding.sampler);
+                    encoder->setSamplerState(metalSampler->GetHandle(), binding.binding);
+                }
+                break;
+
+            case DescriptorType::AccelerationStructure: {
+                auto* structure = static_cast<MetalAccelerationStructure*>(binding.accelerationStructure.get());
+                if (structure && structure->IsValid()) {
+                    encoder->setAccelerationStructure(structure->GetHandle(), binding.binding + METAL_BUFFER_OFFSET);
+                    const std::vector<const MTL::Resource*>& bottomLevels = structure->GetBottomLevelResources();
+                    if (!bottomLevels.empty()) {
+                        encoder->useResources(bottomLevels.data(), bottomLevels.size(), MTL::ResourceUsageRead);
+                    }
+                }
+                break;
+            }
+        }
+    }
+}
+
+void MetalDescriptorSet::ApplyDynamicOffsets(MTL::RenderCommandEncoder* encoder,
+                                             const uint32* dynamicOffsets, uint32 dynamicOffsetCount) const {
+    if (!encoder || !dynamicOffsets) return;
+
+    uint32 dynamicIndex = 0;
+    for (const auto& binding : m_Bindings) {
+        if (binding.type != DescriptorType::UniformBufferDynamic) {
+            continue;
+        }
+        if (dynamicIndex >= dynamicOffsetCount) {
+            break;
+        }
+
+        NS::UInteger offset = dynamicOffsets[dynamicIndex++];
+        uint32 metalBufferIndex = binding.binding + METAL_BUFFER_OFFSET;
+        if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Vertex)) {
+            encoder->setVertexBufferOffset(offset, metalBufferIndex);
+        }
+        if (static_cast<int>(binding.stageFlags) & static_cast<int>(ShaderStage::Fragment)) {
+            encoder->setFragmentBufferOffset(offset, metalBufferIndex);
+        }
+    }
+}
+
+MTL::Buffer* MetalDescriptorSet::GetArgumentBuffer(MTL::Function* function, const std::vector<uint32>& ids) const {
+    auto it = std::find_if(m_ArgumentBuffers.begin(), m_ArgumentBuffers.end(),
+                           [function](const ArgumentBuffer& a) { return a.function == function; });
+    if (it == m_ArgumentBuffers.end()) {
+        ArgumentBuffer argumentBuffer;
+        argumentBuffer.function = function->retain();
+        m_ArgumentBuffers.push_back(argumentBuffer);
+        it = m_ArgumentBuffers.end() - 1;
+    } else if (it->buffer && it->version == m_Version) {
+        return it->buffer;
+    }
+
+    // Encoded into a new buffer rather than over the old one, which command buffers still
+    // in flight read; they hold it until they complete
+    ReleaseArgumentBuffer(*it);
+    MTL::ArgumentEncoder* encoder = function->newArgumentEncoder(METAL_ARGUMENT_BUFFER_INDEX);
+    if (!encoder) {
+        MTL_LOG_ERROR("Failed to create an argument encoder");
+        return nullptr;
+    }
+    it->buffer = m_Context.device->newBuffer(encoder->encodedLength(), MTL::ResourceStorageModeShared);
+    it->version = m_Version;
+    if (it->buffer) {
+        encoder->setArgumentBuffer(it->buffer, 0);
+        EncodeArguments(encoder, ids);
+        m_Context.stats->AddAllocation();
+        m_Context.memory->Add(MemoryCategory::Uniform, it->buffer->allocatedSize());
+    }
+    encoder->release();
+    return it->buffer;
+}
+
+void MetalDescriptorSet::EncodeArguments(MTL::ArgumentEncoder* encoder, const std::vector<uint32>& ids) const {
+    // The set may have bindings the function does not read, which its layout then lacks
+    auto declared = [&ids](uint32 id) { return std::binary_search(ids.begin(), ids.end(), id); };
+
+    for (const auto& binding : m_Bindings) {
+        uint32 id = GetMetalArgumentId(binding.binding);
+        uint32 samplerId = GetMetalSamplerArgumentId(binding.binding);
+
+        switch (binding.type) {
+            case DescriptorType::UniformBuffer:
+            case DescriptorType::UniformBufferDynamic:
+            case DescriptorType::AccelerationStructure:
+                break;  // Bound directly
+
+            case DescriptorType::StorageBuffer:
+                if (binding.buffer && declared(id)) {
+                    encoder->setBuffer(static_cast<MetalBuffer*>(binding.buffer.get())->GetHandle(), 0, id);
+                }
+                break;
+
+            case DescriptorType::SampledTexture:
+            case DescriptorType::StorageTexture: {
+                // Array elements take consecutive ids from the binding's
+                auto elements = m_ArrayElements.find(binding.binding);
+                uint32 count = std::min(binding.count, METAL_MAX_ARGUMENT_ARRAY_SIZE);
+                for (uint32 i = 0; i < count; ++i) {
+                    const ArrayElement* element = nullptr;
+                    if (i > 0) {
+                        if (elements == m_ArrayElements.end() || i >= elements->second.size()) {
+                            break;
+                        }
+                        element = &elements->second[i];
+                    }
+                    const Ref<Texture>& texture = element ? element->texture : binding.texture;
+                    const Ref<Sampler>& sampler = element ? element->sampler : binding.sampler;
+                    if (texture && declared(id)) {
+                        encoder->setTexture(static_cast<MetalTexture*>(texture.get())->GetHandle(), id + i);
+                    }
+                    if (sampler && declared(samplerId)) {
+                        encoder->setSamplerState(static_cast<MetalSampler*>(sampler.get())->GetHandle(),
+                                                 samplerId + i);
+                    }
+                }
+                break;
+            }
+
+            case DescriptorType::Sampler:
+                if (binding.sampler && declared(samplerId)) {
+                    encoder->setSamplerState(static_cast<MetalSampler*>(binding.sampler.get())->GetHandle(),
+                                             samplerId);
+                }
+                break;
         }
     }
 }
 
+void MetalDescriptorSet::UpdateResidency() const {
+    if (m_ResidencyVersion == m_Version) {
+        return;
+    }
+    m_ResidencyVersion = m_Version;
+    m_ResidentHeaps.clear();
+    m_ReadResources.clear();
+    m_ReadWriteResources.clear();
+
+    // Read-only resources placed in heaps come in with their heap, a handful per model
+    auto add = [this](const MTL::Resource* resource, MTL::Heap* heap, bool write) {
+        if (write) {
+            m_ReadWriteResources.push_back(resource);
+        } else if (!heap) {
+            m_ReadResources.push_back(resource);
+        } else if (std::find(m_ResidentHeaps.begin(), m_ResidentHeaps.end(), heap) == m_ResidentHeaps.end()) {
+            m_ResidentHeaps.push_back(heap);
+        }
+    };
+    auto addTexture = [&add](const Ref<Texture>& texture, bool write) {
+        if (texture) {
+            auto metalTexture = static_cast<MetalTexture*>(texture.get());
+            add(metalTexture->GetHandle(), metalTexture->GetHeap(), write);
+        }
+    };
+
+    for (const auto& binding : m_Bindings) {
+        switch (binding.type) {
+            case DescriptorType::StorageBuffer:
+                if (binding.buffer) {
+                    auto metalBuffer = static_cast<MetalBuffer*>(binding.buffer.get());
+                    add(metalBuffer->GetHandle(), metalBuffer->GetHeap(), true);
+                }
+                break;
+
+            case DescriptorType::SampledTexture:
+            case DescriptorType::StorageTexture: {
+                bool write = binding.type == DescriptorType::StorageTexture;
+                addTexture(binding.texture, write);
+                auto elements = m_ArrayElements.find(binding.binding);
+                if (elements != m_ArrayElements.end()) {
+                    for (size_t i = 1; i < elements->second.size(); ++i) {
+                        addTexture(elements->second[i].texture, write);
+                    }
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+void MetalDescriptorSet::ReleaseArgumentBuffer(ArgumentBuffer& argumentBuffer) const {
+    if (argumentBuffer.buffer) {
+        m_Context.memory->Remove(MemoryCategory::Uniform, argumentBuffer.buffer->allocatedSize());
+        argumentBuffer.buffer->release();
+        argumentBuffer.buffer = nullptr;
+    }
+}
+
 } // namespace rhi
 } // namespace metagfx
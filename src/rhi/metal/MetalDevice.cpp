@@ -9,45 +9,160 @@
 #include "metagfx/rhi/metal/MetalSampler.h"
 #include "metagfx/rhi/metal/MetalShader.h"
 #include "metagfx/rhi/metal/MetalPipeline.h"
+#include "metagfx/rhi/metal/MetalComputePipeline.h"
 #include "metagfx/rhi/metal/MetalCommandBuffer.h"
 #include "metagfx/rhi/metal/MetalFramebuffer.h"
 #include "metagfx/rhi/metal/MetalDescriptorSet.h"
+#include "metagfx/rhi/metal/MetalPipelineCache.h"
+#include "metagfx/rhi/metal/MetalGpuProfiler.h"
+#include "metagfx/rhi/metal/MetalHeapAllocator.h"
+#include "metagfx/rhi/metal/MetalIOQueue.h"
+#include "metagfx/rhi/metal/MetalUploadManager.h"
+#include "metagfx/rhi/metal/MetalDrawList.h"
+#include "metagfx/rhi/metal/MetalAccelerationStructure.h"
+#include "metagfx/rhi/metal/MetalTemporalUpscaler.h"
 #include "MetalSDLBridge.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_metal.h>
 
+#include <thread>
+
 namespace metagfx {
 namespace rhi {
 
-MetalDevice::MetalDevice(SDL_Window* window) : m_Window(window) {
+MetalDevice::MetalDevice(SDL_Window* window, const GraphicsDeviceDesc& desc) : m_Window(window) {
     METAGFX_INFO << "Initializing Metal device...";
+    m_Context.framesInFlight = desc.framesInFlight;
+    m_Context.stats = &m_StatsCounters;
+    m_Context.memory = &m_MemoryCounters;
 
-    CreateDevice(window);
+    CreateDevice(window, desc.adapterIndex);
     CreateCommandQueue();
 
+    m_HeapAllocator = CreateScope<MetalHeapAllocator>(m_Context);
+    m_Context.heapAllocator = m_HeapAllocator.get();
+
+    m_UploadManager = CreateScope<MetalUploadManager>(m_Context);
+    m_Context.uploadManager = m_UploadManager.get();
+
+    m_IOQueue = CreateScope<MetalIOQueue>(m_Context);
+    m_Context.ioQueue = m_IOQueue.get();
+
+    // Loaded before any shader or pipeline is created; saved again when the device is destroyed
+    m_PipelineCache = CreateScope<MetalPipelineCache>(m_Context, desc.pipelineCachePath);
+    m_Context.pipelineCache = m_PipelineCache.get();
+
     // Create swap chain
-    m_SwapChain = CreateRef<MetalSwapChain>(m_Context, window);
+    m_SwapChain = CreateRef<MetalSwapChain>(m_Context, window, desc.framesInFlight, desc.presentMode,
+                                            desc.offscreen);
+
+    for (uint32 i = 0; i < desc.framesInFlight; ++i) {
+        m_FrameCommandBuffers.push_back(CreateRef<MetalCommandBuffer>(m_Context));
+    }
+    if (m_Context.computeQueue) {
+        for (uint32 i = 0; i < desc.framesInFlight; ++i) {
+            m_FrameComputeCommandBuffers.push_back(
+                CreateRef<MetalCommandBuffer>(m_Context, nullptr, m_Context.computeQueue));
+        }
+    }
 
     // Fill device info - get device name using metal-cpp
     const char* deviceName = m_Context.device->name()->utf8String();
     m_DeviceInfo.deviceName = std::string(deviceName);
     m_DeviceInfo.api = GraphicsAPI::Metal;
     m_DeviceInfo.apiVersion = 0; // Metal doesn't have a version number like Vulkan
+    m_DeviceInfo.minUniformBufferOffsetAlignment = 256; // Constant address space offsets on macOS
+    m_DeviceInfo.framesInFlight = desc.framesInFlight;
+    // Apple silicon and Intel integrated GPUs share the CPU's memory
+    m_DeviceInfo.isIntegratedGPU = m_Context.device->hasUnifiedMemory() || m_Context.device->lowPower();
+    // BC on Macs; ASTC and ETC2 on every Apple-family GPU (incl. Apple Silicon Macs)
+    m_DeviceInfo.supportsBCTextures = m_Context.device->supportsBCTextureCompression();
+    m_DeviceInfo.supportsASTCTextures = m_Context.device->supportsFamily(MTL::GPUFamilyApple2);
+    m_DeviceInfo.supportsETC2Textures = m_DeviceInfo.supportsASTCTextures;
+    // Indirect draws are issued one per command, each honoring baseInstance
+    m_DeviceInfo.supportsDrawIndirectFirstInstance = true;
+    // [[primitive_id]] in fragment functions
+    m_DeviceInfo.supportsPrimitiveId = m_Context.device->supportsFamily(MTL::GPUFamilyApple7) ||
+                                       m_Context.device->supportsFamily(MTL::GPUFamilyMac2);
+    // Sub-encoders of a parallel render command encoder are recorded on any thread
+    m_DeviceInfo.supportsParallelRecording = true;
+    // Metal objects are thread-safe; uploads drain their own autorelease pools
+    m_DeviceInfo.supportsThreadedResourceCreation = true;
+    m_DeviceInfo.supportsMemorylessAttachments = m_Context.supportsMemoryless;
+    // Texture tables live in the argument buffers of Tier 2 devices
+    m_DeviceInfo.supportsBindlessTextures = m_Context.supportsArgumentBuffers;
+    m_DeviceInfo.maxBindlessTextures = m_Context.supportsArgumentBuffers ? METAL_MAX_ARGUMENT_ARRAY_SIZE : 0;
+    m_DeviceInfo.maxComputeWorkGroupInvocations =
+        static_cast<uint32>(m_Context.device->maxThreadsPerThreadgroup().width);
+    // Timestamps are sampled between passes, which every counter-sampling GPU supports
+    m_DeviceInfo.supportsTimestampQueries =
+        MetalGpuProfiler::FindTimestampCounterSet(m_Context.device) != nullptr &&
+        m_Context.device->supportsCounterSampling(MTL::CounterSamplingPointAtStageBoundary);
+    // What the device can use without hurting performance stands for its memory
+    m_DeviceInfo.deviceMemory = m_Context.device->recommendedMaxWorkingSetSize();
+    m_DeviceInfo.supportsMemoryBudget = true;
+    m_DeviceInfo.supportsFileTextureLoads = m_IOQueue->IsSupported();
+    m_DeviceInfo.supportsAccelerationStructures = m_Context.supportsRayTracing;
+    m_DeviceInfo.supportsRayQuery = m_Context.supportsRayQuery;
+    m_DeviceInfo.supportsTemporalUpscaler = MTLFX::TemporalScalerDescriptor::supportsDevice(m_Context.device);
+    // SPIRV-Cross writes 16-bit floats as half, which every Metal GPU has
+    m_DeviceInfo.supportsShaderFloat16 = true;
+    // A second command queue, ordered against the first by shared events
+    m_DeviceInfo.supportsAsyncCompute = m_Context.computeQueue != nullptr;
+    // Depth32Float and a filterable Depth16Unorm on every supported GPU
+    m_DeviceInfo.depthFormat = Format::D32_SFLOAT;
+    m_DeviceInfo.supportsDepth16 = true;
+    // Layered rendering, [[render_target_array_index]] from the vertex function, on every
+    // supported GPU; the view mask stays within 32 views like Vulkan's
+    m_DeviceInfo.supportsMultiview = true;
+    m_DeviceInfo.maxMultiviewViews = 32;
 
     METAGFX_INFO << "Metal device initialized: " << m_DeviceInfo.deviceName;
 }
 
 MetalDevice::~MetalDevice() {
+    WaitForPipelineCompiles();
     WaitIdle();
+    ReleasePipelineCache();
+    ReleaseRetired(true);
 
+    m_FrameCommandBuffers.clear();
+    m_FrameComputeCommandBuffers.clear();
     m_SwapChain.reset();
 
+    m_PipelineCache.reset();
+    m_Context.pipelineCache = nullptr;
+
+    // The swap chain's textures are the last of the device's own resources
+    m_HeapAllocator.reset();
+    m_Context.heapAllocator = nullptr;
+
+    // Loads in flight finished before the queue's command buffers waiting for them
+    m_IOQueue.reset();
+    m_Context.ioQueue = nullptr;
+
+    // Its command buffers, those of the loads included, have completed in WaitIdle()
+    m_UploadManager.reset();
+    m_Context.uploadManager = nullptr;
+
     // Release Metal objects (metal-cpp uses manual retain/release)
     if (m_Context.commandQueue) {
         m_Context.commandQueue->release();
         m_Context.commandQueue = nullptr;
     }
+    if (m_Context.computeQueue) {
+        m_Context.computeQueue->release();
+        m_Context.computeQueue = nullptr;
+    }
+    if (m_Context.graphicsEvent) {
+        m_Context.graphicsEvent->release();
+        m_Context.graphicsEvent = nullptr;
+    }
+    if (m_Context.computeEvent) {
+        m_Context.computeEvent->release();
+        m_Context.computeEvent = nullptr;
+    }
 
     if (m_Context.device) {
         m_Context.device->release();
@@ -65,7 +180,34 @@ MetalDevice::~MetalDevice() {
     METAGFX_INFO << "Metal device destroyed";
 }
 
-void MetalDevice::CreateDevice(SDL_Window* window) {
+static AdapterInfo DescribeAdapter(MTL::Device* device) {
+    AdapterInfo adapter;
+    adapter.name = device->name()->utf8String();
+    adapter.deviceMemory = device->recommendedMaxWorkingSetSize();
+    adapter.isIntegratedGPU = device->hasUnifiedMemory() || device->lowPower();
+    return adapter;
+}
+
+std::vector<AdapterInfo> MetalDevice::EnumerateAdapters() {
+    std::vector<AdapterInfo> adapters;
+#if TARGET_OS_OSX
+    NS::Array* devices = MTL::CopyAllDevices();
+    for (NS::UInteger i = 0; devices && i < devices->count(); ++i) {
+        adapters.push_back(DescribeAdapter(devices->object<MTL::Device>(i)));
+    }
+    if (devices) {
+        devices->release();
+    }
+#else
+    if (MTL::Device* device = MTL::CreateSystemDefaultDevice()) {
+        adapters.push_back(DescribeAdapter(device));
+        device->release();
+    }
+#endif
+    return adapters;
+}
+
+void MetalDevice::CreateDevice(SDL_Window* window, uint32 adapterIndex) {
     // Create Metal view from SDL window
     m_Context.metalView = SDL_Metal_CreateView(window);
     if (!m_Context.metalView) {
@@ -80,8 +222,37 @@ void MetalDevice::CreateDevice(SDL_Window* window) {
         return;
     }
 
-    // Create the default Metal device using metal-cpp
-    m_Context.device = MTL::CreateSystemDefaultDevice();
+    // The requested GPU (Macs with several), else the system default
+#if TARGET_OS_OSX
+    if (adapterIndex != DEFAULT_ADAPTER) {
+        NS::Array* devices = MTL::CopyAllDevices();
+        if (devices && adapterIndex < devices->count()) {
+            m_Context.device = devices->object<MTL::Device>(adapterIndex);
+            m_Context.device->retain();
+            m_DeviceInfo.adapterIndex = adapterIndex;
+        } else {
+            METAGFX_WARN << "GPU " << adapterIndex << " is not available, using the system default";
+        }
+        if (devices) {
+            devices->release();
+        }
+    }
+#endif
+    if (!m_Context.device) {
+        m_Context.device = MTL::CreateSystemDefaultDevice();
+#if TARGET_OS_OSX
+        // Its place among all devices
+        NS::Array* devices = MTL::CopyAllDevices();
+        for (NS::UInteger i = 0; m_Context.device && devices && i < devices->count(); ++i) {
+            if (devices->object<MTL::Device>(i)->registryID() == m_Context.device->registryID()) {
+                m_DeviceInfo.adapterIndex = static_cast<uint32>(i);
+            }
+        }
+        if (devices) {
+            devices->release();
+        }
+#endif
+    }
     if (!m_Context.device) {
         METAGFX_ERROR << "Failed to create Metal device - Metal may not be supported";
         return;
@@ -94,8 +265,16 @@ void MetalDevice::CreateDevice(SDL_Window* window) {
     m_Context.supportsArgumentBuffers =
         m_Context.device->argumentBuffersSupport() != MTL::ArgumentBuffersTier1;
 
+    // Draws encoded once and replayed (MetalDrawList); macOS 10.14 GPUs and Apple3 on
+    m_Context.supportsIndirectCommandBuffers =
+        m_Context.device->supportsFamily(MTL::GPUFamilyMac2) || m_Context.device->supportsFamily(MTL::GPUFamilyApple3);
+
+    // Tile memory render targets; every Apple-family GPU has them, Intel and AMD Macs do not
+    m_Context.supportsMemoryless = m_Context.device->supportsFamily(MTL::GPUFamilyApple1);
+
 #if TARGET_OS_OSX
     m_Context.supportsRayTracing = m_Context.device->supportsRaytracing();
+    m_Context.supportsRayQuery = m_Context.supportsRayTracing && m_Context.device->supportsRaytracingFromRender();
 #else
     m_Context.supportsRayTracing = false;
 #endif
@@ -116,6 +295,26 @@ void MetalDevice::CreateCommandQueue() {
     }
 
     METAGFX_DEBUG << "Metal command queue created";
+
+    // Async compute: optional, the renderer runs its passes inline without it
+    m_Context.computeQueue = m_Context.device->newCommandQueue();
+    m_Context.graphicsEvent = m_Context.device->newSharedEvent();
+    m_Context.computeEvent = m_Context.device->newSharedEvent();
+    if (!m_Context.computeQueue || !m_Context.graphicsEvent || !m_Context.computeEvent) {
+        METAGFX_WARN << "Metal async compute queue unavailable";
+        if (m_Context.computeQueue) {
+            m_Context.computeQueue->release();
+            m_Context.computeQueue = nullptr;
+        }
+        if (m_Context.graphicsEvent) {
+            m_Context.graphicsEvent->release();
+            m_Context.graphicsEvent = nullptr;
+        }
+        if (m_Context.computeEvent) {
+            m_Context.computeEvent->release();
+            m_Context.computeEvent = nullptr;
+        }
+    }
 }
 
 Ref<Buffer> MetalDevice::CreateBuffer(const BufferDesc& desc) {
@@ -134,10 +333,23 @@ Ref<Shader> MetalDevice::CreateShader(const ShaderDesc& desc) {
     return CreateRef<MetalShader>(m_Context, desc);
 }
 
-Ref<Pipeline> MetalDevice::CreateGraphicsPipeline(const PipelineDesc& desc) {
+Ref<Pipeline> MetalDevice::CompileGraphicsPipeline(const PipelineDesc& desc) {
     return CreateRef<MetalPipeline>(m_Context, desc);
 }
 
+Ref<PipelineFuture> MetalDevice::CompileGraphicsPipelineAsync(const PipelineDesc& desc) {
+    // MTL::Device is thread-safe, so the synchronous path runs as a job; it keeps the
+    // binary archive lookup that the completion-handler variant would bypass
+    MetalContext* context = &m_Context;
+    return LaunchPipelineCompile([context, desc]() -> Ref<Pipeline> {
+        return CreateRef<MetalPipeline>(*context, desc);
+    });
+}
+
+Ref<Pipeline> MetalDevice::CreateComputePipeline(const ComputePipelineDesc& desc) {
+    return CreateRef<MetalComputePipeline>(m_Context, desc);
+}
+
 Ref<Framebuffer> MetalDevice::CreateFramebuffer(const FramebufferDesc& desc) {
     return CreateRef<MetalFramebuffer>(m_Context, desc);
 }
@@ -146,19 +358,45 @@ Ref<DescriptorSet> MetalDevice::CreateDescriptorSet(const DescriptorSetDesc& des
     return CreateRef<MetalDescriptorSet>(m_Context, desc);
 }
 
-void MetalDevice::SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) {
-    // Metal doesn't use descriptor set layouts like Vulkan
-    // Resources are bound directly to the encoder, so this is a no-op
-    (void)descriptorSet;
+Ref<DrawList> MetalDevice::CreateDrawList(const DrawListDesc& desc) {
+    return CreateRef<MetalDrawList>(*this, m_Context, desc);
 }
 
 Ref<CommandBuffer> MetalDevice::CreateCommandBuffer() {
     return CreateRef<MetalCommandBuffer>(m_Context);
 }
 
+FrameContext MetalDevice::BeginFrame() {
+    EndFrameStats();
+
+    // Acquiring the drawable waits on the frame semaphore, so the GPU has finished the
+    // frame that last used this slot before the application writes its ring slices
+    auto swapChain = std::static_pointer_cast<MetalSwapChain>(m_SwapChain);
+    swapChain->GetCurrentBackBuffer();
+
+    // Retired resources whose last frame has completed (GraphicsDevice::Retire())
+    ReleaseRetired();
+
+    // Periodic save, so pipelines compiled this session survive a crash
+    m_PipelineCache->Tick();
+
+    FrameContext frame;
+    frame.frameIndex = swapChain->GetCurrentFrame();
+    frame.frameCount = swapChain->GetFramesInFlight();
+    frame.commandBuffer = m_FrameCommandBuffers[frame.frameIndex];
+    if (!m_FrameComputeCommandBuffers.empty()) {
+        frame.computeCommandBuffer = m_FrameComputeCommandBuffers[frame.frameIndex];
+    }
+    // The value the frame's compute command buffer signals and its graphics one waits for
+    ++m_Context.computeEventValue;
+    m_ComputeSubmitted = false;
+    return frame;
+}
+
 void MetalDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
     auto mtlCmd = std::static_pointer_cast<MetalCommandBuffer>(commandBuffer);
     auto swapChain = std::static_pointer_cast<MetalSwapChain>(m_SwapChain);
+    AddSubmittedStats(*mtlCmd);
 
     // Get the underlying Metal command buffer
     MTL::CommandBuffer* cmdBuffer = mtlCmd->GetHandle();
@@ -189,14 +427,16 @@ void MetalDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
         if (submitFrameCount <= 5) {
             METAGFX_INFO << "  presentDrawable called";
         }
-    } else {
+    } else if (!swapChain->IsOffscreen()) {
         METAGFX_ERROR << "Metal: No drawable to present!";
     }
 
-    // Add completion handler for frame synchronization and error checking
+    // Add completion handler for frame synchronization, the device's progress value
+    // (GetCompletedFrameValue()) and error checking
     dispatch_semaphore_t frameSemaphore = swapChain->GetFrameSemaphore();
+    uint64 signalValue = NextSignalValue();
     static int handlerFrameCount = 0;
-    cmdBuffer->addCompletedHandler([frameSemaphore](MTL::CommandBuffer* buffer) {
+    cmdBuffer->addCompletedHandler([this, frameSemaphore, signalValue](MTL::CommandBuffer* buffer) {
         handlerFrameCount++;
         // Check for errors
         if (buffer->status() == MTL::CommandBufferStatusError) {
@@ -209,9 +449,28 @@ void MetalDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
         } else if (handlerFrameCount <= 5) {
             METAGFX_INFO << "  Command buffer completed successfully (status=" << static_cast<int>(buffer->status()) << ")";
         }
+        {
+            std::lock_guard<std::mutex> lock(m_CompletedMutex);
+            CompleteValue(signalValue);
+        }
+        m_CompletedCondition.notify_all();
         dispatch_semaphore_signal(frameSemaphore);
     });
 
+    // Async compute: a graphics command buffer that waited for compute never submitted
+    // would hang, so the event is signaled from here; compute submitted without a wait
+    // is waited for at the end, so the frame completes only once its compute has
+    if (m_Context.computeEvent) {
+        if (!m_ComputeSubmitted && mtlCmd->HasWaitedForAsyncCompute()) {
+            m_Context.computeEvent->setSignaledValue(m_Context.computeEventValue);
+        } else if (m_ComputeSubmitted && !mtlCmd->HasWaitedForAsyncCompute()) {
+            cmdBuffer->encodeWait(m_Context.computeEvent, m_Context.computeEventValue);
+        }
+    }
+    if (m_Context.graphicsEvent) {
+        cmdBuffer->encodeSignalEvent(m_Context.graphicsEvent, ++m_Context.graphicsEventValue);
+    }
+
     // Commit the command buffer
     cmdBuffer->commit();
 
@@ -224,13 +483,73 @@ void MetalDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
     swapChain->AdvanceFrame();
 }
 
+void MetalDevice::SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer) {
+    if (!m_Context.computeQueue) {
+        METAGFX_ERROR << "SubmitComputeCommandBuffer(): the device has no async compute queue";
+        return;
+    }
+    auto mtlCmd = std::static_pointer_cast<MetalCommandBuffer>(commandBuffer);
+    AddSubmittedStats(*mtlCmd);
+    MTL::CommandBuffer* cmdBuffer = mtlCmd->GetHandle();
+    if (!cmdBuffer) {
+        return;
+    }
+    cmdBuffer->encodeSignalEvent(m_Context.computeEvent, m_Context.computeEventValue);
+    cmdBuffer->commit();
+    m_ComputeSubmitted = true;
+}
+
+MemoryBudget MetalDevice::GetMemoryBudget() const {
+    MemoryBudget budget;
+    budget.budgetBytes = m_Context.device->recommendedMaxWorkingSetSize();
+    budget.usageBytes = m_Context.device->currentAllocatedSize();
+    return budget;
+}
+
+Ref<AccelerationStructure> MetalDevice::CreateAccelerationStructure(const AccelerationStructureDesc& desc) {
+    if (!m_Context.supportsRayTracing) {
+        return nullptr;
+    }
+    auto structure = CreateRef<MetalAccelerationStructure>(m_Context, desc);
+    return structure->IsValid() ? structure : nullptr;
+}
+
+Ref<TemporalUpscaler> MetalDevice::CreateTemporalUpscaler(const TemporalUpscalerDesc& desc) {
+    if (!m_DeviceInfo.supportsTemporalUpscaler) {
+        return nullptr;
+    }
+    auto upscaler = CreateRef<MetalTemporalUpscaler>(m_Context, desc);
+    return upscaler->IsValid() ? upscaler : nullptr;
+}
+
+Ref<GpuProfiler> MetalDevice::CreateGpuProfiler() {
+    if (!m_DeviceInfo.supportsTimestampQueries) {
+        return nullptr;
+    }
+    auto profiler = CreateRef<MetalGpuProfiler>(m_Context, m_DeviceInfo.framesInFlight,
+                                                MetalGpuProfiler::FindTimestampCounterSet(m_Context.device));
+    return profiler->IsValid() ? profiler : nullptr;
+}
+
 void MetalDevice::WaitIdle() {
-    // Create a temporary command buffer and wait for it to complete
-    // This ensures all previously submitted work is finished
-    if (m_Context.commandQueue) {
-        MTL::CommandBuffer* cmdBuffer = m_Context.commandQueue->commandBuffer();
-        cmdBuffer->commit();
-        cmdBuffer->waitUntilCompleted();
+    // Every command buffer committed to the queue reports its completion through a
+    // handler: frames through the progress value, uploads through their tickets. The
+    // handlers of the last frames may still be running when their command buffers are
+    // done, so this waits for them rather than for an empty command buffer of its own.
+    uint64 value = SignalValue();
+    if (m_UploadManager) {
+        m_UploadManager->WaitIdle();
+    }
+    {
+        std::unique_lock<std::mutex> lock(m_CompletedMutex);
+        m_CompletedCondition.wait(lock, [this, value]() { return GetCompletedFrameValue() >= value; });
+    }
+
+    // Compute submitted after the frame's last graphics command buffer is not covered by it
+    if (m_ComputeSubmitted && m_Context.computeEvent) {
+        while (m_Context.computeEvent->signaledValue() < m_Context.computeEventValue) {
+            std::this_thread::yield();
+        }
     }
 }
 
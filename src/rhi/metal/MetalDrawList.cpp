@@ -0,0 +1,80 @@
+// ============================================================================
+// src/rhi/metal/MetalDrawList.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalDrawList.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+MetalDrawList::MetalDrawList(GraphicsDevice& device, MetalContext& context, const DrawListDesc& desc)
+    : DrawList(device, desc)
+    , m_Context(context) {
+}
+
+MetalDrawList::~MetalDrawList() {
+    for (Encoded& encoded : m_Encoded) {
+        m_Context.memory->Remove(MemoryCategory::Geometry, encoded.bytes);
+        encoded.commands->release();
+        encoded.indexBuffer->release();
+    }
+    m_Encoded.clear();
+}
+
+MTL::IndirectCommandBuffer* MetalDrawList::GetIndirectCommandBuffer(MTL::Buffer* indexBuffer,
+                                                                    uint64 indexBufferOffset,
+                                                                    MTL::IndexType indexType,
+                                                                    MTL::PrimitiveType primitiveType) {
+    if (!m_Context.supportsIndirectCommandBuffers || !indexBuffer || GetDrawCount() == 0) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::find_if(m_Encoded.begin(), m_Encoded.end(), [&](const Encoded& e) {
+        return e.indexBuffer == indexBuffer && e.indexBufferOffset == indexBufferOffset &&
+               e.indexType == indexType && e.primitiveType == primitiveType;
+    });
+    if (it != m_Encoded.end()) {
+        return it->commands;
+    }
+
+    // Every command inherits the pipeline and the buffers bound when executed
+    MTL::IndirectCommandBufferDescriptor* icbDesc = MTL::IndirectCommandBufferDescriptor::alloc()->init();
+    icbDesc->setCommandTypes(MTL::IndirectCommandTypeDrawIndexed);
+    icbDesc->setInheritPipelineState(true);
+    icbDesc->setInheritBuffers(true);
+    MTL::IndirectCommandBuffer* commands =
+        m_Context.device->newIndirectCommandBuffer(icbDesc, GetDrawCount(), MTL::ResourceStorageModeShared);
+    icbDesc->release();
+    m_Context.stats->AddAllocation();
+    if (!commands) {
+        MTL_LOG_ERROR("Failed to create an indirect command buffer of " << GetDrawCount() << " draws");
+        return nullptr;
+    }
+
+    const uint64 indexSize = indexType == MTL::IndexTypeUInt32 ? 4 : 2;
+    const std::vector<DrawIndexedIndirectCommand>& draws = GetCommands();
+    for (uint32 i = 0; i < GetDrawCount(); ++i) {
+        const DrawIndexedIndirectCommand& draw = draws[i];
+        commands->indirectRenderCommand(i)->drawIndexedPrimitives(
+            primitiveType, draw.indexCount, indexType, indexBuffer,
+            indexBufferOffset + draw.firstIndex * indexSize, draw.instanceCount, draw.vertexOffset,
+            draw.firstInstance);
+    }
+
+    Encoded encoded;
+    encoded.commands = commands;
+    encoded.indexBuffer = indexBuffer->retain();  // Encoded into the commands
+    encoded.indexBufferOffset = indexBufferOffset;
+    encoded.indexType = indexType;
+    encoded.primitiveType = primitiveType;
+    encoded.bytes = commands->allocatedSize();
+    m_Context.memory->Add(MemoryCategory::Geometry, encoded.bytes);
+    m_Encoded.push_back(encoded);
+    return commands;
+}
+
+} // namespace rhi
+} // namespace metagfx
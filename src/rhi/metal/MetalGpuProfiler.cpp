@@ -0,0 +1,82 @@
+// ============================================================================
+// src/rhi/metal/MetalGpuProfiler.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalGpuProfiler.h"
+#include "metagfx/rhi/metal/MetalCommandBuffer.h"
+
+namespace metagfx {
+namespace rhi {
+
+MTL::CounterSet* MetalGpuProfiler::FindTimestampCounterSet(MTL::Device* device) {
+    NS::Array* counterSets = device->counterSets();
+    if (!counterSets) {
+        return nullptr;
+    }
+    for (NS::UInteger i = 0; i < counterSets->count(); ++i) {
+        auto* counterSet = counterSets->object<MTL::CounterSet>(i);
+        if (counterSet->name()->isEqualToString(MTL::CommonCounterSetTimestamp)) {
+            return counterSet;
+        }
+    }
+    return nullptr;
+}
+
+MetalGpuProfiler::MetalGpuProfiler(MetalContext& context, uint32 frameCount, MTL::CounterSet* timestampCounterSet)
+    : GpuProfiler(frameCount), m_Context(context) {
+    MTL::CounterSampleBufferDescriptor* desc = MTL::CounterSampleBufferDescriptor::alloc()->init();
+    desc->setCounterSet(timestampCounterSet);
+    desc->setStorageMode(MTL::StorageModeShared);
+    desc->setSampleCount(frameCount * MAX_QUERIES);
+
+    NS::Error* error = nullptr;
+    m_SampleBuffer = m_Context.device->newCounterSampleBuffer(desc, &error);
+    desc->release();
+    if (!m_SampleBuffer) {
+        METAGFX_ERROR << "Failed to create Metal counter sample buffer: "
+                      << (error ? error->localizedDescription()->utf8String() : "unknown error");
+    }
+
+    m_Context.device->sampleTimestamps(&m_CalibrationCpu, &m_CalibrationGpu);
+}
+
+MetalGpuProfiler::~MetalGpuProfiler() {
+    if (m_SampleBuffer) {
+        m_SampleBuffer->release();
+    }
+}
+
+bool MetalGpuProfiler::WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) {
+    return m_SampleBuffer &&
+           static_cast<MetalCommandBuffer&>(cmd).WriteTimestamp(m_SampleBuffer, frameIndex * MAX_QUERIES + query);
+}
+
+bool MetalGpuProfiler::ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) {
+    if (!m_SampleBuffer) {
+        return false;
+    }
+    NS::Data* data = m_SampleBuffer->resolveCounterRange(NS::Range::Make(frameIndex * MAX_QUERIES, queryCount));
+    if (!data || data->length() < queryCount * sizeof(MTL::CounterResultTimestamp)) {
+        return false;
+    }
+
+    // Apple GPUs tick in nanoseconds; others are scaled by the CPU clock over the session
+    MTL::Timestamp cpu = 0;
+    MTL::Timestamp gpu = 0;
+    m_Context.device->sampleTimestamps(&cpu, &gpu);
+    if (gpu > m_CalibrationGpu && cpu > m_CalibrationCpu) {
+        m_NanosecondsPerTick = static_cast<double>(cpu - m_CalibrationCpu) / static_cast<double>(gpu - m_CalibrationGpu);
+    }
+
+    const auto* samples = static_cast<const MTL::CounterResultTimestamp*>(data->mutableBytes());
+    for (uint32 i = 0; i < queryCount; ++i) {
+        uint64 ticks = samples[i].timestamp;
+        nanoseconds[i] = ticks == MTL::CounterErrorValue || ticks == 0
+            ? INVALID_TIMESTAMP
+            : static_cast<uint64>(static_cast<double>(ticks) * m_NanosecondsPerTick);
+    }
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
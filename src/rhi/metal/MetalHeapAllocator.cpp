@@ -0,0 +1,176 @@
+// ============================================================================
+// src/rhi/metal/MetalHeapAllocator.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalHeapAllocator.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+MetalHeapAllocator::MetalHeapAllocator(MetalContext& context)
+    : m_Context(context) {
+}
+
+MetalHeapAllocator::~MetalHeapAllocator() {
+    for (Heap& heap : m_Heaps) {
+        if (heap.resourceCount > 0) {
+            METAGFX_WARN << "Metal heap released with " << heap.resourceCount << " resources still placed in it";
+        }
+        heap.heap->release();
+    }
+    m_Heaps.clear();
+}
+
+bool MetalHeapAllocator::CanPlace(MTL::StorageMode storageMode) const {
+    // Heaps take no managed or memoryless resources, and shared ones only where the GPU
+    // shares the CPU's memory
+    return storageMode == MTL::StorageModePrivate ||
+           (storageMode == MTL::StorageModeShared && m_Context.device->hasUnifiedMemory());
+}
+
+MTL::Texture* MetalHeapAllocator::NewTexture(MTL::TextureDescriptor* desc, ResourceGroup group,
+                                             MTL::Heap*& outHeap) {
+    outHeap = nullptr;
+    if (!CanPlace(desc->storageMode())) {
+        return nullptr;
+    }
+    MTL::SizeAndAlign sizeAndAlign = m_Context.device->heapTextureSizeAndAlign(desc);
+    if (sizeAndAlign.size > MAX_HEAP_SIZE / 2) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        // A heap whose free space is split may still fail; a new one cannot
+        Heap* heap = FindHeap(sizeAndAlign, group, desc->storageMode(), desc->cpuCacheMode(), attempt == 1);
+        if (!heap) {
+            return nullptr;
+        }
+        if (MTL::Texture* texture = heap->heap->newTexture(desc)) {
+            heap->resourceCount++;
+            outHeap = heap->heap;
+            return texture;
+        }
+    }
+    return nullptr;
+}
+
+MTL::Buffer* MetalHeapAllocator::NewBuffer(NS::UInteger length, MTL::ResourceOptions options, ResourceGroup group,
+                                           MTL::Heap*& outHeap) {
+    outHeap = nullptr;
+    auto storageMode = static_cast<MTL::StorageMode>((options & MTL::ResourceStorageModeMask) >>
+                                                     MTL::ResourceStorageModeShift);
+    auto cpuCacheMode = static_cast<MTL::CPUCacheMode>((options & MTL::ResourceCPUCacheModeMask) >>
+                                                       MTL::ResourceCPUCacheModeShift);
+    if (!CanPlace(storageMode)) {
+        return nullptr;
+    }
+    MTL::SizeAndAlign sizeAndAlign = m_Context.device->heapBufferSizeAndAlign(length, options);
+    if (sizeAndAlign.size > MAX_HEAP_SIZE / 2) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (int attempt = 0; attempt < 2; ++attempt) {
+        Heap* heap = FindHeap(sizeAndAlign, group, storageMode, cpuCacheMode, attempt == 1);
+        if (!heap) {
+            return nullptr;
+        }
+        if (MTL::Buffer* buffer = heap->heap->newBuffer(length, options)) {
+            heap->resourceCount++;
+            outHeap = heap->heap;
+            return buffer;
+        }
+    }
+    return nullptr;
+}
+
+void MetalHeapAllocator::Release(MTL::Heap* heap) {
+    if (!heap) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::find_if(m_Heaps.begin(), m_Heaps.end(), [heap](const Heap& h) { return h.heap == heap; });
+    if (it == m_Heaps.end() || --it->resourceCount > 0) {
+        return;
+    }
+
+    // A group's heaps go with its last resource; the shared group keeps one empty heap
+    // per storage mode around, so resources recreated every so often do not churn heaps
+    if (it->group == 0) {
+        size_t emptyCount = std::count_if(m_Heaps.begin(), m_Heaps.end(), [&](const Heap& h) {
+            return h.group == 0 && h.resourceCount == 0 && h.storageMode == it->storageMode &&
+                   h.cpuCacheMode == it->cpuCacheMode;
+        });
+        if (emptyCount == 1) {
+            return;
+        }
+    }
+    it->heap->release();
+    m_Heaps.erase(it);
+}
+
+MetalHeapAllocator::Stats MetalHeapAllocator::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Stats stats;
+    for (const Heap& heap : m_Heaps) {
+        stats.heapCount++;
+        stats.resourceCount += heap.resourceCount;
+        stats.heapBytes += heap.heap->size();
+        stats.usedBytes += heap.heap->usedSize();
+    }
+    return stats;
+}
+
+MetalHeapAllocator::Heap* MetalHeapAllocator::FindHeap(MTL::SizeAndAlign sizeAndAlign, ResourceGroup group,
+                                                       MTL::StorageMode storageMode, MTL::CPUCacheMode cpuCacheMode,
+                                                       bool createNew) {
+    uint32 groupHeapCount = 0;
+    for (Heap& heap : m_Heaps) {
+        if (heap.group != group || heap.storageMode != storageMode || heap.cpuCacheMode != cpuCacheMode) {
+            continue;
+        }
+        groupHeapCount++;
+        if (!createNew && heap.heap->maxAvailableSize(sizeAndAlign.align) >= sizeAndAlign.size) {
+            return &heap;
+        }
+    }
+
+    // Small groups (a light model) stay in small heaps; each further heap doubles
+    uint64 size = std::min(MIN_HEAP_SIZE << std::min(groupHeapCount, 3u), MAX_HEAP_SIZE);
+    size = std::max<uint64>(size, sizeAndAlign.size + sizeAndAlign.align);
+    return CreateHeap(size, group, storageMode, cpuCacheMode);
+}
+
+MetalHeapAllocator::Heap* MetalHeapAllocator::CreateHeap(uint64 size, ResourceGroup group,
+                                                         MTL::StorageMode storageMode,
+                                                         MTL::CPUCacheMode cpuCacheMode) {
+    MTL::HeapDescriptor* heapDesc = MTL::HeapDescriptor::alloc()->init();
+    heapDesc->setType(MTL::HeapTypeAutomatic);
+    heapDesc->setSize(size);
+    heapDesc->setStorageMode(storageMode);
+    heapDesc->setCpuCacheMode(cpuCacheMode);
+    heapDesc->setHazardTrackingMode(MTL::HazardTrackingModeTracked);
+    MTL::Heap* mtlHeap = m_Context.device->newHeap(heapDesc);
+    heapDesc->release();
+    m_Context.stats->AddAllocation();
+
+    if (!mtlHeap) {
+        MTL_LOG_ERROR("Failed to create a heap of " << size << " bytes");
+        return nullptr;
+    }
+
+    Heap heap;
+    heap.heap = mtlHeap;
+    heap.group = group;
+    heap.storageMode = storageMode;
+    heap.cpuCacheMode = cpuCacheMode;
+    m_Heaps.push_back(heap);
+    return &m_Heaps.back();
+}
+
+} // namespace rhi
+} // namespace metagfx
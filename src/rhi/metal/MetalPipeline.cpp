@@ -3,8 +3,12 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/metal/MetalPipeline.h"
+#include "metagfx/rhi/metal/MetalPipelineCache.h"
 #include "metagfx/rhi/metal/MetalShader.h"
 
+#include <algorithm>
+#include <atomic>
+
 namespace metagfx {
 namespace rhi {
 
@@ -16,19 +20,34 @@ MetalPipeline::MetalPipeline(MetalContext& context, const PipelineDesc& desc)
     m_CullMode = ToMetalCullMode(desc.rasterization.cullMode);
     m_FrontFace = ToMetalFrontFace(desc.rasterization.frontFace);
     m_FillMode = ToMetalPolygonMode(desc.rasterization.polygonMode);
+    m_ViewCount = std::max(desc.viewCount, 1u);
 
     // Create render pipeline descriptor
     MTL::RenderPipelineDescriptor* pipelineDesc = MTL::RenderPipelineDescriptor::alloc()->init();
 
     // Set shaders
+    // Specialization constants become function constants; the descriptor retains the functions.
+    // Those taking an argument buffer are kept too, for descriptor sets to encode it from.
+    auto setFunction = [&](const Ref<Shader>& shader, ArgumentLayout& arguments, bool vertex) {
+        auto metalShader = static_cast<MetalShader*>(shader.get());
+        MTL::Function* function = metalShader->CreateSpecializedFunction(desc.specializationConstants);
+        if (vertex) {
+            pipelineDesc->setVertexFunction(function);
+        } else {
+            pipelineDesc->setFragmentFunction(function);
+        }
+        if (function && !metalShader->GetArgumentIds().empty()) {
+            arguments.function = function;
+            arguments.ids = metalShader->GetArgumentIds();
+        } else if (function) {
+            function->release();
+        }
+    };
     if (desc.vertexShader) {
-        auto metalShader = static_cast<MetalShader*>(desc.vertexShader.get());
-        pipelineDesc->setVertexFunction(metalShader->GetFunction());
+        setFunction(desc.vertexShader, m_VertexArguments, true);
     }
-
     if (desc.fragmentShader) {
-        auto metalShader = static_cast<MetalShader*>(desc.fragmentShader.get());
-        pipelineDesc->setFragmentFunction(metalShader->GetFunction());
+        setFunction(desc.fragmentShader, m_FragmentArguments, false);
     }
 
     // Set vertex descriptor using vertexInputState (preferred) or vertexInput (legacy)
@@ -38,8 +57,8 @@ MetalPipeline::MetalPipeline(MetalContext& context, const PipelineDesc& desc)
     const auto& bindings = desc.vertexInputState.bindings;
 
     // DEBUG: Log vertex descriptor setup
-    static int pipelineCount = 0;
-    pipelineCount++;
+    static std::atomic<int> s_PipelineCount{0};  // Pipelines may be compiled on worker threads
+    int pipelineCount = ++s_PipelineCount;
     bool logThis = (pipelineCount <= 5);
     if (logThis) {
         METAGFX_INFO << "MetalPipeline " << pipelineCount << ": " << attributes.size() << " vertex attributes, stride=" << desc.vertexInput.stride;
@@ -87,35 +106,73 @@ MetalPipeline::MetalPipeline(MetalContext& context, const PipelineDesc& desc)
         vertexDesc->release();
     }
 
-    // Set color attachments - use BGRA8 as default format (common swap chain format)
+    // Set color attachments - desc.colorFormats, with Format::Undefined (and attachments
+    // past the listed formats) being BGRA8, the swap chain format
+    auto colorPixelFormat = [&desc](size_t i) {
+        Format format = i < desc.colorFormats.size() ? desc.colorFormats[i] : Format::Undefined;
+        return format == Format::Undefined ? MTL::PixelFormatBGRA8Unorm : ToMetalPixelFormat(format);
+    };
     if (desc.colorAttachments.empty()) {
-        // Default: one color attachment with BGRA8
-        pipelineDesc->colorAttachments()->object(0)->setPixelFormat(MTL::PixelFormatBGRA8Unorm);
+        // Default: one color attachment
+        pipelineDesc->colorAttachments()->object(0)->setPixelFormat(colorPixelFormat(0));
     } else {
         for (size_t i = 0; i < desc.colorAttachments.size(); ++i) {
-            // ColorAttachmentState doesn't have format, use default
-            pipelineDesc->colorAttachments()->object(i)->setPixelFormat(MTL::PixelFormatBGRA8Unorm);
+            pipelineDesc->colorAttachments()->object(i)->setPixelFormat(colorPixelFormat(i));
+            if (!desc.colorAttachments[i].writeEnable) {
+                pipelineDesc->colorAttachments()->object(i)->setWriteMask(MTL::ColorWriteMaskNone);
+            }
 
             // Set blending if enabled
             if (desc.colorAttachments[i].blendEnable) {
-                pipelineDesc->colorAttachments()->object(i)->setBlendingEnabled(true);
-                // Default blend mode (src alpha, one minus src alpha)
-                pipelineDesc->colorAttachments()->object(i)->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
-                pipelineDesc->colorAttachments()->object(i)->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
-                pipelineDesc->colorAttachments()->object(i)->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
-                pipelineDesc->colorAttachments()->object(i)->setDestinationAlphaBlendFactor(MTL::BlendFactorZero);
+                auto* attachment = pipelineDesc->colorAttachments()->object(i);
+                attachment->setBlendingEnabled(true);
+                switch (desc.colorAttachments[i].blendMode) {
+                    case BlendMode::Alpha:
+                        attachment->setSourceRGBBlendFactor(MTL::BlendFactorSourceAlpha);
+                        attachment->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+                        attachment->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
+                        attachment->setDestinationAlphaBlendFactor(MTL::BlendFactorZero);
+                        break;
+                    case BlendMode::Additive:
+                        attachment->setSourceRGBBlendFactor(MTL::BlendFactorOne);
+                        attachment->setDestinationRGBBlendFactor(MTL::BlendFactorOne);
+                        attachment->setSourceAlphaBlendFactor(MTL::BlendFactorOne);
+                        attachment->setDestinationAlphaBlendFactor(MTL::BlendFactorOne);
+                        break;
+                    case BlendMode::Attenuate:
+                        attachment->setSourceRGBBlendFactor(MTL::BlendFactorZero);
+                        attachment->setDestinationRGBBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+                        attachment->setSourceAlphaBlendFactor(MTL::BlendFactorZero);
+                        attachment->setDestinationAlphaBlendFactor(MTL::BlendFactorOneMinusSourceAlpha);
+                        break;
+                }
             }
         }
     }
 
+    pipelineDesc->setRasterSampleCount(desc.sampleCount);
+
+    // Layered rendering (multiview) needs the primitive class up front on macOS
+    if (m_ViewCount > 1) {
+        pipelineDesc->setInputPrimitiveTopology(
+            m_PrimitiveType == MTL::PrimitiveTypePoint ? MTL::PrimitiveTopologyClassPoint
+            : (m_PrimitiveType == MTL::PrimitiveTypeLine || m_PrimitiveType == MTL::PrimitiveTypeLineStrip)
+                ? MTL::PrimitiveTopologyClassLine : MTL::PrimitiveTopologyClassTriangle);
+    }
+
+    // Any pipeline may be bound when a draw list replays its indirect command buffer
+    pipelineDesc->setSupportIndirectCommandBuffers(m_Context.supportsIndirectCommandBuffers);
+
     // Set depth attachment format (use D32 as default depth format)
     if (desc.depthStencil.depthTestEnable || desc.depthStencil.depthWriteEnable) {
         pipelineDesc->setDepthAttachmentPixelFormat(MTL::PixelFormatDepth32Float);
     }
 
-    // Create render pipeline state
+    // Create render pipeline state, from the binary archive when it has been compiled before
     NS::Error* error = nullptr;
-    m_RenderPipelineState = m_Context.device->newRenderPipelineState(pipelineDesc, &error);
+    m_RenderPipelineState = m_Context.pipelineCache
+        ? m_Context.pipelineCache->CreateRenderPipelineState(pipelineDesc, &error)
+        : m_Context.device->newRenderPipelineState(pipelineDesc, &error);
     pipelineDesc->release();
 
     if (error || !m_RenderPipelineState) {
@@ -148,6 +205,12 @@ MetalPipeline::~MetalPipeline() {
         m_RenderPipelineState->release();
         m_RenderPipelineState = nullptr;
     }
+    for (ArgumentLayout* arguments : { &m_VertexArguments, &m_FragmentArguments }) {
+        if (arguments->function) {
+            arguments->function->release();
+            arguments->function = nullptr;
+        }
+    }
 }
 
 } // namespace rhi
@@ -0,0 +1,264 @@
+// ============================================================================
+// src/rhi/metal/MetalPipelineCache.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/metal/MetalPipelineCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+// Bump when the SPIR-V to MSL translation options in MetalShader change
+constexpr uint32 MSL_CACHE_VERSION = 2;
+
+const char* GetStageTag(ShaderStage stage) {
+    switch (stage) {
+        case ShaderStage::Vertex:   return "vert";
+        case ShaderStage::Fragment: return "frag";
+        case ShaderStage::Compute:  return "comp";
+        default:                    return "other";
+    }
+}
+
+bool FileExists(const std::string& path) {
+    std::error_code ec;
+    return std::filesystem::exists(path, ec);
+}
+
+} // namespace
+
+MetalPipelineCache::MetalPipelineCache(MetalContext& context, const std::string& filePath)
+    : m_Context(context) {
+    if (filePath.empty() || !m_Context.device) {
+        return;
+    }
+
+    m_ArchivePath = filePath + ".binarchive";
+    m_ShaderDirectory = filePath + ".msl";
+    std::error_code ec;
+    std::filesystem::create_directories(m_ShaderDirectory, ec);
+    if (ec) {
+        METAGFX_WARN << "Failed to create shader cache directory: " << m_ShaderDirectory;
+        m_ShaderDirectory.clear();
+    }
+
+    // An archive from another OS or GPU fails to load; it is replaced on the next save
+    MTL::BinaryArchiveDescriptor* archiveDesc = MTL::BinaryArchiveDescriptor::alloc()->init();
+    bool loading = FileExists(m_ArchivePath);
+    if (loading) {
+        NS::String* path = NS::String::string(m_ArchivePath.c_str(), NS::UTF8StringEncoding);
+        archiveDesc->setUrl(NS::URL::fileURLWithPath(path));
+    }
+    NS::Error* error = nullptr;
+    m_Archive = m_Context.device->newBinaryArchive(archiveDesc, &error);
+    if (!m_Archive && loading) {
+        METAGFX_INFO << "Pipeline archive unusable on this system, rebuilding: " << m_ArchivePath;
+        archiveDesc->setUrl(nullptr);
+        error = nullptr;
+        m_Archive = m_Context.device->newBinaryArchive(archiveDesc, &error);
+    }
+    archiveDesc->release();
+
+    if (!m_Archive) {
+        METAGFX_WARN << "Binary archives unavailable, pipelines are compiled every launch";
+    } else if (loading) {
+        METAGFX_INFO << "Loaded pipeline archive: " << m_ArchivePath;
+    }
+}
+
+MetalPipelineCache::~MetalPipelineCache() {
+    if (!m_Archive) {
+        return;
+    }
+    if (m_Dirty.load(std::memory_order_relaxed)) {
+        Save();
+    }
+    m_Archive->release();
+    m_Archive = nullptr;
+}
+
+uint64 MetalPipelineCache::HashSpirv(const void* data, uint64 size) {
+    // FNV-1a; shader modules are a few KB
+    const uint8* bytes = static_cast<const uint8*>(data);
+    uint64 hash = 0xcbf29ce484222325ull;
+    for (uint64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+std::string MetalPipelineCache::GetShaderPath(uint64 spirvHash, const char* extension) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(spirvHash));
+    return m_ShaderDirectory + "/" + name + extension;
+}
+
+bool MetalPipelineCache::LoadMSL(uint64 spirvHash, ShaderStage stage, std::string& outSource,
+                                 uint32 outThreadGroupSize[3]) const {
+    if (m_ShaderDirectory.empty()) {
+        return false;
+    }
+    std::ifstream in(GetShaderPath(spirvHash, ".metal"));
+    if (!in.is_open()) {
+        return false;
+    }
+
+    // First line: "// metagfx-msl <version> <stage> <x> <y> <z>"
+    std::string line;
+    std::getline(in, line);
+    std::istringstream header(line);
+    std::string comment, tag, stageTag;
+    uint32 version = 0;
+    uint32 size[3] = { 1, 1, 1 };
+    header >> comment >> tag >> version >> stageTag >> size[0] >> size[1] >> size[2];
+    if (!header || tag != "metagfx-msl" || version != MSL_CACHE_VERSION || stageTag != GetStageTag(stage)) {
+        return false;
+    }
+
+    std::ostringstream source;
+    source << line << '\n' << in.rdbuf();
+    outSource = source.str();
+    for (uint32 i = 0; i < 3; ++i) {
+        outThreadGroupSize[i] = size[i];
+    }
+    return true;
+}
+
+void MetalPipelineCache::StoreMSL(uint64 spirvHash, ShaderStage stage, const std::string& source,
+                                  const uint32 threadGroupSize[3]) const {
+    if (m_ShaderDirectory.empty()) {
+        return;
+    }
+
+    // Renamed into place, so a concurrent reader never sees a partial file
+    std::string path = GetShaderPath(spirvHash, ".metal");
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!out.is_open()) {
+            return;
+        }
+        out << "// metagfx-msl " << MSL_CACHE_VERSION << ' ' << GetStageTag(stage) << ' '
+            << threadGroupSize[0] << ' ' << threadGroupSize[1] << ' ' << threadGroupSize[2] << '\n'
+            << source;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+MTL::Library* MetalPipelineCache::LoadLibrary(uint64 spirvHash) const {
+    if (m_ShaderDirectory.empty()) {
+        return nullptr;
+    }
+    std::string path = GetShaderPath(spirvHash, ".metallib");
+    if (!FileExists(path)) {
+        return nullptr;
+    }
+
+    NS::Error* error = nullptr;
+    MTL::Library* library = m_Context.device->newLibrary(NS::String::string(path.c_str(), NS::UTF8StringEncoding), &error);
+    if (!library) {
+        METAGFX_WARN << "Ignoring unloadable metallib: " << path;
+    }
+    return library;
+}
+
+MTL::RenderPipelineState* MetalPipelineCache::CreateRenderPipelineState(MTL::RenderPipelineDescriptor* descriptor,
+                                                                        NS::Error** error) {
+    if (!m_Archive) {
+        return m_Context.device->newRenderPipelineState(descriptor, error);
+    }
+
+    std::lock_guard<std::mutex> lock(m_ArchiveMutex);
+    descriptor->setBinaryArchives(NS::Array::array(m_Archive));
+
+    NS::Error* missError = nullptr;
+    MTL::RenderPipelineState* state = m_Context.device->newRenderPipelineState(
+        descriptor, MTL::PipelineOptionFailOnBinaryArchiveMiss, nullptr, &missError);
+    if (state) {
+        return state;
+    }
+
+    // Miss: compile the functions into the archive, then create the state from it
+    NS::Error* addError = nullptr;
+    if (m_Archive->addRenderPipelineFunctions(descriptor, &addError)) {
+        m_Dirty.store(true, std::memory_order_relaxed);
+    }
+    return m_Context.device->newRenderPipelineState(descriptor, error);
+}
+
+MTL::ComputePipelineState* MetalPipelineCache::CreateComputePipelineState(MTL::ComputePipelineDescriptor* descriptor,
+                                                                          NS::Error** error) {
+    if (!m_Archive) {
+        return m_Context.device->newComputePipelineState(descriptor, MTL::PipelineOptionNone, nullptr, error);
+    }
+
+    std::lock_guard<std::mutex> lock(m_ArchiveMutex);
+    descriptor->setBinaryArchives(NS::Array::array(m_Archive));
+
+    NS::Error* missError = nullptr;
+    MTL::ComputePipelineState* state = m_Context.device->newComputePipelineState(
+        descriptor, MTL::PipelineOptionFailOnBinaryArchiveMiss, nullptr, &missError);
+    if (state) {
+        return state;
+    }
+
+    NS::Error* addError = nullptr;
+    if (m_Archive->addComputePipelineFunctions(descriptor, &addError)) {
+        m_Dirty.store(true, std::memory_order_relaxed);
+    }
+    return m_Context.device->newComputePipelineState(descriptor, MTL::PipelineOptionNone, nullptr, error);
+}
+
+void MetalPipelineCache::Tick() {
+    if (++m_FramesSinceSave < SAVE_INTERVAL_FRAMES) {
+        return;
+    }
+    m_FramesSinceSave = 0;
+    if (m_Dirty.load(std::memory_order_relaxed)) {
+        Save();
+    }
+}
+
+bool MetalPipelineCache::Save() {
+    if (!m_Archive) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_ArchiveMutex);
+    m_Dirty.store(false, std::memory_order_relaxed);
+
+    // Serialized next to the old archive and renamed over it
+    std::string tempPath = m_ArchivePath + ".tmp";
+    NS::URL* url = NS::URL::fileURLWithPath(NS::String::string(tempPath.c_str(), NS::UTF8StringEncoding));
+    NS::Error* error = nullptr;
+    if (!m_Archive->serializeToURL(url, &error)) {
+        METAGFX_WARN << "Failed to write pipeline archive: " << m_ArchivePath
+                     << (error ? std::string(" (") + error->localizedDescription()->utf8String() + ")" : "");
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, m_ArchivePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        METAGFX_WARN << "Failed to write pipeline archive: " << m_ArchivePath;
+        return false;
+    }
+
+    METAGFX_DEBUG << "Saved pipeline archive: " << m_ArchivePath;
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
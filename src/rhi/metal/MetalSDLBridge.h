@@ -29,6 +29,9 @@ MTL::PixelFormat GetMetalLayerPixelFormat(CA::MetalLayer* layer);
 // Set the drawable size on the Metal layer
 void SetMetalLayerDrawableSize(CA::MetalLayer* layer, uint32_t width, uint32_t height);
 
+// Sync presentation to the display refresh (macOS only; iOS always syncs)
+void SetMetalLayerDisplaySyncEnabled(CA::MetalLayer* layer, bool enabled);
+
 // Get the next drawable from the Metal layer
 CA::MetalDrawable* GetNextDrawable(CA::MetalLayer* layer);
 
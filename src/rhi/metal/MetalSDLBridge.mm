@@ -58,6 +58,18 @@ void SetMetalLayerDrawableSize(CA::MetalLayer* layer, uint32_t width, uint32_t h
     objcLayer.drawableSize = CGSizeMake(static_cast<CGFloat>(width), static_cast<CGFloat>(height));
 }
 
+void SetMetalLayerDisplaySyncEnabled(CA::MetalLayer* layer, bool enabled) {
+#if TARGET_OS_OSX
+    CAMetalLayer* objcLayer = (__bridge CAMetalLayer*)layer;
+    if (@available(macOS 10.13, *)) {
+        objcLayer.displaySyncEnabled = enabled ? YES : NO;
+    }
+#else
+    (void)layer;
+    (void)enabled;
+#endif
+}
+
 CA::MetalDrawable* GetNextDrawable(CA::MetalLayer* layer) {
     CAMetalLayer* objcLayer = (__bridge CAMetalLayer*)layer;
     id<CAMetalDrawable> drawable = [objcLayer nextDrawable];
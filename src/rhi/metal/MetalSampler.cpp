@@ -29,6 +29,9 @@ MetalSampler::MetalSampler(MetalContext& context, const SamplerDesc& desc)
     samplerDesc->setLodMinClamp(desc.minLod);
     samplerDesc->setLodMaxClamp(desc.maxLod);
 
+    // Descriptor sets encode samplers into argument buffers (MetalDescriptorSet)
+    samplerDesc->setSupportArgumentBuffers(m_Context.supportsArgumentBuffers);
+
     m_Sampler = m_Context.device->newSamplerState(samplerDesc);
     samplerDesc->release();
 
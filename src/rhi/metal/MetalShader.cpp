@@ -3,19 +3,25 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/metal/MetalShader.h"
+#include "metagfx/rhi/metal/MetalPipelineCache.h"
 
 // SPIRV-Cross for SPIR-V to MSL translation
 #include <spirv_msl.hpp>
 
+#include <algorithm>
+#include <cstdlib>
 #include <vector>
 
 namespace metagfx {
 namespace rhi {
 
-MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
-    : m_Context(context)
-    , m_Stage(desc.stage) {
-
+// SPIR-V to MSL with the binding layout the Metal backend expects (see MetalTypes.h).
+// With argumentBuffers, set 0 but its uniform buffers becomes an argument buffer; higher
+// sets (per pass, per material) stay bound directly, their binding numbers being unique
+// across the pipeline's sets. Outputs the compute local size too, which Metal takes at
+// dispatch time.
+static bool TranslateToMSL(const ShaderDesc& desc, bool argumentBuffers, std::string& outSource,
+                           uint32 outThreadGroupSize[3]) {
     // Convert SPIR-V to MSL using SPIRV-Cross
     std::vector<uint32_t> spirvData(
         reinterpret_cast<const uint32_t*>(desc.code.data()),
@@ -23,68 +29,122 @@ MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
     );
 
     spirv_cross::CompilerMSL mslCompiler(spirvData);
+    spirv_cross::ShaderResources resources = mslCompiler.get_shader_resources();
 
-    // Set MSL options
+    // Set MSL options; ray queries (intersection_query) need MSL 2.4
     spirv_cross::CompilerMSL::Options mslOptions;
     mslOptions.platform = spirv_cross::CompilerMSL::Options::macOS;
-    mslOptions.msl_version = spirv_cross::CompilerMSL::Options::make_msl_version(2, 0);
+    mslOptions.msl_version = resources.acceleration_structures.empty()
+                                 ? spirv_cross::CompilerMSL::Options::make_msl_version(2, 0)
+                                 : spirv_cross::CompilerMSL::Options::make_msl_version(2, 4);
+    if (argumentBuffers) {
+        mslOptions.argument_buffers = true;
+        mslOptions.argument_buffers_tier = spirv_cross::CompilerMSL::Options::ArgumentBuffersTier::Tier2;
+    }
+    // Multiview vertex shaders draw each view as an instance into its own render target
+    // layer, gl_ViewIndex coming from the instance index and the view mask buffer
+    const auto& capabilities = mslCompiler.get_declared_capabilities();
+    if (desc.stage == ShaderStage::Vertex &&
+        std::find(capabilities.begin(), capabilities.end(), spv::CapabilityMultiView) != capabilities.end()) {
+        mslOptions.multiview = true;
+        mslOptions.multiview_layered_rendering = true;
+        mslOptions.view_mask_buffer_index = METAL_VIEW_MASK_BUFFER_INDEX;
+    }
     mslCompiler.set_msl_options(mslOptions);
 
+    const spv::ExecutionModel executionModel =
+        (desc.stage == ShaderStage::Vertex) ? spv::ExecutionModelVertex :
+        (desc.stage == ShaderStage::Fragment) ? spv::ExecutionModelFragment :
+        spv::ExecutionModelGLCompute;
+
+    // Uniform buffers stay out of the argument buffers, in a set of their own bound
+    // directly: their dynamic offsets then move with setVertexBufferOffset per draw
+    // instead of re-encoding the argument buffer
+    const uint32_t DIRECT_SET = 7;
+    if (argumentBuffers) {
+        mslCompiler.add_discrete_descriptor_set(DIRECT_SET);
+    }
+
     // Override resource bindings to preserve Vulkan binding indices in MSL
     // IMPORTANT: In Metal, vertex buffers and uniform buffers share the same buffer index namespace!
-    // We need to offset uniform/storage buffers to avoid conflicting with vertex buffer at index 0.
-    // Use an offset of 10 for descriptor buffers to leave room for vertex buffers (0-9).
-    const uint32_t BUFFER_OFFSET = 10;  // Offset for uniform/storage buffers to avoid vertex buffer conflicts
-
+    // Directly bound buffers are offset by METAL_BUFFER_OFFSET to leave room for vertex buffers (0-9).
+    std::vector<uint32_t> argumentSets;
     auto addResourceBindings = [&](const spirv_cross::SmallVector<spirv_cross::Resource>& resources,
-                                   spirv_cross::SPIRType::BaseType expectedType,
-                                   bool isBuffer) {
+                                   bool isBuffer, bool direct) {
         for (const auto& resource : resources) {
             uint32_t set = mslCompiler.get_decoration(resource.id, spv::DecorationDescriptorSet);
             uint32_t binding = mslCompiler.get_decoration(resource.id, spv::DecorationBinding);
 
             spirv_cross::MSLResourceBinding mslBinding;
-            mslBinding.stage = (desc.stage == ShaderStage::Vertex) ? spv::ExecutionModelVertex :
-                               (desc.stage == ShaderStage::Fragment) ? spv::ExecutionModelFragment :
-                               spv::ExecutionModelGLCompute;
-            mslBinding.desc_set = set;
+            mslBinding.stage = executionModel;
             mslBinding.binding = binding;
-            // Offset buffer bindings to avoid conflict with vertex buffers at index 0
-            mslBinding.msl_buffer = isBuffer ? (binding + BUFFER_OFFSET) : binding;
-            mslBinding.msl_texture = binding;  // Textures have separate namespace, no offset needed
-            mslBinding.msl_sampler = binding;  // Samplers have separate namespace, no offset needed
+            if (!argumentBuffers || direct || set != 0) {
+                if (argumentBuffers) {
+                    mslCompiler.set_decoration(resource.id, spv::DecorationDescriptorSet, DIRECT_SET);
+                    set = DIRECT_SET;
+                }
+                // Offset buffer bindings to avoid conflict with vertex buffers at index 0
+                mslBinding.msl_buffer = isBuffer ? (binding + METAL_BUFFER_OFFSET) : binding;
+                mslBinding.msl_texture = binding;  // Textures have separate namespace, no offset needed
+                mslBinding.msl_sampler = binding;  // Samplers have separate namespace, no offset needed
+            } else {
+                // [[id]]s inside the set's argument buffer
+                mslBinding.msl_buffer = GetMetalArgumentId(binding);
+                mslBinding.msl_texture = GetMetalArgumentId(binding);
+                mslBinding.msl_sampler = GetMetalSamplerArgumentId(binding);
+                if (std::find(argumentSets.begin(), argumentSets.end(), set) == argumentSets.end()) {
+                    argumentSets.push_back(set);
+                }
+            }
+            mslBinding.desc_set = set;
 
             mslCompiler.add_msl_resource_binding(mslBinding);
         }
     };
 
-    // Get shader resources and add explicit binding overrides
-    spirv_cross::ShaderResources resources = mslCompiler.get_shader_resources();
-    addResourceBindings(resources.uniform_buffers, spirv_cross::SPIRType::Struct, true);   // Buffers need offset
-    addResourceBindings(resources.storage_buffers, spirv_cross::SPIRType::Struct, true);   // Buffers need offset
-    addResourceBindings(resources.sampled_images, spirv_cross::SPIRType::SampledImage, false);  // Textures, no offset
-    addResourceBindings(resources.separate_images, spirv_cross::SPIRType::Image, false);        // Textures, no offset
-    addResourceBindings(resources.separate_samplers, spirv_cross::SPIRType::Sampler, false);    // Samplers, no offset
-    addResourceBindings(resources.storage_images, spirv_cross::SPIRType::Image, false);         // Textures, no offset
-
-    // Handle push constants - map to buffer 30 (Metal max is 30, not 31)
+    // Add explicit binding overrides. Acceleration structures take buffer indices and are
+    // bound directly (setFragmentAccelerationStructure), like uniform buffers.
+    addResourceBindings(resources.uniform_buffers, true, true);
+    addResourceBindings(resources.acceleration_structures, true, true);
+    addResourceBindings(resources.storage_buffers, true, false);
+    addResourceBindings(resources.sampled_images, false, false);
+    addResourceBindings(resources.separate_images, false, false);
+    addResourceBindings(resources.separate_samplers, false, false);
+    addResourceBindings(resources.storage_images, false, false);
+
+    // Each set's argument buffer takes a buffer index down from METAL_ARGUMENT_BUFFER_INDEX
+    for (uint32_t set : argumentSets) {
+        spirv_cross::MSLResourceBinding argumentBinding;
+        argumentBinding.stage = executionModel;
+        argumentBinding.desc_set = set;
+        argumentBinding.binding = spirv_cross::kArgumentBufferBinding;
+        argumentBinding.msl_buffer = METAL_ARGUMENT_BUFFER_INDEX - set;
+        mslCompiler.add_msl_resource_binding(argumentBinding);
+    }
+
+    // Handle push constants - map to the last buffer index (Metal max is 30, not 31)
     if (!resources.push_constant_buffers.empty()) {
         spirv_cross::MSLResourceBinding pushConstBinding;
-        pushConstBinding.stage = (desc.stage == ShaderStage::Vertex) ? spv::ExecutionModelVertex :
-                                 (desc.stage == ShaderStage::Fragment) ? spv::ExecutionModelFragment :
-                                 spv::ExecutionModelGLCompute;
+        pushConstBinding.stage = executionModel;
         pushConstBinding.desc_set = spirv_cross::kPushConstDescSet;
         pushConstBinding.binding = spirv_cross::kPushConstBinding;
-        pushConstBinding.msl_buffer = 30;  // Use buffer 30 for push constants (Metal max is 30)
+        pushConstBinding.msl_buffer = METAL_PUSH_CONSTANT_BUFFER_INDEX;
         mslCompiler.add_msl_resource_binding(pushConstBinding);
     }
 
-    std::string mslSource;
+    // Metal takes the threadgroup size at dispatch time; keep the shader's local_size
+    if (desc.stage == ShaderStage::Compute) {
+        for (uint32_t i = 0; i < 3; ++i) {
+            outThreadGroupSize[i] = std::max(mslCompiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i), 1u);
+        }
+    }
+
+    std::string& mslSource = outSource;  // Name kept for the debug dump below
     try {
         mslSource = mslCompiler.compile();
     } catch (const spirv_cross::CompilerError& e) {
         MTL_LOG_ERROR("SPIRV-Cross compilation failed: " << e.what());
-        return;
+        return false;
     }
 
     METAGFX_DEBUG << "MSL shader compiled, source length: " << mslSource.size();
@@ -93,7 +153,8 @@ MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
     static int shaderCount = 0;
     shaderCount++;
     const char* stageName = (desc.stage == ShaderStage::Vertex) ? "VERTEX" :
-                            (desc.stage == ShaderStage::Fragment) ? "FRAGMENT" : "OTHER";
+                            (desc.stage == ShaderStage::Fragment) ? "FRAGMENT" :
+                            (desc.stage == ShaderStage::Compute) ? "COMPUTE" : "OTHER";
 
     // Log ALL shaders for now to debug the issue
     METAGFX_INFO << "=== MSL Shader " << shaderCount << " (" << stageName << ") ===";
@@ -112,23 +173,62 @@ MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
         }
     }
     METAGFX_INFO << "=== END MSL Shader " << shaderCount << " ===";
+    return true;
+}
 
-    // Create Metal library from MSL source
-    NS::Error* error = nullptr;
-    NS::String* source = NS::String::string(mslSource.c_str(), NS::UTF8StringEncoding);
+// The [[id]]s of the descriptor set 0 argument buffer SPIRV-Cross declared, read back
+// from the MSL so cached translations have them too. SPIRV-Cross drops resources the
+// function never reads, so the set may have bindings its argument buffer lacks.
+static std::vector<uint32> FindArgumentIds(const std::string& mslSource) {
+    std::vector<uint32> ids;
+    size_t structPos = mslSource.find("struct spvDescriptorSetBuffer0");
+    if (structPos == std::string::npos) {
+        return ids;
+    }
+    size_t structEnd = mslSource.find("};", structPos);
+    const std::string idTag = "[[id(";
+    for (size_t pos = mslSource.find(idTag, structPos); pos < structEnd; pos = mslSource.find(idTag, pos)) {
+        pos += idTag.size();
+        ids.push_back(static_cast<uint32>(std::strtoul(mslSource.c_str() + pos, nullptr, 10)));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
 
-    MTL::CompileOptions* compileOptions = MTL::CompileOptions::alloc()->init();
-    m_Library = m_Context.device->newLibrary(source, compileOptions, &error);
-    compileOptions->release();
-    source->release();
+MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
+    : m_Context(context)
+    , m_Stage(desc.stage) {
 
-    if (error || !m_Library) {
-        if (error) {
-            MTL_LOG_ERROR("Failed to create Metal library: " << error->localizedDescription()->utf8String());
-            error->release();
-        } else {
-            MTL_LOG_ERROR("Failed to create Metal library");
+    // Translated MSL and precompiled libraries are cached by SPIR-V hash across launches
+    MetalPipelineCache* cache = m_Context.pipelineCache;
+    uint64 spirvHash = MetalPipelineCache::HashSpirv(desc.code.data(), desc.code.size());
+
+    // Render functions take argument buffers where the device has Tier 2 (MetalDescriptorSet
+    // encodes them); compute ones keep their resources bound directly
+    bool argumentBuffers = m_Context.supportsArgumentBuffers && desc.stage != ShaderStage::Compute;
+    if (argumentBuffers) {
+        spirvHash ^= 0x9e3779b97f4a7c15ull;  // Translates differently, caches apart
+    }
+
+    std::string mslSource;
+    if (!cache || !cache->LoadMSL(spirvHash, desc.stage, mslSource, m_ThreadGroupSize)) {
+        if (!TranslateToMSL(desc, argumentBuffers, mslSource, m_ThreadGroupSize)) {
+            return;
+        }
+        if (cache) {
+            cache->StoreMSL(spirvHash, desc.stage, mslSource, m_ThreadGroupSize);
         }
+    }
+
+    if (argumentBuffers) {
+        m_ArgumentIds = FindArgumentIds(mslSource);
+    }
+
+    m_Library = cache ? cache->LoadLibrary(spirvHash) : nullptr;
+    if (!m_Library) {
+        CompileLibrary(mslSource);
+    }
+    if (!m_Library) {
         return;
     }
 
@@ -138,6 +238,7 @@ MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
     if (entryPoint == "main") {
         entryPoint = "main0";  // SPIRV-Cross convention
     }
+    m_FunctionName = entryPoint;
     NS::String* functionName = NS::String::string(entryPoint.c_str(), NS::UTF8StringEncoding);
     m_Function = m_Library->newFunction(functionName);
     functionName->release();
@@ -147,6 +248,55 @@ MetalShader::MetalShader(MetalContext& context, const ShaderDesc& desc)
     }
 }
 
+MTL::Function* MetalShader::CreateSpecializedFunction(const std::vector<SpecializationConstant>& constants) const {
+    if (!m_Function) {
+        return nullptr;
+    }
+    // SPIRV-Cross emits each constant_id as [[function_constant(id)]] with the SPIR-V
+    // default as fallback, so only functions declaring some need a specialized copy
+    NS::Dictionary* declared = m_Function->functionConstantsDictionary();
+    if (constants.empty() || !declared || declared->count() == 0) {
+        return m_Function->retain();
+    }
+
+    MTL::FunctionConstantValues* values = MTL::FunctionConstantValues::alloc()->init();
+    for (const SpecializationConstant& constant : constants) {
+        values->setConstantValue(&constant.value, MTL::DataTypeUInt, constant.id);
+    }
+
+    NS::Error* error = nullptr;
+    NS::String* functionName = NS::String::string(m_FunctionName.c_str(), NS::UTF8StringEncoding);
+    MTL::Function* function = m_Library->newFunction(functionName, values, &error);
+    values->release();
+
+    if (!function) {
+        MTL_LOG_ERROR("Failed to specialize function '" << m_FunctionName << "': "
+                      << (error ? error->localizedDescription()->utf8String() : "unknown error"));
+        return m_Function->retain();
+    }
+    return function;
+}
+
+void MetalShader::CompileLibrary(const std::string& mslSource) {
+    // Create Metal library from MSL source
+    NS::Error* error = nullptr;
+    NS::String* source = NS::String::string(mslSource.c_str(), NS::UTF8StringEncoding);
+
+    MTL::CompileOptions* compileOptions = MTL::CompileOptions::alloc()->init();
+    m_Library = m_Context.device->newLibrary(source, compileOptions, &error);
+    compileOptions->release();
+    source->release();
+
+    if (error || !m_Library) {
+        if (error) {
+            MTL_LOG_ERROR("Failed to create Metal library: " << error->localizedDescription()->utf8String());
+            error->release();
+        } else {
+            MTL_LOG_ERROR("Failed to create Metal library");
+        }
+    }
+}
+
 MetalShader::~MetalShader() {
     if (m_Function) {
         m_Function->release();
@@ -11,12 +11,15 @@
 namespace metagfx {
 namespace rhi {
 
-MetalSwapChain::MetalSwapChain(MetalContext& context, SDL_Window* window)
+MetalSwapChain::MetalSwapChain(MetalContext& context, SDL_Window* window, uint32 framesInFlight,
+                               PresentMode presentMode, bool offscreen)
     : m_Context(context)
-    , m_Window(window) {
+    , m_Window(window)
+    , m_Offscreen(offscreen)
+    , m_FramesInFlight(framesInFlight) {
 
     // Create semaphore for limiting frames in flight
-    m_FrameSemaphore = dispatch_semaphore_create(MAX_FRAMES_IN_FLIGHT);
+    m_FrameSemaphore = dispatch_semaphore_create(m_FramesInFlight);
 
     // Get initial window size
     int w, h;
@@ -26,26 +29,33 @@ MetalSwapChain::MetalSwapChain(MetalContext& context, SDL_Window* window)
 
     // Configure the Metal layer
     UpdateDrawableSize();
+    SetPresentMode(presentMode);
 
     // Set format based on layer pixel format (via bridge function)
     m_Format = FromMetalPixelFormat(GetMetalLayerPixelFormat(m_Context.metalLayer));
 
-    METAGFX_INFO << "Metal swap chain created: " << m_Width << "x" << m_Height;
+    if (m_Offscreen) {
+        CreateOffscreenTextures();
+    }
+
+    METAGFX_INFO << "Metal " << (m_Offscreen ? "offscreen " : "") << "swap chain created: "
+                 << m_Width << "x" << m_Height;
 }
 
 MetalSwapChain::~MetalSwapChain() {
     // Wait for all frames to complete
-    for (uint32 i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (uint32 i = 0; i < m_FramesInFlight; ++i) {
         dispatch_semaphore_wait(m_FrameSemaphore, DISPATCH_TIME_FOREVER);
     }
 
     // Release the semaphore signals we just acquired
-    for (uint32 i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+    for (uint32 i = 0; i < m_FramesInFlight; ++i) {
         dispatch_semaphore_signal(m_FrameSemaphore);
     }
 
     m_CurrentDrawable = nullptr;
     m_CurrentTexture.reset();
+    m_OffscreenTextures.clear();
 
     METAGFX_INFO << "Metal swap chain destroyed";
 }
@@ -73,10 +83,24 @@ void MetalSwapChain::Resize(uint32 width, uint32 height) {
     m_CurrentDrawable = nullptr;
     m_CurrentTexture.reset();
 
+    // Command buffers retain the textures they use, so the old ones can go at once
+    if (m_Offscreen) {
+        CreateOffscreenTextures();
+    }
+
     METAGFX_DEBUG << "Metal swap chain resized: " << m_Width << "x" << m_Height;
 }
 
 Ref<Texture> MetalSwapChain::GetCurrentBackBuffer() {
+    if (m_Offscreen) {
+        // Claiming the slot's texture waits on the frame semaphore like a drawable acquire
+        if (!m_CurrentTexture) {
+            dispatch_semaphore_wait(m_FrameSemaphore, DISPATCH_TIME_FOREVER);
+            m_CurrentTexture = m_OffscreenTextures[m_CurrentFrame];
+        }
+        return m_CurrentTexture;
+    }
+
     // Acquire drawable if we don't have one
     if (!m_CurrentDrawable) {
         AcquireNextDrawable();
@@ -112,13 +136,34 @@ void MetalSwapChain::AcquireNextDrawable() {
     }
 }
 
+void MetalSwapChain::CreateOffscreenTextures() {
+    TextureDesc desc{};
+    desc.width = m_Width;
+    desc.height = m_Height;
+    desc.format = m_Format;
+    // Copied out by captures and sampled by the stream encoder
+    desc.usage = TextureUsage::ColorAttachment | TextureUsage::TransferSrc | TextureUsage::Sampled;
+    desc.debugName = "Offscreen back buffer";
+    m_OffscreenTextures.clear();
+    for (uint32 i = 0; i < m_FramesInFlight; ++i) {
+        m_OffscreenTextures.push_back(CreateRef<MetalTexture>(m_Context, desc));
+    }
+}
+
 void MetalSwapChain::UpdateDrawableSize() {
     // Update the drawable size on the Metal layer (via bridge function)
     SetMetalLayerDrawableSize(m_Context.metalLayer, m_Width, m_Height);
 }
 
+void MetalSwapChain::SetPresentMode(PresentMode mode) {
+    // Without display sync a drawable is shown as soon as it is presented (and may tear).
+    // Mailbox and FIFO relaxed have no separate Metal equivalent and keep display sync.
+    m_PresentMode = mode == PresentMode::Immediate ? PresentMode::Immediate : PresentMode::Fifo;
+    SetMetalLayerDisplaySyncEnabled(m_Context.metalLayer, m_PresentMode != PresentMode::Immediate);
+}
+
 void MetalSwapChain::AdvanceFrame() {
-    m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_FramesInFlight;
 }
 
 } // namespace rhi
@@ -0,0 +1,92 @@
+// ============================================================================
+// src/rhi/metal/MetalTemporalUpscaler.cpp
+// ============================================================================
+#include "metagfx/rhi/metal/MetalTemporalUpscaler.h"
+#include "metagfx/rhi/metal/MetalTexture.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+MetalTemporalUpscaler::MetalTemporalUpscaler(MetalContext& context, const TemporalUpscalerDesc& desc)
+    : TemporalUpscaler(desc) {
+    MTLFX::TemporalScalerDescriptor* descriptor = MTLFX::TemporalScalerDescriptor::alloc()->init();
+    descriptor->setColorTextureFormat(ToMetalPixelFormat(desc.colorFormat));
+    descriptor->setDepthTextureFormat(ToMetalPixelFormat(desc.depthFormat));
+    descriptor->setMotionTextureFormat(ToMetalPixelFormat(desc.motionFormat));
+    descriptor->setOutputTextureFormat(ToMetalPixelFormat(desc.outputFormat));
+    descriptor->setInputWidth(desc.inputWidth);
+    descriptor->setInputHeight(desc.inputHeight);
+    descriptor->setOutputWidth(desc.outputWidth);
+    descriptor->setOutputHeight(desc.outputHeight);
+    descriptor->setAutoExposureEnabled(true);
+
+    // Scales are of the output over the content: the whole input at least, and as little
+    // of it as the scaler takes at most
+    float minScale = std::min(static_cast<float>(desc.outputWidth) / std::max(desc.inputWidth, 1u),
+                              static_cast<float>(desc.outputHeight) / std::max(desc.inputHeight, 1u));
+    float maxScale = MTLFX::TemporalScalerDescriptor::supportedInputContentMaxScale(context.device);
+    descriptor->setInputContentPropertiesEnabled(true);
+    descriptor->setInputContentMinScale(std::max(minScale, 1.0f));
+    descriptor->setInputContentMaxScale(std::max(maxScale, minScale));
+
+    m_Scaler = descriptor->newTemporalScaler(context.device);
+    descriptor->release();
+    if (!m_Scaler) {
+        MTL_LOG_ERROR("Failed to create the temporal scaler " << (desc.debugName ? desc.debugName : "")
+                      << " from " << desc.inputWidth << "x" << desc.inputHeight << " to "
+                      << desc.outputWidth << "x" << desc.outputHeight);
+    }
+}
+
+MetalTemporalUpscaler::~MetalTemporalUpscaler() {
+    if (m_Scaler) {
+        m_Scaler->release();
+    }
+}
+
+bool MetalTemporalUpscaler::Encode(MTL::CommandBuffer* commandBuffer, const TemporalUpscaleFrame& frame) {
+    if (!m_Scaler || !frame.color || !frame.depth || !frame.motion || !frame.output) {
+        return false;
+    }
+
+    MTL::Texture* color = static_cast<MetalTexture*>(frame.color)->GetHandle();
+    MTL::Texture* depth = static_cast<MetalTexture*>(frame.depth)->GetHandle();
+    MTL::Texture* motion = static_cast<MetalTexture*>(frame.motion)->GetHandle();
+    MTL::Texture* output = static_cast<MetalTexture*>(frame.output)->GetHandle();
+    auto hasUsage = [](MTL::Texture* texture, MTL::TextureUsage usage) {
+        return (texture->usage() & usage) == usage;
+    };
+    if (!hasUsage(color, m_Scaler->colorTextureUsage()) || !hasUsage(depth, m_Scaler->depthTextureUsage()) ||
+        !hasUsage(motion, m_Scaler->motionTextureUsage()) || !hasUsage(output, m_Scaler->outputTextureUsage())) {
+        if (!m_UsageReported) {
+            MTL_LOG_ERROR("Textures without the usages the temporal scaler needs");
+            m_UsageReported = true;
+        }
+        return false;
+    }
+
+    m_Scaler->setColorTexture(color);
+    m_Scaler->setDepthTexture(depth);
+    m_Scaler->setMotionTexture(motion);
+    m_Scaler->setOutputTexture(output);
+    m_Scaler->setInputContentWidth(frame.contentWidth > 0 ? std::min(frame.contentWidth, m_Desc.inputWidth)
+                                                          : m_Desc.inputWidth);
+    m_Scaler->setInputContentHeight(frame.contentHeight > 0 ? std::min(frame.contentHeight, m_Desc.inputHeight)
+                                                            : m_Desc.inputHeight);
+    // MetalFX takes where each pixel's sample lies from its center, the projection's
+    // offset reversed
+    m_Scaler->setJitterOffsetX(-frame.jitterX);
+    m_Scaler->setJitterOffsetY(-frame.jitterY);
+    m_Scaler->setMotionVectorScaleX(frame.motionScaleX);
+    m_Scaler->setMotionVectorScaleY(frame.motionScaleY);
+    m_Scaler->setDepthReversed(frame.depthReversed);
+    m_Scaler->setReset(frame.reset);
+    m_Scaler->encodeToCommandBuffer(commandBuffer);
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
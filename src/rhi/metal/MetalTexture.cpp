@@ -3,6 +3,14 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/metal/MetalTexture.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/rhi/metal/MetalHeapAllocator.h"
+#include "metagfx/rhi/metal/MetalIOQueue.h"
+#include "metagfx/rhi/metal/MetalUploadManager.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/MipGenerator.h"
+
+#include <cstring>
 
 namespace metagfx {
 namespace rhi {
@@ -26,16 +34,31 @@ MetalTexture::MetalTexture(MetalContext& context, const TextureDesc& desc)
     , m_Height(desc.height)
     , m_MipLevels(desc.mipLevels)
     , m_ArrayLayers(desc.arrayLayers)
+    , m_SampleCount(desc.sampleCount)
     , m_Format(desc.format)
     , m_Type(desc.type)
+    , m_MemoryCategory(GetTextureMemoryCategory(desc))
+    , m_GenerateMipmaps(desc.generateMipmaps && desc.mipLevels > 1)
+    , m_Transient((static_cast<int>(desc.usage) & static_cast<int>(TextureUsage::Transient)) != 0)
     , m_OwnsTexture(true) {
 
+    // Neither the blit encoder nor the CPU filter can generate compressed mips
+    if (m_GenerateMipmaps && IsCompressedFormat(desc.format)) {
+        METAGFX_WARN << "Cannot generate mipmaps for a compressed texture; using a single mip level";
+        m_GenerateMipmaps = false;
+        m_MipLevels = 1;
+    }
+
     MTL::TextureDescriptor* textureDesc = MTL::TextureDescriptor::alloc()->init();
 
     // Set texture type
     switch (desc.type) {
         case TextureType::Texture2D:
-            textureDesc->setTextureType(MTL::TextureType2D);
+            if (desc.arrayLayers > 1) {
+                textureDesc->setTextureType(MTL::TextureType2DArray);
+            } else {
+                textureDesc->setTextureType(m_SampleCount > 1 ? MTL::TextureType2DMultisample : MTL::TextureType2D);
+            }
             break;
         case TextureType::Texture3D:
             textureDesc->setTextureType(MTL::TextureType3D);
@@ -51,7 +74,8 @@ MetalTexture::MetalTexture(MetalContext& context, const TextureDesc& desc)
     textureDesc->setPixelFormat(ToMetalPixelFormat(desc.format));
     textureDesc->setWidth(desc.width);
     textureDesc->setHeight(desc.height);
-    textureDesc->setMipmapLevelCount(desc.mipLevels);
+    textureDesc->setMipmapLevelCount(m_MipLevels);
+    textureDesc->setSampleCount(m_SampleCount);
 
     // For cubemaps, arrayLength must be 1 (6 faces are implicit in the cube type)
     // For cube arrays, arrayLength would be the number of cubes
@@ -71,28 +95,36 @@ MetalTexture::MetalTexture(MetalContext& context, const TextureDesc& desc)
     if (static_cast<int>(desc.usage) & static_cast<int>(TextureUsage::Storage)) {
         usage |= MTL::TextureUsageShaderWrite;
     }
+    if (m_Transient) {
+        // Memoryless textures can only be rendered to
+        usage = MTL::TextureUsageRenderTarget;
+    }
     textureDesc->setUsage(usage);
 
     // Set storage mode based on usage
-    if (isRenderTarget || isDepthStencil) {
-        // Render targets should be GPU-only for performance
-        textureDesc->setStorageMode(MTL::StorageModePrivate);
+    if (m_Transient && m_Context.supportsMemoryless) {
+        // Lives in tile memory for the duration of a render pass only
+        textureDesc->setStorageMode(MTL::StorageModeMemoryless);
     } else {
-        // Regular textures that need CPU upload can use shared on iOS or managed on macOS
-#if TARGET_OS_OSX
-        textureDesc->setStorageMode(MTL::StorageModeManaged);
-#else
-        textureDesc->setStorageMode(MTL::StorageModeShared);
-#endif
+        // GPU-only, with the GPU's own layout and compression. Textures uploaded from the
+        // CPU are staged and blitted (MetalUploadManager), so uploads never touch a
+        // texture the GPU may be reading.
+        textureDesc->setStorageMode(MTL::StorageModePrivate);
     }
 
-    m_Texture = m_Context.device->newTexture(textureDesc);
+    m_Texture = m_Context.heapAllocator->NewTexture(textureDesc, GraphicsDevice::GetCurrentResourceGroup(), m_Heap);
+    if (!m_Texture) {
+        m_Texture = m_Context.device->newTexture(textureDesc);
+        m_Context.stats->AddAllocation();
+    }
     textureDesc->release();
 
     if (!m_Texture) {
         MTL_LOG_ERROR("Failed to create texture");
         return;
     }
+    // Memoryless textures allocate nothing
+    m_Context.memory->Add(m_MemoryCategory, m_Texture->allocatedSize());
 
     if (desc.debugName) {
         NS::String* label = NS::String::string(desc.debugName, NS::UTF8StringEncoding);
@@ -102,105 +134,203 @@ MetalTexture::MetalTexture(MetalContext& context, const TextureDesc& desc)
 }
 
 MetalTexture::~MetalTexture() {
+    if (m_FileLoad) {
+        m_FileLoad->release();
+        m_FileLoad = nullptr;
+    }
     if (m_Texture && m_OwnsTexture) {
+        m_Context.memory->Remove(m_MemoryCategory, m_Texture->allocatedSize());
         m_Texture->release();
+        m_Context.heapAllocator->Release(m_Heap);
     }
     m_Texture = nullptr;
 }
 
-// Helper function to get bytes per pixel for a format
-static uint32 GetBytesPerPixel(Format format) {
-    switch (format) {
-        case Format::R8_UNORM:
-        case Format::R8_SNORM:
-        case Format::R8_UINT:
-        case Format::R8_SINT:
-            return 1;
-        case Format::R8G8_UNORM:
-        case Format::R8G8_SNORM:
-        case Format::R8G8_UINT:
-        case Format::R8G8_SINT:
-        case Format::R16_UNORM:
-        case Format::R16_SNORM:
-        case Format::R16_UINT:
-        case Format::R16_SINT:
-        case Format::R16_SFLOAT:
-            return 2;
-        case Format::R8G8B8A8_UNORM:
-        case Format::R8G8B8A8_SNORM:
-        case Format::R8G8B8A8_UINT:
-        case Format::R8G8B8A8_SINT:
-        case Format::R8G8B8A8_SRGB:
-        case Format::B8G8R8A8_UNORM:
-        case Format::B8G8R8A8_SRGB:
-        case Format::R32_UINT:
-        case Format::R32_SINT:
-        case Format::R32_SFLOAT:
-        case Format::R16G16_UNORM:
-        case Format::R16G16_SNORM:
-        case Format::R16G16_UINT:
-        case Format::R16G16_SINT:
-        case Format::R16G16_SFLOAT:
-            return 4;
-        case Format::R16G16B16A16_UNORM:
-        case Format::R16G16B16A16_SNORM:
-        case Format::R16G16B16A16_UINT:
-        case Format::R16G16B16A16_SINT:
-        case Format::R16G16B16A16_SFLOAT:
-        case Format::R32G32_UINT:
-        case Format::R32G32_SINT:
-        case Format::R32G32_SFLOAT:
-            return 8;
-        case Format::R32G32B32_UINT:
-        case Format::R32G32B32_SINT:
-        case Format::R32G32B32_SFLOAT:
-            return 12;
-        case Format::R32G32B32A32_UINT:
-        case Format::R32G32B32A32_SINT:
-        case Format::R32G32B32A32_SFLOAT:
-            return 16;
-        default:
-            return 4;
-    }
-}
-
 void MetalTexture::UploadData(const void* data, uint64 size) {
     if (!m_Texture || !data) {
         return;
     }
 
-    uint32 bytesPerPixel = GetBytesPerPixel(m_Format);
+    // Determine number of array layers (6 for cubemaps, otherwise m_ArrayLayers)
+    uint32 numLayers = (m_Type == TextureType::TextureCube) ? 6 : m_ArrayLayers;
+
     const uint8* srcData = static_cast<const uint8*>(data);
+    bool blitMipmaps = false;
+    std::vector<uint8> mipChain;
+    if (m_GenerateMipmaps) {
+        if (CanBlitMipmaps()) {
+            blitMipmaps = true;
+        } else if (GenerateMipChainCPU(data, m_Width, m_Height, numLayers, m_MipLevels, m_Format, mipChain)) {
+            srcData = mipChain.data();
+            size = mipChain.size();
+        } else {
+            return;
+        }
+    }
+    uint32 uploadedMips = blitMipmaps ? 1 : m_MipLevels;
+
+    // The data is mip-major and tightly packed: each level's layers lie together
+    std::vector<TextureLevelData> levels(uploadedMips);
     uint64 offset = 0;
+    for (uint32 mip = 0; mip < uploadedMips; ++mip) {
+        uint64 faceSize = GetFormatImageSize(m_Format, std::max(1u, m_Width >> mip), std::max(1u, m_Height >> mip));
+        levels[mip].data = srcData + offset;
+        levels[mip].size = faceSize * numLayers;
+        offset += levels[mip].size;
+        if (offset > size) {
+            MTL_LOG_ERROR("Not enough data for texture upload at mip " << mip);
+            return;
+        }
+    }
+    StageLevels(levels.data(), uploadedMips, blitMipmaps);
+
+    METAGFX_DEBUG << "Texture data uploaded: " << m_Width << "x" << m_Height
+                  << ", mips=" << m_MipLevels << ", layers=" << numLayers
+                  << ", total=" << offset << " bytes";
+}
+
+void MetalTexture::UploadLevels(const TextureLevelData* levels, uint32 levelCount) {
+    // Mip 0 alone, or mips generated from it, take UploadData()'s path
+    if (levelCount <= 1 || m_GenerateMipmaps || levelCount != m_MipLevels) {
+        Texture::UploadLevels(levels, levelCount);
+        return;
+    }
+    if (!m_Texture) {
+        return;
+    }
 
-    // Determine number of array layers (6 for cubemaps, otherwise m_ArrayLayers)
     uint32 numLayers = (m_Type == TextureType::TextureCube) ? 6 : m_ArrayLayers;
+    for (uint32 mip = 0; mip < levelCount; ++mip) {
+        uint64 faceSize = GetFormatImageSize(m_Format, std::max(1u, m_Width >> mip), std::max(1u, m_Height >> mip));
+        if (levels[mip].size < faceSize * numLayers) {
+            MTL_LOG_ERROR("Not enough data for texture upload at mip " << mip);
+            return;
+        }
+    }
+    StageLevels(levels, levelCount, false);
+}
 
-    // Upload each mip level and array layer/face
-    for (uint32 mip = 0; mip < m_MipLevels; ++mip) {
-        uint32 mipWidth = std::max(1u, m_Width >> mip);
-        uint32 mipHeight = std::max(1u, m_Height >> mip);
-        uint32 bytesPerRow = mipWidth * bytesPerPixel;
-        uint64 faceSize = static_cast<uint64>(mipWidth) * mipHeight * bytesPerPixel;
+void MetalTexture::StageLevels(const TextureLevelData* levels, uint32 levelCount, bool blitMipmaps) {
+    uint32 numLayers = (m_Type == TextureType::TextureCube) ? 6 : m_ArrayLayers;
 
-        MTL::Region region = MTL::Region::Make2D(0, 0, mipWidth, mipHeight);
+    // Each level is copied straight into the staging buffer, where the blits take it from
+    struct LevelCopy {
+        uint64 offset = 0;
+        uint64 faceSize = 0;
+        uint32 bytesPerRow = 0;
+        uint32 width = 1;
+        uint32 height = 1;
+    };
+    std::vector<LevelCopy> copies(levelCount);
+    uint64 stagingSize = 0;
+    for (uint32 mip = 0; mip < levelCount; ++mip) {
+        LevelCopy& copy = copies[mip];
+        copy.width = std::max(1u, m_Width >> mip);
+        copy.height = std::max(1u, m_Height >> mip);
+        // Compressed formats: one "row" is a row of blocks
+        copy.bytesPerRow = GetFormatRowPitch(m_Format, copy.width);
+        copy.faceSize = GetFormatImageSize(m_Format, copy.width, copy.height);
+        copy.offset = stagingSize;
+        stagingSize += copy.faceSize * numLayers;
+    }
 
-        for (uint32 layer = 0; layer < numLayers; ++layer) {
-            if (offset + faceSize > size) {
-                MTL_LOG_ERROR("Not enough data for texture upload at mip " << mip << " layer " << layer);
-                return;
+    MTL::Buffer* staging = m_Context.uploadManager->NewStagingBuffer(stagingSize);
+    if (!staging) {
+        return;
+    }
+    uint8* stagingData = static_cast<uint8*>(staging->contents());
+    for (uint32 mip = 0; mip < levelCount; ++mip) {
+        memcpy(stagingData + copies[mip].offset, levels[mip].data, copies[mip].faceSize * numLayers);
+    }
+    m_Context.stats->AddTextureUpload(stagingSize);
+
+    // Later command buffers on the queue see the whole chain; nothing waits here
+    m_UploadTicket = m_Context.uploadManager->Submit(staging, [&](MTL::CommandBuffer* cmdBuffer) {
+        MTL::BlitCommandEncoder* blit = cmdBuffer->blitCommandEncoder();
+        for (uint32 mip = 0; mip < levelCount; ++mip) {
+            const LevelCopy& copy = copies[mip];
+            // For cubemaps, 'slice' is the face index (0-5); for regular textures the array layer
+            for (uint32 layer = 0; layer < numLayers; ++layer) {
+                blit->copyFromBuffer(staging, copy.offset + layer * copy.faceSize, copy.bytesPerRow, copy.faceSize,
+                                     MTL::Size::Make(copy.width, copy.height, 1), m_Texture, layer, mip,
+                                     MTL::Origin::Make(0, 0, 0));
             }
+        }
+        if (blitMipmaps) {
+            blit->generateMipmaps(m_Texture);
+        }
+        blit->endEncoding();
+    });
+}
+
+bool MetalTexture::CanBlitMipmaps() const {
+    // The blit encoder needs a filterable, color-renderable format. 32-bit float formats
+    // are not filterable on every GPU, so they take the CPU path.
+    return m_Format != Format::R32_SFLOAT && m_Format != Format::R32G32_SFLOAT &&
+           m_Format != Format::R32G32B32_SFLOAT && m_Format != Format::R32G32B32A32_SFLOAT;
+}
+
+bool MetalTexture::LoadFromFile(const TextureFileSource& source) {
+    if (!m_Texture || !m_Context.ioQueue->IsSupported() || (m_GenerateMipmaps && !CanBlitMipmaps())) {
+        return false;
+    }
+    uint32 loadedMips = m_GenerateMipmaps ? 1 : m_MipLevels;
+    if (source.levelOffsets.size() < loadedMips) {
+        MTL_LOG_ERROR("Texture file source lists " << source.levelOffsets.size() << " of " << loadedMips
+                      << " mip levels");
+        return false;
+    }
+
+    MTL::IOFileHandle* file = m_Context.ioQueue->OpenFile(source.path);
+    if (!file) {
+        return false;
+    }
 
-            // For cubemaps, 'slice' is the face index (0-5)
-            // For regular textures, 'slice' is the array layer
-            m_Texture->replaceRegion(region, mip, layer, srcData + offset, bytesPerRow, 0);
-            offset += faceSize;
+    uint32 numLayers = (m_Type == TextureType::TextureCube) ? 6 : m_ArrayLayers;
+    uint64 size = 0;
+    MTL::IOCommandBuffer* commands = m_Context.ioQueue->NewCommandBuffer();
+    for (uint32 mip = 0; mip < loadedMips; ++mip) {
+        uint32 mipWidth = std::max(1u, m_Width >> mip);
+        uint32 mipHeight = std::max(1u, m_Height >> mip);
+        uint32 bytesPerRow = GetFormatRowPitch(m_Format, mipWidth);
+        uint64 faceSize = GetFormatImageSize(m_Format, mipWidth, mipHeight);
+
+        for (uint32 layer = 0; layer < numLayers; ++layer) {
+            commands->loadTexture(m_Texture, layer, mip, MTL::Size::Make(mipWidth, mipHeight, 1), bytesPerRow,
+                                  faceSize, MTL::Origin::Make(0, 0, 0), file,
+                                  source.levelOffsets[mip] + layer * faceSize);
         }
+        size += faceSize * numLayers;
     }
+    m_Context.stats->AddTextureUpload(size);
 
-    METAGFX_DEBUG << "Texture data uploaded: " << m_Width << "x" << m_Height
-                  << ", mips=" << m_MipLevels << ", layers=" << numLayers
-                  << ", total=" << offset << " bytes";
+    // Kept to poll; a texture reloaded before the last load landed just replaces it
+    if (m_FileLoad) {
+        m_FileLoad->release();
+    }
+    m_FileLoad = commands->retain();
+
+    bool blitMipmaps = m_GenerateMipmaps;
+    m_UploadTicket = m_Context.ioQueue->Submit(commands, [&](MTL::CommandBuffer* cmdBuffer) {
+        if (blitMipmaps) {
+            MTL::BlitCommandEncoder* blit = cmdBuffer->blitCommandEncoder();
+            blit->generateMipmaps(m_Texture);
+            blit->endEncoding();
+        }
+    });
+    file->release();
+
+    METAGFX_DEBUG << "Texture data loading from " << source.path << ": " << m_Width << "x" << m_Height
+                  << ", mips=" << m_MipLevels << ", layers=" << numLayers << ", total=" << size << " bytes";
+    return true;
+}
+
+bool MetalTexture::IsUploadComplete() const {
+    // A failed load (logged by MetalIOQueue) leaves whatever it got to in the texture
+    if (m_FileLoad && m_FileLoad->status() == MTL::IOStatusPending) {
+        return false;
+    }
+    return m_Context.uploadManager->IsComplete(m_UploadTicket);
 }
 
 } // namespace rhi
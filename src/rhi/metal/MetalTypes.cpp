@@ -7,8 +7,10 @@
 #define NS_PRIVATE_IMPLEMENTATION
 #define MTL_PRIVATE_IMPLEMENTATION
 #define CA_PRIVATE_IMPLEMENTATION
+#define MTLFX_PRIVATE_IMPLEMENTATION
 
 #include "metagfx/rhi/metal/MetalTypes.h"
+#include <MetalFX/MetalFX.hpp>
 
 namespace metagfx {
 namespace rhi {
@@ -88,6 +90,31 @@ MTL::PixelFormat ToMetalPixelFormat(Format format) {
 #endif
         case Format::D32_SFLOAT_S8_UINT: return MTL::PixelFormatDepth32Float_Stencil8;
 
+        // BC (Macs)
+        case Format::BC1_RGBA_UNORM: return MTL::PixelFormatBC1_RGBA;
+        case Format::BC1_RGBA_SRGB: return MTL::PixelFormatBC1_RGBA_sRGB;
+        case Format::BC3_RGBA_UNORM: return MTL::PixelFormatBC3_RGBA;
+        case Format::BC3_RGBA_SRGB: return MTL::PixelFormatBC3_RGBA_sRGB;
+        case Format::BC4_R_UNORM: return MTL::PixelFormatBC4_RUnorm;
+        case Format::BC5_RG_UNORM: return MTL::PixelFormatBC5_RGUnorm;
+        case Format::BC6H_RGB_UFLOAT: return MTL::PixelFormatBC6H_RGBUfloat;
+        case Format::BC7_RGBA_UNORM: return MTL::PixelFormatBC7_RGBAUnorm;
+        case Format::BC7_RGBA_SRGB: return MTL::PixelFormatBC7_RGBAUnorm_sRGB;
+
+        // ETC2 / EAC (Apple GPUs)
+        case Format::ETC2_RGB8_UNORM: return MTL::PixelFormatETC2_RGB8;
+        case Format::ETC2_RGB8_SRGB: return MTL::PixelFormatETC2_RGB8_sRGB;
+        case Format::ETC2_RGBA8_UNORM: return MTL::PixelFormatEAC_RGBA8;
+        case Format::ETC2_RGBA8_SRGB: return MTL::PixelFormatEAC_RGBA8_sRGB;
+
+        // ASTC LDR (Apple GPUs)
+        case Format::ASTC_4x4_UNORM: return MTL::PixelFormatASTC_4x4_LDR;
+        case Format::ASTC_4x4_SRGB: return MTL::PixelFormatASTC_4x4_sRGB;
+        case Format::ASTC_6x6_UNORM: return MTL::PixelFormatASTC_6x6_LDR;
+        case Format::ASTC_6x6_SRGB: return MTL::PixelFormatASTC_6x6_sRGB;
+        case Format::ASTC_8x8_UNORM: return MTL::PixelFormatASTC_8x8_LDR;
+        case Format::ASTC_8x8_SRGB: return MTL::PixelFormatASTC_8x8_sRGB;
+
         case Format::Undefined:
         default:
             return MTL::PixelFormatInvalid;
@@ -152,6 +179,31 @@ Format FromMetalPixelFormat(MTL::PixelFormat format) {
 #endif
         case MTL::PixelFormatDepth32Float_Stencil8: return Format::D32_SFLOAT_S8_UINT;
 
+        // BC (Macs)
+        case MTL::PixelFormatBC1_RGBA: return Format::BC1_RGBA_UNORM;
+        case MTL::PixelFormatBC1_RGBA_sRGB: return Format::BC1_RGBA_SRGB;
+        case MTL::PixelFormatBC3_RGBA: return Format::BC3_RGBA_UNORM;
+        case MTL::PixelFormatBC3_RGBA_sRGB: return Format::BC3_RGBA_SRGB;
+        case MTL::PixelFormatBC4_RUnorm: return Format::BC4_R_UNORM;
+        case MTL::PixelFormatBC5_RGUnorm: return Format::BC5_RG_UNORM;
+        case MTL::PixelFormatBC6H_RGBUfloat: return Format::BC6H_RGB_UFLOAT;
+        case MTL::PixelFormatBC7_RGBAUnorm: return Format::BC7_RGBA_UNORM;
+        case MTL::PixelFormatBC7_RGBAUnorm_sRGB: return Format::BC7_RGBA_SRGB;
+
+        // ETC2 / EAC (Apple GPUs)
+        case MTL::PixelFormatETC2_RGB8: return Format::ETC2_RGB8_UNORM;
+        case MTL::PixelFormatETC2_RGB8_sRGB: return Format::ETC2_RGB8_SRGB;
+        case MTL::PixelFormatEAC_RGBA8: return Format::ETC2_RGBA8_UNORM;
+        case MTL::PixelFormatEAC_RGBA8_sRGB: return Format::ETC2_RGBA8_SRGB;
+
+        // ASTC LDR (Apple GPUs)
+        case MTL::PixelFormatASTC_4x4_LDR: return Format::ASTC_4x4_UNORM;
+        case MTL::PixelFormatASTC_4x4_sRGB: return Format::ASTC_4x4_SRGB;
+        case MTL::PixelFormatASTC_6x6_LDR: return Format::ASTC_6x6_UNORM;
+        case MTL::PixelFormatASTC_6x6_sRGB: return Format::ASTC_6x6_SRGB;
+        case MTL::PixelFormatASTC_8x8_LDR: return Format::ASTC_8x8_UNORM;
+        case MTL::PixelFormatASTC_8x8_sRGB: return Format::ASTC_8x8_SRGB;
+
         default:
             return Format::Undefined;
     }
@@ -244,6 +296,9 @@ MTL::VertexFormat ToMetalVertexFormat(Format format) {
         case Format::R8G8B8A8_UNORM: return MTL::VertexFormatUChar4Normalized;
         case Format::R8G8B8A8_SNORM: return MTL::VertexFormatChar4Normalized;
 
+        case Format::R16G16_SNORM: return MTL::VertexFormatShort2Normalized;
+        case Format::R16G16B16A16_UNORM: return MTL::VertexFormatUShort4Normalized;
+
         case Format::R16G16_SFLOAT: return MTL::VertexFormatHalf2;
         case Format::R16G16B16A16_SFLOAT: return MTL::VertexFormatHalf4;
 
@@ -0,0 +1,116 @@
+// ============================================================================
+// src/rhi/metal/MetalUploadManager.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/metal/MetalUploadManager.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+MetalUploadManager::MetalUploadManager(MetalContext& context)
+    : m_Context(context) {
+    // Without the event, polls take the completion handlers' ticket instead
+    m_Event = m_Context.device->newSharedEvent();
+    if (!m_Event) {
+        METAGFX_WARN << "Metal upload event unavailable";
+    }
+}
+
+MetalUploadManager::~MetalUploadManager() {
+    WaitIdle();
+    if (m_Event) {
+        m_Event->release();
+        m_Event = nullptr;
+    }
+}
+
+MTL::Buffer* MetalUploadManager::NewStagingBuffer(uint64 size) {
+    MTL::Buffer* staging = m_Context.device->newBuffer(size, MTL::ResourceStorageModeShared |
+                                                                 MTL::ResourceCPUCacheModeWriteCombined);
+    m_Context.stats->AddAllocation();
+    if (!staging) {
+        MTL_LOG_ERROR("Failed to create a " << size << " byte staging buffer");
+        return nullptr;
+    }
+    m_Context.memory->Add(MemoryCategory::Staging, staging->allocatedSize());
+    return staging;
+}
+
+MetalUploadTicket MetalUploadManager::Submit(MTL::Buffer* staging,
+                                             const std::function<void(MTL::CommandBuffer*)>& encode) {
+    // Worker threads have no autorelease pool of their own to drain the command buffer
+    NS::AutoreleasePool* pool = NS::AutoreleasePool::alloc()->init();
+
+    // Commit order has to match the tickets, or a poll could pass early
+    std::lock_guard<std::mutex> lock(m_SubmitMutex);
+    MetalUploadTicket ticket = ++m_LastTicket;
+    MTL::CommandBuffer* cmdBuffer = m_Context.commandQueue->commandBuffer();
+    if (encode) {
+        encode(cmdBuffer);
+    }
+    if (m_Event) {
+        cmdBuffer->encodeSignalEvent(m_Event, ticket);
+    }
+
+    MemoryCounters* memory = m_Context.memory;
+    cmdBuffer->addCompletedHandler([this, staging, memory, ticket](MTL::CommandBuffer* buffer) {
+        if (buffer->status() == MTL::CommandBufferStatusError) {
+            NS::Error* error = buffer->error();
+            METAGFX_ERROR << "Metal upload command buffer error: "
+                          << (error ? error->localizedDescription()->utf8String() : "unknown error");
+        }
+        if (staging) {
+            memory->Remove(MemoryCategory::Staging, staging->allocatedSize());
+            staging->release();
+        }
+        Complete(ticket);
+    });
+    cmdBuffer->commit();
+    pool->release();
+    return ticket;
+}
+
+void MetalUploadManager::Complete(MetalUploadTicket ticket) {
+    {
+        std::lock_guard<std::mutex> lock(m_CompletedMutex);
+        // Command buffers on one queue complete in order, but their handlers may race
+        m_CompletedTicket = std::max(m_CompletedTicket, ticket);
+    }
+    m_CompletedCondition.notify_all();
+}
+
+bool MetalUploadManager::IsComplete(MetalUploadTicket ticket) const {
+    if (ticket == 0) {
+        return true;
+    }
+    if (m_Event) {
+        return m_Event->signaledValue() >= ticket;
+    }
+    std::lock_guard<std::mutex> lock(m_CompletedMutex);
+    return m_CompletedTicket >= ticket;
+}
+
+void MetalUploadManager::Wait(MetalUploadTicket ticket) {
+    if (IsComplete(ticket)) {
+        return;
+    }
+    METAGFX_PROFILE_SCOPE("Upload wait");
+    m_Context.stats->AddUploadWait();
+    std::unique_lock<std::mutex> lock(m_CompletedMutex);
+    m_CompletedCondition.wait(lock, [this, ticket]() { return m_CompletedTicket >= ticket; });
+}
+
+void MetalUploadManager::WaitIdle() {
+    MetalUploadTicket ticket = 0;
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitMutex);
+        ticket = m_LastTicket;
+    }
+    Wait(ticket);
+}
+
+} // namespace rhi
+} // namespace metagfx
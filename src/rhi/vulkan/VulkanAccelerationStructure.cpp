@@ -0,0 +1,292 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanAccelerationStructure.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanAccelerationStructure.h"
+#include "metagfx/rhi/vulkan/VulkanBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+namespace rhi {
+
+VulkanAccelerationStructureBuffer::VulkanAccelerationStructureBuffer(VulkanContext& context, VkDeviceSize size,
+                                                                     VkBufferUsageFlags usage,
+                                                                     VkMemoryPropertyFlags properties)
+    : m_Context(context) {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = usage | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VK_CHECK(vkCreateBuffer(m_Context.device, &bufferInfo, nullptr, &m_Buffer));
+
+    if (!m_Context.allocator->AllocateBuffer(m_Buffer, properties, m_Allocation)) {
+        METAGFX_ERROR << "Failed to allocate memory for acceleration structure buffer of " << size << " bytes";
+        return;
+    }
+    m_Context.memory->Add(MemoryCategory::AccelerationStructure, m_Allocation.size);
+
+    VkBufferDeviceAddressInfo addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = m_Buffer;
+    m_Address = m_Context.getBufferDeviceAddress(m_Context.device, &addressInfo);
+}
+
+VulkanAccelerationStructureBuffer::~VulkanAccelerationStructureBuffer() {
+    if (m_Buffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_Context.device, m_Buffer, nullptr);
+    }
+    if (m_Allocation.IsValid()) {
+        m_Context.memory->Remove(MemoryCategory::AccelerationStructure, m_Allocation.size);
+    }
+    m_Context.allocator->Free(m_Allocation);
+}
+
+static VkBuildAccelerationStructureFlagsKHR ToVulkanBuildFlags(AccelerationStructureFlags flags) {
+    VkBuildAccelerationStructureFlagsKHR vkFlags = HasFlag(flags, AccelerationStructureFlags::PreferFastBuild)
+        ? VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR
+        : VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+    if (HasFlag(flags, AccelerationStructureFlags::AllowUpdate)) {
+        vkFlags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+    }
+    if (HasFlag(flags, AccelerationStructureFlags::AllowCompaction)) {
+        vkFlags |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_COMPACTION_BIT_KHR;
+    }
+    return vkFlags;
+}
+
+VulkanAccelerationStructure::VulkanAccelerationStructure(VulkanContext& context, const AccelerationStructureDesc& desc,
+                                                         VkDeviceSize storageSize)
+    : AccelerationStructure(desc), m_Context(context) {
+    const bool topLevel = desc.type == AccelerationStructureType::TopLevel;
+    std::vector<uint32> maxPrimitiveCounts;
+
+    if (topLevel) {
+        if (desc.maxInstances == 0) {
+            METAGFX_ERROR << "Top-level acceleration structure without instances";
+            return;
+        }
+        VkDeviceSize regionSize = VkDeviceSize(desc.maxInstances) * sizeof(VkAccelerationStructureInstanceKHR);
+        m_Instances = CreateScope<VulkanAccelerationStructureBuffer>(
+            m_Context, regionSize * m_Context.framesInFlight,
+            VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        if (!m_Instances->IsValid()) {
+            return;
+        }
+
+        VkAccelerationStructureGeometryKHR geometry{};
+        geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+        geometry.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+        geometry.geometry.instances.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+        geometry.geometry.instances.arrayOfPointers = VK_FALSE;
+        geometry.geometry.instances.data.deviceAddress = m_Instances->GetAddress();
+        m_Geometries.push_back(geometry);
+        m_Ranges.push_back({});
+        maxPrimitiveCounts.push_back(desc.maxInstances);
+    } else {
+        for (const AccelerationStructureGeometry& input : desc.geometries) {
+            auto vertexBuffer = std::static_pointer_cast<VulkanBuffer>(input.vertexBuffer);
+            auto indexBuffer = std::static_pointer_cast<VulkanBuffer>(input.indexBuffer);
+            VkFormat vertexFormat = ToVulkanFormat(input.vertexFormat);
+
+            VkFormatProperties formatProperties{};
+            vkGetPhysicalDeviceFormatProperties(m_Context.physicalDevice, vertexFormat, &formatProperties);
+            if (!(formatProperties.bufferFeatures & VK_FORMAT_FEATURE_ACCELERATION_STRUCTURE_VERTEX_BUFFER_BIT_KHR)) {
+                METAGFX_WARN << "Acceleration structure vertex format " << static_cast<int>(input.vertexFormat)
+                             << " is not supported by the device";
+                return;
+            }
+            if (!vertexBuffer || !indexBuffer || vertexBuffer->GetDeviceAddress() == 0 ||
+                indexBuffer->GetDeviceAddress() == 0 || input.vertexCount == 0 || input.indexCount < 3) {
+                METAGFX_ERROR << "Acceleration structure geometry needs vertices and indices in "
+                                 "BufferUsage::AccelerationStructureInput buffers";
+                return;
+            }
+
+            VkAccelerationStructureGeometryKHR geometry{};
+            geometry.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+            geometry.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+            geometry.flags = input.opaque ? VK_GEOMETRY_OPAQUE_BIT_KHR : 0;
+            auto& triangles = geometry.geometry.triangles;
+            triangles.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+            triangles.vertexFormat = vertexFormat;
+            triangles.vertexData.deviceAddress = vertexBuffer->GetDeviceAddress() + input.vertexOffset;
+            triangles.vertexStride = input.vertexStride;
+            triangles.maxVertex = input.vertexCount - 1;
+            triangles.indexType = VK_INDEX_TYPE_UINT32;
+            triangles.indexData.deviceAddress = indexBuffer->GetDeviceAddress() + input.indexOffset;
+            m_Geometries.push_back(geometry);
+
+            VkAccelerationStructureBuildRangeInfoKHR range{};
+            range.primitiveCount = input.indexCount / 3;
+            m_Ranges.push_back(range);
+            maxPrimitiveCounts.push_back(range.primitiveCount);
+        }
+        if (m_Geometries.empty()) {
+            METAGFX_ERROR << "Bottom-level acceleration structure without geometry";
+            return;
+        }
+    }
+
+    VkAccelerationStructureBuildGeometryInfoKHR buildInfo = GetGeometryInfo();
+    VkAccelerationStructureBuildSizesInfoKHR sizes{};
+    sizes.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
+    m_Context.getAccelerationStructureBuildSizes(m_Context.device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR,
+                                                 &buildInfo, maxPrimitiveCounts.data(), &sizes);
+    m_StorageSize = storageSize != 0 ? storageSize : sizes.accelerationStructureSize;
+    m_BuildScratchSize = sizes.buildScratchSize;
+    m_UpdateScratchSize = sizes.updateScratchSize;
+
+    m_Storage = CreateScope<VulkanAccelerationStructureBuffer>(
+        m_Context, m_StorageSize, VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (!m_Storage->IsValid()) {
+        return;
+    }
+
+    // Updates happen every frame, so they keep their scratch rather than allocating a batch's
+    if (HasFlag(desc.flags, AccelerationStructureFlags::AllowUpdate)) {
+        VkDeviceSize alignment = m_Context.accelerationStructureScratchAlignment;
+        m_Scratch = CreateScope<VulkanAccelerationStructureBuffer>(
+            m_Context, std::max(m_BuildScratchSize, m_UpdateScratchSize) + alignment - 1,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!m_Scratch->IsValid()) {
+            return;
+        }
+    }
+
+    if (HasFlag(desc.flags, AccelerationStructureFlags::AllowCompaction)) {
+        VkQueryPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        poolInfo.queryType = VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR;
+        poolInfo.queryCount = 1;
+        VK_CHECK(vkCreateQueryPool(m_Context.device, &poolInfo, nullptr, &m_CompactionQueries));
+    }
+
+    VkAccelerationStructureCreateInfoKHR createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
+    createInfo.buffer = m_Storage->GetHandle();
+    createInfo.size = m_StorageSize;
+    createInfo.type = topLevel ? VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR
+                               : VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+    VK_CHECK(m_Context.createAccelerationStructure(m_Context.device, &createInfo, nullptr, &m_Handle));
+    if (m_Handle == VK_NULL_HANDLE) {
+        return;
+    }
+
+    VkAccelerationStructureDeviceAddressInfoKHR addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
+    addressInfo.accelerationStructure = m_Handle;
+    m_DeviceAddress = m_Context.getAccelerationStructureDeviceAddress(m_Context.device, &addressInfo);
+}
+
+VulkanAccelerationStructure::~VulkanAccelerationStructure() {
+    if (m_Handle != VK_NULL_HANDLE) {
+        m_Context.destroyAccelerationStructure(m_Context.device, m_Handle, nullptr);
+    }
+    if (m_CompactionQueries != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_Context.device, m_CompactionQueries, nullptr);
+    }
+}
+
+VkAccelerationStructureBuildGeometryInfoKHR VulkanAccelerationStructure::GetGeometryInfo() const {
+    VkAccelerationStructureBuildGeometryInfoKHR info{};
+    info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
+    info.type = m_Desc.type == AccelerationStructureType::TopLevel ? VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR
+                                                                    : VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+    info.flags = ToVulkanBuildFlags(m_Desc.flags);
+    info.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+    info.geometryCount = static_cast<uint32>(m_Geometries.size());
+    info.pGeometries = m_Geometries.data();
+    return info;
+}
+
+bool VulkanAccelerationStructure::PrepareBuild(const AccelerationStructureBuild& build,
+                                               VkAccelerationStructureBuildGeometryInfoKHR& outInfo,
+                                               const VkAccelerationStructureBuildRangeInfoKHR*& outRanges) {
+    if (!IsValid()) {
+        return false;
+    }
+    bool update = build.update && m_Built && HasFlag(m_Desc.flags, AccelerationStructureFlags::AllowUpdate);
+
+    if (m_Desc.type == AccelerationStructureType::TopLevel) {
+        uint32 count = std::min(build.instanceCount, m_Desc.maxInstances);
+        if (build.instanceCount > m_Desc.maxInstances) {
+            METAGFX_WARN << "Acceleration structure build of " << build.instanceCount << " instances, "
+                         << m_Desc.maxInstances << " fit";
+        }
+        update = update && count == m_BuiltInstanceCount;
+
+        // The region of the build recorded framesInFlight builds ago, which the GPU is done with
+        m_InstanceRegion = (m_InstanceRegion + 1) % m_Context.framesInFlight;
+        VkDeviceSize regionOffset =
+            VkDeviceSize(m_InstanceRegion) * m_Desc.maxInstances * sizeof(VkAccelerationStructureInstanceKHR);
+        auto* instances = reinterpret_cast<VkAccelerationStructureInstanceKHR*>(
+            static_cast<uint8*>(m_Instances->GetMappedData()) + regionOffset);
+        for (uint32 i = 0; i < count; ++i) {
+            const AccelerationStructureInstance& source = build.instances[i];
+            VkAccelerationStructureInstanceKHR& instance = instances[i];
+            std::memcpy(instance.transform.matrix, source.transform, sizeof(instance.transform.matrix));
+            instance.instanceCustomIndex = source.instanceID & 0xFFFFFF;
+            instance.mask = source.mask;
+            instance.instanceShaderBindingTableRecordOffset = 0;
+            // Both faces, as Metal intersects them
+            instance.flags = VK_GEOMETRY_INSTANCE_TRIANGLE_FACING_CULL_DISABLE_BIT_KHR;
+            const auto* bottomLevel = static_cast<const VulkanAccelerationStructure*>(source.bottomLevel);
+            instance.accelerationStructureReference = bottomLevel ? bottomLevel->GetDeviceAddress() : 0;
+        }
+        m_Geometries[0].geometry.instances.data.deviceAddress = m_Instances->GetAddress() + regionOffset;
+        m_Ranges[0].primitiveCount = count;
+        m_BuiltInstanceCount = count;
+    }
+
+    outInfo = GetGeometryInfo();
+    outInfo.mode = update ? VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR
+                          : VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+    outInfo.srcAccelerationStructure = update ? m_Handle : VK_NULL_HANDLE;
+    outInfo.dstAccelerationStructure = m_Handle;
+    outRanges = m_Ranges.data();
+    return true;
+}
+
+VkDeviceSize VulkanAccelerationStructure::GetBatchScratchSize(const VkAccelerationStructureBuildGeometryInfoKHR& info) const {
+    if (m_Scratch) {
+        return 0;
+    }
+    return info.mode == VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR ? m_UpdateScratchSize : m_BuildScratchSize;
+}
+
+VkDeviceAddress VulkanAccelerationStructure::GetScratchAddress() const {
+    if (!m_Scratch) {
+        return 0;
+    }
+    VkDeviceSize alignment = m_Context.accelerationStructureScratchAlignment;
+    return (m_Scratch->GetAddress() + alignment - 1) / alignment * alignment;
+}
+
+void VulkanAccelerationStructure::MarkBuilt(bool compactionQueryWritten) {
+    m_Built = true;
+    m_CompactionPending = compactionQueryWritten;
+    m_CompactedSize = 0;
+}
+
+uint64 VulkanAccelerationStructure::GetCompactedSize() {
+    if (m_CompactedSize != 0 || !m_CompactionPending) {
+        return m_CompactedSize;
+    }
+    // VK_NOT_READY until the build has run on the GPU
+    uint64 size = 0;
+    VkResult result = vkGetQueryPoolResults(m_Context.device, m_CompactionQueries, 0, 1, sizeof(size), &size,
+                                            sizeof(size), VK_QUERY_RESULT_64_BIT);
+    if (result == VK_SUCCESS) {
+        m_CompactedSize = size;
+        m_CompactionPending = false;
+    }
+    return m_CompactedSize;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,228 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanBarrierBatch.cpp
+// ============================================================================
+#include "metagfx/rhi/vulkan/VulkanBarrierBatch.h"
+#include "metagfx/rhi/vulkan/VulkanBuffer.h"
+#include "metagfx/rhi/vulkan/VulkanTexture.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+constexpr VkAccessFlags2KHR WRITE_ACCESS = VK_ACCESS_2_SHADER_WRITE_BIT_KHR |
+                                           VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT_KHR |
+                                           VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT_KHR |
+                                           VK_ACCESS_2_TRANSFER_WRITE_BIT_KHR |
+                                           VK_ACCESS_2_HOST_WRITE_BIT_KHR |
+                                           VK_ACCESS_2_MEMORY_WRITE_BIT_KHR;
+
+bool operator==(const VulkanResourceState& a, const VulkanResourceState& b) {
+    return a.layout == b.layout && a.writeStages == b.writeStages && a.writeAccess == b.writeAccess &&
+           a.readStages == b.readStages;
+}
+
+} // namespace
+
+bool VulkanBarrierBatch::Plan(VulkanResourceState& state, const VulkanAccess& access, VkImageLayout layout,
+                              VkPipelineStageFlags2KHR& srcStages, VkAccessFlags2KHR& srcAccess) {
+    bool transition = layout != state.layout;
+    bool write = (access.access & WRITE_ACCESS) != 0;
+    srcAccess = state.writeAccess;
+
+    bool barrier = false;
+    if (transition || write) {
+        // Writes and layout transitions wait for every earlier access (WAW, WAR)
+        srcStages = state.writeStages | state.readStages;
+        barrier = transition || srcStages != 0;
+        // A transition counts as a write of the stages it was made visible to
+        state.writeStages = access.stages;
+        state.writeAccess = access.access & WRITE_ACCESS;
+        state.readStages = write ? 0 : access.stages;
+    } else {
+        // Reads wait for the last write, once per stage
+        srcStages = state.writeStages;
+        barrier = state.writeStages != 0 && (access.stages & ~state.readStages) != 0;
+        state.readStages |= access.stages;
+    }
+    state.layout = layout;
+    return barrier;
+}
+
+void VulkanBarrierBatch::Use(VulkanTexture& texture, const VulkanAccess& access, bool discard,
+                             uint32 baseMip, uint32 mipCount, uint32 baseLayer, uint32 layerCount) {
+    uint32 endMip = std::min(texture.GetMipLevels(), baseMip + std::min(mipCount, texture.GetMipLevels()));
+    uint32 endLayer = std::min(texture.GetArrayLayers(), baseLayer + std::min(layerCount, texture.GetArrayLayers()));
+
+    // Usually every subresource is in the same state: one barrier for the range
+    const VulkanResourceState& first = texture.GetState(baseMip, baseLayer);
+    bool uniform = true;
+    for (uint32 layer = baseLayer; layer < endLayer && uniform; ++layer) {
+        for (uint32 mip = baseMip; mip < endMip && uniform; ++mip) {
+            uniform = texture.GetState(mip, layer) == first;
+        }
+    }
+
+    auto plan = [&](uint32 mip, uint32 mips, uint32 layer, uint32 layers) {
+        VulkanResourceState before = texture.GetState(mip, layer);
+        VulkanResourceState after = before;
+        VkImageLayout layout = access.layout != VK_IMAGE_LAYOUT_UNDEFINED ? access.layout : before.layout;
+        VkPipelineStageFlags2KHR srcStages = 0;
+        VkAccessFlags2KHR srcAccess = 0;
+        bool barrier = Plan(after, access, layout, srcStages, srcAccess);
+        for (uint32 l = layer; l < layer + layers; ++l) {
+            for (uint32 m = mip; m < mip + mips; ++m) {
+                texture.GetState(m, l) = after;
+            }
+        }
+        if (!barrier) {
+            return;
+        }
+
+        VkImageLayout oldLayout = discard ? VK_IMAGE_LAYOUT_UNDEFINED : before.layout;
+        // Extend the previous barrier over consecutive mips of the same layer
+        if (!m_ImageBarriers.empty()) {
+            VkImageMemoryBarrier2KHR& last = m_ImageBarriers.back();
+            VkImageSubresourceRange& range = last.subresourceRange;
+            if (last.image == texture.GetImage() && layers == 1 && range.baseArrayLayer == layer &&
+                range.layerCount == 1 && range.baseMipLevel + range.levelCount == mip &&
+                last.oldLayout == oldLayout && last.newLayout == layout && last.srcStageMask == srcStages &&
+                last.srcAccessMask == srcAccess) {
+                range.levelCount += mips;
+                return;
+            }
+        }
+
+        VkImageMemoryBarrier2KHR barrierInfo{};
+        barrierInfo.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+        barrierInfo.srcStageMask = srcStages;
+        barrierInfo.srcAccessMask = srcAccess;
+        barrierInfo.dstStageMask = access.stages;
+        barrierInfo.dstAccessMask = access.access;
+        barrierInfo.oldLayout = oldLayout;
+        barrierInfo.newLayout = layout;
+        barrierInfo.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrierInfo.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrierInfo.image = texture.GetImage();
+        barrierInfo.subresourceRange = { texture.GetAspectMask(), mip, mips, layer, layers };
+        m_ImageBarriers.push_back(barrierInfo);
+    };
+
+    if (uniform) {
+        plan(baseMip, endMip - baseMip, baseLayer, endLayer - baseLayer);
+        return;
+    }
+    for (uint32 layer = baseLayer; layer < endLayer; ++layer) {
+        for (uint32 mip = baseMip; mip < endMip; ++mip) {
+            plan(mip, 1, layer, 1);
+        }
+    }
+}
+
+void VulkanBarrierBatch::Use(VulkanBuffer& buffer, const VulkanAccess& access) {
+    VkPipelineStageFlags2KHR srcStages = 0;
+    VkAccessFlags2KHR srcAccess = 0;
+    if (!Plan(buffer.GetState(), access, VK_IMAGE_LAYOUT_UNDEFINED, srcStages, srcAccess)) {
+        return;
+    }
+
+    VkBufferMemoryBarrier2KHR barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstStageMask = access.stages;
+    barrier.dstAccessMask = access.access;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer.GetHandle();
+    barrier.offset = 0;
+    barrier.size = VK_WHOLE_SIZE;
+    m_BufferBarriers.push_back(barrier);
+}
+
+void VulkanBarrierBatch::Assume(VulkanTexture& texture, const VulkanAccess& access,
+                                uint32 baseMip, uint32 mipCount, uint32 baseLayer, uint32 layerCount) {
+    VulkanResourceState state{};
+    state.layout = access.layout;
+    state.writeStages = access.stages;
+    state.writeAccess = access.access & WRITE_ACCESS;
+
+    uint32 endMip = std::min(texture.GetMipLevels(), baseMip + std::min(mipCount, texture.GetMipLevels()));
+    uint32 endLayer = std::min(texture.GetArrayLayers(), baseLayer + std::min(layerCount, texture.GetArrayLayers()));
+    for (uint32 layer = baseLayer; layer < endLayer; ++layer) {
+        for (uint32 mip = baseMip; mip < endMip; ++mip) {
+            texture.GetState(mip, layer) = state;
+        }
+    }
+}
+
+bool VulkanBarrierBatch::Flush(VkCommandBuffer commandBuffer) {
+    if (m_ImageBarriers.empty() && m_BufferBarriers.empty()) {
+        return false;
+    }
+
+    if (m_Context.cmdPipelineBarrier2) {
+        VkDependencyInfoKHR dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+        dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32>(m_BufferBarriers.size());
+        dependencyInfo.pBufferMemoryBarriers = m_BufferBarriers.data();
+        dependencyInfo.imageMemoryBarrierCount = static_cast<uint32>(m_ImageBarriers.size());
+        dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data();
+        m_Context.cmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+    } else {
+        // One stage mask pair for all barriers; the flags used are all legacy ones
+        VkPipelineStageFlags srcStages = 0;
+        VkPipelineStageFlags dstStages = 0;
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        imageBarriers.reserve(m_ImageBarriers.size());
+        bufferBarriers.reserve(m_BufferBarriers.size());
+
+        for (const VkImageMemoryBarrier2KHR& barrier2 : m_ImageBarriers) {
+            srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+            dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+            VkImageMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            barrier.srcAccessMask = static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+            barrier.dstAccessMask = static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+            barrier.oldLayout = barrier2.oldLayout;
+            barrier.newLayout = barrier2.newLayout;
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.image = barrier2.image;
+            barrier.subresourceRange = barrier2.subresourceRange;
+            imageBarriers.push_back(barrier);
+        }
+        for (const VkBufferMemoryBarrier2KHR& barrier2 : m_BufferBarriers) {
+            srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+            dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+            VkBufferMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            barrier.srcAccessMask = static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+            barrier.dstAccessMask = static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+            barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            barrier.buffer = barrier2.buffer;
+            barrier.offset = barrier2.offset;
+            barrier.size = barrier2.size;
+            bufferBarriers.push_back(barrier);
+        }
+
+        // Legacy barriers take no empty stage masks
+        vkCmdPipelineBarrier(commandBuffer,
+                             srcStages != 0 ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             dstStages != 0 ? dstStages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr,
+                             static_cast<uint32>(bufferBarriers.size()), bufferBarriers.data(),
+                             static_cast<uint32>(imageBarriers.size()), imageBarriers.data());
+    }
+
+    m_ImageBarriers.clear();
+    m_BufferBarriers.clear();
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -3,87 +3,138 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/vulkan/VulkanBuffer.h"
-#include "metagfx/rhi/vulkan/VulkanDevice.h"
+#include "metagfx/rhi/vulkan/VulkanUploadManager.h"
+
+#include <cstring>
 
 namespace metagfx {
 namespace rhi {
 
 VulkanBuffer::VulkanBuffer(VulkanContext& context, const BufferDesc& desc)
-    : m_Context(context), m_Size(desc.size), m_Usage(desc.usage), m_MemoryUsage(desc.memoryUsage) {
+    : m_Context(context), m_Size(desc.size), m_Usage(desc.usage), m_MemoryUsage(desc.memoryUsage),
+      m_MemoryCategory(GetBufferMemoryCategory(desc)) {
     
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size = desc.size;
     bufferInfo.usage = ToVulkanBufferUsage(desc.usage);
+    if (desc.memoryUsage == MemoryUsage::GPUOnly) {
+        bufferInfo.usage |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;  // Filled through the staging ring
+    }
     bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
     
     VK_CHECK(vkCreateBuffer(m_Context.device, &bufferInfo, nullptr, &m_Buffer));
-    
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(m_Context.device, m_Buffer, &memRequirements);
-    
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    
-    // Find memory type
+
+    // Sub-allocated from a shared block; host-visible blocks are persistently mapped
     VkMemoryPropertyFlags properties = ToVulkanMemoryUsage(desc.memoryUsage);
-    allocInfo.memoryTypeIndex = 0;
-    for (uint32 i = 0; i < m_Context.memoryProperties.memoryTypeCount; i++) {
-        if ((memRequirements.memoryTypeBits & (1 << i)) &&
-            (m_Context.memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            allocInfo.memoryTypeIndex = i;
-            break;
-        }
+    if (!m_Context.allocator->AllocateBuffer(m_Buffer, properties, m_Allocation)) {
+        METAGFX_ERROR << "Failed to allocate memory for buffer of " << desc.size << " bytes";
+    } else {
+        m_Context.memory->Add(m_MemoryCategory, m_Allocation.size);
     }
-    
-    VK_CHECK(vkAllocateMemory(m_Context.device, &allocInfo, nullptr, &m_Memory));
-    VK_CHECK(vkBindBufferMemory(m_Context.device, m_Buffer, m_Memory, 0));
 }
 
 VulkanBuffer::~VulkanBuffer() {
-    if (m_MappedData != nullptr) {
-        Unmap();
+    // A staged copy into this buffer may still be queued or executing
+    if (m_UploadTicket != 0 && m_Context.uploadManager) {
+        m_Context.uploadManager->Wait(m_UploadTicket);
     }
-    
+
     if (m_Buffer != VK_NULL_HANDLE) {
         vkDestroyBuffer(m_Context.device, m_Buffer, nullptr);
     }
-    
-    if (m_Memory != VK_NULL_HANDLE) {
-        vkFreeMemory(m_Context.device, m_Memory, nullptr);
+
+    if (m_Allocation.IsValid()) {
+        m_Context.memory->Remove(m_MemoryCategory, m_Allocation.size);
     }
+    m_Context.allocator->Free(m_Allocation);
 }
 
 void* VulkanBuffer::Map() {
-    if (m_MappedData == nullptr) {
-        VK_CHECK(vkMapMemory(m_Context.device, m_Memory, 0, m_Size, 0, &m_MappedData));
+    // The allocator keeps host-visible memory mapped; the same VkDeviceMemory can
+    // back several buffers, so it must not be mapped again here
+    if (m_Allocation.mappedData == nullptr) {
+        METAGFX_ERROR << "Buffer memory is not host visible";
     }
-    return m_MappedData;
+    return m_Allocation.mappedData;
 }
 
 void VulkanBuffer::Unmap() {
-    if (m_MappedData != nullptr) {
-        vkUnmapMemory(m_Context.device, m_Memory);
-        m_MappedData = nullptr;
-    }
+    // Memory stays mapped until the buffer is destroyed
 }
 
 void VulkanBuffer::CopyData(const void* data, uint64 size, uint64 offset) {
-    void* mapped = Map();
-    memcpy(static_cast<char*>(mapped) + offset, data, size);
-
-    // Flush mapped memory to make writes visible to GPU
-    VkMappedMemoryRange range{};
-    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-    range.memory = m_Memory;
-    range.offset = offset;
-    range.size = size;
-    VK_CHECK(vkFlushMappedMemoryRanges(m_Context.device, 1, &range));
-
-    Unmap();
+    WriteData(size, offset, [data, size](void* destination) {
+        memcpy(destination, data, size);
+    });
+}
+
+void VulkanBuffer::WriteData(uint64 size, uint64 offset, const WriteCallback& write) {
+    if (offset + size > m_Size) {
+        METAGFX_ERROR << "Buffer copy out of bounds: offset=" << offset << ", size=" << size
+                      << ", buffer size=" << m_Size;
+        return;
+    }
+    m_Context.stats->AddBufferUpload(size);
+
+    // Device-local memory is not mappable: stage the data and copy on the upload queue
+    if (m_Allocation.mappedData == nullptr) {
+        VkPipelineStageFlags dstStage = 0;
+        VkAccessFlags dstAccess = 0;
+        uint32 usage = static_cast<uint32>(m_Usage);
+        if (usage & static_cast<uint32>(BufferUsage::Vertex)) {
+            dstStage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            dstAccess |= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+        }
+        if (usage & static_cast<uint32>(BufferUsage::Index)) {
+            dstStage |= VK_PIPELINE_STAGE_VERTEX_INPUT_BIT;
+            dstAccess |= VK_ACCESS_INDEX_READ_BIT;
+        }
+        if (usage & static_cast<uint32>(BufferUsage::Uniform)) {
+            dstStage |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dstAccess |= VK_ACCESS_UNIFORM_READ_BIT;
+        }
+        if (usage & static_cast<uint32>(BufferUsage::Storage)) {
+            dstStage |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            dstAccess |= VK_ACCESS_SHADER_READ_BIT;
+        }
+        if (usage & static_cast<uint32>(BufferUsage::AccelerationStructureInput)) {
+            dstStage |= VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+            dstAccess |= VK_ACCESS_SHADER_READ_BIT;
+        }
+        if (usage & static_cast<uint32>(BufferUsage::TransferSrc)) {
+            dstStage |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+            dstAccess |= VK_ACCESS_TRANSFER_READ_BIT;
+        }
+        if (dstStage == 0) {
+            dstStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+            dstAccess = VK_ACCESS_MEMORY_READ_BIT;
+        }
+
+        m_UploadTicket = m_Context.uploadManager->UploadBuffer(m_Buffer, offset, size, write, dstStage, dstAccess);
+        return;
+    }
+
+    write(static_cast<char*>(m_Allocation.mappedData) + offset);
+
+    // Make writes visible to GPU (no-op for coherent memory, which CPU-writable buffers prefer)
+    m_Context.allocator->Flush(m_Allocation, offset, size);
+}
+
+VkDeviceAddress VulkanBuffer::GetDeviceAddress() const {
+    if (!m_Context.getBufferDeviceAddress ||
+        (m_Usage & BufferUsage::AccelerationStructureInput) == BufferUsage{}) {
+        return 0;
+    }
+    VkBufferDeviceAddressInfo addressInfo{};
+    addressInfo.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+    addressInfo.buffer = m_Buffer;
+    return m_Context.getBufferDeviceAddress(m_Context.device, &addressInfo);
+}
+
+bool VulkanBuffer::IsUploadComplete() const {
+    return m_UploadTicket == 0 || m_Context.uploadManager->IsComplete(m_UploadTicket);
 }
 
 } // namespace rhi
 } // namespace metagfx
-
@@ -6,35 +6,100 @@
 #include "metagfx/rhi/vulkan/VulkanTexture.h"
 #include "metagfx/rhi/vulkan/VulkanBuffer.h"
 #include "metagfx/rhi/vulkan/VulkanPipeline.h"
+#include "metagfx/rhi/vulkan/VulkanComputePipeline.h"
 #include "metagfx/rhi/vulkan/VulkanDescriptorSet.h"
+#include "metagfx/rhi/vulkan/VulkanRenderPassCache.h"
+#include "metagfx/rhi/vulkan/VulkanSampler.h"
 #include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/FormatInfo.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
 
 namespace metagfx {
 namespace rhi {
 
-VulkanCommandBuffer::VulkanCommandBuffer(VulkanContext& context, VkCommandPool commandPool)
-    : m_Context(context), m_CommandPool(commandPool) {
+// Depth/stencil aspect mask for a depth attachment format
+static VkImageAspectFlags GetDepthAspectMask(VkFormat format) {
+    if (format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT) {
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    return VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+constexpr VkAccessFlags COLOR_ATTACHMENT_ACCESS =
+    VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+constexpr VkPipelineStageFlags DEPTH_ATTACHMENT_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+constexpr VkAccessFlags DEPTH_ATTACHMENT_ACCESS =
+    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+// Stages and accesses of a ResourceState, and the layout textures are in. Present keeps
+// the color output stage, so a pass loading the presentable image (ImGui's) can wait for
+// the transition.
+static VulkanAccess GetStateAccess(ResourceState state, const VulkanTexture* texture) {
+    switch (state) {
+        case ResourceState::Undefined:
+            return { 0, 0, VK_IMAGE_LAYOUT_UNDEFINED };
+        case ResourceState::ColorAttachment:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, COLOR_ATTACHMENT_ACCESS,
+                     VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+        case ResourceState::DepthAttachment:
+            return { DEPTH_ATTACHMENT_STAGES, DEPTH_ATTACHMENT_ACCESS,
+                     VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+        case ResourceState::ShaderRead:
+            return { VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT |
+                     VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT,
+                     texture ? texture->GetShaderReadLayout() : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        case ResourceState::StorageWrite:
+            return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                     VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL };
+        case ResourceState::IndirectArgument:
+            return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+                     VK_IMAGE_LAYOUT_GENERAL };
+        case ResourceState::TransferWrite:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL };
+        case ResourceState::TransferRead:
+            return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                     VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL };
+        case ResourceState::ShadingRate:
+            return { VK_PIPELINE_STAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR,
+                     VK_ACCESS_FRAGMENT_SHADING_RATE_ATTACHMENT_READ_BIT_KHR,
+                     VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR };
+        case ResourceState::Present:
+            return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR };
+    }
+    return { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+             VK_IMAGE_LAYOUT_GENERAL };
+}
+
+VulkanCommandBuffer::VulkanCommandBuffer(VulkanContext& context, VkCommandPool commandPool,
+                                         VulkanCommandBuffer* primary)
+    : m_Context(context), m_CommandPool(commandPool), m_Barriers(context), m_Primary(primary) {
     
     VkCommandBufferAllocateInfo allocInfo{};
     allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
     allocInfo.commandPool = commandPool;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.level = primary ? VK_COMMAND_BUFFER_LEVEL_SECONDARY : VK_COMMAND_BUFFER_LEVEL_PRIMARY;
     allocInfo.commandBufferCount = 1;
     
     VK_CHECK(vkAllocateCommandBuffers(m_Context.device, &allocInfo, &m_CommandBuffer));
+    m_Segments[0] = m_CommandBuffer;
 }
 
 VulkanCommandBuffer::~VulkanCommandBuffer() {
-    if (m_CurrentFramebuffer != VK_NULL_HANDLE) {
-        vkDestroyFramebuffer(m_Context.device, m_CurrentFramebuffer, nullptr);
+    // Render passes and framebuffers are owned by the device's VulkanRenderPassCache
+    for (Secondary& secondary : m_Secondaries) {
+        secondary.commandBuffer.reset();
+        vkDestroyCommandPool(m_Context.device, secondary.pool, nullptr);
     }
-    
-    if (m_CurrentRenderPass != VK_NULL_HANDLE) {
-        vkDestroyRenderPass(m_Context.device, m_CurrentRenderPass, nullptr);
-    }
-    
-    if (m_CommandBuffer != VK_NULL_HANDLE) {
-        vkFreeCommandBuffers(m_Context.device, m_CommandPool, 1, &m_CommandBuffer);
+    for (VkCommandBuffer segment : m_Segments) {
+        if (segment != VK_NULL_HANDLE) {
+            vkFreeCommandBuffers(m_Context.device, m_CommandPool, 1, &segment);
+        }
     }
 }
 
@@ -42,9 +107,94 @@ void VulkanCommandBuffer::Begin() {
     VkCommandBufferBeginInfo beginInfo{};
     beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
     beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    VkCommandBufferInheritanceInfo inheritanceInfo{};
+    VkCommandBufferInheritanceRenderingInfoKHR renderingInheritance{};
+    if (m_Primary) {
+        // Continue the primary's open parallel render pass
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = m_Primary->m_InheritedRenderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = m_Primary->m_InheritedFramebuffer;
+        if (m_Context.dynamicRendering) {
+            VkFormat depthFormat = m_Primary->m_InheritedDepthFormat;
+            renderingInheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+            renderingInheritance.colorAttachmentCount = m_Primary->m_InheritedColorFormat != VK_FORMAT_UNDEFINED ? 1 : 0;
+            renderingInheritance.pColorAttachmentFormats = &m_Primary->m_InheritedColorFormat;
+            renderingInheritance.depthAttachmentFormat = depthFormat;
+            renderingInheritance.stencilAttachmentFormat =
+                (GetDepthAspectMask(depthFormat) & VK_IMAGE_ASPECT_STENCIL_BIT) ? depthFormat : VK_FORMAT_UNDEFINED;
+            renderingInheritance.rasterizationSamples = m_Primary->m_InheritedSamples;
+            renderingInheritance.viewMask = m_Primary->m_InheritedViewMask;
+            inheritanceInfo.pNext = &renderingInheritance;
+        }
+        beginInfo.flags |= VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+    } else {
+        // Like this command buffer, the secondaries it executed are no longer in use
+        for (Secondary& secondary : m_Secondaries) {
+            VK_CHECK(vkResetCommandPool(m_Context.device, secondary.pool, 0));
+        }
+        m_ActiveSecondaryCount = 0;
+        m_BuildScratch.clear();
+    }
     
+    m_CommandBuffer = m_Segments[0];
+    m_SegmentCount = 1;
     VK_CHECK(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
     m_IsRecording = true;
+    m_BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    m_FilteredCallCount = 0;
+    m_Stats = FrameStats{};
+    InvalidateState();
+}
+
+void VulkanCommandBuffer::InvalidateState() {
+    for (uint32 i = 0; i < 2; ++i) {
+        m_BoundPipelines[i] = VK_NULL_HANDLE;
+        for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+            m_BoundSetLayouts[i][set] = VK_NULL_HANDLE;
+            m_BoundSets[i][set] = VK_NULL_HANDLE;
+            m_BoundOffsets[i][set].count = 0;
+        }
+    }
+    m_BoundVertexBuffer = VK_NULL_HANDLE;
+    m_BoundIndexBuffer = VK_NULL_HANDLE;
+    m_ViewportBound = false;
+    m_ScissorBound = false;
+    ResetPushConstantState(VK_NULL_HANDLE);
+}
+
+void VulkanCommandBuffer::WaitForAsyncCompute() {
+    if (m_Primary || !m_IsRecording || m_InsideRenderPass || m_SegmentCount > 1) {
+        METAGFX_WARN << "WaitForAsyncCompute() ignored: needs a recording primary outside any render pass, once";
+        return;
+    }
+    if (m_Segments[1] == VK_NULL_HANDLE) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = m_CommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = 1;
+        VK_CHECK(vkAllocateCommandBuffers(m_Context.device, &allocInfo, &m_Segments[1]));
+    }
+
+    // Barriers already planned belong to the commands before the wait
+    FlushBarriers();
+    VK_CHECK(vkEndCommandBuffer(m_CommandBuffer));
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    m_CommandBuffer = m_Segments[1];
+    m_SegmentCount = 2;
+    VK_CHECK(vkBeginCommandBuffer(m_CommandBuffer, &beginInfo));
+    InvalidateState();
+}
+
+void VulkanCommandBuffer::ResetPushConstantState(VkPipelineLayout layout) {
+    m_PushConstantLayout = layout;
+    std::memset(m_PushConstantStages, 0, sizeof(m_PushConstantStages));
 }
 
 void VulkanCommandBuffer::End() {
@@ -52,151 +202,403 @@ void VulkanCommandBuffer::End() {
     m_IsRecording = false;
 }
 
-void VulkanCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                                         Ref<Texture> depthAttachment,
-                                         const std::vector<ClearValue>& clearValues) {
+void VulkanCommandBuffer::BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                                         const Ref<Texture>& depthAttachment,
+                                         std::span<const ClearValue> clearValues,
+                                         const RenderPassActions& actions,
+                                         std::span<const Ref<Texture>> resolveTargets,
+                                         const Ref<Texture>& shadingRate) {
 
     // Support both color+depth and depth-only rendering
     bool hasColorAttachment = !colorAttachments.empty();
-    std::vector<VkAttachmentDescription> attachments;
 
-    // Setup color attachment if provided
-    VkAttachmentDescription colorAttachment{};
-    VkAttachmentReference colorAttachmentRef{};
     Ref<VulkanTexture> vkTexture;
+    Ref<VulkanTexture> vkDepthTexture;
+    Ref<VulkanTexture> vkResolveTexture;
+    uint32_t fbWidth = 0, fbHeight = 0;
+    uint32 sampleCount = 1;
 
     if (hasColorAttachment) {
         vkTexture = std::static_pointer_cast<VulkanTexture>(colorAttachments[0]);
-        colorAttachment.format = ToVulkanFormat(vkTexture->GetFormat());
-        colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-        colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-        colorAttachmentRef.attachment = 0;
-        colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-        attachments.push_back(colorAttachment);
-    }
-
-    // Setup depth attachment if provided
-    VkAttachmentDescription depthAttachmentDesc{};
-    VkAttachmentReference depthAttachmentRef{};
-
-    if (depthAttachment) {
-        auto vkDepthTexture = std::static_pointer_cast<VulkanTexture>(depthAttachment);
-        depthAttachmentDesc.format = ToVulkanFormat(vkDepthTexture->GetFormat());
-        depthAttachmentDesc.samples = VK_SAMPLE_COUNT_1_BIT;
-        depthAttachmentDesc.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachmentDesc.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-        depthAttachmentDesc.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-        depthAttachmentDesc.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-        depthAttachmentDesc.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        depthAttachmentDesc.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-        attachments.push_back(depthAttachmentDesc);
-
-        // Attachment index depends on whether we have a color attachment
-        depthAttachmentRef.attachment = hasColorAttachment ? 1 : 0;
-        depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-    }
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = hasColorAttachment ? 1 : 0;
-    subpass.pColorAttachments = hasColorAttachment ? &colorAttachmentRef : nullptr;
-    if (depthAttachment) {
-        subpass.pDepthStencilAttachment = &depthAttachmentRef;
-    }
-
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments = attachments.data();
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    
-    VK_CHECK(vkCreateRenderPass(m_Context.device, &renderPassInfo, nullptr, &m_CurrentRenderPass));
-
-    // Create framebuffer
-    std::vector<VkImageView> framebufferAttachments;
-    uint32_t fbWidth, fbHeight;
-
-    if (hasColorAttachment) {
-        framebufferAttachments.push_back(vkTexture->GetImageView());
         fbWidth = vkTexture->GetWidth();
         fbHeight = vkTexture->GetHeight();
+        sampleCount = vkTexture->GetSampleCount();
+        if (!resolveTargets.empty() && resolveTargets[0] && sampleCount > 1) {
+            vkResolveTexture = std::static_pointer_cast<VulkanTexture>(resolveTargets[0]);
+        }
     }
 
     if (depthAttachment) {
-        auto vkDepthTexture = std::static_pointer_cast<VulkanTexture>(depthAttachment);
-        framebufferAttachments.push_back(vkDepthTexture->GetImageView());
+        vkDepthTexture = std::static_pointer_cast<VulkanTexture>(depthAttachment);
         if (!hasColorAttachment) {
             fbWidth = vkDepthTexture->GetWidth();
             fbHeight = vkDepthTexture->GetHeight();
+            sampleCount = vkDepthTexture->GetSampleCount();
         }
     }
 
-    VkFramebufferCreateInfo framebufferInfo{};
-    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    framebufferInfo.renderPass = m_CurrentRenderPass;
-    framebufferInfo.attachmentCount = static_cast<uint32_t>(framebufferAttachments.size());
-    framebufferInfo.pAttachments = framebufferAttachments.data();
-    framebufferInfo.width = fbWidth;
-    framebufferInfo.height = fbHeight;
-    framebufferInfo.layers = 1;
-    
-    VK_CHECK(vkCreateFramebuffer(m_Context.device, &framebufferInfo, nullptr, &m_CurrentFramebuffer));
-    
-    // Begin render pass
-    VkRenderPassBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    beginInfo.renderPass = m_CurrentRenderPass;
-    beginInfo.framebuffer = m_CurrentFramebuffer;
-    beginInfo.renderArea.offset = { 0, 0 };
-    beginInfo.renderArea.extent = { fbWidth, fbHeight };
-
     // Setup clear values
-    std::vector<VkClearValue> vkClearValues;
+    // For depth-only rendering, the first clear value is the depth clear;
+    // for color+depth rendering it is color first, then depth
+    VkClearValue colorClear{};
+    VkClearValue depthClear{};
     if (!clearValues.empty()) {
-        // For depth-only rendering, the first clear value is the depth clear
         if (!hasColorAttachment && depthAttachment) {
-            VkClearValue depthClear{};
             depthClear.depthStencil.depth = clearValues[0].depthStencil.depth;
             depthClear.depthStencil.stencil = clearValues[0].depthStencil.stencil;
-            vkClearValues.push_back(depthClear);
         } else if (hasColorAttachment) {
-            // For color+depth rendering
-            VkClearValue colorClear{};
             colorClear.color = { clearValues[0].color[0], clearValues[0].color[1],
                                 clearValues[0].color[2], clearValues[0].color[3] };
-            vkClearValues.push_back(colorClear);
 
             if (depthAttachment && clearValues.size() > 1) {
-                VkClearValue depthClear{};
                 depthClear.depthStencil.depth = clearValues[1].depthStencil.depth;
                 depthClear.depthStencil.stencil = clearValues[1].depthStencil.stencil;
-                vkClearValues.push_back(depthClear);
             }
         }
     }
 
-    beginInfo.clearValueCount = static_cast<uint32_t>(vkClearValues.size());
-    beginInfo.pClearValues = vkClearValues.data();
+    m_InheritedRenderPass = VK_NULL_HANDLE;
+    m_InheritedFramebuffer = VK_NULL_HANDLE;
+    m_InheritedColorFormat = vkTexture ? ToVulkanFormat(vkTexture->GetFormat()) : VK_FORMAT_UNDEFINED;
+    m_InheritedDepthFormat = vkDepthTexture ? ToVulkanFormat(vkDepthTexture->GetFormat()) : VK_FORMAT_UNDEFINED;
+    m_InheritedSamples = ToVulkanSampleCount(sampleCount);
+    m_InheritedViewMask = ToVulkanViewMask(actions.viewCount);
+
+    // Only dynamic rendering takes a shading rate image (VulkanContext::shadingRateImage)
+    if (m_Context.dynamicRendering) {
+        Ref<VulkanTexture> vkShadingRate =
+            m_Context.shadingRateImage ? std::static_pointer_cast<VulkanTexture>(shadingRate) : nullptr;
+        BeginDynamicRendering(vkTexture, vkDepthTexture, vkResolveTexture, vkShadingRate, fbWidth, fbHeight,
+                              colorClear, depthClear, actions);
+        return;
+    }
+
+    // Describe the render pass and framebuffer; the device-level cache returns
+    // existing objects when the attachments match a previous pass. The keys are
+    // members so their vectors keep their storage from pass to pass.
+    VulkanRenderPassKey& renderPassKey = m_RenderPassKey;
+    VulkanFramebufferKey& framebufferKey = m_FramebufferKey;
+    renderPassKey.Reset();
+    framebufferKey.Reset();
+
+    // Transient attachments are not stored, so they can stay in tile memory; neither are
+    // the ones the caller drops
+    if (vkTexture) {
+        renderPassKey.colorFormats.push_back(ToVulkanFormat(vkTexture->GetFormat()));
+        if (!IsStored(actions.colorStore, vkTexture->IsTransient(), vkResolveTexture != nullptr)) {
+            renderPassKey.colorStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+        framebufferKey.attachments.push_back(vkTexture->GetAttachmentView());
+    }
+
+    if (vkDepthTexture) {
+        renderPassKey.depthFormat = ToVulkanFormat(vkDepthTexture->GetFormat());
+        if (!IsStored(actions.depthStore, vkDepthTexture->IsTransient(), false)) {
+            renderPassKey.depthStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        }
+        framebufferKey.attachments.push_back(vkDepthTexture->GetAttachmentView());
+    }
 
-    vkCmdBeginRenderPass(m_CommandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+    // The multisampled attachments are resolved into a subpass resolve attachment
+    renderPassKey.samples = ToVulkanSampleCount(sampleCount);
+    renderPassKey.viewMask = m_InheritedViewMask;
+    if (vkResolveTexture) {
+        renderPassKey.resolveColor = true;
+        framebufferKey.attachments.push_back(vkResolveTexture->GetAttachmentView());
+    }
+
+    // Loaded attachments come from the layouts previous passes left them in: color from
+    // presentation, depth from the shader read transition after its pass
+    if (actions.colorLoad == LoadOp::Load) {
+        renderPassKey.colorLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        renderPassKey.colorInitialLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    } else if (actions.colorLoad == LoadOp::DontCare) {
+        renderPassKey.colorLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    }
+    if (vkDepthTexture) {
+        if (actions.depthLoad == LoadOp::Load) {
+            renderPassKey.depthLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+            renderPassKey.depthInitialLayout = vkDepthTexture->GetShaderReadLayout();
+        } else if (actions.depthLoad == LoadOp::DontCare) {
+            renderPassKey.depthLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        }
+    }
+
+    VkRenderPass renderPass = m_Context.renderPassCache->GetRenderPass(renderPassKey);
+
+    framebufferKey.renderPass = renderPass;
+    framebufferKey.width = fbWidth;
+    framebufferKey.height = fbHeight;
+    VkFramebuffer framebuffer = m_Context.renderPassCache->GetFramebuffer(framebufferKey);
+
+    if (renderPass == VK_NULL_HANDLE || framebuffer == VK_NULL_HANDLE) {
+        METAGFX_ERROR << "BeginRendering: failed to get render pass/framebuffer";
+        return;
+    }
+
+    // The render pass transitions the attachments from its initial layouts; wait for
+    // earlier accesses, and bring loaded attachments to those layouts. A multiview pass
+    // covers a layer per view.
+    uint32 layerCount = std::max(actions.viewCount, 1u);
+    if (vkTexture) {
+        m_Barriers.Use(*vkTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, COLOR_ATTACHMENT_ACCESS,
+                                     renderPassKey.colorInitialLayout }, false, 0, 1, 0, layerCount);
+    }
+    if (vkResolveTexture) {
+        m_Barriers.Use(*vkResolveTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                            VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT }, false, 0, 1, 0, layerCount);
+    }
+    if (vkDepthTexture) {
+        m_Barriers.Use(*vkDepthTexture, { DEPTH_ATTACHMENT_STAGES, DEPTH_ATTACHMENT_ACCESS,
+                                          renderPassKey.depthInitialLayout }, false, 0, 1, 0, layerCount);
+    }
+    FlushBarriers();
+
+    // Begin render pass
+    VkRenderPassBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    beginInfo.renderPass = renderPass;
+    beginInfo.framebuffer = framebuffer;
+    beginInfo.renderArea.offset = { 0, 0 };
+    beginInfo.renderArea.extent = { fbWidth, fbHeight };
+
+    VkClearValue vkClearValues[2];
+    uint32_t clearValueCount = 0;
+    if (!clearValues.empty()) {
+        if (hasColorAttachment) {
+            vkClearValues[clearValueCount++] = colorClear;
+        }
+        if (depthAttachment && (!hasColorAttachment || clearValues.size() > 1)) {
+            vkClearValues[clearValueCount++] = depthClear;
+        }
+    }
+
+    beginInfo.clearValueCount = clearValueCount;
+    beginInfo.pClearValues = vkClearValues;
+
+    vkCmdBeginRenderPass(m_CommandBuffer, &beginInfo,
+                         m_SecondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+                                             : VK_SUBPASS_CONTENTS_INLINE);
+    m_InsideRenderPass = true;
+    ++m_Stats.renderPasses;
+    m_InheritedRenderPass = renderPass;
+    m_InheritedFramebuffer = framebuffer;
+
+    // Where the render pass leaves them
+    if (vkTexture) {
+        m_Barriers.Assume(*vkTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, COLOR_ATTACHMENT_ACCESS,
+                                        renderPassKey.colorFinalLayout }, 0, 1, 0, layerCount);
+    }
+    if (vkResolveTexture) {
+        m_Barriers.Assume(*vkResolveTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, COLOR_ATTACHMENT_ACCESS,
+                                               renderPassKey.colorFinalLayout }, 0, 1, 0, layerCount);
+    }
+    if (vkDepthTexture) {
+        m_Barriers.Assume(*vkDepthTexture, { DEPTH_ATTACHMENT_STAGES, DEPTH_ATTACHMENT_ACCESS,
+                                             renderPassKey.depthFinalLayout }, 0, 1, 0, layerCount);
+    }
+}
+
+void VulkanCommandBuffer::BeginDynamicRendering(const Ref<VulkanTexture>& colorTexture,
+                                                const Ref<VulkanTexture>& depthTexture,
+                                                const Ref<VulkanTexture>& resolveTexture,
+                                                const Ref<VulkanTexture>& shadingRateTexture,
+                                                uint32 width, uint32 height,
+                                                const VkClearValue& colorClear,
+                                                const VkClearValue& depthClear,
+                                                const RenderPassActions& actions) {
+    // Without a render pass there are no implicit layout transitions; attachments that are
+    // not loaded and resolve targets drop their contents
+    bool load = actions.colorLoad == LoadOp::Load;
+    bool loadDepth = actions.depthLoad == LoadOp::Load;
+    uint32 layerCount = std::max(actions.viewCount, 1u);
+
+    VkRenderingAttachmentInfoKHR colorInfo{};
+    VkRenderingAttachmentInfoKHR depthInfo{};
+
+    if (colorTexture) {
+        m_Barriers.Use(*colorTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, COLOR_ATTACHMENT_ACCESS,
+                                        VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }, !load, 0, 1, 0, layerCount);
+
+        colorInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        colorInfo.imageView = colorTexture->GetAttachmentView();
+        colorInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+        colorInfo.loadOp = ToVulkanLoadOp(actions.colorLoad);
+        colorInfo.storeOp = IsStored(actions.colorStore, colorTexture->IsTransient(), resolveTexture != nullptr)
+                                ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorInfo.clearValue = colorClear;
+
+        m_DynamicColorTexture = colorTexture.get();
+    }
+
+    // Written by the resolve as the pass ends, averaging the samples
+    if (colorTexture && resolveTexture) {
+        m_Barriers.Use(*resolveTexture, { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                                          VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+                                          VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL }, true, 0, 1, 0, layerCount);
+
+        colorInfo.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT_KHR;
+        colorInfo.resolveImageView = resolveTexture->GetAttachmentView();
+        colorInfo.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        m_DynamicResolveTexture = resolveTexture.get();
+    }
+
+    if (depthTexture) {
+        m_Barriers.Use(*depthTexture, { DEPTH_ATTACHMENT_STAGES, DEPTH_ATTACHMENT_ACCESS,
+                                        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL }, !loadDepth, 0, 1, 0, layerCount);
+
+        depthInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+        depthInfo.imageView = depthTexture->GetAttachmentView();
+        depthInfo.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        depthInfo.loadOp = ToVulkanLoadOp(actions.depthLoad);
+        depthInfo.storeOp = IsStored(actions.depthStore, depthTexture->IsTransient(), false)
+                                ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthInfo.clearValue = depthClear;
+    }
+
+    if (shadingRateTexture) {
+        m_Barriers.Use(*shadingRateTexture, GetStateAccess(ResourceState::ShadingRate, shadingRateTexture.get()));
+    }
+    FlushBarriers();
+
+    VkRenderingInfoKHR renderingInfo{};
+    renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+    renderingInfo.renderArea.offset = { 0, 0 };
+    renderingInfo.renderArea.extent = { width, height };
+    renderingInfo.layerCount = 1;
+    renderingInfo.viewMask = m_InheritedViewMask;
+    if (m_SecondaryContents) {
+        renderingInfo.flags = VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR;
+    }
+    renderingInfo.colorAttachmentCount = colorTexture ? 1 : 0;
+    renderingInfo.pColorAttachments = colorTexture ? &colorInfo : nullptr;
+    if (depthTexture) {
+        renderingInfo.pDepthAttachment = &depthInfo;
+        VkFormat depthFormat = ToVulkanFormat(depthTexture->GetFormat());
+        if (GetDepthAspectMask(depthFormat) & VK_IMAGE_ASPECT_STENCIL_BIT) {
+            renderingInfo.pStencilAttachment = &depthInfo;
+        }
+    }
+
+    VkRenderingFragmentShadingRateAttachmentInfoKHR shadingRateInfo{};
+    if (shadingRateTexture) {
+        shadingRateInfo.sType = VK_STRUCTURE_TYPE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_INFO_KHR;
+        shadingRateInfo.imageView = shadingRateTexture->GetImageView();
+        shadingRateInfo.imageLayout = VK_IMAGE_LAYOUT_FRAGMENT_SHADING_RATE_ATTACHMENT_OPTIMAL_KHR;
+        shadingRateInfo.shadingRateAttachmentTexelSize = { m_Context.shadingRateTexelSize,
+                                                           m_Context.shadingRateTexelSize };
+        renderingInfo.pNext = &shadingRateInfo;
+    }
+
+    m_Context.cmdBeginRendering(m_CommandBuffer, &renderingInfo);
+    m_InsideRenderPass = true;
+    ++m_Stats.renderPasses;
 }
 
 void VulkanCommandBuffer::EndRendering() {
-    vkCmdEndRenderPass(m_CommandBuffer);
+    if (!m_InsideRenderPass) {
+        return;
+    }
+
+    if (!m_Context.dynamicRendering) {
+        vkCmdEndRenderPass(m_CommandBuffer);
+        m_InsideRenderPass = false;
+        return;
+    }
+
+    m_Context.cmdEndRendering(m_CommandBuffer);
+    m_InsideRenderPass = false;
+
+    // Match the render pass path's final layout: color attachments and resolve targets end
+    // in PRESENT_SRC. Depth stays in DEPTH_STENCIL_ATTACHMENT_OPTIMAL.
+    uint32 layerCount = std::max<uint32>(std::bit_width(m_InheritedViewMask), 1);
+    for (VulkanTexture* texture : { m_DynamicColorTexture, m_DynamicResolveTexture }) {
+        if (texture) {
+            m_Barriers.Use(*texture, GetStateAccess(ResourceState::Present, texture), false, 0, 1, 0, layerCount);
+        }
+    }
+    FlushBarriers();
+    m_DynamicColorTexture = nullptr;
+    m_DynamicResolveTexture = nullptr;
+}
+
+void VulkanCommandBuffer::BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                                 const Ref<Texture>& depthAttachment,
+                                                 std::span<const ClearValue> clearValues,
+                                                 uint32 secondaryCount,
+                                                 const RenderPassActions& actions,
+                                                 std::span<const Ref<Texture>> resolveTargets,
+                                                 const Ref<Texture>& shadingRate) {
+    m_SecondaryContents = true;
+    BeginRendering(colorAttachments, depthAttachment, clearValues, actions, resolveTargets, shadingRate);
+    m_SecondaryContents = false;
+
+    while (m_Secondaries.size() < secondaryCount) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        poolInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
+
+        Secondary secondary;
+        VK_CHECK(vkCreateCommandPool(m_Context.device, &poolInfo, nullptr, &secondary.pool));
+        secondary.commandBuffer = CreateRef<VulkanCommandBuffer>(m_Context, secondary.pool, this);
+        m_Secondaries.push_back(std::move(secondary));
+    }
+    m_ActiveSecondaryCount = secondaryCount;
 }
 
-void VulkanCommandBuffer::BindPipeline(Ref<Pipeline> pipeline) {
-    auto vkPipeline = std::static_pointer_cast<VulkanPipeline>(pipeline);
-    vkCmdBindPipeline(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, vkPipeline->GetHandle());
+Ref<CommandBuffer> VulkanCommandBuffer::GetSecondaryCommandBuffer(uint32 index) {
+    return index < m_ActiveSecondaryCount ? m_Secondaries[index].commandBuffer : nullptr;
+}
+
+void VulkanCommandBuffer::EndParallelRendering() {
+    if (m_InsideRenderPass && m_ActiveSecondaryCount > 0) {
+        std::vector<VkCommandBuffer> handles;
+        handles.reserve(m_ActiveSecondaryCount);
+        for (uint32 i = 0; i < m_ActiveSecondaryCount; ++i) {
+            handles.push_back(m_Secondaries[i].commandBuffer->GetHandle());
+            AddSecondaryStats(*m_Secondaries[i].commandBuffer);
+        }
+        vkCmdExecuteCommands(m_CommandBuffer, static_cast<uint32>(handles.size()), handles.data());
+    }
+    m_ActiveSecondaryCount = 0;
+    EndRendering();
+
+    // Executing secondaries leaves this command buffer's bound state undefined
+    InvalidateState();
+}
+
+// Layout of a graphics or compute pipeline
+static VkPipelineLayout GetPipelineLayout(const Ref<Pipeline>& pipeline) {
+    if (pipeline->GetBindPoint() == PipelineBindPoint::Compute) {
+        return std::static_pointer_cast<VulkanComputePipeline>(pipeline)->GetLayout();
+    }
+    return std::static_pointer_cast<VulkanPipeline>(pipeline)->GetLayout();
+}
+
+void VulkanCommandBuffer::BindPipeline(const Ref<Pipeline>& pipeline) {
+    VkPipeline handle;
+    if (pipeline->GetBindPoint() == PipelineBindPoint::Compute) {
+        m_BindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+        handle = std::static_pointer_cast<VulkanComputePipeline>(pipeline)->GetHandle();
+    } else {
+        m_BindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        handle = std::static_pointer_cast<VulkanPipeline>(pipeline)->GetHandle();
+    }
+
+    if (m_BoundPipelines[BindPointIndex()] == handle) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    vkCmdBindPipeline(m_CommandBuffer, m_BindPoint, handle);
+    ++m_Stats.pipelineBinds;
+    m_BoundPipelines[BindPointIndex()] = handle;
+
+    VkPipelineLayout layout = GetPipelineLayout(pipeline);
+    if (layout != m_PushConstantLayout) {
+        ResetPushConstantState(layout);
+    }
 }
 
 void VulkanCommandBuffer::SetViewport(const Viewport& viewport) {
@@ -207,43 +609,110 @@ void VulkanCommandBuffer::SetViewport(const Viewport& viewport) {
     vp.height = viewport.height;
     vp.minDepth = viewport.minDepth;
     vp.maxDepth = viewport.maxDepth;
-    
+
+    // Every pipeline declares viewport and scissor dynamic, so binds keep them
+    if (m_ViewportBound && std::memcmp(&m_BoundViewport, &viewport, sizeof(Viewport)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
     vkCmdSetViewport(m_CommandBuffer, 0, 1, &vp);
+    m_BoundViewport = viewport;
+    m_ViewportBound = true;
 }
 
 void VulkanCommandBuffer::SetScissor(const Rect2D& scissor) {
     VkRect2D sc{};
     sc.offset = { scissor.x, scissor.y };
     sc.extent = { scissor.width, scissor.height };
-    
+
+    if (m_ScissorBound && std::memcmp(&m_BoundScissor, &scissor, sizeof(Rect2D)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
     vkCmdSetScissor(m_CommandBuffer, 0, 1, &sc);
+    m_BoundScissor = scissor;
+    m_ScissorBound = true;
 }
 
-void VulkanCommandBuffer::BindVertexBuffer(Ref<Buffer> buffer, uint64 offset) {
+void VulkanCommandBuffer::BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
     auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(buffer);
     VkBuffer buffers[] = { vkBuffer->GetHandle() };
     VkDeviceSize offsets[] = { offset };
-    
+
+    if (buffers[0] == m_BoundVertexBuffer && offset == m_BoundVertexOffset) {
+        ++m_FilteredCallCount;
+        return;
+    }
     vkCmdBindVertexBuffers(m_CommandBuffer, 0, 1, buffers, offsets);
+    m_BoundVertexBuffer = buffers[0];
+    m_BoundVertexOffset = offset;
 }
 
-void VulkanCommandBuffer::BindIndexBuffer(Ref<Buffer> buffer, uint64 offset) {
-    auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(buffer);
-    vkCmdBindIndexBuffer(m_CommandBuffer, vkBuffer->GetHandle(), offset, VK_INDEX_TYPE_UINT32);
+void VulkanCommandBuffer::BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
+    VkBuffer handle = std::static_pointer_cast<VulkanBuffer>(buffer)->GetHandle();
+    if (handle == m_BoundIndexBuffer && offset == m_BoundIndexOffset) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    vkCmdBindIndexBuffer(m_CommandBuffer, handle, offset, VK_INDEX_TYPE_UINT32);
+    m_BoundIndexBuffer = handle;
+    m_BoundIndexOffset = offset;
 }
 
 void VulkanCommandBuffer::Draw(uint32 vertexCount, uint32 instanceCount,
                               uint32 firstVertex, uint32 firstInstance) {
     vkCmdDraw(m_CommandBuffer, vertexCount, instanceCount, firstVertex, firstInstance);
+    CountDraw(vertexCount, instanceCount);
 }
 
 void VulkanCommandBuffer::DrawIndexed(uint32 indexCount, uint32 instanceCount,
                                      uint32 firstIndex, int32 vertexOffset,
                                      uint32 firstInstance) {
     vkCmdDrawIndexed(m_CommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    CountDraw(indexCount, instanceCount);
+}
+
+void VulkanCommandBuffer::DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                                              uint32 stride) {
+    VkBuffer buffer = std::static_pointer_cast<VulkanBuffer>(argumentBuffer)->GetHandle();
+    ++m_Stats.drawCalls;
+    if (m_Context.multiDrawIndirect || drawCount <= 1) {
+        vkCmdDrawIndexedIndirect(m_CommandBuffer, buffer, offset, drawCount, stride);
+        return;
+    }
+
+    // Without multiDrawIndirect each call may only read one command
+    for (uint32 i = 0; i < drawCount; ++i) {
+        vkCmdDrawIndexedIndirect(m_CommandBuffer, buffer, offset + static_cast<uint64>(i) * stride, 1, stride);
+    }
 }
 
-void VulkanCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+void VulkanCommandBuffer::DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                                   const Ref<Buffer>& countBuffer, uint64 countOffset,
+                                                   uint32 maxDrawCount, uint32 stride) {
+    if (!m_Context.cmdDrawIndexedIndirectCount) {
+        DrawIndexedIndirect(argumentBuffer, offset, maxDrawCount, stride);
+        return;
+    }
+
+    m_Context.cmdDrawIndexedIndirectCount(m_CommandBuffer,
+                                          std::static_pointer_cast<VulkanBuffer>(argumentBuffer)->GetHandle(), offset,
+                                          std::static_pointer_cast<VulkanBuffer>(countBuffer)->GetHandle(), countOffset,
+                                          maxDrawCount, stride);
+    ++m_Stats.drawCalls;
+}
+
+void VulkanCommandBuffer::Dispatch(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ) {
+    vkCmdDispatch(m_CommandBuffer, groupCountX, groupCountY, groupCountZ);
+    ++m_Stats.dispatches;
+}
+
+void VulkanCommandBuffer::DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset) {
+    vkCmdDispatchIndirect(m_CommandBuffer, std::static_pointer_cast<VulkanBuffer>(argumentBuffer)->GetHandle(), offset);
+    ++m_Stats.dispatches;
+}
+
+void VulkanCommandBuffer::CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                                     uint64 size, uint64 srcOffset, uint64 dstOffset) {
     auto vkSrc = std::static_pointer_cast<VulkanBuffer>(src);
     auto vkDst = std::static_pointer_cast<VulkanBuffer>(dst);
@@ -256,14 +725,99 @@ void VulkanCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
     vkCmdCopyBuffer(m_CommandBuffer, vkSrc->GetHandle(), vkDst->GetHandle(), 1, &copyRegion);
 }
 
-void VulkanCommandBuffer::BindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet descriptorSet) {
-    vkCmdBindDescriptorSets(m_CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS,
-                           layout, 0, 1, &descriptorSet, 0, nullptr);
+void VulkanCommandBuffer::CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset) {
+    auto vkSrc = std::static_pointer_cast<VulkanTexture>(src);
+    auto vkDst = std::static_pointer_cast<VulkanBuffer>(dst);
+    FormatInfo info = GetFormatInfo(src->GetFormat());
+
+    // Barriers the caller already recorded drop out here
+    m_Barriers.Use(*vkSrc, GetStateAccess(ResourceState::TransferRead, vkSrc.get()));
+    m_Barriers.Use(*vkDst, GetStateAccess(ResourceState::TransferWrite, nullptr));
+    FlushBarriers();
+
+    VkBufferImageCopy region{};
+    region.bufferOffset = dstOffset;
+    region.bufferRowLength = GetReadbackRowPitch(src->GetFormat(), src->GetWidth()) / info.blockSize * info.blockWidth;
+    region.imageSubresource.aspectMask = vkSrc->GetAspectMask();
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { src->GetWidth(), src->GetHeight(), 1 };
+    vkCmdCopyImageToBuffer(m_CommandBuffer, vkSrc->GetImage(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                           vkDst->GetHandle(), 1, &region);
+
+    // The fence wait that precedes the map covers device accesses only
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(m_CommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier,
+                         0, nullptr, 0, nullptr);
+    ++m_Stats.pipelineBarriers;
+}
+
+void VulkanCommandBuffer::BindDescriptorSet(VkPipelineLayout layout, uint32 setIndex, VkDescriptorSet descriptorSet,
+                                            const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    if (setIndex >= MAX_DESCRIPTOR_SETS) {
+        METAGFX_ERROR << "Descriptor set " << setIndex << " is beyond MAX_DESCRIPTOR_SETS";
+        return;
+    }
+
+    // Same set through the same layout: binding pipelines in between does not disturb it
+    uint32 point = BindPointIndex();
+    if (m_BoundSets[point][setIndex] == descriptorSet && m_BoundSetLayouts[point][setIndex] == layout &&
+        m_BoundOffsets[point][setIndex].Matches(dynamicOffsets, dynamicOffsetCount)) {
+        ++m_FilteredCallCount;
+        return;
+    }
+
+    vkCmdBindDescriptorSets(m_CommandBuffer, m_BindPoint,
+                           layout, setIndex, 1, &descriptorSet, dynamicOffsetCount, dynamicOffsets);
+    ++m_Stats.descriptorSetBinds;
+    bool tracked = m_BoundOffsets[point][setIndex].Assign(dynamicOffsets, dynamicOffsetCount);
+    m_BoundSets[point][setIndex] = tracked ? descriptorSet : VK_NULL_HANDLE;
+    m_BoundSetLayouts[point][setIndex] = layout;
+
+    // Sets bound through another layout may be disturbed, unless it is compatible for
+    // them; rather than compare set layouts, those are bound again when next used
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (m_BoundSetLayouts[point][set] != layout) {
+            m_BoundSets[point][set] = VK_NULL_HANDLE;
+        }
+    }
 }
 
 void VulkanCommandBuffer::PushConstants(VkPipelineLayout layout, VkShaderStageFlags stageFlags,
                                        uint32 offset, uint32 size, const void* data) {
+    if (offset + size > MAX_PUSH_CONSTANT_SIZE) {
+        vkCmdPushConstants(m_CommandBuffer, layout, stageFlags, offset, size, data);
+        ++m_Stats.pushConstantCalls;
+        return;
+    }
+    if (layout != m_PushConstantLayout) {
+        ResetPushConstantState(layout);
+    }
+
+    const uint8* bytes = static_cast<const uint8*>(data);
+    bool redundant = true;
+    for (uint32 i = 0; i < size && redundant; ++i) {
+        redundant = (m_PushConstantStages[offset + i] & stageFlags) == stageFlags &&
+                    m_PushConstantData[offset + i] == bytes[i];
+    }
+    if (redundant) {
+        ++m_FilteredCallCount;
+        return;
+    }
+
     vkCmdPushConstants(m_CommandBuffer, layout, stageFlags, offset, size, data);
+    ++m_Stats.pushConstantCalls;
+    for (uint32 i = 0; i < size; ++i) {
+        // A changed byte is now known only for the stages just written
+        if (m_PushConstantData[offset + i] != bytes[i]) {
+            m_PushConstantData[offset + i] = bytes[i];
+            m_PushConstantStages[offset + i] = stageFlags;
+        } else {
+            m_PushConstantStages[offset + i] |= stageFlags;
+        }
+    }
 }
 
 void VulkanCommandBuffer::BufferMemoryBarrier(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
@@ -288,20 +842,131 @@ void VulkanCommandBuffer::BufferMemoryBarrier(VkBuffer buffer, VkDeviceSize offs
         1, &barrier,
         0, nullptr
     );
+    ++m_Stats.pipelineBarriers;
 }
 
 // Abstract interface implementations
-void VulkanCommandBuffer::BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                                            uint32 frameIndex) {
-    auto vkPipeline = std::static_pointer_cast<VulkanPipeline>(pipeline);
-    VkDescriptorSet vkDescSet = static_cast<VkDescriptorSet>(descriptorSet->GetNativeHandle(frameIndex));
-    BindDescriptorSet(vkPipeline->GetLayout(), vkDescSet);
+void VulkanCommandBuffer::BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                            const Ref<DescriptorSet>& descriptorSet, uint32 frameIndex,
+                                            const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    auto vkDescriptorSet = std::static_pointer_cast<VulkanDescriptorSet>(descriptorSet);
+    if (vkDescriptorSet->IsPushDescriptorSet()) {
+        METAGFX_ERROR << "BindDescriptorSet: set " << setIndex << " is a push descriptor set (PushDescriptorSet)";
+        return;
+    }
+
+    // Write any bindings changed since this frame's set was last used
+    vkDescriptorSet->FlushUpdates(frameIndex);
+
+    VkDescriptorSet vkDescSet = vkDescriptorSet->GetSet(frameIndex);
+    BindDescriptorSet(GetPipelineLayout(pipeline), setIndex, vkDescSet, dynamicOffsets, dynamicOffsetCount);
 }
 
-void VulkanCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
-                                        uint32 offset, uint32 size, const void* data) {
-    auto vkPipeline = std::static_pointer_cast<VulkanPipeline>(pipeline);
+void VulkanCommandBuffer::PushDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                            const std::vector<DescriptorBindingDesc>& bindings,
+                                            const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    if (!m_Context.cmdPushDescriptorSet) {
+        CommandBuffer::PushDescriptorSet(pipeline, setIndex, bindings, dynamicOffsets, dynamicOffsetCount);
+        return;
+    }
+    if (setIndex >= MAX_DESCRIPTOR_SETS) {
+        METAGFX_ERROR << "Descriptor set " << setIndex << " is beyond MAX_DESCRIPTOR_SETS";
+        return;
+    }
+
+    // Infos are reserved up front, as the writes point into them
+    std::vector<VkWriteDescriptorSet> writes;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    writes.reserve(bindings.size());
+    bufferInfos.reserve(bindings.size());
+    imageInfos.reserve(bindings.size());
+
+    uint32 dynamicIndex = 0;
+    for (const DescriptorBindingDesc& binding : bindings) {
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstBinding = binding.binding;
+        write.descriptorCount = 1;
+        write.descriptorType = VulkanDescriptorSet::ToVulkanDescriptorType(binding.type);
+
+        switch (binding.type) {
+            case DescriptorType::UniformBuffer:
+            case DescriptorType::UniformBufferDynamic:
+            case DescriptorType::StorageBuffer: {
+                if (!binding.buffer) {
+                    continue;
+                }
+                auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(binding.buffer);
+                VkDescriptorBufferInfo bufferInfo{};
+                bufferInfo.buffer = vkBuffer->GetHandle();
+                bufferInfo.range = binding.range > 0 ? binding.range : vkBuffer->GetSize();
+                if (binding.type == DescriptorType::UniformBufferDynamic) {
+                    bufferInfo.offset = dynamicIndex < dynamicOffsetCount ? dynamicOffsets[dynamicIndex] : 0;
+                    ++dynamicIndex;
+                    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+                }
+                bufferInfos.push_back(bufferInfo);
+                write.pBufferInfo = &bufferInfos.back();
+                break;
+            }
+            case DescriptorType::SampledTexture:
+            case DescriptorType::StorageTexture: {
+                bool sampled = binding.type == DescriptorType::SampledTexture;
+                if (!binding.texture || (sampled && !binding.sampler)) {
+                    continue;
+                }
+                auto vkTexture = std::static_pointer_cast<VulkanTexture>(binding.texture);
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.imageView = vkTexture->GetImageView();
+                imageInfo.imageLayout = sampled ? vkTexture->GetShaderReadLayout() : VK_IMAGE_LAYOUT_GENERAL;
+                if (sampled) {
+                    imageInfo.sampler = std::static_pointer_cast<VulkanSampler>(binding.sampler)->GetHandle();
+                }
+                imageInfos.push_back(imageInfo);
+                write.pImageInfo = &imageInfos.back();
+                break;
+            }
+            case DescriptorType::Sampler: {
+                if (!binding.sampler) {
+                    continue;
+                }
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.sampler = std::static_pointer_cast<VulkanSampler>(binding.sampler)->GetHandle();
+                imageInfos.push_back(imageInfo);
+                write.pImageInfo = &imageInfos.back();
+                break;
+            }
+            default:
+                METAGFX_ERROR << "PushDescriptorSet: binding " << binding.binding << " cannot be pushed";
+                continue;
+        }
+        writes.push_back(write);
+    }
+    if (writes.empty()) {
+        return;
+    }
+
+    VkPipelineLayout layout = GetPipelineLayout(pipeline);
+    m_Context.cmdPushDescriptorSet(m_CommandBuffer, m_BindPoint, layout, setIndex,
+                                   static_cast<uint32>(writes.size()), writes.data());
+    ++m_Stats.descriptorSetBinds;
+    m_Context.stats->AddDescriptorUpdates(static_cast<uint32>(writes.size()));
+
+    // The pushed set replaces whatever was bound there; sets bound through another
+    // layout may be disturbed, as in BindDescriptorSet()
+    uint32 point = BindPointIndex();
+    m_BoundSets[point][setIndex] = VK_NULL_HANDLE;
+    m_BoundSetLayouts[point][setIndex] = layout;
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (m_BoundSetLayouts[point][set] != layout) {
+            m_BoundSets[point][set] = VK_NULL_HANDLE;
+        }
+    }
+}
 
+void VulkanCommandBuffer::PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
+                                        uint32 offset, uint32 size, const void* data) {
     // Convert ShaderStage to VkShaderStageFlags
     VkShaderStageFlags vkStages = 0;
     if (static_cast<int>(stages) & static_cast<int>(ShaderStage::Vertex))
@@ -311,20 +976,234 @@ void VulkanCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stag
     if (static_cast<int>(stages) & static_cast<int>(ShaderStage::Compute))
         vkStages |= VK_SHADER_STAGE_COMPUTE_BIT;
 
-    PushConstants(vkPipeline->GetLayout(), vkStages, offset, size, data);
+    PushConstants(GetPipelineLayout(pipeline), vkStages, offset, size, data);
 }
 
-void VulkanCommandBuffer::BufferMemoryBarrier(Ref<Buffer> buffer) {
+void VulkanCommandBuffer::BufferMemoryBarrier(const Ref<Buffer>& buffer) {
+    // Host writes are visible to the submission without one; only GPU writes recorded
+    // earlier (see ResourceBarrier()) need a barrier
     auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(buffer);
-    BufferMemoryBarrier(
-        vkBuffer->GetHandle(),
-        0,
-        vkBuffer->GetSize(),
-        VK_PIPELINE_STAGE_HOST_BIT,
-        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-        VK_ACCESS_HOST_WRITE_BIT,
-        VK_ACCESS_UNIFORM_READ_BIT
-    );
+    m_Barriers.Use(*vkBuffer, GetStateAccess(ResourceState::ShaderRead, nullptr));
+    FlushBarriers();
+}
+
+bool VulkanCommandBuffer::WriteTimestamp(VkQueryPool queryPool, uint32 query) {
+    if (m_Primary || m_ActiveSecondaryCount > 0) {
+        return false;
+    }
+    vkCmdWriteTimestamp(m_CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, query);
+    return true;
+}
+
+void VulkanCommandBuffer::PipelineBarrier(BarrierType type) {
+    // Global memory barrier: storage images stay in GENERAL, so no layout transitions
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    VkPipelineStageFlags srcStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkPipelineStageFlags dstStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+
+    switch (type) {
+        case BarrierType::ComputeToCompute:
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            break;
+        case BarrierType::ComputeToGraphics:
+            dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT |
+                       VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT |
+                                    VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+                                    VK_ACCESS_SHADER_READ_BIT;
+            break;
+        case BarrierType::ComputeToIndirect:
+            dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT;
+            break;
+        case BarrierType::GraphicsToCompute:
+            srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT |
+                       VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+                                    VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+            break;
+        case BarrierType::GraphicsToTransfer:
+            // Write-after-read: an execution dependency is enough
+            srcStage = VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+            dstStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = 0;
+            break;
+        case BarrierType::TransferToGraphics:
+            srcStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            dstStage = VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+            break;
+    }
+
+    vkCmdPipelineBarrier(m_CommandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    ++m_Stats.pipelineBarriers;
+}
+
+void VulkanCommandBuffer::ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                                          const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) {
+    // The batch knows what the textures and buffers were last used as; the before states
+    // only say whether contents may be discarded
+    for (uint32 i = 0; i < textureBarrierCount; ++i) {
+        auto texture = std::static_pointer_cast<VulkanTexture>(textureBarriers[i].texture);
+        m_Barriers.Use(*texture, GetStateAccess(textureBarriers[i].after, texture.get()),
+                       textureBarriers[i].before == ResourceState::Undefined);
+    }
+    for (uint32 i = 0; i < bufferBarrierCount; ++i) {
+        auto buffer = std::static_pointer_cast<VulkanBuffer>(bufferBarriers[i].buffer);
+        m_Barriers.Use(*buffer, GetStateAccess(bufferBarriers[i].after, nullptr));
+    }
+    FlushBarriers();
+}
+
+void VulkanCommandBuffer::AccelerationStructureBarrier(VkPipelineStageFlags srcStage, VkAccessFlags srcAccess,
+                                                       VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    VkMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstAccessMask = dstAccess;
+    vkCmdPipelineBarrier(m_CommandBuffer, srcStage, dstStage, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+    ++m_Stats.pipelineBarriers;
+}
+
+void VulkanCommandBuffer::BuildAccelerationStructures(std::span<const AccelerationStructureBuild> builds) {
+    if (!m_Context.accelerationStructure || builds.empty()) {
+        return;
+    }
+    constexpr VkPipelineStageFlags BUILD_STAGE = VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+    constexpr VkAccessFlags BUILD_ACCESS =
+        VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+    constexpr VkPipelineStageFlags TRACE_STAGES =
+        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    const VkDeviceSize alignment = m_Context.accelerationStructureScratchAlignment;
+
+    // Bottom levels (0), then top levels (1). The levels run one after the other, so they
+    // share the batch scratch.
+    struct PreparedBuild {
+        VulkanAccelerationStructure* structure = nullptr;
+        VkAccelerationStructureBuildGeometryInfoKHR info{};
+        const VkAccelerationStructureBuildRangeInfoKHR* ranges = nullptr;
+        VkDeviceSize scratchOffset = 0;
+    };
+    std::vector<PreparedBuild> levels[2];
+    VkDeviceSize scratchSizes[2] = {};
+    bool compaction[2] = {};
+    FlushBarriers();
+    for (const AccelerationStructureBuild& build : builds) {
+        PreparedBuild prepared;
+        prepared.structure = static_cast<VulkanAccelerationStructure*>(build.structure);
+        if (!prepared.structure || !prepared.structure->PrepareBuild(build, prepared.info, prepared.ranges)) {
+            continue;
+        }
+        uint32 level = prepared.structure->GetType() == AccelerationStructureType::TopLevel ? 1 : 0;
+        prepared.scratchOffset = scratchSizes[level];
+        scratchSizes[level] += (prepared.structure->GetBatchScratchSize(prepared.info) + alignment - 1) /
+                               alignment * alignment;
+        if (VkQueryPool queries = prepared.structure->GetCompactionQueryPool()) {
+            vkCmdResetQueryPool(m_CommandBuffer, queries, 0, 1);
+            compaction[level] = true;
+        }
+        levels[level].push_back(prepared);
+    }
+    if (levels[0].empty() && levels[1].empty()) {
+        return;
+    }
+
+    VkDeviceAddress scratchAddress = 0;
+    VkDeviceSize scratchSize = std::max(scratchSizes[0], scratchSizes[1]);
+    if (scratchSize > 0) {
+        auto scratch = CreateScope<VulkanAccelerationStructureBuffer>(
+            m_Context, scratchSize + alignment - 1, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        if (!scratch->IsValid()) {
+            return;
+        }
+        scratchAddress = (scratch->GetAddress() + alignment - 1) / alignment * alignment;
+        m_BuildScratch.push_back(std::move(scratch));
+    }
+
+    // Earlier traces may still read the structures, earlier builds write what these read
+    AccelerationStructureBarrier(BUILD_STAGE | TRACE_STAGES, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                                 BUILD_STAGE, BUILD_ACCESS);
+
+    std::vector<VkAccelerationStructureBuildGeometryInfoKHR> infos;
+    std::vector<const VkAccelerationStructureBuildRangeInfoKHR*> ranges;
+    for (uint32 level = 0; level < 2; ++level) {
+        if (levels[level].empty()) {
+            continue;
+        }
+        infos.clear();
+        ranges.clear();
+        for (PreparedBuild& prepared : levels[level]) {
+            VkDeviceAddress ownScratch = prepared.structure->GetScratchAddress();
+            prepared.info.scratchData.deviceAddress = ownScratch != 0 ? ownScratch
+                                                                      : scratchAddress + prepared.scratchOffset;
+            infos.push_back(prepared.info);
+            ranges.push_back(prepared.ranges);
+        }
+        m_Context.cmdBuildAccelerationStructures(m_CommandBuffer, static_cast<uint32>(infos.size()),
+                                                 infos.data(), ranges.data());
+
+        // The top levels read the bottom levels and reuse their scratch; compacted sizes
+        // are read from the finished structures
+        if (compaction[level] || (level == 0 && !levels[1].empty())) {
+            AccelerationStructureBarrier(BUILD_STAGE, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                                         BUILD_STAGE, BUILD_ACCESS);
+        }
+        for (PreparedBuild& prepared : levels[level]) {
+            VkQueryPool queries = prepared.structure->GetCompactionQueryPool();
+            if (queries != VK_NULL_HANDLE) {
+                VkAccelerationStructureKHR handle = prepared.structure->GetHandle();
+                m_Context.cmdWriteAccelerationStructuresProperties(
+                    m_CommandBuffer, 1, &handle, VK_QUERY_TYPE_ACCELERATION_STRUCTURE_COMPACTED_SIZE_KHR, queries, 0);
+            }
+            prepared.structure->MarkBuilt(queries != VK_NULL_HANDLE);
+        }
+    }
+
+    AccelerationStructureBarrier(BUILD_STAGE, VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                                 BUILD_STAGE | TRACE_STAGES, BUILD_ACCESS);
+}
+
+Ref<AccelerationStructure> VulkanCommandBuffer::CompactAccelerationStructure(const Ref<AccelerationStructure>& source) {
+    auto vkSource = std::static_pointer_cast<VulkanAccelerationStructure>(source);
+    if (!vkSource || !vkSource->IsBuilt()) {
+        return nullptr;
+    }
+    uint64 compactedSize = vkSource->GetCompactedSize();
+    if (compactedSize == 0) {
+        return nullptr;
+    }
+    auto target = CreateRef<VulkanAccelerationStructure>(m_Context, source->GetDesc(), compactedSize);
+    if (!target->IsValid()) {
+        return nullptr;
+    }
+
+    // The size is known, so the source's build has finished on the GPU
+    FlushBarriers();
+    VkCopyAccelerationStructureInfoKHR copyInfo{};
+    copyInfo.sType = VK_STRUCTURE_TYPE_COPY_ACCELERATION_STRUCTURE_INFO_KHR;
+    copyInfo.src = vkSource->GetHandle();
+    copyInfo.dst = target->GetHandle();
+    copyInfo.mode = VK_COPY_ACCELERATION_STRUCTURE_MODE_COMPACT_KHR;
+    m_Context.cmdCopyAccelerationStructure(m_CommandBuffer, &copyInfo);
+    AccelerationStructureBarrier(VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                                 VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR,
+                                 VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR |
+                                     VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                                 VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR);
+    target->MarkBuilt(false);
+    return target;
+}
+
+void VulkanCommandBuffer::FlushBarriers() {
+    if (m_Barriers.Flush(m_CommandBuffer)) {
+        ++m_Stats.pipelineBarriers;
+    }
 }
 
 } // namespace rhi
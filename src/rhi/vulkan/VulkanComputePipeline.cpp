@@ -0,0 +1,55 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanComputePipeline.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanComputePipeline.h"
+#include "metagfx/rhi/vulkan/VulkanDescriptorCache.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineCache.h"
+#include "metagfx/rhi/vulkan/VulkanShader.h"
+
+namespace metagfx {
+namespace rhi {
+
+VulkanComputePipeline::VulkanComputePipeline(VulkanContext& context, const ComputePipelineDesc& desc,
+                                             VkDescriptorSetLayout descriptorSetLayout)
+    : m_Context(context) {
+
+    auto computeShader = std::static_pointer_cast<VulkanShader>(desc.computeShader);
+
+    VkPipelineShaderStageCreateInfo stageInfo{};
+    stageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stageInfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+    stageInfo.module = computeShader->GetModule();
+    stageInfo.pName = computeShader->GetEntryPoint().c_str();
+
+    // Any push constants get the whole guaranteed 128 bytes, so every compute pipeline over
+    // a set layout shares one pipeline layout
+    VulkanPipelineLayoutKey layoutKey;
+    layoutKey.setLayouts = { descriptorSetLayout };
+    layoutKey.pushConstantStages = desc.pushConstantSize > 0 ? VK_SHADER_STAGE_COMPUTE_BIT : 0;
+    layoutKey.pushConstantSize = desc.pushConstantSize > 0 ? 128 : 0;
+    m_Layout = m_Context.descriptorCache->GetPipelineLayout(layoutKey);
+
+    VkComputePipelineCreateInfo pipelineInfo{};
+    pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+    pipelineInfo.stage = stageInfo;
+    pipelineInfo.layout = m_Layout;
+
+    VkPipelineCache cache = m_Context.pipelineCache ? m_Context.pipelineCache->GetHandle() : VK_NULL_HANDLE;
+    VK_CHECK(vkCreateComputePipelines(m_Context.device, cache, 1, &pipelineInfo, nullptr, &m_Pipeline));
+    if (m_Context.pipelineCache) {
+        m_Context.pipelineCache->MarkDirty();
+    }
+
+    METAGFX_DEBUG << "Vulkan compute pipeline created" << (desc.debugName ? ": " : "")
+                  << (desc.debugName ? desc.debugName : "");
+}
+
+VulkanComputePipeline::~VulkanComputePipeline() {
+    if (m_Pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(m_Context.device, m_Pipeline, nullptr);
+    }
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,300 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanDescriptorCache.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanDescriptorCache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace metagfx {
+namespace rhi {
+
+// Boost-style hash combine
+template<typename T>
+static void HashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// Descriptors of a type per set in shared pools; a set needing over a quarter of the
+// smallest pool's share of a type gets a pool of its own
+static uint32 GetSharedPoolRatio(VkDescriptorType type) {
+    switch (type) {
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER: return 2;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC: return 1;
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER: return 4;
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: return 8;
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE: return 2;
+        case VK_DESCRIPTOR_TYPE_SAMPLER: return 1;
+        case VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR: return 1;
+        default: return 0;
+    }
+}
+
+size_t VulkanSetLayoutKeyHash::operator()(const VulkanSetLayoutKey& key) const {
+    size_t seed = 0;
+    for (const auto& binding : key.bindings) {
+        HashCombine(seed, binding.binding);
+        HashCombine(seed, static_cast<uint32>(binding.type));
+        HashCombine(seed, binding.count);
+        HashCombine(seed, static_cast<uint32>(binding.stages));
+    }
+    HashCombine(seed, key.pushDescriptors);
+    return seed;
+}
+
+size_t VulkanPipelineLayoutKeyHash::operator()(const VulkanPipelineLayoutKey& key) const {
+    size_t seed = 0;
+    for (VkDescriptorSetLayout setLayout : key.setLayouts) {
+        HashCombine(seed, setLayout);
+    }
+    HashCombine(seed, static_cast<uint32>(key.pushConstantStages));
+    HashCombine(seed, key.pushConstantSize);
+    return seed;
+}
+
+VulkanDescriptorCache::VulkanDescriptorCache(VulkanContext& context)
+    : m_Context(context) {
+}
+
+VulkanDescriptorCache::~VulkanDescriptorCache() {
+    for (const Pool& pool : m_Pools) {
+        if (pool.liveSets > 0) {
+            METAGFX_WARN << "VulkanDescriptorCache: destroying a descriptor pool with " << pool.liveSets
+                         << " sets still allocated";
+        }
+        vkDestroyDescriptorPool(m_Context.device, pool.pool, nullptr);
+    }
+    for (const auto& [key, layout] : m_PipelineLayouts) {
+        vkDestroyPipelineLayout(m_Context.device, layout, nullptr);
+    }
+    for (const auto& [key, layout] : m_SetLayouts) {
+        vkDestroyDescriptorSetLayout(m_Context.device, layout, nullptr);
+    }
+}
+
+VkDescriptorSetLayout VulkanDescriptorCache::GetSetLayout(const VulkanSetLayoutKey& key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return GetSetLayoutLocked(key);
+}
+
+VkDescriptorSetLayout VulkanDescriptorCache::GetSetLayoutLocked(const VulkanSetLayoutKey& key) {
+    auto it = m_SetLayouts.find(key);
+    if (it != m_SetLayouts.end()) {
+        return it->second;
+    }
+
+    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    std::vector<VkDescriptorBindingFlags> bindingFlags;
+    bool hasTextureTable = false;
+    for (const auto& binding : key.bindings) {
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding = binding.binding;
+        layoutBinding.descriptorType = binding.type;
+        layoutBinding.descriptorCount = binding.count;
+        layoutBinding.stageFlags = binding.stages;
+        layoutBindings.push_back(layoutBinding);
+
+        // Texture tables only get the elements materials actually use written
+        bool isTable = binding.count > 1;
+        bindingFlags.push_back(isTable ? VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT : 0);
+        hasTextureTable |= isTable;
+    }
+
+    VkDescriptorSetLayoutCreateInfo layoutInfo{};
+    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+    layoutInfo.bindingCount = static_cast<uint32>(layoutBindings.size());
+    layoutInfo.pBindings = layoutBindings.data();
+    if (key.pushDescriptors) {
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+    }
+
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+    bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+    bindingFlagsInfo.bindingCount = static_cast<uint32>(bindingFlags.size());
+    bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+
+    if (hasTextureTable) {
+        if (m_Context.descriptorIndexing) {
+            layoutInfo.pNext = &bindingFlagsInfo;
+        } else {
+            METAGFX_ERROR << "VulkanDescriptorCache: texture arrays require descriptor indexing; "
+                          << "every element must be written before use";
+        }
+    }
+
+    VkDescriptorSetLayout layout = VK_NULL_HANDLE;
+    VK_CHECK(vkCreateDescriptorSetLayout(m_Context.device, &layoutInfo, nullptr, &layout));
+    m_SetLayouts.emplace(key, layout);
+    return layout;
+}
+
+VkPipelineLayout VulkanDescriptorCache::GetPipelineLayout(const VulkanPipelineLayoutKey& key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_PipelineLayouts.find(key);
+    if (it != m_PipelineLayouts.end()) {
+        return it->second;
+    }
+
+    VkPushConstantRange pushConstantRange{};
+    pushConstantRange.stageFlags = key.pushConstantStages;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = key.pushConstantSize;
+
+    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    if (!key.setLayouts.empty()) {
+        pipelineLayoutInfo.setLayoutCount = static_cast<uint32>(key.setLayouts.size());
+        pipelineLayoutInfo.pSetLayouts = key.setLayouts.data();
+    }
+    if (key.pushConstantSize > 0) {
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+    }
+
+    VkPipelineLayout layout = VK_NULL_HANDLE;
+    VK_CHECK(vkCreatePipelineLayout(m_Context.device, &pipelineLayoutInfo, nullptr, &layout));
+    m_PipelineLayouts.emplace(key, layout);
+    return layout;
+}
+
+std::vector<VkDescriptorPoolSize> VulkanDescriptorCache::GetSharedPoolSizes(uint32 maxSets) const {
+    static const VkDescriptorType TYPES[] = {
+        VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
+        VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLER,
+        VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR,
+    };
+    std::vector<VkDescriptorPoolSize> sizes;
+    for (VkDescriptorType type : TYPES) {
+        if (type == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR && !m_Context.accelerationStructure) {
+            continue;
+        }
+        sizes.push_back({ type, GetSharedPoolRatio(type) * maxSets });
+    }
+    return sizes;
+}
+
+VkDescriptorPool VulkanDescriptorCache::CreatePool(uint32 maxSets, const std::vector<VkDescriptorPoolSize>& sizes,
+                                                   bool dedicated) {
+    // Sets are freed one by one as their owners go, so pools are reused instead of reset
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.poolSizeCount = static_cast<uint32>(sizes.size());
+    poolInfo.pPoolSizes = sizes.data();
+    poolInfo.maxSets = maxSets;
+
+    Pool pool;
+    pool.maxSets = maxSets;
+    pool.dedicated = dedicated;
+    if (vkCreateDescriptorPool(m_Context.device, &poolInfo, nullptr, &pool.pool) != VK_SUCCESS) {
+        METAGFX_ERROR << "VulkanDescriptorCache: failed to create a descriptor pool of " << maxSets << " sets";
+        return VK_NULL_HANDLE;
+    }
+    m_Pools.push_back(pool);
+    return pool.pool;
+}
+
+bool VulkanDescriptorCache::TryAllocate(Pool& pool, VkDescriptorSetLayout layout, uint32 count,
+                                        VkDescriptorSet* outSets) {
+    std::vector<VkDescriptorSetLayout> layouts(count, layout);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorPool = pool.pool;
+    allocInfo.descriptorSetCount = count;
+    allocInfo.pSetLayouts = layouts.data();
+
+    // VK_ERROR_OUT_OF_POOL_MEMORY or VK_ERROR_FRAGMENTED_POOL: try the next pool
+    if (vkAllocateDescriptorSets(m_Context.device, &allocInfo, outSets) != VK_SUCCESS) {
+        return false;
+    }
+    pool.liveSets += count;
+    return true;
+}
+
+VkDescriptorPool VulkanDescriptorCache::AllocateSets(const VulkanSetLayoutKey& key, uint32 count,
+                                                     VkDescriptorSet* outSets) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    VkDescriptorSetLayout layout = GetSetLayoutLocked(key);
+
+    // Descriptors of each type the sets need
+    std::vector<VkDescriptorPoolSize> needed;
+    bool dedicated = false;
+    for (const auto& binding : key.bindings) {
+        auto it = std::find_if(needed.begin(), needed.end(),
+                               [&](const VkDescriptorPoolSize& size) { return size.type == binding.type; });
+        if (it == needed.end()) {
+            needed.push_back({ binding.type, 0 });
+            it = needed.end() - 1;
+        }
+        it->descriptorCount += binding.count * count;
+    }
+    for (const auto& size : needed) {
+        dedicated |= size.descriptorCount * 4 > GetSharedPoolRatio(size.type) * SETS_PER_POOL;
+    }
+
+    if (dedicated) {
+        VkDescriptorPool handle = CreatePool(count, needed, true);
+        if (handle == VK_NULL_HANDLE) {
+            return VK_NULL_HANDLE;
+        }
+        if (!TryAllocate(m_Pools.back(), layout, count, outSets)) {
+            METAGFX_ERROR << "VulkanDescriptorCache: failed to allocate " << count << " descriptor sets";
+            vkDestroyDescriptorPool(m_Context.device, handle, nullptr);
+            m_Pools.pop_back();
+            return VK_NULL_HANDLE;
+        }
+        return handle;
+    }
+
+    // Newest shared pool first: older ones only have room where sets were freed
+    for (auto it = m_Pools.rbegin(); it != m_Pools.rend(); ++it) {
+        if (!it->dedicated && it->liveSets + count <= it->maxSets && TryAllocate(*it, layout, count, outSets)) {
+            return it->pool;
+        }
+    }
+
+    uint32 maxSets = m_NextPoolSize;
+    m_NextPoolSize = std::min(m_NextPoolSize * 2, MAX_SETS_PER_POOL);
+    VkDescriptorPool handle = CreatePool(maxSets, GetSharedPoolSizes(maxSets), false);
+    if (handle == VK_NULL_HANDLE || !TryAllocate(m_Pools.back(), layout, count, outSets)) {
+        METAGFX_ERROR << "VulkanDescriptorCache: failed to allocate " << count << " descriptor sets";
+        return VK_NULL_HANDLE;
+    }
+    METAGFX_DEBUG << "VulkanDescriptorCache: descriptor pool of " << maxSets << " sets created";
+    return handle;
+}
+
+void VulkanDescriptorCache::FreeSets(VkDescriptorPool pool, uint32 count, const VkDescriptorSet* sets) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::find_if(m_Pools.begin(), m_Pools.end(), [&](const Pool& entry) { return entry.pool == pool; });
+    if (it == m_Pools.end()) {
+        return;
+    }
+
+    VK_CHECK(vkFreeDescriptorSets(m_Context.device, pool, count, sets));
+    it->liveSets -= std::min(it->liveSets, count);
+    if (it->dedicated && it->liveSets == 0) {
+        vkDestroyDescriptorPool(m_Context.device, pool, nullptr);
+        m_Pools.erase(it);
+    }
+}
+
+size_t VulkanDescriptorCache::GetSetLayoutCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_SetLayouts.size();
+}
+
+size_t VulkanDescriptorCache::GetPipelineLayoutCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_PipelineLayouts.size();
+}
+
+size_t VulkanDescriptorCache::GetPoolCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Pools.size();
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -6,6 +6,9 @@
 #include "metagfx/rhi/vulkan/VulkanBuffer.h"
 #include "metagfx/rhi/vulkan/VulkanTexture.h"
 #include "metagfx/rhi/vulkan/VulkanSampler.h"
+#include "metagfx/rhi/vulkan/VulkanAccelerationStructure.h"
+
+#include <algorithm>
 
 namespace metagfx {
 namespace rhi {
@@ -14,10 +17,12 @@ namespace rhi {
 VkDescriptorType VulkanDescriptorSet::ToVulkanDescriptorType(DescriptorType type) {
     switch (type) {
         case DescriptorType::UniformBuffer: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        case DescriptorType::UniformBufferDynamic: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
         case DescriptorType::StorageBuffer: return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
         case DescriptorType::SampledTexture: return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         case DescriptorType::StorageTexture: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
         case DescriptorType::Sampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+        case DescriptorType::AccelerationStructure: return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
         default: return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
     }
 }
@@ -44,21 +49,42 @@ VkShaderStageFlags VulkanDescriptorSet::ToVulkanShaderStage(ShaderStage stage) {
 VulkanDescriptorSet::VulkanDescriptorSet(VulkanContext& context, const DescriptorSetDesc& desc)
     : m_Context(context) {
 
-    // Convert backend-agnostic bindings to Vulkan bindings
+    m_LayoutKey.pushDescriptors = desc.pushDescriptors && m_Context.cmdPushDescriptorSet != nullptr;
+    if (desc.pushDescriptors && !m_LayoutKey.pushDescriptors) {
+        METAGFX_ERROR << "VulkanDescriptorSet: push descriptors are not supported ("
+                      << (desc.debugName ? desc.debugName : "unnamed") << ")";
+    }
+
+    // Convert backend-agnostic bindings to Vulkan bindings. Push descriptor layouts take
+    // no dynamic buffers; the push writes the offset into the buffer info instead.
     for (const auto& binding : desc.bindings) {
         DescriptorBinding vkBinding;
         vkBinding.binding = binding.binding;
         vkBinding.type = ToVulkanDescriptorType(binding.type);
+        if (m_LayoutKey.pushDescriptors && vkBinding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) {
+            vkBinding.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        }
         vkBinding.stageFlags = ToVulkanShaderStage(binding.stageFlags);
         vkBinding.buffer = binding.buffer;
         vkBinding.texture = binding.texture;
         vkBinding.sampler = binding.sampler;
+        vkBinding.range = binding.range;
+        vkBinding.accelerationStructure = binding.accelerationStructure;
+        vkBinding.count = std::max(binding.count, 1u);
+        if (vkBinding.count > 1) {
+            vkBinding.arrayTextures.resize(vkBinding.count);
+            vkBinding.arraySamplers.resize(vkBinding.count);
+        }
         m_Bindings.push_back(vkBinding);
     }
 
     CreateLayout(m_Bindings);
+    if (m_LayoutKey.pushDescriptors) {
+        m_DescriptorSets.resize(m_Context.framesInFlight, VK_NULL_HANDLE);  // Nothing to allocate
+        return;
+    }
     AllocateSets();
-    UpdateSets(m_Bindings);
+    WriteAllSets();
 }
 
 // Legacy constructor for backward compatibility
@@ -68,157 +94,302 @@ VulkanDescriptorSet::VulkanDescriptorSet(VulkanContext& context,
 
     CreateLayout(bindings);
     AllocateSets();
-    UpdateSets(bindings);
+    WriteAllSets();
 }
 
 VulkanDescriptorSet::~VulkanDescriptorSet() {
-    if (m_Pool != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(m_Context.device, m_Pool, nullptr);
-    }
-    
-    if (m_Layout != VK_NULL_HANDLE) {
-        vkDestroyDescriptorSetLayout(m_Context.device, m_Layout, nullptr);
+    if (m_Pool != VK_NULL_HANDLE && m_Context.descriptorCache) {
+        m_Context.descriptorCache->FreeSets(m_Pool, static_cast<uint32>(m_DescriptorSets.size()),
+                                            m_DescriptorSets.data());
     }
 }
 
 void VulkanDescriptorSet::CreateLayout(const std::vector<DescriptorBinding>& bindings) {
-    std::vector<VkDescriptorSetLayoutBinding> layoutBindings;
+    if (bindings.size() > 64) {
+        METAGFX_ERROR << "VulkanDescriptorSet: " << bindings.size()
+                      << " bindings exceed the 64 tracked for partial updates";
+    }
 
+    // Sets with the same bindings share one layout, whatever order they list them in
+    m_LayoutKey.bindings.clear();
     for (const auto& binding : bindings) {
-        VkDescriptorSetLayoutBinding layoutBinding{};
-        layoutBinding.binding = binding.binding;
-        layoutBinding.descriptorType = binding.type;
-        layoutBinding.descriptorCount = 1;
-        layoutBinding.stageFlags = binding.stageFlags;
-        layoutBinding.pImmutableSamplers = nullptr;
-
-        layoutBindings.push_back(layoutBinding);
+        VulkanSetLayoutKey::Binding keyBinding;
+        keyBinding.binding = binding.binding;
+        keyBinding.type = binding.type;
+        keyBinding.count = binding.count;
+        keyBinding.stages = binding.stageFlags;
+        m_LayoutKey.bindings.push_back(keyBinding);
     }
+    std::sort(m_LayoutKey.bindings.begin(), m_LayoutKey.bindings.end(),
+              [](const VulkanSetLayoutKey::Binding& a, const VulkanSetLayoutKey::Binding& b) {
+                  return a.binding < b.binding;
+              });
 
-    VkDescriptorSetLayoutCreateInfo layoutInfo{};
-    layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-    layoutInfo.bindingCount = static_cast<uint32>(layoutBindings.size());
-    layoutInfo.pBindings = layoutBindings.data();
-
-    VK_CHECK(vkCreateDescriptorSetLayout(m_Context.device, &layoutInfo, nullptr, &m_Layout));
+    m_Layout = m_Context.descriptorCache->GetSetLayout(m_LayoutKey);
 }
 
 void VulkanDescriptorSet::AllocateSets() {
-    // Create descriptor pool
-    std::vector<VkDescriptorPoolSize> poolSizes;
-    
+    m_DescriptorSets.resize(m_Context.framesInFlight, VK_NULL_HANDLE);
+    m_Pool = m_Context.descriptorCache->AllocateSets(m_LayoutKey, m_Context.framesInFlight, m_DescriptorSets.data());
+    if (m_Pool == VK_NULL_HANDLE) {
+        std::fill(m_DescriptorSets.begin(), m_DescriptorSets.end(), VK_NULL_HANDLE);
+    }
+}
+
+void VulkanDescriptorSet::WriteAllSets() {
+    for (uint32 i = 0; i < m_Context.framesInFlight; i++) {
+        WriteBindings(i, ~0ull);
+        m_DirtyMasks[i] = 0;
+    }
+}
+
+void VulkanDescriptorSet::WriteBindings(uint32 frameIndex, uint64 mask) {
+    if (m_DescriptorSets[frameIndex] == VK_NULL_HANDLE) {
+        return;  // Allocation failed
+    }
+
+    std::vector<VkWriteDescriptorSet> descriptorWrites;
+    std::vector<VkDescriptorBufferInfo> bufferInfos;
+    std::vector<VkDescriptorImageInfo> imageInfos;
+    std::vector<VkWriteDescriptorSetAccelerationStructureKHR> structureInfos;
+    std::vector<VkAccelerationStructureKHR> structureHandles;
+
+    // Reserve space to prevent reallocation (which would invalidate pointers)
+    size_t descriptorCount = 0;
     for (const auto& binding : m_Bindings) {
-        VkDescriptorPoolSize poolSize{};
-        poolSize.type = binding.type;
-        poolSize.descriptorCount = MAX_FRAMES;
-        poolSizes.push_back(poolSize);
-    }
-    
-    VkDescriptorPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-    poolInfo.poolSizeCount = static_cast<uint32>(poolSizes.size());
-    poolInfo.pPoolSizes = poolSizes.data();
-    poolInfo.maxSets = MAX_FRAMES;
-    
-    VK_CHECK(vkCreateDescriptorPool(m_Context.device, &poolInfo, nullptr, &m_Pool));
-    
-    // Allocate descriptor sets
-    std::vector<VkDescriptorSetLayout> layouts(MAX_FRAMES, m_Layout);
-    
-    VkDescriptorSetAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    allocInfo.descriptorPool = m_Pool;
-    allocInfo.descriptorSetCount = MAX_FRAMES;
-    allocInfo.pSetLayouts = layouts.data();
-    
-    m_DescriptorSets.resize(MAX_FRAMES);
-    VK_CHECK(vkAllocateDescriptorSets(m_Context.device, &allocInfo, m_DescriptorSets.data()));
-}
-
-void VulkanDescriptorSet::UpdateSets(const std::vector<DescriptorBinding>& bindings) {
-    for (uint32 i = 0; i < MAX_FRAMES; i++) {
-        std::vector<VkWriteDescriptorSet> descriptorWrites;
-        std::vector<VkDescriptorBufferInfo> bufferInfos;
-        std::vector<VkDescriptorImageInfo> imageInfos;
-
-        // Reserve space to prevent reallocation (which would invalidate pointers)
-        bufferInfos.reserve(bindings.size());
-        imageInfos.reserve(bindings.size());
-        descriptorWrites.reserve(bindings.size());
-
-        for (const auto& binding : bindings) {
-            if (binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
-                binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
-                if (binding.buffer) {
-                    auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(binding.buffer);
-
-                    VkDescriptorBufferInfo bufferInfo{};
-                    bufferInfo.buffer = vkBuffer->GetHandle();
-                    bufferInfo.offset = 0;
-                    bufferInfo.range = vkBuffer->GetSize();
-                    bufferInfos.push_back(bufferInfo);
-
-                    VkWriteDescriptorSet descriptorWrite{};
-                    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    descriptorWrite.dstSet = m_DescriptorSets[i];
-                    descriptorWrite.dstBinding = binding.binding;
-                    descriptorWrite.dstArrayElement = 0;
-                    descriptorWrite.descriptorType = binding.type;
-                    descriptorWrite.descriptorCount = 1;
-                    descriptorWrite.pBufferInfo = &bufferInfos.back();
-
-                    descriptorWrites.push_back(descriptorWrite);
-                }
-            } else if (binding.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
-                if (binding.texture && binding.sampler) {
-                    auto vkTexture = std::static_pointer_cast<VulkanTexture>(binding.texture);
-                    auto vkSampler = std::static_pointer_cast<VulkanSampler>(binding.sampler);
-
-                    VkDescriptorImageInfo imageInfo{};
-                    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    imageInfo.imageView = vkTexture->GetImageView();
-                    imageInfo.sampler = vkSampler->GetHandle();
-                    imageInfos.push_back(imageInfo);
-
-                    VkWriteDescriptorSet descriptorWrite{};
-                    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    descriptorWrite.dstSet = m_DescriptorSets[i];
-                    descriptorWrite.dstBinding = binding.binding;
-                    descriptorWrite.dstArrayElement = 0;
-                    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    descriptorWrite.descriptorCount = 1;
-                    descriptorWrite.pImageInfo = &imageInfos.back();
-
-                    descriptorWrites.push_back(descriptorWrite);
+        descriptorCount += binding.count;
+    }
+    bufferInfos.reserve(m_Bindings.size());
+    imageInfos.reserve(descriptorCount);
+    descriptorWrites.reserve(descriptorCount);
+    structureInfos.reserve(m_Bindings.size());
+    structureHandles.reserve(m_Bindings.size());
+
+    for (size_t index = 0; index < m_Bindings.size(); index++) {
+        if (!(mask & (1ull << index))) {
+            continue;
+        }
+        const auto& binding = m_Bindings[index];
+
+        if (binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+            binding.type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+            binding.type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER) {
+            if (binding.buffer) {
+                auto vkBuffer = std::static_pointer_cast<VulkanBuffer>(binding.buffer);
+
+                VkDescriptorBufferInfo bufferInfo{};
+                bufferInfo.buffer = vkBuffer->GetHandle();
+                bufferInfo.offset = 0;
+                bufferInfo.range = binding.range > 0 ? binding.range : vkBuffer->GetSize();
+                bufferInfos.push_back(bufferInfo);
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = m_DescriptorSets[frameIndex];
+                descriptorWrite.dstBinding = binding.binding;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = binding.type;
+                descriptorWrite.descriptorCount = 1;
+                descriptorWrite.pBufferInfo = &bufferInfos.back();
+
+                descriptorWrites.push_back(descriptorWrite);
+            }
+        } else if (binding.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER && binding.count > 1) {
+            // Texture table: write every populated element, leave the rest unbound
+            for (uint32 element = 0; element < binding.count; element++) {
+                if (element >= binding.arrayTextures.size() ||
+                    !binding.arrayTextures[element] || !binding.arraySamplers[element]) {
+                    continue;
                 }
+                auto vkTexture = std::static_pointer_cast<VulkanTexture>(binding.arrayTextures[element]);
+                auto vkSampler = std::static_pointer_cast<VulkanSampler>(binding.arraySamplers[element]);
+
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.imageLayout = vkTexture->GetShaderReadLayout();
+                imageInfo.imageView = vkTexture->GetImageView();
+                imageInfo.sampler = vkSampler->GetHandle();
+                imageInfos.push_back(imageInfo);
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = m_DescriptorSets[frameIndex];
+                descriptorWrite.dstBinding = binding.binding;
+                descriptorWrite.dstArrayElement = element;
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorWrite.descriptorCount = 1;
+                descriptorWrite.pImageInfo = &imageInfos.back();
+
+                descriptorWrites.push_back(descriptorWrite);
+            }
+        } else if (binding.type == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) {
+            if (binding.texture && binding.sampler) {
+                auto vkTexture = std::static_pointer_cast<VulkanTexture>(binding.texture);
+                auto vkSampler = std::static_pointer_cast<VulkanSampler>(binding.sampler);
+
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.imageLayout = vkTexture->GetShaderReadLayout();
+                imageInfo.imageView = vkTexture->GetImageView();
+                imageInfo.sampler = vkSampler->GetHandle();
+                imageInfos.push_back(imageInfo);
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = m_DescriptorSets[frameIndex];
+                descriptorWrite.dstBinding = binding.binding;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+                descriptorWrite.descriptorCount = 1;
+                descriptorWrite.pImageInfo = &imageInfos.back();
+
+                descriptorWrites.push_back(descriptorWrite);
+            }
+        } else if (binding.type == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE) {
+            if (binding.texture) {
+                auto vkTexture = std::static_pointer_cast<VulkanTexture>(binding.texture);
+
+                VkDescriptorImageInfo imageInfo{};
+                imageInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+                imageInfo.imageView = vkTexture->GetImageView();
+                imageInfos.push_back(imageInfo);
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = m_DescriptorSets[frameIndex];
+                descriptorWrite.dstBinding = binding.binding;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+                descriptorWrite.descriptorCount = 1;
+                descriptorWrite.pImageInfo = &imageInfos.back();
+
+                descriptorWrites.push_back(descriptorWrite);
+            }
+        } else if (binding.type == VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR) {
+            auto* structure = static_cast<VulkanAccelerationStructure*>(binding.accelerationStructure.get());
+            if (structure && structure->IsValid()) {
+                structureHandles.push_back(structure->GetHandle());
+
+                VkWriteDescriptorSetAccelerationStructureKHR structureInfo{};
+                structureInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+                structureInfo.accelerationStructureCount = 1;
+                structureInfo.pAccelerationStructures = &structureHandles.back();
+                structureInfos.push_back(structureInfo);
+
+                VkWriteDescriptorSet descriptorWrite{};
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.pNext = &structureInfos.back();
+                descriptorWrite.dstSet = m_DescriptorSets[frameIndex];
+                descriptorWrite.dstBinding = binding.binding;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+                descriptorWrite.descriptorCount = 1;
+
+                descriptorWrites.push_back(descriptorWrite);
             }
         }
+    }
 
+    if (!descriptorWrites.empty()) {
         vkUpdateDescriptorSets(m_Context.device,
-                              static_cast<uint32>(descriptorWrites.size()),
-                              descriptorWrites.data(), 0, nullptr);
+                               static_cast<uint32>(descriptorWrites.size()),
+                               descriptorWrites.data(), 0, nullptr);
+        m_Context.stats->AddDescriptorUpdates(static_cast<uint32>(descriptorWrites.size()));
     }
 }
 
-void VulkanDescriptorSet::UpdateBuffer(uint32 binding, Ref<Buffer> buffer) {
+void VulkanDescriptorSet::MarkDirty(uint32 binding) {
+    for (size_t index = 0; index < m_Bindings.size(); index++) {
+        if (m_Bindings[index].binding == binding) {
+            for (auto& mask : m_DirtyMasks) {
+                mask |= 1ull << index;
+            }
+            return;
+        }
+    }
+}
+
+void VulkanDescriptorSet::FlushUpdates(uint32 frameIndex) {
+    if (frameIndex >= m_Context.framesInFlight) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_FlushMutex);
+    if (m_DirtyMasks[frameIndex] == 0) {
+        return;
+    }
+
+    WriteBindings(frameIndex, m_DirtyMasks[frameIndex]);
+    m_DirtyMasks[frameIndex] = 0;
+}
+
+void VulkanDescriptorSet::UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) {
     for (auto& b : m_Bindings) {
         if (b.binding == binding) {
+            if (b.buffer == buffer) {
+                return;
+            }
             b.buffer = buffer;
             break;
         }
     }
-    UpdateSets(m_Bindings);
+    MarkDirty(binding);
 }
 
-void VulkanDescriptorSet::UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) {
+void VulkanDescriptorSet::UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
     for (auto& b : m_Bindings) {
         if (b.binding == binding) {
+            if (b.texture == texture && b.sampler == sampler) {
+                return;
+            }
             b.texture = texture;
             b.sampler = sampler;
             break;
         }
     }
-    UpdateSets(m_Bindings);
+    MarkDirty(binding);
+}
+
+void VulkanDescriptorSet::UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                                    const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
+    for (auto& b : m_Bindings) {
+        if (b.binding != binding) {
+            continue;
+        }
+        if (b.count <= 1) {
+            if (arrayElement == 0) {
+                UpdateTexture(binding, texture, sampler);
+            }
+            return;
+        }
+        if (arrayElement >= b.count) {
+            METAGFX_ERROR << "VulkanDescriptorSet: element " << arrayElement << " out of range for binding "
+                          << binding << " (" << b.count << " elements)";
+            return;
+        }
+        if (b.arrayTextures.size() < b.count) {
+            b.arrayTextures.resize(b.count);
+            b.arraySamplers.resize(b.count);
+        }
+        if (b.arrayTextures[arrayElement] == texture && b.arraySamplers[arrayElement] == sampler) {
+            return;
+        }
+        b.arrayTextures[arrayElement] = texture;
+        b.arraySamplers[arrayElement] = sampler;
+        MarkDirty(binding);
+        return;
+    }
+}
+
+void VulkanDescriptorSet::UpdateAccelerationStructure(uint32 binding, const Ref<AccelerationStructure>& structure) {
+    for (auto& b : m_Bindings) {
+        if (b.binding == binding) {
+            if (b.accelerationStructure == structure) {
+                return;
+            }
+            b.accelerationStructure = structure;
+            break;
+        }
+    }
+    MarkDirty(binding);
 }
 
 void* VulkanDescriptorSet::GetNativeHandle(uint32 frameIndex) const {
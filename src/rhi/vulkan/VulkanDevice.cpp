@@ -2,6 +2,7 @@
 // src/rhi/vulkan/VulkanDevice.cpp
 // ============================================================================
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
 #include "metagfx/rhi/vulkan/VulkanDevice.h"
 #include "metagfx/rhi/vulkan/VulkanSwapChain.h"
 #include "metagfx/rhi/vulkan/VulkanBuffer.h"
@@ -9,42 +10,184 @@
 #include "metagfx/rhi/vulkan/VulkanSampler.h"
 #include "metagfx/rhi/vulkan/VulkanShader.h"
 #include "metagfx/rhi/vulkan/VulkanPipeline.h"
+#include "metagfx/rhi/vulkan/VulkanComputePipeline.h"
 #include "metagfx/rhi/vulkan/VulkanCommandBuffer.h"
 #include "metagfx/rhi/vulkan/VulkanFramebuffer.h"
 #include "metagfx/rhi/vulkan/VulkanDescriptorSet.h"
+#include "metagfx/rhi/vulkan/VulkanRenderPassCache.h"
+#include "metagfx/rhi/vulkan/VulkanMemoryAllocator.h"
+#include "metagfx/rhi/vulkan/VulkanUploadManager.h"
+#include "metagfx/rhi/vulkan/VulkanTimeline.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineCache.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineLibrary.h"
+#include "metagfx/rhi/vulkan/VulkanDescriptorCache.h"
+#include "metagfx/rhi/vulkan/VulkanGpuProfiler.h"
+#include "metagfx/rhi/vulkan/VulkanAccelerationStructure.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
 
+#include <algorithm>
+#include <cstring>
+
 namespace metagfx {
 namespace rhi {
 
-VulkanDevice::VulkanDevice(SDL_Window* window) : m_Window(window) {
+VulkanDevice::VulkanDevice(SDL_Window* window, const GraphicsDeviceDesc& desc) : m_Window(window) {
     METAGFX_INFO << "Initializing Vulkan device...";
 
+    // Sizes every per-frame resource below, so it is set first
+    m_Context.framesInFlight = desc.framesInFlight;
+    m_Context.stats = &m_StatsCounters;
+    m_Context.memory = &m_MemoryCounters;
+
     CreateInstance(window);
-    PickPhysicalDevice();
+    PickPhysicalDevice(desc.adapterIndex);
     CreateLogicalDevice();
     CreateCommandPool();
+
+    // Every graphics queue submission below signals it, so it is created first
+    m_Timeline = CreateScope<VulkanTimeline>(m_Context, m_Context.graphicsQueue, m_Context.timelineSemaphore);
+    m_Context.timeline = m_Timeline.get();
+    if (m_Context.computeQueue != VK_NULL_HANDLE) {
+        m_ComputeTimeline = CreateScope<VulkanTimeline>(m_Context, m_Context.computeQueue, true);
+    }
+
+    // Memory allocator must outlive every buffer and texture (including swap chain depth targets)
+    m_MemoryAllocator = CreateScope<VulkanMemoryAllocator>(m_Context);
+    m_Context.allocator = m_MemoryAllocator.get();
+
+    // Texture uploads stage through the allocator, so it is created after it
+    m_UploadManager = CreateScope<VulkanUploadManager>(m_Context);
+    m_Context.uploadManager = m_UploadManager.get();
+
+    // Loaded before any pipeline is created; saved again when the device is destroyed
+    m_PipelineCache = CreateScope<VulkanPipelineCache>(m_Context, desc.pipelineCachePath);
+    m_Context.pipelineCache = m_PipelineCache.get();
+    if (m_Context.graphicsPipelineLibrary) {
+        m_PipelineLibraries = CreateScope<VulkanPipelineLibraryCache>(m_Context);
+        METAGFX_INFO << "Graphics pipelines fast-linked from pipeline libraries";
+    }
+
+    // Layouts and pools of every descriptor set and pipeline, so it outlives them all
+    m_DescriptorCache = CreateScope<VulkanDescriptorCache>(m_Context);
+    m_Context.descriptorCache = m_DescriptorCache.get();
+
+    // Render pass/framebuffer cache must outlive the swap chain (it evicts swap chain framebuffers)
+    m_RenderPassCache = CreateScope<VulkanRenderPassCache>(m_Context);
+    m_Context.renderPassCache = m_RenderPassCache.get();
     
     // Create swap chain
-    m_SwapChain = CreateRef<VulkanSwapChain>(m_Context, window);
+    m_SwapChain = CreateRef<VulkanSwapChain>(m_Context, window, desc.presentMode, desc.offscreen);
     
     // Fill device info
     m_DeviceInfo.deviceName = std::string(m_Context.deviceProperties.deviceName);
     m_DeviceInfo.api = GraphicsAPI::Vulkan;
     m_DeviceInfo.apiVersion = m_Context.deviceProperties.apiVersion;
+    m_DeviceInfo.isIntegratedGPU = m_Context.deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+    m_DeviceInfo.minUniformBufferOffsetAlignment =
+        static_cast<uint32>(m_Context.deviceProperties.limits.minUniformBufferOffsetAlignment);
+    m_DeviceInfo.framesInFlight = desc.framesInFlight;
+    if (m_Context.descriptorIndexing) {
+        // A combined image sampler counts against both the sampler and sampled image limits.
+        // Keep a few slots for the non-table bindings of the same stage.
+        const auto& limits = m_Context.deviceProperties.limits;
+        uint32 maxTextures = std::min({ limits.maxPerStageDescriptorSamplers,
+                                        limits.maxPerStageDescriptorSampledImages,
+                                        limits.maxDescriptorSetSamplers,
+                                        limits.maxDescriptorSetSampledImages });
+        m_DeviceInfo.supportsBindlessTextures = maxTextures > 16;
+        m_DeviceInfo.maxBindlessTextures = maxTextures > 16 ? maxTextures - 16 : 0;
+    }
+    m_DeviceInfo.supportsBCTextures = m_Context.deviceFeatures.textureCompressionBC == VK_TRUE;
+    m_DeviceInfo.supportsETC2Textures = m_Context.deviceFeatures.textureCompressionETC2 == VK_TRUE;
+    m_DeviceInfo.supportsASTCTextures = m_Context.deviceFeatures.textureCompressionASTC_LDR == VK_TRUE;
+    m_DeviceInfo.supportsMultiDrawIndirect = m_Context.multiDrawIndirect;
+    m_DeviceInfo.supportsDrawIndirectCount = m_Context.cmdDrawIndexedIndirectCount != nullptr;
+    m_DeviceInfo.supportsDrawIndirectFirstInstance = m_Context.deviceFeatures.drawIndirectFirstInstance == VK_TRUE;
+    m_DeviceInfo.supportsPrimitiveId = m_Context.deviceFeatures.geometryShader == VK_TRUE;
+    m_DeviceInfo.maxComputeWorkGroupInvocations = m_Context.deviceProperties.limits.maxComputeWorkGroupInvocations;
+    m_DeviceInfo.supportsParallelRecording = true;
+    m_DeviceInfo.supportsThreadedResourceCreation = true;
+    m_DeviceInfo.supportsAsyncCompute = m_ComputeTimeline != nullptr;
+    m_DeviceInfo.supportsPresentWait = m_Context.waitForPresent != nullptr;
+    m_DeviceInfo.supportsTimestampQueries = m_TimestampValidBits > 0 &&
+                                            m_Context.deviceProperties.limits.timestampPeriod > 0.0f;
+    for (uint32 i = 0; i < m_Context.memoryProperties.memoryTypeCount; ++i) {
+        if (m_Context.memoryProperties.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) {
+            m_DeviceInfo.supportsMemorylessAttachments = true;
+        }
+    }
+    m_DeviceInfo.supportsShadingRateImage = m_Context.shadingRateImage;
+    m_DeviceInfo.shadingRateTexelSize = m_Context.shadingRateTexelSize;
+    m_DeviceInfo.deviceMemory = 0;
+    for (uint32 i = 0; i < m_Context.memoryProperties.memoryHeapCount; ++i) {
+        if (m_Context.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            m_DeviceInfo.deviceMemory += m_Context.memoryProperties.memoryHeaps[i].size;
+        }
+    }
+    m_DeviceInfo.supportsMemoryBudget = m_Context.memoryBudget;
+    m_DeviceInfo.supportsAccelerationStructures = m_Context.accelerationStructure;
+    m_DeviceInfo.supportsRayQuery = m_Context.rayQuery;
+    m_DeviceInfo.supportsShaderFloat16 = m_Context.shaderFloat16;
+    m_DeviceInfo.supportsPipelineLibraries = m_Context.graphicsPipelineLibrary;
+    m_DeviceInfo.supportsPushDescriptors = m_Context.cmdPushDescriptorSet != nullptr;
+    m_DeviceInfo.supportsMultiview = m_Context.maxMultiviewViews > 1;
+    m_DeviceInfo.maxMultiviewViews = std::max(m_Context.maxMultiviewViews, 1u);
+
+    // D16_UNORM renders and samples on every device; D32_SFLOAT rendering is optional
+    constexpr VkFormatFeatureFlags depthFeatures =
+        VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+    VkFormatProperties depthProperties{};
+    vkGetPhysicalDeviceFormatProperties(m_Context.physicalDevice, VK_FORMAT_D32_SFLOAT, &depthProperties);
+    m_DeviceInfo.depthFormat = (depthProperties.optimalTilingFeatures & depthFeatures) == depthFeatures
+                                   ? Format::D32_SFLOAT : Format::D16_UNORM;
+    vkGetPhysicalDeviceFormatProperties(m_Context.physicalDevice, VK_FORMAT_D16_UNORM, &depthProperties);
+    m_DeviceInfo.supportsDepth16 =
+        (depthProperties.optimalTilingFeatures & (depthFeatures | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)) ==
+        (depthFeatures | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
 
     METAGFX_INFO << "Vulkan device initialized: " << m_DeviceInfo.deviceName;
 }
 
 VulkanDevice::~VulkanDevice() {
+    WaitForPipelineCompiles();
     WaitIdle();
+    ReleasePipelineCache();
+    ReleaseRetired(true);
     
     m_SwapChain.reset();
+
+    m_RenderPassCache.reset();
+    m_Context.renderPassCache = nullptr;
+
+    m_UploadManager.reset();
+    m_Context.uploadManager = nullptr;
+
+    m_PipelineLibraries.reset();
+    m_PipelineCache.reset();
+    m_Context.pipelineCache = nullptr;
+
+    m_DescriptorCache.reset();
+    m_Context.descriptorCache = nullptr;
+
+    m_MemoryAllocator.reset();
+    m_Context.allocator = nullptr;
+
+    m_ComputeTimeline.reset();
+    m_Timeline.reset();
+    m_Context.timeline = nullptr;
+
+    // Command buffers free themselves back into their pool, so release them first
+    m_FrameCommandBuffers.clear();
+    m_FrameComputeCommandBuffers.clear();
+    for (VkCommandPool pool : m_FrameCommandPools) {
+        vkDestroyCommandPool(m_Context.device, pool, nullptr);
+    }
+    m_FrameCommandPools.clear();
     
-    if (m_CommandPool != VK_NULL_HANDLE) {
-        vkDestroyCommandPool(m_Context.device, m_CommandPool, nullptr);
+    for (auto& [thread, pool] : m_ThreadCommandPools) {
+        vkDestroyCommandPool(m_Context.device, pool, nullptr);
     }
     
     if (m_Context.device != VK_NULL_HANDLE) {
@@ -106,7 +249,91 @@ void VulkanDevice::CreateInstance(SDL_Window* window) {
     }
 }
 
-void VulkanDevice::PickPhysicalDevice() {
+static AdapterInfo DescribeAdapter(VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkPhysicalDeviceMemoryProperties memoryProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    AdapterInfo adapter;
+    adapter.name = properties.deviceName;
+    adapter.isIntegratedGPU = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU;
+    adapter.isSoftware = properties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+    for (uint32 i = 0; i < memoryProperties.memoryHeapCount; ++i) {
+        if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            adapter.deviceMemory += memoryProperties.memoryHeaps[i].size;
+        }
+    }
+    return adapter;
+}
+
+// Discrete over integrated over virtual over software GPUs, then by how many of the
+// optional features the renderer uses the device has, then by memory
+static uint64 RankAdapter(VkPhysicalDevice physicalDevice, const AdapterInfo& adapter) {
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+    VkPhysicalDeviceFeatures features;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &features);
+    uint64 type = 0;
+    switch (properties.deviceType) {
+        case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:   type = 4; break;
+        case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: type = 3; break;
+        case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:    type = 2; break;
+        case VK_PHYSICAL_DEVICE_TYPE_OTHER:          type = 1; break;
+        default:                                     type = 0; break;
+    }
+
+    uint32 familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+    bool timestamps = false;
+    for (const VkQueueFamilyProperties& family : families) {
+        timestamps = timestamps || ((family.queueFlags & VK_QUEUE_GRAPHICS_BIT) && family.timestampValidBits > 0);
+    }
+    timestamps = timestamps && properties.limits.timestampPeriod > 0.0f;
+
+    // Vulkan 1.2 brings timeline semaphores and descriptor indexing (bindless tables)
+    uint64 features12 = properties.apiVersion >= VK_API_VERSION_1_2 ? 1 : 0;
+    uint64 capabilities = features12 * 2 + (timestamps ? 1 : 0) +
+                          (features.shaderSampledImageArrayDynamicIndexing ? 1 : 0) +
+                          (features.multiDrawIndirect ? 1 : 0) + (features.drawIndirectFirstInstance ? 1 : 0);
+    return (type << 56) | (capabilities << 48) | std::min<uint64>(adapter.deviceMemory >> 20, (1ull << 48) - 1);
+}
+
+std::vector<AdapterInfo> VulkanDevice::EnumerateAdapters() {
+    VkApplicationInfo appInfo{};
+    appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+    appInfo.apiVersion = VK_API_VERSION_1_2;
+
+    VkInstanceCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
+    createInfo.pApplicationInfo = &appInfo;
+    #ifdef __APPLE__
+    const char* extensions[] = { VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME };
+    createInfo.flags |= VK_INSTANCE_CREATE_ENUMERATE_PORTABILITY_BIT_KHR;
+    createInfo.enabledExtensionCount = 1;
+    createInfo.ppEnabledExtensionNames = extensions;
+    #endif
+
+    std::vector<AdapterInfo> adapters;
+    VkInstance instance = VK_NULL_HANDLE;
+    if (vkCreateInstance(&createInfo, nullptr, &instance) != VK_SUCCESS) {
+        METAGFX_ERROR << "Failed to create a Vulkan instance to enumerate GPUs";
+        return adapters;
+    }
+    uint32 deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+    for (VkPhysicalDevice device : devices) {
+        adapters.push_back(DescribeAdapter(device));
+    }
+    vkDestroyInstance(instance, nullptr);
+    return adapters;
+}
+
+void VulkanDevice::PickPhysicalDevice(uint32 adapterIndex) {
     uint32 deviceCount = 0;
     vkEnumeratePhysicalDevices(m_Context.instance, &deviceCount, nullptr);
     
@@ -117,15 +344,65 @@ void VulkanDevice::PickPhysicalDevice() {
     
     std::vector<VkPhysicalDevice> devices(deviceCount);
     vkEnumeratePhysicalDevices(m_Context.instance, &deviceCount, devices.data());
-    
-    // Just pick the first device for now
-    m_Context.physicalDevice = devices[0];
+
+    // A device must have a graphics queue family that can present to the window's surface,
+    // and the features CreateLogicalDevice() always enables
+    auto isSuitable = [this](VkPhysicalDevice device) {
+        VkPhysicalDeviceFeatures features;
+        vkGetPhysicalDeviceFeatures(device, &features);
+        if (!features.fillModeNonSolid) {
+            return false;
+        }
+        uint32 familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(device, &familyCount, families.data());
+        bool graphics = false;
+        bool present = m_Context.surface == VK_NULL_HANDLE;
+        for (uint32 i = 0; i < familyCount; ++i) {
+            graphics = graphics || (families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0;
+            VkBool32 presentSupport = VK_FALSE;
+            if (!present) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, m_Context.surface, &presentSupport);
+            }
+            present = present || presentSupport == VK_TRUE;
+        }
+        return graphics && present;
+    };
+
+    uint32 selected = ~0u;
+    if (adapterIndex != DEFAULT_ADAPTER) {
+        if (adapterIndex < deviceCount && isSuitable(devices[adapterIndex])) {
+            selected = adapterIndex;
+        } else {
+            METAGFX_WARN << "GPU " << adapterIndex << " is not available (" << deviceCount
+                         << " found) or lacks a required feature, picking the best one";
+        }
+    }
+    if (selected == ~0u) {
+        uint64 bestRank = 0;
+        for (uint32 i = 0; i < deviceCount; ++i) {
+            AdapterInfo adapter = DescribeAdapter(devices[i]);
+            uint64 rank = RankAdapter(devices[i], adapter);
+            METAGFX_INFO << "  GPU " << i << ": " << adapter.name << " (" << (adapter.deviceMemory >> 20) << " MB)";
+            if (isSuitable(devices[i]) && (selected == ~0u || rank > bestRank)) {
+                selected = i;
+                bestRank = rank;
+            }
+        }
+        if (selected == ~0u) {
+            METAGFX_ERROR << "No GPU can render to the window";
+            selected = 0;
+        }
+    }
+    m_Context.physicalDevice = devices[selected];
+    m_DeviceInfo.adapterIndex = selected;
     
     vkGetPhysicalDeviceProperties(m_Context.physicalDevice, &m_Context.deviceProperties);
     vkGetPhysicalDeviceFeatures(m_Context.physicalDevice, &m_Context.deviceFeatures);
     vkGetPhysicalDeviceMemoryProperties(m_Context.physicalDevice, &m_Context.memoryProperties);
 
-    METAGFX_INFO << "Selected GPU: " << m_Context.deviceProperties.deviceName;
+    METAGFX_INFO << "Selected GPU " << selected << ": " << m_Context.deviceProperties.deviceName;
 }
 
 void VulkanDevice::CreateLogicalDevice() {
@@ -148,24 +425,65 @@ void VulkanDevice::CreateLogicalDevice() {
             m_Context.presentQueueFamily = i;
         }
     }
+
+    m_TimestampValidBits = queueFamilies[m_Context.graphicsQueueFamily].timestampValidBits;
+
+    // Find a transfer queue family for uploads: prefer a transfer-only (DMA) family, then
+    // any non-graphics family with transfer support. Mip tails are copied down to 1x1, so
+    // the family must not impose an image transfer granularity.
+    m_Context.transferQueueFamily = m_Context.graphicsQueueFamily;
+    int bestTransferScore = 0;
+    for (uint32 i = 0; i < queueFamilyCount; i++) {
+        VkQueueFlags flags = queueFamilies[i].queueFlags;
+        VkExtent3D granularity = queueFamilies[i].minImageTransferGranularity;
+        if (!(flags & VK_QUEUE_TRANSFER_BIT) || (flags & VK_QUEUE_GRAPHICS_BIT) ||
+            granularity.width != 1 || granularity.height != 1 || granularity.depth != 1) {
+            continue;
+        }
+
+        int score = (flags & VK_QUEUE_COMPUTE_BIT) ? 1 : 2;
+        if (score > bestTransferScore) {
+            bestTransferScore = score;
+            m_Context.transferQueueFamily = i;
+        }
+    }
     
+    // Async compute takes a second queue of the graphics family where it has one (most
+    // desktop GPUs): the queues share the family's resources without ownership transfers
+    // and the hardware schedules their work side by side
+    bool asyncComputeQueue = queueFamilies[m_Context.graphicsQueueFamily].queueCount >= 2;
+
     // Create queue create infos
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-    float queuePriority = 1.0f;
+    const float queuePriorities[] = { 1.0f, 1.0f };
     
     VkDeviceQueueCreateInfo queueCreateInfo{};
     queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
     queueCreateInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
-    queueCreateInfo.queueCount = 1;
-    queueCreateInfo.pQueuePriorities = &queuePriority;
+    queueCreateInfo.queueCount = asyncComputeQueue ? 2 : 1;
+    queueCreateInfo.pQueuePriorities = queuePriorities;
     queueCreateInfos.push_back(queueCreateInfo);
+
+    if (m_Context.transferQueueFamily != m_Context.graphicsQueueFamily) {
+        queueCreateInfo.queueFamilyIndex = m_Context.transferQueueFamily;
+        queueCreateInfo.queueCount = 1;
+        queueCreateInfos.push_back(queueCreateInfo);
+    }
     
     // Device features
     VkPhysicalDeviceFeatures deviceFeatures{};
     deviceFeatures.fillModeNonSolid = VK_TRUE; // For wireframe mode
-
-    // NOTE: Dynamic rendering causes issues with MoltenVK on macOS
-    // We'll use traditional render passes for now
+    deviceFeatures.shaderSampledImageArrayDynamicIndexing =
+        m_Context.deviceFeatures.shaderSampledImageArrayDynamicIndexing;  // Bindless texture tables
+    // Block-compressed texture formats, whichever families the device samples
+    deviceFeatures.textureCompressionBC = m_Context.deviceFeatures.textureCompressionBC;
+    deviceFeatures.textureCompressionETC2 = m_Context.deviceFeatures.textureCompressionETC2;
+    deviceFeatures.textureCompressionASTC_LDR = m_Context.deviceFeatures.textureCompressionASTC_LDR;
+    // Indirect draws of many commands per call, with a first instance per command
+    deviceFeatures.multiDrawIndirect = m_Context.deviceFeatures.multiDrawIndirect;
+    deviceFeatures.drawIndirectFirstInstance = m_Context.deviceFeatures.drawIndirectFirstInstance;
+    // gl_PrimitiveID in fragment shaders (the visibility buffer's pass)
+    deviceFeatures.geometryShader = m_Context.deviceFeatures.geometryShader;
 
     // Device extensions
     std::vector<const char*> deviceExtensions = {
@@ -176,8 +494,388 @@ void VulkanDevice::CreateLogicalDevice() {
     deviceExtensions.push_back("VK_KHR_portability_subset");
     #endif
 
+    // Dynamic rendering (VK_KHR_dynamic_rendering, core in Vulkan 1.3)
+    // NOTE: Dynamic rendering causes issues with MoltenVK on macOS, so the
+    // render pass path is kept there and on devices without the extension
+    VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+    dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+    bool useDynamicRendering = false;
+
+    #ifndef __APPLE__
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+        IsDeviceExtensionSupported(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME)) {
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &dynamicRenderingFeatures;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        useDynamicRendering = dynamicRenderingFeatures.dynamicRendering == VK_TRUE;
+    }
+    #endif
+
+    if (useDynamicRendering) {
+        deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+    }
+
+    // Shading rate images (VK_KHR_fragment_shading_rate's attachment rate), through dynamic
+    // rendering only. The images are R8_UINT, written by compute; their texels cover
+    // squares of 16 pixels, or the nearest size the device takes.
+    VkPhysicalDeviceFragmentShadingRateFeaturesKHR shadingRateFeatures{};
+    shadingRateFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR;
+    bool useShadingRate = false;
+    uint32 shadingRateTexelSize = 0;
+
+    if (useDynamicRendering && IsDeviceExtensionSupported(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME)) {
+        VkPhysicalDeviceFragmentShadingRateFeaturesKHR supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        VkPhysicalDeviceFragmentShadingRatePropertiesKHR shadingRateProperties{};
+        shadingRateProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_PROPERTIES_KHR;
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &shadingRateProperties;
+        vkGetPhysicalDeviceProperties2(m_Context.physicalDevice, &properties2);
+
+        VkFormatProperties formatProperties{};
+        vkGetPhysicalDeviceFormatProperties(m_Context.physicalDevice, VK_FORMAT_R8_UINT, &formatProperties);
+        constexpr VkFormatFeatureFlags rateFormatFeatures =
+            VK_FORMAT_FEATURE_STORAGE_IMAGE_BIT | VK_FORMAT_FEATURE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+
+        // Texel sizes are powers of two, so the clamped size is one too
+        const VkExtent2D& minTexel = shadingRateProperties.minFragmentShadingRateAttachmentTexelSize;
+        const VkExtent2D& maxTexel = shadingRateProperties.maxFragmentShadingRateAttachmentTexelSize;
+        uint32 texelSize = std::clamp(16u, minTexel.width, std::max(minTexel.width, maxTexel.width));
+        bool squareTexels = texelSize >= minTexel.height && texelSize <= maxTexel.height;
+
+        // The compute pass writes the rates through an r8ui image, an extended storage format
+        if (supported.attachmentFragmentShadingRate == VK_TRUE && squareTexels &&
+            m_Context.deviceFeatures.shaderStorageImageExtendedFormats == VK_TRUE &&
+            (formatProperties.optimalTilingFeatures & rateFormatFeatures) == rateFormatFeatures) {
+            shadingRateFeatures.attachmentFragmentShadingRate = VK_TRUE;
+            deviceFeatures.shaderStorageImageExtendedFormats = VK_TRUE;
+            useShadingRate = true;
+            shadingRateTexelSize = texelSize;
+        }
+    }
+
+    if (useShadingRate) {
+        deviceExtensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+    }
+
+    // GPU-sourced draw counts (VK_KHR_draw_indirect_count, core in Vulkan 1.2)
+    bool useDrawIndirectCount = IsDeviceExtensionSupported(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    if (useDrawIndirectCount) {
+        deviceExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+    }
+
+    // Descriptors written into the command buffer (VK_KHR_push_descriptor), for the
+    // per-material set where texture tables are unavailable
+    bool usePushDescriptors = IsDeviceExtensionSupported(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    if (usePushDescriptors) {
+        deviceExtensions.push_back(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+    }
+
+    // Heap budgets and usage (VK_EXT_memory_budget); the query is core in Vulkan 1.1
+    bool useMemoryBudget = m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_1 &&
+                           IsDeviceExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (useMemoryBudget) {
+        deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
+
+    // Descriptor indexing (VK_EXT_descriptor_indexing, core in Vulkan 1.2). Only partially
+    // bound bindings are needed: texture tables are written before the frame that binds
+    // them, so update-after-bind (which forbids dynamic uniform buffers) is not used.
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
+    descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+    bool useDescriptorIndexing = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+        m_Context.deviceFeatures.shaderSampledImageArrayDynamicIndexing) {
+        VkPhysicalDeviceDescriptorIndexingFeatures supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        if (supported.descriptorBindingPartiallyBound == VK_TRUE) {
+            descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+            useDescriptorIndexing = true;
+        }
+    }
+
+    // Timeline semaphores (VK_KHR_timeline_semaphore, core in Vulkan 1.2): one counts the
+    // graphics queue's submissions in place of per-frame and per-upload fences
+    VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures{};
+    timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+    bool useTimelineSemaphore = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceTimelineSemaphoreFeatures supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        if (supported.timelineSemaphore == VK_TRUE) {
+            timelineFeatures.timelineSemaphore = VK_TRUE;
+            useTimelineSemaphore = true;
+        }
+    }
+
+    // 16-bit float arithmetic in shaders (VK_KHR_shader_float16_int8, core in Vulkan 1.2):
+    // the half-precision build of the model shader
+    VkPhysicalDeviceShaderFloat16Int8Features float16Int8Features{};
+    float16Int8Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES;
+    bool useShaderFloat16 = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_2) {
+        VkPhysicalDeviceShaderFloat16Int8Features supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_FLOAT16_INT8_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        if (supported.shaderFloat16 == VK_TRUE) {
+            float16Int8Features.shaderFloat16 = VK_TRUE;
+            useShaderFloat16 = true;
+        }
+    }
+
+    // Multiview (VK_KHR_multiview, core in Vulkan 1.1): one pass and one draw stream render
+    // into several layers, the vertex shader picking each view's transform by gl_ViewIndex
+    VkPhysicalDeviceMultiviewFeatures multiviewFeatures{};
+    multiviewFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+    bool useMultiview = false;
+    uint32 maxMultiviewViews = 1;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_1) {
+        VkPhysicalDeviceMultiviewFeatures supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_FEATURES;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        VkPhysicalDeviceMultiviewProperties multiviewProperties{};
+        multiviewProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MULTIVIEW_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &multiviewProperties;
+        vkGetPhysicalDeviceProperties2(m_Context.physicalDevice, &properties2);
+
+        // A view mask is 32 bits wide
+        if (supported.multiview == VK_TRUE && multiviewProperties.maxMultiviewViewCount > 1) {
+            multiviewFeatures.multiview = VK_TRUE;
+            useMultiview = true;
+            maxMultiviewViews = std::min(multiviewProperties.maxMultiviewViewCount, 32u);
+        }
+    }
+
+    // Graphics pipeline libraries (VK_EXT_graphics_pipeline_library): only where the
+    // driver links them fast, or linking on first use would hitch like a whole compile
+    VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibraryFeatures{};
+    pipelineLibraryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+    bool usePipelineLibraries = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_1 &&
+        IsDeviceExtensionSupported(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) &&
+        IsDeviceExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME)) {
+        VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT libraryProperties{};
+        libraryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT;
+
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &libraryProperties;
+        vkGetPhysicalDeviceProperties2(m_Context.physicalDevice, &properties2);
+
+        if (supported.graphicsPipelineLibrary == VK_TRUE &&
+            libraryProperties.graphicsPipelineLibraryFastLinking == VK_TRUE) {
+            pipelineLibraryFeatures.graphicsPipelineLibrary = VK_TRUE;
+            usePipelineLibraries = true;
+            deviceExtensions.push_back(VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        }
+    }
+
+    // Synchronization2 (VK_KHR_synchronization2, core in Vulkan 1.3): the barrier batch
+    // records each transition point as one vkCmdPipelineBarrier2 with per-barrier stages
+    VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+    synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+    bool useSynchronization2 = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_1 &&
+        IsDeviceExtensionSupported(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME)) {
+        VkPhysicalDeviceSynchronization2FeaturesKHR supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        if (supported.synchronization2 == VK_TRUE) {
+            synchronization2Features.synchronization2 = VK_TRUE;
+            useSynchronization2 = true;
+            deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+        }
+    }
+
+    // Present pacing (VK_KHR_present_id + VK_KHR_present_wait)
+    VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures{};
+    presentIdFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+    VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures{};
+    presentWaitFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+    bool usePresentWait = false;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_1 &&
+        IsDeviceExtensionSupported(VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+        IsDeviceExtensionSupported(VK_KHR_PRESENT_WAIT_EXTENSION_NAME)) {
+        presentIdFeatures.pNext = &presentWaitFeatures;
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &presentIdFeatures;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        usePresentWait = presentIdFeatures.presentId == VK_TRUE && presentWaitFeatures.presentWait == VK_TRUE;
+        presentIdFeatures.pNext = nullptr;
+        presentWaitFeatures.pNext = nullptr;
+    }
+
+    if (usePresentWait) {
+        deviceExtensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+        deviceExtensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+    }
+
+    // Acceleration structures (VK_KHR_acceleration_structure): builds read their inputs
+    // and scratch through buffer device addresses (core in Vulkan 1.2)
+    VkPhysicalDeviceAccelerationStructureFeaturesKHR accelerationStructureFeatures{};
+    accelerationStructureFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+    VkPhysicalDeviceBufferDeviceAddressFeatures bufferDeviceAddressFeatures{};
+    bufferDeviceAddressFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+    VkPhysicalDeviceRayQueryFeaturesKHR rayQueryFeatures{};
+    rayQueryFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+    bool useAccelerationStructure = false;
+    bool useRayQuery = false;
+    VkDeviceSize scratchAlignment = 0;
+
+    if (m_Context.deviceProperties.apiVersion >= VK_API_VERSION_1_2 &&
+        IsDeviceExtensionSupported(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME) &&
+        IsDeviceExtensionSupported(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME)) {
+        VkPhysicalDeviceAccelerationStructureFeaturesKHR supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+        VkPhysicalDeviceBufferDeviceAddressFeatures supportedAddress{};
+        supportedAddress.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+        VkPhysicalDeviceRayQueryFeaturesKHR supportedRayQuery{};
+        supportedRayQuery.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+        supported.pNext = &supportedAddress;
+        if (IsDeviceExtensionSupported(VK_KHR_RAY_QUERY_EXTENSION_NAME)) {
+            supportedAddress.pNext = &supportedRayQuery;
+        }
+
+        VkPhysicalDeviceFeatures2 features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported;
+        vkGetPhysicalDeviceFeatures2(m_Context.physicalDevice, &features2);
+
+        if (supported.accelerationStructure == VK_TRUE && supportedAddress.bufferDeviceAddress == VK_TRUE) {
+            VkPhysicalDeviceAccelerationStructurePropertiesKHR properties{};
+            properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR;
+            VkPhysicalDeviceProperties2 properties2{};
+            properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+            properties2.pNext = &properties;
+            vkGetPhysicalDeviceProperties2(m_Context.physicalDevice, &properties2);
+            scratchAlignment = properties.minAccelerationStructureScratchOffsetAlignment;
+
+            accelerationStructureFeatures.accelerationStructure = VK_TRUE;
+            bufferDeviceAddressFeatures.bufferDeviceAddress = VK_TRUE;
+            useAccelerationStructure = true;
+            deviceExtensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+            deviceExtensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+
+            // Ray queries from any shader stage (VK_KHR_ray_query); their SPIR-V 1.4
+            // modules need the Vulkan 1.2 device this path already requires
+            if (supportedRayQuery.rayQuery == VK_TRUE) {
+                rayQueryFeatures.rayQuery = VK_TRUE;
+                useRayQuery = true;
+                deviceExtensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+            }
+        }
+    }
+
+    // Chain the enabled feature structs
+    void* featureChain = nullptr;
+    if (useAccelerationStructure) {
+        bufferDeviceAddressFeatures.pNext = featureChain;
+        accelerationStructureFeatures.pNext = &bufferDeviceAddressFeatures;
+        featureChain = &accelerationStructureFeatures;
+    }
+    if (useRayQuery) {
+        rayQueryFeatures.pNext = featureChain;
+        featureChain = &rayQueryFeatures;
+    }
+    if (usePresentWait) {
+        presentWaitFeatures.pNext = featureChain;
+        presentIdFeatures.pNext = &presentWaitFeatures;
+        featureChain = &presentIdFeatures;
+    }
+    if (useSynchronization2) {
+        synchronization2Features.pNext = featureChain;
+        featureChain = &synchronization2Features;
+    }
+    if (useTimelineSemaphore) {
+        timelineFeatures.pNext = featureChain;
+        featureChain = &timelineFeatures;
+    }
+    if (useShaderFloat16) {
+        float16Int8Features.pNext = featureChain;
+        featureChain = &float16Int8Features;
+    }
+    if (useMultiview) {
+        multiviewFeatures.pNext = featureChain;
+        featureChain = &multiviewFeatures;
+    }
+    if (usePipelineLibraries) {
+        pipelineLibraryFeatures.pNext = featureChain;
+        featureChain = &pipelineLibraryFeatures;
+    }
+    if (useDescriptorIndexing) {
+        descriptorIndexingFeatures.pNext = featureChain;
+        featureChain = &descriptorIndexingFeatures;
+    }
+    if (useDynamicRendering) {
+        dynamicRenderingFeatures.pNext = featureChain;
+        featureChain = &dynamicRenderingFeatures;
+    }
+    if (useShadingRate) {
+        shadingRateFeatures.pNext = featureChain;
+        featureChain = &shadingRateFeatures;
+    }
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = featureChain;
     createInfo.queueCreateInfoCount = static_cast<uint32>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     createInfo.pEnabledFeatures = &deviceFeatures;
@@ -188,16 +886,168 @@ void VulkanDevice::CreateLogicalDevice() {
     
     vkGetDeviceQueue(m_Context.device, m_Context.graphicsQueueFamily, 0, &m_Context.graphicsQueue);
     vkGetDeviceQueue(m_Context.device, m_Context.presentQueueFamily, 0, &m_Context.presentQueue);
+    vkGetDeviceQueue(m_Context.device, m_Context.transferQueueFamily, 0, &m_Context.transferQueue);
+    // The graphics queue waits for it through a timeline semaphore
+    if (asyncComputeQueue && useTimelineSemaphore) {
+        vkGetDeviceQueue(m_Context.device, m_Context.graphicsQueueFamily, 1, &m_Context.computeQueue);
+        METAGFX_INFO << "Async compute queue: graphics family " << m_Context.graphicsQueueFamily << ", queue 1";
+    }
+
+    if (useDynamicRendering) {
+        m_Context.cmdBeginRendering = reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdBeginRenderingKHR"));
+        m_Context.cmdEndRendering = reinterpret_cast<PFN_vkCmdEndRenderingKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdEndRenderingKHR"));
+        m_Context.dynamicRendering = m_Context.cmdBeginRendering && m_Context.cmdEndRendering;
+    }
+
+    m_Context.shadingRateImage = useShadingRate && m_Context.dynamicRendering;
+    m_Context.shadingRateTexelSize = m_Context.shadingRateImage ? shadingRateTexelSize : 0;
+
+    m_Context.descriptorIndexing = useDescriptorIndexing;
+    m_Context.memoryBudget = useMemoryBudget;
+    m_Context.timelineSemaphore = useTimelineSemaphore;
+    m_Context.shaderFloat16 = useShaderFloat16;
+    m_Context.maxMultiviewViews = useMultiview ? maxMultiviewViews : 0;
+    m_Context.graphicsPipelineLibrary = usePipelineLibraries;
+
+    m_Context.multiDrawIndirect = deviceFeatures.multiDrawIndirect == VK_TRUE;
+    if (useDrawIndirectCount) {
+        m_Context.cmdDrawIndexedIndirectCount = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdDrawIndexedIndirectCountKHR"));
+    }
+
+    if (usePushDescriptors) {
+        m_Context.cmdPushDescriptorSet = reinterpret_cast<PFN_vkCmdPushDescriptorSetKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdPushDescriptorSetKHR"));
+    }
+
+    if (useSynchronization2) {
+        m_Context.cmdPipelineBarrier2 = reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdPipelineBarrier2KHR"));
+    }
+
+    if (usePresentWait) {
+        m_Context.waitForPresent = reinterpret_cast<PFN_vkWaitForPresentKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkWaitForPresentKHR"));
+    }
+
+    if (useAccelerationStructure) {
+        m_Context.getBufferDeviceAddress = reinterpret_cast<PFN_vkGetBufferDeviceAddress>(
+            vkGetDeviceProcAddr(m_Context.device, "vkGetBufferDeviceAddress"));
+        m_Context.getAccelerationStructureBuildSizes = reinterpret_cast<PFN_vkGetAccelerationStructureBuildSizesKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkGetAccelerationStructureBuildSizesKHR"));
+        m_Context.createAccelerationStructure = reinterpret_cast<PFN_vkCreateAccelerationStructureKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCreateAccelerationStructureKHR"));
+        m_Context.destroyAccelerationStructure = reinterpret_cast<PFN_vkDestroyAccelerationStructureKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkDestroyAccelerationStructureKHR"));
+        m_Context.getAccelerationStructureDeviceAddress =
+            reinterpret_cast<PFN_vkGetAccelerationStructureDeviceAddressKHR>(
+                vkGetDeviceProcAddr(m_Context.device, "vkGetAccelerationStructureDeviceAddressKHR"));
+        m_Context.cmdBuildAccelerationStructures = reinterpret_cast<PFN_vkCmdBuildAccelerationStructuresKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdBuildAccelerationStructuresKHR"));
+        m_Context.cmdWriteAccelerationStructuresProperties =
+            reinterpret_cast<PFN_vkCmdWriteAccelerationStructuresPropertiesKHR>(
+                vkGetDeviceProcAddr(m_Context.device, "vkCmdWriteAccelerationStructuresPropertiesKHR"));
+        m_Context.cmdCopyAccelerationStructure = reinterpret_cast<PFN_vkCmdCopyAccelerationStructureKHR>(
+            vkGetDeviceProcAddr(m_Context.device, "vkCmdCopyAccelerationStructureKHR"));
+        m_Context.accelerationStructure = m_Context.getBufferDeviceAddress &&
+                                          m_Context.getAccelerationStructureBuildSizes &&
+                                          m_Context.createAccelerationStructure &&
+                                          m_Context.destroyAccelerationStructure &&
+                                          m_Context.getAccelerationStructureDeviceAddress &&
+                                          m_Context.cmdBuildAccelerationStructures &&
+                                          m_Context.cmdWriteAccelerationStructuresProperties &&
+                                          m_Context.cmdCopyAccelerationStructure;
+        m_Context.accelerationStructureScratchAlignment = std::max<VkDeviceSize>(scratchAlignment, 1);
+        m_Context.rayQuery = m_Context.accelerationStructure && useRayQuery;
+    }
+
+    METAGFX_INFO << "Vulkan render path: "
+                 << (m_Context.dynamicRendering ? "dynamic rendering" : "render passes");
+    METAGFX_INFO << "Vulkan bindless textures: "
+                 << (m_Context.descriptorIndexing ? "supported" : "not supported");
+    METAGFX_INFO << "Vulkan shading rate images: "
+                 << (m_Context.shadingRateImage ? "supported" : "not supported");
+    METAGFX_INFO << "Vulkan barriers: "
+                 << (m_Context.cmdPipelineBarrier2 ? "synchronization2" : "legacy");
+    METAGFX_INFO << "Vulkan acceleration structures: "
+                 << (m_Context.accelerationStructure ? "supported" : "not supported");
+    METAGFX_INFO << "Vulkan ray queries: "
+                 << (m_Context.rayQuery ? "supported" : "not supported");
+}
+
+MemoryBudget VulkanDevice::GetMemoryBudget() const {
+    if (!m_Context.memoryBudget) {
+        return GraphicsDevice::GetMemoryBudget();
+    }
+
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+    budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 properties{};
+    properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    properties.pNext = &budgetProperties;
+    vkGetPhysicalDeviceMemoryProperties2(m_Context.physicalDevice, &properties);
+
+    // Device-local heaps only; on integrated GPUs that is the shared system heap
+    MemoryBudget budget;
+    for (uint32 i = 0; i < properties.memoryProperties.memoryHeapCount; ++i) {
+        if (properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) {
+            budget.budgetBytes += budgetProperties.heapBudget[i];
+            budget.usageBytes += budgetProperties.heapUsage[i];
+        }
+    }
+    return budget;
+}
+
+bool VulkanDevice::IsDeviceExtensionSupported(const char* extensionName) const {
+    uint32 extensionCount = 0;
+    vkEnumerateDeviceExtensionProperties(m_Context.physicalDevice, nullptr, &extensionCount, nullptr);
+
+    std::vector<VkExtensionProperties> extensions(extensionCount);
+    vkEnumerateDeviceExtensionProperties(m_Context.physicalDevice, nullptr, &extensionCount, extensions.data());
+
+    for (const auto& extension : extensions) {
+        if (std::strcmp(extension.extensionName, extensionName) == 0) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void VulkanDevice::CreateCommandPool() {
-    VkCommandPoolCreateInfo poolInfo{};
-    poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    poolInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
+    // The creating (render) thread's
+    m_Context.commandPool = GetThreadCommandPool();
+
+    // Per-frame pools: buffers are never reset individually, the whole pool is
+    // reset when its frame slot comes around again
+    VkCommandPoolCreateInfo framePoolInfo{};
+    framePoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    framePoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    framePoolInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
 
-    VK_CHECK(vkCreateCommandPool(m_Context.device, &poolInfo, nullptr, &m_CommandPool));
-    m_Context.commandPool = m_CommandPool;
+    m_FrameCommandPools.resize(m_Context.framesInFlight, VK_NULL_HANDLE);
+    for (uint32 i = 0; i < m_Context.framesInFlight; ++i) {
+        VK_CHECK(vkCreateCommandPool(m_Context.device, &framePoolInfo, nullptr, &m_FrameCommandPools[i]));
+        m_FrameCommandBuffers.push_back(CreateRef<VulkanCommandBuffer>(m_Context, m_FrameCommandPools[i]));
+        // The compute queue shares the family, so its command buffers come from the same pool
+        if (m_Context.computeQueue != VK_NULL_HANDLE) {
+            m_FrameComputeCommandBuffers.push_back(CreateRef<VulkanCommandBuffer>(m_Context, m_FrameCommandPools[i]));
+        }
+    }
+}
+
+VkCommandPool VulkanDevice::GetThreadCommandPool() {
+    std::lock_guard<std::mutex> lock(m_CommandPoolMutex);
+    VkCommandPool& pool = m_ThreadCommandPools[std::this_thread::get_id()];
+    if (pool == VK_NULL_HANDLE) {
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
+        VK_CHECK(vkCreateCommandPool(m_Context.device, &poolInfo, nullptr, &pool));
+    }
+    return pool;
 }
 
 Ref<Buffer> VulkanDevice::CreateBuffer(const BufferDesc& desc) {
@@ -220,109 +1070,279 @@ Ref<DescriptorSet> VulkanDevice::CreateDescriptorSet(const DescriptorSetDesc& de
     return CreateRef<VulkanDescriptorSet>(m_Context, desc);
 }
 
-void VulkanDevice::SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) {
+Ref<Shader> VulkanDevice::CreateShader(const ShaderDesc& desc) {
+    return CreateRef<VulkanShader>(m_Context, desc);
+}
+
+void VulkanDevice::ResolvePipelineTargets(const PipelineDesc& desc, std::vector<VkFormat>& colorFormats,
+                                          VkFormat& depthFormat, VkRenderPass& renderPass) {
+    auto swapChain = std::static_pointer_cast<VulkanSwapChain>(m_SwapChain);
+
+    // Resolve attachment formats (Format::Undefined color = swap chain format)
+    colorFormats.clear();
+    for (Format format : desc.colorFormats) {
+        colorFormats.push_back(ToVulkanFormat(format == Format::Undefined ? swapChain->GetFormat() : format));
+    }
+    depthFormat = ToVulkanFormat(desc.depthFormat);
+
+    // With dynamic rendering the pipeline is created from the formats alone.
+    // Otherwise it needs a compatible render pass; use the same cached one that
+    // BeginRendering() will pick for these attachments.
+    renderPass = VK_NULL_HANDLE;
+    if (!m_Context.dynamicRendering) {
+        VulkanRenderPassKey renderPassKey{};
+        renderPassKey.colorFormats = colorFormats;
+        renderPassKey.depthFormat = depthFormat;
+        renderPassKey.samples = ToVulkanSampleCount(desc.sampleCount);
+        renderPassKey.resolveColor = desc.sampleCount > 1 && !colorFormats.empty();
+        renderPassKey.viewMask = ToVulkanViewMask(desc.viewCount);
+        renderPass = m_RenderPassCache->GetRenderPass(renderPassKey);
+    }
+}
+
+Ref<Pipeline> VulkanDevice::CompileGraphicsPipeline(const PipelineDesc& desc) {
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    ResolvePipelineTargets(desc, colorFormats, depthFormat, renderPass);
+
+    std::vector<VkDescriptorSetLayout> layouts = ResolveSetLayouts(desc);
+    if (m_PipelineLibraries) {
+        if (Ref<VulkanPipeline> pipeline =
+                m_PipelineLibraries->CreatePipeline(desc, renderPass, layouts, colorFormats, depthFormat)) {
+            LaunchPipelineCompile([pipeline]() -> Ref<Pipeline> {
+                pipeline->Optimize();
+                return pipeline;
+            });
+            return pipeline;
+        }
+    }
+    return CreateRef<VulkanPipeline>(m_Context, desc, renderPass, layouts, colorFormats, depthFormat);
+}
+
+Ref<PipelineFuture> VulkanDevice::CompileGraphicsPipelineAsync(const PipelineDesc& desc) {
+    // Device state (swap chain format, render pass cache) is read here;
+    // the job only compiles, which Vulkan allows on any thread
+    std::vector<VkFormat> colorFormats;
+    VkFormat depthFormat = VK_FORMAT_UNDEFINED;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    ResolvePipelineTargets(desc, colorFormats, depthFormat, renderPass);
+
+    VulkanContext* context = &m_Context;
+    VulkanPipelineLibraryCache* libraries = m_PipelineLibraries.get();
+    std::vector<VkDescriptorSetLayout> layouts = ResolveSetLayouts(desc);
+    Ref<PipelineFuture> future = LaunchPipelineCompile(
+        [context, libraries, desc, renderPass, layouts, colorFormats, depthFormat]() -> Ref<Pipeline> {
+            if (libraries) {
+                if (Ref<VulkanPipeline> pipeline =
+                        libraries->CreatePipeline(desc, renderPass, layouts, colorFormats, depthFormat)) {
+                    return pipeline;
+                }
+            }
+            return CreateRef<VulkanPipeline>(*context, desc, renderPass, layouts, colorFormats, depthFormat);
+        });
+
+    // The future is ready with the fast-linked pipeline; the optimized link follows as a
+    // compile of its own (launched here, so WaitForPipelineCompiles() sees it) and swaps
+    // its handle in. Pipelines compiled whole ignore Optimize().
+    if (libraries) {
+        LaunchPipelineCompile([future]() -> Ref<Pipeline> {
+            Ref<Pipeline> pipeline = future->Wait();
+            if (pipeline) {
+                std::static_pointer_cast<VulkanPipeline>(pipeline)->Optimize();
+            }
+            return pipeline;
+        });
+    }
+    return future;
+}
+
+// The set layouts the pipeline is created with, and the swap chain format of
+// Format::Undefined. Set layouts are deduplicated and live as long as the device, so the
+// handles are stable.
+void VulkanDevice::AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const {
+    std::vector<VkDescriptorSetLayout> layouts = ResolveSetLayouts(desc);
+    Format swapChainFormat = std::static_pointer_cast<VulkanSwapChain>(m_SwapChain)->GetFormat();
+    uint32 layoutCount = static_cast<uint32>(layouts.size());
+    key.append(reinterpret_cast<const char*>(&layoutCount), sizeof(layoutCount));
+    key.append(reinterpret_cast<const char*>(layouts.data()), layouts.size() * sizeof(VkDescriptorSetLayout));
+    key.append(reinterpret_cast<const char*>(&swapChainFormat), sizeof(swapChainFormat));
+}
+
+VkDescriptorSetLayout VulkanDevice::ResolveSetLayout(const Ref<DescriptorSet>& descriptorSet) const {
     if (descriptorSet) {
-        VkDescriptorSetLayout layout = static_cast<VkDescriptorSetLayout>(descriptorSet->GetNativeLayout());
-        SetDescriptorSetLayout(layout);
+        return static_cast<VkDescriptorSetLayout>(descriptorSet->GetNativeLayout());
     }
+    return m_Context.descriptorCache->GetSetLayout(VulkanSetLayoutKey{});
 }
 
-Ref<Shader> VulkanDevice::CreateShader(const ShaderDesc& desc) {
-    return CreateRef<VulkanShader>(m_Context, desc);
+std::vector<VkDescriptorSetLayout> VulkanDevice::ResolveSetLayouts(const PipelineDesc& desc) const {
+    std::vector<VkDescriptorSetLayout> layouts = { ResolveSetLayout(desc.descriptorSetLayout) };
+    for (const Ref<DescriptorSet>& setLayout : desc.extraSetLayouts) {
+        if (layouts.size() == MAX_DESCRIPTOR_SETS) {
+            METAGFX_WARN << "Pipeline takes more than " << MAX_DESCRIPTOR_SETS << " descriptor sets";
+            break;
+        }
+        // A set the shaders skip still needs a layout; an empty one is shared
+        layouts.push_back(ResolveSetLayout(setLayout));
+    }
+    return layouts;
 }
 
-Ref<Pipeline> VulkanDevice::CreateGraphicsPipeline(const PipelineDesc& desc) {
-    auto swapChain = std::static_pointer_cast<VulkanSwapChain>(m_SwapChain);
-    
-    VkAttachmentDescription colorAttachment{};
-    colorAttachment.format = ToVulkanFormat(swapChain->GetFormat());
-    colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorAttachmentRef{};
-    colorAttachmentRef.attachment = 0;
-    colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-    // Add depth attachment for compatibility with runtime render pass
-    VkAttachmentDescription depthAttachment{};
-    depthAttachment.format = VK_FORMAT_D32_SFLOAT;
-    depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-    depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    VkAttachmentReference depthAttachmentRef{};
-    depthAttachmentRef.attachment = 1;
-    depthAttachmentRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-    std::vector<VkAttachmentDescription> attachments = { colorAttachment, depthAttachment };
-
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorAttachmentRef;
-    subpass.pDepthStencilAttachment = &depthAttachmentRef;
-
-    VkRenderPassCreateInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
-    renderPassInfo.pAttachments = attachments.data();
-    renderPassInfo.subpassCount = 1;
-    renderPassInfo.pSubpasses = &subpass;
-    
-    VkRenderPass renderPass;
-    VK_CHECK(vkCreateRenderPass(m_Context.device, &renderPassInfo, nullptr, &renderPass));
-    
-    // Create pipeline with descriptor set layout
-    // Note: m_DescriptorSetLayout should be set by the application before creating the pipeline
-    return CreateRef<VulkanPipeline>(m_Context, desc, renderPass, m_DescriptorSetLayout);
+Ref<Pipeline> VulkanDevice::CreateComputePipeline(const ComputePipelineDesc& desc) {
+    return CreateRef<VulkanComputePipeline>(m_Context, desc, ResolveSetLayout(desc.descriptorSetLayout));
 }
 
 Ref<CommandBuffer> VulkanDevice::CreateCommandBuffer() {
-    return CreateRef<VulkanCommandBuffer>(m_Context, m_CommandPool);
+    return CreateRef<VulkanCommandBuffer>(m_Context, GetThreadCommandPool());
+}
+
+FrameContext VulkanDevice::BeginFrame() {
+    auto swapChain = std::static_pointer_cast<VulkanSwapChain>(m_SwapChain);
+    uint32 frameIndex = swapChain->GetCurrentFrame();
+    EndFrameStats();
+
+    // Submit uploads recorded since the last frame so this frame's graphics work is
+    // queued behind their acquire barriers, and recycle batches that have finished
+    m_UploadManager->Flush();
+    m_UploadManager->CollectCompleted();
+    METAGFX_PROFILE_COUNTER("Upload staging bytes", m_UploadManager->GetStagingRingBytesInUse());
+
+    // Resources retired while frames the GPU has now finished were in flight
+    ReleaseRetired();
+
+    // Periodic save, so pipelines compiled this session survive a crash
+    m_PipelineCache->Tick();
+
+    // Present() already waited for the timeline value of this slot's last submission, so
+    // the GPU is done with everything recorded from it framesInFlight frames ago
+    VK_CHECK(vkResetCommandPool(m_Context.device, m_FrameCommandPools[frameIndex], 0));
+
+    FrameContext frame;
+    frame.frameIndex = frameIndex;
+    frame.frameCount = m_Context.framesInFlight;
+    frame.commandBuffer = m_FrameCommandBuffers[frameIndex];
+    if (!m_FrameComputeCommandBuffers.empty()) {
+        frame.computeCommandBuffer = m_FrameComputeCommandBuffers[frameIndex];
+    }
+    m_PendingComputeValue = 0;
+    return frame;
 }
 
 void VulkanDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
     auto vkCmd = std::static_pointer_cast<VulkanCommandBuffer>(commandBuffer);
     auto swapChain = std::static_pointer_cast<VulkanSwapChain>(m_SwapChain);
-    
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    
+    AddSubmittedStats(*vkCmd);
+
+    // One batch per segment of the command buffer: the first waits for the acquire, the
+    // one after WaitForAsyncCompute() for the frame's async compute. Without a segment
+    // there, an empty last batch waits for it, so the frame's timeline value covers the
+    // compute work too (frame slots, retired resources).
+    VkSubmitInfo batches[3] = {};
+    VkCommandBuffer segments[2] = {};
+    uint32 batchCount = 0;
+    for (uint32 i = 0; i < vkCmd->GetSegmentCount(); ++i) {
+        segments[i] = vkCmd->GetSegment(i);
+        VkSubmitInfo& batch = batches[batchCount++];
+        batch.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        batch.commandBufferCount = 1;
+        batch.pCommandBuffers = &segments[i];
+    }
+    VulkanTimeline::Wait computeWait;
+    uint32 waitCount = 0;
+    if (m_PendingComputeValue != 0) {
+        if (batchCount == 1) {
+            batches[batchCount++].sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        }
+        computeWait.batch = 1;
+        computeWait.semaphore = m_ComputeTimeline->GetSemaphore();
+        computeWait.value = m_PendingComputeValue;
+        waitCount = 1;
+        m_PendingComputeValue = 0;
+    }
+
+    // An offscreen swap chain has no acquire or present to order against
     VkSemaphore waitSemaphores[] = { swapChain->GetImageAvailableSemaphore() };
     VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-    
+    batches[0].waitSemaphoreCount = waitSemaphores[0] != VK_NULL_HANDLE ? 1 : 0;
+    batches[0].pWaitSemaphores = waitSemaphores;
+    batches[0].pWaitDstStageMask = waitStages;
+
+    VkSemaphore signalSemaphores[] = { swapChain->GetRenderFinishedSemaphore() };
+    VkSubmitInfo& last = batches[batchCount - 1];
+    last.signalSemaphoreCount = signalSemaphores[0] != VK_NULL_HANDLE ? 1 : 0;
+    last.pSignalSemaphores = signalSemaphores;
+
+    // No wait here: Present() waits for the next slot's value before acquiring
+    swapChain->SetFrameValue(m_Timeline->Submit(batchCount, batches, { &computeWait, waitCount }));
+}
+
+void VulkanDevice::SubmitComputeCommandBuffer(Ref<CommandBuffer> commandBuffer) {
+    if (!m_ComputeTimeline) {
+        GraphicsDevice::SubmitComputeCommandBuffer(commandBuffer);
+        return;
+    }
+    auto vkCmd = std::static_pointer_cast<VulkanCommandBuffer>(commandBuffer);
+    AddSubmittedStats(*vkCmd);
+
     VkCommandBuffer cmdBuffer = vkCmd->GetHandle();
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmdBuffer;
-    
-    VkSemaphore signalSemaphores[] = { swapChain->GetRenderFinishedSemaphore() };
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
-    
-    VkFence fence = swapChain->GetInFlightFence();
 
-    // NO fence wait/reset here - that will be done in Present before acquiring next image
-    VkResult result = vkQueueSubmit(m_Context.graphicsQueue, 1, &submitInfo, fence);
-    if (result != VK_SUCCESS) {
-        METAGFX_ERROR << "Failed to submit command buffer: " << result;
+    // After everything given to the graphics queue so far: the uploads the passes read and
+    // the earlier frames' use of what they overwrite
+    VulkanTimeline::Wait graphicsWait;
+    graphicsWait.semaphore = m_Timeline->GetSemaphore();
+    graphicsWait.value = m_Timeline->GetSignaledValue();
+    graphicsWait.stages = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    m_PendingComputeValue = m_ComputeTimeline->Submit(1, &submitInfo, { &graphicsWait, 1 });
+}
+
+Ref<GpuProfiler> VulkanDevice::CreateGpuProfiler() {
+    if (!m_DeviceInfo.supportsTimestampQueries) {
+        return nullptr;
     }
+    return CreateRef<VulkanGpuProfiler>(m_Context, m_Context.framesInFlight, m_TimestampValidBits);
+}
+
+Ref<AccelerationStructure> VulkanDevice::CreateAccelerationStructure(const AccelerationStructureDesc& desc) {
+    if (!m_Context.accelerationStructure) {
+        return nullptr;
+    }
+    auto structure = CreateRef<VulkanAccelerationStructure>(m_Context, desc);
+    return structure->IsValid() ? structure : nullptr;
+}
+
+uint64 VulkanDevice::SignalValue() const {
+    return m_Timeline->GetSignaledValue();
+}
+
+uint64 VulkanDevice::GetCompletedFrameValue() const {
+    return m_Timeline->GetCompletedValue();
+}
+
+void VulkanDevice::WaitValue(uint64 value) {
+    m_Timeline->Wait(value);
 }
 
 void VulkanDevice::WaitIdle() {
     if (m_Context.device != VK_NULL_HANDLE) {
-        vkDeviceWaitIdle(m_Context.device);
+        if (m_UploadManager) {
+            m_UploadManager->Flush();
+        }
+        // Waits for the queues' timelines rather than vkDeviceWaitIdle(), which must not
+        // overlap submissions from other threads
+        if (m_ComputeTimeline) {
+            m_ComputeTimeline->Wait(m_ComputeTimeline->GetSignaledValue());
+        }
+        if (m_Timeline) {
+            m_Timeline->Wait(m_Timeline->GetSignaledValue());
+        }
+        if (m_UploadManager) {
+            m_UploadManager->CollectCompleted();
+        }
     }
 }
 
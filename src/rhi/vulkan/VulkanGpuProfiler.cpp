@@ -0,0 +1,56 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanGpuProfiler.cpp
+// ============================================================================
+#include "metagfx/rhi/vulkan/VulkanGpuProfiler.h"
+#include "metagfx/rhi/vulkan/VulkanCommandBuffer.h"
+
+namespace metagfx {
+namespace rhi {
+
+VulkanGpuProfiler::VulkanGpuProfiler(VulkanContext& context, uint32 frameCount, uint32 timestampValidBits)
+    : GpuProfiler(frameCount)
+    , m_Context(context)
+    , m_TimestampMask(timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1)
+    , m_TimestampPeriod(context.deviceProperties.limits.timestampPeriod) {
+    VkQueryPoolCreateInfo poolInfo{};
+    poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+    poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    poolInfo.queryCount = frameCount * MAX_QUERIES;
+    VK_CHECK(vkCreateQueryPool(m_Context.device, &poolInfo, nullptr, &m_QueryPool));
+}
+
+VulkanGpuProfiler::~VulkanGpuProfiler() {
+    if (m_QueryPool != VK_NULL_HANDLE) {
+        vkDestroyQueryPool(m_Context.device, m_QueryPool, nullptr);
+    }
+}
+
+void VulkanGpuProfiler::ResetQueries(CommandBuffer& cmd, uint32 frameIndex) {
+    auto& vkCmd = static_cast<VulkanCommandBuffer&>(cmd);
+    vkCmdResetQueryPool(vkCmd.GetHandle(), m_QueryPool, frameIndex * MAX_QUERIES, MAX_QUERIES);
+}
+
+bool VulkanGpuProfiler::WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) {
+    return static_cast<VulkanCommandBuffer&>(cmd).WriteTimestamp(m_QueryPool, frameIndex * MAX_QUERIES + query);
+}
+
+bool VulkanGpuProfiler::ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) {
+    // Value and availability per query. The slot's fence has signalled, so this does
+    // not wait; VK_NOT_READY only means some query was not available.
+    uint64 results[MAX_QUERIES * 2];
+    VkResult result = vkGetQueryPoolResults(m_Context.device, m_QueryPool, frameIndex * MAX_QUERIES, queryCount,
+                                            sizeof(results), results, sizeof(uint64) * 2,
+                                            VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+        return false;
+    }
+    for (uint32 i = 0; i < queryCount; ++i) {
+        nanoseconds[i] = results[i * 2 + 1] != 0
+            ? static_cast<uint64>(static_cast<double>(results[i * 2] & m_TimestampMask) * m_TimestampPeriod)
+            : INVALID_TIMESTAMP;
+    }
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
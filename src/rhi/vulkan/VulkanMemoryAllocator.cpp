@@ -0,0 +1,491 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanMemoryAllocator.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanMemoryAllocator.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+static constexpr VkDeviceSize MIN_BLOCK_SIZE = 1ull * 1024 * 1024;
+static constexpr VkDeviceSize SMALL_HEAP_THRESHOLD = 1024ull * 1024 * 1024;
+static constexpr VkDeviceSize MIN_BUDDY_NODE_SIZE = 256;
+
+static VkDeviceSize AlignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+}
+
+static VkDeviceSize FloorPowerOfTwo(VkDeviceSize value) {
+    VkDeviceSize result = 1;
+    while (result * 2 <= value) {
+        result *= 2;
+    }
+    return result;
+}
+
+// ----------------------------------------------------------------------------
+// VulkanMemoryBlock
+// ----------------------------------------------------------------------------
+
+VulkanMemoryBlock::VulkanMemoryBlock(VkDeviceMemory memory, VkDeviceSize size, uint32 memoryTypeIndex,
+                                     VulkanAllocationStrategy strategy, VkDeviceSize minNodeSize, void* mappedData)
+    : m_Memory(memory), m_Size(size), m_MemoryTypeIndex(memoryTypeIndex),
+      m_Strategy(strategy), m_MappedData(mappedData), m_MinNodeSize(minNodeSize) {
+
+    if (m_Strategy == VulkanAllocationStrategy::Buddy) {
+        // Block size and node size are both powers of two
+        while ((m_MinNodeSize << m_MaxOrder) < m_Size) {
+            ++m_MaxOrder;
+        }
+        m_FreeLists.resize(m_MaxOrder + 1);
+        m_FreeLists[m_MaxOrder].insert(0);
+    }
+}
+
+bool VulkanMemoryBlock::Allocate(VkDeviceSize size, VkDeviceSize alignment, VulkanResourceKind kind,
+                                 VkDeviceSize granularity, VkDeviceSize& outOffset) {
+    if (m_Strategy == VulkanAllocationStrategy::Buddy) {
+        // Nodes are at least bufferImageGranularity in size, so two resources never share a page
+        if (!AllocateBuddy(size, alignment, outOffset)) {
+            return false;
+        }
+    } else {
+        VkDeviceSize offset = m_LinearOffset;
+        if (m_AllocationCount > 0 && kind != m_LastKind) {
+            offset = AlignUp(offset, granularity);
+        }
+        offset = AlignUp(offset, alignment);
+        if (offset + size > m_Size) {
+            return false;
+        }
+        m_LinearOffset = offset + size;
+        m_LastKind = kind;
+        outOffset = offset;
+    }
+
+    m_AllocationCount++;
+    m_BytesInUse += size;
+    return true;
+}
+
+void VulkanMemoryBlock::Free(VkDeviceSize offset, VkDeviceSize size) {
+    if (m_Strategy == VulkanAllocationStrategy::Buddy) {
+        FreeBuddy(offset);
+    }
+
+    m_AllocationCount--;
+    m_BytesInUse -= size;
+
+    // A linear block can only be reused once everything in it has been released
+    if (m_Strategy == VulkanAllocationStrategy::Linear && m_AllocationCount == 0) {
+        m_LinearOffset = 0;
+    }
+}
+
+VkDeviceSize VulkanMemoryBlock::GetFreeBytes() const {
+    if (m_Strategy == VulkanAllocationStrategy::Buddy) {
+        return m_Size - m_BytesReserved;
+    }
+    return m_Size - m_LinearOffset;
+}
+
+VkDeviceSize VulkanMemoryBlock::GetLargestFreeRange() const {
+    if (m_Strategy == VulkanAllocationStrategy::Buddy) {
+        for (uint32 order = m_MaxOrder + 1; order-- > 0;) {
+            if (!m_FreeLists[order].empty()) {
+                return m_MinNodeSize << order;
+            }
+        }
+        return 0;
+    }
+    return m_Size - m_LinearOffset;
+}
+
+bool VulkanMemoryBlock::AllocateBuddy(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset) {
+    // Node offsets are multiples of the node size, so a node at least as large as the
+    // (power-of-two) alignment is always suitably aligned
+    VkDeviceSize needed = std::max(size, alignment);
+    uint32 order = 0;
+    while ((m_MinNodeSize << order) < needed) {
+        if (++order > m_MaxOrder) {
+            return false;
+        }
+    }
+
+    uint32 freeOrder = order;
+    while (freeOrder <= m_MaxOrder && m_FreeLists[freeOrder].empty()) {
+        ++freeOrder;
+    }
+    if (freeOrder > m_MaxOrder) {
+        return false;
+    }
+
+    VkDeviceSize offset = *m_FreeLists[freeOrder].begin();
+    m_FreeLists[freeOrder].erase(m_FreeLists[freeOrder].begin());
+
+    // Split down to the requested order, returning the upper halves to the free lists
+    while (freeOrder > order) {
+        --freeOrder;
+        m_FreeLists[freeOrder].insert(offset + (m_MinNodeSize << freeOrder));
+    }
+
+    m_AllocatedOrders[offset] = order;
+    m_BytesReserved += m_MinNodeSize << order;
+    outOffset = offset;
+    return true;
+}
+
+void VulkanMemoryBlock::FreeBuddy(VkDeviceSize offset) {
+    auto it = m_AllocatedOrders.find(offset);
+    if (it == m_AllocatedOrders.end()) {
+        METAGFX_ERROR << "Vulkan memory: freeing unknown block offset " << offset;
+        return;
+    }
+
+    uint32 order = it->second;
+    m_AllocatedOrders.erase(it);
+    m_BytesReserved -= m_MinNodeSize << order;
+
+    // Coalesce with free buddies
+    while (order < m_MaxOrder) {
+        VkDeviceSize buddy = offset ^ (m_MinNodeSize << order);
+        auto buddyIt = m_FreeLists[order].find(buddy);
+        if (buddyIt == m_FreeLists[order].end()) {
+            break;
+        }
+        m_FreeLists[order].erase(buddyIt);
+        offset = std::min(offset, buddy);
+        ++order;
+    }
+    m_FreeLists[order].insert(offset);
+}
+
+// ----------------------------------------------------------------------------
+// VulkanMemoryAllocator
+// ----------------------------------------------------------------------------
+
+VulkanMemoryAllocator::VulkanMemoryAllocator(VulkanContext& context)
+    : m_Context(context) {
+    m_BufferImageGranularity = std::max<VkDeviceSize>(1, m_Context.deviceProperties.limits.bufferImageGranularity);
+    m_Pools.resize(m_Context.memoryProperties.memoryTypeCount);
+}
+
+VulkanMemoryAllocator::~VulkanMemoryAllocator() {
+    for (auto& pool : m_Pools) {
+        for (auto* blocks : { &pool.buddyBlocks, &pool.linearBlocks }) {
+            for (auto& block : *blocks) {
+                if (!block->IsEmpty()) {
+                    METAGFX_WARN << "Vulkan memory: destroying block with " << block->GetAllocationCount()
+                                 << " live allocations";
+                }
+                if (block->GetMappedData()) {
+                    vkUnmapMemory(m_Context.device, block->GetMemory());
+                }
+                vkFreeMemory(m_Context.device, block->GetMemory(), nullptr);
+            }
+            blocks->clear();
+        }
+    }
+
+    if (m_DedicatedAllocationCount > 0) {
+        METAGFX_WARN << "Vulkan memory: " << m_DedicatedAllocationCount << " dedicated allocations leaked";
+    }
+}
+
+bool VulkanMemoryAllocator::AllocateBuffer(VkBuffer buffer, VkMemoryPropertyFlags properties,
+                                           VulkanAllocation& outAllocation, VulkanAllocationStrategy strategy) {
+    VkMemoryRequirements requirements;
+    vkGetBufferMemoryRequirements(m_Context.device, buffer, &requirements);
+
+    if (!Allocate(requirements, properties, VulkanResourceKind::Buffer, strategy, outAllocation)) {
+        return false;
+    }
+    VK_CHECK(vkBindBufferMemory(m_Context.device, buffer, outAllocation.memory, outAllocation.offset));
+    return true;
+}
+
+bool VulkanMemoryAllocator::AllocateImage(VkImage image, VkMemoryPropertyFlags properties,
+                                          VulkanAllocation& outAllocation, VulkanAllocationStrategy strategy) {
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_Context.device, image, &requirements);
+
+    if (!Allocate(requirements, properties, VulkanResourceKind::Image, strategy, outAllocation)) {
+        return false;
+    }
+    VK_CHECK(vkBindImageMemory(m_Context.device, image, outAllocation.memory, outAllocation.offset));
+    return true;
+}
+
+bool VulkanMemoryAllocator::Allocate(const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties,
+                                     VulkanResourceKind kind, VulkanAllocationStrategy strategy,
+                                     VulkanAllocation& outAllocation) {
+    // HOST_CACHED and HOST_COHERENT are preferences, not requirements: drop them one
+    // at a time until a memory type matches (non-coherent memory is flushed in Flush()).
+    // LAZILY_ALLOCATED is one too; only tile-based GPUs have it.
+    uint32 memoryTypeIndex = 0;
+    VkMemoryPropertyFlags candidates[] = {
+        properties,
+        properties & ~VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+        properties & ~(VK_MEMORY_PROPERTY_HOST_CACHED_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT),
+        properties & ~VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT
+    };
+    bool found = false;
+    for (VkMemoryPropertyFlags candidate : candidates) {
+        if (FindMemoryType(requirements.memoryTypeBits, candidate, memoryTypeIndex)) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        METAGFX_ERROR << "Vulkan memory: no suitable memory type (properties=" << properties << ")";
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Lazily allocated memory (transient attachments) gets one allocation per image;
+    // the driver commits it only if the attachment leaves tile memory
+    bool lazy = (m_Context.memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+                 VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+    VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+    if (lazy || requirements.size > blockSize / 2) {
+        return AllocateDedicated(requirements, memoryTypeIndex, outAllocation);
+    }
+
+    MemoryPool& pool = m_Pools[memoryTypeIndex];
+    auto& blocks = strategy == VulkanAllocationStrategy::Buddy ? pool.buddyBlocks : pool.linearBlocks;
+
+    VulkanMemoryBlock* target = nullptr;
+    VkDeviceSize offset = 0;
+    for (auto& block : blocks) {
+        if (block->Allocate(requirements.size, requirements.alignment, kind, m_BufferImageGranularity, offset)) {
+            target = block.get();
+            break;
+        }
+    }
+
+    if (!target) {
+        void* mapped = nullptr;
+        VkDeviceMemory memory = AllocateDeviceMemory(blockSize, memoryTypeIndex, &mapped);
+        if (memory == VK_NULL_HANDLE) {
+            // Not enough room for a whole block; try an exact-size allocation instead
+            return AllocateDedicated(requirements, memoryTypeIndex, outAllocation);
+        }
+
+        VkDeviceSize minNodeSize = std::min(blockSize, std::max(MIN_BUDDY_NODE_SIZE, m_BufferImageGranularity));
+        blocks.push_back(CreateScope<VulkanMemoryBlock>(memory, blockSize, memoryTypeIndex, strategy,
+                                                        minNodeSize, mapped));
+        target = blocks.back().get();
+
+        METAGFX_DEBUG << "Vulkan memory: new " << (strategy == VulkanAllocationStrategy::Buddy ? "buddy" : "linear")
+                      << " block of " << (blockSize / (1024 * 1024)) << " MB in memory type " << memoryTypeIndex;
+
+        if (!target->Allocate(requirements.size, requirements.alignment, kind, m_BufferImageGranularity, offset)) {
+            METAGFX_ERROR << "Vulkan memory: allocation of " << requirements.size << " bytes does not fit a new block";
+            return false;
+        }
+    }
+
+    outAllocation.memory = target->GetMemory();
+    outAllocation.offset = offset;
+    outAllocation.size = requirements.size;
+    outAllocation.mappedData = target->GetMappedData()
+        ? static_cast<uint8*>(target->GetMappedData()) + offset
+        : nullptr;
+    outAllocation.memoryTypeIndex = memoryTypeIndex;
+    outAllocation.block = target;
+    return true;
+}
+
+void VulkanMemoryAllocator::Free(VulkanAllocation& allocation) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (!allocation.block) {
+        // Dedicated: freeing mapped memory implicitly unmaps it
+        vkFreeMemory(m_Context.device, allocation.memory, nullptr);
+        m_DedicatedAllocationCount--;
+        m_DedicatedBytes -= allocation.size;
+        allocation = VulkanAllocation{};
+        return;
+    }
+
+    VulkanMemoryBlock* block = allocation.block;
+    block->Free(allocation.offset, allocation.size);
+
+    if (block->IsEmpty()) {
+        // Keep one empty block per pool around to avoid churn when resources are recreated
+        MemoryPool& pool = m_Pools[block->GetMemoryTypeIndex()];
+        auto& blocks = block->GetStrategy() == VulkanAllocationStrategy::Buddy ? pool.buddyBlocks : pool.linearBlocks;
+        size_t emptyCount = std::count_if(blocks.begin(), blocks.end(),
+                                          [](const Scope<VulkanMemoryBlock>& b) { return b->IsEmpty(); });
+        if (emptyCount > 1) {
+            auto it = std::find_if(blocks.begin(), blocks.end(),
+                                   [block](const Scope<VulkanMemoryBlock>& b) { return b.get() == block; });
+            if (block->GetMappedData()) {
+                vkUnmapMemory(m_Context.device, block->GetMemory());
+            }
+            vkFreeMemory(m_Context.device, block->GetMemory(), nullptr);
+            blocks.erase(it);
+        }
+    }
+
+    allocation = VulkanAllocation{};
+}
+
+void VulkanMemoryAllocator::Flush(const VulkanAllocation& allocation, VkDeviceSize offset, VkDeviceSize size) {
+    if (!allocation.IsValid()) {
+        return;
+    }
+
+    VkMemoryPropertyFlags flags = m_Context.memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+    if (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+        return;
+    }
+
+    // Flush ranges must be aligned to nonCoherentAtomSize
+    VkDeviceSize atomSize = std::max<VkDeviceSize>(1, m_Context.deviceProperties.limits.nonCoherentAtomSize);
+    VkDeviceSize memorySize = allocation.block ? allocation.block->GetSize() : allocation.size;
+    VkDeviceSize begin = allocation.offset + offset;
+    VkDeviceSize alignedBegin = begin / atomSize * atomSize;
+    VkDeviceSize alignedEnd = AlignUp(begin + size, atomSize);
+
+    VkMappedMemoryRange range{};
+    range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+    range.memory = allocation.memory;
+    range.offset = alignedBegin;
+    range.size = alignedEnd >= memorySize ? VK_WHOLE_SIZE : alignedEnd - alignedBegin;
+    VK_CHECK(vkFlushMappedMemoryRanges(m_Context.device, 1, &range));
+}
+
+VulkanMemoryStats VulkanMemoryAllocator::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VulkanMemoryStats stats{};
+    uint64 contiguousFree = 0;
+
+    for (const auto& pool : m_Pools) {
+        for (const auto* blocks : { &pool.buddyBlocks, &pool.linearBlocks }) {
+            for (const auto& block : *blocks) {
+                VkDeviceSize largest = block->GetLargestFreeRange();
+                stats.blockCount++;
+                stats.allocationCount += block->GetAllocationCount();
+                stats.bytesReserved += block->GetSize();
+                stats.bytesInUse += block->GetBytesInUse();
+                stats.bytesFree += block->GetFreeBytes();
+                stats.largestFreeRange = std::max<uint64>(stats.largestFreeRange, largest);
+                contiguousFree += largest;
+            }
+        }
+    }
+
+    stats.dedicatedAllocationCount = m_DedicatedAllocationCount;
+    stats.allocationCount += m_DedicatedAllocationCount;
+    stats.bytesReserved += m_DedicatedBytes;
+    stats.bytesInUse += m_DedicatedBytes;
+
+    if (stats.bytesFree > 0) {
+        stats.fragmentation = 1.0f - static_cast<float>(static_cast<double>(contiguousFree) / stats.bytesFree);
+    }
+    return stats;
+}
+
+void VulkanMemoryAllocator::LogStats() const {
+    VulkanMemoryStats stats = GetStats();
+    METAGFX_INFO << "Vulkan memory: " << stats.allocationCount << " allocations in "
+                 << stats.blockCount << " blocks + " << stats.dedicatedAllocationCount << " dedicated";
+    METAGFX_INFO << "  Reserved: " << (stats.bytesReserved / 1024) << " KB, in use: "
+                 << (stats.bytesInUse / 1024) << " KB, free: " << (stats.bytesFree / 1024) << " KB";
+    METAGFX_INFO << "  Largest free range: " << (stats.largestFreeRange / 1024) << " KB, fragmentation: "
+                 << static_cast<int>(stats.fragmentation * 100.0f) << "%";
+}
+
+bool VulkanMemoryAllocator::FindMemoryType(uint32 typeBits, VkMemoryPropertyFlags properties,
+                                           uint32& outIndex) const {
+    for (uint32 i = 0; i < m_Context.memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1 << i)) &&
+            (m_Context.memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            outIndex = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+VkDeviceSize VulkanMemoryAllocator::GetBlockSize(uint32 memoryTypeIndex) const {
+    uint32 heapIndex = m_Context.memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+    VkDeviceSize heapSize = m_Context.memoryProperties.memoryHeaps[heapIndex].size;
+
+    // Small heaps (e.g. the 256 MB BAR heap) get proportionally smaller blocks
+    if (heapSize >= SMALL_HEAP_THRESHOLD) {
+        return DEFAULT_BLOCK_SIZE;
+    }
+    return std::max(MIN_BLOCK_SIZE, FloorPowerOfTwo(heapSize / 8));
+}
+
+bool VulkanMemoryAllocator::IsHostVisible(uint32 memoryTypeIndex) const {
+    return (m_Context.memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags &
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) != 0;
+}
+
+VkDeviceMemory VulkanMemoryAllocator::AllocateDeviceMemory(VkDeviceSize size, uint32 memoryTypeIndex,
+                                                           void** outMapped) {
+    VkMemoryAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    allocInfo.allocationSize = size;
+    allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+    // Any buffer placed in the block may need its device address (acceleration structure
+    // inputs, storage and scratch)
+    VkMemoryAllocateFlagsInfo flagsInfo{};
+    flagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO;
+    flagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT;
+    if (m_Context.accelerationStructure) {
+        allocInfo.pNext = &flagsInfo;
+    }
+
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    VkResult result = vkAllocateMemory(m_Context.device, &allocInfo, nullptr, &memory);
+    if (result != VK_SUCCESS) {
+        METAGFX_WARN << "Vulkan memory: vkAllocateMemory(" << size << ") failed: " << result;
+        return VK_NULL_HANDLE;
+    }
+    m_Context.stats->AddAllocation();
+
+    *outMapped = nullptr;
+    if (IsHostVisible(memoryTypeIndex)) {
+        // Host-visible memory stays mapped for its whole lifetime
+        VK_CHECK(vkMapMemory(m_Context.device, memory, 0, VK_WHOLE_SIZE, 0, outMapped));
+    }
+    return memory;
+}
+
+bool VulkanMemoryAllocator::AllocateDedicated(const VkMemoryRequirements& requirements, uint32 memoryTypeIndex,
+                                              VulkanAllocation& outAllocation) {
+    void* mapped = nullptr;
+    VkDeviceMemory memory = AllocateDeviceMemory(requirements.size, memoryTypeIndex, &mapped);
+    if (memory == VK_NULL_HANDLE) {
+        METAGFX_ERROR << "Vulkan memory: failed to allocate " << requirements.size << " bytes";
+        return false;
+    }
+
+    m_DedicatedAllocationCount++;
+    m_DedicatedBytes += requirements.size;
+
+    outAllocation.memory = memory;
+    outAllocation.offset = 0;
+    outAllocation.size = requirements.size;
+    outAllocation.mappedData = mapped;
+    outAllocation.memoryTypeIndex = memoryTypeIndex;
+    outAllocation.block = nullptr;
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -3,70 +3,87 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/vulkan/VulkanPipeline.h"
+#include "metagfx/rhi/vulkan/VulkanDescriptorCache.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineCache.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineLibrary.h"
 #include "metagfx/rhi/vulkan/VulkanShader.h"
 
+#include <cstddef>
+
 namespace metagfx {
 namespace rhi {
 
-VulkanPipeline::VulkanPipeline(VulkanContext& context, const PipelineDesc& desc, 
-                               VkRenderPass renderPass, VkDescriptorSetLayout descriptorSetLayout)
-    : m_Context(context) {
-    
+VulkanGraphicsPipelineState::VulkanGraphicsPipelineState(const VulkanContext& context, const PipelineDesc& desc,
+                                                         VkRenderPass pass, const std::vector<VkFormat>& formats,
+                                                         VkFormat depthFormat)
+    : renderPass(pass), colorFormats(formats) {
+
     // Shader stages
     auto vertShader = std::static_pointer_cast<VulkanShader>(desc.vertexShader);
     auto fragShader = std::static_pointer_cast<VulkanShader>(desc.fragmentShader);
     
-    VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
-    vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-    vertShaderStageInfo.module = vertShader->GetModule();
-    vertShaderStageInfo.pName = vertShader->GetEntryPoint().c_str();
+    vertexStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    vertexStage.stage = VK_SHADER_STAGE_VERTEX_BIT;
+    vertexStage.module = vertShader->GetModule();
+    vertexStage.pName = vertShader->GetEntryPoint().c_str();
     
-    VkPipelineShaderStageCreateInfo fragShaderStageInfo{};
-    fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    fragShaderStageInfo.module = fragShader->GetModule();
-    fragShaderStageInfo.pName = fragShader->GetEntryPoint().c_str();
+    hasFragmentShader = fragShader != nullptr;
+    if (hasFragmentShader) {
+        fragmentStage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        fragmentStage.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+        fragmentStage.module = fragShader->GetModule();
+        fragmentStage.pName = fragShader->GetEntryPoint().c_str();
+    }
     
-    VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
+    // One specialization info for both stages; a stage ignores ids it does not declare
+    for (size_t i = 0; i < desc.specializationConstants.size(); ++i) {
+        VkSpecializationMapEntry entry{};
+        entry.constantID = desc.specializationConstants[i].id;
+        entry.offset = static_cast<uint32>(i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, value));
+        entry.size = sizeof(uint32);
+        specializationEntries.push_back(entry);
+    }
+
+    specializationInfo.mapEntryCount = static_cast<uint32>(specializationEntries.size());
+    specializationInfo.pMapEntries = specializationEntries.data();
+    specializationInfo.dataSize = desc.specializationConstants.size() * sizeof(SpecializationConstant);
+    specializationInfo.pData = desc.specializationConstants.data();
+    if (!specializationEntries.empty()) {
+        vertexStage.pSpecializationInfo = &specializationInfo;
+        fragmentStage.pSpecializationInfo = &specializationInfo;
+    }
     
     // Vertex input
-    std::vector<VkVertexInputAttributeDescription> attributeDescs;
     for (const auto& attr : desc.vertexInput.attributes) {
         VkVertexInputAttributeDescription attrDesc{};
         attrDesc.location = attr.location;
         attrDesc.binding = 0;
         attrDesc.format = ToVulkanFormat(attr.format);
         attrDesc.offset = attr.offset;
-        attributeDescs.push_back(attrDesc);
+        attributes.push_back(attrDesc);
     }
     
-    VkVertexInputBindingDescription bindingDesc{};
-    bindingDesc.binding = 0;
-    bindingDesc.stride = desc.vertexInput.stride;
-    bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+    binding.binding = 0;
+    binding.stride = desc.vertexInput.stride;
+    binding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
     
-    VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
-    vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-    vertexInputInfo.vertexBindingDescriptionCount = 1;
-    vertexInputInfo.pVertexBindingDescriptions = &bindingDesc;
-    vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32>(attributeDescs.size());
-    vertexInputInfo.pVertexAttributeDescriptions = attributeDescs.data();
+    vertexInput.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+    vertexInput.vertexBindingDescriptionCount = 1;
+    vertexInput.pVertexBindingDescriptions = &binding;
+    vertexInput.vertexAttributeDescriptionCount = static_cast<uint32>(attributes.size());
+    vertexInput.pVertexAttributeDescriptions = attributes.data();
     
     // Input assembly
-    VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
     inputAssembly.topology = ToVulkanTopology(desc.topology);
     inputAssembly.primitiveRestartEnable = VK_FALSE;
     
     // Viewport and scissor (dynamic)
-    VkPipelineViewportStateCreateInfo viewportState{};
-    viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-    viewportState.viewportCount = 1;
-    viewportState.scissorCount = 1;
+    viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
     
     // Rasterization
-    VkPipelineRasterizationStateCreateInfo rasterizer{};
     rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
     rasterizer.depthClampEnable = desc.rasterization.depthClampEnable ? VK_TRUE : VK_FALSE;
     rasterizer.rasterizerDiscardEnable = VK_FALSE;
@@ -77,94 +94,180 @@ VulkanPipeline::VulkanPipeline(VulkanContext& context, const PipelineDesc& desc,
     rasterizer.depthBiasEnable = desc.rasterization.depthBiasEnable ? VK_TRUE : VK_FALSE;
     
     // Multisampling
-    VkPipelineMultisampleStateCreateInfo multisampling{};
     multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
     multisampling.sampleShadingEnable = VK_FALSE;
-    multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+    multisampling.rasterizationSamples = ToVulkanSampleCount(desc.sampleCount);
     
     // Depth stencil
-    VkPipelineDepthStencilStateCreateInfo depthStencil{};
     depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
     depthStencil.depthTestEnable = desc.depthStencil.depthTestEnable ? VK_TRUE : VK_FALSE;
     depthStencil.depthWriteEnable = desc.depthStencil.depthWriteEnable ? VK_TRUE : VK_FALSE;
     depthStencil.depthCompareOp = ToVulkanCompareOp(desc.depthStencil.depthCompareOp);
     depthStencil.stencilTestEnable = desc.depthStencil.stencilTestEnable ? VK_TRUE : VK_FALSE;
     
-    // Color blending
+    // Color blending (one state per color attachment; none for depth-only pipelines)
     VkPipelineColorBlendAttachmentState colorBlendAttachment{};
     colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT |
                                           VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
     colorBlendAttachment.blendEnable = VK_FALSE;
+    blendAttachments.assign(colorFormats.size(), colorBlendAttachment);
+    for (size_t i = 0; i < blendAttachments.size() && i < desc.colorAttachments.size(); ++i) {
+        if (!desc.colorAttachments[i].writeEnable) {
+            blendAttachments[i].colorWriteMask = 0;
+        }
+        // The factors of the blend mode, as Metal and WebGPU blend
+        if (desc.colorAttachments[i].blendEnable) {
+            VkPipelineColorBlendAttachmentState& blend = blendAttachments[i];
+            blend.blendEnable = VK_TRUE;
+            blend.colorBlendOp = VK_BLEND_OP_ADD;
+            blend.alphaBlendOp = VK_BLEND_OP_ADD;
+            switch (desc.colorAttachments[i].blendMode) {
+                case BlendMode::Alpha:
+                    blend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+                    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+                    break;
+                case BlendMode::Additive:
+                    blend.srcColorBlendFactor = VK_BLEND_FACTOR_ONE;
+                    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE;
+                    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+                    break;
+                case BlendMode::Attenuate:
+                    blend.srcColorBlendFactor = VK_BLEND_FACTOR_ZERO;
+                    blend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                    blend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+                    blend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+                    break;
+            }
+        }
+    }
     
-    VkPipelineColorBlendStateCreateInfo colorBlending{};
     colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
     colorBlending.logicOpEnable = VK_FALSE;
-    colorBlending.attachmentCount = 1;
-    colorBlending.pAttachments = &colorBlendAttachment;
+    colorBlending.attachmentCount = static_cast<uint32>(blendAttachments.size());
+    colorBlending.pAttachments = blendAttachments.data();
     
     // Dynamic state
-    VkDynamicState dynamicStates[] = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-    
-    VkPipelineDynamicStateCreateInfo dynamicState{};
     dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
     dynamicState.dynamicStateCount = 2;
     dynamicState.pDynamicStates = dynamicStates;
-    
-    // Pipeline layout with push constants for camera position and material flags
-    VkPushConstantRange pushConstantRange{};
-    pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    pushConstantRange.offset = 0;
-    pushConstantRange.size = 32;  // vec4 cameraPosition + uint materialFlags + padding (32 bytes)
 
-    VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-    pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+    // Dynamic rendering: no render pass, attachment formats are given directly
+    if (renderPass == VK_NULL_HANDLE) {
+        renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+        renderingInfo.colorAttachmentCount = static_cast<uint32>(colorFormats.size());
+        renderingInfo.pColorAttachmentFormats = colorFormats.data();
+        renderingInfo.depthAttachmentFormat = depthFormat;
+        renderingInfo.viewMask = ToVulkanViewMask(desc.viewCount);
+        if (depthFormat == VK_FORMAT_D24_UNORM_S8_UINT || depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT) {
+            renderingInfo.stencilAttachmentFormat = depthFormat;
+        }
+    }
+
+    // Any pass may bring a shading rate image, whose rate replaces the pipeline's 1x1
+    shadingRateImage = renderPass == VK_NULL_HANDLE && context.shadingRateImage;
+    if (shadingRateImage) {
+        shadingRateState.sType = VK_STRUCTURE_TYPE_PIPELINE_FRAGMENT_SHADING_RATE_STATE_CREATE_INFO_KHR;
+        shadingRateState.fragmentSize = { 1, 1 };
+        shadingRateState.combinerOps[0] = VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR;
+        shadingRateState.combinerOps[1] = VK_FRAGMENT_SHADING_RATE_COMBINER_OP_REPLACE_KHR;
+        renderingInfo.pNext = &shadingRateState;
+    }
+}
+
+void VulkanGraphicsPipelineState::ChainRendering(VkGraphicsPipelineCreateInfo& info) {
+    info.renderPass = renderPass;
+    info.subpass = 0;
+    if (renderPass == VK_NULL_HANDLE) {
+        if (shadingRateImage) {
+            shadingRateState.pNext = info.pNext;
+        } else {
+            renderingInfo.pNext = info.pNext;
+        }
+        info.pNext = &renderingInfo;
+    }
+    if (shadingRateImage) {
+        info.flags |= VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+    }
+}
 
-    if (descriptorSetLayout != VK_NULL_HANDLE) {
-        METAGFX_INFO << "Pipeline using descriptor set layout: " << descriptorSetLayout;
-        pipelineLayoutInfo.setLayoutCount = 1;
-        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
-    } else {
+VkPipelineLayout GetGraphicsPipelineLayout(VulkanContext& context, const std::vector<VkDescriptorSetLayout>& setLayouts) {
+    // Shared pipeline layout with push constants for the per-material words
+    // (model: materialFlags + materialIndex; skybox: exposure + lod; tone mapping: exposure + operator)
+    if (setLayouts.empty() || setLayouts[0] == VK_NULL_HANDLE) {
         METAGFX_WARN << "Pipeline created WITHOUT descriptor set layout!";
-        pipelineLayoutInfo.setLayoutCount = 0;
     }
+    VulkanPipelineLayoutKey layoutKey;
+    layoutKey.setLayouts = setLayouts;
+    layoutKey.pushConstantStages = VK_SHADER_STAGE_FRAGMENT_BIT;
+    layoutKey.pushConstantSize = 16;
+    return context.descriptorCache->GetPipelineLayout(layoutKey);
+}
 
-    pipelineLayoutInfo.pushConstantRangeCount = 1;
-    pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+VulkanPipeline::VulkanPipeline(VulkanContext& context, const PipelineDesc& desc, 
+                               VkRenderPass renderPass, const std::vector<VkDescriptorSetLayout>& setLayouts,
+                               const std::vector<VkFormat>& colorFormats, VkFormat depthFormat)
+    : m_Context(context) {
+    
+    VulkanGraphicsPipelineState state(m_Context, desc, renderPass, colorFormats, depthFormat);
+    VkPipelineShaderStageCreateInfo shaderStages[] = { state.vertexStage, state.fragmentStage };
 
-    VK_CHECK(vkCreatePipelineLayout(m_Context.device, &pipelineLayoutInfo, nullptr, &m_Layout));
+    m_Layout = GetGraphicsPipelineLayout(m_Context, setLayouts);
     
     // Create graphics pipeline
     VkGraphicsPipelineCreateInfo pipelineInfo{};
     pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-    pipelineInfo.stageCount = 2;
+    pipelineInfo.stageCount = state.hasFragmentShader ? 2 : 1;
     pipelineInfo.pStages = shaderStages;
-    pipelineInfo.pVertexInputState = &vertexInputInfo;
-    pipelineInfo.pInputAssemblyState = &inputAssembly;
-    pipelineInfo.pViewportState = &viewportState;
-    pipelineInfo.pRasterizationState = &rasterizer;
-    pipelineInfo.pMultisampleState = &multisampling;
-    pipelineInfo.pDepthStencilState = &depthStencil;
-    pipelineInfo.pColorBlendState = &colorBlending;
-    pipelineInfo.pDynamicState = &dynamicState;
+    pipelineInfo.pVertexInputState = &state.vertexInput;
+    pipelineInfo.pInputAssemblyState = &state.inputAssembly;
+    pipelineInfo.pViewportState = &state.viewport;
+    pipelineInfo.pRasterizationState = &state.rasterizer;
+    pipelineInfo.pMultisampleState = &state.multisampling;
+    pipelineInfo.pDepthStencilState = &state.depthStencil;
+    pipelineInfo.pColorBlendState = &state.colorBlending;
+    pipelineInfo.pDynamicState = &state.dynamicState;
     pipelineInfo.layout = m_Layout;
-    pipelineInfo.renderPass = renderPass;
-    pipelineInfo.subpass = 0;
+    state.ChainRendering(pipelineInfo);
     
-    VK_CHECK(vkCreateGraphicsPipelines(m_Context.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_Pipeline));
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkPipelineCache cache = m_Context.pipelineCache ? m_Context.pipelineCache->GetHandle() : VK_NULL_HANDLE;
+    VK_CHECK(vkCreateGraphicsPipelines(m_Context.device, cache, 1, &pipelineInfo, nullptr, &pipeline));
+    m_Pipeline.store(pipeline, std::memory_order_release);
+    if (m_Context.pipelineCache) {
+        m_Context.pipelineCache->MarkDirty();
+    }
     
     METAGFX_DEBUG << "Vulkan graphics pipeline created";
 }
 
+VulkanPipeline::VulkanPipeline(VulkanContext& context, VkPipelineLayout layout,
+                               std::vector<Ref<VulkanPipelineLibrary>> libraries)
+    : m_Context(context), m_Layout(layout), m_Libraries(std::move(libraries)) {
+    m_FastLinked = LinkPipelineLibraries(m_Context, m_Layout, m_Libraries, false);
+    m_Pipeline.store(m_FastLinked, std::memory_order_release);
+}
+
+void VulkanPipeline::Optimize() {
+    if (m_Libraries.empty()) {
+        return;
+    }
+    VkPipeline optimized = LinkPipelineLibraries(m_Context, m_Layout, m_Libraries, true);
+    if (optimized != VK_NULL_HANDLE) {
+        m_Pipeline.store(optimized, std::memory_order_release);
+    }
+    m_Libraries.clear();
+}
+
 VulkanPipeline::~VulkanPipeline() {
-    if (m_Pipeline != VK_NULL_HANDLE) {
-        vkDestroyPipeline(m_Context.device, m_Pipeline, nullptr);
+    VkPipeline pipeline = m_Pipeline.load(std::memory_order_acquire);
+    if (pipeline != VK_NULL_HANDLE) {
+        vkDestroyPipeline(m_Context.device, pipeline, nullptr);
     }
-    
-    if (m_Layout != VK_NULL_HANDLE) {
-        vkDestroyPipelineLayout(m_Context.device, m_Layout, nullptr);
+    if (m_FastLinked != VK_NULL_HANDLE && m_FastLinked != pipeline) {
+        vkDestroyPipeline(m_Context.device, m_FastLinked, nullptr);
     }
 }
 
@@ -0,0 +1,189 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanPipelineCache.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineCache.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+constexpr uint32 PIPELINE_CACHE_MAGIC = 0x43505647;  // "GVPC"
+constexpr uint32 PIPELINE_CACHE_VERSION = 1;
+
+// Precedes the driver's blob in the file
+struct PipelineCacheFileHeader {
+    uint32 magic;
+    uint32 version;
+    uint32 vendorID;
+    uint32 deviceID;
+    uint32 driverVersion;
+    uint8 pipelineCacheUUID[VK_UUID_SIZE];
+    uint64 dataSize;
+};
+
+PipelineCacheFileHeader MakeHeader(const VkPhysicalDeviceProperties& properties, uint64 dataSize) {
+    PipelineCacheFileHeader header{};
+    header.magic = PIPELINE_CACHE_MAGIC;
+    header.version = PIPELINE_CACHE_VERSION;
+    header.vendorID = properties.vendorID;
+    header.deviceID = properties.deviceID;
+    header.driverVersion = properties.driverVersion;
+    std::memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = dataSize;
+    return header;
+}
+
+} // namespace
+
+VulkanPipelineCache::VulkanPipelineCache(VulkanContext& context, const std::string& filePath)
+    : m_Context(context), m_FilePath(filePath) {
+    std::vector<uint8> initialData;
+    if (!m_FilePath.empty() && Load(initialData)) {
+        METAGFX_INFO << "Loaded pipeline cache: " << m_FilePath << " (" << initialData.size() / 1024 << " KB)";
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = initialData.size();
+    createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    VkResult result = vkCreatePipelineCache(m_Context.device, &createInfo, nullptr, &m_Cache);
+    if (result != VK_SUCCESS && !initialData.empty()) {
+        // The driver rejected the blob despite a matching header; start empty
+        METAGFX_WARN << "Pipeline cache data rejected by the driver, starting empty";
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData = nullptr;
+        result = vkCreatePipelineCache(m_Context.device, &createInfo, nullptr, &m_Cache);
+    }
+    if (result != VK_SUCCESS) {
+        METAGFX_ERROR << "Failed to create pipeline cache: " << result;
+        m_Cache = VK_NULL_HANDLE;  // Pipelines are then created without a cache
+    }
+}
+
+VulkanPipelineCache::~VulkanPipelineCache() {
+    if (m_Cache == VK_NULL_HANDLE) {
+        return;
+    }
+    if (m_Dirty.load(std::memory_order_relaxed)) {
+        Save();
+    }
+    vkDestroyPipelineCache(m_Context.device, m_Cache, nullptr);
+}
+
+void VulkanPipelineCache::Tick() {
+    if (++m_FramesSinceSave < SAVE_INTERVAL_FRAMES) {
+        return;
+    }
+    m_FramesSinceSave = 0;
+    if (m_Dirty.load(std::memory_order_relaxed)) {
+        Save();
+    }
+}
+
+bool VulkanPipelineCache::Save() {
+    if (m_FilePath.empty() || m_Cache == VK_NULL_HANDLE) {
+        return false;
+    }
+
+    // Cleared first: a pipeline created while the data is read is saved next time
+    m_Dirty.store(false, std::memory_order_relaxed);
+
+    size_t dataSize = 0;
+    VK_CHECK(vkGetPipelineCacheData(m_Context.device, m_Cache, &dataSize, nullptr));
+    std::vector<uint8> data(dataSize);
+    if (dataSize > 0) {
+        // VK_INCOMPLETE if the cache grew in between; the partial blob is still valid
+        VkResult result = vkGetPipelineCacheData(m_Context.device, m_Cache, &dataSize, data.data());
+        if (result != VK_SUCCESS && result != VK_INCOMPLETE) {
+            METAGFX_WARN << "Failed to read pipeline cache data: " << result;
+            return false;
+        }
+        data.resize(dataSize);
+    }
+
+    // Written next to the old file and renamed over it, so a crash never leaves a torn cache
+    PipelineCacheFileHeader header = MakeHeader(m_Context.deviceProperties, data.size());
+    std::string tempPath = m_FilePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            METAGFX_WARN << "Failed to write pipeline cache: " << m_FilePath;
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            METAGFX_WARN << "Failed to write pipeline cache: " << m_FilePath;
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, m_FilePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        METAGFX_WARN << "Failed to write pipeline cache: " << m_FilePath;
+        return false;
+    }
+
+    METAGFX_DEBUG << "Saved pipeline cache: " << m_FilePath << " (" << data.size() / 1024 << " KB)";
+    return true;
+}
+
+bool VulkanPipelineCache::Load(std::vector<uint8>& outData) const {
+    std::ifstream in(m_FilePath, std::ios::binary);
+    if (!in.is_open()) {
+        return false;  // First run
+    }
+
+    PipelineCacheFileHeader header{};
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        header.magic != PIPELINE_CACHE_MAGIC || header.version != PIPELINE_CACHE_VERSION) {
+        METAGFX_WARN << "Ignoring invalid pipeline cache: " << m_FilePath;
+        return false;
+    }
+
+    // Blobs from another GPU or driver are at best useless and at worst crash the driver
+    PipelineCacheFileHeader expected = MakeHeader(m_Context.deviceProperties, header.dataSize);
+    if (header.vendorID != expected.vendorID || header.deviceID != expected.deviceID ||
+        header.driverVersion != expected.driverVersion ||
+        std::memcmp(header.pipelineCacheUUID, expected.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        METAGFX_INFO << "Pipeline cache was written by another GPU or driver, rebuilding: " << m_FilePath;
+        return false;
+    }
+
+    outData.resize(static_cast<size_t>(header.dataSize));
+    if (!in.read(reinterpret_cast<char*>(outData.data()), static_cast<std::streamsize>(outData.size()))) {
+        METAGFX_WARN << "Ignoring truncated pipeline cache: " << m_FilePath;
+        outData.clear();
+        return false;
+    }
+
+    // The Vulkan header leading the blob must agree with ours
+    VkPipelineCacheHeaderVersionOne vkHeader{};
+    if (outData.size() < sizeof(vkHeader)) {
+        outData.clear();
+        return false;
+    }
+    std::memcpy(&vkHeader, outData.data(), sizeof(vkHeader));
+    if (vkHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        vkHeader.vendorID != header.vendorID || vkHeader.deviceID != header.deviceID ||
+        std::memcmp(vkHeader.pipelineCacheUUID, header.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        METAGFX_WARN << "Ignoring pipeline cache with mismatching Vulkan header: " << m_FilePath;
+        outData.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace rhi
+} // namespace metagfx
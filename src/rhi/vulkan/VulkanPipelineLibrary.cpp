@@ -0,0 +1,259 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanPipelineLibrary.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineLibrary.h"
+#include "metagfx/rhi/vulkan/VulkanPipeline.h"
+#include "metagfx/rhi/vulkan/VulkanPipelineCache.h"
+
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+template <typename T>
+void AppendKey(std::string& key, const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Key parts are appended as bytes");
+    key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void AppendStageKey(std::string& key, const VkPipelineShaderStageCreateInfo& stage, const PipelineDesc& desc) {
+    AppendKey(key, stage.module);
+    key.append(stage.pName ? stage.pName : "");
+    key.push_back('\0');
+    for (const SpecializationConstant& constant : desc.specializationConstants) {
+        AppendKey(key, constant.id);
+        AppendKey(key, constant.value);
+    }
+}
+
+// What the pre-rasterization and fragment shader parts compile against
+void AppendLayoutKey(std::string& key, const VulkanGraphicsPipelineState& state, VkPipelineLayout layout) {
+    AppendKey(key, layout);
+    AppendKey(key, state.renderPass);
+    AppendKey(key, state.renderingInfo.viewMask);
+    AppendKey(key, state.shadingRateImage);
+}
+
+VkPipelineCache GetCacheHandle(const VulkanContext& context) {
+    return context.pipelineCache ? context.pipelineCache->GetHandle() : VK_NULL_HANDLE;
+}
+
+// Compiles the state info points to as a library of parts
+VkPipeline CompileLibrary(VulkanContext& context, VkGraphicsPipelineCreateInfo& info,
+                          VkGraphicsPipelineLibraryFlagsEXT parts) {
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryInfo{};
+    libraryInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+    libraryInfo.flags = parts;
+    libraryInfo.pNext = info.pNext;
+    info.pNext = &libraryInfo;
+    info.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+
+    VkPipeline library = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(context.device, GetCacheHandle(context), 1, &info, nullptr, &library) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    if (context.pipelineCache) {
+        context.pipelineCache->MarkDirty();
+    }
+    return library;
+}
+
+} // anonymous namespace
+
+VulkanPipelineLibrary::~VulkanPipelineLibrary() {
+    if (m_Library != VK_NULL_HANDLE) {
+        vkDestroyPipeline(m_Context.device, m_Library, nullptr);
+    }
+}
+
+VkPipeline LinkPipelineLibraries(VulkanContext& context, VkPipelineLayout layout,
+                                 const std::vector<Ref<VulkanPipelineLibrary>>& libraries, bool optimize) {
+    std::vector<VkPipeline> handles;
+    VkGraphicsPipelineCreateInfo info{};
+    info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+    for (const Ref<VulkanPipelineLibrary>& library : libraries) {
+        handles.push_back(library->GetHandle());
+        info.flags |= library->GetLinkFlags();
+    }
+    if (optimize) {
+        info.flags |= VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+    }
+
+    VkPipelineLibraryCreateInfoKHR linkInfo{};
+    linkInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+    linkInfo.libraryCount = static_cast<uint32>(handles.size());
+    linkInfo.pLibraries = handles.data();
+    info.pNext = &linkInfo;
+    info.layout = layout;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (vkCreateGraphicsPipelines(context.device, GetCacheHandle(context), 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
+        METAGFX_WARN << "Linking pipeline libraries failed" << (optimize ? " (optimized)" : "");
+        return VK_NULL_HANDLE;
+    }
+    if (context.pipelineCache) {
+        context.pipelineCache->MarkDirty();
+    }
+    return pipeline;
+}
+
+Ref<VulkanPipeline> VulkanPipelineLibraryCache::CreatePipeline(const PipelineDesc& desc, VkRenderPass renderPass,
+                                                               const std::vector<VkDescriptorSetLayout>& setLayouts,
+                                                               const std::vector<VkFormat>& colorFormats,
+                                                               VkFormat depthFormat) {
+    VulkanGraphicsPipelineState state(m_Context, desc, renderPass, colorFormats, depthFormat);
+    VkPipelineLayout layout = GetGraphicsPipelineLayout(m_Context, setLayouts);
+    std::vector<Ref<VulkanPipelineLibrary>> libraries(static_cast<size_t>(VulkanPipelineLibraryPart::Count));
+
+    // Vertex input
+    std::string key(1, static_cast<char>(VulkanPipelineLibraryPart::VertexInput));
+    AppendKey(key, state.binding.stride);
+    for (const VkVertexInputAttributeDescription& attribute : state.attributes) {
+        AppendKey(key, attribute.location);
+        AppendKey(key, attribute.format);
+        AppendKey(key, attribute.offset);
+    }
+    AppendKey(key, state.inputAssembly.topology);
+    libraries[0] = FindOrCreate(key, nullptr, [&](VkPipelineCreateFlags&) {
+        VkGraphicsPipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.pVertexInputState = &state.vertexInput;
+        info.pInputAssemblyState = &state.inputAssembly;
+        return CompileLibrary(m_Context, info, VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT);
+    });
+
+    // Pre-rasterization shaders
+    key.assign(1, static_cast<char>(VulkanPipelineLibraryPart::PreRasterization));
+    AppendStageKey(key, state.vertexStage, desc);
+    AppendLayoutKey(key, state, layout);
+    AppendKey(key, state.rasterizer.depthClampEnable);
+    AppendKey(key, state.rasterizer.polygonMode);
+    AppendKey(key, state.rasterizer.lineWidth);
+    AppendKey(key, state.rasterizer.cullMode);
+    AppendKey(key, state.rasterizer.frontFace);
+    AppendKey(key, state.rasterizer.depthBiasEnable);
+    libraries[1] = FindOrCreate(key, desc.vertexShader, [&](VkPipelineCreateFlags& linkFlags) {
+        VkGraphicsPipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.stageCount = 1;
+        info.pStages = &state.vertexStage;
+        info.pViewportState = &state.viewport;
+        info.pRasterizationState = &state.rasterizer;
+        info.pDynamicState = &state.dynamicState;
+        info.layout = layout;
+        state.ChainRendering(info);
+        linkFlags = info.flags;
+        return CompileLibrary(m_Context, info, VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT);
+    });
+
+    // Fragment shader
+    key.assign(1, static_cast<char>(VulkanPipelineLibraryPart::FragmentShader));
+    if (state.hasFragmentShader) {
+        AppendStageKey(key, state.fragmentStage, desc);
+    }
+    AppendLayoutKey(key, state, layout);
+    AppendKey(key, state.multisampling.rasterizationSamples);
+    AppendKey(key, state.depthStencil.depthTestEnable);
+    AppendKey(key, state.depthStencil.depthWriteEnable);
+    AppendKey(key, state.depthStencil.depthCompareOp);
+    AppendKey(key, state.depthStencil.stencilTestEnable);
+    libraries[2] = FindOrCreate(key, desc.fragmentShader, [&](VkPipelineCreateFlags& linkFlags) {
+        VkGraphicsPipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.stageCount = state.hasFragmentShader ? 1 : 0;
+        info.pStages = state.hasFragmentShader ? &state.fragmentStage : nullptr;
+        info.pMultisampleState = &state.multisampling;
+        info.pDepthStencilState = &state.depthStencil;
+        info.layout = layout;
+        state.ChainRendering(info);
+        linkFlags = info.flags;
+        return CompileLibrary(m_Context, info, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT);
+    });
+
+    // Fragment output
+    key.assign(1, static_cast<char>(VulkanPipelineLibraryPart::FragmentOutput));
+    AppendKey(key, state.renderPass);
+    AppendKey(key, state.renderingInfo.viewMask);
+    AppendKey(key, state.multisampling.rasterizationSamples);
+    AppendKey(key, depthFormat);
+    for (size_t i = 0; i < colorFormats.size(); ++i) {
+        const VkPipelineColorBlendAttachmentState& blend = state.blendAttachments[i];
+        AppendKey(key, colorFormats[i]);
+        AppendKey(key, blend.colorWriteMask);
+        AppendKey(key, blend.blendEnable);
+        AppendKey(key, blend.srcColorBlendFactor);
+        AppendKey(key, blend.dstColorBlendFactor);
+        AppendKey(key, blend.srcAlphaBlendFactor);
+        AppendKey(key, blend.dstAlphaBlendFactor);
+    }
+    libraries[3] = FindOrCreate(key, nullptr, [&](VkPipelineCreateFlags&) {
+        VkGraphicsPipelineCreateInfo info{};
+        info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+        info.pColorBlendState = &state.colorBlending;
+        info.pMultisampleState = &state.multisampling;
+        state.ChainRendering(info);
+        // The shading rate attachment is the pre-rasterization and fragment parts' flag
+        info.flags &= ~VK_PIPELINE_CREATE_RENDERING_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+        return CompileLibrary(m_Context, info, VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT);
+    });
+
+    if (std::any_of(libraries.begin(), libraries.end(), [](const Ref<VulkanPipelineLibrary>& library) { return !library; })) {
+        METAGFX_WARN << "Pipeline library compile failed" << (desc.debugName ? ": " : "")
+                     << (desc.debugName ? desc.debugName : "");
+        return nullptr;
+    }
+
+    auto pipeline = CreateRef<VulkanPipeline>(m_Context, layout, std::move(libraries));
+    return pipeline->GetHandle() != VK_NULL_HANDLE ? pipeline : nullptr;
+}
+
+Ref<VulkanPipelineLibrary> VulkanPipelineLibraryCache::FindOrCreate(
+    const std::string& key, const Ref<Shader>& shader, const std::function<VkPipeline(VkPipelineCreateFlags&)>& compile) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto found = m_Libraries.find(key);
+        if (found != m_Libraries.end() && !found->second.IsStale()) {
+            return found->second.library;
+        }
+    }
+
+    // Compiled unlocked, so parts compile in parallel; a request racing this one for the
+    // same part keeps whichever library lands first
+    VkPipelineCreateFlags linkFlags = 0;
+    VkPipeline handle = compile(linkFlags);
+    if (handle == VK_NULL_HANDLE) {
+        return nullptr;
+    }
+    linkFlags &= ~(VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT);
+    auto library = CreateRef<VulkanPipelineLibrary>(m_Context, handle, linkFlags);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    CachedLibrary& cached = m_Libraries[key];
+    if (cached.library && !cached.IsStale()) {
+        return cached.library;
+    }
+    cached.library = library;
+    cached.shader = shader;
+    cached.hasShader = shader != nullptr;
+    if (m_Libraries.size() >= m_PruneSize) {
+        PruneLibraries();
+    }
+    return library;
+}
+
+// Pipelines hold the libraries they still link, so dropping an entry never pulls a
+// library from under a link
+void VulkanPipelineLibraryCache::PruneLibraries() {
+    for (auto it = m_Libraries.begin(); it != m_Libraries.end();) {
+        it = it->second.IsStale() ? m_Libraries.erase(it) : std::next(it);
+    }
+    m_PruneSize = std::max<size_t>(64, m_Libraries.size() * 2);
+}
+
+} // namespace rhi
+} // namespace metagfx
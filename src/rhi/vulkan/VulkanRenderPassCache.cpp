@@ -0,0 +1,287 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanRenderPassCache.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanRenderPassCache.h"
+
+#include <algorithm>
+#include <functional>
+
+namespace metagfx {
+namespace rhi {
+
+// Boost-style hash combine
+template<typename T>
+static void HashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+void VulkanRenderPassKey::Reset() {
+    std::vector<VkFormat> formats = std::move(colorFormats);
+    formats.clear();
+    *this = VulkanRenderPassKey{};
+    colorFormats = std::move(formats);
+}
+
+void VulkanFramebufferKey::Reset() {
+    std::vector<VkImageView> views = std::move(attachments);
+    views.clear();
+    *this = VulkanFramebufferKey{};
+    attachments = std::move(views);
+}
+
+bool VulkanRenderPassKey::operator==(const VulkanRenderPassKey& other) const {
+    return colorFormats == other.colorFormats &&
+           depthFormat == other.depthFormat &&
+           samples == other.samples &&
+           resolveColor == other.resolveColor &&
+           viewMask == other.viewMask &&
+           colorLoadOp == other.colorLoadOp &&
+           colorStoreOp == other.colorStoreOp &&
+           colorInitialLayout == other.colorInitialLayout &&
+           colorFinalLayout == other.colorFinalLayout &&
+           depthLoadOp == other.depthLoadOp &&
+           depthStoreOp == other.depthStoreOp &&
+           depthInitialLayout == other.depthInitialLayout &&
+           depthFinalLayout == other.depthFinalLayout;
+}
+
+bool VulkanFramebufferKey::operator==(const VulkanFramebufferKey& other) const {
+    return renderPass == other.renderPass &&
+           attachments == other.attachments &&
+           width == other.width &&
+           height == other.height;
+}
+
+size_t VulkanRenderPassKeyHash::operator()(const VulkanRenderPassKey& key) const {
+    size_t seed = 0;
+    for (VkFormat format : key.colorFormats) {
+        HashCombine(seed, static_cast<uint32>(format));
+    }
+    HashCombine(seed, static_cast<uint32>(key.depthFormat));
+    HashCombine(seed, static_cast<uint32>(key.samples));
+    HashCombine(seed, key.resolveColor);
+    HashCombine(seed, key.viewMask);
+    HashCombine(seed, static_cast<uint32>(key.colorLoadOp));
+    HashCombine(seed, static_cast<uint32>(key.colorStoreOp));
+    HashCombine(seed, static_cast<uint32>(key.colorInitialLayout));
+    HashCombine(seed, static_cast<uint32>(key.colorFinalLayout));
+    HashCombine(seed, static_cast<uint32>(key.depthLoadOp));
+    HashCombine(seed, static_cast<uint32>(key.depthStoreOp));
+    HashCombine(seed, static_cast<uint32>(key.depthInitialLayout));
+    HashCombine(seed, static_cast<uint32>(key.depthFinalLayout));
+    return seed;
+}
+
+size_t VulkanFramebufferKeyHash::operator()(const VulkanFramebufferKey& key) const {
+    size_t seed = 0;
+    HashCombine(seed, key.renderPass);
+    for (VkImageView view : key.attachments) {
+        HashCombine(seed, view);
+    }
+    HashCombine(seed, key.width);
+    HashCombine(seed, key.height);
+    return seed;
+}
+
+VulkanRenderPassCache::VulkanRenderPassCache(VulkanContext& context)
+    : m_Context(context) {
+}
+
+VulkanRenderPassCache::~VulkanRenderPassCache() {
+    Clear();
+}
+
+VkRenderPass VulkanRenderPassCache::GetRenderPass(const VulkanRenderPassKey& key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_RenderPasses.find(key);
+    if (it != m_RenderPasses.end()) {
+        return it->second;
+    }
+
+    VkRenderPass renderPass = CreateRenderPass(key);
+    if (renderPass != VK_NULL_HANDLE) {
+        m_RenderPasses.emplace(key, renderPass);
+        METAGFX_DEBUG << "Render pass cache: created render pass (" << m_RenderPasses.size() << " cached)";
+    }
+    return renderPass;
+}
+
+VkFramebuffer VulkanRenderPassCache::GetFramebuffer(const VulkanFramebufferKey& key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Framebuffers.find(key);
+    if (it != m_Framebuffers.end()) {
+        return it->second;
+    }
+
+    VkFramebufferCreateInfo framebufferInfo{};
+    framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    framebufferInfo.renderPass = key.renderPass;
+    framebufferInfo.attachmentCount = static_cast<uint32>(key.attachments.size());
+    framebufferInfo.pAttachments = key.attachments.data();
+    framebufferInfo.width = key.width;
+    framebufferInfo.height = key.height;
+    framebufferInfo.layers = 1;
+
+    VkFramebuffer framebuffer = VK_NULL_HANDLE;
+    VkResult result = vkCreateFramebuffer(m_Context.device, &framebufferInfo, nullptr, &framebuffer);
+    if (result != VK_SUCCESS) {
+        METAGFX_ERROR << "Render pass cache: failed to create framebuffer: " << result;
+        return VK_NULL_HANDLE;
+    }
+    m_Context.stats->AddRenderPassCreated();
+
+    m_Framebuffers.emplace(key, framebuffer);
+    METAGFX_DEBUG << "Render pass cache: created framebuffer " << key.width << "x" << key.height
+                  << " (" << m_Framebuffers.size() << " cached)";
+    return framebuffer;
+}
+
+void VulkanRenderPassCache::InvalidateImageView(VkImageView imageView) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (auto it = m_Framebuffers.begin(); it != m_Framebuffers.end();) {
+        const auto& views = it->first.attachments;
+        if (std::find(views.begin(), views.end(), imageView) != views.end()) {
+            vkDestroyFramebuffer(m_Context.device, it->second, nullptr);
+            it = m_Framebuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void VulkanRenderPassCache::ClearFramebuffers() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ClearFramebuffersLocked();
+}
+
+size_t VulkanRenderPassCache::GetRenderPassCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_RenderPasses.size();
+}
+
+size_t VulkanRenderPassCache::GetFramebufferCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Framebuffers.size();
+}
+
+void VulkanRenderPassCache::ClearFramebuffersLocked() {
+    for (auto& [key, framebuffer] : m_Framebuffers) {
+        vkDestroyFramebuffer(m_Context.device, framebuffer, nullptr);
+    }
+    m_Framebuffers.clear();
+}
+
+void VulkanRenderPassCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    ClearFramebuffersLocked();
+
+    for (auto& [key, renderPass] : m_RenderPasses) {
+        vkDestroyRenderPass(m_Context.device, renderPass, nullptr);
+    }
+    m_RenderPasses.clear();
+}
+
+VkRenderPass VulkanRenderPassCache::CreateRenderPass(const VulkanRenderPassKey& key) {
+    std::vector<VkAttachmentDescription> attachments;
+    std::vector<VkAttachmentReference> colorRefs;
+
+    for (VkFormat format : key.colorFormats) {
+        VkAttachmentDescription colorAttachment{};
+        colorAttachment.format = format;
+        colorAttachment.samples = key.samples;
+        colorAttachment.loadOp = key.colorLoadOp;
+        colorAttachment.storeOp = key.colorStoreOp;
+        colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        colorAttachment.initialLayout = key.colorInitialLayout;
+        colorAttachment.finalLayout = key.colorFinalLayout;
+
+        VkAttachmentReference colorRef{};
+        colorRef.attachment = static_cast<uint32>(attachments.size());
+        colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+        attachments.push_back(colorAttachment);
+        colorRefs.push_back(colorRef);
+    }
+
+    bool hasDepth = key.depthFormat != VK_FORMAT_UNDEFINED;
+    VkAttachmentReference depthRef{};
+
+    if (hasDepth) {
+        VkAttachmentDescription depthAttachment{};
+        depthAttachment.format = key.depthFormat;
+        depthAttachment.samples = key.samples;
+        depthAttachment.loadOp = key.depthLoadOp;
+        depthAttachment.storeOp = key.depthStoreOp;
+        depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.initialLayout = key.depthInitialLayout;
+        depthAttachment.finalLayout = key.depthFinalLayout;
+
+        depthRef.attachment = static_cast<uint32>(attachments.size());
+        depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+        attachments.push_back(depthAttachment);
+    }
+
+    // Resolve targets are written by the resolve at the end of the subpass only, so they
+    // neither load nor keep what was in them
+    std::vector<VkAttachmentReference> resolveRefs;
+    if (key.resolveColor) {
+        for (VkFormat format : key.colorFormats) {
+            VkAttachmentDescription resolveAttachment{};
+            resolveAttachment.format = format;
+            resolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+            resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            resolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+            resolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+            resolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+            resolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            resolveAttachment.finalLayout = key.colorFinalLayout;
+
+            VkAttachmentReference resolveRef{};
+            resolveRef.attachment = static_cast<uint32>(attachments.size());
+            resolveRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+            attachments.push_back(resolveAttachment);
+            resolveRefs.push_back(resolveRef);
+        }
+    }
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = static_cast<uint32>(colorRefs.size());
+    subpass.pColorAttachments = colorRefs.empty() ? nullptr : colorRefs.data();
+    subpass.pResolveAttachments = resolveRefs.empty() ? nullptr : resolveRefs.data();
+    subpass.pDepthStencilAttachment = hasDepth ? &depthRef : nullptr;
+
+    VkRenderPassCreateInfo renderPassInfo{};
+    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    renderPassInfo.attachmentCount = static_cast<uint32>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpass;
+
+    // Every attachment layer of the mask is drawn by the subpass; the framebuffer stays one
+    // layer, the views addressing the layers of the array image views
+    VkRenderPassMultiviewCreateInfo multiviewInfo{};
+    if (key.viewMask != 0) {
+        multiviewInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_MULTIVIEW_CREATE_INFO;
+        multiviewInfo.subpassCount = 1;
+        multiviewInfo.pViewMasks = &key.viewMask;
+        renderPassInfo.pNext = &multiviewInfo;
+    }
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkResult result = vkCreateRenderPass(m_Context.device, &renderPassInfo, nullptr, &renderPass);
+    if (result != VK_SUCCESS) {
+        METAGFX_ERROR << "Render pass cache: failed to create render pass: " << result;
+        return VK_NULL_HANDLE;
+    }
+    m_Context.stats->AddRenderPassCreated();
+    return renderPass;
+}
+
+} // namespace rhi
+} // namespace metagfx
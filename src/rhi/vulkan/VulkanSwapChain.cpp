@@ -4,17 +4,39 @@
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/vulkan/VulkanSwapChain.h"
 #include "metagfx/rhi/vulkan/VulkanTexture.h"
+#include "metagfx/rhi/vulkan/VulkanRenderPassCache.h"
+#include "metagfx/rhi/vulkan/VulkanTimeline.h"
+
+#include <algorithm>
 
 namespace metagfx {
 namespace rhi {
 
-VulkanSwapChain::VulkanSwapChain(VulkanContext& context, SDL_Window* window)
-    : m_Context(context), m_Window(window) {
+static VkPresentModeKHR ToVulkanPresentMode(PresentMode mode) {
+    switch (mode) {
+        case PresentMode::FifoRelaxed: return VK_PRESENT_MODE_FIFO_RELAXED_KHR;
+        case PresentMode::Mailbox:     return VK_PRESENT_MODE_MAILBOX_KHR;
+        case PresentMode::Immediate:   return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        default:                       return VK_PRESENT_MODE_FIFO_KHR;
+    }
+}
+
+VulkanSwapChain::VulkanSwapChain(VulkanContext& context, SDL_Window* window, PresentMode presentMode,
+                                 bool offscreen)
+    : m_Context(context), m_Window(window), m_Offscreen(offscreen), m_RequestedPresentMode(presentMode) {
     
     int width, height;
     SDL_GetWindowSize(window, &width, &height);
     m_Width = static_cast<uint32>(width);
     m_Height = static_cast<uint32>(height);
+
+    if (m_Offscreen) {
+        m_PresentMode = presentMode;
+        CreateOffscreenImages();
+        CreateSyncObjects();
+        METAGFX_INFO << "Vulkan offscreen swap chain created: " << m_Width << "x" << m_Height;
+        return;
+    }
     
     CreateSwapChain();
     CreateImageViews();
@@ -61,13 +83,16 @@ void VulkanSwapChain::CreateSwapChain() {
     m_VkFormat = surfaceFormat.format;
     m_Format = FromVulkanFormat(m_VkFormat);
     
-    // Choose present mode (prefer mailbox for triple buffering)
+    // Use the requested present mode if the surface has it; FIFO is always available
     VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& mode : presentModes) {
-        if (mode == VK_PRESENT_MODE_MAILBOX_KHR) {
-            presentMode = mode;
-            break;
-        }
+    m_PresentMode = PresentMode::Fifo;
+    VkPresentModeKHR requestedMode = ToVulkanPresentMode(m_RequestedPresentMode);
+    if (std::find(presentModes.begin(), presentModes.end(), requestedMode) != presentModes.end()) {
+        presentMode = requestedMode;
+        m_PresentMode = m_RequestedPresentMode;
+    } else {
+        METAGFX_WARN << GetPresentModeName(m_RequestedPresentMode)
+                     << " present mode not supported by the surface, using FIFO";
     }
     
     // Choose extent
@@ -114,6 +139,7 @@ void VulkanSwapChain::CreateSwapChain() {
     createInfo.oldSwapchain = m_OldSwapChain;
     
     VK_CHECK(vkCreateSwapchainKHR(m_Context.device, &createInfo, nullptr, &m_SwapChain));
+    m_FirstPresentId = m_PresentId + 1;
     
     // Get swap chain images
     vkGetSwapchainImagesKHR(m_Context.device, m_SwapChain, &imageCount, nullptr);
@@ -149,41 +175,59 @@ void VulkanSwapChain::CreateImageViews() {
     }
 }
 
+void VulkanSwapChain::CreateOffscreenImages() {
+    m_Format = Format::B8G8R8A8_SRGB;
+    m_VkFormat = ToVulkanFormat(m_Format);
+
+    // One per frame slot: image i is rendered again only after slot i's fence was waited on
+    TextureDesc desc{};
+    desc.width = m_Width;
+    desc.height = m_Height;
+    desc.format = m_Format;
+    // Copied out by captures and sampled by the stream encoder
+    desc.usage = TextureUsage::ColorAttachment | TextureUsage::TransferSrc | TextureUsage::Sampled;
+    desc.debugName = "Offscreen back buffer";
+    m_Textures.clear();
+    for (uint32 i = 0; i < m_Context.framesInFlight; ++i) {
+        m_Textures.push_back(CreateRef<VulkanTexture>(m_Context, desc));
+    }
+}
+
 void VulkanSwapChain::CreateSyncObjects() {
-    m_ImageAvailableSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_RenderFinishedSemaphores.resize(MAX_FRAMES_IN_FLIGHT);
-    m_InFlightFences.resize(MAX_FRAMES_IN_FLIGHT);
-    
+    m_ImageAvailableSemaphores.resize(m_Context.framesInFlight);
+    m_RenderFinishedSemaphores.resize(m_Context.framesInFlight);
+    m_FrameValues.assign(m_Context.framesInFlight, 0);
+    if (m_Offscreen) {
+        return;
+    }
+
     VkSemaphoreCreateInfo semaphoreInfo{};
     semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
     
-    VkFenceCreateInfo fenceInfo{};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-    
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    for (uint32 i = 0; i < m_Context.framesInFlight; i++) {
         VK_CHECK(vkCreateSemaphore(m_Context.device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[i]));
         VK_CHECK(vkCreateSemaphore(m_Context.device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphores[i]));
-        VK_CHECK(vkCreateFence(m_Context.device, &fenceInfo, nullptr, &m_InFlightFences[i]));
     }
 }
 
 void VulkanSwapChain::Cleanup() {
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+    DestroyRetired(true);
+
+    for (uint32 i = 0; i < m_Context.framesInFlight; i++) {
         if (m_ImageAvailableSemaphores[i] != VK_NULL_HANDLE) {
             vkDestroySemaphore(m_Context.device, m_ImageAvailableSemaphores[i], nullptr);
         }
         if (m_RenderFinishedSemaphores[i] != VK_NULL_HANDLE) {
             vkDestroySemaphore(m_Context.device, m_RenderFinishedSemaphores[i], nullptr);
         }
-        if (m_InFlightFences[i] != VK_NULL_HANDLE) {
-            vkDestroyFence(m_Context.device, m_InFlightFences[i], nullptr);
-        }
     }
     
     m_Textures.clear();
     
     for (auto imageView : m_ImageViews) {
+        if (m_Context.renderPassCache) {
+            m_Context.renderPassCache->InvalidateImageView(imageView);
+        }
         vkDestroyImageView(m_Context.device, imageView, nullptr);
     }
     
@@ -193,6 +237,14 @@ void VulkanSwapChain::Cleanup() {
 }
 
 void VulkanSwapChain::Present() {
+    if (m_Offscreen) {
+        m_CurrentFrame = (m_CurrentFrame + 1) % m_Context.framesInFlight;
+        m_Context.timeline->Wait(m_FrameValues[m_CurrentFrame]);
+        m_CurrentImageIndex = m_CurrentFrame;
+        m_FrameNumber++;
+        return;
+    }
+
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 
@@ -205,18 +257,35 @@ void VulkanSwapChain::Present() {
     presentInfo.pSwapchains = swapChains;
     presentInfo.pImageIndices = &m_CurrentImageIndex;
 
-    VkResult result = vkQueuePresentKHR(m_Context.presentQueue, &presentInfo);
+    // Tag the present so WaitForPresent() can wait for it to reach the display
+    VkPresentIdKHR presentIdInfo{};
+    uint64 presentId = m_PresentId + 1;
+    if (m_Context.waitForPresent) {
+        presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+        presentIdInfo.swapchainCount = 1;
+        presentIdInfo.pPresentIds = &presentId;
+        presentInfo.pNext = &presentIdInfo;
+        m_PresentId = presentId;
+    }
+
+    // The graphics queue is shared with uploads submitted from other threads
+    VkResult result = m_Context.presentQueue == m_Context.graphicsQueue
+                          ? m_Context.timeline->Present(presentInfo)
+                          : vkQueuePresentKHR(m_Context.presentQueue, &presentInfo);
 
     // Check if swap chain is out of date or suboptimal
     bool swapChainNeedsRecreation = (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR);
 
     // Advance to next frame
-    m_CurrentFrame = (m_CurrentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_Context.framesInFlight;
+
+    // Wait for the NEXT slot's last submission before acquiring, so resources recorded
+    // from it framesInFlight frames ago can be reused
+    m_Context.timeline->Wait(m_FrameValues[m_CurrentFrame]);
 
-    // Wait for the NEXT frame's fence and reset it before acquiring
-    // This ensures we can safely reuse resources from MAX_FRAMES_IN_FLIGHT frames ago
-    vkWaitForFences(m_Context.device, 1, &m_InFlightFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(m_Context.device, 1, &m_InFlightFences[m_CurrentFrame]);
+    // Swap chains retired framesInFlight presents ago are no longer referenced
+    m_FrameNumber++;
+    DestroyRetired(false);
 
     // Acquire next image
     result = vkAcquireNextImageKHR(m_Context.device, m_SwapChain, UINT64_MAX,
@@ -241,61 +310,103 @@ void VulkanSwapChain::Resize(uint32 width, uint32 height) {
 
     m_Width = width;
     m_Height = height;
-
-    // Wait for in-flight frames to complete (don't use vkDeviceWaitIdle as it can timeout on MoltenVK)
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (m_InFlightFences[i] != VK_NULL_HANDLE) {
-            vkWaitForFences(m_Context.device, 1, &m_InFlightFences[i], VK_TRUE, UINT64_MAX);
-        }
+    if (m_Offscreen) {
+        // Rare enough (benchmarks run at a fixed size) to simply wait for the GPU. Not
+        // vkDeviceWaitIdle(), which must not overlap submissions from other threads.
+        m_Context.timeline->Wait(m_Context.timeline->GetSignaledValue());
+        CreateOffscreenImages();
+        return;
     }
+    Recreate();
 
-    // Save old swap chain for proper recreation
-    VkSwapchainKHR oldSwapChain = m_SwapChain;
+    METAGFX_INFO << "Swap chain resized: " << m_Width << "x" << m_Height;
+}
 
-    // Clean up old resources (except swap chain itself, we'll pass it to creation)
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-        if (m_ImageAvailableSemaphores[i] != VK_NULL_HANDLE) {
-            vkDestroySemaphore(m_Context.device, m_ImageAvailableSemaphores[i], nullptr);
-            m_ImageAvailableSemaphores[i] = VK_NULL_HANDLE;
-        }
-        if (m_RenderFinishedSemaphores[i] != VK_NULL_HANDLE) {
-            vkDestroySemaphore(m_Context.device, m_RenderFinishedSemaphores[i], nullptr);
-            m_RenderFinishedSemaphores[i] = VK_NULL_HANDLE;
-        }
-        if (m_InFlightFences[i] != VK_NULL_HANDLE) {
-            vkDestroyFence(m_Context.device, m_InFlightFences[i], nullptr);
-            m_InFlightFences[i] = VK_NULL_HANDLE;
-        }
+void VulkanSwapChain::SetPresentMode(PresentMode mode) {
+    if (mode == m_RequestedPresentMode) {
+        return;
     }
 
-    m_Textures.clear();
+    m_RequestedPresentMode = mode;
+    if (m_Offscreen) {
+        m_PresentMode = mode;  // Nothing is presented
+        return;
+    }
+    Recreate();
 
-    for (auto imageView : m_ImageViews) {
-        vkDestroyImageView(m_Context.device, imageView, nullptr);
+    METAGFX_INFO << "Swap chain present mode: " << GetPresentModeName(m_PresentMode);
+}
+
+bool VulkanSwapChain::WaitForPresent(uint32 maxPendingPresents) {
+    if (!m_Context.waitForPresent || m_Offscreen) {
+        return false;
+    }
+    if (m_PresentId < m_FirstPresentId + maxPendingPresents) {
+        return true;  // Not that many presents on this swap chain yet
     }
+
+    // Bounded, so a minimized or occluded window (whose presents never complete) does
+    // not stall the loop
+    constexpr uint64 timeoutNs = 100'000'000;
+    VkResult result = m_Context.waitForPresent(m_Context.device, m_SwapChain,
+                                               m_PresentId - maxPendingPresents, timeoutNs);
+    return result == VK_SUCCESS || result == VK_TIMEOUT || result == VK_SUBOPTIMAL_KHR;
+}
+
+void VulkanSwapChain::Recreate() {
+    // No GPU wait: earlier frames may still render to and present the old images, so the
+    // old swap chain is handed to the new one as oldSwapchain and retired with its views
+    RetiredSwapChain retired;
+    retired.swapChain = m_SwapChain;
+    retired.imageViews = std::move(m_ImageViews);
+    retired.destroyAtFrame = m_FrameNumber + m_Context.framesInFlight;
     m_ImageViews.clear();
+    m_Textures.clear();
+
+    // The current slot's semaphore has a pending signal from the acquire on the old swap
+    // chain, so it retires too and the slot gets a fresh one
+    retired.acquireSemaphore = m_ImageAvailableSemaphores[m_CurrentFrame];
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    VK_CHECK(vkCreateSemaphore(m_Context.device, &semaphoreInfo, nullptr, &m_ImageAvailableSemaphores[m_CurrentFrame]));
 
-    // Recreate swap chain (passing old one for efficient recreation)
-    m_OldSwapChain = oldSwapChain;
+    m_OldSwapChain = retired.swapChain;
     CreateSwapChain();
     m_OldSwapChain = VK_NULL_HANDLE;
-
-    // Destroy old swap chain after new one is created
-    if (oldSwapChain != VK_NULL_HANDLE) {
-        vkDestroySwapchainKHR(m_Context.device, oldSwapChain, nullptr);
-    }
+    m_Retired.push_back(std::move(retired));
 
     CreateImageViews();
-    CreateSyncObjects();
 
-    // Acquire the first image after resize
+    // Acquire the first image of the new swap chain
     VkResult result = vkAcquireNextImageKHR(m_Context.device, m_SwapChain, UINT64_MAX,
                                             m_ImageAvailableSemaphores[m_CurrentFrame], VK_NULL_HANDLE, &m_CurrentImageIndex);
     if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR) {
         METAGFX_ERROR << "Failed to acquire swap chain image after resize";
     }
+}
 
-    METAGFX_INFO << "Swap chain resized: " << m_Width << "x" << m_Height;
+void VulkanSwapChain::DestroyRetired(bool all) {
+    for (auto it = m_Retired.begin(); it != m_Retired.end(); ) {
+        if (!all && it->destroyAtFrame > m_FrameNumber) {
+            ++it;
+            continue;
+        }
+
+        // Cached framebuffers referencing the views must go before the views do
+        for (VkImageView imageView : it->imageViews) {
+            if (m_Context.renderPassCache) {
+                m_Context.renderPassCache->InvalidateImageView(imageView);
+            }
+            vkDestroyImageView(m_Context.device, imageView, nullptr);
+        }
+        if (it->acquireSemaphore != VK_NULL_HANDLE) {
+            vkDestroySemaphore(m_Context.device, it->acquireSemaphore, nullptr);
+        }
+        if (it->swapChain != VK_NULL_HANDLE) {
+            vkDestroySwapchainKHR(m_Context.device, it->swapChain, nullptr);
+        }
+        it = m_Retired.erase(it);
+    }
 }
 
 Ref<Texture> VulkanSwapChain::GetCurrentBackBuffer() {
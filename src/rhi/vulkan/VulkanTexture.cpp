@@ -3,55 +3,45 @@
 // ============================================================================
 #include "metagfx/core/Logger.h"
 #include "metagfx/rhi/vulkan/VulkanTexture.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/MipGenerator.h"
+#include "metagfx/rhi/vulkan/VulkanRenderPassCache.h"
+#include "metagfx/rhi/vulkan/VulkanUploadManager.h"
 
 namespace metagfx {
 namespace rhi {
 
-// Helper function to get the size in bytes of a format
-static uint32 GetFormatSize(Format format) {
-    switch (format) {
-        case Format::R8_UNORM:
-            return 1;
-        case Format::R8G8B8A8_UNORM:
-        case Format::R8G8B8A8_SRGB:
-        case Format::B8G8R8A8_UNORM:
-        case Format::B8G8R8A8_SRGB:
-            return 4;
-        case Format::R16G16_SFLOAT:
-            return 4; // 2 channels * 2 bytes
-        case Format::R16G16B16A16_SFLOAT:
-            return 8; // 4 channels * 2 bytes
-        case Format::R32_SFLOAT:
-            return 4;
-        case Format::R32G32_SFLOAT:
-            return 8;
-        case Format::R32G32B32_SFLOAT:
-            return 12;
-        case Format::R32G32B32A32_SFLOAT:
-            return 16;
-        case Format::D32_SFLOAT:
-            return 4;
-        case Format::D24_UNORM_S8_UINT:
-            return 4;
-        default:
-            return 4; // Default to 4 bytes
-    }
-}
-
 VulkanTexture::VulkanTexture(VulkanContext& context, VkImage image, VkImageView imageView,
                             uint32 width, uint32 height, VkFormat format)
     : m_Context(context), m_Image(image), m_ImageView(imageView),
       m_Width(width), m_Height(height), m_VkFormat(format), m_OwnsImage(false) {
     m_Format = FromVulkanFormat(format);
+    m_States.resize(1);
 }
 
 VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
     : m_Context(context), m_Width(desc.width), m_Height(desc.height),
-      m_MipLevels(desc.mipLevels), m_ArrayLayers(desc.arrayLayers),
+      m_MipLevels(desc.mipLevels), m_ArrayLayers(desc.arrayLayers), m_SampleCount(desc.sampleCount),
       m_Type(desc.type), m_Format(desc.format), m_OwnsImage(true) {
 
     m_VkFormat = ToVulkanFormat(desc.format);
 
+    // Mip generation: blit chain when the format supports it, CPU box filter otherwise
+    if (desc.generateMipmaps && m_MipLevels > 1) {
+        VkFormatProperties formatProps;
+        vkGetPhysicalDeviceFormatProperties(m_Context.physicalDevice, m_VkFormat, &formatProps);
+        const VkFormatFeatureFlags blitFeatures = VK_FORMAT_FEATURE_BLIT_SRC_BIT |
+                                                  VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                                  VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        m_BlitMipmaps = (formatProps.optimalTilingFeatures & blitFeatures) == blitFeatures;
+        m_GenerateMipmaps = m_BlitMipmaps || IsCPUMipGenerationSupported(desc.format);
+
+        if (!m_GenerateMipmaps) {
+            METAGFX_WARN << "Texture format cannot generate mipmaps; using a single mip level";
+            m_MipLevels = 1;
+        }
+    }
+
     // Create VkImage
     VkImageCreateInfo imageInfo{};
     imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -59,7 +49,7 @@ VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
     imageInfo.extent.width = desc.width;
     imageInfo.extent.height = desc.height;
     imageInfo.extent.depth = desc.depth;
-    imageInfo.mipLevels = desc.mipLevels;
+    imageInfo.mipLevels = m_MipLevels;
     imageInfo.arrayLayers = desc.arrayLayers;
     imageInfo.format = m_VkFormat;
     imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
@@ -70,8 +60,13 @@ VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
         imageInfo.flags = VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT;
     }
 
-    // Convert usage flags
-    imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;  // For uploading data
+    // Convert usage flags. Transient attachments allow nothing but attachment usages.
+    m_Transient = (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::Transient)) != 0;
+    imageInfo.usage = m_Transient ? VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT
+                                  : VK_IMAGE_USAGE_TRANSFER_DST_BIT;  // For uploading data
+    if (m_BlitMipmaps) {
+        imageInfo.usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;  // Each level is the next one's blit source
+    }
     if (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::Sampled)) {
         imageInfo.usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
     }
@@ -81,24 +76,35 @@ VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
     if (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::DepthStencilAttachment)) {
         imageInfo.usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
     }
+    if (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::ShadingRate)) {
+        imageInfo.usage |= VK_IMAGE_USAGE_FRAGMENT_SHADING_RATE_ATTACHMENT_BIT_KHR;
+    }
+    m_Storage = (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::Storage)) != 0;
+    if (m_Storage) {
+        imageInfo.usage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    }
 
-    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.samples = ToVulkanSampleCount(m_SampleCount);
     imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
     VK_CHECK(vkCreateImage(m_Context.device, &imageInfo, nullptr, &m_Image));
 
-    // Allocate memory
-    VkMemoryRequirements memRequirements;
-    vkGetImageMemoryRequirements(m_Context.device, m_Image, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits,
-                                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-    VK_CHECK(vkAllocateMemory(m_Context.device, &allocInfo, nullptr, &m_Memory));
-    VK_CHECK(vkBindImageMemory(m_Context.device, m_Image, m_Memory, 0));
+    // Allocate memory (sub-allocated from a shared device-local block; transient
+    // attachments prefer lazily allocated memory, which stays in tile memory)
+    VkMemoryPropertyFlags memoryProperties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+    if (m_Transient) {
+        memoryProperties |= VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+    }
+    if (!m_Context.allocator->AllocateImage(m_Image, memoryProperties, m_Allocation)) {
+        METAGFX_ERROR << "Failed to allocate memory for texture " << desc.width << "x" << desc.height;
+    } else {
+        // Lazily allocated memory stays in tile memory and takes none of the heap
+        bool lazy = (m_Context.memoryProperties.memoryTypes[m_Allocation.memoryTypeIndex].propertyFlags &
+                     VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT) != 0;
+        m_MemoryCategory = GetTextureMemoryCategory(desc);
+        m_MemoryBytes = lazy ? 0 : m_Allocation.size;
+        m_Context.memory->Add(m_MemoryCategory, m_MemoryBytes);
+    }
 
     // Create image view
     VkImageViewCreateInfo viewInfo{};
@@ -111,7 +117,7 @@ VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
     } else if (desc.type == TextureType::Texture3D) {
         viewInfo.viewType = VK_IMAGE_VIEW_TYPE_3D;
     } else {
-        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.viewType = desc.arrayLayers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
     }
 
     viewInfo.format = m_VkFormat;
@@ -120,74 +126,88 @@ VulkanTexture::VulkanTexture(VulkanContext& context, const TextureDesc& desc)
     bool isDepthFormat = (static_cast<uint32>(desc.usage) & static_cast<uint32>(TextureUsage::DepthStencilAttachment)) != 0;
     viewInfo.subresourceRange.aspectMask = isDepthFormat ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
     viewInfo.subresourceRange.baseMipLevel = 0;
-    viewInfo.subresourceRange.levelCount = desc.mipLevels;
+    viewInfo.subresourceRange.levelCount = m_MipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount = desc.arrayLayers;
 
     VK_CHECK(vkCreateImageView(m_Context.device, &viewInfo, nullptr, &m_ImageView));
 
+    // Attachments are 2D or 2D array views of one mip: cube maps rendered into (multiview
+    // passes, one face per view) get a 2D array view of their faces
+    uint32 attachmentUsage = static_cast<uint32>(TextureUsage::ColorAttachment) |
+                             static_cast<uint32>(TextureUsage::DepthStencilAttachment);
+    if (desc.type == TextureType::TextureCube && (static_cast<uint32>(desc.usage) & attachmentUsage)) {
+        VkImageViewCreateInfo attachmentViewInfo = viewInfo;
+        attachmentViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+        attachmentViewInfo.subresourceRange.levelCount = 1;
+        VK_CHECK(vkCreateImageView(m_Context.device, &attachmentViewInfo, nullptr, &m_AttachmentView));
+    }
+
     // Don't transition layout here - let UploadData handle it for sampled textures
-    // Depth attachments are transitioned by the render pass
+    // Depth attachments are transitioned by the render pass. Storage images live in
+    // GENERAL for their whole lifetime, so compute writes and later samples need no
+    // transitions (only CommandBuffer::PipelineBarrier).
+    if (m_Storage) {
+        m_UploadTicket = m_Context.uploadManager->TransitionImage(m_Image, viewInfo.subresourceRange.aspectMask,
+                                                                  m_MipLevels, m_ArrayLayers,
+                                                                  VK_IMAGE_LAYOUT_GENERAL);
+    }
+
+    m_States.resize(m_MipLevels * m_ArrayLayers);
+    if (m_Storage) {
+        for (VulkanResourceState& state : m_States) {
+            state.layout = VK_IMAGE_LAYOUT_GENERAL;
+        }
+    }
 
     if (desc.type == TextureType::TextureCube) {
         METAGFX_INFO << "Created cubemap texture: " << desc.width << "x" << desc.height
-                     << " with " << desc.mipLevels << " mip levels";
+                     << " with " << m_MipLevels << " mip levels";
     } else {
         METAGFX_INFO << "Created texture: " << desc.width << "x" << desc.height
-                     << " with " << desc.mipLevels << " mip levels";
+                     << " with " << m_MipLevels << " mip levels";
     }
 }
 
 VulkanTexture::~VulkanTexture() {
     if (m_OwnsImage) {
+        // The copy into this image may still be queued or executing
+        if (m_UploadTicket != 0 && m_Context.uploadManager) {
+            m_Context.uploadManager->Wait(m_UploadTicket);
+        }
+
         if (m_ImageView != VK_NULL_HANDLE) {
+            // Evict any cached framebuffer that uses this view (e.g. depth buffer recreated on resize)
+            if (m_Context.renderPassCache) {
+                m_Context.renderPassCache->InvalidateImageView(m_ImageView);
+            }
             vkDestroyImageView(m_Context.device, m_ImageView, nullptr);
         }
+        if (m_AttachmentView != VK_NULL_HANDLE) {
+            if (m_Context.renderPassCache) {
+                m_Context.renderPassCache->InvalidateImageView(m_AttachmentView);
+            }
+            vkDestroyImageView(m_Context.device, m_AttachmentView, nullptr);
+        }
 
         if (m_Image != VK_NULL_HANDLE) {
             vkDestroyImage(m_Context.device, m_Image, nullptr);
         }
 
-        if (m_Memory != VK_NULL_HANDLE) {
-            vkFreeMemory(m_Context.device, m_Memory, nullptr);
+        if (m_Allocation.IsValid()) {
+            m_Context.memory->Remove(m_MemoryCategory, m_MemoryBytes);
         }
+        m_Context.allocator->Free(m_Allocation);
     }
 }
 
 void VulkanTexture::UploadData(const void* data, uint64 size) {
-    // Create staging buffer
-    VkBufferCreateInfo bufferInfo{};
-    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-    bufferInfo.size = size;
-    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    VkBuffer stagingBuffer;
-    VK_CHECK(vkCreateBuffer(m_Context.device, &bufferInfo, nullptr, &stagingBuffer));
-
-    VkMemoryRequirements memRequirements;
-    vkGetBufferMemoryRequirements(m_Context.device, stagingBuffer, &memRequirements);
-
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize = memRequirements.size;
-    allocInfo.memoryTypeIndex = FindMemoryType(memRequirements.memoryTypeBits,
-                                               VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
-                                               VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-    VkDeviceMemory stagingMemory;
-    VK_CHECK(vkAllocateMemory(m_Context.device, &allocInfo, nullptr, &stagingMemory));
-    VK_CHECK(vkBindBufferMemory(m_Context.device, stagingBuffer, stagingMemory, 0));
-
-    // Copy data to staging buffer
-    void* mappedData;
-    VK_CHECK(vkMapMemory(m_Context.device, stagingMemory, 0, size, 0, &mappedData));
-    memcpy(mappedData, data, size);
+    m_Context.stats->AddTextureUpload(size);
 
     // DEBUG: Print first few bytes of mip 1 data for cubemaps
     if (m_ArrayLayers == 6 && m_MipLevels > 1) {
         const uint8* byteData = static_cast<const uint8*>(data);
-        uint64 mip0Size = static_cast<uint64>(m_Width) * m_Height * GetFormatSize(m_Format) * 6;
+        uint64 mip0Size = GetFormatImageSize(m_Format, m_Width, m_Height) * 6;
         if (size > mip0Size + 16) {
             METAGFX_INFO << "First 16 bytes of Mip 1 data in buffer:";
             for (int i = 0; i < 16; i++) {
@@ -196,48 +216,60 @@ void VulkanTexture::UploadData(const void* data, uint64 size) {
         }
     }
 
-    vkUnmapMemory(m_Context.device, stagingMemory);
-
-    // Create command buffer for copy operation
-    VkCommandBufferAllocateInfo cmdAllocInfo{};
-    cmdAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    cmdAllocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cmdAllocInfo.commandPool = m_Context.commandPool;
-    cmdAllocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(m_Context.device, &cmdAllocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    // Transition to transfer destination layout
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = m_Image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = m_MipLevels;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = m_ArrayLayers;
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer,
-                        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        0, 0, nullptr, 0, nullptr, 1, &barrier);
+    // The caller passed mip 0 only; build the rest on the CPU when the GPU can't blit it
+    std::vector<uint8> mipChain;
+    if (m_GenerateMipmaps && !m_BlitMipmaps) {
+        if (!GenerateMipChainCPU(data, m_Width, m_Height, m_ArrayLayers, m_MipLevels, m_Format, mipChain)) {
+            return;
+        }
+        data = mipChain.data();
+        size = mipChain.size();
+    }
+
+    VulkanImageUpload upload = DescribeUpload(size);
+    QueueUpload(upload, size, [data, size](void* staging) {
+        memcpy(staging, data, size);
+    });
+}
+
+void VulkanTexture::UploadLevels(const TextureLevelData* levels, uint32 levelCount) {
+    // Mip 0 alone, or mips generated on the CPU from it, take the packed path
+    if (levelCount <= 1 || m_GenerateMipmaps || levelCount != m_MipLevels) {
+        Texture::UploadLevels(levels, levelCount);
+        return;
+    }
+
+    uint64 size = 0;
+    for (uint32 i = 0; i < levelCount; ++i) {
+        size += levels[i].size;
+    }
+    m_Context.stats->AddTextureUpload(size);
+
+    // One staging copy per level, read from wherever it lies (a mapped file's pages)
+    VulkanImageUpload upload = DescribeUpload(size);
+    QueueUpload(upload, size, [levels, levelCount](void* staging) {
+        uint8* dst = static_cast<uint8*>(staging);
+        for (uint32 i = 0; i < levelCount; ++i) {
+            memcpy(dst, levels[i].data, levels[i].size);
+            dst += levels[i].size;
+        }
+    });
+}
+
+VulkanImageUpload VulkanTexture::DescribeUpload(uint64 size) const {
+    VulkanImageUpload upload{};
+    upload.image = m_Image;
+    upload.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    upload.mipLevels = m_MipLevels;
+    upload.arrayLayers = m_ArrayLayers;
+    upload.texelSize = GetFormatInfo(m_Format).blockSize;  // Compressed: bytes per block
+    upload.generateMipmaps = m_BlitMipmaps;
+    upload.width = m_Width;
+    upload.height = m_Height;
+    uint32 uploadedMips = m_BlitMipmaps ? 1 : m_MipLevels;
 
     // Copy buffer to image (all mip levels and layers)
     // NOTE: Upload each face separately for better MoltenVK compatibility
-    std::vector<VkBufferImageCopy> regions;
     uint64 bufferOffset = 0;
 
     METAGFX_INFO << "Setting up texture upload regions:";
@@ -245,13 +277,13 @@ void VulkanTexture::UploadData(const void* data, uint64 size) {
     METAGFX_INFO << "  Texture dimensions: " << m_Width << "x" << m_Height;
     METAGFX_INFO << "  Mip levels: " << m_MipLevels;
     METAGFX_INFO << "  Array layers: " << m_ArrayLayers;
-    METAGFX_INFO << "  Format size: " << GetFormatSize(m_Format) << " bytes/pixel";
+    METAGFX_INFO << "  Format size: " << GetFormatInfo(m_Format).blockSize << " bytes/block";
 
-    for (uint32 mip = 0; mip < m_MipLevels; ++mip) {
+    for (uint32 mip = 0; mip < uploadedMips; ++mip) {
         uint32 mipWidth = std::max(1u, m_Width >> mip);
         uint32 mipHeight = std::max(1u, m_Height >> mip);
-        uint32 bytesPerPixel = GetFormatSize(m_Format);
-        uint64 faceSize = static_cast<uint64>(mipWidth) * mipHeight * bytesPerPixel;
+        // Rounded up to whole blocks for compressed formats
+        uint64 faceSize = GetFormatImageSize(m_Format, mipWidth, mipHeight);
 
         // Upload each array layer (cubemap face) separately
         for (uint32 layer = 0; layer < m_ArrayLayers; ++layer) {
@@ -266,7 +298,7 @@ void VulkanTexture::UploadData(const void* data, uint64 size) {
             region.imageOffset = {0, 0, 0};
             region.imageExtent = {mipWidth, mipHeight, 1};
 
-            regions.push_back(region);
+            upload.regions.push_back(region);
             bufferOffset += faceSize;
         }
 
@@ -275,124 +307,41 @@ void VulkanTexture::UploadData(const void* data, uint64 size) {
                      << "dimensions=" << mipWidth << "x" << mipHeight;
     }
 
-    METAGFX_INFO << "  Total regions: " << regions.size();
+    METAGFX_INFO << "  Total regions: " << upload.regions.size();
     METAGFX_INFO << "  Total calculated size: " << bufferOffset << " bytes";
 
-    vkCmdCopyBufferToImage(commandBuffer, stagingBuffer, m_Image,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          static_cast<uint32>(regions.size()), regions.data());
-
-    // Transition to shader read layout
-    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-    vkCmdPipelineBarrier(commandBuffer,
-                        VK_PIPELINE_STAGE_TRANSFER_BIT,
-                        VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                        0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    vkEndCommandBuffer(commandBuffer);
-
-    // Submit and wait
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(m_Context.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(m_Context.graphicsQueue);
-
-    // Cleanup
-    vkFreeCommandBuffers(m_Context.device, m_Context.commandPool, 1, &commandBuffer);
-    vkDestroyBuffer(m_Context.device, stagingBuffer, nullptr);
-    vkFreeMemory(m_Context.device, stagingMemory, nullptr);
-
-    METAGFX_INFO << "Uploaded " << size << " bytes to texture";
+    return upload;
 }
 
-void VulkanTexture::TransitionImageLayout(VkImageLayout oldLayout, VkImageLayout newLayout) {
-    VkCommandBufferAllocateInfo allocInfo{};
-    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    allocInfo.commandPool = m_Context.commandPool;
-    allocInfo.commandBufferCount = 1;
-
-    VkCommandBuffer commandBuffer;
-    vkAllocateCommandBuffers(m_Context.device, &allocInfo, &commandBuffer);
-
-    VkCommandBufferBeginInfo beginInfo{};
-    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-
-    vkBeginCommandBuffer(commandBuffer, &beginInfo);
-
-    VkImageMemoryBarrier barrier{};
-    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-    barrier.oldLayout = oldLayout;
-    barrier.newLayout = newLayout;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = m_Image;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.baseMipLevel = 0;
-    barrier.subresourceRange.levelCount = m_MipLevels;
-    barrier.subresourceRange.baseArrayLayer = 0;
-    barrier.subresourceRange.layerCount = m_ArrayLayers;
-
-    VkPipelineStageFlags sourceStage;
-    VkPipelineStageFlags destinationStage;
-
-    if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-        barrier.srcAccessMask = 0;
-        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-        destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-    } else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-        sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-        destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-    } else {
-        METAGFX_ERROR << "Unsupported layout transition";
-        return;
+void VulkanTexture::QueueUpload(const VulkanImageUpload& upload, uint64 size,
+                                const std::function<void(void*)>& write) {
+    // Recorded into the device's upload batch; no queue wait here. The image is
+    // sampleable on the graphics queue once the ticket completes.
+    m_UploadTicket = m_Context.uploadManager->UploadImage(upload, size, write);
+    // Where the upload batch leaves every subresource; its submission precedes the frames
+    for (VulkanResourceState& state : m_States) {
+        state = VulkanResourceState{};
+        state.layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
     }
 
-    vkCmdPipelineBarrier(commandBuffer, sourceStage, destinationStage,
-                        0, 0, nullptr, 0, nullptr, 1, &barrier);
-
-    vkEndCommandBuffer(commandBuffer);
-
-    VkSubmitInfo submitInfo{};
-    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-
-    vkQueueSubmit(m_Context.graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-    vkQueueWaitIdle(m_Context.graphicsQueue);
-
-    vkFreeCommandBuffers(m_Context.device, m_Context.commandPool, 1, &commandBuffer);
+    METAGFX_INFO << "Queued " << size << " bytes for upload to texture (ticket " << m_UploadTicket << ")";
 }
 
-uint32 VulkanTexture::FindMemoryType(uint32 typeFilter, VkMemoryPropertyFlags properties) {
-    VkPhysicalDeviceMemoryProperties memProperties;
-    vkGetPhysicalDeviceMemoryProperties(m_Context.physicalDevice, &memProperties);
-
-    for (uint32 i = 0; i < memProperties.memoryTypeCount; i++) {
-        if ((typeFilter & (1 << i)) &&
-            (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-            return i;
-        }
+VkImageAspectFlags VulkanTexture::GetAspectMask() const {
+    switch (m_VkFormat) {
+        case VK_FORMAT_D16_UNORM:
+        case VK_FORMAT_D32_SFLOAT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT;
+        case VK_FORMAT_D24_UNORM_S8_UINT:
+        case VK_FORMAT_D32_SFLOAT_S8_UINT:
+            return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+        default:
+            return VK_IMAGE_ASPECT_COLOR_BIT;
     }
+}
 
-    METAGFX_ERROR << "Failed to find suitable memory type";
-    return 0;
+bool VulkanTexture::IsUploadComplete() const {
+    return m_UploadTicket == 0 || m_Context.uploadManager->IsComplete(m_UploadTicket);
 }
 
 } // namespace rhi
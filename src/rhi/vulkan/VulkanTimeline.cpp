@@ -0,0 +1,196 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanTimeline.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/vulkan/VulkanTimeline.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+VulkanTimeline::VulkanTimeline(VulkanContext& context, VkQueue queue, bool timelineSemaphore)
+    : m_Context(context), m_Queue(queue) {
+    if (!timelineSemaphore) {
+        METAGFX_INFO << "Vulkan timeline semaphores not supported, using fences";
+        return;
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    VK_CHECK(vkCreateSemaphore(m_Context.device, &semaphoreInfo, nullptr, &m_Semaphore));
+}
+
+VulkanTimeline::~VulkanTimeline() {
+    Wait(GetSignaledValue());
+
+    for (const PendingFence& pending : m_PendingFences) {
+        vkDestroyFence(m_Context.device, pending.fence, nullptr);
+    }
+    for (VkFence fence : m_FreeFences) {
+        vkDestroyFence(m_Context.device, fence, nullptr);
+    }
+    if (m_Semaphore != VK_NULL_HANDLE) {
+        vkDestroySemaphore(m_Context.device, m_Semaphore, nullptr);
+    }
+}
+
+uint64 VulkanTimeline::Submit(uint32 submitCount, const VkSubmitInfo* submits, std::span<const Wait> waits) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint64 value = m_SignaledValue.load(std::memory_order_relaxed) + 1;
+
+    VkResult result = VK_SUCCESS;
+    if (m_Semaphore != VK_NULL_HANDLE) {
+        // Each batch adds its timeline waits to its own semaphores, and the last signals
+        // the timeline besides its own; binary semaphores ignore their values
+        struct BatchSemaphores {
+            std::vector<VkSemaphore> waits;
+            std::vector<VkPipelineStageFlags> waitStages;
+            std::vector<uint64> waitValues;
+            std::vector<VkSemaphore> signals;
+            std::vector<uint64> signalValues;
+        };
+        std::vector<VkSubmitInfo> batches(submits, submits + submitCount);
+        std::vector<BatchSemaphores> semaphores(submitCount);
+        std::vector<VkTimelineSemaphoreSubmitInfo> timelineInfos(submitCount);
+        for (uint32 i = 0; i < submitCount; ++i) {
+            VkSubmitInfo& batch = batches[i];
+            BatchSemaphores& lists = semaphores[i];
+            if (batch.waitSemaphoreCount > 0) {
+                lists.waits.assign(batch.pWaitSemaphores, batch.pWaitSemaphores + batch.waitSemaphoreCount);
+                lists.waitStages.assign(batch.pWaitDstStageMask, batch.pWaitDstStageMask + batch.waitSemaphoreCount);
+            }
+            lists.waitValues.assign(lists.waits.size(), 0);
+            for (const Wait& wait : waits) {
+                if (wait.batch == i && wait.semaphore != VK_NULL_HANDLE) {
+                    lists.waits.push_back(wait.semaphore);
+                    lists.waitStages.push_back(wait.stages);
+                    lists.waitValues.push_back(wait.value);
+                }
+            }
+            if (batch.signalSemaphoreCount > 0) {
+                lists.signals.assign(batch.pSignalSemaphores, batch.pSignalSemaphores + batch.signalSemaphoreCount);
+            }
+            lists.signalValues.assign(lists.signals.size(), 0);
+            if (i + 1 == submitCount) {
+                lists.signals.push_back(m_Semaphore);
+                lists.signalValues.push_back(value);
+            }
+
+            VkTimelineSemaphoreSubmitInfo& timelineInfo = timelineInfos[i];
+            timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+            timelineInfo.pNext = batch.pNext;
+            timelineInfo.waitSemaphoreValueCount = static_cast<uint32>(lists.waitValues.size());
+            timelineInfo.pWaitSemaphoreValues = lists.waitValues.data();
+            timelineInfo.signalSemaphoreValueCount = static_cast<uint32>(lists.signalValues.size());
+            timelineInfo.pSignalSemaphoreValues = lists.signalValues.data();
+
+            batch.pNext = &timelineInfo;
+            batch.waitSemaphoreCount = static_cast<uint32>(lists.waits.size());
+            batch.pWaitSemaphores = lists.waits.data();
+            batch.pWaitDstStageMask = lists.waitStages.data();
+            batch.signalSemaphoreCount = static_cast<uint32>(lists.signals.size());
+            batch.pSignalSemaphores = lists.signals.data();
+        }
+
+        result = vkQueueSubmit(m_Queue, submitCount, batches.data(), VK_NULL_HANDLE);
+    } else {
+        CollectFencesLocked();
+        VkFence fence = VK_NULL_HANDLE;
+        if (!m_FreeFences.empty()) {
+            fence = m_FreeFences.back();
+            m_FreeFences.pop_back();
+        } else {
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            VK_CHECK(vkCreateFence(m_Context.device, &fenceInfo, nullptr, &fence));
+        }
+
+        result = vkQueueSubmit(m_Queue, submitCount, submits, fence);
+        if (result == VK_SUCCESS) {
+            m_PendingFences.push_back({ value, fence });
+        } else {
+            m_FreeFences.push_back(fence);
+        }
+    }
+
+    if (result != VK_SUCCESS) {
+        METAGFX_ERROR << "Failed to submit to the queue: " << result;
+        return value - 1;
+    }
+    m_SignaledValue.store(value, std::memory_order_release);
+    return value;
+}
+
+VkResult VulkanTimeline::Present(const VkPresentInfoKHR& presentInfo) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return vkQueuePresentKHR(m_Queue, &presentInfo);
+}
+
+uint64 VulkanTimeline::GetCompletedValue() {
+    if (m_Semaphore != VK_NULL_HANDLE) {
+        uint64 value = 0;
+        if (vkGetSemaphoreCounterValue(m_Context.device, m_Semaphore, &value) == VK_SUCCESS) {
+            // Concurrent readers may store out of order; the value only moves forward
+            uint64 completed = m_CompletedValue.load(std::memory_order_relaxed);
+            while (completed < value &&
+                   !m_CompletedValue.compare_exchange_weak(completed, value, std::memory_order_acq_rel)) {
+            }
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        CollectFencesLocked();
+    }
+    return m_CompletedValue.load(std::memory_order_acquire);
+}
+
+void VulkanTimeline::Wait(uint64 value) {
+    value = std::min(value, GetSignaledValue());
+    if (value <= m_CompletedValue.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    if (m_Semaphore != VK_NULL_HANDLE) {
+        VkSemaphoreWaitInfo waitInfo{};
+        waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+        waitInfo.semaphoreCount = 1;
+        waitInfo.pSemaphores = &m_Semaphore;
+        waitInfo.pValues = &value;
+        VK_CHECK(vkWaitSemaphores(m_Context.device, &waitInfo, UINT64_MAX));
+        GetCompletedValue();
+        return;
+    }
+
+    // Held while waiting, so the fence is not recycled under the wait
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const PendingFence& pending : m_PendingFences) {
+        if (pending.value >= value) {
+            vkWaitForFences(m_Context.device, 1, &pending.fence, VK_TRUE, UINT64_MAX);
+            break;
+        }
+    }
+    CollectFencesLocked();
+}
+
+void VulkanTimeline::CollectFencesLocked() {
+    // Submissions to one queue complete in order
+    while (!m_PendingFences.empty()) {
+        PendingFence& pending = m_PendingFences.front();
+        if (vkGetFenceStatus(m_Context.device, pending.fence) != VK_SUCCESS) {
+            break;
+        }
+        m_CompletedValue.store(pending.value, std::memory_order_release);
+        vkResetFences(m_Context.device, 1, &pending.fence);
+        m_FreeFences.push_back(pending.fence);
+        m_PendingFences.pop_front();
+    }
+}
+
+} // namespace rhi
+} // namespace metagfx
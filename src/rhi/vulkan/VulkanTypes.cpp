@@ -9,18 +9,44 @@ namespace rhi {
 VkFormat ToVulkanFormat(Format format) {
     switch (format) {
         case Format::R8_UNORM: return VK_FORMAT_R8_UNORM;
+        case Format::R8_UINT: return VK_FORMAT_R8_UINT;
+        case Format::R8G8_UNORM: return VK_FORMAT_R8G8_UNORM;
         case Format::R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_UNORM;
         case Format::R8G8B8A8_SRGB: return VK_FORMAT_R8G8B8A8_SRGB;
         case Format::B8G8R8A8_UNORM: return VK_FORMAT_B8G8R8A8_UNORM;
         case Format::B8G8R8A8_SRGB: return VK_FORMAT_B8G8R8A8_SRGB;
+        case Format::R16G16_SNORM: return VK_FORMAT_R16G16_SNORM;
         case Format::R16G16_SFLOAT: return VK_FORMAT_R16G16_SFLOAT;
+        case Format::R16G16B16A16_UNORM: return VK_FORMAT_R16G16B16A16_UNORM;
         case Format::R16G16B16A16_SFLOAT: return VK_FORMAT_R16G16B16A16_SFLOAT;
+        case Format::R32_UINT: return VK_FORMAT_R32_UINT;
         case Format::R32_SFLOAT: return VK_FORMAT_R32_SFLOAT;
         case Format::R32G32_SFLOAT: return VK_FORMAT_R32G32_SFLOAT;
         case Format::R32G32B32_SFLOAT: return VK_FORMAT_R32G32B32_SFLOAT;
+        case Format::R32G32B32A32_UINT: return VK_FORMAT_R32G32B32A32_UINT;
         case Format::R32G32B32A32_SFLOAT: return VK_FORMAT_R32G32B32A32_SFLOAT;
+        case Format::D16_UNORM: return VK_FORMAT_D16_UNORM;
         case Format::D32_SFLOAT: return VK_FORMAT_D32_SFLOAT;
         case Format::D24_UNORM_S8_UINT: return VK_FORMAT_D24_UNORM_S8_UINT;
+        case Format::BC1_RGBA_UNORM: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case Format::BC1_RGBA_SRGB: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case Format::BC3_RGBA_UNORM: return VK_FORMAT_BC3_UNORM_BLOCK;
+        case Format::BC3_RGBA_SRGB: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case Format::BC4_R_UNORM: return VK_FORMAT_BC4_UNORM_BLOCK;
+        case Format::BC5_RG_UNORM: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case Format::BC6H_RGB_UFLOAT: return VK_FORMAT_BC6H_UFLOAT_BLOCK;
+        case Format::BC7_RGBA_UNORM: return VK_FORMAT_BC7_UNORM_BLOCK;
+        case Format::BC7_RGBA_SRGB: return VK_FORMAT_BC7_SRGB_BLOCK;
+        case Format::ETC2_RGB8_UNORM: return VK_FORMAT_ETC2_R8G8B8_UNORM_BLOCK;
+        case Format::ETC2_RGB8_SRGB: return VK_FORMAT_ETC2_R8G8B8_SRGB_BLOCK;
+        case Format::ETC2_RGBA8_UNORM: return VK_FORMAT_ETC2_R8G8B8A8_UNORM_BLOCK;
+        case Format::ETC2_RGBA8_SRGB: return VK_FORMAT_ETC2_R8G8B8A8_SRGB_BLOCK;
+        case Format::ASTC_4x4_UNORM: return VK_FORMAT_ASTC_4x4_UNORM_BLOCK;
+        case Format::ASTC_4x4_SRGB: return VK_FORMAT_ASTC_4x4_SRGB_BLOCK;
+        case Format::ASTC_6x6_UNORM: return VK_FORMAT_ASTC_6x6_UNORM_BLOCK;
+        case Format::ASTC_6x6_SRGB: return VK_FORMAT_ASTC_6x6_SRGB_BLOCK;
+        case Format::ASTC_8x8_UNORM: return VK_FORMAT_ASTC_8x8_UNORM_BLOCK;
+        case Format::ASTC_8x8_SRGB: return VK_FORMAT_ASTC_8x8_SRGB_BLOCK;
         default: return VK_FORMAT_UNDEFINED;
     }
 }
@@ -28,16 +54,23 @@ VkFormat ToVulkanFormat(Format format) {
 Format FromVulkanFormat(VkFormat format) {
     switch (format) {
         case VK_FORMAT_R8_UNORM: return Format::R8_UNORM;
+        case VK_FORMAT_R8_UINT: return Format::R8_UINT;
+        case VK_FORMAT_R8G8_UNORM: return Format::R8G8_UNORM;
         case VK_FORMAT_R8G8B8A8_UNORM: return Format::R8G8B8A8_UNORM;
         case VK_FORMAT_R8G8B8A8_SRGB: return Format::R8G8B8A8_SRGB;
         case VK_FORMAT_B8G8R8A8_UNORM: return Format::B8G8R8A8_UNORM;
         case VK_FORMAT_B8G8R8A8_SRGB: return Format::B8G8R8A8_SRGB;
+        case VK_FORMAT_R16G16_SNORM: return Format::R16G16_SNORM;
         case VK_FORMAT_R16G16_SFLOAT: return Format::R16G16_SFLOAT;
+        case VK_FORMAT_R16G16B16A16_UNORM: return Format::R16G16B16A16_UNORM;
         case VK_FORMAT_R16G16B16A16_SFLOAT: return Format::R16G16B16A16_SFLOAT;
+        case VK_FORMAT_R32_UINT: return Format::R32_UINT;
         case VK_FORMAT_R32_SFLOAT: return Format::R32_SFLOAT;
         case VK_FORMAT_R32G32_SFLOAT: return Format::R32G32_SFLOAT;
         case VK_FORMAT_R32G32B32_SFLOAT: return Format::R32G32B32_SFLOAT;
+        case VK_FORMAT_R32G32B32A32_UINT: return Format::R32G32B32A32_UINT;
         case VK_FORMAT_R32G32B32A32_SFLOAT: return Format::R32G32B32A32_SFLOAT;
+        case VK_FORMAT_D16_UNORM: return Format::D16_UNORM;
         case VK_FORMAT_D32_SFLOAT: return Format::D32_SFLOAT;
         case VK_FORMAT_D24_UNORM_S8_UINT: return Format::D24_UNORM_S8_UINT;
         default: return Format::Undefined;
@@ -58,6 +91,11 @@ VkBufferUsageFlags ToVulkanBufferUsage(BufferUsage usage) {
         flags |= VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
     if ((usage & BufferUsage::TransferDst) != BufferUsage{})
         flags |= VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    if ((usage & BufferUsage::Indirect) != BufferUsage{})
+        flags |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    if ((usage & BufferUsage::AccelerationStructureInput) != BufferUsage{})
+        flags |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR |
+                 VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
     return flags;
 }
 
@@ -140,5 +178,27 @@ VkCompareOp ToVulkanCompareOp(CompareOp op) {
     }
 }
 
+VkSampleCountFlagBits ToVulkanSampleCount(uint32 count) {
+    switch (count) {
+        case 2: return VK_SAMPLE_COUNT_2_BIT;
+        case 4: return VK_SAMPLE_COUNT_4_BIT;
+        case 8: return VK_SAMPLE_COUNT_8_BIT;
+        case 16: return VK_SAMPLE_COUNT_16_BIT;
+        default: return VK_SAMPLE_COUNT_1_BIT;
+    }
+}
+
+uint32 ToVulkanViewMask(uint32 viewCount) {
+    return viewCount > 1 ? (1u << viewCount) - 1 : 0;
+}
+
+VkAttachmentLoadOp ToVulkanLoadOp(LoadOp op) {
+    switch (op) {
+        case LoadOp::Load: return VK_ATTACHMENT_LOAD_OP_LOAD;
+        case LoadOp::DontCare: return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        default: return VK_ATTACHMENT_LOAD_OP_CLEAR;
+    }
+}
+
 } // namespace rhi
 } // namespace metagfx
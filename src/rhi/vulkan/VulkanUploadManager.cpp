@@ -0,0 +1,720 @@
+// ============================================================================
+// src/rhi/vulkan/VulkanUploadManager.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/vulkan/VulkanUploadManager.h"
+#include "metagfx/rhi/vulkan/VulkanTimeline.h"
+
+#include <cstring>
+#include <numeric>
+
+namespace metagfx {
+namespace rhi {
+
+// Persistent staging ring shared by every upload
+static constexpr VkDeviceSize STAGING_RING_SIZE = 32ull * 1024 * 1024;
+
+// Submit the open batch early once a quarter of the ring is staged, so a large model load
+// keeps recycling ring space instead of filling it before the next frame
+static constexpr uint64 MAX_BATCH_STAGING_BYTES = STAGING_RING_SIZE / 4;
+
+VulkanUploadManager::VulkanUploadManager(VulkanContext& context)
+    : m_Context(context) {
+    CreateStagingRing();
+
+    METAGFX_INFO << "Vulkan texture uploads: "
+                 << (UsesTransferQueue() ? "dedicated transfer queue (family " : "graphics queue (family ")
+                 << m_Context.transferQueueFamily << ")";
+}
+
+VulkanUploadManager::~VulkanUploadManager() {
+    // Open batches were never submitted, so nothing on the GPU references them
+    for (auto& [thread, context] : m_Contexts) {
+        Batch& batch = context->openBatch;
+        if (batch.transferCmd != VK_NULL_HANDLE) {
+            vkEndCommandBuffer(batch.transferCmd);
+            if (batch.acquireCmd != VK_NULL_HANDLE) {
+                vkEndCommandBuffer(batch.acquireCmd);
+            }
+            RecycleBatch(batch);
+        }
+    }
+
+    if (!m_InFlight.empty()) {
+        m_Context.timeline->Wait(m_InFlight.back().timelineValue);
+    }
+    for (Batch& batch : m_InFlight) {
+        RecycleBatch(batch);
+    }
+    m_InFlight.clear();
+
+    if (m_RingBuffer != VK_NULL_HANDLE) {
+        vkDestroyBuffer(m_Context.device, m_RingBuffer, nullptr);
+        m_Context.memory->Remove(MemoryCategory::Staging, m_RingAllocation.size);
+        m_Context.allocator->Free(m_RingAllocation);
+    }
+
+    // Destroying the pools frees their command buffers
+    for (auto& [thread, context] : m_Contexts) {
+        if (context->acquirePool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(m_Context.device, context->acquirePool, nullptr);
+        }
+        vkDestroyCommandPool(m_Context.device, context->transferPool, nullptr);
+    }
+}
+
+VulkanUploadTicket VulkanUploadManager::UploadImage(const VulkanImageUpload& upload, const void* data, uint64 size) {
+    return UploadImage(upload, size, [data, size](void* staging) {
+        memcpy(staging, data, size);
+    });
+}
+
+VulkanUploadTicket VulkanUploadManager::UploadImage(const VulkanImageUpload& upload, uint64 size,
+                                                    const std::function<void(void*)>& write) {
+    UploadContext& context = GetThreadContext();
+    std::lock_guard<std::mutex> lock(context.mutex);
+
+    // Copy offsets must be a multiple of the texel size and of 4
+    VkDeviceSize alignment = std::lcm<VkDeviceSize>(std::max(upload.texelSize, 1u), 4);
+    alignment = std::lcm(alignment, std::max<VkDeviceSize>(
+        m_Context.deviceProperties.limits.optimalBufferCopyOffsetAlignment, 1));
+
+    StagingSlice staging;
+    if (!AllocateStaging(context, size, alignment, staging)) {
+        return 0;
+    }
+    write(staging.mappedData);
+
+    Batch& batch = context.openBatch;
+    std::vector<VkBufferImageCopy> regions = upload.regions;
+    for (VkBufferImageCopy& region : regions) {
+        region.bufferOffset += staging.offset;
+    }
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = upload.image;
+    barrier.subresourceRange.aspectMask = upload.aspectMask;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = upload.mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = upload.arrayLayers;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    vkCmdPipelineBarrier(batch.transferCmd,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    vkCmdCopyBufferToImage(batch.transferCmd, staging.buffer, upload.image,
+                           VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                           static_cast<uint32>(regions.size()), regions.data());
+
+    if (upload.generateMipmaps && upload.mipLevels > 1) {
+        if (UsesTransferQueue()) {
+            // Hand the image to the graphics queue still in TRANSFER_DST; the blits run there
+            barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.srcQueueFamilyIndex = m_Context.transferQueueFamily;
+            barrier.dstQueueFamilyIndex = m_Context.graphicsQueueFamily;
+            barrier.dstAccessMask = 0;
+            vkCmdPipelineBarrier(batch.transferCmd,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+            vkCmdPipelineBarrier(batch.acquireCmd,
+                                 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                                 VK_PIPELINE_STAGE_TRANSFER_BIT,
+                                 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+            RecordMipChain(batch.acquireCmd, upload);
+        } else {
+            RecordMipChain(batch.transferCmd, upload);
+        }
+
+        VulkanUploadTicket ticket = batch.ticket;
+        EndUpload(context, size);
+        return ticket;
+    }
+
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    if (UsesTransferQueue()) {
+        // Release on the transfer queue...
+        barrier.srcQueueFamilyIndex = m_Context.transferQueueFamily;
+        barrier.dstQueueFamilyIndex = m_Context.graphicsQueueFamily;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.transferCmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        // ...and acquire on the graphics queue (same layouts, as the spec requires)
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(batch.acquireCmd,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+    } else {
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(batch.transferCmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    VulkanUploadTicket ticket = batch.ticket;
+    EndUpload(context, size);
+    return ticket;
+}
+
+void VulkanUploadManager::RecordMipChain(VkCommandBuffer cmd, const VulkanImageUpload& upload) {
+    // All levels are in TRANSFER_DST_OPTIMAL with mip 0 written. Each level is turned
+    // into a blit source, downsampled into the next one, then made shader-readable.
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = upload.image;
+    barrier.subresourceRange.aspectMask = upload.aspectMask;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = upload.arrayLayers;
+
+    int32 mipWidth = static_cast<int32>(upload.width);
+    int32 mipHeight = static_cast<int32>(upload.height);
+
+    for (uint32 level = 1; level < upload.mipLevels; ++level) {
+        barrier.subresourceRange.baseMipLevel = level - 1;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        int32 nextWidth = std::max(mipWidth / 2, 1);
+        int32 nextHeight = std::max(mipHeight / 2, 1);
+
+        VkImageBlit blit{};
+        blit.srcOffsets[0] = {0, 0, 0};
+        blit.srcOffsets[1] = {mipWidth, mipHeight, 1};
+        blit.srcSubresource.aspectMask = upload.aspectMask;
+        blit.srcSubresource.mipLevel = level - 1;
+        blit.srcSubresource.baseArrayLayer = 0;
+        blit.srcSubresource.layerCount = upload.arrayLayers;
+        blit.dstOffsets[0] = {0, 0, 0};
+        blit.dstOffsets[1] = {nextWidth, nextHeight, 1};
+        blit.dstSubresource.aspectMask = upload.aspectMask;
+        blit.dstSubresource.mipLevel = level;
+        blit.dstSubresource.baseArrayLayer = 0;
+        blit.dstSubresource.layerCount = upload.arrayLayers;
+
+        vkCmdBlitImage(cmd,
+                       upload.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       upload.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1, &blit, VK_FILTER_LINEAR);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        mipWidth = nextWidth;
+        mipHeight = nextHeight;
+    }
+
+    // The last level was only ever a blit destination
+    barrier.subresourceRange.baseMipLevel = upload.mipLevels - 1;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+VulkanUploadTicket VulkanUploadManager::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void* data, uint64 size,
+                                                     VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    return UploadBuffer(buffer, offset, size, [data, size](void* staging) {
+        memcpy(staging, data, size);
+    }, dstStage, dstAccess);
+}
+
+VulkanUploadTicket VulkanUploadManager::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, uint64 size,
+                                                     const std::function<void(void*)>& write,
+                                                     VkPipelineStageFlags dstStage, VkAccessFlags dstAccess) {
+    UploadContext& context = GetThreadContext();
+    std::lock_guard<std::mutex> lock(context.mutex);
+
+    StagingSlice staging;
+    if (!AllocateStaging(context, size, 4, staging)) {
+        return 0;
+    }
+    write(staging.mappedData);
+
+    Batch& batch = context.openBatch;
+    VkBufferCopy region{};
+    region.srcOffset = staging.offset;
+    region.dstOffset = offset;
+    region.size = size;
+    vkCmdCopyBuffer(batch.transferCmd, staging.buffer, buffer, 1, &region);
+
+    VkBufferMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = buffer;
+    barrier.offset = offset;
+    barrier.size = size;
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    if (UsesTransferQueue()) {
+        barrier.srcQueueFamilyIndex = m_Context.transferQueueFamily;
+        barrier.dstQueueFamilyIndex = m_Context.graphicsQueueFamily;
+        barrier.dstAccessMask = 0;
+        vkCmdPipelineBarrier(batch.transferCmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(batch.acquireCmd,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, dstStage,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+    } else {
+        barrier.dstAccessMask = dstAccess;
+        vkCmdPipelineBarrier(batch.transferCmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage,
+                             0, 0, nullptr, 1, &barrier, 0, nullptr);
+    }
+
+    VulkanUploadTicket ticket = batch.ticket;
+    EndUpload(context, size);
+    return ticket;
+}
+
+VulkanUploadTicket VulkanUploadManager::TransitionImage(VkImage image, VkImageAspectFlags aspectMask,
+                                                        uint32 mipLevels, uint32 arrayLayers,
+                                                        VkImageLayout newLayout) {
+    UploadContext& context = GetThreadContext();
+    std::lock_guard<std::mutex> lock(context.mutex);
+    {
+        std::lock_guard<std::mutex> managerLock(m_Mutex);
+        if (context.openBatch.transferCmd == VK_NULL_HANDLE) {
+            BeginBatch(context);
+        }
+    }
+    Batch& batch = context.openBatch;
+
+    VkImageMemoryBarrier barrier{};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = newLayout;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image;
+    barrier.subresourceRange.aspectMask = aspectMask;
+    barrier.subresourceRange.baseMipLevel = 0;
+    barrier.subresourceRange.levelCount = mipLevels;
+    barrier.subresourceRange.baseArrayLayer = 0;
+    barrier.subresourceRange.layerCount = arrayLayers;
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    // Never owned by any queue yet, so no ownership transfer: record it where the
+    // graphics queue executes it
+    VkCommandBuffer cmd = UsesTransferQueue() ? batch.acquireCmd : batch.transferCmd;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+    VulkanUploadTicket ticket = batch.ticket;
+    EndUpload(context, 0);
+    return ticket;
+}
+
+void VulkanUploadManager::Flush() {
+    METAGFX_PROFILE_SCOPE("Upload flush");
+    for (UploadContext* context : GetContexts()) {
+        std::lock_guard<std::mutex> contextLock(context->mutex);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        SubmitOpenBatch(*context);
+    }
+}
+
+void VulkanUploadManager::CollectCompleted() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    CollectCompletedLocked();
+}
+
+bool VulkanUploadManager::IsComplete(VulkanUploadTicket ticket) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (ticket == 0) {
+        return true;
+    }
+    CollectCompletedLocked();
+    return ticket < m_NextTicket && m_PendingTickets.count(ticket) == 0;
+}
+
+void VulkanUploadManager::Wait(VulkanUploadTicket ticket) {
+    if (IsComplete(ticket)) {
+        return;
+    }
+    METAGFX_PROFILE_SCOPE("Upload wait");
+    m_Context.stats->AddUploadWait();
+
+    // Still open on some thread: submit it
+    for (UploadContext* context : GetContexts()) {
+        std::lock_guard<std::mutex> contextLock(context->mutex);
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (context->openBatch.ticket == ticket) {
+            SubmitOpenBatch(*context);
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    // Batches complete in submission order, so waiting on this one covers older ones
+    for (Batch& batch : m_InFlight) {
+        if (batch.ticket == ticket) {
+            m_Context.timeline->Wait(batch.timelineValue);
+            break;
+        }
+    }
+    CollectCompletedLocked();
+}
+
+uint32 VulkanUploadManager::GetPendingBatchCount() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return static_cast<uint32>(m_InFlight.size()) + m_OpenBatchCount;
+}
+
+VkDeviceSize VulkanUploadManager::GetStagingRingBytesInUse() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_RingHead - m_RingTail;
+}
+
+VulkanUploadManager::UploadContext& VulkanUploadManager::GetThreadContext() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::unique_ptr<UploadContext>& context = m_Contexts[std::this_thread::get_id()];
+    if (!context) {
+        context = std::make_unique<UploadContext>();
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.queueFamilyIndex = m_Context.transferQueueFamily;
+        VK_CHECK(vkCreateCommandPool(m_Context.device, &poolInfo, nullptr, &context->transferPool));
+
+        if (UsesTransferQueue()) {
+            poolInfo.queueFamilyIndex = m_Context.graphicsQueueFamily;
+            VK_CHECK(vkCreateCommandPool(m_Context.device, &poolInfo, nullptr, &context->acquirePool));
+        }
+    }
+    return *context;
+}
+
+std::vector<VulkanUploadManager::UploadContext*> VulkanUploadManager::GetContexts() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<UploadContext*> contexts;
+    contexts.reserve(m_Contexts.size());
+    for (auto& [thread, context] : m_Contexts) {
+        contexts.push_back(context.get());
+    }
+    return contexts;
+}
+
+void VulkanUploadManager::CreateStagingRing() {
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = STAGING_RING_SIZE;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VK_CHECK(vkCreateBuffer(m_Context.device, &bufferInfo, nullptr, &m_RingBuffer));
+
+    if (!m_Context.allocator->AllocateBuffer(m_RingBuffer,
+                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                             m_RingAllocation)) {
+        METAGFX_ERROR << "Upload manager: failed to allocate staging ring, every upload will use its own staging buffer";
+        vkDestroyBuffer(m_Context.device, m_RingBuffer, nullptr);
+        m_RingBuffer = VK_NULL_HANDLE;
+        return;
+    }
+    m_RingSize = STAGING_RING_SIZE;
+    m_Context.memory->Add(MemoryCategory::Staging, m_RingAllocation.size);
+}
+
+bool VulkanUploadManager::AllocateStaging(UploadContext& context, VkDeviceSize size, VkDeviceSize alignment,
+                                          StagingSlice& outSlice) {
+    if (size == 0) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Batch& batch = context.openBatch;
+
+    if (m_RingBuffer != VK_NULL_HANDLE && size <= m_RingSize) {
+        VkDeviceSize offset = 0;
+        bool allocated = false;
+        while (!(allocated = AllocateFromRing(size, alignment, offset))) {
+            // Ring full: this thread's open batch holds part of it, submit so it can
+            // retire, then wait for the oldest batch to hand its range back. Ranges held
+            // by other threads' open batches only come back once they submit, so with
+            // nothing left in flight the upload takes the overflow path.
+            if (batch.usesRing) {
+                SubmitOpenBatch(context);
+            }
+            if (m_InFlight.empty()) {
+                break;
+            }
+            m_Context.timeline->Wait(m_InFlight.front().timelineValue);
+            CollectCompletedLocked();
+        }
+
+        if (allocated) {
+            if (batch.transferCmd == VK_NULL_HANDLE) {
+                BeginBatch(context);
+            }
+            batch.usesRing = true;
+            m_RingRanges.push_back({ m_RingHead, batch.ticket });
+
+            outSlice.buffer = m_RingBuffer;
+            outSlice.offset = offset;
+            outSlice.mappedData = static_cast<uint8*>(m_RingAllocation.mappedData) + offset;
+            return true;
+        }
+    }
+
+    // Overflow: bigger than the whole ring (no ring, or a ring held by other threads' open
+    // batches), so it gets its own short-lived buffer from a linear block that is recycled
+    // once the batch has finished
+    if (!m_LoggedOverflow) {
+        METAGFX_WARN << "Upload manager: " << size << " byte upload exceeds the " << m_RingSize
+                     << " byte staging ring, using a dedicated staging buffer";
+        m_LoggedOverflow = true;
+    }
+
+    StagingBuffer staging;
+
+    VkBufferCreateInfo bufferInfo{};
+    bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VK_CHECK(vkCreateBuffer(m_Context.device, &bufferInfo, nullptr, &staging.buffer));
+
+    if (!m_Context.allocator->AllocateBuffer(staging.buffer,
+                                             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                                             VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                                             staging.allocation, VulkanAllocationStrategy::Linear)) {
+        METAGFX_ERROR << "Upload manager: failed to allocate " << size << " bytes of staging memory";
+        vkDestroyBuffer(m_Context.device, staging.buffer, nullptr);
+        return false;
+    }
+
+    m_Context.memory->Add(MemoryCategory::Staging, staging.allocation.size);
+
+    if (batch.transferCmd == VK_NULL_HANDLE) {
+        BeginBatch(context);
+    }
+    batch.stagingBuffers.push_back(staging);
+
+    outSlice.buffer = staging.buffer;
+    outSlice.offset = 0;
+    outSlice.mappedData = staging.allocation.mappedData;
+    return true;
+}
+
+bool VulkanUploadManager::AllocateFromRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset) {
+    // Nothing staged: restart at offset 0 so a large slice is not split by the wrap point
+    if (m_RingHead == m_RingTail) {
+        m_RingHead = (m_RingHead + m_RingSize - 1) / m_RingSize * m_RingSize;
+        m_RingTail = m_RingHead;
+    }
+
+    uint64 head = (m_RingHead + alignment - 1) / alignment * alignment;
+
+    // A slice never wraps: skip the tail end of the ring and start again at offset 0
+    if (head % m_RingSize + size > m_RingSize) {
+        head = (head / m_RingSize + 1) * m_RingSize;
+    }
+
+    if (head + size - m_RingTail > m_RingSize) {
+        return false;
+    }
+
+    outOffset = head % m_RingSize;
+    m_RingHead = head + size;
+    return true;
+}
+
+void VulkanUploadManager::EndUpload(UploadContext& context, uint64 size) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Batch& batch = context.openBatch;
+    batch.uploadCount++;
+    batch.stagedBytes += size;
+    if (batch.stagedBytes >= MAX_BATCH_STAGING_BYTES) {
+        SubmitOpenBatch(context);
+    }
+}
+
+void VulkanUploadManager::BeginBatch(UploadContext& context) {
+    Batch& batch = context.openBatch;
+    batch = Batch{};
+    batch.ticket = m_NextTicket++;
+    batch.context = &context;
+    m_PendingTickets.insert(batch.ticket);
+    m_OpenBatchCount++;
+
+    // Command buffers of finished batches are begun again as they are; the pools
+    // allow resetting them one by one, and begin does that implicitly
+    auto takeCommandBuffer = [this](std::vector<VkCommandBuffer>& freeList, VkCommandPool pool) {
+        if (freeList.empty()) {
+            return AllocateCommandBuffer(pool);
+        }
+        VkCommandBuffer commandBuffer = freeList.back();
+        freeList.pop_back();
+        return commandBuffer;
+    };
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    batch.transferCmd = takeCommandBuffer(context.freeTransferCmds, context.transferPool);
+    vkBeginCommandBuffer(batch.transferCmd, &beginInfo);
+
+    if (UsesTransferQueue()) {
+        batch.acquireCmd = takeCommandBuffer(context.freeAcquireCmds, context.acquirePool);
+        vkBeginCommandBuffer(batch.acquireCmd, &beginInfo);
+    }
+}
+
+void VulkanUploadManager::SubmitOpenBatch(UploadContext& context) {
+    Batch& batch = context.openBatch;
+    if (batch.transferCmd == VK_NULL_HANDLE) {
+        return;
+    }
+
+    vkEndCommandBuffer(batch.transferCmd);
+
+    VkSubmitInfo transferSubmit{};
+    transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    transferSubmit.commandBufferCount = 1;
+    transferSubmit.pCommandBuffers = &batch.transferCmd;
+
+    if (UsesTransferQueue()) {
+        vkEndCommandBuffer(batch.acquireCmd);
+
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        VK_CHECK(vkCreateSemaphore(m_Context.device, &semaphoreInfo, nullptr, &batch.semaphore));
+
+        transferSubmit.signalSemaphoreCount = 1;
+        transferSubmit.pSignalSemaphores = &batch.semaphore;
+        VK_CHECK(vkQueueSubmit(m_Context.transferQueue, 1, &transferSubmit, VK_NULL_HANDLE));
+
+        // Graphics work submitted after this (the next frame) is ordered behind the acquire barriers
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo acquireSubmit{};
+        acquireSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        acquireSubmit.waitSemaphoreCount = 1;
+        acquireSubmit.pWaitSemaphores = &batch.semaphore;
+        acquireSubmit.pWaitDstStageMask = &waitStage;
+        acquireSubmit.commandBufferCount = 1;
+        acquireSubmit.pCommandBuffers = &batch.acquireCmd;
+        batch.timelineValue = m_Context.timeline->Submit(1, &acquireSubmit);
+    } else {
+        batch.timelineValue = m_Context.timeline->Submit(1, &transferSubmit);
+    }
+
+    METAGFX_DEBUG << "Upload manager: submitted batch " << batch.ticket << " ("
+                  << batch.uploadCount << " uploads, " << batch.stagedBytes << " bytes)";
+
+    m_InFlight.push_back(std::move(batch));
+    batch = Batch{};
+    m_OpenBatchCount--;
+}
+
+void VulkanUploadManager::CollectCompletedLocked() {
+    if (m_InFlight.empty()) {
+        return;
+    }
+    uint64 completedValue = m_Context.timeline->GetCompletedValue();
+    bool retired = false;
+    while (!m_InFlight.empty()) {
+        Batch& batch = m_InFlight.front();
+        if (batch.timelineValue > completedValue) {
+            break;
+        }
+        m_PendingTickets.erase(batch.ticket);
+        RecycleBatch(batch);
+        m_InFlight.pop_front();
+        retired = true;
+    }
+    if (retired) {
+        AdvanceRingTail();
+    }
+}
+
+void VulkanUploadManager::AdvanceRingTail() {
+    // Threads submit in any order, so a finished batch's range is only handed back once
+    // every range staged before it has been too
+    while (!m_RingRanges.empty() && m_PendingTickets.count(m_RingRanges.front().ticket) == 0) {
+        m_RingTail = m_RingRanges.front().end;
+        m_RingRanges.pop_front();
+    }
+}
+
+void VulkanUploadManager::RecycleBatch(Batch& batch) {
+    for (StagingBuffer& staging : batch.stagingBuffers) {
+        vkDestroyBuffer(m_Context.device, staging.buffer, nullptr);
+        m_Context.memory->Remove(MemoryCategory::Staging, staging.allocation.size);
+        m_Context.allocator->Free(staging.allocation);
+    }
+    batch.stagingBuffers.clear();
+
+    if (batch.transferCmd != VK_NULL_HANDLE) {
+        batch.context->freeTransferCmds.push_back(batch.transferCmd);
+    }
+    if (batch.acquireCmd != VK_NULL_HANDLE) {
+        batch.context->freeAcquireCmds.push_back(batch.acquireCmd);
+    }
+    if (batch.semaphore != VK_NULL_HANDLE) {
+        vkDestroySemaphore(m_Context.device, batch.semaphore, nullptr);
+    }
+    batch = Batch{};
+}
+
+VkCommandBuffer VulkanUploadManager::AllocateCommandBuffer(VkCommandPool pool) {
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool = pool;
+    allocInfo.commandBufferCount = 1;
+
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VK_CHECK(vkAllocateCommandBuffers(m_Context.device, &allocInfo, &commandBuffer));
+    return commandBuffer;
+}
+
+} // namespace rhi
+} // namespace metagfx
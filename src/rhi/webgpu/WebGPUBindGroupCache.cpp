@@ -0,0 +1,150 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUBindGroupCache.cpp
+// ============================================================================
+#include "metagfx/rhi/webgpu/WebGPUBindGroupCache.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+// Boost-style hash combine
+template<typename T>
+static void HashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// The fields WebGPUDescriptorSet fills in
+static bool SameLayoutEntry(const wgpu::BindGroupLayoutEntry& a, const wgpu::BindGroupLayoutEntry& b) {
+    return a.binding == b.binding && a.visibility == b.visibility &&
+           a.buffer.type == b.buffer.type && a.buffer.hasDynamicOffset == b.buffer.hasDynamicOffset &&
+           a.buffer.minBindingSize == b.buffer.minBindingSize &&
+           a.sampler.type == b.sampler.type &&
+           a.texture.sampleType == b.texture.sampleType && a.texture.viewDimension == b.texture.viewDimension &&
+           a.texture.multisampled == b.texture.multisampled &&
+           a.storageTexture.access == b.storageTexture.access && a.storageTexture.format == b.storageTexture.format &&
+           a.storageTexture.viewDimension == b.storageTexture.viewDimension;
+}
+
+bool WebGPUBindGroupCache::BindGroupKey::operator==(const BindGroupKey& other) const {
+    if (layout.Get() != other.layout.Get() || entries.size() != other.entries.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < entries.size(); ++i) {
+        const wgpu::BindGroupEntry& a = entries[i];
+        const wgpu::BindGroupEntry& b = other.entries[i];
+        if (a.binding != b.binding || a.buffer.Get() != b.buffer.Get() || a.offset != b.offset ||
+            a.size != b.size || a.sampler.Get() != b.sampler.Get() || a.textureView.Get() != b.textureView.Get()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t WebGPUBindGroupCache::BindGroupKeyHash::operator()(const BindGroupKey& key) const {
+    size_t seed = 0;
+    HashCombine(seed, static_cast<const void*>(key.layout.Get()));
+    for (const wgpu::BindGroupEntry& entry : key.entries) {
+        HashCombine(seed, entry.binding);
+        HashCombine(seed, static_cast<const void*>(entry.buffer.Get()));
+        HashCombine(seed, entry.offset);
+        HashCombine(seed, entry.size);
+        HashCombine(seed, static_cast<const void*>(entry.sampler.Get()));
+        HashCombine(seed, static_cast<const void*>(entry.textureView.Get()));
+    }
+    return seed;
+}
+
+WebGPUBindGroupCache::WebGPUBindGroupCache(WebGPUContext& context)
+    : m_Context(context) {
+}
+
+wgpu::BindGroupLayout WebGPUBindGroupCache::AcquireLayout(const std::vector<wgpu::BindGroupLayoutEntry>& entries) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    for (const Layout& layout : m_Layouts) {
+        if (layout.entries.size() == entries.size() &&
+            std::equal(entries.begin(), entries.end(), layout.entries.begin(), SameLayoutEntry)) {
+            return layout.layout;
+        }
+    }
+
+    wgpu::BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.label = "Bind Group Layout";
+    layoutDesc.entryCount = entries.size();
+    layoutDesc.entries = entries.data();
+    wgpu::BindGroupLayout layout = m_Context.device.CreateBindGroupLayout(&layoutDesc);
+    if (layout) {
+        m_Layouts.push_back({ entries, layout });
+    }
+    return layout;
+}
+
+wgpu::BindGroupLayout WebGPUBindGroupCache::AcquirePushConstantLayout() {
+    wgpu::BindGroupLayoutEntry entry{};
+    entry.binding = 0;
+    entry.visibility = wgpu::ShaderStage::Vertex | wgpu::ShaderStage::Fragment;
+    entry.buffer.type = wgpu::BufferBindingType::Uniform;
+    entry.buffer.hasDynamicOffset = true;
+    entry.buffer.minBindingSize = WEBGPU_MAX_PUSH_CONSTANT_SIZE;
+    return AcquireLayout({ entry });
+}
+
+wgpu::BindGroup WebGPUBindGroupCache::AcquireBindGroup(const wgpu::BindGroupLayout& layout,
+                                                       const std::vector<wgpu::BindGroupEntry>& entries) {
+    BindGroupKey key{ layout, entries };
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_BindGroups.find(key);
+    if (it != m_BindGroups.end()) {
+        ++m_Hits;
+        m_LRU.splice(m_LRU.begin(), m_LRU, it->second.lruPosition);
+        return it->second.bindGroup;
+    }
+    ++m_Misses;
+
+    wgpu::BindGroupDescriptor groupDesc{};
+    groupDesc.label = "Bind Group";
+    groupDesc.layout = layout;
+    groupDesc.entryCount = entries.size();
+    groupDesc.entries = entries.data();
+    wgpu::BindGroup bindGroup = m_Context.device.CreateBindGroup(&groupDesc);
+    m_Context.stats->AddDescriptorUpdates(static_cast<uint32>(entries.size()));
+    if (!bindGroup) {
+        return nullptr;
+    }
+
+    // Descriptor sets hold on to the bind groups they use, so dropping one here only
+    // means it is built again should its combination come back
+    if (m_BindGroups.size() >= MAX_BIND_GROUPS) {
+        m_BindGroups.erase(m_LRU.back());
+        m_LRU.pop_back();
+        ++m_Evictions;
+    }
+
+    m_LRU.push_front(key);
+    Entry entry;
+    entry.bindGroup = bindGroup;
+    entry.lruPosition = m_LRU.begin();
+    m_BindGroups.emplace(std::move(key), std::move(entry));
+    return bindGroup;
+}
+
+void WebGPUBindGroupCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_BindGroups.clear();
+    m_LRU.clear();
+}
+
+WebGPUBindGroupCache::Stats WebGPUBindGroupCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Stats stats;
+    stats.bindGroupCount = static_cast<uint32>(m_BindGroups.size());
+    stats.layoutCount = static_cast<uint32>(m_Layouts.size());
+    stats.hits = m_Hits;
+    stats.misses = m_Misses;
+    stats.evictions = m_Evictions;
+    return stats;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -5,6 +5,7 @@
 #include "metagfx/core/Logger.h"
 
 #include <cstring>
+#include <memory>
 
 namespace metagfx {
 namespace rhi {
@@ -13,13 +14,20 @@ WebGPUBuffer::WebGPUBuffer(WebGPUContext& context, const BufferDesc& desc)
     : m_Context(context)
     , m_Size(desc.size)
     , m_Usage(desc.usage)
-    , m_MemoryUsage(desc.memoryUsage) {
+    , m_MemoryUsage(desc.memoryUsage)
+    , m_MemoryCategory(GetBufferMemoryCategory(desc)) {
 
     // Convert buffer usage flags
     wgpu::BufferUsage usage = ToWebGPUBufferUsage(desc.usage);
 
-    // Add MapWrite usage for CPU-writable buffers
-    if (m_MemoryUsage == MemoryUsage::CPUToGPU || m_MemoryUsage == MemoryUsage::CPUOnly) {
+    // CPU-to-GPU buffers are updated with queue.WriteBuffer, which needs CopyDst.
+    // (MapWrite may only be combined with CopySrc, so it is reserved for CPUOnly staging.)
+    if (m_MemoryUsage == MemoryUsage::CPUToGPU) {
+        usage |= wgpu::BufferUsage::CopyDst;
+    }
+
+    // Add MapWrite usage for CPU-only buffers
+    if (m_MemoryUsage == MemoryUsage::CPUOnly) {
         usage |= wgpu::BufferUsage::MapWrite;
     }
 
@@ -42,18 +50,27 @@ WebGPUBuffer::WebGPUBuffer(WebGPUContext& context, const BufferDesc& desc)
 
     // Create the buffer
     m_Buffer = m_Context.device.CreateBuffer(&bufferDesc);
+    m_Context.stats->AddAllocation();
 
     if (!m_Buffer) {
         WEBGPU_LOG_ERROR("Failed to create buffer");
         throw std::runtime_error("Failed to create WebGPU buffer");
     }
+    // WebGPU reports no allocation sizes
+    m_Context.memory->Add(m_MemoryCategory, m_Size);
 }
 
 WebGPUBuffer::~WebGPUBuffer() {
     if (m_IsMapped) {
         Unmap();
     }
+    if (m_PendingMap) {
+        // Rejects the map: OnMapped() calls back with nullptr
+        m_PendingMap->owner = nullptr;
+        m_Buffer.Unmap();
+    }
 
+    m_Context.memory->Remove(m_MemoryCategory, m_Size);
     m_Buffer = nullptr;
 }
 
@@ -61,6 +78,10 @@ void* WebGPUBuffer::Map() {
     if (m_IsMapped) {
         return m_MappedData;
     }
+    if (m_PendingMap) {
+        WEBGPU_LOG_ERROR("Cannot map a buffer while MapAsync() is in flight");
+        return nullptr;
+    }
 
     // WebGPU mapping is asynchronous, but we'll use a synchronous wrapper
     struct MapData {
@@ -72,12 +93,12 @@ void* WebGPUBuffer::Map() {
 
     // Determine map mode based on memory usage
     wgpu::MapMode mapMode = wgpu::MapMode::None;
-    if (m_MemoryUsage == MemoryUsage::CPUToGPU || m_MemoryUsage == MemoryUsage::CPUOnly) {
+    if (m_MemoryUsage == MemoryUsage::CPUOnly) {
         mapMode = wgpu::MapMode::Write;
     } else if (m_MemoryUsage == MemoryUsage::GPUToCPU) {
         mapMode = wgpu::MapMode::Read;
     } else {
-        WEBGPU_LOG_ERROR("Cannot map GPU-only buffer");
+        WEBGPU_LOG_ERROR("Cannot map GPU-only or CPU-to-GPU buffer (use CopyData)");
         return nullptr;
     }
 
@@ -131,6 +152,37 @@ void WebGPUBuffer::Unmap() {
     m_IsMapped = false;
 }
 
+void WebGPUBuffer::MapAsync(MapCallback callback) {
+    if (m_MemoryUsage != MemoryUsage::GPUToCPU) {
+        WEBGPU_LOG_ERROR("MapAsync() reads back GPUToCPU buffers only");
+        callback(nullptr, 0);
+        return;
+    }
+    if (m_IsMapped || m_PendingMap) {
+        WEBGPU_LOG_ERROR("Buffer is already mapped");
+        callback(nullptr, 0);
+        return;
+    }
+
+    m_PendingMap = new PendingMap{ this, m_Buffer, m_Size, std::move(callback) };
+    m_Buffer.MapAsync(wgpu::MapMode::Read, 0, m_Size, OnMapped, m_PendingMap);
+}
+
+void WebGPUBuffer::OnMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    std::unique_ptr<PendingMap> pending(static_cast<PendingMap*>(userdata));
+    if (pending->owner) {
+        pending->owner->m_PendingMap = nullptr;
+    }
+    if (status != WGPUBufferMapAsyncStatus_Success || !pending->owner) {
+        pending->callback(nullptr, 0);
+        return;
+    }
+
+    const void* data = pending->buffer.GetConstMappedRange(0, pending->size);
+    pending->callback(data, data ? pending->size : 0);
+    pending->buffer.Unmap();
+}
+
 void WebGPUBuffer::CopyData(const void* data, uint64 size, uint64 offset) {
     if (!data || size == 0) {
         return;
@@ -142,14 +194,10 @@ void WebGPUBuffer::CopyData(const void* data, uint64 size, uint64 offset) {
         return;
     }
 
-    // For small updates or CPU-writable buffers, use queue.WriteBuffer
-    if (m_MemoryUsage == MemoryUsage::CPUToGPU || size <= 65536) {  // 64KB threshold
-        m_Context.queue.WriteBuffer(m_Buffer, offset, data, size);
-    } else {
-        // For larger GPU-only buffers, we could use a staging buffer approach
-        // For now, just use WriteBuffer (Dawn handles this efficiently)
-        m_Context.queue.WriteBuffer(m_Buffer, offset, data, size);
-    }
+    // queue.WriteBuffer is WebGPU's equivalent of a persistently mapped upload:
+    // the implementation stages the data and orders it before the next submit
+    m_Context.queue.WriteBuffer(m_Buffer, offset, data, size);
+    m_Context.stats->AddBufferUpload(size);
 }
 
 } // namespace rhi
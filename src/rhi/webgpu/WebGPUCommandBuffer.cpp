@@ -3,9 +3,13 @@
 // ============================================================================
 #include "metagfx/rhi/webgpu/WebGPUCommandBuffer.h"
 #include "metagfx/rhi/webgpu/WebGPUPipeline.h"
+#include "metagfx/rhi/webgpu/WebGPUComputePipeline.h"
 #include "metagfx/rhi/webgpu/WebGPUBuffer.h"
 #include "metagfx/rhi/webgpu/WebGPUTexture.h"
 #include "metagfx/rhi/webgpu/WebGPUDescriptorSet.h"
+#include "metagfx/rhi/webgpu/WebGPUBindGroupCache.h"
+#include "metagfx/rhi/webgpu/WebGPUDrawList.h"
+#include "metagfx/rhi/FormatInfo.h"
 #include "metagfx/core/Logger.h"
 
 #include <cstring>
@@ -13,30 +17,63 @@
 namespace metagfx {
 namespace rhi {
 
-WebGPUCommandBuffer::WebGPUCommandBuffer(WebGPUContext& context)
-    : m_Context(context) {
-
-    // Create push constant GPU buffer (small uniform buffer for push constants)
-    wgpu::BufferDescriptor bufferDesc{};
-    bufferDesc.label = "Push Constants Buffer";
-    bufferDesc.size = MAX_PUSH_CONSTANT_SIZE;
-    bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
-    bufferDesc.mappedAtCreation = false;
-
-    m_PushConstantGPUBuffer = m_Context.device.CreateBuffer(&bufferDesc);
-    if (!m_PushConstantGPUBuffer) {
-        WEBGPU_LOG_ERROR("Failed to create push constant buffer");
-    }
+WebGPUCommandBuffer::WebGPUCommandBuffer(WebGPUContext& context, WebGPUCommandBuffer* primary)
+    : m_Context(context), m_Primary(primary) {
 }
 
 WebGPUCommandBuffer::~WebGPUCommandBuffer() {
-    m_PushConstantGPUBuffer = nullptr;
+    m_Context.memory->Remove(MemoryCategory::Uniform,
+                             static_cast<uint64>(m_PushConstantChunks.size()) * PUSH_CONSTANT_CHUNK_SIZE);
+    m_PushConstantChunks.clear();
+    m_Secondaries.clear();
+    m_BundleEncoder = nullptr;
+    m_Bundle = nullptr;
+    m_ComputePassEncoder = nullptr;
     m_RenderPassEncoder = nullptr;
     m_CommandEncoder = nullptr;
     m_CommandBuffer = nullptr;
 }
 
 void WebGPUCommandBuffer::Begin() {
+    // Frame command buffers are recycled, so drop state from the previous recording
+    m_BoundPipeline.reset();
+    m_BoundVertexBuffer.reset();
+    m_VertexBufferOffset = 0;
+    m_BoundIndexBuffer.reset();
+    m_IndexBufferOffset = 0;
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        m_BoundBindGroups[set] = nullptr;
+        m_BoundDynamicOffsets[set].clear();
+    }
+    m_PushConstantSize = 0;
+    m_PushConstantStages = static_cast<ShaderStage>(0);
+    for (PushConstantChunk& chunk : m_PushConstantChunks) {
+        chunk.used = 0;
+    }
+    m_PushConstantChunk = 0;
+    m_PushConstantGroup = nullptr;
+    m_CommandBuffer = nullptr;
+    m_FilteredCallCount = 0;
+    m_Stats = FrameStats{};
+    ResetPassState();
+
+    if (m_Primary) {
+        wgpu::RenderBundleEncoderDescriptor bundleDesc{};
+        bundleDesc.label = "Render Bundle Encoder";
+        bundleDesc.colorFormatCount = m_Primary->m_BundleColorFormats.size();
+        bundleDesc.colorFormats = m_Primary->m_BundleColorFormats.data();
+        bundleDesc.depthStencilFormat = m_Primary->m_BundleDepthFormat;
+        bundleDesc.sampleCount = m_Primary->m_BundleSampleCount;
+
+        m_Bundle = nullptr;
+        m_BundleEncoder = m_Context.device.CreateRenderBundleEncoder(&bundleDesc);
+        if (!m_BundleEncoder) {
+            WEBGPU_LOG_ERROR("Failed to create render bundle encoder");
+        }
+        return;
+    }
+
+    m_ActiveSecondaryCount = 0;
     wgpu::CommandEncoderDescriptor encoderDesc{};
     encoderDesc.label = "Command Encoder";
 
@@ -46,12 +83,41 @@ void WebGPUCommandBuffer::Begin() {
     }
 }
 
+void WebGPUCommandBuffer::InvalidateState() {
+    ResetPassState();
+}
+
+void WebGPUCommandBuffer::ResetPassState() {
+    m_PassPipeline = nullptr;
+    for (WGPUBindGroup& bindGroup : m_PassBindGroups) {
+        bindGroup = nullptr;
+    }
+    m_PassPushConstantGroup = nullptr;
+    m_PassVertexBuffer = nullptr;
+    m_PassIndexBuffer = nullptr;
+    m_PassViewportSet = false;
+    m_PassScissorSet = false;
+}
+
 void WebGPUCommandBuffer::End() {
-    // End any active render pass
+    UploadPushConstants();
+
+    if (m_Primary) {
+        if (m_BundleEncoder) {
+            wgpu::RenderBundleDescriptor bundleDesc{};
+            bundleDesc.label = "Render Bundle";
+            m_Bundle = m_BundleEncoder.Finish(&bundleDesc);
+            m_BundleEncoder = nullptr;
+        }
+        return;
+    }
+
+    // End any active render or compute pass
     if (m_RenderPassEncoder) {
         m_RenderPassEncoder.End();
         m_RenderPassEncoder = nullptr;
     }
+    EndComputePass();
 
     // Finish encoding and get command buffer
     wgpu::CommandBufferDescriptor cmdBufferDesc{};
@@ -65,24 +131,41 @@ void WebGPUCommandBuffer::End() {
     }
 }
 
-void WebGPUCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorAttachments,
-                                          Ref<Texture> depthAttachment,
-                                          const std::vector<ClearValue>& clearValues) {
+void WebGPUCommandBuffer::BeginRendering(std::span<const Ref<Texture>> colorAttachments,
+                                          const Ref<Texture>& depthAttachment,
+                                          std::span<const ClearValue> clearValues,
+                                          const RenderPassActions& actions,
+                                          std::span<const Ref<Texture>> resolveTargets,
+                                          const Ref<Texture>& shadingRate) {
+    (void)shadingRate;  // Not supported (DeviceInfo::supportsShadingRateImage)
+    if (actions.viewCount > 1) {
+        // Not supported either (DeviceInfo::supportsMultiview): only the first layer is drawn
+        WEBGPU_LOG_ERROR("Multiview render pass on a device without multiview");
+    }
     wgpu::RenderPassDescriptor passDesc{};
+    // No don't-care load: those clear
+    bool load = actions.colorLoad == LoadOp::Load;
     passDesc.label = "Render Pass";
 
-    // Color attachments
-    std::vector<wgpu::RenderPassColorAttachment> colorAttachDescs;
+    // Color attachments, into a member that keeps its storage from pass to pass
+    m_ColorAttachDescs.clear();
     for (size_t i = 0; i < colorAttachments.size(); ++i) {
         wgpu::RenderPassColorAttachment colorAttach{};
 
+        bool transient = false;
         if (colorAttachments[i]) {
             auto webgpuTexture = static_cast<WebGPUTexture*>(colorAttachments[i].get());
             colorAttach.view = webgpuTexture->GetView();
+            transient = webgpuTexture->IsTransient();
         }
 
-        colorAttach.loadOp = wgpu::LoadOp::Clear;
-        colorAttach.storeOp = wgpu::StoreOp::Store;
+        // A multisampled attachment resolves into its target as the pass ends
+        bool resolved = i < resolveTargets.size() && resolveTargets[i];
+        colorAttach.loadOp = ToWebGPULoadOp(load);
+        colorAttach.storeOp = ToWebGPUStoreOp(IsStored(actions.colorStore, transient, resolved));
+        if (resolved) {
+            colorAttach.resolveTarget = static_cast<WebGPUTexture*>(resolveTargets[i].get())->GetView();
+        }
 
         // Set clear color from clearValues if available
         if (i < clearValues.size()) {
@@ -94,19 +177,19 @@ void WebGPUCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorA
             colorAttach.clearValue = {0.0, 0.0, 0.0, 1.0};
         }
 
-        colorAttachDescs.push_back(colorAttach);
+        m_ColorAttachDescs.push_back(colorAttach);
     }
 
-    passDesc.colorAttachmentCount = colorAttachDescs.size();
-    passDesc.colorAttachments = colorAttachDescs.data();
+    passDesc.colorAttachmentCount = m_ColorAttachDescs.size();
+    passDesc.colorAttachments = m_ColorAttachDescs.data();
 
     // Depth attachment
     wgpu::RenderPassDepthStencilAttachment depthAttachDesc{};
     if (depthAttachment) {
         auto webgpuTexture = static_cast<WebGPUTexture*>(depthAttachment.get());
         depthAttachDesc.view = webgpuTexture->GetView();
-        depthAttachDesc.depthLoadOp = wgpu::LoadOp::Clear;
-        depthAttachDesc.depthStoreOp = wgpu::StoreOp::Store;
+        depthAttachDesc.depthLoadOp = ToWebGPULoadOp(actions.depthLoad == LoadOp::Load);
+        depthAttachDesc.depthStoreOp = ToWebGPUStoreOp(IsStored(actions.depthStore, webgpuTexture->IsTransient(), false));
 
         // Use clear value from last entry if available
         double clearDepth = 1.0;
@@ -118,11 +201,26 @@ void WebGPUCommandBuffer::BeginRendering(const std::vector<Ref<Texture>>& colorA
         passDesc.depthStencilAttachment = &depthAttachDesc;
     }
 
+    // Bundles must match the attachments of the pass that executes them
+    m_BundleColorFormats.clear();
+    for (const Ref<Texture>& attachment : colorAttachments) {
+        m_BundleColorFormats.push_back(attachment ? ToWebGPUTextureFormat(attachment->GetFormat())
+                                                  : wgpu::TextureFormat::Undefined);
+    }
+    m_BundleDepthFormat = depthAttachment ? ToWebGPUTextureFormat(depthAttachment->GetFormat())
+                                          : wgpu::TextureFormat::Undefined;
+    const Ref<Texture>& firstAttachment = !colorAttachments.empty() ? colorAttachments[0] : depthAttachment;
+    m_BundleSampleCount = firstAttachment ? firstAttachment->GetSampleCount() : 1;
+
+    EndComputePass();
     m_RenderPassEncoder = m_CommandEncoder.BeginRenderPass(&passDesc);
+    ResetPassState();
 
-    if (!m_RenderPassEncoder) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("Failed to begin render pass");
+        return;
     }
+    ++m_Stats.renderPasses;
 }
 
 void WebGPUCommandBuffer::EndRendering() {
@@ -132,22 +230,118 @@ void WebGPUCommandBuffer::EndRendering() {
     }
 }
 
-void WebGPUCommandBuffer::BindPipeline(Ref<Pipeline> pipeline) {
-    if (!m_RenderPassEncoder) {
+void WebGPUCommandBuffer::BeginParallelRendering(std::span<const Ref<Texture>> colorAttachments,
+                                                 const Ref<Texture>& depthAttachment,
+                                                 std::span<const ClearValue> clearValues,
+                                                 uint32 secondaryCount,
+                                                 const RenderPassActions& actions,
+                                                 std::span<const Ref<Texture>> resolveTargets,
+                                                 const Ref<Texture>& shadingRate) {
+    BeginRendering(colorAttachments, depthAttachment, clearValues, actions, resolveTargets, shadingRate);
+
+    while (m_Secondaries.size() < secondaryCount) {
+        m_Secondaries.push_back(CreateRef<WebGPUCommandBuffer>(m_Context, this));
+    }
+    m_ActiveSecondaryCount = secondaryCount;
+}
+
+Ref<CommandBuffer> WebGPUCommandBuffer::GetSecondaryCommandBuffer(uint32 index) {
+    return index < m_ActiveSecondaryCount ? m_Secondaries[index] : nullptr;
+}
+
+void WebGPUCommandBuffer::EndParallelRendering() {
+    std::vector<wgpu::RenderBundle> bundles;
+    bundles.reserve(m_ActiveSecondaryCount);
+    for (uint32 i = 0; i < m_ActiveSecondaryCount; ++i) {
+        WebGPUCommandBuffer& secondary = *m_Secondaries[i];
+        if (secondary.m_Bundle) {
+            bundles.push_back(secondary.m_Bundle);
+            secondary.m_Bundle = nullptr;
+        }
+        AddSecondaryStats(secondary);
+    }
+    m_ActiveSecondaryCount = 0;
+
+    if (m_RenderPassEncoder && !bundles.empty()) {
+        m_RenderPassEncoder.ExecuteBundles(bundles.size(), bundles.data());
+    }
+    EndRendering();
+}
+
+void WebGPUCommandBuffer::BindPipeline(const Ref<Pipeline>& pipeline) {
+    if (pipeline->GetBindPoint() == PipelineBindPoint::Compute) {
+        if (!GetComputePass()) {
+            return;
+        }
+        m_BoundPipeline = pipeline;
+        if (m_PassPipeline == pipeline.get()) {
+            ++m_FilteredCallCount;
+            return;
+        }
+        auto computePipeline = static_cast<WebGPUComputePipeline*>(pipeline.get());
+        m_ComputePassEncoder.SetPipeline(computePipeline->GetComputePipeline());
+        ++m_Stats.pipelineBinds;
+        m_PassPipeline = pipeline.get();
+        return;
+    }
+
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("BindPipeline called without active render pass");
         return;
     }
 
     m_BoundPipeline = pipeline;
+    if (m_PassPipeline == pipeline.get()) {
+        ++m_FilteredCallCount;
+        return;
+    }
     auto webgpuPipeline = static_cast<WebGPUPipeline*>(pipeline.get());
-    m_RenderPassEncoder.SetPipeline(webgpuPipeline->GetRenderPipeline());
+    EncodeRender([&](auto& encoder) { encoder.SetPipeline(webgpuPipeline->GetRenderPipeline()); });
+    ++m_Stats.pipelineBinds;
+    m_PassPipeline = pipeline.get();
+    BindEmptyGroups(*webgpuPipeline);
+}
+
+// Every group of the layout needs a bind group at draws, so the sets a pipeline does not
+// take get an empty one in place of what an earlier pipeline's set left there
+void WebGPUCommandBuffer::BindEmptyGroups(const WebGPUPipeline& pipeline) {
+    uint32 mask = pipeline.GetEmptyGroupMask();
+    if (mask == 0) {
+        return;
+    }
+    if (!m_EmptyBindGroup) {
+        m_EmptyBindGroup = m_Context.bindGroupCache->AcquireBindGroup(m_Context.bindGroupCache->AcquireLayout({}), {});
+    }
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (!(mask & (1u << set))) {
+            continue;
+        }
+        m_BoundBindGroups[set] = m_EmptyBindGroup;
+        m_BoundDynamicOffsets[set].clear();
+        if (m_PassBindGroups[set] == m_EmptyBindGroup.Get()) {
+            continue;
+        }
+        m_PassBindGroups[set] = m_EmptyBindGroup.Get();
+        m_PassOffsets[set].Assign(nullptr, 0);
+        EncodeRender([&](auto& encoder) { encoder.SetBindGroup(set, m_EmptyBindGroup, 0, nullptr); });
+    }
 }
 
 void WebGPUCommandBuffer::SetViewport(const Viewport& viewport) {
-    if (!m_RenderPassEncoder) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("SetViewport called without active render pass");
         return;
     }
+    if (m_BundleEncoder) {
+        return;  // Bundles inherit the pass viewport
+    }
+
+    if (m_PassViewportSet && std::memcmp(&m_PassViewport, &viewport, sizeof(Viewport)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    m_PassViewport = viewport;
+    m_PassViewportSet = true;
 
     m_RenderPassEncoder.SetViewport(
         viewport.x,
@@ -160,31 +354,52 @@ void WebGPUCommandBuffer::SetViewport(const Viewport& viewport) {
 }
 
 void WebGPUCommandBuffer::SetScissor(const Rect2D& scissor) {
-    if (!m_RenderPassEncoder) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("SetScissor called without active render pass");
         return;
     }
+    if (m_BundleEncoder) {
+        return;  // Bundles inherit the pass scissor
+    }
+
+    if (m_PassScissorSet && std::memcmp(&m_PassScissor, &scissor, sizeof(Rect2D)) == 0) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    m_PassScissor = scissor;
+    m_PassScissorSet = true;
 
     m_RenderPassEncoder.SetScissorRect(
-        scissor.offset.x,
-        scissor.offset.y,
-        scissor.extent.width,
-        scissor.extent.height
+        static_cast<uint32>(scissor.x),
+        static_cast<uint32>(scissor.y),
+        scissor.width,
+        scissor.height
     );
 }
 
-void WebGPUCommandBuffer::BindVertexBuffer(Ref<Buffer> buffer, uint64 offset) {
-    if (!m_RenderPassEncoder) {
+void WebGPUCommandBuffer::BindVertexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("BindVertexBuffer called without active render pass");
         return;
     }
 
+    m_BoundVertexBuffer = buffer;
+    m_VertexBufferOffset = offset;
+
     auto webgpuBuffer = static_cast<WebGPUBuffer*>(buffer.get());
-    m_RenderPassEncoder.SetVertexBuffer(0, webgpuBuffer->GetHandle(), offset, buffer->GetSize() - offset);
+    if (m_PassVertexBuffer == webgpuBuffer->GetHandle().Get() && m_PassVertexOffset == offset) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    EncodeRender([&](auto& encoder) {
+        encoder.SetVertexBuffer(0, webgpuBuffer->GetHandle(), offset, buffer->GetSize() - offset);
+    });
+    m_PassVertexBuffer = webgpuBuffer->GetHandle().Get();
+    m_PassVertexOffset = offset;
 }
 
-void WebGPUCommandBuffer::BindIndexBuffer(Ref<Buffer> buffer, uint64 offset) {
-    if (!m_RenderPassEncoder) {
+void WebGPUCommandBuffer::BindIndexBuffer(const Ref<Buffer>& buffer, uint64 offset) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("BindIndexBuffer called without active render pass");
         return;
     }
@@ -197,17 +412,20 @@ void WebGPUCommandBuffer::BindIndexBuffer(Ref<Buffer> buffer, uint64 offset) {
     m_IndexFormat = wgpu::IndexFormat::Uint32;
 
     auto webgpuBuffer = static_cast<WebGPUBuffer*>(buffer.get());
-    m_RenderPassEncoder.SetIndexBuffer(
-        webgpuBuffer->GetHandle(),
-        m_IndexFormat,
-        offset,
-        buffer->GetSize() - offset
-    );
+    if (m_PassIndexBuffer == webgpuBuffer->GetHandle().Get() && m_PassIndexOffset == offset) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    m_PassIndexBuffer = webgpuBuffer->GetHandle().Get();
+    m_PassIndexOffset = offset;
+    EncodeRender([&](auto& encoder) {
+        encoder.SetIndexBuffer(webgpuBuffer->GetHandle(), m_IndexFormat, offset, buffer->GetSize() - offset);
+    });
 }
 
 void WebGPUCommandBuffer::Draw(uint32 vertexCount, uint32 instanceCount,
                                 uint32 firstVertex, uint32 firstInstance) {
-    if (!m_RenderPassEncoder) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("Draw called without active render pass");
         return;
     }
@@ -215,13 +433,14 @@ void WebGPUCommandBuffer::Draw(uint32 vertexCount, uint32 instanceCount,
     // Flush push constants before draw
     FlushPushConstants();
 
-    m_RenderPassEncoder.Draw(vertexCount, instanceCount, firstVertex, firstInstance);
+    EncodeRender([&](auto& encoder) { encoder.Draw(vertexCount, instanceCount, firstVertex, firstInstance); });
+    CountDraw(vertexCount, instanceCount);
 }
 
 void WebGPUCommandBuffer::DrawIndexed(uint32 indexCount, uint32 instanceCount,
                                        uint32 firstIndex, int32 vertexOffset,
                                        uint32 firstInstance) {
-    if (!m_RenderPassEncoder) {
+    if (!InRenderPass()) {
         WEBGPU_LOG_ERROR("DrawIndexed called without active render pass");
         return;
     }
@@ -229,15 +448,173 @@ void WebGPUCommandBuffer::DrawIndexed(uint32 indexCount, uint32 instanceCount,
     // Flush push constants before draw
     FlushPushConstants();
 
-    m_RenderPassEncoder.DrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    EncodeRender([&](auto& encoder) {
+        encoder.DrawIndexed(indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
+    });
+    CountDraw(indexCount, instanceCount);
+}
+
+void WebGPUCommandBuffer::DrawIndexedIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset, uint32 drawCount,
+                                              uint32 stride) {
+    if (!InRenderPass()) {
+        WEBGPU_LOG_ERROR("DrawIndexedIndirect called without active render pass");
+        return;
+    }
+
+    FlushPushConstants();
+
+    // WebGPU has no multi-draw: one indirect draw per command
+    auto webgpuBuffer = static_cast<WebGPUBuffer*>(argumentBuffer.get());
+    EncodeRender([&](auto& encoder) {
+        for (uint32 i = 0; i < drawCount; ++i) {
+            encoder.DrawIndexedIndirect(webgpuBuffer->GetHandle(), offset + static_cast<uint64>(i) * stride);
+        }
+    });
+    ++m_Stats.drawCalls;
 }
 
-void WebGPUCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
+void WebGPUCommandBuffer::DrawIndexedIndirectCount(const Ref<Buffer>& argumentBuffer, uint64 offset,
+                                                   const Ref<Buffer>& countBuffer, uint64 countOffset,
+                                                   uint32 maxDrawCount, uint32 stride) {
+    // No GPU-sourced draw counts; unused commands draw zero instances
+    (void)countBuffer;
+    (void)countOffset;
+    DrawIndexedIndirect(argumentBuffer, offset, maxDrawCount, stride);
+}
+
+void WebGPUCommandBuffer::ExecuteDrawList(const Ref<DrawList>& drawList) {
+    if (!m_RenderPassEncoder || !m_BoundPipeline || !m_BoundVertexBuffer || !m_BoundIndexBuffer || !drawList) {
+        CommandBuffer::ExecuteDrawList(drawList);
+        return;
+    }
+
+    FlushPushConstants();
+
+    WebGPUDrawList::BundleState state;
+    state.pipeline = static_cast<WebGPUPipeline*>(m_BoundPipeline.get())->GetRenderPipeline();
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        state.bindGroups[set] = m_BoundBindGroups[set];
+        state.dynamicOffsets[set] = m_BoundDynamicOffsets[set];
+    }
+    if (m_PushConstantGroup) {
+        state.pushConstantGroup = m_PushConstantChunks[m_PushConstantChunk].bindGroup;
+        state.pushConstantOffset = m_PushConstantOffset;
+    }
+    state.vertexBuffer = static_cast<WebGPUBuffer*>(m_BoundVertexBuffer.get())->GetHandle();
+    state.vertexBufferOffset = m_VertexBufferOffset;
+    state.indexBuffer = static_cast<WebGPUBuffer*>(m_BoundIndexBuffer.get())->GetHandle();
+    state.indexBufferOffset = m_IndexBufferOffset;
+    state.indexFormat = m_IndexFormat;
+    state.colorFormats = m_BundleColorFormats;
+    state.depthFormat = m_BundleDepthFormat;
+    state.sampleCount = m_BundleSampleCount;
+
+    wgpu::RenderBundle bundle = static_cast<WebGPUDrawList*>(drawList.get())->GetBundle(state);
+    if (!bundle) {
+        CommandBuffer::ExecuteDrawList(drawList);
+        return;
+    }
+    m_RenderPassEncoder.ExecuteBundles(1, &bundle);
+    ++m_Stats.drawCalls;
+
+    // Executing bundles clears the pass's pipeline, bind groups and buffers: restore the
+    // bound ones, so later commands can rely on them as after any other draw
+    m_RenderPassEncoder.SetPipeline(state.pipeline);
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (state.bindGroups[set]) {
+            m_RenderPassEncoder.SetBindGroup(set, state.bindGroups[set], state.dynamicOffsets[set].size(),
+                                             state.dynamicOffsets[set].data());
+        }
+    }
+    if (state.pushConstantGroup) {
+        m_RenderPassEncoder.SetBindGroup(WEBGPU_PUSH_CONSTANT_GROUP, state.pushConstantGroup, 1,
+                                         &state.pushConstantOffset);
+    }
+    m_RenderPassEncoder.SetVertexBuffer(0, state.vertexBuffer, state.vertexBufferOffset,
+                                        m_BoundVertexBuffer->GetSize() - state.vertexBufferOffset);
+    m_RenderPassEncoder.SetIndexBuffer(state.indexBuffer, state.indexFormat, state.indexBufferOffset,
+                                       m_BoundIndexBuffer->GetSize() - state.indexBufferOffset);
+}
+
+wgpu::ComputePassEncoder WebGPUCommandBuffer::GetComputePass() {
+    if (m_RenderPassEncoder) {
+        WEBGPU_LOG_ERROR("Compute work recorded inside a render pass");
+        return nullptr;
+    }
+
+    if (!m_ComputePassEncoder) {
+        wgpu::ComputePassDescriptor passDesc{};
+        passDesc.label = "Compute Pass";
+        m_ComputePassEncoder = m_CommandEncoder.BeginComputePass(&passDesc);
+        ResetPassState();
+        if (!m_ComputePassEncoder) {
+            WEBGPU_LOG_ERROR("Failed to begin compute pass");
+        }
+    }
+    return m_ComputePassEncoder;
+}
+
+void WebGPUCommandBuffer::EndComputePass() {
+    if (m_ComputePassEncoder) {
+        m_ComputePassEncoder.End();
+        m_ComputePassEncoder = nullptr;
+    }
+}
+
+bool WebGPUCommandBuffer::WriteTimestamp(const wgpu::QuerySet& querySet, uint32 queryIndex) {
+    wgpu::CommandEncoder encoder = GetEncoderBetweenPasses();
+    if (!encoder) {
+        return false;
+    }
+
+    wgpu::ComputePassTimestampWrites timestampWrites{};
+    timestampWrites.querySet = querySet;
+    timestampWrites.beginningOfPassWriteIndex = queryIndex;
+    timestampWrites.endOfPassWriteIndex = WGPU_QUERY_SET_INDEX_UNDEFINED;
+
+    wgpu::ComputePassDescriptor passDesc{};
+    passDesc.label = "Timestamp Pass";
+    passDesc.timestampWrites = &timestampWrites;
+    encoder.BeginComputePass(&passDesc).End();
+    return true;
+}
+
+wgpu::CommandEncoder WebGPUCommandBuffer::GetEncoderBetweenPasses() {
+    if (m_Primary || InRenderPass() || !m_CommandEncoder) {
+        return nullptr;
+    }
+    EndComputePass();
+    return m_CommandEncoder;
+}
+
+void WebGPUCommandBuffer::Dispatch(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ) {
+    if (!m_ComputePassEncoder) {
+        WEBGPU_LOG_ERROR("Dispatch called without a bound compute pipeline");
+        return;
+    }
+
+    m_ComputePassEncoder.DispatchWorkgroups(groupCountX, groupCountY, groupCountZ);
+    ++m_Stats.dispatches;
+}
+
+void WebGPUCommandBuffer::DispatchIndirect(const Ref<Buffer>& argumentBuffer, uint64 offset) {
+    if (!m_ComputePassEncoder) {
+        WEBGPU_LOG_ERROR("DispatchIndirect called without a bound compute pipeline");
+        return;
+    }
+
+    auto webgpuBuffer = static_cast<WebGPUBuffer*>(argumentBuffer.get());
+    m_ComputePassEncoder.DispatchWorkgroupsIndirect(webgpuBuffer->GetHandle(), offset);
+    ++m_Stats.dispatches;
+}
+
+void WebGPUCommandBuffer::CopyBuffer(const Ref<Buffer>& src, const Ref<Buffer>& dst,
                                       uint64 size, uint64 srcOffset, uint64 dstOffset) {
     if (m_RenderPassEncoder) {
         WEBGPU_LOG_ERROR("CopyBuffer called during active render pass");
         return;
     }
+    EndComputePass();
 
     auto webgpuSrc = static_cast<WebGPUBuffer*>(src.get());
     auto webgpuDst = static_cast<WebGPUBuffer*>(dst.get());
@@ -251,18 +628,78 @@ void WebGPUCommandBuffer::CopyBuffer(Ref<Buffer> src, Ref<Buffer> dst,
     );
 }
 
-void WebGPUCommandBuffer::BindDescriptorSet(Ref<Pipeline> pipeline, Ref<DescriptorSet> descriptorSet,
-                                              uint32 frameIndex) {
-    if (!m_RenderPassEncoder) {
-        WEBGPU_LOG_ERROR("BindDescriptorSet called without active render pass");
+void WebGPUCommandBuffer::CopyTextureToBuffer(const Ref<Texture>& src, const Ref<Buffer>& dst, uint64 dstOffset) {
+    if (m_RenderPassEncoder) {
+        WEBGPU_LOG_ERROR("CopyTextureToBuffer called during active render pass");
         return;
     }
+    EndComputePass();
+
+    wgpu::ImageCopyTexture source{};
+    source.texture = static_cast<WebGPUTexture*>(src.get())->GetHandle();
+    source.aspect = wgpu::TextureAspect::All;
+
+    wgpu::ImageCopyBuffer destination{};
+    destination.buffer = static_cast<WebGPUBuffer*>(dst.get())->GetHandle();
+    destination.layout.offset = dstOffset;
+    destination.layout.bytesPerRow = GetReadbackRowPitch(src->GetFormat(), src->GetWidth());
+    destination.layout.rowsPerImage = src->GetHeight();
 
-    // TODO: Implement when WebGPUDescriptorSet is complete
-    WEBGPU_LOG_WARNING("BindDescriptorSet not yet implemented");
+    wgpu::Extent3D extent = { src->GetWidth(), src->GetHeight(), 1 };
+    m_CommandEncoder.CopyTextureToBuffer(&source, &destination, &extent);
 }
 
-void WebGPUCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stages,
+void WebGPUCommandBuffer::BindDescriptorSet(const Ref<Pipeline>& pipeline, uint32 setIndex,
+                                              const Ref<DescriptorSet>& descriptorSet, uint32 frameIndex,
+                                              const uint32* dynamicOffsets, uint32 dynamicOffsetCount) {
+    (void)frameIndex;  // One bind group serves every frame
+
+    if (setIndex >= MAX_DESCRIPTOR_SETS) {
+        WEBGPU_LOG_ERROR("Descriptor set " << setIndex << " is beyond MAX_DESCRIPTOR_SETS");
+        return;
+    }
+
+    bool compute = pipeline && pipeline->GetBindPoint() == PipelineBindPoint::Compute;
+    if (compute ? !m_ComputePassEncoder : !InRenderPass()) {
+        WEBGPU_LOG_ERROR("BindDescriptorSet called without active " << (compute ? "compute" : "render") << " pass");
+        return;
+    }
+
+    auto webgpuDescSet = std::static_pointer_cast<WebGPUDescriptorSet>(descriptorSet);
+    // Bind groups are immutable: rebuild once if bindings changed since the last bind
+    if (webgpuDescSet->IsDirty()) {
+        webgpuDescSet->Update();
+    }
+
+    if (!compute) {
+        m_BoundBindGroups[setIndex] = webgpuDescSet->GetBindGroup();
+        m_BoundDynamicOffsets[setIndex].assign(dynamicOffsets, dynamicOffsets + dynamicOffsetCount);
+    }
+
+    // Update() may have replaced the bind group, so compare the handle. Groups stay bound
+    // across pipelines, so a material change only sets its own group.
+    WGPUBindGroup bindGroup = webgpuDescSet->GetBindGroup().Get();
+    if (bindGroup == m_PassBindGroups[setIndex] && m_PassOffsets[setIndex].Matches(dynamicOffsets, dynamicOffsetCount)) {
+        ++m_FilteredCallCount;
+        return;
+    }
+    m_PassBindGroups[setIndex] =
+        m_PassOffsets[setIndex].Assign(dynamicOffsets, dynamicOffsetCount) ? bindGroup : nullptr;
+    ++m_Stats.descriptorSetBinds;
+
+    if (compute) {
+        m_ComputePassEncoder.SetBindGroup(setIndex, webgpuDescSet->GetBindGroup(), dynamicOffsetCount,
+                                          dynamicOffsets);
+        return;
+    }
+
+    // Dynamic offsets select the slice of each UniformBufferDynamic binding
+    EncodeRender([&](auto& encoder) {
+        encoder.SetBindGroup(setIndex, webgpuDescSet->GetBindGroup(), dynamicOffsetCount, dynamicOffsets);
+    });
+}
+
+void WebGPUCommandBuffer::PushConstants(const Ref<Pipeline>& pipeline, ShaderStage stages,
                                          uint32 offset, uint32 size, const void* data) {
     // Accumulate push constant data in staging buffer
     if (offset + size > MAX_PUSH_CONSTANT_SIZE) {
@@ -276,30 +713,125 @@ void WebGPUCommandBuffer::PushConstants(Ref<Pipeline> pipeline, ShaderStage stag
 }
 
 void WebGPUCommandBuffer::FlushPushConstants() {
-    if (!m_RenderPassEncoder || m_PushConstantSize == 0) {
+    if (!InRenderPass()) {
         return;
     }
 
-    // Write accumulated push constant data to GPU buffer
-    m_Context.queue.WriteBuffer(
-        m_PushConstantGPUBuffer,
-        0,
-        m_PushConstantBuffer,
-        m_PushConstantSize
-    );
+    // Render pipeline layouts include the push constant group, so every draw needs a
+    // slice bound, even before anything was pushed. The last slice is kept while no
+    // bytes were pushed, or the ones pushed are already in it.
+    if (m_PushConstantGroup && m_PushConstantSize > 0) {
+        const PushConstantChunk& chunk = m_PushConstantChunks[m_PushConstantChunk];
+        if (std::memcmp(chunk.data.data() + m_PushConstantOffset, m_PushConstantBuffer, MAX_PUSH_CONSTANT_SIZE) == 0) {
+            ++m_FilteredCallCount;
+        } else {
+            m_PushConstantGroup = nullptr;
+        }
+    }
 
-    // TODO: Bind the push constant buffer as a dynamic uniform buffer
-    // This requires bind group support (will be implemented with WebGPUDescriptorSet)
+    if (!m_PushConstantGroup) {
+        uint32 offset = 0;
+        if (!AllocatePushConstantSlice(offset)) {
+            m_PushConstantSize = 0;
+            m_PushConstantStages = static_cast<ShaderStage>(0);
+            return;
+        }
+        // The whole block: bytes pushed for earlier draws stay in effect
+        PushConstantChunk& chunk = m_PushConstantChunks[m_PushConstantChunk];
+        std::memcpy(chunk.data.data() + offset, m_PushConstantBuffer, MAX_PUSH_CONSTANT_SIZE);
+        m_PushConstantGroup = chunk.bindGroup.Get();
+        m_PushConstantOffset = offset;
+        ++m_Stats.pushConstantCalls;
+    }
+
+    if (m_PushConstantGroup != m_PassPushConstantGroup || m_PushConstantOffset != m_PassPushConstantOffset) {
+        m_PassPushConstantGroup = m_PushConstantGroup;
+        m_PassPushConstantOffset = m_PushConstantOffset;
+        const wgpu::BindGroup& bindGroup = m_PushConstantChunks[m_PushConstantChunk].bindGroup;
+        EncodeRender([&](auto& encoder) {
+            encoder.SetBindGroup(WEBGPU_PUSH_CONSTANT_GROUP, bindGroup, 1, &m_PushConstantOffset);
+        });
+    }
 
     // Reset for next draw call
     m_PushConstantSize = 0;
     m_PushConstantStages = static_cast<ShaderStage>(0);
 }
 
-void WebGPUCommandBuffer::BufferMemoryBarrier(Ref<Buffer> buffer) {
+bool WebGPUCommandBuffer::AllocatePushConstantSlice(uint32& offset) {
+    const uint32 alignment = m_Context.minUniformBufferOffsetAlignment;
+    const uint32 stride = (MAX_PUSH_CONSTANT_SIZE + alignment - 1) / alignment * alignment;
+
+    if (m_PushConstantChunk < m_PushConstantChunks.size() &&
+        m_PushConstantChunks[m_PushConstantChunk].used + stride > PUSH_CONSTANT_CHUNK_SIZE) {
+        ++m_PushConstantChunk;
+    }
+
+    if (m_PushConstantChunk == m_PushConstantChunks.size()) {
+        PushConstantChunk chunk;
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Push Constant Ring";
+        bufferDesc.size = PUSH_CONSTANT_CHUNK_SIZE;
+        bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+        chunk.buffer = m_Context.device.CreateBuffer(&bufferDesc);
+        if (!chunk.buffer) {
+            WEBGPU_LOG_ERROR("Failed to create push constant ring buffer");
+            return false;
+        }
+
+        wgpu::BindGroupEntry entry{};
+        entry.binding = 0;
+        entry.buffer = chunk.buffer;
+        entry.offset = 0;
+        entry.size = MAX_PUSH_CONSTANT_SIZE;
+        chunk.bindGroup = m_Context.bindGroupCache->AcquireBindGroup(
+            m_Context.bindGroupCache->AcquirePushConstantLayout(), { entry });
+        if (!chunk.bindGroup) {
+            WEBGPU_LOG_ERROR("Failed to create push constant bind group");
+            return false;
+        }
+
+        chunk.data.resize(PUSH_CONSTANT_CHUNK_SIZE);
+        m_Context.stats->AddAllocation();
+        m_Context.memory->Add(MemoryCategory::Uniform, PUSH_CONSTANT_CHUNK_SIZE);
+        m_PushConstantChunks.push_back(std::move(chunk));
+    }
+
+    PushConstantChunk& chunk = m_PushConstantChunks[m_PushConstantChunk];
+    offset = chunk.used;
+    chunk.used += stride;
+    return true;
+}
+
+void WebGPUCommandBuffer::UploadPushConstants() {
+    // Queue writes land before any later submit, so the command buffer sees them all
+    for (PushConstantChunk& chunk : m_PushConstantChunks) {
+        if (chunk.used == 0) {
+            break;
+        }
+        m_Context.queue.WriteBuffer(chunk.buffer, 0, chunk.data.data(), chunk.used);
+    }
+}
+
+void WebGPUCommandBuffer::BufferMemoryBarrier(const Ref<Buffer>& buffer) {
     // WebGPU handles synchronization automatically
     // No explicit barrier needed (similar to Metal)
 }
 
+void WebGPUCommandBuffer::PipelineBarrier(BarrierType type) {
+    // Usage scopes are synchronized by the implementation: each dispatch is its own
+    // scope and passes are ordered, so there is nothing to record
+    (void)type;
+}
+
+void WebGPUCommandBuffer::ResourceBarrier(const TextureBarrier* textureBarriers, uint32 textureBarrierCount,
+                                          const BufferBarrier* bufferBarriers, uint32 bufferBarrierCount) {
+    // The implementation derives usage transitions from each pass's bindings
+    (void)textureBarriers;
+    (void)textureBarrierCount;
+    (void)bufferBarriers;
+    (void)bufferBarrierCount;
+}
+
 } // namespace rhi
 } // namespace metagfx
@@ -0,0 +1,50 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUComputePipeline.cpp
+// ============================================================================
+#include "metagfx/rhi/webgpu/WebGPUComputePipeline.h"
+#include "metagfx/rhi/webgpu/WebGPUShader.h"
+#include "metagfx/core/Logger.h"
+
+namespace metagfx {
+namespace rhi {
+
+WebGPUComputePipeline::WebGPUComputePipeline(WebGPUContext& context, const ComputePipelineDesc& desc,
+                                             wgpu::BindGroupLayout bindGroupLayout)
+    : m_Context(context) {
+
+    // Group 0 is the desc's descriptor set layout, so its bind groups are compatible
+    wgpu::PipelineLayoutDescriptor layoutDesc{};
+    layoutDesc.label = desc.debugName ? desc.debugName : "Compute Pipeline Layout";
+    layoutDesc.bindGroupLayoutCount = bindGroupLayout ? 1 : 0;
+    layoutDesc.bindGroupLayouts = bindGroupLayout ? &bindGroupLayout : nullptr;
+
+    m_PipelineLayout = m_Context.device.CreatePipelineLayout(&layoutDesc);
+    if (!m_PipelineLayout) {
+        WEBGPU_LOG_ERROR("Failed to create compute pipeline layout");
+        throw std::runtime_error("Failed to create WebGPU compute pipeline layout");
+    }
+
+    wgpu::ComputePipelineDescriptor pipelineDesc{};
+    pipelineDesc.label = desc.debugName ? desc.debugName : "Compute Pipeline";
+    pipelineDesc.layout = m_PipelineLayout;
+
+    auto webgpuShader = static_cast<WebGPUShader*>(desc.computeShader.get());
+    pipelineDesc.compute.module = webgpuShader->GetModule();
+    pipelineDesc.compute.entryPoint = webgpuShader->GetEntryPoint().c_str();
+
+    m_ComputePipeline = m_Context.device.CreateComputePipeline(&pipelineDesc);
+    if (!m_ComputePipeline) {
+        WEBGPU_LOG_ERROR("Failed to create compute pipeline");
+        throw std::runtime_error("Failed to create WebGPU compute pipeline");
+    }
+
+    WEBGPU_LOG_INFO("WebGPU compute pipeline created successfully");
+}
+
+WebGPUComputePipeline::~WebGPUComputePipeline() {
+    m_ComputePipeline = nullptr;
+    m_PipelineLayout = nullptr;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -2,11 +2,14 @@
 // src/rhi/webgpu/WebGPUDescriptorSet.cpp
 // ============================================================================
 #include "metagfx/rhi/webgpu/WebGPUDescriptorSet.h"
+#include "metagfx/rhi/webgpu/WebGPUBindGroupCache.h"
 #include "metagfx/rhi/webgpu/WebGPUBuffer.h"
 #include "metagfx/rhi/webgpu/WebGPUTexture.h"
 #include "metagfx/rhi/webgpu/WebGPUSampler.h"
 #include "metagfx/core/Logger.h"
 
+#include <algorithm>
+
 namespace metagfx {
 namespace rhi {
 
@@ -28,6 +31,12 @@ WebGPUDescriptorSet::WebGPUDescriptorSet(WebGPUContext& context, const Descripto
                 entry.buffer.minBindingSize = 0;
                 break;
 
+            case DescriptorType::UniformBufferDynamic:
+                entry.buffer.type = wgpu::BufferBindingType::Uniform;
+                entry.buffer.hasDynamicOffset = true;
+                entry.buffer.minBindingSize = binding.range;
+                break;
+
             case DescriptorType::StorageBuffer:
                 entry.buffer.type = wgpu::BufferBindingType::Storage;
                 entry.buffer.hasDynamicOffset = false;
@@ -81,20 +90,34 @@ WebGPUDescriptorSet::WebGPUDescriptorSet(WebGPUContext& context, const Descripto
         BindingInfo info{};
         info.binding = binding.binding;
         info.type = binding.type;
+        info.buffer = binding.buffer;
+        info.texture = binding.texture;
+        info.sampler = binding.sampler;
+        info.range = binding.range;
         m_Bindings.push_back(info);
     }
 
-    // Create bind group layout
-    wgpu::BindGroupLayoutDescriptor layoutDesc{};
-    layoutDesc.label = "Bind Group Layout";
-    layoutDesc.entryCount = layoutEntries.size();
-    layoutDesc.entries = layoutEntries.data();
-
-    m_BindGroupLayout = m_Context.device.CreateBindGroupLayout(&layoutDesc);
+    // Shared with every set of the same layout description
+    m_BindGroupLayout = m_Context.bindGroupCache->AcquireLayout(layoutEntries);
     if (!m_BindGroupLayout) {
         WEBGPU_LOG_ERROR("Failed to create bind group layout");
         throw std::runtime_error("Failed to create WebGPU bind group layout");
     }
+
+    // A set created with all its resources (a material's) gets its bind group now, at
+    // load, rather than at its first draw
+    bool complete = std::all_of(m_Bindings.begin(), m_Bindings.end(), [](const BindingInfo& info) {
+        switch (info.type) {
+            case DescriptorType::CombinedImageSampler: return info.texture && info.sampler;
+            case DescriptorType::SampledImage:
+            case DescriptorType::StorageImage: return static_cast<bool>(info.texture);
+            case DescriptorType::Sampler: return static_cast<bool>(info.sampler);
+            default: return static_cast<bool>(info.buffer);
+        }
+    });
+    if (complete && !m_Bindings.empty()) {
+        Update();
+    }
 }
 
 WebGPUDescriptorSet::~WebGPUDescriptorSet() {
@@ -102,11 +125,12 @@ WebGPUDescriptorSet::~WebGPUDescriptorSet() {
     m_BindGroupLayout = nullptr;
 }
 
-void WebGPUDescriptorSet::UpdateBuffer(uint32 binding, Ref<Buffer> buffer) {
+void WebGPUDescriptorSet::UpdateBuffer(uint32 binding, const Ref<Buffer>& buffer) {
     // Find binding info
     for (auto& info : m_Bindings) {
         if (info.binding == binding) {
             info.buffer = buffer;
+            m_Dirty = true;
             return;
         }
     }
@@ -114,12 +138,13 @@ void WebGPUDescriptorSet::UpdateBuffer(uint32 binding, Ref<Buffer> buffer) {
     WEBGPU_LOG_WARNING("UpdateBuffer: binding " << binding << " not found");
 }
 
-void WebGPUDescriptorSet::UpdateTexture(uint32 binding, Ref<Texture> texture, Ref<Sampler> sampler) {
+void WebGPUDescriptorSet::UpdateTexture(uint32 binding, const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
     // Find binding info
     for (auto& info : m_Bindings) {
         if (info.binding == binding) {
             info.texture = texture;
             info.sampler = sampler;
+            m_Dirty = true;
             return;
         }
     }
@@ -127,19 +152,33 @@ void WebGPUDescriptorSet::UpdateTexture(uint32 binding, Ref<Texture> texture, Re
     WEBGPU_LOG_WARNING("UpdateTexture: binding " << binding << " not found");
 }
 
+void WebGPUDescriptorSet::UpdateTextureArrayElement(uint32 binding, uint32 arrayElement,
+                                                    const Ref<Texture>& texture, const Ref<Sampler>& sampler) {
+    // Core WebGPU has no binding arrays (DeviceInfo::supportsBindlessTextures is false),
+    // so only the first element maps onto the regular binding
+    if (arrayElement == 0) {
+        UpdateTexture(binding, texture, sampler);
+        return;
+    }
+
+    WEBGPU_LOG_WARNING("UpdateTextureArrayElement: binding arrays not supported, element "
+                       << arrayElement << " of binding " << binding << " ignored");
+}
+
 void WebGPUDescriptorSet::Update() {
     // Create bind group entries from current bindings
     std::vector<wgpu::BindGroupEntry> entries;
 
     for (const auto& info : m_Bindings) {
-        if (info.type == DescriptorType::UniformBuffer || info.type == DescriptorType::StorageBuffer) {
+        if (info.type == DescriptorType::UniformBuffer || info.type == DescriptorType::UniformBufferDynamic ||
+            info.type == DescriptorType::StorageBuffer) {
             if (info.buffer) {
                 wgpu::BindGroupEntry entry{};
                 entry.binding = info.binding;
                 auto webgpuBuffer = static_cast<WebGPUBuffer*>(info.buffer.get());
                 entry.buffer = webgpuBuffer->GetHandle();
                 entry.offset = 0;
-                entry.size = info.buffer->GetSize();
+                entry.size = info.range > 0 ? info.range : info.buffer->GetSize();
                 entries.push_back(entry);
             }
         } else if (info.type == DescriptorType::CombinedImageSampler) {
@@ -158,7 +197,7 @@ void WebGPUDescriptorSet::Update() {
                 samplerEntry.sampler = webgpuSampler->GetHandle();
                 entries.push_back(samplerEntry);
             }
-        } else if (info.type == DescriptorType::SampledImage) {
+        } else if (info.type == DescriptorType::SampledImage || info.type == DescriptorType::StorageImage) {
             if (info.texture) {
                 wgpu::BindGroupEntry entry{};
                 entry.binding = info.binding;
@@ -177,20 +216,14 @@ void WebGPUDescriptorSet::Update() {
         }
     }
 
-    // Create bind group
-    wgpu::BindGroupDescriptor groupDesc{};
-    groupDesc.label = "Bind Group";
-    groupDesc.layout = m_BindGroupLayout;
-    groupDesc.entryCount = entries.size();
-    groupDesc.entries = entries.data();
-
-    m_BindGroup = m_Context.device.CreateBindGroup(&groupDesc);
+    // Bindings that return to an earlier combination (materials swapped back and forth,
+    // ping-ponged history textures) take the bind group built for it then
+    m_BindGroup = m_Context.bindGroupCache->AcquireBindGroup(m_BindGroupLayout, entries);
     if (!m_BindGroup) {
         WEBGPU_LOG_ERROR("Failed to create bind group");
         throw std::runtime_error("Failed to create WebGPU bind group");
     }
-
-    WEBGPU_LOG_INFO("Bind group updated with " << entries.size() << " entries");
+    m_Dirty = false;
 }
 
 void* WebGPUDescriptorSet::GetNativeHandle(uint32 frameIndex) const {
@@ -8,22 +8,39 @@
 #include "metagfx/rhi/webgpu/WebGPUSampler.h"
 #include "metagfx/rhi/webgpu/WebGPUShader.h"
 #include "metagfx/rhi/webgpu/WebGPUPipeline.h"
+#include "metagfx/rhi/webgpu/WebGPUComputePipeline.h"
 #include "metagfx/rhi/webgpu/WebGPUCommandBuffer.h"
 #include "metagfx/rhi/webgpu/WebGPUFramebuffer.h"
 #include "metagfx/rhi/webgpu/WebGPUDescriptorSet.h"
+#include "metagfx/rhi/webgpu/WebGPUBindGroupCache.h"
+#include "metagfx/rhi/webgpu/WebGPUDrawList.h"
+#include "metagfx/rhi/webgpu/WebGPUUploadBelt.h"
+#include "metagfx/rhi/webgpu/WebGPUMipGenerator.h"
+#include "metagfx/rhi/webgpu/WebGPUShaderCache.h"
 #include "metagfx/rhi/webgpu/WebGPUSurfaceBridge.h"
+#include "metagfx/rhi/webgpu/WebGPUGpuProfiler.h"
 #include "metagfx/core/Logger.h"
 
 #include <SDL3/SDL.h>
 
+#include <algorithm>
+#include <memory>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
 namespace metagfx {
 namespace rhi {
 
-WebGPUDevice::WebGPUDevice(SDL_Window* window)
+WebGPUDevice::WebGPUDevice(SDL_Window* window, const GraphicsDeviceDesc& desc)
     : m_Window(window) {
 
     METAGFX_INFO << "Initializing WebGPU device...";
 
+    m_Context.stats = &m_StatsCounters;
+    m_Context.memory = &m_MemoryCounters;
+
     // Create WebGPU instance
     CreateInstance();
 
@@ -39,14 +56,39 @@ WebGPUDevice::WebGPUDevice(SDL_Window* window)
     // Query device capabilities and limits
     QueryDeviceCapabilities();
 
+    m_BindGroupCache = CreateScope<WebGPUBindGroupCache>(m_Context);
+    m_Context.bindGroupCache = m_BindGroupCache.get();
+    m_UploadBelt = CreateScope<WebGPUUploadBelt>(m_Context);
+    m_Context.uploadBelt = m_UploadBelt.get();
+    m_MipGenerator = CreateScope<WebGPUMipGenerator>(m_Context);
+    m_Context.mipGenerator = m_MipGenerator.get();
+    m_ShaderCache = CreateScope<WebGPUShaderCache>(desc.pipelineCachePath, desc.precompiledShaders,
+                                                   desc.precompiledShaderCount);
+    m_Context.shaderCache = m_ShaderCache.get();
+
     // Create swap chain
-    m_SwapChain = CreateRef<WebGPUSwapChain>(m_Context, window);
+    m_SwapChain = CreateRef<WebGPUSwapChain>(m_Context, window, desc.presentMode);
+
+    for (uint32 i = 0; i < desc.framesInFlight; ++i) {
+        m_FrameCommandBuffers.push_back(CreateRef<WebGPUCommandBuffer>(m_Context));
+    }
 
     // Fill device info
     m_DeviceInfo.deviceName = "WebGPU Device (Dawn)";
     m_DeviceInfo.api = GraphicsAPI::WebGPU;
     m_DeviceInfo.apiVersion = 1;  // WebGPU version
     m_DeviceInfo.deviceMemory = 0;  // Not easily queryable in WebGPU
+    m_DeviceInfo.minUniformBufferOffsetAlignment = m_Context.minUniformBufferOffsetAlignment;
+    m_DeviceInfo.framesInFlight = desc.framesInFlight;
+    m_DeviceInfo.supportsBCTextures = m_Context.supportsBCTextures;
+    m_DeviceInfo.supportsETC2Textures = m_Context.supportsETC2Textures;
+    m_DeviceInfo.supportsASTCTextures = m_Context.supportsASTCTextures;
+    m_DeviceInfo.isIntegratedGPU = m_Context.isIntegratedGPU;
+    m_DeviceInfo.maxComputeWorkGroupInvocations = 256;  // maxComputeInvocationsPerWorkgroup default limit
+    m_DeviceInfo.supportsTimestampQueries = m_Context.supportsTimestampQueries;
+    // depth32float and depth16unorm are core formats
+    m_DeviceInfo.depthFormat = Format::D32_SFLOAT;
+    m_DeviceInfo.supportsDepth16 = true;
 
     METAGFX_INFO << "WebGPU device initialized successfully";
     METAGFX_INFO << "  Device: " << m_DeviceInfo.deviceName;
@@ -54,10 +96,20 @@ WebGPUDevice::WebGPUDevice(SDL_Window* window)
 
 WebGPUDevice::~WebGPUDevice() {
     WaitIdle();
+    ReleasePipelineCache();
+    ReleaseRetired(true);
 
     // Release resources in reverse order
+    m_FrameCommandBuffers.clear();
     m_SwapChain.reset();
-    m_ActiveDescriptorSetLayout.reset();
+    m_BindGroupCache.reset();
+    m_Context.bindGroupCache = nullptr;
+    m_MipGenerator.reset();
+    m_Context.mipGenerator = nullptr;
+    m_UploadBelt.reset();
+    m_Context.uploadBelt = nullptr;
+    m_ShaderCache.reset();
+    m_Context.shaderCache = nullptr;
 
     // Release WebGPU objects (handled by wgpu::RefCounted)
     m_Context.surface = nullptr;
@@ -150,8 +202,22 @@ void WebGPUDevice::RequestDevice() {
     requiredLimits.limits.maxVertexBuffers = 8;
     requiredLimits.limits.maxVertexAttributes = 16;
 
+    // Optional texture compression and timestamp query features, requested when the
+    // adapter has them
+    std::vector<wgpu::FeatureName> requiredFeatures;
+    for (wgpu::FeatureName feature : { wgpu::FeatureName::TextureCompressionBC,
+                                       wgpu::FeatureName::TextureCompressionETC2,
+                                       wgpu::FeatureName::TextureCompressionASTC,
+                                       wgpu::FeatureName::TimestampQuery }) {
+        if (m_Context.adapter.HasFeature(feature)) {
+            requiredFeatures.push_back(feature);
+        }
+    }
+
     wgpu::DeviceDescriptor deviceDesc{};
     deviceDesc.requiredLimits = &requiredLimits;
+    deviceDesc.requiredFeatureCount = requiredFeatures.size();
+    deviceDesc.requiredFeatures = requiredFeatures.data();
     deviceDesc.defaultQueue.label = "Default Queue";
 
     auto callback = [](WGPURequestDeviceStatus status, WGPUDevice device,
@@ -232,14 +298,24 @@ void WebGPUDevice::QueryDeviceCapabilities() {
 
     // Query features (these would need to be checked individually in Dawn)
     // For now, we'll set conservative defaults
-    m_Context.supportsTimestampQueries = false;
+    m_Context.supportsTimestampQueries = m_Context.device.HasFeature(wgpu::FeatureName::TimestampQuery);
     m_Context.supportsDepthClipControl = false;
     m_Context.supportsBGRA8UnormStorage = true;
+    m_Context.supportsBCTextures = m_Context.device.HasFeature(wgpu::FeatureName::TextureCompressionBC);
+    m_Context.supportsETC2Textures = m_Context.device.HasFeature(wgpu::FeatureName::TextureCompressionETC2);
+    m_Context.supportsASTCTextures = m_Context.device.HasFeature(wgpu::FeatureName::TextureCompressionASTC);
+
+    wgpu::AdapterProperties adapterProperties{};
+    m_Context.adapter.GetProperties(&adapterProperties);
+    m_Context.isIntegratedGPU = adapterProperties.adapterType == wgpu::AdapterType::IntegratedGPU;
 
     METAGFX_INFO << "Device capabilities:";
     METAGFX_INFO << "  Max bind groups: " << m_Context.maxBindGroups;
     METAGFX_INFO << "  Max uniform buffer size: " << m_Context.maxUniformBufferBindingSize;
     METAGFX_INFO << "  Min uniform buffer alignment: " << m_Context.minUniformBufferOffsetAlignment;
+    METAGFX_INFO << "  Texture compression: BC=" << m_Context.supportsBCTextures
+                 << " ETC2=" << m_Context.supportsETC2Textures
+                 << " ASTC=" << m_Context.supportsASTCTextures;
 }
 
 Ref<Buffer> WebGPUDevice::CreateBuffer(const BufferDesc& desc) {
@@ -258,8 +334,47 @@ Ref<Shader> WebGPUDevice::CreateShader(const ShaderDesc& desc) {
     return CreateRef<WebGPUShader>(m_Context, desc);
 }
 
-Ref<Pipeline> WebGPUDevice::CreateGraphicsPipeline(const PipelineDesc& desc) {
-    return CreateRef<WebGPUPipeline>(m_Context, desc);
+Ref<Pipeline> WebGPUDevice::CompileGraphicsPipeline(const PipelineDesc& desc) {
+    return CreateRef<WebGPUPipeline>(m_Context, desc, ResolveBindGroupLayouts(desc));
+}
+
+Ref<PipelineFuture> WebGPUDevice::CompileGraphicsPipelineAsync(const PipelineDesc& desc) {
+    return WebGPUPipeline::CreateAsync(m_Context, desc, ResolveBindGroupLayouts(desc));
+}
+
+// Pipelines are created against the bind group layouts
+void WebGPUDevice::AppendPipelineStateKey(const PipelineDesc& desc, std::string& key) const {
+    std::vector<wgpu::BindGroupLayout> layouts = ResolveBindGroupLayouts(desc);
+    uint32 layoutCount = static_cast<uint32>(layouts.size());
+    key.append(reinterpret_cast<const char*>(&layoutCount), sizeof(layoutCount));
+    for (const wgpu::BindGroupLayout& layout : layouts) {
+        WGPUBindGroupLayout handle = layout.Get();
+        key.append(reinterpret_cast<const char*>(&handle), sizeof(handle));
+    }
+}
+
+wgpu::BindGroupLayout WebGPUDevice::ResolveBindGroupLayout(const Ref<DescriptorSet>& descriptorSet) const {
+    if (!descriptorSet) {
+        return nullptr;
+    }
+    return std::static_pointer_cast<WebGPUDescriptorSet>(descriptorSet)->GetBindGroupLayout();
+}
+
+std::vector<wgpu::BindGroupLayout> WebGPUDevice::ResolveBindGroupLayouts(const PipelineDesc& desc) const {
+    std::vector<wgpu::BindGroupLayout> layouts = { ResolveBindGroupLayout(desc.descriptorSetLayout) };
+    for (const Ref<DescriptorSet>& setLayout : desc.extraSetLayouts) {
+        if (layouts.size() == MAX_DESCRIPTOR_SETS) {
+            WEBGPU_LOG_ERROR("Pipeline takes more than " << MAX_DESCRIPTOR_SETS << " descriptor sets");
+            break;
+        }
+        layouts.push_back(ResolveBindGroupLayout(setLayout));
+    }
+    return layouts;
+}
+
+Ref<Pipeline> WebGPUDevice::CreateComputePipeline(const ComputePipelineDesc& desc) {
+    wgpu::BindGroupLayout bindGroupLayout = ResolveBindGroupLayout(desc.descriptorSetLayout);
+    return CreateRef<WebGPUComputePipeline>(m_Context, desc, bindGroupLayout);
 }
 
 Ref<Framebuffer> WebGPUDevice::CreateFramebuffer(const FramebufferDesc& desc) {
@@ -270,28 +385,82 @@ Ref<DescriptorSet> WebGPUDevice::CreateDescriptorSet(const DescriptorSetDesc& de
     return CreateRef<WebGPUDescriptorSet>(m_Context, desc);
 }
 
+Ref<DrawList> WebGPUDevice::CreateDrawList(const DrawListDesc& desc) {
+    return CreateRef<WebGPUDrawList>(*this, m_Context, desc);
+}
+
 Ref<CommandBuffer> WebGPUDevice::CreateCommandBuffer() {
     return CreateRef<WebGPUCommandBuffer>(m_Context);
 }
 
+FrameContext WebGPUDevice::BeginFrame() {
+    // Queue writes and submits are ordered, so the previous recording of this slot
+    // can be overwritten as soon as it has been submitted
+    EndFrameStats();
+
+    // Once per frame: completes Buffer::MapAsync() reads the GPU has finished
+#ifndef __EMSCRIPTEN__
+    m_Context.device.Tick();
+#endif
+
+    // Retire() queue, after Tick() delivered the completed submissions
+    ReleaseRetired();
+
+    FrameContext frame;
+    frame.frameIndex = m_FrameIndex;
+    frame.frameCount = static_cast<uint32>(m_FrameCommandBuffers.size());
+    frame.commandBuffer = m_FrameCommandBuffers[m_FrameIndex];
+    m_FrameIndex = (m_FrameIndex + 1) % frame.frameCount;
+    return frame;
+}
+
 void WebGPUDevice::SubmitCommandBuffer(Ref<CommandBuffer> commandBuffer) {
     auto webgpuCmd = std::static_pointer_cast<WebGPUCommandBuffer>(commandBuffer);
     wgpu::CommandBuffer cmd = webgpuCmd->GetHandle();
 
+    // Texture uploads recorded since the last submit go first
+    m_UploadBelt->Flush();
+
     if (cmd) {
         m_Context.queue.Submit(1, &cmd);
+        AddSubmittedStats(*webgpuCmd);
+
+        // Completes the device's progress value (GetCompletedFrameValue()) from Tick()
+        m_Context.queue.OnSubmittedWorkDone(OnSubmittedWorkDone, new SubmittedWork{ this, NextSignalValue() });
     }
 }
 
+void WebGPUDevice::OnSubmittedWorkDone(WGPUQueueWorkDoneStatus status, void* userdata) {
+    std::unique_ptr<SubmittedWork> work(static_cast<SubmittedWork*>(userdata));
+    if (status != WGPUQueueWorkDoneStatus_Success) {
+        WEBGPU_LOG_ERROR("Submitted work failed: " << static_cast<int>(status));
+    }
+    work->device->CompleteValue(work->value);
+}
+
+void WebGPUDevice::WaitValue(uint64 value) {
+    value = std::min(value, SignalValue());
+    while (GetCompletedFrameValue() < value) {
+#ifdef __EMSCRIPTEN__
+        emscripten_sleep(1);
+#else
+        m_Context.device.Tick();
+#endif
+    }
+}
+
+Ref<GpuProfiler> WebGPUDevice::CreateGpuProfiler() {
+    if (!m_DeviceInfo.supportsTimestampQueries) {
+        return nullptr;
+    }
+    return CreateRef<WebGPUGpuProfiler>(m_Context, m_DeviceInfo.framesInFlight);
+}
+
 void WebGPUDevice::WaitIdle() {
     // WebGPU doesn't have an explicit WaitIdle, but we can submit an empty command buffer
     // and wait for it via a fence-like mechanism (or just rely on queue completion)
     // For simplicity, we'll do nothing here as Dawn handles synchronization internally
 }
 
-void WebGPUDevice::SetActiveDescriptorSetLayout(Ref<DescriptorSet> descriptorSet) {
-    m_ActiveDescriptorSetLayout = descriptorSet;
-}
-
 } // namespace rhi
 } // namespace metagfx
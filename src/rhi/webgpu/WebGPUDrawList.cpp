@@ -0,0 +1,92 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUDrawList.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/webgpu/WebGPUDrawList.h"
+
+#include <algorithm>
+
+namespace metagfx {
+namespace rhi {
+
+bool WebGPUDrawList::BundleState::operator==(const BundleState& other) const {
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (bindGroups[set].Get() != other.bindGroups[set].Get() || dynamicOffsets[set] != other.dynamicOffsets[set]) {
+            return false;
+        }
+    }
+    return pipeline.Get() == other.pipeline.Get() && pushConstantGroup.Get() == other.pushConstantGroup.Get() &&
+           pushConstantOffset == other.pushConstantOffset && vertexBuffer.Get() == other.vertexBuffer.Get() &&
+           vertexBufferOffset == other.vertexBufferOffset && indexBuffer.Get() == other.indexBuffer.Get() &&
+           indexBufferOffset == other.indexBufferOffset && indexFormat == other.indexFormat &&
+           colorFormats == other.colorFormats && depthFormat == other.depthFormat &&
+           sampleCount == other.sampleCount;
+}
+
+WebGPUDrawList::WebGPUDrawList(GraphicsDevice& device, WebGPUContext& context, const DrawListDesc& desc)
+    : DrawList(device, desc)
+    , m_Context(context) {
+}
+
+wgpu::RenderBundle WebGPUDrawList::GetBundle(const BundleState& state) {
+    if (GetDrawCount() == 0 || !state.pipeline || !state.vertexBuffer || !state.indexBuffer) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = std::find_if(m_Bundles.begin(), m_Bundles.end(),
+                           [&](const Recorded& recorded) { return recorded.state == state; });
+    if (it != m_Bundles.end()) {
+        m_Bundles.splice(m_Bundles.begin(), m_Bundles, it);
+        return it->bundle;
+    }
+
+    wgpu::RenderBundleEncoderDescriptor encoderDesc{};
+    encoderDesc.label = "Draw List Bundle Encoder";
+    encoderDesc.colorFormatCount = state.colorFormats.size();
+    encoderDesc.colorFormats = state.colorFormats.data();
+    encoderDesc.depthStencilFormat = state.depthFormat;
+    encoderDesc.sampleCount = state.sampleCount;
+    wgpu::RenderBundleEncoder encoder = m_Context.device.CreateRenderBundleEncoder(&encoderDesc);
+    if (!encoder) {
+        WEBGPU_LOG_ERROR("Failed to create render bundle encoder");
+        return nullptr;
+    }
+
+    encoder.SetPipeline(state.pipeline);
+    for (uint32 set = 0; set < MAX_DESCRIPTOR_SETS; ++set) {
+        if (state.bindGroups[set]) {
+            encoder.SetBindGroup(set, state.bindGroups[set], state.dynamicOffsets[set].size(),
+                                 state.dynamicOffsets[set].data());
+        }
+    }
+    if (state.pushConstantGroup) {
+        encoder.SetBindGroup(WEBGPU_PUSH_CONSTANT_GROUP, state.pushConstantGroup, 1, &state.pushConstantOffset);
+    }
+    encoder.SetVertexBuffer(0, state.vertexBuffer, state.vertexBufferOffset,
+                            state.vertexBuffer.GetSize() - state.vertexBufferOffset);
+    encoder.SetIndexBuffer(state.indexBuffer, state.indexFormat, state.indexBufferOffset,
+                           state.indexBuffer.GetSize() - state.indexBufferOffset);
+    for (const DrawIndexedIndirectCommand& draw : GetCommands()) {
+        encoder.DrawIndexed(draw.indexCount, draw.instanceCount, draw.firstIndex, draw.vertexOffset,
+                            draw.firstInstance);
+    }
+
+    wgpu::RenderBundleDescriptor bundleDesc{};
+    bundleDesc.label = "Draw List Bundle";
+    wgpu::RenderBundle bundle = encoder.Finish(&bundleDesc);
+    m_Context.stats->AddAllocation();
+    if (!bundle) {
+        WEBGPU_LOG_ERROR("Failed to record a render bundle of " << GetDrawCount() << " draws");
+        return nullptr;
+    }
+
+    if (m_Bundles.size() >= MAX_BUNDLES) {
+        m_Bundles.pop_back();
+    }
+    m_Bundles.push_front({ state, bundle });
+    return bundle;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,117 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUGpuProfiler.cpp
+// ============================================================================
+#include "metagfx/rhi/webgpu/WebGPUGpuProfiler.h"
+#include "metagfx/rhi/webgpu/WebGPUCommandBuffer.h"
+
+#include <cstring>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+constexpr uint64 SLOT_SIZE = GpuProfiler::MAX_QUERIES * sizeof(uint64);  // Multiple of the 256-byte resolve alignment
+
+} // namespace
+
+WebGPUGpuProfiler::WebGPUGpuProfiler(WebGPUContext& context, uint32 frameCount)
+    : GpuProfiler(frameCount), m_Context(context), m_Readbacks(frameCount) {
+    wgpu::QuerySetDescriptor querySetDesc{};
+    querySetDesc.label = "GPU Profiler Timestamps";
+    querySetDesc.type = wgpu::QueryType::Timestamp;
+    querySetDesc.count = frameCount * MAX_QUERIES;
+    m_QuerySet = m_Context.device.CreateQuerySet(&querySetDesc);
+
+    wgpu::BufferDescriptor resolveDesc{};
+    resolveDesc.label = "GPU Profiler Resolve";
+    resolveDesc.size = frameCount * SLOT_SIZE;
+    resolveDesc.usage = wgpu::BufferUsage::QueryResolve | wgpu::BufferUsage::CopySrc;
+    m_ResolveBuffer = m_Context.device.CreateBuffer(&resolveDesc);
+
+    for (Readback& readback : m_Readbacks) {
+        wgpu::BufferDescriptor readbackDesc{};
+        readbackDesc.label = "GPU Profiler Readback";
+        readbackDesc.size = SLOT_SIZE;
+        readbackDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+        readback.buffer = m_Context.device.CreateBuffer(&readbackDesc);
+    }
+}
+
+WebGPUGpuProfiler::~WebGPUGpuProfiler() {
+    // Pending maps complete with an aborted status once the buffers are destroyed
+    for (Readback& readback : m_Readbacks) {
+        if (readback.state == ReadbackState::Mapped) {
+            readback.buffer.Unmap();
+        }
+        readback.buffer.Destroy();
+    }
+#ifndef __EMSCRIPTEN__
+    m_Context.device.Tick();
+#endif
+    m_QuerySet.Destroy();
+}
+
+bool WebGPUGpuProfiler::WriteTimestamp(CommandBuffer& cmd, uint32 frameIndex, uint32 query) {
+    return static_cast<WebGPUCommandBuffer&>(cmd).WriteTimestamp(m_QuerySet, frameIndex * MAX_QUERIES + query);
+}
+
+bool WebGPUGpuProfiler::ResolveQueries(CommandBuffer& cmd, uint32 frameIndex, uint32 queryCount) {
+    Readback& readback = m_Readbacks[frameIndex];
+    if (readback.state == ReadbackState::Mapped) {
+        // A read that came back after its frame was dropped
+        readback.buffer.Unmap();
+        readback.state = ReadbackState::Idle;
+    }
+    wgpu::CommandEncoder encoder = static_cast<WebGPUCommandBuffer&>(cmd).GetEncoderBetweenPasses();
+    if (readback.state != ReadbackState::Idle || !encoder) {
+        return false;
+    }
+
+    encoder.ResolveQuerySet(m_QuerySet, frameIndex * MAX_QUERIES, queryCount, m_ResolveBuffer, frameIndex * SLOT_SIZE);
+    encoder.CopyBufferToBuffer(m_ResolveBuffer, frameIndex * SLOT_SIZE, readback.buffer, 0, queryCount * sizeof(uint64));
+    readback.state = ReadbackState::Submitted;
+    readback.queryCount = queryCount;
+    return true;
+}
+
+void WebGPUGpuProfiler::OnMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    auto* readback = static_cast<Readback*>(userdata);
+    readback->state = status == WGPUBufferMapAsyncStatus_Success ? ReadbackState::Mapped : ReadbackState::Idle;
+}
+
+void WebGPUGpuProfiler::PollReadbacks() {
+    // Every resolve recorded so far was submitted with its frame
+    for (Readback& readback : m_Readbacks) {
+        if (readback.state == ReadbackState::Submitted) {
+            readback.state = ReadbackState::Mapping;
+            readback.buffer.MapAsync(wgpu::MapMode::Read, 0, readback.queryCount * sizeof(uint64), OnMapped, &readback);
+        }
+    }
+#ifndef __EMSCRIPTEN__
+    m_Context.device.Tick();
+#endif
+}
+
+bool WebGPUGpuProfiler::ReadTimestamps(uint32 frameIndex, uint32 queryCount, uint64* nanoseconds) {
+    Readback& readback = m_Readbacks[frameIndex];
+    if (readback.state != ReadbackState::Mapped) {
+        return false;
+    }
+    const void* data = readback.buffer.GetConstMappedRange(0, queryCount * sizeof(uint64));
+    if (data) {
+        std::memcpy(nanoseconds, data, queryCount * sizeof(uint64));
+        // Unwritten queries resolve to 0
+        for (uint32 i = 0; i < queryCount; ++i) {
+            if (nanoseconds[i] == 0) {
+                nanoseconds[i] = INVALID_TIMESTAMP;
+            }
+        }
+    }
+    readback.buffer.Unmap();
+    readback.state = ReadbackState::Idle;
+    return data != nullptr;
+}
+
+} // namespace rhi
+} // namespace metagfx
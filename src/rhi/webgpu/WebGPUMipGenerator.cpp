@@ -0,0 +1,192 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUMipGenerator.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/webgpu/WebGPUMipGenerator.h"
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+// Fullscreen triangle; uv (0, 0) is the top left texel of the level
+const char* MIP_SHADER_WGSL = R"(
+struct VertexOutput {
+    @builtin(position) position : vec4f,
+    @location(0) uv : vec2f,
+};
+
+@vertex
+fn vs(@builtin(vertex_index) index : u32) -> VertexOutput {
+    let uv = vec2f(f32((index << 1u) & 2u), f32(index & 2u));
+    var output : VertexOutput;
+    output.position = vec4f(uv.x * 2.0 - 1.0, 1.0 - uv.y * 2.0, 0.0, 1.0);
+    output.uv = uv;
+    return output;
+}
+
+@group(0) @binding(0) var sourceSampler : sampler;
+@group(0) @binding(1) var source : texture_2d<f32>;
+
+@fragment
+fn fs(input : VertexOutput) -> @location(0) vec4f {
+    return textureSampleLevel(source, sourceSampler, input.uv, 0.0);
+}
+)";
+
+} // namespace
+
+WebGPUMipGenerator::WebGPUMipGenerator(WebGPUContext& context)
+    : m_Context(context) {
+    wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
+    wgslDesc.code = MIP_SHADER_WGSL;
+    wgpu::ShaderModuleDescriptor moduleDesc{};
+    moduleDesc.nextInChain = &wgslDesc;
+    moduleDesc.label = "Mip Generation";
+    m_Module = m_Context.device.CreateShaderModule(&moduleDesc);
+
+    wgpu::SamplerDescriptor samplerDesc{};
+    samplerDesc.label = "Mip Generation Sampler";
+    samplerDesc.minFilter = wgpu::FilterMode::Linear;
+    samplerDesc.magFilter = wgpu::FilterMode::Linear;
+    samplerDesc.addressModeU = wgpu::AddressMode::ClampToEdge;
+    samplerDesc.addressModeV = wgpu::AddressMode::ClampToEdge;
+    m_Sampler = m_Context.device.CreateSampler(&samplerDesc);
+
+    wgpu::BindGroupLayoutEntry entries[2] = {};
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Fragment;
+    entries[0].sampler.type = wgpu::SamplerBindingType::Filtering;
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Fragment;
+    entries[1].texture.sampleType = wgpu::TextureSampleType::Float;
+    entries[1].texture.viewDimension = wgpu::TextureViewDimension::e2D;
+
+    wgpu::BindGroupLayoutDescriptor layoutDesc{};
+    layoutDesc.label = "Mip Generation Layout";
+    layoutDesc.entryCount = 2;
+    layoutDesc.entries = entries;
+    m_BindGroupLayout = m_Context.device.CreateBindGroupLayout(&layoutDesc);
+
+    wgpu::PipelineLayoutDescriptor pipelineLayoutDesc{};
+    pipelineLayoutDesc.label = "Mip Generation Pipeline Layout";
+    pipelineLayoutDesc.bindGroupLayoutCount = 1;
+    pipelineLayoutDesc.bindGroupLayouts = &m_BindGroupLayout;
+    m_PipelineLayout = m_Context.device.CreatePipelineLayout(&pipelineLayoutDesc);
+
+    if (!m_Module || !m_Sampler || !m_BindGroupLayout || !m_PipelineLayout) {
+        WEBGPU_LOG_ERROR("Failed to create the mip generation objects");
+    }
+}
+
+bool WebGPUMipGenerator::IsSupported(Format format, TextureType type) {
+    if (type != TextureType::Texture2D && type != TextureType::TextureCube) {
+        return false;
+    }
+    switch (format) {
+        case Format::R8_UNORM:
+        case Format::R8G8_UNORM:
+        case Format::R8G8B8A8_UNORM:
+        case Format::R8G8B8A8_SRGB:
+        case Format::B8G8R8A8_UNORM:
+        case Format::B8G8R8A8_SRGB:
+        case Format::R16G16B16A16_SFLOAT:
+            return true;
+        default:
+            return false;  // 32-bit floats are not filterable in core WebGPU
+    }
+}
+
+void WebGPUMipGenerator::Generate(wgpu::CommandEncoder& encoder, const wgpu::Texture& texture, Format format,
+                                  uint32 mipLevels, uint32 layers) {
+    wgpu::TextureFormat textureFormat = ToWebGPUTextureFormat(format);
+    wgpu::RenderPipeline pipeline = GetPipeline(textureFormat);
+    if (!pipeline) {
+        return;
+    }
+
+    for (uint32 layer = 0; layer < layers; ++layer) {
+        wgpu::TextureViewDescriptor viewDesc{};
+        viewDesc.format = textureFormat;
+        viewDesc.dimension = wgpu::TextureViewDimension::e2D;
+        viewDesc.mipLevelCount = 1;
+        viewDesc.baseArrayLayer = layer;
+        viewDesc.arrayLayerCount = 1;
+        viewDesc.aspect = wgpu::TextureAspect::All;
+
+        viewDesc.baseMipLevel = 0;
+        wgpu::TextureView source = texture.CreateView(&viewDesc);
+        for (uint32 mip = 1; mip < mipLevels; ++mip) {
+            viewDesc.baseMipLevel = mip;
+            wgpu::TextureView target = texture.CreateView(&viewDesc);
+
+            wgpu::BindGroupEntry entries[2] = {};
+            entries[0].binding = 0;
+            entries[0].sampler = m_Sampler;
+            entries[1].binding = 1;
+            entries[1].textureView = source;
+            wgpu::BindGroupDescriptor groupDesc{};
+            groupDesc.label = "Mip Generation Bind Group";
+            groupDesc.layout = m_BindGroupLayout;
+            groupDesc.entryCount = 2;
+            groupDesc.entries = entries;
+            wgpu::BindGroup bindGroup = m_Context.device.CreateBindGroup(&groupDesc);
+
+            wgpu::RenderPassColorAttachment colorAttachment{};
+            colorAttachment.view = target;
+            colorAttachment.loadOp = wgpu::LoadOp::Clear;
+            colorAttachment.storeOp = wgpu::StoreOp::Store;
+            colorAttachment.clearValue = {0.0, 0.0, 0.0, 0.0};
+            wgpu::RenderPassDescriptor passDesc{};
+            passDesc.label = "Mip Generation Pass";
+            passDesc.colorAttachmentCount = 1;
+            passDesc.colorAttachments = &colorAttachment;
+
+            wgpu::RenderPassEncoder pass = encoder.BeginRenderPass(&passDesc);
+            pass.SetPipeline(pipeline);
+            pass.SetBindGroup(0, bindGroup);
+            pass.Draw(3);
+            pass.End();
+
+            source = target;
+        }
+    }
+}
+
+wgpu::RenderPipeline WebGPUMipGenerator::GetPipeline(wgpu::TextureFormat format) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Pipelines.find(static_cast<uint32>(format));
+    if (it != m_Pipelines.end()) {
+        return it->second;
+    }
+
+    wgpu::ColorTargetState colorTarget{};
+    colorTarget.format = format;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    wgpu::FragmentState fragment{};
+    fragment.module = m_Module;
+    fragment.entryPoint = "fs";
+    fragment.targetCount = 1;
+    fragment.targets = &colorTarget;
+
+    wgpu::RenderPipelineDescriptor pipelineDesc{};
+    pipelineDesc.label = "Mip Generation Pipeline";
+    pipelineDesc.layout = m_PipelineLayout;
+    pipelineDesc.vertex.module = m_Module;
+    pipelineDesc.vertex.entryPoint = "vs";
+    pipelineDesc.primitive.topology = wgpu::PrimitiveTopology::TriangleList;
+    pipelineDesc.fragment = &fragment;
+    pipelineDesc.multisample.count = 1;
+
+    wgpu::RenderPipeline pipeline = m_Context.device.CreateRenderPipeline(&pipelineDesc);
+    if (!pipeline) {
+        WEBGPU_LOG_ERROR("Failed to create the mip generation pipeline");
+        return nullptr;
+    }
+    m_Pipelines.emplace(static_cast<uint32>(format), pipeline);
+    return pipeline;
+}
+
+} // namespace rhi
+} // namespace metagfx
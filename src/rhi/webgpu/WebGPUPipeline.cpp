@@ -3,25 +3,104 @@
 // ============================================================================
 #include "metagfx/rhi/webgpu/WebGPUPipeline.h"
 #include "metagfx/rhi/webgpu/WebGPUShader.h"
+#include "metagfx/rhi/webgpu/WebGPUBindGroupCache.h"
 #include "metagfx/core/Logger.h"
 
+#include <memory>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
 namespace metagfx {
 namespace rhi {
 
-WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
+namespace {
+
+// Keeps the pipeline and its future alive until CreateRenderPipelineAsync() calls back
+struct PendingCompile {
+    Ref<WebGPUPipeline> pipeline;
+    Ref<PipelineFuture> future;
+};
+
+} // namespace
+
+WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc,
+                               const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts)
+    : m_Context(context) {
+    Build(desc, bindGroupLayouts, [this](const wgpu::RenderPipelineDescriptor& pipelineDesc) {
+        m_RenderPipeline = m_Context.device.CreateRenderPipeline(&pipelineDesc);
+        if (!m_RenderPipeline) {
+            WEBGPU_LOG_ERROR("Failed to create render pipeline");
+            throw std::runtime_error("Failed to create WebGPU render pipeline");
+        }
+    });
+
+    WEBGPU_LOG_INFO("WebGPU render pipeline created successfully");
+}
+
+WebGPUPipeline::WebGPUPipeline(WebGPUContext& context)
     : m_Context(context) {
+}
+
+Ref<PipelineFuture> WebGPUPipeline::CreateAsync(WebGPUContext& context, const PipelineDesc& desc,
+                                                const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts) {
+    // The callback runs in device.Tick() natively (WebGPUDevice::BeginFrame()) and from
+    // the browser's event loop on the web, which waiting has to yield to
+    wgpu::Device device = context.device;
+    Ref<PipelineFuture> future = PipelineFuture::MakePending([device]() {
+#ifdef __EMSCRIPTEN__
+        emscripten_sleep(1);
+#else
+        device.Tick();
+#endif
+    });
+
+    Ref<WebGPUPipeline> pipeline(new WebGPUPipeline(context));
+    pipeline->Build(desc, bindGroupLayouts, [&](const wgpu::RenderPipelineDescriptor& pipelineDesc) {
+        context.device.CreateRenderPipelineAsync(&pipelineDesc, OnCreated,
+                                                 new PendingCompile{ pipeline, future });
+    });
+    return future;
+}
 
+void WebGPUPipeline::OnCreated(WGPUCreatePipelineAsyncStatus status, WGPURenderPipeline renderPipeline,
+                               char const* message, void* userdata) {
+    std::unique_ptr<PendingCompile> pending(static_cast<PendingCompile*>(userdata));
+    if (status != WGPUCreatePipelineAsyncStatus_Success || !renderPipeline) {
+        WEBGPU_LOG_ERROR("Failed to create render pipeline: " << (message ? message : "unknown error"));
+        pending->future->Resolve(nullptr);
+        return;
+    }
+    pending->pipeline->m_RenderPipeline = wgpu::RenderPipeline::Acquire(renderPipeline);
+    pending->future->Resolve(std::move(pending->pipeline));
+}
+
+void WebGPUPipeline::Build(const PipelineDesc& desc, const std::vector<wgpu::BindGroupLayout>& bindGroupLayouts,
+                           const std::function<void(const wgpu::RenderPipelineDescriptor&)>& create) {
     // Store rasterization state
     m_PrimitiveTopology = ToWebGPUPrimitiveTopology(desc.topology);
     m_CullMode = ToWebGPUCullMode(desc.rasterization.cullMode);
     m_FrontFace = ToWebGPUFrontFace(desc.rasterization.frontFace);
 
-    // Create pipeline layout (for now, use empty layout)
-    // TODO: Add bind group layouts from descriptor sets
+    // Groups below WEBGPU_PUSH_CONSTANT_GROUP are the descriptor sets' layouts (empty
+    // where the pipeline takes no set), that one the push constant ring's
+    wgpu::BindGroupLayout layouts[WEBGPU_PUSH_CONSTANT_GROUP + 1];
+    m_EmptyGroupMask = 0;
+    for (uint32 group = 0; group < WEBGPU_PUSH_CONSTANT_GROUP; ++group) {
+        if (group < bindGroupLayouts.size() && bindGroupLayouts[group]) {
+            layouts[group] = bindGroupLayouts[group];
+        } else {
+            layouts[group] = m_Context.bindGroupCache->AcquireLayout({});
+            m_EmptyGroupMask |= 1u << group;
+        }
+    }
+    layouts[WEBGPU_PUSH_CONSTANT_GROUP] = m_Context.bindGroupCache->AcquirePushConstantLayout();
+
     wgpu::PipelineLayoutDescriptor layoutDesc{};
     layoutDesc.label = "Pipeline Layout";
-    layoutDesc.bindGroupLayoutCount = 0;
-    layoutDesc.bindGroupLayouts = nullptr;
+    layoutDesc.bindGroupLayoutCount = WEBGPU_PUSH_CONSTANT_GROUP + 1;
+    layoutDesc.bindGroupLayouts = layouts;
 
     m_PipelineLayout = m_Context.device.CreatePipelineLayout(&layoutDesc);
     if (!m_PipelineLayout) {
@@ -36,10 +115,16 @@ WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
 
     // Vertex state
     wgpu::VertexState vertexState{};
+    std::vector<wgpu::ConstantEntry> vertexConstants;
     if (desc.vertexShader) {
         auto webgpuShader = static_cast<WebGPUShader*>(desc.vertexShader.get());
         vertexState.module = webgpuShader->GetModule();
         vertexState.entryPoint = webgpuShader->GetEntryPoint().c_str();
+
+        // Specialization constants are WGSL override constants
+        vertexConstants = webgpuShader->GetOverrideConstants(desc.specializationConstants);
+        vertexState.constantCount = vertexConstants.size();
+        vertexState.constants = vertexConstants.data();
     }
 
     // Vertex buffer layouts
@@ -123,7 +208,7 @@ WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
 
     // Multisample state
     wgpu::MultisampleState multisampleState{};
-    multisampleState.count = 1;
+    multisampleState.count = desc.sampleCount;
     multisampleState.mask = 0xFFFFFFFF;
     multisampleState.alphaToCoverageEnabled = false;
 
@@ -133,11 +218,15 @@ WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
     wgpu::FragmentState fragmentState{};
     wgpu::ColorTargetState colorTarget{};
     wgpu::BlendState blendState{};
+    std::vector<wgpu::ConstantEntry> fragmentConstants;
 
     if (desc.fragmentShader) {
         auto webgpuShader = static_cast<WebGPUShader*>(desc.fragmentShader.get());
         fragmentState.module = webgpuShader->GetModule();
         fragmentState.entryPoint = webgpuShader->GetEntryPoint().c_str();
+        fragmentConstants = webgpuShader->GetOverrideConstants(desc.specializationConstants);
+        fragmentState.constantCount = fragmentConstants.size();
+        fragmentState.constants = fragmentConstants.data();
 
         // Color targets
         if (desc.colorAttachments.empty()) {
@@ -151,16 +240,32 @@ WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
             // Use specified color attachments
             // For simplicity, use first attachment's settings
             colorTarget.format = wgpu::TextureFormat::BGRA8Unorm;
-            colorTarget.writeMask = wgpu::ColorWriteMask::All;
+            colorTarget.writeMask = desc.colorAttachments[0].writeEnable ? wgpu::ColorWriteMask::All
+                                                                         : wgpu::ColorWriteMask::None;
 
             if (desc.colorAttachments[0].blendEnable) {
-                // Default alpha blending
                 blendState.color.operation = wgpu::BlendOperation::Add;
-                blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
-                blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
                 blendState.alpha.operation = wgpu::BlendOperation::Add;
-                blendState.alpha.srcFactor = wgpu::BlendFactor::One;
-                blendState.alpha.dstFactor = wgpu::BlendFactor::Zero;
+                switch (desc.colorAttachments[0].blendMode) {
+                    case BlendMode::Alpha:
+                        blendState.color.srcFactor = wgpu::BlendFactor::SrcAlpha;
+                        blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+                        blendState.alpha.srcFactor = wgpu::BlendFactor::One;
+                        blendState.alpha.dstFactor = wgpu::BlendFactor::Zero;
+                        break;
+                    case BlendMode::Additive:
+                        blendState.color.srcFactor = wgpu::BlendFactor::One;
+                        blendState.color.dstFactor = wgpu::BlendFactor::One;
+                        blendState.alpha.srcFactor = wgpu::BlendFactor::One;
+                        blendState.alpha.dstFactor = wgpu::BlendFactor::One;
+                        break;
+                    case BlendMode::Attenuate:
+                        blendState.color.srcFactor = wgpu::BlendFactor::Zero;
+                        blendState.color.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+                        blendState.alpha.srcFactor = wgpu::BlendFactor::Zero;
+                        blendState.alpha.dstFactor = wgpu::BlendFactor::OneMinusSrcAlpha;
+                        break;
+                }
 
                 colorTarget.blend = &blendState;
             }
@@ -172,15 +277,7 @@ WebGPUPipeline::WebGPUPipeline(WebGPUContext& context, const PipelineDesc& desc)
         pipelineDesc.fragment = &fragmentState;
     }
 
-    // Create render pipeline
-    m_RenderPipeline = m_Context.device.CreateRenderPipeline(&pipelineDesc);
-
-    if (!m_RenderPipeline) {
-        WEBGPU_LOG_ERROR("Failed to create render pipeline");
-        throw std::runtime_error("Failed to create WebGPU render pipeline");
-    }
-
-    WEBGPU_LOG_INFO("WebGPU render pipeline created successfully");
+    create(pipelineDesc);
 }
 
 WebGPUPipeline::~WebGPUPipeline() {
@@ -2,30 +2,33 @@
 // src/rhi/webgpu/WebGPUShader.cpp
 // ============================================================================
 #include "metagfx/rhi/webgpu/WebGPUShader.h"
+#include "metagfx/rhi/webgpu/WebGPUShaderCache.h"
 #include "metagfx/core/Logger.h"
 
 // Tint for SPIR-V to WGSL transpilation
 #include <tint/tint.h>
 
+#include <string>
 #include <vector>
 
 namespace metagfx {
 namespace rhi {
 
-WebGPUShader::WebGPUShader(WebGPUContext& context, const ShaderDesc& desc)
-    : m_Context(context)
-    , m_Stage(desc.stage)
-    , m_EntryPoint(desc.entryPoint.empty() ? "main" : desc.entryPoint) {
+namespace {
 
-    // Convert SPIR-V to WGSL using Tint (Google's official SPIR-V → WGSL compiler)
+// Convert SPIR-V to WGSL using Tint (Google's official SPIR-V → WGSL compiler)
+std::string TranslateToWGSL(const ShaderDesc& desc) {
     std::vector<uint32_t> spirvData(
         reinterpret_cast<const uint32_t*>(desc.code.data()),
         reinterpret_cast<const uint32_t*>(desc.code.data()) + desc.code.size() / sizeof(uint32_t)
     );
 
-    // Parse SPIR-V using Tint
+    // Parse SPIR-V using Tint. Push constant blocks need the Chromium extension; they
+    // are made uniform buffers by the caller.
     tint::Source::File sourceFile("shader.spv", "");
-    tint::Program program = tint::spirv::reader::Read(spirvData, {});
+    tint::spirv::reader::Options readerOptions;
+    readerOptions.allow_chromium_extensions = true;
+    tint::Program program = tint::spirv::reader::Read(spirvData, readerOptions);
 
     if (!program.IsValid()) {
         std::string errors;
@@ -50,9 +53,39 @@ WebGPUShader::WebGPUShader(WebGPUContext& context, const ShaderDesc& desc)
         throw std::runtime_error("Failed to generate WGSL from SPIR-V with Tint");
     }
 
-    m_WGSLSource = result->wgsl;
+    return result->wgsl;
+}
+
+} // namespace
+
+WebGPUShader::WebGPUShader(WebGPUContext& context, const ShaderDesc& desc)
+    : m_Context(context)
+    , m_Stage(desc.stage)
+    , m_EntryPoint(desc.entryPoint.empty() ? "main" : desc.entryPoint) {
+
+    // Tint is the slow part of startup, in WASM above all; a cached translation skips it
+    WebGPUShaderCache* cache = m_Context.shaderCache;
+    uint64 spirvHash = WebGPUShaderCache::HashSpirv(desc.code.data(), desc.code.size());
+    if (!cache || !cache->Find(spirvHash, m_WGSLSource)) {
+        m_WGSLSource = TranslateToWGSL(desc);
+        if (cache) {
+            cache->Store(spirvHash, m_WGSLSource);
+        }
+    }
+
+    // Push constants become the uniform buffer WebGPUCommandBuffer binds per draw
+    const std::string pushConstantEnable = "enable chromium_experimental_push_constant;";
+    if (size_t pos = m_WGSLSource.find(pushConstantEnable); pos != std::string::npos) {
+        m_WGSLSource.erase(pos, pushConstantEnable.size());
+    }
+    const std::string pushConstantVar = "var<push_constant>";
+    const std::string uniformVar = "@group(" + std::to_string(WEBGPU_PUSH_CONSTANT_GROUP) + ") @binding(0) var<uniform>";
+    for (size_t pos = m_WGSLSource.find(pushConstantVar); pos != std::string::npos;
+         pos = m_WGSLSource.find(pushConstantVar, pos + uniformVar.size())) {
+        m_WGSLSource.replace(pos, pushConstantVar.size(), uniformVar);
+    }
 
-    WEBGPU_LOG_INFO("Tint successfully transpiled SPIR-V → WGSL for "
+    WEBGPU_LOG_INFO("WGSL ready for "
                     << (desc.stage == ShaderStage::Vertex ? "vertex" : "fragment")
                     << " stage (" << m_WGSLSource.length() << " bytes)");
 
@@ -62,13 +95,23 @@ WebGPUShader::WebGPUShader(WebGPUContext& context, const ShaderDesc& desc)
         WEBGPU_LOG_INFO("WGSL preview: " << preview << (m_WGSLSource.length() > 500 ? "..." : ""));
     }
 
+    // Overrides the module declares, so pipelines only set constants it knows
+    // (unknown override keys fail pipeline validation)
+    for (size_t pos = m_WGSLSource.find("@id("); pos != std::string::npos;
+         pos = m_WGSLSource.find("@id(", pos + 4)) {
+        size_t end = m_WGSLSource.find(')', pos);
+        if (end != std::string::npos) {
+            m_OverrideIds.push_back(m_WGSLSource.substr(pos + 4, end - pos - 4));
+        }
+    }
+
     // Create WebGPU shader module from WGSL source
     wgpu::ShaderModuleWGSLDescriptor wgslDesc{};
     wgslDesc.code = m_WGSLSource.c_str();
 
     wgpu::ShaderModuleDescriptor moduleDesc{};
     moduleDesc.nextInChain = &wgslDesc;
-    moduleDesc.label = desc.debugName.empty() ? "Shader" : desc.debugName.c_str();
+    moduleDesc.label = desc.debugName ? desc.debugName : "Shader";
 
     m_Module = m_Context.device.CreateShaderModule(&moduleDesc);
 
@@ -77,7 +120,24 @@ WebGPUShader::WebGPUShader(WebGPUContext& context, const ShaderDesc& desc)
         throw std::runtime_error("Failed to create WebGPU shader module");
     }
 
-    WEBGPU_LOG_INFO("WebGPU shader module created successfully from Tint-generated WGSL");
+    WEBGPU_LOG_INFO("WebGPU shader module created successfully from WGSL");
+}
+
+std::vector<wgpu::ConstantEntry> WebGPUShader::GetOverrideConstants(
+    const std::vector<SpecializationConstant>& constants) const {
+    std::vector<wgpu::ConstantEntry> entries;
+    for (const SpecializationConstant& constant : constants) {
+        for (const std::string& id : m_OverrideIds) {
+            if (id == std::to_string(constant.id)) {
+                wgpu::ConstantEntry entry{};
+                entry.key = id.c_str();
+                entry.value = static_cast<double>(constant.value);
+                entries.push_back(entry);
+                break;
+            }
+        }
+    }
+    return entries;
 }
 
 WebGPUShader::~WebGPUShader() {
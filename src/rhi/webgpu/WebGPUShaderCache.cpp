@@ -0,0 +1,116 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUShaderCache.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/webgpu/WebGPUShaderCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+// Bump when the Tint reader or writer options in WebGPUShader change
+constexpr uint32 WGSL_CACHE_VERSION = 1;
+const char* WGSL_CACHE_HEADER = "// metagfx-wgsl";
+
+} // namespace
+
+WebGPUShaderCache::WebGPUShaderCache(const std::string& filePath, const PrecompiledShader* precompiled,
+                                     uint32 precompiledCount) {
+    for (uint32 i = 0; i < precompiledCount; ++i) {
+        m_Precompiled.emplace(precompiled[i].spirvHash, precompiled[i].source);
+    }
+    if (precompiledCount > 0) {
+        METAGFX_INFO << "WebGPU shader cache: " << precompiledCount << " modules precompiled to WGSL";
+    }
+
+    if (filePath.empty()) {
+        return;
+    }
+    m_ShaderDirectory = filePath + ".wgsl";
+    std::error_code ec;
+    std::filesystem::create_directories(m_ShaderDirectory, ec);
+    if (ec) {
+        METAGFX_WARN << "Failed to create shader cache directory: " << m_ShaderDirectory;
+        m_ShaderDirectory.clear();
+    }
+}
+
+uint64 WebGPUShaderCache::HashSpirv(const void* data, uint64 size) {
+    const uint8* bytes = static_cast<const uint8*>(data);
+    uint64 hash = 0xcbf29ce484222325ull;
+    for (uint64 i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool WebGPUShaderCache::Find(uint64 spirvHash, std::string& outSource) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (auto it = m_Precompiled.find(spirvHash); it != m_Precompiled.end()) {
+        outSource = it->second;
+        return true;
+    }
+    if (auto it = m_Translated.find(spirvHash); it != m_Translated.end()) {
+        outSource = it->second;
+        return true;
+    }
+    if (m_ShaderDirectory.empty()) {
+        return false;
+    }
+
+    std::ifstream in(GetShaderPath(spirvHash));
+    if (!in.is_open()) {
+        return false;
+    }
+    // First line: "// metagfx-wgsl <version>"
+    std::string line;
+    std::getline(in, line);
+    if (line != std::string(WGSL_CACHE_HEADER) + " " + std::to_string(WGSL_CACHE_VERSION)) {
+        return false;
+    }
+    std::ostringstream source;
+    source << in.rdbuf();
+    outSource = source.str();
+    m_Translated.emplace(spirvHash, outSource);
+    return true;
+}
+
+void WebGPUShaderCache::Store(uint64 spirvHash, const std::string& source) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Translated[spirvHash] = source;
+    if (m_ShaderDirectory.empty()) {
+        return;
+    }
+
+    // Renamed into place, so a concurrent reader never sees a partial file
+    std::string path = GetShaderPath(spirvHash);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::trunc);
+        if (!out.is_open()) {
+            return;
+        }
+        out << WGSL_CACHE_HEADER << ' ' << WGSL_CACHE_VERSION << '\n' << source;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tempPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+    }
+}
+
+std::string WebGPUShaderCache::GetShaderPath(uint64 spirvHash) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(spirvHash));
+    return m_ShaderDirectory + "/" + name + ".wgsl";
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -19,7 +19,9 @@ namespace rhi {
 wgpu::Surface CreateWebGPUSurfaceFromWindow(SDL_Window* window, wgpu::Instance instance) {
 #ifdef __EMSCRIPTEN__
     // For Emscripten, we create a surface from the canvas element
-    // The canvas selector is typically "#canvas" but can be customized
+    // The canvas selector is typically "#canvas" but can be customized. In threaded
+    // builds this runs in the main worker, where the selector names the OffscreenCanvas
+    // transferred to it (OFFSCREENCANVASES_TO_PTHREAD).
 
     // Get canvas selector (default to #canvas)
     const char* canvasSelector = "#canvas";
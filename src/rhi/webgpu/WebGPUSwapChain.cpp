@@ -7,12 +7,28 @@
 
 #include <SDL3/SDL.h>
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten/emscripten.h>
+#endif
+
 namespace metagfx {
 namespace rhi {
 
-WebGPUSwapChain::WebGPUSwapChain(WebGPUContext& context, SDL_Window* window)
+// Dawn's swap chain has no capability query, so only the modes every native surface
+// offers are requested; browsers present with FIFO only
+static PresentMode ResolvePresentMode(PresentMode mode) {
+#ifdef __EMSCRIPTEN__
+    (void)mode;
+    return PresentMode::Fifo;
+#else
+    return mode == PresentMode::Immediate ? PresentMode::Immediate : PresentMode::Fifo;
+#endif
+}
+
+WebGPUSwapChain::WebGPUSwapChain(WebGPUContext& context, SDL_Window* window, PresentMode presentMode)
     : m_Context(context)
-    , m_Window(window) {
+    , m_Window(window)
+    , m_PresentMode(ResolvePresentMode(presentMode)) {
 
     // Get window size
     int w, h;
@@ -50,7 +66,8 @@ void WebGPUSwapChain::CreateSwapChain() {
     swapChainDesc.format = preferredFormat;
     swapChainDesc.width = m_Width;
     swapChainDesc.height = m_Height;
-    swapChainDesc.presentMode = wgpu::PresentMode::Fifo;  // VSync
+    swapChainDesc.presentMode = m_PresentMode == PresentMode::Immediate ? wgpu::PresentMode::Immediate
+                                                                        : wgpu::PresentMode::Fifo;
 
     m_SwapChain = m_Context.device.CreateSwapChain(m_Context.surface, &swapChainDesc);
 
@@ -104,6 +121,12 @@ void WebGPUSwapChain::Present() {
 
     // However, we should call present() on the swap chain to advance to next frame
     m_SwapChain.Present();
+
+#ifdef __EMSCRIPTEN__
+    // The browser shows the canvas, or the OffscreenCanvas of the render worker, only
+    // once that thread's event loop runs; the frame loop never returns to it otherwise
+    emscripten_sleep(0);
+#endif
 }
 
 void WebGPUSwapChain::Resize(uint32 width, uint32 height) {
@@ -124,5 +147,17 @@ void WebGPUSwapChain::Resize(uint32 width, uint32 height) {
     WEBGPU_LOG_INFO("WebGPU swap chain resized: " << m_Width << "x" << m_Height);
 }
 
+void WebGPUSwapChain::SetPresentMode(PresentMode mode) {
+    PresentMode resolved = ResolvePresentMode(mode);
+    if (resolved == m_PresentMode) {
+        return;
+    }
+
+    m_PresentMode = resolved;
+    m_SwapChain = nullptr;
+    m_CurrentTexture = nullptr;
+    CreateSwapChain();
+}
+
 } // namespace rhi
 } // namespace metagfx
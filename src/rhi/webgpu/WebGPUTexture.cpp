@@ -2,6 +2,10 @@
 // src/rhi/webgpu/WebGPUTexture.cpp
 // ============================================================================
 #include "metagfx/rhi/webgpu/WebGPUTexture.h"
+#include "metagfx/rhi/webgpu/WebGPUUploadBelt.h"
+#include "metagfx/rhi/webgpu/WebGPUMipGenerator.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/MipGenerator.h"
 #include "metagfx/core/Logger.h"
 
 namespace metagfx {
@@ -13,15 +17,27 @@ WebGPUTexture::WebGPUTexture(WebGPUContext& context, const TextureDesc& desc)
     , m_Height(desc.height)
     , m_Depth(desc.depth)
     , m_MipLevels(desc.mipLevels)
+    , m_SampleCount(desc.sampleCount)
     , m_Format(desc.format)
     , m_Type(desc.type)
-    , m_Usage(desc.usage) {
+    , m_Usage(desc.usage)
+    , m_GenerateMipmaps(desc.generateMipmaps && desc.mipLevels > 1) {
+
+    m_GPUMipmaps = m_GenerateMipmaps && WebGPUMipGenerator::IsSupported(m_Format, m_Type);
+    if (m_GenerateMipmaps && !m_GPUMipmaps && !IsCPUMipGenerationSupported(m_Format)) {
+        WEBGPU_LOG_WARNING("Texture format cannot generate mipmaps; using a single mip level");
+        m_GenerateMipmaps = false;
+        m_MipLevels = 1;
+    }
 
     CreateTexture(desc);
     CreateTextureView();
 }
 
 WebGPUTexture::~WebGPUTexture() {
+    if (m_Texture) {
+        m_Context.memory->Remove(m_MemoryCategory, m_MemoryBytes);
+    }
     m_TextureView = nullptr;
     m_Texture = nullptr;
 }
@@ -60,6 +76,10 @@ void WebGPUTexture::CreateTexture(const TextureDesc& desc) {
     if (static_cast<int>(m_Usage) & static_cast<int>(TextureUsage::TransferDst)) {
         usage |= wgpu::TextureUsage::CopyDst;
     }
+    // Each level is rendered from the one above
+    if (m_GPUMipmaps) {
+        usage |= wgpu::TextureUsage::TextureBinding | wgpu::TextureUsage::RenderAttachment;
+    }
 
     // Create texture descriptor
     wgpu::TextureDescriptor textureDesc{};
@@ -70,18 +90,26 @@ void WebGPUTexture::CreateTexture(const TextureDesc& desc) {
     textureDesc.size.depthOrArrayLayers = (m_Type == TextureType::TextureCube) ? 6 : m_Depth;
     textureDesc.format = format;
     textureDesc.mipLevelCount = m_MipLevels;
-    textureDesc.sampleCount = 1;
+    textureDesc.sampleCount = m_SampleCount;
     textureDesc.usage = usage;
     textureDesc.viewFormatCount = 0;
     textureDesc.viewFormats = nullptr;
 
     // Create the texture
     m_Texture = m_Context.device.CreateTexture(&textureDesc);
+    m_Context.stats->AddAllocation();
 
     if (!m_Texture) {
         WEBGPU_LOG_ERROR("Failed to create texture");
         throw std::runtime_error("Failed to create WebGPU texture");
     }
+
+    // WebGPU reports no allocation sizes
+    TextureDesc allocated = desc;
+    allocated.mipLevels = m_MipLevels;
+    m_MemoryCategory = GetTextureMemoryCategory(desc);
+    m_MemoryBytes = GetTextureSize(allocated);
+    m_Context.memory->Add(m_MemoryCategory, m_MemoryBytes);
 }
 
 void WebGPUTexture::CreateTextureView() {
@@ -117,36 +145,79 @@ void WebGPUTexture::UploadData(const void* data, uint64 size) {
         return;
     }
 
-    // Calculate expected size for validation
-    uint32 bytesPerPixel = 4;  // Assume RGBA8 for now (could be calculated from format)
-    uint64 expectedSize = static_cast<uint64>(m_Width) * m_Height * m_Depth * bytesPerPixel;
+    FormatInfo formatInfo = GetFormatInfo(m_Format);
+    uint32 numLayers = (m_Type == TextureType::TextureCube) ? 6 : m_Depth;
+
+    // WebGPU has no blit: mips are rendered after the base level is uploaded, or for
+    // formats that cannot be, box-filtered on the CPU and written with it
+    std::vector<uint8> mipChain;
+    if (m_GenerateMipmaps && !m_GPUMipmaps) {
+        if (!GenerateMipChainCPU(data, m_Width, m_Height, numLayers, m_MipLevels, m_Format, mipChain)) {
+            return;
+        }
+        data = mipChain.data();
+        size = mipChain.size();
+    }
+
+    // Calculate expected size for validation (mip 0 only for callers that don't pass mips)
+    uint64 expectedSize = GetFormatImageSize(m_Format, m_Width, m_Height) * numLayers;
 
     if (size < expectedSize) {
         WEBGPU_LOG_ERROR("Texture data size mismatch: provided=" << size
                         << ", expected at least=" << expectedSize);
+        return;
     }
 
-    // Prepare texture data layout
-    wgpu::TextureDataLayout dataLayout{};
-    dataLayout.offset = 0;
-    dataLayout.bytesPerRow = m_Width * bytesPerPixel;
-    dataLayout.rowsPerImage = m_Height;
-
-    // Prepare image copy texture
-    wgpu::ImageCopyTexture destination{};
-    destination.texture = m_Texture;
-    destination.mipLevel = 0;
-    destination.origin = {0, 0, 0};
-    destination.aspect = wgpu::TextureAspect::All;
-
-    // Prepare extent
-    wgpu::Extent3D writeSize{};
-    writeSize.width = m_Width;
-    writeSize.height = m_Height;
-    writeSize.depthOrArrayLayers = 1;
+    const uint8* srcData = static_cast<const uint8*>(data);
+    uint64 offset = 0;
+
+    const uint32 uploadedMips = m_GPUMipmaps ? 1 : m_MipLevels;
+    for (uint32 mip = 0; mip < uploadedMips; ++mip) {
+        uint32 mipWidth = std::max(1u, m_Width >> mip);
+        uint32 mipHeight = std::max(1u, m_Height >> mip);
+        uint64 faceSize = GetFormatImageSize(m_Format, mipWidth, mipHeight);
+
+        for (uint32 layer = 0; layer < numLayers; ++layer) {
+            if (offset + faceSize > size) {
+                // Caller uploaded fewer levels than the texture has
+                return;
+            }
+
+            uint32 rowPitch = GetFormatRowPitch(m_Format, mipWidth);
+            uint32 rowCount = GetFormatRowCount(m_Format, mipHeight);  // In block rows
+
+            // Compressed copies cover whole blocks, even past the mip edge
+            wgpu::Extent3D writeSize{};
+            writeSize.width = rowPitch / formatInfo.blockSize * formatInfo.blockWidth;
+            writeSize.height = rowCount * formatInfo.blockHeight;
+            writeSize.depthOrArrayLayers = 1;
+
+            // Batched through the belt; straight to the queue when it has no room
+            if (!m_Context.uploadBelt->WriteTexture(m_Texture, mip, layer, srcData + offset, rowPitch, rowCount,
+                                                    writeSize)) {
+                wgpu::TextureDataLayout dataLayout{};
+                dataLayout.offset = 0;
+                dataLayout.bytesPerRow = rowPitch;
+                dataLayout.rowsPerImage = rowCount;
+
+                wgpu::ImageCopyTexture destination{};
+                destination.texture = m_Texture;
+                destination.mipLevel = mip;
+                destination.origin = {0, 0, layer};
+                destination.aspect = wgpu::TextureAspect::All;
+
+                m_Context.queue.WriteTexture(&destination, srcData + offset, faceSize, &dataLayout, &writeSize);
+            }
+            m_Context.stats->AddTextureUpload(faceSize);
+            offset += faceSize;
+        }
+    }
 
-    // Upload data to GPU
-    m_Context.queue.WriteTexture(&destination, data, size, &dataLayout, &writeSize);
+    if (m_GPUMipmaps) {
+        m_Context.uploadBelt->Record([&](wgpu::CommandEncoder& encoder) {
+            m_Context.mipGenerator->Generate(encoder, m_Texture, m_Format, m_MipLevels, numLayers);
+        });
+    }
 }
 
 } // namespace rhi
@@ -67,6 +67,27 @@ wgpu::TextureFormat ToWebGPUTextureFormat(Format format) {
         case Format::D24_UNORM_S8_UINT: return wgpu::TextureFormat::Depth24PlusStencil8;
         case Format::D32_SFLOAT_S8_UINT: return wgpu::TextureFormat::Depth32FloatStencil8;
 
+        // Block-compressed formats (need the matching TextureCompression* feature)
+        case Format::BC1_RGBA_UNORM:    return wgpu::TextureFormat::BC1RGBAUnorm;
+        case Format::BC1_RGBA_SRGB:     return wgpu::TextureFormat::BC1RGBAUnormSrgb;
+        case Format::BC3_RGBA_UNORM:    return wgpu::TextureFormat::BC3RGBAUnorm;
+        case Format::BC3_RGBA_SRGB:     return wgpu::TextureFormat::BC3RGBAUnormSrgb;
+        case Format::BC4_R_UNORM:       return wgpu::TextureFormat::BC4RUnorm;
+        case Format::BC5_RG_UNORM:      return wgpu::TextureFormat::BC5RGUnorm;
+        case Format::BC6H_RGB_UFLOAT:   return wgpu::TextureFormat::BC6HRGBUfloat;
+        case Format::BC7_RGBA_UNORM:    return wgpu::TextureFormat::BC7RGBAUnorm;
+        case Format::BC7_RGBA_SRGB:     return wgpu::TextureFormat::BC7RGBAUnormSrgb;
+        case Format::ETC2_RGB8_UNORM:   return wgpu::TextureFormat::ETC2RGB8Unorm;
+        case Format::ETC2_RGB8_SRGB:    return wgpu::TextureFormat::ETC2RGB8UnormSrgb;
+        case Format::ETC2_RGBA8_UNORM:  return wgpu::TextureFormat::ETC2RGBA8Unorm;
+        case Format::ETC2_RGBA8_SRGB:   return wgpu::TextureFormat::ETC2RGBA8UnormSrgb;
+        case Format::ASTC_4x4_UNORM:    return wgpu::TextureFormat::ASTC4x4Unorm;
+        case Format::ASTC_4x4_SRGB:     return wgpu::TextureFormat::ASTC4x4UnormSrgb;
+        case Format::ASTC_6x6_UNORM:    return wgpu::TextureFormat::ASTC6x6Unorm;
+        case Format::ASTC_6x6_SRGB:     return wgpu::TextureFormat::ASTC6x6UnormSrgb;
+        case Format::ASTC_8x8_UNORM:    return wgpu::TextureFormat::ASTC8x8Unorm;
+        case Format::ASTC_8x8_SRGB:     return wgpu::TextureFormat::ASTC8x8UnormSrgb;
+
         // Unsupported formats - return undefined and log warning
         case Format::R16_UNORM:
         case Format::R16_SNORM:
@@ -113,6 +134,8 @@ wgpu::BufferUsage ToWebGPUBufferUsage(BufferUsage usage) {
         result |= wgpu::BufferUsage::CopySrc;
     if (static_cast<int>(usage) & static_cast<int>(BufferUsage::TransferDst))
         result |= wgpu::BufferUsage::CopyDst;
+    if (static_cast<int>(usage) & static_cast<int>(BufferUsage::Indirect))
+        result |= wgpu::BufferUsage::Indirect;
 
     return result;
 }
@@ -0,0 +1,187 @@
+// ============================================================================
+// src/rhi/webgpu/WebGPUUploadBelt.cpp
+// ============================================================================
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/webgpu/WebGPUUploadBelt.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+namespace rhi {
+
+namespace {
+
+// CopyBufferToTexture needs rows and offsets on 256 bytes
+constexpr uint64 COPY_ALIGNMENT = 256;
+
+uint64 AlignUp(uint64 value, uint64 alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+WebGPUUploadBelt::WebGPUUploadBelt(WebGPUContext& context)
+    : m_Context(context) {
+}
+
+WebGPUUploadBelt::~WebGPUUploadBelt() {
+    // Pending maps complete with an aborted status once the buffers are destroyed; let
+    // them run while the chunks still exist
+    for (Scope<Chunk>& chunk : m_Chunks) {
+        chunk->buffer.Destroy();
+        m_Context.memory->Remove(MemoryCategory::Staging, chunk->size);
+    }
+#ifndef __EMSCRIPTEN__
+    m_Context.device.Tick();
+#endif
+    m_Chunks.clear();
+}
+
+bool WebGPUUploadBelt::WriteTexture(const wgpu::Texture& texture, uint32 mipLevel, uint32 layer,
+                                    const void* data, uint32 rowPitch, uint32 rowCount,
+                                    const wgpu::Extent3D& extent) {
+    const uint64 alignedPitch = AlignUp(rowPitch, COPY_ALIGNMENT);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    uint64 offset = 0;
+    Chunk* chunk = Allocate(alignedPitch * rowCount, offset);
+    if (!chunk) {
+        return false;
+    }
+
+    const uint8* src = static_cast<const uint8*>(data);
+    uint8* dst = chunk->mapped + offset;
+    if (alignedPitch == rowPitch) {
+        std::memcpy(dst, src, static_cast<uint64>(rowPitch) * rowCount);
+    } else {
+        for (uint32 row = 0; row < rowCount; ++row) {
+            std::memcpy(dst + row * alignedPitch, src + static_cast<uint64>(row) * rowPitch, rowPitch);
+        }
+    }
+
+    wgpu::ImageCopyBuffer source{};
+    source.buffer = chunk->buffer;
+    source.layout.offset = offset;
+    source.layout.bytesPerRow = static_cast<uint32>(alignedPitch);
+    source.layout.rowsPerImage = rowCount;
+
+    wgpu::ImageCopyTexture destination{};
+    destination.texture = texture;
+    destination.mipLevel = mipLevel;
+    destination.origin = {0, 0, layer};
+    destination.aspect = wgpu::TextureAspect::All;
+
+    GetEncoder().CopyBufferToTexture(&source, &destination, &extent);
+    return true;
+}
+
+void WebGPUUploadBelt::Record(const std::function<void(wgpu::CommandEncoder&)>& record) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    record(GetEncoder());
+}
+
+void WebGPUUploadBelt::Flush() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    if (!m_Encoder) {
+        return;
+    }
+
+    // Copies read the chunks only once they are unmapped
+    for (Scope<Chunk>& chunk : m_Chunks) {
+        if (chunk->state == ChunkState::Pending) {
+            chunk->buffer.Unmap();
+            chunk->mapped = nullptr;
+        }
+    }
+
+    wgpu::CommandBufferDescriptor commandsDesc{};
+    commandsDesc.label = "Texture Uploads";
+    wgpu::CommandBuffer commands = m_Encoder.Finish(&commandsDesc);
+    m_Encoder = nullptr;
+    m_Current = nullptr;
+    if (commands) {
+        m_Context.queue.Submit(1, &commands);
+    } else {
+        WEBGPU_LOG_ERROR("Failed to finish texture upload commands");
+    }
+
+    // Mapping waits for the submitted copies
+    for (Scope<Chunk>& chunk : m_Chunks) {
+        if (chunk->state == ChunkState::Pending) {
+            chunk->state = ChunkState::Mapping;
+            chunk->buffer.MapAsync(wgpu::MapMode::Write, 0, chunk->size, OnMapped, chunk.get());
+        }
+    }
+}
+
+void WebGPUUploadBelt::OnMapped(WGPUBufferMapAsyncStatus status, void* userdata) {
+    auto* chunk = static_cast<Chunk*>(userdata);
+    std::lock_guard<std::mutex> lock(chunk->belt->m_Mutex);
+    chunk->state = ChunkState::Free;
+    chunk->used = 0;
+    chunk->mapped = status == WGPUBufferMapAsyncStatus_Success
+                        ? static_cast<uint8*>(chunk->buffer.GetMappedRange(0, chunk->size))
+                        : nullptr;
+}
+
+WebGPUUploadBelt::Chunk* WebGPUUploadBelt::Allocate(uint64 size, uint64& offset) {
+    if (m_Current && AlignUp(m_Current->used, COPY_ALIGNMENT) + size <= m_Current->size) {
+        offset = AlignUp(m_Current->used, COPY_ALIGNMENT);
+        m_Current->used = offset + size;
+        return m_Current;
+    }
+
+    // A filled chunk stays pending until the flush; take a free one or add one
+    Chunk* chunk = nullptr;
+    for (Scope<Chunk>& candidate : m_Chunks) {
+        if (candidate->state == ChunkState::Free && candidate->mapped && candidate->size >= size) {
+            chunk = candidate.get();
+            break;
+        }
+    }
+
+    if (!chunk) {
+        auto created = CreateScope<Chunk>();
+        created->belt = this;
+        created->size = std::max(CHUNK_SIZE, AlignUp(size, COPY_ALIGNMENT));
+
+        wgpu::BufferDescriptor bufferDesc{};
+        bufferDesc.label = "Texture Upload Belt";
+        bufferDesc.size = created->size;
+        bufferDesc.usage = wgpu::BufferUsage::MapWrite | wgpu::BufferUsage::CopySrc;
+        bufferDesc.mappedAtCreation = true;
+        created->buffer = m_Context.device.CreateBuffer(&bufferDesc);
+        m_Context.stats->AddAllocation();
+        if (!created->buffer) {
+            WEBGPU_LOG_ERROR("Failed to create a " << created->size << " byte upload chunk");
+            return nullptr;
+        }
+        created->mapped = static_cast<uint8*>(created->buffer.GetMappedRange(0, created->size));
+        if (!created->mapped) {
+            WEBGPU_LOG_ERROR("Failed to map a new upload chunk");
+            return nullptr;
+        }
+        m_Context.memory->Add(MemoryCategory::Staging, created->size);
+        chunk = created.get();
+        m_Chunks.push_back(std::move(created));
+    }
+
+    chunk->state = ChunkState::Pending;
+    chunk->used = size;
+    offset = 0;
+    m_Current = chunk;
+    return chunk;
+}
+
+wgpu::CommandEncoder& WebGPUUploadBelt::GetEncoder() {
+    if (!m_Encoder) {
+        wgpu::CommandEncoderDescriptor encoderDesc{};
+        encoderDesc.label = "Texture Upload Encoder";
+        m_Encoder = m_Context.device.CreateCommandEncoder(&encoderDesc);
+    }
+    return m_Encoder;
+}
+
+} // namespace rhi
+} // namespace metagfx
@@ -0,0 +1,197 @@
+// ============================================================================
+// src/scene/AmbientOcclusion.cpp
+// ============================================================================
+#include "metagfx/scene/AmbientOcclusion.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Must match local_size_x/y of ambient_occlusion.comp
+constexpr uint32 AO_GROUP_SIZE = 8;
+
+// Visibility and view depth as packHalf2x16, for the half-resolution texture and the
+// histories
+constexpr rhi::Format AO_PACKED_FORMAT = rhi::Format::R32_UINT;
+
+// Push constants of ambient_occlusion.comp
+struct AmbientOcclusionPushConstants {
+    glm::mat4 reprojection;  // This frame's view space to the last frame's
+    glm::vec4 unproject;     // 1 / P00, 1 / P11, P20 - P30, P21 - P31 of the projection P
+    glm::vec4 depthParams;   // P22, P32, P23, P33
+    glm::uvec2 size;         // Of the depth drawn, its top-left region
+    uint32 pass;             // 0 = occlusion, 1 = upsample
+    uint32 frame;            // Rotates the slices; 0 without temporal accumulation
+    float radius;
+    float intensity;
+    float historyWeight;     // 0 without a history
+    uint32 padding;
+};
+
+AmbientOcclusion::AmbientOcclusion(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The textures come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 2, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 3, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 4, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "AmbientOcclusionLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(AmbientOcclusionPushConstants);
+    pipelineDesc.debugName = "AmbientOcclusionPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Ambient occlusion unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Ambient occlusion created: half-resolution GTAO";
+}
+
+void AmbientOcclusion::SetSources(Ref<rhi::Texture> depth, Ref<rhi::Texture> output) {
+    using namespace rhi;
+
+    if (depth == m_Depth && output == m_Output) {
+        return;
+    }
+
+    m_Depth = depth;
+    m_Output = output;
+    if (m_DescriptorSets[0]) {
+        m_Device->Retire(m_DescriptorSets[0]);
+        m_Device->Retire(m_DescriptorSets[1]);
+        m_DescriptorSets[0].reset();
+        m_DescriptorSets[1].reset();
+    }
+    if (!IsValid() || !m_Depth || !m_Output) {
+        return;
+    }
+
+    Resize(m_Depth->GetWidth(), m_Depth->GetHeight());
+    if (!m_HalfResolution || !m_History[0] || !m_History[1]) {
+        return;
+    }
+
+    for (uint32 i = 0; i < 2; ++i) {
+        DescriptorSetDesc desc;
+        desc.bindings = {
+            { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_Depth, m_PointSampler },
+            { 1, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_HalfResolution, nullptr },
+            { 2, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[1 - i], nullptr },
+            { 3, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[i], nullptr },
+            { 4, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Output, nullptr }
+        };
+        desc.debugName = i == 0 ? "AmbientOcclusionDescriptorSet0" : "AmbientOcclusionDescriptorSet1";
+        m_DescriptorSets[i] = m_Device->CreateDescriptorSet(desc);
+    }
+}
+
+void AmbientOcclusion::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (m_History[0] && m_History[0]->GetWidth() == width && m_History[0]->GetHeight() == height) {
+        return;
+    }
+
+    if (m_History[0]) {
+        m_Device->Retire(m_HalfResolution);
+        m_Device->Retire(m_History[0]);
+        m_Device->Retire(m_History[1]);
+    }
+
+    // Storage only: every pass reads them texel by texel
+    TextureDesc textureDesc{};
+    textureDesc.width = std::max(1u, (width + 1) / 2);
+    textureDesc.height = std::max(1u, (height + 1) / 2);
+    textureDesc.format = AO_PACKED_FORMAT;
+    textureDesc.usage = TextureUsage::Storage;
+    textureDesc.debugName = "AmbientOcclusionHalf";
+    m_HalfResolution = m_Device->CreateTexture(textureDesc);
+
+    textureDesc.width = width;
+    textureDesc.height = height;
+    textureDesc.debugName = "AmbientOcclusionHistory0";
+    m_History[0] = m_Device->CreateTexture(textureDesc);
+    textureDesc.debugName = "AmbientOcclusionHistory1";
+    m_History[1] = m_Device->CreateTexture(textureDesc);
+    if (!m_HalfResolution || !m_History[0] || !m_History[1]) {
+        METAGFX_ERROR << "Ambient occlusion: failed to create its textures";
+    }
+    m_HistoryValid = false;
+}
+
+void AmbientOcclusion::Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& projection,
+                             const glm::mat4& reprojection, bool temporal, uint32 width, uint32 height) {
+    using namespace rhi;
+
+    const Ref<DescriptorSet>& descriptorSet = m_DescriptorSets[m_Current];
+    if (!descriptorSet) {
+        return;
+    }
+
+    AmbientOcclusionPushConstants push{};
+    push.reprojection = reprojection;
+    push.unproject = glm::vec4(1.0f / projection[0][0], 1.0f / projection[1][1],
+                               projection[2][0] - projection[3][0], projection[2][1] - projection[3][1]);
+    push.depthParams = glm::vec4(projection[2][2], projection[3][2], projection[2][3], projection[3][3]);
+    push.size = glm::uvec2(m_Depth->GetWidth(), m_Depth->GetHeight());
+    if (width > 0 && height > 0) {
+        push.size = glm::uvec2(std::min(width, push.size.x), std::min(height, push.size.y));
+    }
+    push.radius = std::max(m_Settings.radius, 0.01f);
+    push.intensity = std::max(m_Settings.intensity, 0.0f);
+
+    // A history of another region size is of another image scale
+    if (push.size != m_HistorySize) {
+        m_HistoryValid = false;
+    }
+    if (temporal) {
+        push.frame = ++m_FrameCounter;
+        push.historyWeight = m_HistoryValid ? std::clamp(m_Settings.historyWeight, 0.0f, 0.98f) : 0.0f;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, descriptorSet, frameIndex);
+
+    // The half-resolution texture and the histories are not in the frame's graph: the
+    // last frame's passes wrote and read them
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 0;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    uint32 halfWidth = (push.size.x + 1) / 2;
+    uint32 halfHeight = (push.size.y + 1) / 2;
+    cmd.Dispatch((halfWidth + AO_GROUP_SIZE - 1) / AO_GROUP_SIZE, (halfHeight + AO_GROUP_SIZE - 1) / AO_GROUP_SIZE);
+
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 1;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch((push.size.x + AO_GROUP_SIZE - 1) / AO_GROUP_SIZE, (push.size.y + AO_GROUP_SIZE - 1) / AO_GROUP_SIZE);
+
+    m_Current = 1 - m_Current;
+    m_HistorySize = push.size;
+    m_HistoryValid = temporal;
+}
+
+} // namespace metagfx
@@ -0,0 +1,263 @@
+// ============================================================================
+// src/scene/Animation.cpp
+// ============================================================================
+#include "metagfx/scene/Animation.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/scene/ModelCache.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metagfx {
+
+// ----------------------------------------------------------------------------
+// Quaternions (xyzw in a vec4)
+// ----------------------------------------------------------------------------
+
+static glm::vec4 Slerp(const glm::vec4& a, glm::vec4 b, float t) {
+    float cosAngle = glm::dot(a, b);
+    if (cosAngle < 0.0f) {  // The shorter way round
+        b = -b;
+        cosAngle = -cosAngle;
+    }
+    if (cosAngle > 0.9995f) {  // Nearly parallel: a normalized lerp is as good
+        return glm::normalize(a + (b - a) * t);
+    }
+    float angle = std::acos(cosAngle);
+    float sinAngle = std::sin(angle);
+    return (a * std::sin((1.0f - t) * angle) + b * std::sin(t * angle)) / sinAngle;
+}
+
+static glm::mat3 RotationMatrix(const glm::vec4& q) {
+    float x = q.x, y = q.y, z = q.z, w = q.w;
+    return glm::mat3(glm::vec3(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y)),
+                     glm::vec3(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x)),
+                     glm::vec3(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y)));
+}
+
+// Of a pure rotation matrix (Shepperd's method: the largest diagonal term is divided by)
+static glm::vec4 RotationQuaternion(const glm::mat3& m) {
+    float trace = m[0][0] + m[1][1] + m[2][2];
+    glm::vec4 q;
+    if (trace > 0.0f) {
+        float s = 2.0f * std::sqrt(trace + 1.0f);
+        q = glm::vec4((m[1][2] - m[2][1]) / s, (m[2][0] - m[0][2]) / s, (m[0][1] - m[1][0]) / s, 0.25f * s);
+    } else if (m[0][0] > m[1][1] && m[0][0] > m[2][2]) {
+        float s = 2.0f * std::sqrt(1.0f + m[0][0] - m[1][1] - m[2][2]);
+        q = glm::vec4(0.25f * s, (m[1][0] + m[0][1]) / s, (m[2][0] + m[0][2]) / s, (m[1][2] - m[2][1]) / s);
+    } else if (m[1][1] > m[2][2]) {
+        float s = 2.0f * std::sqrt(1.0f + m[1][1] - m[0][0] - m[2][2]);
+        q = glm::vec4((m[1][0] + m[0][1]) / s, 0.25f * s, (m[2][1] + m[1][2]) / s, (m[2][0] - m[0][2]) / s);
+    } else {
+        float s = 2.0f * std::sqrt(1.0f + m[2][2] - m[0][0] - m[1][1]);
+        q = glm::vec4((m[2][0] + m[0][2]) / s, (m[2][1] + m[1][2]) / s, 0.25f * s, (m[0][1] - m[1][0]) / s);
+    }
+    return glm::normalize(q);
+}
+
+// ----------------------------------------------------------------------------
+// Sampling
+// ----------------------------------------------------------------------------
+
+// Keys around time and the blend between them; the ends hold outside the keys
+static void FindKeys(const std::vector<float>& times, float time, size_t& outFirst, size_t& outSecond, float& outBlend) {
+    auto next = std::upper_bound(times.begin(), times.end(), time);
+    if (next == times.begin()) {
+        outFirst = outSecond = 0;
+        outBlend = 0.0f;
+        return;
+    }
+    if (next == times.end()) {
+        outFirst = outSecond = times.size() - 1;
+        outBlend = 0.0f;
+        return;
+    }
+    outSecond = static_cast<size_t>(next - times.begin());
+    outFirst = outSecond - 1;
+    float span = times[outSecond] - times[outFirst];
+    outBlend = span > 0.0f ? (time - times[outFirst]) / span : 0.0f;
+}
+
+// ----------------------------------------------------------------------------
+// Animator
+// ----------------------------------------------------------------------------
+
+Animator::Animator(const Model& model) : m_Model(model) {
+    uint32 nodeCount = model.GetNodeCount();
+    m_BindPoses.resize(nodeCount);
+    m_Local.resize(nodeCount);
+    m_World.resize(nodeCount);
+    for (uint32 node = 0; node < nodeCount; ++node) {
+        const glm::mat4& local = model.GetNodeLocalTransform(node);
+        m_Local[node] = local;
+
+        Pose& pose = m_BindPoses[node];
+        pose.translation = glm::vec3(local[3]);
+        glm::mat3 rotation(local);
+        for (int column = 0; column < 3; ++column) {
+            pose.scale[column] = glm::length(rotation[column]);
+            if (pose.scale[column] > 0.0f) {
+                rotation[column] /= pose.scale[column];
+            }
+        }
+        if (glm::dot(glm::cross(rotation[0], rotation[1]), rotation[2]) < 0.0f) {  // Mirrored
+            pose.scale.x = -pose.scale.x;
+            rotation[0] = -rotation[0];
+        }
+        pose.rotation = RotationQuaternion(rotation);
+    }
+
+    const auto& deformed = model.GetDeformedMeshes();
+    const auto& skins = model.GetSkins();
+    m_PaletteOffsets.push_back(0);
+    m_WeightOffsets.push_back(0);
+    for (const DeformedMesh& mesh : deformed) {
+        uint32 joints = mesh.skin < skins.size() ? static_cast<uint32>(skins[mesh.skin].joints.size()) : 0;
+        m_PaletteOffsets.push_back(m_PaletteOffsets.back() + joints);
+        m_WeightOffsets.push_back(m_WeightOffsets.back() + mesh.morphTargetCount);
+    }
+    m_Palettes.resize(m_PaletteOffsets.back(), glm::mat4(1.0f));
+    m_MorphWeights.resize(m_WeightOffsets.back(), 0.0f);
+
+    Evaluate();
+}
+
+void Animator::Play(uint32 clip) {
+    m_Clip = clip < m_Model.GetAnimations().size() ? clip : NO_CLIP;
+    m_Time = 0.0f;
+
+    m_AnimatedNodes.clear();
+    if (m_Clip != NO_CLIP) {
+        for (const AnimationChannel& channel : m_Model.GetAnimations()[m_Clip].channels) {
+            if (channel.path != AnimationPath::Weights && channel.node < m_Local.size()) {
+                m_AnimatedNodes.push_back(channel.node);
+            }
+        }
+        std::sort(m_AnimatedNodes.begin(), m_AnimatedNodes.end());
+        m_AnimatedNodes.erase(std::unique(m_AnimatedNodes.begin(), m_AnimatedNodes.end()), m_AnimatedNodes.end());
+    }
+
+    // Nodes the last clip left posed go back to the model's
+    for (uint32 node = 0; node < m_Local.size(); ++node) {
+        m_Local[node] = m_Model.GetNodeLocalTransform(node);
+    }
+    Evaluate();
+}
+
+void Animator::Update(float deltaTime) {
+    if (m_Clip != NO_CLIP && !m_Paused) {
+        float duration = m_Model.GetAnimations()[m_Clip].duration;
+        m_Time = duration > 0.0f ? std::fmod(m_Time + deltaTime * m_Speed, duration) : 0.0f;
+        if (m_Time < 0.0f) {
+            m_Time += duration;
+        }
+    }
+    Evaluate();
+}
+
+void Animator::UpdateAll(std::span<Animator* const> animators, float deltaTime) {
+    METAGFX_PROFILE_SCOPE("Animation");
+    if (animators.size() < 2 || JobSystem::GetWorkerCount() == 0) {
+        for (Animator* animator : animators) {
+            animator->Update(deltaTime);
+        }
+        return;
+    }
+    JobSystem::ParallelFor(static_cast<uint32>(animators.size()), 1, [&](uint32 begin, uint32 end) {
+        for (uint32 i = begin; i < end; ++i) {
+            animators[i]->Update(deltaTime);
+        }
+    });
+}
+
+void Animator::Evaluate() {
+    const auto& deformed = m_Model.GetDeformedMeshes();
+    for (size_t i = 0; i < deformed.size(); ++i) {
+        std::copy(deformed[i].morphWeights.begin(), deformed[i].morphWeights.end(),
+                  m_MorphWeights.begin() + m_WeightOffsets[i]);
+    }
+
+    // Channels of the clip over the bind poses of the nodes it drives
+    if (m_Clip != NO_CLIP) {
+        m_Poses.resize(m_AnimatedNodes.size());
+        for (size_t i = 0; i < m_AnimatedNodes.size(); ++i) {
+            m_Poses[i] = m_BindPoses[m_AnimatedNodes[i]];
+        }
+
+        for (const AnimationChannel& channel : m_Model.GetAnimations()[m_Clip].channels) {
+            if (channel.times.empty() || channel.node >= m_Local.size()) {
+                continue;
+            }
+            size_t first, second;
+            float blend;
+            FindKeys(channel.times, m_Time, first, second, blend);
+
+            if (channel.path == AnimationPath::Weights) {
+                for (size_t mesh = 0; mesh < deformed.size(); ++mesh) {
+                    if (deformed[mesh].node != channel.node) {
+                        continue;
+                    }
+                    uint32 count = std::min(channel.weightCount, deformed[mesh].morphTargetCount);
+                    for (uint32 target = 0; target < count; ++target) {
+                        float a = channel.weights[first * channel.weightCount + target];
+                        float b = channel.weights[second * channel.weightCount + target];
+                        m_MorphWeights[m_WeightOffsets[mesh] + target] = a + (b - a) * blend;
+                    }
+                }
+                continue;
+            }
+
+            auto it = std::lower_bound(m_AnimatedNodes.begin(), m_AnimatedNodes.end(), channel.node);
+            Pose& pose = m_Poses[static_cast<size_t>(it - m_AnimatedNodes.begin())];
+            const glm::vec4& a = channel.values[first];
+            const glm::vec4& b = channel.values[second];
+            switch (channel.path) {
+                case AnimationPath::Translation: pose.translation = glm::vec3(a + (b - a) * blend); break;
+                case AnimationPath::Rotation:    pose.rotation = Slerp(a, b, blend); break;
+                case AnimationPath::Scale:       pose.scale = glm::vec3(a + (b - a) * blend); break;
+                default: break;
+            }
+        }
+
+        for (size_t i = 0; i < m_AnimatedNodes.size(); ++i) {
+            const Pose& pose = m_Poses[i];
+            glm::mat3 rotation = RotationMatrix(glm::normalize(pose.rotation));
+            glm::mat4& local = m_Local[m_AnimatedNodes[i]];
+            local = glm::mat4(glm::vec4(rotation[0] * pose.scale.x, 0.0f), glm::vec4(rotation[1] * pose.scale.y, 0.0f),
+                              glm::vec4(rotation[2] * pose.scale.z, 0.0f), glm::vec4(pose.translation, 1.0f));
+        }
+    }
+
+    // Parents precede their children
+    for (uint32 node = 0; node < m_Local.size(); ++node) {
+        uint32 parent = m_Model.GetNodeParent(node);
+        m_World[node] = parent == NodeData::NO_PARENT ? m_Local[node] : m_World[parent] * m_Local[node];
+    }
+
+    const auto& skins = m_Model.GetSkins();
+    for (size_t i = 0; i < deformed.size(); ++i) {
+        if (deformed[i].skin >= skins.size()) {
+            continue;
+        }
+        const Skin& skin = skins[deformed[i].skin];
+        glm::mat4 meshInverse = glm::inverse(m_World[deformed[i].node]);
+        glm::mat4* palette = &m_Palettes[m_PaletteOffsets[i]];
+        for (size_t joint = 0; joint < skin.joints.size(); ++joint) {
+            palette[joint] = meshInverse * m_World[skin.joints[joint]] * skin.inverseBindMatrices[joint];
+        }
+    }
+}
+
+std::span<const glm::mat4> Animator::GetPalette(uint32 index) const {
+    return std::span<const glm::mat4>(m_Palettes).subspan(m_PaletteOffsets[index],
+                                                          m_PaletteOffsets[index + 1] - m_PaletteOffsets[index]);
+}
+
+std::span<const float> Animator::GetMorphWeights(uint32 index) const {
+    return std::span<const float>(m_MorphWeights).subspan(m_WeightOffsets[index],
+                                                          m_WeightOffsets[index + 1] - m_WeightOffsets[index]);
+}
+
+} // namespace metagfx
@@ -0,0 +1,143 @@
+// ============================================================================
+// src/scene/AutoExposure.cpp
+// ============================================================================
+#include "metagfx/scene/AutoExposure.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <cmath>
+
+namespace metagfx {
+
+// Must match local_size_x/y of auto_exposure.comp
+constexpr uint32 EXPOSURE_GROUP_SIZE = 16;
+
+// Push constants of auto_exposure.comp
+struct AutoExposureConstants {
+    uint32 pass;              // 0 = histogram, 1 = average and adapt
+    uint32 width;             // Of the sampled grid
+    uint32 height;
+    float minLogLuminance;
+    float logLuminanceRange;
+    float adaptation;         // Fraction of the way to the measured luminance
+    uint32 padding[2];
+};
+
+AutoExposure::AutoExposure(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    BufferDesc histogramDesc{};
+    histogramDesc.size = HISTOGRAM_BINS * sizeof(uint32);
+    histogramDesc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    histogramDesc.memoryUsage = MemoryUsage::GPUOnly;
+    histogramDesc.debugName = "LuminanceHistogram";
+    m_Histogram = device->CreateBuffer(histogramDesc);
+
+    BufferDesc stateDesc{};
+    stateDesc.size = sizeof(ExposureState);
+    stateDesc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    stateDesc.memoryUsage = MemoryUsage::GPUOnly;
+    stateDesc.debugName = "ExposureState";
+    m_ExposureState = device->CreateBuffer(stateDesc);
+
+    if (!m_Histogram || !m_ExposureState) {
+        METAGFX_ERROR << "Auto exposure unavailable: failed to create its buffers";
+        return;
+    }
+    // The adaptation pass clears the histogram after reading it, so it starts at zero;
+    // the state starts at an exposure of 1
+    std::vector<uint32> zeroBins(HISTOGRAM_BINS, 0);
+    m_Histogram->CopyData(zeroBins.data(), histogramDesc.size);
+    ExposureState initialState{ 0.18f, 1.0f };
+    m_ExposureState->CopyData(&initialState, sizeof(initialState));
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The scene color comes with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Histogram, nullptr, nullptr },
+        { 2, DescriptorType::StorageBuffer, ShaderStage::Compute, m_ExposureState, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "AutoExposureLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(AutoExposureConstants);
+    pipelineDesc.debugName = "AutoExposurePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Auto exposure unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Auto exposure created: " << HISTOGRAM_BINS << "-bin luminance histogram";
+}
+
+void AutoExposure::SetSource(Ref<rhi::Texture> sceneColor) {
+    using namespace rhi;
+
+    if (sceneColor == m_SceneColor) {
+        return;
+    }
+
+    if (m_DescriptorSet) {
+        m_Device->Retire(m_DescriptorSet);
+        m_DescriptorSet.reset();
+    }
+    m_SceneColor = sceneColor;
+    if (!IsValid() || !m_SceneColor) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_SceneColor, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Histogram, nullptr, nullptr },
+        { 2, DescriptorType::StorageBuffer, ShaderStage::Compute, m_ExposureState, nullptr, nullptr }
+    };
+    desc.debugName = "AutoExposureDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void AutoExposure::Measure(rhi::CommandBuffer& cmd, uint32 frameIndex, float deltaTime) {
+    using namespace rhi;
+
+    if (!m_DescriptorSet) {
+        return;
+    }
+
+    AutoExposureConstants push{};
+    push.width = (m_SceneColor->GetWidth() + 1) / 2;
+    push.height = (m_SceneColor->GetHeight() + 1) / 2;
+    push.minLogLuminance = m_Settings.minLogLuminance;
+    push.logLuminanceRange = std::max(m_Settings.maxLogLuminance - m_Settings.minLogLuminance, 1.0f);
+    push.adaptation = 1.0f - std::exp(-std::max(deltaTime, 0.0f) * m_Settings.adaptationRate);
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+
+    push.pass = 0;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch((push.width + EXPOSURE_GROUP_SIZE - 1) / EXPOSURE_GROUP_SIZE,
+                 (push.height + EXPOSURE_GROUP_SIZE - 1) / EXPOSURE_GROUP_SIZE);
+
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 1;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(1, 1);
+}
+
+} // namespace metagfx
@@ -0,0 +1,456 @@
+// ============================================================================
+// src/scene/BVH.cpp
+// ============================================================================
+#include "metagfx/scene/BVH.h"
+#include "metagfx/core/SimdMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace metagfx {
+
+// Deep enough for any balanced tree a 32-bit proxy id can address
+static constexpr uint32 QUERY_STACK_SIZE = 256;
+
+// ----------------------------------------------------------------------------
+// AABB
+// ----------------------------------------------------------------------------
+
+float AABB::GetSurfaceArea() const {
+    glm::vec3 extent = GetExtent();
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+bool AABB::Contains(const AABB& other) const {
+    return min.x <= other.min.x && min.y <= other.min.y && min.z <= other.min.z &&
+           max.x >= other.max.x && max.y >= other.max.y && max.z >= other.max.z;
+}
+
+bool AABB::Overlaps(const AABB& other) const {
+    return min.x <= other.max.x && max.x >= other.min.x &&
+           min.y <= other.max.y && max.y >= other.min.y &&
+           min.z <= other.max.z && max.z >= other.min.z;
+}
+
+AABB AABB::Union(const AABB& a, const AABB& b) {
+    AABB result;
+    result.min = glm::min(a.min, b.min);
+    result.max = glm::max(a.max, b.max);
+    return result;
+}
+
+AABB AABB::Transform(const AABB& box, const glm::mat4& matrix) {
+    AABB result;
+    simd::TransformBox(matrix, box.min, box.max, result.min, result.max);
+    return result;
+}
+
+bool AABB::IntersectsRay(const glm::vec3& origin, const glm::vec3& inverseDirection, float maxT,
+                         float& outT) const {
+    // Slabs; an infinite inverse (axis-parallel ray) yields +-inf distances that fall out
+    float tNear = 0.0f;
+    float tFar = maxT;
+    for (int axis = 0; axis < 3; ++axis) {
+        float t0 = (min[axis] - origin[axis]) * inverseDirection[axis];
+        float t1 = (max[axis] - origin[axis]) * inverseDirection[axis];
+        if (t0 > t1) {
+            std::swap(t0, t1);
+        }
+        tNear = std::max(tNear, t0);
+        tFar = std::min(tFar, t1);
+        if (tNear > tFar) {
+            return false;
+        }
+    }
+    outT = tNear;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// BVH
+// ----------------------------------------------------------------------------
+
+// Leaves are stored enlarged so small motions stay inside and need no reinsertion
+static AABB Fatten(const AABB& bounds) {
+    glm::vec3 margin = bounds.GetExtent() * 0.1f + glm::vec3(0.01f);
+    AABB fat;
+    fat.min = bounds.min - margin;
+    fat.max = bounds.max + margin;
+    return fat;
+}
+
+uint32 BVH::AllocateNode() {
+    if (m_FreeList == INVALID_PROXY) {
+        m_Nodes.emplace_back();
+        return static_cast<uint32>(m_Nodes.size() - 1);
+    }
+
+    uint32 node = m_FreeList;
+    m_FreeList = m_Nodes[node].parent;
+    m_Nodes[node] = Node{};
+    return node;
+}
+
+void BVH::FreeNode(uint32 node) {
+    m_Nodes[node].parent = m_FreeList;
+    m_Nodes[node].height = -1;
+    m_FreeList = node;
+}
+
+uint32 BVH::Insert(const AABB& bounds, uint32 userData) {
+    uint32 proxy = AllocateNode();
+    m_Nodes[proxy].bounds = Fatten(bounds);
+    m_Nodes[proxy].userData = userData;
+    InsertLeaf(proxy);
+    ++m_LeafCount;
+    return proxy;
+}
+
+void BVH::Remove(uint32 proxy) {
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --m_LeafCount;
+}
+
+bool BVH::Update(uint32 proxy, const AABB& bounds) {
+    // Keep the leaf while it still fits, unless it shrank so much the fat box is mostly air
+    AABB fat = Fatten(bounds);
+    const AABB& current = m_Nodes[proxy].bounds;
+    if (current.Contains(bounds) && current.GetSurfaceArea() <= 4.0f * fat.GetSurfaceArea()) {
+        return false;
+    }
+
+    RemoveLeaf(proxy);
+    m_Nodes[proxy].bounds = fat;
+    InsertLeaf(proxy);
+    return true;
+}
+
+void BVH::Clear() {
+    m_Nodes.clear();
+    m_Root = INVALID_PROXY;
+    m_FreeList = INVALID_PROXY;
+    m_LeafCount = 0;
+}
+
+uint32 BVH::GetHeight() const {
+    return m_Root == INVALID_PROXY ? 0 : static_cast<uint32>(m_Nodes[m_Root].height);
+}
+
+void BVH::InsertLeaf(uint32 leaf) {
+    m_Nodes[leaf].parent = INVALID_PROXY;
+    if (m_Root == INVALID_PROXY) {
+        m_Root = leaf;
+        return;
+    }
+
+    // Descend towards the sibling with the lowest surface area cost
+    AABB leafBounds = m_Nodes[leaf].bounds;
+    uint32 index = m_Root;
+    while (!m_Nodes[index].IsLeaf()) {
+        const Node& node = m_Nodes[index];
+        float area = node.bounds.GetSurfaceArea();
+        float combinedArea = AABB::Union(node.bounds, leafBounds).GetSurfaceArea();
+
+        // Making a new parent here, versus pushing the leaf further down
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto descendCost = [&](uint32 child) {
+            const Node& childNode = m_Nodes[child];
+            float unionArea = AABB::Union(childNode.bounds, leafBounds).GetSurfaceArea();
+            float childCost = childNode.IsLeaf() ? unionArea : unionArea - childNode.bounds.GetSurfaceArea();
+            return childCost + inheritanceCost;
+        };
+        float cost1 = descendCost(node.child1);
+        float cost2 = descendCost(node.child2);
+
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    uint32 sibling = index;
+    uint32 oldParent = m_Nodes[sibling].parent;
+    uint32 newParent = AllocateNode();
+    m_Nodes[newParent].parent = oldParent;
+    m_Nodes[newParent].bounds = AABB::Union(leafBounds, m_Nodes[sibling].bounds);
+    m_Nodes[newParent].height = m_Nodes[sibling].height + 1;
+    m_Nodes[newParent].child1 = sibling;
+    m_Nodes[newParent].child2 = leaf;
+    m_Nodes[sibling].parent = newParent;
+    m_Nodes[leaf].parent = newParent;
+
+    if (oldParent == INVALID_PROXY) {
+        m_Root = newParent;
+    } else if (m_Nodes[oldParent].child1 == sibling) {
+        m_Nodes[oldParent].child1 = newParent;
+    } else {
+        m_Nodes[oldParent].child2 = newParent;
+    }
+
+    // Refit and rebalance up to the root
+    index = m_Nodes[leaf].parent;
+    while (index != INVALID_PROXY) {
+        index = Balance(index);
+        Node& node = m_Nodes[index];
+        node.height = 1 + std::max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+        node.bounds = AABB::Union(m_Nodes[node.child1].bounds, m_Nodes[node.child2].bounds);
+        index = node.parent;
+    }
+}
+
+void BVH::RemoveLeaf(uint32 leaf) {
+    if (leaf == m_Root) {
+        m_Root = INVALID_PROXY;
+        return;
+    }
+
+    uint32 parent = m_Nodes[leaf].parent;
+    uint32 grandParent = m_Nodes[parent].parent;
+    uint32 sibling = m_Nodes[parent].child1 == leaf ? m_Nodes[parent].child2 : m_Nodes[parent].child1;
+
+    if (grandParent == INVALID_PROXY) {
+        m_Root = sibling;
+        m_Nodes[sibling].parent = INVALID_PROXY;
+        FreeNode(parent);
+        return;
+    }
+
+    // The sibling takes the parent's place
+    if (m_Nodes[grandParent].child1 == parent) {
+        m_Nodes[grandParent].child1 = sibling;
+    } else {
+        m_Nodes[grandParent].child2 = sibling;
+    }
+    m_Nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    uint32 index = grandParent;
+    while (index != INVALID_PROXY) {
+        index = Balance(index);
+        Node& node = m_Nodes[index];
+        node.height = 1 + std::max(m_Nodes[node.child1].height, m_Nodes[node.child2].height);
+        node.bounds = AABB::Union(m_Nodes[node.child1].bounds, m_Nodes[node.child2].bounds);
+        index = node.parent;
+    }
+}
+
+uint32 BVH::Balance(uint32 iA) {
+    // Rotate the taller grandchild up when the children's heights differ by more than 1
+    Node& A = m_Nodes[iA];
+    if (A.IsLeaf() || A.height < 2) {
+        return iA;
+    }
+
+    uint32 iB = A.child1;
+    uint32 iC = A.child2;
+    Node& B = m_Nodes[iB];
+    Node& C = m_Nodes[iC];
+    int32 balance = C.height - B.height;
+
+    auto replaceChild = [this](uint32 parent, uint32 oldChild, uint32 newChild) {
+        if (parent == INVALID_PROXY) {
+            m_Root = newChild;
+        } else if (m_Nodes[parent].child1 == oldChild) {
+            m_Nodes[parent].child1 = newChild;
+        } else {
+            m_Nodes[parent].child2 = newChild;
+        }
+    };
+
+    if (balance > 1) {
+        // C moves up
+        uint32 iF = C.child1;
+        uint32 iG = C.child2;
+        Node& F = m_Nodes[iF];
+        Node& G = m_Nodes[iG];
+
+        C.child1 = iA;
+        C.parent = A.parent;
+        A.parent = iC;
+        replaceChild(C.parent, iA, iC);
+
+        if (F.height > G.height) {
+            C.child2 = iF;
+            A.child2 = iG;
+            G.parent = iA;
+            A.bounds = AABB::Union(B.bounds, G.bounds);
+            C.bounds = AABB::Union(A.bounds, F.bounds);
+            A.height = 1 + std::max(B.height, G.height);
+            C.height = 1 + std::max(A.height, F.height);
+        } else {
+            C.child2 = iG;
+            A.child2 = iF;
+            F.parent = iA;
+            A.bounds = AABB::Union(B.bounds, F.bounds);
+            C.bounds = AABB::Union(A.bounds, G.bounds);
+            A.height = 1 + std::max(B.height, F.height);
+            C.height = 1 + std::max(A.height, G.height);
+        }
+        return iC;
+    }
+
+    if (balance < -1) {
+        // B moves up
+        uint32 iD = B.child1;
+        uint32 iE = B.child2;
+        Node& D = m_Nodes[iD];
+        Node& E = m_Nodes[iE];
+
+        B.child1 = iA;
+        B.parent = A.parent;
+        A.parent = iB;
+        replaceChild(B.parent, iA, iB);
+
+        if (D.height > E.height) {
+            B.child2 = iD;
+            A.child1 = iE;
+            E.parent = iA;
+            A.bounds = AABB::Union(C.bounds, E.bounds);
+            B.bounds = AABB::Union(A.bounds, D.bounds);
+            A.height = 1 + std::max(C.height, E.height);
+            B.height = 1 + std::max(A.height, D.height);
+        } else {
+            B.child2 = iE;
+            A.child1 = iD;
+            D.parent = iA;
+            A.bounds = AABB::Union(C.bounds, D.bounds);
+            B.bounds = AABB::Union(A.bounds, E.bounds);
+            A.height = 1 + std::max(C.height, D.height);
+            B.height = 1 + std::max(A.height, E.height);
+        }
+        return iB;
+    }
+
+    return iA;
+}
+
+void BVH::CollectLeaves(uint32 node, std::vector<uint32>& outProxies) const {
+    uint32 stack[QUERY_STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = node;
+    while (stackSize > 0) {
+        const Node& current = m_Nodes[stack[--stackSize]];
+        if (current.IsLeaf()) {
+            outProxies.push_back(static_cast<uint32>(&current - m_Nodes.data()));
+        } else {
+            stack[stackSize++] = current.child1;
+            stack[stackSize++] = current.child2;
+        }
+    }
+}
+
+void BVH::QueryFrustum(const Frustum& frustum, std::vector<uint32>& outProxies) const {
+    if (m_Root == INVALID_PROXY) {
+        return;
+    }
+
+    uint32 stack[QUERY_STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = m_Root;
+    while (stackSize > 0) {
+        uint32 index = stack[--stackSize];
+        const Node& node = m_Nodes[index];
+        if (!frustum.IntersectsBox(node.bounds.min, node.bounds.max)) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            outProxies.push_back(index);
+        } else if (frustum.ContainsBox(node.bounds.min, node.bounds.max)) {
+            CollectLeaves(index, outProxies);
+        } else {
+            stack[stackSize++] = node.child1;
+            stack[stackSize++] = node.child2;
+        }
+    }
+}
+
+void BVH::QueryBox(const AABB& box, std::vector<uint32>& outProxies) const {
+    if (m_Root == INVALID_PROXY) {
+        return;
+    }
+
+    uint32 stack[QUERY_STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = m_Root;
+    while (stackSize > 0) {
+        uint32 index = stack[--stackSize];
+        const Node& node = m_Nodes[index];
+        if (!node.bounds.Overlaps(box)) {
+            continue;
+        }
+
+        if (node.IsLeaf()) {
+            outProxies.push_back(index);
+        } else {
+            stack[stackSize++] = node.child1;
+            stack[stackSize++] = node.child2;
+        }
+    }
+}
+
+void BVH::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxT,
+                   const std::function<float(uint32 proxy, float maxT)>& visitor) const {
+    if (m_Root == INVALID_PROXY) {
+        return;
+    }
+
+    constexpr float INF = std::numeric_limits<float>::infinity();
+    glm::vec3 inverseDirection(direction.x != 0.0f ? 1.0f / direction.x : INF,
+                               direction.y != 0.0f ? 1.0f / direction.y : INF,
+                               direction.z != 0.0f ? 1.0f / direction.z : INF);
+
+    // Entries carry the distance at which the ray entered them, to skip subtrees that
+    // a hit found since then has made too far
+    struct Entry {
+        uint32 node;
+        float t;
+    };
+    Entry stack[QUERY_STACK_SIZE];
+    uint32 stackSize = 0;
+
+    float rootT = 0.0f;
+    if (!m_Nodes[m_Root].bounds.IntersectsRay(origin, inverseDirection, maxT, rootT)) {
+        return;
+    }
+    stack[stackSize++] = { m_Root, rootT };
+
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        if (entry.t > maxT) {
+            continue;
+        }
+
+        const Node& node = m_Nodes[entry.node];
+        if (node.IsLeaf()) {
+            maxT = visitor(entry.node, maxT);
+            continue;
+        }
+
+        float t1 = 0.0f;
+        float t2 = 0.0f;
+        bool hit1 = m_Nodes[node.child1].bounds.IntersectsRay(origin, inverseDirection, maxT, t1);
+        bool hit2 = m_Nodes[node.child2].bounds.IntersectsRay(origin, inverseDirection, maxT, t2);
+
+        // Push the farther child first so the nearer one is visited next
+        if (hit1 && hit2) {
+            if (t1 <= t2) {
+                stack[stackSize++] = { node.child2, t2 };
+                stack[stackSize++] = { node.child1, t1 };
+            } else {
+                stack[stackSize++] = { node.child1, t1 };
+                stack[stackSize++] = { node.child2, t2 };
+            }
+        } else if (hit1) {
+            stack[stackSize++] = { node.child1, t1 };
+        } else if (hit2) {
+            stack[stackSize++] = { node.child2, t2 };
+        }
+    }
+}
+
+} // namespace metagfx
@@ -0,0 +1,210 @@
+// ============================================================================
+// src/scene/Bloom.cpp
+// ============================================================================
+#include "metagfx/scene/Bloom.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Must match local_size_x/y of bloom.comp
+constexpr uint32 BLOOM_GROUP_SIZE = 8;
+
+// Bytes per texel of the chain: RGB as half floats, padded to 8
+constexpr uint32 BLOOM_TEXEL_SIZE = 8;
+
+// Push constants of bloom.comp
+struct BloomPushConstants {
+    uint32 pass;  // BloomPass
+    uint32 srcOffset;
+    uint32 dstOffset;
+    uint32 srcWidth;
+    uint32 srcHeight;
+    uint32 dstWidth;
+    uint32 dstHeight;
+    uint32 padding0;
+    float sceneWeight;
+    float bloomWeight;
+    uint32 padding1[2];
+};
+
+enum BloomPass : uint32 {
+    BLOOM_DOWNSAMPLE_SCENE = 0,
+    BLOOM_DOWNSAMPLE = 1,
+    BLOOM_UPSAMPLE = 2,
+    BLOOM_COMPOSITE = 3
+};
+
+Bloom::Bloom(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    // The scene color and the chain come with the first frame; the pipeline only needs
+    // the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "BloomLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(BloomPushConstants);
+    pipelineDesc.debugName = "BloomPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Bloom unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Bloom created: up to " << MAX_LEVELS << " levels";
+}
+
+void Bloom::SetSource(Ref<rhi::Texture> sceneColor) {
+    using namespace rhi;
+
+    if (sceneColor == m_SceneColor) {
+        return;
+    }
+
+    m_SceneColor = sceneColor;
+    if (m_DescriptorSet) {
+        m_Device->Retire(m_DescriptorSet);
+        m_DescriptorSet.reset();
+    }
+    if (!IsValid() || !m_SceneColor) {
+        return;
+    }
+
+    Resize(m_SceneColor->GetWidth(), m_SceneColor->GetHeight());
+    if (!m_Chain) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_SceneColor, nullptr },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Chain, nullptr, nullptr }
+    };
+    desc.debugName = "BloomDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void Bloom::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (width == m_Width && height == m_Height && m_Chain) {
+        return;
+    }
+    m_Width = width;
+    m_Height = height;
+
+    // Level 0 halves the scene color, each further level halves the previous one
+    // (rounding up), while both sides stay above one texel
+    m_Levels.clear();
+    uint32 levelWidth = std::max(1u, (width + 1) / 2);
+    uint32 levelHeight = std::max(1u, (height + 1) / 2);
+    uint32 offset = 0;
+    while (m_Levels.size() < MAX_LEVELS) {
+        m_Levels.push_back({ offset, levelWidth, levelHeight });
+        offset += levelWidth * levelHeight;
+        if (levelWidth <= 2 || levelHeight <= 2) {
+            break;
+        }
+        levelWidth = (levelWidth + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+
+    BufferDesc chainDesc{};
+    chainDesc.size = static_cast<uint64>(offset) * BLOOM_TEXEL_SIZE;
+    chainDesc.usage = BufferUsage::Storage;
+    chainDesc.memoryUsage = MemoryUsage::GPUOnly;
+    chainDesc.debugName = "BloomChain";
+    Ref<Buffer> chain = m_Device->CreateBuffer(chainDesc);
+    if (!chain) {
+        METAGFX_ERROR << "Bloom: failed to create its mip chain";
+    }
+
+    if (m_Chain) {
+        m_Device->Retire(m_Chain);
+    }
+    m_Chain = chain;
+}
+
+void Bloom::Apply(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    using namespace rhi;
+
+    if (!m_DescriptorSet || m_Levels.empty()) {
+        return;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+
+    auto dispatch = [&](BloomPushConstants& push) {
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((push.dstWidth + BLOOM_GROUP_SIZE - 1) / BLOOM_GROUP_SIZE,
+                     (push.dstHeight + BLOOM_GROUP_SIZE - 1) / BLOOM_GROUP_SIZE);
+    };
+
+    // Down the chain
+    for (size_t level = 0; level < m_Levels.size(); ++level) {
+        const Level& dst = m_Levels[level];
+        BloomPushConstants push{};
+        push.dstOffset = dst.offset;
+        push.dstWidth = dst.width;
+        push.dstHeight = dst.height;
+        if (level == 0) {
+            push.pass = BLOOM_DOWNSAMPLE_SCENE;
+            push.srcWidth = m_Width;
+            push.srcHeight = m_Height;
+        } else {
+            const Level& src = m_Levels[level - 1];
+            push.pass = BLOOM_DOWNSAMPLE;
+            push.srcOffset = src.offset;
+            push.srcWidth = src.width;
+            push.srcHeight = src.height;
+            cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        }
+        dispatch(push);
+    }
+
+    // Back up, each level gathering the ones below it
+    for (size_t level = m_Levels.size() - 1; level > 0; --level) {
+        const Level& src = m_Levels[level];
+        const Level& dst = m_Levels[level - 1];
+        BloomPushConstants push{};
+        push.pass = BLOOM_UPSAMPLE;
+        push.srcOffset = src.offset;
+        push.srcWidth = src.width;
+        push.srcHeight = src.height;
+        push.dstOffset = dst.offset;
+        push.dstWidth = dst.width;
+        push.dstHeight = dst.height;
+        cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        dispatch(push);
+    }
+
+    // Level 0 holds the sum of every level; its mean is what replaces part of the scene
+    const Level& top = m_Levels[0];
+    float strength = std::clamp(m_Settings.strength, 0.0f, 1.0f);
+    BloomPushConstants push{};
+    push.pass = BLOOM_COMPOSITE;
+    push.srcOffset = top.offset;
+    push.srcWidth = top.width;
+    push.srcHeight = top.height;
+    push.dstWidth = m_Width;
+    push.dstHeight = m_Height;
+    push.sceneWeight = 1.0f - strength;
+    push.bloomWeight = strength / static_cast<float>(m_Levels.size());
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    dispatch(push);
+}
+
+} // namespace metagfx
@@ -3,6 +3,7 @@
 // ============================================================================
 #include "metagfx/scene/Camera.h"
 #include <SDL3/SDL.h>
+#include <cmath>
 
 namespace metagfx {
 
@@ -21,11 +22,17 @@ void Camera::SetPerspective(float fov, float aspectRatio, float nearPlane, float
     m_NearPlane = nearPlane;
     m_FarPlane = farPlane;
     
-    m_ProjectionMatrix = glm::perspective(glm::radians(fov), aspectRatio, nearPlane, farPlane);
-    
-    // GLM was originally designed for OpenGL, where the Y coordinate of the clip coordinates is inverted
-    // For Vulkan, we need to flip the Y axis
-    m_ProjectionMatrix[1][1] *= -1;
+    // Reverse-Z with an infinite far plane: clip z is the near plane's distance, w the
+    // view depth, so depth is nearPlane / viewDepth, 1 at the near plane and toward 0 with
+    // distance. Float depth keeps its precision over the whole range that way; farPlane
+    // only bounds the shadow cascades and light clusters. Y is flipped for Vulkan.
+    float tanHalfFov = std::tan(glm::radians(fov) * 0.5f);
+    m_UnjitteredProjectionMatrix = glm::mat4(0.0f);
+    m_UnjitteredProjectionMatrix[0][0] = 1.0f / (aspectRatio * tanHalfFov);
+    m_UnjitteredProjectionMatrix[1][1] = -1.0f / tanHalfFov;
+    m_UnjitteredProjectionMatrix[2][3] = -1.0f;
+    m_UnjitteredProjectionMatrix[3][2] = nearPlane;
+    UpdateProjectionMatrix();
 }
 
 void Camera::SetOrthographic(float left, float right, float bottom, float top, 
@@ -38,8 +45,25 @@ void Camera::SetOrthographic(float left, float right, float bottom, float top,
     m_NearPlane = nearPlane;
     m_FarPlane = farPlane;
     
-    m_ProjectionMatrix = glm::ortho(left, right, bottom, top, nearPlane, farPlane);
-    m_ProjectionMatrix[1][1] *= -1; // Flip Y for Vulkan
+    // Reverse-Z like the perspective projection: [0, 1] depth from the far plane to the
+    // near one, which orthoRH_ZO gives with the planes swapped
+    m_UnjitteredProjectionMatrix = glm::orthoRH_ZO(left, right, bottom, top, farPlane, nearPlane);
+    m_UnjitteredProjectionMatrix[1][1] *= -1; // Flip Y for Vulkan
+    UpdateProjectionMatrix();
+}
+
+void Camera::SetJitter(const glm::vec2& jitter) {
+    m_Jitter = jitter;
+    UpdateProjectionMatrix();
+}
+
+void Camera::UpdateProjectionMatrix() {
+    // A translation after the projection shifts every vertex by the same NDC offset,
+    // for perspective and orthographic projections alike
+    m_ProjectionMatrix = m_UnjitteredProjectionMatrix;
+    if (m_Jitter != glm::vec2(0.0f)) {
+        m_ProjectionMatrix = glm::translate(glm::mat4(1.0f), glm::vec3(m_Jitter, 0.0f)) * m_ProjectionMatrix;
+    }
 }
 
 void Camera::SetAspectRatio(float aspectRatio) {
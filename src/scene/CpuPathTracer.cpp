@@ -0,0 +1,1044 @@
+// ============================================================================
+// src/scene/CpuPathTracer.cpp
+// ============================================================================
+#include "metagfx/scene/CpuPathTracer.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/utils/TextureUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <map>
+#include <mutex>
+
+namespace metagfx {
+
+namespace {
+
+constexpr float PI = 3.14159265359f;
+constexpr float RAY_MAX = 1.0e6f;
+constexpr float FLOAT_MAX = std::numeric_limits<float>::max();
+
+// Ranges binned by several jobs, and subtrees built as jobs of their own, from these sizes
+constexpr uint32 PARALLEL_BINNING_TRIANGLES = 64 * 1024;
+constexpr uint32 PARALLEL_SUBTREE_TRIANGLES = 4 * 1024;
+// Traversal stack entries; a four-wide tree this deep holds far more triangles than memory
+constexpr uint32 STACK_SIZE = 256;
+
+constexpr int LIGHT_TYPE_DIRECTIONAL = 0;
+constexpr int LIGHT_TYPE_SPOT = 2;
+
+double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// PCG hash (Jarzynski and Olano, "Hash Functions for GPU Rendering"), as path_trace.comp
+uint32 PcgHash(uint32 value) {
+    uint32 state = value * 747796405u + 2891336453u;
+    uint32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+float SurfaceArea(const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 extent = boxMax - boxMin;
+    if (extent.x < 0.0f || extent.y < 0.0f || extent.z < 0.0f) {
+        return 0.0f;
+    }
+    return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+}
+
+// ============================================================================
+// BRDF (model.frag's: Lambert diffuse and GGX specular), as path_trace.comp
+// ============================================================================
+
+float DistributionGGX(float NdotH, float roughness) {
+    float a = roughness * roughness;
+    float a2 = a * a;
+    float denom = NdotH * NdotH * (a2 - 1.0f) + 1.0f;
+    return a2 / std::max(PI * denom * denom, 0.0001f);
+}
+
+float GeometrySchlickGGX(float NdotV, float roughness) {
+    float r = roughness + 1.0f;
+    float k = (r * r) / 8.0f;
+    return NdotV / std::max(NdotV * (1.0f - k) + k, 0.0001f);
+}
+
+glm::vec3 FresnelSchlick(float cosTheta, const glm::vec3& F0) {
+    return F0 + (glm::vec3(1.0f) - F0) * std::pow(std::clamp(1.0f - cosTheta, 0.0f, 1.0f), 5.0f);
+}
+
+float Luminance(const glm::vec3& color) {
+    return color.x * 0.2126f + color.y * 0.7152f + color.z * 0.0722f;
+}
+
+// Orthonormal basis around a unit vector (Duff et al., "Building an Orthonormal Basis, Revisited")
+void Basis(const glm::vec3& n, glm::vec3& outT, glm::vec3& outB) {
+    float s = n.z >= 0.0f ? 1.0f : -1.0f;
+    float a = -1.0f / (s + n.z);
+    float b = n.x * n.y * a;
+    outT = glm::vec3(1.0f + s * n.x * n.x * a, s * b, -s * n.x);
+    outB = glm::vec3(b, s + n.y * n.y * a, -n.y);
+}
+
+glm::vec3 Reflect(const glm::vec3& incident, const glm::vec3& normal) {
+    return incident - normal * (2.0f * glm::dot(normal, incident));
+}
+
+// Moves a ray origin off the surface by a few ulps along the normal on the ray's side
+// (Wachter and Binder, as path_trace.comp)
+glm::vec3 OffsetRayOrigin(const glm::vec3& position, glm::vec3 normal, const glm::vec3& direction) {
+    constexpr float ORIGIN = 1.0f / 32.0f;
+    constexpr float FLOAT_SCALE = 1.0f / 65536.0f;
+    constexpr float INT_SCALE = 256.0f;
+
+    if (glm::dot(normal, direction) < 0.0f) {
+        normal = -normal;
+    }
+    glm::vec3 result;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (std::abs(position[axis]) < ORIGIN) {
+            result[axis] = position[axis] + FLOAT_SCALE * normal[axis];
+            continue;
+        }
+        float value = position[axis];
+        int32 offset = static_cast<int32>(INT_SCALE * normal[axis]);
+        int32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        bits += value < 0.0f ? -offset : offset;
+        std::memcpy(&value, &bits, sizeof(bits));
+        result[axis] = value;
+    }
+    return result;
+}
+
+// sRGB-encoded byte to linear
+const std::array<float, 256>& SrgbToLinearTable() {
+    static const std::array<float, 256> table = []() {
+        std::array<float, 256> values{};
+        for (uint32 i = 0; i < 256; ++i) {
+            float c = static_cast<float>(i) / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+} // namespace
+
+// ============================================================================
+// Helpers
+// ============================================================================
+
+struct CpuPathTracer::Surface {
+    glm::vec3 position;
+    glm::vec3 normal;          // Shading normal, facing the incoming ray
+    glm::vec3 geometryNormal;  // Of the vertex normals, for the ray offsets
+    glm::vec3 albedo;
+    float metallic;
+    float roughness;
+    glm::vec3 emissive;
+};
+
+class CpuPathTracer::Random {
+public:
+    explicit Random(uint32 seed) : m_State(seed) {}
+
+    float Next() {
+        m_State = PcgHash(m_State);
+        return static_cast<float>(m_State >> 8u) * (1.0f / 16777216.0f);
+    }
+
+    glm::vec2 Next2() {
+        float x = Next();
+        float y = Next();
+        return glm::vec2(x, y);
+    }
+
+private:
+    uint32 m_State;
+};
+
+// Triangles [begin, end) of the build order, with their bounds and their centroids' bounds
+struct CpuPathTracer::BuildRange {
+    uint32 begin = 0;
+    uint32 end = 0;
+    glm::vec3 boundsMin = glm::vec3(FLOAT_MAX);
+    glm::vec3 boundsMax = glm::vec3(-FLOAT_MAX);
+    glm::vec3 centroidMin = glm::vec3(FLOAT_MAX);
+    glm::vec3 centroidMax = glm::vec3(-FLOAT_MAX);
+
+    uint32 GetCount() const { return end - begin; }
+
+    void Add(const glm::vec3& triangleMin, const glm::vec3& triangleMax, const glm::vec3& centroid) {
+        boundsMin = glm::min(boundsMin, triangleMin);
+        boundsMax = glm::max(boundsMax, triangleMax);
+        centroidMin = glm::min(centroidMin, centroid);
+        centroidMax = glm::max(centroidMax, centroid);
+    }
+
+    void Add(const BuildRange& other) {
+        boundsMin = glm::min(boundsMin, other.boundsMin);
+        boundsMax = glm::max(boundsMax, other.boundsMax);
+        centroidMin = glm::min(centroidMin, other.centroidMin);
+        centroidMax = glm::max(centroidMax, other.centroidMax);
+    }
+};
+
+struct CpuPathTracer::BuildContext {
+    std::vector<glm::vec3> boundsMin;  // Per triangle
+    std::vector<glm::vec3> boundsMax;
+    std::vector<glm::vec3> centroids;
+    std::vector<uint32> order;         // Triangles in build order; ranges index it
+};
+
+glm::vec4 CpuPathTracer::Image::Sample(const glm::vec2& texCoord) const {
+    float x = (texCoord.x - std::floor(texCoord.x)) * static_cast<float>(width) - 0.5f;
+    float y = (texCoord.y - std::floor(texCoord.y)) * static_cast<float>(height) - 0.5f;
+    float fx = std::floor(x);
+    float fy = std::floor(y);
+    float wx = x - fx;
+    float wy = y - fy;
+    auto wrap = [](float coordinate, uint32 size) {
+        int32 i = static_cast<int32>(coordinate) % static_cast<int32>(size);
+        return static_cast<uint32>(i < 0 ? i + static_cast<int32>(size) : i);
+    };
+    uint32 x0 = wrap(fx, width), x1 = wrap(fx + 1.0f, width);
+    uint32 y0 = wrap(fy, height), y1 = wrap(fy + 1.0f, height);
+
+    const std::array<float, 256>& toLinear = SrgbToLinearTable();
+    auto texel = [&](uint32 tx, uint32 ty) {
+        const uint8* p = &texels[(static_cast<size_t>(ty) * width + tx) * 4];
+        if (srgb) {
+            return glm::vec4(toLinear[p[0]], toLinear[p[1]], toLinear[p[2]], p[3] / 255.0f);
+        }
+        return glm::vec4(p[0] / 255.0f, p[1] / 255.0f, p[2] / 255.0f, p[3] / 255.0f);
+    };
+    glm::vec4 top = glm::mix(texel(x0, y0), texel(x1, y0), wx);
+    glm::vec4 bottom = glm::mix(texel(x0, y1), texel(x1, y1), wx);
+    return glm::mix(top, bottom, wy);
+}
+
+// ============================================================================
+// Scene
+// ============================================================================
+
+bool CpuPathTracer::Build(const ModelData& model, const std::string& modelPath) {
+    METAGFX_PROFILE_SCOPE("CPU path tracer build");
+    m_Nodes.clear();
+    m_Triangles.clear();
+    m_Positions.clear();
+    m_Vertices.clear();
+    m_Indices.clear();
+    m_TriangleMaterials.clear();
+    m_Materials.clear();
+    m_Images.clear();
+    m_Stats = {};
+
+    // Parents precede their children
+    std::vector<glm::mat4> world(model.nodes.size(), glm::mat4(1.0f));
+    for (size_t i = 0; i < model.nodes.size(); ++i) {
+        const NodeData& node = model.nodes[i];
+        world[i] = node.parent == NodeData::NO_PARENT ? node.localTransform
+                                                      : world[node.parent] * node.localTransform;
+    }
+
+    // The last material stands in for meshes naming none
+    uint32 defaultMaterial = static_cast<uint32>(model.materials.size());
+    for (const MeshData& mesh : model.meshes) {
+        glm::mat4 transform = mesh.node < world.size() ? world[mesh.node] : glm::mat4(1.0f);
+        glm::mat3 linear = glm::mat3(transform);
+        glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+        uint32 base = static_cast<uint32>(m_Positions.size());
+
+        for (uint32 i = 0; i < mesh.vertexCount; ++i) {
+            const Vertex& vertex = mesh.vertices[i];
+            m_Positions.push_back(glm::vec3(transform * glm::vec4(vertex.position, 1.0f)));
+            ShadingVertex shading;
+            shading.normal = normalMatrix * vertex.normal;
+            shading.texCoord = vertex.texCoord;
+            shading.tangent = glm::vec4(linear * glm::vec3(vertex.tangent), vertex.tangent.w);
+            m_Vertices.push_back(shading);
+        }
+
+        uint32 material = mesh.materialIndex < model.materials.size() ? mesh.materialIndex : defaultMaterial;
+        for (uint32 i = 0; i + 2 < mesh.indexCount; i += 3) {
+            uint32 a = mesh.indices[i], b = mesh.indices[i + 1], c = mesh.indices[i + 2];
+            if (a >= mesh.vertexCount || b >= mesh.vertexCount || c >= mesh.vertexCount) {
+                continue;
+            }
+            m_Indices.push_back(base + a);
+            m_Indices.push_back(base + b);
+            m_Indices.push_back(base + c);
+            m_TriangleMaterials.push_back(material);
+        }
+    }
+
+    m_Stats.triangleCount = static_cast<uint32>(m_TriangleMaterials.size());
+    if (m_Stats.triangleCount == 0) {
+        METAGFX_ERROR << "CPU path tracer: the model has no triangles";
+        return false;
+    }
+
+    DecodeTextures(model, modelPath);
+    BuildBVH();
+    METAGFX_INFO << "CPU path tracer: " << m_Stats.triangleCount << " triangles, " << m_Stats.nodeCount
+                 << " BVH4 nodes in " << m_Stats.buildMs << " ms, " << m_Stats.textureCount << " textures";
+    return true;
+}
+
+void CpuPathTracer::DecodeTextures(const ModelData& model, const std::string& modelPath) {
+    std::string modelDir = std::filesystem::path(modelPath).parent_path().string();
+    if (modelDir.empty()) {
+        modelDir = ".";
+    }
+
+    // One image per (reference, color space), as the model's materials share them
+    std::map<std::pair<std::string, bool>, int32> imageIndices;
+    std::vector<std::pair<std::string, bool>> requests;
+    auto request = [&](const std::string& texPath, bool srgb) {
+        if (texPath.empty()) {
+            return NO_TEXTURE;
+        }
+        auto [it, inserted] = imageIndices.emplace(std::make_pair(texPath, srgb),
+                                                   static_cast<int32>(requests.size()));
+        if (inserted) {
+            requests.emplace_back(texPath, srgb);
+        }
+        return it->second;
+    };
+
+    // The slots Model.cpp's ProcessMaterial() fills; ambient occlusion maps are left out,
+    // since the paths find the occlusion themselves
+    for (const MaterialDesc& desc : model.materials) {
+        ShadingMaterial material;
+        material.albedo = desc.albedo;
+        material.roughness = desc.roughness;
+        material.metallic = desc.metallic;
+        material.emissiveFactor = desc.hasEmissiveFactor ? glm::max(desc.emissiveFactor, glm::vec3(0.0f))
+                                                         : glm::vec3(0.0f);
+        material.albedoMap = request(desc.albedoMap, true);
+        material.normalMap = request(desc.normalMap, false);
+        material.metallicRoughnessMap = request(!desc.packedMetallicRoughnessMap.empty()
+                                                    ? desc.packedMetallicRoughnessMap
+                                                    : desc.metallicRoughnessMap, false);
+        if (material.metallicRoughnessMap == NO_TEXTURE) {
+            material.roughnessMap = request(desc.roughnessMap, false);
+        }
+        material.emissiveMap = request(desc.emissiveMap, true);
+        m_Materials.push_back(material);
+    }
+    m_Materials.emplace_back();
+
+    m_Images.resize(requests.size());
+    JobSystem::ParallelFor(static_cast<uint32>(requests.size()), 1, [&](uint32 begin, uint32 end) {
+        for (uint32 i = begin; i < end; ++i) {
+            const auto& [texPath, srgb] = requests[i];
+            utils::ImageData image;
+            if (texPath[0] == '*') {
+                int32 index = std::atoi(texPath.c_str() + 1);
+                if (index >= 0 && static_cast<size_t>(index) < model.embeddedTextures.size()) {
+                    const EmbeddedTexture& embedded = model.embeddedTextures[index];
+                    if (embedded.width == 0 && embedded.data) {
+                        image = utils::LoadImageFromMemory(embedded.data, static_cast<uint32>(embedded.size), 4);
+                    }
+                }
+            } else {
+                image = utils::LoadImage((std::filesystem::path(modelDir) / texPath).string(), 4);
+            }
+            if (!image.pixels) {
+                METAGFX_WARN << "CPU path tracer: cannot decode " << texPath << ", using the material constant";
+                continue;
+            }
+
+            Image& decoded = m_Images[i];
+            decoded.width = image.width;
+            decoded.height = image.height;
+            decoded.srgb = srgb;
+            decoded.texels.assign(image.pixels, image.pixels + static_cast<size_t>(image.width) * image.height * 4);
+            utils::FreeImage(image);
+        }
+    });
+
+    // Slots whose image failed fall back to the constant
+    auto resolve = [&](int32& slot) {
+        if (slot != NO_TEXTURE && m_Images[slot].texels.empty()) {
+            slot = NO_TEXTURE;
+        }
+    };
+    for (ShadingMaterial& material : m_Materials) {
+        resolve(material.albedoMap);
+        resolve(material.normalMap);
+        resolve(material.metallicRoughnessMap);
+        resolve(material.roughnessMap);
+        resolve(material.emissiveMap);
+    }
+    m_Stats.textureCount = static_cast<uint32>(std::count_if(m_Images.begin(), m_Images.end(),
+                                                             [](const Image& image) { return !image.texels.empty(); }));
+}
+
+void CpuPathTracer::SetEnvironment(const glm::vec3& color) {
+    m_EnvironmentColor = color;
+    m_EnvironmentMap.clear();
+    m_EnvironmentWidth = 0;
+    m_EnvironmentHeight = 0;
+}
+
+void CpuPathTracer::SetEnvironmentMap(std::vector<float> rgb, uint32 width, uint32 height, float intensity) {
+    if (width == 0 || height == 0 || rgb.size() < static_cast<size_t>(width) * height * 3) {
+        METAGFX_ERROR << "CPU path tracer: environment map of " << rgb.size() << " floats is not " << width << "x"
+                      << height << " RGB";
+        return;
+    }
+    m_EnvironmentMap = std::move(rgb);
+    m_EnvironmentWidth = width;
+    m_EnvironmentHeight = height;
+    m_EnvironmentIntensity = intensity;
+}
+
+// ============================================================================
+// BVH
+// ============================================================================
+
+void CpuPathTracer::BuildBVH() {
+    auto startTime = std::chrono::steady_clock::now();
+    uint32 triangleCount = m_Stats.triangleCount;
+
+    BuildContext context;
+    context.boundsMin.resize(triangleCount);
+    context.boundsMax.resize(triangleCount);
+    context.centroids.resize(triangleCount);
+    context.order.resize(triangleCount);
+    m_Triangles.resize(triangleCount);
+
+    // Ranges bounds of their own, merged into the root's
+    BuildRange root;
+    root.end = triangleCount;
+    std::mutex rootMutex;
+    JobSystem::ParallelFor(triangleCount, 4096, [&](uint32 begin, uint32 end) {
+        BuildRange local;
+        for (uint32 i = begin; i < end; ++i) {
+            glm::vec3 a = m_Positions[m_Indices[i * 3]];
+            glm::vec3 b = m_Positions[m_Indices[i * 3 + 1]];
+            glm::vec3 c = m_Positions[m_Indices[i * 3 + 2]];
+            context.boundsMin[i] = glm::min(glm::min(a, b), c);
+            context.boundsMax[i] = glm::max(glm::max(a, b), c);
+            context.centroids[i] = (context.boundsMin[i] + context.boundsMax[i]) * 0.5f;
+            context.order[i] = i;
+            local.Add(context.boundsMin[i], context.boundsMax[i], context.centroids[i]);
+        }
+        std::lock_guard<std::mutex> lock(rootMutex);
+        root.Add(local);
+    });
+
+    // Every inner node has two or more children and every leaf a triangle, so there
+    // are fewer inner nodes than triangles
+    m_Nodes.resize(triangleCount + 1);
+    m_NodeCount.store(1, std::memory_order_relaxed);
+    BuildNode(context, 0, root);
+    m_Nodes.resize(m_NodeCount.load(std::memory_order_relaxed));
+
+    // Triangles in leaf order, so a leaf's are adjacent
+    JobSystem::ParallelFor(triangleCount, 4096, [&](uint32 begin, uint32 end) {
+        for (uint32 i = begin; i < end; ++i) {
+            uint32 primitive = context.order[i];
+            glm::vec3 a = m_Positions[m_Indices[primitive * 3]];
+            Triangle& triangle = m_Triangles[i];
+            triangle.v0 = a;
+            triangle.edge1 = m_Positions[m_Indices[primitive * 3 + 1]] - a;
+            triangle.edge2 = m_Positions[m_Indices[primitive * 3 + 2]] - a;
+            triangle.primitive = primitive;
+        }
+    });
+
+    m_Stats.nodeCount = static_cast<uint32>(m_Nodes.size());
+    m_Stats.buildMs = MillisecondsSince(startTime);
+}
+
+void CpuPathTracer::Split(BuildContext& context, const BuildRange& range, BuildRange& outLeft,
+                          BuildRange& outRight) {
+    struct Bin {
+        BuildRange bounds;
+        uint32 count = 0;
+    };
+    using Bins = std::array<std::array<Bin, SAH_BINS>, 3>;
+
+    glm::vec3 extent = range.centroidMax - range.centroidMin;
+    glm::vec3 scale(0.0f);
+    for (int axis = 0; axis < 3; ++axis) {
+        // Just under SAH_BINS, so the maximum centroid lands in the last bin
+        scale[axis] = extent[axis] > 0.0f ? static_cast<float>(SAH_BINS) * 0.99999f / extent[axis] : 0.0f;
+    }
+    auto binOf = [&](uint32 triangle, int axis) {
+        float offset = (context.centroids[triangle][axis] - range.centroidMin[axis]) * scale[axis];
+        return std::min(static_cast<uint32>(offset), SAH_BINS - 1);
+    };
+
+    auto binRange = [&](uint32 begin, uint32 end, Bins& bins) {
+        for (uint32 i = begin; i < end; ++i) {
+            uint32 triangle = context.order[i];
+            for (int axis = 0; axis < 3; ++axis) {
+                Bin& bin = bins[axis][binOf(triangle, axis)];
+                bin.bounds.Add(context.boundsMin[triangle], context.boundsMax[triangle], context.centroids[triangle]);
+                ++bin.count;
+            }
+        }
+    };
+
+    Bins bins{};
+    if (range.GetCount() >= PARALLEL_BINNING_TRIANGLES) {
+        std::mutex mutex;
+        JobSystem::ParallelFor(range.GetCount(), 16 * 1024, [&](uint32 begin, uint32 end) {
+            Bins local{};
+            binRange(range.begin + begin, range.begin + end, local);
+            std::lock_guard<std::mutex> lock(mutex);
+            for (int axis = 0; axis < 3; ++axis) {
+                for (uint32 b = 0; b < SAH_BINS; ++b) {
+                    bins[axis][b].bounds.Add(local[axis][b].bounds);
+                    bins[axis][b].count += local[axis][b].count;
+                }
+            }
+        });
+    } else {
+        binRange(range.begin, range.end, bins);
+    }
+
+    // Cheapest plane between bins: area times triangles on each side
+    int bestAxis = -1;
+    uint32 bestSplit = 0;
+    float bestCost = FLOAT_MAX;
+    for (int axis = 0; axis < 3; ++axis) {
+        if (scale[axis] == 0.0f) {
+            continue;
+        }
+        std::array<float, SAH_BINS> rightCost{};
+        BuildRange right;
+        uint32 rightCount = 0;
+        for (uint32 b = SAH_BINS - 1; b > 0; --b) {
+            right.Add(bins[axis][b].bounds);
+            rightCount += bins[axis][b].count;
+            rightCost[b] = rightCount > 0 ? SurfaceArea(right.boundsMin, right.boundsMax) * rightCount : -1.0f;
+        }
+        BuildRange left;
+        uint32 leftCount = 0;
+        for (uint32 b = 1; b < SAH_BINS; ++b) {
+            left.Add(bins[axis][b - 1].bounds);
+            leftCount += bins[axis][b - 1].count;
+            if (leftCount == 0 || rightCost[b] < 0.0f) {
+                continue;
+            }
+            float cost = SurfaceArea(left.boundsMin, left.boundsMax) * leftCount + rightCost[b];
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestAxis = axis;
+                bestSplit = b;
+            }
+        }
+    }
+
+    uint32* first = context.order.data() + range.begin;
+    uint32* last = context.order.data() + range.end;
+    outLeft = BuildRange{};
+    outRight = BuildRange{};
+
+    if (bestAxis >= 0) {
+        uint32* middle = std::partition(first, last, [&](uint32 triangle) { return binOf(triangle, bestAxis) < bestSplit; });
+        outLeft.begin = range.begin;
+        outLeft.end = static_cast<uint32>(middle - context.order.data());
+        for (uint32 b = 0; b < SAH_BINS; ++b) {
+            (b < bestSplit ? outLeft : outRight).Add(bins[bestAxis][b].bounds);
+        }
+    } else {
+        // Every centroid in one spot: halve the range as it is
+        outLeft.begin = range.begin;
+        outLeft.end = range.begin + range.GetCount() / 2;
+        for (uint32 i = outLeft.begin; i < range.end; ++i) {
+            uint32 triangle = context.order[i];
+            (i < outLeft.end ? outLeft : outRight)
+                .Add(context.boundsMin[triangle], context.boundsMax[triangle], context.centroids[triangle]);
+        }
+    }
+    outRight.begin = outLeft.end;
+    outRight.end = range.end;
+}
+
+void CpuPathTracer::BuildNode(BuildContext& context, uint32 nodeIndex, const BuildRange& range) {
+    // Split the child of the largest area until there are four, or none is worth it
+    std::array<BuildRange, 4> children;
+    children[0] = range;
+    uint32 childCount = 1;
+    while (childCount < 4) {
+        int widest = -1;
+        float widestArea = -1.0f;
+        for (uint32 i = 0; i < childCount; ++i) {
+            float area = SurfaceArea(children[i].boundsMin, children[i].boundsMax);
+            if (children[i].GetCount() > MAX_LEAF_TRIANGLES && area > widestArea) {
+                widest = static_cast<int>(i);
+                widestArea = area;
+            }
+        }
+        if (widest < 0) {
+            break;
+        }
+        BuildRange left, right;
+        Split(context, children[widest], left, right);
+        children[widest] = left;
+        children[childCount++] = right;
+    }
+
+    Node& node = m_Nodes[nodeIndex];
+    node.childMask = (1u << childCount) - 1u;
+    JobCounter counter;
+    for (uint32 i = 0; i < 4; ++i) {
+        const BuildRange& child = children[i];
+        bool used = i < childCount;
+        node.bounds.minX[i] = used ? child.boundsMin.x : FLOAT_MAX;
+        node.bounds.minY[i] = used ? child.boundsMin.y : FLOAT_MAX;
+        node.bounds.minZ[i] = used ? child.boundsMin.z : FLOAT_MAX;
+        node.bounds.maxX[i] = used ? child.boundsMax.x : -FLOAT_MAX;
+        node.bounds.maxY[i] = used ? child.boundsMax.y : -FLOAT_MAX;
+        node.bounds.maxZ[i] = used ? child.boundsMax.z : -FLOAT_MAX;
+        node.children[i] = 0;
+        node.counts[i] = 0;
+        if (!used) {
+            continue;
+        }
+
+        if (child.GetCount() <= MAX_LEAF_TRIANGLES) {
+            node.children[i] = child.begin;
+            node.counts[i] = child.GetCount();
+            continue;
+        }
+        uint32 childIndex = m_NodeCount.fetch_add(1, std::memory_order_relaxed);
+        node.children[i] = childIndex;
+        if (child.GetCount() >= PARALLEL_SUBTREE_TRIANGLES) {
+            JobSystem::Run([this, &context, childIndex, child]() { BuildNode(context, childIndex, child); }, &counter);
+        } else {
+            BuildNode(context, childIndex, child);
+        }
+    }
+    JobSystem::Wait(counter);
+}
+
+// ============================================================================
+// Traversal
+// ============================================================================
+
+bool CpuPathTracer::Intersect(const glm::vec3& origin, const glm::vec3& direction, float maxT, Hit& outHit) const {
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    struct Entry {
+        uint32 node;
+        float t;
+    };
+    Entry stack[STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = { 0, 0.0f };
+    bool found = false;
+    outHit.t = maxT;
+
+    while (stackSize > 0) {
+        Entry entry = stack[--stackSize];
+        if (entry.t > outHit.t) {
+            continue;
+        }
+        const Node& node = m_Nodes[entry.node];
+        float t[4];
+        uint32 mask = simd::IntersectRayBox4(origin, inverseDirection, outHit.t, node.bounds, t) & node.childMask;
+
+        // Leaves right away; inner children pushed far to near, so the nearest pops first
+        Entry inner[4];
+        uint32 innerCount = 0;
+        for (; mask; mask &= mask - 1) {
+            uint32 slot = static_cast<uint32>(std::countr_zero(mask));
+            if (node.counts[slot] == 0) {
+                inner[innerCount++] = { node.children[slot], t[slot] };
+                continue;
+            }
+            for (uint32 i = node.children[slot], end = i + node.counts[slot]; i < end; ++i) {
+                // Moller-Trumbore
+                const Triangle& triangle = m_Triangles[i];
+                glm::vec3 p = glm::cross(direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+                if (std::abs(determinant) < 1e-12f) {
+                    continue;
+                }
+                float inverseDeterminant = 1.0f / determinant;
+                glm::vec3 s = origin - triangle.v0;
+                float u = glm::dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f) {
+                    continue;
+                }
+                glm::vec3 q = glm::cross(s, triangle.edge1);
+                float v = glm::dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f) {
+                    continue;
+                }
+                float hitT = glm::dot(triangle.edge2, q) * inverseDeterminant;
+                if (hitT > 0.0f && hitT < outHit.t) {
+                    outHit.t = hitT;
+                    outHit.u = u;
+                    outHit.v = v;
+                    outHit.primitive = triangle.primitive;
+                    found = true;
+                }
+            }
+        }
+        std::sort(inner, inner + innerCount, [](const Entry& a, const Entry& b) { return a.t > b.t; });
+        for (uint32 i = 0; i < innerCount && stackSize < STACK_SIZE; ++i) {
+            stack[stackSize++] = inner[i];
+        }
+    }
+    return found;
+}
+
+bool CpuPathTracer::Occluded(const glm::vec3& origin, const glm::vec3& direction, float maxT) const {
+    glm::vec3 inverseDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+    uint32 stack[STACK_SIZE];
+    uint32 stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        const Node& node = m_Nodes[stack[--stackSize]];
+        float t[4];
+        uint32 mask = simd::IntersectRayBox4(origin, inverseDirection, maxT, node.bounds, t) & node.childMask;
+        for (; mask; mask &= mask - 1) {
+            uint32 slot = static_cast<uint32>(std::countr_zero(mask));
+            if (node.counts[slot] == 0) {
+                if (stackSize < STACK_SIZE) {
+                    stack[stackSize++] = node.children[slot];
+                }
+                continue;
+            }
+            for (uint32 i = node.children[slot], end = i + node.counts[slot]; i < end; ++i) {
+                const Triangle& triangle = m_Triangles[i];
+                glm::vec3 p = glm::cross(direction, triangle.edge2);
+                float determinant = glm::dot(triangle.edge1, p);
+                if (std::abs(determinant) < 1e-12f) {
+                    continue;
+                }
+                float inverseDeterminant = 1.0f / determinant;
+                glm::vec3 s = origin - triangle.v0;
+                float u = glm::dot(s, p) * inverseDeterminant;
+                if (u < 0.0f || u > 1.0f) {
+                    continue;
+                }
+                glm::vec3 q = glm::cross(s, triangle.edge1);
+                float v = glm::dot(direction, q) * inverseDeterminant;
+                if (v < 0.0f || u + v > 1.0f) {
+                    continue;
+                }
+                float hitT = glm::dot(triangle.edge2, q) * inverseDeterminant;
+                if (hitT > 0.0f && hitT < maxT) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// ============================================================================
+// Shading
+// ============================================================================
+
+bool CpuPathTracer::LoadSurface(const Hit& hit, const glm::vec3& origin, const glm::vec3& direction,
+                                Surface& outSurface) const {
+    uint32 i0 = m_Indices[hit.primitive * 3];
+    uint32 i1 = m_Indices[hit.primitive * 3 + 1];
+    uint32 i2 = m_Indices[hit.primitive * 3 + 2];
+    const ShadingVertex& v0 = m_Vertices[i0];
+    const ShadingVertex& v1 = m_Vertices[i1];
+    const ShadingVertex& v2 = m_Vertices[i2];
+    float w0 = 1.0f - hit.u - hit.v;
+
+    glm::vec3 normal = v0.normal * w0 + v1.normal * hit.u + v2.normal * hit.v;
+    if (glm::dot(normal, normal) <= 0.0f) {
+        normal = glm::cross(m_Positions[i1] - m_Positions[i0], m_Positions[i2] - m_Positions[i0]);
+        if (glm::dot(normal, normal) <= 0.0f) {
+            return false;
+        }
+    }
+    normal = glm::normalize(normal);
+    glm::vec4 tangent = v0.tangent * w0 + v1.tangent * hit.u + v2.tangent * hit.v;
+    glm::vec2 texCoord = v0.texCoord * w0 + v1.texCoord * hit.u + v2.texCoord * hit.v;
+
+    // Both sides of a surface shade, like the rasterizer's unculled draws
+    if (glm::dot(normal, direction) > 0.0f) {
+        normal = -normal;
+    }
+    outSurface.position = origin + direction * hit.t;
+    outSurface.geometryNormal = normal;
+
+    // The material as path_trace.comp reads it
+    const ShadingMaterial& material = m_Materials[m_TriangleMaterials[hit.primitive]];
+    outSurface.albedo = material.albedoMap != NO_TEXTURE ? glm::vec3(m_Images[material.albedoMap].Sample(texCoord))
+                                                         : material.albedo;
+
+    outSurface.normal = normal;
+    glm::vec3 tangentXYZ(tangent);
+    if (material.normalMap != NO_TEXTURE && glm::dot(tangentXYZ, tangentXYZ) > 0.0f) {
+        // Z rebuilt from XY, as the GPU shaders do for two-channel normal maps
+        glm::vec3 tangentNormal(glm::vec2(m_Images[material.normalMap].Sample(texCoord)) * 2.0f - 1.0f, 0.0f);
+        tangentNormal.z = std::sqrt(std::max(1.0f - tangentNormal.x * tangentNormal.x - tangentNormal.y * tangentNormal.y, 0.0f));
+        glm::vec3 T = tangentXYZ - normal * glm::dot(normal, tangentXYZ);
+        if (glm::dot(T, T) > 0.0f) {
+            T = glm::normalize(T);
+            glm::vec3 B = glm::cross(normal, T) * (tangent.w < 0.0f ? -1.0f : 1.0f);
+            glm::vec3 mapped = T * tangentNormal.x + B * tangentNormal.y + normal * tangentNormal.z;
+            if (glm::dot(mapped, mapped) > 0.0f) {
+                outSurface.normal = glm::normalize(mapped);
+            }
+        }
+    }
+
+    if (material.metallicRoughnessMap != NO_TEXTURE) {
+        glm::vec4 mr = m_Images[material.metallicRoughnessMap].Sample(texCoord);
+        outSurface.roughness = mr.y;
+        outSurface.metallic = mr.z;
+    } else {
+        outSurface.metallic = material.metallic;
+        outSurface.roughness = material.roughnessMap != NO_TEXTURE
+                                   ? m_Images[material.roughnessMap].Sample(texCoord).x
+                                   : material.roughness;
+    }
+    outSurface.roughness = std::max(outSurface.roughness, 0.04f);
+
+    outSurface.emissive = material.emissiveMap != NO_TEXTURE
+                              ? glm::vec3(m_Images[material.emissiveMap].Sample(texCoord)) * material.emissiveFactor
+                              : material.emissiveFactor;
+    return true;
+}
+
+namespace {
+
+// Reflected radiance towards V per unit of incoming radiance from L, times the cosine
+template <typename SurfaceType>
+glm::vec3 EvaluateBRDF(const SurfaceType& surface, const glm::vec3& V, const glm::vec3& L) {
+    const glm::vec3& N = surface.normal;
+    float NdotL = glm::dot(N, L);
+    float NdotV = std::max(glm::dot(N, V), 0.0f);
+    if (NdotL <= 0.0f) {
+        return glm::vec3(0.0f);
+    }
+    glm::vec3 H = glm::normalize(V + L);
+    glm::vec3 F0 = glm::mix(glm::vec3(0.04f), surface.albedo, surface.metallic);
+    glm::vec3 F = FresnelSchlick(std::max(glm::dot(H, V), 0.0f), F0);
+    float D = DistributionGGX(std::max(glm::dot(N, H), 0.0f), surface.roughness);
+    float G = GeometrySchlickGGX(NdotV, surface.roughness) * GeometrySchlickGGX(NdotL, surface.roughness);
+
+    glm::vec3 specular = F * (D * G / (4.0f * NdotV * NdotL + 0.0001f));
+    glm::vec3 kD = (glm::vec3(1.0f) - F) * (1.0f - surface.metallic);
+    return (kD * surface.albedo / PI + specular) * NdotL;
+}
+
+// Probability of sampling the GGX lobe rather than the Lambert one
+template <typename SurfaceType>
+float SpecularProbability(const SurfaceType& surface, const glm::vec3& V) {
+    glm::vec3 F0 = glm::mix(glm::vec3(0.04f), surface.albedo, surface.metallic);
+    float specular = Luminance(FresnelSchlick(std::max(glm::dot(surface.normal, V), 0.0f), F0));
+    float diffuse = Luminance(surface.albedo) * (1.0f - surface.metallic) * (1.0f - specular);
+    return std::clamp(specular / std::max(specular + diffuse, 0.0001f), 0.1f, 0.9f);
+}
+
+} // namespace
+
+glm::vec3 CpuPathTracer::SampleLight(const Surface& surface, const glm::vec3& V, Random& random, uint64& rays) const {
+    uint32 lightCount = static_cast<uint32>(m_Lights.size());
+    if (lightCount == 0) {
+        return glm::vec3(0.0f);
+    }
+    uint32 lightIndex = std::min(static_cast<uint32>(random.Next() * static_cast<float>(lightCount)), lightCount - 1);
+    const LightData& light = m_Lights[lightIndex];
+    int lightType = static_cast<int>(light.positionAndType.w);
+
+    // Attenuation as model.frag's
+    glm::vec3 L;
+    float attenuation = 1.0f;
+    glm::vec3 lightPosition(light.positionAndType);
+    if (lightType == LIGHT_TYPE_DIRECTIONAL) {
+        L = glm::normalize(-glm::vec3(light.directionAndRange));
+    } else {
+        glm::vec3 toLight = lightPosition - surface.position;
+        float distance = glm::length(toLight);
+        float range = light.directionAndRange.w;
+        if (distance <= 0.0f || distance > range) {
+            return glm::vec3(0.0f);
+        }
+        L = toLight / distance;
+
+        float attQuadratic = 1.0f / (range * range);
+        attenuation = 1.0f / (light.spotAngles.z + light.spotAngles.w * distance + attQuadratic * distance * distance);
+        if (lightType == LIGHT_TYPE_SPOT) {
+            float theta = glm::dot(L, -glm::normalize(glm::vec3(light.directionAndRange)));
+            float innerCutoff = std::cos(light.spotAngles.x);
+            float outerCutoff = std::cos(light.spotAngles.y);
+            attenuation *= std::clamp((theta - outerCutoff) / (innerCutoff - outerCutoff), 0.0f, 1.0f);
+        }
+    }
+
+    glm::vec3 contribution = EvaluateBRDF(surface, V, L) * glm::vec3(light.colorAndIntensity) *
+                             (light.colorAndIntensity.w * attenuation);
+    if (glm::dot(contribution, contribution) <= 0.0f) {
+        return glm::vec3(0.0f);
+    }
+    glm::vec3 origin = OffsetRayOrigin(surface.position, surface.geometryNormal, L);
+    float tMax = lightType == LIGHT_TYPE_DIRECTIONAL ? RAY_MAX : glm::length(lightPosition - origin);
+    ++rays;
+    if (Occluded(origin, L, tMax)) {
+        return glm::vec3(0.0f);
+    }
+    return contribution * static_cast<float>(lightCount);
+}
+
+glm::vec3 CpuPathTracer::EnvironmentRadiance(const glm::vec3& direction) const {
+    if (m_EnvironmentMap.empty()) {
+        return m_EnvironmentColor;
+    }
+    // As IBLPrecompute::SampleEquirect()
+    float u = std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f;
+    float v = std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / PI;
+    uint32 x = std::min(static_cast<uint32>(std::clamp(u, 0.0f, 1.0f) * m_EnvironmentWidth), m_EnvironmentWidth - 1);
+    uint32 y = std::min(static_cast<uint32>(std::clamp(v, 0.0f, 1.0f) * m_EnvironmentHeight), m_EnvironmentHeight - 1);
+    const float* texel = &m_EnvironmentMap[(static_cast<size_t>(y) * m_EnvironmentWidth + x) * 3];
+    return glm::vec3(texel[0], texel[1], texel[2]) * m_EnvironmentIntensity;
+}
+
+glm::vec3 CpuPathTracer::TracePath(glm::vec3 origin, glm::vec3 direction, uint32 maxBounces, Random& random,
+                                   uint64& rays) const {
+    glm::vec3 radiance(0.0f);
+    glm::vec3 throughput(1.0f);
+
+    for (uint32 bounce = 0; bounce <= maxBounces; ++bounce) {
+        Hit hit;
+        ++rays;
+        if (!Intersect(origin, direction, RAY_MAX, hit)) {
+            radiance += throughput * EnvironmentRadiance(direction);
+            break;
+        }
+
+        Surface surface;
+        if (!LoadSurface(hit, origin, direction, surface)) {
+            break;
+        }
+        glm::vec3 V = -direction;
+
+        // Emitters are only found by the paths, so they count at every hit
+        radiance += throughput * (surface.emissive + SampleLight(surface, V, random, rays));
+        if (bounce == maxBounces) {
+            break;
+        }
+
+        // A direction from the mix of both lobes, weighed by the mixture's density
+        glm::vec3 tangent, bitangent;
+        Basis(surface.normal, tangent, bitangent);
+        float pSpecular = SpecularProbability(surface, V);
+        glm::vec2 u = random.Next2();
+        glm::vec3 L;
+        if (random.Next() < pSpecular) {
+            float a = surface.roughness * surface.roughness;
+            float cosTheta = std::sqrt((1.0f - u.x) / (1.0f + (a * a - 1.0f) * u.x));
+            float sinTheta = std::sqrt(std::max(1.0f - cosTheta * cosTheta, 0.0f));
+            float phi = 2.0f * PI * u.y;
+            glm::vec3 H = tangent * (sinTheta * std::cos(phi)) + bitangent * (sinTheta * std::sin(phi)) +
+                          surface.normal * cosTheta;
+            L = Reflect(-V, H);
+        } else {
+            float radius = std::sqrt(u.x);
+            float phi = 2.0f * PI * u.y;
+            L = tangent * (radius * std::cos(phi)) + bitangent * (radius * std::sin(phi)) +
+                surface.normal * std::sqrt(std::max(1.0f - u.x, 0.0f));
+        }
+
+        float NdotL = glm::dot(surface.normal, L);
+        if (NdotL <= 0.0f) {
+            break;
+        }
+        glm::vec3 H = glm::normalize(V + L);
+        float NdotH = std::max(glm::dot(surface.normal, H), 0.0f);
+        float VdotH = std::max(glm::dot(V, H), 0.0001f);
+        float specularPdf = DistributionGGX(NdotH, surface.roughness) * NdotH / (4.0f * VdotH);
+        float diffusePdf = NdotL / PI;
+        float pdf = diffusePdf + (specularPdf - diffusePdf) * pSpecular;
+        if (pdf <= 0.0f) {
+            break;
+        }
+        throughput *= EvaluateBRDF(surface, V, L) / pdf;
+
+        // Russian roulette past the first bounces: dim paths end early, the survivors
+        // carry their share
+        if (bounce >= 2) {
+            float survival = std::clamp(std::max(throughput.x, std::max(throughput.y, throughput.z)), 0.05f, 0.95f);
+            if (random.Next() >= survival) {
+                break;
+            }
+            throughput /= survival;
+        }
+        origin = OffsetRayOrigin(surface.position, surface.geometryNormal, L);
+        direction = L;
+    }
+    return radiance;
+}
+
+void CpuPathTracer::Render(const View& view, const Settings& settings, uint32 width, uint32 height,
+                           std::vector<glm::vec3>& outPixels) {
+    METAGFX_PROFILE_SCOPE("CPU path tracer render");
+    outPixels.assign(static_cast<size_t>(width) * height, glm::vec3(0.0f));
+    if (m_Nodes.empty() || width == 0 || height == 0) {
+        return;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+
+    glm::mat4 inverseViewProjection = glm::inverse(view.viewProjection);
+    uint32 samples = std::max(settings.samplesPerPixel, 1u);
+    uint32 columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32 tileCount = columns * ((height + TILE_SIZE - 1) / TILE_SIZE);
+
+    // One loop per thread taking tiles until none are left: tile costs differ wildly
+    // (sky against foliage), so a static split would leave threads idle at the end
+    std::atomic<uint32> nextTile{0};
+    std::atomic<uint64> totalRays{0};
+    JobSystem::ParallelFor(JobSystem::GetWorkerCount() + 1, 1, [&](uint32, uint32) {
+        uint64 rays = 0;
+        for (uint32 tile = nextTile.fetch_add(1); tile < tileCount; tile = nextTile.fetch_add(1)) {
+            uint32 x0 = tile % columns * TILE_SIZE;
+            uint32 y0 = tile / columns * TILE_SIZE;
+            for (uint32 y = y0; y < std::min(y0 + TILE_SIZE, height); ++y) {
+                for (uint32 x = x0; x < std::min(x0 + TILE_SIZE, width); ++x) {
+                    glm::vec3 sum(0.0f);
+                    for (uint32 sample = 0; sample < samples; ++sample) {
+                        Random random(PcgHash(x + y * 65536u) ^ PcgHash(sample * 9781u + 1u));
+
+                        // A random point of the pixel, so the samples antialias it
+                        glm::vec2 jitter = random.Next2();
+                        float ndcX = (static_cast<float>(x) + jitter.x) / static_cast<float>(width) * 2.0f - 1.0f;
+                        float ndcY = 1.0f - (static_cast<float>(y) + jitter.y) / static_cast<float>(height) * 2.0f;
+                        glm::vec4 target = inverseViewProjection * glm::vec4(ndcX, ndcY, 0.5f, 1.0f);
+                        glm::vec3 direction = glm::normalize(glm::vec3(target) / target.w - view.cameraPosition);
+
+                        glm::vec3 radiance = TracePath(view.cameraPosition, direction, settings.maxBounces, random, rays);
+                        // A degenerate path would poison the pixel's mean
+                        if (std::isfinite(radiance.x) && std::isfinite(radiance.y) && std::isfinite(radiance.z)) {
+                            sum += radiance;
+                        }
+                    }
+                    outPixels[static_cast<size_t>(y) * width + x] = sum / static_cast<float>(samples);
+                }
+            }
+        }
+        totalRays.fetch_add(rays, std::memory_order_relaxed);
+    });
+
+    m_Stats.renderMs = MillisecondsSince(startTime);
+    m_Stats.rayCount = totalRays.load();
+}
+
+} // namespace metagfx
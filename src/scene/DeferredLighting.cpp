@@ -0,0 +1,219 @@
+// ============================================================================
+// src/scene/DeferredLighting.cpp
+// ============================================================================
+#include "metagfx/scene/DeferredLighting.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace metagfx {
+
+// Bindings of the main set the lighting pass reads: frame constants, lights, IBL maps,
+// shadow map and its UBO, shadow atlas, PCSS depth, EVSM moments and light probes
+constexpr uint32 LIGHTING_SCENE_BINDINGS[] = { 0, 3, 8, 9, 10, 12, 13, 18, 19, 20, 21, 29 };
+
+// Bindings of the targets in deferred_lighting.comp, after the scene's
+constexpr uint32 GBUFFER_BINDING = 22;
+constexpr uint32 DEPTH_BINDING = 23;
+constexpr uint32 LIT_COLOR_BINDING = 24;
+constexpr uint32 AMBIENT_OCCLUSION_BINDING = 25;
+constexpr uint32 REFLECTIONS_BINDING = 26;
+
+// Push constants of deferred_lighting.comp
+struct LightingPushConstants {
+    uint32 width;   // Of the G-buffer drawn, its top-left region
+    uint32 height;
+    uint32 ambientOcclusion;  // 1 = binding 25 holds the screen-space occlusion
+    uint32 reflections;       // 1 = binding 26 holds the screen-space reflections
+};
+
+DeferredLighting::DeferredLighting(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> lightingShader,
+                                   Ref<rhi::Shader> compositeVertexShader, Ref<rhi::Shader> compositeFragmentShader,
+                                   const std::vector<rhi::DescriptorBindingDesc>& sceneBindings,
+                                   rhi::Format sceneColorFormat)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    for (const DescriptorBindingDesc& binding : sceneBindings) {
+        if (std::find(std::begin(LIGHTING_SCENE_BINDINGS), std::end(LIGHTING_SCENE_BINDINGS), binding.binding) !=
+            std::end(LIGHTING_SCENE_BINDINGS)) {
+            m_LightingBindings.push_back(binding);
+            m_LightingBindings.back().stageFlags = ShaderStage::Compute;
+        }
+    }
+    if (m_LightingBindings.size() != std::size(LIGHTING_SCENE_BINDINGS)) {
+        METAGFX_ERROR << "Deferred lighting unavailable: the scene bindings lack the lights, shadows or IBL maps";
+        return;
+    }
+    m_LightingBindings.push_back({ GBUFFER_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                                   nullptr, nullptr, m_PointSampler });
+    m_LightingBindings.push_back({ DEPTH_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                                   nullptr, nullptr, m_PointSampler });
+    m_LightingBindings.push_back({ LIT_COLOR_BINDING, DescriptorType::StorageTexture, ShaderStage::Compute,
+                                   nullptr, nullptr, nullptr });
+    m_LightingBindings.push_back({ AMBIENT_OCCLUSION_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                                   nullptr, nullptr, m_PointSampler });
+    m_LightingBindings.push_back({ REFLECTIONS_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                                   nullptr, nullptr, m_PointSampler });
+
+    // The targets come with the first frame; the pipelines only need the layouts
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = m_LightingBindings;
+    layoutDesc.debugName = "DeferredLightingLayout";
+    Ref<DescriptorSet> lightingLayout = device->CreateDescriptorSet(layoutDesc);
+
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler },  // Lit color
+        { 1, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler }   // Depth
+    };
+    layoutDesc.debugName = "DeferredCompositeLayout";
+    Ref<DescriptorSet> compositeLayout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc lightingDesc{};
+    lightingDesc.computeShader = lightingShader;
+    lightingDesc.pushConstantSize = sizeof(LightingPushConstants);
+    lightingDesc.debugName = "DeferredLightingPipeline";
+    lightingDesc.descriptorSetLayout = lightingLayout;
+    m_LightingPipeline = device->CreateComputePipeline(lightingDesc);
+
+    // A triangle over the viewport, made by the vertex shader; it writes the G-buffer's
+    // depth, so the test always passes
+    PipelineDesc compositeDesc{};
+    compositeDesc.vertexShader = compositeVertexShader;
+    compositeDesc.fragmentShader = compositeFragmentShader;
+    compositeDesc.vertexInput.stride = 0;
+    compositeDesc.rasterization.cullMode = CullMode::None;
+    compositeDesc.depthStencil.depthTestEnable = true;
+    compositeDesc.depthStencil.depthWriteEnable = true;
+    compositeDesc.depthStencil.depthCompareOp = CompareOp::Always;
+    compositeDesc.colorFormats = { sceneColorFormat };
+    compositeDesc.depthFormat = device->GetDeviceInfo().depthFormat;
+    compositeDesc.debugName = "DeferredCompositePipeline";
+    compositeDesc.descriptorSetLayout = compositeLayout;
+    m_CompositePipeline = device->CreateGraphicsPipeline(compositeDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Deferred lighting unavailable: failed to create its pipelines";
+        return;
+    }
+    METAGFX_INFO << "Deferred lighting created: " << TILE_SIZE << "x" << TILE_SIZE << " tiles, up to "
+                 << MAX_LIGHTS_PER_TILE << " lights each";
+}
+
+void DeferredLighting::SetTargets(Ref<rhi::Texture> gbuffer, Ref<rhi::Texture> depth, Ref<rhi::Texture> litColor,
+                                  Ref<rhi::Texture> ambientOcclusion, Ref<rhi::Texture> reflections) {
+    if (gbuffer == m_GBuffer && depth == m_Depth && litColor == m_LitColor &&
+        ambientOcclusion == m_AmbientOcclusion && reflections == m_Reflections) {
+        return;
+    }
+
+    m_Device->Retire(m_LightingDescriptorSet);
+    m_Device->Retire(m_CompositeDescriptorSet);
+    m_GBuffer = gbuffer;
+    m_Depth = depth;
+    m_LitColor = litColor;
+    m_AmbientOcclusion = ambientOcclusion;
+    m_Reflections = reflections;
+    CreateDescriptorSets();
+}
+
+void DeferredLighting::SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler) {
+    for (rhi::DescriptorBindingDesc& sceneBinding : m_LightingBindings) {
+        if (sceneBinding.binding == binding) {
+            sceneBinding.texture = texture;
+            sceneBinding.sampler = sampler;
+        }
+    }
+    if (m_LightingDescriptorSet) {
+        m_LightingDescriptorSet->UpdateTexture(binding, texture, sampler);
+    }
+}
+
+void DeferredLighting::SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer) {
+    for (rhi::DescriptorBindingDesc& sceneBinding : m_LightingBindings) {
+        if (sceneBinding.binding == binding) {
+            sceneBinding.buffer = buffer;
+        }
+    }
+    if (m_LightingDescriptorSet) {
+        m_LightingDescriptorSet->UpdateBuffer(binding, buffer);
+    }
+}
+
+void DeferredLighting::CreateDescriptorSets() {
+    using namespace rhi;
+
+    m_LightingDescriptorSet.reset();
+    m_CompositeDescriptorSet.reset();
+    if (!IsValid() || !m_GBuffer || !m_Depth || !m_LitColor) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = m_LightingBindings;
+    for (DescriptorBindingDesc& binding : desc.bindings) {
+        if (binding.binding == GBUFFER_BINDING) {
+            binding.texture = m_GBuffer;
+        } else if (binding.binding == DEPTH_BINDING) {
+            binding.texture = m_Depth;
+        } else if (binding.binding == LIT_COLOR_BINDING) {
+            binding.texture = m_LitColor;
+        } else if (binding.binding == AMBIENT_OCCLUSION_BINDING) {
+            // Without occlusion the depth stands in, unread
+            binding.texture = m_AmbientOcclusion ? m_AmbientOcclusion : m_Depth;
+        } else if (binding.binding == REFLECTIONS_BINDING) {
+            binding.texture = m_Reflections ? m_Reflections : m_Depth;
+        }
+    }
+    desc.debugName = "DeferredLightingDescriptorSet";
+    m_LightingDescriptorSet = m_Device->CreateDescriptorSet(desc);
+
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_LitColor, m_PointSampler },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_Depth, m_PointSampler }
+    };
+    desc.debugName = "DeferredCompositeDescriptorSet";
+    m_CompositeDescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void DeferredLighting::Light(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset,
+                             uint32 width, uint32 height) {
+    if (!m_LightingDescriptorSet) {
+        return;
+    }
+
+    LightingPushConstants push{};
+    push.width = width ? std::min(width, m_LitColor->GetWidth()) : m_LitColor->GetWidth();
+    push.height = height ? std::min(height, m_LitColor->GetHeight()) : m_LitColor->GetHeight();
+    push.ambientOcclusion = m_AmbientOcclusion ? 1 : 0;
+    push.reflections = m_Reflections ? 1 : 0;
+
+    cmd.BindPipeline(m_LightingPipeline);
+    cmd.BindDescriptorSet(m_LightingPipeline, m_LightingDescriptorSet, frameIndex, &frameUniformOffset, 1);
+    cmd.PushConstants(m_LightingPipeline, rhi::ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch((push.width + TILE_SIZE - 1) / TILE_SIZE, (push.height + TILE_SIZE - 1) / TILE_SIZE);
+}
+
+void DeferredLighting::Composite(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    if (!m_CompositeDescriptorSet) {
+        return;
+    }
+
+    cmd.BindPipeline(m_CompositePipeline);
+    cmd.BindDescriptorSet(m_CompositePipeline, m_CompositeDescriptorSet, frameIndex);
+    cmd.Draw(3);
+}
+
+} // namespace metagfx
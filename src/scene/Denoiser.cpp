@@ -0,0 +1,233 @@
+// ============================================================================
+// src/scene/Denoiser.cpp
+// ============================================================================
+#include "metagfx/scene/Denoiser.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Must match local_size_x/y of denoise.comp
+constexpr uint32 DENOISE_GROUP_SIZE = 8;
+
+// Of the moments, whose second outgrows halves on bright pixels, and the guides' copies
+constexpr rhi::Format DENOISE_FLOAT_FORMAT = rhi::Format::R32G32B32A32_SFLOAT;
+
+// Passes and flags of denoise.comp
+constexpr uint32 DENOISE_PASS_TEMPORAL = 0;
+constexpr uint32 DENOISE_PASS_SPATIAL = 1;
+constexpr uint32 DENOISE_PASS_COPY = 2;
+constexpr uint32 DENOISE_WRITE_HISTORY = 1u << 0;
+constexpr uint32 DENOISE_WRITE_OUTPUT = 1u << 1;
+
+// Push constants of denoise.comp
+struct DenoisePushConstants {
+    glm::mat4 reprojection;  // This frame's NDC to the histories' clip space
+    glm::uvec2 size;         // Of the image
+    uint32 pass;
+    uint32 flags;
+    uint32 step;             // Of the spatial iteration's taps, in pixels
+    uint32 source;           // Filter texture the spatial iteration reads; it writes the other
+    uint32 historyValid;
+    float maxHistory;
+    float fadeSamples;
+    float luminanceSigma;
+    float normalPower;
+    float depthSigma;
+};
+
+Denoiser::Denoiser(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The textures come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 5, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 7, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 8, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 9, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 10, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 11, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "DenoiseLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(DenoisePushConstants);
+    pipelineDesc.debugName = "DenoisePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Denoiser unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Denoiser created: SVGF, up to " << MAX_ITERATIONS << " a-trous iterations";
+}
+
+void Denoiser::SetSources(Ref<rhi::Texture> image, Ref<rhi::Texture> guide, Ref<rhi::Texture> albedo,
+                          Ref<rhi::Texture> output) {
+    using namespace rhi;
+
+    Ref<Texture> sources[4] = { image, guide, albedo, output };
+    if (std::equal(std::begin(sources), std::end(sources), std::begin(m_Sources))) {
+        return;
+    }
+
+    std::copy(std::begin(sources), std::end(sources), std::begin(m_Sources));
+    if (m_DescriptorSets[0]) {
+        m_Device->Retire(m_DescriptorSets[0]);
+        m_Device->Retire(m_DescriptorSets[1]);
+        m_DescriptorSets[0].reset();
+        m_DescriptorSets[1].reset();
+    }
+    if (!IsValid() || !image || !guide || !albedo || !output) {
+        return;
+    }
+
+    Resize(image->GetWidth(), image->GetHeight());
+    if (!m_Filter[0]) {
+        return;
+    }
+
+    for (uint32 i = 0; i < 2; ++i) {
+        DescriptorSetDesc desc;
+        desc.bindings = {
+            { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, image, m_PointSampler },
+            { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, guide, m_PointSampler },
+            { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, albedo, m_PointSampler },
+            { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_Guides[1 - i], m_PointSampler },
+            { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_History[1 - i], m_PointSampler },
+            { 5, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_Moments[1 - i], m_PointSampler },
+            { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Guides[i], nullptr },
+            { 7, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[i], nullptr },
+            { 8, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Moments[i], nullptr },
+            { 9, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Filter[0], nullptr },
+            { 10, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Filter[1], nullptr },
+            { 11, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, output, nullptr }
+        };
+        desc.debugName = i == 0 ? "DenoiseDescriptorSet0" : "DenoiseDescriptorSet1";
+        m_DescriptorSets[i] = m_Device->CreateDescriptorSet(desc);
+    }
+}
+
+void Denoiser::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (m_Filter[0] && m_Filter[0]->GetWidth() == width && m_Filter[0]->GetHeight() == height) {
+        return;
+    }
+
+    for (Ref<Texture>* textures : { m_History, m_Moments, m_Guides, m_Filter }) {
+        for (uint32 i = 0; i < 2; ++i) {
+            if (textures[i]) {
+                m_Device->Retire(textures[i]);
+                textures[i].reset();
+            }
+        }
+    }
+
+    // Written as storage, read back by the next pass or frame
+    TextureDesc desc{};
+    desc.width = width;
+    desc.height = height;
+    desc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    for (uint32 i = 0; i < 2; ++i) {
+        desc.format = HISTORY_FORMAT;
+        desc.debugName = i == 0 ? "DenoiseHistory0" : "DenoiseHistory1";
+        m_History[i] = m_Device->CreateTexture(desc);
+        desc.debugName = i == 0 ? "DenoiseFilter0" : "DenoiseFilter1";
+        m_Filter[i] = m_Device->CreateTexture(desc);
+        desc.format = DENOISE_FLOAT_FORMAT;
+        desc.debugName = i == 0 ? "DenoiseMoments0" : "DenoiseMoments1";
+        m_Moments[i] = m_Device->CreateTexture(desc);
+        desc.debugName = i == 0 ? "DenoiseGuide0" : "DenoiseGuide1";
+        m_Guides[i] = m_Device->CreateTexture(desc);
+    }
+    if (!m_History[0] || !m_History[1] || !m_Moments[0] || !m_Moments[1] || !m_Guides[0] || !m_Guides[1] ||
+        !m_Filter[0] || !m_Filter[1]) {
+        METAGFX_ERROR << "Denoiser: failed to create its " << width << "x" << height << " textures";
+        m_Filter[0].reset();
+    }
+    m_HistoryValid = false;
+}
+
+void Denoiser::Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& viewProjection,
+                     uint32 sampleCount) {
+    using namespace rhi;
+
+    const Ref<DescriptorSet>& descriptorSet = m_DescriptorSets[m_Current];
+    if (!descriptorSet) {
+        return;
+    }
+
+    DenoisePushConstants push{};
+    push.reprojection = m_HistoryViewProjection * glm::inverse(viewProjection);
+    push.size = glm::uvec2(m_Sources[0]->GetWidth(), m_Sources[0]->GetHeight());
+    push.historyValid = m_HistoryValid ? 1 : 0;
+    push.maxHistory = static_cast<float>(std::max(m_Settings.maxHistory, 1u));
+    push.fadeSamples = static_cast<float>(std::max(m_Settings.fadeSamples, 1u));
+    push.luminanceSigma = std::max(m_Settings.luminanceSigma, 0.01f);
+    push.normalPower = std::max(m_Settings.normalPower, 1.0f);
+    push.depthSigma = std::max(m_Settings.depthSigma, 0.01f);
+    uint32 groupsX = (push.size.x + DENOISE_GROUP_SIZE - 1) / DENOISE_GROUP_SIZE;
+    uint32 groupsY = (push.size.y + DENOISE_GROUP_SIZE - 1) / DENOISE_GROUP_SIZE;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, descriptorSet, frameIndex);
+
+    // Converged far enough to show as it is: the histories stay as they were, with the
+    // view they were drawn from, for when the camera moves again
+    if (sampleCount >= m_Settings.fadeSamples) {
+        push.pass = DENOISE_PASS_COPY;
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch(groupsX, groupsY);
+        return;
+    }
+
+    // The histories and filter textures are not in the frame's graph: the last frame's
+    // passes wrote the ones read here, and read the ones written
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = DENOISE_PASS_TEMPORAL;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(groupsX, groupsY);
+
+    // The temporal pass writes filter texture 0; each iteration reads one and writes the
+    // other, and the last the output instead
+    uint32 iterations = std::clamp(m_Settings.iterations, 1u, MAX_ITERATIONS);
+    push.pass = DENOISE_PASS_SPATIAL;
+    for (uint32 i = 0; i < iterations; ++i) {
+        push.step = 1u << i;
+        push.source = i % 2;
+        push.flags = (i == 0 ? DENOISE_WRITE_HISTORY : 0) | (i + 1 == iterations ? DENOISE_WRITE_OUTPUT : 0);
+        cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch(groupsX, groupsY);
+    }
+
+    m_HistoryViewProjection = viewProjection;
+    m_Current = 1 - m_Current;
+    m_HistoryValid = true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,333 @@
+// ============================================================================
+// src/scene/EnvironmentBaker.cpp
+// ============================================================================
+#include "metagfx/scene/EnvironmentBaker.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/ReadbackPool.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+namespace {
+
+// Must match local_size_x/y and the passes of environment_bake.comp
+constexpr uint32 ENVIRONMENT_BAKE_GROUP_SIZE = 8;
+constexpr uint32 PASS_ENVIRONMENT = 0;
+constexpr uint32 PASS_IRRADIANCE_SH = 1;
+constexpr uint32 PASS_PREFILTER = 2;
+constexpr uint32 PASS_BRDF_LUT = 3;
+
+// The spherical harmonics as float vec4s
+constexpr uint64 SH_SIZE = utils::SH_COEFFICIENT_COUNT * 4 * sizeof(float);
+
+// Half floats per texel in the output buffer
+constexpr uint64 CUBE_TEXEL_SIZE = 4 * sizeof(uint16);
+constexpr uint64 LUT_TEXEL_SIZE = 2 * sizeof(uint16);
+
+uint64 CubeMapSize(uint32 size, uint32 mipLevels) {
+    uint64 bytes = 0;
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        uint64 mipSize = std::max(size >> mip, 1u);
+        bytes += 6 * mipSize * mipSize * CUBE_TEXEL_SIZE;
+    }
+    return bytes;
+}
+
+} // namespace
+
+EnvironmentBaker::EnvironmentBaker(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.addressModeU = SamplerAddressMode::Repeat;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_Sampler = device->CreateSampler(samplerDesc);
+
+    // The HDR and the output come with each Bake(); the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_Sampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "EnvironmentBakeLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(Constants);
+    pipelineDesc.debugName = "EnvironmentBakePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Runtime IBL baking unavailable: failed to create its pipeline";
+    }
+}
+
+EnvironmentBaker::~EnvironmentBaker() {
+    Release();
+}
+
+void EnvironmentBaker::Release() {
+    if (m_Output) {
+        m_Device->Retire(m_Output);
+        m_Device->Retire(m_DescriptorSet);
+        m_Device->Retire(m_Source);
+    }
+    m_Output.reset();
+    m_DescriptorSet.reset();
+    m_Source.reset();
+    m_Steps.clear();
+    m_NextStep = 0;
+}
+
+bool EnvironmentBaker::Bake(Ref<rhi::Texture> equirect, bool brdfLut) {
+    using namespace rhi;
+
+    if (!IsValid() || !equirect) {
+        return false;
+    }
+    // A newer bake wins; the callback of a pending read back fills the old result
+    Release();
+    m_ReadbackPending = false;
+    m_Result.reset();
+
+    Layout layout;
+    layout.settings = m_Settings;
+    layout.settings.prefilteredMips = std::clamp(layout.settings.prefilteredMips, 1u, 16u);
+    layout.brdfLut = brdfLut;
+    const Settings& settings = layout.settings;
+    layout.irradianceOffset = CubeMapSize(settings.environmentSize, 1);
+    layout.prefilteredOffset = layout.irradianceOffset + SH_SIZE;
+    layout.brdfLutOffset = layout.prefilteredOffset + CubeMapSize(settings.prefilteredSize, settings.prefilteredMips);
+    layout.size = layout.brdfLutOffset
+                + (brdfLut ? static_cast<uint64>(settings.brdfLutSize) * settings.brdfLutSize * LUT_TEXEL_SIZE : 0);
+
+    BufferDesc outputDesc{};
+    outputDesc.size = layout.size;
+    outputDesc.usage = BufferUsage::Storage | BufferUsage::TransferSrc;
+    outputDesc.memoryUsage = MemoryUsage::GPUOnly;
+    outputDesc.debugName = "EnvironmentBakeOutput";
+    Ref<Buffer> output = m_Device->CreateBuffer(outputDesc);
+    if (!output) {
+        METAGFX_ERROR << "Failed to create the environment bake buffer (" << layout.size << " bytes)";
+        return false;
+    }
+
+    DescriptorSetDesc setDesc;
+    setDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, equirect, m_Sampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, output, nullptr, nullptr }
+    };
+    setDesc.debugName = "EnvironmentBakeSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(setDesc);
+    m_Output = output;
+    m_Source = equirect;
+    m_Layout = layout;
+
+    // Bands of rows that each stay within a frame's budget
+    m_TotalSamples = 0;
+    m_RecordedSamples = 0;
+    auto addMap = [&](uint32 pass, uint32 size, uint32 faces, uint64 offset, uint64 texelSize,
+                      uint32 sampleCount, float roughness) {
+        uint64 texelCost = sampleCount;
+        uint64 rowCost = std::max<uint64>(static_cast<uint64>(size) * texelCost, 1);
+        uint32 bandRows = static_cast<uint32>(std::clamp<uint64>(settings.samplesPerFrame / rowCost, 1, size));
+        for (uint32 face = 0; face < faces; ++face) {
+            uint64 faceOffset = offset + static_cast<uint64>(face) * size * size * texelSize;
+            for (uint32 row = 0; row < size; row += bandRows) {
+                Step step;
+                step.constants.pass = pass;
+                step.constants.face = face;
+                step.constants.size = size;
+                step.constants.firstRow = row;
+                step.constants.rowCount = std::min(bandRows, size - row);
+                step.constants.sampleCount = sampleCount;
+                step.constants.outputOffset = static_cast<uint32>(faceOffset / sizeof(uint32));
+                step.constants.roughness = roughness;
+                step.groupsX = (size + ENVIRONMENT_BAKE_GROUP_SIZE - 1) / ENVIRONMENT_BAKE_GROUP_SIZE;
+                step.groupsY = (step.constants.rowCount + ENVIRONMENT_BAKE_GROUP_SIZE - 1) / ENVIRONMENT_BAKE_GROUP_SIZE;
+                step.samples = rowCost * step.constants.rowCount;
+                m_TotalSamples += step.samples;
+                m_Steps.push_back(step);
+            }
+        }
+    };
+
+    addMap(PASS_ENVIRONMENT, settings.environmentSize, 6, 0, CUBE_TEXEL_SIZE, 1, 0.0f);
+
+    // The projection is one workgroup over the whole grid
+    Step projection;
+    projection.constants.pass = PASS_IRRADIANCE_SH;
+    projection.constants.size = std::max(settings.irradianceGridWidth, 2u);
+    projection.constants.rowCount = projection.constants.size / 2;
+    projection.constants.outputOffset = static_cast<uint32>(layout.irradianceOffset / sizeof(uint32));
+    projection.samples = static_cast<uint64>(projection.constants.size) * projection.constants.rowCount;
+    m_TotalSamples += projection.samples;
+    m_Steps.push_back(projection);
+
+    uint64 mipOffset = layout.prefilteredOffset;
+    for (uint32 mip = 0; mip < settings.prefilteredMips; ++mip) {
+        uint32 mipSize = std::max(settings.prefilteredSize >> mip, 1u);
+        float roughness = settings.prefilteredMips > 1
+                        ? static_cast<float>(mip) / static_cast<float>(settings.prefilteredMips - 1) : 0.0f;
+        // Roughness 0 is a single lookup
+        addMap(PASS_PREFILTER, mipSize, 6, mipOffset, CUBE_TEXEL_SIZE,
+               mip == 0 ? 1 : settings.sampleCount, roughness);
+        mipOffset += 6ull * mipSize * mipSize * CUBE_TEXEL_SIZE;
+    }
+    if (brdfLut) {
+        addMap(PASS_BRDF_LUT, settings.brdfLutSize, 1, layout.brdfLutOffset, LUT_TEXEL_SIZE,
+               settings.sampleCount, 0.0f);
+    }
+
+    m_Result = std::make_shared<Result>();
+    METAGFX_INFO << "Baking IBL maps: " << m_Steps.size() << " dispatches, "
+                 << (layout.size >> 20) << " MB";
+    return true;
+}
+
+float EnvironmentBaker::GetProgress() const {
+    if (m_TotalSamples == 0) {
+        return 0.0f;
+    }
+    return static_cast<float>(static_cast<double>(m_RecordedSamples) / static_cast<double>(m_TotalSamples));
+}
+
+void EnvironmentBaker::BeginFrame() {
+    if (!m_Readback) {
+        return;
+    }
+    m_Readback->BeginFrame();
+    if (m_Result && m_Result->ready) {
+        m_ReadbackPending = false;
+    }
+    // Keep no staging memory between bakes
+    if (!m_ReadbackPending && !m_Output) {
+        m_Readback.reset();
+    }
+}
+
+void EnvironmentBaker::Record(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    using namespace rhi;
+
+    // The HDR samples as black until its upload has landed
+    if (!m_Output || !m_Source->IsUploadComplete()) {
+        return;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+    uint64 budget = 0;
+    while (m_NextStep < m_Steps.size()) {
+        const Step& step = m_Steps[m_NextStep];
+        if (budget > 0 && budget + step.samples > m_Layout.settings.samplesPerFrame) {
+            break;
+        }
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(Constants), &step.constants);
+        cmd.Dispatch(step.groupsX, step.groupsY, 1);
+        budget += step.samples;
+        m_RecordedSamples += step.samples;
+        ++m_NextStep;
+    }
+    if (m_NextStep < m_Steps.size()) {
+        return;
+    }
+
+    // Every step is recorded: read the maps back once this frame has finished
+    BufferBarrier barrier{ m_Output, ResourceState::StorageWrite, ResourceState::TransferRead };
+    cmd.ResourceBarrier(nullptr, 0, &barrier, 1);
+
+    if (!m_Readback) {
+        m_Readback = CreateScope<ReadbackPool>(m_Device);
+    }
+    Ref<GraphicsDevice> device = m_Device;
+    std::shared_ptr<Result> result = m_Result;
+    Layout layout = m_Layout;
+    bool started = m_Readback->Read(cmd, m_Output, 0, m_Layout.size,
+        [device, result, layout](const void* data, uint64 size) {
+            if (!data || size < layout.size) {
+                METAGFX_ERROR << "Failed to read back the baked IBL maps";
+                result->ready = true;
+                return;
+            }
+            CreateMaps(*device, layout, static_cast<const uint8*>(data), result->maps);
+            result->ready = true;
+        });
+    if (!started) {
+        METAGFX_ERROR << "Failed to read back the baked IBL maps (" << m_Layout.size << " bytes)";
+    }
+    m_ReadbackPending = started;
+    Release();
+}
+
+void EnvironmentBaker::CreateMaps(rhi::GraphicsDevice& device, const Layout& layout, const uint8* data, Maps& maps) {
+    using namespace rhi;
+    const Settings& settings = layout.settings;
+
+    auto createCube = [&](uint32 size, uint32 mipLevels, uint64 offset, const char* name) {
+        TextureDesc desc{};
+        desc.type = TextureType::TextureCube;
+        desc.width = size;
+        desc.height = size;
+        desc.mipLevels = mipLevels;
+        desc.arrayLayers = 6;
+        desc.format = Format::R16G16B16A16_SFLOAT;
+        desc.usage = TextureUsage::Sampled | TextureUsage::TransferDst;
+        desc.debugName = name;
+        Ref<Texture> texture = device.CreateTexture(desc);
+        if (texture) {
+            texture->UploadData(data + offset, CubeMapSize(size, mipLevels));
+        }
+        return texture;
+    };
+
+    maps.environment = createCube(settings.environmentSize, 1, 0, "BakedEnvironmentMap");
+
+    utils::RadianceSH radiance;
+    const float* projection = reinterpret_cast<const float*>(data + layout.irradianceOffset);
+    for (uint32 i = 0; i < utils::SH_COEFFICIENT_COUNT; ++i) {
+        radiance.coefficients[i] = glm::vec3(projection[4 * i], projection[4 * i + 1], projection[4 * i + 2]);
+    }
+    maps.irradianceSH = utils::IrradianceSH::FromRadiance(radiance);
+    maps.prefiltered = createCube(settings.prefilteredSize, settings.prefilteredMips, layout.prefilteredOffset,
+                                  "BakedPrefilteredMap");
+
+    if (layout.brdfLut) {
+        TextureDesc desc{};
+        desc.width = settings.brdfLutSize;
+        desc.height = settings.brdfLutSize;
+        desc.format = Format::R16G16_SFLOAT;
+        desc.usage = TextureUsage::Sampled | TextureUsage::TransferDst;
+        desc.debugName = "BakedBRDFLUT";
+        maps.brdfLut = device.CreateTexture(desc);
+        if (maps.brdfLut) {
+            maps.brdfLut->UploadData(data + layout.brdfLutOffset, layout.size - layout.brdfLutOffset);
+        }
+    }
+
+    if (!maps.environment || !maps.prefiltered || (layout.brdfLut && !maps.brdfLut)) {
+        METAGFX_ERROR << "Failed to create the baked IBL textures";
+        maps = Maps{};
+    }
+}
+
+bool EnvironmentBaker::TakeMaps(Maps& maps) {
+    if (!m_Result || !m_Result->ready) {
+        return false;
+    }
+    std::shared_ptr<Result> result = std::move(m_Result);
+    if (!result->maps.environment) {
+        return false;
+    }
+    maps = std::move(result->maps);
+    METAGFX_INFO << "IBL maps baked";
+    return true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,93 @@
+// ============================================================================
+// src/scene/Frustum.cpp
+// ============================================================================
+#include "metagfx/scene/Frustum.h"
+#include "metagfx/core/SimdMath.h"
+
+
+namespace metagfx {
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection) {
+    // Gribb-Hartmann: each plane is the last row plus or minus one of the others
+    glm::mat4 rows = glm::transpose(viewProjection);
+
+    Frustum frustum;
+    frustum.planes[0] = rows[3] + rows[0];
+    frustum.planes[1] = rows[3] - rows[0];
+    frustum.planes[2] = rows[3] + rows[1];
+    frustum.planes[3] = rows[3] - rows[1];
+    frustum.planes[4] = rows[3] + rows[2];
+    frustum.planes[5] = rows[3] - rows[2];
+
+    for (glm::vec4& plane : frustum.planes) {
+        float length = glm::length(glm::vec3(plane));
+        if (length > 0.0f) {
+            plane = plane / length;
+        }
+    }
+    return frustum;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const {
+    for (const glm::vec4& plane : planes) {
+        if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::IntersectsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (const glm::vec4& plane : planes) {
+        // Corner farthest along the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? boxMax.x : boxMin.x,
+                         plane.y >= 0.0f ? boxMax.y : boxMin.y,
+                         plane.z >= 0.0f ? boxMax.z : boxMin.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool Frustum::ContainsBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+    for (const glm::vec4& plane : planes) {
+        // Corner farthest against the plane normal
+        glm::vec3 corner(plane.x >= 0.0f ? boxMin.x : boxMax.x,
+                         plane.y >= 0.0f ? boxMin.y : boxMax.y,
+                         plane.z >= 0.0f ? boxMin.z : boxMax.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BoundingSphereSoA::Clear() {
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    radius.clear();
+}
+
+void BoundingSphereSoA::Add(const glm::vec3& center, float sphereRadius) {
+    centerX.push_back(center.x);
+    centerY.push_back(center.y);
+    centerZ.push_back(center.z);
+    radius.push_back(sphereRadius);
+}
+
+uint32 CullSpheres(const Frustum& frustum, const BoundingSphereSoA& spheres, std::vector<uint32>& outVisible) {
+    const size_t first = outVisible.size();
+    outVisible.resize(first + spheres.Size());
+    simd::SphereArrays arrays;
+    arrays.centerX = spheres.centerX.data();
+    arrays.centerY = spheres.centerY.data();
+    arrays.centerZ = spheres.centerZ.data();
+    arrays.radius = spheres.radius.data();
+    size_t visible = simd::CullSpheres(frustum.planes, arrays, spheres.Size(), outVisible.data() + first);
+    outVisible.resize(first + visible);
+    return static_cast<uint32>(visible);
+}
+
+} // namespace metagfx
@@ -0,0 +1,893 @@
+// ============================================================================
+// src/scene/GLTFLoader.cpp
+// ============================================================================
+#include "metagfx/scene/GLTFLoader.h"
+#include "metagfx/scene/MeshoptDecoder.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/SimdMath.h"
+#include "metagfx/utils/Json.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+namespace metagfx {
+
+constexpr uint32 GLB_MAGIC = 0x46546C67;       // "glTF"
+constexpr uint32 GLB_VERSION = 2;
+constexpr uint32 GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+constexpr uint32 GLB_CHUNK_BIN = 0x004E4942;   // "BIN\0"
+
+// Accessor component types
+constexpr int64 COMPONENT_BYTE = 5120;
+constexpr int64 COMPONENT_UNSIGNED_BYTE = 5121;
+constexpr int64 COMPONENT_SHORT = 5122;
+constexpr int64 COMPONENT_UNSIGNED_SHORT = 5123;
+constexpr int64 COMPONENT_UNSIGNED_INT = 5125;
+constexpr int64 COMPONENT_FLOAT = 5126;
+
+// Primitive topologies (0-3 are points and lines)
+constexpr int64 MODE_TRIANGLES = 4;
+constexpr int64 MODE_TRIANGLE_STRIP = 5;
+constexpr int64 MODE_TRIANGLE_FAN = 6;
+
+constexpr uint32 MAX_NODE_DEPTH = 256;
+
+// Extensions a file may require and still be loaded here
+static const char* const SUPPORTED_EXTENSIONS[] = {
+    "KHR_mesh_quantization",
+    "EXT_meshopt_compression",
+    "KHR_texture_basisu",
+    "KHR_materials_emissive_strength",
+};
+
+struct ByteSpan {
+    const uint8* data = nullptr;
+    uint64 size = 0;
+};
+
+struct BufferViewEntry {
+    ByteSpan span;
+    uint32 stride = 0;  // 0 = tightly packed
+    bool resolved = false;
+    bool valid = false;
+};
+
+// Parsing state of one Load() call
+struct GLTFDocument {
+    utils::JsonValue root;
+    std::filesystem::path baseDir;
+    std::vector<ByteSpan> buffers;  // Null data: buffer without content (meshopt fallback)
+    std::vector<BufferViewEntry> views;
+    std::vector<std::vector<uint8>>* ownedData = nullptr;
+};
+
+// Element layout of one accessor, resolved against its buffer view
+struct AccessorView {
+    const uint8* data = nullptr;  // nullptr: no buffer view, every element is zero
+    uint64 count = 0;
+    int64 componentType = 0;
+    uint32 componentSize = 0;
+    uint32 componentCount = 0;
+    uint32 stride = 0;
+    bool normalized = false;
+};
+
+static uint32 ReadU32(const uint8* data) {
+    uint32 value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+bool GLTFLoader::IsGLTFFile(const std::string& filepath) {
+    std::string extension = std::filesystem::path(filepath).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    return extension == ".gltf" || extension == ".glb";
+}
+
+// ----------------------------------------------------------------------------
+// URIs
+// ----------------------------------------------------------------------------
+
+static bool IsDataURI(const std::string& uri) {
+    return uri.compare(0, 5, "data:") == 0;
+}
+
+static std::string DecodePercentEscapes(const std::string& uri) {
+    auto hexValue = [](char c) -> int {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    };
+
+    std::string result;
+    result.reserve(uri.size());
+    for (size_t i = 0; i < uri.size(); ++i) {
+        if (uri[i] == '%' && i + 2 < uri.size() && hexValue(uri[i + 1]) >= 0 && hexValue(uri[i + 2]) >= 0) {
+            result += static_cast<char>(hexValue(uri[i + 1]) * 16 + hexValue(uri[i + 2]));
+            i += 2;
+        } else {
+            result += uri[i];
+        }
+    }
+    return result;
+}
+
+// Decode a base64 "data:" URI; other encodings are not used by glTF
+static bool DecodeDataURI(const std::string& uri, std::vector<uint8>& out) {
+    size_t marker = uri.find(";base64,");
+    if (marker == std::string::npos) {
+        return false;
+    }
+
+    auto sextet = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+
+    out.clear();
+    out.reserve((uri.size() - marker) / 4 * 3);
+
+    uint32 accumulator = 0;
+    uint32 bits = 0;
+    for (size_t i = marker + 8; i < uri.size() && uri[i] != '='; ++i) {
+        int value = sextet(uri[i]);
+        if (value < 0) {
+            return false;
+        }
+        accumulator = (accumulator << 6) | static_cast<uint32>(value);
+        bits += 6;
+        if (bits >= 8) {
+            bits -= 8;
+            out.push_back(static_cast<uint8>(accumulator >> bits));
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Buffers, buffer views and accessors
+// ----------------------------------------------------------------------------
+
+static MeshoptFilter ParseMeshoptFilter(const std::string& name) {
+    if (name == "OCTAHEDRAL") return MeshoptFilter::Octahedral;
+    if (name == "QUATERNION") return MeshoptFilter::Quaternion;
+    if (name == "EXPONENTIAL") return MeshoptFilter::Exponential;
+    return MeshoptFilter::None;
+}
+
+// Decode an EXT_meshopt_compression buffer view into owned storage
+static bool DecodeMeshoptView(GLTFDocument& doc, const utils::JsonValue& meshopt, ByteSpan& out) {
+    int64 bufferIndex = meshopt["buffer"].AsInt(-1);
+    uint64 offset = static_cast<uint64>(meshopt["byteOffset"].AsInt(0));
+    uint64 length = static_cast<uint64>(meshopt["byteLength"].AsInt(0));
+    uint64 stride = static_cast<uint64>(meshopt["byteStride"].AsInt(0));
+    uint64 count = static_cast<uint64>(meshopt["count"].AsInt(0));
+    const std::string& mode = meshopt["mode"].AsString();
+
+    if (bufferIndex < 0 || static_cast<size_t>(bufferIndex) >= doc.buffers.size() || stride == 0) {
+        return false;
+    }
+    const ByteSpan& buffer = doc.buffers[bufferIndex];
+    if (!buffer.data || offset + length > buffer.size) {
+        return false;
+    }
+    const uint8* source = buffer.data + offset;
+
+    std::vector<uint8> decoded(count * stride);
+    bool ok = false;
+    if (mode == "ATTRIBUTES") {
+        ok = DecodeMeshoptVertexBuffer(decoded.data(), count, stride, source, length) &&
+             ApplyMeshoptFilter(decoded.data(), count, stride, ParseMeshoptFilter(meshopt["filter"].AsString()));
+    } else if (mode == "TRIANGLES") {
+        ok = DecodeMeshoptIndexBuffer(decoded.data(), count, stride, source, length);
+    } else if (mode == "INDICES") {
+        ok = DecodeMeshoptIndexSequence(decoded.data(), count, stride, source, length);
+    }
+    if (!ok) {
+        return false;
+    }
+
+    doc.ownedData->push_back(std::move(decoded));
+    out.data = doc.ownedData->back().data();
+    out.size = doc.ownedData->back().size();
+    return true;
+}
+
+// Resolve (and on first use decode) a buffer view
+static const BufferViewEntry* GetBufferView(GLTFDocument& doc, int64 index) {
+    if (index < 0 || static_cast<size_t>(index) >= doc.views.size()) {
+        return nullptr;
+    }
+
+    BufferViewEntry& entry = doc.views[index];
+    if (!entry.resolved) {
+        entry.resolved = true;
+
+        const utils::JsonValue& view = doc.root["bufferViews"][static_cast<size_t>(index)];
+        entry.stride = static_cast<uint32>(view["byteStride"].AsInt(0));
+
+        const utils::JsonValue& meshopt = view["extensions"]["EXT_meshopt_compression"];
+        if (meshopt.IsObject()) {
+            entry.valid = DecodeMeshoptView(doc, meshopt, entry.span);
+        } else {
+            int64 bufferIndex = view["buffer"].AsInt(-1);
+            uint64 offset = static_cast<uint64>(view["byteOffset"].AsInt(0));
+            uint64 length = static_cast<uint64>(view["byteLength"].AsInt(0));
+            if (bufferIndex >= 0 && static_cast<size_t>(bufferIndex) < doc.buffers.size()) {
+                const ByteSpan& buffer = doc.buffers[bufferIndex];
+                if (buffer.data && offset + length <= buffer.size) {
+                    entry.span = { buffer.data + offset, length };
+                    entry.valid = true;
+                }
+            }
+        }
+    }
+    return entry.valid ? &entry : nullptr;
+}
+
+static uint32 GetComponentSize(int64 componentType) {
+    switch (componentType) {
+        case COMPONENT_BYTE:
+        case COMPONENT_UNSIGNED_BYTE: return 1;
+        case COMPONENT_SHORT:
+        case COMPONENT_UNSIGNED_SHORT: return 2;
+        case COMPONENT_UNSIGNED_INT:
+        case COMPONENT_FLOAT: return 4;
+        default: return 0;
+    }
+}
+
+static uint32 GetComponentCount(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT2") return 4;
+    if (type == "MAT3") return 9;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+static bool ResolveAccessor(GLTFDocument& doc, int64 index, AccessorView& out) {
+    const utils::JsonValue& accessor = doc.root["accessors"][static_cast<size_t>(index < 0 ? SIZE_MAX : index)];
+    if (!accessor.IsObject()) {
+        METAGFX_WARN << "glTF: invalid accessor " << index;
+        return false;
+    }
+    if (accessor.Has("sparse")) {
+        METAGFX_WARN << "glTF: sparse accessors are not supported";
+        return false;
+    }
+
+    out.count = static_cast<uint64>(accessor["count"].AsInt(0));
+    out.componentType = accessor["componentType"].AsInt(0);
+    out.componentSize = GetComponentSize(out.componentType);
+    out.componentCount = GetComponentCount(accessor["type"].AsString());
+    out.normalized = accessor["normalized"].AsBool(false);
+    if (out.componentSize == 0 || out.componentCount == 0) {
+        METAGFX_WARN << "glTF: accessor " << index << " has an invalid type";
+        return false;
+    }
+
+    uint32 elementSize = out.componentSize * out.componentCount;
+    out.stride = elementSize;
+    out.data = nullptr;
+
+    if (accessor.Has("bufferView")) {
+        const BufferViewEntry* view = GetBufferView(doc, accessor["bufferView"].AsInt(-1));
+        if (!view) {
+            METAGFX_WARN << "glTF: accessor " << index << " references an invalid buffer view";
+            return false;
+        }
+        if (view->stride != 0) {
+            out.stride = view->stride;
+        }
+
+        uint64 offset = static_cast<uint64>(accessor["byteOffset"].AsInt(0));
+        uint64 required = out.count == 0 ? 0 : (out.count - 1) * out.stride + elementSize;
+        if (offset + required > view->span.size) {
+            METAGFX_WARN << "glTF: accessor " << index << " exceeds its buffer view";
+            return false;
+        }
+        out.data = view->span.data + offset;
+    }
+    return true;
+}
+
+static float ReadComponent(const uint8* data, int64 componentType, bool normalized) {
+    switch (componentType) {
+        case COMPONENT_BYTE: {
+            int8 value = static_cast<int8>(*data);
+            return normalized ? std::max(value / 127.0f, -1.0f) : static_cast<float>(value);
+        }
+        case COMPONENT_UNSIGNED_BYTE:
+            return normalized ? *data / 255.0f : static_cast<float>(*data);
+        case COMPONENT_SHORT: {
+            int16 value;
+            std::memcpy(&value, data, sizeof(value));
+            return normalized ? std::max(value / 32767.0f, -1.0f) : static_cast<float>(value);
+        }
+        case COMPONENT_UNSIGNED_SHORT: {
+            uint16 value;
+            std::memcpy(&value, data, sizeof(value));
+            return normalized ? value / 65535.0f : static_cast<float>(value);
+        }
+        case COMPONENT_UNSIGNED_INT: {
+            uint32 value;
+            std::memcpy(&value, data, sizeof(value));
+            return static_cast<float>(value);
+        }
+        default: {
+            float value;
+            std::memcpy(&value, data, sizeof(value));
+            return value;
+        }
+    }
+}
+
+// Convert up to `components` components of every element to float and write them to
+// out + i * outStride, i.e. straight into a field of the interleaved vertex array
+static void ReadFloats(const AccessorView& accessor, uint32 components, uint8* out, size_t outStride) {
+    uint32 readCount = std::min(components, accessor.componentCount);
+    for (uint64 i = 0; i < accessor.count; ++i) {
+        float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        if (accessor.data) {
+            const uint8* element = accessor.data + i * accessor.stride;
+            for (uint32 c = 0; c < readCount; ++c) {
+                values[c] = ReadComponent(element + c * accessor.componentSize, accessor.componentType,
+                                          accessor.normalized);
+            }
+        }
+        std::memcpy(out + i * outStride, values, components * sizeof(float));
+    }
+}
+
+static bool ReadIndices(const AccessorView& accessor, std::vector<uint32>& out) {
+    if (accessor.componentCount != 1 ||
+        (accessor.componentType != COMPONENT_UNSIGNED_BYTE &&
+         accessor.componentType != COMPONENT_UNSIGNED_SHORT &&
+         accessor.componentType != COMPONENT_UNSIGNED_INT)) {
+        METAGFX_WARN << "glTF: invalid index accessor type";
+        return false;
+    }
+
+    out.resize(accessor.count);
+    for (uint64 i = 0; i < accessor.count; ++i) {
+        uint32 value = 0;
+        if (accessor.data) {
+            const uint8* element = accessor.data + i * accessor.stride;
+            if (accessor.componentSize == 1) {
+                value = *element;
+            } else if (accessor.componentSize == 2) {
+                uint16 index16;
+                std::memcpy(&index16, element, sizeof(index16));
+                value = index16;
+            } else {
+                std::memcpy(&value, element, sizeof(value));
+            }
+        }
+        out[i] = value;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Meshes and nodes
+// ----------------------------------------------------------------------------
+
+// Strips and fans become lists (what aiProcess_Triangulate does on the Assimp path)
+static void TriangulateIndices(int64 mode, std::vector<uint32>& indices) {
+    if (mode == MODE_TRIANGLES || indices.size() < 3) {
+        if (mode != MODE_TRIANGLES) {
+            indices.clear();
+        }
+        indices.resize(indices.size() - indices.size() % 3);
+        return;
+    }
+
+    std::vector<uint32> triangles;
+    triangles.reserve((indices.size() - 2) * 3);
+    for (size_t i = 0; i + 2 < indices.size(); ++i) {
+        if (mode == MODE_TRIANGLE_STRIP) {
+            // Every other triangle is flipped to keep a consistent winding
+            bool odd = (i % 2) != 0;
+            triangles.push_back(indices[i]);
+            triangles.push_back(indices[odd ? i + 2 : i + 1]);
+            triangles.push_back(indices[odd ? i + 1 : i + 2]);
+        } else {
+            triangles.push_back(indices[i + 1]);
+            triangles.push_back(indices[i + 2]);
+            triangles.push_back(indices[0]);
+        }
+    }
+    indices = std::move(triangles);
+}
+
+// Area-weighted vertex normals for primitives without a NORMAL attribute
+static void GenerateSmoothNormals(std::vector<Vertex>& vertices, const std::vector<uint32>& indices) {
+    for (Vertex& vertex : vertices) {
+        vertex.normal = glm::vec3(0.0f);
+    }
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+        Vertex& v0 = vertices[indices[i + 0]];
+        Vertex& v1 = vertices[indices[i + 1]];
+        Vertex& v2 = vertices[indices[i + 2]];
+        glm::vec3 faceNormal = glm::cross(v1.position - v0.position, v2.position - v0.position);
+        v0.normal = v0.normal + faceNormal;
+        v1.normal = v1.normal + faceNormal;
+        v2.normal = v2.normal + faceNormal;
+    }
+    for (Vertex& vertex : vertices) {
+        float length = glm::length(vertex.normal);
+        vertex.normal = length > 0.0f ? vertex.normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+    }
+}
+
+static glm::mat4 GetLocalTransform(const utils::JsonValue& node) {
+    glm::mat4 transform(1.0f);
+
+    const utils::JsonValue& matrix = node["matrix"];
+    if (matrix.Size() == 16) {
+        // Column-major, like glm
+        for (int column = 0; column < 4; ++column) {
+            for (int row = 0; row < 4; ++row) {
+                transform[column][row] = matrix[static_cast<size_t>(column * 4 + row)].AsFloat();
+            }
+        }
+        return transform;
+    }
+
+    // T * R * S
+    const utils::JsonValue& t = node["translation"];
+    const utils::JsonValue& r = node["rotation"];
+    const utils::JsonValue& s = node["scale"];
+
+    float x = r[0].AsFloat(0.0f), y = r[1].AsFloat(0.0f), z = r[2].AsFloat(0.0f), w = r[3].AsFloat(1.0f);
+    transform[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f);
+    transform[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f);
+    transform[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+
+    transform[0] = transform[0] * s[0].AsFloat(1.0f);
+    transform[1] = transform[1] * s[1].AsFloat(1.0f);
+    transform[2] = transform[2] * s[2].AsFloat(1.0f);
+    transform[3] = glm::vec4(t[0].AsFloat(0.0f), t[1].AsFloat(0.0f), t[2].AsFloat(0.0f), 1.0f);
+    return transform;
+}
+
+// Read one primitive into out, baking the node's world transform into the vertices.
+// Returns false when the file cannot be loaded natively; point and line primitives
+// are skipped (skipped = true), as aiProcess_Triangulate leaves nothing drawable for them.
+static bool ExtractPrimitive(GLTFDocument& doc, const utils::JsonValue& primitive, const glm::mat4& world,
+                             size_t materialCount, MeshData& out, bool& skipped) {
+    int64 mode = primitive["mode"].AsInt(MODE_TRIANGLES);
+    skipped = mode < MODE_TRIANGLES || mode > MODE_TRIANGLE_FAN;
+    if (skipped) {
+        METAGFX_WARN << "glTF: skipping point/line primitive";
+        return true;
+    }
+
+    const utils::JsonValue& attributes = primitive["attributes"];
+    AccessorView positions;
+    if (!attributes.Has("POSITION") || !ResolveAccessor(doc, attributes["POSITION"].AsInt(-1), positions) ||
+        positions.componentCount != 3) {
+        METAGFX_WARN << "glTF: primitive without valid positions";
+        return false;
+    }
+
+    std::vector<Vertex>& vertices = out.vertexStorage;
+    vertices.resize(positions.count);
+    uint8* vertexBytes = reinterpret_cast<uint8*>(vertices.data());
+
+    ReadFloats(positions, 3, vertexBytes + offsetof(Vertex, position), sizeof(Vertex));
+
+    bool hasNormals = attributes.Has("NORMAL");
+    if (hasNormals) {
+        AccessorView normals;
+        if (!ResolveAccessor(doc, attributes["NORMAL"].AsInt(-1), normals) ||
+            normals.componentCount != 3 || normals.count != positions.count) {
+            return false;
+        }
+        ReadFloats(normals, 3, vertexBytes + offsetof(Vertex, normal), sizeof(Vertex));
+    }
+
+    AccessorView texCoords;
+    if (attributes.Has("TEXCOORD_0")) {
+        if (!ResolveAccessor(doc, attributes["TEXCOORD_0"].AsInt(-1), texCoords) ||
+            texCoords.componentCount != 2 || texCoords.count != positions.count) {
+            return false;
+        }
+    } else {
+        texCoords.count = positions.count;  // No data: zeros
+        texCoords.componentCount = 2;
+    }
+    ReadFloats(texCoords, 2, vertexBytes + offsetof(Vertex, texCoord), sizeof(Vertex));
+
+    // The spec ignores tangents of a primitive without normals
+    bool hasTangents = hasNormals && attributes.Has("TANGENT");
+    if (hasTangents) {
+        AccessorView tangents;
+        if (!ResolveAccessor(doc, attributes["TANGENT"].AsInt(-1), tangents) ||
+            tangents.componentCount != 4 || tangents.count != positions.count) {
+            return false;
+        }
+        ReadFloats(tangents, 4, vertexBytes + offsetof(Vertex, tangent), sizeof(Vertex));
+    }
+
+    // Indices (a non-indexed primitive draws its vertices in order)
+    std::vector<uint32>& indices = out.indexStorage;
+    if (primitive.Has("indices")) {
+        AccessorView indexAccessor;
+        if (!ResolveAccessor(doc, primitive["indices"].AsInt(-1), indexAccessor) ||
+            !ReadIndices(indexAccessor, indices)) {
+            return false;
+        }
+    } else {
+        indices.resize(vertices.size());
+        for (size_t i = 0; i < indices.size(); ++i) {
+            indices[i] = static_cast<uint32>(i);
+        }
+    }
+    TriangulateIndices(mode, indices);
+
+    for (uint32 index : indices) {
+        if (index >= vertices.size()) {
+            METAGFX_WARN << "glTF: index out of range";
+            return false;
+        }
+    }
+
+    // Bake the world transform (this is also what dequantizes KHR_mesh_quantization positions).
+    // Tangents lie in the surface and transform like positions; a mirroring transform
+    // flips their handedness along with the winding.
+    glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(world)));
+    bool mirrored = glm::determinant(glm::mat3(world)) < 0.0f;
+    for (Vertex& vertex : vertices) {
+        vertex.position = glm::vec3(world * glm::vec4(vertex.position, 1.0f));
+        if (hasNormals) {
+            glm::vec3 normal = normalMatrix * vertex.normal;
+            float length = glm::length(normal);
+            vertex.normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+        if (hasTangents) {
+            glm::vec3 tangent = glm::mat3(world) * glm::vec3(vertex.tangent);
+            float length = glm::length(tangent);
+            float handedness = (vertex.tangent.w < 0.0f) != mirrored ? -1.0f : 1.0f;
+            vertex.tangent = glm::vec4(length > 0.0f ? tangent / length : tangent, handedness);
+        }
+    }
+
+    // A mirroring transform flips the winding
+    if (mirrored) {
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            std::swap(indices[i + 1], indices[i + 2]);
+        }
+    }
+
+    if (!hasNormals) {
+        GenerateSmoothNormals(vertices, indices);
+    }
+    if (!hasTangents) {
+        ComputeTangents(vertices.data(), static_cast<uint32>(vertices.size()),
+                        indices.data(), static_cast<uint32>(indices.size()));
+    }
+
+    int64 material = primitive["material"].AsInt(-1);
+    out.materialIndex = (material >= 0 && static_cast<size_t>(material) < materialCount)
+        ? static_cast<uint32>(material)
+        : static_cast<uint32>(materialCount);  // Out of range = default material
+
+    out.vertices = vertices.data();
+    out.vertexCount = static_cast<uint32>(vertices.size());
+    out.indices = indices.data();
+    out.indexCount = static_cast<uint32>(indices.size());
+
+    out.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    out.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    if (!vertices.empty()) {
+        simd::ComputeBounds(&vertices[0].position, vertices.size(), sizeof(Vertex), out.boundsMin, out.boundsMax);
+    }
+    return true;
+}
+
+static bool ExtractMesh(GLTFDocument& doc, int64 meshIndex, const glm::mat4& world, ModelData& model,
+                        const std::atomic<bool>* cancelled) {
+    const utils::JsonValue& mesh = doc.root["meshes"][static_cast<size_t>(meshIndex < 0 ? SIZE_MAX : meshIndex)];
+    if (!mesh.IsObject()) {
+        METAGFX_WARN << "glTF: invalid mesh " << meshIndex;
+        return false;
+    }
+
+    for (const utils::JsonValue& primitive : mesh["primitives"].GetArray()) {
+        if (cancelled && cancelled->load()) {
+            return true;
+        }
+
+        MeshData data;
+        bool skipped = false;
+        if (!ExtractPrimitive(doc, primitive, world, model.materials.size(), data, skipped)) {
+            return false;
+        }
+        if (!skipped) {
+            model.meshes.push_back(std::move(data));
+        }
+    }
+    return true;
+}
+
+// Depth-first, each node's meshes before its children (the order Assimp produces)
+static bool CollectNode(GLTFDocument& doc, int64 nodeIndex, const glm::mat4& parent, uint32 depth,
+                        ModelData& model, const std::atomic<bool>* cancelled) {
+    const utils::JsonValue& node = doc.root["nodes"][static_cast<size_t>(nodeIndex < 0 ? SIZE_MAX : nodeIndex)];
+    if (!node.IsObject() || depth > MAX_NODE_DEPTH) {
+        METAGFX_WARN << "glTF: invalid node hierarchy at node " << nodeIndex;
+        return false;
+    }
+
+    glm::mat4 world = parent * GetLocalTransform(node);
+    if (node.Has("mesh") && !ExtractMesh(doc, node["mesh"].AsInt(-1), world, model, cancelled)) {
+        return false;
+    }
+
+    for (const utils::JsonValue& child : node["children"].GetArray()) {
+        if (!CollectNode(doc, child.AsInt(-1), world, depth + 1, model, cancelled)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Materials and images
+// ----------------------------------------------------------------------------
+
+static std::string GetTextureReference(const GLTFDocument& doc, const utils::JsonValue& textureInfo,
+                                       const std::vector<std::string>& imageRefs) {
+    if (!textureInfo.IsObject()) {
+        return {};
+    }
+
+    int64 index = textureInfo["index"].AsInt(-1);
+    const utils::JsonValue& texture = doc.root["textures"][static_cast<size_t>(index < 0 ? SIZE_MAX : index)];
+
+    // KTX2 (Basis Universal) source when the file provides one
+    int64 source = texture["extensions"]["KHR_texture_basisu"]["source"].AsInt(texture["source"].AsInt(-1));
+    if (source < 0 || static_cast<size_t>(source) >= imageRefs.size()) {
+        return {};
+    }
+    return imageRefs[source];
+}
+
+static MaterialDesc ExtractMaterialDesc(const GLTFDocument& doc, const utils::JsonValue& material,
+                                        const std::vector<std::string>& imageRefs) {
+    MaterialDesc desc;
+
+    const utils::JsonValue& pbr = material["pbrMetallicRoughness"];
+    const utils::JsonValue& baseColor = pbr["baseColorFactor"];
+    desc.albedo = glm::vec3(baseColor[0].AsFloat(1.0f), baseColor[1].AsFloat(1.0f), baseColor[2].AsFloat(1.0f));
+    desc.roughness = pbr["roughnessFactor"].AsFloat(1.0f);
+    desc.metallic = pbr["metallicFactor"].AsFloat(1.0f);
+    desc.alpha = baseColor[3].AsFloat(1.0f);
+
+    const std::string& alphaMode = material["alphaMode"].AsString();
+    if (alphaMode == "MASK") {
+        desc.alphaMode = AlphaMode::Mask;
+        desc.alphaCutoff = material["alphaCutoff"].AsFloat(0.5f);
+    } else if (alphaMode == "BLEND") {
+        desc.alphaMode = AlphaMode::Blend;
+    }
+
+    const utils::JsonValue& emissive = material["emissiveFactor"];
+    float emissiveStrength = material["extensions"]["KHR_materials_emissive_strength"]["emissiveStrength"].AsFloat(1.0f);
+    desc.emissiveFactor = glm::vec3(emissive[0].AsFloat(0.0f), emissive[1].AsFloat(0.0f), emissive[2].AsFloat(0.0f)) *
+                          emissiveStrength;
+    desc.hasEmissiveFactor = true;
+
+    desc.albedoMap = GetTextureReference(doc, pbr["baseColorTexture"], imageRefs);
+    desc.metallicRoughnessMap = GetTextureReference(doc, pbr["metallicRoughnessTexture"], imageRefs);
+    desc.normalMap = GetTextureReference(doc, material["normalTexture"], imageRefs);
+    desc.aoMap = GetTextureReference(doc, material["occlusionTexture"], imageRefs);
+    desc.emissiveMap = GetTextureReference(doc, material["emissiveTexture"], imageRefs);
+    return desc;
+}
+
+// ----------------------------------------------------------------------------
+// Loading
+// ----------------------------------------------------------------------------
+
+void GLTFLoader::Close() {
+    m_File.Close();
+    m_ExternalBuffers.clear();
+    m_OwnedData.clear();
+}
+
+bool GLTFLoader::Load(const std::string& filepath, ModelData& outData, const std::atomic<bool>* cancelled) {
+    Close();
+    outData = ModelData{};
+
+    auto fail = [&](const char* reason) {
+        METAGFX_WARN << "glTF: " << reason << ": " << filepath;
+        outData = ModelData{};
+        Close();
+        return false;
+    };
+
+    if (!m_File.Open(filepath)) {
+        return fail("cannot open file");
+    }
+    const uint8* fileData = m_File.GetData();
+    uint64 fileSize = m_File.GetSize();
+
+    // GLB: 12-byte header, JSON chunk, optional BIN chunk. Otherwise the file is the JSON.
+    const char* jsonText = reinterpret_cast<const char*>(fileData);
+    uint64 jsonSize = fileSize;
+    ByteSpan binChunk;
+
+    if (fileSize >= 12 && ReadU32(fileData) == GLB_MAGIC) {
+        uint64 length = ReadU32(fileData + 8);
+        if (ReadU32(fileData + 4) != GLB_VERSION || length > fileSize) {
+            return fail("unsupported or truncated GLB");
+        }
+
+        jsonText = nullptr;
+        for (uint64 offset = 12; offset + 8 <= length;) {
+            uint64 chunkLength = ReadU32(fileData + offset);
+            uint32 chunkType = ReadU32(fileData + offset + 4);
+            offset += 8;
+            if (offset + chunkLength > length) {
+                return fail("truncated GLB chunk");
+            }
+
+            if (chunkType == GLB_CHUNK_JSON && !jsonText) {
+                jsonText = reinterpret_cast<const char*>(fileData + offset);
+                jsonSize = chunkLength;
+            } else if (chunkType == GLB_CHUNK_BIN && !binChunk.data) {
+                binChunk = { fileData + offset, chunkLength };
+            }
+            offset += chunkLength;
+        }
+        if (!jsonText) {
+            return fail("GLB without JSON chunk");
+        }
+    }
+
+    GLTFDocument doc;
+    doc.ownedData = &m_OwnedData;
+    doc.baseDir = std::filesystem::path(filepath).parent_path();
+
+    std::string parseError;
+    if (!utils::JsonValue::Parse(jsonText, jsonSize, doc.root, &parseError)) {
+        METAGFX_WARN << "glTF: " << parseError;
+        return fail("invalid JSON");
+    }
+    const utils::JsonValue& root = doc.root;
+
+    if (root["asset"]["version"].AsString().compare(0, 2, "2.") != 0) {
+        return fail("not a glTF 2.0 file");
+    }
+
+    for (const utils::JsonValue& required : root["extensionsRequired"].GetArray()) {
+        bool supported = false;
+        for (const char* extension : SUPPORTED_EXTENSIONS) {
+            supported = supported || required.AsString() == extension;
+        }
+        if (!supported) {
+            METAGFX_WARN << "glTF: required extension " << required.AsString() << " is not supported";
+            return fail("unsupported extension");
+        }
+    }
+
+    // Nodes are baked into the vertices here; skins, morph targets and clips need them
+    // kept, which the Assimp path does
+    bool morphTargets = false;
+    for (const utils::JsonValue& mesh : root["meshes"].GetArray()) {
+        for (const utils::JsonValue& primitive : mesh["primitives"].GetArray()) {
+            morphTargets = morphTargets || primitive["targets"].Size() > 0;
+        }
+    }
+    if (morphTargets || root["skins"].Size() > 0 || root["animations"].Size() > 0) {
+        return fail("animated model");
+    }
+
+    // Buffers: the GLB BIN chunk, data URIs or mapped external files
+    const utils::JsonValue& buffers = root["buffers"];
+    doc.buffers.resize(buffers.Size());
+    for (size_t i = 0; i < buffers.Size(); ++i) {
+        const utils::JsonValue& buffer = buffers[i];
+        const std::string& uri = buffer["uri"].AsString();
+        uint64 byteLength = static_cast<uint64>(buffer["byteLength"].AsInt(0));
+        ByteSpan& span = doc.buffers[i];
+
+        if (uri.empty()) {
+            if (i == 0 && binChunk.data) {
+                span = binChunk;
+            }
+        } else if (IsDataURI(uri)) {
+            std::vector<uint8> decoded;
+            if (!DecodeDataURI(uri, decoded)) {
+                return fail("invalid buffer data URI");
+            }
+            m_OwnedData.push_back(std::move(decoded));
+            span = { m_OwnedData.back().data(), m_OwnedData.back().size() };
+        } else {
+            utils::MappedFile file;
+            if (file.Open((doc.baseDir / DecodePercentEscapes(uri)).string())) {
+                span = { file.GetData(), file.GetSize() };
+                m_ExternalBuffers.push_back(std::move(file));
+            } else if (!buffer["extensions"]["EXT_meshopt_compression"]["fallback"].AsBool(false)) {
+                METAGFX_WARN << "glTF: cannot open buffer " << uri;
+                return fail("missing buffer");
+            }
+        }
+
+        if (span.data && span.size < byteLength) {
+            return fail("buffer shorter than its byteLength");
+        }
+    }
+    doc.views.resize(root["bufferViews"].Size());
+
+    // Images: embedded ones are numbered in image order ("*N", as Assimp numbers them)
+    std::vector<std::string> imageRefs;
+    for (const utils::JsonValue& image : root["images"].GetArray()) {
+        const std::string& uri = image["uri"].AsString();
+        if (image.Has("bufferView") || IsDataURI(uri)) {
+            EmbeddedTexture texture;
+            if (image.Has("bufferView")) {
+                const BufferViewEntry* view = GetBufferView(doc, image["bufferView"].AsInt(-1));
+                if (!view) {
+                    return fail("invalid image buffer view");
+                }
+                texture.data = view->span.data;  // Zero-copy view into the GLB
+                texture.size = view->span.size;
+            } else {
+                std::vector<uint8> decoded;
+                if (!DecodeDataURI(uri, decoded)) {
+                    return fail("invalid image data URI");
+                }
+                m_OwnedData.push_back(std::move(decoded));
+                texture.data = m_OwnedData.back().data();
+                texture.size = m_OwnedData.back().size();
+            }
+            imageRefs.push_back("*" + std::to_string(outData.embeddedTextures.size()));
+            outData.embeddedTextures.push_back(texture);
+        } else {
+            imageRefs.push_back(DecodePercentEscapes(uri));
+        }
+    }
+
+    for (const utils::JsonValue& material : root["materials"].GetArray()) {
+        outData.materials.push_back(ExtractMaterialDesc(doc, material, imageRefs));
+    }
+
+    // Default scene; a file without scenes still gets its meshes, untransformed
+    const utils::JsonValue& scenes = root["scenes"];
+    if (scenes.Size() > 0) {
+        const utils::JsonValue& scene = scenes[static_cast<size_t>(root["scene"].AsInt(0))];
+        for (const utils::JsonValue& node : scene["nodes"].GetArray()) {
+            if (!CollectNode(doc, node.AsInt(-1), glm::mat4(1.0f), 0, outData, cancelled)) {
+                return fail("unsupported geometry");
+            }
+        }
+    } else {
+        for (size_t i = 0; i < root["meshes"].Size(); ++i) {
+            if (!ExtractMesh(doc, static_cast<int64>(i), glm::mat4(1.0f), outData, cancelled)) {
+                return fail("unsupported geometry");
+            }
+        }
+    }
+
+    METAGFX_INFO << "glTF: " << outData.meshes.size() << " primitives, " << outData.materials.size()
+                 << " materials, " << outData.embeddedTextures.size() << " embedded images";
+    return true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,490 @@
+// ============================================================================
+// src/scene/GPUCuller.cpp
+// ============================================================================
+#include "metagfx/scene/GPUCuller.h"
+#include "metagfx/scene/Frustum.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/Texture.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+
+// Must match local_size_x of cull.comp and local_size_x/y of depth_pyramid.comp
+constexpr uint32 CULL_GROUP_SIZE = 64;
+constexpr uint32 PYRAMID_GROUP_SIZE = 8;
+
+// Push constants of cull.comp
+struct CullPushConstants {
+    uint32 resetCount;  // Clear the shadow draw count instead of culling
+};
+
+// Push constants of depth_pyramid.comp
+struct PyramidPushConstants {
+    uint32 srcOffset;
+    uint32 dstOffset;
+    uint32 srcWidth;
+    uint32 srcHeight;
+    uint32 dstWidth;
+    uint32 dstHeight;
+    uint32 fromTexture;  // Level 0 reads the depth texture, the others the previous level
+    uint32 minOffset;    // Of the nearest-depth chain, after the farthest
+    glm::vec2 regionScale;  // Level 0: of the depth texture drawn, its top-left region
+    uint32 padding1[2];
+};
+
+GPUCuller::GPUCuller(Ref<rhi::GraphicsDevice> device, rhi::UniformRingBuffer& uniforms,
+                     Ref<rhi::Shader> cullShader, Ref<rhi::Shader> pyramidShader)
+    : m_Device(device)
+    , m_Uniforms(uniforms) {
+    using namespace rhi;
+
+    m_CompactShadows = device->GetDeviceInfo().supportsDrawIndirectCount;
+    // Without multi-draw a mesh's meshlets would each be a separate indirect draw
+    m_MeshletDraws = device->GetDeviceInfo().supportsMultiDrawIndirect;
+    m_FramesInFlight = std::max(1u, device->GetDeviceInfo().framesInFlight);
+
+    // Stands in for the pyramid until there is a depth buffer
+    BufferDesc placeholderDesc{};
+    placeholderDesc.size = 16;
+    placeholderDesc.usage = BufferUsage::Storage;
+    placeholderDesc.memoryUsage = MemoryUsage::GPUOnly;
+    placeholderDesc.debugName = "DepthPyramidPlaceholder";
+    m_Pyramid = device->CreateBuffer(placeholderDesc);
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // Pipelines take the layout of the active set; resources are bound later
+    DescriptorSetDesc cullLayoutDesc;
+    cullLayoutDesc.bindings = {
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Compute, nullptr, nullptr, nullptr, sizeof(CullUniforms) },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Draw records
+        { 2, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Camera draws
+        { 3, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Shadow draws
+        { 4, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Shadow draw count
+        { 5, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Depth pyramid
+        { 6, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }   // Mesh levels
+    };
+    cullLayoutDesc.debugName = "CullLayout";
+    Ref<DescriptorSet> cullLayout = device->CreateDescriptorSet(cullLayoutDesc);
+
+    ComputePipelineDesc cullDesc{};
+    cullDesc.computeShader = cullShader;
+    cullDesc.pushConstantSize = sizeof(CullPushConstants);
+    cullDesc.debugName = "CullPipeline";
+    cullDesc.descriptorSetLayout = cullLayout;
+    m_CullPipeline = device->CreateComputePipeline(cullDesc);
+
+    DescriptorSetDesc pyramidLayoutDesc;
+    pyramidLayoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },  // Depth buffer
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }    // Pyramid
+    };
+    pyramidLayoutDesc.debugName = "DepthPyramidLayout";
+    Ref<DescriptorSet> pyramidLayout = device->CreateDescriptorSet(pyramidLayoutDesc);
+
+    ComputePipelineDesc pyramidDesc{};
+    pyramidDesc.computeShader = pyramidShader;
+    pyramidDesc.pushConstantSize = sizeof(PyramidPushConstants);
+    pyramidDesc.debugName = "DepthPyramidPipeline";
+    pyramidDesc.descriptorSetLayout = pyramidLayout;
+    m_PyramidPipeline = device->CreateComputePipeline(pyramidDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "GPU culling unavailable: failed to create compute pipelines";
+        return;
+    }
+    METAGFX_INFO << "GPU culling initialized (" << (m_CompactShadows ? "compacted" : "in-place")
+                 << " shadow draws, " << (m_MeshletDraws ? "meshlet" : "mesh") << " records)";
+}
+
+GPUCuller::~GPUCuller() = default;
+
+bool GPUCuller::SetModel(const Model* model) {
+    using namespace rhi;
+
+    m_Device->Retire(std::vector<Ref<Buffer>>{ m_MeshData, m_ClusterRecords, m_MeshLods, m_CameraDraws, m_ShadowDraws,
+                                               m_ShadowDrawCount });
+    m_Device->Retire(m_CullDescriptorSet);
+    m_MeshData.reset();
+    m_ClusterRecords.reset();
+    m_ClusterCount = 0;
+    m_MeshLods.reset();
+    m_MappedMeshLods = nullptr;
+    m_CameraDraws.reset();
+    m_ShadowDraws.reset();
+    m_ShadowDrawCount.reset();
+    m_CullDescriptorSet.reset();
+    m_MeshCount = 0;
+    m_DrawCount = 0;
+    m_RecordCount = 0;
+    m_MeshFirstDraw.clear();
+
+    // The draws index the pool's buffers, like Model::GetDrawList()
+    if (!IsValid() || !model || !model->GetDrawList()) {
+        return false;
+    }
+
+    std::vector<MeshCullData> records;
+    records.reserve(model->GetMeshCount());
+    std::vector<uint32> meshFirstDraw;
+    meshFirstDraw.reserve(model->GetMeshCount() + 1);
+    // Model::GetDrawList()'s rule: without the feature every node is the identity
+    bool nodeInstances = m_Device->GetDeviceInfo().supportsDrawIndirectFirstInstance;
+    const auto& meshes = model->GetMeshes();
+    const BoundingSphereSoA& bounds = model->GetMeshBounds();
+    uint32 drawCount = 0;
+    for (size_t i = 0; i < meshes.size(); ++i) {
+        const Mesh& mesh = *meshes[i];
+        meshFirstDraw.push_back(drawCount);
+
+        // Without multi-draw a mesh has one command, whichever level draws it
+        auto addRecord = [&](MeshCullData record) {
+            record.drawSlot = m_MeshletDraws ? drawCount++ : meshFirstDraw.back();
+            records.push_back(record);
+        };
+
+        MeshCullData record{};
+        record.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+        record.vertexOffset = mesh.GetVertexOffset();
+        record.firstInstance = nodeInstances ? model->GetMeshNode(i) : 0;
+        record.mesh = static_cast<uint32>(i);
+        glm::vec4 meshSphere(bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i], bounds.radius[i]);
+        for (uint32 lod = 1; lod < mesh.GetLodCount(); ++lod) {
+            record.sphere = meshSphere;
+            record.indexCount = mesh.GetLodIndexCount(lod);
+            record.firstIndex = mesh.GetLodFirstIndex(lod);
+            record.lod = lod;
+            addRecord(record);
+        }
+        record.lod = 0;
+        if (!m_MeshletDraws) {
+            ++drawCount;
+        }
+        if (!m_MeshletDraws || mesh.GetMeshlets().empty()) {
+            record.sphere = meshSphere;
+            record.indexCount = mesh.GetIndexCount();
+            record.firstIndex = mesh.GetFirstIndex();
+            addRecord(record);
+            continue;
+        }
+
+        // Meshlet bounds are in the mesh's space: move them into the model's like the mesh
+        // bounds. A cone only survives a rotation and uniform scale that keeps the winding.
+        const glm::mat4& world = model->GetNodeWorldTransform(model->GetMeshNode(i));
+        glm::vec3 axisScale(glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                            glm::length(glm::vec3(world[2])));
+        float scale = std::max({ axisScale.x, axisScale.y, axisScale.z });
+        bool keepsCones = glm::determinant(glm::mat3(world)) > 0.0f &&
+                          scale <= std::min({ axisScale.x, axisScale.y, axisScale.z }) * 1.001f;
+        for (const Meshlet& meshlet : mesh.GetMeshlets()) {
+            record.sphere = glm::vec4(glm::vec3(world * glm::vec4(meshlet.center, 1.0f)), meshlet.radius * scale);
+            record.cone = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+            if (keepsCones && meshlet.coneCutoff < 1.0f) {
+                record.cone = glm::vec4(glm::normalize(glm::mat3(world) * meshlet.coneAxis), meshlet.coneCutoff);
+            }
+            record.indexCount = meshlet.indexCount;
+            record.firstIndex = mesh.GetFirstIndex() + meshlet.firstIndex;
+            addRecord(record);
+        }
+    }
+    uint32 meshCount = static_cast<uint32>(meshes.size());
+    uint32 recordCount = static_cast<uint32>(records.size());
+    meshFirstDraw.push_back(drawCount);
+
+    // Number the triangles in clusters; a meshlet fits one
+    std::vector<uint32> clusterRecords;
+    for (uint32 i = 0; i < recordCount; ++i) {
+        records[i].firstCluster = static_cast<uint32>(clusterRecords.size());
+        uint32 triangles = records[i].indexCount / 3;
+        clusterRecords.insert(clusterRecords.end(), (triangles + CLUSTER_TRIANGLES - 1) / CLUSTER_TRIANGLES, i);
+    }
+    if (clusterRecords.empty()) {
+        clusterRecords.push_back(0);
+    }
+
+    BufferDesc meshDesc{};
+    meshDesc.size = recordCount * sizeof(MeshCullData);
+    meshDesc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    meshDesc.memoryUsage = MemoryUsage::GPUOnly;
+    meshDesc.debugName = "CullMeshData";
+    m_MeshData = m_Device->CreateBuffer(meshDesc);
+
+    BufferDesc clusterDesc = meshDesc;
+    clusterDesc.size = clusterRecords.size() * sizeof(uint32);
+    clusterDesc.debugName = "CullClusterRecords";
+    m_ClusterRecords = m_Device->CreateBuffer(clusterDesc);
+
+    // The camera commands, then their visibility copies
+    BufferDesc drawDesc{};
+    drawDesc.size = 2 * drawCount * sizeof(DrawIndexedIndirectCommand);
+    drawDesc.usage = BufferUsage::Storage | BufferUsage::Indirect;
+    drawDesc.memoryUsage = MemoryUsage::GPUOnly;
+    drawDesc.debugName = "CullCameraDraws";
+    m_CameraDraws = m_Device->CreateBuffer(drawDesc);
+    drawDesc.size = drawCount * sizeof(DrawIndexedIndirectCommand);
+    drawDesc.debugName = "CullShadowDraws";
+    m_ShadowDraws = m_Device->CreateBuffer(drawDesc);
+
+    BufferDesc countDesc{};
+    countDesc.size = sizeof(uint32);
+    countDesc.usage = BufferUsage::Storage | BufferUsage::Indirect;
+    countDesc.memoryUsage = MemoryUsage::GPUOnly;
+    countDesc.debugName = "CullShadowDrawCount";
+    m_ShadowDrawCount = m_Device->CreateBuffer(countDesc);
+
+    // Written before every cull, so a frame in flight keeps its own
+    BufferDesc lodDesc{};
+    lodDesc.size = static_cast<uint64>(meshCount) * m_FramesInFlight * sizeof(uint32);
+    lodDesc.usage = BufferUsage::Storage;
+    lodDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    lodDesc.debugName = "CullMeshLods";
+    m_MeshLods = m_Device->CreateBuffer(lodDesc);
+
+    if (!m_MeshData || !m_ClusterRecords || !m_MeshLods || !m_CameraDraws || !m_ShadowDraws || !m_ShadowDrawCount) {
+        METAGFX_ERROR << "GPU culling: failed to create buffers for " << drawCount << " draws";
+        m_MeshData.reset();
+        m_ClusterRecords.reset();
+        m_MeshLods.reset();
+        m_CameraDraws.reset();
+        m_ShadowDraws.reset();
+        m_ShadowDrawCount.reset();
+        return false;
+    }
+    m_MeshData->CopyData(records.data(), meshDesc.size);
+    m_ClusterRecords->CopyData(clusterRecords.data(), clusterDesc.size);
+    m_MappedMeshLods = static_cast<uint32*>(m_MeshLods->GetMappedPointer());
+
+    m_MeshCount = meshCount;
+    m_DrawCount = drawCount;
+    m_RecordCount = recordCount;
+    m_ClusterCount = static_cast<uint32>(clusterRecords.size());
+    m_MeshFirstDraw = std::move(meshFirstDraw);
+    if (recordCount != meshCount) {
+        METAGFX_INFO << "GPU culling: " << recordCount << " records (meshlets and levels of detail) in "
+                     << meshCount << " meshes";
+    }
+    CreateCullDescriptorSet();
+    return true;
+}
+
+void GPUCuller::CreateCullDescriptorSet() {
+    using namespace rhi;
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Compute, m_Uniforms.GetBuffer(), nullptr, nullptr, sizeof(CullUniforms) },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_MeshData, nullptr, nullptr },
+        { 2, DescriptorType::StorageBuffer, ShaderStage::Compute, m_CameraDraws, nullptr, nullptr },
+        { 3, DescriptorType::StorageBuffer, ShaderStage::Compute, m_ShadowDraws, nullptr, nullptr },
+        { 4, DescriptorType::StorageBuffer, ShaderStage::Compute, m_ShadowDrawCount, nullptr, nullptr },
+        { 5, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Pyramid, nullptr, nullptr },
+        { 6, DescriptorType::StorageBuffer, ShaderStage::Compute, m_MeshLods, nullptr, nullptr }
+    };
+    desc.debugName = "CullDescriptorSet";
+    m_CullDescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void GPUCuller::SetDepthSize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (width == m_DepthWidth && height == m_DepthHeight) {
+        return;
+    }
+    m_DepthWidth = width;
+    m_DepthHeight = height;
+    m_PyramidValid = false;
+    if (!IsValid() || width == 0 || height == 0) {
+        return;
+    }
+
+    // Level 0 halves the depth buffer, each further level halves the previous one
+    // (rounding up) down to 1x1
+    m_PyramidLevels.clear();
+    uint32 levelWidth = std::max(1u, (width + 1) / 2);
+    uint32 levelHeight = std::max(1u, (height + 1) / 2);
+    uint32 offset = 0;
+    while (m_PyramidLevels.size() < MAX_PYRAMID_LEVELS) {
+        m_PyramidLevels.push_back({ offset, levelWidth, levelHeight });
+        offset += levelWidth * levelHeight;
+        if (levelWidth == 1 && levelHeight == 1) {
+            break;
+        }
+        levelWidth = std::max(1u, (levelWidth + 1) / 2);
+        levelHeight = std::max(1u, (levelHeight + 1) / 2);
+    }
+
+    // The nearest-depth chain follows the farthest, level for level
+    m_MinDepthOffset = offset;
+    BufferDesc pyramidDesc{};
+    pyramidDesc.size = static_cast<uint64>(offset) * 2 * sizeof(float);
+    pyramidDesc.usage = BufferUsage::Storage;
+    pyramidDesc.memoryUsage = MemoryUsage::GPUOnly;
+    pyramidDesc.debugName = "DepthPyramid";
+    Ref<Buffer> pyramid = m_Device->CreateBuffer(pyramidDesc);
+    if (!pyramid) {
+        METAGFX_ERROR << "GPU culling: failed to create depth pyramid";
+        return;
+    }
+
+    m_Device->Retire(m_Pyramid);
+    m_Device->Retire(m_PyramidDescriptorSet);
+    m_Pyramid = pyramid;
+    m_PyramidDescriptorSet.reset();
+    CreatePyramidDescriptorSet();
+
+    // The cull set reads the pyramid too
+    if (m_CullDescriptorSet) {
+        m_Device->Retire(m_CullDescriptorSet);
+        CreateCullDescriptorSet();
+    }
+}
+
+void GPUCuller::SetDepthSource(Ref<rhi::Texture> depthTexture) {
+    if (depthTexture == m_DepthTexture) {
+        return;
+    }
+    if (depthTexture && (depthTexture->GetWidth() != m_DepthWidth || depthTexture->GetHeight() != m_DepthHeight)) {
+        METAGFX_WARN << "GPU culling: depth source is " << depthTexture->GetWidth() << "x" << depthTexture->GetHeight()
+                     << ", the pyramid was sized for " << m_DepthWidth << "x" << m_DepthHeight;
+        SetDepthSize(depthTexture->GetWidth(), depthTexture->GetHeight());
+    }
+
+    m_DepthTexture = depthTexture;
+    m_Device->Retire(m_PyramidDescriptorSet);
+    m_PyramidDescriptorSet.reset();
+    CreatePyramidDescriptorSet();
+}
+
+void GPUCuller::CreatePyramidDescriptorSet() {
+    using namespace rhi;
+
+    if (!IsValid() || !m_DepthTexture || m_PyramidLevels.empty()) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_DepthTexture, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Pyramid, nullptr, nullptr }
+    };
+    desc.debugName = "DepthPyramidDescriptorSet";
+    m_PyramidDescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void GPUCuller::Cull(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& modelMatrix,
+                     const glm::mat4& cameraViewProjection, const glm::vec3& cameraPosition,
+                     const glm::mat4& lightViewProjection, bool occlusion,
+                     const uint8* cameraLods, const uint8* shadowLods) {
+    using namespace rhi;
+
+    if (!HasModel()) {
+        return;
+    }
+
+    m_MeshLodScratch.resize(m_MeshCount);
+    for (uint32 mesh = 0; mesh < m_MeshCount; ++mesh) {
+        uint32 cameraLod = cameraLods ? cameraLods[mesh] : 0;
+        uint32 shadowLod = shadowLods ? shadowLods[mesh] : 0;
+        m_MeshLodScratch[mesh] = cameraLod | shadowLod << 8;
+    }
+    uint32 lodOffset = (frameIndex % m_FramesInFlight) * m_MeshCount;
+    if (m_MappedMeshLods) {
+        std::memcpy(m_MappedMeshLods + lodOffset, m_MeshLodScratch.data(), m_MeshCount * sizeof(uint32));
+    } else {
+        m_MeshLods->CopyData(m_MeshLodScratch.data(), m_MeshCount * sizeof(uint32),
+                             static_cast<uint64>(lodOffset) * sizeof(uint32));
+    }
+
+    CullUniforms uniforms{};
+    uniforms.occlusionMatrix = m_PyramidViewProjection * modelMatrix;
+    Frustum cameraFrustum = Frustum::FromMatrix(cameraViewProjection * modelMatrix);
+    Frustum lightFrustum = Frustum::FromMatrix(lightViewProjection * modelMatrix);
+    for (uint32 i = 0; i < 6; ++i) {
+        uniforms.cameraPlanes[i] = cameraFrustum.planes[i];
+        uniforms.lightPlanes[i] = lightFrustum.planes[i];
+    }
+    uniforms.cameraPosition = glm::inverse(modelMatrix) * glm::vec4(cameraPosition, 1.0f);
+    uniforms.drawCount = m_RecordCount;
+    uniforms.occlusionEnabled = (occlusion && m_PyramidValid) ? 1u : 0u;
+    uniforms.compactShadows = m_CompactShadows ? 1u : 0u;
+    uniforms.pyramidLevelCount = static_cast<uint32>(m_PyramidLevels.size());
+    uniforms.lodOffset = lodOffset;
+    uniforms.sharedSlots = m_MeshletDraws ? 0u : 1u;
+    uniforms.visibilityDrawBase = m_DrawCount;
+    uniforms.depthSize = glm::vec4(static_cast<float>(m_DepthWidth), static_cast<float>(m_DepthHeight), 0.0f, 0.0f);
+    for (size_t level = 0; level < m_PyramidLevels.size(); ++level) {
+        const PyramidLevel& info = m_PyramidLevels[level];
+        uniforms.pyramidLevels[level] = glm::uvec4(info.offset, info.width, info.height, 0);
+    }
+    uint32 uniformOffset = m_Uniforms.Push(uniforms);
+
+    cmd.BindPipeline(m_CullPipeline);
+    cmd.BindDescriptorSet(m_CullPipeline, m_CullDescriptorSet, frameIndex, &uniformOffset, 1);
+
+    // Clear the compacted count, then cull
+    CullPushConstants push{ 1 };
+    cmd.PushConstants(m_CullPipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(1);
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+
+    push.resetCount = 0;
+    cmd.PushConstants(m_CullPipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch((m_RecordCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE);
+}
+
+void GPUCuller::BuildDepthPyramid(rhi::CommandBuffer& cmd, uint32 frameIndex,
+                                  const glm::mat4& cameraViewProjection, uint32 regionWidth, uint32 regionHeight) {
+    using namespace rhi;
+
+    if (!IsValid() || !m_PyramidDescriptorSet) {
+        return;
+    }
+
+    cmd.BindPipeline(m_PyramidPipeline);
+    cmd.BindDescriptorSet(m_PyramidPipeline, m_PyramidDescriptorSet, frameIndex);
+
+    for (size_t level = 0; level < m_PyramidLevels.size(); ++level) {
+        const PyramidLevel& dst = m_PyramidLevels[level];
+        PyramidPushConstants push{};
+        push.dstOffset = dst.offset;
+        push.minOffset = m_MinDepthOffset;
+        push.dstWidth = dst.width;
+        push.dstHeight = dst.height;
+        if (level == 0) {
+            // The region drawn stands for the whole depth buffer, stretched over level 0
+            push.srcWidth = regionWidth ? std::min(regionWidth, m_DepthWidth) : m_DepthWidth;
+            push.srcHeight = regionHeight ? std::min(regionHeight, m_DepthHeight) : m_DepthHeight;
+            push.fromTexture = 1;
+            push.regionScale = glm::vec2(static_cast<float>(push.srcWidth) / static_cast<float>(m_DepthWidth),
+                                         static_cast<float>(push.srcHeight) / static_cast<float>(m_DepthHeight));
+        } else {
+            const PyramidLevel& src = m_PyramidLevels[level - 1];
+            push.srcOffset = src.offset;
+            push.srcWidth = src.width;
+            push.srcHeight = src.height;
+            cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        }
+
+        cmd.PushConstants(m_PyramidPipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((dst.width + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+                     (dst.height + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE);
+    }
+
+    m_PyramidViewProjection = cameraViewProjection;
+    m_PyramidValid = true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,69 @@
+// ============================================================================
+// src/scene/GeometryPool.cpp
+// ============================================================================
+#include "metagfx/scene/GeometryPool.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/core/Logger.h"
+
+namespace metagfx {
+
+bool GeometryPool::Initialize(rhi::GraphicsDevice* device, VertexFormat format,
+                              uint32 vertexCapacity, uint32 indexCapacity, bool positionStream, bool deformable) {
+    if (!device || vertexCapacity == 0 || indexCapacity == 0) {
+        METAGFX_ERROR << "GeometryPool::Initialize - Invalid parameters";
+        return false;
+    }
+
+    // Pooled meshes may also be traced (RayTracingScene). Shaders read the buffers as
+    // storage too: where a ray hit them (PathTracer), when resolving a visibility buffer,
+    // and when vertex pulling fetches the vertices instead of the input assembler.
+    const rhi::DeviceInfo& info = device->GetDeviceInfo();
+    rhi::BufferUsage traceUsage = info.supportsAccelerationStructures
+                                      ? rhi::BufferUsage::AccelerationStructureInput
+                                      : rhi::BufferUsage{};
+    auto createBuffer = [device, traceUsage](uint64 size, rhi::BufferUsage usage) {
+        rhi::BufferDesc desc = {};
+        desc.size = size;
+        desc.usage = usage | rhi::BufferUsage::Storage | rhi::BufferUsage::TransferDst | traceUsage;
+        desc.memoryUsage = rhi::MemoryUsage::GPUOnly;
+        return device->CreateBuffer(desc);
+    };
+
+    m_VertexBuffer = createBuffer(static_cast<uint64>(vertexCapacity) * GetVertexStride(format), rhi::BufferUsage::Vertex);
+    m_IndexBuffer = createBuffer(static_cast<uint64>(indexCapacity) * sizeof(uint32), rhi::BufferUsage::Index);
+    if (positionStream) {
+        m_PositionBuffer = createBuffer(static_cast<uint64>(vertexCapacity) * GetPositionInputLayout(format).stride,
+                                        rhi::BufferUsage::Vertex);
+    }
+
+    if (!m_VertexBuffer || !m_IndexBuffer || (positionStream && !m_PositionBuffer)) {
+        METAGFX_ERROR << "GeometryPool::Initialize - Failed to create buffers";
+        m_VertexBuffer.reset();
+        m_IndexBuffer.reset();
+        m_PositionBuffer.reset();
+        return false;
+    }
+
+    m_VertexFormat = format;
+    m_Deformable = deformable;
+    m_VertexCount = 0;
+    m_IndexCount = 0;
+    m_VertexCapacity = vertexCapacity;
+    m_IndexCapacity = indexCapacity;
+    return true;
+}
+
+bool GeometryPool::Allocate(uint32 vertexCount, uint32 indexCount, Allocation& outAllocation) {
+    if (vertexCount > m_VertexCapacity - m_VertexCount || indexCount > m_IndexCapacity - m_IndexCount) {
+        return false;
+    }
+
+    outAllocation.firstVertex = m_VertexCount;
+    outAllocation.firstIndex = m_IndexCount;
+    m_VertexCount += vertexCount;
+    m_IndexCount += indexCount;
+    return true;
+}
+
+} // namespace metagfx
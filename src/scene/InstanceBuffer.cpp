@@ -0,0 +1,118 @@
+// ============================================================================
+// src/scene/InstanceBuffer.cpp
+// ============================================================================
+#include "metagfx/scene/InstanceBuffer.h"
+#include "metagfx/scene/Scene.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+
+InstanceBuffer::InstanceBuffer(Ref<rhi::GraphicsDevice> device, uint32 nodeCapacity, uint32 instancesPerFrame,
+                               uint32 framesInFlight)
+    : m_NodeCapacity(nodeCapacity)
+    , m_InstancesPerFrame(instancesPerFrame)
+    , m_FramesInFlight(framesInFlight) {
+    using namespace rhi;
+
+    uint64 entryCount = static_cast<uint64>(nodeCapacity) + static_cast<uint64>(instancesPerFrame) * framesInFlight;
+
+    BufferDesc desc{};
+    desc.size = entryCount * sizeof(uint32);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "InstanceNodes";
+    m_Buffer = device->CreateBuffer(desc);
+    if (!m_Buffer) {
+        METAGFX_ERROR << "InstanceBuffer: failed to create " << desc.size << " byte buffer";
+        return;
+    }
+    m_MappedData = static_cast<uint32*>(m_Buffer->GetMappedPointer());
+
+    // Identity table: single draws pass their node as firstInstance
+    std::vector<uint32> identity(nodeCapacity);
+    for (uint32 i = 0; i < nodeCapacity; ++i) {
+        identity[i] = i;
+    }
+    if (m_MappedData) {
+        std::memcpy(m_MappedData, identity.data(), identity.size() * sizeof(uint32));
+    } else {
+        m_Buffer->CopyData(identity.data(), identity.size() * sizeof(uint32));
+    }
+    BeginFrame(0);
+}
+
+void InstanceBuffer::BeginFrame(uint32 frameIndex) {
+    m_FrameBase = m_NodeCapacity + (frameIndex % m_FramesInFlight) * m_InstancesPerFrame;
+    m_Offset = m_FrameBase;
+}
+
+uint32 InstanceBuffer::Push(const uint32* nodes, uint32 count) {
+    if (!m_Buffer || m_Offset + count > m_FrameBase + m_InstancesPerFrame) {
+        if (m_Buffer && !m_OverflowReported) {
+            METAGFX_WARN << "InstanceBuffer: frame region of " << m_InstancesPerFrame
+                         << " instances exhausted, drawing the rest one by one";
+            m_OverflowReported = true;
+        }
+        return INVALID_OFFSET;
+    }
+
+    uint32 offset = m_Offset;
+    if (m_MappedData) {
+        std::memcpy(m_MappedData + offset, nodes, count * sizeof(uint32));
+    } else {
+        m_Buffer->CopyData(nodes, count * sizeof(uint32), static_cast<uint64>(offset) * sizeof(uint32));
+    }
+    m_Offset += count;
+    return offset;
+}
+
+void InstanceBuffer::BuildBatches(const Scene& scene, const std::vector<uint32>& instances,
+                                  std::vector<DrawBatch>& outBatches, const std::vector<uint8>* lods) {
+    outBatches.clear();
+
+    m_Sorted.clear();
+    for (uint32 instance : instances) {
+        const MeshInstance& entry = scene.GetMeshInstance(instance);
+        if (entry.mesh && entry.node < m_NodeCapacity) {
+            uint32 lod = lods && instance < lods->size() ? (*lods)[instance] : 0;
+            m_Sorted.emplace_back(static_cast<uint64>(entry.userData) << 32 | lod, entry.node);
+        }
+    }
+    std::sort(m_Sorted.begin(), m_Sorted.end());
+
+    size_t groupStart = 0;
+    while (groupStart < m_Sorted.size()) {
+        uint64 key = m_Sorted[groupStart].first;
+        uint32 mesh = static_cast<uint32>(key >> 32);
+        uint32 lod = static_cast<uint32>(key);
+        size_t groupEnd = groupStart + 1;
+        while (groupEnd < m_Sorted.size() && m_Sorted[groupEnd].first == key) {
+            ++groupEnd;
+        }
+
+        uint32 count = static_cast<uint32>(groupEnd - groupStart);
+        uint32 offset = INVALID_OFFSET;
+        if (count > 1) {
+            m_Nodes.clear();
+            for (size_t i = groupStart; i < groupEnd; ++i) {
+                m_Nodes.push_back(m_Sorted[i].second);
+            }
+            offset = Push(m_Nodes.data(), count);
+        }
+
+        if (offset != INVALID_OFFSET) {
+            outBatches.push_back({ mesh, offset, count, lod });
+        } else {
+            for (size_t i = groupStart; i < groupEnd; ++i) {
+                outBatches.push_back({ mesh, m_Sorted[i].second, 1, lod });
+            }
+        }
+        groupStart = groupEnd;
+    }
+}
+
+} // namespace metagfx
@@ -7,8 +7,7 @@ namespace metagfx {
 
 // Verify std140 alignment at compile time
 static_assert(sizeof(LightData) == 64, "LightData must be 64 bytes for std140 alignment");
-static_assert(sizeof(LightBuffer) == 1040, "LightBuffer must be 1040 bytes");
-static_assert(offsetof(LightBuffer, lights) == 16, "lights array must start at offset 16");
+static_assert(sizeof(LightBufferHeader) == 16, "lights array must start at offset 16");
 
 // ============================================================================
 // Light Base Class
@@ -23,10 +22,12 @@ Light::Light(LightType type, const glm::vec3& color, float intensity)
 
 void Light::SetColor(const glm::vec3& color) {
     m_Color = color;
+    MarkDirty();
 }
 
 void Light::SetIntensity(float intensity) {
     m_Intensity = std::max(0.0f, intensity);  // Clamp to non-negative
+    MarkDirty();
 }
 
 // ============================================================================
@@ -43,6 +44,7 @@ DirectionalLight::DirectionalLight(const glm::vec3& direction,
 
 void DirectionalLight::SetDirection(const glm::vec3& direction) {
     m_Direction = glm::normalize(direction);
+    MarkDirty();
 }
 
 LightData DirectionalLight::ToGPUData() const {
@@ -81,15 +83,18 @@ PointLight::PointLight(const glm::vec3& position,
 
 void PointLight::SetPosition(const glm::vec3& position) {
     m_Position = position;
+    MarkDirty();
 }
 
 void PointLight::SetRange(float range) {
     m_Range = std::max(0.01f, range);  // Prevent division by zero
+    MarkDirty();
 }
 
 void PointLight::SetAttenuation(float constant, float linear) {
     m_AttenuationConstant = std::max(0.0f, constant);
     m_AttenuationLinear = std::max(0.0f, linear);
+    MarkDirty();
 }
 
 LightData PointLight::ToGPUData() const {
@@ -139,10 +144,12 @@ SpotLight::SpotLight(const glm::vec3& position,
 
 void SpotLight::SetPosition(const glm::vec3& position) {
     m_Position = position;
+    MarkDirty();
 }
 
 void SpotLight::SetDirection(const glm::vec3& direction) {
     m_Direction = glm::normalize(direction);
+    MarkDirty();
 }
 
 void SpotLight::SetConeAngles(float innerDegrees, float outerDegrees) {
@@ -154,15 +161,18 @@ void SpotLight::SetConeAngles(float innerDegrees, float outerDegrees) {
         std::swap(m_InnerConeAngle, m_OuterConeAngle);
         METAGFX_WARN << "SpotLight: outer cone angle was smaller than inner, swapped values";
     }
+    MarkDirty();
 }
 
 void SpotLight::SetRange(float range) {
     m_Range = std::max(0.01f, range);
+    MarkDirty();
 }
 
 void SpotLight::SetAttenuation(float constant, float linear) {
     m_AttenuationConstant = std::max(0.0f, constant);
     m_AttenuationLinear = std::max(0.0f, linear);
+    MarkDirty();
 }
 
 LightData SpotLight::ToGPUData() const {
@@ -0,0 +1,283 @@
+// ============================================================================
+// src/scene/LightClusters.cpp
+// ============================================================================
+#include "metagfx/scene/LightClusters.h"
+#include "metagfx/scene/Camera.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/SimdMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace metagfx {
+
+namespace {
+
+// Tile under an NDC coordinate. With the camera's Vulkan-convention projection, NDC y
+// grows downwards like gl_FragCoord.y on every backend.
+uint32 GetTile(float ndc, uint32 count) {
+    float tile = std::floor((ndc * 0.5f + 0.5f) * static_cast<float>(count));
+    return static_cast<uint32>(std::clamp(tile, 0.0f, static_cast<float>(count - 1)));
+}
+
+} // namespace
+
+LightClusters::LightClusters(Ref<rhi::GraphicsDevice> device, uint32 indicesPerFrame, uint32 framesInFlight)
+    : m_IndicesPerFrame(indicesPerFrame)
+    , m_FramesInFlight(std::max(framesInFlight, 1u)) {
+    using namespace rhi;
+
+    uint64 regionSize = static_cast<uint64>(CLUSTER_COUNT) * 2 + indicesPerFrame;
+
+    BufferDesc desc{};
+    desc.size = regionSize * m_FramesInFlight * sizeof(uint32);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "LightClusters";
+    m_Buffer = device->CreateBuffer(desc);
+    if (!m_Buffer) {
+        METAGFX_ERROR << "LightClusters: failed to create " << desc.size << " byte buffer";
+        return;
+    }
+    m_MappedData = static_cast<uint32*>(m_Buffer->GetMappedPointer());
+
+    // Empty clusters in every region until the first Build() of each
+    std::vector<uint32> empty(static_cast<size_t>(regionSize) * m_FramesInFlight, 0);
+    if (m_MappedData) {
+        std::memcpy(m_MappedData, empty.data(), empty.size() * sizeof(uint32));
+    } else {
+        m_Buffer->CopyData(empty.data(), empty.size() * sizeof(uint32));
+    }
+    m_Counts.resize(CLUSTER_COUNT);
+}
+
+void LightClusters::UpdateClusterBounds(const glm::mat4& projection, float nearPlane, float farPlane) {
+    m_BoundsProjection = projection;
+    m_NearPlane = nearPlane;
+    m_FarPlane = farPlane;
+
+    float logRatio = std::log(farPlane / nearPlane);
+    m_SliceScale = static_cast<float>(GRID_Z) / logRatio;
+    m_SliceBias = -static_cast<float>(GRID_Z) * std::log(nearPlane) / logRatio;
+
+    float sliceDepths[GRID_Z + 1];
+    for (uint32 z = 0; z <= GRID_Z; ++z) {
+        sliceDepths[z] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / static_cast<float>(GRID_Z));
+    }
+
+    // Point at a view depth on the ray through an NDC position: the ray is unprojected
+    // at two depths, which holds for perspective and orthographic projections alike. Both
+    // are finite: the camera's reverse-Z projection puts depth 0 at infinity.
+    glm::mat4 inverseProjection = glm::inverse(projection);
+    auto unproject = [&](float x, float y, float z) {
+        glm::vec4 point = inverseProjection * glm::vec4(x, y, z, 1.0f);
+        return glm::vec3(point) / point.w;
+    };
+
+    m_ClusterBounds.resize(CLUSTER_COUNT);
+    for (uint32 y = 0; y < GRID_Y; ++y) {
+        for (uint32 x = 0; x < GRID_X; ++x) {
+            glm::vec3 rayStart[4];
+            glm::vec3 rayEnd[4];
+            for (uint32 corner = 0; corner < 4; ++corner) {
+                float ndcX = static_cast<float>(x + (corner & 1)) / GRID_X * 2.0f - 1.0f;
+                float ndcY = static_cast<float>(y + (corner >> 1)) / GRID_Y * 2.0f - 1.0f;
+                rayStart[corner] = unproject(ndcX, ndcY, Camera::NEAR_DEPTH);
+                rayEnd[corner] = unproject(ndcX, ndcY, 0.5f);
+            }
+
+            for (uint32 z = 0; z < GRID_Z; ++z) {
+                ClusterBounds& bounds = m_ClusterBounds[x + y * GRID_X + z * GRID_X * GRID_Y];
+                bounds.min = glm::vec3(std::numeric_limits<float>::max());
+                bounds.max = glm::vec3(-std::numeric_limits<float>::max());
+                for (uint32 corner = 0; corner < 4; ++corner) {
+                    const glm::vec3& start = rayStart[corner];
+                    glm::vec3 delta = rayEnd[corner] - start;
+                    for (float depth : { sliceDepths[z], sliceDepths[z + 1] }) {
+                        glm::vec3 point = start + delta * ((depth + start.z) / -delta.z);
+                        bounds.min = glm::min(bounds.min, point);
+                        bounds.max = glm::max(bounds.max, point);
+                    }
+                }
+            }
+        }
+    }
+
+    m_ClusterBoxes.resize(CLUSTER_COUNT * 6);
+    for (uint32 cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        const ClusterBounds& bounds = m_ClusterBounds[cluster];
+        for (int axis = 0; axis < 3; ++axis) {
+            m_ClusterBoxes[axis * CLUSTER_COUNT + cluster] = bounds.min[axis];
+            m_ClusterBoxes[(axis + 3) * CLUSTER_COUNT + cluster] = bounds.max[axis];
+        }
+    }
+}
+
+uint32 LightClusters::GetSlice(float depth) const {
+    float slice = std::floor(std::log(depth) * m_SliceScale + m_SliceBias);
+    return static_cast<uint32>(std::clamp(slice, 0.0f, static_cast<float>(GRID_Z - 1)));
+}
+
+LightClusterParams LightClusters::Build(uint32 frameIndex, const std::vector<LightData>& lights, uint32 firstLocal,
+                                        const Camera& camera, uint32 width, uint32 height) {
+    const glm::mat4& view = camera.GetViewMatrix();
+    const glm::mat4& projection = camera.GetProjectionMatrix();
+    float nearPlane = camera.GetNearPlane();
+    float farPlane = camera.GetFarPlane();
+    if (projection != m_BoundsProjection || nearPlane != m_NearPlane || farPlane != m_FarPlane) {
+        UpdateClusterBounds(projection, nearPlane, farPlane);
+    }
+
+    m_PairClusters.clear();
+    m_PairLights.clear();
+    m_VisibleLights = 0;
+
+    for (uint32 i = firstLocal; i < lights.size(); ++i) {
+        const LightData& light = lights[i];
+        auto type = static_cast<LightType>(static_cast<uint32>(light.positionAndType.w));
+        if (type == LightType::Directional) {
+            continue;
+        }
+
+        glm::vec3 center = glm::vec3(view * glm::vec4(glm::vec3(light.positionAndType), 1.0f));
+        float radius = light.directionAndRange.w;
+        float depth = -center.z;
+        if (depth + radius < nearPlane || depth - radius > farPlane) {
+            continue;
+        }
+        uint32 firstSlice = GetSlice(std::max(depth - radius, nearPlane));
+        uint32 lastSlice = GetSlice(std::min(depth + radius, farPlane));
+
+        // Screen rectangle of the view-space bounding box; the whole screen when the box
+        // reaches behind the near plane
+        uint32 firstX = 0, lastX = GRID_X - 1;
+        uint32 firstY = 0, lastY = GRID_Y - 1;
+        if (depth - radius > nearPlane) {
+            glm::vec2 ndcMin(std::numeric_limits<float>::max());
+            glm::vec2 ndcMax(-std::numeric_limits<float>::max());
+            for (uint32 corner = 0; corner < 8; ++corner) {
+                glm::vec3 offset((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius,
+                                 (corner & 4) ? radius : -radius);
+                glm::vec4 clip = projection * glm::vec4(center + offset, 1.0f);
+                glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                ndcMin = glm::min(ndcMin, ndc);
+                ndcMax = glm::max(ndcMax, ndc);
+            }
+            if (ndcMax.x < -1.0f || ndcMin.x > 1.0f || ndcMax.y < -1.0f || ndcMin.y > 1.0f) {
+                continue;
+            }
+            firstX = GetTile(ndcMin.x, GRID_X);
+            lastX = GetTile(ndcMax.x, GRID_X);
+            firstY = GetTile(ndcMin.y, GRID_Y);
+            lastY = GetTile(ndcMax.y, GRID_Y);
+        }
+
+        // Spot lights: cone against the froxel's bounding sphere
+        bool spot = type == LightType::Spot;
+        glm::vec3 spotDirection(0.0f);
+        float coneSin = 0.0f;
+        float coneCos = 1.0f;
+        if (spot) {
+            spotDirection = glm::normalize(glm::mat3(view) * glm::vec3(light.directionAndRange));
+            coneSin = std::sin(light.spotAngles.y);
+            coneCos = std::cos(light.spotAngles.y);
+        }
+
+        // Each row of froxels is contiguous in x: test the sphere against it in one batch
+        bool visible = false;
+        uint32 rowLength = lastX - firstX + 1;
+        m_RowHits.resize(rowLength);
+        for (uint32 z = firstSlice; z <= lastSlice; ++z) {
+            for (uint32 y = firstY; y <= lastY; ++y) {
+                uint32 rowStart = firstX + y * GRID_X + z * GRID_X * GRID_Y;
+                simd::BoxArrays row;
+                row.minX = &m_ClusterBoxes[0 * CLUSTER_COUNT + rowStart];
+                row.minY = &m_ClusterBoxes[1 * CLUSTER_COUNT + rowStart];
+                row.minZ = &m_ClusterBoxes[2 * CLUSTER_COUNT + rowStart];
+                row.maxX = &m_ClusterBoxes[3 * CLUSTER_COUNT + rowStart];
+                row.maxY = &m_ClusterBoxes[4 * CLUSTER_COUNT + rowStart];
+                row.maxZ = &m_ClusterBoxes[5 * CLUSTER_COUNT + rowStart];
+                size_t hitCount = simd::OverlapSphereBoxes(center, radius, row, rowLength, m_RowHits.data());
+
+                for (size_t hit = 0; hit < hitCount; ++hit) {
+                    uint32 cluster = rowStart + m_RowHits[hit];
+                    const ClusterBounds& bounds = m_ClusterBounds[cluster];
+
+                    if (spot) {
+                        glm::vec3 sphereCenter = (bounds.min + bounds.max) * 0.5f;
+                        float sphereRadius = glm::length(bounds.max - bounds.min) * 0.5f;
+                        glm::vec3 toSphere = sphereCenter - center;
+                        float axial = glm::dot(toSphere, spotDirection);
+                        float lateral = std::sqrt(std::max(glm::dot(toSphere, toSphere) - axial * axial, 0.0f));
+                        float coneDistance = coneCos * lateral - axial * coneSin;
+                        if (coneDistance > sphereRadius || axial > sphereRadius + radius || axial < -sphereRadius) {
+                            continue;
+                        }
+                    }
+
+                    m_PairClusters.push_back(cluster);
+                    m_PairLights.push_back(i);
+                    visible = true;
+                }
+            }
+        }
+        if (visible) {
+            ++m_VisibleLights;
+        }
+    }
+
+    // Counting sort of the pairs by cluster; clusters keep their lights in light order.
+    // Lists past the index capacity are cut short.
+    uint32 pairCount = static_cast<uint32>(m_PairClusters.size());
+    if (pairCount > m_IndicesPerFrame) {
+        METAGFX_WARN_ONCE << "LightClusters: " << pairCount << " light indices exceed the frame region of "
+                          << m_IndicesPerFrame << ", dropping the rest";
+    }
+
+    uint32 regionBase = (frameIndex % m_FramesInFlight) * (CLUSTER_COUNT * 2 + m_IndicesPerFrame);
+    uint32 indexBase = regionBase + CLUSTER_COUNT * 2;
+
+    std::fill(m_Counts.begin(), m_Counts.end(), 0u);
+    for (uint32 cluster : m_PairClusters) {
+        ++m_Counts[cluster];
+    }
+
+    m_IndexCount = std::min(pairCount, m_IndicesPerFrame);
+    m_MaxLightsPerCluster = 0;
+    m_Region.resize(CLUSTER_COUNT * 2 + m_IndexCount);
+    uint32 offset = 0;
+    for (uint32 cluster = 0; cluster < CLUSTER_COUNT; ++cluster) {
+        uint32 count = std::min(m_Counts[cluster], m_IndexCount - offset);
+        m_Region[cluster * 2] = indexBase + offset;
+        m_Region[cluster * 2 + 1] = count;
+        m_MaxLightsPerCluster = std::max(m_MaxLightsPerCluster, count);
+        m_Counts[cluster] = offset;  // Now the cluster's write cursor
+        offset += count;
+    }
+    for (uint32 pair = 0; pair < pairCount; ++pair) {
+        uint32 cluster = m_PairClusters[pair];
+        uint32 end = m_Region[cluster * 2] - indexBase + m_Region[cluster * 2 + 1];
+        if (m_Counts[cluster] < end) {
+            m_Region[CLUSTER_COUNT * 2 + m_Counts[cluster]++] = m_PairLights[pair];
+        }
+    }
+
+    if (m_MappedData) {
+        std::memcpy(m_MappedData + regionBase, m_Region.data(), m_Region.size() * sizeof(uint32));
+    } else if (m_Buffer) {
+        m_Buffer->CopyData(m_Region.data(), m_Region.size() * sizeof(uint32),
+                           static_cast<uint64>(regionBase) * sizeof(uint32));
+    }
+
+    LightClusterParams params;
+    params.base = regionBase;
+    params.tileScale = glm::vec2(static_cast<float>(GRID_X) / static_cast<float>(std::max(width, 1u)),
+                                 static_cast<float>(GRID_Y) / static_cast<float>(std::max(height, 1u)));
+    params.depthScaleBias = glm::vec2(m_SliceScale, m_SliceBias);
+    return params;
+}
+
+} // namespace metagfx
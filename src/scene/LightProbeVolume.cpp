@@ -0,0 +1,381 @@
+// ============================================================================
+// src/scene/LightProbeVolume.cpp
+// ============================================================================
+#include "metagfx/scene/LightProbeVolume.h"
+#include "metagfx/scene/GeometryPool.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Scene.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+
+namespace metagfx {
+
+// Bindings of the main set the volume reads: frame constants, lights, prefiltered
+// environment, the scene's top level and the probes themselves
+constexpr uint32 PROBE_SCENE_BINDINGS[] = { 0, 3, 9, 22, LightProbeVolume::PROBE_BINDING };
+constexpr uint32 TOP_LEVEL_BINDING = 22;
+
+// Bindings of probe_update.comp besides the scene's, as path_trace.comp's
+constexpr uint32 MATERIAL_BINDING = 1;
+constexpr uint32 TEXTURE_TABLE_BINDING = 14;
+constexpr uint32 VERTEX_BINDING = 23;
+constexpr uint32 INDEX_BINDING = 24;
+constexpr uint32 INSTANCE_BINDING = 25;
+
+// Push constants of probe_update.comp
+struct UpdatePushConstants {
+    LightProbeVolume::GridHeader grid;  // counts.w: probes in the grid
+    uint32 firstProbe;
+    uint32 reset;        // 1: clear the probes and write the header, 0: trace them
+    uint32 updateIndex;  // Rotates the rays
+    float hysteresis;
+    uint32 environment;
+    float environmentIntensity;
+    uint32 padding[2];
+};
+
+Ref<rhi::Buffer> LightProbeVolume::CreateProbeBuffer(rhi::GraphicsDevice& device) {
+    rhi::BufferDesc desc{};
+    desc.size = PROBE_BUFFER_SIZE;
+    desc.usage = rhi::BufferUsage::Storage | rhi::BufferUsage::TransferDst;
+    desc.memoryUsage = rhi::MemoryUsage::GPUOnly;
+    desc.debugName = "LightProbes";
+    Ref<rhi::Buffer> buffer = device.CreateBuffer(desc);
+    if (buffer) {
+        std::vector<uint8> zeros(PROBE_BUFFER_SIZE, 0);
+        buffer->CopyData(zeros.data(), zeros.size());
+    }
+    return buffer;
+}
+
+LightProbeVolume::LightProbeVolume(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader,
+                                   const std::vector<rhi::DescriptorBindingDesc>& sceneBindings,
+                                   uint32 textureCapacity)
+    : m_Device(device), m_TextureCapacity(textureCapacity) {
+    using namespace rhi;
+
+    const DeviceInfo& info = device->GetDeviceInfo();
+    if (!info.supportsRayQuery || !info.supportsBindlessTextures || info.maxBindlessTextures < textureCapacity) {
+        METAGFX_INFO << "Light probes unavailable: the device lacks ray queries or bindless textures";
+        return;
+    }
+
+    for (const DescriptorBindingDesc& binding : sceneBindings) {
+        if (std::find(std::begin(PROBE_SCENE_BINDINGS), std::end(PROBE_SCENE_BINDINGS), binding.binding) !=
+            std::end(PROBE_SCENE_BINDINGS)) {
+            m_Bindings.push_back(binding);
+            m_Bindings.back().stageFlags = ShaderStage::Compute;
+            if (binding.binding == PROBE_BINDING) {
+                m_ProbeBuffer = binding.buffer;
+            }
+        }
+    }
+    if (m_Bindings.size() != std::size(PROBE_SCENE_BINDINGS) || !m_ProbeBuffer) {
+        METAGFX_ERROR << "Light probes unavailable: the scene bindings lack the lights, top level or probe buffer";
+        m_Bindings.clear();
+        m_ProbeBuffer.reset();
+        return;
+    }
+    m_Bindings.push_back({ MATERIAL_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ TEXTURE_TABLE_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr, 0, textureCapacity });
+    m_Bindings.push_back({ VERTEX_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ INDEX_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ INSTANCE_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+
+    GridHeader offHeader{};
+    BufferDesc headerDesc{};
+    headerDesc.size = sizeof(GridHeader);
+    headerDesc.usage = BufferUsage::TransferSrc;
+    headerDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    headerDesc.debugName = "LightProbeOffHeader";
+    m_OffHeader = device->CreateBuffer(headerDesc);
+    if (!m_OffHeader) {
+        METAGFX_ERROR << "Light probes unavailable: failed to create their header buffer";
+        return;
+    }
+    m_OffHeader->CopyData(&offHeader, sizeof(offHeader));
+
+    // The materials and geometry come later; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = m_Bindings;
+    layoutDesc.debugName = "LightProbeLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(UpdatePushConstants);
+    pipelineDesc.debugName = "LightProbeUpdatePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Light probes unavailable: failed to create their pipeline";
+        return;
+    }
+    METAGFX_INFO << "Light probe volume created: up to " << MAX_PROBES << " probes, " << RAY_COUNT
+                 << " rays per update";
+}
+
+void LightProbeVolume::SetSettings(const Settings& settings) {
+    bool regrid = settings.probesPerAxis != m_Settings.probesPerAxis;
+    m_Settings = settings;
+    m_Settings.probesPerFrame = std::max(m_Settings.probesPerFrame, 1u);
+    m_Settings.probesPerAxis = std::clamp(m_Settings.probesPerAxis, 2u, MAX_PROBES_PER_AXIS);
+    m_Settings.hysteresis = std::clamp(m_Settings.hysteresis, 0.0f, 0.99f);
+    if (regrid) {
+        PlaceProbes();
+    }
+}
+
+void LightProbeVolume::SetEnabled(bool enabled) {
+    if (enabled && !m_Enabled) {
+        m_ResetPending = true;
+    }
+    m_Enabled = enabled;
+}
+
+void LightProbeVolume::SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture,
+                                  Ref<rhi::Sampler> sampler) {
+    for (rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == binding) {
+            entry.buffer = buffer;
+            entry.texture = texture;
+            entry.sampler = sampler;
+        }
+    }
+    if (m_DescriptorSet) {
+        if (texture) {
+            m_DescriptorSet->UpdateTexture(binding, texture, sampler);
+        } else {
+            m_DescriptorSet->UpdateBuffer(binding, buffer);
+        }
+    } else {
+        CreateDescriptorSet();
+    }
+}
+
+void LightProbeVolume::SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler) {
+    SetBinding(binding, nullptr, texture, sampler);
+}
+
+void LightProbeVolume::SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer) {
+    SetBinding(binding, buffer, nullptr, nullptr);
+}
+
+void LightProbeVolume::SetTopLevel(Ref<rhi::AccelerationStructure> topLevel) {
+    if (topLevel == m_TopLevel) {
+        return;
+    }
+    m_TopLevel = topLevel;
+    for (rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == TOP_LEVEL_BINDING) {
+            entry.accelerationStructure = m_TopLevel;
+        }
+    }
+    if (m_DescriptorSet && m_TopLevel) {
+        m_DescriptorSet->UpdateAccelerationStructure(TOP_LEVEL_BINDING, m_TopLevel);
+    }
+}
+
+void LightProbeVolume::SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                                    Ref<rhi::Sampler> sampler) {
+    if (!IsValid()) {
+        return;
+    }
+    if (textures.size() > m_TextureCapacity) {
+        METAGFX_WARN << "Light probes: " << textures.size() << " material textures, " << m_TextureCapacity << " fit";
+        return;
+    }
+    m_Textures = textures;
+    m_TextureSampler = sampler;
+    SetBinding(MATERIAL_BINDING, materialBuffer, nullptr, nullptr);
+
+    // A set created just now wrote the table already
+    if (m_DescriptorSet) {
+        uint32 count = static_cast<uint32>(m_Textures.size());
+        for (uint32 i = 0; i < std::max(count, m_WrittenTextures); ++i) {
+            if (i < count) {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+            } else {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, nullptr, nullptr);
+            }
+        }
+        m_WrittenTextures = count;
+    }
+    m_ResetPending = true;
+}
+
+void LightProbeVolume::SetGeometry(const Scene& scene, const GeometryPool& pool,
+                                   const std::unordered_map<const Material*, uint32>& materialIndices) {
+    using namespace rhi;
+
+    if (!IsValid()) {
+        return;
+    }
+
+    // The instances as the path tracer lists them; the grid covers those it can hit
+    std::vector<InstanceData> instances(std::max(scene.GetMeshInstanceCount(), 1u));
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    for (uint32 i = 0; i < scene.GetMeshInstanceCount(); ++i) {
+        InstanceData& data = instances[i];
+        data = { 0, 0, NO_MATERIAL, 0 };
+
+        const MeshInstance& instance = scene.GetMeshInstance(i);
+        const Mesh* mesh = instance.mesh;
+        if (!mesh || mesh->GetVertexBuffer() != pool.GetVertexBuffer()) {
+            continue;
+        }
+        auto material = materialIndices.find(mesh->GetMaterial());
+        data.firstIndex = mesh->GetFirstIndex();
+        data.vertexOffset = mesh->GetVertexOffset();
+        data.materialIndex = material != materialIndices.end() ? material->second : 0;
+        data.compact = mesh->GetVertexFormat() == VertexFormat::Compact ? 1 : 0;
+
+        AABB local;
+        local.min = mesh->GetBoundsMin();
+        local.max = mesh->GetBoundsMax();
+        AABB bounds = AABB::Transform(local, instance.transform);
+        boundsMin = glm::min(boundsMin, bounds.min);
+        boundsMax = glm::max(boundsMax, bounds.max);
+    }
+
+    BufferDesc desc{};
+    desc.size = instances.size() * sizeof(InstanceData);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "LightProbeInstances";
+    Ref<Buffer> buffer = m_Device->CreateBuffer(desc);
+    if (!buffer) {
+        METAGFX_ERROR << "Light probes: failed to create " << desc.size << " byte instance buffer";
+        return;
+    }
+    buffer->CopyData(instances.data(), desc.size);
+
+    // Earlier frames in flight may still read the last one
+    for (const rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == INSTANCE_BINDING && entry.buffer) {
+            m_Device->Retire(entry.buffer);
+        }
+    }
+    SetBinding(VERTEX_BINDING, pool.GetVertexBuffer(), nullptr, nullptr);
+    SetBinding(INDEX_BINDING, pool.GetIndexBuffer(), nullptr, nullptr);
+    SetBinding(INSTANCE_BINDING, buffer, nullptr, nullptr);
+
+    if (boundsMin.x > boundsMax.x) {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+    }
+    m_BoundsMin = boundsMin;
+    m_BoundsMax = boundsMax;
+    PlaceProbes();
+}
+
+void LightProbeVolume::PlaceProbes() {
+    // Cubic cells, probesPerAxis along the longest side; the others get as many as
+    // cover them, at least two so every point lies between probes
+    glm::vec3 extent = m_BoundsMax - m_BoundsMin;
+    float longest = std::max(std::max(extent.x, extent.y), extent.z);
+    if (longest <= 0.0f) {
+        m_ProbeCount = 0;
+        return;
+    }
+    m_Spacing = longest / static_cast<float>(m_Settings.probesPerAxis - 1);
+    for (int axis = 0; axis < 3; ++axis) {
+        uint32 cells = static_cast<uint32>(std::ceil(extent[axis] / m_Spacing - 0.001f));
+        m_Counts[axis] = std::clamp(cells + 1, 2u, m_Settings.probesPerAxis);
+    }
+    glm::vec3 center = (m_BoundsMin + m_BoundsMax) * 0.5f;
+    m_Origin = center - (glm::vec3(m_Counts) - glm::vec3(1.0f)) * (m_Spacing * 0.5f);
+    m_ProbeCount = m_Counts.x * m_Counts.y * m_Counts.z;
+    m_ResetPending = true;
+}
+
+void LightProbeVolume::CreateDescriptorSet() {
+    using namespace rhi;
+
+    if (!IsValid() || m_DescriptorSet) {
+        return;
+    }
+    for (const DescriptorBindingDesc& binding : m_Bindings) {
+        // The top level may come later (SetTopLevel()), the table's elements after the set
+        bool bound = binding.buffer || binding.texture || binding.count > 1 ||
+                     binding.type == DescriptorType::AccelerationStructure;
+        if (!bound) {
+            return;
+        }
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = m_Bindings;
+    desc.debugName = "LightProbeDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+    if (!m_DescriptorSet) {
+        return;
+    }
+    m_WrittenTextures = static_cast<uint32>(m_Textures.size());
+    for (uint32 i = 0; i < m_WrittenTextures; ++i) {
+        m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+    }
+}
+
+void LightProbeVolume::Update(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset,
+                              const View& view) {
+    using namespace rhi;
+
+    if (!NeedsUpdate()) {
+        return;
+    }
+    if (!m_Enabled) {
+        cmd.CopyBuffer(m_OffHeader, m_ProbeBuffer, sizeof(GridHeader));
+        m_HeaderOn = false;
+        return;
+    }
+
+    UpdatePushConstants push{};
+    push.grid.origin = glm::vec4(m_Origin, 1.0f);
+    push.grid.spacing = glm::vec4(glm::vec3(m_Spacing), 0.0f);
+    push.grid.counts = glm::uvec4(m_Counts, m_ProbeCount);
+    push.hysteresis = m_Settings.hysteresis;
+    push.environment = view.environment ? 1 : 0;
+    push.environmentIntensity = view.environmentIntensity;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex, &frameUniformOffset, 1);
+
+    // The header, and every probe marked as never traced, so the first trace replaces
+    // its coefficients instead of blending into them
+    bool traceAll = false;
+    if (m_ResetPending) {
+        push.reset = 1;
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((m_ProbeCount + GROUP_SIZE - 1) / GROUP_SIZE);
+        m_ResetPending = false;
+        m_HeaderOn = true;
+        m_NextProbe = 0;
+        traceAll = true;
+        cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        push.reset = 0;
+    }
+
+    // One workgroup per probe; the dispatch wraps around the grid's end in the shader
+    uint32 probes = traceAll ? m_ProbeCount : std::min(m_Settings.probesPerFrame, m_ProbeCount);
+    push.firstProbe = m_NextProbe;
+    push.updateIndex = m_UpdateIndex++;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(probes);
+    m_NextProbe = (m_NextProbe + probes) % m_ProbeCount;
+}
+
+} // namespace metagfx
@@ -0,0 +1,72 @@
+// ============================================================================
+// src/scene/LodSelector.cpp
+// ============================================================================
+#include "metagfx/scene/LodSelector.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Scene.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metagfx {
+
+void LodSelector::Update(const Scene& scene, const glm::mat4& modelMatrix, const glm::mat4& projection,
+                         const glm::vec3& eye, float viewportHeight) {
+    uint32 instanceCount = scene.GetMeshInstanceCount();
+    if (m_CameraLods.size() != instanceCount) {
+        m_CameraLods.assign(instanceCount, 0);
+        m_ShadowLods.assign(instanceCount, 0);
+    }
+
+    // Pixels a unit spans at unit distance; an orthographic projection keeps it at any
+    bool perspective = projection[2][3] != 0.0f;
+    float pixelsPerUnit = std::abs(projection[1][1]) * viewportHeight * 0.5f;
+    float threshold = std::max(m_Settings.pixelThreshold, 0.0f);
+    float coarserThreshold = threshold * (1.0f - std::clamp(m_Settings.hysteresis, 0.0f, 1.0f));
+
+    m_HasCoarserLods = false;
+    for (uint32 instance = 0; instance < instanceCount; ++instance) {
+        const MeshInstance& entry = scene.GetMeshInstance(instance);
+        uint32 lodCount = entry.mesh ? entry.mesh->GetLodCount() : 1;
+        if (lodCount == 1) {
+            m_CameraLods[instance] = 0;
+            m_ShadowLods[instance] = 0;
+            continue;
+        }
+        const Mesh& mesh = *entry.mesh;
+
+        // Errors scale with the largest axis of the transform
+        glm::mat4 world = modelMatrix * entry.transform;
+        float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                                 glm::length(glm::vec3(world[2])) });
+        glm::vec3 center = glm::vec3(world * glm::vec4(mesh.GetBoundsCenter(), 1.0f));
+        float distance = perspective ? glm::length(center - eye) - mesh.GetBoundsRadius() * scale : 1.0f;
+
+        uint32 level = 0;
+        if (distance > 0.0f) {
+            float pixelsPerError = scale * pixelsPerUnit / distance;
+            for (uint32 lod = lodCount - 1; lod > 0; --lod) {
+                if (mesh.GetLodError(lod) * pixelsPerError <= threshold) {
+                    level = lod;
+                    break;
+                }
+            }
+            uint32 current = std::min<uint32>(m_CameraLods[instance], lodCount - 1);
+            while (level > current && mesh.GetLodError(level) * pixelsPerError > coarserThreshold) {
+                --level;
+            }
+        }
+
+        m_CameraLods[instance] = static_cast<uint8>(level);
+        m_ShadowLods[instance] = static_cast<uint8>(std::min(level + m_Settings.shadowBias, lodCount - 1));
+        m_HasCoarserLods = m_HasCoarserLods || m_ShadowLods[instance] > 0;
+    }
+}
+
+void LodSelector::Reset() {
+    m_CameraLods.clear();
+    m_ShadowLods.clear();
+    m_HasCoarserLods = false;
+}
+
+} // namespace metagfx
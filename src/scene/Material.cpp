@@ -14,8 +14,7 @@ Material::Material(const glm::vec3& albedo, float roughness, float metallic) {
     SetEmissiveFactor(glm::vec3(0.0f));  // Default: no emission
 
     // Initialize padding to zero
-    m_Properties.padding1[0] = 0.0f;
-    m_Properties.padding1[1] = 0.0f;
+    m_Properties.padding1 = 0.0f;
     m_Properties.padding2 = 0.0f;
 }
 
@@ -40,6 +39,26 @@ void Material::SetEmissiveFactor(const glm::vec3& emissive) {
     m_Properties.emissiveFactor = glm::max(emissive, glm::vec3(0.0f));
 }
 
+void Material::SetAlpha(float alpha) {
+    m_Properties.alpha = std::clamp(alpha, 0.0f, 1.0f);
+}
+
+void Material::SetAlphaMode(AlphaMode mode) {
+    // The shaders read the mode with the texture flags
+    m_AlphaMode = mode;
+    m_TextureFlags &= ~(static_cast<uint32>(MaterialTextureFlags::AlphaMask) |
+                        static_cast<uint32>(MaterialTextureFlags::AlphaBlend));
+    if (mode == AlphaMode::Mask) {
+        m_TextureFlags |= static_cast<uint32>(MaterialTextureFlags::AlphaMask);
+    } else if (mode == AlphaMode::Blend) {
+        m_TextureFlags |= static_cast<uint32>(MaterialTextureFlags::AlphaBlend);
+    }
+}
+
+void Material::SetAlphaCutoff(float cutoff) {
+    m_Properties.alphaCutoff = std::clamp(cutoff, 0.0f, 1.0f);
+}
+
 void Material::SetAlbedoMap(Ref<rhi::Texture> texture) {
     m_AlbedoMap = texture;
 
@@ -3,12 +3,284 @@
 // ============================================================================
 #include "metagfx/scene/Mesh.h"
 #include "metagfx/scene/Material.h"
+#include "metagfx/scene/GeometryPool.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Types.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/SimdMath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
 
 namespace metagfx {
 
+// ----------------------------------------------------------------------------
+// Compact vertex encoding
+// ----------------------------------------------------------------------------
+
+VertexQuantization VertexQuantization::FromBounds(const glm::vec3& boundsMin, const glm::vec3& boundsMax) {
+    VertexQuantization quantization;
+    quantization.offset = boundsMin;
+    glm::vec3 extent = boundsMax - boundsMin;
+    quantization.scale = std::max({ extent.x, extent.y, extent.z, 1e-6f });
+    return quantization;
+}
+
+glm::mat4 VertexQuantization::GetDequantizeMatrix() const {
+    glm::mat4 matrix(scale);
+    matrix[3] = glm::vec4(offset, 1.0f);
+    return matrix;
+}
+
+uint32 GetVertexStride(VertexFormat format) {
+    return format == VertexFormat::Compact ? sizeof(CompactVertex) : sizeof(Vertex);
+}
+
+rhi::VertexInputLayout GetVertexInputLayout(VertexFormat format, bool positionOnly) {
+    rhi::VertexInputLayout layout;
+    layout.stride = GetVertexStride(format);
+    if (format == VertexFormat::Compact) {
+        layout.attributes = {
+            { 0, rhi::Format::R16G16B16A16_UNORM, offsetof(CompactVertex, position), 0 },
+            { 1, rhi::Format::R16G16_SNORM, offsetof(CompactVertex, normal), 0 },
+            { 2, rhi::Format::R16G16_SFLOAT, offsetof(CompactVertex, texCoord), 0 },
+            { 3, rhi::Format::R8G8B8A8_SNORM, offsetof(CompactVertex, tangent), 0 }
+        };
+    } else {
+        layout.attributes = {
+            { 0, rhi::Format::R32G32B32_SFLOAT, offsetof(Vertex, position), 0 },
+            { 1, rhi::Format::R32G32B32_SFLOAT, offsetof(Vertex, normal), 0 },
+            { 2, rhi::Format::R32G32_SFLOAT, offsetof(Vertex, texCoord), 0 },
+            { 3, rhi::Format::R32G32B32A32_SFLOAT, offsetof(Vertex, tangent), 0 }
+        };
+    }
+    if (positionOnly) {
+        layout.attributes.resize(1);
+    }
+    return layout;
+}
+
+rhi::VertexInputLayout GetPositionInputLayout(VertexFormat format) {
+    rhi::VertexInputLayout layout;
+    if (format == VertexFormat::Compact) {
+        layout.stride = sizeof(CompactVertex::position);
+        layout.attributes = { { 0, rhi::Format::R16G16B16A16_UNORM, 0, 0 } };
+    } else {
+        layout.stride = sizeof(glm::vec3);
+        layout.attributes = { { 0, rhi::Format::R32G32B32_SFLOAT, 0, 0 } };
+    }
+    return layout;
+}
+
+// IEEE half, round to nearest even; out-of-range values saturate to infinity
+static uint16 FloatToHalf(float value) {
+    uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    uint32 sign = (bits >> 16) & 0x8000u;
+    uint32 absBits = bits & 0x7FFFFFFFu;
+    if (absBits >= 0x7F800000u) {
+        return static_cast<uint16>(sign | 0x7C00u | (absBits > 0x7F800000u ? 0x200u : 0u));  // Inf / NaN
+    }
+    if (absBits >= 0x477FF000u) {
+        return static_cast<uint16>(sign | 0x7C00u);  // Rounds past the largest half
+    }
+    if (absBits < 0x38800000u) {
+        // Subnormal half (or zero): shift the implicit-one mantissa into place
+        if (absBits < 0x33000000u) {
+            return static_cast<uint16>(sign);
+        }
+        uint32 exponent = absBits >> 23;
+        uint32 mantissa = (absBits & 0x7FFFFFu) | 0x800000u;
+        uint32 shift = 126 - exponent;
+        uint32 half = mantissa >> shift;
+        uint32 remainder = mantissa & ((1u << shift) - 1);
+        uint32 halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            ++half;
+        }
+        return static_cast<uint16>(sign | half);
+    }
+
+    uint32 half = (absBits - 0x38000000u) >> 13;
+    uint32 remainder = absBits & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        ++half;
+    }
+    return static_cast<uint16>(sign | half);
+}
+
+static int16 ToSnorm16(float value) {
+    return static_cast<int16>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static int8 ToSnorm8(float value) {
+    return static_cast<int8>(std::lround(std::clamp(value, -1.0f, 1.0f) * 127.0f));
+}
+
+static uint16 ToUnorm16(float value) {
+    return static_cast<uint16>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+// Octahedral mapping of a unit vector onto [-1, 1]^2
+static glm::vec2 EncodeOctahedral(const glm::vec3& normal) {
+    float sum = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+    if (sum <= 0.0f) {
+        return glm::vec2(0.0f);  // Degenerate normal decodes to +Z
+    }
+    glm::vec2 encoded(normal.x / sum, normal.y / sum);
+    if (normal.z < 0.0f) {
+        encoded = glm::vec2((1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                            (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+    }
+    return encoded;
+}
+
+static void EncodeCompactPosition(const glm::vec3& position, const VertexQuantization& quantization,
+                                  uint16 outPosition[4]) {
+    glm::vec3 normalized = (position - quantization.offset) / quantization.scale;
+    outPosition[0] = ToUnorm16(normalized.x);
+    outPosition[1] = ToUnorm16(normalized.y);
+    outPosition[2] = ToUnorm16(normalized.z);
+    outPosition[3] = 0;
+}
+
+void EncodeCompactVertices(const Vertex* vertices, uint32 count, const VertexQuantization& quantization,
+                           CompactVertex* outVertices) {
+    for (uint32 i = 0; i < count; ++i) {
+        const Vertex& vertex = vertices[i];
+        CompactVertex& out = outVertices[i];
+
+        EncodeCompactPosition(vertex.position, quantization, out.position);
+
+        glm::vec2 normal = EncodeOctahedral(vertex.normal);
+        out.normal[0] = ToSnorm16(normal.x);
+        out.normal[1] = ToSnorm16(normal.y);
+
+        out.texCoord[0] = FloatToHalf(vertex.texCoord.x);
+        out.texCoord[1] = FloatToHalf(vertex.texCoord.y);
+
+        out.tangent[0] = ToSnorm8(vertex.tangent.x);
+        out.tangent[1] = ToSnorm8(vertex.tangent.y);
+        out.tangent[2] = ToSnorm8(vertex.tangent.z);
+        out.tangent[3] = vertex.tangent.w < 0.0f ? -127 : 127;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Tangents
+// ----------------------------------------------------------------------------
+
+// Any unit vector perpendicular to a unit normal
+static glm::vec3 PerpendicularTangent(const glm::vec3& normal) {
+    glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+    return glm::normalize(glm::cross(glm::cross(normal, axis), normal));
+}
+
+void ComputeTangents(Vertex* vertices, uint32 vertexCount, const uint32* indices, uint32 indexCount) {
+    // Sum the UV gradients of the triangles around each vertex
+    std::vector<glm::vec3> tangents(vertexCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> bitangents(vertexCount, glm::vec3(0.0f));
+    for (uint32 i = 0; i + 2 < indexCount; i += 3) {
+        uint32 i0 = indices[i], i1 = indices[i + 1], i2 = indices[i + 2];
+        if (i0 >= vertexCount || i1 >= vertexCount || i2 >= vertexCount) {
+            continue;
+        }
+        const Vertex& v0 = vertices[i0];
+        glm::vec3 e1 = vertices[i1].position - v0.position;
+        glm::vec3 e2 = vertices[i2].position - v0.position;
+        glm::vec2 d1 = vertices[i1].texCoord - v0.texCoord;
+        glm::vec2 d2 = vertices[i2].texCoord - v0.texCoord;
+
+        float det = d1.x * d2.y - d2.x * d1.y;
+        if (std::abs(det) < 1e-12f) {
+            continue;  // No UV gradient
+        }
+        // Position derivatives along U and V
+        float r = 1.0f / det;
+        glm::vec3 tangent = (e1 * d2.y - e2 * d1.y) * r;
+        glm::vec3 bitangent = (e2 * d1.x - e1 * d2.x) * r;
+        for (uint32 index : { i0, i1, i2 }) {
+            tangents[index] += tangent;
+            bitangents[index] += bitangent;
+        }
+    }
+
+    for (uint32 i = 0; i < vertexCount; ++i) {
+        Vertex& vertex = vertices[i];
+        glm::vec3 normal = vertex.normal;
+        float normalLength = glm::length(normal);
+        normal = normalLength > 0.0f ? normal / normalLength : glm::vec3(0.0f, 0.0f, 1.0f);
+
+        // Gram-Schmidt against the normal
+        glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+        float tangentLength = glm::length(tangent);
+        if (tangentLength < 1e-12f) {
+            vertex.tangent = glm::vec4(PerpendicularTangent(normal), 1.0f);
+            continue;
+        }
+        tangent /= tangentLength;
+        float handedness = glm::dot(glm::cross(normal, tangent), bitangents[i]) < 0.0f ? -1.0f : 1.0f;
+        vertex.tangent = glm::vec4(tangent, handedness);
+    }
+}
+
+// Write the vertices in the GPU layout of the format at a byte offset. Encoded
+// layouts are written straight into the upload's staging memory.
+static void UploadVertices(rhi::Buffer& buffer, const Vertex* vertices, uint32 count, VertexFormat format,
+                           const VertexQuantization& quantization, uint64 offset) {
+    uint64 size = static_cast<uint64>(count) * GetVertexStride(format);
+    if (format == VertexFormat::Compact) {
+        buffer.WriteData(size, offset, [&](void* data) {
+            EncodeCompactVertices(vertices, count, quantization, static_cast<CompactVertex*>(data));
+        });
+    } else {
+        buffer.CopyData(vertices, size, offset);
+    }
+}
+
+// Write the packed positions (GetPositionInputLayout) at a byte offset
+static void UploadPositions(rhi::Buffer& buffer, const Vertex* vertices, uint32 count, VertexFormat format,
+                            const VertexQuantization& quantization, uint64 offset) {
+    uint64 size = static_cast<uint64>(count) * GetPositionInputLayout(format).stride;
+    if (format == VertexFormat::Compact) {
+        // Same quantized positions as the interleaved buffer, so depth matches exactly
+        buffer.WriteData(size, offset, [&](void* data) {
+            uint16* positions = static_cast<uint16*>(data);
+            for (uint32 i = 0; i < count; ++i) {
+                EncodeCompactPosition(vertices[i].position, quantization, &positions[static_cast<size_t>(i) * 4]);
+            }
+        });
+    } else {
+        buffer.WriteData(size, offset, [&](void* data) {
+            glm::vec3* positions = static_cast<glm::vec3*>(data);
+            for (uint32 i = 0; i < count; ++i) {
+                positions[i] = vertices[i].position;
+            }
+        });
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Mesh
+// ----------------------------------------------------------------------------
+
+// Box, then a sphere around its center; looser than a minimal sphere but two passes
+static void ComputeBounds(const Vertex* vertices, uint32_t count, glm::vec3& outMin, glm::vec3& outMax,
+                          glm::vec3& outCenter, float& outRadius) {
+    simd::ComputeBounds(&vertices[0].position, count, sizeof(Vertex), outMin, outMax);
+
+    outCenter = (outMin + outMax) * 0.5f;
+    float radiusSquared = 0.0f;
+    for (uint32_t i = 0; i < count; ++i) {
+        glm::vec3 delta = vertices[i].position - outCenter;
+        radiusSquared = std::max(radiusSquared, glm::dot(delta, delta));
+    }
+    outRadius = std::sqrt(radiusSquared);
+}
+
 Mesh::Mesh() = default;
 
 Mesh::~Mesh() {
@@ -18,10 +290,27 @@ Mesh::~Mesh() {
 Mesh::Mesh(Mesh&& other) noexcept
     : m_Vertices(std::move(other.m_Vertices))
     , m_Indices(std::move(other.m_Indices))
+    , m_CompressedPositions(std::move(other.m_CompressedPositions))
+    , m_CompressedIndices16(std::move(other.m_CompressedIndices16))
+    , m_CompressedIndices32(std::move(other.m_CompressedIndices32))
+    , m_Meshlets(std::move(other.m_Meshlets))
+    , m_Lods(std::move(other.m_Lods))
+    , m_LodIndices(std::move(other.m_LodIndices))
     , m_VertexBuffer(std::move(other.m_VertexBuffer))
     , m_IndexBuffer(std::move(other.m_IndexBuffer))
+    , m_PositionBuffer(std::move(other.m_PositionBuffer))
     , m_VertexCount(other.m_VertexCount)
     , m_IndexCount(other.m_IndexCount)
+    , m_FirstIndex(other.m_FirstIndex)
+    , m_VertexOffset(other.m_VertexOffset)
+    , m_Pooled(other.m_Pooled)
+    , m_CPUDataMode(other.m_CPUDataMode)
+    , m_VertexFormat(other.m_VertexFormat)
+    , m_Quantization(other.m_Quantization)
+    , m_BoundsMin(other.m_BoundsMin)
+    , m_BoundsMax(other.m_BoundsMax)
+    , m_BoundsCenter(other.m_BoundsCenter)
+    , m_BoundsRadius(other.m_BoundsRadius)
     , m_Material(std::move(other.m_Material))
 {
     other.m_VertexCount = 0;
@@ -34,10 +323,27 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept {
 
         m_Vertices = std::move(other.m_Vertices);
         m_Indices = std::move(other.m_Indices);
+        m_CompressedPositions = std::move(other.m_CompressedPositions);
+        m_CompressedIndices16 = std::move(other.m_CompressedIndices16);
+        m_CompressedIndices32 = std::move(other.m_CompressedIndices32);
+        m_Meshlets = std::move(other.m_Meshlets);
+        m_Lods = std::move(other.m_Lods);
+        m_LodIndices = std::move(other.m_LodIndices);
         m_VertexBuffer = std::move(other.m_VertexBuffer);
         m_IndexBuffer = std::move(other.m_IndexBuffer);
+        m_PositionBuffer = std::move(other.m_PositionBuffer);
         m_VertexCount = other.m_VertexCount;
         m_IndexCount = other.m_IndexCount;
+        m_FirstIndex = other.m_FirstIndex;
+        m_VertexOffset = other.m_VertexOffset;
+        m_Pooled = other.m_Pooled;
+        m_CPUDataMode = other.m_CPUDataMode;
+        m_VertexFormat = other.m_VertexFormat;
+        m_Quantization = other.m_Quantization;
+        m_BoundsMin = other.m_BoundsMin;
+        m_BoundsMax = other.m_BoundsMax;
+        m_BoundsCenter = other.m_BoundsCenter;
+        m_BoundsRadius = other.m_BoundsRadius;
         m_Material = std::move(other.m_Material);
 
         other.m_VertexCount = 0;
@@ -47,37 +353,63 @@ Mesh& Mesh::operator=(Mesh&& other) noexcept {
 }
 
 bool Mesh::Initialize(rhi::GraphicsDevice* device,
-                     const std::vector<Vertex>& vertices,
-                     const std::vector<uint32_t>& indices) {
-    if (!device || vertices.empty() || indices.empty()) {
+                     std::vector<Vertex> vertices,
+                     std::vector<uint32_t> indices,
+                     bool dynamic,
+                     VertexFormat format,
+                     const VertexQuantization& quantization) {
+    SetCPUData(std::move(vertices), std::move(indices));
+    return Initialize(device, m_Vertices.data(), static_cast<uint32_t>(m_Vertices.size()),
+                      m_Indices.data(), static_cast<uint32_t>(m_Indices.size()), dynamic, format, quantization);
+}
+
+bool Mesh::Initialize(rhi::GraphicsDevice* device,
+                     const Vertex* vertices, uint32_t vertexCount,
+                     const uint32_t* indices, uint32_t indexCount,
+                     bool dynamic,
+                     VertexFormat format,
+                     const VertexQuantization& quantization) {
+    if (!device || !vertices || !indices || vertexCount == 0 || indexCount == 0) {
         METAGFX_ERROR << "Mesh::Initialize - Invalid parameters";
         return false;
     }
 
-    // Store vertices and indices
-    m_Vertices = vertices;
-    m_Indices = indices;
-    m_VertexCount = static_cast<uint32_t>(vertices.size());
-    m_IndexCount = static_cast<uint32_t>(indices.size());
+    m_VertexCount = vertexCount;
+    m_IndexCount = indexCount;
+    m_VertexFormat = format;
+    m_Quantization = quantization;
+    m_FirstIndex = 0;
+    m_VertexOffset = 0;
+    m_Pooled = false;
+    m_PositionBuffer.reset();
+    ComputeBounds(vertices, vertexCount, m_BoundsMin, m_BoundsMax, m_BoundsCenter, m_BoundsRadius);
+
+    // Static geometry lives in device-local memory and is filled through the upload
+    // path (staging ring + copy); only dynamic meshes stay host-visible
+    rhi::MemoryUsage memoryUsage = dynamic ? rhi::MemoryUsage::CPUToGPU : rhi::MemoryUsage::GPUOnly;
+    // Static geometry may also be traced (RayTracingScene)
+    rhi::BufferUsage traceUsage = !dynamic && device->GetDeviceInfo().supportsAccelerationStructures
+                                      ? rhi::BufferUsage::AccelerationStructureInput
+                                      : rhi::BufferUsage{};
 
     // Create vertex buffer
     rhi::BufferDesc vbDesc = {};
-    vbDesc.size = static_cast<uint32_t>(vertices.size() * sizeof(Vertex));
-    vbDesc.usage = rhi::BufferUsage::Vertex | rhi::BufferUsage::TransferDst;
-    vbDesc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    vbDesc.size = static_cast<uint64>(vertexCount) * GetVertexStride(format);
+    vbDesc.usage = rhi::BufferUsage::Vertex | rhi::BufferUsage::TransferDst | traceUsage;
+    vbDesc.memoryUsage = memoryUsage;
 
     m_VertexBuffer = device->CreateBuffer(vbDesc);
     if (!m_VertexBuffer) {
         METAGFX_ERROR << "Mesh::Initialize - Failed to create vertex buffer";
         return false;
     }
-    m_VertexBuffer->CopyData(vertices.data(), vbDesc.size);
+    UploadVertices(*m_VertexBuffer, vertices, vertexCount, format, quantization, 0);
 
-    // Create index buffer
+    // Create index buffer, with the indices of the coarser levels after the mesh's own
     rhi::BufferDesc ibDesc = {};
-    ibDesc.size = static_cast<uint32_t>(indices.size() * sizeof(uint32_t));
-    ibDesc.usage = rhi::BufferUsage::Index | rhi::BufferUsage::TransferDst;
-    ibDesc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    ibDesc.size = (static_cast<uint64>(indexCount) + m_LodIndices.size()) * sizeof(uint32_t);
+    ibDesc.usage = rhi::BufferUsage::Index | rhi::BufferUsage::TransferDst | traceUsage;
+    ibDesc.memoryUsage = memoryUsage;
 
     m_IndexBuffer = device->CreateBuffer(ibDesc);
     if (!m_IndexBuffer) {
@@ -85,7 +417,12 @@ bool Mesh::Initialize(rhi::GraphicsDevice* device,
         m_VertexBuffer.reset();
         return false;
     }
-    m_IndexBuffer->CopyData(indices.data(), ibDesc.size);
+    m_IndexBuffer->CopyData(indices, static_cast<uint64>(indexCount) * sizeof(uint32_t));
+    if (!m_LodIndices.empty()) {
+        m_IndexBuffer->CopyData(m_LodIndices.data(), m_LodIndices.size() * sizeof(uint32_t),
+                                static_cast<uint64>(indexCount) * sizeof(uint32_t));
+    }
+    StoreCPUData(vertices, indices);
 
     // Create default material if none is set
     if (!m_Material) {
@@ -96,14 +433,189 @@ bool Mesh::Initialize(rhi::GraphicsDevice* device,
     return true;
 }
 
+bool Mesh::Initialize(GeometryPool& pool,
+                     const Vertex* vertices, uint32_t vertexCount,
+                     const uint32_t* indices, uint32_t indexCount,
+                     const VertexQuantization& quantization) {
+    if (!vertices || !indices || vertexCount == 0 || indexCount == 0 || !pool.GetVertexBuffer()) {
+        METAGFX_ERROR << "Mesh::Initialize - Invalid parameters";
+        return false;
+    }
+
+    GeometryPool::Allocation allocation;
+    if (!pool.Allocate(vertexCount, indexCount + static_cast<uint32_t>(m_LodIndices.size()), allocation)) {
+        METAGFX_ERROR << "Mesh::Initialize - Geometry pool is full";
+        return false;
+    }
+
+    m_VertexCount = vertexCount;
+    m_IndexCount = indexCount;
+    m_FirstIndex = allocation.firstIndex;
+    m_VertexOffset = static_cast<int32_t>(allocation.firstVertex);
+    m_Pooled = true;
+    m_VertexFormat = pool.GetVertexFormat();
+    m_Quantization = quantization;
+    ComputeBounds(vertices, vertexCount, m_BoundsMin, m_BoundsMax, m_BoundsCenter, m_BoundsRadius);
+
+    m_VertexBuffer = pool.GetVertexBuffer();
+    m_IndexBuffer = pool.GetIndexBuffer();
+    m_PositionBuffer = pool.GetPositionBuffer();
+
+    UploadVertices(*m_VertexBuffer, vertices, vertexCount, m_VertexFormat, quantization,
+                   static_cast<uint64>(allocation.firstVertex) * GetVertexStride(m_VertexFormat));
+    m_IndexBuffer->CopyData(indices, static_cast<uint64>(indexCount) * sizeof(uint32_t),
+                            static_cast<uint64>(allocation.firstIndex) * sizeof(uint32_t));
+    if (!m_LodIndices.empty()) {
+        m_IndexBuffer->CopyData(m_LodIndices.data(), m_LodIndices.size() * sizeof(uint32_t),
+                                (static_cast<uint64>(allocation.firstIndex) + indexCount) * sizeof(uint32_t));
+    }
+    if (m_PositionBuffer) {
+        UploadPositions(*m_PositionBuffer, vertices, vertexCount, m_VertexFormat, quantization,
+                        static_cast<uint64>(allocation.firstVertex) * GetPositionInputLayout(m_VertexFormat).stride);
+    }
+    StoreCPUData(vertices, indices);
+
+    if (!m_Material) {
+        m_Material = std::make_unique<Material>();
+    }
+    return true;
+}
+
+bool Mesh::CreatePositionStream(rhi::GraphicsDevice* device) {
+    if (!device || m_Vertices.empty() || m_Pooled) {
+        return false;
+    }
+
+    rhi::BufferDesc desc = {};
+    desc.size = static_cast<uint64>(m_VertexCount) * GetPositionInputLayout(m_VertexFormat).stride;
+    desc.usage = rhi::BufferUsage::Vertex | rhi::BufferUsage::TransferDst;
+    desc.memoryUsage = rhi::MemoryUsage::GPUOnly;
+
+    m_PositionBuffer = device->CreateBuffer(desc);
+    if (!m_PositionBuffer) {
+        METAGFX_ERROR << "Mesh::CreatePositionStream - Failed to create position buffer";
+        return false;
+    }
+
+    UploadPositions(*m_PositionBuffer, m_Vertices.data(), m_VertexCount, m_VertexFormat, m_Quantization, 0);
+    return true;
+}
+
 void Mesh::Cleanup() {
     m_VertexBuffer.reset();
     m_IndexBuffer.reset();
+    m_PositionBuffer.reset();
     m_Material.reset();
     m_Vertices.clear();
     m_Indices.clear();
+    m_CompressedPositions.clear();
+    m_CompressedIndices16.clear();
+    m_CompressedIndices32.clear();
+    m_Meshlets.clear();
+    m_Lods.clear();
+    m_LodIndices.clear();
     m_VertexCount = 0;
     m_IndexCount = 0;
+    m_FirstIndex = 0;
+    m_VertexOffset = 0;
+    m_Pooled = false;
+    m_VertexFormat = VertexFormat::Float;
+    m_BoundsMin = glm::vec3(0.0f);
+    m_BoundsMax = glm::vec3(0.0f);
+    m_BoundsCenter = glm::vec3(0.0f);
+    m_BoundsRadius = 0.0f;
+}
+
+void Mesh::SetCPUData(std::vector<Vertex> vertices, std::vector<uint32_t> indices) {
+    m_Vertices = std::move(vertices);
+    m_Indices = std::move(indices);
+}
+
+void Mesh::SetCPUDataMode(MeshCPUData mode) {
+    m_CPUDataMode = mode;
+    if (mode == MeshCPUData::Full) {
+        return;
+    }
+    if (mode == MeshCPUData::Compressed && !m_Vertices.empty()) {
+        CompressCPUData(m_Vertices.data(), m_Indices.data());
+    } else if (mode == MeshCPUData::None) {
+        std::vector<uint16>().swap(m_CompressedPositions);
+        std::vector<uint16>().swap(m_CompressedIndices16);
+        std::vector<uint32_t>().swap(m_CompressedIndices32);
+    }
+    ReleaseFullCPUData();
+}
+
+uint32 Mesh::GetCPUTriangleCount() const {
+    size_t indexCount = m_Indices.size() + m_CompressedIndices16.size() + m_CompressedIndices32.size();
+    return static_cast<uint32>(indexCount / 3);
+}
+
+void Mesh::GetCPUTriangle(uint32 triangle, glm::vec3& outA, glm::vec3& outB, glm::vec3& outC) const {
+    uint32_t first = triangle * 3;
+    outA = GetCPUPosition(first);
+    outB = GetCPUPosition(first + 1);
+    outC = GetCPUPosition(first + 2);
+}
+
+// Position of the vertex the index at position i refers to, in whichever copy is kept
+glm::vec3 Mesh::GetCPUPosition(uint32_t i) const {
+    if (!m_Indices.empty()) {
+        return m_Vertices[m_Indices[i]].position;
+    }
+    uint32_t index = m_CompressedIndices16.empty() ? m_CompressedIndices32[i] : m_CompressedIndices16[i];
+    const uint16* position = &m_CompressedPositions[static_cast<size_t>(index) * 3];
+    glm::vec3 normalized(position[0], position[1], position[2]);
+    return m_BoundsMin + normalized / 65535.0f * (m_BoundsMax - m_BoundsMin);
+}
+
+// Keeps what the CPU data mode asks for of the geometry just uploaded
+void Mesh::StoreCPUData(const Vertex* vertices, const uint32_t* indices) {
+    bool held = vertices == m_Vertices.data() && indices == m_Indices.data();  // Handed over by SetCPUData()
+    if (m_CPUDataMode == MeshCPUData::Full) {
+        if (!held) {
+            m_Vertices.assign(vertices, vertices + m_VertexCount);
+            m_Indices.assign(indices, indices + m_IndexCount);
+        }
+        return;
+    }
+    if (m_CPUDataMode == MeshCPUData::Compressed) {
+        CompressCPUData(vertices, indices);
+    }
+    ReleaseFullCPUData();
+}
+
+// Positions quantized within the bounds, which Initialize() computed from the same vertices
+void Mesh::CompressCPUData(const Vertex* vertices, const uint32_t* indices) {
+    glm::vec3 extent = glm::max(m_BoundsMax - m_BoundsMin, glm::vec3(1e-20f));
+    m_CompressedPositions.resize(static_cast<size_t>(m_VertexCount) * 3);
+    for (uint32_t v = 0; v < m_VertexCount; ++v) {
+        glm::vec3 normalized = (vertices[v].position - m_BoundsMin) / extent;
+        for (int c = 0; c < 3; ++c) {
+            m_CompressedPositions[static_cast<size_t>(v) * 3 + c] = ToUnorm16(normalized[c]);
+        }
+    }
+
+    m_CompressedIndices16.clear();
+    m_CompressedIndices32.clear();
+    if (m_VertexCount <= 65536) {
+        m_CompressedIndices16.assign(indices, indices + m_IndexCount);
+    } else {
+        m_CompressedIndices32.assign(indices, indices + m_IndexCount);
+    }
+    m_CompressedPositions.shrink_to_fit();
+    m_CompressedIndices16.shrink_to_fit();
+    m_CompressedIndices32.shrink_to_fit();
+}
+
+void Mesh::ReleaseFullCPUData() {
+    std::vector<Vertex>().swap(m_Vertices);
+    std::vector<uint32_t>().swap(m_Indices);
+}
+
+void Mesh::SetLods(const MeshLod* lods, uint32 lodCount, const uint32* lodIndices, uint32 lodIndexCount) {
+    m_Lods.assign(lods, lods + std::min(lodCount, MeshLod::MAX_LEVELS));
+    m_LodIndices.assign(lodIndices, lodIndices + lodIndexCount);
 }
 
 void Mesh::SetMaterial(std::unique_ptr<Material> material) {
@@ -0,0 +1,845 @@
+// ============================================================================
+// src/scene/MeshOptimizer.cpp
+// ============================================================================
+#include "metagfx/scene/MeshOptimizer.h"
+#include "metagfx/scene/ModelCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace metagfx {
+
+constexpr uint32 INVALID_INDEX = std::numeric_limits<uint32>::max();
+
+// ----------------------------------------------------------------------------
+// Vertex cache optimization
+// ----------------------------------------------------------------------------
+//
+// Greedy: always emit the highest-scoring triangle that touches the simulated LRU cache.
+// A vertex scores higher the more recently it was used and the fewer unemitted
+// triangles it has left (so lone triangles do not get stranded).
+
+constexpr uint32 FORSYTH_CACHE_SIZE = 32;
+constexpr float CACHE_DECAY_POWER = 1.5f;
+constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+constexpr float VALENCE_BOOST_SCALE = 2.0f;
+constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+static float VertexScore(int32 cachePosition, uint32 remainingValence) {
+    if (remainingValence == 0) {
+        return -1.0f;  // No triangles left; never pulls a triangle in
+    }
+
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // Used by the last triangle: fixed score, so its neighbours are not favoured
+            // just for sharing the most recent vertex
+            score = LAST_TRIANGLE_SCORE;
+        } else {
+            float scale = 1.0f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+            score = std::pow(1.0f - static_cast<float>(cachePosition - 3) * scale, CACHE_DECAY_POWER);
+        }
+    }
+
+    score += VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+    return score;
+}
+
+void OptimizeVertexCache(uint32* indices, size_t indexCount, size_t vertexCount) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Triangles of every vertex; the first remaining[v] entries are the unemitted ones
+    std::vector<uint32> remaining(vertexCount, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++remaining[indices[i]];
+    }
+    std::vector<uint32> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<uint32> adjacency(triangleCount * 3);
+    {
+        std::vector<uint32> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) {
+            adjacency[cursor[indices[i]]++] = static_cast<uint32>(i / 3);
+        }
+    }
+
+    std::vector<int32> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScore(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    uint32 bestTriangle = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        const uint32* tri = indices + t * 3;
+        triangleScore[t] = vertexScore[tri[0]] + vertexScore[tri[1]] + vertexScore[tri[2]];
+        if (triangleScore[t] > triangleScore[bestTriangle]) {
+            bestTriangle = static_cast<uint32>(t);
+        }
+    }
+
+    std::vector<uint32> output(triangleCount * 3);
+    uint32 cache[FORSYTH_CACHE_SIZE + 3];
+    uint32 newCache[FORSYTH_CACHE_SIZE + 3];
+    size_t cacheCount = 0;
+    size_t scanCursor = 0;
+
+    for (size_t outTriangle = 0; outTriangle < triangleCount; ++outTriangle) {
+        if (bestTriangle == INVALID_INDEX) {
+            // Nothing in the cache has triangles left; continue with the next one in input order
+            while (emitted[scanCursor]) {
+                ++scanCursor;
+            }
+            bestTriangle = static_cast<uint32>(scanCursor);
+        }
+
+        const uint32* tri = indices + static_cast<size_t>(bestTriangle) * 3;
+        std::memcpy(&output[outTriangle * 3], tri, 3 * sizeof(uint32));
+        emitted[bestTriangle] = true;
+
+        // Drop the triangle from its vertices' lists
+        for (int k = 0; k < 3; ++k) {
+            uint32 v = tri[k];
+            uint32* list = &adjacency[offsets[v]];
+            for (uint32 i = 0; i < remaining[v]; ++i) {
+                if (list[i] == bestTriangle) {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    --remaining[v];
+                    break;
+                }
+            }
+        }
+
+        // The triangle's vertices move to the front; up to three entries fall out
+        size_t newCount = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (std::find(newCache, newCache + newCount, tri[k]) == newCache + newCount) {
+                newCache[newCount++] = tri[k];
+            }
+        }
+        for (size_t i = 0; i < cacheCount; ++i) {
+            if (tri[0] != cache[i] && tri[1] != cache[i] && tri[2] != cache[i]) {
+                newCache[newCount++] = cache[i];
+            }
+        }
+
+        // Rescore the touched vertices and propagate the change to their triangles
+        for (size_t i = 0; i < newCount; ++i) {
+            uint32 v = newCache[i];
+            cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int32>(i) : -1;
+
+            float score = VertexScore(cachePosition[v], remaining[v]);
+            float delta = score - vertexScore[v];
+            vertexScore[v] = score;
+
+            const uint32* list = &adjacency[offsets[v]];
+            for (uint32 j = 0; j < remaining[v]; ++j) {
+                triangleScore[list[j]] += delta;
+            }
+        }
+
+        cacheCount = std::min<size_t>(newCount, FORSYTH_CACHE_SIZE);
+        std::memcpy(cache, newCache, cacheCount * sizeof(uint32));
+
+        // Next: the best triangle reachable from the cache
+        bestTriangle = INVALID_INDEX;
+        float bestScore = -1.0f;
+        for (size_t i = 0; i < cacheCount; ++i) {
+            uint32 v = cache[i];
+            const uint32* list = &adjacency[offsets[v]];
+            for (uint32 j = 0; j < remaining[v]; ++j) {
+                if (triangleScore[list[j]] > bestScore) {
+                    bestScore = triangleScore[list[j]];
+                    bestTriangle = list[j];
+                }
+            }
+        }
+    }
+
+    std::memcpy(indices, output.data(), output.size() * sizeof(uint32));
+}
+
+// ----------------------------------------------------------------------------
+// Overdraw optimization
+// ----------------------------------------------------------------------------
+
+constexpr uint32 FIFO_CACHE_SIZE = 16;
+
+// FIFO cache simulation by timestamps: a vertex is cached while fewer than cacheSize
+// misses happened since its own
+struct FifoCache {
+    std::vector<uint32> timestamps;
+    uint32 cacheSize;
+    uint32 time;
+
+    FifoCache(size_t vertexCount, uint32 size) : timestamps(vertexCount, 0), cacheSize(size), time(size + 1) {}
+
+    void Reset() { time += cacheSize + 1; }
+
+    uint32 Access(const uint32* tri) {
+        uint32 misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            if (time - timestamps[tri[k]] > cacheSize) {
+                timestamps[tri[k]] = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+};
+
+float ComputeACMR(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0) {
+        return 0.0f;
+    }
+
+    FifoCache cache(vertexCount, cacheSize);
+    uint64 misses = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        misses += cache.Access(indices + t * 3);
+    }
+    return static_cast<float>(misses) / static_cast<float>(triangleCount);
+}
+
+void OptimizeOverdraw(uint32* indices, size_t indexCount, const Vertex* vertices, size_t vertexCount,
+                      float threshold) {
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Hard boundaries: triangles where the cache restarts anyway (no vertex cached)
+    FifoCache cache(vertexCount, FIFO_CACHE_SIZE);
+    std::vector<uint32> hardClusters;
+    uint64 meshMisses = 0;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        uint32 misses = cache.Access(indices + t * 3);
+        if (t == 0 || misses == 3) {
+            hardClusters.push_back(static_cast<uint32>(t));
+        }
+        meshMisses += misses;
+    }
+    hardClusters.push_back(static_cast<uint32>(triangleCount));
+
+    // Soft boundaries: split a hard cluster once its own ACMR is close enough to the mesh's
+    float clusterThreshold = threshold * static_cast<float>(meshMisses) / static_cast<float>(triangleCount);
+    std::vector<uint32> clusters;
+    for (size_t c = 0; c + 1 < hardClusters.size(); ++c) {
+        uint32 start = hardClusters[c];
+        uint32 end = hardClusters[c + 1];
+
+        cache.Reset();
+        clusters.push_back(start);
+        uint32 clusterStart = start;
+        uint32 clusterMisses = 0;
+        for (uint32 t = start; t < end; ++t) {
+            clusterMisses += cache.Access(indices + static_cast<size_t>(t) * 3);
+            if (t + 1 < end &&
+                static_cast<float>(clusterMisses) <= clusterThreshold * static_cast<float>(t + 1 - clusterStart)) {
+                clusters.push_back(t + 1);
+                clusterStart = t + 1;
+                clusterMisses = 0;
+                cache.Reset();
+            }
+        }
+    }
+    clusters.push_back(static_cast<uint32>(triangleCount));
+
+    size_t clusterCount = clusters.size() - 1;
+    if (clusterCount < 2) {
+        return;
+    }
+
+    // Occlusion potential: clusters far out from the mesh centre and facing away from it
+    // tend to cover the rest, so they draw first
+    struct ClusterInfo {
+        glm::vec3 centroid = glm::vec3(0.0f);
+        glm::vec3 normal = glm::vec3(0.0f);  // Area-weighted
+        float area = 0.0f;
+    };
+    std::vector<ClusterInfo> infos(clusterCount);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; ++c) {
+        ClusterInfo& info = infos[c];
+        for (uint32 t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const uint32* tri = indices + static_cast<size_t>(t) * 3;
+            const glm::vec3& p0 = vertices[tri[0]].position;
+            const glm::vec3& p1 = vertices[tri[1]].position;
+            const glm::vec3& p2 = vertices[tri[2]].position;
+
+            glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+            float area = glm::length(normal);
+            info.centroid = info.centroid + (p0 + p1 + p2) * (area / 3.0f);
+            info.normal = info.normal + normal;
+            info.area += area;
+        }
+        meshCentroid = meshCentroid + info.centroid;
+        meshArea += info.area;
+        if (info.area > 0.0f) {
+            info.centroid = info.centroid / info.area;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid = meshCentroid / meshArea;
+    }
+
+    std::vector<float> sortKeys(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        float normalLength = glm::length(infos[c].normal);
+        if (normalLength > 0.0f) {
+            sortKeys[c] = glm::dot(infos[c].centroid - meshCentroid, infos[c].normal / normalLength);
+        }
+    }
+
+    std::vector<uint32> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        order[c] = static_cast<uint32>(c);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32 a, uint32 b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<uint32> output;
+    output.reserve(triangleCount * 3);
+    for (uint32 c : order) {
+        output.insert(output.end(), indices + static_cast<size_t>(clusters[c]) * 3,
+                      indices + static_cast<size_t>(clusters[c + 1]) * 3);
+    }
+    std::memcpy(indices, output.data(), output.size() * sizeof(uint32));
+}
+
+// ----------------------------------------------------------------------------
+// Vertex fetch optimization
+// ----------------------------------------------------------------------------
+
+size_t OptimizeVertexFetch(Vertex* vertices, uint32* indices, size_t indexCount, size_t vertexCount) {
+    std::vector<uint32> remap(vertexCount, INVALID_INDEX);
+    uint32 nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        uint32& target = remap[indices[i]];
+        if (target == INVALID_INDEX) {
+            target = nextVertex++;
+        }
+        indices[i] = target;
+    }
+
+    std::vector<Vertex> reordered(nextVertex);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] != INVALID_INDEX) {
+            reordered[remap[v]] = vertices[v];
+        }
+    }
+    std::copy(reordered.begin(), reordered.end(), vertices);
+    return nextVertex;
+}
+
+// ----------------------------------------------------------------------------
+// Meshlets
+// ----------------------------------------------------------------------------
+//
+// Greedy growth: a meshlet starts at the first triangle not yet taken, in the optimized
+// order, and keeps taking the triangle next to it that adds the fewest new vertices
+// (nearest to its centre on a tie) until either limit is reached or nothing borders it.
+// The triangles are then written back meshlet by meshlet. The cone axis is the mean of
+// the unit triangle normals; the cone's spread is the widest angle a normal makes with
+// it. Normals more than ~84 degrees apart (or a meshlet without a non-degenerate
+// triangle) leave the cone open, since it would almost never reject anything.
+
+constexpr float MESHLET_MIN_CONE_DOT = 0.1f;
+
+static Meshlet FinishMeshlet(const uint32* indices, uint32 firstIndex, uint32 indexCount, uint32 vertexCount,
+                             const Vertex* vertices) {
+    Meshlet meshlet;
+    meshlet.firstIndex = firstIndex;
+    meshlet.indexCount = indexCount;
+    meshlet.vertexCount = vertexCount;
+
+    const uint32* meshletIndices = indices + firstIndex;
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (uint32 i = 0; i < indexCount; ++i) {
+        boundsMin = glm::min(boundsMin, vertices[meshletIndices[i]].position);
+        boundsMax = glm::max(boundsMax, vertices[meshletIndices[i]].position);
+    }
+    meshlet.center = (boundsMin + boundsMax) * 0.5f;
+    for (uint32 i = 0; i < indexCount; ++i) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[meshletIndices[i]].position - meshlet.center));
+    }
+
+    // Counter-clockwise front faces, as the pipelines rasterize them
+    std::vector<glm::vec3> normals;
+    normals.reserve(indexCount / 3);
+    glm::vec3 axis(0.0f);
+    for (uint32 i = 0; i + 2 < indexCount; i += 3) {
+        const glm::vec3& p0 = vertices[meshletIndices[i]].position;
+        const glm::vec3& p1 = vertices[meshletIndices[i + 1]].position;
+        const glm::vec3& p2 = vertices[meshletIndices[i + 2]].position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area > 0.0f) {
+            normals.push_back(normal / area);
+            axis = axis + normal / area;
+        }
+    }
+    float axisLength = glm::length(axis);
+    if (normals.empty() || axisLength == 0.0f) {
+        return meshlet;
+    }
+    axis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const glm::vec3& normal : normals) {
+        minDot = std::min(minDot, glm::dot(normal, axis));
+    }
+    if (minDot <= MESHLET_MIN_CONE_DOT) {
+        return meshlet;
+    }
+    meshlet.coneAxis = axis;
+    meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    return meshlet;
+}
+
+std::vector<Meshlet> BuildMeshlets(uint32* indices, size_t indexCount, const Vertex* vertices,
+                                   size_t vertexCount, uint32 maxVertices, uint32 maxTriangles) {
+    std::vector<Meshlet> meshlets;
+    size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0 || maxVertices < 3 || maxTriangles == 0) {
+        return meshlets;
+    }
+
+    // Triangles around each vertex
+    std::vector<uint32> firstTriangle(vertexCount + 1, 0);
+    for (size_t i = 0; i < triangleCount * 3; ++i) {
+        ++firstTriangle[indices[i] + 1];
+    }
+    for (size_t v = 0; v < vertexCount; ++v) {
+        firstTriangle[v + 1] += firstTriangle[v];
+    }
+    std::vector<uint32> vertexTriangles(triangleCount * 3);
+    {
+        std::vector<uint32> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < triangleCount * 3; ++i) {
+            vertexTriangles[fill[indices[i]]++] = static_cast<uint32>(i / 3);
+        }
+    }
+
+    std::vector<uint32> output;
+    output.reserve(triangleCount * 3);
+    std::vector<uint8> emitted(triangleCount, 0);
+    std::vector<uint32> vertexMeshlet(vertexCount, INVALID_INDEX);  // Meshlet each vertex was last taken into
+    std::vector<uint32> meshletVertices;
+    uint32 seed = 0;
+    while (true) {
+        while (seed < triangleCount && emitted[seed]) {
+            ++seed;
+        }
+        if (seed == triangleCount) {
+            break;
+        }
+
+        uint32 meshletIndex = static_cast<uint32>(meshlets.size());
+        uint32 firstIndex = static_cast<uint32>(output.size());
+        meshletVertices.clear();
+        glm::vec3 centroid(0.0f);
+        uint32 triangle = seed;
+        uint32 taken = 0;
+        while (triangle != INVALID_INDEX) {
+            const uint32* tri = indices + static_cast<size_t>(triangle) * 3;
+            for (uint32 corner = 0; corner < 3; ++corner) {
+                if (vertexMeshlet[tri[corner]] != meshletIndex) {
+                    vertexMeshlet[tri[corner]] = meshletIndex;
+                    meshletVertices.push_back(tri[corner]);
+                    centroid = centroid + vertices[tri[corner]].position;
+                }
+            }
+            output.insert(output.end(), tri, tri + 3);
+            emitted[triangle] = 1;
+            ++taken;
+            if (taken == maxTriangles) {
+                break;
+            }
+
+            // Best neighbour that still fits
+            glm::vec3 center = centroid / static_cast<float>(meshletVertices.size());
+            triangle = INVALID_INDEX;
+            uint32 bestNew = 4;
+            float bestDistance = 0.0f;
+            for (uint32 vertex : meshletVertices) {
+                for (uint32 t = firstTriangle[vertex]; t < firstTriangle[vertex + 1]; ++t) {
+                    uint32 candidate = vertexTriangles[t];
+                    if (emitted[candidate]) {
+                        continue;
+                    }
+                    const uint32* candidateTri = indices + static_cast<size_t>(candidate) * 3;
+                    uint32 newVertices = 0;
+                    glm::vec3 candidateCenter(0.0f);
+                    for (uint32 corner = 0; corner < 3; ++corner) {
+                        bool repeated = (corner > 0 && candidateTri[corner] == candidateTri[0]) ||
+                                        (corner > 1 && candidateTri[corner] == candidateTri[1]);
+                        if (vertexMeshlet[candidateTri[corner]] != meshletIndex && !repeated) {
+                            ++newVertices;
+                        }
+                        candidateCenter = candidateCenter + vertices[candidateTri[corner]].position;
+                    }
+                    if (meshletVertices.size() + newVertices > maxVertices || newVertices > bestNew) {
+                        continue;
+                    }
+                    float distance = glm::length(candidateCenter / 3.0f - center);
+                    if (newVertices < bestNew || distance < bestDistance) {
+                        triangle = candidate;
+                        bestNew = newVertices;
+                        bestDistance = distance;
+                    }
+                }
+            }
+        }
+
+        meshlets.push_back(FinishMeshlet(output.data(), firstIndex, static_cast<uint32>(output.size()) - firstIndex,
+                                         static_cast<uint32>(meshletVertices.size()), vertices));
+    }
+
+    std::copy(output.begin(), output.end(), indices);
+    return meshlets;
+}
+
+void BuildMeshletData(MeshData& mesh) {
+    // Mapped (cached) meshes come with their meshlets. The bounds and cones of a deformed
+    // mesh's would only hold in the bind pose, so it is culled whole.
+    if (mesh.vertexStorage.empty() || mesh.indexStorage.empty() || mesh.IsDeformed()) {
+        return;
+    }
+
+    mesh.meshletStorage = BuildMeshlets(mesh.indexStorage.data(), mesh.indexStorage.size(), mesh.vertexStorage.data(),
+                                        mesh.vertexStorage.size());
+    mesh.meshlets = mesh.meshletStorage.data();
+    mesh.meshletCount = static_cast<uint32>(mesh.meshletStorage.size());
+}
+
+// ----------------------------------------------------------------------------
+// Simplification
+// ----------------------------------------------------------------------------
+//
+// Garland-Heckbert quadrics, with half-edge collapses so no vertex is created. Each
+// pass ranks every collapse of the current triangles by its error, then takes them in
+// order while their neighbourhoods are untouched by the pass's earlier collapses, so the
+// ranking stays exact within a pass. Quadrics are area-weighted and normalized by their
+// weight, which makes the error a distance in mesh units.
+
+constexpr float LOD_MAX_RELATIVE_ERROR = 0.05f;  // Of the mesh's bounding radius
+constexpr float LOD_MIN_REDUCTION = 0.85f;       // A level keeps at most this share of the one before
+constexpr size_t LOD_MIN_INDICES = 3 * 64;
+
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    void AddPlane(const glm::vec3& normal, float d, double planeWeight) {
+        double a = normal.x, b = normal.y, c = normal.z;
+        a2 += planeWeight * a * a; ab += planeWeight * a * b; ac += planeWeight * a * c; ad += planeWeight * a * d;
+        b2 += planeWeight * b * b; bc += planeWeight * b * c; bd += planeWeight * b * d;
+        c2 += planeWeight * c * c; cd += planeWeight * c * d;
+        d2 += planeWeight * d * d;
+        weight += planeWeight;
+    }
+
+    void Add(const Quadric& other) {
+        a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+        b2 += other.b2; bc += other.bc; bd += other.bd;
+        c2 += other.c2; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+    }
+
+    // Weighted mean squared distance of p to the planes
+    double Evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        double error = a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x +
+                       b2 * y * y + 2 * bc * y * z + 2 * bd * y +
+                       c2 * z * z + 2 * cd * z + d2;
+        return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+    }
+};
+
+struct PositionKey {
+    uint32 bits[3];
+    bool operator==(const PositionKey& other) const { return std::memcmp(bits, other.bits, sizeof(bits)) == 0; }
+};
+
+struct PositionKeyHash {
+    size_t operator()(const PositionKey& key) const {
+        return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+    }
+};
+
+struct Collapse {
+    uint32 from;
+    uint32 to;
+    float error;  // Squared
+};
+
+size_t SimplifyMesh(uint32* destination, const uint32* indices, size_t indexCount, const Vertex* vertices,
+                    size_t vertexCount, size_t targetIndexCount, float maxError, float* outError) {
+    std::vector<uint32> current(indices, indices + indexCount - indexCount % 3);
+    float resultError = 0.0f;
+
+    // Vertices sharing a position (attribute seams) share one quadric and stay in place
+    std::vector<uint32> weld(vertexCount);
+    std::vector<uint8> locked(vertexCount, 0);
+    {
+        std::unordered_map<PositionKey, uint32, PositionKeyHash> firstVertex;
+        firstVertex.reserve(vertexCount);
+        for (uint32 v = 0; v < vertexCount; ++v) {
+            PositionKey key;
+            std::memcpy(key.bits, &vertices[v].position, sizeof(key.bits));
+            auto [it, inserted] = firstVertex.emplace(key, v);
+            weld[v] = it->second;
+            if (!inserted) {
+                locked[v] = 1;
+                locked[it->second] = 1;
+            }
+        }
+    }
+
+    // Border edges (of the welded surface) have no twin running the other way
+    {
+        std::unordered_map<uint64, uint32> directedEdges;
+        directedEdges.reserve(current.size());
+        auto edgeKey = [](uint32 a, uint32 b) { return (static_cast<uint64>(a) << 32) | b; };
+        for (size_t i = 0; i < current.size(); i += 3) {
+            for (uint32 e = 0; e < 3; ++e) {
+                ++directedEdges[edgeKey(weld[current[i + e]], weld[current[i + (e + 1) % 3]])];
+            }
+        }
+        for (size_t i = 0; i < current.size(); i += 3) {
+            for (uint32 e = 0; e < 3; ++e) {
+                uint32 a = current[i + e];
+                uint32 b = current[i + (e + 1) % 3];
+                if (directedEdges.find(edgeKey(weld[b], weld[a])) == directedEdges.end()) {
+                    locked[a] = 1;
+                    locked[b] = 1;
+                }
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < current.size(); i += 3) {
+        const glm::vec3& p0 = vertices[current[i]].position;
+        const glm::vec3& p1 = vertices[current[i + 1]].position;
+        const glm::vec3& p2 = vertices[current[i + 2]].position;
+        glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+        float area = glm::length(normal);
+        if (area == 0.0f) {
+            continue;
+        }
+        normal = normal / area;
+        Quadric plane;
+        plane.AddPlane(normal, -glm::dot(normal, p0), area);
+        for (uint32 corner = 0; corner < 3; ++corner) {
+            quadrics[weld[current[i + corner]]].Add(plane);
+        }
+    }
+
+    float maxErrorSquared = maxError * maxError;
+    std::vector<uint32> firstTriangle(vertexCount + 1);
+    std::vector<uint32> vertexTriangles;
+    std::vector<Collapse> collapses;
+    std::vector<uint32> remap(vertexCount);
+    std::vector<uint8> touched(vertexCount);
+    while (current.size() > targetIndexCount) {
+        // Triangles around each vertex
+        size_t triangleCount = current.size() / 3;
+        std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+        for (uint32 index : current) {
+            ++firstTriangle[index + 1];
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            firstTriangle[v + 1] += firstTriangle[v];
+        }
+        vertexTriangles.resize(current.size());
+        {
+            std::vector<uint32> fill(firstTriangle.begin(), firstTriangle.end() - 1);
+            for (size_t i = 0; i < current.size(); ++i) {
+                vertexTriangles[fill[current[i]]++] = static_cast<uint32>(i / 3);
+            }
+        }
+
+        // Every collapse along an edge, cheapest first
+        collapses.clear();
+        for (size_t i = 0; i < current.size(); i += 3) {
+            for (uint32 e = 0; e < 3; ++e) {
+                uint32 from = current[i + e];
+                uint32 to = current[i + (e + 1) % 3];
+                if (locked[from] || weld[from] == weld[to]) {
+                    continue;
+                }
+                Quadric combined = quadrics[weld[from]];
+                combined.Add(quadrics[weld[to]]);
+                float error = static_cast<float>(combined.Evaluate(vertices[to].position));
+                if (error <= maxErrorSquared) {
+                    collapses.push_back({ from, to, error });
+                }
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+        // About two triangles go per collapse
+        size_t wanted = std::max<size_t>((current.size() - targetIndexCount) / 6, 1);
+        size_t made = 0;
+        for (uint32 v = 0; v < vertexCount; ++v) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+        for (const Collapse& collapse : collapses) {
+            if (made >= wanted) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Moving from onto to must not turn any remaining triangle around
+            bool flips = false;
+            const glm::vec3& target = vertices[collapse.to].position;
+            for (uint32 t = firstTriangle[collapse.from]; t < firstTriangle[collapse.from + 1] && !flips; ++t) {
+                const uint32* tri = &current[static_cast<size_t>(vertexTriangles[t]) * 3];
+                if (tri[0] == collapse.to || tri[1] == collapse.to || tri[2] == collapse.to) {
+                    continue;  // Collapses away
+                }
+                glm::vec3 p[3];
+                glm::vec3 moved[3];
+                for (uint32 corner = 0; corner < 3; ++corner) {
+                    p[corner] = vertices[tri[corner]].position;
+                    moved[corner] = tri[corner] == collapse.from ? target : p[corner];
+                }
+                glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+                glm::vec3 after = glm::cross(moved[1] - moved[0], moved[2] - moved[0]);
+                flips = glm::dot(before, after) <= 0.0f;
+            }
+            if (flips) {
+                continue;
+            }
+
+            remap[collapse.from] = collapse.to;
+            quadrics[weld[collapse.to]].Add(quadrics[weld[collapse.from]]);
+            resultError = std::max(resultError, collapse.error);
+            for (uint32 t = firstTriangle[collapse.from]; t < firstTriangle[collapse.from + 1]; ++t) {
+                const uint32* tri = &current[static_cast<size_t>(vertexTriangles[t]) * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            ++made;
+        }
+        if (made == 0) {
+            break;
+        }
+
+        // Drop the triangles that collapsed
+        size_t kept = 0;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            uint32 a = remap[current[t * 3]];
+            uint32 b = remap[current[t * 3 + 1]];
+            uint32 c = remap[current[t * 3 + 2]];
+            if (a != b && b != c && a != c) {
+                current[kept++] = a;
+                current[kept++] = b;
+                current[kept++] = c;
+            }
+        }
+        current.resize(kept);
+    }
+
+    std::copy(current.begin(), current.end(), destination);
+    if (outError) {
+        *outError = std::sqrt(resultError);
+    }
+    return current.size();
+}
+
+void BuildLodData(MeshData& mesh) {
+    // Mapped (cached) meshes come with their levels
+    if (mesh.vertexStorage.empty() || mesh.indexStorage.empty()) {
+        return;
+    }
+
+    mesh.lodStorage.clear();
+    mesh.lodIndexStorage.clear();
+
+    float radius = 0.5f * glm::length(mesh.boundsMax - mesh.boundsMin);
+    float maxError = radius * LOD_MAX_RELATIVE_ERROR;
+    std::vector<uint32> levelIndices(mesh.indexCount);
+    size_t previousCount = mesh.indexCount;
+    while (mesh.lodStorage.size() < MeshLod::MAX_LEVELS && previousCount / 2 >= LOD_MIN_INDICES) {
+        float error = 0.0f;
+        size_t target = (previousCount / 2) / 3 * 3;
+        size_t count = SimplifyMesh(levelIndices.data(), mesh.indices, mesh.indexCount, mesh.vertices,
+                                    mesh.vertexCount, target, maxError, &error);
+        if (static_cast<float>(count) > LOD_MIN_REDUCTION * static_cast<float>(previousCount)) {
+            break;
+        }
+
+        // Dropping triangles leaves the survivors in a poorer cache order
+        OptimizeVertexCache(levelIndices.data(), count, mesh.vertexCount);
+
+        MeshLod lod;
+        lod.firstIndex = static_cast<uint32>(mesh.lodIndexStorage.size());
+        lod.indexCount = static_cast<uint32>(count);
+        lod.error = error;
+        mesh.lodStorage.push_back(lod);
+        mesh.lodIndexStorage.insert(mesh.lodIndexStorage.end(), levelIndices.begin(), levelIndices.begin() + count);
+        previousCount = count;
+    }
+
+    mesh.lods = mesh.lodStorage.data();
+    mesh.lodCount = static_cast<uint32>(mesh.lodStorage.size());
+    mesh.lodIndices = mesh.lodIndexStorage.data();
+    mesh.lodIndexCount = static_cast<uint32>(mesh.lodIndexStorage.size());
+}
+
+void OptimizeMeshData(MeshData& mesh) {
+    // Mapped (cached) meshes were optimized before they were written
+    if (mesh.vertexStorage.empty() || mesh.indexStorage.empty()) {
+        return;
+    }
+
+    std::vector<Vertex>& vertices = mesh.vertexStorage;
+    std::vector<uint32>& indices = mesh.indexStorage;
+
+    OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+    OptimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertices.size());
+    // The skin and morph targets are parallel to the vertices, so deformed meshes keep their order
+    if (!mesh.IsDeformed()) {
+        vertices.resize(OptimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.size()));
+    }
+
+    mesh.vertices = vertices.data();
+    mesh.vertexCount = static_cast<uint32>(vertices.size());
+    mesh.indices = indices.data();
+    mesh.indexCount = static_cast<uint32>(indices.size());
+
+    // Dropped vertices may have extended the bounds
+    mesh.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    mesh.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const Vertex& vertex : vertices) {
+        mesh.boundsMin = glm::min(mesh.boundsMin, vertex.position);
+        mesh.boundsMax = glm::max(mesh.boundsMax, vertex.position);
+    }
+}
+
+} // namespace metagfx
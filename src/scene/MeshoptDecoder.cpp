@@ -0,0 +1,455 @@
+// ============================================================================
+// src/scene/MeshoptDecoder.cpp
+// ============================================================================
+#include "metagfx/scene/MeshoptDecoder.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace metagfx {
+
+// ----------------------------------------------------------------------------
+// Vertex codec
+// ----------------------------------------------------------------------------
+//
+// Elements are split into blocks. Within a block every byte position of the element
+// ("byte plane") is stored as zigzag-encoded deltas from the previous element, in
+// groups of 16 deltas packed at 0, 2, 4 or 8 bits; 2- and 4-bit groups escape values
+// that do not fit into trailing bytes. The stream ends with a tail holding the
+// baseline (first element) the first deltas are relative to.
+
+constexpr uint8 VERTEX_HEADER = 0xA0;
+constexpr size_t BYTE_GROUP_SIZE = 16;
+constexpr size_t VERTEX_BLOCK_SIZE_BYTES = 8192;
+constexpr size_t VERTEX_BLOCK_MAX_SIZE = 256;
+constexpr size_t TAIL_MAX_SIZE = 32;
+
+static size_t GetVertexBlockSize(size_t stride) {
+    size_t result = VERTEX_BLOCK_SIZE_BYTES / stride;
+    result &= ~(BYTE_GROUP_SIZE - 1);
+    return result < VERTEX_BLOCK_MAX_SIZE ? result : VERTEX_BLOCK_MAX_SIZE;
+}
+
+static uint8 Unzigzag8(uint8 value) {
+    return static_cast<uint8>(-(value & 1) ^ (value >> 1));
+}
+
+// Decode one group of 16 bytes; returns the position after it, or nullptr past end
+static const uint8* DecodeBytesGroup(const uint8* data, const uint8* end, uint8* out, uint32 bitsLog2) {
+    switch (bitsLog2) {
+        case 0:
+            std::memset(out, 0, BYTE_GROUP_SIZE);
+            return data;
+        case 1: {
+            if (end - data < 4) return nullptr;
+            const uint8* exceptions = data + 4;
+            for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+                uint8 encoded = (data[i / 4] >> (6 - (i % 4) * 2)) & 3;
+                if (encoded == 3) {
+                    if (exceptions >= end) return nullptr;
+                    encoded = *exceptions++;
+                }
+                out[i] = encoded;
+            }
+            return exceptions;
+        }
+        case 2: {
+            if (end - data < 8) return nullptr;
+            const uint8* exceptions = data + 8;
+            for (size_t i = 0; i < BYTE_GROUP_SIZE; ++i) {
+                uint8 encoded = (data[i / 2] >> (4 - (i % 2) * 4)) & 15;
+                if (encoded == 15) {
+                    if (exceptions >= end) return nullptr;
+                    encoded = *exceptions++;
+                }
+                out[i] = encoded;
+            }
+            return exceptions;
+        }
+        default:
+            if (end - data < static_cast<ptrdiff_t>(BYTE_GROUP_SIZE)) return nullptr;
+            std::memcpy(out, data, BYTE_GROUP_SIZE);
+            return data + BYTE_GROUP_SIZE;
+    }
+}
+
+// One byte plane of a block: 2-bit group modes (four per header byte), then the groups
+static const uint8* DecodeBytes(const uint8* data, const uint8* end, uint8* out, size_t alignedCount) {
+    size_t groupCount = alignedCount / BYTE_GROUP_SIZE;
+    size_t headerSize = (groupCount + 3) / 4;
+    if (static_cast<size_t>(end - data) < headerSize) {
+        return nullptr;
+    }
+
+    const uint8* header = data;
+    data += headerSize;
+    for (size_t group = 0; group < groupCount && data; ++group) {
+        uint32 bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data = DecodeBytesGroup(data, end, out + group * BYTE_GROUP_SIZE, bitsLog2);
+    }
+    return data;
+}
+
+bool DecodeMeshoptVertexBuffer(void* destination, size_t count, size_t stride,
+                               const uint8* buffer, size_t size) {
+    if (stride == 0 || stride > 256 || stride % 4 != 0) {
+        return false;
+    }
+
+    size_t tailSize = stride < TAIL_MAX_SIZE ? TAIL_MAX_SIZE : stride;
+    if (size < 1 + tailSize || buffer[0] != VERTEX_HEADER) {
+        return false;
+    }
+
+    const uint8* data = buffer + 1;
+    const uint8* end = buffer + size - tailSize;
+
+    uint8 last[256];
+    std::memcpy(last, buffer + size - stride, stride);
+
+    uint8* output = static_cast<uint8*>(destination);
+    size_t blockSize = GetVertexBlockSize(stride);
+    uint8 deltas[VERTEX_BLOCK_MAX_SIZE];
+
+    for (size_t blockStart = 0; blockStart < count; blockStart += blockSize) {
+        size_t blockCount = count - blockStart < blockSize ? count - blockStart : blockSize;
+        size_t alignedCount = (blockCount + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+
+        for (size_t k = 0; k < stride; ++k) {
+            data = DecodeBytes(data, end, deltas, alignedCount);
+            if (!data) {
+                return false;
+            }
+
+            uint8 previous = last[k];
+            for (size_t i = 0; i < blockCount; ++i) {
+                uint8 value = static_cast<uint8>(Unzigzag8(deltas[i]) + previous);
+                output[(blockStart + i) * stride + k] = value;
+                previous = value;
+            }
+            last[k] = previous;
+        }
+    }
+
+    // Everything up to the tail must have been consumed
+    return data == end;
+}
+
+// ----------------------------------------------------------------------------
+// Index codecs
+// ----------------------------------------------------------------------------
+
+constexpr uint8 INDEX_HEADER = 0xE0;
+constexpr uint8 SEQUENCE_HEADER = 0xD0;
+
+static uint32 DecodeVByte(const uint8*& data) {
+    uint8 lead = *data++;
+    if (lead < 128) {
+        return lead;
+    }
+
+    // Up to 5 bytes of 7 bits, low bits first
+    uint32 result = lead & 127;
+    uint32 shift = 7;
+    for (int i = 0; i < 4; ++i) {
+        uint8 group = *data++;
+        result |= static_cast<uint32>(group & 127) << shift;
+        shift += 7;
+        if (group < 128) {
+            break;
+        }
+    }
+    return result;
+}
+
+static uint32 DecodeIndex(const uint8*& data, uint32 last) {
+    uint32 value = DecodeVByte(data);
+    uint32 delta = (value >> 1) ^ (0u - (value & 1));
+    return last + delta;
+}
+
+static void WriteIndex(void* destination, size_t offset, size_t indexSize, uint32 value) {
+    if (indexSize == 2) {
+        static_cast<uint16*>(destination)[offset] = static_cast<uint16>(value);
+    } else {
+        static_cast<uint32*>(destination)[offset] = value;
+    }
+}
+
+bool DecodeMeshoptIndexBuffer(void* destination, size_t count, size_t indexSize,
+                              const uint8* buffer, size_t size) {
+    if (count % 3 != 0 || (indexSize != 2 && indexSize != 4)) {
+        return false;
+    }
+
+    // Header, one code per triangle and the 16-entry auxiliary code table at the end
+    if (size < 1 + count / 3 + 16 || (buffer[0] & 0xF0) != INDEX_HEADER) {
+        return false;
+    }
+    uint32 version = buffer[0] & 0x0F;
+    if (version > 1) {
+        return false;
+    }
+
+    // A triangle reads at most 16 bytes past `data`, which the table guarantees
+    const uint8* code = buffer + 1;
+    const uint8* data = code + count / 3;
+    const uint8* safeEnd = buffer + size - 16;
+    const uint8* codeAuxTable = safeEnd;
+
+    // Recently seen edges and vertices; codes refer to them by age
+    uint32 edgeFifo[16][2];
+    uint32 vertexFifo[16];
+    std::memset(edgeFifo, 0xFF, sizeof(edgeFifo));
+    std::memset(vertexFifo, 0xFF, sizeof(vertexFifo));
+    size_t edgeOffset = 0;
+    size_t vertexOffset = 0;
+
+    auto pushVertex = [&](uint32 v, bool advance = true) {
+        vertexFifo[vertexOffset] = v;
+        vertexOffset = (vertexOffset + (advance ? 1 : 0)) & 15;
+    };
+    auto pushEdge = [&](uint32 a, uint32 b) {
+        edgeFifo[edgeOffset][0] = a;
+        edgeFifo[edgeOffset][1] = b;
+        edgeOffset = (edgeOffset + 1) & 15;
+    };
+
+    uint32 next = 0;  // Next never-seen vertex
+    uint32 last = 0;  // Last explicitly encoded vertex; free indices are deltas from it
+    int fecMax = version >= 1 ? 13 : 15;
+
+    for (size_t i = 0; i < count; i += 3) {
+        if (data > safeEnd) {
+            return false;
+        }
+
+        uint8 codeTri = *code++;
+        uint32 a, b, c;
+
+        if (codeTri < 0xF0) {
+            // Shares an edge from the FIFO; the third vertex is new, recent or free
+            int fe = codeTri >> 4;
+            a = edgeFifo[(edgeOffset - 1 - fe) & 15][0];
+            b = edgeFifo[(edgeOffset - 1 - fe) & 15][1];
+
+            int fec = codeTri & 15;
+            if (fec < fecMax) {
+                bool fec0 = fec == 0;
+                c = fec0 ? next : vertexFifo[(vertexOffset - 1 - fec) & 15];
+                next += fec0 ? 1 : 0;
+                pushVertex(c, fec0);
+            } else {
+                // 13 and 14 (version 1) decode to -1 and +1
+                c = fec != 15 ? last + static_cast<uint32>(fec - (fec ^ 3)) : DecodeIndex(data, last);
+                last = c;
+                pushVertex(c);
+            }
+
+            pushEdge(c, b);
+            pushEdge(a, c);
+        } else if (codeTri < 0xFE) {
+            // No shared edge; the first vertex is new, the others come from the code table
+            uint8 codeAux = codeAuxTable[codeTri & 15];
+            int feb = codeAux >> 4;
+            int fec = codeAux & 15;
+
+            a = next++;
+
+            bool feb0 = feb == 0;
+            b = feb0 ? next : vertexFifo[(vertexOffset - feb) & 15];
+            next += feb0 ? 1 : 0;
+
+            bool fec0 = fec == 0;
+            c = fec0 ? next : vertexFifo[(vertexOffset - fec) & 15];
+            next += fec0 ? 1 : 0;
+
+            pushVertex(a);
+            pushVertex(b, feb0);
+            pushVertex(c, fec0);
+
+            pushEdge(b, a);
+            pushEdge(c, b);
+            pushEdge(a, c);
+        } else {
+            // Explicit codes in the data stream; 15 marks a free index, aux 0 resets `next`
+            uint8 codeAux = *data++;
+            int fea = codeTri == 0xFE ? 0 : 15;
+            int feb = codeAux >> 4;
+            int fec = codeAux & 15;
+
+            if (codeAux == 0) {
+                next = 0;
+            }
+
+            a = fea == 0 ? next++ : 0;
+            b = feb == 0 ? next++ : vertexFifo[(vertexOffset - feb) & 15];
+            c = fec == 0 ? next++ : vertexFifo[(vertexOffset - fec) & 15];
+
+            if (fea == 15) last = a = DecodeIndex(data, last);
+            if (feb == 15) last = b = DecodeIndex(data, last);
+            if (fec == 15) last = c = DecodeIndex(data, last);
+
+            pushVertex(a);
+            pushVertex(b, feb == 0 || feb == 15);
+            pushVertex(c, fec == 0 || fec == 15);
+
+            pushEdge(b, a);
+            pushEdge(c, b);
+            pushEdge(a, c);
+        }
+
+        WriteIndex(destination, i + 0, indexSize, a);
+        WriteIndex(destination, i + 1, indexSize, b);
+        WriteIndex(destination, i + 2, indexSize, c);
+    }
+
+    return data == safeEnd;
+}
+
+bool DecodeMeshoptIndexSequence(void* destination, size_t count, size_t indexSize,
+                                const uint8* buffer, size_t size) {
+    if (indexSize != 2 && indexSize != 4) {
+        return false;
+    }
+
+    // Header, at least one byte per index and a 4-byte tail that bounds vbyte reads
+    if (size < 1 + count + 4 || (buffer[0] & 0xF0) != SEQUENCE_HEADER) {
+        return false;
+    }
+    uint32 version = buffer[0] & 0x0F;
+    if (version > 1) {
+        return false;
+    }
+
+    const uint8* data = buffer + 1;
+    const uint8* safeEnd = buffer + size - 4;
+
+    // Two baselines; the low bit of each value selects which one the delta applies to
+    uint32 last[2] = { 0, 0 };
+
+    for (size_t i = 0; i < count; ++i) {
+        if (data >= safeEnd) {
+            return false;
+        }
+
+        uint32 value = DecodeVByte(data);
+        uint32 current = value & 1;
+        value >>= 1;
+
+        uint32 delta = (value >> 1) ^ (0u - (value & 1));
+        last[current] += delta;
+        WriteIndex(destination, i, indexSize, last[current]);
+    }
+
+    return data == safeEnd;
+}
+
+// ----------------------------------------------------------------------------
+// Filters
+// ----------------------------------------------------------------------------
+
+template<typename T>
+static void DecodeOctahedralFilter(T* data, size_t count) {
+    // Components 0/1 hold the octahedral coordinates, component 2 the quantization
+    // range (also the target length); component 3 is passed through
+    constexpr float MAX_VALUE = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+
+    for (size_t i = 0; i < count; ++i) {
+        T* element = data + i * 4;
+        float one = static_cast<float>(element[2]);
+        float x = static_cast<float>(element[0]);
+        float y = static_cast<float>(element[1]);
+        float z = one - std::fabs(x) - std::fabs(y);
+
+        // Fold the lower hemisphere back over the diagonals
+        float t = z < 0.0f ? -z : 0.0f;
+        x += x >= 0.0f ? -t : t;
+        y += y >= 0.0f ? -t : t;
+
+        float length = std::sqrt(x * x + y * y + z * z);
+        float scale = length > 0.0f ? MAX_VALUE / length : 0.0f;
+
+        element[0] = static_cast<T>(std::lround(x * scale));
+        element[1] = static_cast<T>(std::lround(y * scale));
+        element[2] = static_cast<T>(std::lround(z * scale));
+    }
+}
+
+static void DecodeQuaternionFilter(int16* data, size_t count) {
+    constexpr float SQRT_HALF = 0.70710678f;
+
+    for (size_t i = 0; i < count; ++i) {
+        int16* element = data + i * 4;
+
+        // The fourth component stores the quantization scale (upper bits) and the
+        // index of the dropped largest component (lower 2 bits)
+        int32 sf = element[3] | 3;
+        float scale = SQRT_HALF / static_cast<float>(sf);
+
+        float x = static_cast<float>(element[0]) * scale;
+        float y = static_cast<float>(element[1]) * scale;
+        float z = static_cast<float>(element[2]) * scale;
+        float ww = 1.0f - x * x - y * y - z * z;
+        float w = std::sqrt(ww >= 0.0f ? ww : 0.0f);
+
+        int32 qc = element[3] & 3;
+        int16 values[4] = {
+            static_cast<int16>(std::lround(x * 32767.0f)),
+            static_cast<int16>(std::lround(y * 32767.0f)),
+            static_cast<int16>(std::lround(z * 32767.0f)),
+            static_cast<int16>(std::lround(w * 32767.0f))
+        };
+
+        // Rotate so the reconstructed component lands at index qc
+        element[(qc + 1) & 3] = values[0];
+        element[(qc + 2) & 3] = values[1];
+        element[(qc + 3) & 3] = values[2];
+        element[(qc + 0) & 3] = values[3];
+    }
+}
+
+static void DecodeExponentialFilter(uint32* data, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        uint32 value = data[i];
+
+        // Signed 24-bit mantissa, signed 8-bit exponent
+        int32 mantissa = static_cast<int32>(value << 8) >> 8;
+        int32 exponent = static_cast<int32>(value) >> 24;
+
+        float result = std::ldexp(static_cast<float>(mantissa), exponent);
+        std::memcpy(&data[i], &result, sizeof(result));
+    }
+}
+
+bool ApplyMeshoptFilter(void* data, size_t count, size_t stride, MeshoptFilter filter) {
+    switch (filter) {
+        case MeshoptFilter::None:
+            return true;
+        case MeshoptFilter::Octahedral:
+            if (stride == 4) {
+                DecodeOctahedralFilter(static_cast<int8*>(data), count);
+                return true;
+            }
+            if (stride == 8) {
+                DecodeOctahedralFilter(static_cast<int16*>(data), count);
+                return true;
+            }
+            return false;
+        case MeshoptFilter::Quaternion:
+            if (stride != 8) {
+                return false;
+            }
+            DecodeQuaternionFilter(static_cast<int16*>(data), count);
+            return true;
+        case MeshoptFilter::Exponential:
+            if (stride % 4 != 0) {
+                return false;
+            }
+            DecodeExponentialFilter(static_cast<uint32*>(data), count * (stride / 4));
+            return true;
+    }
+    return false;
+}
+
+} // namespace metagfx
@@ -2,19 +2,48 @@
 // src/scene/Model.cpp
 // ============================================================================
 #include "metagfx/scene/Model.h"
+#include "metagfx/scene/BVH.h"
+#include "metagfx/scene/GLTFLoader.h"
+#include "metagfx/scene/MeshOptimizer.h"
+#include "metagfx/scene/ModelCache.h"
 #include "metagfx/scene/Material.h"
+#include "metagfx/rhi/FormatInfo.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Types.h"
+#include "metagfx/core/AllocationTracker.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/core/SimdMath.h"
+#include "metagfx/utils/AssetArchive.h"
+#include "metagfx/utils/MappedFile.h"
 #include "metagfx/utils/TextureUtils.h"
+#include "metagfx/utils/TextureManifest.h"
+#include "metagfx/utils/TextureCache.h"
 
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <assimp/GltfMaterial.h>
 
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <iterator>
 #include <limits>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 namespace metagfx {
 
@@ -27,6 +56,22 @@ Model::~Model() {
 Model::Model(Model&& other) noexcept
     : m_Meshes(std::move(other.m_Meshes))
     , m_FilePath(std::move(other.m_FilePath))
+    , m_VertexFormat(other.m_VertexFormat)
+    , m_Quantization(other.m_Quantization)
+    , m_GeometryPool(std::move(other.m_GeometryPool))
+    , m_DrawList(std::move(other.m_DrawList))
+    , m_MeshBounds(std::move(other.m_MeshBounds))
+    , m_BoundsMin(other.m_BoundsMin)
+    , m_BoundsMax(other.m_BoundsMax)
+    , m_NodeLocal(std::move(other.m_NodeLocal))
+    , m_NodeWorld(std::move(other.m_NodeWorld))
+    , m_NodeParents(std::move(other.m_NodeParents))
+    , m_MeshNodes(std::move(other.m_MeshNodes))
+    , m_StreamableTextures(std::move(other.m_StreamableTextures))
+    , m_ResourceGroup(other.m_ResourceGroup)
+    , m_Skins(std::move(other.m_Skins))
+    , m_Animations(std::move(other.m_Animations))
+    , m_DeformedMeshes(std::move(other.m_DeformedMeshes))
 {
 }
 
@@ -35,344 +80,1705 @@ Model& Model::operator=(Model&& other) noexcept {
         Cleanup();
         m_Meshes = std::move(other.m_Meshes);
         m_FilePath = std::move(other.m_FilePath);
+        m_VertexFormat = other.m_VertexFormat;
+        m_Quantization = other.m_Quantization;
+        m_GeometryPool = std::move(other.m_GeometryPool);
+        m_DrawList = std::move(other.m_DrawList);
+        m_MeshBounds = std::move(other.m_MeshBounds);
+        m_BoundsMin = other.m_BoundsMin;
+        m_BoundsMax = other.m_BoundsMax;
+        m_NodeLocal = std::move(other.m_NodeLocal);
+        m_NodeWorld = std::move(other.m_NodeWorld);
+        m_NodeParents = std::move(other.m_NodeParents);
+        m_MeshNodes = std::move(other.m_MeshNodes);
+        m_StreamableTextures = std::move(other.m_StreamableTextures);
+        m_ResourceGroup = other.m_ResourceGroup;
+        m_Skins = std::move(other.m_Skins);
+        m_Animations = std::move(other.m_Animations);
+        m_DeformedMeshes = std::move(other.m_DeformedMeshes);
     }
     return *this;
 }
 
+void Model::CreateDrawList(rhi::GraphicsDevice* device) {
+    m_DrawList.reset();
+    if (!m_GeometryPool || m_Meshes.empty()) {
+        return;
+    }
+
+    // firstInstance selects the node transform. Without indirect firstInstance support it
+    // must be 0, which is only right when every mesh sits at the model origin.
+    bool nodeInstances = device->GetDeviceInfo().supportsDrawIndirectFirstInstance;
+    if (!nodeInstances && HasNodeTransforms()) {
+        return;
+    }
+
+    std::vector<rhi::DrawIndexedIndirectCommand> commands;
+    commands.reserve(m_Meshes.size());
+    for (size_t i = 0; i < m_Meshes.size(); ++i) {
+        const Mesh& mesh = *m_Meshes[i];
+        if (!mesh.IsPooled()) {
+            return;  // Some mesh has its own buffers; a single indirect draw cannot cover it
+        }
+        rhi::DrawIndexedIndirectCommand command;
+        command.indexCount = mesh.GetIndexCount();
+        command.instanceCount = 1;
+        command.firstIndex = mesh.GetFirstIndex();
+        command.vertexOffset = mesh.GetVertexOffset();
+        command.firstInstance = nodeInstances ? m_MeshNodes[i] : 0;
+        commands.push_back(command);
+    }
+
+    rhi::DrawListDesc desc;
+    desc.commands = std::move(commands);
+    desc.debugName = "ModelIndirectDraws";
+    m_DrawList = device->CreateDrawList(desc);
+    if (m_DrawList && !m_DrawList->GetBuffer()) {
+        m_DrawList.reset();
+    }
+}
+
+glm::mat4 Model::GetDequantizeMatrix() const {
+    return m_VertexFormat == VertexFormat::Compact ? m_Quantization.GetDequantizeMatrix() : glm::mat4(1.0f);
+}
+
+// Where a model's material textures are resolved from
+struct TextureLookup {
+    std::string modelPath;
+    std::string modelDir;
+    utils::TextureManifest cooked;         // texture_cook output; empty when the model was not cooked
+    utils::TextureCache* cache = nullptr;  // Optional; shares textures across materials and reloads
+    const std::vector<EmbeddedTexture>* embedded = nullptr;  // ModelData::embeddedTextures
+
+    // ModelImportSettings::textureStreamingExtent; capped textures are listed in streamable
+    uint32 streamingExtent = 0;
+    std::vector<StreamableTexture>* streamable = nullptr;  // The model's, filled on the device's thread
+
+    // Decoded in parallel before the material pass (PreloadTextures); nullptr = decode failed
+    std::unordered_map<std::string, Ref<rhi::Texture>> preloaded;
+};
+
+// What a material slot samples, which decides the format its decoded images get: scalar
+// maps keep R alone and normal maps RG (the shaders rebuild Z), so only color and
+// packed maps pay for RGBA
+enum class TextureSlot {
+    Color,   // Albedo, emissive: RGBA8 sRGB
+    Normal,  // RG8
+    Scalar,  // Roughness, AO: R8
+    Packed   // glTF metallic-roughness (R = AO, G = roughness, B = metallic): RGBA8
+};
+
+static rhi::Format GetSlotFormat(TextureSlot slot) {
+    switch (slot) {
+        case TextureSlot::Color:  return rhi::Format::R8G8B8A8_SRGB;
+        case TextureSlot::Normal: return rhi::Format::R8G8_UNORM;
+        case TextureSlot::Scalar: return rhi::Format::R8_UNORM;
+        default:                  return rhi::Format::R8G8B8A8_UNORM;
+    }
+}
+
+// An AO map that is also the metallic-roughness map (ORM) is loaded once, as the latter
+static TextureSlot GetAOSlot(const MaterialDesc& desc) {
+    bool packed = desc.aoMap == desc.metallicRoughnessMap || desc.aoMap == desc.packedMetallicRoughnessMap;
+    return packed ? TextureSlot::Packed : TextureSlot::Scalar;
+}
+
+static std::string MakePreloadKey(const std::string& texPath, TextureSlot slot) {
+    return std::to_string(static_cast<int>(slot)) + "\t" + texPath;
+}
+
+// Create the texture through the cache when the caller provided one.
+// data/size is what identifies the content (the encoded file, not decoded pixels).
+static Ref<rhi::Texture> AcquireTexture(const TextureLookup& textures,
+                                        const std::string& source,
+                                        const void* data,
+                                        uint64 size,
+                                        rhi::Format format,
+                                        const std::function<Ref<rhi::Texture>()>& create) {
+    if (!textures.cache) {
+        return create();
+    }
+
+    utils::TextureCacheKey key{ source, utils::TextureCache::HashBytes(data, size), format };
+    return textures.cache->Acquire(key, create);
+}
+
+static bool ReadFileBytes(const std::filesystem::path& path, std::vector<uint8>& outData) {
+    utils::MappedFile file;  // Asset archives included
+    if (!file.Open(path.string())) {
+        return false;
+    }
+    outData.assign(file.GetData(), file.GetData() + file.GetSize());
+    return true;
+}
+
+// Decode an encoded image (PNG, JPG, ...) and upload it in format (8-bit R, RG or RGBA)
+// with a generated mip chain
+static Ref<rhi::Texture> CreateTextureFromEncodedImage(rhi::GraphicsDevice* device,
+                                                       const uint8* data,
+                                                       uint64 size,
+                                                       rhi::Format format) {
+    utils::ImageData imageData = utils::LoadImageFromMemory(data, static_cast<uint32>(size), 4);
+    if (!imageData.pixels) {
+        return nullptr;
+    }
+    utils::KeepImageChannels(imageData, static_cast<uint32>(rhi::GetFormatImageSize(format, 1, 1)));
+
+    auto texture = utils::CreateTextureFromImage(device, imageData, format);
+    utils::FreeImage(imageData);
+    return texture;
+}
+
+// Create a KTX2 or DDS file's texture without its mips above the streaming extent, and
+// list it for TextureStreamer when that left some out. data/size identify the content as
+// for AcquireTexture().
+static Ref<rhi::Texture> LoadStreamableTexture(rhi::GraphicsDevice* device,
+                                               const TextureLookup& textures,
+                                               const std::string& path,
+                                               const std::string& source,
+                                               const void* data,
+                                               uint64 size,
+                                               rhi::Format format) {
+    // The capped texture is another upload than the file's full chain
+    std::string cappedSource = source + "@" + std::to_string(textures.streamingExtent);
+
+    bool created = false;
+    bool capped = false;
+    auto texture = AcquireTexture(textures, cappedSource, data, size, format, [&]() -> Ref<rhi::Texture> {
+        created = true;
+        utils::TextureMipChain chain;
+        if (!utils::LoadTextureMipChain(device, path, chain, textures.streamingExtent)) {
+            return nullptr;
+        }
+        capped = chain.firstMip > 0;
+        return utils::CreateTextureFromMipChain(device, chain, path.c_str());
+    });
+
+    // A texture taken from the cache was capped if it fits the extent; the streamer
+    // finds out from the file when it was not
+    bool fits = texture && std::max(texture->GetWidth(), texture->GetHeight()) <= textures.streamingExtent;
+    if (textures.streamable && (capped || (!created && fits))) {
+        auto& streamable = *textures.streamable;
+        bool listed = std::any_of(streamable.begin(), streamable.end(),
+                                  [&](const StreamableTexture& entry) { return entry.texture == texture; });
+        if (!listed) {
+            streamable.push_back({ texture, path });
+        }
+    }
+    return texture;
+}
+
+static Ref<rhi::Texture> LoadCookedFile(rhi::GraphicsDevice* device, const std::string& cookedPath) {
+    if (std::filesystem::path(cookedPath).extension() == ".ktx2") {
+        return utils::LoadKTX2Texture(device, cookedPath);
+    }
+    return utils::LoadDDS2DTexture(device, cookedPath);
+}
+
+// Load the texture_cook output for a source texture (block-compressed, full mip chain).
+// Returns nullptr when the cooked file is missing, stale or not usable on this device,
+// in which case the caller decodes the source image instead.
+static Ref<rhi::Texture> LoadCookedTexture(rhi::GraphicsDevice* device,
+                                           const TextureLookup& textures,
+                                           const std::string& texPath,
+                                           const std::string& cookedPath,
+                                           rhi::Format format) {
+    // Packed cooked files are identified by their size and content hash, and packed
+    // sources cannot change underneath them
+    utils::AssetArchive::EntryInfo packed;
+    if (utils::AssetArchive::FindMounted(cookedPath, &packed)) {
+        uint64 stamp[2] = { packed.size, packed.hash };
+        std::string source = utils::AssetArchive::NormalizePath(cookedPath);
+        if (textures.streamingExtent > 0) {
+            return LoadStreamableTexture(device, textures, cookedPath, source, stamp, sizeof(stamp), format);
+        }
+        return AcquireTexture(textures, source, stamp, sizeof(stamp), format, [&]() {
+            return LoadCookedFile(device, cookedPath);
+        });
+    }
+
+    std::error_code ec;
+    if (!std::filesystem::exists(cookedPath, ec)) {
+        METAGFX_WARN << "Cooked texture listed in manifest is missing: " << cookedPath;
+        return nullptr;
+    }
+
+    auto cookedTime = std::filesystem::last_write_time(cookedPath, ec);
+    if (ec) {
+        return nullptr;
+    }
+
+    // An edited source wins over an old cooked file
+    if (texPath[0] != '*') {
+        std::filesystem::path sourcePath = std::filesystem::path(textures.modelDir) / texPath;
+        auto sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+        if (!ec && sourceTime > cookedTime) {
+            METAGFX_WARN << "Cooked texture is older than its source, re-run texture_cook: " << cookedPath;
+            return nullptr;
+        }
+    }
+
+    // Cooked files are loaded by path, so they are identified by size and write time
+    // instead of hashing their contents
+    uint64 stamp[2] = {
+        static_cast<uint64>(std::filesystem::file_size(cookedPath, ec)),
+        static_cast<uint64>(cookedTime.time_since_epoch().count())
+    };
+    std::string source = std::filesystem::absolute(cookedPath, ec).lexically_normal().string();
+
+    if (textures.streamingExtent > 0) {
+        return LoadStreamableTexture(device, textures, cookedPath, source, stamp, sizeof(stamp), format);
+    }
+
+    return AcquireTexture(textures, source, stamp, sizeof(stamp), format, [&]() {
+        return LoadCookedFile(device, cookedPath);
+    });
+}
+
+// Result of decoding one texture, possibly on a worker thread
+struct DecodedTexture {
+    size_t requestIndex = 0;
+    utils::TextureCacheKey key;
+    Ref<rhi::Texture> cached;  // Already in the texture cache, nothing was decoded
+    utils::ImageData image;    // stb_image pixels; freed once uploaded
+};
+
+// Create and upload (or take from the cache) a decoded texture and free its pixels.
+// Runs on the thread that owns the device.
+static Ref<rhi::Texture> CreateDecodedTexture(rhi::GraphicsDevice* device, DecodedTexture& decoded,
+                                              const TextureLookup& textures) {
+    Ref<rhi::Texture> texture = decoded.cached;
+    if (!texture && decoded.image.pixels) {
+        auto create = [&]() { return utils::CreateTextureFromImage(device, decoded.image, decoded.key.format); };
+        texture = textures.cache ? textures.cache->Acquire(decoded.key, create) : create();
+    }
+    if (decoded.image.pixels) {
+        utils::FreeImage(decoded.image);
+    }
+    return texture;
+}
+
+// ============================================================================
+// Packed AO-roughness-metallic maps
+// ============================================================================
+//
+// Separate AO and roughness maps, or an AO map next to glTF's metallic-roughness map,
+// are packed at import into one texture laid out like the latter (R = AO, G = roughness,
+// B = metallic), so the shaders sample one map instead of two or three. The packed
+// texture's reference lists its channels: "orm:<R>|<G>|<B>", each either a channel
+// index followed by a texture reference, or "=" and a constant.
+
+struct PackedChannel {
+    std::string texPath;  // Empty: constant
+    uint32 channel = 0;   // Of texPath's texels
+    uint8 constant = 255;
+};
+
+static bool IsPackedORMPath(const std::string& texPath) {
+    return texPath.compare(0, 4, "orm:") == 0;
+}
+
+// Only images stb_image decodes are packed: not KTX2, DDS, raw embedded texels or
+// textures that were cooked (they are block-compressed already)
+static bool IsPackableTexture(const std::string& texPath, const TextureLookup& textures) {
+    if (texPath.empty() || !textures.cooked.Find(texPath, false).empty()) {
+        return false;
+    }
+    if (texPath[0] == '*') {
+        int textureIndex = std::atoi(texPath.c_str() + 1);
+        if (!textures.embedded || textureIndex < 0 || static_cast<size_t>(textureIndex) >= textures.embedded->size()) {
+            return false;
+        }
+        const EmbeddedTexture& embeddedTex = (*textures.embedded)[textureIndex];
+        return embeddedTex.width == 0 && embeddedTex.data && !utils::IsKTX2Data(embeddedTex.data, embeddedTex.size);
+    }
+    std::filesystem::path extension = std::filesystem::path(texPath).extension();
+    return extension != ".ktx2" && extension != ".dds";
+}
+
+// Reference of a material's packed map, or empty when it has fewer than two maps to pack
+static std::string MakePackedORMPath(const MaterialDesc& desc, const TextureLookup& textures) {
+    if (desc.aoMap.empty() || !desc.packedMetallicRoughnessMap.empty() || !IsPackableTexture(desc.aoMap, textures)) {
+        return {};
+    }
+
+    std::string ao = "0" + desc.aoMap;
+    if (!desc.metallicRoughnessMap.empty()) {
+        if (desc.metallicRoughnessMap == desc.aoMap || !IsPackableTexture(desc.metallicRoughnessMap, textures)) {
+            return {};
+        }
+        return "orm:" + ao + "|1" + desc.metallicRoughnessMap + "|2" + desc.metallicRoughnessMap;
+    }
+    if (desc.roughnessMap.empty() || desc.roughnessMap == desc.aoMap || !IsPackableTexture(desc.roughnessMap, textures)) {
+        return {};
+    }
+    // Without a metallic map the shader would use the material's value
+    int metallic = static_cast<int>(glm::clamp(desc.metallic, 0.0f, 1.0f) * 255.0f + 0.5f);
+    return "orm:" + ao + "|0" + desc.roughnessMap + "|=" + std::to_string(metallic);
+}
+
+static bool ParsePackedORMPath(const std::string& texPath, PackedChannel channels[3]) {
+    size_t start = 4;
+    for (uint32 i = 0; i < 3; ++i) {
+        size_t end = i < 2 ? texPath.find('|', start) : texPath.size();
+        if (end == std::string::npos || end - start < 2) {
+            return false;
+        }
+        if (texPath[start] == '=') {
+            channels[i].constant = static_cast<uint8>(std::atoi(texPath.c_str() + start + 1));
+        } else {
+            channels[i].channel = static_cast<uint32>(texPath[start] - '0');
+            channels[i].texPath = texPath.substr(start + 1, end - start - 1);
+        }
+        start = end + 1;
+    }
+    return true;
+}
+
+// Read, hash, decode and pack the sources of a packed map (any thread). The image is
+// left empty when a source fails or the sources differ in size; the caller then loads
+// the maps separately.
+static DecodedTexture DecodePackedORM(const std::string& texPath, const TextureLookup& textures) {
+    DecodedTexture result;
+    result.key.source = textures.modelPath + "|" + texPath;
+    result.key.format = rhi::Format::R8G8B8A8_UNORM;
+
+    PackedChannel channels[3];
+    if (!ParsePackedORMPath(texPath, channels)) {
+        return result;
+    }
+
+    // Each distinct source once
+    struct Source {
+        std::string texPath;
+        std::vector<uint8> fileData;
+        const uint8* data = nullptr;
+        uint64 size = 0;
+        utils::ImageData image;
+    };
+    std::vector<Source> sources;
+    sources.reserve(3);
+    uint32 sourceIndex[3] = {};
+    bool failed = false;
+    for (uint32 i = 0; i < 3 && !failed; ++i) {
+        const std::string& path = channels[i].texPath;
+        if (path.empty()) {
+            continue;
+        }
+        auto it = std::find_if(sources.begin(), sources.end(), [&](const Source& source) { return source.texPath == path; });
+        sourceIndex[i] = static_cast<uint32>(it - sources.begin());
+        if (it != sources.end()) {
+            continue;
+        }
+
+        Source& source = sources.emplace_back();
+        source.texPath = path;
+        if (path[0] == '*') {
+            const EmbeddedTexture& embeddedTex = (*textures.embedded)[std::atoi(path.c_str() + 1)];
+            source.data = embeddedTex.data;
+            source.size = embeddedTex.size;
+        } else if (ReadFileBytes(std::filesystem::path(textures.modelDir) / path, source.fileData)) {
+            source.data = source.fileData.data();
+            source.size = source.fileData.size();
+        } else {
+            METAGFX_ERROR << "Failed to load texture from: " << path;
+            failed = true;
+        }
+    }
+    if (failed) {
+        return result;
+    }
+
+    if (textures.cache) {
+        uint64 hashes[3] = {};
+        for (size_t i = 0; i < sources.size(); ++i) {
+            hashes[i] = utils::TextureCache::HashBytes(sources[i].data, sources[i].size);
+        }
+        result.key.contentHash = utils::TextureCache::HashBytes(hashes, sizeof(hashes));
+        result.cached = textures.cache->Find(result.key);
+        if (result.cached) {
+            return result;
+        }
+    }
+
+    for (Source& source : sources) {
+        source.image = utils::LoadImageFromMemory(source.data, static_cast<uint32>(source.size), 4);
+        if (!source.image.pixels) {
+            METAGFX_ERROR << "Failed to decode texture: " << source.texPath;
+            failed = true;
+        } else if (source.image.width != sources[0].image.width || source.image.height != sources[0].image.height) {
+            METAGFX_INFO << "Not packing maps of different sizes: " << texPath;
+            failed = true;
+        }
+    }
+
+    if (!failed) {
+        // Into the first source's pixels; every texel reads only its own sources
+        uint8* packed = sources[0].image.pixels;
+        uint64 texelCount = static_cast<uint64>(sources[0].image.width) * sources[0].image.height;
+        for (uint64 t = 0; t < texelCount; ++t) {
+            uint8 values[3];
+            for (uint32 i = 0; i < 3; ++i) {
+                const PackedChannel& channel = channels[i];
+                values[i] = channel.texPath.empty() ? channel.constant
+                                                    : sources[sourceIndex[i]].image.pixels[t * 4 + channel.channel];
+            }
+            packed[t * 4 + 0] = values[0];
+            packed[t * 4 + 1] = values[1];
+            packed[t * 4 + 2] = values[2];
+            packed[t * 4 + 3] = 255;
+        }
+        result.image = sources[0].image;
+        sources[0].image = {};
+    }
+
+    for (Source& source : sources) {
+        utils::FreeImage(source.image);
+    }
+    return result;
+}
+
 // Helper function to load texture (handles both embedded and external textures)
-static Ref<rhi::Texture> LoadTextureFromAssimp(rhi::GraphicsDevice* device,
-                                                const aiScene* scene,
-                                                const std::string& texPath,
-                                                const std::string& modelDir,
-                                                bool useSRGB = false) {
-    // Determine format: SRGB for albedo/diffuse, UNORM for data textures (normal, metallic, roughness, AO)
-    rhi::Format format = useSRGB ? rhi::Format::R8G8B8A8_SRGB : rhi::Format::R8G8B8A8_UNORM;
+static Ref<rhi::Texture> LoadMaterialTexture(rhi::GraphicsDevice* device,
+                                             const std::string& texPath,
+                                             const TextureLookup& textures,
+                                             TextureSlot slot) {
+    // Decoded images get the slot's format; KTX2 and cooked files keep their own
+    rhi::Format format = GetSlotFormat(slot);
+
+    auto preloadedIt = textures.preloaded.find(MakePreloadKey(texPath, slot));
+    if (preloadedIt != textures.preloaded.end()) {
+        return preloadedIt->second;
+    }
+
+    if (IsPackedORMPath(texPath)) {
+        DecodedTexture decoded = DecodePackedORM(texPath, textures);
+        return CreateDecodedTexture(device, decoded, textures);
+    }
+
+    // Prefer the cooked texture over decoding the source PNG/JPG
+    std::string cookedPath = textures.cooked.Find(texPath, slot == TextureSlot::Color);
+    if (!cookedPath.empty()) {
+        if (auto texture = LoadCookedTexture(device, textures, texPath, cookedPath, format)) {
+            return texture;
+        }
+    }
 
     // Check if this is an embedded texture (path starts with '*')
     if (texPath[0] == '*') {
         // Embedded texture: extract index
         int textureIndex = std::atoi(texPath.c_str() + 1);
 
-        if (textureIndex >= 0 && static_cast<unsigned int>(textureIndex) < scene->mNumTextures) {
-            const aiTexture* embeddedTex = scene->mTextures[textureIndex];
+        if (textures.embedded && textureIndex >= 0 && static_cast<size_t>(textureIndex) < textures.embedded->size()) {
+            const EmbeddedTexture& embeddedTex = (*textures.embedded)[textureIndex];
+            const uint8* data = embeddedTex.data;
+            std::string source = textures.modelPath + texPath;
 
-            // Check if texture is compressed (mHeight == 0) or uncompressed
-            if (embeddedTex->mHeight == 0) {
-                // Compressed texture (PNG, JPG, etc.)
-                utils::ImageData imageData = utils::LoadImageFromMemory(
-                    reinterpret_cast<const uint8_t*>(embeddedTex->pcData),
-                    embeddedTex->mWidth  // mWidth stores the data size for compressed textures
-                );
+            // Check if texture is compressed (no extent) or uncompressed
+            if (embeddedTex.width == 0) {
+                uint64 size = embeddedTex.size;
 
-                return utils::CreateTextureFromImage(device, imageData, format);
+                return AcquireTexture(textures, source, data, size, format, [&]() {
+                    // KHR_texture_basisu images arrive as embedded KTX2 files
+                    if (utils::IsKTX2Data(data, size)) {
+                        return utils::LoadKTX2TextureFromMemory(device, data, size);
+                    }
+                    // Compressed texture (PNG, JPG, etc.)
+                    return CreateTextureFromEncodedImage(device, data, size, format);
+                });
             } else {
                 // Uncompressed texture (raw RGBA data)
-                utils::ImageData imageData{
-                    reinterpret_cast<uint8_t*>(embeddedTex->pcData),
-                    embeddedTex->mWidth,
-                    embeddedTex->mHeight,
-                    4  // RGBA
-                };
-
-                return utils::CreateTextureFromImage(device, imageData, format);
+                uint64 size = embeddedTex.size;
+
+                return AcquireTexture(textures, source, data, size, format, [&]() {
+                    utils::ImageData imageData{
+                        const_cast<uint8_t*>(data),
+                        embeddedTex.width,
+                        embeddedTex.height,
+                        4  // RGBA
+                    };
+                    // Compact slots take a copy, the model's texels stay as they are
+                    std::vector<uint8> compact;
+                    uint32 channels = static_cast<uint32>(rhi::GetFormatImageSize(format, 1, 1));
+                    if (channels < 4) {
+                        compact.assign(data, data + static_cast<size_t>(embeddedTex.width) * embeddedTex.height * 4);
+                        imageData.pixels = compact.data();
+                        utils::KeepImageChannels(imageData, channels);
+                    }
+                    return utils::CreateTextureFromImage(device, imageData, format);
+                });
             }
         } else {
             METAGFX_WARN << "Invalid embedded texture index: " << textureIndex;
             return nullptr;
         }
     } else {
-        // External texture file
-        std::filesystem::path fullPath = std::filesystem::path(modelDir) / texPath;
+        // External texture file, read once for both the content hash and decoding
+        std::filesystem::path fullPath = std::filesystem::path(textures.modelDir) / texPath;
 
-        // For external files, we need to create texture with correct format
-        utils::ImageData imageData = utils::LoadImage(fullPath.string(), 4);
-        if (!imageData.pixels) {
+        std::vector<uint8> fileData;
+        if (!ReadFileBytes(fullPath, fileData)) {
             METAGFX_ERROR << "Failed to load texture from: " << fullPath;
             return nullptr;
         }
 
-        auto texture = utils::CreateTextureFromImage(device, imageData, format);
-        utils::FreeImage(imageData);
+        std::error_code ec;
+        std::string source = std::filesystem::absolute(fullPath, ec).lexically_normal().string();
+
+        if (textures.streamingExtent > 0 && fullPath.extension() == ".ktx2") {
+            return LoadStreamableTexture(device, textures, fullPath.string(), source,
+                                         fileData.data(), fileData.size(), format);
+        }
+
+        return AcquireTexture(textures, source, fileData.data(), fileData.size(), format, [&]() {
+            if (fullPath.extension() == ".ktx2") {
+                return utils::LoadKTX2TextureFromMemory(device, fileData.data(), fileData.size(),
+                                                        fullPath.string().c_str());
+            }
+
+            auto texture = CreateTextureFromEncodedImage(device, fileData.data(), fileData.size(), format);
+            if (!texture) {
+                METAGFX_ERROR << "Failed to load texture from: " << fullPath;
+            }
+            return texture;
+        });
+    }
+}
+
+// UNKNOWN-type glTF textures treated as combined metallic-roughness maps
+static bool IsMetallicRoughnessPath(const std::string& pathStr) {
+    return pathStr.find("metallicRoughness") != std::string::npos ||
+           pathStr.find("MetallicRoughness") != std::string::npos ||
+           pathStr.find("metallic_roughness") != std::string::npos ||
+           pathStr[0] == '*';  // Embedded textures in glTF are often metallic-roughness
+}
+
+// One texture reference ProcessMaterial will resolve
+struct TextureRequest {
+    std::string texPath;
+    TextureSlot slot = TextureSlot::Color;
+    const uint8* embeddedData = nullptr;  // Encoded bytes of an embedded texture
+    uint64 embeddedSize = 0;
+};
+
+// Every PNG/JPG-style texture the materials reference, once per color space. Mirrors the
+// slot logic of ProcessMaterial; anything missed here is simply loaded serially there.
+// Cooked, KTX2 and raw embedded textures need no stb_image decode and are skipped.
+static std::vector<TextureRequest> CollectTextureRequests(const ModelData& model, const TextureLookup& textures) {
+    std::vector<TextureRequest> requests;
+    std::unordered_set<std::string> seen;
+
+    auto add = [&](const std::string& texPath, TextureSlot slot) {
+        if (texPath.empty() || !seen.insert(MakePreloadKey(texPath, slot)).second) {
+            return;
+        }
+        if (!textures.cooked.Find(texPath, slot == TextureSlot::Color).empty()) {
+            return;
+        }
+
+        TextureRequest request{ texPath, slot };
+        if (texPath[0] == '*') {
+            int textureIndex = std::atoi(texPath.c_str() + 1);
+            if (textureIndex < 0 || static_cast<size_t>(textureIndex) >= model.embeddedTextures.size()) {
+                return;
+            }
+            const EmbeddedTexture& embeddedTex = model.embeddedTextures[textureIndex];
+            request.embeddedData = embeddedTex.data;
+            request.embeddedSize = embeddedTex.size;
+            if (embeddedTex.width != 0 || !embeddedTex.data ||
+                utils::IsKTX2Data(request.embeddedData, request.embeddedSize)) {
+                return;
+            }
+        } else if (std::filesystem::path(texPath).extension() == ".ktx2") {
+            return;
+        }
+        requests.push_back(std::move(request));
+    };
+
+    for (const MaterialDesc& material : model.materials) {
+        add(material.albedoMap, TextureSlot::Color);
+        add(material.normalMap, TextureSlot::Normal);
+        std::string ormPath = MakePackedORMPath(material, textures);
+        if (!ormPath.empty()) {
+            add(ormPath, TextureSlot::Packed);
+        } else {
+            add(material.metallicRoughnessMap, TextureSlot::Packed);
+            if (material.metallicRoughnessMap.empty()) {
+                add(material.roughnessMap, TextureSlot::Scalar);
+            }
+            add(material.aoMap, GetAOSlot(material));
+        }
+        add(material.emissiveMap, TextureSlot::Color);
+        add(material.packedMetallicRoughnessMap, TextureSlot::Packed);
+    }
+
+    return requests;
+}
+
+// Read (external files), hash and decode one request. Runs on a worker thread, so it
+// never touches the device; a texture found in the cache skips the decode.
+static DecodedTexture DecodeTextureRequest(const TextureRequest& request, const TextureLookup& textures) {
+    if (IsPackedORMPath(request.texPath)) {
+        return DecodePackedORM(request.texPath, textures);
+    }
+
+    DecodedTexture result;
+    result.key.format = GetSlotFormat(request.slot);
+
+    std::vector<uint8> fileData;
+    const uint8* data = request.embeddedData;
+    uint64 size = request.embeddedSize;
+
+    if (request.texPath[0] == '*') {
+        result.key.source = textures.modelPath + request.texPath;
+    } else {
+        std::filesystem::path fullPath = std::filesystem::path(textures.modelDir) / request.texPath;
+        if (!ReadFileBytes(fullPath, fileData)) {
+            METAGFX_ERROR << "Failed to load texture from: " << fullPath;
+            return result;
+        }
+        data = fileData.data();
+        size = fileData.size();
+
+        std::error_code ec;
+        result.key.source = std::filesystem::absolute(fullPath, ec).lexically_normal().string();
+    }
+
+    if (textures.cache) {
+        result.key.contentHash = utils::TextureCache::HashBytes(data, size);
+        result.cached = textures.cache->Find(result.key);
+        if (result.cached) {
+            return result;
+        }
+    }
+
+    result.image = utils::LoadImageFromMemory(data, static_cast<uint32>(size), 4);
+    if (!result.image.pixels) {
+        METAGFX_ERROR << "Failed to decode texture: " << request.texPath;
+        return result;
+    }
+    utils::KeepImageChannels(result.image, static_cast<uint32>(rhi::GetFormatImageSize(result.key.format, 1, 1)));
+    return result;
+}
+
+// Create and upload (or take from the cache) one decoded texture and record it in
+// textures.preloaded. Runs on the thread that owns the device.
+static void UploadDecodedTexture(rhi::GraphicsDevice* device, const TextureRequest& request,
+                                 DecodedTexture& decoded, TextureLookup& textures) {
+    textures.preloaded[MakePreloadKey(request.texPath, request.slot)] = CreateDecodedTexture(device, decoded, textures);
+}
+
+// Decode requests as JobSystem jobs, one per request. onDecoded runs on the calling
+// thread for each result as soon as it is ready (in completion order), so the caller
+// can upload while the remaining decodes continue. Once cancelled is set, the remaining
+// requests are reported without being decoded.
+static void DecodeTexturesParallel(const std::vector<TextureRequest>& requests,
+                                   const TextureLookup& textures,
+                                   const std::atomic<bool>* cancelled,
+                                   const std::function<void(DecodedTexture&)>& onDecoded) {
+    if (requests.empty()) {
+        return;
+    }
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::mutex finishedMutex;
+    std::condition_variable finishedCondition;
+    std::deque<DecodedTexture> finished;
+
+    JobCounter decodes;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        JobSystem::Run([&, i]() {
+            DecodedTexture decoded;
+            if (!cancelled || !cancelled->load()) {
+                METAGFX_PROFILE_SCOPE("Decode texture");
+                decoded = DecodeTextureRequest(requests[i], textures);
+            }
+            decoded.requestIndex = i;
+            {
+                std::lock_guard<std::mutex> lock(finishedMutex);
+                finished.push_back(std::move(decoded));
+            }
+            finishedCondition.notify_one();
+        }, &decodes);
+    }
+
+    for (size_t received = 0; received < requests.size(); ++received) {
+        DecodedTexture decoded;
+        {
+            std::unique_lock<std::mutex> lock(finishedMutex);
+            finishedCondition.wait(lock, [&]() { return !finished.empty(); });
+            decoded = std::move(finished.front());
+            finished.pop_front();
+        }
+        onDecoded(decoded);
+    }
+
+    JobSystem::Wait(decodes);
+
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+    METAGFX_INFO << "Decoded " << requests.size() << " textures on " << JobSystem::GetWorkerCount()
+                 << " worker threads in " << elapsedMs << " ms";
+}
+
+// Decode every stb_image texture of the scene in parallel and upload each one as soon
+// as its decode finishes, so uploads (batched by the backend's async uploader) overlap
+// with the remaining decodes. Results land in textures.preloaded for ProcessMaterial.
+// timings, when given, receives the time waited for decodes and the time spent uploading.
+static void PreloadTextures(rhi::GraphicsDevice* device, const ModelData& model, TextureLookup& textures,
+                            ModelLoadTimings* timings = nullptr) {
+    auto startTime = std::chrono::steady_clock::now();
+    double uploadMs = 0.0;
+    uint32 decodedCount = 0;
+
+    std::vector<TextureRequest> requests = CollectTextureRequests(model, textures);
+    DecodeTexturesParallel(requests, textures, nullptr, [&](DecodedTexture& decoded) {
+        auto uploadStart = std::chrono::steady_clock::now();
+        decodedCount += decoded.image.pixels ? 1 : 0;
+        UploadDecodedTexture(device, requests[decoded.requestIndex], decoded, textures);
+        uploadMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - uploadStart).count();
+    });
+
+    if (timings) {
+        double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        timings->decodeMs = totalMs - uploadMs;
+        timings->uploadMs += uploadMs;
+        timings->texturesDecoded = decodedCount;
+    }
+}
+
+// Helper function to extract material parameters and texture references from Assimp
+static MaterialDesc ExtractMaterialDesc(const aiMaterial* aiMat) {
+    MaterialDesc desc;
+
+    // Extract diffuse color → albedo
+    aiColor3D diffuse(0.8f, 0.8f, 0.8f);
+    aiMat->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
+    desc.albedo = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+
+    // Extract shininess → roughness (inverse relationship)
+    float shininess = 32.0f;
+    aiMat->Get(AI_MATKEY_SHININESS, shininess);
+
+    // Convert shininess to roughness (inverse mapping)
+    // High shininess (256) = low roughness (0), Low shininess (0) = high roughness (1)
+    desc.roughness = 1.0f - glm::clamp(shininess / 256.0f, 0.0f, 1.0f);
+
+    // Metallic defaults to 0.0 (no metallic data in basic formats like OBJ)
+    desc.metallic = 0.0f;
+
+    // Extract emissive factor (glTF/PBR)
+    aiColor3D emissiveColor(0.0f, 0.0f, 0.0f);
+    if (aiMat->Get(AI_MATKEY_COLOR_EMISSIVE, emissiveColor) == AI_SUCCESS) {
+        desc.emissiveFactor = glm::vec3(emissiveColor.r, emissiveColor.g, emissiveColor.b);
+        desc.hasEmissiveFactor = true;
+    }
+
+    // Alpha: glTF's mode and cutoff where the importer keeps them, otherwise the opacity
+    // of formats like OBJ, blended when below one
+    float opacity = 1.0f;
+    if (aiMat->Get(AI_MATKEY_OPACITY, opacity) == AI_SUCCESS) {
+        desc.alpha = glm::clamp(opacity, 0.0f, 1.0f);
+    }
+    aiString alphaMode;
+    if (aiMat->Get(AI_MATKEY_GLTF_ALPHAMODE, alphaMode) == AI_SUCCESS) {
+        if (std::strcmp(alphaMode.C_Str(), "MASK") == 0) {
+            desc.alphaMode = AlphaMode::Mask;
+            aiMat->Get(AI_MATKEY_GLTF_ALPHACUTOFF, desc.alphaCutoff);
+        } else if (std::strcmp(alphaMode.C_Str(), "BLEND") == 0) {
+            desc.alphaMode = AlphaMode::Blend;
+        }
+    } else if (desc.alpha < 1.0f) {
+        desc.alphaMode = AlphaMode::Blend;
+    }
+
+    auto getTexture = [&](aiTextureType type) -> std::string {
+        aiString texPath;
+        if (aiMat->GetTextureCount(type) > 0 && aiMat->GetTexture(type, 0, &texPath) == AI_SUCCESS) {
+            return texPath.C_Str();
+        }
+        return {};
+    };
+
+    desc.albedoMap = getTexture(aiTextureType_DIFFUSE);
+    desc.normalMap = getTexture(aiTextureType_NORMALS);
+    // For glTF models, Assimp provides the combined metallic-roughness texture via aiTextureType_METALNESS
+    desc.metallicRoughnessMap = getTexture(aiTextureType_METALNESS);
+    desc.roughnessMap = getTexture(aiTextureType_DIFFUSE_ROUGHNESS);
+    desc.aoMap = getTexture(aiTextureType_AMBIENT_OCCLUSION);
+    desc.emissiveMap = getTexture(aiTextureType_EMISSIVE);
+
+    // Check if an UNKNOWN-type texture might be a combined metallic-roughness texture
+    std::string unknown = getTexture(aiTextureType_UNKNOWN);
+    if (!unknown.empty() && IsMetallicRoughnessPath(unknown)) {
+        desc.packedMetallicRoughnessMap = unknown;
+    }
+
+    return desc;
+}
 
-        return texture;
+// Helper function to create a material and load its textures
+static std::unique_ptr<Material> ProcessMaterial(rhi::GraphicsDevice* device,
+                                                  const MaterialDesc& desc,
+                                                  const TextureLookup& textures) {
+    // Create material with scalar properties
+    auto material = std::make_unique<Material>(desc.albedo, desc.roughness, desc.metallic);
+
+    METAGFX_INFO << "Material properties: albedo=(" << desc.albedo.r << ", " << desc.albedo.g << ", " << desc.albedo.b
+                 << "), roughness=" << desc.roughness << ", metallic=" << desc.metallic;
+
+    // Load one texture slot; failures leave the slot on its default
+    auto loadTexture = [&](const std::string& texPath, TextureSlot slot, const char* what) -> Ref<rhi::Texture> {
+        if (texPath.empty()) {
+            return nullptr;
+        }
+        try {
+            auto texture = LoadMaterialTexture(device, texPath, textures, slot);
+            if (texture) {
+                METAGFX_INFO << "Loaded " << what << ": " << texPath;
+            }
+            return texture;
+        } catch (const std::exception& e) {
+            METAGFX_WARN << "Failed to load " << what << ": " << texPath << " - " << e.what();
+            return nullptr;
+        }
+    };
+
+    // Extract albedo/diffuse texture
+    if (auto texture = loadTexture(desc.albedoMap, TextureSlot::Color, "albedo texture")) {
+        material->SetAlbedoMap(texture);
+    }
+
+    // Extract normal map
+    if (auto texture = loadTexture(desc.normalMap, TextureSlot::Normal, "normal map")) {
+        material->SetNormalMap(texture);
+    }
+
+    // AO packed with roughness and metallic where the maps allow; sampled as the
+    // metallic-roughness map, so the separate roughness and AO slots stay free
+    bool hasMetallicRoughness = false;
+    bool packedAO = false;
+    std::string ormPath = MakePackedORMPath(desc, textures);
+    if (auto texture = loadTexture(ormPath, TextureSlot::Packed, "packed AO-roughness-metallic map")) {
+        material->SetMetallicRoughnessMap(texture);
+        hasMetallicRoughness = true;
+        packedAO = true;
+    }
+
+    // Extract metallic-roughness map (glTF workflow)
+    // glTF format: G channel = roughness, B channel = metallic
+    if (!hasMetallicRoughness) {
+        if (auto texture = loadTexture(desc.metallicRoughnessMap, TextureSlot::Packed, "metallic-roughness map (glTF)")) {
+            // Treat as combined metallic-roughness texture for glTF
+            material->SetMetallicRoughnessMap(texture);
+            hasMetallicRoughness = true;
+        }
+    }
+
+    // Extract separate roughness map (non-glTF workflows only if we don't have combined texture)
+    if (!hasMetallicRoughness) {
+        if (auto texture = loadTexture(desc.roughnessMap, TextureSlot::Scalar, "roughness map")) {
+            material->SetRoughnessMap(texture);
+        }
+    }
+
+    // Extract ambient occlusion map
+    if (!packedAO) {
+        if (auto texture = loadTexture(desc.aoMap, GetAOSlot(desc), "AO map")) {
+            material->SetAOMap(texture);
+        }
+    }
+
+    // Extract emissive texture and factor (glTF/PBR)
+    if (desc.hasEmissiveFactor) {
+        material->SetEmissiveFactor(desc.emissiveFactor);
+        METAGFX_INFO << "Emissive factor: (" << desc.emissiveFactor.r << ", " << desc.emissiveFactor.g
+                     << ", " << desc.emissiveFactor.b << ")";
+    }
+
+    if (auto texture = loadTexture(desc.emissiveMap, TextureSlot::Color, "emissive texture")) {
+        material->SetEmissiveMap(texture);
+    }
+
+    material->SetAlpha(desc.alpha);
+    material->SetAlphaMode(desc.alphaMode);
+    material->SetAlphaCutoff(desc.alphaCutoff);
+
+    // Extract combined metallic-roughness map (glTF standard)
+    // In glTF: R channel is unused/occlusion, G is roughness, B is metallic
+    if (auto texture = loadTexture(desc.packedMetallicRoughnessMap, TextureSlot::Packed, "combined metallic-roughness map")) {
+        material->SetMetallicRoughnessMap(texture);
+    }
+
+    return material;
+}
+
+// Helper function to extract the vertices and indices of an Assimp mesh (no device access)
+static MeshData ExtractMeshData(const aiMesh* aiMesh) {
+    MeshData data;
+    data.materialIndex = aiMesh->mMaterialIndex;
+    std::vector<Vertex>& vertices = data.vertexStorage;
+    std::vector<uint32_t>& indices = data.indexStorage;
+
+    // Process vertices
+    vertices.reserve(aiMesh->mNumVertices);
+
+    // DEBUG: Log normal availability
+    if (!aiMesh->HasNormals()) {
+        METAGFX_WARN << "Mesh has NO normals! Using default up vector.";
+    } else {
+        METAGFX_INFO << "Mesh has normals: " << aiMesh->mNumVertices << " vertices";
+        // Log first 3 normals to verify they vary
+        if (aiMesh->mNumVertices >= 3) {
+            METAGFX_INFO << "  Normal[0]: (" << aiMesh->mNormals[0].x << ", "
+                         << aiMesh->mNormals[0].y << ", " << aiMesh->mNormals[0].z << ")";
+            METAGFX_INFO << "  Normal[1]: (" << aiMesh->mNormals[1].x << ", "
+                         << aiMesh->mNormals[1].y << ", " << aiMesh->mNormals[1].z << ")";
+            METAGFX_INFO << "  Normal[2]: (" << aiMesh->mNormals[2].x << ", "
+                         << aiMesh->mNormals[2].y << ", " << aiMesh->mNormals[2].z << ")";
+        }
+    }
+
+    for (uint32_t i = 0; i < aiMesh->mNumVertices; ++i) {
+        Vertex vertex;
+
+        // Position
+        vertex.position = glm::vec3(
+            aiMesh->mVertices[i].x,
+            aiMesh->mVertices[i].y,
+            aiMesh->mVertices[i].z
+        );
+
+        // Normal
+        if (aiMesh->HasNormals()) {
+            vertex.normal = glm::vec3(
+                aiMesh->mNormals[i].x,
+                aiMesh->mNormals[i].y,
+                aiMesh->mNormals[i].z
+            );
+        } else {
+            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+
+        // Texture coordinates (use first UV channel if available)
+        if (aiMesh->HasTextureCoords(0)) {
+            vertex.texCoord = glm::vec2(
+                aiMesh->mTextureCoords[0][i].x,
+                aiMesh->mTextureCoords[0][i].y
+            );
+        } else {
+            vertex.texCoord = glm::vec2(0.0f, 0.0f);
+        }
+
+        // Tangent (aiProcess_CalcTangentSpace); the handedness is where the bitangent
+        // falls relative to cross(normal, tangent)
+        if (aiMesh->HasTangentsAndBitangents()) {
+            glm::vec3 tangent(aiMesh->mTangents[i].x, aiMesh->mTangents[i].y, aiMesh->mTangents[i].z);
+            glm::vec3 bitangent(aiMesh->mBitangents[i].x, aiMesh->mBitangents[i].y, aiMesh->mBitangents[i].z);
+            float handedness = glm::dot(glm::cross(vertex.normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+            vertex.tangent = glm::vec4(tangent, handedness);
+        }
+
+        vertices.push_back(vertex);
+    }
+
+    // Process indices
+    indices.reserve(static_cast<size_t>(aiMesh->mNumFaces) * 3);
+    for (uint32_t i = 0; i < aiMesh->mNumFaces; ++i) {
+        const aiFace& face = aiMesh->mFaces[i];
+        for (uint32_t j = 0; j < face.mNumIndices; ++j) {
+            indices.push_back(face.mIndices[j]);
+        }
+    }
+
+    // Assimp computes no tangents without UVs or for degenerate ones (it leaves NaN there)
+    bool validTangents = aiMesh->HasTangentsAndBitangents();
+    for (uint32_t i = 0; validTangents && i < vertices.size(); ++i) {
+        const glm::vec4& tangent = vertices[i].tangent;
+        validTangents = !std::isnan(tangent.x) && !std::isnan(tangent.y) && !std::isnan(tangent.z);
+    }
+    if (!validTangents) {
+        ComputeTangents(vertices.data(), static_cast<uint32>(vertices.size()),
+                        indices.data(), static_cast<uint32>(indices.size()));
+    }
+
+    data.vertices = vertices.data();
+    data.vertexCount = static_cast<uint32>(vertices.size());
+    data.indices = indices.data();
+    data.indexCount = static_cast<uint32>(indices.size());
+
+    // Bounds (stored in the mesh cache)
+    data.boundsMin = glm::vec3(std::numeric_limits<float>::max());
+    data.boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    if (!vertices.empty()) {
+        simd::ComputeBounds(&vertices[0].position, vertices.size(), sizeof(Vertex), data.boundsMin, data.boundsMax);
+    }
+
+    return data;
+}
+
+// Assimp matrices are row-major; glm is column-major
+static glm::mat4 ToGlm(const aiMatrix4x4& m) {
+    glm::mat4 result;
+    for (int row = 0; row < 4; ++row) {
+        for (int column = 0; column < 4; ++column) {
+            result[column][row] = m[row][column];
+        }
+    }
+    return result;
+}
+
+// Node indices by name, numbered in the order CollectMeshData records the nodes, for
+// resolving bones and animation channels; a name used twice resolves to its first node
+using NodeIndexMap = std::unordered_map<std::string, uint32>;
+
+static void CollectNodeIndices(const aiNode* node, NodeIndexMap& indices, uint32& nextIndex) {
+    indices.emplace(node->mName.C_Str(), nextIndex++);
+    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
+        CollectNodeIndices(node->mChildren[i], indices, nextIndex);
+    }
+}
+
+// Helper function to extract the bones and morph targets of an Assimp mesh into its data,
+// adding its skin to the model. Vertices keep their four largest weights, renormalized.
+static void ExtractDeformation(const aiMesh* aiMesh, const NodeIndexMap& nodeIndices, MeshData& data,
+                               ModelData& model) {
+    if (aiMesh->HasBones()) {
+        Skin skin;
+        std::vector<glm::vec4> weights(data.vertexCount, glm::vec4(0.0f));
+        std::vector<glm::uvec4> joints(data.vertexCount, glm::uvec4(0));
+        for (uint32_t b = 0; b < aiMesh->mNumBones; ++b) {
+            const aiBone* bone = aiMesh->mBones[b];
+            auto node = nodeIndices.find(bone->mName.C_Str());
+            if (node == nodeIndices.end()) {
+                METAGFX_WARN << "Bone " << bone->mName.C_Str() << " has no node, its weights are dropped";
+                continue;
+            }
+            uint32 joint = static_cast<uint32>(skin.joints.size());
+            skin.joints.push_back(node->second);
+            skin.inverseBindMatrices.push_back(ToGlm(bone->mOffsetMatrix));
+
+            for (uint32_t w = 0; w < bone->mNumWeights; ++w) {
+                const aiVertexWeight& weight = bone->mWeights[w];
+                if (weight.mVertexId >= data.vertexCount) {
+                    continue;
+                }
+                glm::vec4& vertexWeights = weights[weight.mVertexId];
+                int smallest = 0;
+                for (int i = 1; i < 4; ++i) {
+                    smallest = vertexWeights[i] < vertexWeights[smallest] ? i : smallest;
+                }
+                if (weight.mWeight > vertexWeights[smallest]) {
+                    vertexWeights[smallest] = weight.mWeight;
+                    joints[weight.mVertexId][smallest] = joint;
+                }
+            }
+        }
+
+        if (!skin.joints.empty() && skin.joints.size() <= UINT16_MAX) {
+            // A vertex without weights keeps its bind pose (skinning.comp)
+            data.skinStorage.resize(data.vertexCount);
+            for (uint32 v = 0; v < data.vertexCount; ++v) {
+                float total = weights[v].x + weights[v].y + weights[v].z + weights[v].w;
+                SkinVertex& skinVertex = data.skinStorage[v];
+                for (int i = 0; i < 4; ++i) {
+                    skinVertex.joints[i] = static_cast<uint16>(joints[v][i]);
+                    skinVertex.weights[i] = total > 0.0f
+                        ? static_cast<uint16>(std::lround(weights[v][i] / total * 65535.0f)) : 0;
+                }
+            }
+            data.skin = static_cast<uint32>(model.skins.size());
+            model.skins.push_back(std::move(skin));
+        }
+    }
+
+    // Assimp stores each target's whole vertices; the deltas are their difference
+    bool morphTargets = aiMesh->mNumAnimMeshes > 0;
+    for (uint32_t t = 0; morphTargets && t < aiMesh->mNumAnimMeshes; ++t) {
+        morphTargets = aiMesh->mAnimMeshes[t]->mNumVertices == data.vertexCount;
+    }
+    if (!morphTargets) {
+        if (aiMesh->mNumAnimMeshes > 0) {
+            METAGFX_WARN << "Morph targets of mesh " << aiMesh->mName.C_Str() << " do not match its vertices";
+        }
+        return;
+    }
+    data.morphTargetCount = aiMesh->mNumAnimMeshes;
+    data.morphDeltaStorage.resize(static_cast<size_t>(data.morphTargetCount) * data.vertexCount);
+    for (uint32_t t = 0; t < aiMesh->mNumAnimMeshes; ++t) {
+        const aiAnimMesh* target = aiMesh->mAnimMeshes[t];
+        data.morphWeights.push_back(target->mWeight);
+        MorphTargetDelta* deltas = &data.morphDeltaStorage[static_cast<size_t>(t) * data.vertexCount];
+        for (uint32 v = 0; v < data.vertexCount; ++v) {
+            if (target->HasPositions()) {
+                const aiVector3D& position = target->mVertices[v];
+                deltas[v].position = glm::vec4(glm::vec3(position.x, position.y, position.z) - data.vertices[v].position, 0.0f);
+            }
+            if (target->HasNormals() && aiMesh->HasNormals()) {
+                const aiVector3D& normal = target->mNormals[v];
+                deltas[v].normal = glm::vec4(glm::vec3(normal.x, normal.y, normal.z) - data.vertices[v].normal, 0.0f);
+            }
+        }
+    }
+}
+
+// Helper function to convert the clips of an Assimp scene; channels of nodes the
+// hierarchy does not have are dropped
+static void ExtractAnimations(const aiScene* scene, const NodeIndexMap& nodeIndices, ModelData& model) {
+    for (uint32_t a = 0; a < scene->mNumAnimations; ++a) {
+        const aiAnimation* animation = scene->mAnimations[a];
+        double ticksPerSecond = animation->mTicksPerSecond > 0.0 ? animation->mTicksPerSecond : 25.0;
+        AnimationClip clip;
+        clip.name = animation->mName.length > 0 ? animation->mName.C_Str() : "Animation " + std::to_string(a);
+        clip.duration = static_cast<float>(animation->mDuration / ticksPerSecond);
+
+        auto addChannel = [&](uint32 node, AnimationPath path, uint32 keyCount, auto&& key) {
+            if (keyCount == 0) {
+                return;
+            }
+            AnimationChannel channel;
+            channel.node = node;
+            channel.path = path;
+            for (uint32 k = 0; k < keyCount; ++k) {
+                double time = 0.0;
+                glm::vec4 value = key(k, time);
+                channel.times.push_back(static_cast<float>(time / ticksPerSecond));
+                channel.values.push_back(value);
+            }
+            clip.duration = std::max(clip.duration, channel.times.back());
+            clip.channels.push_back(std::move(channel));
+        };
+
+        for (uint32_t c = 0; c < animation->mNumChannels; ++c) {
+            const aiNodeAnim* nodeAnim = animation->mChannels[c];
+            auto node = nodeIndices.find(nodeAnim->mNodeName.C_Str());
+            if (node == nodeIndices.end()) {
+                continue;
+            }
+            addChannel(node->second, AnimationPath::Translation, nodeAnim->mNumPositionKeys, [&](uint32 k, double& time) {
+                const aiVectorKey& key = nodeAnim->mPositionKeys[k];
+                time = key.mTime;
+                return glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, 0.0f);
+            });
+            addChannel(node->second, AnimationPath::Rotation, nodeAnim->mNumRotationKeys, [&](uint32 k, double& time) {
+                const aiQuatKey& key = nodeAnim->mRotationKeys[k];
+                time = key.mTime;
+                return glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, key.mValue.w);
+            });
+            addChannel(node->second, AnimationPath::Scale, nodeAnim->mNumScalingKeys, [&](uint32 k, double& time) {
+                const aiVectorKey& key = nodeAnim->mScalingKeys[k];
+                time = key.mTime;
+                return glm::vec4(key.mValue.x, key.mValue.y, key.mValue.z, 0.0f);
+            });
+        }
+
+        // Morph weights are named after the node of the meshes they drive
+        for (uint32_t c = 0; c < animation->mNumMorphMeshChannels; ++c) {
+            const aiMeshMorphAnim* morphAnim = animation->mMorphMeshChannels[c];
+            auto node = nodeIndices.find(morphAnim->mName.C_Str());
+            if (node == nodeIndices.end() || morphAnim->mNumKeys == 0) {
+                continue;
+            }
+            AnimationChannel channel;
+            channel.node = node->second;
+            channel.path = AnimationPath::Weights;
+            for (uint32_t k = 0; k < morphAnim->mNumKeys; ++k) {
+                const aiMeshMorphKey& key = morphAnim->mKeys[k];
+                for (uint32_t i = 0; i < key.mNumValuesAndWeights; ++i) {
+                    channel.weightCount = std::max(channel.weightCount, key.mValues[i] + 1);
+                }
+            }
+            channel.weights.assign(static_cast<size_t>(channel.weightCount) * morphAnim->mNumKeys, 0.0f);
+            for (uint32_t k = 0; k < morphAnim->mNumKeys; ++k) {
+                const aiMeshMorphKey& key = morphAnim->mKeys[k];
+                channel.times.push_back(static_cast<float>(key.mTime / ticksPerSecond));
+                for (uint32_t i = 0; i < key.mNumValuesAndWeights; ++i) {
+                    channel.weights[static_cast<size_t>(k) * channel.weightCount + key.mValues[i]] =
+                        static_cast<float>(key.mWeights[i]);
+                }
+            }
+            clip.duration = std::max(clip.duration, channel.times.back());
+            clip.channels.push_back(std::move(channel));
+        }
+
+        if (!clip.channels.empty()) {
+            model.animations.push_back(std::move(clip));
+        }
+    }
+}
+
+// Helper function to extract every mesh of an Assimp node recursively. Records the node
+// (depth-first, so parents precede children) and tags its meshes with it.
+static void CollectMeshData(const aiNode* node, const aiScene* scene, ModelData& model, uint32 parent,
+                            const NodeIndexMap& nodeIndices, const std::atomic<bool>* cancelled = nullptr) {
+    uint32 nodeIndex = static_cast<uint32>(model.nodes.size());
+    NodeData nodeData;
+    nodeData.localTransform = ToGlm(node->mTransformation);
+    nodeData.parent = parent;
+    model.nodes.push_back(nodeData);
+
+    // Process all meshes in this node
+    for (uint32_t i = 0; i < node->mNumMeshes; ++i) {
+        if (cancelled && cancelled->load()) {
+            return;
+        }
+        const aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
+        model.meshes.push_back(ExtractMeshData(aiMesh));
+        model.meshes.back().node = nodeIndex;
+        ExtractDeformation(aiMesh, nodeIndices, model.meshes.back(), model);
+    }
+
+    // Process children nodes recursively
+    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
+        CollectMeshData(node->mChildren[i], scene, model, nodeIndex, nodeIndices, cancelled);
+    }
+}
+
+// Compact positions of every mesh are quantized to one cube around the whole model
+static VertexQuantization ComputeQuantization(const ModelData& model) {
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(std::numeric_limits<float>::lowest());
+    for (const MeshData& data : model.meshes) {
+        if (data.vertexCount > 0) {
+            boundsMin = glm::min(boundsMin, data.boundsMin);
+            boundsMax = glm::max(boundsMax, data.boundsMax);
+        }
+    }
+    if (boundsMin.x > boundsMax.x) {
+        return VertexQuantization{};
+    }
+    return VertexQuantization::FromBounds(boundsMin, boundsMax);
+}
+
+static bool HasDeformedMeshes(const ModelData& model) {
+    for (const MeshData& data : model.meshes) {
+        if (data.IsDeformed()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Skinning writes posed vertices in the Float layout: they leave the quantization cube
+static void AdjustSettingsForModel(ModelImportSettings& settings, const ModelData& model) {
+    if (settings.vertexFormat != VertexFormat::Float && HasDeformedMeshes(model)) {
+        METAGFX_INFO << "Deformed meshes: using the Float vertex format";
+        settings.vertexFormat = VertexFormat::Float;
+    }
+}
+
+// What Skinning needs of a deformed mesh, taken before CreateMesh takes its storage
+static DeformedMesh TakeDeformation(MeshData& data) {
+    DeformedMesh deformation;
+    if (!data.IsDeformed()) {
+        return deformation;
+    }
+    deformation.bindPose.assign(data.vertices, data.vertices + data.vertexCount);
+    deformation.skin = data.skin;
+    deformation.skinVertices = std::move(data.skinStorage);
+    deformation.morphTargetCount = data.morphTargetCount;
+    deformation.morphDeltas = std::move(data.morphDeltaStorage);
+    deformation.morphWeights = std::move(data.morphWeights);
+    return deformation;
+}
+
+// One pool sized for every mesh of the model
+static Ref<GeometryPool> CreateGeometryPool(rhi::GraphicsDevice* device, const ModelData& model,
+                                            const ModelImportSettings& settings) {
+    uint64 vertexCount = 0;
+    uint64 indexCount = 0;
+    for (const MeshData& data : model.meshes) {
+        vertexCount += data.vertexCount;
+        indexCount += static_cast<uint64>(data.indexCount) + data.lodIndexCount;
+    }
+    if (vertexCount == 0 || indexCount == 0 || vertexCount > UINT32_MAX || indexCount > UINT32_MAX) {
+        return nullptr;
+    }
+
+    auto pool = CreateRef<GeometryPool>();
+    if (!pool->Initialize(device, settings.vertexFormat, static_cast<uint32>(vertexCount),
+                          static_cast<uint32>(indexCount), settings.positionStream, HasDeformedMeshes(model))) {
+        return nullptr;
+    }
+    METAGFX_INFO << "Geometry pool: " << vertexCount << " vertices, " << indexCount << " indices in "
+                 << model.meshes.size() << " meshes";
+    return pool;
+}
+
+// Create the GPU buffers of an extracted mesh (material attached separately). With a
+// pool the mesh becomes a range of its buffers; without one it gets its own. A CPU copy
+// the mesh keeps takes over the imported storage rather than copying it.
+static std::unique_ptr<Mesh> CreateMesh(rhi::GraphicsDevice* device, MeshData& data,
+                                        const ModelImportSettings& settings, const VertexQuantization& quantization,
+                                        GeometryPool* pool) {
+    auto mesh = std::make_unique<Mesh>();
+    bool positionStream = settings.positionStream && !pool;  // Built from the full CPU copy
+    mesh->SetCPUDataMode(positionStream ? MeshCPUData::Full : settings.cpuGeometry);
+    if (settings.cpuGeometry == MeshCPUData::Full && data.vertices == data.vertexStorage.data() &&
+        data.indices == data.indexStorage.data()) {
+        // The views stay valid: moving a vector keeps its buffer
+        mesh->SetCPUData(std::move(data.vertexStorage), std::move(data.indexStorage));
+    }
+    if (data.meshlets) {
+        mesh->SetMeshlets(data.meshlets, data.meshletCount);
+    }
+    if (data.lods) {
+        mesh->SetLods(data.lods, data.lodCount, data.lodIndices, data.lodIndexCount);
+    }
+    if (pool) {
+        if (!mesh->Initialize(*pool, data.vertices, data.vertexCount, data.indices, data.indexCount, quantization)) {
+            METAGFX_ERROR << "Failed to initialize mesh";
+            return nullptr;
+        }
+        return mesh;
+    }
+
+    if (!mesh->Initialize(device, data.vertices, data.vertexCount, data.indices, data.indexCount,
+                          false, settings.vertexFormat, quantization)) {
+        METAGFX_ERROR << "Failed to initialize mesh";
+        return nullptr;
+    }
+    if (positionStream) {
+        mesh->CreatePositionStream(device);
+        mesh->SetCPUDataMode(settings.cpuGeometry);
+    }
+    return mesh;
+}
+
+// Extract and attach the mesh's material
+static void AttachMaterial(rhi::GraphicsDevice* device, Mesh& mesh, uint32_t materialIndex,
+                           const ModelData& model, const TextureLookup& textures) {
+    if (materialIndex < model.materials.size()) {
+        mesh.SetMaterial(ProcessMaterial(device, model.materials[materialIndex], textures));
+    } else {
+        // Fallback to default material
+        mesh.SetMaterial(std::make_unique<Material>());
     }
 }
 
-// Helper function to extract material from Assimp
-static std::unique_ptr<Material> ProcessMaterial(rhi::GraphicsDevice* device,
-                                                  const aiScene* scene,
-                                                  const aiMaterial* aiMat,
-                                                  const std::string& modelDir) {
-    if (!aiMat) {
-        return std::make_unique<Material>();  // Return default material
+// Post-processing applied to every import (part of the mesh cache key)
+// aiProcess_Triangulate: Convert all primitives to triangles
+// aiProcess_FlipUVs: Flip texture coordinates on Y axis (OpenGL convention)
+// aiProcess_GenSmoothNormals: Generate smooth normals if not present (for proper shading)
+// aiProcess_CalcTangentSpace: Calculate tangents/bitangents (for normal mapping later)
+// aiProcess_JoinIdenticalVertices: Optimize by merging identical vertices
+// aiProcess_LimitBoneWeights: At most four bones per vertex (SkinVertex)
+constexpr uint32 MODEL_IMPORT_FLAGS =
+    aiProcess_Triangulate |
+    aiProcess_FlipUVs |
+    aiProcess_GenSmoothNormals |  // Use smooth normals instead of flat
+    aiProcess_CalcTangentSpace |
+    aiProcess_JoinIdenticalVertices |
+    aiProcess_LimitBoneWeights;
+
+// Assimp reads files in mounted asset archives through their mapping
+class ArchiveIOStream : public Assimp::IOStream {
+public:
+    explicit ArchiveIOStream(utils::MappedFile&& file) : m_File(std::move(file)) {}
+
+    size_t Read(void* buffer, size_t size, size_t count) override {
+        if (size == 0) {
+            return 0;
+        }
+        size_t available = static_cast<size_t>(m_File.GetSize()) - m_Position;
+        count = std::min(count, available / size);
+        memcpy(buffer, m_File.GetData() + m_Position, count * size);
+        m_Position += count * size;
+        return count;
     }
+    size_t Write(const void*, size_t, size_t) override { return 0; }
 
-    // Extract diffuse color → albedo
-    aiColor3D diffuse(0.8f, 0.8f, 0.8f);
-    aiMat->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse);
-
-    // Extract shininess → roughness (inverse relationship)
-    float shininess = 32.0f;
-    aiMat->Get(AI_MATKEY_SHININESS, shininess);
-
-    // Convert shininess to roughness (inverse mapping)
-    // High shininess (256) = low roughness (0), Low shininess (0) = high roughness (1)
-    float roughness = 1.0f - glm::clamp(shininess / 256.0f, 0.0f, 1.0f);
-
-    // Metallic defaults to 0.0 (no metallic data in basic formats like OBJ)
-    float metallic = 0.0f;
-
-    // Create material with scalar properties
-    auto material = std::make_unique<Material>(
-        glm::vec3(diffuse.r, diffuse.g, diffuse.b),
-        roughness,
-        metallic
-    );
-
-    METAGFX_INFO << "Material properties: albedo=(" << diffuse.r << ", " << diffuse.g << ", " << diffuse.b
-                 << "), roughness=" << roughness << ", metallic=" << metallic;
-
-    // Extract albedo/diffuse texture
-    if (aiMat->GetTextureCount(aiTextureType_DIFFUSE) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_DIFFUSE, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir, true);  // Use SRGB for albedo
-                if (texture) {
-                    material->SetAlbedoMap(texture);
-                    METAGFX_INFO << "Loaded albedo texture: " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load albedo texture: " << texPath.C_Str() << " - " << e.what();
-            }
+    aiReturn Seek(size_t offset, aiOrigin origin) override {
+        size_t base = origin == aiOrigin_CUR ? m_Position
+                    : origin == aiOrigin_END ? static_cast<size_t>(m_File.GetSize()) : 0;
+        if (base + offset > m_File.GetSize()) {
+            return aiReturn_FAILURE;
         }
+        m_Position = base + offset;
+        return aiReturn_SUCCESS;
+    }
+    size_t Tell() const override { return m_Position; }
+    size_t FileSize() const override { return static_cast<size_t>(m_File.GetSize()); }
+    void Flush() override {}
+
+private:
+    utils::MappedFile m_File;
+    size_t m_Position = 0;
+};
+
+class ArchiveIOSystem : public Assimp::DefaultIOSystem {
+public:
+    bool Exists(const char* file) const override {
+        return utils::AssetArchive::FindMounted(file) || DefaultIOSystem::Exists(file);
     }
 
-    // Extract normal map
-    if (aiMat->GetTextureCount(aiTextureType_NORMALS) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_NORMALS, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir);
-                if (texture) {
-                    material->SetNormalMap(texture);
-                    METAGFX_INFO << "Loaded normal map: " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load normal map: " << texPath.C_Str() << " - " << e.what();
-            }
+    Assimp::IOStream* Open(const char* file, const char* mode) override {
+        utils::MappedFile mapped;
+        if (mode[0] == 'r' && utils::AssetArchive::OpenMounted(file, mapped)) {
+            return new ArchiveIOStream(std::move(mapped));
         }
+        return DefaultIOSystem::Open(file, mode);
     }
+};
 
-    // Extract metallic-roughness map (glTF workflow)
-    // For glTF models, Assimp provides the combined metallic-roughness texture via aiTextureType_METALNESS
-    // glTF format: G channel = roughness, B channel = metallic
-    bool hasMetallicRoughness = false;
-    if (aiMat->GetTextureCount(aiTextureType_METALNESS) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_METALNESS, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir);
-                if (texture) {
-                    // Treat as combined metallic-roughness texture for glTF
-                    material->SetMetallicRoughnessMap(texture);
-                    hasMetallicRoughness = true;
-                    METAGFX_INFO << "Loaded metallic-roughness map (glTF): " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load metallic-roughness map: " << texPath.C_Str() << " - " << e.what();
-            }
-        }
+// Load the model file with Assimp
+static const aiScene* ImportScene(Assimp::Importer& importer, const std::string& filepath) {
+    if (utils::AssetArchive::HasMounts()) {
+        importer.SetIOHandler(new ArchiveIOSystem);  // Owned by the importer
     }
+    const aiScene* scene = importer.ReadFile(filepath, MODEL_IMPORT_FLAGS);
 
-    // Extract separate roughness map (non-glTF workflows only if we don't have combined texture)
-    if (!hasMetallicRoughness && aiMat->GetTextureCount(aiTextureType_DIFFUSE_ROUGHNESS) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_DIFFUSE_ROUGHNESS, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir);
-                if (texture) {
-                    material->SetRoughnessMap(texture);
-                    METAGFX_INFO << "Loaded roughness map: " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load roughness map: " << texPath.C_Str() << " - " << e.what();
-            }
-        }
+    // Check for errors
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        METAGFX_ERROR << "Assimp error: " << importer.GetErrorString();
+        return nullptr;
     }
+    return scene;
+}
 
-    // Extract ambient occlusion map
-    if (aiMat->GetTextureCount(aiTextureType_AMBIENT_OCCLUSION) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_AMBIENT_OCCLUSION, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir);
-                if (texture) {
-                    material->SetAOMap(texture);
-                    METAGFX_INFO << "Loaded AO map: " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load AO map: " << texPath.C_Str() << " - " << e.what();
-            }
-        }
+// Extract everything the GPU stage needs from an imported scene. Embedded textures
+// point into the scene, which must outlive the returned data.
+static void ExtractModelData(const aiScene* scene, ModelData& model, const std::atomic<bool>* cancelled) {
+    NodeIndexMap nodeIndices;
+    uint32 nodeCount = 0;
+    CollectNodeIndices(scene->mRootNode, nodeIndices, nodeCount);
+    CollectMeshData(scene->mRootNode, scene, model, NodeData::NO_PARENT, nodeIndices, cancelled);
+    ExtractAnimations(scene, nodeIndices, model);
+    if (!model.skins.empty() || !model.animations.empty()) {
+        METAGFX_INFO << "Animation: " << model.skins.size() << " skins, " << model.animations.size() << " clips";
     }
 
-    // Extract emissive texture and factor (glTF/PBR)
-    aiColor3D emissiveColor(0.0f, 0.0f, 0.0f);
-    if (aiMat->Get(AI_MATKEY_COLOR_EMISSIVE, emissiveColor) == AI_SUCCESS) {
-        material->SetEmissiveFactor(glm::vec3(emissiveColor.r, emissiveColor.g, emissiveColor.b));
-        METAGFX_INFO << "Emissive factor: (" << emissiveColor.r << ", " << emissiveColor.g << ", " << emissiveColor.b << ")";
+    model.materials.reserve(scene->mNumMaterials);
+    for (uint32_t i = 0; i < scene->mNumMaterials; ++i) {
+        model.materials.push_back(ExtractMaterialDesc(scene->mMaterials[i]));
     }
 
-    if (aiMat->GetTextureCount(aiTextureType_EMISSIVE) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_EMISSIVE, 0, &texPath) == AI_SUCCESS) {
-            try {
-                auto texture = LoadTextureFromAssimp(device, scene, texPath.C_Str(), modelDir, true);  // Use SRGB for emissive
-                if (texture) {
-                    material->SetEmissiveMap(texture);
-                    METAGFX_INFO << "Loaded emissive texture: " << texPath.C_Str();
-                }
-            } catch (const std::exception& e) {
-                METAGFX_WARN << "Failed to load emissive texture: " << texPath.C_Str() << " - " << e.what();
-            }
+    model.embeddedTextures.reserve(scene->mNumTextures);
+    for (uint32_t i = 0; i < scene->mNumTextures; ++i) {
+        const aiTexture* embeddedTex = scene->mTextures[i];
+        EmbeddedTexture texture;
+        texture.data = reinterpret_cast<const uint8*>(embeddedTex->pcData);
+        if (embeddedTex->mHeight == 0) {
+            texture.size = embeddedTex->mWidth;  // mWidth stores the data size for compressed textures
+        } else {
+            texture.size = static_cast<uint64>(embeddedTex->mWidth) * embeddedTex->mHeight * 4;
+            texture.width = embeddedTex->mWidth;
+            texture.height = embeddedTex->mHeight;
         }
+        model.embeddedTextures.push_back(texture);
     }
+}
 
-    // Extract combined metallic-roughness map (glTF standard)
-    // In glTF: R channel is unused/occlusion, G is roughness, B is metallic
-    if (aiMat->GetTextureCount(aiTextureType_UNKNOWN) > 0) {
-        aiString texPath;
-        if (aiMat->GetTexture(aiTextureType_UNKNOWN, 0, &texPath) == AI_SUCCESS) {
-            std::string pathStr = texPath.C_Str();
-            // Check if this might be a combined metallic-roughness texture
-            if (pathStr.find("metallicRoughness") != std::string::npos ||
-                pathStr.find("MetallicRoughness") != std::string::npos ||
-                pathStr.find("metallic_roughness") != std::string::npos ||
-                pathStr[0] == '*') {  // Embedded textures in glTF are often metallic-roughness
-
-                try {
-                    auto texture = LoadTextureFromAssimp(device, scene, pathStr, modelDir);
-                    if (texture) {
-                        material->SetMetallicRoughnessMap(texture);
-                        METAGFX_INFO << "Loaded combined metallic-roughness map: " << pathStr;
-                    }
-                } catch (const std::exception& e) {
-                    METAGFX_WARN << "Failed to load metallic-roughness map: " << pathStr << " - " << e.what();
-                }
-            }
+// Run the MeshOptimizer passes over every imported mesh
+static void OptimizeModelGeometry(ModelData& model, const std::atomic<bool>* cancelled) {
+    auto startTime = std::chrono::steady_clock::now();
+
+    uint64 triangleCount = 0;
+    double missesBefore = 0.0;
+    double missesAfter = 0.0;
+    for (MeshData& mesh : model.meshes) {
+        if (cancelled && cancelled->load()) {
+            return;
         }
+
+        size_t meshTriangles = mesh.indexCount / 3;
+        triangleCount += meshTriangles;
+        missesBefore += ComputeACMR(mesh.indices, mesh.indexCount, mesh.vertexCount) * meshTriangles;
+        OptimizeMeshData(mesh);
+        missesAfter += ComputeACMR(mesh.indices, mesh.indexCount, mesh.vertexCount) * meshTriangles;
     }
 
-    return material;
+    if (triangleCount > 0) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        METAGFX_INFO << "Optimized " << triangleCount << " triangles in " << elapsedMs << " ms (ACMR "
+                     << (missesBefore / triangleCount) << " -> " << (missesAfter / triangleCount) << ")";
+    }
 }
 
-// Helper function to process an Assimp mesh
-static std::unique_ptr<Mesh> ProcessMesh(rhi::GraphicsDevice* device, aiMesh* aiMesh, const aiScene* scene,
-                                         const std::string& modelDir) {
-    std::vector<Vertex> vertices;
-    std::vector<uint32_t> indices;
-
-    // Process vertices
-    vertices.reserve(aiMesh->mNumVertices);
+// Split every imported mesh into meshlets, after the optimization that orders its triangles
+static void BuildModelMeshlets(ModelData& model, const std::atomic<bool>* cancelled) {
+    auto startTime = std::chrono::steady_clock::now();
 
-    // DEBUG: Log normal availability
-    if (!aiMesh->HasNormals()) {
-        METAGFX_WARN << "Mesh has NO normals! Using default up vector.";
-    } else {
-        METAGFX_INFO << "Mesh has normals: " << aiMesh->mNumVertices << " vertices";
-        // Log first 3 normals to verify they vary
-        if (aiMesh->mNumVertices >= 3) {
-            METAGFX_INFO << "  Normal[0]: (" << aiMesh->mNormals[0].x << ", "
-                         << aiMesh->mNormals[0].y << ", " << aiMesh->mNormals[0].z << ")";
-            METAGFX_INFO << "  Normal[1]: (" << aiMesh->mNormals[1].x << ", "
-                         << aiMesh->mNormals[1].y << ", " << aiMesh->mNormals[1].z << ")";
-            METAGFX_INFO << "  Normal[2]: (" << aiMesh->mNormals[2].x << ", "
-                         << aiMesh->mNormals[2].y << ", " << aiMesh->mNormals[2].z << ")";
+    uint64 meshletCount = 0;
+    for (MeshData& mesh : model.meshes) {
+        if (cancelled && cancelled->load()) {
+            return;
         }
+        BuildMeshletData(mesh);
+        meshletCount += mesh.meshletCount;
     }
 
-    for (uint32_t i = 0; i < aiMesh->mNumVertices; ++i) {
-        Vertex vertex;
+    if (meshletCount > 0) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        METAGFX_INFO << "Built " << meshletCount << " meshlets in " << elapsedMs << " ms";
+    }
+}
 
-        // Position
-        vertex.position = glm::vec3(
-            aiMesh->mVertices[i].x,
-            aiMesh->mVertices[i].y,
-            aiMesh->mVertices[i].z
-        );
+// Simplify every imported mesh into its coarser levels, from the final index order
+static void BuildModelLods(ModelData& model, const std::atomic<bool>* cancelled) {
+    auto startTime = std::chrono::steady_clock::now();
 
-        // Normal
-        if (aiMesh->HasNormals()) {
-            vertex.normal = glm::vec3(
-                aiMesh->mNormals[i].x,
-                aiMesh->mNormals[i].y,
-                aiMesh->mNormals[i].z
-            );
-        } else {
-            vertex.normal = glm::vec3(0.0f, 1.0f, 0.0f);
+    uint64 levelCount = 0;
+    uint64 lodIndexCount = 0;
+    for (MeshData& mesh : model.meshes) {
+        if (cancelled && cancelled->load()) {
+            return;
         }
+        BuildLodData(mesh);
+        levelCount += mesh.lodCount;
+        lodIndexCount += mesh.lodIndexCount;
+    }
 
-        // Texture coordinates (use first UV channel if available)
-        if (aiMesh->HasTextureCoords(0)) {
-            vertex.texCoord = glm::vec2(
-                aiMesh->mTextureCoords[0][i].x,
-                aiMesh->mTextureCoords[0][i].y
-            );
-        } else {
-            vertex.texCoord = glm::vec2(0.0f, 0.0f);
-        }
+    if (levelCount > 0) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+        METAGFX_INFO << "Built " << levelCount << " LOD levels (" << lodIndexCount << " indices) for "
+                     << model.meshes.size() << " meshes in " << elapsedMs << " ms";
+    }
+}
 
-        vertices.push_back(vertex);
+// Mesh cache key of files read by GLTFLoader; never equal to MODEL_IMPORT_FLAGS
+constexpr uint32 GLTF_IMPORT_FLAGS = 0x474C0000u | GLTFLoader::VERSION;
+
+// Whatever backs an imported ModelData (mapped cache, glTF buffers or Assimp scene)
+struct ModelSource {
+    Assimp::Importer importer;
+    ModelCache meshCache;
+    GLTFLoader gltf;
+
+    void Release() {
+        meshCache.Close();
+        gltf.Close();
+        importer.FreeScene();
+    }
+};
+
+// Fill model from the mesh cache when it matches the file, otherwise import it (glTF
+// natively, everything else - and glTF the native loader rejects - with Assimp) and
+// write the cache for the next load. The source backs the returned data and must
+// outlive it. Runs without the device. timings, when given, receives the read, import
+// and process stages.
+static bool ImportModel(const std::string& filepath, const ModelImportSettings& settings, ModelSource& source,
+                        ModelData& model, const std::atomic<bool>* cancelled = nullptr,
+                        ModelLoadTimings* timings = nullptr) {
+    METAGFX_PROFILE_SCOPE("Import model");
+    METAGFX_ALLOCATION_SCOPE(Load);
+    auto startTime = std::chrono::steady_clock::now();
+    auto elapsedMs = [&]() {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime).count();
+    };
+    // Milliseconds since the previous stage ended
+    auto stageStart = startTime;
+    auto endStage = [&]() {
+        auto now = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - stageStart).count();
+        stageStart = now;
+        return ms;
+    };
+    ModelLoadTimings unusedTimings;
+    ModelLoadTimings& stages = timings ? *timings : unusedTimings;
+
+    uint64 sourceHash = 0;
+    bool haveSourceHash = ModelCache::HashSourceFile(filepath, sourceHash);
+    stages.readMs = endStage();
+    std::string cachePath = ModelCache::GetPathForModel(filepath);
+    bool isGLTF = GLTFLoader::IsGLTFFile(filepath);
+    uint32 processFlags = (settings.optimizeGeometry ? MODEL_PROCESS_OPTIMIZE_GEOMETRY : MODEL_PROCESS_NONE) |
+                          (settings.buildMeshlets ? MODEL_PROCESS_BUILD_MESHLETS : MODEL_PROCESS_NONE) |
+                          (settings.buildLods ? MODEL_PROCESS_BUILD_LODS : MODEL_PROCESS_NONE);
+
+    // A glTF cache may come from either importer (Assimp after a native failure)
+    if (haveSourceHash &&
+        ((isGLTF && source.meshCache.Open(cachePath, sourceHash, GLTF_IMPORT_FLAGS, processFlags, model)) ||
+         source.meshCache.Open(cachePath, sourceHash, MODEL_IMPORT_FLAGS, processFlags, model))) {
+        stages.importMs = endStage();
+        stages.fromMeshCache = true;
+        METAGFX_INFO << "Loaded mesh cache " << cachePath << " (" << model.meshes.size()
+                     << " meshes) in " << elapsedMs() << " ms";
+        return true;
     }
 
-    // Process indices
-    for (uint32_t i = 0; i < aiMesh->mNumFaces; ++i) {
-        aiFace face = aiMesh->mFaces[i];
-        for (uint32_t j = 0; j < face.mNumIndices; ++j) {
-            indices.push_back(face.mIndices[j]);
+    uint32 importFlags = MODEL_IMPORT_FLAGS;
+    if (isGLTF && source.gltf.Load(filepath, model, cancelled)) {
+        importFlags = GLTF_IMPORT_FLAGS;
+    } else {
+        if (isGLTF) {
+            METAGFX_WARN << "Native glTF import failed, falling back to Assimp";
+        }
+        const aiScene* scene = ImportScene(source.importer, filepath);
+        if (!scene) {
+            return false;
         }
+        ExtractModelData(scene, model, cancelled);
     }
+    stages.importMs = endStage();
+    METAGFX_INFO << "Imported " << filepath << (importFlags == GLTF_IMPORT_FLAGS ? " (native glTF)" : "")
+                 << " in " << elapsedMs() << " ms";
 
-    // Create and initialize mesh
-    auto mesh = std::make_unique<Mesh>();
-    if (!mesh->Initialize(device, vertices, indices)) {
-        METAGFX_ERROR << "Failed to initialize mesh";
-        return nullptr;
+    if (settings.optimizeGeometry) {
+        OptimizeModelGeometry(model, cancelled);
+    }
+    if (settings.buildMeshlets) {
+        BuildModelMeshlets(model, cancelled);
     }
+    if (settings.buildLods) {
+        BuildModelLods(model, cancelled);
+    }
+    stages.processMs = endStage();
 
-    // Extract and attach material
-    if (scene && aiMesh->mMaterialIndex >= 0 && aiMesh->mMaterialIndex < scene->mNumMaterials) {
-        aiMaterial* aiMat = scene->mMaterials[aiMesh->mMaterialIndex];
-        auto material = ProcessMaterial(device, scene, aiMat, modelDir);
-        mesh->SetMaterial(std::move(material));
-    } else {
-        // Fallback to default material
-        mesh->SetMaterial(std::make_unique<Material>());
+    if (model.IsAnimated()) {
+        METAGFX_INFO << "Animated model, not cached";  // ModelCache holds no skins or clips
+    } else if (haveSourceHash && !(cancelled && cancelled->load())) {
+        if (ModelCache::Write(cachePath, model, sourceHash, importFlags, processFlags)) {
+            METAGFX_INFO << "Wrote mesh cache: " << cachePath;
+        } else {
+            METAGFX_WARN << "Failed to write mesh cache: " << cachePath;
+        }
     }
+    return true;
+}
 
-    return mesh;
+struct ModelImporter::Source : ModelSource {};
+
+ModelImporter::ModelImporter() : m_Source(std::make_unique<Source>()) {}
+ModelImporter::~ModelImporter() = default;
+
+bool ModelImporter::Import(const std::string& filepath, ModelData& outData, const ModelImportSettings& settings) {
+    m_Source->Release();
+    outData = ModelData{};
+    return ImportModel(filepath, settings, *m_Source, outData);
 }
 
-// Helper function to process an Assimp node recursively
-static void ProcessNode(rhi::GraphicsDevice* device, aiNode* node, const aiScene* scene,
-                       std::vector<std::unique_ptr<Mesh>>& meshes, const std::string& modelDir) {
-    // Process all meshes in this node
-    for (uint32_t i = 0; i < node->mNumMeshes; ++i) {
-        aiMesh* aiMesh = scene->mMeshes[node->mMeshes[i]];
-        auto mesh = ProcessMesh(device, aiMesh, scene, modelDir);
-        if (mesh) {
-            meshes.push_back(std::move(mesh));
-        }
+// Resolve the model directory (texture paths are relative to it) and the cooked manifest
+static void InitTextureLookup(TextureLookup& textures, const std::string& filepath,
+                              utils::TextureCache* textureCache, const ModelData& model,
+                              const ModelImportSettings& settings,
+                              std::vector<StreamableTexture>& streamable) {
+    textures.modelPath = filepath;
+    textures.cache = textureCache;
+    textures.embedded = &model.embeddedTextures;
+    textures.streamingExtent = settings.textureStreamingExtent;
+    textures.streamable = &streamable;
+    textures.modelDir = std::filesystem::path(filepath).parent_path().string();
+    if (textures.modelDir.empty()) {
+        textures.modelDir = ".";  // Current directory if no path specified
     }
 
-    // Process children nodes recursively
-    for (uint32_t i = 0; i < node->mNumChildren; ++i) {
-        ProcessNode(device, node->mChildren[i], scene, meshes, modelDir);
+    // Cooked textures (tools/texture_cook) skip image decoding and mip generation
+    if (textures.cooked.Load(utils::TextureManifest::GetPathForModel(filepath))) {
+        METAGFX_INFO << "Using cooked texture manifest (" << textures.cooked.GetEntryCount() << " entries)";
     }
 }
 
-bool Model::LoadFromFile(rhi::GraphicsDevice* device, const std::string& filepath) {
+bool Model::LoadFromFile(rhi::GraphicsDevice* device, const std::string& filepath,
+                         utils::TextureCache* textureCache, const ModelImportSettings& settings,
+                         ModelLoadTimings* timings) {
+    METAGFX_PROFILE_SCOPE("Load model");
+    METAGFX_ALLOCATION_SCOPE(Load);
     if (!device) {
         METAGFX_ERROR << "Model::LoadFromFile - Invalid device";
         return false;
@@ -380,52 +1786,324 @@ bool Model::LoadFromFile(rhi::GraphicsDevice* device, const std::string& filepat
 
     METAGFX_INFO << "Loading model: " << filepath;
 
-    // Create Assimp importer
-    Assimp::Importer importer;
-
-    // Load the model with post-processing
-    // aiProcess_Triangulate: Convert all primitives to triangles
-    // aiProcess_FlipUVs: Flip texture coordinates on Y axis (OpenGL convention)
-    // aiProcess_GenSmoothNormals: Generate smooth normals if not present (for proper shading)
-    // aiProcess_CalcTangentSpace: Calculate tangents/bitangents (for normal mapping later)
-    // aiProcess_JoinIdenticalVertices: Optimize by merging identical vertices
-    const aiScene* scene = importer.ReadFile(filepath,
-        aiProcess_Triangulate |
-        aiProcess_FlipUVs |
-        aiProcess_GenSmoothNormals |  // Use smooth normals instead of flat
-        aiProcess_CalcTangentSpace |
-        aiProcess_JoinIdenticalVertices
-    );
+    if (timings) {
+        *timings = ModelLoadTimings{};
+    }
 
-    // Check for errors
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        METAGFX_ERROR << "Assimp error: " << importer.GetErrorString();
+    ModelSource source;
+    ModelData model;
+    if (!ImportModel(filepath, settings, source, model, nullptr, timings)) {
         return false;
     }
+    ModelImportSettings meshSettings = settings;
+    AdjustSettingsForModel(meshSettings, model);
 
     // Clear existing meshes
     Cleanup();
 
-    // Extract model directory for texture path resolution
-    std::filesystem::path modelPath(filepath);
-    std::string modelDir = modelPath.parent_path().string();
-    if (modelDir.empty()) {
-        modelDir = ".";  // Current directory if no path specified
+    // Everything created below goes away with the model
+    m_ResourceGroup = device->CreateResourceGroup();
+    rhi::ResourceGroupScope groupScope(m_ResourceGroup);
+
+    TextureLookup textures;
+    InitTextureLookup(textures, filepath, textureCache, model, settings, m_StreamableTextures);
+
+    // Decode all textures up front in parallel, then build meshes and materials
+    PreloadTextures(device, model, textures, timings);
+
+    auto uploadStart = std::chrono::steady_clock::now();
+    m_VertexFormat = meshSettings.vertexFormat;
+    m_Quantization = ComputeQuantization(model);
+    m_GeometryPool = CreateGeometryPool(device, model, meshSettings);
+    SetNodes(model.nodes);
+    m_Skins = std::move(model.skins);
+    m_Animations = std::move(model.animations);
+    for (MeshData& data : model.meshes) {
+        DeformedMesh deformation = TakeDeformation(data);
+        auto mesh = CreateMesh(device, data, meshSettings, m_Quantization, m_GeometryPool.get());
+        if (mesh) {
+            AttachMaterial(device, *mesh, data.materialIndex, model, textures);
+            AddMesh(std::move(mesh), data.node, std::move(deformation));
+        }
     }
 
-    // Process the scene
-    ProcessNode(device, scene->mRootNode, scene, m_Meshes, modelDir);
-
     if (m_Meshes.empty()) {
         METAGFX_ERROR << "No meshes loaded from: " << filepath;
         return false;
     }
 
+    CreateDrawList(device);
+    if (timings) {
+        timings->uploadMs += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - uploadStart).count();
+    }
+
     m_FilePath = filepath;
     METAGFX_INFO << "Model loaded successfully: " << m_Meshes.size() << " meshes";
+    if (textureCache) {
+        textureCache->LogStats();
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// Asynchronous loading
+// ----------------------------------------------------------------------------
+
+// State shared by the load handle (render thread) and its worker thread. The worker
+// owns everything up to the decoded images; the render thread owns the device, the
+// model and textures.preloaded.
+struct ModelLoadHandle::Job {
+    rhi::GraphicsDevice* device = nullptr;
+    std::string filepath;
+    ModelImportSettings settings;
+
+    std::thread worker;
+    std::atomic<bool> cancelled{false};
+    std::atomic<bool> importFinished{false};  // scene, meshData and requests are published
+    std::atomic<bool> workerFinished{false};  // every decode has been handed over
+    bool importFailed = false;                // Written before importFinished
+
+    ModelSource source;  // Backs modelData (geometry, embedded textures) until the load ends
+    ModelData modelData;
+    TextureLookup textures;
+    std::vector<TextureRequest> requests;
+
+    std::mutex decodedMutex;
+    std::vector<DecodedTexture> decoded;  // Finished decodes waiting for upload
+
+    std::unique_ptr<Model> model;
+    std::vector<uint32_t> materialIndices;  // Per created mesh
+    size_t nextMesh = 0;
+    bool materialsAttached = false;
+    std::chrono::steady_clock::time_point startTime;
+
+    void Run() {
+        METAGFX_PROFILE_THREAD("Model loader");
+        METAGFX_PROFILE_SCOPE("Load model");
+        METAGFX_ALLOCATION_SCOPE(Load);
+        if (!ImportModel(filepath, settings, source, modelData, &cancelled)) {
+            importFailed = true;
+            importFinished = true;
+            workerFinished = true;
+            return;
+        }
+
+        requests = CollectTextureRequests(modelData, textures);
+        AdjustSettingsForModel(settings, modelData);
+        model->m_VertexFormat = settings.vertexFormat;
+        model->m_Quantization = ComputeQuantization(modelData);
+        importFinished = true;
+
+        DecodeTexturesParallel(requests, textures, &cancelled, [&](DecodedTexture& result) {
+            std::lock_guard<std::mutex> lock(decodedMutex);
+            decoded.push_back(std::move(result));
+        });
+        workerFinished = true;
+    }
+};
+
+bool Model::IsResident() const {
+    auto resident = [](const Ref<rhi::Texture>& texture) { return !texture || texture->IsUploadComplete(); };
+
+    if (m_DrawList && !m_DrawList->GetBuffer()->IsUploadComplete()) {
+        return false;
+    }
+
+    for (const auto& mesh : m_Meshes) {
+        if (!mesh->GetVertexBuffer()->IsUploadComplete() || !mesh->GetIndexBuffer()->IsUploadComplete() ||
+            (mesh->GetPositionBuffer() && !mesh->GetPositionBuffer()->IsUploadComplete())) {
+            return false;
+        }
+
+        const Material* material = mesh->GetMaterial();
+        if (material &&
+            (!resident(material->GetAlbedoMap()) || !resident(material->GetNormalMap()) ||
+             !resident(material->GetMetallicRoughnessMap()) || !resident(material->GetMetallicMap()) ||
+             !resident(material->GetRoughnessMap()) || !resident(material->GetAOMap()) ||
+             !resident(material->GetEmissiveMap()))) {
+            return false;
+        }
+    }
     return true;
 }
 
+Ref<ModelLoadHandle> Model::LoadFromFileAsync(rhi::GraphicsDevice* device, const std::string& filepath,
+                                              utils::TextureCache* textureCache,
+                                              const ModelImportSettings& settings) {
+    Ref<ModelLoadHandle> handle(new ModelLoadHandle());
+    ModelLoadHandle::Job& job = *handle->m_Job;
+
+    if (!device) {
+        METAGFX_ERROR << "Model::LoadFromFileAsync - Invalid device";
+        handle->m_State = ModelLoadState::Failed;
+        return handle;
+    }
+
+    METAGFX_INFO << "Loading model in the background: " << filepath;
+
+    job.device = device;
+    job.filepath = filepath;
+    job.settings = settings;
+    job.model = std::make_unique<Model>();
+    job.model->m_ResourceGroup = device->CreateResourceGroup();
+    job.startTime = std::chrono::steady_clock::now();
+    InitTextureLookup(job.textures, filepath, textureCache, job.modelData, settings,
+                      job.model->m_StreamableTextures);
+
+    job.worker = std::thread([&job]() { job.Run(); });
+    return handle;
+}
+
+ModelLoadHandle::ModelLoadHandle()
+    : m_Job(std::make_unique<Job>()) {
+}
+
+ModelLoadHandle::~ModelLoadHandle() {
+    Cancel();
+    if (m_Job->worker.joinable()) {
+        m_Job->worker.join();
+    }
+
+    // Textures decoded but never uploaded
+    for (DecodedTexture& decoded : m_Job->decoded) {
+        if (decoded.image.pixels) {
+            utils::FreeImage(decoded.image);
+        }
+    }
+}
+
+void ModelLoadHandle::Cancel() {
+    m_Job->cancelled = true;
+}
+
+const std::string& ModelLoadHandle::GetFilePath() const {
+    return m_Job->filepath;
+}
+
+ModelLoadState ModelLoadHandle::Update(ModelUploadBudget* budget) {
+    if (m_State == ModelLoadState::Ready || m_State == ModelLoadState::Failed ||
+        m_State == ModelLoadState::Cancelled) {
+        return m_State;
+    }
+
+    Job& job = *m_Job;
+
+    if (job.cancelled) {
+        // Wait for the worker to notice instead of blocking the frame on join()
+        if (job.workerFinished) {
+            job.worker.join();
+            m_State = ModelLoadState::Cancelled;
+            METAGFX_INFO << "Cancelled loading model: " << job.filepath;
+        }
+        return m_State;
+    }
+
+    if (!job.importFinished) {
+        return m_State;
+    }
+    if (job.importFailed) {
+        job.worker.join();
+        m_State = ModelLoadState::Failed;
+        return m_State;
+    }
+    m_State = ModelLoadState::Uploading;
+    METAGFX_PROFILE_SCOPE("Model upload");
+    METAGFX_ALLOCATION_SCOPE(Load);
+    rhi::ResourceGroupScope groupScope(job.model->m_ResourceGroup);
+
+    ModelUploadBudget ownBudget;
+    ModelUploadBudget& uploads = budget ? *budget : ownBudget;
+
+    // Upload what finished decoding since the last frame, as much as the budget allows.
+    // The flag is read first: once it is set, the queue holds every remaining decode.
+    bool decodesFinished = job.workerFinished;
+    std::vector<DecodedTexture> decoded;
+    {
+        std::lock_guard<std::mutex> lock(job.decodedMutex);
+        size_t count = std::min<size_t>(job.decoded.size(), uploads.textures);
+        decoded.assign(std::make_move_iterator(job.decoded.begin()),
+                       std::make_move_iterator(job.decoded.begin() + count));
+        job.decoded.erase(job.decoded.begin(), job.decoded.begin() + count);
+        decodesFinished = decodesFinished && job.decoded.empty();
+    }
+    for (DecodedTexture& texture : decoded) {
+        UploadDecodedTexture(job.device, job.requests[texture.requestIndex], texture, job.textures);
+    }
+    uploads.textures -= static_cast<uint32>(decoded.size());
+    METAGFX_PROFILE_COUNTER("Model textures uploaded", decoded.size());
+
+    // Geometry uploads are spread over frames so one frame never creates every buffer
+    std::vector<MeshData>& meshData = job.modelData.meshes;
+    if (job.nextMesh == 0 && !job.model->m_GeometryPool) {
+        job.model->m_GeometryPool = CreateGeometryPool(job.device, job.modelData, job.settings);
+        job.model->SetNodes(job.modelData.nodes);
+        job.model->m_Skins = std::move(job.modelData.skins);
+        job.model->m_Animations = std::move(job.modelData.animations);
+    }
+    size_t meshEnd = std::min(meshData.size(), job.nextMesh + uploads.meshes);
+    uploads.meshes -= static_cast<uint32>(meshEnd - job.nextMesh);
+    for (; job.nextMesh < meshEnd; ++job.nextMesh) {
+        MeshData& data = meshData[job.nextMesh];
+        DeformedMesh deformation = TakeDeformation(data);
+        if (auto mesh = CreateMesh(job.device, data, job.settings, job.model->m_Quantization,
+                                   job.model->m_GeometryPool.get())) {
+            job.model->AddMesh(std::move(mesh), data.node, std::move(deformation));
+            job.materialIndices.push_back(data.materialIndex);
+        }
+        data = MeshData{};  // Drops the imported storage the mesh did not take over
+    }
+
+    // Materials need every decoded texture in textures.preloaded
+    if (job.nextMesh < meshData.size() || !decodesFinished) {
+        return m_State;
+    }
+
+    if (!job.materialsAttached) {
+        job.worker.join();
+
+        const auto& meshes = job.model->GetMeshes();
+        for (size_t i = 0; i < meshes.size(); ++i) {
+            AttachMaterial(job.device, *meshes[i], job.materialIndices[i], job.modelData, job.textures);
+        }
+        job.materialsAttached = true;
+        job.model->CreateDrawList(job.device);
+
+        // Materials hold their textures; the source data and the decode bookkeeping can go
+        job.textures.preloaded.clear();
+        job.textures.embedded = nullptr;
+        job.modelData = ModelData{};
+        job.source.Release();
+
+        if (job.model->GetMeshes().empty()) {
+            METAGFX_ERROR << "No meshes loaded from: " << job.filepath;
+            m_State = ModelLoadState::Failed;
+            return m_State;
+        }
+        job.model->m_FilePath = job.filepath;
+    }
+
+    // Swap in only once nothing would be drawn from a half-uploaded resource
+    if (job.model->IsResident()) {
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - job.startTime).count();
+        METAGFX_INFO << "Model loaded in the background: " << job.model->GetMeshes().size()
+                     << " meshes, resident after " << elapsedMs << " ms";
+        if (job.textures.cache) {
+            job.textures.cache->LogStats();
+        }
+        m_State = ModelLoadState::Ready;
+    }
+    return m_State;
+}
+
+std::unique_ptr<Model> ModelLoadHandle::TakeModel() {
+    if (m_State != ModelLoadState::Ready) {
+        return nullptr;
+    }
+    return std::move(m_Job->model);
+}
+
 bool Model::CreateCube(rhi::GraphicsDevice* device, float size) {
     if (!device) {
         METAGFX_ERROR << "Model::CreateCube - Invalid device";
@@ -483,8 +2161,11 @@ bool Model::CreateCube(rhi::GraphicsDevice* device, float size) {
         20, 21, 22, 22, 23, 20  // Bottom
     };
 
+    ComputeTangents(vertices.data(), static_cast<uint32>(vertices.size()),
+                    indices.data(), static_cast<uint32>(indices.size()));
+
     auto mesh = std::make_unique<Mesh>();
-    if (!mesh->Initialize(device, vertices, indices)) {
+    if (!mesh->Initialize(device, std::move(vertices), std::move(indices))) {
         METAGFX_ERROR << "Failed to create cube mesh";
         return false;
     }
@@ -496,7 +2177,8 @@ bool Model::CreateCube(rhi::GraphicsDevice* device, float size) {
         0.0f                           // metallic: non-metallic
     ));
 
-    m_Meshes.push_back(std::move(mesh));
+    SetNodes({});
+    AddMesh(std::move(mesh));
     m_FilePath = "procedural_cube";
     return true;
 }
@@ -549,8 +2231,11 @@ bool Model::CreateSphere(rhi::GraphicsDevice* device, float radius, uint32_t seg
         }
     }
 
+    ComputeTangents(vertices.data(), static_cast<uint32>(vertices.size()),
+                    indices.data(), static_cast<uint32>(indices.size()));
+
     auto mesh = std::make_unique<Mesh>();
-    if (!mesh->Initialize(device, vertices, indices)) {
+    if (!mesh->Initialize(device, std::move(vertices), std::move(indices))) {
         METAGFX_ERROR << "Failed to create sphere mesh";
         return false;
     }
@@ -562,7 +2247,8 @@ bool Model::CreateSphere(rhi::GraphicsDevice* device, float radius, uint32_t seg
         0.0f                           // metallic: non-metallic
     ));
 
-    m_Meshes.push_back(std::move(mesh));
+    SetNodes({});
+    AddMesh(std::move(mesh));
     m_FilePath = "procedural_sphere";
     return true;
 }
@@ -570,32 +2256,104 @@ bool Model::CreateSphere(rhi::GraphicsDevice* device, float radius, uint32_t seg
 void Model::Cleanup() {
     m_Meshes.clear();
     m_FilePath.clear();
+    m_VertexFormat = VertexFormat::Float;
+    m_Quantization = VertexQuantization{};
+    m_GeometryPool.reset();
+    m_DrawList.reset();
+    m_MeshBounds.Clear();
+    m_BoundsMin = glm::vec3(0.0f);
+    m_BoundsMax = glm::vec3(0.0f);
+    m_NodeLocal.clear();
+    m_NodeWorld.clear();
+    m_NodeParents.clear();
+    m_MeshNodes.clear();
+    m_StreamableTextures.clear();
+    m_ResourceGroup = 0;
+    m_Skins.clear();
+    m_Animations.clear();
+    m_DeformedMeshes.clear();
+}
+
+void Model::SetNodes(const std::vector<NodeData>& nodes) {
+    m_NodeLocal.clear();
+    m_NodeWorld.clear();
+    m_NodeParents.clear();
+    if (nodes.empty()) {
+        m_NodeLocal.push_back(glm::mat4(1.0f));
+        m_NodeWorld.push_back(glm::mat4(1.0f));
+        m_NodeParents.push_back(NodeData::NO_PARENT);
+        return;
+    }
+
+    // Parents precede children, so one pass resolves every world matrix
+    for (const NodeData& node : nodes) {
+        m_NodeLocal.push_back(node.localTransform);
+        m_NodeParents.push_back(node.parent);
+        m_NodeWorld.push_back(node.parent == NodeData::NO_PARENT ? node.localTransform
+                                                                  : m_NodeWorld[node.parent] * node.localTransform);
+    }
 }
 
-void Model::AddMesh(std::unique_ptr<Mesh> mesh) {
-    if (mesh) {
-        m_Meshes.push_back(std::move(mesh));
+bool Model::HasNodeTransforms() const {
+    const glm::mat4 identity(1.0f);
+    for (uint32 node : m_MeshNodes) {
+        if (std::memcmp(&m_NodeWorld[node], &identity, sizeof(glm::mat4)) != 0) {
+            return true;
+        }
     }
+    return false;
 }
 
-bool Model::GetBoundingBox(glm::vec3& outMin, glm::vec3& outMax) const {
+void Model::AddMesh(std::unique_ptr<Mesh> mesh, uint32 node) {
+    if (!mesh) {
+        return;
+    }
+    if (m_NodeWorld.empty()) {
+        SetNodes({});
+    }
+    if (node >= m_NodeWorld.size()) {
+        node = 0;
+    }
+
     if (m_Meshes.empty()) {
-        return false;
+        m_BoundsMin = glm::vec3(std::numeric_limits<float>::max());
+        m_BoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+    }
+    AccumulateBounds(*mesh, m_NodeWorld[node]);
+    m_Meshes.push_back(std::move(mesh));
+    m_MeshNodes.push_back(node);
+}
+
+void Model::AddMesh(std::unique_ptr<Mesh> mesh, uint32 node, DeformedMesh deformation) {
+    if (!mesh) {
+        return;
+    }
+    AddMesh(std::move(mesh), node);
+    if (!deformation.bindPose.empty()) {
+        deformation.mesh = static_cast<uint32>(m_Meshes.size() - 1);
+        deformation.node = m_MeshNodes.back();
+        m_DeformedMeshes.push_back(std::move(deformation));
     }
+}
 
-    // Initialize with extreme values
-    outMin = glm::vec3(std::numeric_limits<float>::max());
-    outMax = glm::vec3(std::numeric_limits<float>::lowest());
+void Model::AccumulateBounds(const Mesh& mesh, const glm::mat4& world) {
+    // Largest axis scale bounds how much the node stretches the sphere
+    float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                             glm::length(glm::vec3(world[2])) });
+    m_MeshBounds.Add(glm::vec3(world * glm::vec4(mesh.GetBoundsCenter(), 1.0f)), mesh.GetBoundsRadius() * scale);
 
-    // Iterate through all meshes and all vertices
-    for (const auto& mesh : m_Meshes) {
-        const auto& vertices = mesh->GetVertices();
-        for (const auto& vertex : vertices) {
-            outMin = glm::min(outMin, vertex.position);
-            outMax = glm::max(outMax, vertex.position);
-        }
+    AABB box = AABB::Transform(AABB{ mesh.GetBoundsMin(), mesh.GetBoundsMax() }, world);
+    m_BoundsMin = glm::min(m_BoundsMin, box.min);
+    m_BoundsMax = glm::max(m_BoundsMax, box.max);
+}
+
+bool Model::GetBoundingBox(glm::vec3& outMin, glm::vec3& outMax) const {
+    if (m_Meshes.empty()) {
+        return false;
     }
 
+    outMin = m_BoundsMin;
+    outMax = m_BoundsMax;
     return true;
 }
 
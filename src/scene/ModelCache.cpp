@@ -0,0 +1,449 @@
+// ============================================================================
+// src/scene/ModelCache.cpp
+// ============================================================================
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/utils/TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+namespace metagfx {
+
+// Extension appended to a model's file name for its mesh cache
+constexpr const char* MODEL_CACHE_EXTENSION = ".meshcache";
+constexpr char MODEL_CACHE_MAGIC[8] = { 'M', 'G', 'F', 'X', 'M', 'D', 'L', '\0' };
+constexpr uint64 BLOB_ALIGNMENT = 16;
+constexpr uint32 NO_STRING = std::numeric_limits<uint32>::max();
+constexpr uint32 MATERIAL_TEXTURE_COUNT = 7;
+
+// File layout: header, mesh table, material table, embedded texture table, node
+// table, string table, then the vertex, index, meshlet, LOD, LOD index and embedded texture blobs (each 16-byte aligned).
+// Offsets are from the start of the file.
+struct CacheHeader {
+    char magic[8];
+    uint32 version;
+    uint32 vertexStride;      // sizeof(Vertex) of the writer
+    uint64 sourceHash;
+    uint32 importFlags;
+    uint32 processFlags;      // ModelProcessFlags applied after the import
+    uint32 meshCount;
+    uint32 materialCount;
+    uint32 embeddedCount;
+    uint32 nodeCount;
+    uint64 meshTableOffset;
+    uint64 materialTableOffset;
+    uint64 embeddedTableOffset;
+    uint64 nodeTableOffset;
+    uint64 stringTableOffset;
+    uint64 stringTableSize;
+    uint64 fileSize;
+    float boundsMin[3];       // Whole model
+    float boundsMax[3];
+};
+
+struct CacheMesh {
+    uint64 vertexOffset;
+    uint64 indexOffset;
+    uint64 meshletOffset;
+    uint64 lodOffset;
+    uint64 lodIndexOffset;
+    uint32 vertexCount;
+    uint32 indexCount;
+    uint32 meshletCount;
+    uint32 lodCount;
+    uint32 lodIndexCount;
+    uint32 materialIndex;
+    float boundsMin[3];
+    float boundsMax[3];
+    uint32 node;
+    uint32 padding;
+};
+
+struct CacheMaterial {
+    float albedo[3];
+    float roughness;
+    float metallic;
+    float emissiveFactor[3];
+    uint32 hasEmissiveFactor;
+    uint32 alphaMode;  // AlphaMode
+    float alpha;
+    float alphaCutoff;
+    uint32 textures[MATERIAL_TEXTURE_COUNT];  // String table offsets, NO_STRING = none
+};
+
+struct CacheEmbeddedTexture {
+    uint64 offset;
+    uint64 size;
+    uint32 width;
+    uint32 height;
+};
+
+struct CacheNode {
+    float localTransform[16];  // Column-major
+    uint32 parent;
+    uint32 padding[3];
+};
+
+// Texture slot of a material in CacheMaterial::textures order (MaterialDesc or const MaterialDesc)
+template<typename MaterialT>
+static auto& GetMaterialTexture(MaterialT& material, uint32 slot) {
+    switch (slot) {
+        case 0: return material.albedoMap;
+        case 1: return material.normalMap;
+        case 2: return material.metallicRoughnessMap;
+        case 3: return material.roughnessMap;
+        case 4: return material.aoMap;
+        case 5: return material.emissiveMap;
+        default: return material.packedMetallicRoughnessMap;
+    }
+}
+
+static uint64 AlignUp(uint64 value, uint64 alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+bool ModelData::IsAnimated() const {
+    if (!skins.empty() || !animations.empty()) {
+        return true;
+    }
+    for (const MeshData& mesh : meshes) {
+        if (mesh.IsDeformed()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string ModelCache::GetPathForModel(const std::string& modelPath) {
+    return modelPath + MODEL_CACHE_EXTENSION;
+}
+
+bool ModelCache::HashSourceFile(const std::string& modelPath, uint64& outHash) {
+    utils::MappedFile file;
+    if (!file.Open(modelPath)) {
+        return false;
+    }
+    outHash = utils::TextureCache::HashBytes(file.GetData(), file.GetSize());
+    return true;
+}
+
+bool ModelCache::Write(const std::string& cachePath, const ModelData& data, uint64 sourceHash,
+                       uint32 importFlags, uint32 processFlags) {
+    if (data.IsAnimated()) {
+        return false;
+    }
+
+    CacheHeader header{};
+    std::memcpy(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.vertexStride = sizeof(Vertex);
+    header.sourceHash = sourceHash;
+    header.importFlags = importFlags;
+    header.processFlags = processFlags;
+    header.meshCount = static_cast<uint32>(data.meshes.size());
+    header.materialCount = static_cast<uint32>(data.materials.size());
+    header.embeddedCount = static_cast<uint32>(data.embeddedTextures.size());
+    header.nodeCount = static_cast<uint32>(data.nodes.size());
+
+    // String table
+    std::vector<char> strings;
+    auto addString = [&](const std::string& value) -> uint32 {
+        if (value.empty()) {
+            return NO_STRING;
+        }
+        uint32 offset = static_cast<uint32>(strings.size());
+        strings.insert(strings.end(), value.begin(), value.end());
+        strings.push_back('\0');
+        return offset;
+    };
+
+    std::vector<CacheMaterial> materials(data.materials.size());
+    for (size_t i = 0; i < data.materials.size(); ++i) {
+        const MaterialDesc& source = data.materials[i];
+        CacheMaterial& material = materials[i];
+        std::memcpy(material.albedo, &source.albedo[0], sizeof(material.albedo));
+        material.roughness = source.roughness;
+        material.metallic = source.metallic;
+        std::memcpy(material.emissiveFactor, &source.emissiveFactor[0], sizeof(material.emissiveFactor));
+        material.hasEmissiveFactor = source.hasEmissiveFactor ? 1 : 0;
+        material.alphaMode = static_cast<uint32>(source.alphaMode);
+        material.alpha = source.alpha;
+        material.alphaCutoff = source.alphaCutoff;
+        for (uint32 slot = 0; slot < MATERIAL_TEXTURE_COUNT; ++slot) {
+            material.textures[slot] = addString(GetMaterialTexture(source, slot));
+        }
+    }
+
+    // Tables, then the blobs
+    header.meshTableOffset = sizeof(CacheHeader);
+    header.materialTableOffset = header.meshTableOffset + sizeof(CacheMesh) * header.meshCount;
+    header.embeddedTableOffset = header.materialTableOffset + sizeof(CacheMaterial) * header.materialCount;
+    header.nodeTableOffset = header.embeddedTableOffset + sizeof(CacheEmbeddedTexture) * header.embeddedCount;
+    header.stringTableOffset = header.nodeTableOffset + sizeof(CacheNode) * header.nodeCount;
+    header.stringTableSize = strings.size();
+    uint64 offset = header.stringTableOffset + header.stringTableSize;
+
+    glm::vec3 modelMin(std::numeric_limits<float>::max());
+    glm::vec3 modelMax(std::numeric_limits<float>::lowest());
+
+    std::vector<CacheMesh> meshes(data.meshes.size());
+    for (size_t i = 0; i < data.meshes.size(); ++i) {
+        const MeshData& source = data.meshes[i];
+        CacheMesh& mesh = meshes[i];
+        mesh = {};
+        mesh.vertexCount = source.vertexCount;
+        mesh.indexCount = source.indexCount;
+        mesh.meshletCount = source.meshlets ? source.meshletCount : 0;
+        mesh.lodCount = source.lods && source.lodIndices ? source.lodCount : 0;
+        mesh.lodIndexCount = mesh.lodCount > 0 ? source.lodIndexCount : 0;
+        mesh.materialIndex = source.materialIndex;
+        mesh.node = source.node;
+        std::memcpy(mesh.boundsMin, &source.boundsMin[0], sizeof(mesh.boundsMin));
+        std::memcpy(mesh.boundsMax, &source.boundsMax[0], sizeof(mesh.boundsMax));
+        modelMin = glm::min(modelMin, source.boundsMin);
+        modelMax = glm::max(modelMax, source.boundsMax);
+
+        mesh.vertexOffset = AlignUp(offset, BLOB_ALIGNMENT);
+        offset = mesh.vertexOffset + sizeof(Vertex) * static_cast<uint64>(source.vertexCount);
+        mesh.indexOffset = AlignUp(offset, BLOB_ALIGNMENT);
+        offset = mesh.indexOffset + sizeof(uint32) * static_cast<uint64>(source.indexCount);
+        mesh.meshletOffset = AlignUp(offset, BLOB_ALIGNMENT);
+        offset = mesh.meshletOffset + sizeof(Meshlet) * static_cast<uint64>(mesh.meshletCount);
+        mesh.lodOffset = AlignUp(offset, BLOB_ALIGNMENT);
+        offset = mesh.lodOffset + sizeof(MeshLod) * static_cast<uint64>(mesh.lodCount);
+        mesh.lodIndexOffset = AlignUp(offset, BLOB_ALIGNMENT);
+        offset = mesh.lodIndexOffset + sizeof(uint32) * static_cast<uint64>(mesh.lodIndexCount);
+    }
+
+    std::vector<CacheNode> nodes(data.nodes.size());
+    for (size_t i = 0; i < data.nodes.size(); ++i) {
+        nodes[i] = {};
+        std::memcpy(nodes[i].localTransform, &data.nodes[i].localTransform[0][0], sizeof(nodes[i].localTransform));
+        nodes[i].parent = data.nodes[i].parent;
+    }
+
+    std::vector<CacheEmbeddedTexture> embedded(data.embeddedTextures.size());
+    for (size_t i = 0; i < data.embeddedTextures.size(); ++i) {
+        const EmbeddedTexture& source = data.embeddedTextures[i];
+        embedded[i].offset = AlignUp(offset, BLOB_ALIGNMENT);
+        embedded[i].size = source.data ? source.size : 0;
+        embedded[i].width = source.width;
+        embedded[i].height = source.height;
+        offset = embedded[i].offset + embedded[i].size;
+    }
+
+    header.fileSize = offset;
+    if (!data.meshes.empty()) {
+        std::memcpy(header.boundsMin, &modelMin[0], sizeof(header.boundsMin));
+        std::memcpy(header.boundsMax, &modelMax[0], sizeof(header.boundsMax));
+    }
+
+    // Assemble in memory and write once
+    std::vector<uint8> file(header.fileSize, 0);
+    auto put = [&](uint64 at, const void* source, uint64 size) {
+        if (size > 0) {
+            std::memcpy(file.data() + at, source, size);
+        }
+    };
+    put(0, &header, sizeof(header));
+    put(header.meshTableOffset, meshes.data(), sizeof(CacheMesh) * meshes.size());
+    put(header.materialTableOffset, materials.data(), sizeof(CacheMaterial) * materials.size());
+    put(header.embeddedTableOffset, embedded.data(), sizeof(CacheEmbeddedTexture) * embedded.size());
+    put(header.nodeTableOffset, nodes.data(), sizeof(CacheNode) * nodes.size());
+    put(header.stringTableOffset, strings.data(), strings.size());
+    for (size_t i = 0; i < data.meshes.size(); ++i) {
+        put(meshes[i].vertexOffset, data.meshes[i].vertices, sizeof(Vertex) * static_cast<uint64>(meshes[i].vertexCount));
+        put(meshes[i].indexOffset, data.meshes[i].indices, sizeof(uint32) * static_cast<uint64>(meshes[i].indexCount));
+        put(meshes[i].meshletOffset, data.meshes[i].meshlets, sizeof(Meshlet) * static_cast<uint64>(meshes[i].meshletCount));
+        put(meshes[i].lodOffset, data.meshes[i].lods, sizeof(MeshLod) * static_cast<uint64>(meshes[i].lodCount));
+        put(meshes[i].lodIndexOffset, data.meshes[i].lodIndices, sizeof(uint32) * static_cast<uint64>(meshes[i].lodIndexCount));
+    }
+    for (size_t i = 0; i < data.embeddedTextures.size(); ++i) {
+        put(embedded[i].offset, data.embeddedTextures[i].data, embedded[i].size);
+    }
+
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+        if (!out) {
+            out.close();
+            std::error_code ec;
+            std::filesystem::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tempPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool ModelCache::Open(const std::string& cachePath, uint64 sourceHash, uint32 importFlags, uint32 processFlags,
+                      ModelData& outData) {
+    Close();
+    if (!m_File.Open(cachePath)) {
+        return false;
+    }
+
+    const uint8* base = m_File.GetData();
+    uint64 fileSize = m_File.GetSize();
+
+    auto fail = [&](const char* reason) {
+        METAGFX_INFO << "Mesh cache " << cachePath << " not used: " << reason;
+        Close();
+        return false;
+    };
+    auto inFile = [&](uint64 offset, uint64 size) {
+        return offset <= fileSize && size <= fileSize - offset;
+    };
+
+    if (fileSize < sizeof(CacheHeader)) {
+        return fail("truncated");
+    }
+    CacheHeader header;
+    std::memcpy(&header, base, sizeof(header));
+
+    if (std::memcmp(header.magic, MODEL_CACHE_MAGIC, sizeof(header.magic)) != 0) {
+        return fail("not a mesh cache");
+    }
+    if (header.version != VERSION || header.vertexStride != sizeof(Vertex)) {
+        return fail("written by another version");
+    }
+    if (header.sourceHash != sourceHash) {
+        return fail("model file changed");
+    }
+    if (header.importFlags != importFlags) {
+        return fail("import flags changed");
+    }
+    if (header.processFlags != processFlags) {
+        return fail("processing options changed");
+    }
+    if (header.fileSize != fileSize ||
+        !inFile(header.meshTableOffset, sizeof(CacheMesh) * static_cast<uint64>(header.meshCount)) ||
+        !inFile(header.materialTableOffset, sizeof(CacheMaterial) * static_cast<uint64>(header.materialCount)) ||
+        !inFile(header.embeddedTableOffset, sizeof(CacheEmbeddedTexture) * static_cast<uint64>(header.embeddedCount)) ||
+        !inFile(header.nodeTableOffset, sizeof(CacheNode) * static_cast<uint64>(header.nodeCount)) ||
+        !inFile(header.stringTableOffset, header.stringTableSize) ||
+        (header.stringTableSize > 0 && base[header.stringTableOffset + header.stringTableSize - 1] != '\0')) {
+        return fail("corrupt");
+    }
+
+    const char* strings = reinterpret_cast<const char*>(base + header.stringTableOffset);
+    auto getString = [&](uint32 offset) -> std::string {
+        if (offset == NO_STRING || offset >= header.stringTableSize) {
+            return {};
+        }
+        return strings + offset;
+    };
+
+    ModelData data;
+
+    data.meshes.resize(header.meshCount);
+    for (uint32 i = 0; i < header.meshCount; ++i) {
+        CacheMesh source;
+        std::memcpy(&source, base + header.meshTableOffset + sizeof(CacheMesh) * i, sizeof(source));
+        if (!inFile(source.vertexOffset, sizeof(Vertex) * static_cast<uint64>(source.vertexCount)) ||
+            !inFile(source.indexOffset, sizeof(uint32) * static_cast<uint64>(source.indexCount)) ||
+            !inFile(source.meshletOffset, sizeof(Meshlet) * static_cast<uint64>(source.meshletCount)) ||
+            !inFile(source.lodOffset, sizeof(MeshLod) * static_cast<uint64>(source.lodCount)) ||
+            !inFile(source.lodIndexOffset, sizeof(uint32) * static_cast<uint64>(source.lodIndexCount)) ||
+            source.vertexOffset % alignof(Vertex) != 0 || source.indexOffset % alignof(uint32) != 0 ||
+            source.meshletOffset % alignof(Meshlet) != 0 || source.lodOffset % alignof(MeshLod) != 0 ||
+            source.lodIndexOffset % alignof(uint32) != 0 || source.lodCount > MeshLod::MAX_LEVELS) {
+            return fail("corrupt mesh table");
+        }
+        // The levels are drawn straight from their ranges
+        const MeshLod* lods = reinterpret_cast<const MeshLod*>(base + source.lodOffset);
+        for (uint32 lod = 0; lod < source.lodCount; ++lod) {
+            if (static_cast<uint64>(lods[lod].firstIndex) + lods[lod].indexCount > source.lodIndexCount) {
+                return fail("corrupt LOD table");
+            }
+        }
+
+        MeshData& mesh = data.meshes[i];
+        mesh.vertices = reinterpret_cast<const Vertex*>(base + source.vertexOffset);
+        mesh.vertexCount = source.vertexCount;
+        mesh.indices = reinterpret_cast<const uint32*>(base + source.indexOffset);
+        mesh.indexCount = source.indexCount;
+        mesh.meshlets = source.meshletCount > 0 ? reinterpret_cast<const Meshlet*>(base + source.meshletOffset) : nullptr;
+        mesh.meshletCount = source.meshletCount;
+        mesh.lods = source.lodCount > 0 ? lods : nullptr;
+        mesh.lodCount = source.lodCount;
+        mesh.lodIndices = source.lodIndexCount > 0 ? reinterpret_cast<const uint32*>(base + source.lodIndexOffset) : nullptr;
+        mesh.lodIndexCount = source.lodIndexCount;
+        mesh.materialIndex = source.materialIndex;
+        mesh.node = source.node;
+        mesh.boundsMin = glm::vec3(source.boundsMin[0], source.boundsMin[1], source.boundsMin[2]);
+        mesh.boundsMax = glm::vec3(source.boundsMax[0], source.boundsMax[1], source.boundsMax[2]);
+    }
+
+    data.materials.resize(header.materialCount);
+    for (uint32 i = 0; i < header.materialCount; ++i) {
+        CacheMaterial source;
+        std::memcpy(&source, base + header.materialTableOffset + sizeof(CacheMaterial) * i, sizeof(source));
+
+        MaterialDesc& material = data.materials[i];
+        material.albedo = glm::vec3(source.albedo[0], source.albedo[1], source.albedo[2]);
+        material.roughness = source.roughness;
+        material.metallic = source.metallic;
+        material.emissiveFactor = glm::vec3(source.emissiveFactor[0], source.emissiveFactor[1], source.emissiveFactor[2]);
+        material.hasEmissiveFactor = source.hasEmissiveFactor != 0;
+        material.alphaMode = source.alphaMode <= static_cast<uint32>(AlphaMode::Blend)
+                                 ? static_cast<AlphaMode>(source.alphaMode) : AlphaMode::Opaque;
+        material.alpha = source.alpha;
+        material.alphaCutoff = source.alphaCutoff;
+        for (uint32 slot = 0; slot < MATERIAL_TEXTURE_COUNT; ++slot) {
+            GetMaterialTexture(material, slot) = getString(source.textures[slot]);
+        }
+    }
+
+    data.embeddedTextures.resize(header.embeddedCount);
+    for (uint32 i = 0; i < header.embeddedCount; ++i) {
+        CacheEmbeddedTexture source;
+        std::memcpy(&source, base + header.embeddedTableOffset + sizeof(CacheEmbeddedTexture) * i, sizeof(source));
+        if (!inFile(source.offset, source.size)) {
+            return fail("corrupt embedded texture table");
+        }
+
+        EmbeddedTexture& texture = data.embeddedTextures[i];
+        texture.data = source.size > 0 ? base + source.offset : nullptr;
+        texture.size = source.size;
+        texture.width = source.width;
+        texture.height = source.height;
+    }
+
+    data.nodes.resize(header.nodeCount);
+    for (uint32 i = 0; i < header.nodeCount; ++i) {
+        CacheNode source;
+        std::memcpy(&source, base + header.nodeTableOffset + sizeof(CacheNode) * i, sizeof(source));
+        if (source.parent != NodeData::NO_PARENT && source.parent >= i) {
+            return fail("corrupt node table");
+        }
+
+        NodeData& node = data.nodes[i];
+        std::memcpy(&node.localTransform[0][0], source.localTransform, sizeof(source.localTransform));
+        node.parent = source.parent;
+    }
+    for (const MeshData& mesh : data.meshes) {
+        if (mesh.node >= std::max(1u, header.nodeCount)) {
+            return fail("corrupt mesh table");
+        }
+    }
+
+    outData = std::move(data);
+    return true;
+}
+
+} // namespace metagfx
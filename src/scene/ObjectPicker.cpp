@@ -0,0 +1,102 @@
+// ============================================================================
+// src/scene/ObjectPicker.cpp
+// ============================================================================
+#include "metagfx/scene/ObjectPicker.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/FormatInfo.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace metagfx {
+
+ObjectPicker::ObjectPicker(Ref<rhi::GraphicsDevice> device)
+    : m_Device(device)
+    , m_Pending(std::make_shared<Pending>()) {
+    m_Readback = std::make_unique<rhi::ReadbackPool>(device);
+}
+
+void ObjectPicker::Request(const glm::vec2& ndc) {
+    m_RequestNdc = ndc;
+    m_Requested = true;
+}
+
+glm::mat4 ObjectPicker::BeginPick(const glm::vec2& viewportSize) {
+    m_Requested = false;
+    m_Pending->serial = ++m_Serial;
+    m_Pending->ready = false;
+
+    // In clip space, so the translation scales with w: the request moves to the center,
+    // then REGION_SIZE pixels of the viewport span the target
+    glm::vec3 scale(viewportSize.x / static_cast<float>(REGION_SIZE),
+                    viewportSize.y / static_cast<float>(REGION_SIZE), 1.0f);
+    glm::mat4 region = glm::scale(glm::mat4(1.0f), scale);
+    return glm::translate(region, glm::vec3(-m_RequestNdc, 0.0f));
+}
+
+void ObjectPicker::ReadBack(rhi::CommandBuffer& cmd, const Ref<rhi::Texture>& ids) {
+    std::shared_ptr<Pending> pending = m_Pending;
+    uint64 serial = m_Serial;
+    bool started = m_Readback->ReadTexture(cmd, ids, [pending, serial](const void* data, uint64 size) {
+        // A newer pick has been drawn since; its own result follows
+        if (pending->serial != serial) {
+            return;
+        }
+        pending->result = Resolve(data, size);
+        pending->resolved = serial;
+        pending->ready = true;
+    });
+    if (!started) {
+        METAGFX_ERROR << "ObjectPicker: failed to read back the pick";
+        m_Pending->resolved = serial;
+    }
+}
+
+void ObjectPicker::BeginFrame() {
+    if (m_Readback) {
+        m_Readback->BeginFrame();
+    }
+}
+
+bool ObjectPicker::TakeResult(Result& result) {
+    if (!m_Pending->ready) {
+        return false;
+    }
+    result = m_Pending->result;
+    m_Pending->ready = false;
+    return true;
+}
+
+ObjectPicker::Result ObjectPicker::Resolve(const void* data, uint64 size) {
+    Result result;
+    uint32 rowPitch = rhi::GetReadbackRowPitch(ID_FORMAT, REGION_SIZE);
+    if (!data || size < static_cast<uint64>(rowPitch) * REGION_SIZE) {
+        return result;
+    }
+
+    // The drawn texel nearest the center, which is the cursor's; which way rows run does
+    // not matter to the distance
+    const int32 center = static_cast<int32>(REGION_SIZE / 2);
+    int32 nearest = -1;
+    for (uint32 y = 0; y < REGION_SIZE; ++y) {
+        const float* row = reinterpret_cast<const float*>(static_cast<const uint8*>(data) + y * rowPitch);
+        for (uint32 x = 0; x < REGION_SIZE; ++x) {
+            const float* texel = row + x * 4;
+            if (texel[3] < 1.0f) {
+                continue;
+            }
+            int32 dx = static_cast<int32>(x) - center;
+            int32 dy = static_cast<int32>(y) - center;
+            int32 distance = dx * dx + dy * dy;
+            if (nearest < 0 || distance < nearest) {
+                nearest = distance;
+                result.hit = true;
+                result.mesh = static_cast<uint32>(texel[3]) - 1;
+                result.position = glm::vec3(texel[0], texel[1], texel[2]);
+            }
+        }
+    }
+    return result;
+}
+
+} // namespace metagfx
@@ -0,0 +1,433 @@
+// ============================================================================
+// src/scene/PathTracer.cpp
+// ============================================================================
+#include "metagfx/scene/PathTracer.h"
+#include "metagfx/scene/GeometryPool.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Scene.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace metagfx {
+
+// Bindings of the main set the tracer reads: frame constants, lights, prefiltered
+// environment and the scene's top level
+constexpr uint32 PATH_TRACE_SCENE_BINDINGS[] = { 0, 3, 9, 22 };
+constexpr uint32 TOP_LEVEL_BINDING = 22;
+
+// Bindings of path_trace.comp besides the scene's; 1 and 14 as the bindless main pass's
+constexpr uint32 MATERIAL_BINDING = 1;
+constexpr uint32 TEXTURE_TABLE_BINDING = 14;
+constexpr uint32 VERTEX_BINDING = 23;
+constexpr uint32 INDEX_BINDING = 24;
+constexpr uint32 INSTANCE_BINDING = 25;
+constexpr uint32 ACCUMULATION_BINDING = 26;
+constexpr uint32 GUIDE_BINDING = 27;
+constexpr uint32 ALBEDO_BINDING = 28;
+
+// Push constants of path_trace.comp
+struct TracePushConstants {
+    glm::uvec2 tileOrigin;
+    glm::uvec2 size;
+    uint32 sampleIndex;
+    uint32 maxBounces;
+    uint32 environment;
+    float environmentIntensity;
+};
+
+PathTracer::PathTracer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> traceShader,
+                       Ref<rhi::Shader> compositeVertexShader, Ref<rhi::Shader> compositeFragmentShader,
+                       const std::vector<rhi::DescriptorBindingDesc>& sceneBindings, uint32 textureCapacity,
+                       rhi::Format sceneColorFormat)
+    : m_Device(device), m_TextureCapacity(textureCapacity) {
+    using namespace rhi;
+
+    const DeviceInfo& info = device->GetDeviceInfo();
+    if (!info.supportsRayQuery || !info.supportsBindlessTextures || info.maxBindlessTextures < textureCapacity) {
+        METAGFX_INFO << "Path tracing unavailable: the device lacks ray queries or bindless textures";
+        return;
+    }
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    for (const DescriptorBindingDesc& binding : sceneBindings) {
+        if (std::find(std::begin(PATH_TRACE_SCENE_BINDINGS), std::end(PATH_TRACE_SCENE_BINDINGS), binding.binding) !=
+            std::end(PATH_TRACE_SCENE_BINDINGS)) {
+            m_Bindings.push_back(binding);
+            m_Bindings.back().stageFlags = ShaderStage::Compute;
+        }
+    }
+    if (m_Bindings.size() != std::size(PATH_TRACE_SCENE_BINDINGS)) {
+        METAGFX_ERROR << "Path tracing unavailable: the scene bindings lack the lights, environment or top level";
+        m_Bindings.clear();
+        return;
+    }
+    m_Bindings.push_back({ MATERIAL_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ TEXTURE_TABLE_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr, 0, textureCapacity });
+    m_Bindings.push_back({ VERTEX_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ INDEX_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ INSTANCE_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ ACCUMULATION_BINDING, DescriptorType::StorageTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ GUIDE_BINDING, DescriptorType::StorageTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ ALBEDO_BINDING, DescriptorType::StorageTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+
+    // The materials, geometry and accumulation come later; the pipelines only need the layouts
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = m_Bindings;
+    layoutDesc.debugName = "PathTraceLayout";
+    Ref<DescriptorSet> traceLayout = device->CreateDescriptorSet(layoutDesc);
+
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler }  // Accumulation
+    };
+    layoutDesc.debugName = "PathTraceCompositeLayout";
+    Ref<DescriptorSet> compositeLayout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc traceDesc{};
+    traceDesc.computeShader = traceShader;
+    traceDesc.pushConstantSize = sizeof(TracePushConstants);
+    traceDesc.debugName = "PathTracePipeline";
+    traceDesc.descriptorSetLayout = traceLayout;
+    m_TracePipeline = device->CreateComputePipeline(traceDesc);
+
+    // A triangle over the viewport, made by the vertex shader; the image has no depth
+    PipelineDesc compositeDesc{};
+    compositeDesc.vertexShader = compositeVertexShader;
+    compositeDesc.fragmentShader = compositeFragmentShader;
+    compositeDesc.vertexInput.stride = 0;
+    compositeDesc.rasterization.cullMode = CullMode::None;
+    compositeDesc.depthStencil.depthTestEnable = false;
+    compositeDesc.depthStencil.depthWriteEnable = false;
+    compositeDesc.colorFormats = { sceneColorFormat };
+    compositeDesc.debugName = "PathTraceCompositePipeline";
+    compositeDesc.descriptorSetLayout = compositeLayout;
+    m_CompositePipeline = device->CreateGraphicsPipeline(compositeDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Path tracing unavailable: failed to create its pipelines";
+        return;
+    }
+    METAGFX_INFO << "Path tracer created: " << TILE_SIZE << "x" << TILE_SIZE << " tiles, " << textureCapacity
+                 << " table textures";
+}
+
+void PathTracer::SetSettings(const Settings& settings) {
+    if (settings.maxBounces != m_Settings.maxBounces) {
+        m_ResetPending = true;
+    }
+    m_Settings = settings;
+    m_Settings.tilesPerFrame = std::max(m_Settings.tilesPerFrame, 1u);
+    m_Settings.maxSamples = std::max(m_Settings.maxSamples, 1u);
+}
+
+void PathTracer::SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture,
+                            Ref<rhi::Sampler> sampler) {
+    for (rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == binding) {
+            entry.buffer = buffer;
+            entry.texture = texture;
+            entry.sampler = sampler;
+        }
+    }
+    if (m_DescriptorSet) {
+        if (texture) {
+            m_DescriptorSet->UpdateTexture(binding, texture, sampler);
+        } else {
+            m_DescriptorSet->UpdateBuffer(binding, buffer);
+        }
+    } else {
+        CreateDescriptorSets();
+    }
+}
+
+void PathTracer::SetSceneTexture(uint32 binding, Ref<rhi::Texture> texture, Ref<rhi::Sampler> sampler) {
+    SetBinding(binding, nullptr, texture, sampler);
+    m_ResetPending = true;
+}
+
+void PathTracer::SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer) {
+    SetBinding(binding, buffer, nullptr, nullptr);
+}
+
+void PathTracer::SetTopLevel(Ref<rhi::AccelerationStructure> topLevel) {
+    if (topLevel == m_TopLevel) {
+        return;
+    }
+    m_TopLevel = topLevel;
+    for (rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == TOP_LEVEL_BINDING) {
+            entry.accelerationStructure = m_TopLevel;
+        }
+    }
+    if (m_DescriptorSet && m_TopLevel) {
+        m_DescriptorSet->UpdateAccelerationStructure(TOP_LEVEL_BINDING, m_TopLevel);
+    }
+    m_ResetPending = true;
+}
+
+void PathTracer::SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                              Ref<rhi::Sampler> sampler) {
+    if (!IsValid()) {
+        return;
+    }
+    if (textures.size() > m_TextureCapacity) {
+        METAGFX_WARN << "Path tracing: " << textures.size() << " material textures, " << m_TextureCapacity << " fit";
+        return;
+    }
+    m_Textures = textures;
+    m_TextureSampler = sampler;
+    SetBinding(MATERIAL_BINDING, materialBuffer, nullptr, nullptr);
+
+    // A set created just now wrote the table already
+    if (m_DescriptorSet) {
+        uint32 count = static_cast<uint32>(m_Textures.size());
+        for (uint32 i = 0; i < std::max(count, m_WrittenTextures); ++i) {
+            if (i < count) {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+            } else {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, nullptr, nullptr);
+            }
+        }
+        m_WrittenTextures = count;
+    }
+    m_ResetPending = true;
+}
+
+void PathTracer::SetGeometry(const Scene& scene, const GeometryPool& pool,
+                             const std::unordered_map<const Material*, uint32>& materialIndices) {
+    using namespace rhi;
+
+    if (!IsValid()) {
+        return;
+    }
+
+    // One entry per scene slot, as the top level's instance indices name them; meshes
+    // outside the pool or the table are never hit, since they are not pooled either
+    std::vector<InstanceData> instances(std::max(scene.GetMeshInstanceCount(), 1u));
+    for (uint32 i = 0; i < scene.GetMeshInstanceCount(); ++i) {
+        InstanceData& data = instances[i];
+        data = { 0, 0, NO_MATERIAL, 0 };
+
+        const Mesh* mesh = scene.GetMeshInstance(i).mesh;
+        if (!mesh || mesh->GetVertexBuffer() != pool.GetVertexBuffer()) {
+            continue;
+        }
+        auto material = materialIndices.find(mesh->GetMaterial());
+        data.firstIndex = mesh->GetFirstIndex();
+        data.vertexOffset = mesh->GetVertexOffset();
+        data.materialIndex = material != materialIndices.end() ? material->second : 0;
+        data.compact = mesh->GetVertexFormat() == VertexFormat::Compact ? 1 : 0;
+    }
+
+    BufferDesc desc{};
+    desc.size = instances.size() * sizeof(InstanceData);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "PathTraceInstances";
+    Ref<Buffer> buffer = m_Device->CreateBuffer(desc);
+    if (!buffer) {
+        METAGFX_ERROR << "Path tracing: failed to create " << desc.size << " byte instance buffer";
+        return;
+    }
+    buffer->CopyData(instances.data(), desc.size);
+
+    // Earlier frames in flight may still read the last one
+    for (const rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == INSTANCE_BINDING && entry.buffer) {
+            m_Device->Retire(entry.buffer);
+        }
+    }
+    SetBinding(VERTEX_BINDING, pool.GetVertexBuffer(), nullptr, nullptr);
+    SetBinding(INDEX_BINDING, pool.GetIndexBuffer(), nullptr, nullptr);
+    SetBinding(INSTANCE_BINDING, buffer, nullptr, nullptr);
+    m_ResetPending = true;
+}
+
+void PathTracer::CreateDescriptorSets() {
+    using namespace rhi;
+
+    if (!IsValid() || m_DescriptorSet || !m_Accumulation) {
+        return;
+    }
+    for (const DescriptorBindingDesc& binding : m_Bindings) {
+        // The top level may come later (SetTopLevel()), the table's elements after the set
+        bool bound = binding.buffer || binding.texture || binding.count > 1 ||
+                     binding.type == DescriptorType::AccelerationStructure;
+        if (!bound) {
+            return;
+        }
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = m_Bindings;
+    desc.debugName = "PathTraceDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+    if (!m_DescriptorSet) {
+        return;
+    }
+    m_WrittenTextures = static_cast<uint32>(m_Textures.size());
+    for (uint32 i = 0; i < m_WrittenTextures; ++i) {
+        m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+    }
+
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_Accumulation, m_PointSampler }
+    };
+    desc.debugName = "PathTraceCompositeDescriptorSet";
+    m_CompositeDescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void PathTracer::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    width = std::max(width, 1u);
+    height = std::max(height, 1u);
+    if (!IsValid() || (width == m_Width && height == m_Height && m_Accumulation)) {
+        return;
+    }
+    m_Width = width;
+    m_Height = height;
+
+    // Rest in GENERAL like every storage texture; the composite and the denoiser read
+    // them in place
+    TextureDesc accumulationDesc{};
+    accumulationDesc.width = width;
+    accumulationDesc.height = height;
+    accumulationDesc.format = ACCUMULATION_FORMAT;
+    accumulationDesc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    accumulationDesc.debugName = "PathTraceAccumulation";
+    Ref<Texture> accumulation = m_Device->CreateTexture(accumulationDesc);
+    TextureDesc guideDesc = accumulationDesc;
+    guideDesc.format = GUIDE_FORMAT;
+    guideDesc.debugName = "PathTraceGuide";
+    Ref<Texture> guide = m_Device->CreateTexture(guideDesc);
+    guideDesc.format = ALBEDO_FORMAT;
+    guideDesc.debugName = "PathTraceAlbedo";
+    Ref<Texture> albedo = m_Device->CreateTexture(guideDesc);
+    if (!accumulation || !guide || !albedo) {
+        METAGFX_ERROR << "Path tracing: failed to create its " << width << "x" << height << " accumulation";
+        return;
+    }
+
+    if (m_Accumulation) {
+        m_Device->Retire(m_Accumulation);
+        m_Device->Retire(m_Guide);
+        m_Device->Retire(m_Albedo);
+    }
+    m_Accumulation = accumulation;
+    m_Guide = guide;
+    m_Albedo = albedo;
+    for (DescriptorBindingDesc& binding : m_Bindings) {
+        if (binding.binding == ACCUMULATION_BINDING) {
+            binding.texture = m_Accumulation;
+        } else if (binding.binding == GUIDE_BINDING) {
+            binding.texture = m_Guide;
+        } else if (binding.binding == ALBEDO_BINDING) {
+            binding.texture = m_Albedo;
+        }
+    }
+    if (m_DescriptorSet) {
+        m_DescriptorSet->UpdateTexture(ACCUMULATION_BINDING, m_Accumulation, nullptr);
+        m_DescriptorSet->UpdateTexture(GUIDE_BINDING, m_Guide, nullptr);
+        m_DescriptorSet->UpdateTexture(ALBEDO_BINDING, m_Albedo, nullptr);
+        m_CompositeDescriptorSet->UpdateTexture(0, m_Accumulation, m_PointSampler);
+    } else {
+        CreateDescriptorSets();
+    }
+    m_ResetPending = true;
+}
+
+uint32 PathTracer::GetTileCount() const {
+    uint32 columns = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32 rows = (m_Height + TILE_SIZE - 1) / TILE_SIZE;
+    return columns * rows;
+}
+
+float PathTracer::GetPassProgress() const {
+    uint32 tiles = GetTileCount();
+    return tiles != 0 && !IsConverged() ? static_cast<float>(m_NextTile) / static_cast<float>(tiles) : 0.0f;
+}
+
+void PathTracer::Trace(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 frameUniformOffset, const View& view,
+                       const Scene& scene) {
+    if (!IsReady()) {
+        return;
+    }
+
+    // The view and lights compare as bytes: any change at all restarts the image
+    const std::vector<LightData>& lights = scene.GetGPULights();
+    bool viewChanged = view.viewProjection != m_View.viewProjection || view.environment != m_View.environment ||
+                       view.environmentIntensity != m_View.environmentIntensity;
+    bool lightsChanged = lights.size() != m_Lights.size() ||
+                         (!lights.empty() && std::memcmp(lights.data(), m_Lights.data(),
+                                                         lights.size() * sizeof(LightData)) != 0);
+    if (m_ResetPending || viewChanged || lightsChanged) {
+        m_View = view;
+        m_Lights = lights;
+        m_ResetPending = false;
+        m_Pass = 0;
+        m_NextTile = 0;
+    }
+    if (IsConverged()) {
+        return;
+    }
+
+    // The first pass traces the whole image, so a moving view never shows stale tiles
+    uint32 tileCount = GetTileCount();
+    uint32 columns = (m_Width + TILE_SIZE - 1) / TILE_SIZE;
+    uint32 tiles = m_Pass == 0 ? tileCount : std::min(m_Settings.tilesPerFrame, tileCount - m_NextTile);
+
+    TracePushConstants push{};
+    push.size = glm::uvec2(m_Width, m_Height);
+    push.sampleIndex = m_Pass;
+    push.maxBounces = m_Settings.maxBounces;
+    push.environment = m_View.environment ? 1 : 0;
+    push.environmentIntensity = m_View.environmentIntensity;
+
+    cmd.BindPipeline(m_TracePipeline);
+    cmd.BindDescriptorSet(m_TracePipeline, m_DescriptorSet, frameIndex, &frameUniformOffset, 1);
+    for (uint32 i = 0; i < tiles; ++i, ++m_NextTile) {
+        push.tileOrigin = glm::uvec2(m_NextTile % columns * TILE_SIZE, m_NextTile / columns * TILE_SIZE);
+        uint32 width = std::min(TILE_SIZE, m_Width - push.tileOrigin.x);
+        uint32 height = std::min(TILE_SIZE, m_Height - push.tileOrigin.y);
+        cmd.PushConstants(m_TracePipeline, rhi::ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((width + GROUP_SIZE - 1) / GROUP_SIZE, (height + GROUP_SIZE - 1) / GROUP_SIZE);
+    }
+    if (m_NextTile >= tileCount) {
+        m_NextTile = 0;
+        ++m_Pass;
+    }
+}
+
+void PathTracer::Composite(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    if (!m_CompositeDescriptorSet) {
+        return;
+    }
+
+    cmd.BindPipeline(m_CompositePipeline);
+    cmd.BindDescriptorSet(m_CompositePipeline, m_CompositeDescriptorSet, frameIndex);
+    cmd.Draw(3);
+}
+
+} // namespace metagfx
@@ -0,0 +1,229 @@
+// ============================================================================
+// src/scene/RayTracingScene.cpp
+// ============================================================================
+#include "metagfx/scene/RayTracingScene.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Scene.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/core/Logger.h"
+
+#include <cstring>
+
+namespace metagfx {
+
+RayTracingScene::RayTracingScene(Ref<rhi::GraphicsDevice> device)
+    : m_Device(std::move(device)) {
+}
+
+RayTracingScene::~RayTracingScene() {
+    Clear();
+}
+
+void RayTracingScene::Clear() {
+    if (m_Device) {
+        for (auto& [mesh, bottomLevel] : m_BottomLevels) {
+            m_Device->Retire(bottomLevel.structure);
+        }
+        if (m_TopLevel) {
+            m_Device->Retire(m_TopLevel);
+        }
+    }
+    m_BottomLevels.clear();
+    m_Untraceable.clear();
+    m_TopLevel.reset();
+    m_Instances.clear();
+    m_Stats = {};
+}
+
+RayTracingScene::BottomLevel* RayTracingScene::GetBottomLevel(const Mesh& mesh,
+                                                             std::vector<rhi::AccelerationStructureBuild>& builds) {
+    auto found = m_BottomLevels.find(&mesh);
+    if (found != m_BottomLevels.end()) {
+        return &found->second;
+    }
+    if (m_Untraceable.count(&mesh) != 0) {
+        return nullptr;
+    }
+
+    const Ref<rhi::Buffer>& vertexBuffer = mesh.GetVertexBuffer();
+    const Ref<rhi::Buffer>& indexBuffer = mesh.GetIndexBuffer();
+    bool inputs = vertexBuffer && indexBuffer &&
+                  (vertexBuffer->GetUsage() & rhi::BufferUsage::AccelerationStructureInput) != rhi::BufferUsage{} &&
+                  (indexBuffer->GetUsage() & rhi::BufferUsage::AccelerationStructureInput) != rhi::BufferUsage{};
+
+    Ref<rhi::AccelerationStructure> structure;
+    if (inputs) {
+        // Positions lead both vertex layouts; compact ones stay quantized, and the
+        // instance transform dequantizes them
+        uint32 stride = GetVertexStride(mesh.GetVertexFormat());
+        rhi::AccelerationStructureGeometry geometry;
+        geometry.vertexBuffer = vertexBuffer;
+        geometry.vertexOffset = static_cast<uint64>(mesh.GetVertexOffset()) * stride;
+        geometry.vertexStride = stride;
+        geometry.vertexCount = mesh.GetVertexCount();
+        geometry.vertexFormat = mesh.GetVertexFormat() == VertexFormat::Compact ? rhi::Format::R16G16B16A16_UNORM
+                                                                                : rhi::Format::R32G32B32_SFLOAT;
+        geometry.indexBuffer = indexBuffer;
+        geometry.indexOffset = static_cast<uint64>(mesh.GetFirstIndex()) * sizeof(uint32);
+        geometry.indexCount = mesh.GetIndexCount();
+
+        rhi::AccelerationStructureDesc desc;
+        desc.type = rhi::AccelerationStructureType::BottomLevel;
+        desc.flags = rhi::AccelerationStructureFlags::AllowCompaction;
+        desc.geometries.push_back(geometry);
+        desc.debugName = "MeshBLAS";
+        structure = m_Device->CreateAccelerationStructure(desc);
+    }
+    if (!structure) {
+        METAGFX_WARN << "RayTracingScene: mesh of " << mesh.GetVertexCount() << " vertices cannot be traced"
+                     << (inputs ? "" : " (buffers without AccelerationStructureInput usage)");
+        m_Untraceable.insert(&mesh);
+        return nullptr;
+    }
+
+    rhi::AccelerationStructureBuild build;
+    build.structure = structure.get();
+    builds.push_back(build);
+
+    BottomLevel& bottomLevel = m_BottomLevels[&mesh];
+    bottomLevel.structure = std::move(structure);
+    return &bottomLevel;
+}
+
+void RayTracingScene::CompactBottomLevels(rhi::CommandBuffer& cmd) {
+    for (auto& [mesh, bottomLevel] : m_BottomLevels) {
+        if (bottomLevel.compacted || !bottomLevel.structure->IsBuilt()) {
+            continue;
+        }
+        uint64 compactedSize = bottomLevel.structure->GetCompactedSize();
+        if (compactedSize == 0) {
+            continue;  // The build has not finished on the GPU yet
+        }
+
+        bottomLevel.compacted = true;
+        if (compactedSize >= bottomLevel.structure->GetSize()) {
+            continue;
+        }
+        Ref<rhi::AccelerationStructure> copy = cmd.CompactAccelerationStructure(bottomLevel.structure);
+        if (copy) {
+            // The last top level may still place the original in frames in flight
+            m_Device->Retire(bottomLevel.structure);
+            bottomLevel.structure = std::move(copy);
+        }
+    }
+}
+
+bool RayTracingScene::EnsureTopLevel(uint32 instanceCount) {
+    if (m_TopLevel && m_TopLevel->GetDesc().maxInstances >= instanceCount) {
+        return true;
+    }
+
+    // Grow in powers of two so a scene filling up recreates it rarely
+    uint32 capacity = 64;
+    while (capacity < instanceCount) {
+        capacity *= 2;
+    }
+
+    rhi::AccelerationStructureDesc desc;
+    desc.type = rhi::AccelerationStructureType::TopLevel;
+    desc.flags = rhi::AccelerationStructureFlags::AllowUpdate;
+    desc.maxInstances = capacity;
+    desc.debugName = "SceneTLAS";
+    Ref<rhi::AccelerationStructure> topLevel = m_Device->CreateAccelerationStructure(desc);
+    if (!topLevel) {
+        METAGFX_ERROR << "RayTracingScene: failed to create a top level for " << capacity << " instances";
+        return false;
+    }
+
+    if (m_TopLevel) {
+        m_Device->Retire(m_TopLevel);
+    }
+    m_TopLevel = std::move(topLevel);
+    m_Instances.clear();
+    return true;
+}
+
+void RayTracingScene::Update(rhi::CommandBuffer& cmd, const Scene& scene, const glm::mat4& modelMatrix) {
+    if (!IsSupported()) {
+        return;
+    }
+
+    // Compaction first: the copies are recorded before the top-level build that places
+    // them, and replace their originals in it
+    CompactBottomLevels(cmd);
+
+    m_Builds.clear();
+    m_NextInstances.clear();
+    for (uint32 i = 0; i < scene.GetMeshInstanceCount(); ++i) {
+        const MeshInstance& entry = scene.GetMeshInstance(i);
+        if (!entry.mesh) {
+            continue;
+        }
+        BottomLevel* bottomLevel = GetBottomLevel(*entry.mesh, m_Builds);
+        if (!bottomLevel) {
+            continue;
+        }
+
+        glm::mat4 transform = modelMatrix * entry.transform;
+        if (entry.mesh->GetVertexFormat() == VertexFormat::Compact) {
+            transform = transform * entry.mesh->GetQuantization().GetDequantizeMatrix();
+        }
+
+        rhi::AccelerationStructureInstance instance;
+        instance.bottomLevel = bottomLevel->structure.get();
+        for (int row = 0; row < 3; ++row) {
+            for (int column = 0; column < 4; ++column) {
+                instance.transform[row][column] = transform[column][row];  // glm is column-major
+            }
+        }
+        instance.instanceID = i;
+        m_NextInstances.push_back(instance);
+    }
+
+    if (m_NextInstances.empty()) {
+        // Nothing to trace; drop the top level rather than keep placing retired meshes
+        if (m_TopLevel) {
+            m_Device->Retire(m_TopLevel);
+            m_TopLevel.reset();
+        }
+        m_Instances.clear();
+    } else if (EnsureTopLevel(static_cast<uint32>(m_NextInstances.size()))) {
+        // Refit while the same bottom levels sit in the same slots; skip when nothing moved
+        bool sameLayout = m_TopLevel->IsBuilt() && m_Instances.size() == m_NextInstances.size();
+        bool moved = !sameLayout;
+        for (size_t i = 0; sameLayout && i < m_NextInstances.size(); ++i) {
+            const rhi::AccelerationStructureInstance& previous = m_Instances[i];
+            const rhi::AccelerationStructureInstance& next = m_NextInstances[i];
+            sameLayout = previous.bottomLevel == next.bottomLevel && previous.instanceID == next.instanceID;
+            moved = moved || std::memcmp(previous.transform, next.transform, sizeof(next.transform)) != 0;
+        }
+
+        if (!sameLayout || moved) {
+            rhi::AccelerationStructureBuild build;
+            build.structure = m_TopLevel.get();
+            build.update = sameLayout;
+            build.instances = m_NextInstances.data();
+            build.instanceCount = static_cast<uint32>(m_NextInstances.size());
+            m_Builds.push_back(build);
+
+            m_Instances.swap(m_NextInstances);
+            m_Stats.instances = build.instanceCount;
+            m_Stats.refit = build.update;
+        }
+    }
+    if (!m_Builds.empty()) {
+        cmd.BuildAccelerationStructures(m_Builds);
+    }
+
+    m_Stats.bottomLevels = static_cast<uint32>(m_BottomLevels.size());
+    m_Stats.compacted = 0;
+    m_Stats.bottomLevelBytes = 0;
+    for (const auto& [mesh, bottomLevel] : m_BottomLevels) {
+        m_Stats.compacted += bottomLevel.compacted ? 1 : 0;
+        m_Stats.bottomLevelBytes += bottomLevel.structure->GetSize();
+    }
+    m_Stats.topLevelBytes = m_TopLevel ? m_TopLevel->GetSize() : 0;
+}
+
+} // namespace metagfx
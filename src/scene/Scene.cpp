@@ -1,8 +1,13 @@
 #include "metagfx/scene/Scene.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Model.h"
 #include "metagfx/rhi/GraphicsDevice.h"
 #include "metagfx/rhi/Buffer.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/core/SimdMath.h"
 #include <algorithm>
+#include <cstring>
+#include <limits>
 
 namespace metagfx {
 
@@ -12,62 +17,475 @@ Scene::~Scene() {
     ClearLights();
 }
 
-Light* Scene::AddLight(std::unique_ptr<Light> light) {
-    if (m_Lights.size() >= MAX_LIGHTS) {
+std::unique_ptr<Model> Scene::SetModel(std::unique_ptr<Model> model) {
+    std::swap(m_Model, model);
+    return model;
+}
+
+template<typename T>
+Scene::LightHandle Scene::AddLightOfType(std::vector<T>& lights, std::vector<LightHandle>& handles, const T& light) {
+    if (GetLightCount() >= MAX_LIGHTS) {
         METAGFX_WARN << "Cannot add light: maximum of " << MAX_LIGHTS << " lights reached";
-        return nullptr;
+        return INVALID_LIGHT;
     }
 
-    Light* ptr = light.get();
-    m_Lights.push_back(std::move(light));
-    METAGFX_INFO << "Added light, total count: " << m_Lights.size();
-    return ptr;
+    LightHandle handle;
+    if (m_FreeLightSlots.empty()) {
+        handle = static_cast<LightHandle>(m_LightSlots.size());
+        m_LightSlots.emplace_back();
+    } else {
+        handle = m_FreeLightSlots.back();
+        m_FreeLightSlots.pop_back();
+    }
+
+    LightSlot& slot = m_LightSlots[handle];
+    slot.type = light.GetType();
+    slot.index = static_cast<uint32>(lights.size());
+    slot.used = true;
+    lights.push_back(light);
+    lights.back().m_Dirty = true;
+    handles.push_back(handle);
+
+    AABB bounds;
+    slot.proxy = GetLightBounds(light, bounds) ? m_BVH.Insert(bounds, LIGHT_FLAG | handle) : BVH::INVALID_PROXY;
+    m_LightsMoved = true;
+    METAGFX_DEBUG << "Added light, total count: " << GetLightCount();
+    return handle;
+}
+
+Scene::LightHandle Scene::AddLight(const DirectionalLight& light) {
+    return AddLightOfType(m_DirectionalLights, m_DirectionalHandles, light);
+}
+
+Scene::LightHandle Scene::AddLight(const PointLight& light) {
+    return AddLightOfType(m_PointLights, m_PointHandles, light);
+}
+
+Scene::LightHandle Scene::AddLight(const SpotLight& light) {
+    return AddLightOfType(m_SpotLights, m_SpotHandles, light);
+}
+
+// Swap-and-pop, keeping the type's array contiguous
+template<typename T>
+static void ErasePacked(std::vector<T>& lights, std::vector<uint32>& handles, uint32 index, uint32& outMovedHandle) {
+    uint32 last = static_cast<uint32>(lights.size()) - 1;
+    outMovedHandle = ~0u;
+    if (index != last) {
+        lights[index] = std::move(lights[last]);
+        handles[index] = handles[last];
+        outMovedHandle = handles[index];
+    }
+    lights.pop_back();
+    handles.pop_back();
 }
 
-void Scene::RemoveLight(Light* light) {
-    auto it = std::remove_if(m_Lights.begin(), m_Lights.end(),
-        [light](const std::unique_ptr<Light>& l) { return l.get() == light; });
+void Scene::RemoveLight(LightHandle light) {
+    if (light >= m_LightSlots.size() || !m_LightSlots[light].used) {
+        return;
+    }
 
-    if (it != m_Lights.end()) {
-        m_Lights.erase(it, m_Lights.end());
-        METAGFX_INFO << "Removed light, remaining count: " << m_Lights.size();
+    LightSlot& slot = m_LightSlots[light];
+    if (slot.proxy != BVH::INVALID_PROXY) {
+        m_BVH.Remove(slot.proxy);
+    }
+
+    uint32 moved;
+    switch (slot.type) {
+        case LightType::Directional: ErasePacked(m_DirectionalLights, m_DirectionalHandles, slot.index, moved); break;
+        case LightType::Point:       ErasePacked(m_PointLights, m_PointHandles, slot.index, moved); break;
+        case LightType::Spot:        ErasePacked(m_SpotLights, m_SpotHandles, slot.index, moved); break;
+    }
+    if (moved != ~0u) {
+        m_LightSlots[moved].index = slot.index;
     }
+
+    slot = LightSlot{};
+    m_FreeLightSlots.push_back(light);
+    m_LightsMoved = true;
+    METAGFX_DEBUG << "Removed light, remaining count: " << GetLightCount();
 }
 
 void Scene::ClearLights() {
-    m_Lights.clear();
+    for (const LightSlot& slot : m_LightSlots) {
+        if (slot.used && slot.proxy != BVH::INVALID_PROXY) {
+            m_BVH.Remove(slot.proxy);
+        }
+    }
+    m_DirectionalLights.clear();
+    m_PointLights.clear();
+    m_SpotLights.clear();
+    m_DirectionalHandles.clear();
+    m_PointHandles.clear();
+    m_SpotHandles.clear();
+    m_LightSlots.clear();
+    m_FreeLightSlots.clear();
+    m_LightsMoved = true;
+}
+
+const Light* Scene::FindLight(LightHandle light) const {
+    if (light >= m_LightSlots.size() || !m_LightSlots[light].used) {
+        return nullptr;
+    }
+    const LightSlot& slot = m_LightSlots[light];
+    switch (slot.type) {
+        case LightType::Directional: return &m_DirectionalLights[slot.index];
+        case LightType::Point:       return &m_PointLights[slot.index];
+        case LightType::Spot:        return &m_SpotLights[slot.index];
+    }
+    return nullptr;
+}
+
+uint32 Scene::GetGPULightIndex(LightHandle light) const {
+    if (light >= m_LightSlots.size() || !m_LightSlots[light].used) {
+        return INVALID_LIGHT;
+    }
+    const LightSlot& slot = m_LightSlots[light];
+    switch (slot.type) {
+        case LightType::Directional: return slot.index;
+        case LightType::Point:       return static_cast<uint32>(m_DirectionalLights.size()) + slot.index;
+        case LightType::Spot:        return static_cast<uint32>(m_DirectionalLights.size() + m_PointLights.size()) + slot.index;
+    }
+    return INVALID_LIGHT;
+}
+
+Light* Scene::GetLight(LightHandle light) {
+    return const_cast<Light*>(FindLight(light));
+}
+
+DirectionalLight* Scene::GetDirectionalLight(LightHandle light) {
+    Light* found = GetLight(light);
+    return found && found->GetType() == LightType::Directional ? static_cast<DirectionalLight*>(found) : nullptr;
+}
+
+PointLight* Scene::GetPointLight(LightHandle light) {
+    Light* found = GetLight(light);
+    return found && found->GetType() == LightType::Point ? static_cast<PointLight*>(found) : nullptr;
+}
+
+SpotLight* Scene::GetSpotLight(LightHandle light) {
+    Light* found = GetLight(light);
+    return found && found->GetType() == LightType::Spot ? static_cast<SpotLight*>(found) : nullptr;
 }
 
-void Scene::InitializeLightBuffer(rhi::GraphicsDevice* device) {
+void Scene::InitializeLightBuffer(rhi::GraphicsDevice* device, uint32 framesInFlight) {
     m_Device = device;
+    m_LightRegionCount = std::max(framesInFlight, 1u);
+    m_DirtyLightRanges.assign(m_LightRegionCount, LightRange{});
 
-    // Create light buffer (1040 bytes: count + padding + 16 lights)
+    // Create light buffer: header + a region of MAX_LIGHTS lights per frame in flight
     rhi::BufferDesc bufferDesc{};
-    bufferDesc.size = sizeof(LightBuffer);
-    bufferDesc.usage = rhi::BufferUsage::Uniform;
+    bufferDesc.size = sizeof(LightBufferHeader) + static_cast<uint64>(m_LightRegionCount) * MAX_LIGHTS * sizeof(LightData);
+    bufferDesc.usage = rhi::BufferUsage::Storage;
     bufferDesc.memoryUsage = rhi::MemoryUsage::CPUToGPU;
+    bufferDesc.debugName = "LightBuffer";
 
     m_LightBuffer = m_Device->CreateBuffer(bufferDesc);
+    m_MappedLights = m_LightBuffer ? static_cast<uint8*>(m_LightBuffer->GetMappedPointer()) : nullptr;
+    m_LightsMoved = true;
     METAGFX_INFO << "Light buffer created: " << bufferDesc.size << " bytes";
 }
 
-void Scene::UpdateLightBuffer() {
+// Converts the type's dirty lights (all of them when all is set) into the GPU copy at
+// base, refits their leaves and widens every region's pending range
+template<typename T>
+void Scene::UpdateLights(std::vector<T>& lights, const std::vector<LightHandle>& handles, uint32 base, bool all) {
+    for (uint32 i = 0; i < lights.size(); ++i) {
+        T& light = lights[i];
+        if (!all && !light.m_Dirty) {
+            continue;
+        }
+        m_GPULights[base + i] = light.ToGPUData();
+
+        AABB bounds;
+        uint32 proxy = m_LightSlots[handles[i]].proxy;
+        if (light.m_Dirty && proxy != BVH::INVALID_PROXY && GetLightBounds(light, bounds)) {
+            m_BVH.Update(proxy, bounds);
+        }
+        light.m_Dirty = false;
+
+        for (LightRange& range : m_DirtyLightRanges) {
+            range.begin = range.begin < range.end ? std::min(range.begin, base + i) : base + i;
+            range.end = std::max(range.end, base + i + 1);
+        }
+    }
+}
+
+void Scene::UpdateLightBuffer(uint32 frameIndex) {
     if (!m_LightBuffer) {
         METAGFX_WARN << "Light buffer not initialized";
         return;
     }
 
-    // Prepare buffer data
-    LightBuffer bufferData{};
-    bufferData.lightCount = static_cast<uint32>(m_Lights.size());
+    // Added or removed lights shift the GPU indices of others: convert everything. The
+    // header only changes then; frames in flight read their counts from frame constants.
+    uint32 pointBase = GetDirectionalLightCount();
+    uint32 spotBase = pointBase + static_cast<uint32>(m_PointLights.size());
+    bool all = m_LightsMoved;
+    if (all) {
+        m_GPULights.resize(GetLightCount());
+        for (LightRange& range : m_DirtyLightRanges) {
+            range = LightRange{};
+        }
+
+        LightBufferHeader header{};
+        header.lightCount = static_cast<uint32>(m_GPULights.size());
+        header.directionalCount = pointBase;
+        if (m_MappedLights) {
+            std::memcpy(m_MappedLights, &header, sizeof(header));
+        } else {
+            m_LightBuffer->CopyData(&header, sizeof(header));
+        }
+        m_LightsMoved = false;
+    }
+    UpdateLights(m_DirectionalLights, m_DirectionalHandles, 0, all);
+    UpdateLights(m_PointLights, m_PointHandles, pointBase, all);
+    UpdateLights(m_SpotLights, m_SpotHandles, spotBase, all);
+
+    // This frame's region catches up on what changed since it was last written
+    uint32 region = frameIndex % m_LightRegionCount;
+    LightRange& range = m_DirtyLightRanges[region];
+    if (range.begin < range.end) {
+        uint64 offset = sizeof(LightBufferHeader) + (static_cast<uint64>(region) * MAX_LIGHTS + range.begin) * sizeof(LightData);
+        uint64 size = static_cast<uint64>(range.end - range.begin) * sizeof(LightData);
+        if (m_MappedLights) {
+            std::memcpy(m_MappedLights + offset, m_GPULights.data() + range.begin, size);
+        } else {
+            m_LightBuffer->CopyData(m_GPULights.data() + range.begin, size, offset);
+        }
+    }
+    range = LightRange{};
+}
+
+// ----------------------------------------------------------------------------
+// Spatial index
+// ----------------------------------------------------------------------------
+
+bool Scene::GetLightBounds(const Light& light, AABB& outBounds) {
+    // Range spheres; a spot light's cone is conservatively its whole sphere
+    glm::vec3 position;
+    float range;
+    if (light.GetType() == LightType::Point) {
+        const auto& point = static_cast<const PointLight&>(light);
+        position = point.GetPosition();
+        range = point.GetRange();
+    } else if (light.GetType() == LightType::Spot) {
+        const auto& spot = static_cast<const SpotLight&>(light);
+        position = spot.GetPosition();
+        range = spot.GetRange();
+    } else {
+        return false;
+    }
+
+    outBounds.min = position - glm::vec3(range);
+    outBounds.max = position + glm::vec3(range);
+    return true;
+}
+
+AABB Scene::GetInstanceBounds(const MeshInstance& instance) {
+    AABB local;
+    local.min = instance.mesh->GetBoundsMin();
+    local.max = instance.mesh->GetBoundsMax();
+    return AABB::Transform(local, instance.transform);
+}
+
+uint32 Scene::AddMeshInstance(const Mesh* mesh, const glm::mat4& transform, uint32 userData) {
+    if (!mesh) {
+        return INVALID_INSTANCE;
+    }
+
+    uint32 instance;
+    if (m_FreeInstances.empty()) {
+        instance = static_cast<uint32>(m_Instances.size());
+        m_Instances.emplace_back();
+    } else {
+        instance = m_FreeInstances.back();
+        m_FreeInstances.pop_back();
+    }
+
+    MeshInstance& entry = m_Instances[instance];
+    entry.mesh = mesh;
+    entry.transform = transform;
+    entry.userData = userData;
+    entry.proxy = m_BVH.Insert(GetInstanceBounds(entry), instance);
+    return instance;
+}
+
+void Scene::SetMeshInstanceTransform(uint32 instance, const glm::mat4& transform) {
+    MeshInstance& entry = m_Instances[instance];
+    entry.transform = transform;
+    m_BVH.Update(entry.proxy, GetInstanceBounds(entry));
+}
+
+void Scene::SetMeshInstanceNode(uint32 instance, uint32 node) {
+    MeshInstance& entry = m_Instances[instance];
+    entry.node = node;
+    if (node != SceneGraph::INVALID_NODE) {
+        SetMeshInstanceTransform(instance, m_SceneGraph.GetWorldTransform(node));
+    }
+}
+
+bool Scene::UpdateTransforms() {
+    if (!m_SceneGraph.Update()) {
+        return false;
+    }
+
+    // Gather the moved instances, bound them in one batch, then refit their leaves
+    m_RefitInstances.clear();
+    m_RefitMatrices.clear();
+    m_RefitMins.clear();
+    m_RefitMaxs.clear();
+    uint32 nodeCount = m_SceneGraph.GetNodeCount();
+    for (uint32 instance = 0; instance < m_Instances.size(); ++instance) {
+        MeshInstance& entry = m_Instances[instance];
+        if (entry.mesh && entry.node < nodeCount && m_SceneGraph.WasUpdated(entry.node)) {
+            entry.transform = m_SceneGraph.GetWorldTransform(entry.node);
+            m_RefitInstances.push_back(instance);
+            m_RefitMatrices.push_back(entry.transform);
+            m_RefitMins.push_back(entry.mesh->GetBoundsMin());
+            m_RefitMaxs.push_back(entry.mesh->GetBoundsMax());
+        }
+    }
+
+    size_t count = m_RefitInstances.size();
+    simd::TransformBoxes(m_RefitMatrices.data(), m_RefitMins.data(), m_RefitMaxs.data(), count,
+                         m_RefitMins.data(), m_RefitMaxs.data());
+    for (size_t i = 0; i < count; ++i) {
+        m_BVH.Update(m_Instances[m_RefitInstances[i]].proxy, AABB{ m_RefitMins[i], m_RefitMaxs[i] });
+    }
+    return true;
+}
+
+void Scene::RemoveMeshInstance(uint32 instance) {
+    MeshInstance& entry = m_Instances[instance];
+    if (!entry.mesh) {
+        return;
+    }
+
+    m_BVH.Remove(entry.proxy);
+    entry = MeshInstance{};
+    m_FreeInstances.push_back(instance);
+}
+
+void Scene::ClearMeshInstances() {
+    for (uint32 instance = 0; instance < m_Instances.size(); ++instance) {
+        RemoveMeshInstance(instance);
+    }
+    m_Instances.clear();
+    m_FreeInstances.clear();
+}
+
+void Scene::QueryInstances(const Frustum& frustum, std::vector<uint32>& outInstances) const {
+    size_t first = outInstances.size();
+    m_BVH.QueryFrustum(frustum, outInstances);
+
+    // Proxies to instance ids, dropping lights
+    size_t count = first;
+    for (size_t i = first; i < outInstances.size(); ++i) {
+        uint32 userData = m_BVH.GetUserData(outInstances[i]);
+        if ((userData & LIGHT_FLAG) == 0) {
+            outInstances[count++] = userData;
+        }
+    }
+    outInstances.resize(count);
+}
+
+void Scene::QueryLights(const Frustum& frustum, std::vector<LightHandle>& outLights) const {
+    outLights.insert(outLights.end(), m_DirectionalHandles.begin(), m_DirectionalHandles.end());
+
+    // Local lights through the tree, skipping the instance leaves it also returns
+    std::vector<uint32> proxies;
+    m_BVH.QueryFrustum(frustum, proxies);
+    for (uint32 proxy : proxies) {
+        uint32 userData = m_BVH.GetUserData(proxy);
+        if (userData & LIGHT_FLAG) {
+            outLights.push_back(userData & ~LIGHT_FLAG);
+        }
+    }
+}
+
+void Scene::QueryShadowCasters(const Light& light, std::vector<uint32>& outInstances) const {
+    AABB bounds;
+    if (!GetLightBounds(light, bounds)) {
+        for (uint32 instance = 0; instance < m_Instances.size(); ++instance) {
+            if (m_Instances[instance].mesh) {
+                outInstances.push_back(instance);
+            }
+        }
+        return;
+    }
 
-    // Copy light data
-    for (size_t i = 0; i < m_Lights.size() && i < MAX_LIGHTS; i++) {
-        bufferData.lights[i] = m_Lights[i]->ToGPUData();
+    size_t first = outInstances.size();
+    m_BVH.QueryBox(bounds, outInstances);
+
+    size_t count = first;
+    for (size_t i = first; i < outInstances.size(); ++i) {
+        uint32 userData = m_BVH.GetUserData(outInstances[i]);
+        if ((userData & LIGHT_FLAG) == 0) {
+            outInstances[count++] = userData;
+        }
     }
+    outInstances.resize(count);
+}
+
+// Moller-Trumbore; returns the ray parameter of the hit, or a negative value
+static float IntersectTriangle(const glm::vec3& origin, const glm::vec3& direction,
+                               const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2) {
+    constexpr float EPSILON = 1e-8f;
+    glm::vec3 edge1 = v1 - v0;
+    glm::vec3 edge2 = v2 - v0;
+    glm::vec3 p = glm::cross(direction, edge2);
+    float determinant = glm::dot(edge1, p);
+    if (std::abs(determinant) < EPSILON) {
+        return -1.0f;
+    }
+
+    float inverseDeterminant = 1.0f / determinant;
+    glm::vec3 s = origin - v0;
+    float u = glm::dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f) {
+        return -1.0f;
+    }
+
+    glm::vec3 q = glm::cross(s, edge1);
+    float v = glm::dot(direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f) {
+        return -1.0f;
+    }
+    return glm::dot(edge2, q) * inverseDeterminant;
+}
+
+bool Scene::Pick(const glm::vec3& origin, const glm::vec3& direction, ScenePickResult& outResult) const {
+    bool hit = false;
+    m_BVH.QueryRay(origin, direction, std::numeric_limits<float>::max(), [&](uint32 proxy, float maxT) {
+        uint32 userData = m_BVH.GetUserData(proxy);
+        if (userData & LIGHT_FLAG) {
+            return maxT;
+        }
+
+        // Test the mesh's triangles in model space; an affine transform keeps the ray
+        // parameter, so distances compare across instances
+        const MeshInstance& instance = m_Instances[userData];
+        glm::mat4 worldToModel = glm::inverse(instance.transform);
+        glm::vec3 localOrigin = glm::vec3(worldToModel * glm::vec4(origin, 1.0f));
+        glm::vec3 localDirection = glm::vec3(worldToModel * glm::vec4(direction, 0.0f));
 
-    // Upload to GPU
-    m_LightBuffer->CopyData(&bufferData, sizeof(bufferData));
+        const Mesh& mesh = *instance.mesh;
+        uint32 triangleCount = mesh.GetCPUTriangleCount();
+        for (uint32 triangle = 0; triangle < triangleCount; ++triangle) {
+            glm::vec3 a, b, c;
+            mesh.GetCPUTriangle(triangle, a, b, c);
+            float t = IntersectTriangle(localOrigin, localDirection, a, b, c);
+            if (t >= 0.0f && t < maxT) {
+                maxT = t;
+                outResult.instance = userData;
+                outResult.distance = t;
+                outResult.position = origin + direction * t;
+                hit = true;
+            }
+        }
+        return maxT;
+    });
+    return hit;
 }
 
 } // namespace metagfx
@@ -0,0 +1,193 @@
+// ============================================================================
+// src/scene/SceneDescription.cpp
+// ============================================================================
+#include "metagfx/scene/SceneDescription.h"
+#include "metagfx/utils/Json.h"
+#include "metagfx/utils/MappedFile.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace metagfx {
+
+namespace {
+
+bool ReadVector(const utils::JsonValue& value, glm::vec3& out) {
+    if (value.Size() != 3 || !value[0].IsNumber() || !value[1].IsNumber() || !value[2].IsNumber()) {
+        return false;
+    }
+    out = glm::vec3(value[0].AsFloat(), value[1].AsFloat(), value[2].AsFloat());
+    return true;
+}
+
+// Absolute paths stay; relative ones are the scene file's
+std::string ResolvePath(const std::string& scenePath, const std::string& path) {
+    std::filesystem::path resolved(path);
+    if (resolved.is_relative()) {
+        resolved = std::filesystem::path(scenePath).parent_path() / resolved;
+    }
+    return resolved.lexically_normal().string();
+}
+
+glm::mat4 ReadInstance(const utils::JsonValue& instance) {
+    glm::vec3 translation(0.0f), rotation(0.0f), scale(1.0f);
+    ReadVector(instance["translation"], translation);
+    ReadVector(instance["rotation"], rotation);
+    if (instance["scale"].IsNumber()) {
+        scale = glm::vec3(instance["scale"].AsFloat(1.0f));
+    } else {
+        ReadVector(instance["scale"], scale);
+    }
+
+    glm::mat4 transform = glm::translate(glm::mat4(1.0f), translation);
+    transform = glm::rotate(transform, glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f));
+    transform = glm::rotate(transform, glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f));
+    transform = glm::rotate(transform, glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f));
+    return glm::scale(transform, scale);
+}
+
+bool ReadLight(const utils::JsonValue& light, SceneDescription::LightDesc& out, std::string& error) {
+    const std::string& type = light["type"].AsString();
+    if (type == "directional") {
+        out.type = LightType::Directional;
+    } else if (type == "point") {
+        out.type = LightType::Point;
+    } else if (type == "spot") {
+        out.type = LightType::Spot;
+    } else {
+        error = "unknown light type '" + type + "'";
+        return false;
+    }
+
+    if (out.type != LightType::Directional && !ReadVector(light["position"], out.position)) {
+        error = type + " light without a position";
+        return false;
+    }
+    if (out.type != LightType::Point && !ReadVector(light["direction"], out.direction)) {
+        error = type + " light without a direction";
+        return false;
+    }
+    if (glm::dot(out.direction, out.direction) < 1e-8f) {
+        error = type + " light with a zero direction";
+        return false;
+    }
+    ReadVector(light["color"], out.color);
+    out.intensity = std::max(0.0f, light["intensity"].AsFloat(out.intensity));
+    out.range = std::max(0.01f, light["range"].AsFloat(out.range));
+    out.innerCone = std::clamp(light["innerCone"].AsFloat(out.innerCone), 0.0f, 89.0f);
+    out.outerCone = std::clamp(light["outerCone"].AsFloat(out.outerCone), out.innerCone, 89.0f);
+    out.castsShadows = light["shadows"].AsBool(false);
+    return true;
+}
+
+bool ReadCameraKey(const utils::JsonValue& key, SceneDescription::CameraKey& out) {
+    if (!ReadVector(key["position"], out.position)) {
+        return false;
+    }
+    out.hasTarget = ReadVector(key["target"], out.target);
+    out.fov = std::clamp(key["fov"].AsFloat(45.0f), 1.0f, 170.0f);
+    return true;
+}
+
+} // anonymous namespace
+
+bool SceneDescription::ParseCameraKeys(const utils::JsonValue& keys, const char* prefix,
+                                       std::vector<CameraKey>& out, std::string* error) {
+    for (size_t i = 0; i < keys.Size(); ++i) {
+        const utils::JsonValue& key = keys[i];
+        CameraKey cameraKey;
+        if (!ReadCameraKey(key, cameraKey)) {
+            if (error) {
+                *error = "camera key " + std::to_string(i) + " has no position";
+            }
+            return false;
+        }
+        if (key["name"].IsString() && !key["name"].AsString().empty()) {
+            cameraKey.name = key["name"].AsString();
+        } else {
+            char name[64];
+            std::snprintf(name, sizeof(name), "%s_%04zu", prefix, i);
+            cameraKey.name = name;
+        }
+        out.push_back(std::move(cameraKey));
+    }
+    return true;
+}
+
+bool SceneDescription::Load(const std::string& path, SceneDescription& out, std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) {
+            *error = message;
+        }
+        return false;
+    };
+
+    utils::MappedFile file;  // Asset archives included
+    if (!file.Open(path)) {
+        return fail("cannot open " + path);
+    }
+    utils::JsonValue root;
+    std::string parseError;
+    if (!utils::JsonValue::Parse(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), root, &parseError)) {
+        return fail(parseError);
+    }
+    if (!root.IsObject()) {
+        return fail("the scene is not a JSON object");
+    }
+
+    out = SceneDescription{};
+    out.filePath = path;
+    if (root["model"].IsString() && !root["model"].AsString().empty()) {
+        out.modelPath = ResolvePath(path, root["model"].AsString());
+    }
+    const utils::JsonValue& instances = root["instances"];
+    for (size_t i = 0; i < instances.Size(); ++i) {
+        out.instances.push_back(ReadInstance(instances[i]));
+    }
+
+    out.hasLights = root["lights"].IsArray();
+    const utils::JsonValue& lights = root["lights"];
+    for (size_t i = 0; i < lights.Size(); ++i) {
+        LightDesc light;
+        std::string lightError;
+        if (!ReadLight(lights[i], light, lightError)) {
+            return fail("light " + std::to_string(i) + ": " + lightError);
+        }
+        out.lights.push_back(light);
+    }
+
+    if (root["environment"].IsString() && !root["environment"].AsString().empty()) {
+        out.environmentPath = ResolvePath(path, root["environment"].AsString());
+    }
+    out.ground = root["ground"].AsBool(true);
+
+    if (root.Has("camera")) {
+        if (!ReadCameraKey(root["camera"], out.camera)) {
+            return fail("the camera has no position");
+        }
+        out.hasCamera = true;
+    }
+    std::string keyError;
+    if (!ParseCameraKeys(root["cameraPath"], "path", out.cameraPath, &keyError)) {
+        return fail(keyError);
+    }
+
+    const utils::JsonValue& cells = root["cells"];
+    for (size_t i = 0; i < cells.Size(); ++i) {
+        const utils::JsonValue& cell = cells[i];
+        CellDesc desc;
+        if (!cell["model"].IsString() || cell["model"].AsString().empty()) {
+            return fail("cell " + std::to_string(i) + " has no model");
+        }
+        if (!ReadVector(cell["min"], desc.boundsMin) || !ReadVector(cell["max"], desc.boundsMax)) {
+            return fail("cell " + std::to_string(i) + " has no bounds");
+        }
+        desc.modelPath = ResolvePath(path, cell["model"].AsString());
+        out.cells.push_back(std::move(desc));
+    }
+    return true;
+}
+
+} // namespace metagfx
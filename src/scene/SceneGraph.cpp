@@ -0,0 +1,120 @@
+// ============================================================================
+// src/scene/SceneGraph.cpp
+// ============================================================================
+#include "metagfx/scene/SceneGraph.h"
+#include "metagfx/core/JobSystem.h"
+
+#include <mutex>
+
+namespace metagfx {
+
+uint32 SceneGraph::AddNode(const glm::mat4& localTransform, uint32 parent) {
+    uint32 node = GetNodeCount();
+    if (parent != INVALID_NODE && parent >= node) {
+        parent = INVALID_NODE;  // Parents must precede children
+    }
+
+    // Usable before the next Update() unless an ancestor has a pending change
+    m_Local.push_back(localTransform);
+    m_World.push_back(parent == INVALID_NODE ? localTransform : m_World[parent] * localTransform);
+    m_Parent.push_back(parent);
+    m_FirstChild.push_back(INVALID_NODE);
+    m_NextSibling.push_back(INVALID_NODE);
+    m_Dirty.push_back(1);
+    m_UpdatedFlags.push_back(0);
+    m_DirtyNodes.push_back(node);
+
+    if (parent != INVALID_NODE) {
+        m_NextSibling[node] = m_FirstChild[parent];
+        m_FirstChild[parent] = node;
+    }
+    return node;
+}
+
+void SceneGraph::Clear() {
+    m_Local.clear();
+    m_World.clear();
+    m_Parent.clear();
+    m_FirstChild.clear();
+    m_NextSibling.clear();
+    m_Dirty.clear();
+    m_UpdatedFlags.clear();
+    m_DirtyNodes.clear();
+    m_Updated.clear();
+}
+
+void SceneGraph::SetLocalTransform(uint32 node, const glm::mat4& localTransform) {
+    m_Local[node] = localTransform;
+    if (!m_Dirty[node]) {
+        m_Dirty[node] = 1;
+        m_DirtyNodes.push_back(node);
+    }
+}
+
+void SceneGraph::PropagateSubtree(uint32 root, std::vector<uint32>& outUpdated) {
+    std::vector<uint32> stack;
+    stack.push_back(root);
+    while (!stack.empty()) {
+        uint32 node = stack.back();
+        stack.pop_back();
+
+        uint32 parent = m_Parent[node];
+        m_World[node] = parent == INVALID_NODE ? m_Local[node] : m_World[parent] * m_Local[node];
+        m_UpdatedFlags[node] = 1;
+        outUpdated.push_back(node);
+
+        for (uint32 child = m_FirstChild[node]; child != INVALID_NODE; child = m_NextSibling[child]) {
+            stack.push_back(child);
+        }
+    }
+}
+
+bool SceneGraph::Update() {
+    for (uint32 node : m_Updated) {
+        m_UpdatedFlags[node] = 0;
+    }
+    m_Updated.clear();
+
+    if (m_DirtyNodes.empty()) {
+        return false;
+    }
+
+    // A marked node below another marked node is covered by that node's subtree
+    std::vector<uint32> roots;
+    for (uint32 node : m_DirtyNodes) {
+        bool covered = false;
+        for (uint32 ancestor = m_Parent[node]; ancestor != INVALID_NODE; ancestor = m_Parent[ancestor]) {
+            if (m_Dirty[ancestor]) {
+                covered = true;
+                break;
+            }
+        }
+        if (!covered) {
+            roots.push_back(node);
+        }
+    }
+    for (uint32 node : m_DirtyNodes) {
+        m_Dirty[node] = 0;
+    }
+    m_DirtyNodes.clear();
+
+    // Subtrees are disjoint, so jobs write disjoint world matrices
+    if (JobSystem::GetWorkerCount() > 0 && roots.size() > 1 && GetNodeCount() >= PARALLEL_THRESHOLD) {
+        std::mutex updatedMutex;
+        JobSystem::ParallelFor(static_cast<uint32>(roots.size()), 1, [&](uint32 begin, uint32 end) {
+            std::vector<uint32> updated;
+            for (uint32 i = begin; i < end; ++i) {
+                PropagateSubtree(roots[i], updated);
+            }
+            std::lock_guard<std::mutex> lock(updatedMutex);
+            m_Updated.insert(m_Updated.end(), updated.begin(), updated.end());
+        });
+    } else {
+        for (uint32 root : roots) {
+            PropagateSubtree(root, m_Updated);
+        }
+    }
+    return true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,267 @@
+// ============================================================================
+// src/scene/ScreenSpaceReflections.cpp
+// ============================================================================
+#include "metagfx/scene/ScreenSpaceReflections.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Must match local_size_x/y of ssr.comp
+constexpr uint32 SSR_GROUP_SIZE = 8;
+
+// Radiance and confidence as two packHalf2x16, then the view depth, for the histories
+constexpr rhi::Format SSR_HISTORY_FORMAT = rhi::Format::R32G32B32A32_UINT;
+constexpr rhi::Format SSR_COLOR_FORMAT = rhi::Format::R16G16B16A16_SFLOAT;
+
+// std140 uniforms of ssr.comp
+struct ReflectionUniforms {
+    glm::mat4 view;
+    glm::mat4 reprojection;  // This frame's view space to the last frame's
+    glm::vec4 unproject;     // 1 / P00, 1 / P11, P20 - P30, P21 - P31 of the projection P
+    glm::vec4 depthParams;   // P22, P32, P23, P33
+    glm::uvec2 size;         // Of the depth drawn, its top-left region
+    uint32 frame;            // Draws the ray samples; 0 without temporal accumulation
+    uint32 minDepthOffset;   // Of the pyramid's min-depth chain
+    float maxRoughness;
+    float historyWeight;     // 0 without a history
+    uint32 colorValid;       // The color history holds the last frame's lit color
+    uint32 padding;
+};
+
+// Push constants of ssr.comp
+struct ReflectionPushConstants {
+    uint32 pass;  // 0 = trace, 1 = resolve, 2 = capture
+    uint32 padding[3];
+};
+
+ScreenSpaceReflections::ScreenSpaceReflections(Ref<rhi::GraphicsDevice> device, rhi::UniformRingBuffer& uniforms,
+                                               Ref<rhi::Shader> shader)
+    : m_Device(device)
+    , m_Uniforms(uniforms) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+    samplerDesc.minFilter = Filter::Linear;
+    samplerDesc.magFilter = Filter::Linear;
+    m_LinearSampler = device->CreateSampler(samplerDesc);
+
+    // The textures come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Compute, nullptr, nullptr, nullptr, sizeof(ReflectionUniforms) },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },   // Depth
+        { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },   // G-buffer
+        { 3, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },           // Depth pyramid
+        { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_LinearSampler },  // Color history
+        { 5, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },          // Half resolution
+        { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },          // History read
+        { 7, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },          // History written
+        { 8, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },          // Output
+        { 9, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_LinearSampler },  // Lit color
+        { 10, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }          // Color capture
+    };
+    layoutDesc.debugName = "ScreenSpaceReflectionsLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(ReflectionPushConstants);
+    pipelineDesc.debugName = "ScreenSpaceReflectionsPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Screen-space reflections unavailable: failed to create their pipeline";
+        return;
+    }
+    METAGFX_INFO << "Screen-space reflections created: half-resolution hierarchical-Z trace";
+}
+
+void ScreenSpaceReflections::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (!IsValid() || width == 0 || height == 0 ||
+        (m_History[0] && m_History[0]->GetWidth() == width && m_History[0]->GetHeight() == height)) {
+        return;
+    }
+
+    if (m_History[0]) {
+        m_Device->Retire(m_HalfResolution);
+        m_Device->Retire(m_History[0]);
+        m_Device->Retire(m_History[1]);
+        m_Device->Retire(m_ColorHistory);
+    }
+    // The next SetSources() binds the new textures
+    for (Ref<DescriptorSet>& descriptorSet : m_DescriptorSets) {
+        m_Device->Retire(descriptorSet);
+        descriptorSet.reset();
+    }
+
+    // Storage only but the color history, which the trace filters
+    TextureDesc textureDesc{};
+    textureDesc.width = std::max(1u, (width + 1) / 2);
+    textureDesc.height = std::max(1u, (height + 1) / 2);
+    textureDesc.format = OUTPUT_FORMAT;
+    textureDesc.usage = TextureUsage::Storage;
+    textureDesc.debugName = "ReflectionsHalf";
+    m_HalfResolution = m_Device->CreateTexture(textureDesc);
+
+    textureDesc.format = SSR_COLOR_FORMAT;
+    textureDesc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    textureDesc.debugName = "ReflectionsColorHistory";
+    m_ColorHistory = m_Device->CreateTexture(textureDesc);
+
+    textureDesc.width = width;
+    textureDesc.height = height;
+    textureDesc.format = SSR_HISTORY_FORMAT;
+    textureDesc.usage = TextureUsage::Storage;
+    textureDesc.debugName = "ReflectionsHistory0";
+    m_History[0] = m_Device->CreateTexture(textureDesc);
+    textureDesc.debugName = "ReflectionsHistory1";
+    m_History[1] = m_Device->CreateTexture(textureDesc);
+    if (!m_HalfResolution || !m_ColorHistory || !m_History[0] || !m_History[1]) {
+        METAGFX_ERROR << "Screen-space reflections: failed to create their textures";
+    }
+    m_HistoryValid = false;
+    m_ColorValid = false;
+}
+
+void ScreenSpaceReflections::SetSources(Ref<rhi::Texture> depth, Ref<rhi::Texture> gbuffer, Ref<rhi::Buffer> pyramid,
+                                        Ref<rhi::Texture> litColor, Ref<rhi::Texture> output) {
+    using namespace rhi;
+
+    if (m_DescriptorSets[0] && depth == m_Depth && gbuffer == m_GBuffer && pyramid == m_Pyramid &&
+        litColor == m_LitColor && output == m_Output) {
+        return;
+    }
+
+    m_Depth = depth;
+    m_GBuffer = gbuffer;
+    m_Pyramid = pyramid;
+    m_LitColor = litColor;
+    m_Output = output;
+    for (Ref<DescriptorSet>& descriptorSet : m_DescriptorSets) {
+        m_Device->Retire(descriptorSet);
+        descriptorSet.reset();
+    }
+    if (!IsValid() || !m_Depth || !m_GBuffer || !m_Pyramid || !m_LitColor || !m_Output) {
+        return;
+    }
+
+    Resize(m_Depth->GetWidth(), m_Depth->GetHeight());
+    if (!m_HalfResolution || !m_ColorHistory || !m_History[0] || !m_History[1]) {
+        return;
+    }
+
+    for (uint32 i = 0; i < 2; ++i) {
+        DescriptorSetDesc desc;
+        desc.bindings = {
+            { 0, DescriptorType::UniformBufferDynamic, ShaderStage::Compute, m_Uniforms.GetBuffer(), nullptr, nullptr, sizeof(ReflectionUniforms) },
+            { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_Depth, m_PointSampler },
+            { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_GBuffer, m_PointSampler },
+            { 3, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Pyramid, nullptr, nullptr },
+            { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_ColorHistory, m_LinearSampler },
+            { 5, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_HalfResolution, nullptr },
+            { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[1 - i], nullptr },
+            { 7, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[i], nullptr },
+            { 8, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Output, nullptr },
+            { 9, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_LitColor, m_LinearSampler },
+            { 10, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_ColorHistory, nullptr }
+        };
+        desc.debugName = i == 0 ? "ScreenSpaceReflectionsDescriptorSet0" : "ScreenSpaceReflectionsDescriptorSet1";
+        m_DescriptorSets[i] = m_Device->CreateDescriptorSet(desc);
+    }
+}
+
+void ScreenSpaceReflections::Trace(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& view,
+                                   const glm::mat4& projection, const glm::mat4& reprojection, uint32 minDepthOffset,
+                                   bool temporal, uint32 width, uint32 height) {
+    using namespace rhi;
+
+    const Ref<DescriptorSet>& descriptorSet = m_DescriptorSets[m_Current];
+    if (!descriptorSet) {
+        return;
+    }
+
+    ReflectionUniforms uniforms{};
+    uniforms.view = view;
+    uniforms.reprojection = reprojection;
+    uniforms.unproject = glm::vec4(1.0f / projection[0][0], 1.0f / projection[1][1],
+                                   projection[2][0] - projection[3][0], projection[2][1] - projection[3][1]);
+    uniforms.depthParams = glm::vec4(projection[2][2], projection[3][2], projection[2][3], projection[3][3]);
+    uniforms.size = glm::uvec2(m_Depth->GetWidth(), m_Depth->GetHeight());
+    if (width > 0 && height > 0) {
+        uniforms.size = glm::uvec2(std::min(width, uniforms.size.x), std::min(height, uniforms.size.y));
+    }
+    uniforms.minDepthOffset = minDepthOffset;
+    uniforms.maxRoughness = std::clamp(m_Settings.maxRoughness, 0.05f, 1.0f);
+
+    // Histories of another region size are of another image scale
+    if (uniforms.size != m_HistorySize) {
+        m_HistoryValid = false;
+        m_ColorValid = false;
+    }
+    if (temporal) {
+        uniforms.frame = ++m_FrameCounter;
+        uniforms.historyWeight = m_HistoryValid ? std::clamp(m_Settings.historyWeight, 0.0f, 0.98f) : 0.0f;
+    }
+    uniforms.colorValid = m_ColorValid ? 1u : 0u;
+    m_UniformOffset = m_Uniforms.Push(uniforms);
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, descriptorSet, frameIndex, &m_UniformOffset, 1);
+
+    // The half-resolution texture and the histories are not in the frame's graph: the
+    // last frame's passes wrote and read them
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    ReflectionPushConstants push{};
+    push.pass = 0;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    uint32 halfWidth = (uniforms.size.x + 1) / 2;
+    uint32 halfHeight = (uniforms.size.y + 1) / 2;
+    cmd.Dispatch((halfWidth + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE, (halfHeight + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE);
+
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 1;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch((uniforms.size.x + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE,
+                 (uniforms.size.y + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE);
+
+    m_Current = 1 - m_Current;
+    m_HistorySize = uniforms.size;
+    m_HistoryValid = temporal;
+}
+
+void ScreenSpaceReflections::CaptureColor(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    using namespace rhi;
+
+    // The set Trace() bound, before it flipped the histories
+    const Ref<DescriptorSet>& descriptorSet = m_DescriptorSets[1 - m_Current];
+    if (!descriptorSet || m_HistorySize.x == 0) {
+        return;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, descriptorSet, frameIndex, &m_UniformOffset, 1);
+    ReflectionPushConstants push{};
+    push.pass = 2;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    uint32 halfWidth = (m_HistorySize.x + 1) / 2;
+    uint32 halfHeight = (m_HistorySize.y + 1) / 2;
+    cmd.Dispatch((halfWidth + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE, (halfHeight + SSR_GROUP_SIZE - 1) / SSR_GROUP_SIZE);
+
+    m_ColorValid = true;
+}
+
+} // namespace metagfx
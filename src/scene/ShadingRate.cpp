@@ -0,0 +1,157 @@
+// ============================================================================
+// src/scene/ShadingRate.cpp
+// ============================================================================
+#include "metagfx/scene/ShadingRate.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Push constants of shading_rate.comp
+struct ShadingRatePushConstants {
+    glm::mat4 reprojection;   // This frame's (jittered) NDC to the last frame's clip space
+    glm::uvec2 region;        // Of the render target drawn, its top-left region
+    glm::uvec2 colorRegion;   // Of the scene color, standing for the same image
+    uint32 texelSize;         // Pixels per side of a rate texel
+    uint32 motion;            // The depth and motion vectors are bound
+    float contrastThreshold;
+    float motionThreshold;
+};
+
+ShadingRate::ShadingRate(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    const DeviceInfo& info = device->GetDeviceInfo();
+    if (!info.supportsShadingRateImage || info.shadingRateTexelSize == 0) {
+        METAGFX_INFO << "Variable rate shading unavailable: the device takes no shading rate image";
+        return;
+    }
+    m_TexelSize = info.shadingRateTexelSize;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The textures come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 4, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "ShadingRateLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(ShadingRatePushConstants);
+    pipelineDesc.debugName = "ShadingRatePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Variable rate shading unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Shading rate image created: " << m_TexelSize << "x" << m_TexelSize << " pixel tiles";
+}
+
+void ShadingRate::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (!IsValid() || (width == m_Width && height == m_Height && m_Rates)) {
+        return;
+    }
+    m_Width = width;
+    m_Height = height;
+
+    if (m_Rates) {
+        m_Device->Retire(m_Rates);
+        m_Device->Retire(m_DescriptorSet);
+        m_DescriptorSet.reset();
+    }
+
+    // Rests in GENERAL like every storage texture; the main pass's barrier takes it to
+    // its attachment layout and back
+    TextureDesc rateDesc{};
+    rateDesc.width = std::max(1u, (width + m_TexelSize - 1) / m_TexelSize);
+    rateDesc.height = std::max(1u, (height + m_TexelSize - 1) / m_TexelSize);
+    rateDesc.format = RATE_FORMAT;
+    rateDesc.usage = TextureUsage::Storage | TextureUsage::ShadingRate;
+    rateDesc.debugName = "ShadingRateImage";
+    m_Rates = m_Device->CreateTexture(rateDesc);
+    if (!m_Rates) {
+        METAGFX_ERROR << "Variable rate shading: failed to create its rate image";
+    }
+    m_HasRates = false;
+}
+
+void ShadingRate::SetSources(Ref<rhi::Texture> sceneColor, Ref<rhi::Texture> sceneDepth,
+                             Ref<rhi::Texture> motionVectors, Ref<rhi::Texture> motionDepth) {
+    using namespace rhi;
+
+    Ref<Texture> sources[4] = { sceneColor, sceneDepth, motionVectors, motionDepth };
+    if (m_DescriptorSet && std::equal(std::begin(sources), std::end(sources), std::begin(m_Sources))) {
+        return;
+    }
+
+    std::copy(std::begin(sources), std::end(sources), std::begin(m_Sources));
+    if (m_DescriptorSet) {
+        m_Device->Retire(m_DescriptorSet);
+        m_DescriptorSet.reset();
+    }
+    if (!IsValid() || !m_Rates || !sceneColor) {
+        return;
+    }
+
+    // Without motion the scene color stands in for the textures the shader then skips
+    bool motion = sceneDepth && motionVectors && motionDepth;
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, sceneColor, m_PointSampler },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motion ? sceneDepth : sceneColor, m_PointSampler },
+        { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motion ? motionVectors : sceneColor, m_PointSampler },
+        { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motion ? motionDepth : sceneColor, m_PointSampler },
+        { 4, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Rates, nullptr }
+    };
+    desc.debugName = "ShadingRateDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void ShadingRate::Generate(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& reprojection,
+                           const glm::uvec2& region, const glm::uvec2& colorRegion) {
+    using namespace rhi;
+
+    if (!m_DescriptorSet) {
+        return;
+    }
+
+    ShadingRatePushConstants push{};
+    push.reprojection = reprojection;
+    push.region = glm::uvec2(std::min(region.x, m_Width), std::min(region.y, m_Height));
+    push.colorRegion = colorRegion;
+    push.texelSize = m_TexelSize;
+    push.motion = m_Sources[1] && m_Sources[2] && m_Sources[3] ? 1 : 0;
+    push.contrastThreshold = std::max(m_Settings.contrastThreshold, 0.0f);
+    push.motionThreshold = std::max(m_Settings.motionThreshold, 0.0f);
+
+    // One work group per rate texel
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(m_Rates->GetWidth(), m_Rates->GetHeight());
+    m_HasRates = true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,465 @@
+// ============================================================================
+// src/scene/ShadowAtlas.cpp
+// ============================================================================
+#include "metagfx/scene/ShadowAtlas.h"
+#include "metagfx/scene/Camera.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/core/Logger.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <cmath>
+#include <cstring>
+
+namespace metagfx {
+
+namespace {
+
+// Near plane of the face projections; casters closer to the light are clipped
+constexpr float FACE_NEAR = 0.05f;
+
+// Update() calls a light out of view keeps its tiles for, unless they are needed
+constexpr uint64 RELEASE_DELAY = 120;
+
+// vec4s of a frame's region
+constexpr uint32 LIGHT_MAP_VEC4S = Scene::MAX_LIGHTS / 4;
+constexpr uint32 REGION_VEC4S = LIGHT_MAP_VEC4S + ShadowAtlas::MAX_FACES * ShadowAtlas::FACE_VEC4S;
+
+// Vulkan-style perspective projection with [0, 1] depth and no Y flip, like the
+// cascades: view-space z in [-far, -near] maps to NDC z in [0, 1]
+glm::mat4 FacePerspective(float tanHalfFov, float farPlane) {
+    glm::mat4 projection(0.0f);
+    projection[0][0] = 1.0f / tanHalfFov;
+    projection[1][1] = 1.0f / tanHalfFov;
+    projection[2][2] = farPlane / (FACE_NEAR - farPlane);
+    projection[2][3] = -1.0f;
+    projection[3][2] = -(farPlane * FACE_NEAR) / (farPlane - FACE_NEAR);
+    return projection;
+}
+
+// A light map entry of no faces: NO_FACE's bits
+glm::vec4 NoFaces() {
+    float noFace;
+    std::memcpy(&noFace, &ShadowAtlas::NO_FACE, sizeof(noFace));
+    return glm::vec4(noFace);
+}
+
+} // namespace
+
+ShadowAtlas::ShadowAtlas(Ref<rhi::GraphicsDevice> device, uint32 size, uint32 framesInFlight, rhi::Format depthFormat)
+    : m_Size(std::max(size / MAX_TILE_SIZE, 1u) * MAX_TILE_SIZE)
+    , m_FramesInFlight(std::max(framesInFlight, 1u)) {
+    using namespace rhi;
+
+    METAGFX_INFO << "Creating shadow atlas: " << m_Size << "x" << m_Size;
+
+    TextureDesc depthDesc{};
+    depthDesc.type = TextureType::Texture2D;
+    depthDesc.width = m_Size;
+    depthDesc.height = m_Size;
+    depthDesc.format = depthFormat;
+    depthDesc.usage = TextureUsage::DepthStencilAttachment | TextureUsage::Sampled;
+    depthDesc.mipLevels = 1;
+    depthDesc.arrayLayers = 1;
+    depthDesc.debugName = "ShadowAtlas_Depth";
+    m_DepthTexture = device->CreateTexture(depthDesc);
+
+    // Comparison sampler for PCF, like the cascades'
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Linear;
+    samplerDesc.magFilter = Filter::Linear;
+    samplerDesc.mipmapMode = Filter::Linear;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    samplerDesc.enableCompare = true;
+    samplerDesc.compareOp = CompareOp::LessOrEqual;
+    m_Sampler = device->CreateSampler(samplerDesc);
+
+    BufferDesc desc{};
+    desc.size = static_cast<uint64>(REGION_VEC4S) * m_FramesInFlight * sizeof(glm::vec4);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "ShadowAtlas";
+    m_Buffer = device->CreateBuffer(desc);
+    if (!m_Buffer) {
+        METAGFX_ERROR << "ShadowAtlas: failed to create " << desc.size << " byte buffer";
+        return;
+    }
+    m_MappedData = static_cast<glm::vec4*>(m_Buffer->GetMappedPointer());
+
+    // No shadowed lights in any region until the first Upload() of each
+    m_Region.assign(static_cast<size_t>(REGION_VEC4S) * m_FramesInFlight, NoFaces());
+    if (m_MappedData) {
+        std::memcpy(m_MappedData, m_Region.data(), m_Region.size() * sizeof(glm::vec4));
+    } else {
+        m_Buffer->CopyData(m_Region.data(), m_Region.size() * sizeof(glm::vec4));
+    }
+    m_Region.resize(REGION_VEC4S);
+
+    Clear();
+}
+
+void ShadowAtlas::Clear() {
+    m_Entries.clear();
+    m_RenderQueue.clear();
+    for (std::vector<Tile>& freeTiles : m_FreeTiles) {
+        freeTiles.clear();
+    }
+    for (uint32 y = 0; y < m_Size; y += MAX_TILE_SIZE) {
+        for (uint32 x = 0; x < m_Size; x += MAX_TILE_SIZE) {
+            m_FreeTiles[0].push_back({ x, y, 0 });
+        }
+    }
+    m_FaceCount = 0;
+    m_StaleFaces = 0;
+    m_Occupancy = 0.0f;
+}
+
+bool ShadowAtlas::AllocateTile(uint32 level, Tile& outTile) {
+    // Smallest free block at least as large, split down to the level; the other three
+    // quarters of each split become free blocks of the level below
+    uint32 source = level + 1;
+    while (source > 0 && m_FreeTiles[source - 1].empty()) {
+        --source;
+    }
+    if (source == 0) {
+        return false;
+    }
+    --source;
+
+    Tile tile = m_FreeTiles[source].back();
+    m_FreeTiles[source].pop_back();
+    while (tile.level < level) {
+        ++tile.level;
+        uint32 half = GetTileSize(tile.level);
+        m_FreeTiles[tile.level].push_back({ tile.x + half, tile.y, tile.level });
+        m_FreeTiles[tile.level].push_back({ tile.x, tile.y + half, tile.level });
+        m_FreeTiles[tile.level].push_back({ tile.x + half, tile.y + half, tile.level });
+    }
+    outTile = tile;
+    return true;
+}
+
+void ShadowAtlas::FreeTile(const Tile& tile) {
+    // Merge with the three siblings while they are all free
+    Tile merged = tile;
+    while (merged.level > 0) {
+        uint32 parentSize = GetTileSize(merged.level - 1);
+        uint32 parentX = merged.x - merged.x % parentSize;
+        uint32 parentY = merged.y - merged.y % parentSize;
+
+        std::vector<Tile>& freeTiles = m_FreeTiles[merged.level];
+        size_t siblings[3];
+        uint32 found = 0;
+        for (size_t i = 0; i < freeTiles.size() && found < 3; ++i) {
+            const Tile& other = freeTiles[i];
+            bool sibling = other.x >= parentX && other.x < parentX + parentSize &&
+                           other.y >= parentY && other.y < parentY + parentSize &&
+                           (other.x != merged.x || other.y != merged.y);
+            if (sibling) {
+                siblings[found++] = i;
+            }
+        }
+        if (found < 3) {
+            break;
+        }
+        // Remove from the back so the earlier indices stay valid
+        std::sort(siblings, siblings + 3);
+        for (int i = 2; i >= 0; --i) {
+            freeTiles[siblings[i]] = freeTiles.back();
+            freeTiles.pop_back();
+        }
+        merged = { parentX, parentY, merged.level - 1 };
+    }
+    m_FreeTiles[merged.level].push_back(merged);
+}
+
+bool ShadowAtlas::AllocateTiles(uint32 count, uint32 level, Tile* outTiles) {
+    for (uint32 i = 0; i < count; ++i) {
+        if (!AllocateTile(level, outTiles[i])) {
+            for (uint32 j = 0; j < i; ++j) {
+                FreeTile(outTiles[j]);
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+void ShadowAtlas::ReleaseEntry(Entry& entry) {
+    for (uint32 face = 0; face < entry.faceCount; ++face) {
+        if (entry.tiles[face].level != NO_LEVEL) {
+            FreeTile(entry.tiles[face]);
+            entry.tiles[face].level = NO_LEVEL;
+        }
+        entry.rendered[face] = false;
+    }
+    entry.level = NO_LEVEL;
+}
+
+bool ShadowAtlas::EvictFor(float importance, const Entry* keep) {
+    // Lights out of view go first, the longest unseen one; then the least important
+    // visible light below the one that needs the space
+    auto preferred = [this](const Entry& a, const Entry& b) {
+        bool aUnseen = a.lastSeen != m_UpdateCount;
+        bool bUnseen = b.lastSeen != m_UpdateCount;
+        if (aUnseen != bUnseen) {
+            return aUnseen;
+        }
+        return aUnseen ? a.lastSeen < b.lastSeen : a.importance < b.importance;
+    };
+
+    Entry* victim = nullptr;
+    for (Entry& entry : m_Entries) {
+        if (&entry == keep || entry.level == NO_LEVEL) {
+            continue;
+        }
+        if (entry.lastSeen == m_UpdateCount && entry.importance >= importance) {
+            continue;
+        }
+        if (!victim || preferred(entry, *victim)) {
+            victim = &entry;
+        }
+    }
+    if (!victim) {
+        return false;
+    }
+    ReleaseEntry(*victim);
+    return true;
+}
+
+void ShadowAtlas::Place(Entry& entry, uint32 level) {
+    // Shrinking: the tiles given back hold the smaller ones
+    if (entry.level != NO_LEVEL && level > entry.level) {
+        ReleaseEntry(entry);
+    }
+
+    // The desired size, making room if needed, or else the next smaller one. A light
+    // growing keeps its tiles when no larger ones can be had.
+    Tile tiles[MAX_LIGHT_FACES];
+    uint32 lastLevel = entry.level != NO_LEVEL ? entry.level : LEVEL_COUNT;
+    for (uint32 tryLevel = level; tryLevel < lastLevel; ++tryLevel) {
+        bool placed = AllocateTiles(entry.faceCount, tryLevel, tiles);
+        while (!placed && EvictFor(entry.importance, &entry)) {
+            placed = AllocateTiles(entry.faceCount, tryLevel, tiles);
+        }
+        if (placed) {
+            ReleaseEntry(entry);
+            std::copy(tiles, tiles + entry.faceCount, entry.tiles);
+            entry.level = tryLevel;
+            return;
+        }
+    }
+}
+
+uint32 ShadowAtlas::ComputeFaces(const Light& light, glm::mat4* outMatrices) {
+    if (light.GetType() == LightType::Point) {
+        // Faces in the order the shaders pick them by the major axis of the light to
+        // fragment vector; any up vector works since they are sampled as 2D tiles
+        static const glm::vec3 directions[6] = {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f } };
+        static const glm::vec3 ups[6] = {
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f },
+            { 0.0f, 0.0f, -1.0f }, { 0.0f, -1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } };
+        const PointLight& point = static_cast<const PointLight&>(light);
+        glm::mat4 projection = FacePerspective(1.0f, std::max(point.GetRange(), FACE_NEAR * 2.0f));
+        for (uint32 face = 0; face < 6; ++face) {
+            glm::mat4 view = glm::lookAt(point.GetPosition(), point.GetPosition() + directions[face], ups[face]);
+            outMatrices[face] = projection * view;
+        }
+        return 6;
+    }
+
+    if (light.GetType() == LightType::Spot) {
+        const SpotLight& spot = static_cast<const SpotLight&>(light);
+        glm::vec3 direction = glm::normalize(spot.GetDirection());
+        glm::vec3 up = std::abs(direction.y) > 0.999f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        glm::mat4 view = glm::lookAt(spot.GetPosition(), spot.GetPosition() + direction, up);
+        // The square frustum encloses the cone
+        float halfAngle = glm::radians(std::min(spot.GetOuterConeAngle(), 85.0f));
+        outMatrices[0] = FacePerspective(std::tan(halfAngle), std::max(spot.GetRange(), FACE_NEAR * 2.0f)) * view;
+        return 1;
+    }
+    return 0;
+}
+
+void ShadowAtlas::Update(const Scene& scene, const Camera& camera, uint32 viewportHeight) {
+    ++m_UpdateCount;
+    m_RenderQueue.clear();
+
+    // Lights that stopped casting shadows or were removed give their tiles back at once
+    for (Entry& entry : m_Entries) {
+        const Light* light = scene.GetLight(entry.light);
+        if (!light || light->GetType() == LightType::Directional || !light->CastsShadows()) {
+            ReleaseEntry(entry);
+            entry.light = Scene::INVALID_LIGHT;
+        }
+    }
+
+    // Candidates: shadow casting local lights in view. The projected diameter of a light's
+    // range sphere sizes its tiles; scaled by its brightness it ranks the light.
+    m_VisibleLights.clear();
+    scene.QueryLights(camera.GetFrustumPlanes(), m_VisibleLights);
+    m_Candidates.clear();
+    const glm::mat4& view = camera.GetViewMatrix();
+    float pixelsPerUnit = std::abs(camera.GetProjectionMatrix()[1][1]) * 0.5f * static_cast<float>(viewportHeight);
+    for (Scene::LightHandle handle : m_VisibleLights) {
+        const Light* light = scene.GetLight(handle);
+        if (!light || light->GetType() == LightType::Directional || !light->CastsShadows()) {
+            continue;
+        }
+        bool point = light->GetType() == LightType::Point;
+        glm::vec3 position = point ? static_cast<const PointLight*>(light)->GetPosition()
+                                   : static_cast<const SpotLight*>(light)->GetPosition();
+        float range = point ? static_cast<const PointLight*>(light)->GetRange()
+                            : static_cast<const SpotLight*>(light)->GetRange();
+        float distance = glm::length(glm::vec3(view * glm::vec4(position, 1.0f)));
+        float maxPixels = 2.0f * static_cast<float>(viewportHeight);
+        float pixels = distance > range
+            ? std::min(2.0f * range * pixelsPerUnit / std::sqrt(distance * distance - range * range), maxPixels)
+            : maxPixels;
+
+        // A point light face spans 90 degrees, about half of the sphere seen from outside
+        float texels = pixels * m_QualityScale * (point ? 0.5f : 1.0f);
+        uint32 level = 0;
+        while (level + 1 < LEVEL_COUNT && static_cast<float>(GetTileSize(level + 1)) >= texels) {
+            ++level;
+        }
+
+        glm::vec3 color = light->GetColor();
+        float luminance = glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * light->GetIntensity();
+        m_Candidates.push_back({ handle, light, pixels * std::min(luminance, 1.0f), level });
+    }
+    std::sort(m_Candidates.begin(), m_Candidates.end(),
+              [](const Candidate& a, const Candidate& b) { return a.importance > b.importance; });
+
+    // Place the candidates, most important first
+    for (const Candidate& candidate : m_Candidates) {
+        Entry* entry = nullptr;
+        for (Entry& existing : m_Entries) {
+            if (existing.light == candidate.light) {
+                entry = &existing;
+                break;
+            }
+        }
+        if (!entry) {
+            size_t slot = 0;
+            while (slot < m_Entries.size() && m_Entries[slot].light != Scene::INVALID_LIGHT) {
+                ++slot;
+            }
+            if (slot == m_Entries.size()) {
+                m_Entries.emplace_back();
+            }
+            entry = &m_Entries[slot];
+            *entry = Entry{};
+            entry->light = candidate.light;
+        }
+
+        entry->importance = candidate.importance;
+        entry->lastSeen = m_UpdateCount;
+        uint32 faceCount = ComputeFaces(*candidate.source, entry->matrices);
+        if (faceCount != entry->faceCount) {
+            ReleaseEntry(*entry);
+            entry->faceCount = faceCount;
+        }
+
+        // Grow at once, shrink only when four times too large
+        if (entry->level == NO_LEVEL || candidate.level < entry->level || candidate.level >= entry->level + 2) {
+            Place(*entry, candidate.level);
+        }
+    }
+
+    // Forget lights out of view for long, and those without tiles
+    for (Entry& entry : m_Entries) {
+        if (entry.light != Scene::INVALID_LIGHT && m_UpdateCount - entry.lastSeen > RELEASE_DELAY) {
+            ReleaseEntry(entry);
+        }
+        if (entry.level == NO_LEVEL) {
+            entry.light = Scene::INVALID_LIGHT;
+        }
+    }
+    m_Entries.erase(std::remove_if(m_Entries.begin(), m_Entries.end(),
+                                   [](const Entry& entry) { return entry.light == Scene::INVALID_LIGHT; }),
+                    m_Entries.end());
+
+    // Stale faces: never rendered in their tile, or rendered with another matrix or
+    // before the last Invalidate(). Incomplete lights come first, as they are unshadowed
+    // until all of their faces are done; then the most important.
+    struct StaleFace {
+        uint32 entry;
+        uint32 face;
+        bool complete;
+        float importance;
+    };
+    std::vector<StaleFace> stale;
+    m_FaceCount = 0;
+    uint32 usedTexels = 0;
+    for (uint32 i = 0; i < m_Entries.size(); ++i) {
+        const Entry& entry = m_Entries[i];
+        bool complete = std::all_of(entry.rendered, entry.rendered + entry.faceCount, [](bool r) { return r; });
+        for (uint32 face = 0; face < entry.faceCount; ++face) {
+            if (!entry.rendered[face] || entry.renderedGeneration[face] != m_Generation ||
+                (entry.lastSeen == m_UpdateCount && entry.renderedMatrices[face] != entry.matrices[face])) {
+                stale.push_back({ i, face, complete, entry.importance });
+            }
+        }
+        m_FaceCount += entry.faceCount;
+        usedTexels += entry.faceCount * GetTileSize(entry.level) * GetTileSize(entry.level);
+    }
+    std::sort(stale.begin(), stale.end(), [](const StaleFace& a, const StaleFace& b) {
+        return a.complete != b.complete ? !a.complete : a.importance > b.importance;
+    });
+
+    uint32 queued = std::min(static_cast<uint32>(stale.size()), m_FaceBudget);
+    for (uint32 i = 0; i < queued; ++i) {
+        Entry& entry = m_Entries[stale[i].entry];
+        uint32 face = stale[i].face;
+        const Tile& tile = entry.tiles[face];
+        m_RenderQueue.push_back({ entry.matrices[face], tile.x, tile.y, GetTileSize(tile.level), entry.light });
+        entry.renderedMatrices[face] = entry.matrices[face];
+        entry.rendered[face] = true;
+        entry.renderedGeneration[face] = m_Generation;
+    }
+    m_StaleFaces = static_cast<uint32>(stale.size()) - queued;
+    m_Occupancy = static_cast<float>(usedTexels) / (static_cast<float>(m_Size) * static_cast<float>(m_Size));
+}
+
+uint32 ShadowAtlas::Upload(uint32 frameIndex, const Scene& scene) {
+    uint32 regionBase = (frameIndex % m_FramesInFlight) * REGION_VEC4S;
+
+    // Lights map to their first face once every face holds a rendering
+    std::fill(m_Region.begin(), m_Region.begin() + LIGHT_MAP_VEC4S, NoFaces());
+    uint32 faceSlot = 0;
+    float texelScale = 1.0f / static_cast<float>(m_Size);
+    for (const Entry& entry : m_Entries) {
+        uint32 lightIndex = scene.GetGPULightIndex(entry.light);
+        bool complete = std::all_of(entry.rendered, entry.rendered + entry.faceCount, [](bool r) { return r; });
+        if (!complete || lightIndex >= Scene::MAX_LIGHTS || faceSlot + entry.faceCount > MAX_FACES) {
+            continue;
+        }
+
+        uint32 first = regionBase + LIGHT_MAP_VEC4S + faceSlot * FACE_VEC4S;
+        std::memcpy(reinterpret_cast<uint8*>(m_Region.data()) + lightIndex * sizeof(uint32), &first, sizeof(first));
+        for (uint32 face = 0; face < entry.faceCount; ++face, ++faceSlot) {
+            glm::vec4* values = &m_Region[LIGHT_MAP_VEC4S + faceSlot * FACE_VEC4S];
+            for (uint32 column = 0; column < 4; ++column) {
+                values[column] = entry.renderedMatrices[face][column];
+            }
+            const Tile& tile = entry.tiles[face];
+            float size = static_cast<float>(GetTileSize(tile.level)) * texelScale;
+            values[4] = glm::vec4(static_cast<float>(tile.x) * texelScale, static_cast<float>(tile.y) * texelScale,
+                                  size, size);
+        }
+    }
+
+    size_t count = LIGHT_MAP_VEC4S + static_cast<size_t>(faceSlot) * FACE_VEC4S;
+    if (m_MappedData) {
+        std::memcpy(m_MappedData + regionBase, m_Region.data(), count * sizeof(glm::vec4));
+    } else if (m_Buffer) {
+        m_Buffer->CopyData(m_Region.data(), count * sizeof(glm::vec4),
+                           static_cast<uint64>(regionBase) * sizeof(glm::vec4));
+    }
+    return regionBase;
+}
+
+} // namespace metagfx
@@ -4,23 +4,38 @@
 #include "metagfx/scene/ShadowMap.h"
 #include "metagfx/core/Logger.h"
 #include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 
 namespace metagfx {
 
-ShadowMap::ShadowMap(Ref<rhi::GraphicsDevice> device, uint32 width, uint32 height)
+namespace {
+
+// How far towards the light casters in front of a cascade's sphere are still rendered
+constexpr float CASTER_DISTANCE = 50.0f;
+
+} // namespace
+
+ShadowMap::ShadowMap(Ref<rhi::GraphicsDevice> device, uint32 width, uint32 height, rhi::Format depthFormat)
     : m_Device(device)
     , m_Width(width)
     , m_Height(height)
-    , m_LightSpaceMatrix(1.0f) {
+    , m_CullMatrix(1.0f) {
+
+    for (glm::mat4& matrix : m_CascadeMatrices) {
+        matrix = glm::mat4(1.0f);
+    }
 
-    METAGFX_INFO << "Creating shadow map: " << width << "x" << height;
+    METAGFX_INFO << "Creating shadow map: " << width << "x" << height
+                 << (depthFormat == rhi::Format::D16_UNORM ? ", 16-bit depth" : "");
 
     // Create depth texture for shadow map
     rhi::TextureDesc depthDesc{};
     depthDesc.type = rhi::TextureType::Texture2D;
     depthDesc.width = width;
     depthDesc.height = height;
-    depthDesc.format = rhi::Format::D32_SFLOAT;
+    depthDesc.format = depthFormat;
     depthDesc.usage = rhi::TextureUsage::DepthStencilAttachment | rhi::TextureUsage::Sampled;
     depthDesc.mipLevels = 1;
     depthDesc.arrayLayers = 1;
@@ -47,6 +62,13 @@ ShadowMap::ShadowMap(Ref<rhi::GraphicsDevice> device, uint32 width, uint32 heigh
 
     METAGFX_INFO << "Shadow sampler created with LessOrEqual comparison";
 
+    // Depth values themselves, for filters that average the blockers
+    samplerDesc.minFilter = rhi::Filter::Nearest;
+    samplerDesc.magFilter = rhi::Filter::Nearest;
+    samplerDesc.mipmapMode = rhi::Filter::Nearest;
+    samplerDesc.enableCompare = false;
+    m_DepthSampler = device->CreateSampler(samplerDesc);
+
     METAGFX_INFO << "Shadow map created successfully";
 }
 
@@ -54,94 +76,154 @@ ShadowMap::~ShadowMap() {
     METAGFX_INFO << "Destroying shadow map";
 }
 
-void ShadowMap::UpdateLightMatrix(const glm::vec3& lightDir, const Camera& camera) {
-    // For directional lights, we use an orthographic projection
-    // The light "position" is along the light direction from the scene center
-
-    // TODO: In a production system, this should compute a tight bounding box
-    // around the visible scene geometry to minimize shadow map resolution waste
-
-    // CRITICAL: Use a larger orthographic frustum to ensure all models are captured
-    // The helmet model is tall and needs a bigger frustum than the bunny
-    float orthoSize = 30.0f;  // Increased from 20.0f to handle larger models
-
-    // IMPORTANT: Use Vulkan-style orthographic projection with [0, 1] depth range
-    // glm::ortho uses OpenGL convention [-1, 1], which is wrong for Vulkan
-    float nearPlane = 0.1f;
-    float farPlane = 100.0f;
-
-    // Manually construct orthographic matrix for Vulkan
-    // Vulkan NDC: X right, Y down, Z forward [0, 1]
-    // GLM's lookAt produces right-handed view space where -Z is forward (objects have negative Z)
-    // We need to map view-space Z range [-far, -near] to NDC [0, 1]
-    // Formula: NDC_z = (view_z + far) / (far - near) maps [-far, -near] to [0, 1]
-    //   But view_z is negative, so: NDC_z = (-view_z - near) / (far - near)
-    //   This is: NDC_z = -view_z / (far - near) - near / (far - near)
-    glm::mat4 lightProjection = glm::mat4(1.0f);
-    lightProjection[0][0] = 1.0f / orthoSize;  // Scale X (column 0, row 0)
-    lightProjection[1][1] = 1.0f / orthoSize;  // Scale Y (column 1, row 1)
-    lightProjection[2][2] = -1.0f / (farPlane - nearPlane);  // Scale Z (column 2, row 2)
-    // NOTE: GLM is column-major, so [col][row]
-    // Translation is in column 3: lightProjection[3] = vec4(tx, ty, tz, 1)
-    // Formula: NDC = -view_z / (far - near) - near / (far - near)
-    lightProjection[3][2] = -nearPlane / (farPlane - nearPlane);  // Translate Z (column 3, row 2)
+void ShadowMap::SetCascadeCount(uint32 count) {
+    m_CascadeCount = std::clamp(count, 1u, MAX_CASCADES);
+}
+
+glm::vec4 ShadowMap::GetCascadeRect(uint32 cascade) const {
+    return glm::vec4(static_cast<float>(cascade % 2) * 0.5f, static_cast<float>(cascade / 2) * 0.5f, 0.5f, 0.5f);
+}
+
+float ShadowMap::GetCascadePenumbraScale(uint32 cascade, float lightRadius) const {
+    // The cascades are orthographic: a row's length is clip units per world unit
+    const glm::mat4& matrix = m_CascadeMatrices[cascade];
+    float clipPerWorldX = glm::length(glm::vec3(matrix[0][0], matrix[1][0], matrix[2][0]));
+    float clipPerWorldZ = glm::length(glm::vec3(matrix[0][2], matrix[1][2], matrix[2][2]));
+    if (clipPerWorldZ <= 0.0f) {
+        return 0.0f;
+    }
+    // World distance per unit of depth, widened by the light's cone, then halved from
+    // clip x [-1, 1] to the tile's [0, 1]
+    return std::tan(lightRadius) / clipPerWorldZ * clipPerWorldX * 0.5f;
+}
+
+void ShadowMap::GetCascadeViewport(uint32 cascade, uint32& outX, uint32& outY, uint32& outWidth, uint32& outHeight) const {
+    outWidth = m_Width / 2;
+    outHeight = m_Height / 2;
+    outX = (cascade % 2) * outWidth;
+    outY = (cascade / 2) * outHeight;
+}
+
+void ShadowMap::UpdateCascades(const glm::vec3& lightDir, const Camera& camera) {
+    // Practical split scheme: blend the logarithmic split, which keeps the texel to pixel
+    // ratio constant, with the uniform one, which spends fewer texels right at the camera
+    float nearPlane = camera.GetNearPlane();
+    float farPlane = std::max(std::min(m_ShadowDistance, camera.GetFarPlane()), nearPlane * 2.0f);
+    for (uint32 i = 0; i < MAX_CASCADES; ++i) {
+        if (i >= m_CascadeCount) {
+            m_CascadeSplits[i] = farPlane;
+            continue;
+        }
+        float t = static_cast<float>(i + 1) / static_cast<float>(m_CascadeCount);
+        float logSplit = nearPlane * std::pow(farPlane / nearPlane, t);
+        float uniformSplit = nearPlane + (farPlane - nearPlane) * t;
+        m_CascadeSplits[i] = m_SplitLambda * logSplit + (1.0f - m_SplitLambda) * uniformSplit;
+    }
+
+    // Bounding sphere of the view frustum between two view depths. It depends only on
+    // the projection and the depths, so it keeps its size as the camera turns; the radius
+    // is rounded up so float noise does not change the texel size either.
+    const glm::mat4& projection = camera.GetProjectionMatrix();
+    glm::mat4 inverseView = glm::inverse(camera.GetViewMatrix());
+    bool perspective = projection[2][3] != 0.0f;
+    float tanX = 1.0f / projection[0][0];
+    float tanY = 1.0f / std::abs(projection[1][1]);
+    auto sliceSphere = [&](float sliceNear, float sliceFar, glm::vec3& outCenter, float& outRadius) {
+        glm::vec3 corners[8];
+        glm::vec3 center(0.0f);
+        for (uint32 i = 0; i < 8; ++i) {
+            float depth = (i & 4) ? sliceFar : sliceNear;
+            float scale = perspective ? depth : 1.0f;
+            corners[i] = glm::vec3((i & 1) ? tanX * scale : -tanX * scale,
+                                   (i & 2) ? tanY * scale : -tanY * scale, -depth);
+            center += corners[i] / 8.0f;
+        }
+        float radius = 0.0f;
+        for (const glm::vec3& corner : corners) {
+            radius = std::max(radius, glm::length(corner - center));
+        }
+        outCenter = glm::vec3(inverseView * glm::vec4(center, 1.0f));
+        outRadius = std::ceil(radius * 16.0f) / 16.0f;
+    };
+
+    float sliceNear = nearPlane;
+    for (uint32 i = 0; i < MAX_CASCADES; ++i) {
+        if (i >= m_CascadeCount) {
+            m_CascadeMatrices[i] = m_CascadeMatrices[m_CascadeCount - 1];
+            continue;
+        }
+        glm::vec3 center;
+        float radius;
+        sliceSphere(sliceNear, m_CascadeSplits[i], center, radius);
+        m_CascadeMatrices[i] = FitSphere(lightDir, center, radius);
+        sliceNear = m_CascadeSplits[i];
+    }
+
+    glm::vec3 center;
+    float radius;
+    sliceSphere(nearPlane, farPlane, center, radius);
+    m_CullMatrix = FitSphere(lightDir, center, radius);
 
-    // Light "position" along the negative light direction (farther back)
-    glm::vec3 lightPos = -glm::normalize(lightDir) * 60.0f;  // Increased from 40.0f for larger frustum
+    METAGFX_DEBUG_ONCE << "Shadow cascades: " << m_CascadeCount << ", splits " << m_CascadeSplits[0] << ", "
+                       << m_CascadeSplits[1] << ", " << m_CascadeSplits[2] << ", " << m_CascadeSplits[3]
+                       << " (lambda " << m_SplitLambda << ", near " << nearPlane << ", far " << farPlane << ")";
+}
 
-    // Light looks at the origin (scene center)
-    glm::vec3 target = glm::vec3(0.0f, 0.0f, 0.0f);
+bool ShadowMap::UpdateCache(uint64 casterHash) {
+    // Boost-style hash combine of the cascade matrices' bits: the cascades are recomputed
+    // from the same inputs every frame, so a still camera gives identical matrices
+    uint64 key = casterHash;
+    auto combine = [&key](uint64 value) {
+        key ^= value + 0x9e3779b97f4a7c15ull + (key << 6) + (key >> 2);
+    };
+    combine(m_CascadeCount);
+    for (uint32 i = 0; i < m_CascadeCount; ++i) {
+        const float* values = &m_CascadeMatrices[i][0][0];
+        for (uint32 j = 0; j < 16; ++j) {
+            uint32 bits;
+            std::memcpy(&bits, &values[j], sizeof(bits));
+            combine(bits);
+        }
+    }
+
+    bool render = !m_CachingEnabled || !m_CacheValid || key != m_CacheKey;
+    m_CacheKey = key;
+    m_CacheValid = true;
+    return render;
+}
+
+glm::mat4 ShadowMap::FitSphere(const glm::vec3& lightDir, const glm::vec3& center, float radius) const {
+    glm::vec3 direction = glm::normalize(lightDir);
     glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
 
     // Avoid degenerate case where light direction is parallel to up vector
-    if (std::abs(glm::dot(glm::normalize(lightDir), up)) > 0.999f) {
+    if (std::abs(glm::dot(direction, up)) > 0.999f) {
         up = glm::vec3(1.0f, 0.0f, 0.0f);
     }
 
-    glm::mat4 lightView = glm::lookAt(lightPos, target, up);
-
-    // Combined light-space matrix
-    m_LightSpaceMatrix = lightProjection * lightView;
-
-    // Debug logging (enabled for shadow debugging)
-    static bool logged = false;
-    if (!logged) {
-        METAGFX_INFO << "Shadow frustum - orthoSize: " << orthoSize
-                     << " (covers -" << orthoSize << " to +" << orthoSize << " in X and Z)"
-                     << ", near: " << nearPlane << ", far: " << farPlane
-                     << ", lightPos: (" << lightPos.x << ", " << lightPos.y << ", " << lightPos.z << ")"
-                     << ", lightDir: (" << lightDir.x << ", " << lightDir.y << ", " << lightDir.z << ")";
-        METAGFX_INFO << "Using Vulkan-style orthographic projection (depth [0,1])";
-        METAGFX_INFO << "Projection matrix Z row: [" << lightProjection[2][0] << ", "
-                     << lightProjection[2][1] << ", " << lightProjection[2][2] << ", " << lightProjection[2][3] << "]";
-        METAGFX_INFO << "Projection matrix W row: [" << lightProjection[3][0] << ", "
-                     << lightProjection[3][1] << ", " << lightProjection[3][2] << ", " << lightProjection[3][3] << "]";
-
-        // Test transformation: origin point (0, 0, 0) should be in middle of frustum
-        glm::vec4 testOrigin = m_LightSpaceMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-        glm::vec3 testNDC = glm::vec3(testOrigin) / testOrigin.w;
-        METAGFX_INFO << "Test: Origin (0,0,0) -> Light NDC (raw): ("
-                     << testNDC.x << ", " << testNDC.y << ", " << testNDC.z << ")";
-        // For texture sampling, X/Y need * 0.5 + 0.5, but Z is already [0,1]
-        glm::vec3 testTexCoord = testNDC;
-        testTexCoord.x = testNDC.x * 0.5f + 0.5f;
-        testTexCoord.y = testNDC.y * 0.5f + 0.5f;
-        METAGFX_INFO << "  -> Texture coords: ("
-                     << testTexCoord.x << ", " << testTexCoord.y << ", " << testTexCoord.z << ")";
-
-        // Test a point 2 units above origin (where models might be)
-        glm::vec4 testAbove = m_LightSpaceMatrix * glm::vec4(0.0f, 2.0f, 0.0f, 1.0f);
-        glm::vec3 testAboveNDC = glm::vec3(testAbove) / testAbove.w;
-        METAGFX_INFO << "Test: Point (0,2,0) -> Light NDC (raw): ("
-                     << testAboveNDC.x << ", " << testAboveNDC.y << ", " << testAboveNDC.z << ")";
-        glm::vec3 testAboveTexCoord = testAboveNDC;
-        testAboveTexCoord.x = testAboveNDC.x * 0.5f + 0.5f;
-        testAboveTexCoord.y = testAboveNDC.y * 0.5f + 0.5f;
-        METAGFX_INFO << "  -> Texture coords: ("
-                     << testAboveTexCoord.x << ", " << testAboveTexCoord.y << ", " << testAboveTexCoord.z << ")";
-
-        logged = true;
-    }
+    glm::vec3 lightPos = center - direction * (radius + CASTER_DISTANCE);
+    glm::mat4 lightView = glm::lookAt(lightPos, center, up);
+
+    // Vulkan-style orthographic projection with [0, 1] depth range; glm::ortho uses the
+    // OpenGL [-1, 1] convention. View-space z in [-far, 0] maps to NDC z = -view_z / far.
+    // NOTE: GLM is column-major, so [col][row]
+    float farPlane = 2.0f * radius + CASTER_DISTANCE;
+    glm::mat4 lightProjection = glm::mat4(1.0f);
+    lightProjection[0][0] = 1.0f / radius;
+    lightProjection[1][1] = 1.0f / radius;
+    lightProjection[2][2] = -1.0f / farPlane;
+
+    // Snap the projection so the world origin falls on a texel corner of the cascade's
+    // tile. The light's rotation and the radius are fixed, so the whole texel grid then
+    // stays put in world space while the sphere slides over it.
+    glm::vec2 halfTile = glm::vec2(static_cast<float>(m_Width / 2), static_cast<float>(m_Height / 2)) * 0.5f;
+    glm::vec4 origin = lightProjection * lightView * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    glm::vec2 texel = glm::vec2(origin) * halfTile;
+    glm::vec2 offset = (glm::round(texel) - texel) / halfTile;
+    lightProjection[3][0] += offset.x;
+    lightProjection[3][1] += offset.y;
+
+    return lightProjection * lightView;
 }
 
 } // namespace metagfx
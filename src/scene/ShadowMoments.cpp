@@ -0,0 +1,127 @@
+// ============================================================================
+// src/scene/ShadowMoments.cpp
+// ============================================================================
+#include "metagfx/scene/ShadowMoments.h"
+#include "metagfx/scene/ShadowMap.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+
+namespace metagfx {
+
+// Must match local_size_x/y of shadow_evsm.comp
+constexpr uint32 MOMENTS_GROUP_SIZE = 8;
+
+// Push constants of shadow_evsm.comp
+struct MomentsPushConstants {
+    uint32 pass;        // 0 = warp the depth, 1 = horizontal blur, 2 = vertical blur
+    uint32 width;       // Of the moment textures
+    uint32 height;
+    uint32 tileSize;    // Cascade tiles in moment texels
+    uint32 blurRadius;
+    float exponent;
+    uint32 padding[2];
+};
+
+ShadowMoments::ShadowMoments(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, const ShadowMap& shadowMap)
+    : m_Device(device)
+    , m_Width(shadowMap.GetWidth() / 2)
+    , m_Height(shadowMap.GetHeight() / 2)
+    , m_TileSize(shadowMap.GetWidth() / 4) {
+    using namespace rhi;
+
+    TextureDesc momentsDesc{};
+    momentsDesc.type = TextureType::Texture2D;
+    momentsDesc.width = m_Width;
+    momentsDesc.height = m_Height;
+    momentsDesc.format = Format::R16G16B16A16_SFLOAT;
+    momentsDesc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    momentsDesc.mipLevels = 1;
+    momentsDesc.arrayLayers = 1;
+    momentsDesc.debugName = "ShadowMoments";
+    m_Moments = device->CreateTexture(momentsDesc);
+    momentsDesc.debugName = "ShadowMoments_Scratch";
+    m_Scratch = device->CreateTexture(momentsDesc);
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+    samplerDesc.minFilter = Filter::Linear;
+    samplerDesc.magFilter = Filter::Linear;
+    m_Sampler = device->CreateSampler(samplerDesc);
+
+    // Each pass reads one texture and writes another, so no texture is bound for both
+    Ref<Texture> sources[3] = { shadowMap.GetDepthTexture(), m_Moments, m_Scratch };
+    Ref<Texture> destinations[3] = { m_Moments, m_Scratch, m_Moments };
+    const char* names[3] = { "ShadowMomentsWarp", "ShadowMomentsBlurX", "ShadowMomentsBlurY" };
+    for (uint32 pass = 0; pass < 3; ++pass) {
+        DescriptorSetDesc setDesc;
+        setDesc.bindings = {
+            { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, sources[pass], m_PointSampler },
+            { 1, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, destinations[pass], nullptr }
+        };
+        setDesc.debugName = names[pass];
+        m_PassDescriptorSets[pass] = device->CreateDescriptorSet(setDesc);
+    }
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(MomentsPushConstants);
+    pipelineDesc.debugName = "ShadowMomentsPipeline";
+    pipelineDesc.descriptorSetLayout = m_PassDescriptorSets[0];
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "EVSM shadows unavailable: failed to create the moment textures or pipeline";
+        return;
+    }
+    METAGFX_INFO << "Shadow moments created: " << m_Width << "x" << m_Height << " RGBA16F";
+}
+
+void ShadowMoments::SetBlurRadius(uint32 radius) {
+    radius = std::min(radius, MAX_BLUR_RADIUS);
+    if (radius != m_BlurRadius) {
+        m_BlurRadius = radius;
+        m_Current = false;
+    }
+}
+
+void ShadowMoments::Build(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    using namespace rhi;
+
+    if (!IsValid()) {
+        return;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+
+    uint32 passCount = m_BlurRadius > 0 ? 3 : 1;
+    for (uint32 pass = 0; pass < passCount; ++pass) {
+        if (pass > 0) {
+            cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+        }
+        MomentsPushConstants push{};
+        push.pass = pass;
+        push.width = m_Width;
+        push.height = m_Height;
+        push.tileSize = m_TileSize;
+        push.blurRadius = m_BlurRadius;
+        push.exponent = EXPONENT;
+
+        cmd.BindDescriptorSet(m_Pipeline, m_PassDescriptorSets[pass], frameIndex);
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((m_Width + MOMENTS_GROUP_SIZE - 1) / MOMENTS_GROUP_SIZE,
+                     (m_Height + MOMENTS_GROUP_SIZE - 1) / MOMENTS_GROUP_SIZE);
+    }
+
+    m_Current = true;
+}
+
+} // namespace metagfx
@@ -0,0 +1,240 @@
+// ============================================================================
+// src/scene/Skinning.cpp
+// ============================================================================
+#include "metagfx/scene/Skinning.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/scene/Animation.h"
+#include "metagfx/scene/Model.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+
+// Push constants of skinning.comp
+struct SkinningConstants {
+    uint32 sourceVertex;
+    uint32 vertexCount;
+    uint32 targetVertex;
+    uint32 jointCount;
+    uint32 paletteOffset;
+    uint32 morphTargetCount;
+    uint32 morphOffset;
+    uint32 weightOffset;
+    uint32 positionStream;  // 1: also write the pool's position stream
+    uint32 padding[3];
+};
+
+static_assert(sizeof(Vertex) == 12 * sizeof(float), "skinning.comp reads vertices as 12 floats");
+static_assert(sizeof(SkinVertex) == 4 * sizeof(uint32), "skinning.comp reads skin vertices as 4 uints");
+
+Skinning::Skinning(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, uint32 framesInFlight)
+    : m_Device(device)
+    , m_FramesInFlight(std::max(framesInFlight, 1u)) {
+    using namespace rhi;
+
+    // The buffers come with the first model; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    for (uint32 binding = 0; binding < 6; ++binding) {
+        layoutDesc.bindings.push_back({ binding, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr });
+    }
+    layoutDesc.debugName = "SkinningLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(SkinningConstants);
+    pipelineDesc.debugName = "SkinningPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Skinning unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Compute skinning created";
+}
+
+void Skinning::Release() {
+    if (m_BindPose) {
+        m_Device->Retire(m_BindPose);
+        m_Device->Retire(m_SkinVertices);
+        m_Device->Retire(m_MorphDeltas);
+        m_Device->Retire(m_FrameData);
+        m_Device->Retire(m_DescriptorSets);
+    }
+    m_BindPose.reset();
+    m_SkinVertices.reset();
+    m_MorphDeltas.reset();
+    m_FrameData.clear();
+    m_DescriptorSets.clear();
+    m_VertexBuffer.reset();
+    m_PositionBuffer.reset();
+    m_Dispatches.clear();
+    m_Staging.clear();
+    m_VertexCount = 0;
+}
+
+bool Skinning::SetModel(const Model* model) {
+    using namespace rhi;
+
+    Release();
+    if (!IsValid() || !model || model->GetDeformedMeshes().empty()) {
+        return false;
+    }
+    const Ref<GeometryPool>& pool = model->GetGeometryPool();
+    if (!pool || !pool->IsDeformable() || pool->GetVertexFormat() != VertexFormat::Float) {
+        METAGFX_WARN << "Skinning: the model's geometry pool cannot be written, meshes stay in their bind pose";
+        return false;
+    }
+
+    // Lay out every deformed mesh one after the other, palettes first in the frame data
+    // (in the order of Animator's), then the weights
+    const auto& deformed = model->GetDeformedMeshes();
+    const auto& skins = model->GetSkins();
+    const auto& meshes = model->GetMeshes();
+    std::vector<Vertex> bindPose;
+    std::vector<SkinVertex> skinVertices;
+    std::vector<MorphTargetDelta> morphDeltas;
+    uint32 paletteFloats = 0;
+    uint32 weightCount = 0;
+    for (uint32 i = 0; i < deformed.size(); ++i) {
+        const DeformedMesh& mesh = deformed[i];
+        uint32 vertexCount = static_cast<uint32>(mesh.bindPose.size());
+        uint32 jointCount = mesh.skin < skins.size() && !mesh.skinVertices.empty()
+                                ? static_cast<uint32>(skins[mesh.skin].joints.size()) : 0;
+
+        Dispatch dispatch{};
+        dispatch.deformedMesh = i;
+        dispatch.sourceVertex = static_cast<uint32>(bindPose.size());
+        dispatch.vertexCount = vertexCount;
+        dispatch.targetVertex = static_cast<uint32>(meshes[mesh.mesh]->GetVertexOffset());
+        dispatch.jointCount = jointCount;
+        dispatch.paletteOffset = paletteFloats;
+        dispatch.morphTargetCount = mesh.morphTargetCount;
+        dispatch.morphOffset = static_cast<uint32>(morphDeltas.size());
+        dispatch.weightOffset = weightCount;  // Moved past the palettes below
+        m_Dispatches.push_back(dispatch);
+
+        bindPose.insert(bindPose.end(), mesh.bindPose.begin(), mesh.bindPose.end());
+        if (jointCount > 0) {
+            skinVertices.insert(skinVertices.end(), mesh.skinVertices.begin(), mesh.skinVertices.end());
+        } else {
+            skinVertices.resize(bindPose.size());  // Keeps the two parallel
+        }
+        morphDeltas.insert(morphDeltas.end(), mesh.morphDeltas.begin(), mesh.morphDeltas.end());
+        paletteFloats += (mesh.skin < skins.size() ? static_cast<uint32>(skins[mesh.skin].joints.size()) : 0) * 16;
+        weightCount += mesh.morphTargetCount;
+    }
+    for (Dispatch& dispatch : m_Dispatches) {
+        dispatch.weightOffset += paletteFloats;
+    }
+    m_VertexCount = static_cast<uint32>(bindPose.size());
+
+    auto createBuffer = [this](uint64 size, MemoryUsage memoryUsage, const char* name) {
+        BufferDesc desc{};
+        desc.size = std::max<uint64>(size, 16);  // Bound even when empty
+        desc.usage = memoryUsage == MemoryUsage::GPUOnly ? BufferUsage::Storage | BufferUsage::TransferDst
+                                                         : BufferUsage::Storage;
+        desc.memoryUsage = memoryUsage;
+        desc.debugName = name;
+        return m_Device->CreateBuffer(desc);
+    };
+    m_BindPose = createBuffer(bindPose.size() * sizeof(Vertex), MemoryUsage::GPUOnly, "SkinningBindPose");
+    m_SkinVertices = createBuffer(skinVertices.size() * sizeof(SkinVertex), MemoryUsage::GPUOnly, "SkinningWeights");
+    m_MorphDeltas = createBuffer(morphDeltas.size() * sizeof(MorphTargetDelta), MemoryUsage::GPUOnly, "SkinningMorphTargets");
+    for (uint32 i = 0; i < m_FramesInFlight; ++i) {
+        m_FrameData.push_back(createBuffer(static_cast<uint64>(paletteFloats + weightCount) * sizeof(float),
+                                           MemoryUsage::CPUToGPU, "SkinningPalettes"));
+    }
+    bool created = m_BindPose && m_SkinVertices && m_MorphDeltas &&
+                   std::all_of(m_FrameData.begin(), m_FrameData.end(), [](const Ref<Buffer>& buffer) { return buffer != nullptr; });
+    if (!created) {
+        METAGFX_ERROR << "Skinning: failed to create its buffers";
+        Release();
+        return false;
+    }
+    m_BindPose->CopyData(bindPose.data(), bindPose.size() * sizeof(Vertex));
+    m_SkinVertices->CopyData(skinVertices.data(), skinVertices.size() * sizeof(SkinVertex));
+    if (!morphDeltas.empty()) {
+        m_MorphDeltas->CopyData(morphDeltas.data(), morphDeltas.size() * sizeof(MorphTargetDelta));
+    }
+    m_Staging.assign(paletteFloats + weightCount, 0.0f);
+
+    // Without a position stream binding 5 repeats the vertex buffer, which is not written
+    m_VertexBuffer = pool->GetVertexBuffer();
+    m_PositionBuffer = pool->GetPositionBuffer();
+    for (uint32 i = 0; i < m_FramesInFlight; ++i) {
+        DescriptorSetDesc desc;
+        desc.bindings = {
+            { 0, DescriptorType::StorageBuffer, ShaderStage::Compute, m_BindPose, nullptr, nullptr },
+            { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_SkinVertices, nullptr, nullptr },
+            { 2, DescriptorType::StorageBuffer, ShaderStage::Compute, m_MorphDeltas, nullptr, nullptr },
+            { 3, DescriptorType::StorageBuffer, ShaderStage::Compute, m_FrameData[i], nullptr, nullptr },
+            { 4, DescriptorType::StorageBuffer, ShaderStage::Compute, m_VertexBuffer, nullptr, nullptr },
+            { 5, DescriptorType::StorageBuffer, ShaderStage::Compute,
+              m_PositionBuffer ? m_PositionBuffer : m_VertexBuffer, nullptr, nullptr }
+        };
+        desc.debugName = "SkinningDescriptorSet";
+        m_DescriptorSets.push_back(m_Device->CreateDescriptorSet(desc));
+    }
+
+    METAGFX_INFO << "Skinning " << m_Dispatches.size() << " meshes (" << m_VertexCount << " vertices, "
+                 << paletteFloats / 16 << " joints, " << weightCount << " morph targets)";
+    return true;
+}
+
+void Skinning::Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const Animator& animator) {
+    using namespace rhi;
+    METAGFX_PROFILE_SCOPE("Skinning");
+
+    if (m_Dispatches.empty()) {
+        return;
+    }
+    uint32 slot = frameIndex % m_FramesInFlight;
+
+    for (const Dispatch& dispatch : m_Dispatches) {
+        auto palette = animator.GetPalette(dispatch.deformedMesh);
+        auto weights = animator.GetMorphWeights(dispatch.deformedMesh);
+        std::memcpy(m_Staging.data() + dispatch.paletteOffset, palette.data(), palette.size_bytes());
+        std::memcpy(m_Staging.data() + dispatch.weightOffset, weights.data(), weights.size_bytes());
+    }
+    const Ref<Buffer>& frameData = m_FrameData[slot];
+    if (void* mapped = frameData->GetMappedPointer()) {
+        std::memcpy(mapped, m_Staging.data(), m_Staging.size() * sizeof(float));
+    } else {
+        frameData->CopyData(m_Staging.data(), m_Staging.size() * sizeof(float));
+    }
+
+    // The last frame's draws may still read the pose being replaced
+    BufferBarrier before[2] = { { m_VertexBuffer, ResourceState::ShaderRead, ResourceState::StorageWrite },
+                                { m_PositionBuffer, ResourceState::ShaderRead, ResourceState::StorageWrite } };
+    cmd.ResourceBarrier(nullptr, 0, before, m_PositionBuffer ? 2 : 1);
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSets[slot], frameIndex);
+    for (const Dispatch& dispatch : m_Dispatches) {
+        SkinningConstants push{};
+        push.sourceVertex = dispatch.sourceVertex;
+        push.vertexCount = dispatch.vertexCount;
+        push.targetVertex = dispatch.targetVertex;
+        push.jointCount = dispatch.jointCount;
+        push.paletteOffset = dispatch.paletteOffset;
+        push.morphTargetCount = dispatch.morphTargetCount;
+        push.morphOffset = dispatch.morphOffset;
+        push.weightOffset = dispatch.weightOffset;
+        push.positionStream = m_PositionBuffer ? 1 : 0;
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+        cmd.Dispatch((dispatch.vertexCount + GROUP_SIZE - 1) / GROUP_SIZE);
+    }
+
+    BufferBarrier after[2] = { { m_VertexBuffer, ResourceState::StorageWrite, ResourceState::ShaderRead },
+                               { m_PositionBuffer, ResourceState::StorageWrite, ResourceState::ShaderRead } };
+    cmd.ResourceBarrier(nullptr, 0, after, m_PositionBuffer ? 2 : 1);
+    cmd.PipelineBarrier(BarrierType::ComputeToGraphics);  // Vertex fetch is not a shader read
+}
+
+} // namespace metagfx
@@ -0,0 +1,262 @@
+// ============================================================================
+// src/scene/StreamEncoder.cpp
+// ============================================================================
+#include "metagfx/scene/StreamEncoder.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <cstring>
+
+namespace metagfx {
+
+// Must match local_size_x/y of stream_encode.comp
+constexpr uint32 STREAM_GROUP_SIZE = 8;
+
+// Push constants of stream_encode.comp
+struct StreamEncodeConstants {
+    uint32 width;         // Of the source
+    uint32 height;
+    uint32 pitch;         // Bytes per row of both planes
+    uint32 paddedHeight;  // Rows of the luma plane
+    uint32 srgbSource;    // Sampling decodes sRGB, so the shader encodes it again
+    uint32 padding[3];
+};
+
+namespace {
+
+uint32 GetPitch(uint32 width) {
+    return (width + 3) / 4 * 4;
+}
+
+uint32 GetPaddedHeight(uint32 height) {
+    return (height + 1) / 2 * 2;
+}
+
+bool IsSrgbFormat(rhi::Format format) {
+    return format == rhi::Format::R8G8B8A8_SRGB || format == rhi::Format::B8G8R8A8_SRGB;
+}
+
+} // namespace
+
+uint64 StreamEncoder::GetFrameSize(uint32 width, uint32 height) {
+    return static_cast<uint64>(GetPitch(width)) * GetPaddedHeight(height) * 3 / 2;
+}
+
+StreamEncoder::StreamEncoder(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader,
+                             const VideoEncoder::Settings& videoSettings)
+    : m_Device(device), m_VideoSettings(videoSettings) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The back buffer and the output come with the first frame; the pipeline only needs
+    // the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "StreamEncodeLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(StreamEncodeConstants);
+    pipelineDesc.debugName = "StreamEncodePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!m_Pipeline) {
+        METAGFX_ERROR << "Stream encoder unavailable: failed to create its pipeline";
+        return;
+    }
+    m_Readback = std::make_unique<ReadbackPool>(device);
+    METAGFX_INFO << "Stream encoder created: NV12 (BT.709) converted on the GPU, H.264 where the platform encodes it";
+}
+
+void StreamEncoder::SetFormat(stream::PixelFormat format) {
+    if (format == m_Format) {
+        return;
+    }
+    m_Format = format;
+    m_VideoEncoder.reset();
+    m_VideoUnavailable = false;
+    if (m_Format == stream::PixelFormat::H264) {
+        m_KeyFrameRequested = true;
+        CreateVideoEncoder();
+    }
+}
+
+void StreamEncoder::CreateVideoEncoder() {
+    if (m_Format != stream::PixelFormat::H264 || m_VideoEncoder || m_VideoUnavailable || m_Width == 0) {
+        return;
+    }
+
+    VideoEncoder::Settings settings = m_VideoSettings;
+    settings.width = m_Width;
+    settings.height = m_Height;
+    // On the encoder's thread, also while it is destroyed
+    uint32 width = m_Width;
+    uint32 height = m_Height;
+    m_VideoEncoder = VideoEncoder::CreateH264(settings, [this, width, height](VideoEncoder::Packet&& packet) {
+        Frame frame;
+        frame.frameNumber = packet.frameNumber;
+        frame.encodeTimeNs = packet.encodeTimeNs;
+        frame.width = width;
+        frame.height = height;
+        frame.format = stream::PixelFormat::H264;
+        frame.keyFrame = packet.keyFrame;
+        frame.data = std::move(packet.data);
+        if (m_FrameCallback) {
+            m_FrameCallback(std::move(frame));
+        }
+    });
+    if (!m_VideoEncoder) {
+        METAGFX_WARN << "Stream encoder: no hardware H.264 encoder for " << m_Width << "x" << m_Height
+                     << "; streaming raw NV12";
+        m_VideoUnavailable = true;
+    }
+    m_KeyFrameRequested = true;
+}
+
+void StreamEncoder::SetSource(const Ref<rhi::Texture>& backBuffer) {
+    using namespace rhi;
+
+    if (!IsValid() || !backBuffer) {
+        return;
+    }
+
+    // A resize replaces the back buffers and the output with them
+    uint32 width = backBuffer->GetWidth();
+    uint32 height = backBuffer->GetHeight();
+    if (width != m_Width || height != m_Height || !m_Output) {
+        for (SourceBinding& source : m_Sources) {
+            m_Device->Retire(source.descriptorSet);
+        }
+        m_Sources.clear();
+        if (m_Output) {
+            m_Device->Retire(m_Output);
+            m_Output.reset();
+        }
+        m_Width = width;
+        m_Height = height;
+        // An encoder is of one size; its frames in flight finish first
+        m_VideoEncoder.reset();
+        m_VideoUnavailable = false;
+        CreateVideoEncoder();
+
+        BufferDesc outputDesc{};
+        outputDesc.size = GetFrameSize(width, height);
+        outputDesc.usage = BufferUsage::Storage | BufferUsage::TransferSrc;
+        outputDesc.memoryUsage = MemoryUsage::GPUOnly;
+        outputDesc.debugName = "StreamFrame";
+        m_Output = m_Device->CreateBuffer(outputDesc);
+        if (!m_Output) {
+            METAGFX_ERROR << "Stream encoder: failed to create its " << width << "x" << height << " output";
+            return;
+        }
+    }
+
+    for (uint32 i = 0; i < m_Sources.size(); ++i) {
+        if (m_Sources[i].texture == backBuffer) {
+            m_SourceIndex = i;
+            return;
+        }
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, backBuffer, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, m_Output, nullptr, nullptr }
+    };
+    desc.debugName = "StreamEncodeDescriptorSet";
+    SourceBinding source;
+    source.texture = backBuffer;
+    source.descriptorSet = m_Device->CreateDescriptorSet(desc);
+    m_SourceIndex = static_cast<uint32>(m_Sources.size());
+    m_Sources.push_back(std::move(source));
+}
+
+void StreamEncoder::Encode(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    using namespace rhi;
+
+    if (!m_Output || m_SourceIndex >= m_Sources.size() || !m_Sources[m_SourceIndex].descriptorSet) {
+        return;
+    }
+    const SourceBinding& source = m_Sources[m_SourceIndex];
+
+    StreamEncodeConstants push{};
+    push.width = m_Width;
+    push.height = m_Height;
+    push.pitch = GetPitch(m_Width);
+    push.paddedHeight = GetPaddedHeight(m_Height);
+    push.srgbSource = IsSrgbFormat(source.texture->GetFormat()) ? 1 : 0;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, source.descriptorSet, frameIndex);
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    // One invocation per 4x2 block
+    uint32 blocksX = push.pitch / 4;
+    uint32 blocksY = push.paddedHeight / 2;
+    cmd.Dispatch((blocksX + STREAM_GROUP_SIZE - 1) / STREAM_GROUP_SIZE,
+                 (blocksY + STREAM_GROUP_SIZE - 1) / STREAM_GROUP_SIZE);
+
+    ++m_FrameNumber;
+    m_EncodeTimeNs = Profiler::Now();
+}
+
+void StreamEncoder::ReadBack(rhi::CommandBuffer& cmd) {
+    if (!m_Output || !m_FrameCallback) {
+        return;
+    }
+
+    Frame frame;
+    frame.frameNumber = m_FrameNumber;
+    frame.encodeTimeNs = m_EncodeTimeNs;
+    frame.width = m_Width;
+    frame.height = m_Height;
+    frame.pitch = GetPitch(m_Width);
+
+    // The callback runs in BeginFrame(), where this and the encoder of the time are alive
+    bool started = m_Readback->Read(cmd, m_Output, 0, GetFrameSize(m_Width, m_Height),
+                                    [this, frame](const void* data, uint64 size) mutable {
+        if (!data || size == 0) {
+            return;
+        }
+        if (m_VideoEncoder) {
+            // Frames of an earlier size went with its encoder
+            const VideoEncoder::Settings& settings = m_VideoEncoder->GetSettings();
+            if (settings.width == frame.width && settings.height == frame.height) {
+                bool keyFrame = m_KeyFrameRequested.exchange(false);
+                if (!m_VideoEncoder->Encode(static_cast<const uint8*>(data), frame.pitch, frame.frameNumber,
+                                            frame.encodeTimeNs, keyFrame) && keyFrame) {
+                    m_KeyFrameRequested = true;
+                }
+            }
+            return;
+        }
+        frame.data.resize(size);
+        std::memcpy(frame.data.data(), data, size);
+        m_FrameCallback(std::move(frame));
+    });
+    if (!started) {
+        METAGFX_ERROR << "Stream encoder: failed to read back frame " << m_FrameNumber;
+    }
+}
+
+void StreamEncoder::BeginFrame() {
+    if (m_Readback) {
+        m_Readback->BeginFrame();
+    }
+}
+
+} // namespace metagfx
@@ -0,0 +1,376 @@
+// ============================================================================
+// src/scene/TemporalAA.cpp
+// ============================================================================
+#include "metagfx/scene/TemporalAA.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/TemporalUpscaler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace metagfx {
+
+// Must match local_size_x/y of taa.comp
+constexpr uint32 TAA_GROUP_SIZE = 8;
+
+// Push constants of taa.comp
+struct TemporalAAPushConstants {
+    glm::mat4 reprojection;
+    uint32 pass;  // 0 = resolve, 1 = sharpen
+    uint32 historyValid;
+    float currentWeight;
+    float sharpness;
+    glm::vec2 jitter;      // In scene color texels
+    glm::uvec2 inputSize;  // Of the scene color drawn, its top-left region
+};
+
+// Push constants of taa_motion.comp
+struct TemporalAAMotionPushConstants {
+    glm::mat4 reprojection;
+    glm::uvec2 inputSize;
+    glm::uvec2 padding;
+};
+
+namespace {
+
+// Radical inverse of index in base, in [0, 1)
+float Halton(uint32 index, uint32 base) {
+    float result = 0.0f;
+    float fraction = 1.0f / static_cast<float>(base);
+    while (index > 0) {
+        result += static_cast<float>(index % base) * fraction;
+        index /= base;
+        fraction /= static_cast<float>(base);
+    }
+    return result;
+}
+
+} // namespace
+
+TemporalAA::TemporalAA(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> shader, Ref<rhi::Shader> motionShader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+    samplerDesc.minFilter = Filter::Linear;
+    samplerDesc.magFilter = Filter::Linear;
+    m_LinearSampler = device->CreateSampler(samplerDesc);
+
+    // The textures come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+        { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_LinearSampler },
+        { 5, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "TemporalAALayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(TemporalAAPushConstants);
+    pipelineDesc.debugName = "TemporalAAPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Temporal AA unavailable: failed to create its pipeline";
+        return;
+    }
+
+    // The full motion for the device's upscaler; without it upscaling stays in taa.comp
+    if (motionShader && device->GetDeviceInfo().supportsTemporalUpscaler) {
+        DescriptorSetDesc motionLayoutDesc;
+        motionLayoutDesc.bindings = {
+            { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+            { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+            { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, nullptr, m_PointSampler },
+            { 3, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, nullptr, nullptr }
+        };
+        motionLayoutDesc.debugName = "TemporalAAMotionLayout";
+
+        ComputePipelineDesc motionPipelineDesc{};
+        motionPipelineDesc.computeShader = motionShader;
+        motionPipelineDesc.pushConstantSize = sizeof(TemporalAAMotionPushConstants);
+        motionPipelineDesc.debugName = "TemporalAAMotionPipeline";
+        motionPipelineDesc.descriptorSetLayout = device->CreateDescriptorSet(motionLayoutDesc);
+        m_MotionPipeline = device->CreateComputePipeline(motionPipelineDesc);
+        if (!m_MotionPipeline) {
+            METAGFX_WARN << "Temporal AA: failed to create its motion pipeline; upscaling in compute";
+        }
+    }
+    METAGFX_INFO << "Temporal AA created: " << JITTER_PHASES << " jitter phases"
+                 << (m_MotionPipeline ? ", upscaling with the device's temporal upscaler" : "");
+}
+
+glm::vec2 TemporalAA::GetJitter(uint64 frame, uint32 width, uint32 height, uint32 phases) {
+    // Halton indices start at 1: index 0 is the pixel's corner in both bases
+    uint32 index = static_cast<uint32>(frame % std::max(phases, 1u)) + 1;
+    glm::vec2 offset(Halton(index, 2) - 0.5f, Halton(index, 3) - 0.5f);
+
+    // A pixel is 2 / size wide in NDC
+    return offset * glm::vec2(2.0f / static_cast<float>(std::max(width, 1u)),
+                              2.0f / static_cast<float>(std::max(height, 1u)));
+}
+
+glm::uvec2 TemporalAA::GetInputSize(uint32 width, uint32 height, float upscale) {
+    upscale = std::max(upscale, 1.0f);
+    return glm::uvec2(std::max(static_cast<uint32>(std::lround(width / upscale)), 1u),
+                      std::max(static_cast<uint32>(std::lround(height / upscale)), 1u));
+}
+
+uint32 TemporalAA::GetJitterPhases(float upscale) {
+    // As many phases per output pixel as without upscaling
+    upscale = std::max(upscale, 1.0f);
+    return static_cast<uint32>(std::ceil(JITTER_PHASES * upscale * upscale));
+}
+
+rhi::TextureUsage TemporalAA::GetOutputUsage() const {
+    // MetalFX writes its output as a render target
+    return m_MotionPipeline ? rhi::TextureUsage::ColorAttachment : static_cast<rhi::TextureUsage>(0);
+}
+
+void TemporalAA::SetSources(Ref<rhi::Texture> sceneColor, Ref<rhi::Texture> sceneDepth,
+                            Ref<rhi::Texture> motionVectors, Ref<rhi::Texture> motionDepth,
+                            Ref<rhi::Texture> output) {
+    using namespace rhi;
+
+    Ref<Texture> sources[5] = { sceneColor, sceneDepth, motionVectors, motionDepth, output };
+    if (std::equal(std::begin(sources), std::end(sources), std::begin(m_Sources))) {
+        return;
+    }
+
+    std::copy(std::begin(sources), std::end(sources), std::begin(m_Sources));
+    if (m_DescriptorSets[0]) {
+        m_Device->Retire(m_DescriptorSets[0]);
+        m_Device->Retire(m_DescriptorSets[1]);
+        m_DescriptorSets[0].reset();
+        m_DescriptorSets[1].reset();
+    }
+    if (m_MotionDescriptorSet) {
+        m_Device->Retire(m_MotionDescriptorSet);
+        m_MotionDescriptorSet.reset();
+    }
+    if (!IsValid() || !sceneColor || !sceneDepth || !motionVectors || !motionDepth) {
+        ReleaseUpscaler();
+        return;
+    }
+
+    // Upscaling goes to the device's upscaler where it takes the sources
+    if (!output || !CreateUpscaler()) {
+        ReleaseUpscaler();
+    }
+    if (m_Upscaler) {
+        DescriptorSetDesc motionDesc;
+        motionDesc.bindings = {
+            { 0, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, sceneDepth, m_PointSampler },
+            { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motionVectors, m_PointSampler },
+            { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motionDepth, m_PointSampler },
+            { 3, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_Motion, nullptr }
+        };
+        motionDesc.debugName = "TemporalAAMotionDescriptorSet";
+        m_MotionDescriptorSet = m_Device->CreateDescriptorSet(motionDesc);
+    }
+
+    // The history is of the output's size; without one the result goes back into the
+    // scene color, bound a second time
+    if (!output) {
+        output = sceneColor;
+    }
+    Resize(output->GetWidth(), output->GetHeight());
+    if (!m_History[0] || !m_History[1]) {
+        return;
+    }
+
+    for (uint32 i = 0; i < 2; ++i) {
+        DescriptorSetDesc desc;
+        desc.bindings = {
+            { 0, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, sceneColor, nullptr },
+            { 1, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, sceneDepth, m_PointSampler },
+            { 2, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motionVectors, m_PointSampler },
+            { 3, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, motionDepth, m_PointSampler },
+            { 4, DescriptorType::SampledTexture, ShaderStage::Compute, nullptr, m_History[1 - i], m_LinearSampler },
+            { 5, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, m_History[i], nullptr },
+            { 6, DescriptorType::StorageTexture, ShaderStage::Compute, nullptr, output, nullptr }
+        };
+        desc.debugName = i == 0 ? "TemporalAADescriptorSet0" : "TemporalAADescriptorSet1";
+        m_DescriptorSets[i] = m_Device->CreateDescriptorSet(desc);
+    }
+}
+
+bool TemporalAA::CreateUpscaler() {
+    using namespace rhi;
+
+    if (!m_MotionPipeline) {
+        return false;
+    }
+
+    TemporalUpscalerDesc desc{};
+    desc.inputWidth = m_Sources[0]->GetWidth();
+    desc.inputHeight = m_Sources[0]->GetHeight();
+    desc.outputWidth = m_Sources[4]->GetWidth();
+    desc.outputHeight = m_Sources[4]->GetHeight();
+    desc.colorFormat = m_Sources[0]->GetFormat();
+    desc.depthFormat = m_Sources[1]->GetFormat();
+    desc.motionFormat = MOTION_FORMAT;
+    desc.outputFormat = m_Sources[4]->GetFormat();
+    desc.debugName = "TemporalAAUpscaler";
+    if (m_Upscaler) {
+        const TemporalUpscalerDesc& current = m_Upscaler->GetDesc();
+        if (current.inputWidth == desc.inputWidth && current.inputHeight == desc.inputHeight &&
+            current.outputWidth == desc.outputWidth && current.outputHeight == desc.outputHeight &&
+            current.colorFormat == desc.colorFormat && current.depthFormat == desc.depthFormat &&
+            current.outputFormat == desc.outputFormat) {
+            return true;
+        }
+    }
+    ReleaseUpscaler();
+
+    TextureDesc motionDesc{};
+    motionDesc.width = desc.inputWidth;
+    motionDesc.height = desc.inputHeight;
+    motionDesc.format = MOTION_FORMAT;
+    motionDesc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    motionDesc.debugName = "TemporalAAMotion";
+    m_Motion = m_Device->CreateTexture(motionDesc);
+    m_Upscaler = m_Motion ? m_Device->CreateTemporalUpscaler(desc) : nullptr;
+    if (!m_Upscaler) {
+        METAGFX_WARN << "Temporal AA: the device's upscaler does not take " << desc.inputWidth << "x"
+                     << desc.inputHeight << " to " << desc.outputWidth << "x" << desc.outputHeight
+                     << "; upscaling in compute";
+        return false;
+    }
+    // The new upscaler's history starts empty
+    m_HistoryValid = false;
+    return true;
+}
+
+void TemporalAA::ReleaseUpscaler() {
+    if (m_Upscaler) {
+        m_Device->Retire(m_Upscaler);
+        m_Upscaler.reset();
+    }
+    if (m_Motion) {
+        m_Device->Retire(m_Motion);
+        m_Motion.reset();
+    }
+}
+
+void TemporalAA::Resize(uint32 width, uint32 height) {
+    using namespace rhi;
+
+    if (m_History[0] && m_History[0]->GetWidth() == width && m_History[0]->GetHeight() == height) {
+        return;
+    }
+
+    if (m_History[0]) {
+        m_Device->Retire(m_History[0]);
+        m_Device->Retire(m_History[1]);
+    }
+
+    // Written as storage, read back filtered by the next frame
+    TextureDesc historyDesc{};
+    historyDesc.width = width;
+    historyDesc.height = height;
+    historyDesc.format = HISTORY_FORMAT;
+    historyDesc.usage = TextureUsage::Storage | TextureUsage::Sampled;
+    historyDesc.debugName = "TemporalAAHistory0";
+    m_History[0] = m_Device->CreateTexture(historyDesc);
+    historyDesc.debugName = "TemporalAAHistory1";
+    m_History[1] = m_Device->CreateTexture(historyDesc);
+    if (!m_History[0] || !m_History[1]) {
+        METAGFX_ERROR << "Temporal AA: failed to create its history textures";
+    }
+    m_HistoryValid = false;
+}
+
+void TemporalAA::Resolve(rhi::CommandBuffer& cmd, uint32 frameIndex, const glm::mat4& reprojection,
+                         const glm::vec2& jitter, const glm::uvec2& inputSize) {
+    using namespace rhi;
+
+    const Ref<DescriptorSet>& descriptorSet = m_DescriptorSets[m_Current];
+    if (!descriptorSet) {
+        return;
+    }
+
+    TemporalAAPushConstants push{};
+    push.reprojection = reprojection;
+    push.historyValid = m_HistoryValid ? 1 : 0;
+    push.currentWeight = std::clamp(m_Settings.currentWeight, 0.01f, 1.0f);
+    push.sharpness = std::clamp(m_Settings.sharpness, 0.0f, 1.0f);
+    push.inputSize = glm::uvec2(m_Sources[0]->GetWidth(), m_Sources[0]->GetHeight());
+    if (inputSize.x > 0 && inputSize.y > 0) {
+        push.inputSize = glm::min(inputSize, push.inputSize);
+    }
+    // From NDC, 2 / size per texel, with the texture's y down like NDC's
+    push.jitter = jitter * 0.5f * glm::vec2(push.inputSize);
+
+    if (m_Upscaler && m_MotionDescriptorSet) {
+        TemporalAAMotionPushConstants motionPush{};
+        motionPush.reprojection = reprojection;
+        motionPush.inputSize = push.inputSize;
+        cmd.BindPipeline(m_MotionPipeline);
+        cmd.BindDescriptorSet(m_MotionPipeline, m_MotionDescriptorSet, frameIndex);
+        cmd.PushConstants(m_MotionPipeline, ShaderStage::Compute, 0, sizeof(motionPush), &motionPush);
+        cmd.Dispatch((push.inputSize.x + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE,
+                     (push.inputSize.y + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE);
+
+        // The motion is in texture coordinates of the drawn region
+        TemporalUpscaleFrame frame{};
+        frame.color = m_Sources[0].get();
+        frame.depth = m_Sources[1].get();
+        frame.motion = m_Motion.get();
+        frame.output = m_Sources[4].get();
+        frame.jitterX = push.jitter.x;
+        frame.jitterY = push.jitter.y;
+        frame.motionScaleX = static_cast<float>(push.inputSize.x);
+        frame.motionScaleY = static_cast<float>(push.inputSize.y);
+        frame.contentWidth = push.inputSize.x;
+        frame.contentHeight = push.inputSize.y;
+        frame.reset = !m_HistoryValid;
+        if (cmd.TemporalUpscale(*m_Upscaler, frame)) {
+            m_HistoryValid = true;
+            return;
+        }
+
+        // Until the sources change, the compute resolve upscales from an empty history
+        METAGFX_WARN << "Temporal AA: the device's upscaler cannot take the textures; upscaling in compute";
+        ReleaseUpscaler();
+        m_HistoryValid = false;
+    }
+    uint32 groupsX = (m_History[0]->GetWidth() + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE;
+    uint32 groupsY = (m_History[0]->GetHeight() + TAA_GROUP_SIZE - 1) / TAA_GROUP_SIZE;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, descriptorSet, frameIndex);
+
+    // The histories are not in the frame's graph: the last frame's resolve wrote the one
+    // read here, and read the one written
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 0;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(groupsX, groupsY);
+
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    push.pass = 1;
+    cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    cmd.Dispatch(groupsX, groupsY);
+
+    m_Current = 1 - m_Current;
+    m_HistoryValid = true;
+}
+
+} // namespace metagfx
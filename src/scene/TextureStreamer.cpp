@@ -0,0 +1,325 @@
+// ============================================================================
+// src/scene/TextureStreamer.cpp
+// ============================================================================
+#include "metagfx/scene/TextureStreamer.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/scene/Frustum.h"
+#include "metagfx/scene/Material.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/scene/Scene.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace metagfx {
+
+// Point every slot of the material holding from at to
+static void ReplaceMaterialTexture(Material& material, const Ref<rhi::Texture>& from, const Ref<rhi::Texture>& to) {
+    if (material.GetAlbedoMap() == from) {
+        material.SetAlbedoMap(to);
+    }
+    if (material.GetNormalMap() == from) {
+        material.SetNormalMap(to);
+    }
+    if (material.GetMetallicMap() == from) {
+        material.SetMetallicMap(to);
+    }
+    if (material.GetRoughnessMap() == from) {
+        material.SetRoughnessMap(to);
+    }
+    if (material.GetMetallicRoughnessMap() == from) {
+        material.SetMetallicRoughnessMap(to);
+    }
+    if (material.GetAOMap() == from) {
+        material.SetAOMap(to);
+    }
+    if (material.GetEmissiveMap() == from) {
+        material.SetEmissiveMap(to);
+    }
+}
+
+static bool MaterialUses(const Material& material, const Ref<rhi::Texture>& texture) {
+    return material.GetAlbedoMap() == texture || material.GetNormalMap() == texture ||
+           material.GetMetallicMap() == texture || material.GetRoughnessMap() == texture ||
+           material.GetMetallicRoughnessMap() == texture || material.GetAOMap() == texture ||
+           material.GetEmissiveMap() == texture;
+}
+
+// Smallest power of two at or above value
+static uint32 CeilPowerOfTwo(uint32 value) {
+    uint32 result = 1;
+    while (result < value && result < (1u << 31)) {
+        result <<= 1;
+    }
+    return result;
+}
+
+TextureStreamer::TextureStreamer(Ref<rhi::GraphicsDevice> device)
+    : m_Device(device) {
+}
+
+TextureStreamer::~TextureStreamer() {
+    WaitForLoads();
+}
+
+void TextureStreamer::SetModel(Model* model) {
+    WaitForLoads();
+    m_Loads.clear();
+    m_Entries.clear();
+    m_MaterialEntries.clear();
+    m_Stats = Stats{};
+    m_Model = model;
+    if (!model) {
+        return;
+    }
+
+    for (const StreamableTexture& streamable : model->GetStreamableTextures()) {
+        Entry entry;
+        entry.base = streamable.texture;
+        entry.path = streamable.path;
+        m_Entries.push_back(std::move(entry));
+    }
+
+    for (const auto& mesh : model->GetMeshes()) {
+        Material* material = mesh ? mesh->GetMaterial() : nullptr;
+        if (!material || m_MaterialEntries.count(material)) {
+            continue;
+        }
+        std::vector<uint32> entries;
+        for (uint32 i = 0; i < m_Entries.size(); ++i) {
+            if (MaterialUses(*material, m_Entries[i].base)) {
+                entries.push_back(i);
+                m_Entries[i].materials.push_back(material);
+            }
+        }
+        if (!entries.empty()) {
+            m_MaterialEntries[material] = std::move(entries);
+        }
+    }
+
+    m_Stats.textureCount = static_cast<uint32>(m_Entries.size());
+    if (!m_Entries.empty()) {
+        METAGFX_INFO << "Texture streaming: " << m_Entries.size() << " textures loaded without their largest mips";
+    }
+}
+
+bool TextureStreamer::Update(const Scene& scene, const glm::mat4& modelMatrix, const glm::mat4& viewProjection,
+                             const glm::mat4& projection, const glm::vec3& eye, float viewportHeight) {
+    ++m_Frame;
+    if (m_Entries.empty()) {
+        return false;
+    }
+
+    // Texels each texture needs: the most any visible mesh using it spans on screen
+    for (Entry& entry : m_Entries) {
+        entry.wantedExtent = 0;
+    }
+    Frustum frustum = Frustum::FromMatrix(viewProjection);
+    bool perspective = projection[2][3] != 0.0f;
+    float pixelsPerUnit = std::abs(projection[1][1]) * viewportHeight * 0.5f;
+    float texelsPerPixel = std::max(m_Settings.texelsPerPixel, 0.0f);
+
+    for (uint32 instance = 0; instance < scene.GetMeshInstanceCount(); ++instance) {
+        const MeshInstance& entry = scene.GetMeshInstance(instance);
+        const Material* material = entry.mesh ? entry.mesh->GetMaterial() : nullptr;
+        auto it = material ? m_MaterialEntries.find(material) : m_MaterialEntries.end();
+        if (it == m_MaterialEntries.end()) {
+            continue;
+        }
+
+        glm::mat4 world = modelMatrix * entry.transform;
+        float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])),
+                                 glm::length(glm::vec3(world[2])) });
+        glm::vec3 center = glm::vec3(world * glm::vec4(entry.mesh->GetBoundsCenter(), 1.0f));
+        float radius = entry.mesh->GetBoundsRadius() * scale;
+        if (!frustum.IntersectsSphere(center, radius)) {
+            continue;
+        }
+
+        // Inside the sphere the mesh may fill the screen and more: everything it has
+        float distance = perspective ? glm::length(center - eye) - radius : 1.0f;
+        float pixels = distance > 0.0f ? 2.0f * radius * pixelsPerUnit / distance
+                                       : static_cast<float>(std::numeric_limits<uint32>::max());
+        float texels = std::min(pixels * texelsPerPixel, static_cast<float>(1u << 31));
+        uint32 wanted = static_cast<uint32>(std::ceil(texels));
+
+        for (uint32 index : it->second) {
+            m_Entries[index].wantedExtent = std::max(m_Entries[index].wantedExtent, wanted);
+            m_Entries[index].lastSeenFrame = m_Frame;
+        }
+    }
+
+    // A budget that shrank (the device's, as other processes take memory) evicts too
+    uint64 budget = ComputeBudget();
+    uint64 evictions = m_Stats.evictions;
+    MakeRoom(0, budget, nullptr);
+    bool changed = m_Stats.evictions != evictions;
+
+    changed = FinishLoads(budget) || changed;
+    StartLoads();
+
+    m_Stats.budgetBytes = budget;
+    m_Stats.streamedCount = static_cast<uint32>(std::count_if(m_Entries.begin(), m_Entries.end(),
+        [](const Entry& entry) { return entry.streamed != nullptr; }));
+    m_Stats.loadsInFlight = static_cast<uint32>(m_Loads.size());
+    return changed;
+}
+
+uint64 TextureStreamer::ComputeBudget() const {
+    if (m_Settings.budgetBytes > 0) {
+        return m_Settings.budgetBytes;
+    }
+
+    // What the process leaves free of the device's budget, plus what streaming already
+    // takes of it, so the budget does not shrink as the textures stream in
+    rhi::MemoryBudget device = m_Device->GetMemoryBudget();
+    if (device.budgetBytes == 0) {
+        return FALLBACK_BUDGET_BYTES;
+    }
+    uint64 free = device.budgetBytes > device.usageBytes ? device.budgetBytes - device.usageBytes : 0;
+    float fraction = std::clamp(m_Settings.deviceBudgetFraction, 0.0f, 1.0f);
+    return static_cast<uint64>(static_cast<double>(free + m_Stats.streamedBytes) * fraction);
+}
+
+uint32 TextureStreamer::GetResidentExtent(const Entry& entry) const {
+    const Ref<rhi::Texture>& texture = entry.streamed ? entry.streamed : entry.base;
+    return std::max(texture->GetWidth(), texture->GetHeight());
+}
+
+void TextureStreamer::Replace(Entry& entry, Ref<rhi::Texture> texture, uint64 bytes) {
+    const Ref<rhi::Texture>& current = entry.streamed ? entry.streamed : entry.base;
+    const Ref<rhi::Texture>& next = texture ? texture : entry.base;
+    for (Material* material : entry.materials) {
+        ReplaceMaterialTexture(*material, current, next);
+    }
+
+    // Still sampled by frames in flight
+    m_Device->Retire(entry.streamed);
+    m_Stats.streamedBytes -= entry.streamedBytes;
+    entry.streamed = std::move(texture);
+    entry.streamedBytes = entry.streamed ? bytes : 0;
+    m_Stats.streamedBytes += entry.streamedBytes;
+}
+
+bool TextureStreamer::MakeRoom(uint64 bytes, uint64 budget, const Entry* keep) {
+    // Textures on screen this frame are only evicted for a budget that shrank (bytes 0)
+    while (m_Stats.streamedBytes + bytes > budget) {
+        Entry* victim = nullptr;
+        for (Entry& entry : m_Entries) {
+            if (!entry.streamed || &entry == keep || (bytes > 0 && entry.lastSeenFrame == m_Frame)) {
+                continue;
+            }
+            if (!victim || entry.lastSeenFrame < victim->lastSeenFrame ||
+                (entry.lastSeenFrame == victim->lastSeenFrame && entry.streamedBytes > victim->streamedBytes)) {
+                victim = &entry;
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+        Replace(*victim, nullptr, 0);
+        victim->retryFrame = m_Frame + m_Settings.retryFrames;
+        ++m_Stats.evictions;
+    }
+    return true;
+}
+
+bool TextureStreamer::FinishLoads(uint64 budget) {
+    bool changed = false;
+    for (auto it = m_Loads.begin(); it != m_Loads.end(); ) {
+        Load& load = **it;
+        if (!load.done.IsDone()) {
+            ++it;
+            continue;
+        }
+
+        Entry& entry = m_Entries[load.entry];
+        entry.loading = false;
+        if (load.loaded) {
+            entry.fullExtent = std::max(load.chain.baseWidth, load.chain.baseHeight);
+        }
+
+        // Worth a texture only when it holds more than the entry does now
+        uint32 extent = std::max(load.chain.width, load.chain.height);
+        if (load.loaded && extent > GetResidentExtent(entry)) {
+            uint64 bytes = 0;
+            uint32 width = load.chain.width;
+            uint32 height = load.chain.height;
+            for (uint32 mip = 0; mip < load.chain.mipLevels; ++mip) {
+                bytes += rhi::GetFormatImageSize(load.chain.format, std::max(1u, width >> mip),
+                                                 std::max(1u, height >> mip));
+            }
+
+            // The entry's own streamed texture goes once the new one replaces it
+            uint64 freed = entry.streamedBytes;
+            uint64 needed = bytes > freed ? bytes - freed : 0;
+            if (MakeRoom(needed, budget, &entry)) {
+                rhi::ResourceGroupScope groupScope(m_Model->GetResourceGroup());
+                Ref<rhi::Texture> texture = utils::CreateTextureFromMipChain(m_Device.get(), load.chain,
+                                                                             load.path.c_str());
+                if (texture) {
+                    Replace(entry, texture, bytes);
+                    ++m_Stats.loads;
+                    changed = true;
+                }
+            } else {
+                entry.retryFrame = m_Frame + m_Settings.retryFrames;
+            }
+        } else if (!load.loaded) {
+            // A file that fails once is not read again for this model
+            entry.fullExtent = GetResidentExtent(entry);
+        }
+
+        it = m_Loads.erase(it);
+    }
+    return changed;
+}
+
+void TextureStreamer::StartLoads() {
+    // Entries short of the most texels, relative to what they hold, go first
+    std::vector<uint32> candidates;
+    for (uint32 i = 0; i < m_Entries.size(); ++i) {
+        const Entry& entry = m_Entries[i];
+        uint32 resident = GetResidentExtent(entry);
+        bool complete = entry.fullExtent != 0 && resident >= entry.fullExtent;
+        if (!entry.loading && !complete && entry.wantedExtent > resident && m_Frame >= entry.retryFrame) {
+            candidates.push_back(i);
+        }
+    }
+    std::sort(candidates.begin(), candidates.end(), [&](uint32 a, uint32 b) {
+        const Entry& entryA = m_Entries[a];
+        const Entry& entryB = m_Entries[b];
+        return static_cast<uint64>(entryA.wantedExtent) * GetResidentExtent(entryB) >
+               static_cast<uint64>(entryB.wantedExtent) * GetResidentExtent(entryA);
+    });
+
+    rhi::GraphicsDevice* device = m_Device.get();
+    for (uint32 index : candidates) {
+        if (m_Loads.size() >= std::max(m_Settings.maxLoadsInFlight, 1u)) {
+            break;
+        }
+        Entry& entry = m_Entries[index];
+        entry.loading = true;
+
+        auto load = std::make_unique<Load>();
+        load->entry = index;
+        load->maxExtent = CeilPowerOfTwo(entry.wantedExtent);
+        load->path = entry.path;
+        Load* job = load.get();
+        JobSystem::Run([device, job]() {
+            job->loaded = utils::LoadTextureMipChain(device, job->path, job->chain, job->maxExtent);
+        }, &load->done);
+        m_Loads.push_back(std::move(load));
+    }
+}
+
+void TextureStreamer::WaitForLoads() {
+    for (auto& load : m_Loads) {
+        JobSystem::Wait(load->done);
+    }
+}
+
+} // namespace metagfx
@@ -0,0 +1,123 @@
+// ============================================================================
+// src/scene/ToneMapper.cpp
+// ============================================================================
+#include "metagfx/scene/ToneMapper.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+namespace metagfx {
+
+namespace {
+
+// tonemap.frag's push constants
+struct ToneMapPushConstants {
+    float exposure;
+    uint32 toneMapOperator;
+    uint32 autoExposure;
+};
+
+} // namespace
+
+ToneMapper::ToneMapper(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader,
+                       Ref<rhi::Shader> fragmentShader)
+    : m_Device(device) {
+    using namespace rhi;
+
+    // AutoExposure::ExposureState of a frame without auto exposure, so binding 1 is
+    // always a buffer
+    const float defaultExposure[2] = { 0.18f, 1.0f };
+    BufferDesc exposureDesc{};
+    exposureDesc.size = sizeof(defaultExposure);
+    exposureDesc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    exposureDesc.memoryUsage = MemoryUsage::GPUOnly;
+    exposureDesc.debugName = "DefaultExposure";
+    m_DefaultExposure = device->CreateBuffer(exposureDesc);
+    if (m_DefaultExposure) {
+        m_DefaultExposure->CopyData(defaultExposure, sizeof(defaultExposure));
+    }
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The scene color comes with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_DefaultExposure, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "ToneMapLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    // A triangle over the viewport, made by the vertex shader, into the back buffer alone
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertexShader;
+    pipelineDesc.fragmentShader = fragmentShader;
+    pipelineDesc.vertexInput.stride = 0;
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+    pipelineDesc.depthStencil.depthTestEnable = false;
+    pipelineDesc.depthStencil.depthWriteEnable = false;
+    pipelineDesc.depthFormat = Format::Undefined;
+    pipelineDesc.debugName = "ToneMapPipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateGraphicsPipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Tone mapping unavailable: failed to create its pipeline";
+        return;
+    }
+    METAGFX_INFO << "Tone mapper created: HDR scene color";
+}
+
+void ToneMapper::SetSource(Ref<rhi::Texture> sceneColor, Ref<rhi::Buffer> exposureBuffer) {
+    using namespace rhi;
+
+    if (!exposureBuffer) {
+        exposureBuffer = m_DefaultExposure;
+    }
+    if (sceneColor == m_SceneColor && exposureBuffer == m_ExposureBuffer) {
+        return;
+    }
+
+    if (m_DescriptorSet) {
+        m_Device->Retire(m_DescriptorSet);
+        m_DescriptorSet.reset();
+    }
+    m_SceneColor = sceneColor;
+    m_ExposureBuffer = exposureBuffer;
+    if (!IsValid() || !m_SceneColor || !m_ExposureBuffer) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_SceneColor, m_PointSampler },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Fragment, m_ExposureBuffer, nullptr, nullptr }
+    };
+    desc.debugName = "ToneMapDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void ToneMapper::Apply(rhi::CommandBuffer& cmd, uint32 frameIndex, const Settings& settings) {
+    if (!m_DescriptorSet) {
+        return;
+    }
+
+    ToneMapPushConstants pushConstants{};
+    pushConstants.exposure = settings.exposure;
+    pushConstants.toneMapOperator = static_cast<uint32>(settings.toneMapOperator);
+    pushConstants.autoExposure = settings.autoExposure ? 1u : 0u;
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+    cmd.PushConstants(m_Pipeline, rhi::ShaderStage::Fragment, 0, sizeof(pushConstants), &pushConstants);
+    cmd.Draw(3);
+}
+
+} // namespace metagfx
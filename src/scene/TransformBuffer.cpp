@@ -0,0 +1,153 @@
+// ============================================================================
+// src/scene/TransformBuffer.cpp
+// ============================================================================
+#include "metagfx/scene/TransformBuffer.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace metagfx {
+
+TransformBuffer::TransformBuffer(Ref<rhi::GraphicsDevice> device, uint32 capacity, uint32 framesInFlight)
+    : m_Device(std::move(device))
+    , m_Capacity(capacity) {
+    using namespace rhi;
+
+    BufferDesc desc{};
+    desc.size = static_cast<uint64>(capacity) * sizeof(NodeTransform);
+    desc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    desc.memoryUsage = MemoryUsage::GPUOnly;
+    desc.debugName = "NodeTransforms";
+    m_Buffer = m_Device->CreateBuffer(desc);
+    desc.debugName = "PreviousNodeTransforms";
+    m_PreviousBuffer = m_Device->CreateBuffer(desc);
+    if (!m_PreviousBuffer) {
+        m_Buffer.reset();
+    }
+
+    desc.size *= 2;
+    desc.usage = BufferUsage::TransferSrc;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "NodeTransformStaging";
+    for (uint32 i = 0; i < framesInFlight && m_Buffer; ++i) {
+        Ref<Buffer> staging = m_Device->CreateBuffer(desc);
+        if (!staging) {
+            m_Buffer.reset();
+            break;
+        }
+        m_Staging.push_back(staging);
+    }
+
+    if (!m_Buffer) {
+        METAGFX_ERROR << "Failed to create the node transform buffer (" << capacity << " nodes)";
+        m_PreviousBuffer.reset();
+        m_Staging.clear();
+        return;
+    }
+    m_Uploaded.assign(capacity, NodeTransform{});
+}
+
+void TransformBuffer::CopyRuns(rhi::CommandBuffer& cmd, const Ref<rhi::Buffer>& staging, uint64 stagingBase,
+                               const Ref<rhi::Buffer>& dst, const std::vector<uint32>& nodes,
+                               const std::function<NodeTransform(uint32)>& transform) {
+    auto* mapped = static_cast<uint8*>(staging->GetMappedPointer());
+
+    size_t runStart = 0;
+    while (runStart < nodes.size()) {
+        size_t runEnd = runStart + 1;
+        while (runEnd < nodes.size() && nodes[runEnd] == nodes[runEnd - 1] + 1) {
+            ++runEnd;
+        }
+
+        m_Transforms.clear();
+        for (size_t i = runStart; i < runEnd; ++i) {
+            m_Transforms.push_back(transform(nodes[i]));
+        }
+
+        uint64 offset = static_cast<uint64>(nodes[runStart]) * sizeof(NodeTransform);
+        uint64 size = m_Transforms.size() * sizeof(NodeTransform);
+        if (mapped) {
+            std::memcpy(mapped + stagingBase + offset, m_Transforms.data(), size);
+        } else {
+            staging->CopyData(m_Transforms.data(), size, stagingBase + offset);
+        }
+        cmd.CopyBuffer(staging, dst, size, stagingBase + offset, offset);
+
+        runStart = runEnd;
+    }
+}
+
+uint32 TransformBuffer::Upload(rhi::CommandBuffer& cmd, uint32 frameIndex, const SceneGraph& graph,
+                               const glm::mat4& basis) {
+    METAGFX_PROFILE_SCOPE("Transform upload");
+    if (!m_Buffer) {
+        return 0;
+    }
+
+    if (std::memcmp(&basis, &m_Basis, sizeof(glm::mat4)) != 0) {
+        m_Basis = basis;
+        m_Invalid = true;
+    }
+
+    uint32 nodeCount = std::min(graph.GetNodeCount(), m_Capacity);
+    if (graph.GetNodeCount() > m_Capacity && !m_OverflowReported) {
+        METAGFX_WARN << "Scene graph has " << graph.GetNodeCount() << " nodes, only the first " << m_Capacity
+                     << " are uploaded";
+        m_OverflowReported = true;
+    }
+
+    m_Nodes.clear();
+    if (m_Invalid) {
+        for (uint32 node = 0; node < nodeCount; ++node) {
+            m_Nodes.push_back(node);
+        }
+        m_Invalid = false;
+    } else {
+        for (uint32 node : graph.GetUpdatedNodes()) {
+            if (node < nodeCount) {
+                m_Nodes.push_back(node);
+            }
+        }
+        std::sort(m_Nodes.begin(), m_Nodes.end());
+    }
+    if (m_Nodes.empty() && m_LastNodes.empty()) {
+        return 0;
+    }
+
+    // The previous matrix of a node changed now or by the last upload is the one in the
+    // current buffer; everything else already matches
+    m_PreviousNodes.clear();
+    std::set_union(m_Nodes.begin(), m_Nodes.end(), m_LastNodes.begin(), m_LastNodes.end(),
+                   std::back_inserter(m_PreviousNodes));
+
+    // Stage at the destination offsets (previous matrices in the second half), then copy
+    // each run of consecutive nodes
+    const Ref<rhi::Buffer>& staging = m_Staging[frameIndex % m_Staging.size()];
+    glm::mat4 inverseBasis = glm::inverse(m_Basis);
+
+    // Previous frames' vertex shaders may still read the matrices being replaced
+    cmd.PipelineBarrier(rhi::BarrierType::GraphicsToTransfer);
+
+    CopyRuns(cmd, staging, static_cast<uint64>(m_Capacity) * sizeof(NodeTransform), m_PreviousBuffer,
+             m_PreviousNodes, [&](uint32 node) { return m_Uploaded[node]; });
+    CopyRuns(cmd, staging, 0, m_Buffer, m_Nodes, [&](uint32 node) {
+        NodeTransform& uploaded = m_Uploaded[node];
+        uploaded.world = inverseBasis * graph.GetWorldTransform(node) * m_Basis;
+        glm::mat3 normal = glm::transpose(glm::inverse(glm::mat3(uploaded.world)));
+        for (int column = 0; column < 3; ++column) {
+            uploaded.normal[column] = glm::vec4(normal[column], 0.0f);
+        }
+        return uploaded;
+    });
+    m_LastNodes.swap(m_Nodes);
+
+    cmd.PipelineBarrier(rhi::BarrierType::TransferToGraphics);
+    return static_cast<uint32>(m_LastNodes.size());
+}
+
+} // namespace metagfx
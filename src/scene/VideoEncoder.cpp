@@ -0,0 +1,240 @@
+// ============================================================================
+// src/scene/VideoEncoder.cpp
+// ============================================================================
+#include "metagfx/scene/VideoEncoder.h"
+#include "metagfx/core/Logger.h"
+
+#if defined(__APPLE__)
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreMedia/CoreMedia.h>
+#include <CoreVideo/CoreVideo.h>
+#include <VideoToolbox/VideoToolbox.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#endif
+
+namespace metagfx {
+
+#if defined(__APPLE__)
+
+namespace {
+
+constexpr uint8 START_CODE[] = { 0, 0, 0, 1 };
+
+void SetNumber(VTCompressionSessionRef session, CFStringRef key, int32_t value) {
+    CFNumberRef number = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &value);
+    VTSessionSetProperty(session, key, number);
+    CFRelease(number);
+}
+
+class VideoToolboxEncoder final : public VideoEncoder {
+public:
+    VideoToolboxEncoder(const Settings& settings, PacketCallback callback)
+        : VideoEncoder(settings), m_Callback(std::move(callback)) {
+        // The hardware encoder or none: the software one would cost more than raw NV12
+        CFMutableDictionaryRef specification = CFDictionaryCreateMutable(
+            kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        CFDictionarySetValue(specification, kVTVideoEncoderSpecification_RequireHardwareAcceleratedVideoEncoder,
+                             kCFBooleanTrue);
+
+        // Pooled IOSurface-backed NV12 buffers, the layout StreamEncoder writes
+        int32_t pixelFormat = kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+        int32_t width = static_cast<int32_t>(settings.width);
+        int32_t height = static_cast<int32_t>(settings.height);
+        CFNumberRef formatNumber = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &pixelFormat);
+        CFNumberRef widthNumber = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &width);
+        CFNumberRef heightNumber = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &height);
+        CFDictionaryRef surfaceProperties = CFDictionaryCreate(
+            kCFAllocatorDefault, nullptr, nullptr, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        CFMutableDictionaryRef bufferAttributes = CFDictionaryCreateMutable(
+            kCFAllocatorDefault, 0, &kCFTypeDictionaryKeyCallBacks, &kCFTypeDictionaryValueCallBacks);
+        CFDictionarySetValue(bufferAttributes, kCVPixelBufferPixelFormatTypeKey, formatNumber);
+        CFDictionarySetValue(bufferAttributes, kCVPixelBufferWidthKey, widthNumber);
+        CFDictionarySetValue(bufferAttributes, kCVPixelBufferHeightKey, heightNumber);
+        CFDictionarySetValue(bufferAttributes, kCVPixelBufferIOSurfacePropertiesKey, surfaceProperties);
+
+        OSStatus status = VTCompressionSessionCreate(kCFAllocatorDefault, width, height, kCMVideoCodecType_H264,
+                                                     specification, bufferAttributes, kCFAllocatorDefault,
+                                                     &VideoToolboxEncoder::OnFrameEncoded, this, &m_Session);
+        CFRelease(bufferAttributes);
+        CFRelease(surfaceProperties);
+        CFRelease(heightNumber);
+        CFRelease(widthNumber);
+        CFRelease(formatNumber);
+        CFRelease(specification);
+        if (status != noErr || !m_Session) {
+            METAGFX_WARN << "Video encoder: no hardware H.264 encoder for " << settings.width << "x"
+                         << settings.height << " (VideoToolbox status " << status << ")";
+            m_Session = nullptr;
+            return;
+        }
+
+        // Real time and in order: each frame leaves before the next arrives
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_RealTime, kCFBooleanTrue);
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_AllowFrameReordering, kCFBooleanFalse);
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_ProfileLevel, kVTProfileLevel_H264_High_AutoLevel);
+        SetNumber(m_Session, kVTCompressionPropertyKey_AverageBitRate,
+                  static_cast<int32_t>(std::min<uint64>(settings.bitrateKbps * 1000ull, INT32_MAX)));
+        SetNumber(m_Session, kVTCompressionPropertyKey_ExpectedFrameRate, static_cast<int32_t>(settings.frameRate));
+        SetNumber(m_Session, kVTCompressionPropertyKey_MaxKeyFrameInterval,
+                  static_cast<int32_t>(std::max(settings.keyFrameInterval, 1u)));
+        // stream_encode.comp's BT.709 limited range
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_ColorPrimaries, kCVImageBufferColorPrimaries_ITU_R_709_2);
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_TransferFunction,
+                             kCVImageBufferTransferFunction_ITU_R_709_2);
+        VTSessionSetProperty(m_Session, kVTCompressionPropertyKey_YCbCrMatrix, kCVImageBufferYCbCrMatrix_ITU_R_709_2);
+        VTCompressionSessionPrepareToEncodeFrames(m_Session);
+    }
+
+    ~VideoToolboxEncoder() override {
+        if (m_Session) {
+            VTCompressionSessionCompleteFrames(m_Session, kCMTimeInvalid);
+            VTCompressionSessionInvalidate(m_Session);
+            CFRelease(m_Session);
+        }
+    }
+
+    bool IsValid() const { return m_Session != nullptr; }
+
+    bool Encode(const uint8* nv12, uint32 pitch, uint64 frameNumber, uint64 encodeTimeNs, bool keyFrame) override {
+        CVPixelBufferPoolRef pool = VTCompressionSessionGetPixelBufferPool(m_Session);
+        CVPixelBufferRef pixelBuffer = nullptr;
+        if (!pool || CVPixelBufferPoolCreatePixelBuffer(kCFAllocatorDefault, pool, &pixelBuffer) != kCVReturnSuccess) {
+            return false;
+        }
+
+        // Row by row: the pool's rows are aligned to its own pitch
+        uint32 paddedHeight = (m_Settings.height + 1) / 2 * 2;
+        const uint8* planes[2] = { nv12, nv12 + static_cast<uint64>(pitch) * paddedHeight };
+        CVPixelBufferLockBaseAddress(pixelBuffer, 0);
+        for (size_t plane = 0; plane < 2; ++plane) {
+            auto* target = static_cast<uint8*>(CVPixelBufferGetBaseAddressOfPlane(pixelBuffer, plane));
+            size_t targetPitch = CVPixelBufferGetBytesPerRowOfPlane(pixelBuffer, plane);
+            size_t rows = std::min<size_t>(CVPixelBufferGetHeightOfPlane(pixelBuffer, plane),
+                                           plane == 0 ? paddedHeight : paddedHeight / 2);
+            size_t rowBytes = std::min<size_t>(targetPitch, pitch);
+            for (size_t row = 0; row < rows; ++row) {
+                std::memcpy(target + row * targetPitch, planes[plane] + row * pitch, rowBytes);
+            }
+        }
+        CVPixelBufferUnlockBaseAddress(pixelBuffer, 0);
+
+        CFDictionaryRef frameProperties = nullptr;
+        if (keyFrame) {
+            const void* keys[] = { kVTEncodeFrameOptionKey_ForceKeyFrame };
+            const void* values[] = { kCFBooleanTrue };
+            frameProperties = CFDictionaryCreate(kCFAllocatorDefault, keys, values, 1, &kCFTypeDictionaryKeyCallBacks,
+                                                 &kCFTypeDictionaryValueCallBacks);
+        }
+        // The frame number rides along as the frame's refcon, the encode time as its
+        // presentation time
+        CMTime presentationTime = CMTimeMake(static_cast<int64_t>(encodeTimeNs), 1000000000);
+        OSStatus status = VTCompressionSessionEncodeFrame(m_Session, pixelBuffer, presentationTime, kCMTimeInvalid,
+                                                          frameProperties,
+                                                          reinterpret_cast<void*>(static_cast<uintptr_t>(frameNumber)),
+                                                          nullptr);
+        if (frameProperties) {
+            CFRelease(frameProperties);
+        }
+        CVPixelBufferRelease(pixelBuffer);
+        if (status != noErr) {
+            METAGFX_ERROR << "Video encoder: frame " << frameNumber << " failed (VideoToolbox status " << status << ")";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    static void OnFrameEncoded(void* encoderRefcon, void* frameRefcon, OSStatus status, VTEncodeInfoFlags flags,
+                               CMSampleBufferRef sample) {
+        auto* encoder = static_cast<VideoToolboxEncoder*>(encoderRefcon);
+        if (status != noErr || !sample || (flags & kVTEncodeInfo_FrameDropped)) {
+            return;
+        }
+
+        Packet packet;
+        packet.frameNumber = static_cast<uint64>(reinterpret_cast<uintptr_t>(frameRefcon));
+        packet.encodeTimeNs = static_cast<uint64>(CMSampleBufferGetPresentationTimeStamp(sample).value);
+        packet.keyFrame = true;
+        CFArrayRef attachments = CMSampleBufferGetSampleAttachmentsArray(sample, false);
+        if (attachments && CFArrayGetCount(attachments) > 0) {
+            auto attachment = static_cast<CFDictionaryRef>(CFArrayGetValueAtIndex(attachments, 0));
+            CFBooleanRef notSync = nullptr;
+            if (CFDictionaryGetValueIfPresent(attachment, kCMSampleAttachmentKey_NotSync,
+                                              reinterpret_cast<const void**>(&notSync))) {
+                packet.keyFrame = !CFBooleanGetValue(notSync);
+            }
+        }
+
+        // Key frames carry the parameter sets, which the sample keeps in its format
+        CMFormatDescriptionRef format = CMSampleBufferGetFormatDescription(sample);
+        int nalLengthSize = 4;
+        size_t parameterSetCount = 0;
+        CMVideoFormatDescriptionGetH264ParameterSetAtIndex(format, 0, nullptr, nullptr, &parameterSetCount,
+                                                           &nalLengthSize);
+        for (size_t i = 0; packet.keyFrame && i < parameterSetCount; ++i) {
+            const uint8_t* parameterSet = nullptr;
+            size_t size = 0;
+            if (CMVideoFormatDescriptionGetH264ParameterSetAtIndex(format, i, &parameterSet, &size, nullptr, nullptr) ==
+                noErr) {
+                packet.data.insert(packet.data.end(), std::begin(START_CODE), std::end(START_CODE));
+                packet.data.insert(packet.data.end(), parameterSet, parameterSet + size);
+            }
+        }
+
+        // The sample's NAL units are length-prefixed (AVCC); Annex B starts each with a code
+        CMBlockBufferRef block = CMSampleBufferGetDataBuffer(sample);
+        size_t blockSize = CMBlockBufferGetDataLength(block);
+        std::vector<uint8>& units = encoder->m_Units;
+        units.resize(blockSize);
+        if (CMBlockBufferCopyDataBytes(block, 0, blockSize, units.data()) != kCMBlockBufferNoErr) {
+            return;
+        }
+        size_t lengthSize = static_cast<size_t>(std::clamp(nalLengthSize, 1, 4));
+        for (size_t offset = 0; offset + lengthSize <= blockSize;) {
+            size_t length = 0;
+            for (size_t i = 0; i < lengthSize; ++i) {
+                length = (length << 8) | units[offset + i];
+            }
+            offset += lengthSize;
+            if (length > blockSize - offset) {
+                break;
+            }
+            packet.data.insert(packet.data.end(), std::begin(START_CODE), std::end(START_CODE));
+            packet.data.insert(packet.data.end(), units.begin() + offset, units.begin() + offset + length);
+            offset += length;
+        }
+        encoder->m_Callback(std::move(packet));
+    }
+
+    VTCompressionSessionRef m_Session = nullptr;
+    PacketCallback m_Callback;
+    std::vector<uint8> m_Units;  // The encoder thread's copy of a sample
+};
+
+} // namespace
+
+std::unique_ptr<VideoEncoder> VideoEncoder::CreateH264(const Settings& settings, PacketCallback callback) {
+    auto encoder = std::make_unique<VideoToolboxEncoder>(settings, std::move(callback));
+    if (!encoder->IsValid()) {
+        return nullptr;
+    }
+    METAGFX_INFO << "Video encoder created: VideoToolbox H.264, " << settings.width << "x" << settings.height
+                 << " at " << settings.bitrateKbps << " kbps";
+    return encoder;
+}
+
+#else
+
+// Vulkan Video encode is not wired in: streams stay raw NV12 off Apple platforms
+std::unique_ptr<VideoEncoder> VideoEncoder::CreateH264(const Settings& settings, PacketCallback callback) {
+    (void)settings;
+    (void)callback;
+    return nullptr;
+}
+
+#endif
+
+} // namespace metagfx
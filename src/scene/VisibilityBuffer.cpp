@@ -0,0 +1,349 @@
+// ============================================================================
+// src/scene/VisibilityBuffer.cpp
+// ============================================================================
+#include "metagfx/scene/VisibilityBuffer.h"
+#include "metagfx/scene/GeometryPool.h"
+#include "metagfx/scene/GPUCuller.h"
+#include "metagfx/scene/Mesh.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include <iterator>
+
+namespace metagfx {
+
+// Bindings of the main set the resolve reads: frame constants and node transforms
+constexpr uint32 VISIBILITY_SCENE_BINDINGS[] = { 0, 15 };
+
+// Bindings of visibility_resolve.comp besides the scene's; 1, 14 and 30 as the bindless
+// main pass's, 23 and 24 as path_trace.comp's
+constexpr uint32 MATERIAL_BINDING = 1;
+constexpr uint32 TEXTURE_TABLE_BINDING = 14;
+constexpr uint32 VERTEX_BINDING = 23;
+constexpr uint32 INDEX_BINDING = 24;
+constexpr uint32 RECORD_BINDING = 30;
+constexpr uint32 CLUSTER_RECORD_BINDING = 31;
+constexpr uint32 MESH_MATERIAL_BINDING = 32;
+constexpr uint32 MATERIAL_BIN_BINDING = 33;
+constexpr uint32 PIXEL_BINDING = 34;
+constexpr uint32 VISIBILITY_BINDING = 35;
+constexpr uint32 GBUFFER_BINDING = 36;
+
+constexpr uint32 COMPACT_MESH = 0x80000000u;  // Of a mesh's material entry
+
+// Push constants of visibility_resolve.comp
+struct ResolvePushConstants {
+    uint32 mode;
+    uint32 materialCount;
+    glm::uvec2 size;
+};
+
+enum ResolveMode : uint32 {
+    ResolveClear,
+    ResolveCount,
+    ResolveScan,
+    ResolveScatter,
+    ResolveShade
+};
+
+VisibilityBuffer::VisibilityBuffer(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> resolveShader,
+                                   const std::vector<rhi::DescriptorBindingDesc>& sceneBindings,
+                                   uint32 textureCapacity)
+    : m_Device(device), m_TextureCapacity(textureCapacity) {
+    using namespace rhi;
+
+    const DeviceInfo& info = device->GetDeviceInfo();
+    if (!info.supportsBindlessTextures || info.maxBindlessTextures < textureCapacity ||
+        !info.supportsDrawIndirectFirstInstance || !info.supportsPrimitiveId) {
+        METAGFX_INFO << "Visibility buffer unavailable: the device lacks bindless textures, indirect first "
+                        "instances or fragment primitive ids";
+        return;
+    }
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    for (const DescriptorBindingDesc& binding : sceneBindings) {
+        if (std::find(std::begin(VISIBILITY_SCENE_BINDINGS), std::end(VISIBILITY_SCENE_BINDINGS), binding.binding) !=
+            std::end(VISIBILITY_SCENE_BINDINGS)) {
+            m_Bindings.push_back(binding);
+            m_Bindings.back().stageFlags = ShaderStage::Compute;
+        }
+    }
+    if (m_Bindings.size() != std::size(VISIBILITY_SCENE_BINDINGS)) {
+        METAGFX_ERROR << "Visibility buffer unavailable: the scene bindings lack the node transforms";
+        m_Bindings.clear();
+        return;
+    }
+    m_Bindings.push_back({ MATERIAL_BINDING, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+    m_Bindings.push_back({ TEXTURE_TABLE_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr, 0, textureCapacity });
+    for (uint32 binding : { VERTEX_BINDING, INDEX_BINDING, RECORD_BINDING, CLUSTER_RECORD_BINDING,
+                            MESH_MATERIAL_BINDING, MATERIAL_BIN_BINDING, PIXEL_BINDING }) {
+        m_Bindings.push_back({ binding, DescriptorType::StorageBuffer, ShaderStage::Compute,
+                               nullptr, nullptr, nullptr });
+    }
+    m_Bindings.push_back({ VISIBILITY_BINDING, DescriptorType::SampledTexture, ShaderStage::Compute,
+                           nullptr, nullptr, m_PointSampler });
+    m_Bindings.push_back({ GBUFFER_BINDING, DescriptorType::StorageTexture, ShaderStage::Compute,
+                           nullptr, nullptr, nullptr });
+
+    // The materials, geometry and targets come later; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = m_Bindings;
+    layoutDesc.debugName = "VisibilityResolveLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = resolveShader;
+    pipelineDesc.pushConstantSize = sizeof(ResolvePushConstants);
+    pipelineDesc.debugName = "VisibilityResolvePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Visibility buffer unavailable: failed to create its resolve pipeline";
+        return;
+    }
+    METAGFX_INFO << "Visibility buffer created: " << GPUCuller::CLUSTER_TRIANGLES << " triangle clusters, "
+                 << textureCapacity << " table textures";
+}
+
+void VisibilityBuffer::SetBinding(uint32 binding, Ref<rhi::Buffer> buffer, Ref<rhi::Texture> texture,
+                                  Ref<rhi::Sampler> sampler) {
+    for (rhi::DescriptorBindingDesc& entry : m_Bindings) {
+        if (entry.binding == binding) {
+            entry.buffer = buffer;
+            entry.texture = texture;
+            entry.sampler = sampler;
+        }
+    }
+    if (m_DescriptorSet) {
+        if (texture) {
+            m_DescriptorSet->UpdateTexture(binding, texture, sampler);
+        } else {
+            m_DescriptorSet->UpdateBuffer(binding, buffer);
+        }
+    } else {
+        CreateDescriptorSet();
+    }
+}
+
+void VisibilityBuffer::SetSceneBuffer(uint32 binding, Ref<rhi::Buffer> buffer) {
+    SetBinding(binding, buffer, nullptr, nullptr);
+}
+
+void VisibilityBuffer::SetMaterials(Ref<rhi::Buffer> materialBuffer, const std::vector<Ref<rhi::Texture>>& textures,
+                                    Ref<rhi::Sampler> sampler) {
+    if (!IsValid()) {
+        return;
+    }
+    if (textures.size() > m_TextureCapacity) {
+        METAGFX_WARN << "Visibility buffer: " << textures.size() << " material textures, " << m_TextureCapacity
+                     << " fit";
+        return;
+    }
+    m_Textures = textures;
+    m_TextureSampler = sampler;
+    SetBinding(MATERIAL_BINDING, materialBuffer, nullptr, nullptr);
+
+    // A set created just now wrote the table already
+    if (m_DescriptorSet) {
+        uint32 count = static_cast<uint32>(m_Textures.size());
+        for (uint32 i = 0; i < std::max(count, m_WrittenTextures); ++i) {
+            if (i < count) {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+            } else {
+                m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, nullptr, nullptr);
+            }
+        }
+        m_WrittenTextures = count;
+    }
+}
+
+void VisibilityBuffer::SetGeometry(const Model& model, const GPUCuller& culler,
+                                   const std::unordered_map<const Material*, uint32>& materialIndices) {
+    using namespace rhi;
+
+    const Ref<GeometryPool>& pool = model.GetGeometryPool();
+    if (!IsValid() || !pool || !culler.GetRecordBuffer()) {
+        return;
+    }
+
+    // Each mesh's material, and whether its vertices are compact; a mesh outside the
+    // table shades with its first material, as the main pass's draws do
+    uint32 materialCount = 1;
+    for (const auto& entry : materialIndices) {
+        materialCount = std::max(materialCount, entry.second + 1);
+    }
+    std::vector<uint32> meshMaterials(std::max<size_t>(model.GetMeshCount(), 1), 0);
+    for (size_t i = 0; i < model.GetMeshCount(); ++i) {
+        const Mesh& mesh = *model.GetMeshes()[i];
+        auto material = materialIndices.find(mesh.GetMaterial());
+        meshMaterials[i] = material != materialIndices.end() ? material->second : 0;
+        if (mesh.GetVertexFormat() == VertexFormat::Compact) {
+            meshMaterials[i] |= COMPACT_MESH;
+        }
+    }
+
+    BufferDesc desc{};
+    desc.size = meshMaterials.size() * sizeof(uint32);
+    desc.usage = BufferUsage::Storage;
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "VisibilityMeshMaterials";
+    Ref<Buffer> meshMaterialBuffer = m_Device->CreateBuffer(desc);
+
+    // The resolve's dispatch arguments and pixel count, then a counter pair per material
+    desc.size = sizeof(glm::uvec4) + materialCount * sizeof(glm::uvec2);
+    desc.usage = BufferUsage::Storage | BufferUsage::Indirect;
+    desc.memoryUsage = MemoryUsage::GPUOnly;
+    desc.debugName = "VisibilityMaterialBins";
+    Ref<Buffer> bins = m_Device->CreateBuffer(desc);
+    if (!meshMaterialBuffer || !bins) {
+        METAGFX_ERROR << "Visibility buffer: failed to create the material buffers of " << materialCount
+                      << " materials";
+        return;
+    }
+    meshMaterialBuffer->CopyData(meshMaterials.data(), meshMaterials.size() * sizeof(uint32));
+
+    // Earlier frames in flight may still read the last ones
+    for (const DescriptorBindingDesc& entry : m_Bindings) {
+        if ((entry.binding == MESH_MATERIAL_BINDING || entry.binding == MATERIAL_BIN_BINDING) && entry.buffer) {
+            m_Device->Retire(entry.buffer);
+        }
+    }
+    m_MaterialCount = materialCount;
+    m_MaterialBins = bins;
+    SetBinding(VERTEX_BINDING, pool->GetVertexBuffer(), nullptr, nullptr);
+    SetBinding(INDEX_BINDING, pool->GetIndexBuffer(), nullptr, nullptr);
+    SetBinding(RECORD_BINDING, culler.GetRecordBuffer(), nullptr, nullptr);
+    SetBinding(CLUSTER_RECORD_BINDING, culler.GetClusterRecordBuffer(), nullptr, nullptr);
+    SetBinding(MESH_MATERIAL_BINDING, meshMaterialBuffer, nullptr, nullptr);
+    SetBinding(MATERIAL_BIN_BINDING, m_MaterialBins, nullptr, nullptr);
+}
+
+void VisibilityBuffer::SetTargets(Ref<rhi::Texture> visibility, Ref<rhi::Texture> gbuffer) {
+    using namespace rhi;
+
+    if (!IsValid() || (visibility == m_Visibility && gbuffer == m_GBuffer)) {
+        return;
+    }
+
+    // Room for every pixel of the largest target yet
+    uint32 pixelCount = visibility->GetWidth() * visibility->GetHeight();
+    if (pixelCount > m_PixelCapacity) {
+        BufferDesc desc{};
+        desc.size = static_cast<uint64>(pixelCount) * sizeof(uint32);
+        desc.usage = BufferUsage::Storage;
+        desc.memoryUsage = MemoryUsage::GPUOnly;
+        desc.debugName = "VisibilityPixels";
+        Ref<Buffer> pixels = m_Device->CreateBuffer(desc);
+        if (!pixels) {
+            METAGFX_ERROR << "Visibility buffer: failed to create the pixel list of " << pixelCount << " pixels";
+            return;
+        }
+        m_Device->Retire(m_Pixels);
+        m_Pixels = pixels;
+        m_PixelCapacity = pixelCount;
+    }
+
+    m_Visibility = visibility;
+    m_GBuffer = gbuffer;
+    for (DescriptorBindingDesc& binding : m_Bindings) {
+        if (binding.binding == PIXEL_BINDING) {
+            binding.buffer = m_Pixels;
+        } else if (binding.binding == VISIBILITY_BINDING) {
+            binding.texture = m_Visibility;
+        } else if (binding.binding == GBUFFER_BINDING) {
+            binding.texture = m_GBuffer;
+        }
+    }
+
+    // Frames in flight may still read the old set
+    m_Device->Retire(m_DescriptorSet);
+    m_DescriptorSet.reset();
+    CreateDescriptorSet();
+}
+
+void VisibilityBuffer::CreateDescriptorSet() {
+    using namespace rhi;
+
+    if (!IsValid() || m_DescriptorSet) {
+        return;
+    }
+    for (const DescriptorBindingDesc& binding : m_Bindings) {
+        // The table's elements are written after the set
+        if (!binding.buffer && !binding.texture && binding.count <= 1) {
+            return;
+        }
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = m_Bindings;
+    desc.debugName = "VisibilityResolveDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+    if (!m_DescriptorSet) {
+        return;
+    }
+    m_WrittenTextures = static_cast<uint32>(m_Textures.size());
+    for (uint32 i = 0; i < m_WrittenTextures; ++i) {
+        m_DescriptorSet->UpdateTextureArrayElement(TEXTURE_TABLE_BINDING, i, m_Textures[i], m_TextureSampler);
+    }
+}
+
+void VisibilityBuffer::Resolve(rhi::CommandBuffer& cmd, uint32 frameIndex, uint32 modelUniformOffset) {
+    using namespace rhi;
+
+    if (!IsReady()) {
+        return;
+    }
+
+    ResolvePushConstants push{};
+    push.materialCount = m_MaterialCount;
+    push.size = glm::uvec2(m_Visibility->GetWidth(), m_Visibility->GetHeight());
+    auto setMode = [&](uint32 mode) {
+        push.mode = mode;
+        cmd.PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(push), &push);
+    };
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex, &modelUniformOffset, 1);
+
+    // The last frame's resolve may still read the bins and the list
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    setMode(ResolveClear);
+    cmd.Dispatch((m_MaterialCount + GROUP_SIZE - 1) / GROUP_SIZE);
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+
+    // A row of groups per image row
+    uint32 columns = (push.size.x + GROUP_SIZE - 1) / GROUP_SIZE;
+    setMode(ResolveCount);
+    cmd.Dispatch(columns, push.size.y);
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+
+    setMode(ResolveScan);
+    cmd.Dispatch(1);
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+
+    setMode(ResolveScatter);
+    cmd.Dispatch(columns, push.size.y);
+    cmd.PipelineBarrier(BarrierType::ComputeToCompute);
+    cmd.PipelineBarrier(BarrierType::ComputeToIndirect);
+
+    setMode(ResolveShade);
+    cmd.DispatchIndirect(m_MaterialBins, 0);
+}
+
+} // namespace metagfx
@@ -0,0 +1,93 @@
+// ============================================================================
+// src/scene/WeightedBlendedOIT.cpp
+// ============================================================================
+#include "metagfx/scene/WeightedBlendedOIT.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+
+namespace metagfx {
+
+WeightedBlendedOIT::WeightedBlendedOIT(Ref<rhi::GraphicsDevice> device, Ref<rhi::Shader> vertexShader,
+                                       Ref<rhi::Shader> fragmentShader, rhi::Format sceneColorFormat)
+    : m_Device(device) {
+    using namespace rhi;
+
+    SamplerDesc samplerDesc{};
+    samplerDesc.minFilter = Filter::Nearest;
+    samplerDesc.magFilter = Filter::Nearest;
+    samplerDesc.mipmapMode = Filter::Nearest;
+    samplerDesc.addressModeU = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeV = SamplerAddressMode::ClampToEdge;
+    samplerDesc.addressModeW = SamplerAddressMode::ClampToEdge;
+    m_PointSampler = device->CreateSampler(samplerDesc);
+
+    // The targets come with the first frame; the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler },  // Accumulation
+        { 1, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, nullptr, m_PointSampler }   // Revealage
+    };
+    layoutDesc.debugName = "TransparencyCompositeLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    // A triangle over the viewport, made by the vertex shader, blended over the scene
+    // color by its alpha: the transparent surfaces' coverage
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertexShader;
+    pipelineDesc.fragmentShader = fragmentShader;
+    pipelineDesc.vertexInput.stride = 0;
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+    pipelineDesc.depthStencil.depthTestEnable = false;
+    pipelineDesc.depthStencil.depthWriteEnable = false;
+    pipelineDesc.colorAttachments.resize(1);
+    pipelineDesc.colorAttachments[0].blendEnable = true;
+    pipelineDesc.colorAttachments[0].blendMode = BlendMode::Alpha;
+    pipelineDesc.colorFormats = { sceneColorFormat };
+    pipelineDesc.depthFormat = Format::Undefined;
+    pipelineDesc.debugName = "TransparencyCompositePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateGraphicsPipeline(pipelineDesc);
+
+    if (!IsValid()) {
+        METAGFX_ERROR << "Weighted blended transparency unavailable: failed to create its composite pipeline";
+        return;
+    }
+    METAGFX_INFO << "Weighted blended transparency created";
+}
+
+void WeightedBlendedOIT::SetSources(Ref<rhi::Texture> accumulation, Ref<rhi::Texture> revealage) {
+    using namespace rhi;
+
+    if (accumulation == m_Accumulation && revealage == m_Revealage) {
+        return;
+    }
+
+    m_Device->Retire(m_DescriptorSet);
+    m_DescriptorSet.reset();
+    m_Accumulation = accumulation;
+    m_Revealage = revealage;
+    if (!IsValid() || !m_Accumulation || !m_Revealage) {
+        return;
+    }
+
+    DescriptorSetDesc desc;
+    desc.bindings = {
+        { 0, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_Accumulation, m_PointSampler },
+        { 1, DescriptorType::SampledTexture, ShaderStage::Fragment, nullptr, m_Revealage, m_PointSampler }
+    };
+    desc.debugName = "TransparencyCompositeDescriptorSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(desc);
+}
+
+void WeightedBlendedOIT::Composite(rhi::CommandBuffer& cmd, uint32 frameIndex) {
+    if (!m_DescriptorSet) {
+        return;
+    }
+
+    cmd.BindPipeline(m_Pipeline);
+    cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+    cmd.Draw(3);
+}
+
+} // namespace metagfx
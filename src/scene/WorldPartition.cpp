@@ -0,0 +1,314 @@
+// ============================================================================
+// src/scene/WorldPartition.cpp
+// ============================================================================
+#include "metagfx/scene/WorldPartition.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Profiler.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/Material.h"
+#include "metagfx/scene/Mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+
+namespace metagfx {
+
+// Time constant of the camera velocity's smoothing, so a single uneven frame does not
+// swing the prefetch around
+static constexpr float VELOCITY_SMOOTHING_SECONDS = 0.25f;
+// A longer gap between updates (a stall, a load screen) says nothing about the velocity
+static constexpr float MAX_VELOCITY_INTERVAL_SECONDS = 0.5f;
+
+static float DistanceToBox(const glm::vec3& point, const glm::vec3& boxMin, const glm::vec3& boxMax) {
+    glm::vec3 outside = glm::max(glm::max(boxMin - point, point - boxMax), glm::vec3(0.0f));
+    return glm::length(outside);
+}
+
+static uint64 GetTextureBytes(const rhi::Texture& texture) {
+    uint64 bytes = 0;
+    for (uint32 mip = 0; mip < texture.GetMipLevels(); ++mip) {
+        bytes += rhi::GetFormatImageSize(texture.GetFormat(), std::max(1u, texture.GetWidth() >> mip),
+                                         std::max(1u, texture.GetHeight() >> mip));
+    }
+    return bytes;
+}
+
+WorldPartition::WorldPartition(Ref<rhi::GraphicsDevice> device, utils::TextureCache* textureCache,
+                               const ModelImportSettings& importSettings)
+    : m_Device(device)
+    , m_TextureCache(textureCache)
+    , m_ImportSettings(importSettings) {
+}
+
+WorldPartition::~WorldPartition() {
+    Clear();
+}
+
+void WorldPartition::SetCells(const std::vector<SceneDescription::CellDesc>& cells) {
+    Clear();
+    m_Cells.resize(cells.size());
+    for (size_t i = 0; i < cells.size(); ++i) {
+        m_Cells[i].modelPath = cells[i].modelPath;
+        m_Cells[i].boundsMin = glm::min(cells[i].boundsMin, cells[i].boundsMax);
+        m_Cells[i].boundsMax = glm::max(cells[i].boundsMin, cells[i].boundsMax);
+    }
+    m_Stats.cellCount = static_cast<uint32>(m_Cells.size());
+    if (!m_Cells.empty()) {
+        METAGFX_INFO << "World partition: " << m_Cells.size() << " cells";
+    }
+}
+
+void WorldPartition::Clear() {
+    // Loads in flight are waited out by their handles; resident models may still be drawn
+    // by frames in flight
+    for (Cell& cell : m_Cells) {
+        if (cell.load) {
+            cell.load->Cancel();
+        }
+        if (cell.model) {
+            m_Device->Retire(Ref<Model>(std::move(cell.model)));
+        }
+    }
+    m_Cells.clear();
+    m_Stats = Stats{};
+    m_LastUpdateNs = 0;
+}
+
+bool WorldPartition::Update(const glm::vec3& eye, ModelUploadBudget* uploads) {
+    METAGFX_PROFILE_FUNCTION();
+    ++m_Frame;
+
+    // Camera velocity from its motion since the last update, smoothed
+    uint64 now = Profiler::Now();
+    if (m_LastUpdateNs > 0 && now > m_LastUpdateNs) {
+        float seconds = static_cast<float>(now - m_LastUpdateNs) / 1000000000.0f;
+        if (seconds < MAX_VELOCITY_INTERVAL_SECONDS) {
+            glm::vec3 velocity = (eye - m_LastEye) / seconds;
+            float blend = 1.0f - std::exp(-seconds / VELOCITY_SMOOTHING_SECONDS);
+            m_Stats.velocity += (velocity - m_Stats.velocity) * blend;
+        } else {
+            m_Stats.velocity = glm::vec3(0.0f);
+        }
+    }
+    m_LastEye = eye;
+    m_LastUpdateNs = now;
+    if (m_Cells.empty()) {
+        return false;
+    }
+
+    // Where the camera is headed, no farther ahead than a load radius: a reframed camera
+    // moves a long way in one frame
+    float loadDistance = std::max(m_Settings.loadDistance, 0.0f);
+    float unloadDistance = std::max(m_Settings.unloadDistance, loadDistance);
+    glm::vec3 offset = m_Stats.velocity * std::max(m_Settings.prefetchSeconds, 0.0f);
+    float offsetLength = glm::length(offset);
+    if (offsetLength > loadDistance) {
+        offset *= loadDistance / offsetLength;
+    }
+    glm::vec3 ahead = eye + offset;
+    bool prefetch = offsetLength > 0.0f;
+
+    uint64 unloads = m_Stats.unloads;
+    for (Cell& cell : m_Cells) {
+        cell.distance = DistanceToBox(eye, cell.boundsMin, cell.boundsMax);
+        float aheadDistance = prefetch ? DistanceToBox(ahead, cell.boundsMin, cell.boundsMax) : cell.distance;
+        cell.wanted = cell.distance <= loadDistance || aheadDistance <= loadDistance;
+        cell.priority = cell.distance <= loadDistance ? cell.distance : loadDistance + aheadDistance;
+
+        // Left behind: unloaded, or its load dropped
+        if (std::min(cell.distance, aheadDistance) > unloadDistance) {
+            if (cell.state == CellState::Resident) {
+                Unload(cell);
+            } else if (cell.state == CellState::Loading) {
+                cell.load->Cancel();
+            }
+        }
+    }
+
+    // A budget that shrank (the device's, as other processes take memory) unloads too
+    uint64 budget = ComputeBudget();
+    MakeRoom(0, budget, std::numeric_limits<float>::lowest());
+    bool changed = m_Stats.unloads != unloads;
+
+    changed = FinishLoads(budget, uploads) || changed;
+    StartLoads(budget);
+
+    m_Stats.budgetBytes = budget;
+    m_Stats.residentCount = static_cast<uint32>(std::count_if(m_Cells.begin(), m_Cells.end(),
+        [](const Cell& cell) { return cell.state == CellState::Resident; }));
+    m_Stats.loadsInFlight = static_cast<uint32>(std::count_if(m_Cells.begin(), m_Cells.end(),
+        [](const Cell& cell) { return cell.state == CellState::Loading; }));
+    METAGFX_PROFILE_COUNTER("World cells resident", m_Stats.residentCount);
+    METAGFX_PROFILE_COUNTER("World cell MB", static_cast<double>(m_Stats.residentBytes) / (1024.0 * 1024.0));
+    return changed;
+}
+
+uint64 WorldPartition::ComputeBudget() const {
+    if (m_Settings.budgetBytes > 0) {
+        return m_Settings.budgetBytes;
+    }
+
+    // What the process leaves free of the device's budget, plus what the cells already
+    // take of it, so the budget does not shrink as they load
+    rhi::MemoryBudget device = m_Device->GetMemoryBudget();
+    if (device.budgetBytes == 0) {
+        return FALLBACK_BUDGET_BYTES;
+    }
+    uint64 free = device.budgetBytes > device.usageBytes ? device.budgetBytes - device.usageBytes : 0;
+    float fraction = std::clamp(m_Settings.deviceBudgetFraction, 0.0f, 1.0f);
+    return static_cast<uint64>(static_cast<double>(free + m_Stats.residentBytes) * fraction);
+}
+
+bool WorldPartition::MakeRoom(uint64 bytes, uint64 budget, float priority) {
+    while (m_Stats.residentBytes + bytes > budget) {
+        Cell* victim = nullptr;
+        for (Cell& cell : m_Cells) {
+            if (cell.state == CellState::Resident && cell.priority > priority &&
+                (!victim || cell.priority > victim->priority)) {
+                victim = &cell;
+            }
+        }
+        if (!victim) {
+            return false;
+        }
+        Unload(*victim);
+    }
+    return true;
+}
+
+void WorldPartition::Unload(Cell& cell) {
+    // Frames in flight may still draw it
+    m_Device->Retire(Ref<Model>(std::move(cell.model)));
+    m_Stats.residentBytes -= cell.bytes;
+    cell.bytes = 0;
+    cell.state = CellState::Unloaded;
+    ++m_Stats.unloads;
+}
+
+bool WorldPartition::FinishLoads(uint64 budget, ModelUploadBudget* uploads) {
+    bool changed = false;
+    for (Cell& cell : m_Cells) {
+        if (cell.state != CellState::Loading) {
+            continue;
+        }
+
+        switch (cell.load->Update(uploads)) {
+            case ModelLoadState::Ready: {
+                std::unique_ptr<Model> model = cell.load->TakeModel();
+                cell.load.reset();
+                uint64 bytes = EstimateModelBytes(*model);
+                if (!MakeRoom(bytes, budget, cell.priority)) {
+                    // Everything resident is nearer: try again once some of it is gone
+                    METAGFX_DEBUG << "World cell " << cell.modelPath << " (" << bytes / (1024 * 1024)
+                                  << " MB) does not fit the budget";
+                    m_Device->Retire(Ref<Model>(std::move(model)));
+                    cell.state = CellState::Unloaded;
+                    cell.retryFrame = m_Frame + m_Settings.retryFrames;
+                    break;
+                }
+                cell.model = std::move(model);
+                cell.bytes = bytes;
+                cell.state = CellState::Resident;
+                m_Stats.residentBytes += bytes;
+                ++m_Stats.loads;
+                changed = true;
+                break;
+            }
+            case ModelLoadState::Failed:
+                METAGFX_WARN << "World cell " << cell.modelPath << " failed to load; it stays empty";
+                cell.load.reset();
+                cell.state = CellState::Failed;
+                ++m_Stats.failedCount;
+                break;
+            case ModelLoadState::Cancelled:
+                cell.load.reset();
+                cell.state = CellState::Unloaded;
+                break;
+            default:
+                break;
+        }
+    }
+    return changed;
+}
+
+void WorldPartition::StartLoads(uint64 budget) {
+    // Each load imports on a thread of its own; decodes share the job system's workers
+    uint32 maxLoads = m_Settings.maxLoadsInFlight > 0 ? m_Settings.maxLoadsInFlight
+                                                      : std::max(JobSystem::GetWorkerCount(), 1u);
+    uint32 inFlight = static_cast<uint32>(std::count_if(m_Cells.begin(), m_Cells.end(),
+        [](const Cell& cell) { return cell.state == CellState::Loading; }));
+    if (inFlight >= maxLoads) {
+        return;
+    }
+
+    m_Order.clear();
+    for (uint32 i = 0; i < m_Cells.size(); ++i) {
+        const Cell& cell = m_Cells[i];
+        if (cell.wanted && cell.state == CellState::Unloaded && cell.retryFrame <= m_Frame) {
+            m_Order.push_back(i);
+        }
+    }
+    std::sort(m_Order.begin(), m_Order.end(),
+              [this](uint32 a, uint32 b) { return m_Cells[a].priority < m_Cells[b].priority; });
+
+    for (uint32 index : m_Order) {
+        if (inFlight >= maxLoads) {
+            break;
+        }
+        Cell& cell = m_Cells[index];
+
+        // Over the budget with nothing farther to give way, this and every later cell
+        // would be dropped on arrival
+        if (m_Stats.residentBytes >= budget &&
+            std::none_of(m_Cells.begin(), m_Cells.end(), [&](const Cell& other) {
+                return other.state == CellState::Resident && other.priority > cell.priority;
+            })) {
+            break;
+        }
+
+        cell.load = Model::LoadFromFileAsync(m_Device.get(), cell.modelPath, m_TextureCache, m_ImportSettings);
+        cell.state = CellState::Loading;
+        ++inFlight;
+    }
+}
+
+uint64 WorldPartition::EstimateModelBytes(const Model& model) {
+    std::unordered_set<const void*> counted;
+    uint64 bytes = 0;
+    auto addBuffer = [&](const Ref<rhi::Buffer>& buffer) {
+        if (buffer && counted.insert(buffer.get()).second) {
+            bytes += buffer->GetSize();
+        }
+    };
+    auto addTexture = [&](const Ref<rhi::Texture>& texture) {
+        if (texture && counted.insert(texture.get()).second) {
+            bytes += GetTextureBytes(*texture);
+        }
+    };
+
+    // Pooled meshes share the pool's buffers, which the set counts once
+    for (const auto& mesh : model.GetMeshes()) {
+        if (!mesh) {
+            continue;
+        }
+        addBuffer(mesh->GetVertexBuffer());
+        addBuffer(mesh->GetIndexBuffer());
+        addBuffer(mesh->GetPositionBuffer());
+        if (const Material* material = mesh->GetMaterial()) {
+            addTexture(material->GetAlbedoMap());
+            addTexture(material->GetNormalMap());
+            addTexture(material->GetMetallicMap());
+            addTexture(material->GetRoughnessMap());
+            addTexture(material->GetMetallicRoughnessMap());
+            addTexture(material->GetAOMap());
+            addTexture(material->GetEmissiveMap());
+        }
+    }
+    return bytes;
+}
+
+} // namespace metagfx
@@ -0,0 +1,318 @@
+// ============================================================================
+// src/utils/AssetArchive.cpp
+// ============================================================================
+#include "metagfx/utils/AssetArchive.h"
+#include "metagfx/utils/AsyncFileReader.h"
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <shared_mutex>
+#include <vector>
+
+#ifdef METAGFX_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace metagfx {
+namespace utils {
+
+namespace {
+
+struct MountedArchive {
+    std::shared_ptr<const AssetArchive> archive;
+    std::string prefix;  // Normalized mount point plus '/', or empty
+};
+
+std::shared_mutex s_MountMutex;
+std::vector<MountedArchive> s_Mounts;
+std::atomic<bool> s_HasMounts{false};
+
+} // anonymous namespace
+
+AssetArchive::~AssetArchive() = default;
+
+bool AssetArchive::Open(const std::string& filepath, std::string* error) {
+    auto fail = [&](const std::string& message) {
+        if (error) {
+            *error = message;
+        }
+        m_File.reset();
+        m_Reads.reset();
+        m_Entries = nullptr;
+        m_Chunks = nullptr;
+        m_Index.clear();
+        return false;
+    };
+
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(filepath)) {
+        return fail("cannot open " + filepath);
+    }
+    m_File = file;
+    m_Path = filepath;
+
+    const uint8* data = file->GetData();
+    uint64 size = file->GetSize();
+    if (size < sizeof(AssetArchiveHeader)) {
+        return fail("truncated header");
+    }
+    memcpy(&m_Header, data, sizeof(m_Header));
+    if (m_Header.magic != ASSET_ARCHIVE_MAGIC) {
+        return fail("not an asset archive");
+    }
+    if (m_Header.version != ASSET_ARCHIVE_VERSION) {
+        return fail("archive version " + std::to_string(m_Header.version) + ", expected " +
+                    std::to_string(ASSET_ARCHIVE_VERSION));
+    }
+
+    // The table of contents is read in place, so it must be aligned for its structures
+    uint64 entryBytes = static_cast<uint64>(m_Header.entryCount) * sizeof(AssetArchiveEntry);
+    uint64 chunkBytes = static_cast<uint64>(m_Header.chunkCount) * sizeof(AssetArchiveChunk);
+    if (m_Header.tocOffset % alignof(AssetArchiveEntry) != 0 || m_Header.tocOffset > size ||
+        m_Header.tocSize > size - m_Header.tocOffset || entryBytes + chunkBytes > m_Header.tocSize ||
+        (m_Header.chunkCount > 0 && m_Header.chunkSize == 0)) {
+        return fail("corrupt table of contents");
+    }
+    m_Entries = reinterpret_cast<const AssetArchiveEntry*>(data + m_Header.tocOffset);
+    m_Chunks = reinterpret_cast<const AssetArchiveChunk*>(data + m_Header.tocOffset + entryBytes);
+    const char* paths = reinterpret_cast<const char*>(data + m_Header.tocOffset + entryBytes + chunkBytes);
+    uint64 pathBytes = m_Header.tocSize - entryBytes - chunkBytes;
+
+    m_Index.reserve(m_Header.entryCount);
+    for (uint32 i = 0; i < m_Header.entryCount; ++i) {
+        const AssetArchiveEntry& entry = m_Entries[i];
+        if (entry.pathOffset > pathBytes || entry.pathLength > pathBytes - entry.pathOffset) {
+            return fail("corrupt path of entry " + std::to_string(i));
+        }
+        std::string path(paths + entry.pathOffset, entry.pathLength);
+
+        bool valid = false;
+        if (entry.compression == static_cast<uint32>(ArchiveCompression::None)) {
+            valid = entry.offset <= size && entry.size <= size - entry.offset;
+        } else if (entry.compression == static_cast<uint32>(ArchiveCompression::Zstd)) {
+            uint64 chunkCount = (entry.size + m_Header.chunkSize - 1) / m_Header.chunkSize;
+            valid = entry.chunkCount == chunkCount && entry.firstChunk <= m_Header.chunkCount &&
+                    entry.chunkCount <= m_Header.chunkCount - entry.firstChunk;
+            for (uint32 c = 0; valid && c < entry.chunkCount; ++c) {
+                const AssetArchiveChunk& chunk = m_Chunks[entry.firstChunk + c];
+                valid = chunk.offset <= size && chunk.storedSize <= size - chunk.offset;
+            }
+        }
+        if (!valid) {
+            return fail("corrupt entry " + path);
+        }
+        m_Index.emplace(std::move(path), i);
+    }
+
+    if (file->GetSourcePath() == filepath && file->GetSourceOffset() == 0) {
+        m_Reads = std::make_unique<AsyncFile>();
+        if (!m_Reads->Open(filepath)) {
+            m_Reads.reset();
+        }
+    }
+    return true;
+}
+
+const AssetArchiveEntry* AssetArchive::FindEntry(const std::string& entryPath) const {
+    auto it = m_Index.find(entryPath);
+    return it != m_Index.end() ? &m_Entries[it->second] : nullptr;
+}
+
+bool AssetArchive::Find(const std::string& entryPath, EntryInfo* out) const {
+    const AssetArchiveEntry* entry = FindEntry(entryPath);
+    if (entry && out) {
+        out->size = entry->size;
+        out->hash = entry->hash;
+        out->compression = static_cast<ArchiveCompression>(entry->compression);
+    }
+    return entry != nullptr;
+}
+
+bool AssetArchive::DecodeChunk(const AssetArchiveEntry& entry, uint32 chunkIndex, const uint8* src,
+                               uint8* dst) const {
+    const AssetArchiveChunk& chunk = m_Chunks[entry.firstChunk + chunkIndex];
+    uint64 start = static_cast<uint64>(chunkIndex) * m_Header.chunkSize;
+    uint64 size = std::min<uint64>(m_Header.chunkSize, entry.size - start);
+    if (chunk.storedSize == size) {
+        memcpy(dst + start, src, size);
+        return true;
+    }
+#ifdef METAGFX_HAS_ZSTD
+    // One decompression context per thread, reused across chunks and entries
+    thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    size_t written = ZSTD_decompressDCtx(context.get(), dst + start, size, src, chunk.storedSize);
+    return !ZSTD_isError(written) && written == size;
+#else
+    return false;
+#endif
+}
+
+bool AssetArchive::ReadEntry(const AssetArchiveEntry& entry, uint8* dst) const {
+    const uint8* data = m_File->GetData();
+    if (entry.compression == static_cast<uint32>(ArchiveCompression::None)) {
+        memcpy(dst, data + entry.offset, entry.size);
+        return true;
+    }
+    if (entry.chunkCount == 0) {
+        return true;
+    }
+
+    std::atomic<bool> failed{false};
+    if (m_Reads) {
+        // Every chunk is in flight at once; each decodes on a job as soon as it lands
+        JobCounter counter;
+        for (uint32 c = 0; c < entry.chunkCount; ++c) {
+            const AssetArchiveChunk& chunk = m_Chunks[entry.firstChunk + c];
+            AsyncFileReader::Read(*m_Reads, chunk.offset, chunk.storedSize, [&, c](const uint8* src, uint64) {
+                if (!src || !DecodeChunk(entry, c, src, dst)) {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }, &counter);
+        }
+        JobSystem::Wait(counter);
+    } else {
+        // Packed in another archive: start reading every chunk before the jobs fault
+        // them in one by one
+        const AssetArchiveChunk& first = m_Chunks[entry.firstChunk];
+        const AssetArchiveChunk& last = m_Chunks[entry.firstChunk + entry.chunkCount - 1];
+        m_File->Prefetch(first.offset, last.offset + last.storedSize - first.offset);
+
+        JobSystem::ParallelFor(entry.chunkCount, 1, [&](uint32 begin, uint32 end) {
+            for (uint32 c = begin; c < end && !failed.load(std::memory_order_relaxed); ++c) {
+                if (!DecodeChunk(entry, c, data + m_Chunks[entry.firstChunk + c].offset, dst)) {
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+
+    if (failed.load()) {
+#ifdef METAGFX_HAS_ZSTD
+        METAGFX_ERROR << "Corrupt Zstd chunk in asset archive " << m_Path;
+#else
+        METAGFX_ERROR << "Zstd-compressed archive entries need METAGFX_USE_BASISU or libzstd: " << m_Path;
+#endif
+        return false;
+    }
+    return true;
+}
+
+bool AssetArchive::Read(const std::string& entryPath, void* dst, uint64 dstSize) const {
+    const AssetArchiveEntry* entry = FindEntry(entryPath);
+    if (!entry || dstSize < entry->size) {
+        return false;
+    }
+    return ReadEntry(*entry, static_cast<uint8*>(dst));
+}
+
+bool AssetArchive::OpenEntry(const std::string& entryPath, MappedFile& out) const {
+    out.Close();
+    const AssetArchiveEntry* entry = FindEntry(entryPath);
+    if (!entry || entry->size == 0) {
+        return false;  // Empty files do not map either
+    }
+
+    if (entry->compression == static_cast<uint32>(ArchiveCompression::None)) {
+        out.m_Archive = m_File;
+        out.m_Data = m_File->GetData() + entry->offset;
+        out.m_SourcePath = m_Path;
+        out.m_SourceOffset = entry->offset;
+    } else {
+        out.m_Buffer.resize(entry->size);
+        if (!ReadEntry(*entry, out.m_Buffer.data())) {
+            out.m_Buffer = {};
+            return false;
+        }
+        out.m_Data = out.m_Buffer.data();
+    }
+    out.m_Size = entry->size;
+    return true;
+}
+
+// ============================================================================
+// Mounts
+// ============================================================================
+
+std::string AssetArchive::NormalizePath(const std::string& path) {
+    std::filesystem::path normal = std::filesystem::path(path).lexically_normal();
+    if (normal.is_absolute()) {
+        std::error_code ec;
+        std::filesystem::path relative = normal.lexically_relative(std::filesystem::current_path(ec));
+        if (!ec && !relative.empty() && *relative.begin() != "..") {
+            normal = relative;
+        }
+    }
+    std::string result = normal.generic_string();
+    return result == "." ? std::string() : result;
+}
+
+bool AssetArchive::Mount(const std::string& filepath, const std::string& mountPoint) {
+    auto archive = std::make_shared<AssetArchive>();
+    std::string error;
+    if (!archive->Open(filepath, &error)) {
+        METAGFX_ERROR << "Failed to mount asset archive " << filepath << ": " << error;
+        return false;
+    }
+
+    std::string prefix = NormalizePath(mountPoint);
+    if (!prefix.empty() && prefix.back() != '/') {
+        prefix += '/';
+    }
+    METAGFX_INFO << "Mounted asset archive " << filepath << " (" << archive->GetEntryCount() << " files"
+                 << (prefix.empty() ? "" : " under " + prefix) << ")";
+
+    std::unique_lock lock(s_MountMutex);
+    s_Mounts.push_back({ std::move(archive), std::move(prefix) });
+    s_HasMounts.store(true, std::memory_order_release);
+    return true;
+}
+
+void AssetArchive::UnmountAll() {
+    std::unique_lock lock(s_MountMutex);
+    s_Mounts.clear();
+    s_HasMounts.store(false, std::memory_order_release);
+}
+
+bool AssetArchive::HasMounts() {
+    return s_HasMounts.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const AssetArchive> AssetArchive::ResolveMounted(const std::string& filepath,
+                                                                 std::string& entryPath) {
+    if (!HasMounts()) {
+        return nullptr;
+    }
+    std::string path = NormalizePath(filepath);
+
+    std::shared_lock lock(s_MountMutex);
+    for (const MountedArchive& mounted : s_Mounts) {
+        if (path.compare(0, mounted.prefix.size(), mounted.prefix) != 0) {
+            continue;
+        }
+        entryPath = path.substr(mounted.prefix.size());
+        if (mounted.archive->FindEntry(entryPath)) {
+            return mounted.archive;
+        }
+    }
+    return nullptr;
+}
+
+bool AssetArchive::FindMounted(const std::string& filepath, EntryInfo* out) {
+    std::string entryPath;
+    auto archive = ResolveMounted(filepath, entryPath);
+    return archive && archive->Find(entryPath, out);
+}
+
+bool AssetArchive::OpenMounted(const std::string& filepath, MappedFile& out) {
+    std::string entryPath;
+    auto archive = ResolveMounted(filepath, entryPath);
+    return archive && archive->OpenEntry(entryPath, out);
+}
+
+} // namespace utils
+} // namespace metagfx
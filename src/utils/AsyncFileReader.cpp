@@ -0,0 +1,543 @@
+// ============================================================================
+// src/utils/AsyncFileReader.cpp
+// ============================================================================
+#include "metagfx/utils/AsyncFileReader.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__) && __has_include(<linux/io_uring.h>)
+    #define METAGFX_HAS_IO_URING
+    #include <linux/io_uring.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <sys/uio.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+// ============================================================================
+// AsyncFile
+// ============================================================================
+
+AsyncFile::~AsyncFile() {
+    Close();
+}
+
+#ifdef _WIN32
+
+bool AsyncFile::Open(const std::string& filepath) {
+    Close();
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        return false;
+    }
+    m_Handle = file;
+    m_Size = static_cast<uint64>(size.QuadPart);
+    return true;
+}
+
+void AsyncFile::Close() {
+    if (m_Handle) {
+        CloseHandle(static_cast<HANDLE>(m_Handle));
+    }
+    m_Handle = nullptr;
+    m_Size = 0;
+}
+
+bool AsyncFile::IsOpen() const {
+    return m_Handle != nullptr;
+}
+
+bool AsyncFile::ReadAt(uint64 offset, void* dst, uint64 size) const {
+    // An OVERLAPPED offset makes the read positional, so reads may run at once
+    uint8* target = static_cast<uint8*>(dst);
+    while (size > 0) {
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD read = 0;
+        DWORD request = static_cast<DWORD>(std::min<uint64>(size, 1u << 30));
+        if (!ReadFile(static_cast<HANDLE>(m_Handle), target, request, &read, &overlapped) || read == 0) {
+            return false;
+        }
+        target += read;
+        offset += read;
+        size -= read;
+    }
+    return true;
+}
+
+#else
+
+bool AsyncFile::Open(const std::string& filepath) {
+    Close();
+    int fd = open(filepath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        close(fd);
+        return false;
+    }
+    m_Handle = fd;
+    m_Size = static_cast<uint64>(info.st_size);
+    return true;
+}
+
+void AsyncFile::Close() {
+    if (m_Handle >= 0) {
+        close(m_Handle);
+    }
+    m_Handle = -1;
+    m_Size = 0;
+}
+
+bool AsyncFile::IsOpen() const {
+    return m_Handle >= 0;
+}
+
+bool AsyncFile::ReadAt(uint64 offset, void* dst, uint64 size) const {
+    uint8* target = static_cast<uint8*>(dst);
+    while (size > 0) {
+        ssize_t read = pread(m_Handle, target, static_cast<size_t>(std::min<uint64>(size, 1u << 30)),
+                             static_cast<off_t>(offset));
+        if (read < 0 && errno == EINTR) {
+            continue;
+        }
+        if (read <= 0) {
+            return false;
+        }
+        target += read;
+        offset += static_cast<uint64>(read);
+        size -= static_cast<uint64>(read);
+    }
+    return true;
+}
+
+#endif
+
+// ============================================================================
+// io_uring backend
+// ============================================================================
+
+namespace {
+
+#ifdef METAGFX_HAS_IO_URING
+
+// The ring's shared indices are written by the kernel on one side
+uint32 LoadAcquire(const uint32* value) {
+    return std::atomic_ref<const uint32>(*value).load(std::memory_order_acquire);
+}
+
+void StoreRelease(uint32* value, uint32 newValue) {
+    std::atomic_ref<uint32>(*value).store(newValue, std::memory_order_release);
+}
+
+// One ring, QUEUE_DEPTH reads in flight, each in a registered buffer of BUFFER_SIZE or,
+// when larger, a heap buffer. Raw system calls, so there is no liburing dependency.
+class IoUring {
+public:
+    static constexpr uint32 QUEUE_DEPTH = AsyncFileReader::QUEUE_DEPTH;
+    static constexpr uint64 BUFFER_SIZE = AsyncFileReader::BUFFER_SIZE;
+
+    IoUring() = default;
+    ~IoUring();
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    bool Init();
+    bool HasFixedBuffers() const { return m_FixedBuffers; }
+
+    void Read(int fd, uint64 offset, uint64 size, FileReadCallback callback, JobCounter* counter);
+
+private:
+    struct Request {
+        int fd = -1;
+        uint64 offset = 0;
+        uint64 size = 0;
+        FileReadCallback callback;
+        JobCounter* counter = nullptr;  // Held since Read()
+    };
+
+    struct Slot {
+        Request request;
+        int32 buffer = -1;                           // Registered buffer, or -1
+        std::shared_ptr<std::vector<uint8>> heap;    // Reads larger than BUFFER_SIZE
+        uint64 done = 0;                             // Landed so far; short reads go again
+        iovec vector = {};
+    };
+
+    struct Finished {
+        Request request;
+        int32 buffer = -1;
+        std::shared_ptr<std::vector<uint8>> heap;
+        bool succeeded = false;
+    };
+
+    uint8* GetTarget(const Slot& slot) const;
+    void PushLocked(uint32 slot);    // Queues the slot's read as an SQE
+    void SubmitLocked();             // Starts pending reads in free slots and submits the SQEs
+    void CompletionLoop();
+    void Dispatch(Finished& finished);
+    void ReleaseBuffer(int32 buffer);
+    void Destroy();
+
+    int m_RingFd = -1;
+    void* m_SqRing = MAP_FAILED;
+    void* m_CqRing = MAP_FAILED;
+    size_t m_SqRingSize = 0;
+    size_t m_CqRingSize = 0;
+    io_uring_sqe* m_Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t m_SqesSize = 0;
+    uint32* m_SqTail = nullptr;
+    uint32* m_SqMask = nullptr;
+    uint32* m_SqArray = nullptr;
+    uint32* m_CqHead = nullptr;
+    uint32* m_CqTail = nullptr;
+    uint32* m_CqMask = nullptr;
+    io_uring_cqe* m_Cqes = nullptr;
+
+    uint8* m_Buffers = nullptr;  // QUEUE_DEPTH buffers of BUFFER_SIZE, page-aligned
+    bool m_FixedBuffers = false; // Registered with the ring; otherwise read with READV
+
+    std::mutex m_Mutex;
+    std::deque<Request> m_Pending;  // Waiting for a slot or a buffer
+    std::vector<Slot> m_Slots;
+    std::vector<uint32> m_FreeSlots;
+    std::vector<int32> m_FreeBuffers;
+    uint32 m_Unsubmitted = 0;       // SQEs not yet passed to io_uring_enter()
+    bool m_Stopping = false;
+    std::thread m_Thread;
+};
+
+bool IoUring::Init() {
+    // Twice the reads in flight, so the destructor's wake-up always finds room
+    io_uring_params params = {};
+    m_RingFd = static_cast<int>(syscall(__NR_io_uring_setup, QUEUE_DEPTH * 2, &params));
+    if (m_RingFd < 0) {
+        return false;
+    }
+
+    m_SqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32);
+    m_CqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (singleMap) {
+        m_SqRingSize = m_CqRingSize = std::max(m_SqRingSize, m_CqRingSize);
+    }
+    m_SqRing = mmap(nullptr, m_SqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_RingFd,
+                    IORING_OFF_SQ_RING);
+    if (m_SqRing == MAP_FAILED) {
+        Destroy();
+        return false;
+    }
+    m_CqRing = singleMap ? m_SqRing
+                         : mmap(nullptr, m_CqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                m_RingFd, IORING_OFF_CQ_RING);
+    m_SqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    m_Sqes = static_cast<io_uring_sqe*>(mmap(nullptr, m_SqesSize, PROT_READ | PROT_WRITE,
+                                             MAP_SHARED | MAP_POPULATE, m_RingFd, IORING_OFF_SQES));
+    if (m_CqRing == MAP_FAILED || m_Sqes == MAP_FAILED) {
+        Destroy();
+        return false;
+    }
+
+    uint8* sq = static_cast<uint8*>(m_SqRing);
+    uint8* cq = static_cast<uint8*>(m_CqRing);
+    m_SqTail = reinterpret_cast<uint32*>(sq + params.sq_off.tail);
+    m_SqMask = reinterpret_cast<uint32*>(sq + params.sq_off.ring_mask);
+    m_SqArray = reinterpret_cast<uint32*>(sq + params.sq_off.array);
+    m_CqHead = reinterpret_cast<uint32*>(cq + params.cq_off.head);
+    m_CqTail = reinterpret_cast<uint32*>(cq + params.cq_off.tail);
+    m_CqMask = reinterpret_cast<uint32*>(cq + params.cq_off.ring_mask);
+    m_Cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+    // Registered buffers spare the kernel mapping the pages on every read; a low
+    // RLIMIT_MEMLOCK refuses them, and the same buffers are then read into with READV
+    m_Buffers = static_cast<uint8*>(std::aligned_alloc(4096, QUEUE_DEPTH * BUFFER_SIZE));
+    if (!m_Buffers) {
+        Destroy();
+        return false;
+    }
+    iovec vectors[QUEUE_DEPTH];
+    for (uint32 i = 0; i < QUEUE_DEPTH; ++i) {
+        vectors[i].iov_base = m_Buffers + i * BUFFER_SIZE;
+        vectors[i].iov_len = BUFFER_SIZE;
+    }
+    m_FixedBuffers = syscall(__NR_io_uring_register, m_RingFd, IORING_REGISTER_BUFFERS, vectors, QUEUE_DEPTH) == 0;
+
+    m_Slots.resize(QUEUE_DEPTH);
+    for (uint32 i = QUEUE_DEPTH; i-- > 0;) {
+        m_FreeSlots.push_back(i);
+        m_FreeBuffers.push_back(static_cast<int32>(i));
+    }
+    m_Thread = std::thread([this]() { CompletionLoop(); });
+    return true;
+}
+
+IoUring::~IoUring() {
+    if (m_Thread.joinable()) {
+        // A NOP without user data wakes the completion thread, which leaves once every
+        // read has finished
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stopping = true;
+        uint32 tail = *m_SqTail;
+        uint32 index = tail & *m_SqMask;
+        memset(&m_Sqes[index], 0, sizeof(io_uring_sqe));
+        m_Sqes[index].opcode = IORING_OP_NOP;
+        m_SqArray[index] = index;
+        StoreRelease(m_SqTail, tail + 1);
+        ++m_Unsubmitted;
+        SubmitLocked();
+    }
+    if (m_Thread.joinable()) {
+        m_Thread.join();
+    }
+    Destroy();
+}
+
+void IoUring::Destroy() {
+    if (m_Sqes != MAP_FAILED) {
+        munmap(m_Sqes, m_SqesSize);
+    }
+    if (m_CqRing != MAP_FAILED && m_CqRing != m_SqRing) {
+        munmap(m_CqRing, m_CqRingSize);
+    }
+    if (m_SqRing != MAP_FAILED) {
+        munmap(m_SqRing, m_SqRingSize);
+    }
+    if (m_RingFd >= 0) {
+        close(m_RingFd);
+    }
+    std::free(m_Buffers);
+    m_Sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    m_SqRing = m_CqRing = MAP_FAILED;
+    m_RingFd = -1;
+    m_Buffers = nullptr;
+}
+
+uint8* IoUring::GetTarget(const Slot& slot) const {
+    return slot.buffer >= 0 ? m_Buffers + slot.buffer * BUFFER_SIZE : slot.heap->data();
+}
+
+void IoUring::PushLocked(uint32 slotIndex) {
+    Slot& slot = m_Slots[slotIndex];
+    uint8* target = GetTarget(slot) + slot.done;
+    uint32 length = static_cast<uint32>(std::min<uint64>(slot.request.size - slot.done, 1u << 30));
+
+    uint32 tail = *m_SqTail;  // Only written here, under the mutex
+    uint32 index = tail & *m_SqMask;
+    io_uring_sqe& sqe = m_Sqes[index];
+    memset(&sqe, 0, sizeof(sqe));
+    if (slot.buffer >= 0 && m_FixedBuffers) {
+        sqe.opcode = IORING_OP_READ_FIXED;
+        sqe.addr = reinterpret_cast<uint64>(target);
+        sqe.len = length;
+        sqe.buf_index = static_cast<uint16>(slot.buffer);
+    } else {
+        slot.vector.iov_base = target;
+        slot.vector.iov_len = length;
+        sqe.opcode = IORING_OP_READV;
+        sqe.addr = reinterpret_cast<uint64>(&slot.vector);
+        sqe.len = 1;
+    }
+    sqe.fd = slot.request.fd;
+    sqe.off = slot.request.offset + slot.done;
+    sqe.user_data = slotIndex + 1;
+    m_SqArray[index] = index;
+    StoreRelease(m_SqTail, tail + 1);
+    ++m_Unsubmitted;
+}
+
+void IoUring::SubmitLocked() {
+    // In order: a read waiting for a buffer holds up the ones behind it
+    while (!m_Pending.empty() && !m_FreeSlots.empty()) {
+        Request& next = m_Pending.front();
+        int32 buffer = -1;
+        if (next.size <= BUFFER_SIZE) {
+            if (m_FreeBuffers.empty()) {
+                break;
+            }
+            buffer = m_FreeBuffers.back();
+            m_FreeBuffers.pop_back();
+        }
+
+        uint32 slotIndex = m_FreeSlots.back();
+        m_FreeSlots.pop_back();
+        Slot& slot = m_Slots[slotIndex];
+        slot.request = std::move(next);
+        slot.buffer = buffer;
+        slot.heap = buffer < 0 ? std::make_shared<std::vector<uint8>>(slot.request.size) : nullptr;
+        slot.done = 0;
+        m_Pending.pop_front();
+        PushLocked(slotIndex);
+    }
+
+    // A failed or partial submission is retried on the next call; the completion thread
+    // makes one after every batch of completions
+    if (m_Unsubmitted > 0) {
+        long submitted = syscall(__NR_io_uring_enter, m_RingFd, m_Unsubmitted, 0, 0, nullptr, 0);
+        if (submitted > 0) {
+            m_Unsubmitted -= static_cast<uint32>(submitted);
+        }
+    }
+}
+
+void IoUring::Read(int fd, uint64 offset, uint64 size, FileReadCallback callback, JobCounter* counter) {
+    if (counter) {
+        JobSystem::Hold(*counter);
+    }
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Pending.push_back({ fd, offset, size, std::move(callback), counter });
+    SubmitLocked();
+}
+
+void IoUring::CompletionLoop() {
+    std::vector<Finished> finished;
+    for (;;) {
+        syscall(__NR_io_uring_enter, m_RingFd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+        bool stop = false;
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            uint32 head = *m_CqHead;
+            uint32 tail = LoadAcquire(m_CqTail);
+            for (; head != tail; ++head) {
+                const io_uring_cqe& cqe = m_Cqes[head & *m_CqMask];
+                if (cqe.user_data == 0) {
+                    continue;  // The destructor's wake-up
+                }
+                uint32 slotIndex = static_cast<uint32>(cqe.user_data - 1);
+                Slot& slot = m_Slots[slotIndex];
+                if (cqe.res > 0 && slot.done + static_cast<uint64>(cqe.res) < slot.request.size) {
+                    slot.done += static_cast<uint64>(cqe.res);
+                    PushLocked(slotIndex);
+                    continue;
+                }
+                bool succeeded = cqe.res >= 0 && slot.done + static_cast<uint64>(cqe.res) == slot.request.size;
+                finished.push_back({ std::move(slot.request), slot.buffer, std::move(slot.heap), succeeded });
+                m_FreeSlots.push_back(slotIndex);
+            }
+            StoreRelease(m_CqHead, head);
+            SubmitLocked();
+            stop = m_Stopping && m_Pending.empty() && m_FreeSlots.size() == m_Slots.size();
+        }
+
+        for (Finished& read : finished) {
+            Dispatch(read);
+        }
+        finished.clear();
+        if (stop) {
+            return;
+        }
+    }
+}
+
+void IoUring::Dispatch(Finished& finished) {
+    const uint8* data = nullptr;
+    if (finished.succeeded) {
+        data = finished.buffer >= 0 ? m_Buffers + finished.buffer * BUFFER_SIZE : finished.heap->data();
+    }
+    uint64 size = finished.request.size;
+    int32 buffer = finished.buffer;
+    JobCounter* counter = finished.request.counter;
+    JobSystem::Run([this, callback = std::move(finished.request.callback), data, size, buffer,
+                    heap = std::move(finished.heap)]() {
+        callback(data, size);
+        if (buffer >= 0) {
+            ReleaseBuffer(buffer);
+        }
+    }, counter);
+    if (counter) {
+        JobSystem::Release(*counter);  // The job holds it now
+    }
+}
+
+void IoUring::ReleaseBuffer(int32 buffer) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_FreeBuffers.push_back(buffer);
+    SubmitLocked();
+}
+
+IoUring* GetIoUring() {
+    static std::unique_ptr<IoUring> ring = []() {
+        auto created = std::make_unique<IoUring>();
+        if (!created->Init()) {
+            METAGFX_INFO << "File reads: io_uring unavailable, reading on jobs";
+            return std::unique_ptr<IoUring>();
+        }
+        METAGFX_INFO << "File reads: io_uring, queue depth " << AsyncFileReader::QUEUE_DEPTH
+                     << (created->HasFixedBuffers() ? ", registered buffers" : "");
+        return created;
+    }();
+    return ring.get();
+}
+
+#endif
+
+} // anonymous namespace
+
+// ============================================================================
+// AsyncFileReader
+// ============================================================================
+
+void AsyncFileReader::Read(const AsyncFile& file, uint64 offset, uint64 size, FileReadCallback callback,
+                           JobCounter* counter) {
+#ifdef METAGFX_HAS_IO_URING
+    if (size > 0) {
+        if (IoUring* ring = GetIoUring()) {
+            ring->Read(file.m_Handle, offset, size, std::move(callback), counter);
+            return;
+        }
+    }
+#endif
+
+    // A job per read, blocking in its positional read
+    const AsyncFile* source = &file;
+    JobSystem::Run([source, offset, size, callback = std::move(callback)]() {
+        std::vector<uint8> buffer(static_cast<size_t>(std::max<uint64>(size, 1)));
+        bool succeeded = source->ReadAt(offset, buffer.data(), size);
+        callback(succeeded ? buffer.data() : nullptr, size);
+    }, counter);
+}
+
+bool AsyncFileReader::UsesIoUring() {
+#ifdef METAGFX_HAS_IO_URING
+    return GetIoUring() != nullptr;
+#else
+    return false;
+#endif
+}
+
+} // namespace utils
+} // namespace metagfx
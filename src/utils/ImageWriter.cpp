@@ -0,0 +1,398 @@
+// ============================================================================
+// src/utils/ImageWriter.cpp
+// ============================================================================
+#include "metagfx/utils/ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace metagfx {
+namespace utils {
+
+// ----------------------------------------------------------------------------
+// Deflate (RFC 1951) with the fixed Huffman codes, in a zlib stream (RFC 1950)
+// ----------------------------------------------------------------------------
+
+namespace {
+
+constexpr uint32 WINDOW_SIZE = 32768;
+constexpr uint32 HASH_BITS = 15;
+constexpr uint32 MIN_MATCH = 3;
+constexpr uint32 MAX_MATCH = 258;
+constexpr uint32 MAX_CHAIN = 32;  // Earlier occurrences tried per position
+
+constexpr uint16 LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                     35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+constexpr uint8 LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                     3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+constexpr uint16 DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                       257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                       8193, 12289, 16385, 24577 };
+constexpr uint8 DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                       7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8>& out) : m_Out(out) {}
+
+    // LSB first, as deflate packs everything but Huffman codes
+    void Write(uint32 value, uint32 count) {
+        m_Bits |= static_cast<uint64>(value) << m_Count;
+        m_Count += count;
+        while (m_Count >= 8) {
+            m_Out.push_back(static_cast<uint8>(m_Bits));
+            m_Bits >>= 8;
+            m_Count -= 8;
+        }
+    }
+
+    // Huffman codes go MSB first
+    void WriteCode(uint32 code, uint32 length) {
+        uint32 reversed = 0;
+        for (uint32 i = 0; i < length; ++i) {
+            reversed |= ((code >> i) & 1u) << (length - 1 - i);
+        }
+        Write(reversed, length);
+    }
+
+    void Flush() {
+        if (m_Count > 0) {
+            m_Out.push_back(static_cast<uint8>(m_Bits));
+        }
+        m_Bits = 0;
+        m_Count = 0;
+    }
+
+private:
+    std::vector<uint8>& m_Out;
+    uint64 m_Bits = 0;
+    uint32 m_Count = 0;
+};
+
+void WriteLiteralLength(BitWriter& bits, uint32 symbol) {
+    if (symbol < 144) {
+        bits.WriteCode(0x30 + symbol, 8);
+    } else if (symbol < 256) {
+        bits.WriteCode(0x190 + symbol - 144, 9);
+    } else if (symbol < 280) {
+        bits.WriteCode(symbol - 256, 7);
+    } else {
+        bits.WriteCode(0xC0 + symbol - 280, 8);
+    }
+}
+
+void WriteMatch(BitWriter& bits, uint32 length, uint32 distance) {
+    uint32 lengthCode = static_cast<uint32>(std::upper_bound(std::begin(LENGTH_BASE), std::end(LENGTH_BASE), length) -
+                                            std::begin(LENGTH_BASE)) - 1;
+    WriteLiteralLength(bits, 257 + lengthCode);
+    bits.Write(length - LENGTH_BASE[lengthCode], LENGTH_EXTRA[lengthCode]);
+
+    uint32 distanceCode = static_cast<uint32>(std::upper_bound(std::begin(DISTANCE_BASE), std::end(DISTANCE_BASE),
+                                                               distance) - std::begin(DISTANCE_BASE)) - 1;
+    bits.WriteCode(distanceCode, 5);
+    bits.Write(distance - DISTANCE_BASE[distanceCode], DISTANCE_EXTRA[distanceCode]);
+}
+
+uint32 Adler32(const uint8* data, size_t size) {
+    uint32 a = 1, b = 0;
+    while (size > 0) {
+        size_t block = std::min<size_t>(size, 5552);  // Sums stay below 2^32 until reduced
+        for (size_t i = 0; i < block; ++i) {
+            a += data[i];
+            b += a;
+        }
+        a %= 65521;
+        b %= 65521;
+        data += block;
+        size -= block;
+    }
+    return (b << 16) | a;
+}
+
+void AppendBigEndian(std::vector<uint8>& out, uint32 value) {
+    out.push_back(static_cast<uint8>(value >> 24));
+    out.push_back(static_cast<uint8>(value >> 16));
+    out.push_back(static_cast<uint8>(value >> 8));
+    out.push_back(static_cast<uint8>(value));
+}
+
+// One final fixed-Huffman block; greedy matches from hash chains over the last 32 KB
+void Deflate(const std::vector<uint8>& data, std::vector<uint8>& out) {
+    out.push_back(0x78);  // Deflate, 32 KB window
+    out.push_back(0x01);  // Fastest compression level, no dictionary
+    BitWriter bits(out);
+    bits.Write(1, 1);  // Final block
+    bits.Write(1, 2);  // Fixed Huffman codes
+
+    std::vector<int32> head(size_t(1) << HASH_BITS, -1);
+    std::vector<int32> previous(WINDOW_SIZE, -1);
+    const uint32 size = static_cast<uint32>(data.size());
+    auto hash = [&](uint32 position) {
+        uint32 value = data[position] | (data[position + 1] << 8) | (data[position + 2] << 16);
+        return (value * 2654435761u) >> (32 - HASH_BITS);
+    };
+    auto insert = [&](uint32 position) {
+        if (position + MIN_MATCH <= size) {
+            uint32 key = hash(position);
+            previous[position % WINDOW_SIZE] = head[key];
+            head[key] = static_cast<int32>(position);
+        }
+    };
+
+    uint32 position = 0;
+    while (position < size) {
+        uint32 bestLength = 0;
+        uint32 bestDistance = 0;
+        if (position + MIN_MATCH <= size) {
+            uint32 maxLength = std::min(MAX_MATCH, size - position);
+            int32 candidate = head[hash(position)];
+            for (uint32 chain = 0; candidate >= 0 && chain < MAX_CHAIN; ++chain) {
+                uint32 distance = position - static_cast<uint32>(candidate);
+                if (distance > WINDOW_SIZE) {
+                    break;
+                }
+                const uint8* a = &data[candidate];
+                const uint8* b = &data[position];
+                if (a[bestLength] == b[bestLength]) {  // Only a longer match can win
+                    uint32 length = 0;
+                    while (length < maxLength && a[length] == b[length]) {
+                        ++length;
+                    }
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = distance;
+                        if (length == maxLength) {
+                            break;
+                        }
+                    }
+                }
+                int32 next = previous[static_cast<uint32>(candidate) % WINDOW_SIZE];
+                if (next >= candidate) {  // Overwritten by a later position
+                    break;
+                }
+                candidate = next;
+            }
+        }
+
+        if (bestLength >= MIN_MATCH) {
+            WriteMatch(bits, bestLength, bestDistance);
+            for (uint32 i = 0; i < bestLength; ++i) {
+                insert(position + i);
+            }
+            position += bestLength;
+        } else {
+            WriteLiteralLength(bits, data[position]);
+            insert(position);
+            ++position;
+        }
+    }
+    WriteLiteralLength(bits, 256);  // End of block
+    bits.Flush();
+
+    AppendBigEndian(out, Adler32(data.data(), data.size()));
+}
+
+// ----------------------------------------------------------------------------
+// PNG
+// ----------------------------------------------------------------------------
+
+const std::array<uint32, 256>& CrcTable() {
+    static const std::array<uint32, 256> table = [] {
+        std::array<uint32, 256> result{};
+        for (uint32 n = 0; n < 256; ++n) {
+            uint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+    return table;
+}
+
+void AppendChunk(std::vector<uint8>& out, const char type[4], const std::vector<uint8>& data) {
+    AppendBigEndian(out, static_cast<uint32>(data.size()));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+
+    const std::array<uint32, 256>& table = CrcTable();
+    uint32 crc = 0xFFFFFFFFu;
+    for (size_t i = start; i < out.size(); ++i) {
+        crc = table[(crc ^ out[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    AppendBigEndian(out, crc ^ 0xFFFFFFFFu);
+}
+
+uint8 Paeth(int a, int b, int c) {
+    int p = a + b - c;
+    int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    return static_cast<uint8>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+}
+
+} // anonymous namespace
+
+std::vector<uint8> EncodePNG(const ImageView& image, bool swapRedBlue) {
+    constexpr uint32 CHANNELS = 3;
+    const uint32 rowSize = image.width * CHANNELS;
+
+    // Each row: its filter type, then its residuals
+    std::vector<uint8> filtered;
+    filtered.reserve(static_cast<size_t>(rowSize + 1) * image.height);
+    std::vector<uint8> row(rowSize), above(rowSize, 0);
+    std::array<std::vector<uint8>, 5> candidates;
+    for (std::vector<uint8>& candidate : candidates) {
+        candidate.resize(rowSize);
+    }
+    for (uint32 y = 0; y < image.height; ++y) {
+        const uint8* texels = image.data + static_cast<size_t>(y) * image.rowPitch;
+        for (uint32 x = 0; x < image.width; ++x) {
+            row[x * 3 + 0] = texels[x * 4 + (swapRedBlue ? 2 : 0)];
+            row[x * 3 + 1] = texels[x * 4 + 1];
+            row[x * 3 + 2] = texels[x * 4 + (swapRedBlue ? 0 : 2)];
+        }
+
+        // The filter whose residuals sum to the least as signed bytes
+        uint32 bestFilter = 0;
+        uint64 bestSum = UINT64_MAX;
+        for (uint32 filter = 0; filter < 5; ++filter) {
+            std::vector<uint8>& out = candidates[filter];
+            uint64 sum = 0;
+            for (uint32 i = 0; i < rowSize; ++i) {
+                int a = i >= CHANNELS ? row[i - CHANNELS] : 0;
+                int b = above[i];
+                int c = i >= CHANNELS ? above[i - CHANNELS] : 0;
+                uint8 predicted = 0;
+                switch (filter) {
+                    case 1: predicted = static_cast<uint8>(a); break;
+                    case 2: predicted = static_cast<uint8>(b); break;
+                    case 3: predicted = static_cast<uint8>((a + b) / 2); break;
+                    case 4: predicted = Paeth(a, b, c); break;
+                    default: break;
+                }
+                out[i] = static_cast<uint8>(row[i] - predicted);
+                sum += static_cast<uint64>(std::abs(static_cast<int>(static_cast<int8>(out[i]))));
+            }
+            if (sum < bestSum) {
+                bestSum = sum;
+                bestFilter = filter;
+            }
+        }
+        filtered.push_back(static_cast<uint8>(bestFilter));
+        filtered.insert(filtered.end(), candidates[bestFilter].begin(), candidates[bestFilter].end());
+        std::swap(row, above);
+    }
+
+    std::vector<uint8> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8> header;
+    AppendBigEndian(header, image.width);
+    AppendBigEndian(header, image.height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });  // 8 bits per channel, RGB, deflate, adaptive filters, progressive off
+    AppendChunk(png, "IHDR", header);
+
+    std::vector<uint8> compressed;
+    Deflate(filtered, compressed);
+    AppendChunk(png, "IDAT", compressed);
+    AppendChunk(png, "IEND", {});
+    return png;
+}
+
+// ----------------------------------------------------------------------------
+// OpenEXR (little-endian throughout)
+// ----------------------------------------------------------------------------
+
+namespace {
+
+template <typename T>
+void AppendLittleEndian(std::vector<uint8>& out, T value) {
+    uint8 bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));  // Every supported target is little-endian
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void AppendString(std::vector<uint8>& out, const char* text) {
+    out.insert(out.end(), text, text + std::strlen(text) + 1);
+}
+
+void AppendAttribute(std::vector<uint8>& out, const char* name, const char* type, const std::vector<uint8>& value) {
+    AppendString(out, name);
+    AppendString(out, type);
+    AppendLittleEndian(out, static_cast<int32>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+} // anonymous namespace
+
+std::vector<uint8> EncodeEXR(const ImageView& image) {
+    // Channels in the alphabetical order the format stores them in, by RGBA16F offset
+    static const char* CHANNEL_NAMES[3] = { "B", "G", "R" };
+    static const uint32 CHANNEL_OFFSETS[3] = { 4, 2, 0 };
+
+    std::vector<uint8> exr;
+    AppendLittleEndian(exr, static_cast<uint32>(20000630));  // Magic number
+    AppendLittleEndian(exr, static_cast<uint32>(2));         // Version 2, single-part scanlines
+
+    std::vector<uint8> channels;
+    for (const char* name : CHANNEL_NAMES) {
+        AppendString(channels, name);
+        AppendLittleEndian(channels, static_cast<int32>(1));  // HALF
+        channels.insert(channels.end(), { 0, 0, 0, 0 });      // pLinear, reserved
+        AppendLittleEndian(channels, static_cast<int32>(1));  // x and y sampling
+        AppendLittleEndian(channels, static_cast<int32>(1));
+    }
+    channels.push_back(0);
+    AppendAttribute(exr, "channels", "chlist", channels);
+    AppendAttribute(exr, "compression", "compression", { 0 });  // NO_COMPRESSION
+
+    std::vector<uint8> window;
+    for (int32 value : { 0, 0, static_cast<int32>(image.width) - 1, static_cast<int32>(image.height) - 1 }) {
+        AppendLittleEndian(window, value);
+    }
+    AppendAttribute(exr, "dataWindow", "box2i", window);
+    AppendAttribute(exr, "displayWindow", "box2i", window);
+    AppendAttribute(exr, "lineOrder", "lineOrder", { 0 });  // INCREASING_Y
+
+    std::vector<uint8> one, center;
+    AppendLittleEndian(one, 1.0f);
+    AppendLittleEndian(center, 0.0f);
+    AppendLittleEndian(center, 0.0f);
+    AppendAttribute(exr, "pixelAspectRatio", "float", one);
+    AppendAttribute(exr, "screenWindowCenter", "v2f", center);
+    AppendAttribute(exr, "screenWindowWidth", "float", one);
+    exr.push_back(0);  // End of the header
+
+    // Offset table, then one chunk per scanline: y, size, then each channel's halves
+    const uint64 lineSize = static_cast<uint64>(image.width) * 3 * sizeof(uint16);
+    uint64 chunkOffset = exr.size() + static_cast<uint64>(image.height) * sizeof(uint64);
+    exr.reserve(chunkOffset + image.height * (8 + lineSize));
+    for (uint32 y = 0; y < image.height; ++y) {
+        AppendLittleEndian(exr, chunkOffset + y * (8 + lineSize));
+    }
+    for (uint32 y = 0; y < image.height; ++y) {
+        AppendLittleEndian(exr, static_cast<int32>(y));
+        AppendLittleEndian(exr, static_cast<int32>(lineSize));
+        const uint8* texels = image.data + static_cast<size_t>(y) * image.rowPitch;
+        for (uint32 offset : CHANNEL_OFFSETS) {
+            for (uint32 x = 0; x < image.width; ++x) {
+                exr.insert(exr.end(), texels + x * 8 + offset, texels + x * 8 + offset + 2);
+            }
+        }
+    }
+    return exr;
+}
+
+bool WriteFileBytes(const std::string& path, const std::vector<uint8>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return file.good();
+}
+
+} // namespace utils
+} // namespace metagfx
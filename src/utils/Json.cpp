@@ -0,0 +1,347 @@
+// ============================================================================
+// src/utils/Json.cpp
+// ============================================================================
+#include "metagfx/utils/Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace metagfx {
+namespace utils {
+
+static const JsonValue s_NullValue;
+static const std::string s_EmptyString;
+
+// Recursive descent parser; nesting is limited so hostile files cannot overflow the stack
+class JsonParser {
+public:
+    static constexpr uint32 MAX_DEPTH = 256;
+
+    JsonParser(const char* text, size_t length) : m_Text(text), m_End(text + length), m_Pos(text) {}
+
+    bool ParseDocument(JsonValue& out) {
+        SkipWhitespace();
+        if (!ParseValue(out, 0)) {
+            return false;
+        }
+        SkipWhitespace();
+        if (m_Pos != m_End) {
+            return Fail("unexpected data after the document");
+        }
+        return true;
+    }
+
+    std::string GetError() const {
+        return m_Error + " at offset " + std::to_string(m_ErrorOffset);
+    }
+
+private:
+    bool Fail(const char* message) {
+        if (m_Error.empty()) {
+            m_Error = message;
+            m_ErrorOffset = static_cast<size_t>(m_Pos - m_Text);
+        }
+        return false;
+    }
+
+    void SkipWhitespace() {
+        while (m_Pos < m_End && (*m_Pos == ' ' || *m_Pos == '\t' || *m_Pos == '\n' || *m_Pos == '\r')) {
+            ++m_Pos;
+        }
+    }
+
+    bool Consume(const char* literal) {
+        size_t length = std::strlen(literal);
+        if (static_cast<size_t>(m_End - m_Pos) < length || std::memcmp(m_Pos, literal, length) != 0) {
+            return false;
+        }
+        m_Pos += length;
+        return true;
+    }
+
+    bool ParseValue(JsonValue& out, uint32 depth) {
+        if (depth > MAX_DEPTH) {
+            return Fail("nesting too deep");
+        }
+        if (m_Pos >= m_End) {
+            return Fail("unexpected end of input");
+        }
+
+        switch (*m_Pos) {
+            case '{': return ParseObject(out, depth);
+            case '[': return ParseArray(out, depth);
+            case '"':
+                out.m_Type = JsonValue::Type::String;
+                return ParseString(out.m_String);
+            case 't':
+                if (!Consume("true")) return Fail("invalid literal");
+                out.m_Type = JsonValue::Type::Bool;
+                out.m_Bool = true;
+                return true;
+            case 'f':
+                if (!Consume("false")) return Fail("invalid literal");
+                out.m_Type = JsonValue::Type::Bool;
+                out.m_Bool = false;
+                return true;
+            case 'n':
+                if (!Consume("null")) return Fail("invalid literal");
+                out.m_Type = JsonValue::Type::Null;
+                return true;
+            default:
+                return ParseNumber(out);
+        }
+    }
+
+    bool ParseNumber(JsonValue& out) {
+        const char* start = m_Pos;
+        if (m_Pos < m_End && *m_Pos == '-') ++m_Pos;
+        auto digits = [&]() {
+            const char* begin = m_Pos;
+            while (m_Pos < m_End && *m_Pos >= '0' && *m_Pos <= '9') ++m_Pos;
+            return m_Pos != begin;
+        };
+        if (!digits()) {
+            return Fail("invalid value");
+        }
+        if (m_Pos < m_End && *m_Pos == '.') {
+            ++m_Pos;
+            if (!digits()) return Fail("invalid number");
+        }
+        if (m_Pos < m_End && (*m_Pos == 'e' || *m_Pos == 'E')) {
+            ++m_Pos;
+            if (m_Pos < m_End && (*m_Pos == '+' || *m_Pos == '-')) ++m_Pos;
+            if (!digits()) return Fail("invalid number");
+        }
+
+        // strtod needs a terminated buffer; numbers are short
+        char buffer[64];
+        size_t length = static_cast<size_t>(m_Pos - start);
+        if (length >= sizeof(buffer)) {
+            return Fail("number too long");
+        }
+        std::memcpy(buffer, start, length);
+        buffer[length] = '\0';
+
+        out.m_Type = JsonValue::Type::Number;
+        out.m_Number = std::strtod(buffer, nullptr);
+        return true;
+    }
+
+    static void AppendUTF8(std::string& out, uint32 codepoint) {
+        if (codepoint < 0x80) {
+            out += static_cast<char>(codepoint);
+        } else if (codepoint < 0x800) {
+            out += static_cast<char>(0xC0 | (codepoint >> 6));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else if (codepoint < 0x10000) {
+            out += static_cast<char>(0xE0 | (codepoint >> 12));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        } else {
+            out += static_cast<char>(0xF0 | (codepoint >> 18));
+            out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+            out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+            out += static_cast<char>(0x80 | (codepoint & 0x3F));
+        }
+    }
+
+    bool ParseHex4(uint32& out) {
+        if (m_End - m_Pos < 4) {
+            return Fail("truncated escape");
+        }
+        out = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *m_Pos++;
+            out <<= 4;
+            if (c >= '0' && c <= '9') out |= static_cast<uint32>(c - '0');
+            else if (c >= 'a' && c <= 'f') out |= static_cast<uint32>(c - 'a' + 10);
+            else if (c >= 'A' && c <= 'F') out |= static_cast<uint32>(c - 'A' + 10);
+            else return Fail("invalid escape");
+        }
+        return true;
+    }
+
+    bool ParseString(std::string& out) {
+        ++m_Pos;  // Opening quote
+        while (true) {
+            // Copy runs of plain characters at once
+            const char* runStart = m_Pos;
+            while (m_Pos < m_End && *m_Pos != '"' && *m_Pos != '\\') {
+                if (static_cast<unsigned char>(*m_Pos) < 0x20) {
+                    return Fail("control character in string");
+                }
+                ++m_Pos;
+            }
+            out.append(runStart, m_Pos);
+
+            if (m_Pos >= m_End) {
+                return Fail("unterminated string");
+            }
+            if (*m_Pos == '"') {
+                ++m_Pos;
+                return true;
+            }
+
+            ++m_Pos;  // Backslash
+            if (m_Pos >= m_End) {
+                return Fail("unterminated string");
+            }
+            char escape = *m_Pos++;
+            switch (escape) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32 codepoint;
+                    if (!ParseHex4(codepoint)) {
+                        return false;
+                    }
+                    // Surrogate pair
+                    if (codepoint >= 0xD800 && codepoint < 0xDC00 && Consume("\\u")) {
+                        uint32 low;
+                        if (!ParseHex4(low)) {
+                            return false;
+                        }
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                        }
+                    }
+                    AppendUTF8(out, codepoint);
+                    break;
+                }
+                default:
+                    return Fail("invalid escape");
+            }
+        }
+    }
+
+    bool ParseArray(JsonValue& out, uint32 depth) {
+        ++m_Pos;  // [
+        out.m_Type = JsonValue::Type::Array;
+        SkipWhitespace();
+        if (m_Pos < m_End && *m_Pos == ']') {
+            ++m_Pos;
+            return true;
+        }
+
+        while (true) {
+            SkipWhitespace();
+            out.m_Array.emplace_back();
+            if (!ParseValue(out.m_Array.back(), depth + 1)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (m_Pos >= m_End) {
+                return Fail("unterminated array");
+            }
+            char c = *m_Pos++;
+            if (c == ']') {
+                return true;
+            }
+            if (c != ',') {
+                return Fail("expected ',' or ']'");
+            }
+        }
+    }
+
+    bool ParseObject(JsonValue& out, uint32 depth) {
+        ++m_Pos;  // {
+        out.m_Type = JsonValue::Type::Object;
+        SkipWhitespace();
+        if (m_Pos < m_End && *m_Pos == '}') {
+            ++m_Pos;
+            return true;
+        }
+
+        while (true) {
+            SkipWhitespace();
+            if (m_Pos >= m_End || *m_Pos != '"') {
+                return Fail("expected member name");
+            }
+            out.m_Members.emplace_back();
+            JsonValue::Member& member = out.m_Members.back();
+            if (!ParseString(member.first)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (m_Pos >= m_End || *m_Pos != ':') {
+                return Fail("expected ':'");
+            }
+            ++m_Pos;
+            SkipWhitespace();
+            if (!ParseValue(member.second, depth + 1)) {
+                return false;
+            }
+            SkipWhitespace();
+            if (m_Pos >= m_End) {
+                return Fail("unterminated object");
+            }
+            char c = *m_Pos++;
+            if (c == '}') {
+                return true;
+            }
+            if (c != ',') {
+                return Fail("expected ',' or '}'");
+            }
+        }
+    }
+
+    const char* m_Text;
+    const char* m_End;
+    const char* m_Pos;
+    std::string m_Error;
+    size_t m_ErrorOffset = 0;
+};
+
+bool JsonValue::Parse(const char* text, size_t length, JsonValue& out, std::string* error) {
+    out = JsonValue();
+    JsonParser parser(text, length);
+    if (!parser.ParseDocument(out)) {
+        if (error) {
+            *error = parser.GetError();
+        }
+        out = JsonValue();
+        return false;
+    }
+    return true;
+}
+
+const std::string& JsonValue::AsString() const {
+    return IsString() ? m_String : s_EmptyString;
+}
+
+size_t JsonValue::Size() const {
+    if (IsArray()) return m_Array.size();
+    if (IsObject()) return m_Members.size();
+    return 0;
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const {
+    if (!IsArray() || index >= m_Array.size()) {
+        return s_NullValue;
+    }
+    return m_Array[index];
+}
+
+const JsonValue& JsonValue::operator[](std::string_view key) const {
+    if (IsObject()) {
+        for (const Member& member : m_Members) {
+            if (member.first == key) {
+                return member.second;
+            }
+        }
+    }
+    return s_NullValue;
+}
+
+bool JsonValue::Has(std::string_view key) const {
+    return !(*this)[key].IsNull();
+}
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,176 @@
+// ============================================================================
+// src/utils/MappedFile.cpp
+// ============================================================================
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/utils/AssetArchive.h"
+
+#ifdef _WIN32
+    #define WIN32_LEAN_AND_MEAN
+    #define NOMINMAX
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+namespace metagfx {
+namespace utils {
+
+MappedFile::~MappedFile() {
+    Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        Close();
+        m_Data = std::exchange(other.m_Data, nullptr);
+        m_Size = std::exchange(other.m_Size, 0);
+        m_SourcePath = std::move(other.m_SourcePath);
+        m_SourceOffset = std::exchange(other.m_SourceOffset, 0);
+        m_Archive = std::move(other.m_Archive);
+        m_Buffer = std::move(other.m_Buffer);
+#ifdef _WIN32
+        m_FileHandle = std::exchange(other.m_FileHandle, nullptr);
+        m_MappingHandle = std::exchange(other.m_MappingHandle, nullptr);
+#endif
+    }
+    return *this;
+}
+
+bool MappedFile::Open(const std::string& filepath) {
+    Close();
+    if (AssetArchive::HasMounts() && AssetArchive::OpenMounted(filepath, *this)) {
+        return true;
+    }
+    if (!Map(filepath)) {
+        return false;
+    }
+    m_SourcePath = filepath;
+    return true;
+}
+
+void MappedFile::Close() {
+    // Archive entries borrow the archive's mapping or own a plain buffer
+    if (m_Data && !m_Archive && m_Buffer.empty()) {
+        Unmap();
+    }
+    m_Data = nullptr;
+    m_Size = 0;
+    m_SourcePath.clear();
+    m_SourceOffset = 0;
+    m_Archive.reset();
+    m_Buffer = {};
+}
+
+void MappedFile::Prefetch(uint64 offset, uint64 size) const {
+    if (!m_Data || offset >= m_Size) {
+        return;
+    }
+    size = std::min(size, m_Size - offset);
+    if (m_Archive) {
+        m_Archive->Prefetch(m_SourceOffset + offset, size);
+    } else if (m_Buffer.empty()) {
+        PrefetchMapped(offset, size);
+    }
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Map(const std::string& filepath) {
+    HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping) {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    m_Data = static_cast<const uint8*>(data);
+    m_Size = static_cast<uint64>(size.QuadPart);
+    m_FileHandle = file;
+    m_MappingHandle = mapping;
+    return true;
+}
+
+void MappedFile::PrefetchMapped(uint64 offset, uint64 size) const {
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = const_cast<uint8*>(m_Data + offset);
+    range.NumberOfBytes = static_cast<SIZE_T>(size);
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+void MappedFile::Unmap() {
+    UnmapViewOfFile(m_Data);
+    CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+    CloseHandle(static_cast<HANDLE>(m_FileHandle));
+    m_FileHandle = nullptr;
+    m_MappingHandle = nullptr;
+}
+
+#else
+
+bool MappedFile::Map(const std::string& filepath) {
+    int fd = open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    m_Data = static_cast<const uint8*>(data);
+    m_Size = static_cast<uint64>(info.st_size);
+    return true;
+}
+
+void MappedFile::PrefetchMapped(uint64 offset, uint64 size) const {
+    // madvise() takes page-aligned addresses; the mapping itself starts on a page
+    uint64 pageSize = static_cast<uint64>(sysconf(_SC_PAGESIZE));
+    uint64 start = offset / pageSize * pageSize;
+    madvise(const_cast<uint8*>(m_Data) + start, static_cast<size_t>(offset + size - start), MADV_WILLNEED);
+}
+
+void MappedFile::Unmap() {
+    munmap(const_cast<uint8*>(m_Data), static_cast<size_t>(m_Size));
+}
+
+#endif
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,163 @@
+// ============================================================================
+// src/utils/ShaderWatcher.cpp
+// ============================================================================
+#include "metagfx/utils/ShaderWatcher.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <set>
+#include <sstream>
+
+namespace metagfx {
+namespace utils {
+
+namespace {
+
+std::filesystem::file_time_type GetWriteTime(const std::string& path) {
+    std::error_code ec;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, ec);
+    return ec ? std::filesystem::file_time_type::min() : time;
+}
+
+// Folds the write times of path and of the files it #includes, relative to its
+// directory, into newest; visited ends include cycles
+void CollectWriteTime(const std::filesystem::path& path, std::set<std::filesystem::path>& visited,
+                      std::filesystem::file_time_type& newest) {
+    if (!visited.insert(path.lexically_normal()).second) {
+        return;
+    }
+    newest = std::max(newest, GetWriteTime(path.string()));
+
+    std::ifstream in(path);
+    std::string line;
+    while (std::getline(in, line)) {
+        size_t directive = line.find_first_not_of(" \t");
+        if (directive == std::string::npos || line.compare(directive, 8, "#include") != 0) {
+            continue;
+        }
+        size_t open = line.find('"', directive + 8);
+        size_t close = open == std::string::npos ? std::string::npos : line.find('"', open + 1);
+        if (close != std::string::npos) {
+            CollectWriteTime(path.parent_path() / line.substr(open + 1, close - open - 1), visited, newest);
+        }
+    }
+}
+
+// Newest write time of a shader and its includes, so that editing a shared .glsl
+// recompiles every shader using it
+std::filesystem::file_time_type GetSourceWriteTime(const std::string& path) {
+    std::set<std::filesystem::path> visited;
+    std::filesystem::file_time_type newest = std::filesystem::file_time_type::min();
+    CollectWriteTime(path, visited, newest);
+    return newest;
+}
+
+std::string ReadText(const std::string& path) {
+    std::ifstream in(path);
+    std::ostringstream text;
+    text << in.rdbuf();
+    return text.str();
+}
+
+} // namespace
+
+ShaderWatcher::ShaderWatcher(const std::string& sourceDirectory, const std::string& compiler,
+                             const std::vector<std::string>& names)
+    : m_SourceDirectory(sourceDirectory)
+    , m_Compiler(compiler)
+    , m_LastPoll(std::chrono::steady_clock::now()) {
+    std::error_code ec;
+    std::filesystem::path tempDirectory = std::filesystem::temp_directory_path(ec) / "metagfx_shaders";
+    std::filesystem::create_directories(tempDirectory, ec);
+    m_TempDirectory = tempDirectory.string();
+
+    for (const std::string& name : names) {
+        m_Files.push_back({ name, name, std::string(), GetSourceWriteTime(m_SourceDirectory + "/" + name), false });
+    }
+    METAGFX_INFO << "Watching " << m_Files.size() << " shaders in " << m_SourceDirectory;
+}
+
+ShaderWatcher::~ShaderWatcher() {
+    JobSystem::Wait(m_Jobs);
+}
+
+void ShaderWatcher::AddVariant(const std::string& name, const std::string& source, const std::string& define) {
+    m_Files.push_back({ name, source, define, GetSourceWriteTime(m_SourceDirectory + "/" + source), false });
+}
+
+void ShaderWatcher::Poll() {
+    auto now = std::chrono::steady_clock::now();
+    if (now - m_LastPoll < POLL_INTERVAL) {
+        return;
+    }
+    m_LastPoll = now;
+
+    for (size_t i = 0; i < m_Files.size(); ++i) {
+        WatchedFile& file = m_Files[i];
+        std::filesystem::file_time_type writeTime = GetSourceWriteTime(m_SourceDirectory + "/" + file.source);
+        if (writeTime == file.writeTime) {
+            continue;
+        }
+        {
+            // Picked up again by a later poll once the running compile is done
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (file.compiling) {
+                continue;
+            }
+            file.compiling = true;
+        }
+        file.writeTime = writeTime;
+        METAGFX_INFO << "Shader changed, recompiling: " << file.name;
+        JobSystem::Run([this, i]() { Compile(i); }, &m_Jobs);
+    }
+}
+
+std::vector<ShaderWatcher::Result> ShaderWatcher::TakeResults() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    std::vector<Result> results;
+    results.swap(m_Results);
+    return results;
+}
+
+void ShaderWatcher::Compile(size_t fileIndex) {
+    const std::string& name = m_Files[fileIndex].name;
+    const std::string& define = m_Files[fileIndex].define;
+    std::string source = m_SourceDirectory + "/" + m_Files[fileIndex].source;
+    std::string output = m_TempDirectory + "/" + name + ".spv";
+    std::string logPath = m_TempDirectory + "/" + name + ".log";
+
+    // Same target as the build (cmake/MetagfxShaders.cmake), without the optimizer:
+    // iteration time matters more here. Ray query shaders need SPIR-V 1.4.
+    bool glslc = m_Compiler.find("glslc") != std::string::npos;
+    std::string targetEnv = ReadText(source).find("GL_EXT_ray_query") != std::string::npos ? "vulkan1.2" : "vulkan1.0";
+    std::string command = "\"" + m_Compiler + "\"" + (glslc ? " --target-env=" : " -V --target-env ") + targetEnv +
+                          (define.empty() ? "" : " -D" + define) +
+                          " -o \"" + output + "\" \"" + source + "\" > \"" + logPath + "\" 2>&1";
+#ifdef _WIN32
+    command = "\"" + command + "\"";  // cmd /c strips the outer quotes
+#endif
+
+    Result result;
+    result.name = name;
+    std::error_code ec;
+    std::filesystem::remove(output, ec);
+    int exitCode = std::system(command.c_str());
+    result.log = ReadText(logPath);
+
+    std::ifstream in(output, std::ios::binary | std::ios::ate);
+    if (exitCode == 0 && in.is_open()) {
+        result.spirv.resize(static_cast<size_t>(in.tellg()));
+        in.seekg(0);
+        in.read(reinterpret_cast<char*>(result.spirv.data()), static_cast<std::streamsize>(result.spirv.size()));
+        result.success = in.good() && !result.spirv.empty() && result.spirv.size() % 4 == 0;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Results.push_back(std::move(result));
+    m_Files[fileIndex].compiling = false;
+}
+
+} // namespace utils
+} // namespace metagfx
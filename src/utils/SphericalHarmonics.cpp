@@ -0,0 +1,129 @@
+// ============================================================================
+// src/utils/SphericalHarmonics.cpp
+// ============================================================================
+#include "metagfx/utils/SphericalHarmonics.h"
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/core/Logger.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace metagfx {
+namespace utils {
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+// Normalization constants of the real basis functions, in the order of the polynomial
+constexpr float SH_BASIS[SH_COEFFICIENT_COUNT] = {
+    0.282095f,
+    0.488603f, 0.488603f, 0.488603f,
+    1.092548f, 1.092548f, 0.315392f, 1.092548f, 0.546274f
+};
+
+// Convolution with the clamped cosine lobe, per band (Ramamoorthi and Hanrahan 2001)
+constexpr float COSINE_LOBE[SH_COEFFICIENT_COUNT] = {
+    PI,
+    2.0f * PI / 3.0f, 2.0f * PI / 3.0f, 2.0f * PI / 3.0f,
+    PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f, PI / 4.0f
+};
+
+// The polynomials of IrradianceSH, without their constants
+void EvaluatePolynomials(const glm::vec3& n, float (&values)[SH_COEFFICIENT_COUNT]) {
+    values[0] = 1.0f;
+    values[1] = n.y;
+    values[2] = n.z;
+    values[3] = n.x;
+    values[4] = n.x * n.y;
+    values[5] = n.y * n.z;
+    values[6] = 3.0f * n.z * n.z - 1.0f;
+    values[7] = n.x * n.z;
+    values[8] = n.x * n.x - n.y * n.y;
+}
+
+} // namespace
+
+void RadianceSH::Add(const glm::vec3& direction, const glm::vec3& radiance, float solidAngle) {
+    float values[SH_COEFFICIENT_COUNT];
+    EvaluatePolynomials(direction, values);
+    for (uint32 i = 0; i < SH_COEFFICIENT_COUNT; ++i) {
+        coefficients[i] += radiance * (SH_BASIS[i] * values[i] * solidAngle);
+    }
+}
+
+RadianceSH& RadianceSH::operator+=(const RadianceSH& other) {
+    for (uint32 i = 0; i < SH_COEFFICIENT_COUNT; ++i) {
+        coefficients[i] += other.coefficients[i];
+    }
+    return *this;
+}
+
+IrradianceSH IrradianceSH::FromRadiance(const RadianceSH& radiance) {
+    IrradianceSH irradiance;
+    for (uint32 i = 0; i < SH_COEFFICIENT_COUNT; ++i) {
+        irradiance.coefficients[i] = glm::vec4(radiance.coefficients[i] * (COSINE_LOBE[i] * SH_BASIS[i]), 0.0f);
+    }
+    return irradiance;
+}
+
+glm::vec3 IrradianceSH::Evaluate(const glm::vec3& normal) const {
+    float values[SH_COEFFICIENT_COUNT];
+    EvaluatePolynomials(normal, values);
+    glm::vec3 result(0.0f);
+    for (uint32 i = 0; i < SH_COEFFICIENT_COUNT; ++i) {
+        result += glm::vec3(coefficients[i]) * values[i];
+    }
+    return glm::max(result, glm::vec3(0.0f));
+}
+
+bool IrradianceSH::Load(const std::string& filepath) {
+    MappedFile mapped;  // Asset archives included
+    if (!mapped.Open(filepath)) {
+        return false;
+    }
+    std::istringstream file(std::string(reinterpret_cast<const char*>(mapped.GetData()), mapped.GetSize()));
+
+    IrradianceSH loaded;
+    uint32 count = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#' || line[0] == '\r') {
+            continue;
+        }
+        glm::vec3 coefficient;
+        std::istringstream values(line);
+        if (count == SH_COEFFICIENT_COUNT || !(values >> coefficient.x >> coefficient.y >> coefficient.z)) {
+            METAGFX_WARN << "Malformed irradiance coefficients in " << filepath;
+            return false;
+        }
+        loaded.coefficients[count++] = glm::vec4(coefficient, 0.0f);
+    }
+    if (count != SH_COEFFICIENT_COUNT) {
+        METAGFX_WARN << filepath << " holds " << count << " irradiance coefficients, expected "
+                     << SH_COEFFICIENT_COUNT;
+        return false;
+    }
+
+    *this = loaded;
+    return true;
+}
+
+bool IrradianceSH::Save(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        METAGFX_ERROR << "Failed to open irradiance coefficients for writing: " << filepath;
+        return false;
+    }
+
+    file << "# L2 spherical harmonics irradiance, r g b per coefficient (metagfx IrradianceSH)\n";
+    file << std::setprecision(9);
+    for (const glm::vec4& coefficient : coefficients) {
+        file << coefficient.x << ' ' << coefficient.y << ' ' << coefficient.z << '\n';
+    }
+    return file.good();
+}
+
+} // namespace utils
+} // namespace metagfx
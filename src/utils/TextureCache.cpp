@@ -0,0 +1,190 @@
+// ============================================================================
+// src/utils/TextureCache.cpp
+// ============================================================================
+#include "metagfx/utils/TextureCache.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/rhi/FormatInfo.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+namespace utils {
+
+// Boost-style hash combine
+template<typename T>
+static void HashCombine(size_t& seed, const T& value) {
+    seed ^= std::hash<T>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+size_t TextureCacheKeyHash::operator()(const TextureCacheKey& key) const {
+    size_t seed = 0;
+    HashCombine(seed, key.source);
+    HashCombine(seed, key.contentHash);
+    HashCombine(seed, static_cast<uint32>(key.format));
+    return seed;
+}
+
+TextureCache::TextureCache(uint64 budgetBytes)
+    : m_BudgetBytes(budgetBytes) {
+}
+
+static uint64 Mix64(uint64 value) {
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+uint64 TextureCache::HashBytes(const void* data, uint64 size) {
+    constexpr uint64 PRIME = 0x9e3779b97f4a7c15ull;
+    const uint8* bytes = static_cast<const uint8*>(data);
+
+    // Word at a time; a texture file is megabytes, so byte-wise FNV would be slow
+    uint64 hash = Mix64(size ^ PRIME);
+    uint64 offset = 0;
+    for (; offset + 8 <= size; offset += 8) {
+        uint64 word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash = (hash ^ Mix64(word)) * PRIME;
+        hash = (hash << 31) | (hash >> 33);
+    }
+
+    uint64 tail = 0;
+    for (uint64 i = 0; offset + i < size; ++i) {
+        tail |= static_cast<uint64>(bytes[offset + i]) << (i * 8);
+    }
+    return Mix64(hash ^ Mix64(tail));
+}
+
+uint64 TextureCache::EstimateSize(const rhi::Texture& texture) {
+    uint64 bytes = 0;
+    for (uint32 mip = 0; mip < texture.GetMipLevels(); ++mip) {
+        uint32 width = std::max(1u, texture.GetWidth() >> mip);
+        uint32 height = std::max(1u, texture.GetHeight() >> mip);
+        bytes += rhi::GetFormatImageSize(texture.GetFormat(), width, height);
+    }
+    return bytes;
+}
+
+Ref<rhi::Texture> TextureCache::Acquire(const TextureCacheKey& key,
+                                        const std::function<Ref<rhi::Texture>()>& create) {
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Entries.find(key);
+        if (it != m_Entries.end()) {
+            ++m_Hits;
+            m_LRU.splice(m_LRU.begin(), m_LRU, it->second.lruPosition);
+            return it->second.texture;
+        }
+        ++m_Misses;
+    }
+
+    // Decode and upload outside the lock
+    Ref<rhi::Texture> texture = create();
+    if (!texture) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    // Another thread may have created the same texture meanwhile; keep the first one
+    auto it = m_Entries.find(key);
+    if (it != m_Entries.end()) {
+        m_LRU.splice(m_LRU.begin(), m_LRU, it->second.lruPosition);
+        return it->second.texture;
+    }
+
+    m_LRU.push_front(key);
+    Entry entry;
+    entry.texture = texture;
+    entry.bytes = EstimateSize(*texture);
+    entry.lruPosition = m_LRU.begin();
+    m_Bytes += entry.bytes;
+    m_Entries.emplace(key, std::move(entry));
+
+    TrimLocked();
+    return texture;
+}
+
+Ref<rhi::Texture> TextureCache::Find(const TextureCacheKey& key) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    auto it = m_Entries.find(key);
+    if (it == m_Entries.end()) {
+        return nullptr;
+    }
+
+    ++m_Hits;
+    m_LRU.splice(m_LRU.begin(), m_LRU, it->second.lruPosition);
+    return it->second.texture;
+}
+
+void TextureCache::TrimLocked() {
+    // Walk from the least recently used end; entries held outside the cache stay
+    auto it = m_LRU.end();
+    while (m_Bytes > m_BudgetBytes && it != m_LRU.begin()) {
+        --it;
+        auto entryIt = m_Entries.find(*it);
+        if (entryIt->second.texture.use_count() > 1) {
+            continue;
+        }
+
+        m_Bytes -= entryIt->second.bytes;
+        m_Entries.erase(entryIt);
+        it = m_LRU.erase(it);
+        ++m_Evictions;
+    }
+}
+
+void TextureCache::Trim() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    TrimLocked();
+}
+
+void TextureCache::Clear() {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Entries.clear();
+    m_LRU.clear();
+    m_Bytes = 0;
+}
+
+void TextureCache::SetBudget(uint64 budgetBytes) {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_BudgetBytes = budgetBytes;
+    TrimLocked();
+}
+
+uint64 TextureCache::GetBudget() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_BudgetBytes;
+}
+
+TextureCacheStats TextureCache::GetStats() const {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    TextureCacheStats stats;
+    stats.entryCount = static_cast<uint32>(m_Entries.size());
+    for (const auto& [key, entry] : m_Entries) {
+        if (entry.texture.use_count() > 1) {
+            ++stats.entriesInUse;
+        }
+    }
+    stats.bytes = m_Bytes;
+    stats.budgetBytes = m_BudgetBytes;
+    stats.hits = m_Hits;
+    stats.misses = m_Misses;
+    stats.evictions = m_Evictions;
+    return stats;
+}
+
+void TextureCache::LogStats() const {
+    TextureCacheStats stats = GetStats();
+    METAGFX_INFO << "Texture cache: " << stats.entryCount << " textures (" << stats.entriesInUse << " in use), "
+                 << (stats.bytes / (1024 * 1024)) << " / " << (stats.budgetBytes / (1024 * 1024)) << " MB, "
+                 << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evictions";
+}
+
+} // namespace utils
+} // namespace metagfx
@@ -0,0 +1,106 @@
+// ============================================================================
+// src/utils/TextureManifest.cpp
+// ============================================================================
+#include "metagfx/utils/TextureManifest.h"
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/core/Logger.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+
+std::string TextureManifest::GetPathForModel(const std::string& modelPath) {
+    return modelPath + TEXTURE_MANIFEST_EXTENSION;
+}
+
+std::string TextureManifest::MakeKey(const std::string& source, bool srgb) {
+    return (srgb ? "srgb\t" : "linear\t") + source;
+}
+
+bool TextureManifest::Load(const std::string& filepath) {
+    m_Entries.clear();
+
+    MappedFile mapped;  // Asset archives included
+    if (!mapped.Open(filepath)) {
+        return false;
+    }
+    std::istringstream file(std::string(reinterpret_cast<const char*>(mapped.GetData()), mapped.GetSize()));
+
+    m_BaseDir = std::filesystem::path(filepath).parent_path().string();
+
+    std::string line;
+    uint32 lineNumber = 0;
+    while (std::getline(file, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        size_t first = line.find('\t');
+        size_t second = (first == std::string::npos) ? std::string::npos : line.find('\t', first + 1);
+        if (second == std::string::npos) {
+            METAGFX_WARN << "Malformed texture manifest entry at " << filepath << ":" << lineNumber;
+            continue;
+        }
+
+        std::string colorSpace = line.substr(0, first);
+        if (colorSpace != "srgb" && colorSpace != "linear") {
+            METAGFX_WARN << "Unknown color space '" << colorSpace << "' in texture manifest at "
+                         << filepath << ":" << lineNumber;
+            continue;
+        }
+
+        std::string source = line.substr(first + 1, second - first - 1);
+        std::string cooked = line.substr(second + 1);
+        m_Entries[MakeKey(source, colorSpace == "srgb")] = cooked;
+    }
+
+    return true;
+}
+
+bool TextureManifest::Save(const std::string& filepath) const {
+    std::ofstream file(filepath);
+    if (!file.is_open()) {
+        METAGFX_ERROR << "Failed to open texture manifest for writing: " << filepath;
+        return false;
+    }
+
+    // Sorted so re-cooking an unchanged model produces an identical file
+    std::vector<const std::pair<const std::string, std::string>*> entries;
+    entries.reserve(m_Entries.size());
+    for (const auto& entry : m_Entries) {
+        entries.push_back(&entry);
+    }
+    std::sort(entries.begin(), entries.end(),
+              [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    file << "# metagfx cooked textures (generated by texture_cook)\n";
+    for (const auto* entry : entries) {
+        file << entry->first << '\t' << entry->second << '\n';
+    }
+
+    return static_cast<bool>(file);
+}
+
+void TextureManifest::Add(const std::string& source, bool srgb, const std::string& cookedFile) {
+    m_Entries[MakeKey(source, srgb)] = cookedFile;
+}
+
+std::string TextureManifest::Find(const std::string& source, bool srgb) const {
+    auto it = m_Entries.find(MakeKey(source, srgb));
+    if (it == m_Entries.end()) {
+        return {};
+    }
+    return (std::filesystem::path(m_BaseDir) / it->second).string();
+}
+
+} // namespace utils
+} // namespace metagfx
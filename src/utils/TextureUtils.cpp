@@ -2,13 +2,21 @@
 // src/utils/TextureUtils.cpp
 // ============================================================================
 #include "metagfx/utils/TextureUtils.h"
+#include "metagfx/utils/MappedFile.h"
 #include "metagfx/core/Logger.h"
+#include "metagfx/rhi/FormatInfo.h"
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 
-#include <fstream>
+#include <filesystem>
 #include <cstring>
+#include <mutex>
+
+#ifdef METAGFX_HAS_BASISU
+#include <basisu_transcoder.h>
+#include <zstd.h>
+#endif
 
 namespace metagfx {
 namespace utils {
@@ -87,21 +95,167 @@ constexpr uint32 FOURCC_DXT1 = 0x31545844; // "DXT1"
 constexpr uint32 FOURCC_DXT3 = 0x33545844; // "DXT3"
 constexpr uint32 FOURCC_DXT5 = 0x35545844; // "DXT5"
 constexpr uint32 FOURCC_DX10 = 0x30315844; // "DX10"
+constexpr uint32 FOURCC_ATI1 = 0x31495441; // "ATI1" (BC4)
+constexpr uint32 FOURCC_BC4U = 0x55344342; // "BC4U"
+constexpr uint32 FOURCC_ATI2 = 0x32495441; // "ATI2" (BC5)
+constexpr uint32 FOURCC_BC5U = 0x55354342; // "BC5U"
 
 // DXGI formats (DX10 header)
 constexpr uint32 DXGI_FORMAT_R16G16B16A16_FLOAT = 10;
 constexpr uint32 DXGI_FORMAT_R16G16_FLOAT = 34;
 constexpr uint32 DXGI_FORMAT_R32G32B32A32_FLOAT = 2;
+constexpr uint32 DXGI_FORMAT_R8G8B8A8_UNORM = 28;
+constexpr uint32 DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29;
+constexpr uint32 DXGI_FORMAT_BC1_UNORM = 71;
+constexpr uint32 DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+constexpr uint32 DXGI_FORMAT_BC3_UNORM = 77;
+constexpr uint32 DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+constexpr uint32 DXGI_FORMAT_BC4_UNORM = 80;
+constexpr uint32 DXGI_FORMAT_BC5_UNORM = 83;
+constexpr uint32 DXGI_FORMAT_BC6H_UF16 = 95;
+constexpr uint32 DXGI_FORMAT_BC7_UNORM = 98;
+constexpr uint32 DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+
+// ============================================================================
+// KTX2 File Format Structures
+// ============================================================================
+
+#pragma pack(push, 1)
+
+struct KTX2Header {
+    uint8 identifier[12];
+    uint32 vkFormat;
+    uint32 typeSize;
+    uint32 pixelWidth;
+    uint32 pixelHeight;
+    uint32 pixelDepth;
+    uint32 layerCount;
+    uint32 faceCount;
+    uint32 levelCount;
+    uint32 supercompressionScheme;
+    uint32 dfdByteOffset;
+    uint32 dfdByteLength;
+    uint32 kvdByteOffset;
+    uint32 kvdByteLength;
+    uint64 sgdByteOffset;
+    uint64 sgdByteLength;
+};
+
+struct KTX2LevelIndex {
+    uint64 byteOffset;
+    uint64 byteLength;
+    uint64 uncompressedByteLength;
+};
+
+#pragma pack(pop)
+
+constexpr uint8 KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+
+// KTX2 supercompression schemes
+constexpr uint32 KTX2_SUPERCOMPRESSION_NONE = 0;
+constexpr uint32 KTX2_SUPERCOMPRESSION_BASISLZ = 1;
+constexpr uint32 KTX2_SUPERCOMPRESSION_ZSTD = 2;
+
+// VkFormat values stored in KTX2 headers (0 = Basis Universal payload)
+constexpr uint32 KTX2_VK_FORMAT_UNDEFINED = 0;
+constexpr uint32 KTX2_VK_FORMAT_R8_UNORM = 9;
+constexpr uint32 KTX2_VK_FORMAT_R8G8B8A8_UNORM = 37;
+constexpr uint32 KTX2_VK_FORMAT_R8G8B8A8_SRGB = 43;
+constexpr uint32 KTX2_VK_FORMAT_B8G8R8A8_UNORM = 44;
+constexpr uint32 KTX2_VK_FORMAT_B8G8R8A8_SRGB = 50;
+constexpr uint32 KTX2_VK_FORMAT_R16G16_SFLOAT = 83;
+constexpr uint32 KTX2_VK_FORMAT_R16G16B16A16_SFLOAT = 97;
+constexpr uint32 KTX2_VK_FORMAT_R32_SFLOAT = 100;
+constexpr uint32 KTX2_VK_FORMAT_R32G32_SFLOAT = 103;
+constexpr uint32 KTX2_VK_FORMAT_R32G32B32A32_SFLOAT = 109;
+constexpr uint32 KTX2_VK_FORMAT_BC1_RGB_UNORM = 131;
+constexpr uint32 KTX2_VK_FORMAT_BC1_RGB_SRGB = 132;
+constexpr uint32 KTX2_VK_FORMAT_BC1_RGBA_UNORM = 133;
+constexpr uint32 KTX2_VK_FORMAT_BC1_RGBA_SRGB = 134;
+constexpr uint32 KTX2_VK_FORMAT_BC3_UNORM = 137;
+constexpr uint32 KTX2_VK_FORMAT_BC3_SRGB = 138;
+constexpr uint32 KTX2_VK_FORMAT_BC4_UNORM = 139;
+constexpr uint32 KTX2_VK_FORMAT_BC5_UNORM = 141;
+constexpr uint32 KTX2_VK_FORMAT_BC6H_UFLOAT = 143;
+constexpr uint32 KTX2_VK_FORMAT_BC7_UNORM = 145;
+constexpr uint32 KTX2_VK_FORMAT_BC7_SRGB = 146;
+constexpr uint32 KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM = 147;
+constexpr uint32 KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB = 148;
+constexpr uint32 KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM = 151;
+constexpr uint32 KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB = 152;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_4x4_UNORM = 157;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_4x4_SRGB = 158;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_6x6_UNORM = 165;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_6x6_SRGB = 166;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_8x8_UNORM = 171;
+constexpr uint32 KTX2_VK_FORMAT_ASTC_8x8_SRGB = 172;
 
 // ============================================================================
 // DDS Helper Functions
 // ============================================================================
 
+// Map a DX10-header DXGI format; returns Undefined when unsupported
+static rhi::Format FormatFromDXGI(uint32 dxgiFormat) {
+    switch (dxgiFormat) {
+        case DXGI_FORMAT_R16G16B16A16_FLOAT: return rhi::Format::R16G16B16A16_SFLOAT;
+        case DXGI_FORMAT_R16G16_FLOAT:       return rhi::Format::R16G16_SFLOAT;
+        case DXGI_FORMAT_R32G32B32A32_FLOAT: return rhi::Format::R32G32B32A32_SFLOAT;
+        case DXGI_FORMAT_R8G8B8A8_UNORM:     return rhi::Format::R8G8B8A8_UNORM;
+        case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return rhi::Format::R8G8B8A8_SRGB;
+        case DXGI_FORMAT_BC1_UNORM:          return rhi::Format::BC1_RGBA_UNORM;
+        case DXGI_FORMAT_BC1_UNORM_SRGB:     return rhi::Format::BC1_RGBA_SRGB;
+        case DXGI_FORMAT_BC3_UNORM:          return rhi::Format::BC3_RGBA_UNORM;
+        case DXGI_FORMAT_BC3_UNORM_SRGB:     return rhi::Format::BC3_RGBA_SRGB;
+        case DXGI_FORMAT_BC4_UNORM:          return rhi::Format::BC4_R_UNORM;
+        case DXGI_FORMAT_BC5_UNORM:          return rhi::Format::BC5_RG_UNORM;
+        case DXGI_FORMAT_BC6H_UF16:          return rhi::Format::BC6H_RGB_UFLOAT;
+        case DXGI_FORMAT_BC7_UNORM:          return rhi::Format::BC7_RGBA_UNORM;
+        case DXGI_FORMAT_BC7_UNORM_SRGB:     return rhi::Format::BC7_RGBA_SRGB;
+        default:                             return rhi::Format::Undefined;
+    }
+}
+
+// Map a legacy FourCC code; returns Undefined when unsupported (e.g. DXT3/BC2)
+static rhi::Format FormatFromFourCC(uint32 fourCC) {
+    switch (fourCC) {
+        case FOURCC_DXT1: return rhi::Format::BC1_RGBA_UNORM;
+        case FOURCC_DXT5: return rhi::Format::BC3_RGBA_UNORM;
+        case FOURCC_ATI1:
+        case FOURCC_BC4U: return rhi::Format::BC4_R_UNORM;
+        case FOURCC_ATI2:
+        case FOURCC_BC5U: return rhi::Format::BC5_RG_UNORM;
+        default:          return rhi::Format::Undefined;
+    }
+}
+
+// Compressed formats need the matching DeviceInfo::supports*Textures flag
+static bool IsFormatSampleable(rhi::GraphicsDevice* device, rhi::Format format) {
+    if (!rhi::IsCompressedFormat(format)) {
+        return true;
+    }
+    const rhi::DeviceInfo& info = device->GetDeviceInfo();
+    if (format >= rhi::Format::BC1_RGBA_UNORM && format <= rhi::Format::BC7_RGBA_SRGB) {
+        return info.supportsBCTextures;
+    }
+    if (format >= rhi::Format::ETC2_RGB8_UNORM && format <= rhi::Format::ETC2_RGBA8_SRGB) {
+        return info.supportsETC2Textures;
+    }
+    return info.supportsASTCTextures;
+}
+
 ImageData LoadImage(const std::string& filepath, int desiredChannels) {
     ImageData data;
 
+    // Mapped rather than opened by stb, so that files in asset archives load too
+    MappedFile file;
+    if (!file.Open(filepath)) {
+        METAGFX_ERROR << "Failed to open image: " << filepath;
+        return data;
+    }
+
     int width, height, channels;
-    data.pixels = stbi_load(filepath.c_str(), &width, &height, &channels, desiredChannels);
+    data.pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height,
+                                        &channels, desiredChannels);
 
     if (!data.pixels) {
         METAGFX_ERROR << "Failed to load image: " << filepath << " - " << stbi_failure_reason();
@@ -140,8 +294,15 @@ ImageData LoadImageFromMemory(const uint8* buffer, uint32 bufferSize, int desire
 HDRImageData LoadHDRImage(const std::string& filepath, int desiredChannels) {
     HDRImageData data;
 
+    MappedFile file;
+    if (!file.Open(filepath)) {
+        METAGFX_ERROR << "Failed to open HDR image: " << filepath;
+        return data;
+    }
+
     int width, height, channels;
-    data.pixels = stbi_loadf(filepath.c_str(), &width, &height, &channels, desiredChannels);
+    data.pixels = stbi_loadf_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &width, &height,
+                                         &channels, desiredChannels);
 
     if (!data.pixels) {
         METAGFX_ERROR << "Failed to load HDR image: " << filepath << " - " << stbi_failure_reason();
@@ -157,6 +318,20 @@ HDRImageData LoadHDRImage(const std::string& filepath, int desiredChannels) {
     return data;
 }
 
+void KeepImageChannels(ImageData& data, uint32 channels) {
+    if (!data.pixels || channels >= data.channels) {
+        return;
+    }
+    // Each texel moves to an offset no later than its own, so one forward pass suffices
+    uint64 texelCount = static_cast<uint64>(data.width) * data.height;
+    for (uint64 i = 0; i < texelCount; ++i) {
+        for (uint32 c = 0; c < channels; ++c) {
+            data.pixels[i * channels + c] = data.pixels[i * data.channels + c];
+        }
+    }
+    data.channels = channels;
+}
+
 void FreeImage(ImageData& data) {
     if (data.pixels) {
         stbi_image_free(data.pixels);
@@ -192,7 +367,10 @@ Ref<rhi::Texture> CreateTextureFromImage(
     desc.width = imageData.width;
     desc.height = imageData.height;
     desc.format = format;
-    desc.usage = rhi::TextureUsage::Sampled;
+    desc.usage = rhi::TextureUsage::Sampled | rhi::TextureUsage::TransferDst;
+    // Full mip chain, generated from the uploaded base level by the backend
+    desc.mipLevels = rhi::CalculateMipLevels(imageData.width, imageData.height);
+    desc.generateMipmaps = true;
 
     // Create texture
     auto texture = device->CreateTexture(desc);
@@ -219,7 +397,10 @@ Ref<rhi::Texture> CreateTextureFromHDRImage(
     desc.width = imageData.width;
     desc.height = imageData.height;
     desc.format = format;
-    desc.usage = rhi::TextureUsage::Sampled;
+    desc.usage = rhi::TextureUsage::Sampled | rhi::TextureUsage::TransferDst;
+    // Full mip chain, generated from the uploaded base level by the backend
+    desc.mipLevels = rhi::CalculateMipLevels(imageData.width, imageData.height);
+    desc.generateMipmaps = true;
 
     // Create texture
     auto texture = device->CreateTexture(desc);
@@ -273,130 +454,175 @@ Ref<rhi::Texture> LoadHDRTexture(
     return texture;
 }
 
-Ref<rhi::Texture> LoadDDS2DTexture(
-    rhi::GraphicsDevice* device,
-    const std::string& filepath
-) {
-    // Open file
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        METAGFX_ERROR << "Failed to open DDS file: " << filepath;
-        return nullptr;
+// True when the device reads the raw levels of a file it was given the path of
+// (TextureMipChain::file) itself, so they need not be copied out of the file
+static bool LoadsLevelsFromFile(rhi::GraphicsDevice* device, const std::string& filepath) {
+    return device && !filepath.empty() && device->GetDeviceInfo().supportsFileTextureLoads;
+}
+
+// Parse a mapped DDS 2D texture or cubemap into a mip chain (no GPU work). The levels stay
+// in the mapping, in the mip-major layout the DDS writer stores them in. Without a device
+// the format is not checked against it (CreateTextureFromMipChain() does) and the levels
+// are never loaded from the file by the device.
+static bool ParseDDS(rhi::GraphicsDevice* device, const std::shared_ptr<const MappedFile>& file,
+                     const std::string& filepath, TextureMipChain& out) {
+    const uint8* fileData = file->GetData();
+    uint64 fileSize = file->GetSize();
+    uint64 offset = sizeof(uint32) + sizeof(DDSHeader);
+    if (fileSize < offset) {
+        METAGFX_ERROR << "Invalid DDS file (truncated header): " << filepath;
+        return false;
     }
 
     // Read magic number
     uint32 magic;
-    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    memcpy(&magic, fileData, sizeof(magic));
     if (magic != DDS_MAGIC) {
         METAGFX_ERROR << "Invalid DDS file (bad magic number): " << filepath;
-        return nullptr;
+        return false;
     }
 
     // Read DDS header
     DDSHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    memcpy(&header, fileData + sizeof(magic), sizeof(header));
 
     if (header.size != 124) {
         METAGFX_ERROR << "Invalid DDS header size: " << filepath;
-        return nullptr;
+        return false;
     }
 
-    // Check if this is a 2D texture (not a cubemap)
+    // Cubemaps must have all 6 faces
     bool isCubemap = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
-    if (isCubemap) {
-        METAGFX_ERROR << "DDS file is a cubemap, not a 2D texture: " << filepath;
-        return nullptr;
+    if (isCubemap && (header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
+        METAGFX_ERROR << "DDS cubemap does not contain all 6 faces: " << filepath;
+        return false;
     }
 
     // Determine format
     rhi::Format format = rhi::Format::R8G8B8A8_UNORM;
-    uint32 bytesPerPixel = 4;
-    bool isDXT10 = false;
 
     if (header.ddspf.flags & DDPF_FOURCC) {
         if (header.ddspf.fourCC == FOURCC_DX10) {
             // DX10 extended header
+            if (fileSize < offset + sizeof(DDSHeaderDXT10)) {
+                METAGFX_ERROR << "Invalid DDS file (truncated DX10 header): " << filepath;
+                return false;
+            }
             DDSHeaderDXT10 dx10Header;
-            file.read(reinterpret_cast<char*>(&dx10Header), sizeof(dx10Header));
-            isDXT10 = true;
+            memcpy(&dx10Header, fileData + offset, sizeof(dx10Header));
+            offset += sizeof(dx10Header);
 
             // Map DXGI format to our format
-            if (dx10Header.dxgiFormat == DXGI_FORMAT_R16G16B16A16_FLOAT) {
-                format = rhi::Format::R16G16B16A16_SFLOAT;
-                bytesPerPixel = 8; // 4 channels * 2 bytes (float16)
-            } else if (dx10Header.dxgiFormat == DXGI_FORMAT_R16G16_FLOAT) {
-                format = rhi::Format::R16G16_SFLOAT;
-                bytesPerPixel = 4; // 2 channels * 2 bytes (float16)
-            } else if (dx10Header.dxgiFormat == DXGI_FORMAT_R32G32B32A32_FLOAT) {
-                format = rhi::Format::R32G32B32A32_SFLOAT;
-                bytesPerPixel = 16; // 4 channels * 4 bytes (float32)
-            } else {
+            format = FormatFromDXGI(dx10Header.dxgiFormat);
+            if (format == rhi::Format::Undefined) {
                 METAGFX_ERROR << "Unsupported DXGI format in DDS file: " << dx10Header.dxgiFormat;
-                return nullptr;
+                return false;
             }
         } else {
-            METAGFX_ERROR << "Compressed DDS formats (DXT1/3/5) not yet supported";
-            return nullptr;
+            // Legacy block-compressed FourCC (DXT1/DXT5/ATI1/ATI2)
+            format = FormatFromFourCC(header.ddspf.fourCC);
+            if (format == rhi::Format::Undefined) {
+                METAGFX_ERROR << "Unsupported DDS FourCC: 0x" << std::hex << header.ddspf.fourCC << std::dec;
+                return false;
+            }
         }
     } else if (header.ddspf.flags & DDPF_RGB) {
         // Uncompressed RGB/RGBA
         if (header.ddspf.RGBBitCount == 32) {
             format = rhi::Format::R8G8B8A8_UNORM;
-            bytesPerPixel = 4;
         } else {
             METAGFX_ERROR << "Unsupported RGB bit count: " << header.ddspf.RGBBitCount;
-            return nullptr;
+            return false;
         }
     }
 
-    // Get dimensions and mip levels
-    uint32 width = header.width;
-    uint32 height = header.height;
-    uint32 mipLevels = (header.flags & DDSD_MIPMAPCOUNT) ? header.mipMapCount : 1;
+    if (device && !IsFormatSampleable(device, format)) {
+        METAGFX_ERROR << "Device does not support BC-compressed textures: " << filepath;
+        return false;
+    }
 
-    METAGFX_INFO << "Loading DDS 2D texture: " << filepath;
-    METAGFX_INFO << "  Dimensions: " << width << "x" << height;
-    METAGFX_INFO << "  Mip levels: " << mipLevels;
-    METAGFX_INFO << "  Format: " << static_cast<int>(format);
+    out.format = format;
+    out.width = header.width;
+    out.height = header.height;
+    out.baseWidth = header.width;
+    out.baseHeight = header.height;
+    out.faceCount = isCubemap ? 6 : 1;
+    out.mipLevels = (header.flags & DDSD_MIPMAPCOUNT) ? std::max(1u, header.mipMapCount) : 1;
+    out.generateMipmaps = false;
+    out.firstMip = 0;
 
     // Calculate total data size
     uint64 totalSize = 0;
-    for (uint32 mip = 0; mip < mipLevels; ++mip) {
-        uint32 mipWidth = std::max(1u, width >> mip);
-        uint32 mipHeight = std::max(1u, height >> mip);
-        uint64 mipSize = static_cast<uint64>(mipWidth) * mipHeight * bytesPerPixel;
-        totalSize += mipSize;
+    for (uint32 mip = 0; mip < out.mipLevels; ++mip) {
+        uint32 mipWidth = std::max(1u, out.width >> mip);
+        uint32 mipHeight = std::max(1u, out.height >> mip);
+        totalSize += rhi::GetFormatImageSize(format, mipWidth, mipHeight) * out.faceCount;  // Whole blocks
     }
 
-    // Allocate buffer for all data
-    std::vector<uint8> imageData(totalSize);
-    file.read(reinterpret_cast<char*>(imageData.data()), totalSize);
-
-    if (!file) {
+    if (fileSize < offset + totalSize) {
         METAGFX_ERROR << "Failed to read DDS texture data from: " << filepath;
-        return nullptr;
+        return false;
     }
+    // Packed files are loaded from their archive, at the entry's offset in it
+    bool fromFile = !isCubemap && LoadsLevelsFromFile(device, file->GetSourcePath());
+    std::vector<uint64>& levelOffsets = fromFile ? out.file.levelOffsets : out.mappedLevels;
+    uint64 baseOffset = 0;
+    if (fromFile) {
+        out.file.path = file->GetSourcePath();
+        baseOffset = file->GetSourceOffset();
+    } else {
+        out.mapping = file;
+        file->Prefetch(offset, totalSize);
+    }
+    for (uint32 mip = 0; mip < out.mipLevels; ++mip) {
+        levelOffsets.push_back(baseOffset + offset);
+        offset += rhi::GetFormatImageSize(format, std::max(1u, out.width >> mip),
+                                          std::max(1u, out.height >> mip)) * out.faceCount;
+    }
+    return true;
+}
 
-    file.close();
-
-    // Create texture descriptor
-    rhi::TextureDesc desc;
-    desc.type = rhi::TextureType::Texture2D;
-    desc.width = width;
-    desc.height = height;
-    desc.mipLevels = mipLevels;
-    desc.arrayLayers = 1;
-    desc.format = format;
-    desc.usage = rhi::TextureUsage::Sampled;
+// Map and parse a DDS file, expecting faceCount faces
+static bool LoadDDS(rhi::GraphicsDevice* device, const std::string& filepath, uint32 faceCount,
+                    TextureMipChain& out) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(filepath)) {
+        METAGFX_ERROR << "Failed to open DDS file: " << filepath;
+        return false;
+    }
+    if (!ParseDDS(device, file, filepath, out)) {
+        return false;
+    }
+    if (out.faceCount != faceCount) {
+        METAGFX_ERROR << (faceCount == 6 ? "DDS file is not a cubemap: " : "DDS file is a cubemap, not a 2D texture: ")
+                      << filepath;
+        return false;
+    }
+    return true;
+}
 
-    // Create texture
-    auto texture = device->CreateTexture(desc);
+bool LoadDDSMipChain(const std::string& filepath, bool cubemap, TextureMipChain& out) {
+    return LoadDDS(nullptr, filepath, cubemap ? 6 : 1, out);
+}
 
-    // Upload data
-    texture->UploadData(imageData.data(), totalSize);
+Ref<rhi::Texture> LoadDDS2DTexture(
+    rhi::GraphicsDevice* device,
+    const std::string& filepath
+) {
+    TextureMipChain chain;
+    if (!LoadDDS(device, filepath, 1, chain)) {
+        return nullptr;
+    }
 
-    METAGFX_INFO << "Successfully loaded DDS 2D texture: " << filepath;
+    METAGFX_INFO << "Loading DDS 2D texture: " << filepath;
+    METAGFX_INFO << "  Dimensions: " << chain.width << "x" << chain.height;
+    METAGFX_INFO << "  Mip levels: " << chain.mipLevels;
+    METAGFX_INFO << "  Format: " << static_cast<int>(chain.format);
 
+    auto texture = CreateTextureFromMipChain(device, chain, filepath.c_str());
+    if (texture) {
+        METAGFX_INFO << "Successfully loaded DDS 2D texture: " << filepath;
+    }
     return texture;
 }
 
@@ -404,130 +630,454 @@ Ref<rhi::Texture> LoadDDSCubemap(
     rhi::GraphicsDevice* device,
     const std::string& filepath
 ) {
-    // Open file
-    std::ifstream file(filepath, std::ios::binary);
-    if (!file.is_open()) {
-        METAGFX_ERROR << "Failed to open DDS file: " << filepath;
+    TextureMipChain chain;
+    if (!LoadDDS(device, filepath, 6, chain)) {
         return nullptr;
     }
 
-    // Read magic number
-    uint32 magic;
-    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
-    if (magic != DDS_MAGIC) {
-        METAGFX_ERROR << "Invalid DDS file (bad magic number): " << filepath;
-        return nullptr;
+    METAGFX_INFO << "Loading DDS cubemap: " << filepath;
+    METAGFX_INFO << "  Dimensions: " << chain.width << "x" << chain.height;
+    METAGFX_INFO << "  Mip levels: " << chain.mipLevels;
+    METAGFX_INFO << "  Format: " << static_cast<int>(chain.format);
+
+    auto texture = CreateTextureFromMipChain(device, chain, filepath.c_str());
+    if (texture) {
+        METAGFX_INFO << "Successfully loaded DDS cubemap: " << filepath;
     }
+    return texture;
+}
 
-    // Read DDS header
-    DDSHeader header;
-    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+// ============================================================================
+// KTX2 Loading
+// ============================================================================
 
-    if (header.size != 124) {
-        METAGFX_ERROR << "Invalid DDS header size: " << filepath;
-        return nullptr;
+// Map a KTX2 header VkFormat; returns Undefined when unsupported
+static rhi::Format FormatFromKTX2VkFormat(uint32 vkFormat) {
+    switch (vkFormat) {
+        case KTX2_VK_FORMAT_R8_UNORM:            return rhi::Format::R8_UNORM;
+        case KTX2_VK_FORMAT_R8G8B8A8_UNORM:      return rhi::Format::R8G8B8A8_UNORM;
+        case KTX2_VK_FORMAT_R8G8B8A8_SRGB:       return rhi::Format::R8G8B8A8_SRGB;
+        case KTX2_VK_FORMAT_B8G8R8A8_UNORM:      return rhi::Format::B8G8R8A8_UNORM;
+        case KTX2_VK_FORMAT_B8G8R8A8_SRGB:       return rhi::Format::B8G8R8A8_SRGB;
+        case KTX2_VK_FORMAT_R16G16_SFLOAT:       return rhi::Format::R16G16_SFLOAT;
+        case KTX2_VK_FORMAT_R16G16B16A16_SFLOAT: return rhi::Format::R16G16B16A16_SFLOAT;
+        case KTX2_VK_FORMAT_R32_SFLOAT:          return rhi::Format::R32_SFLOAT;
+        case KTX2_VK_FORMAT_R32G32_SFLOAT:       return rhi::Format::R32G32_SFLOAT;
+        case KTX2_VK_FORMAT_R32G32B32A32_SFLOAT: return rhi::Format::R32G32B32A32_SFLOAT;
+        case KTX2_VK_FORMAT_BC1_RGB_UNORM:       // Same block layout; alpha is always opaque
+        case KTX2_VK_FORMAT_BC1_RGBA_UNORM:      return rhi::Format::BC1_RGBA_UNORM;
+        case KTX2_VK_FORMAT_BC1_RGB_SRGB:
+        case KTX2_VK_FORMAT_BC1_RGBA_SRGB:       return rhi::Format::BC1_RGBA_SRGB;
+        case KTX2_VK_FORMAT_BC3_UNORM:           return rhi::Format::BC3_RGBA_UNORM;
+        case KTX2_VK_FORMAT_BC3_SRGB:            return rhi::Format::BC3_RGBA_SRGB;
+        case KTX2_VK_FORMAT_BC4_UNORM:           return rhi::Format::BC4_R_UNORM;
+        case KTX2_VK_FORMAT_BC5_UNORM:           return rhi::Format::BC5_RG_UNORM;
+        case KTX2_VK_FORMAT_BC6H_UFLOAT:         return rhi::Format::BC6H_RGB_UFLOAT;
+        case KTX2_VK_FORMAT_BC7_UNORM:           return rhi::Format::BC7_RGBA_UNORM;
+        case KTX2_VK_FORMAT_BC7_SRGB:            return rhi::Format::BC7_RGBA_SRGB;
+        case KTX2_VK_FORMAT_ETC2_R8G8B8_UNORM:   return rhi::Format::ETC2_RGB8_UNORM;
+        case KTX2_VK_FORMAT_ETC2_R8G8B8_SRGB:    return rhi::Format::ETC2_RGB8_SRGB;
+        case KTX2_VK_FORMAT_ETC2_R8G8B8A8_UNORM: return rhi::Format::ETC2_RGBA8_UNORM;
+        case KTX2_VK_FORMAT_ETC2_R8G8B8A8_SRGB:  return rhi::Format::ETC2_RGBA8_SRGB;
+        case KTX2_VK_FORMAT_ASTC_4x4_UNORM:      return rhi::Format::ASTC_4x4_UNORM;
+        case KTX2_VK_FORMAT_ASTC_4x4_SRGB:       return rhi::Format::ASTC_4x4_SRGB;
+        case KTX2_VK_FORMAT_ASTC_6x6_UNORM:      return rhi::Format::ASTC_6x6_UNORM;
+        case KTX2_VK_FORMAT_ASTC_6x6_SRGB:       return rhi::Format::ASTC_6x6_SRGB;
+        case KTX2_VK_FORMAT_ASTC_8x8_UNORM:      return rhi::Format::ASTC_8x8_UNORM;
+        case KTX2_VK_FORMAT_ASTC_8x8_SRGB:       return rhi::Format::ASTC_8x8_SRGB;
+        default:                                 return rhi::Format::Undefined;
     }
+}
 
-    // Check if this is a cubemap
-    bool isCubemap = (header.caps2 & DDSCAPS2_CUBEMAP) != 0;
-    if (!isCubemap) {
-        METAGFX_ERROR << "DDS file is not a cubemap: " << filepath;
-        return nullptr;
+#ifdef METAGFX_HAS_BASISU
+// Transcode an ETC1S (BasisLZ) or UASTC payload to the best format the device samples:
+// ASTC 4x4, then BC7 (BC1 when opaque), then ETC2 (ETC1 when opaque), else RGBA8.
+static bool TranscodeBasisKTX2(rhi::GraphicsDevice* device, const uint8* fileData, uint64 fileSize,
+                               TextureMipChain& out) {
+    static std::once_flag initFlag;
+    std::call_once(initFlag, [] { basist::basisu_transcoder_init(); });
+
+    basist::ktx2_transcoder transcoder;
+    if (!transcoder.init(fileData, static_cast<uint32>(fileSize)) || !transcoder.start_transcoding()) {
+        METAGFX_ERROR << "Failed to initialize Basis Universal transcoding";
+        return false;
     }
 
-    // Verify all 6 faces are present
-    if ((header.caps2 & DDSCAPS2_CUBEMAP_ALLFACES) != DDSCAPS2_CUBEMAP_ALLFACES) {
-        METAGFX_ERROR << "DDS cubemap does not contain all 6 faces: " << filepath;
-        return nullptr;
+    if (transcoder.get_layers() > 1) {
+        METAGFX_ERROR << "KTX2 texture arrays are not supported";
+        return false;
     }
 
-    // Determine format
-    rhi::Format format = rhi::Format::R8G8B8A8_UNORM;
-    uint32 bytesPerPixel = 4;
-    bool isDXT10 = false;
+    const rhi::DeviceInfo& info = device->GetDeviceInfo();
+    bool srgb = transcoder.get_dfd_transfer_func() == basist::KTX2_KHR_DF_TRANSFER_SRGB;
+    bool alpha = transcoder.get_has_alpha();
+
+    basist::transcoder_texture_format target;
+    if (info.supportsASTCTextures) {
+        target = basist::transcoder_texture_format::cTFASTC_4x4_RGBA;
+        out.format = srgb ? rhi::Format::ASTC_4x4_SRGB : rhi::Format::ASTC_4x4_UNORM;
+    } else if (info.supportsBCTextures) {
+        target = alpha ? basist::transcoder_texture_format::cTFBC7_RGBA : basist::transcoder_texture_format::cTFBC1_RGB;
+        out.format = alpha ? (srgb ? rhi::Format::BC7_RGBA_SRGB : rhi::Format::BC7_RGBA_UNORM)
+                           : (srgb ? rhi::Format::BC1_RGBA_SRGB : rhi::Format::BC1_RGBA_UNORM);
+    } else if (info.supportsETC2Textures) {
+        // ETC1 blocks are valid ETC2 RGB8 blocks
+        target = alpha ? basist::transcoder_texture_format::cTFETC2_RGBA : basist::transcoder_texture_format::cTFETC1_RGB;
+        out.format = alpha ? (srgb ? rhi::Format::ETC2_RGBA8_SRGB : rhi::Format::ETC2_RGBA8_UNORM)
+                           : (srgb ? rhi::Format::ETC2_RGB8_SRGB : rhi::Format::ETC2_RGB8_UNORM);
+    } else {
+        target = basist::transcoder_texture_format::cTFRGBA32;
+        out.format = srgb ? rhi::Format::R8G8B8A8_SRGB : rhi::Format::R8G8B8A8_UNORM;
+    }
 
-    if (header.ddspf.flags & DDPF_FOURCC) {
-        if (header.ddspf.fourCC == FOURCC_DX10) {
-            // DX10 extended header
-            DDSHeaderDXT10 dx10Header;
-            file.read(reinterpret_cast<char*>(&dx10Header), sizeof(dx10Header));
-            isDXT10 = true;
+    out.width = transcoder.get_width();
+    out.height = transcoder.get_height();
+    out.baseWidth = out.width;
+    out.baseHeight = out.height;
+    out.faceCount = transcoder.get_faces();
+    out.mipLevels = transcoder.get_levels();
+    out.generateMipmaps = false;
+
+    bool uncompressed = basist::basis_transcoder_format_is_uncompressed(target);
+    uint32 bytesPerUnit = basist::basis_get_bytes_per_block_or_pixel(target);
+
+    for (uint32 level = 0; level < out.mipLevels; ++level) {
+        for (uint32 face = 0; face < out.faceCount; ++face) {
+            basist::ktx2_image_level_info levelInfo;
+            if (!transcoder.get_image_level_info(levelInfo, level, 0, face)) {
+                METAGFX_ERROR << "Failed to query KTX2 level " << level;
+                return false;
+            }
 
-            // Map DXGI format to our format
-            if (dx10Header.dxgiFormat == DXGI_FORMAT_R16G16B16A16_FLOAT) {
-                format = rhi::Format::R16G16B16A16_SFLOAT;
-                bytesPerPixel = 8; // 4 channels * 2 bytes (float16)
-            } else if (dx10Header.dxgiFormat == DXGI_FORMAT_R32G32B32A32_FLOAT) {
-                format = rhi::Format::R32G32B32A32_SFLOAT;
-                bytesPerPixel = 16; // 4 channels * 4 bytes (float32)
+            uint32 units = uncompressed ? levelInfo.m_orig_width * levelInfo.m_orig_height
+                                        : levelInfo.m_total_blocks;
+            size_t offset = out.data.size();
+            out.data.resize(offset + static_cast<size_t>(units) * bytesPerUnit);
+
+            if (!transcoder.transcode_image_level(level, 0, face, out.data.data() + offset, units, target)) {
+                METAGFX_ERROR << "Failed to transcode KTX2 level " << level << " face " << face;
+                return false;
+            }
+        }
+    }
+
+    METAGFX_INFO << "  Transcoded " << (transcoder.is_etc1s() ? "ETC1S" : "UASTC")
+                 << " to format " << static_cast<int>(out.format);
+    return true;
+}
+#endif
+
+// Parse a KTX2 file into a mip chain (no GPU work)
+// mapping is the file the data is mapped from; null for data in memory, whose levels are
+// copied out
+static bool ParseKTX2(rhi::GraphicsDevice* device, const uint8* fileData, uint64 fileSize,
+                      const std::shared_ptr<const MappedFile>& mapping, TextureMipChain& out) {
+    if (!IsKTX2Data(fileData, fileSize) || fileSize < sizeof(KTX2Header)) {
+        METAGFX_ERROR << "Invalid KTX2 data (bad identifier)";
+        return false;
+    }
+
+    KTX2Header header;
+    memcpy(&header, fileData, sizeof(header));
+
+    if (header.pixelDepth > 1 || header.layerCount > 1) {
+        METAGFX_ERROR << "KTX2 3D textures and texture arrays are not supported";
+        return false;
+    }
+    if (header.faceCount != 1 && header.faceCount != 6) {
+        METAGFX_ERROR << "Invalid KTX2 face count: " << header.faceCount;
+        return false;
+    }
+
+    if (header.vkFormat == KTX2_VK_FORMAT_UNDEFINED) {
+#ifdef METAGFX_HAS_BASISU
+        return TranscodeBasisKTX2(device, fileData, fileSize, out);
+#else
+        METAGFX_ERROR << "KTX2 file holds a Basis Universal payload; rebuild with METAGFX_USE_BASISU";
+        return false;
+#endif
+    }
+
+    out.format = FormatFromKTX2VkFormat(header.vkFormat);
+    if (out.format == rhi::Format::Undefined) {
+        METAGFX_ERROR << "Unsupported KTX2 vkFormat: " << header.vkFormat;
+        return false;
+    }
+    if (!IsFormatSampleable(device, out.format)) {
+        METAGFX_ERROR << "Device cannot sample KTX2 format " << static_cast<int>(out.format);
+        return false;
+    }
+
+    out.width = header.pixelWidth;
+    out.height = header.pixelHeight;
+    out.baseWidth = out.width;
+    out.baseHeight = out.height;
+    out.faceCount = header.faceCount;
+    uint32 storedLevels = std::max(1u, header.levelCount);
+
+    // levelCount 0 asks the loader to generate mips; compressed formats keep one level
+    out.generateMipmaps = header.levelCount == 0 && !rhi::IsCompressedFormat(out.format);
+    out.mipLevels = out.generateMipmaps ? rhi::CalculateMipLevels(out.width, out.height) : storedLevels;
+
+    uint64 levelIndexEnd = sizeof(KTX2Header) + static_cast<uint64>(storedLevels) * sizeof(KTX2LevelIndex);
+    if (fileSize < levelIndexEnd) {
+        METAGFX_ERROR << "Truncated KTX2 level index";
+        return false;
+    }
+
+    // Raw levels can go from the file to the GPU as they are, or else from the mapping
+    bool raw = header.supercompressionScheme == KTX2_SUPERCOMPRESSION_NONE;
+    bool fromFile = raw && mapping && LoadsLevelsFromFile(device, mapping->GetSourcePath());
+    bool fromMapping = raw && !fromFile && mapping;
+    if (fromFile) {
+        out.file.path = mapping->GetSourcePath();
+    } else if (fromMapping) {
+        out.mapping = mapping;
+    }
+
+    // Level index is ordered from the base level down; payloads are stored smallest first
+    for (uint32 level = 0; level < storedLevels; ++level) {
+        KTX2LevelIndex levelIndex;
+        memcpy(&levelIndex, fileData + sizeof(KTX2Header) + level * sizeof(KTX2LevelIndex), sizeof(levelIndex));
+
+        if (levelIndex.byteOffset + levelIndex.byteLength > fileSize) {
+            METAGFX_ERROR << "Truncated KTX2 level " << level;
+            return false;
+        }
+
+        uint32 mipWidth = std::max(1u, out.width >> level);
+        uint32 mipHeight = std::max(1u, out.height >> level);
+        uint64 expectedSize = rhi::GetFormatImageSize(out.format, mipWidth, mipHeight) * out.faceCount;
+
+        if (fromFile || fromMapping) {
+            if (levelIndex.byteLength < expectedSize) {
+                METAGFX_ERROR << "KTX2 level " << level << " is smaller than expected";
+                return false;
+            }
+            if (fromMapping) {
+                out.mappedLevels.push_back(levelIndex.byteOffset);
+                mapping->Prefetch(levelIndex.byteOffset, expectedSize);
             } else {
-                METAGFX_ERROR << "Unsupported DXGI format in DDS file: " << dx10Header.dxgiFormat;
-                return nullptr;
+                out.file.levelOffsets.push_back(mapping->GetSourceOffset() + levelIndex.byteOffset);
             }
-        } else {
-            METAGFX_ERROR << "Compressed DDS formats (DXT1/3/5) not yet supported for cubemaps";
-            return nullptr;
+            continue;
         }
-    } else if (header.ddspf.flags & DDPF_RGB) {
-        // Uncompressed RGB/RGBA
-        if (header.ddspf.RGBBitCount == 32) {
-            format = rhi::Format::R8G8B8A8_UNORM;
-            bytesPerPixel = 4;
+
+        size_t offset = out.data.size();
+        out.data.resize(offset + expectedSize);
+        const uint8* src = fileData + levelIndex.byteOffset;
+
+        if (header.supercompressionScheme == KTX2_SUPERCOMPRESSION_NONE) {
+            if (levelIndex.byteLength < expectedSize) {
+                METAGFX_ERROR << "KTX2 level " << level << " is smaller than expected";
+                return false;
+            }
+            memcpy(out.data.data() + offset, src, expectedSize);
+        } else if (header.supercompressionScheme == KTX2_SUPERCOMPRESSION_ZSTD) {
+#ifdef METAGFX_HAS_BASISU
+            size_t written = ZSTD_decompress(out.data.data() + offset, expectedSize, src, levelIndex.byteLength);
+            if (ZSTD_isError(written) || written != expectedSize) {
+                METAGFX_ERROR << "Failed to decompress Zstd KTX2 level " << level;
+                return false;
+            }
+#else
+            METAGFX_ERROR << "Zstd-supercompressed KTX2 needs METAGFX_USE_BASISU";
+            return false;
+#endif
         } else {
-            METAGFX_ERROR << "Unsupported RGB bit count: " << header.ddspf.RGBBitCount;
-            return nullptr;
+            METAGFX_ERROR << "Unsupported KTX2 supercompression scheme: " << header.supercompressionScheme;
+            return false;
         }
     }
 
-    // Get dimensions and mip levels
-    uint32 width = header.width;
-    uint32 height = header.height;
-    uint32 mipLevels = (header.flags & DDSD_MIPMAPCOUNT) ? header.mipMapCount : 1;
+    return true;
+}
 
-    METAGFX_INFO << "Loading DDS cubemap: " << filepath;
-    METAGFX_INFO << "  Dimensions: " << width << "x" << height;
-    METAGFX_INFO << "  Mip levels: " << mipLevels;
-    METAGFX_INFO << "  Format: " << static_cast<int>(format);
+bool IsKTX2Data(const uint8* data, uint64 size) {
+    return data && size >= sizeof(KTX2_IDENTIFIER) &&
+           memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER)) == 0;
+}
 
-    // Calculate total data size
-    uint64 totalSize = 0;
-    for (uint32 mip = 0; mip < mipLevels; ++mip) {
-        uint32 mipWidth = std::max(1u, width >> mip);
-        uint32 mipHeight = std::max(1u, height >> mip);
-        uint64 mipSize = static_cast<uint64>(mipWidth) * mipHeight * bytesPerPixel;
-        totalSize += mipSize * 6; // 6 faces
+Ref<rhi::Texture> LoadKTX2TextureFromMemory(
+    rhi::GraphicsDevice* device,
+    const uint8* data,
+    uint64 size,
+    const char* debugName
+) {
+    TextureMipChain image;
+    if (!ParseKTX2(device, data, size, nullptr, image)) {
+        return nullptr;
     }
 
-    // Allocate buffer for all data
-    std::vector<uint8> imageData(totalSize);
-    file.read(reinterpret_cast<char*>(imageData.data()), totalSize);
+    METAGFX_INFO << "Loading KTX2 texture: " << (debugName ? debugName : "<memory>");
+    METAGFX_INFO << "  Dimensions: " << image.width << "x" << image.height
+                 << (image.faceCount == 6 ? " (cubemap)" : "");
+    METAGFX_INFO << "  Mip levels: " << image.mipLevels << (image.generateMipmaps ? " (generated)" : "");
+    METAGFX_INFO << "  Format: " << static_cast<int>(image.format);
+
+    return CreateTextureFromMipChain(device, image, debugName);
+}
 
-    if (!file) {
-        METAGFX_ERROR << "Failed to read DDS cubemap data from: " << filepath;
+Ref<rhi::Texture> LoadKTX2Texture(
+    rhi::GraphicsDevice* device,
+    const std::string& filepath
+) {
+    // Mapped: levels the device loads from the file itself are never read here, and raw
+    // ones are copied from the mapping straight into the upload
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(filepath)) {
+        METAGFX_ERROR << "Failed to read KTX2 file: " << filepath;
         return nullptr;
     }
 
-    file.close();
+    TextureMipChain image;
+    if (!ParseKTX2(device, file->GetData(), file->GetSize(), file, image)) {
+        return nullptr;
+    }
+
+    METAGFX_INFO << "Loading KTX2 texture: " << filepath;
+    METAGFX_INFO << "  Dimensions: " << image.width << "x" << image.height
+                 << (image.faceCount == 6 ? " (cubemap)" : "");
+    METAGFX_INFO << "  Mip levels: " << image.mipLevels << (image.generateMipmaps ? " (generated)" : "")
+                 << (image.file.path.empty() ? "" : " (loaded from file)");
+    METAGFX_INFO << "  Format: " << static_cast<int>(image.format);
+
+    return CreateTextureFromMipChain(device, image, filepath.c_str());
+}
+
+// ============================================================================
+// Mip chains
+// ============================================================================
+
+// Drop the levels larger than maxExtent from the front of the chain
+static void DropLargestMips(TextureMipChain& chain, uint32 maxExtent) {
+    if (maxExtent == 0 || chain.generateMipmaps) {
+        return;
+    }
+
+    uint32 skip = 0;
+    uint64 skippedBytes = 0;
+    while (skip + 1 < chain.mipLevels &&
+           (std::max(1u, chain.width >> skip) > maxExtent || std::max(1u, chain.height >> skip) > maxExtent)) {
+        uint32 mipWidth = std::max(1u, chain.width >> skip);
+        uint32 mipHeight = std::max(1u, chain.height >> skip);
+        skippedBytes += rhi::GetFormatImageSize(chain.format, mipWidth, mipHeight) * chain.faceCount;
+        ++skip;
+    }
+    if (skip == 0) {
+        return;
+    }
+
+    if (!chain.file.path.empty()) {
+        chain.file.levelOffsets.erase(chain.file.levelOffsets.begin(), chain.file.levelOffsets.begin() + skip);
+    } else if (chain.mapping) {
+        chain.mappedLevels.erase(chain.mappedLevels.begin(), chain.mappedLevels.begin() + skip);
+    } else {
+        chain.data.erase(chain.data.begin(), chain.data.begin() + static_cast<ptrdiff_t>(skippedBytes));
+    }
+    chain.width = std::max(1u, chain.width >> skip);
+    chain.height = std::max(1u, chain.height >> skip);
+    chain.mipLevels -= skip;
+    chain.firstMip += skip;
+}
+
+bool LoadTextureMipChain(
+    rhi::GraphicsDevice* device,
+    const std::string& filepath,
+    TextureMipChain& out,
+    uint32 maxExtent
+) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(filepath)) {
+        METAGFX_ERROR << "Failed to read texture file: " << filepath;
+        return false;
+    }
+
+    std::string extension = std::filesystem::path(filepath).extension().string();
+    bool parsed = extension == ".dds" || extension == ".DDS"
+        ? ParseDDS(device, file, filepath, out)
+        : ParseKTX2(device, file->GetData(), file->GetSize(), file, out);
+    if (!parsed) {
+        return false;
+    }
+    if (out.faceCount != 1) {
+        METAGFX_ERROR << "Expected a 2D texture, not a cubemap: " << filepath;
+        return false;
+    }
+
+    DropLargestMips(out, maxExtent);
+    return true;
+}
+
+// Upload the chain's levels from where they lie in the mapped file, each copied once
+// into the backend's staging memory (Texture::UploadLevels())
+static bool UploadMappedLevels(rhi::Texture& texture, const TextureMipChain& chain, const MappedFile& file,
+                               const std::vector<uint64>& levelOffsets) {
+    uint32 uploadedMips = chain.generateMipmaps ? 1 : chain.mipLevels;
+    std::vector<rhi::TextureLevelData> levels(uploadedMips);
+    for (uint32 mip = 0; mip < uploadedMips; ++mip) {
+        uint64 levelSize = rhi::GetFormatImageSize(chain.format, std::max(1u, chain.width >> mip),
+                                                   std::max(1u, chain.height >> mip)) * chain.faceCount;
+        uint64 levelOffset = levelOffsets[mip];
+        if (levelOffset + levelSize > file.GetSize()) {
+            METAGFX_ERROR << "Truncated texture file at mip " << mip;
+            return false;
+        }
+        levels[mip].data = file.GetData() + levelOffset;
+        levels[mip].size = levelSize;
+    }
+    texture.UploadLevels(levels.data(), uploadedMips);
+    return true;
+}
+
+Ref<rhi::Texture> CreateTextureFromMipChain(
+    rhi::GraphicsDevice* device,
+    const TextureMipChain& chain,
+    const char* debugName
+) {
+    if (!IsFormatSampleable(device, chain.format)) {
+        METAGFX_ERROR << "Device does not support the compressed format of "
+                      << (debugName ? debugName : "<memory>");
+        return nullptr;
+    }
 
     // Create texture descriptor
     rhi::TextureDesc desc;
-    desc.type = rhi::TextureType::TextureCube;
-    desc.width = width;
-    desc.height = height;
-    desc.mipLevels = mipLevels;
-    desc.arrayLayers = 6; // Cubemap has 6 faces
-    desc.format = format;
-    desc.usage = rhi::TextureUsage::Sampled;
+    desc.type = chain.faceCount == 6 ? rhi::TextureType::TextureCube : rhi::TextureType::Texture2D;
+    desc.width = chain.width;
+    desc.height = chain.height;
+    desc.mipLevels = chain.mipLevels;
+    desc.arrayLayers = chain.faceCount;
+    desc.format = chain.format;
+    desc.usage = rhi::TextureUsage::Sampled | rhi::TextureUsage::TransferDst;
+    desc.generateMipmaps = chain.generateMipmaps;
+    desc.debugName = debugName;
 
     // Create texture
     auto texture = device->CreateTexture(desc);
+    if (!texture) {
+        METAGFX_ERROR << "Failed to create texture " << (debugName ? debugName : "<memory>");
+        return nullptr;
+    }
 
-    // Upload data
-    texture->UploadData(imageData.data(), totalSize);
-
-    METAGFX_INFO << "Successfully loaded DDS cubemap: " << filepath;
+    if (chain.mapping) {
+        return UploadMappedLevels(*texture, chain, *chain.mapping, chain.mappedLevels) ? texture : nullptr;
+    }
+    if (chain.file.path.empty()) {
+        texture->UploadData(chain.data.data(), chain.data.size());
+        return texture;
+    }
+    if (texture->LoadFromFile(chain.file)) {
+        return texture;
+    }
 
-    return texture;
+    // The backend turned the file down after all; upload the levels from a mapping of it
+    MappedFile file;
+    if (!file.Open(chain.file.path)) {
+        METAGFX_ERROR << "Failed to read texture file: " << chain.file.path;
+        return nullptr;
+    }
+    return UploadMappedLevels(*texture, chain, file, chain.file.levelOffsets) ? texture : nullptr;
 }
 
 } // namespace utils
@@ -0,0 +1,288 @@
+// ============================================================================
+// tools/asset_bench/AssetBench.cpp
+// ============================================================================
+#include "AssetBench.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/SwapChain.h"
+#include "metagfx/rhi/Texture.h"
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/utils/TextureCache.h"
+#include "metagfx/utils/TextureUtils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ElapsedMs(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Drop the file's pages from the OS page cache, so the next read comes from disk. Only
+// Linux offers it without privileges; elsewhere the load reads whatever the OS kept.
+bool EvictFromPageCache(const std::string& path) {
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    // Dirty pages (a file just written) are not dropped until they are on disk
+    fdatasync(fd);
+    bool evicted = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return evicted;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // anonymous namespace
+
+AssetBench::AssetBench(Ref<rhi::GraphicsDevice> device, const AssetBenchSettings& settings)
+    : m_Device(device)
+    , m_Settings(settings) {
+    m_Settings.repeats = std::max(m_Settings.repeats, 1u);
+}
+
+AssetBench::~AssetBench() {
+    if (m_Device) {
+        m_Device->WaitIdle();
+    }
+}
+
+bool AssetBench::IsSelected(const std::string& path) const {
+    return m_Settings.filter.empty() ||
+           std::filesystem::path(path).filename().string().find(m_Settings.filter) != std::string::npos;
+}
+
+double AssetBench::WaitResident(const std::function<bool()>& done) {
+    Clock::time_point start = Clock::now();
+    while (!done()) {
+        // Nothing is presented on the offscreen device; the frame flushes staged uploads
+        rhi::FrameContext frame = m_Device->BeginFrame();
+        frame.commandBuffer->Begin();
+        frame.commandBuffer->End();
+        m_Device->SubmitCommandBuffer(frame.commandBuffer);
+        m_Device->GetSwapChain()->Present();
+    }
+    return ElapsedMs(start);
+}
+
+void AssetBench::Measure(const std::string& path, const char* kind, const std::vector<std::string>& files,
+                         const Load& load) {
+    if (!IsSelected(path)) {
+        return;
+    }
+
+    std::vector<std::string> readFiles = files.empty() ? std::vector<std::string>{ path } : files;
+    uint64 fileBytes = 0;
+    for (const std::string& file : readFiles) {
+        std::error_code error;
+        uint64 size = std::filesystem::file_size(file, error);
+        fileBytes += error ? 0 : size;
+    }
+
+    for (bool cold : { true, false }) {
+        if ((cold && !m_Settings.cold) || (!cold && !m_Settings.warm)) {
+            continue;
+        }
+
+        // Warm loads share a cache that an unmeasured load has filled
+        utils::TextureCache warmCache;
+        StageSamples stages;
+        if (!cold && !load(false, warmCache, stages)) {
+            std::cerr << "Error: failed to load " << path << "\n";
+            return;
+        }
+
+        AssetBenchResult result;
+        result.name = std::filesystem::path(path).filename().string();
+        result.kind = kind;
+        result.mode = cold ? "cold" : "warm";
+        result.fileBytes = fileBytes;
+        result.pageCacheDropped = cold;
+
+        std::vector<StageSamples> runs;
+        for (uint32 repeat = 0; repeat < m_Settings.repeats; ++repeat) {
+            // Every load starts with nothing of the last one in flight
+            m_Device->WaitIdle();
+            stages.clear();
+            bool loaded = false;
+            if (cold) {
+                for (const std::string& file : readFiles) {
+                    result.pageCacheDropped = EvictFromPageCache(file) && result.pageCacheDropped;
+                }
+                utils::TextureCache coldCache;
+                loaded = load(true, coldCache, stages);
+            } else {
+                loaded = load(false, warmCache, stages);
+            }
+            if (!loaded) {
+                std::cerr << "Error: failed to load " << path << "\n";
+                return;
+            }
+            runs.push_back(stages);
+        }
+        m_Device->WaitIdle();
+
+        // Every run reports the same stages in the same order
+        for (size_t stage = 0; stage < runs.front().size(); ++stage) {
+            std::vector<double> values;
+            for (const StageSamples& run : runs) {
+                values.push_back(run[stage].second);
+            }
+            std::sort(values.begin(), values.end());
+            result.stages.push_back({ runs.front()[stage].first, values[values.size() / 2], values.front() });
+        }
+        result.texturesDecoded = m_LastTexturesDecoded;
+        m_Results.push_back(result);
+
+        std::cout << "  " << std::left << std::setw(28) << result.name << std::setw(6) << result.mode << std::right
+                  << std::fixed << std::setprecision(1);
+        for (const StageTiming& stage : result.stages) {
+            std::cout << " " << stage.name << " " << stage.median;
+        }
+        std::cout << " ms\n";
+    }
+}
+
+void AssetBench::BenchModel(const std::string& path, const std::vector<std::string>& files) {
+    Measure(path, "model", files, [&](bool cold, utils::TextureCache& cache, StageSamples& stages) {
+        if (cold) {
+            std::error_code error;
+            std::filesystem::remove(ModelCache::GetPathForModel(path), error);
+        }
+
+        Clock::time_point start = Clock::now();
+        Model model;
+        ModelLoadTimings timings;
+        if (!model.LoadFromFile(m_Device.get(), path, &cache, m_Settings.import, &timings)) {
+            return false;
+        }
+        double residentMs = WaitResident([&]() { return model.IsResident(); });
+        stages = { { "read", timings.readMs }, { "import", timings.importMs }, { "process", timings.processMs },
+                   { "decode", timings.decodeMs }, { "upload", timings.uploadMs }, { "resident", residentMs },
+                   { "total", ElapsedMs(start) } };
+        m_LastTexturesDecoded = timings.texturesDecoded;
+        return true;
+    });
+}
+
+void AssetBench::BenchHDRTexture(const std::string& path) {
+    m_LastTexturesDecoded = 0;
+    Measure(path, "hdr", {}, [&](bool, utils::TextureCache&, StageSamples& stages) {
+        // utils::LoadHDRTexture(), a stage at a time
+        Clock::time_point start = Clock::now();
+        utils::HDRImageData image = utils::LoadHDRImage(path, 4);
+        if (!image.pixels) {
+            return false;
+        }
+        double decodeMs = ElapsedMs(start);
+
+        Clock::time_point uploadStart = Clock::now();
+        Ref<rhi::Texture> texture = utils::CreateTextureFromHDRImage(m_Device.get(), image,
+                                                                     rhi::Format::R16G16B16A16_SFLOAT);
+        utils::FreeHDRImage(image);
+        if (!texture) {
+            return false;
+        }
+        double uploadMs = ElapsedMs(uploadStart);
+
+        double residentMs = WaitResident([&]() { return texture->IsUploadComplete(); });
+        stages = { { "decode", decodeMs }, { "upload", uploadMs }, { "resident", residentMs },
+                   { "total", ElapsedMs(start) } };
+        return true;
+    });
+}
+
+void AssetBench::BenchDDSCubemap(const std::string& path) {
+    m_LastTexturesDecoded = 0;
+    Measure(path, "dds_cubemap", {}, [&](bool, utils::TextureCache&, StageSamples& stages) {
+        Clock::time_point start = Clock::now();
+        Ref<rhi::Texture> texture = utils::LoadDDSCubemap(m_Device.get(), path);
+        if (!texture) {
+            return false;
+        }
+        double loadMs = ElapsedMs(start);
+
+        double residentMs = WaitResident([&]() { return texture->IsUploadComplete(); });
+        stages = { { "load", loadMs }, { "resident", residentMs }, { "total", ElapsedMs(start) } };
+        return true;
+    });
+}
+
+bool AssetBench::WriteResults(const std::string& path, const rhi::DeviceInfo& deviceInfo,
+                              const AssetBenchSettings& settings, const std::vector<AssetBenchResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+
+    const char* apiName = "Unknown";
+    switch (deviceInfo.api) {
+        case rhi::GraphicsAPI::Vulkan: apiName = "Vulkan"; break;
+        case rhi::GraphicsAPI::Direct3D12: apiName = "D3D12"; break;
+        case rhi::GraphicsAPI::Metal: apiName = "Metal"; break;
+        case rhi::GraphicsAPI::WebGPU: apiName = "WebGPU"; break;
+    }
+    std::time_t now = std::time(nullptr);
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    const ModelImportSettings& import = settings.import;
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"timestamp\": \"" << timestamp << "\",\n  \"backend\": \"" << apiName << "\",\n  \"device\": ";
+    WriteJsonString(out, deviceInfo.deviceName);
+    out << ",\n  \"repeats\": " << settings.repeats << ",\n  \"import\": { \"optimizeGeometry\": "
+        << (import.optimizeGeometry ? "true" : "false") << ", \"buildMeshlets\": "
+        << (import.buildMeshlets ? "true" : "false") << ", \"buildLods\": " << (import.buildLods ? "true" : "false")
+        << " },\n  \"unit\": \"ms\",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const AssetBenchResult& result = results[i];
+        out << (i ? ",\n    { " : "\n    { ") << "\"name\": ";
+        WriteJsonString(out, result.name);
+        out << ", \"kind\": \"" << result.kind << "\", \"mode\": \"" << result.mode << "\", \"fileBytes\": "
+            << result.fileBytes << ", \"pageCacheDropped\": " << (result.pageCacheDropped ? "true" : "false")
+            << ", \"texturesDecoded\": " << result.texturesDecoded << ",\n      \"stages\": [";
+        for (size_t s = 0; s < result.stages.size(); ++s) {
+            const StageTiming& stage = result.stages[s];
+            out << (s ? ", " : " ") << "{ \"name\": \"" << stage.name << "\", \"median\": " << stage.median
+                << ", \"best\": " << stage.best << " }";
+        }
+        out << " ] }";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+} // namespace tools
+} // namespace metagfx
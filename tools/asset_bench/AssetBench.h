@@ -0,0 +1,96 @@
+// ============================================================================
+// tools/asset_bench/AssetBench.h - Asset Load-Time Benchmarks
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+#include "metagfx/scene/Model.h"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace metagfx {
+
+namespace utils {
+class TextureCache;
+}
+
+namespace tools {
+
+struct AssetBenchSettings {
+    uint32 repeats = 3;          // Loads of each asset per mode; the median is reported
+    bool cold = true;
+    bool warm = true;
+    std::string filter;          // Non-empty: only the assets whose file name contains it
+    ModelImportSettings import;  // Of every model load
+};
+
+// One stage's time over the repeats, in milliseconds
+struct StageTiming {
+    std::string name;
+    double median = 0.0;
+    double best = 0.0;
+};
+
+// One asset loaded in one mode
+struct AssetBenchResult {
+    std::string name;                  // File name
+    std::string kind;                  // "model", "hdr" or "dds_cubemap"
+    std::string mode;                  // "cold" or "warm"
+    uint64 fileBytes = 0;              // Of every file the load reads
+    bool pageCacheDropped = false;     // Cold: the files' pages were evicted before each load
+    uint32 texturesDecoded = 0;        // Models: of the last repeat, not found in the texture cache
+    std::vector<StageTiming> stages;   // In load order, "total" last
+};
+
+// Load times of the asset paths the renderer starts with, stage by stage:
+// - model: Model::LoadFromFile split by ModelLoadTimings into read, import, process,
+//   decode and upload, then resident: the frames until Model::IsResident()
+// - hdr: utils::LoadHDRTexture's decode (LoadHDRImage) and upload
+//   (CreateTextureFromHDRImage), then resident
+// - dds_cubemap: utils::LoadDDSCubemap as one load stage (reading the levels is deferred to
+//   the upload), then resident
+// Cold loads start without the mesh cache file, with an empty texture cache and, where the
+// OS allows, with the files evicted from its page cache. Warm loads follow an unmeasured one
+// into the same texture cache, so the mesh cache, textures and file pages are all there.
+class AssetBench {
+public:
+    explicit AssetBench(Ref<rhi::GraphicsDevice> device, const AssetBenchSettings& settings = {});
+    ~AssetBench();
+
+    AssetBench(const AssetBench&) = delete;
+    AssetBench& operator=(const AssetBench&) = delete;
+
+    // files: every file the load reads, for the size and eviction (empty: the path alone)
+    void BenchModel(const std::string& path, const std::vector<std::string>& files = {});
+    void BenchHDRTexture(const std::string& path);
+    void BenchDDSCubemap(const std::string& path);
+
+    const std::vector<AssetBenchResult>& GetResults() const { return m_Results; }
+
+    // JSON of the device, settings and results, for tracking them over time
+    static bool WriteResults(const std::string& path, const rhi::DeviceInfo& deviceInfo,
+                             const AssetBenchSettings& settings, const std::vector<AssetBenchResult>& results);
+
+private:
+    using StageSamples = std::vector<std::pair<const char*, double>>;  // One load's stages
+    // One load in the mode; false when it failed
+    using Load = std::function<bool(bool cold, utils::TextureCache& cache, StageSamples& stages)>;
+
+    bool IsSelected(const std::string& path) const;
+    void Measure(const std::string& path, const char* kind, const std::vector<std::string>& files, const Load& load);
+    // Runs frames until done() holds, so staged uploads are flushed; returns the milliseconds taken
+    double WaitResident(const std::function<bool()>& done);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    AssetBenchSettings m_Settings;
+    std::vector<AssetBenchResult> m_Results;
+    uint32 m_LastTexturesDecoded = 0;
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,273 @@
+// ============================================================================
+// tools/asset_bench/SyntheticAssets.cpp
+// ============================================================================
+#include "SyntheticAssets.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+constexpr float HEIGHT_SCALE = 0.05f;    // Of the height field, over a unit square
+constexpr float HEIGHT_FREQUENCY = 40.0f;
+
+// Height field of the grid and of its normal map, over u, v in [0, 1]
+float Height(float u, float v) {
+    return HEIGHT_SCALE * std::sin(u * HEIGHT_FREQUENCY) * std::cos(v * HEIGHT_FREQUENCY);
+}
+
+void HeightNormal(float u, float v, float normal[3]) {
+    float du = HEIGHT_SCALE * HEIGHT_FREQUENCY * std::cos(u * HEIGHT_FREQUENCY) * std::cos(v * HEIGHT_FREQUENCY);
+    float dv = -HEIGHT_SCALE * HEIGHT_FREQUENCY * std::sin(u * HEIGHT_FREQUENCY) * std::sin(v * HEIGHT_FREQUENCY);
+    float length = std::sqrt(du * du + dv * dv + 1.0f);
+    normal[0] = -du / length;
+    normal[1] = 1.0f / length;
+    normal[2] = -dv / length;
+}
+
+// PNG is big-endian
+void PutU32BigEndian(std::vector<uint8>& out, uint32 value) {
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<uint8>(value >> (8 * i)));
+    }
+}
+
+uint32 Crc32(const uint8* data, size_t size, uint32 crc = 0) {
+    static const std::array<uint32, 256> table = []() {
+        std::array<uint32, 256> values{};
+        for (uint32 n = 0; n < 256; ++n) {
+            uint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[n] = c;
+        }
+        return values;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void PutChunk(std::vector<uint8>& out, const char* type, const std::vector<uint8>& data) {
+    PutU32BigEndian(out, static_cast<uint32>(data.size()));
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    PutU32BigEndian(out, Crc32(out.data() + typeOffset, 4 + data.size()));
+}
+
+bool WriteFile(const std::string& filepath, const void* data, size_t size) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open " << filepath << " for writing" << std::endl;
+        return false;
+    }
+    file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+    return static_cast<bool>(file);
+}
+
+// 8-bit RGBA PNG of size x size texels, texel(x, y, rgba) filling each one
+template <typename TexelFunc>
+bool WritePNG(const std::string& filepath, uint32 size, TexelFunc texel) {
+    // Filter type 0 (none) ahead of each row
+    std::vector<uint8> raw;
+    raw.reserve(static_cast<size_t>(size) * (size * 4 + 1));
+    for (uint32 y = 0; y < size; ++y) {
+        raw.push_back(0);
+        for (uint32 x = 0; x < size; ++x) {
+            uint8 rgba[4];
+            texel(x, y, rgba);
+            raw.insert(raw.end(), rgba, rgba + 4);
+        }
+    }
+
+    // zlib stream of stored deflate blocks (at most 65535 bytes each) and the Adler-32
+    std::vector<uint8> zlib = { 0x78, 0x01 };
+    zlib.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+    for (size_t offset = 0; offset < raw.size();) {
+        size_t blockSize = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + blockSize == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8>(blockSize));
+        zlib.push_back(static_cast<uint8>(blockSize >> 8));
+        zlib.push_back(static_cast<uint8>(~blockSize));
+        zlib.push_back(static_cast<uint8>(~blockSize >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    }
+    uint32 a = 1, b = 0;
+    for (uint8 value : raw) {
+        a = (a + value) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    PutU32BigEndian(zlib, (b << 16) | a);
+
+    std::vector<uint8> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8> header;
+    PutU32BigEndian(header, size);
+    PutU32BigEndian(header, size);
+    header.insert(header.end(), { 8, 6, 0, 0, 0 });  // 8-bit RGBA, deflate, adaptive filters, no interlace
+    PutChunk(out, "IHDR", header);
+    PutChunk(out, "IDAT", zlib);
+    PutChunk(out, "IEND", {});
+    return WriteFile(filepath, out.data(), out.size());
+}
+
+bool WriteOBJ(const std::string& filepath, const std::string& materialFile, uint32 gridSize) {
+    std::FILE* file = std::fopen(filepath.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Cannot open " << filepath << " for writing" << std::endl;
+        return false;
+    }
+
+    std::fprintf(file, "# metagfx asset_bench synthetic height field, %u x %u quads\n", gridSize, gridSize);
+    std::fprintf(file, "mtllib %s\no grid\n", materialFile.c_str());
+    uint32 side = gridSize + 1;
+    float step = 1.0f / static_cast<float>(gridSize);
+    for (uint32 z = 0; z < side; ++z) {
+        for (uint32 x = 0; x < side; ++x) {
+            float u = x * step;
+            float v = z * step;
+            std::fprintf(file, "v %.6f %.6f %.6f\n", u - 0.5f, Height(u, v), v - 0.5f);
+        }
+    }
+    for (uint32 z = 0; z < side; ++z) {
+        for (uint32 x = 0; x < side; ++x) {
+            std::fprintf(file, "vt %.6f %.6f\n", x * step, 1.0f - z * step);
+        }
+    }
+    for (uint32 z = 0; z < side; ++z) {
+        for (uint32 x = 0; x < side; ++x) {
+            float normal[3];
+            HeightNormal(x * step, z * step, normal);
+            std::fprintf(file, "vn %.6f %.6f %.6f\n", normal[0], normal[1], normal[2]);
+        }
+    }
+
+    // Two counter-clockwise triangles per quad, seen from above; OBJ indices start at 1
+    std::fprintf(file, "usemtl grid\n");
+    for (uint32 z = 0; z < gridSize; ++z) {
+        for (uint32 x = 0; x < gridSize; ++x) {
+            uint32 i00 = z * side + x + 1;
+            uint32 i10 = i00 + 1;
+            uint32 i01 = i00 + side;
+            uint32 i11 = i01 + 1;
+            std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", i00, i00, i00, i01, i01, i01, i10, i10, i10);
+            std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", i10, i10, i10, i01, i01, i01, i11, i11, i11);
+        }
+    }
+
+    bool ok = std::ferror(file) == 0;
+    ok = std::fclose(file) == 0 && ok;
+    return ok;
+}
+
+// Radiance RGBE texel
+void EncodeRGBE(const float rgb[3], uint8 rgbe[4]) {
+    float maxComponent = std::max({ rgb[0], rgb[1], rgb[2] });
+    if (maxComponent < 1e-32f) {
+        rgbe[0] = rgbe[1] = rgbe[2] = rgbe[3] = 0;
+        return;
+    }
+    int exponent;
+    float scale = std::frexp(maxComponent, &exponent) * 256.0f / maxComponent;
+    for (int i = 0; i < 3; ++i) {
+        rgbe[i] = static_cast<uint8>(rgb[i] * scale);
+    }
+    rgbe[3] = static_cast<uint8>(exponent + 128);
+}
+
+} // anonymous namespace
+
+bool SyntheticAssets::WriteModel(const std::string& directory, uint32 gridSize, uint32 textureSize,
+                                 SyntheticModel& out) {
+    std::filesystem::create_directories(directory);
+    std::string base = "grid_" + std::to_string(gridSize) + "_t" + std::to_string(textureSize);
+    std::filesystem::path dir(directory);
+    std::string objPath = (dir / (base + ".obj")).string();
+    std::string mtlName = base + ".mtl";
+    std::string albedoName = base + "_albedo.png";
+    std::string normalName = base + "_normal.png";
+
+    out.modelPath = objPath;
+    out.files = { objPath, (dir / mtlName).string(), (dir / albedoName).string(), (dir / normalName).string() };
+    bool complete = std::all_of(out.files.begin(), out.files.end(),
+                                [](const std::string& file) { return std::filesystem::exists(file); });
+    if (complete) {
+        return true;
+    }
+
+    std::cout << "Writing synthetic model " << objPath << "..." << std::endl;
+    std::string material = "newmtl grid\nKd 1.0 1.0 1.0\nNs 64\nmap_Kd " + albedoName + "\nnorm " + normalName + "\n";
+    if (!WriteFile(out.files[1], material.data(), material.size())) {
+        return false;
+    }
+
+    float texelStep = 1.0f / static_cast<float>(textureSize);
+    bool albedo = WritePNG(out.files[2], textureSize, [&](uint32 x, uint32 y, uint8 rgba[4]) {
+        bool checker = ((x / 64) + (y / 64)) % 2 == 0;
+        rgba[0] = static_cast<uint8>(x * 255 / textureSize);
+        rgba[1] = static_cast<uint8>(y * 255 / textureSize);
+        rgba[2] = checker ? 200 : 60;
+        rgba[3] = 255;
+    });
+    bool normal = albedo && WritePNG(out.files[3], textureSize, [&](uint32 x, uint32 y, uint8 rgba[4]) {
+        // Tangent space: the height field's slope along u and v in x and y, z up
+        float n[3];
+        HeightNormal((x + 0.5f) * texelStep, (y + 0.5f) * texelStep, n);
+        rgba[0] = static_cast<uint8>(std::lround((n[0] * 0.5f + 0.5f) * 255.0f));
+        rgba[1] = static_cast<uint8>(std::lround((n[2] * 0.5f + 0.5f) * 255.0f));
+        rgba[2] = static_cast<uint8>(std::lround((n[1] * 0.5f + 0.5f) * 255.0f));
+        rgba[3] = 255;
+    });
+    // The OBJ last: it is what tells an earlier run's files complete
+    return normal && WriteOBJ(objPath, mtlName, gridSize);
+}
+
+bool SyntheticAssets::WriteHDR(const std::string& directory, uint32 width, uint32 height, std::string& outPath) {
+    std::filesystem::create_directories(directory);
+    outPath = (std::filesystem::path(directory) /
+               ("sky_" + std::to_string(width) + "x" + std::to_string(height) + ".hdr")).string();
+    if (std::filesystem::exists(outPath)) {
+        return true;
+    }
+
+    std::cout << "Writing synthetic environment " << outPath << "..." << std::endl;
+    std::string header = "#?RADIANCE\nFORMAT=32-bit_rle_rgbe\n\n-Y " + std::to_string(height) + " +X " +
+                         std::to_string(width) + "\n";
+    std::vector<uint8> data(header.begin(), header.end());
+    data.reserve(data.size() + static_cast<size_t>(width) * height * 4);
+
+    // A sky gradient with a sun well above 1, so the exponents vary as in a real capture
+    for (uint32 y = 0; y < height; ++y) {
+        float elevation = 1.0f - 2.0f * (y + 0.5f) / height;
+        for (uint32 x = 0; x < width; ++x) {
+            float azimuth = (x + 0.5f) / width;
+            float sun = std::exp(-((azimuth - 0.3f) * (azimuth - 0.3f) + (elevation - 0.6f) * (elevation - 0.6f)) * 4000.0f);
+            float sky = std::max(elevation, 0.0f);
+            float rgb[3] = { 0.3f + 0.2f * sky + 5000.0f * sun, 0.4f + 0.3f * sky + 4800.0f * sun,
+                             0.6f + 0.6f * sky + 4500.0f * sun };
+            if (elevation < 0.0f) {
+                rgb[0] = rgb[1] = rgb[2] = 0.1f;
+            }
+            uint8 rgbe[4];
+            EncodeRGBE(rgb, rgbe);
+            data.insert(data.end(), rgbe, rgbe + 4);
+        }
+    }
+    return WriteFile(outPath, data.data(), data.size());
+}
+
+} // namespace tools
+} // namespace metagfx
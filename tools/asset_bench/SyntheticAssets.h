@@ -0,0 +1,33 @@
+// ============================================================================
+// tools/asset_bench/SyntheticAssets.h - Generated Large Benchmark Inputs
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+// A generated model and every file its load reads
+struct SyntheticModel {
+    std::string modelPath;
+    std::vector<std::string> files;
+};
+
+// Inputs larger than the bundled assets, written without an asset library and named after
+// their size, so a directory holding them from an earlier run is reused as it is:
+// - a model: an OBJ height field of gridSize x gridSize quads (2 * gridSize^2 triangles)
+//   with an albedo and a normal map of textureSize^2 texels, PNGs in stored (uncompressed)
+//   deflate blocks, so their decode is cheaper than that of a compressed PNG of the size
+// - an equirectangular Radiance HDR of width x height texels, flat (not run-length) scanlines
+class SyntheticAssets {
+public:
+    static bool WriteModel(const std::string& directory, uint32 gridSize, uint32 textureSize,
+                           SyntheticModel& out);
+    static bool WriteHDR(const std::string& directory, uint32 width, uint32 height, std::string& outPath);
+};
+
+} // namespace tools
+} // namespace metagfx
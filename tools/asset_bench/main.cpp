@@ -0,0 +1,240 @@
+// ============================================================================
+// tools/asset_bench/main.cpp - Asset Load-Time Benchmark Entry Point
+// ============================================================================
+#include "AssetBench.h"
+#include "SyntheticAssets.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+namespace {
+
+// WGSL tint translated at build time (WebGPU and tint enabled), so the WebGPU backend
+// creates the shaders without translating the SPIR-V
+#if __has_include("precompiled_wgsl.inl")
+#include "precompiled_wgsl.inl"
+#define METAGFX_HAS_PRECOMPILED_WGSL 1
+#else
+#define METAGFX_HAS_PRECOMPILED_WGSL 0
+#endif
+
+const char* const BUNDLED_MODELS[] = { "AntiqueCamera.glb", "DamagedHelmet.glb", "MetalRoughSpheres.glb" };
+const char* const BUNDLED_CUBEMAPS[] = { "environment.dds", "prefiltered.dds", "irradiance.dds" };
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX Asset Load-Time Benchmark\n";
+    std::cout << "=================================\n\n";
+    std::cout << "Usage: " << programName << " [options]\n\n";
+    std::cout << "Times each stage of loading the bundled models and environment maps, and of\n";
+    std::cout << "larger generated ones, on an offscreen device: file read, import, geometry\n";
+    std::cout << "processing, texture decode, GPU upload and residency. Cold loads start without\n";
+    std::cout << "the mesh cache, texture cache or (on Linux) the OS page cache; warm loads with\n";
+    std::cout << "all three. The results are written as JSON.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --api <name>          vulkan, metal or webgpu (default: the first one built)\n";
+    std::cout << "  --adapter <index>     GPU to run on (default: the best one)\n";
+    std::cout << "  --assets <dir>        Directory holding models/ and envmaps/ (default: assets)\n";
+    std::cout << "  --output <file>       JSON results (default: asset_bench.json)\n";
+    std::cout << "  --repeats <count>     Loads of each asset per mode, the median reported (default: 3)\n";
+    std::cout << "  --mode <mode>         cold, warm or both (default: both)\n";
+    std::cout << "  --filter <text>       Only the assets whose file name contains text\n";
+    std::cout << "  --synthetic-dir <dir> Where the generated inputs are written and reused\n";
+    std::cout << "                        (default: metagfx_asset_bench in the temp directory)\n";
+    std::cout << "  --grid <quads>        Generated model's quads per side (default: 512)\n";
+    std::cout << "  --texture-size <px>   Generated model's texture size (default: 4096)\n";
+    std::cout << "  --hdr-width <px>      Generated environment's width, half as high (default: 4096)\n";
+    std::cout << "  --no-synthetic        Only the bundled assets\n";
+    std::cout << "  --no-process          Import without geometry optimization, meshlets and LODs\n";
+    std::cout << "  --verbose             Keep the loaders' info messages (they cost load time)\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " --api vulkan --output results/assets.json\n";
+    std::cout << "  " << programName << " --mode cold --filter Helmet --repeats 5\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+#if defined(METAGFX_USE_VULKAN)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Vulkan;
+#elif defined(METAGFX_USE_METAL)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Metal;
+#else
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::WebGPU;
+#endif
+    AssetBenchSettings settings;
+    std::string assetsDir = "assets";
+    std::string outputPath = "asset_bench.json";
+    std::string syntheticDir = (std::filesystem::temp_directory_path() / "metagfx_asset_bench").string();
+    uint32 adapterIndex = rhi::DEFAULT_ADAPTER;
+    uint32 gridSize = 512;
+    uint32 textureSize = 4096;
+    uint32 hdrWidth = 4096;
+    bool synthetic = true;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (arg == "--api" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "vulkan") {
+                api = rhi::GraphicsAPI::Vulkan;
+            } else if (name == "metal") {
+                api = rhi::GraphicsAPI::Metal;
+            } else if (name == "webgpu") {
+                api = rhi::GraphicsAPI::WebGPU;
+            } else {
+                std::cerr << "Error: unknown API " << name << "\n";
+                return 1;
+            }
+        } else if (arg == "--adapter" && i + 1 < argc) {
+            adapterIndex = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--assets" && i + 1 < argc) {
+            assetsDir = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            settings.repeats = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--mode" && i + 1 < argc) {
+            std::string mode = argv[++i];
+            if (mode != "cold" && mode != "warm" && mode != "both") {
+                std::cerr << "Error: unknown mode " << mode << "\n";
+                return 1;
+            }
+            settings.cold = mode != "warm";
+            settings.warm = mode != "cold";
+        } else if (arg == "--filter" && i + 1 < argc) {
+            settings.filter = argv[++i];
+        } else if (arg == "--synthetic-dir" && i + 1 < argc) {
+            syntheticDir = argv[++i];
+        } else if (arg == "--grid" && i + 1 < argc) {
+            gridSize = static_cast<uint32>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--texture-size" && i + 1 < argc) {
+            textureSize = static_cast<uint32>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--hdr-width" && i + 1 < argc) {
+            hdrWidth = static_cast<uint32>(std::max(std::atoi(argv[++i]), 2));
+        } else if (arg == "--no-synthetic") {
+            synthetic = false;
+        } else if (arg == "--no-process") {
+            settings.import.optimizeGeometry = false;
+            settings.import.buildMeshlets = false;
+            settings.import.buildLods = false;
+        } else if (arg == "--verbose") {
+            verbose = true;
+        } else {
+            std::cerr << "Error: unknown option " << arg << "\n\n";
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Logger::Init();
+    if (!verbose) {
+        Logger::SetLevel(LogLevel::Warning);
+    }
+    // As in the renderer: texture decodes run on the workers
+    JobSystem::Init();
+
+    // Generated before the device exists, so writing them is not in any measurement
+    SyntheticModel syntheticModel;
+    std::string syntheticHDR;
+    if (synthetic && !(SyntheticAssets::WriteModel(syntheticDir, gridSize, textureSize, syntheticModel) &&
+                       SyntheticAssets::WriteHDR(syntheticDir, hdrWidth, hdrWidth / 2, syntheticHDR))) {
+        std::cerr << "Error: failed to write the synthetic inputs to " << syntheticDir << "\n";
+        JobSystem::Shutdown();
+        return 1;
+    }
+
+    // The device needs a (hidden) window; nothing is presented
+    SDL_WindowFlags windowFlags = SDL_WINDOW_HIDDEN;
+    if (api == rhi::GraphicsAPI::Vulkan) {
+        windowFlags |= SDL_WINDOW_VULKAN;
+    } else if (api == rhi::GraphicsAPI::Metal) {
+        windowFlags |= SDL_WINDOW_METAL;
+    }
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+        std::cerr << "Error: failed to initialize SDL: " << SDL_GetError() << "\n";
+        JobSystem::Shutdown();
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("metagfx_asset_bench", 256, 256, windowFlags);
+
+    Ref<rhi::GraphicsDevice> device;
+    if (window) {
+        rhi::GraphicsDeviceDesc deviceDesc{};
+        deviceDesc.offscreen = true;
+        deviceDesc.adapterIndex = adapterIndex;
+#if METAGFX_HAS_PRECOMPILED_WGSL
+        deviceDesc.precompiledShaders = PRECOMPILED_WGSL;
+        deviceDesc.precompiledShaderCount = static_cast<uint32>(std::size(PRECOMPILED_WGSL));
+#endif
+        device = rhi::CreateGraphicsDevice(api, window, deviceDesc);
+    }
+
+    int status = 1;
+    if (device) {
+        const rhi::DeviceInfo& deviceInfo = device->GetDeviceInfo();
+        std::cout << "Device: " << deviceInfo.deviceName << "\n";
+        std::cout << "Repeats: " << settings.repeats << ", decode threads: " << JobSystem::GetWorkerCount()
+                  << "\n\n";
+
+        std::vector<AssetBenchResult> results;
+        {
+            AssetBench bench(device, settings);
+            std::filesystem::path assets(assetsDir);
+            for (const char* model : BUNDLED_MODELS) {
+                std::filesystem::path path = assets / "models" / model;
+                if (std::filesystem::exists(path)) {
+                    bench.BenchModel(path.string());
+                } else {
+                    std::cerr << "Skipping " << path.string() << ": not found (check --assets)\n";
+                }
+            }
+            if (synthetic) {
+                bench.BenchModel(syntheticModel.modelPath, syntheticModel.files);
+                bench.BenchHDRTexture(syntheticHDR);
+            }
+            for (const char* cubemap : BUNDLED_CUBEMAPS) {
+                std::filesystem::path path = assets / "envmaps" / cubemap;
+                if (std::filesystem::exists(path)) {
+                    bench.BenchDDSCubemap(path.string());
+                } else {
+                    std::cerr << "Skipping " << path.string() << ": not found (check --assets)\n";
+                }
+            }
+            results = bench.GetResults();
+        }
+
+        if (results.empty()) {
+            std::cerr << "Error: no asset loaded" << (settings.filter.empty() ? "" : " (check --filter)") << "\n";
+        } else if (AssetBench::WriteResults(outputPath, deviceInfo, settings, results)) {
+            std::cout << "\nResults written to " << outputPath << "\n";
+            status = 0;
+        }
+    } else {
+        std::cerr << "Error: failed to create the graphics device (is the backend built in?)\n";
+    }
+
+    device.reset();
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+    JobSystem::Shutdown();
+    return status;
+}
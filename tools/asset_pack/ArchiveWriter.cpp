@@ -0,0 +1,202 @@
+// ============================================================================
+// tools/asset_pack/ArchiveWriter.cpp
+// ============================================================================
+#include "ArchiveWriter.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/utils/AssetArchive.h"
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/utils/TextureCache.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+#ifdef METAGFX_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+namespace metagfx {
+namespace tools {
+
+namespace fs = std::filesystem;
+
+bool ArchiveWriter::Add(const std::string& path, const std::string& root) {
+    std::error_code ec;
+    fs::path base = fs::absolute(root, ec).lexically_normal();
+
+    auto addFile = [&](const fs::path& file) {
+        fs::path relative = fs::absolute(file, ec).lexically_normal().lexically_relative(base);
+        if (relative.empty() || *relative.begin() == "..") {
+            std::cerr << "Error: " << file.string() << " is not under " << root << std::endl;
+            return false;
+        }
+        m_Sources.push_back({ file.string(), relative.generic_string() });
+        return true;
+    };
+
+    if (fs::is_directory(path, ec)) {
+        for (const fs::directory_entry& item : fs::recursive_directory_iterator(path, ec)) {
+            if (item.is_regular_file(ec) && !addFile(item.path())) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if (!fs::is_regular_file(path, ec)) {
+        std::cerr << "Error: No such file or directory: " << path << std::endl;
+        return false;
+    }
+    return addFile(path);
+}
+
+bool ArchiveWriter::Write(const std::string& outputPath) {
+#ifndef METAGFX_HAS_ZSTD
+    if (m_Settings.compress) {
+        std::cout << "Built without libzstd: every file is stored uncompressed\n";
+    }
+#endif
+
+    std::sort(m_Sources.begin(), m_Sources.end(),
+              [](const Source& a, const Source& b) { return a.entryPath < b.entryPath; });
+    m_Sources.erase(std::unique(m_Sources.begin(), m_Sources.end(),
+                                [](const Source& a, const Source& b) { return a.entryPath == b.entryPath; }),
+                    m_Sources.end());
+
+    std::ofstream out(outputPath, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        std::cerr << "Error: Cannot create " << outputPath << std::endl;
+        return false;
+    }
+
+    uint64 offset = 0;
+    auto writeBytes = [&](const void* data, uint64 size) {
+        out.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        offset += size;
+    };
+    auto pad = [&]() {
+        static const uint8 zeros[4096] = {};
+        uint64 padding = (m_Settings.alignment - offset % m_Settings.alignment) % m_Settings.alignment;
+        while (padding > 0) {
+            uint64 count = std::min<uint64>(padding, sizeof(zeros));
+            writeBytes(zeros, count);
+            padding -= count;
+        }
+    };
+
+    utils::AssetArchiveHeader header;
+    header.chunkSize = m_Settings.chunkSize;
+    header.alignment = m_Settings.alignment;
+    writeBytes(&header, sizeof(header));
+
+    std::vector<utils::AssetArchiveEntry> entries;
+    std::vector<utils::AssetArchiveChunk> chunks;
+    std::string paths;
+    uint64 sourceBytes = 0;
+    uint64 packedBytes = 0;
+
+    for (const Source& source : m_Sources) {
+        std::error_code ec;
+        if (fs::file_size(source.filepath, ec) == 0 && !ec) {
+            std::cout << "  " << source.entryPath << ": empty, skipped\n";
+            continue;
+        }
+        utils::MappedFile file;
+        if (!file.Open(source.filepath)) {
+            std::cerr << "Error: Cannot read " << source.filepath << std::endl;
+            return false;
+        }
+        const uint8* data = file.GetData();
+        uint64 size = file.GetSize();
+
+        utils::AssetArchiveEntry entry;
+        entry.pathOffset = paths.size();
+        entry.pathLength = static_cast<uint32>(source.entryPath.size());
+        entry.size = size;
+        entry.hash = utils::TextureCache::HashBytes(data, size);
+        paths += source.entryPath;
+
+        // Compressed chunks, or none when the file is stored
+        std::vector<std::vector<uint8>> packed;
+        uint64 packedSize = 0;
+#ifdef METAGFX_HAS_ZSTD
+        if (m_Settings.compress) {
+            uint64 chunkSize = m_Settings.chunkSize;
+            packed.resize(static_cast<size_t>((size + chunkSize - 1) / chunkSize));
+            JobSystem::ParallelFor(static_cast<uint32>(packed.size()), 1, [&](uint32 begin, uint32 end) {
+                for (uint32 c = begin; c < end; ++c) {
+                    const uint8* chunkData = data + c * chunkSize;
+                    size_t chunkBytes = static_cast<size_t>(std::min(chunkSize, size - c * chunkSize));
+                    std::vector<uint8>& chunk = packed[c];
+                    chunk.resize(ZSTD_compressBound(chunkBytes));
+                    size_t written = ZSTD_compress(chunk.data(), chunk.size(), chunkData, chunkBytes,
+                                                   m_Settings.compressionLevel);
+                    // Chunks that do not shrink are stored raw
+                    if (ZSTD_isError(written) || written >= chunkBytes) {
+                        chunk.assign(chunkData, chunkData + chunkBytes);
+                    } else {
+                        chunk.resize(written);
+                    }
+                }
+            });
+            for (const std::vector<uint8>& chunk : packed) {
+                packedSize += chunk.size();
+            }
+            if (static_cast<double>(packedSize) > static_cast<double>(size) * (1.0 - m_Settings.minSavings)) {
+                packed.clear();
+            }
+        }
+#endif
+
+        if (packed.empty()) {
+            pad();
+            entry.compression = static_cast<uint32>(utils::ArchiveCompression::None);
+            entry.offset = offset;
+            writeBytes(data, size);
+            packedSize = size;
+        } else {
+            entry.compression = static_cast<uint32>(utils::ArchiveCompression::Zstd);
+            entry.firstChunk = static_cast<uint32>(chunks.size());
+            entry.chunkCount = static_cast<uint32>(packed.size());
+            for (const std::vector<uint8>& chunk : packed) {
+                pad();
+                utils::AssetArchiveChunk record;
+                record.offset = offset;
+                record.storedSize = static_cast<uint32>(chunk.size());
+                chunks.push_back(record);
+                writeBytes(chunk.data(), chunk.size());
+            }
+        }
+        entries.push_back(entry);
+        sourceBytes += size;
+        packedBytes += packedSize;
+
+        std::cout << "  " << source.entryPath << ": " << size << " bytes"
+                  << (packed.empty() ? ", stored" : ", compressed to " + std::to_string(packedSize)) << "\n";
+    }
+
+    // Table of contents; the reader uses it in place, so it starts aligned
+    pad();
+    header.entryCount = static_cast<uint32>(entries.size());
+    header.chunkCount = static_cast<uint32>(chunks.size());
+    header.tocOffset = offset;
+    writeBytes(entries.data(), entries.size() * sizeof(utils::AssetArchiveEntry));
+    writeBytes(chunks.data(), chunks.size() * sizeof(utils::AssetArchiveChunk));
+    writeBytes(paths.data(), paths.size());
+    header.tocSize = offset - header.tocOffset;
+
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Failed writing " << outputPath << std::endl;
+        return false;
+    }
+
+    std::cout << "\nWrote " << outputPath << ": " << entries.size() << " files, " << sourceBytes
+              << " bytes packed into " << packedBytes << " (archive " << offset << " bytes)\n";
+    return true;
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,43 @@
+// ============================================================================
+// tools/asset_pack/ArchiveWriter.h - Asset Archive Writer
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+struct PackSettings {
+    bool compress = true;             // Zstd, for files it shrinks by minSavings (needs libzstd)
+    int compressionLevel = 19;
+    float minSavings = 0.125f;        // Smaller savings keep a file stored, served from the mapping
+    uint32 chunkSize = 256 * 1024;    // Uncompressed bytes per chunk, decompressed one per job
+    uint32 alignment = 4096;          // Of stored files and chunks, for direct I/O
+};
+
+// Writes the archives utils::AssetArchive reads (format in metagfx/utils/AssetArchive.h).
+// Entries are written in path order, so the same files always pack to the same archive.
+class ArchiveWriter {
+public:
+    explicit ArchiveWriter(const PackSettings& settings) : m_Settings(settings) {}
+
+    // Adds a file, or every file under a directory, named by its path relative to root
+    bool Add(const std::string& path, const std::string& root);
+
+    bool Write(const std::string& outputPath);
+
+private:
+    struct Source {
+        std::string filepath;
+        std::string entryPath;
+    };
+
+    std::vector<Source> m_Sources;
+    PackSettings m_Settings;
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,89 @@
+// ============================================================================
+// tools/asset_pack/main.cpp - Asset Packing Tool Entry Point
+// ============================================================================
+#include "ArchiveWriter.h"
+#include "metagfx/core/JobSystem.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX Asset Packing Tool\n";
+    std::cout << "==========================\n\n";
+    std::cout << "Usage: " << programName << " <output> <path> [<path>...] [options]\n\n";
+    std::cout << "Arguments:\n";
+    std::cout << "  output       Archive to write\n";
+    std::cout << "  path         File or directory to pack (directories recursively)\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --root <dir>              Entries are named relative to it (default: .)\n";
+    std::cout << "  --store                   Store every file uncompressed\n";
+    std::cout << "  --level <n>               Zstd level (default: 19)\n";
+    std::cout << "  --min-savings <fraction>  Store files compression shrinks by less (default: 0.125)\n";
+    std::cout << "  --chunk-size <KiB>        Uncompressed chunk size (default: 256)\n";
+    std::cout << "  --alignment <bytes>       Of stored files and chunks (default: 4096)\n\n";
+    std::cout << "Files are looked up in the archive by their path relative to --root, so with the\n";
+    std::cout << "default root the renderer finds \"assets/...\" in it as it would on disk:\n";
+    std::cout << "  " << programName << " assets.pak assets/models assets/envmaps assets/hdris\n";
+    std::cout << "  metagfx --archive assets.pak\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    PackSettings settings;
+    std::string root = ".";
+    std::string output;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--root" && i + 1 < argc) {
+            root = argv[++i];
+        } else if (arg == "--store") {
+            settings.compress = false;
+        } else if (arg == "--level" && i + 1 < argc) {
+            settings.compressionLevel = std::atoi(argv[++i]);
+        } else if (arg == "--min-savings" && i + 1 < argc) {
+            settings.minSavings = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--chunk-size" && i + 1 < argc) {
+            settings.chunkSize = static_cast<uint32>(std::atoi(argv[++i])) * 1024;
+        } else if (arg == "--alignment" && i + 1 < argc) {
+            settings.alignment = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (output.empty()) {
+            output = arg;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    // The reader reads the table of contents in place, which needs 8-byte alignment
+    if (paths.empty() || settings.chunkSize == 0 || settings.alignment < 8 ||
+        (settings.alignment & (settings.alignment - 1)) != 0) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    JobSystem::Init();
+
+    ArchiveWriter writer(settings);
+    bool success = true;
+    for (const std::string& path : paths) {
+        success = success && writer.Add(path, root);
+    }
+    success = success && writer.Write(output);
+
+    JobSystem::Shutdown();
+    return success ? 0 : 1;
+}
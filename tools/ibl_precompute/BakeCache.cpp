@@ -0,0 +1,69 @@
+// ============================================================================
+// tools/ibl_precompute/BakeCache.cpp
+// ============================================================================
+#include "BakeCache.h"
+#include "metagfx/utils/MappedFile.h"
+#include "metagfx/utils/TextureCache.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace metagfx {
+namespace tools {
+
+BakeCache::BakeCache(const std::filesystem::path& directory)
+    : m_Directory(directory) {
+    std::ifstream file(m_Directory / FILE_NAME);
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::istringstream fields(line);
+        std::string artifact;
+        uint64 key = 0;
+        if (fields >> artifact >> std::hex >> key) {
+            m_Keys[artifact] = key;
+        }
+    }
+}
+
+uint64 BakeCache::HashFile(const std::string& filepath) {
+    utils::MappedFile file;
+    if (!file.Open(filepath)) {
+        return 0;
+    }
+    return utils::TextureCache::HashBytes(file.GetData(), file.GetSize());
+}
+
+uint64 BakeCache::Combine(uint64 key, uint64 value) {
+    uint64 values[2] = { key, value };
+    return utils::TextureCache::HashBytes(values, sizeof(values));
+}
+
+bool BakeCache::IsUpToDate(const std::string& artifact, uint64 key) const {
+    auto it = m_Keys.find(artifact);
+    std::error_code ec;
+    return it != m_Keys.end() && it->second == key && std::filesystem::exists(m_Directory / artifact, ec);
+}
+
+void BakeCache::Set(const std::string& artifact, uint64 key) {
+    m_Keys[artifact] = key;
+}
+
+bool BakeCache::Save() const {
+    std::ofstream file(m_Directory / FILE_NAME);
+    if (!file.is_open()) {
+        std::cerr << "Failed to write " << (m_Directory / FILE_NAME).string() << std::endl;
+        return false;
+    }
+    file << "# ibl_precompute content keys: artifact key\n";
+    for (const auto& [artifact, key] : m_Keys) {
+        file << artifact << ' ' << std::hex << key << std::dec << '\n';
+    }
+    return file.good();
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,47 @@
+// ============================================================================
+// tools/ibl_precompute/BakeCache.h - Content Keys of Baked IBL Artifacts
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace metagfx {
+namespace tools {
+
+// The content key each artifact of one directory was baked from, kept next to them in
+// ibl_cache.txt. A key hashes everything the artifact depends on (source contents and
+// settings), so an artifact whose file exists and whose key matches is skipped.
+class BakeCache {
+public:
+    static constexpr const char* FILE_NAME = "ibl_cache.txt";
+
+    // Bump when a kernel changes its output, so existing bakes are redone
+    static constexpr uint64 VERSION = 1;
+
+    // Reads the directory's ibl_cache.txt, if any
+    explicit BakeCache(const std::filesystem::path& directory);
+
+    // The file's content key, or 0 when it cannot be read
+    static uint64 HashFile(const std::string& filepath);
+
+    // Key of value folded into key
+    static uint64 Combine(uint64 key, uint64 value);
+
+    // True when the artifact exists in the directory and was baked from key
+    bool IsUpToDate(const std::string& artifact, uint64 key) const;
+
+    void Set(const std::string& artifact, uint64 key);
+    bool Save() const;
+
+    const std::filesystem::path& GetDirectory() const { return m_Directory; }
+
+private:
+    std::filesystem::path m_Directory;
+    std::map<std::string, uint64> m_Keys;
+};
+
+} // namespace tools
+} // namespace metagfx
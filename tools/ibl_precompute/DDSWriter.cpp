@@ -242,5 +242,56 @@ bool DDSWriter::WriteTexture2D(const std::string& filepath, const Texture2DData&
     return true;
 }
 
+bool DDSWriter::WriteTexture2DMips(const std::string& filepath, uint32 dxgiFormat,
+                                   uint32 width, uint32 height, uint32 mipLevels,
+                                   const std::vector<uint8>& data, uint64 mip0Size) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Failed to open file for writing: " << filepath << std::endl;
+        return false;
+    }
+
+    // Write magic number
+    file.write(reinterpret_cast<const char*>(&DDS_MAGIC), sizeof(DDS_MAGIC));
+
+    // Prepare DDS header
+    DDSHeader header = {};
+    header.size = 124;
+    header.flags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_LINEARSIZE;
+    header.height = height;
+    header.width = width;
+    header.pitchOrLinearSize = static_cast<uint32>(mip0Size);
+    header.mipMapCount = mipLevels;
+    header.caps = DDSCAPS_TEXTURE;
+    if (mipLevels > 1) {
+        header.flags |= DDSD_MIPMAPCOUNT;
+        header.caps |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+    }
+
+    header.ddspf.size = 32;
+    header.ddspf.flags = DDPF_FOURCC;
+    header.ddspf.fourCC = FOURCC_DX10;
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Write DX10 extended header
+    DDSHeaderDXT10 dx10Header = {};
+    dx10Header.dxgiFormat = dxgiFormat;
+    dx10Header.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+    dx10Header.miscFlag = 0;
+    dx10Header.arraySize = 1;
+    dx10Header.miscFlags2 = 0;
+
+    file.write(reinterpret_cast<const char*>(&dx10Header), sizeof(dx10Header));
+    file.write(reinterpret_cast<const char*>(data.data()), data.size());
+
+    if (!file) {
+        std::cerr << "Failed to write texture data to: " << filepath << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
 } // namespace tools
 } // namespace metagfx
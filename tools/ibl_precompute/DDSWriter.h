@@ -5,6 +5,7 @@
 
 #include "IBLPrecompute.h"
 #include <string>
+#include <vector>
 
 namespace metagfx {
 namespace tools {
@@ -17,6 +18,12 @@ public:
 
     // Write 2D texture to DDS file (R16G16_FLOAT format for BRDF LUT)
     static bool WriteTexture2D(const std::string& filepath, const Texture2DData& texture, bool twoChannel = false);
+
+    // Write a 2D texture with a mip chain already in its final encoding (e.g. BC blocks).
+    // data holds mipLevels tightly packed levels, mip 0 first; dxgiFormat is the DX10 header format.
+    static bool WriteTexture2DMips(const std::string& filepath, uint32 dxgiFormat,
+                                   uint32 width, uint32 height, uint32 mipLevels,
+                                   const std::vector<uint8>& data, uint64 mip0Size);
 };
 
 } // namespace tools
@@ -0,0 +1,127 @@
+// ============================================================================
+// tools/ibl_precompute/HDRReader.cpp
+// ============================================================================
+#include "HDRReader.h"
+
+#include <cmath>
+#include <sstream>
+
+namespace metagfx {
+namespace tools {
+
+bool HDRReader::Open(const std::string& filepath) {
+    m_File.open(filepath, std::ios::binary);
+    if (!m_File.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    if (!std::getline(m_File, line) || (line.rfind("#?RADIANCE", 0) != 0 && line.rfind("#?RGBE", 0) != 0)) {
+        return false;
+    }
+
+    // Header variables up to an empty line; only RGBE pixels are handled
+    while (std::getline(m_File, line) && !line.empty()) {
+        if (line.rfind("FORMAT=", 0) == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+            return false;
+        }
+    }
+
+    if (!std::getline(m_File, line)) {
+        return false;
+    }
+    std::string yAxis, xAxis;
+    std::istringstream resolution(line);
+    if (!(resolution >> yAxis >> m_Height >> xAxis >> m_Width) || yAxis != "-Y" || xAxis != "+X" ||
+        m_Width == 0 || m_Height == 0) {
+        return false;
+    }
+
+    m_Scanline.resize(static_cast<size_t>(m_Width) * 4);
+    m_Flat = m_Width < 8 || m_Width >= 32768;
+    m_RowsRead = 0;
+    return true;
+}
+
+bool HDRReader::ReadRLEScanline() {
+    std::streambuf* buffer = m_File.rdbuf();
+    uint8 start[4];
+    if (buffer->sgetn(reinterpret_cast<char*>(start), 4) != 4) {
+        return false;
+    }
+    if (start[0] != 2 || start[1] != 2 || (start[2] & 0x80)) {
+        // Not RLE: on the first scanline the whole file is flat and this was pixel 0
+        if (m_RowsRead != 0) {
+            return false;
+        }
+        m_Flat = true;
+        std::copy(start, start + 4, m_Scanline.begin());
+        std::streamsize rest = static_cast<std::streamsize>(m_Scanline.size() - 4);
+        return buffer->sgetn(reinterpret_cast<char*>(m_Scanline.data() + 4), rest) == rest;
+    }
+    if (((static_cast<uint32>(start[2]) << 8) | start[3]) != m_Width) {
+        return false;
+    }
+
+    // Each channel in turn, as runs (count > 128) or literal spans
+    for (uint32 channel = 0; channel < 4; ++channel) {
+        uint32 x = 0;
+        while (x < m_Width) {
+            int count = buffer->sbumpc();
+            if (count == std::char_traits<char>::eof()) {
+                return false;
+            }
+            if (count > 128) {
+                count -= 128;
+                int value = buffer->sbumpc();
+                if (value == std::char_traits<char>::eof() || static_cast<uint32>(count) > m_Width - x) {
+                    return false;
+                }
+                for (int i = 0; i < count; ++i, ++x) {
+                    m_Scanline[x * 4 + channel] = static_cast<uint8>(value);
+                }
+            } else {
+                if (count == 0 || static_cast<uint32>(count) > m_Width - x) {
+                    return false;
+                }
+                for (int i = 0; i < count; ++i, ++x) {
+                    int value = buffer->sbumpc();
+                    if (value == std::char_traits<char>::eof()) {
+                        return false;
+                    }
+                    m_Scanline[x * 4 + channel] = static_cast<uint8>(value);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool HDRReader::ReadRow(float* rgba) {
+    if (m_RowsRead == m_Height) {
+        return false;
+    }
+
+    if (m_Flat) {
+        std::streamsize size = static_cast<std::streamsize>(m_Scanline.size());
+        if (m_File.rdbuf()->sgetn(reinterpret_cast<char*>(m_Scanline.data()), size) != size) {
+            return false;
+        }
+    } else if (!ReadRLEScanline()) {
+        return false;
+    }
+    ++m_RowsRead;
+
+    for (uint32 x = 0; x < m_Width; ++x, rgba += 4) {
+        const uint8* rgbe = &m_Scanline[x * 4];
+        float scale = rgbe[3] ? std::ldexp(1.0f, static_cast<int>(rgbe[3]) - (128 + 8)) : 0.0f;
+        rgba[0] = rgbe[0] * scale;
+        rgba[1] = rgbe[1] * scale;
+        rgba[2] = rgbe[2] * scale;
+        rgba[3] = 1.0f;
+    }
+    return true;
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,40 @@
+// ============================================================================
+// tools/ibl_precompute/HDRReader.h - Streaming Radiance HDR Reader
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+// Reads a Radiance .hdr (RGBE) one scanline at a time, so an 8K or 16K equirect never
+// has to be held in memory at full resolution. Decodes as stb_image does: flat or
+// new-style RLE scanlines, top to bottom, -Y +X orientation only.
+class HDRReader {
+public:
+    // False when the file is not an RGBE .hdr this reader handles
+    bool Open(const std::string& filepath);
+
+    uint32 GetWidth() const { return m_Width; }
+    uint32 GetHeight() const { return m_Height; }
+
+    // Decodes the next scanline into GetWidth() RGBA floats (alpha = 1)
+    bool ReadRow(float* rgba);
+
+private:
+    bool ReadRLEScanline();
+
+    std::ifstream m_File;
+    std::vector<uint8> m_Scanline;  // RGBE
+    uint32 m_Width = 0;
+    uint32 m_Height = 0;
+    uint32 m_RowsRead = 0;
+    bool m_Flat = false;            // No RLE, decided on the first scanline
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,220 @@
+// ============================================================================
+// tools/ibl_precompute/IBLCompute.cpp
+// ============================================================================
+#include "IBLCompute.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/SwapChain.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// Compiled by metagfx_add_shaders(); without a GLSL compiler only the CPU path is built
+#if __has_include("ibl_precompute.comp.spv.inl")
+#define METAGFX_HAS_IBL_SHADER 1
+#else
+#define METAGFX_HAS_IBL_SHADER 0
+#endif
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+// Must match local_size_x/y and the passes of ibl_precompute.comp
+constexpr uint32 IBL_GROUP_SIZE = 8;
+constexpr uint32 PASS_EQUIRECT = 0;
+constexpr uint32 PASS_PREFILTER = 1;
+constexpr uint32 PASS_BRDF_LUT = 2;
+
+} // namespace
+
+IBLCompute::IBLCompute(Ref<rhi::GraphicsDevice> device)
+    : m_Device(device) {
+#if METAGFX_HAS_IBL_SHADER
+    using namespace rhi;
+
+    ShaderDesc shaderDesc{};
+    shaderDesc.stage = ShaderStage::Compute;
+    shaderDesc.code = {
+        #include "ibl_precompute.comp.spv.inl"
+    };
+    shaderDesc.entryPoint = "main";
+    shaderDesc.debugName = "IBLPrecompute";
+    Ref<Shader> shader = device->CreateShader(shaderDesc);
+    if (!shader) {
+        std::cerr << "Failed to create the IBL compute shader" << std::endl;
+        return;
+    }
+
+    // The buffers come with each Run(); the pipeline only needs the layout
+    DescriptorSetDesc layoutDesc;
+    layoutDesc.bindings = {
+        { 0, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, nullptr, nullptr, nullptr }
+    };
+    layoutDesc.debugName = "IBLPrecomputeLayout";
+    Ref<DescriptorSet> layout = device->CreateDescriptorSet(layoutDesc);
+
+    ComputePipelineDesc pipelineDesc{};
+    pipelineDesc.computeShader = shader;
+    pipelineDesc.pushConstantSize = sizeof(Constants);
+    pipelineDesc.debugName = "IBLPrecomputePipeline";
+    pipelineDesc.descriptorSetLayout = layout;
+    m_Pipeline = device->CreateComputePipeline(pipelineDesc);
+#else
+    std::cerr << "GPU precomputation unavailable: ibl_precompute.comp has not been compiled" << std::endl;
+#endif
+}
+
+std::vector<float> IBLCompute::Run(const float* source, uint64 sourceTexels, uint64 outputTexels,
+                                   const std::vector<Dispatch>& dispatches) {
+    using namespace rhi;
+    constexpr uint64 TEXEL_SIZE = 4 * sizeof(float);
+
+    // Passes without a source still bind one texel
+    BufferDesc sourceDesc{};
+    sourceDesc.size = std::max<uint64>(sourceTexels, 1) * TEXEL_SIZE;
+    sourceDesc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    sourceDesc.memoryUsage = MemoryUsage::GPUOnly;
+    sourceDesc.debugName = "IBLSource";
+    Ref<Buffer> sourceBuffer = m_Device->CreateBuffer(sourceDesc);
+
+    BufferDesc outputDesc{};
+    outputDesc.size = outputTexels * TEXEL_SIZE;
+    outputDesc.usage = BufferUsage::Storage | BufferUsage::TransferSrc;
+    outputDesc.memoryUsage = MemoryUsage::GPUOnly;
+    outputDesc.debugName = "IBLOutput";
+    Ref<Buffer> outputBuffer = m_Device->CreateBuffer(outputDesc);
+
+    BufferDesc readbackDesc{};
+    readbackDesc.size = outputDesc.size;
+    readbackDesc.usage = BufferUsage::TransferDst;
+    readbackDesc.memoryUsage = MemoryUsage::GPUToCPU;
+    readbackDesc.debugName = "IBLReadback";
+    Ref<Buffer> readbackBuffer = m_Device->CreateBuffer(readbackDesc);
+
+    if (!sourceBuffer || !outputBuffer || !readbackBuffer) {
+        std::cerr << "Failed to create the IBL buffers (" << outputDesc.size << " bytes out)" << std::endl;
+        return {};
+    }
+    if (source) {
+        sourceBuffer->CopyData(source, sourceTexels * TEXEL_SIZE);
+    }
+
+    DescriptorSetDesc setDesc;
+    setDesc.bindings = {
+        { 0, DescriptorType::StorageBuffer, ShaderStage::Compute, sourceBuffer, nullptr, nullptr },
+        { 1, DescriptorType::StorageBuffer, ShaderStage::Compute, outputBuffer, nullptr, nullptr }
+    };
+    setDesc.debugName = "IBLPrecomputeSet";
+    Ref<DescriptorSet> descriptorSet = m_Device->CreateDescriptorSet(setDesc);
+
+    // One frame: the dispatches write disjoint texels and only read the source, so they
+    // need no barriers between them
+    FrameContext frame = m_Device->BeginFrame();
+    Ref<CommandBuffer> cmd = frame.commandBuffer;
+    cmd->Begin();
+    cmd->BindPipeline(m_Pipeline);
+    cmd->BindDescriptorSet(m_Pipeline, descriptorSet, frame.frameIndex);
+    for (const Dispatch& dispatch : dispatches) {
+        cmd->PushConstants(m_Pipeline, ShaderStage::Compute, 0, sizeof(Constants), &dispatch.constants);
+        cmd->Dispatch((dispatch.constants.width + IBL_GROUP_SIZE - 1) / IBL_GROUP_SIZE,
+                      (dispatch.constants.height + IBL_GROUP_SIZE - 1) / IBL_GROUP_SIZE,
+                      dispatch.layers);
+    }
+
+    BufferBarrier barrier{ outputBuffer, ResourceState::StorageWrite, ResourceState::TransferRead };
+    cmd->ResourceBarrier(nullptr, 0, &barrier, 1);
+    cmd->CopyBuffer(outputBuffer, readbackBuffer, outputDesc.size);
+    cmd->End();
+
+    m_Device->SubmitCommandBuffer(cmd);
+    m_Device->GetSwapChain()->Present();
+    m_Device->WaitIdle();
+
+    std::vector<float> result(outputTexels * 4);
+    const void* mapped = readbackBuffer->Map();
+    if (!mapped) {
+        std::cerr << "Failed to map the IBL readback buffer" << std::endl;
+        return {};
+    }
+    std::memcpy(result.data(), mapped, outputDesc.size);
+    readbackBuffer->Unmap();
+    return result;
+}
+
+CubemapData IBLCompute::ConvertEquirectToCubemap(const IBLPrecompute& source, uint32 size) {
+    std::cout << "Converting equirectangular to cubemap on the GPU (" << size << "x" << size << ")..." << std::endl;
+
+    Dispatch dispatch;
+    dispatch.constants.pass = PASS_EQUIRECT;
+    dispatch.constants.width = size;
+    dispatch.constants.height = size;
+    dispatch.constants.sourceWidth = source.GetEquirectWidth();
+    dispatch.constants.sourceHeight = source.GetEquirectHeight();
+    dispatch.layers = 6;
+
+    CubemapData cubemap;
+    cubemap.width = size;
+    cubemap.height = size;
+    cubemap.mipLevels = 1;
+    uint64 sourceTexels = static_cast<uint64>(source.GetEquirectWidth()) * source.GetEquirectHeight();
+    cubemap.data = Run(source.GetEquirectData().data(), sourceTexels, 6ull * size * size, { dispatch });
+
+    std::cout << "  Conversion complete" << std::endl;
+    return cubemap;
+}
+
+CubemapData IBLCompute::GeneratePrefilteredMap(const CubemapData& envMap, uint32 size, uint32 mipLevels, uint32 sampleCount) {
+    std::cout << "Generating prefiltered environment map on the GPU (" << size << "x" << size << ", " << mipLevels << " mips, " << sampleCount << " samples)..." << std::endl;
+
+    CubemapData prefiltered;
+    prefiltered.width = size;
+    prefiltered.height = size;
+    prefiltered.mipLevels = mipLevels;
+
+    std::vector<Dispatch> dispatches(mipLevels);
+    uint64 outputTexels = 0;
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        Dispatch& dispatch = dispatches[mip];
+        dispatch.constants.pass = PASS_PREFILTER;
+        dispatch.constants.width = prefiltered.GetMipWidth(mip);
+        dispatch.constants.height = prefiltered.GetMipHeight(mip);
+        dispatch.constants.sourceWidth = envMap.width;
+        dispatch.constants.sourceHeight = envMap.height;
+        dispatch.constants.outputOffset = static_cast<uint32>(prefiltered.GetOffset(0, mip) / 4);
+        dispatch.constants.roughness = static_cast<float>(mip) / static_cast<float>(mipLevels - 1);
+        dispatch.constants.sampleCount = dispatch.constants.roughness > 0.0f ? sampleCount : 1;  // A mirror needs one
+        dispatch.constants.sourceMipLevels = envMap.mipLevels;
+        dispatch.layers = 6;
+        outputTexels += 6ull * dispatch.constants.width * dispatch.constants.height;
+    }
+    prefiltered.data = Run(envMap.data.data(), envMap.data.size() / 4, outputTexels, dispatches);
+
+    std::cout << "  Prefiltered map complete" << std::endl;
+    return prefiltered;
+}
+
+Texture2DData IBLCompute::GenerateBRDFLUT(uint32 size, uint32 sampleCount) {
+    std::cout << "Generating BRDF LUT on the GPU (" << size << "x" << size << ", " << sampleCount << " samples)..." << std::endl;
+
+    Dispatch dispatch;
+    dispatch.constants.pass = PASS_BRDF_LUT;
+    dispatch.constants.width = size;
+    dispatch.constants.height = size;
+    dispatch.constants.sampleCount = sampleCount;
+
+    Texture2DData lut;
+    lut.width = size;
+    lut.height = size;
+    lut.data = Run(nullptr, 0, static_cast<uint64>(size) * size, { dispatch });
+
+    std::cout << "  BRDF LUT complete" << std::endl;
+    return lut;
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,63 @@
+// ============================================================================
+// tools/ibl_precompute/IBLCompute.h - IBL Texture Generation on the GPU
+// ============================================================================
+#pragma once
+
+#include "IBLPrecompute.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+namespace metagfx {
+namespace tools {
+
+// The IBLPrecompute kernels as compute shaders (ibl_precompute.comp) through the RHI,
+// for --gpu. Each call uploads its source as a storage buffer, dispatches one pass per
+// output (mip), copies the result into a readback buffer and waits for it, so the data
+// comes back in the CPU path's layout for DDSWriter. Results match the CPU path up to
+// float rounding. The irradiance projection is a single pass over the environment and
+// stays on the CPU (IBLPrecompute::ProjectIrradianceSH()).
+class IBLCompute {
+public:
+    // device: any backend; nothing is presented. The pipeline is created here.
+    explicit IBLCompute(Ref<rhi::GraphicsDevice> device);
+    ~IBLCompute() = default;
+
+    IBLCompute(const IBLCompute&) = delete;
+    IBLCompute& operator=(const IBLCompute&) = delete;
+
+    // False when the shader was not compiled into the tool or the pipeline failed
+    bool IsValid() const { return m_Pipeline != nullptr; }
+
+    CubemapData ConvertEquirectToCubemap(const IBLPrecompute& source, uint32 size);
+    CubemapData GeneratePrefilteredMap(const CubemapData& envMap, uint32 size, uint32 mipLevels, uint32 sampleCount = 64);
+    Texture2DData GenerateBRDFLUT(uint32 size, uint32 sampleCount = 1024);
+
+private:
+    // Push constants of ibl_precompute.comp
+    struct Constants {
+        uint32 pass = 0;
+        uint32 width = 0;
+        uint32 height = 0;
+        uint32 sourceWidth = 0;
+        uint32 sourceHeight = 0;
+        uint32 sampleCount = 0;
+        uint32 outputOffset = 0;  // In texels
+        float roughness = 0.0f;
+        uint32 sourceMipLevels = 1;
+    };
+
+    struct Dispatch {
+        Constants constants;
+        uint32 layers = 1;  // Cube faces
+    };
+
+    // Runs the dispatches over source (RGBA float texels; null for none) into
+    // outputTexels RGBA float texels. Empty on failure.
+    std::vector<float> Run(const float* source, uint64 sourceTexels, uint64 outputTexels,
+                           const std::vector<Dispatch>& dispatches);
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    Ref<rhi::Pipeline> m_Pipeline;
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -2,6 +2,8 @@
 // tools/ibl_precompute/IBLPrecompute.cpp
 // ============================================================================
 #include "IBLPrecompute.h"
+#include "HDRReader.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Logger.h"
 #include "metagfx/utils/TextureUtils.h"
 
@@ -9,9 +11,82 @@
 #include <cmath>
 #include <iostream>
 
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define METAGFX_IBL_SSE2 1
+#define METAGFX_IBL_SIMD 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define METAGFX_IBL_NEON 1
+#define METAGFX_IBL_SIMD 1
+#endif
+
 namespace metagfx {
 namespace tools {
 
+namespace {
+
+// 4-wide float math for the prefilter kernel. Comparisons return all-ones lanes.
+#if defined(METAGFX_IBL_SSE2)
+using Float4 = __m128;
+inline Float4 Load4(const float* p) { return _mm_loadu_ps(p); }
+inline void Store4(float* p, Float4 a) { _mm_store_ps(p, a); }
+inline Float4 Splat4(float f) { return _mm_set1_ps(f); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+inline Float4 Sqrt4(Float4 a) { return _mm_sqrt_ps(a); }
+inline Float4 Min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+inline Float4 Abs4(Float4 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+inline Float4 Neg4(Float4 a) { return _mm_xor_ps(_mm_set1_ps(-0.0f), a); }
+inline Float4 Greater4(Float4 a, Float4 b) { return _mm_cmpgt_ps(a, b); }
+inline Float4 GreaterEqual4(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+inline Float4 And4(Float4 a, Float4 b) { return _mm_and_ps(a, b); }
+inline Float4 AndNot4(Float4 a, Float4 b) { return _mm_andnot_ps(b, a); }  // a & ~b
+inline Float4 Select4(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+#elif defined(METAGFX_IBL_NEON)
+using Float4 = float32x4_t;
+inline Float4 Load4(const float* p) { return vld1q_f32(p); }
+inline void Store4(float* p, Float4 a) { vst1q_f32(p, a); }
+inline Float4 Splat4(float f) { return vdupq_n_f32(f); }
+inline Float4 Add4(Float4 a, Float4 b) { return vaddq_f32(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return vsubq_f32(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return vmulq_f32(a, b); }
+inline Float4 Div4(Float4 a, Float4 b) { return vdivq_f32(a, b); }
+inline Float4 Sqrt4(Float4 a) { return vsqrtq_f32(a); }
+inline Float4 Min4(Float4 a, Float4 b) { return vminq_f32(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return vmaxq_f32(a, b); }
+inline Float4 Abs4(Float4 a) { return vabsq_f32(a); }
+inline Float4 Neg4(Float4 a) { return vnegq_f32(a); }
+inline Float4 Greater4(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+inline Float4 GreaterEqual4(Float4 a, Float4 b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+inline Float4 And4(Float4 a, Float4 b) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline Float4 AndNot4(Float4 a, Float4 b) {
+    return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+inline Float4 Select4(Float4 mask, Float4 a, Float4 b) { return vbslq_f32(vreinterpretq_u32_f32(mask), a, b); }
+#endif
+
+#if defined(METAGFX_IBL_SIMD)
+inline Float4 Dot4(Float4 ax, Float4 ay, Float4 az, Float4 bx, Float4 by, Float4 bz) {
+    return Add4(Add4(Mul4(ax, bx), Mul4(ay, by)), Mul4(az, bz));
+}
+
+// glm::normalize(): v * (1 / sqrt(dot(v, v)))
+inline void Normalize4(Float4& x, Float4& y, Float4& z) {
+    Float4 invLength = Div4(Splat4(1.0f), Sqrt4(Dot4(x, y, z, x, y, z)));
+    x = Mul4(x, invLength);
+    y = Mul4(y, invLength);
+    z = Mul4(z, invLength);
+}
+#endif
+
+} // namespace
+
 // ============================================================================
 // CubemapData Helper
 // ============================================================================
@@ -38,26 +113,75 @@ size_t CubemapData::GetOffset(uint32 face, uint32 mip) const {
 // IBLPrecompute Implementation
 // ============================================================================
 
-bool IBLPrecompute::LoadHDREnvironment(const std::string& filepath) {
+bool IBLPrecompute::LoadHDREnvironment(const std::string& filepath, uint32 maxWidth) {
     std::cout << "Loading HDR environment: " << filepath << std::endl;
 
-    auto hdrData = utils::LoadHDRImage(filepath, 4);
-    if (!hdrData.pixels) {
-        std::cerr << "Failed to load HDR image: " << filepath << std::endl;
-        return false;
+    // Radiance files are decoded a row at a time and reduced as they stream in, so peak
+    // memory is the reduced map; anything else goes through stb_image whole
+    HDRReader reader;
+    bool streamed = reader.Open(filepath);
+    utils::HDRImageData hdrData;
+    uint32 sourceWidth = reader.GetWidth();
+    uint32 sourceHeight = reader.GetHeight();
+    if (!streamed) {
+        hdrData = utils::LoadHDRImage(filepath, 4);
+        if (!hdrData.pixels) {
+            std::cerr << "Failed to load HDR image: " << filepath << std::endl;
+            return false;
+        }
+        sourceWidth = hdrData.width;
+        sourceHeight = hdrData.height;
     }
 
-    m_EquirectWidth = hdrData.width;
-    m_EquirectHeight = hdrData.height;
-
-    // Copy to internal buffer
-    size_t dataSize = m_EquirectWidth * m_EquirectHeight * 4;
-    m_EquirectData.resize(dataSize);
-    std::memcpy(m_EquirectData.data(), hdrData.pixels, dataSize * sizeof(float));
+    // The pyramid level no wider than maxWidth is the only one the conversion reads; it
+    // is box-filtered from the rows as they arrive
+    uint32 factor = 1;
+    while (maxWidth > 0 && sourceWidth / factor > maxWidth) {
+        factor *= 2;
+    }
+    m_EquirectWidth = std::max(1u, sourceWidth / factor);
+    m_EquirectHeight = std::max(1u, sourceHeight / factor);
+    m_EquirectData.assign(static_cast<size_t>(m_EquirectWidth) * m_EquirectHeight * 4, 0.0f);
+
+    std::vector<float> row(streamed ? static_cast<size_t>(sourceWidth) * 4 : 0);
+    for (uint32 y = 0; y < sourceHeight; ++y) {
+        if (streamed && !reader.ReadRow(row.data())) {
+            std::cerr << "Failed to decode HDR scanline " << y << ": " << filepath << std::endl;
+            return false;
+        }
+        const float* source = streamed ? row.data() : hdrData.pixels + static_cast<size_t>(y) * sourceWidth * 4;
+        float* target = m_EquirectData.data() + static_cast<size_t>(std::min(y / factor, m_EquirectHeight - 1)) * m_EquirectWidth * 4;
+        for (uint32 x = 0; x < sourceWidth; ++x) {
+            float* texel = target + std::min(x / factor, m_EquirectWidth - 1) * 4;
+            texel[0] += source[x * 4 + 0];
+            texel[1] += source[x * 4 + 1];
+            texel[2] += source[x * 4 + 2];
+            texel[3] += source[x * 4 + 3];
+        }
+    }
+    if (!streamed) {
+        utils::FreeHDRImage(hdrData);
+    }
 
-    utils::FreeHDRImage(hdrData);
+    // The last row and column also take the remainder of an odd source size
+    auto span = [factor](uint32 i, uint32 size, uint32 sourceSize) {
+        return i + 1 < size ? factor : sourceSize - i * factor;
+    };
+    for (uint32 y = 0; y < m_EquirectHeight; ++y) {
+        for (uint32 x = 0; x < m_EquirectWidth; ++x) {
+            float scale = 1.0f / static_cast<float>(span(x, m_EquirectWidth, sourceWidth) * span(y, m_EquirectHeight, sourceHeight));
+            float* texel = &m_EquirectData[(static_cast<size_t>(y) * m_EquirectWidth + x) * 4];
+            for (uint32 c = 0; c < 4; ++c) {
+                texel[c] *= scale;
+            }
+        }
+    }
 
-    std::cout << "  Loaded: " << m_EquirectWidth << "x" << m_EquirectHeight << std::endl;
+    std::cout << "  Loaded: " << sourceWidth << "x" << sourceHeight << (streamed ? " (streamed)" : "");
+    if (factor > 1) {
+        std::cout << ", reduced " << factor << "x to " << m_EquirectWidth << "x" << m_EquirectHeight;
+    }
+    std::cout << std::endl;
     return true;
 }
 
@@ -111,11 +235,10 @@ CubemapData IBLPrecompute::ConvertEquirectToCubemap(uint32 size) {
     cubemap.mipLevels = 1;
     cubemap.data.resize(6 * size * size * 4);
 
-    glm::vec3 avgColor(0.0f);
-    uint32 pixelCount = 0;
-
-    for (uint32 face = 0; face < 6; ++face) {
-        for (uint32 y = 0; y < size; ++y) {
+    JobSystem::ParallelFor(6 * size, 1, [&](uint32 firstRow, uint32 endRow) {
+        for (uint32 row = firstRow; row < endRow; ++row) {
+            uint32 face = row / size;
+            uint32 y = row % size;
             for (uint32 x = 0; x < size; ++x) {
                 float u = (x + 0.5f) / size;
                 float v = (y + 0.5f) / size;
@@ -128,11 +251,16 @@ CubemapData IBLPrecompute::ConvertEquirectToCubemap(uint32 size) {
                 cubemap.data[index + 1] = color.g;
                 cubemap.data[index + 2] = color.b;
                 cubemap.data[index + 3] = 1.0f;
-
-                avgColor += color;
-                pixelCount++;
             }
         }
+    });
+
+    // Summed in texel order after the jobs, so the reported average does not depend on
+    // how the rows were split
+    glm::vec3 avgColor(0.0f);
+    uint32 pixelCount = 6 * size * size;
+    for (uint32 i = 0; i < pixelCount; ++i) {
+        avgColor += glm::vec3(cubemap.data[i * 4 + 0], cubemap.data[i * 4 + 1], cubemap.data[i * 4 + 2]);
     }
 
     avgColor /= static_cast<float>(pixelCount);
@@ -141,127 +269,80 @@ CubemapData IBLPrecompute::ConvertEquirectToCubemap(uint32 size) {
     return cubemap;
 }
 
-CubemapData IBLPrecompute::GenerateIrradianceMap(const CubemapData& envMap, uint32 size, uint32 sampleCount) {
-    std::cout << "Generating irradiance map (" << size << "x" << size << ", " << sampleCount << " samples)..." << std::endl;
-
-    CubemapData irradiance;
-    irradiance.width = size;
-    irradiance.height = size;
-    irradiance.mipLevels = 1;
-    irradiance.data.resize(6 * size * size * 4);
+void IBLPrecompute::GenerateMipChain(CubemapData& cubemap) {
+    uint32 mipLevels = 1;
+    while ((std::max(cubemap.width, cubemap.height) >> mipLevels) > 0) {
+        ++mipLevels;
+    }
 
-    for (uint32 face = 0; face < 6; ++face) {
-        std::cout << "  Processing face " << (face + 1) << "/6..." << std::endl;
+    // Mip 0 stays where it is; the rest of the data is rebuilt
+    cubemap.mipLevels = 1;
+    cubemap.data.resize(cubemap.GetOffset(0, 1));
+    cubemap.mipLevels = mipLevels;
+    cubemap.data.resize(cubemap.GetOffset(0, mipLevels));
+
+    for (uint32 mip = 1; mip < mipLevels; ++mip) {
+        uint32 width = cubemap.GetMipWidth(mip);
+        uint32 height = cubemap.GetMipHeight(mip);
+        uint32 parentWidth = cubemap.GetMipWidth(mip - 1);
+        uint32 parentHeight = cubemap.GetMipHeight(mip - 1);
+        JobSystem::ParallelFor(6 * height, 1, [&](uint32 firstRow, uint32 endRow) {
+            for (uint32 row = firstRow; row < endRow; ++row) {
+                uint32 face = row / height;
+                uint32 y = row % height;
+                const float* parent = cubemap.data.data() + cubemap.GetOffset(face, mip - 1);
+                float* texel = cubemap.data.data() + cubemap.GetOffset(face, mip) + static_cast<size_t>(y) * width * 4;
+                for (uint32 x = 0; x < width; ++x, texel += 4) {
+                    // 2x2 parent texels, fewer where the parent is 1 texel wide
+                    uint32 x0 = std::min(2 * x, parentWidth - 1);
+                    uint32 x1 = std::min(2 * x + 1, parentWidth - 1);
+                    uint32 y0 = std::min(2 * y, parentHeight - 1);
+                    uint32 y1 = std::min(2 * y + 1, parentHeight - 1);
+                    for (uint32 c = 0; c < 4; ++c) {
+                        texel[c] = 0.25f * (parent[(y0 * parentWidth + x0) * 4 + c] + parent[(y0 * parentWidth + x1) * 4 + c] +
+                                            parent[(y1 * parentWidth + x0) * 4 + c] + parent[(y1 * parentWidth + x1) * 4 + c]);
+                    }
+                }
+            }
+        });
+    }
+}
 
-        for (uint32 y = 0; y < size; ++y) {
-            for (uint32 x = 0; x < size; ++x) {
+utils::IrradianceSH IBLPrecompute::ProjectIrradianceSH(const CubemapData& envMap) {
+    std::cout << "Projecting irradiance onto spherical harmonics (" << envMap.width << "x" << envMap.height << " faces)..." << std::endl;
+
+    // One pass over mip 0: every texel adds its radiance over its solid angle. Each row
+    // sums on its own and the rows are added in order, so the result does not depend on
+    // the thread count.
+    uint32 size = envMap.width;
+    std::vector<utils::RadianceSH> rowSums(6 * size);
+    JobSystem::ParallelFor(6 * size, 1, [&](uint32 firstRow, uint32 endRow) {
+        for (uint32 row = firstRow; row < endRow; ++row) {
+            uint32 face = row / size;
+            uint32 y = row % size;
+            const float* texel = envMap.data.data() + envMap.GetOffset(face, 0) + static_cast<size_t>(y) * size * 4;
+            for (uint32 x = 0; x < size; ++x, texel += 4) {
                 float u = (x + 0.5f) / size;
                 float v = (y + 0.5f) / size;
 
-                glm::vec3 normal = GetCubemapDirection(face, u, v);
-
-                // Convolution: integrate over hemisphere
-                glm::vec3 irradianceSum(0.0f);
-                float totalWeight = 0.0f;
-
-                // Build tangent space
-                glm::vec3 up = std::abs(normal.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
-                glm::vec3 tangent = glm::normalize(glm::cross(up, normal));
-                glm::vec3 bitangent = glm::cross(normal, tangent);
-
-                // Sample hemisphere
-                float deltaPhi = (2.0f * glm::pi<float>()) / std::sqrt(static_cast<float>(sampleCount));
-                float deltaTheta = (0.5f * glm::pi<float>()) / std::sqrt(static_cast<float>(sampleCount));
-
-                for (float phi = 0.0f; phi < 2.0f * glm::pi<float>(); phi += deltaPhi) {
-                    for (float theta = 0.0f; theta < 0.5f * glm::pi<float>(); theta += deltaTheta) {
-                        // Spherical to Cartesian (in tangent space)
-                        glm::vec3 tangentSample(
-                            std::sin(theta) * std::cos(phi),
-                            std::sin(theta) * std::sin(phi),
-                            std::cos(theta)
-                        );
-
-                        // Transform to world space
-                        glm::vec3 sampleDir = tangent * tangentSample.x + bitangent * tangentSample.y + normal * tangentSample.z;
-
-                        // Sample environment map (we need to sample from envMap cubemap, not equirect)
-                        // For now, sample from the input cubemap at mip 0
-                        // This is a simplified approach; for better quality, interpolate between faces
-                        glm::vec3 envColor(0.0f);
-
-                        // Determine which cubemap face to sample
-                        glm::vec3 absDir = glm::abs(sampleDir);
-                        uint32 sampleFace;
-                        glm::vec2 sampleUV;
-
-                        if (absDir.x >= absDir.y && absDir.x >= absDir.z) {
-                            // X-axis dominant
-                            if (sampleDir.x > 0.0f) {
-                                sampleFace = 0; // +X
-                                sampleUV = glm::vec2(-sampleDir.z / absDir.x, sampleDir.y / absDir.x);
-                            } else {
-                                sampleFace = 1; // -X
-                                sampleUV = glm::vec2(sampleDir.z / absDir.x, sampleDir.y / absDir.x);
-                            }
-                        } else if (absDir.y >= absDir.z) {
-                            // Y-axis dominant
-                            if (sampleDir.y > 0.0f) {
-                                sampleFace = 2; // +Y
-                                sampleUV = glm::vec2(sampleDir.x / absDir.y, -sampleDir.z / absDir.y);
-                            } else {
-                                sampleFace = 3; // -Y
-                                sampleUV = glm::vec2(sampleDir.x / absDir.y, sampleDir.z / absDir.y);
-                            }
-                        } else {
-                            // Z-axis dominant
-                            if (sampleDir.z > 0.0f) {
-                                sampleFace = 4; // +Z
-                                sampleUV = glm::vec2(sampleDir.x / absDir.z, sampleDir.y / absDir.z);
-                            } else {
-                                sampleFace = 5; // -Z
-                                sampleUV = glm::vec2(-sampleDir.x / absDir.z, sampleDir.y / absDir.z);
-                            }
-                        }
-
-                        // Convert to [0,1] range and sample
-                        sampleUV = sampleUV * 0.5f + 0.5f;
-                        sampleUV = glm::clamp(sampleUV, 0.0f, 1.0f);
-
-                        uint32 sx = static_cast<uint32>(sampleUV.x * (envMap.width - 1));
-                        uint32 sy = static_cast<uint32>(sampleUV.y * (envMap.height - 1));
-                        size_t sampleIndex = envMap.GetOffset(sampleFace, 0) + (sy * envMap.width + sx) * 4;
-
-                        envColor = glm::vec3(
-                            envMap.data[sampleIndex + 0],
-                            envMap.data[sampleIndex + 1],
-                            envMap.data[sampleIndex + 2]
-                        );
-
-                        // Accumulate with cosine weighting
-                        float NdotL = std::max(std::cos(theta), 0.0f);
-                        irradianceSum += envColor * NdotL * std::sin(theta);
-                        totalWeight += NdotL * std::sin(theta);
-                    }
-                }
-
-                // Normalize
-                if (totalWeight > 0.0f) {
-                    irradianceSum *= glm::pi<float>() / totalWeight;
-                }
+                // A texel of side 2 / size on the unit cube, seen from its center
+                float uc = 2.0f * u - 1.0f;
+                float vc = 2.0f * v - 1.0f;
+                float distanceSquared = 1.0f + uc * uc + vc * vc;
+                float solidAngle = (4.0f / (static_cast<float>(size) * size)) / (distanceSquared * std::sqrt(distanceSquared));
 
-                // Write to output
-                size_t index = irradiance.GetOffset(face, 0) + (y * size + x) * 4;
-                irradiance.data[index + 0] = irradianceSum.r;
-                irradiance.data[index + 1] = irradianceSum.g;
-                irradiance.data[index + 2] = irradianceSum.b;
-                irradiance.data[index + 3] = 1.0f;
+                rowSums[row].Add(GetCubemapDirection(face, u, v), glm::vec3(texel[0], texel[1], texel[2]), solidAngle);
             }
         }
+    });
+
+    utils::RadianceSH radiance;
+    for (const utils::RadianceSH& rowSum : rowSums) {
+        radiance += rowSum;
     }
 
-    std::cout << "  Irradiance map complete" << std::endl;
-    return irradiance;
+    std::cout << "  Irradiance coefficients complete" << std::endl;
+    return utils::IrradianceSH::FromRadiance(radiance);
 }
 
 // Helper functions for GGX importance sampling
@@ -330,6 +411,100 @@ float IBLPrecompute::GeometrySmith(const glm::vec3& N, const glm::vec3& V, const
     return ggx1 * ggx2;
 }
 
+IBLPrecompute::GGXSamples IBLPrecompute::BuildGGXSamples(float roughness, uint32 sampleCount, const CubemapData& envMap) {
+    // A mirror reflects N itself: every sample would be the same
+    if (roughness == 0.0f) {
+        sampleCount = 1;
+    }
+
+    GGXSamples samples;
+    samples.x.resize(sampleCount);
+    samples.y.resize(sampleCount);
+    samples.z.resize(sampleCount);
+    samples.lod.resize(sampleCount);
+
+    // Solid angle of a texel of mip 0
+    float texelSolidAngle = 4.0f * glm::pi<float>() / (6.0f * envMap.width * envMap.height);
+    float maxLod = static_cast<float>(envMap.mipLevels - 1);
+
+    // The tangent-space half of ImportanceSampleGGX()
+    float a = roughness * roughness;
+    for (uint32 i = 0; i < sampleCount; ++i) {
+        glm::vec2 Xi = Hammersley(i, sampleCount);
+        float phi = 2.0f * glm::pi<float>() * Xi.x;
+        float cosTheta = std::sqrt((1.0f - Xi.y) / (1.0f + (a * a - 1.0f) * Xi.y));
+        float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+        samples.x[i] = sinTheta * std::cos(phi);
+        samples.y[i] = sinTheta * std::sin(phi);
+        samples.z[i] = cosTheta;
+
+        // Filtered importance sampling (GPU Gems 3, ch. 20): read the mip whose texels
+        // cover the solid angle of the sample. With V = N the PDF of L is D(NdotH) / 4.
+        if (roughness > 0.0f) {
+            float pdf = DistributionGGX(glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(samples.x[i], samples.y[i], cosTheta), roughness) / 4.0f;
+            float sampleSolidAngle = 1.0f / (static_cast<float>(sampleCount) * pdf + 0.0001f);
+            samples.lod[i] = glm::clamp(0.5f * std::log2(sampleSolidAngle / texelSolidAngle) + 1.0f, 0.0f, maxLod);
+        } else {
+            samples.lod[i] = 0.0f;
+        }
+    }
+    return samples;
+}
+
+uint32 IBLPrecompute::GetCubemapFace(const glm::vec3& L, glm::vec2& uv) {
+    glm::vec3 absL = glm::abs(L);
+    uint32 face;
+    if (absL.x >= absL.y && absL.x >= absL.z) {
+        face = L.x > 0.0f ? 0 : 1;
+        uv = glm::vec2(L.x > 0.0f ? -L.z : L.z, L.y) / absL.x;
+    } else if (absL.y >= absL.z) {
+        face = L.y > 0.0f ? 2 : 3;
+        uv = glm::vec2(L.x, L.y > 0.0f ? -L.z : L.z) / absL.y;
+    } else {
+        face = L.z > 0.0f ? 4 : 5;
+        uv = glm::vec2(L.z > 0.0f ? L.x : -L.x, L.y) / absL.z;
+    }
+    uv = glm::clamp(uv * 0.5f + 0.5f, 0.0f, 1.0f);
+    return face;
+}
+
+glm::vec3 IBLPrecompute::FetchCubemapTexel(const CubemapData& envMap, uint32 face, uint32 mip, int32 x, int32 y) {
+    int32 width = static_cast<int32>(envMap.GetMipWidth(mip));
+    int32 height = static_cast<int32>(envMap.GetMipHeight(mip));
+    if (x < 0 || y < 0 || x >= width || y >= height) {
+        // The texel center extends the face's plane; its direction finds the neighbour
+        glm::vec2 uv;
+        face = GetCubemapFace(GetCubemapDirection(face, (x + 0.5f) / width, (y + 0.5f) / height), uv);
+        x = std::min(static_cast<int32>(uv.x * width), width - 1);
+        y = std::min(static_cast<int32>(uv.y * height), height - 1);
+    }
+    size_t index = envMap.GetOffset(face, mip) + (static_cast<size_t>(y) * width + x) * 4;
+    return glm::vec3(envMap.data[index + 0], envMap.data[index + 1], envMap.data[index + 2]);
+}
+
+glm::vec3 IBLPrecompute::SampleCubemap(const CubemapData& envMap, uint32 face, float u, float v, float lod) {
+    auto bilinear = [&](uint32 mip) {
+        float x = u * envMap.GetMipWidth(mip) - 0.5f;
+        float y = v * envMap.GetMipHeight(mip) - 0.5f;
+        float x0 = std::floor(x);
+        float y0 = std::floor(y);
+        float fx = x - x0;
+        float fy = y - y0;
+        int32 ix = static_cast<int32>(x0);
+        int32 iy = static_cast<int32>(y0);
+        glm::vec3 top = glm::mix(FetchCubemapTexel(envMap, face, mip, ix, iy), FetchCubemapTexel(envMap, face, mip, ix + 1, iy), fx);
+        glm::vec3 bottom = glm::mix(FetchCubemapTexel(envMap, face, mip, ix, iy + 1), FetchCubemapTexel(envMap, face, mip, ix + 1, iy + 1), fx);
+        return glm::mix(top, bottom, fy);
+    };
+
+    uint32 mip = static_cast<uint32>(lod);
+    float blend = lod - static_cast<float>(mip);
+    if (blend == 0.0f || mip + 1 >= envMap.mipLevels) {
+        return bilinear(std::min(mip, envMap.mipLevels - 1));
+    }
+    return glm::mix(bilinear(mip), bilinear(mip + 1), blend);
+}
+
 CubemapData IBLPrecompute::GeneratePrefilteredMap(const CubemapData& envMap, uint32 size, uint32 mipLevels, uint32 sampleCount) {
     std::cout << "Generating prefiltered environment map (" << size << "x" << size << ", " << mipLevels << " mips, " << sampleCount << " samples)..." << std::endl;
 
@@ -347,105 +522,149 @@ CubemapData IBLPrecompute::GeneratePrefilteredMap(const CubemapData& envMap, uin
     }
     prefiltered.data.resize(totalSize);
 
+    // The sample directions and source mips depend only on the roughness: built once per
+    // mip, then only rotated into each texel's tangent frame
+    std::vector<GGXSamples> mipSamples(mipLevels);
     for (uint32 mip = 0; mip < mipLevels; ++mip) {
         float roughness = static_cast<float>(mip) / static_cast<float>(mipLevels - 1);
-        uint32 mipWidth = prefiltered.GetMipWidth(mip);
-        uint32 mipHeight = prefiltered.GetMipHeight(mip);
+        mipSamples[mip] = BuildGGXSamples(roughness, sampleCount, envMap);
+    }
+
+    // One pass over the rows of every mip, so the small mips at the tail do not each
+    // wait for the workers to drain. firstRows[mip] is the first (face, row) of the mip.
+    std::vector<uint32> firstRows(mipLevels + 1, 0);
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        firstRows[mip + 1] = firstRows[mip] + 6 * prefiltered.GetMipHeight(mip);
+    }
 
-        std::cout << "  Processing mip " << mip << "/" << (mipLevels - 1) << " (roughness=" << roughness << ", " << mipWidth << "x" << mipHeight << ")..." << std::endl;
+    JobSystem::ParallelFor(firstRows[mipLevels], 1, [&](uint32 firstRow, uint32 endRow) {
+        uint32 mip = 0;
+        for (uint32 row = firstRow; row < endRow; ++row) {
+            while (row >= firstRows[mip + 1]) {
+                ++mip;
+            }
+            const GGXSamples& samples = mipSamples[mip];
+            uint32 mipSampleCount = static_cast<uint32>(samples.x.size());
+            uint32 mipWidth = prefiltered.GetMipWidth(mip);
+            uint32 mipHeight = prefiltered.GetMipHeight(mip);
+            uint32 face = (row - firstRows[mip]) / mipHeight;
+            uint32 y = (row - firstRows[mip]) % mipHeight;
+            for (uint32 x = 0; x < mipWidth; ++x) {
+                float u = (x + 0.5f) / mipWidth;
+                float v = (y + 0.5f) / mipHeight;
+
+                glm::vec3 N = GetCubemapDirection(face, u, v);
+                glm::vec3 V = N; // Assume view direction == normal (for prefiltering)
+
+                // Tangent frame of ImportanceSampleGGX()
+                glm::vec3 up = std::abs(N.y) < 0.999f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+                glm::vec3 tangent = glm::normalize(glm::cross(up, N));
+                glm::vec3 bitangent = glm::cross(N, tangent);
+
+                glm::vec3 prefilteredColor(0.0f);
+                float totalWeight = 0.0f;
 
-        glm::vec3 mipAvgColor(0.0f);
-        uint32 mipPixelCount = 0;
-
-        for (uint32 face = 0; face < 6; ++face) {
-            for (uint32 y = 0; y < mipHeight; ++y) {
-                for (uint32 x = 0; x < mipWidth; ++x) {
-                    float u = (x + 0.5f) / mipWidth;
-                    float v = (y + 0.5f) / mipHeight;
-
-                    glm::vec3 N = GetCubemapDirection(face, u, v);
-                    glm::vec3 R = N; // Assume view direction == normal (for prefiltering)
-                    glm::vec3 V = R;
-
-                    glm::vec3 prefilteredColor(0.0f);
-                    float totalWeight = 0.0f;
-
-                    for (uint32 i = 0; i < sampleCount; ++i) {
-                        glm::vec2 Xi = Hammersley(i, sampleCount);
-                        glm::vec3 H = ImportanceSampleGGX(Xi, N, roughness);
-                        glm::vec3 L = glm::normalize(2.0f * glm::dot(V, H) * H - V);
-
-                        float NdotL = std::max(glm::dot(N, L), 0.0f);
-
-                        if (NdotL > 0.0f) {
-                            // Sample environment map in direction L
-                            glm::vec3 envColor(0.0f);
-
-                            // Determine face and UV for L
-                            glm::vec3 absL = glm::abs(L);
-                            uint32 sampleFace;
-                            glm::vec2 sampleUV;
-
-                            if (absL.x >= absL.y && absL.x >= absL.z) {
-                                if (L.x > 0.0f) {
-                                    sampleFace = 0;
-                                    sampleUV = glm::vec2(-L.z / absL.x, L.y / absL.x);
-                                } else {
-                                    sampleFace = 1;
-                                    sampleUV = glm::vec2(L.z / absL.x, L.y / absL.x);
-                                }
-                            } else if (absL.y >= absL.z) {
-                                if (L.y > 0.0f) {
-                                    sampleFace = 2;
-                                    sampleUV = glm::vec2(L.x / absL.y, -L.z / absL.y);
-                                } else {
-                                    sampleFace = 3;
-                                    sampleUV = glm::vec2(L.x / absL.y, L.z / absL.y);
-                                }
-                            } else {
-                                if (L.z > 0.0f) {
-                                    sampleFace = 4;
-                                    sampleUV = glm::vec2(L.x / absL.z, L.y / absL.z);
-                                } else {
-                                    sampleFace = 5;
-                                    sampleUV = glm::vec2(-L.x / absL.z, L.y / absL.z);
-                                }
-                            }
-
-                            sampleUV = sampleUV * 0.5f + 0.5f;
-                            sampleUV = glm::clamp(sampleUV, 0.0f, 1.0f);
-
-                            uint32 sx = static_cast<uint32>(sampleUV.x * (envMap.width - 1));
-                            uint32 sy = static_cast<uint32>(sampleUV.y * (envMap.height - 1));
-                            size_t sampleIndex = envMap.GetOffset(sampleFace, 0) + (sy * envMap.width + sx) * 4;
-
-                            envColor = glm::vec3(
-                                envMap.data[sampleIndex + 0],
-                                envMap.data[sampleIndex + 1],
-                                envMap.data[sampleIndex + 2]
-                            );
-
-                            prefilteredColor += envColor * NdotL;
-                            totalWeight += NdotL;
+                uint32 i = 0;
+#if defined(METAGFX_IBL_SIMD)
+                // Directions, faces and texel coordinates of 4 samples at a time; the
+                // fetches and sums stay in sample order
+                alignas(16) float laneNdotL[4];
+                alignas(16) float laneFace[4];
+                alignas(16) float laneU[4];
+                alignas(16) float laneV[4];
+                for (; i + 4 <= mipSampleCount; i += 4) {
+                    Float4 hx = Load4(&samples.x[i]);
+                    Float4 hy = Load4(&samples.y[i]);
+                    Float4 hz = Load4(&samples.z[i]);
+                    Float4 Hx = Add4(Add4(Mul4(Splat4(tangent.x), hx), Mul4(Splat4(bitangent.x), hy)), Mul4(Splat4(N.x), hz));
+                    Float4 Hy = Add4(Add4(Mul4(Splat4(tangent.y), hx), Mul4(Splat4(bitangent.y), hy)), Mul4(Splat4(N.y), hz));
+                    Float4 Hz = Add4(Add4(Mul4(Splat4(tangent.z), hx), Mul4(Splat4(bitangent.z), hy)), Mul4(Splat4(N.z), hz));
+                    Normalize4(Hx, Hy, Hz);
+
+                    Float4 VdotH2 = Mul4(Splat4(2.0f), Dot4(Splat4(V.x), Splat4(V.y), Splat4(V.z), Hx, Hy, Hz));
+                    Float4 Lx = Sub4(Mul4(VdotH2, Hx), Splat4(V.x));
+                    Float4 Ly = Sub4(Mul4(VdotH2, Hy), Splat4(V.y));
+                    Float4 Lz = Sub4(Mul4(VdotH2, Hz), Splat4(V.z));
+                    Normalize4(Lx, Ly, Lz);
+                    Store4(laneNdotL, Max4(Dot4(Splat4(N.x), Splat4(N.y), Splat4(N.z), Lx, Ly, Lz), Splat4(0.0f)));
+
+                    // Major axis, face and face UV as in the scalar path below
+                    Float4 ax = Abs4(Lx);
+                    Float4 ay = Abs4(Ly);
+                    Float4 az = Abs4(Lz);
+                    Float4 xMajor = And4(GreaterEqual4(ax, ay), GreaterEqual4(ax, az));
+                    Float4 yMajor = AndNot4(GreaterEqual4(ay, az), xMajor);
+                    Float4 positiveX = Greater4(Lx, Splat4(0.0f));
+                    Float4 positiveY = Greater4(Ly, Splat4(0.0f));
+                    Float4 positiveZ = Greater4(Lz, Splat4(0.0f));
+
+                    Float4 major = Select4(xMajor, ax, Select4(yMajor, ay, az));
+                    Float4 uNum = Select4(xMajor, Select4(positiveX, Neg4(Lz), Lz),
+                                          Select4(yMajor, Lx, Select4(positiveZ, Lx, Neg4(Lx))));
+                    Float4 vNum = Select4(yMajor, Select4(positiveY, Neg4(Lz), Lz), Ly);
+                    Float4 faceIndex = Select4(xMajor, Select4(positiveX, Splat4(0.0f), Splat4(1.0f)),
+                                               Select4(yMajor, Select4(positiveY, Splat4(2.0f), Splat4(3.0f)),
+                                                       Select4(positiveZ, Splat4(4.0f), Splat4(5.0f))));
+
+                    Float4 half = Splat4(0.5f);
+                    Float4 su = Add4(Mul4(Div4(uNum, major), half), half);
+                    Float4 sv = Add4(Mul4(Div4(vNum, major), half), half);
+                    Store4(laneU, Min4(Max4(su, Splat4(0.0f)), Splat4(1.0f)));
+                    Store4(laneV, Min4(Max4(sv, Splat4(0.0f)), Splat4(1.0f)));
+                    Store4(laneFace, faceIndex);
+
+                    for (uint32 lane = 0; lane < 4; ++lane) {
+                        if (laneNdotL[lane] > 0.0f) {
+                            glm::vec3 envColor = SampleCubemap(envMap, static_cast<uint32>(laneFace[lane]),
+                                                               laneU[lane], laneV[lane], samples.lod[i + lane]);
+                            prefilteredColor += envColor * laneNdotL[lane];
+                            totalWeight += laneNdotL[lane];
                         }
                     }
+                }
+#endif
+                for (; i < mipSampleCount; ++i) {
+                    glm::vec3 H = glm::normalize(tangent * samples.x[i] + bitangent * samples.y[i] + N * samples.z[i]);
+                    glm::vec3 L = glm::normalize(2.0f * glm::dot(V, H) * H - V);
 
-                    if (totalWeight > 0.0f) {
-                        prefilteredColor /= totalWeight;
-                    }
+                    float NdotL = std::max(glm::dot(N, L), 0.0f);
 
-                    size_t index = prefiltered.GetOffset(face, mip) + (y * mipWidth + x) * 4;
-                    prefiltered.data[index + 0] = prefilteredColor.r;
-                    prefiltered.data[index + 1] = prefilteredColor.g;
-                    prefiltered.data[index + 2] = prefilteredColor.b;
-                    prefiltered.data[index + 3] = 1.0f;
+                    if (NdotL > 0.0f) {
+                        glm::vec2 sampleUV;
+                        uint32 sampleFace = GetCubemapFace(L, sampleUV);
+                        glm::vec3 envColor = SampleCubemap(envMap, sampleFace, sampleUV.x, sampleUV.y, samples.lod[i]);
+                        prefilteredColor += envColor * NdotL;
+                        totalWeight += NdotL;
+                    }
+                }
 
-                    mipAvgColor += prefilteredColor;
-                    mipPixelCount++;
+                if (totalWeight > 0.0f) {
+                    prefilteredColor /= totalWeight;
                 }
+
+                size_t index = prefiltered.GetOffset(face, mip) + (y * mipWidth + x) * 4;
+                prefiltered.data[index + 0] = prefilteredColor.r;
+                prefiltered.data[index + 1] = prefilteredColor.g;
+                prefiltered.data[index + 2] = prefilteredColor.b;
+                prefiltered.data[index + 3] = 1.0f;
             }
         }
+    });
 
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        float roughness = static_cast<float>(mip) / static_cast<float>(mipLevels - 1);
+        uint32 mipWidth = prefiltered.GetMipWidth(mip);
+        uint32 mipHeight = prefiltered.GetMipHeight(mip);
+        std::cout << "  Mip " << mip << "/" << (mipLevels - 1) << " (roughness=" << roughness << ", "
+                  << mipWidth << "x" << mipHeight << ")" << std::endl;
+
+        // Faces of a mip are contiguous
+        glm::vec3 mipAvgColor(0.0f);
+        uint32 mipPixelCount = 6 * mipWidth * mipHeight;
+        const float* mipData = prefiltered.data.data() + prefiltered.GetOffset(0, mip);
+        for (uint32 i = 0; i < mipPixelCount; ++i) {
+            mipAvgColor += glm::vec3(mipData[i * 4 + 0], mipData[i * 4 + 1], mipData[i * 4 + 2]);
+        }
         mipAvgColor /= static_cast<float>(mipPixelCount);
         std::cout << "    Mip " << mip << " average color: RGB("
                   << mipAvgColor.r << ", " << mipAvgColor.g << ", " << mipAvgColor.b << ")" << std::endl;
@@ -463,53 +682,55 @@ Texture2DData IBLPrecompute::GenerateBRDFLUT(uint32 size, uint32 sampleCount) {
     lut.height = size;
     lut.data.resize(size * size * 4); // RGBA, but we'll only use RG
 
-    for (uint32 y = 0; y < size; ++y) {
-        for (uint32 x = 0; x < size; ++x) {
-            float NdotV = (x + 0.5f) / size;
-            float roughness = (y + 0.5f) / size;
+    JobSystem::ParallelFor(size, 1, [&](uint32 firstRow, uint32 endRow) {
+        for (uint32 y = firstRow; y < endRow; ++y) {
+            for (uint32 x = 0; x < size; ++x) {
+                float NdotV = (x + 0.5f) / size;
+                float roughness = (y + 0.5f) / size;
 
-            // Clamp NdotV to avoid division by zero
-            NdotV = std::max(NdotV, 0.001f);
+                // Clamp NdotV to avoid division by zero
+                NdotV = std::max(NdotV, 0.001f);
 
-            glm::vec3 V;
-            V.x = std::sqrt(1.0f - NdotV * NdotV); // sin
-            V.y = 0.0f;
-            V.z = NdotV; // cos
+                glm::vec3 V;
+                V.x = std::sqrt(1.0f - NdotV * NdotV); // sin
+                V.y = 0.0f;
+                V.z = NdotV; // cos
 
-            glm::vec3 N(0.0f, 0.0f, 1.0f);
+                glm::vec3 N(0.0f, 0.0f, 1.0f);
 
-            float A = 0.0f;
-            float B = 0.0f;
+                float A = 0.0f;
+                float B = 0.0f;
 
-            for (uint32 i = 0; i < sampleCount; ++i) {
-                glm::vec2 Xi = Hammersley(i, sampleCount);
-                glm::vec3 H = ImportanceSampleGGX(Xi, N, roughness);
-                glm::vec3 L = glm::normalize(2.0f * glm::dot(V, H) * H - V);
+                for (uint32 i = 0; i < sampleCount; ++i) {
+                    glm::vec2 Xi = Hammersley(i, sampleCount);
+                    glm::vec3 H = ImportanceSampleGGX(Xi, N, roughness);
+                    glm::vec3 L = glm::normalize(2.0f * glm::dot(V, H) * H - V);
 
-                float NdotL = std::max(L.z, 0.0f);
-                float NdotH = std::max(H.z, 0.0f);
-                float VdotH = std::max(glm::dot(V, H), 0.0f);
+                    float NdotL = std::max(L.z, 0.0f);
+                    float NdotH = std::max(H.z, 0.0f);
+                    float VdotH = std::max(glm::dot(V, H), 0.0f);
 
-                if (NdotL > 0.0f) {
-                    float G = GeometrySmith(N, V, L, roughness);
-                    float G_Vis = (G * VdotH) / std::max(NdotH * NdotV, 0.0001f);
-                    float Fc = std::pow(1.0f - VdotH, 5.0f);
+                    if (NdotL > 0.0f) {
+                        float G = GeometrySmith(N, V, L, roughness);
+                        float G_Vis = (G * VdotH) / std::max(NdotH * NdotV, 0.0001f);
+                        float Fc = std::pow(1.0f - VdotH, 5.0f);
 
-                    A += (1.0f - Fc) * G_Vis;
-                    B += Fc * G_Vis;
+                        A += (1.0f - Fc) * G_Vis;
+                        B += Fc * G_Vis;
+                    }
                 }
-            }
 
-            A /= static_cast<float>(sampleCount);
-            B /= static_cast<float>(sampleCount);
+                A /= static_cast<float>(sampleCount);
+                B /= static_cast<float>(sampleCount);
 
-            size_t index = (y * size + x) * 4;
-            lut.data[index + 0] = A;
-            lut.data[index + 1] = B;
-            lut.data[index + 2] = 0.0f; // Unused
-            lut.data[index + 3] = 1.0f; // Unused
+                size_t index = (y * size + x) * 4;
+                lut.data[index + 0] = A;
+                lut.data[index + 1] = B;
+                lut.data[index + 2] = 0.0f; // Unused
+                lut.data[index + 3] = 1.0f; // Unused
+            }
         }
-    }
+    });
 
     std::cout << "  BRDF LUT complete" << std::endl;
     return lut;
@@ -4,6 +4,7 @@
 #pragma once
 
 #include "metagfx/core/Types.h"
+#include "metagfx/utils/SphericalHarmonics.h"
 #include <glm/glm.hpp>
 #include <string>
 #include <vector>
@@ -39,22 +40,53 @@ public:
     IBLPrecompute() = default;
     ~IBLPrecompute() = default;
 
-    // Load HDR equirectangular environment map
-    bool LoadHDREnvironment(const std::string& filepath);
+    // Load HDR equirectangular environment map, box-reduced by powers of two until it is
+    // no wider than maxWidth (0 keeps the full resolution)
+    bool LoadHDREnvironment(const std::string& filepath, uint32 maxWidth = 0);
+
+    // The loaded equirectangular map, RGBA float (source of the GPU path)
+    const std::vector<float>& GetEquirectData() const { return m_EquirectData; }
+    uint32 GetEquirectWidth() const { return m_EquirectWidth; }
+    uint32 GetEquirectHeight() const { return m_EquirectHeight; }
 
     // Convert equirectangular to cubemap
     CubemapData ConvertEquirectToCubemap(uint32 size);
 
-    // Generate diffuse irradiance map
-    CubemapData GenerateIrradianceMap(const CubemapData& envMap, uint32 size, uint32 sampleCount = 1024);
+    // Replaces the mips of a cubemap with a full 2x2 box-filtered chain from mip 0, the
+    // source of the prefilter's filtered importance sampling
+    static void GenerateMipChain(CubemapData& cubemap);
+
+    // Diffuse irradiance as L2 spherical harmonics, in one pass over mip 0 of the cubemap
+    utils::IrradianceSH ProjectIrradianceSH(const CubemapData& envMap);
 
-    // Generate prefiltered specular environment map
-    CubemapData GeneratePrefilteredMap(const CubemapData& envMap, uint32 size, uint32 mipLevels, uint32 sampleCount = 1024);
+    // Generate prefiltered specular environment map. Each sample reads the envMap mip whose
+    // texels cover the sample's solid angle, so envMap should carry a mip chain.
+    CubemapData GeneratePrefilteredMap(const CubemapData& envMap, uint32 size, uint32 mipLevels, uint32 sampleCount = 64);
 
     // Generate BRDF integration lookup table
     Texture2DData GenerateBRDFLUT(uint32 size, uint32 sampleCount = 1024);
 
 private:
+    // Tangent-space GGX half vectors of the Hammersley points of one roughness, as
+    // separate x, y and z arrays for the 4-wide prefilter kernel, and the source mip
+    // each sample reads
+    struct GGXSamples {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> lod;
+    };
+    static GGXSamples BuildGGXSamples(float roughness, uint32 sampleCount, const CubemapData& envMap);
+
+    // Helper: Face of the major axis of a direction, and its UV in [0, 1]
+    static uint32 GetCubemapFace(const glm::vec3& direction, glm::vec2& uv);
+
+    // Helper: Texel of a cubemap mip; coordinates off the face continue on its neighbour
+    static glm::vec3 FetchCubemapTexel(const CubemapData& envMap, uint32 face, uint32 mip, int32 x, int32 y);
+
+    // Helper: Trilinear sample of a cubemap face, UV in [0, 1], filtered across face edges
+    static glm::vec3 SampleCubemap(const CubemapData& envMap, uint32 face, float u, float v, float lod);
+
     // Helper: Sample equirectangular map
     glm::vec3 SampleEquirect(const glm::vec3& direction) const;
 
@@ -2,8 +2,14 @@
 // tools/ibl_precompute/main.cpp - IBL Precomputation Tool Entry Point
 // ============================================================================
 #include "IBLPrecompute.h"
+#include "BakeCache.h"
+#include "IBLCompute.h"
 #include "DDSWriter.h"
+#include "metagfx/core/JobSystem.h"
 #include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <SDL3/SDL.h>
 
 #include <iostream>
 #include <string>
@@ -21,17 +27,23 @@ void PrintUsage(const char* programName) {
     std::cout << "  output_dir   Directory to write output DDS files\n\n";
     std::cout << "Options:\n";
     std::cout << "  --env-size <size>         Cubemap size for environment (default: 1024)\n";
-    std::cout << "  --irr-size <size>         Cubemap size for irradiance (default: 64)\n";
+    std::cout << "  --max-equirect <width>    Widest equirect kept in memory (default: 4 x env size)\n";
     std::cout << "  --pref-size <size>        Cubemap size for prefiltered map (default: 512)\n";
     std::cout << "  --pref-mips <count>       Number of mip levels for prefiltered map (default: 6)\n";
     std::cout << "  --lut-size <size>         Size of BRDF LUT (default: 512)\n";
-    std::cout << "  --samples <count>         Number of samples per pixel (default: 1024)\n";
-    std::cout << "  --fast                    Use fewer samples for faster processing (256 samples)\n\n";
+    std::cout << "  --pref-samples <count>    Samples per prefiltered texel (default: 64)\n";
+    std::cout << "  --samples <count>         Samples per BRDF LUT texel (default: 1024)\n";
+    std::cout << "  --fast                    Use fewer samples for faster processing (32 and 256)\n";
+    std::cout << "  --threads <count>         Threads to convolve on, 1 for none (default: all cores)\n";
+    std::cout << "  --gpu                     Convolve with compute shaders, falling back to the CPU\n";
+    std::cout << "  --shared-lut <dir>        Bake the BRDF LUT once into dir and copy it from there\n";
+    std::cout << "  --force                   Re-bake outputs that are already up to date\n\n";
     std::cout << "Output files (in output_dir):\n";
     std::cout << "  environment.dds           Original environment cubemap\n";
-    std::cout << "  irradiance.dds           Irradiance map for diffuse IBL\n";
+    std::cout << "  irradiance_sh.txt        Spherical harmonics irradiance for diffuse IBL\n";
     std::cout << "  prefiltered.dds          Prefiltered environment map for specular IBL\n";
-    std::cout << "  brdf_lut.dds             BRDF integration lookup table\n\n";
+    std::cout << "  brdf_lut.dds             BRDF integration lookup table\n";
+    std::cout << "  ibl_cache.txt            Content keys of the outputs, to skip unchanged ones\n\n";
     std::cout << "Example:\n";
     std::cout << "  " << programName << " studio.hdr assets/envmaps/studio/\n";
     std::cout << "  " << programName << " outdoor.hdr assets/envmaps/outdoor/ --fast\n";
@@ -49,11 +61,16 @@ int main(int argc, char** argv) {
 
     // Default settings
     uint32 envSize = 1024;
-    uint32 irrSize = 64;
+    uint32 maxEquirect = 0;
     uint32 prefSize = 512;
     uint32 prefMips = 6;
     uint32 lutSize = 512;
+    uint32 prefSamples = 64;
     uint32 samples = 1024;
+    uint32 threads = 0;
+    bool gpu = false;
+    bool force = false;
+    std::string sharedLut;
 
     // Parse optional arguments
     for (int i = 3; i < argc; ++i) {
@@ -61,18 +78,29 @@ int main(int argc, char** argv) {
 
         if (arg == "--env-size" && i + 1 < argc) {
             envSize = std::atoi(argv[++i]);
-        } else if (arg == "--irr-size" && i + 1 < argc) {
-            irrSize = std::atoi(argv[++i]);
+        } else if (arg == "--max-equirect" && i + 1 < argc) {
+            maxEquirect = std::atoi(argv[++i]);
         } else if (arg == "--pref-size" && i + 1 < argc) {
             prefSize = std::atoi(argv[++i]);
         } else if (arg == "--pref-mips" && i + 1 < argc) {
             prefMips = std::atoi(argv[++i]);
         } else if (arg == "--lut-size" && i + 1 < argc) {
             lutSize = std::atoi(argv[++i]);
+        } else if (arg == "--pref-samples" && i + 1 < argc) {
+            prefSamples = std::atoi(argv[++i]);
         } else if (arg == "--samples" && i + 1 < argc) {
             samples = std::atoi(argv[++i]);
         } else if (arg == "--fast") {
+            prefSamples = 32;
             samples = 256;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--gpu") {
+            gpu = true;
+        } else if (arg == "--shared-lut" && i + 1 < argc) {
+            sharedLut = argv[++i];
+        } else if (arg == "--force") {
+            force = true;
         }
     }
 
@@ -92,53 +120,186 @@ int main(int argc, char** argv) {
     std::cout << "Input HDR:        " << inputHDR << "\n";
     std::cout << "Output directory: " << outputDir << "\n";
     std::cout << "Environment size: " << envSize << "x" << envSize << "\n";
-    std::cout << "Irradiance size:  " << irrSize << "x" << irrSize << "\n";
     std::cout << "Prefiltered size: " << prefSize << "x" << prefSize << " (" << prefMips << " mips)\n";
     std::cout << "BRDF LUT size:    " << lutSize << "x" << lutSize << "\n";
-    std::cout << "Samples per pixel: " << samples << "\n";
+    std::cout << "Samples per pixel: " << prefSamples << " (prefiltered), " << samples << " (BRDF LUT)\n";
     std::cout << "========================================\n\n";
 
+    // Content keys: each output hashes the HDR contents and the settings it depends on. A
+    // cube face spans a quarter of the equirect's width, so finer levels than 4x the face
+    // size are never sampled.
+    uint32 equirectWidth = maxEquirect ? maxEquirect : 4 * envSize;
+    uint64 environmentKey = BakeCache::Combine(BakeCache::HashFile(inputHDR), BakeCache::VERSION);
+    environmentKey = BakeCache::Combine(BakeCache::Combine(environmentKey, envSize), equirectWidth);
+    uint64 irradianceKey = environmentKey;
+    uint64 prefilteredKey = BakeCache::Combine(BakeCache::Combine(BakeCache::Combine(environmentKey, prefSize), prefMips), prefSamples);
+    uint64 lutKey = BakeCache::Combine(BakeCache::Combine(BakeCache::VERSION, lutSize), samples);
+
+    std::filesystem::path outPath(outputDir);
+    BakeCache cache(outPath);
+    bool bakeEnvironment = force || !cache.IsUpToDate("environment.dds", environmentKey);
+    bool bakeIrradiance = force || !cache.IsUpToDate("irradiance_sh.txt", irradianceKey);
+    bool bakePrefiltered = force || !cache.IsUpToDate("prefiltered.dds", prefilteredKey);
+    bool needCubemap = bakeEnvironment || bakeIrradiance || bakePrefiltered;
+
+    // The LUT does not depend on the environment: with --shared-lut it is baked once into
+    // that directory, and each output directory gets a copy
+    Scope<BakeCache> lutCache;
+    if (!sharedLut.empty()) {
+        std::filesystem::create_directories(sharedLut);
+        lutCache = CreateScope<BakeCache>(sharedLut);
+    }
+    bool copyLUT = force || !cache.IsUpToDate("brdf_lut.dds", lutKey);
+    bool bakeLUT = copyLUT && (force || !lutCache || !lutCache->IsUpToDate("brdf_lut.dds", lutKey));
+
+    if (!needCubemap && !copyLUT) {
+        std::cout << "All outputs are up to date (--force re-bakes them)\n";
+        return 0;
+    }
+
+    // Rows of the generated maps are convolved in parallel; the calling thread takes part,
+    // and without Init() every row runs on it. Each texel's samples are summed in the same
+    // order either way, so the output does not depend on the thread count.
+    if (threads != 1) {
+        JobSystemDesc jobDesc;
+        jobDesc.workerCount = threads > 1 ? threads - 1 : 0;
+        JobSystem::Init(jobDesc);
+    }
+    std::cout << "Threads: " << JobSystem::GetWorkerCount() + 1 << "\n\n";
+
     // Create IBL precompute instance
     IBLPrecompute ibl;
 
     // Step 1: Load HDR environment
-    if (!ibl.LoadHDREnvironment(inputHDR)) {
+    if (needCubemap && !ibl.LoadHDREnvironment(inputHDR, equirectWidth)) {
         std::cerr << "Error: Failed to load HDR environment\n";
+        JobSystem::Shutdown();
         return 1;
     }
 
-    // Step 2: Convert equirectangular to cubemap
-    auto envCubemap = ibl.ConvertEquirectToCubemap(envSize);
+    // The GPU path needs a device, which needs a (hidden) window; nothing is presented
+    SDL_Window* window = nullptr;
+    Ref<rhi::GraphicsDevice> device;
+    Scope<IBLCompute> compute;
+    if (gpu && (needCubemap || bakeLUT)) {
+#ifdef METAGFX_USE_VULKAN
+        rhi::GraphicsAPI api = rhi::GraphicsAPI::Vulkan;
+        SDL_WindowFlags windowFlags = SDL_WINDOW_HIDDEN | SDL_WINDOW_VULKAN;
+#else
+        rhi::GraphicsAPI api = rhi::GraphicsAPI::Metal;
+        SDL_WindowFlags windowFlags = SDL_WINDOW_HIDDEN | SDL_WINDOW_METAL;
+#endif
+        if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+            window = SDL_CreateWindow("ibl_precompute", 64, 64, windowFlags);
+        }
+        if (window) {
+            rhi::GraphicsDeviceDesc deviceDesc{};
+            deviceDesc.offscreen = true;
+            device = rhi::CreateGraphicsDevice(api, window, deviceDesc);
+        }
+        if (device) {
+            compute = CreateScope<IBLCompute>(device);
+        }
+        if (!compute || !compute->IsValid()) {
+            std::cerr << "Warning: No GPU path available, convolving on the CPU\n";
+            compute.reset();
+        }
+    }
 
-    // Step 3: Generate irradiance map
-    auto irradianceMap = ibl.GenerateIrradianceMap(envCubemap, irrSize, samples);
+    CubemapData envCubemap;
+    utils::IrradianceSH irradianceSH;
+    CubemapData prefilteredMap;
+    Texture2DData brdfLUT;
+    if (needCubemap) {
+        // Step 2: Convert equirectangular to cubemap
+        envCubemap = compute ? compute->ConvertEquirectToCubemap(ibl, envSize) : ibl.ConvertEquirectToCubemap(envSize);
+
+        // Step 3: Project the irradiance onto spherical harmonics, one pass over the cubemap,
+        // and build the mip chain the prefilter samples from
+        if (!envCubemap.data.empty()) {
+            if (bakeIrradiance) {
+                irradianceSH = ibl.ProjectIrradianceSH(envCubemap);
+            }
+            IBLPrecompute::GenerateMipChain(envCubemap);
+        }
 
-    // Step 4: Generate prefiltered environment map
-    auto prefilteredMap = ibl.GeneratePrefilteredMap(envCubemap, prefSize, prefMips, samples);
+        // Step 4: Generate prefiltered environment map
+        if (bakePrefiltered && !envCubemap.data.empty()) {
+            prefilteredMap = compute ? compute->GeneratePrefilteredMap(envCubemap, prefSize, prefMips, prefSamples)
+                                     : ibl.GeneratePrefilteredMap(envCubemap, prefSize, prefMips, prefSamples);
+        }
+    }
 
     // Step 5: Generate BRDF LUT (environment-independent, only needs to be done once)
-    auto brdfLUT = ibl.GenerateBRDFLUT(lutSize, samples);
+    if (bakeLUT) {
+        brdfLUT = compute ? compute->GenerateBRDFLUT(lutSize, samples) : ibl.GenerateBRDFLUT(lutSize, samples);
+    }
+    JobSystem::Shutdown();
 
-    // Step 6: Write output files
-    std::cout << "\nWriting output files...\n";
+    compute.reset();
+    device.reset();
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    if (gpu) {
+        SDL_Quit();
+    }
 
-    std::filesystem::path outPath(outputDir);
+    if ((needCubemap && envCubemap.data.empty()) || (bakePrefiltered && prefilteredMap.data.empty()) ||
+        (bakeLUT && brdfLUT.data.empty())) {
+        std::cerr << "Error: Failed to generate one or more maps\n";
+        return 1;
+    }
+
+    // Step 6: Write the outputs that were baked; each one's key is recorded once it is on disk
+    std::cout << "\nWriting output files...\n";
 
     bool success = true;
-    success &= DDSWriter::WriteCubemap((outPath / "environment.dds").string(), envCubemap);
-    success &= DDSWriter::WriteCubemap((outPath / "irradiance.dds").string(), irradianceMap);
-    success &= DDSWriter::WriteCubemap((outPath / "prefiltered.dds").string(), prefilteredMap);
-    success &= DDSWriter::WriteTexture2D((outPath / "brdf_lut.dds").string(), brdfLUT, true); // 2-channel (RG)
+    auto record = [&](const char* artifact, uint64 key, bool written) {
+        if (written) {
+            cache.Set(artifact, key);
+        }
+        success &= written;
+    };
+    if (bakeEnvironment) {
+        record("environment.dds", environmentKey, DDSWriter::WriteCubemap((outPath / "environment.dds").string(), envCubemap));
+    }
+    if (bakeIrradiance) {
+        record("irradiance_sh.txt", irradianceKey, irradianceSH.Save((outPath / "irradiance_sh.txt").string()));
+    }
+    if (bakePrefiltered) {
+        record("prefiltered.dds", prefilteredKey, DDSWriter::WriteCubemap((outPath / "prefiltered.dds").string(), prefilteredMap));
+    }
+    if (copyLUT) {
+        std::filesystem::path lutPath = (lutCache ? lutCache->GetDirectory() : outPath) / "brdf_lut.dds";
+        bool written = true;
+        if (bakeLUT) {
+            written = DDSWriter::WriteTexture2D(lutPath.string(), brdfLUT, true); // 2-channel (RG)
+            if (written && lutCache) {
+                lutCache->Set("brdf_lut.dds", lutKey);
+                written = lutCache->Save();
+            }
+        }
+        std::error_code ec;
+        if (written && lutCache && !std::filesystem::equivalent(lutPath, outPath / "brdf_lut.dds", ec)) {
+            written = std::filesystem::copy_file(lutPath, outPath / "brdf_lut.dds",
+                                                 std::filesystem::copy_options::overwrite_existing, ec);
+        }
+        record("brdf_lut.dds", lutKey, written);
+    }
+    success &= cache.Save();
 
+    auto status = [](bool baked) { return baked ? "" : " (up to date)"; };
     if (success) {
         std::cout << "\n========================================\n";
         std::cout << "IBL Precomputation Complete!\n";
         std::cout << "========================================\n";
         std::cout << "Output files written to: " << outputDir << "\n";
-        std::cout << "  - environment.dds    (" << (envSize * envSize * 6 * 4 * 2 / 1024) << " KB)\n";
-        std::cout << "  - irradiance.dds     (" << (irrSize * irrSize * 6 * 4 * 2 / 1024) << " KB)\n";
-        std::cout << "  - prefiltered.dds    (varies, ~" << (prefSize * prefSize * 6 * 4 * 2 / 1024) << " KB)\n";
-        std::cout << "  - brdf_lut.dds       (" << (lutSize * lutSize * 2 * 2 / 1024) << " KB)\n";
+        std::cout << "  - environment.dds    (" << (envSize * envSize * 6 * 4 * 2 / 1024) << " KB)" << status(bakeEnvironment) << "\n";
+        std::cout << "  - irradiance_sh.txt  (" << utils::SH_COEFFICIENT_COUNT << " coefficients)" << status(bakeIrradiance) << "\n";
+        std::cout << "  - prefiltered.dds    (varies, ~" << (prefSize * prefSize * 6 * 4 * 2 / 1024) << " KB)" << status(bakePrefiltered) << "\n";
+        std::cout << "  - brdf_lut.dds       (" << (lutSize * lutSize * 2 * 2 / 1024) << " KB)" << status(copyLUT)
+                  << (copyLUT && !bakeLUT ? " (copied from --shared-lut)" : "") << "\n";
         std::cout << "\nYou can now load these textures in MetaGFX using utils::LoadDDSCubemap()\n";
         return 0;
     } else {
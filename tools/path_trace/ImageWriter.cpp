@@ -0,0 +1,214 @@
+// ============================================================================
+// tools/path_trace/ImageWriter.cpp
+// ============================================================================
+#include "ImageWriter.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+// Little-endian appenders; EXR is little-endian throughout
+void PutU32(std::vector<uint8>& out, uint32 value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<uint8>(value >> (8 * i)));
+    }
+}
+
+void PutU64(std::vector<uint8>& out, uint64 value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<uint8>(value >> (8 * i)));
+    }
+}
+
+void PutFloat(std::vector<uint8>& out, float value) {
+    uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    PutU32(out, bits);
+}
+
+void PutString(std::vector<uint8>& out, const char* text) {
+    out.insert(out.end(), text, text + std::strlen(text) + 1);
+}
+
+// EXR header attribute: name, type, size, value
+void PutAttribute(std::vector<uint8>& out, const char* name, const char* type, const std::vector<uint8>& value) {
+    PutString(out, name);
+    PutString(out, type);
+    PutU32(out, static_cast<uint32>(value.size()));
+    out.insert(out.end(), value.begin(), value.end());
+}
+
+// PNG is big-endian
+void PutU32BigEndian(std::vector<uint8>& out, uint32 value) {
+    for (int i = 3; i >= 0; --i) {
+        out.push_back(static_cast<uint8>(value >> (8 * i)));
+    }
+}
+
+uint32 Crc32(const uint8* data, size_t size, uint32 crc = 0) {
+    static const std::array<uint32, 256> table = []() {
+        std::array<uint32, 256> values{};
+        for (uint32 n = 0; n < 256; ++n) {
+            uint32 c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1u) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[n] = c;
+        }
+        return values;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFFu] ^ (crc >> 8);
+    }
+    return ~crc;
+}
+
+void PutChunk(std::vector<uint8>& out, const char* type, const std::vector<uint8>& data) {
+    PutU32BigEndian(out, static_cast<uint32>(data.size()));
+    size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    PutU32BigEndian(out, Crc32(out.data() + typeOffset, 4 + data.size()));
+}
+
+bool WriteFile(const std::string& filepath, const std::vector<uint8>& bytes) {
+    std::ofstream file(filepath, std::ios::binary);
+    if (!file) {
+        std::cerr << "Error: Cannot open " << filepath << " for writing" << std::endl;
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+} // namespace
+
+bool ImageWriter::WriteEXR(const std::string& filepath, const std::vector<glm::vec3>& pixels, uint32 width,
+                           uint32 height) {
+    if (width == 0 || height == 0 || pixels.size() < static_cast<size_t>(width) * height) {
+        return false;
+    }
+    std::vector<uint8> out;
+    PutU32(out, 20000630u);  // Magic
+    PutU32(out, 2u);         // Version 2, scanline, short names
+
+    // Channels in alphabetical order: B, G, R, each FLOAT (2), linear, unsampled
+    std::vector<uint8> channels;
+    for (const char* name : { "B", "G", "R" }) {
+        PutString(channels, name);
+        PutU32(channels, 2u);  // Pixel type FLOAT
+        PutU32(channels, 0u);  // pLinear and reserved
+        PutU32(channels, 1u);  // x sampling
+        PutU32(channels, 1u);  // y sampling
+    }
+    channels.push_back(0);
+    PutAttribute(out, "channels", "chlist", channels);
+    PutAttribute(out, "compression", "compression", { 0 });  // NO_COMPRESSION
+
+    std::vector<uint8> window;
+    PutU32(window, 0u);
+    PutU32(window, 0u);
+    PutU32(window, width - 1);
+    PutU32(window, height - 1);
+    PutAttribute(out, "dataWindow", "box2i", window);
+    PutAttribute(out, "displayWindow", "box2i", window);
+    PutAttribute(out, "lineOrder", "lineOrder", { 0 });  // INCREASING_Y
+
+    std::vector<uint8> aspect;
+    PutFloat(aspect, 1.0f);
+    PutAttribute(out, "pixelAspectRatio", "float", aspect);
+    std::vector<uint8> center;
+    PutFloat(center, 0.0f);
+    PutFloat(center, 0.0f);
+    PutAttribute(out, "screenWindowCenter", "v2f", center);
+    std::vector<uint8> windowWidth;
+    PutFloat(windowWidth, 1.0f);
+    PutAttribute(out, "screenWindowWidth", "float", windowWidth);
+    out.push_back(0);  // End of header
+
+    // Offset table: one scanline per block without compression, each block its y,
+    // its size and the row's channels one after another
+    uint64 rowSize = static_cast<uint64>(width) * 3 * sizeof(float);
+    uint64 blockStart = out.size() + static_cast<uint64>(height) * sizeof(uint64);
+    for (uint32 y = 0; y < height; ++y) {
+        PutU64(out, blockStart + y * (8 + rowSize));
+    }
+    out.reserve(out.size() + height * (8 + rowSize));
+    for (uint32 y = 0; y < height; ++y) {
+        PutU32(out, y);
+        PutU32(out, static_cast<uint32>(rowSize));
+        const glm::vec3* row = &pixels[static_cast<size_t>(y) * width];
+        for (int channel = 2; channel >= 0; --channel) {
+            for (uint32 x = 0; x < width; ++x) {
+                PutFloat(out, row[x][channel]);
+            }
+        }
+    }
+    return WriteFile(filepath, out);
+}
+
+bool ImageWriter::WritePNG(const std::string& filepath, const std::vector<glm::vec3>& pixels, uint32 width,
+                           uint32 height, float exposure) {
+    if (width == 0 || height == 0 || pixels.size() < static_cast<size_t>(width) * height) {
+        return false;
+    }
+
+    // Filter type 0 (none) ahead of each row
+    std::vector<uint8> raw;
+    raw.reserve(static_cast<size_t>(height) * (width * 3 + 1));
+    for (uint32 y = 0; y < height; ++y) {
+        raw.push_back(0);
+        for (uint32 x = 0; x < width; ++x) {
+            const glm::vec3& pixel = pixels[static_cast<size_t>(y) * width + x];
+            for (int channel = 0; channel < 3; ++channel) {
+                float c = std::max(pixel[channel] * exposure, 0.0f);
+                c = std::clamp((c * (2.51f * c + 0.03f)) / (c * (2.43f * c + 0.59f) + 0.14f), 0.0f, 1.0f);
+                c = c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f;
+                raw.push_back(static_cast<uint8>(std::lround(c * 255.0f)));
+            }
+        }
+    }
+
+    // zlib stream of stored deflate blocks (at most 65535 bytes each) and the Adler-32
+    std::vector<uint8> zlib = { 0x78, 0x01 };
+    for (size_t offset = 0; offset < raw.size();) {
+        size_t size = std::min<size_t>(raw.size() - offset, 65535);
+        bool last = offset + size == raw.size();
+        zlib.push_back(last ? 1 : 0);
+        zlib.push_back(static_cast<uint8>(size));
+        zlib.push_back(static_cast<uint8>(size >> 8));
+        zlib.push_back(static_cast<uint8>(~size));
+        zlib.push_back(static_cast<uint8>(~size >> 8));
+        zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+        offset += size;
+    }
+    uint32 a = 1, b = 0;
+    for (uint8 value : raw) {
+        a = (a + value) % 65521u;
+        b = (b + a) % 65521u;
+    }
+    PutU32BigEndian(zlib, (b << 16) | a);
+
+    std::vector<uint8> out = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    std::vector<uint8> header;
+    PutU32BigEndian(header, width);
+    PutU32BigEndian(header, height);
+    header.insert(header.end(), { 8, 2, 0, 0, 0 });  // 8-bit RGB, deflate, adaptive filters, no interlace
+    PutChunk(out, "IHDR", header);
+    PutChunk(out, "sRGB", { 0 });  // Perceptual intent
+    PutChunk(out, "IDAT", zlib);
+    PutChunk(out, "IEND", {});
+    return WriteFile(filepath, out);
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,29 @@
+// ============================================================================
+// tools/path_trace/ImageWriter.h - EXR and PNG Writers
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+// Writers for the path tracer's output, without an image library: the EXR is scanline
+// OpenEXR with 32-bit float channels and no compression, the PNG 8-bit RGB stored in
+// uncompressed deflate blocks. Both read width * height pixels, rows top to bottom.
+class ImageWriter {
+public:
+    // Linear RGB as it is
+    static bool WriteEXR(const std::string& filepath, const std::vector<glm::vec3>& pixels, uint32 width,
+                         uint32 height);
+
+    // Scaled by exposure, ACES tone mapped (model.frag's curve) and sRGB encoded
+    static bool WritePNG(const std::string& filepath, const std::vector<glm::vec3>& pixels, uint32 width,
+                         uint32 height, float exposure);
+};
+
+} // namespace tools
+} // namespace metagfx
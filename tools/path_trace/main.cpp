@@ -0,0 +1,203 @@
+// ============================================================================
+// tools/path_trace/main.cpp - Headless CPU Path Tracer Entry Point
+// ============================================================================
+#include "ImageWriter.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/SimdMath.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/scene/CpuPathTracer.h"
+#include "metagfx/scene/Light.h"
+#include "metagfx/scene/Model.h"
+#include "metagfx/scene/ModelCache.h"
+#include "metagfx/utils/TextureUtils.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX CPU Path Tracer\n";
+    std::cout << "=======================\n\n";
+    std::cout << "Usage: " << programName << " <model> [options]\n\n";
+    std::cout << "Arguments:\n";
+    std::cout << "  model        Model file (glTF, GLB, OBJ, FBX, ...) to render, framed whole\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --output <file>           .exr (linear float) or .png (tone mapped) (default: render.exr)\n";
+    std::cout << "  --width <pixels>          Image width (default: 1280)\n";
+    std::cout << "  --height <pixels>         Image height (default: 720)\n";
+    std::cout << "  --spp <count>             Samples per pixel (default: 64)\n";
+    std::cout << "  --bounces <count>         Surface hits after the camera ray's (default: 4)\n";
+    std::cout << "  --yaw <degrees>           Camera angle around the model (default: 30)\n";
+    std::cout << "  --pitch <degrees>         Camera angle above the model (default: 20)\n";
+    std::cout << "  --fov <degrees>           Vertical field of view (default: 45)\n";
+    std::cout << "  --environment <hdr>       Equirectangular .hdr lighting the scene (default: uniform sky)\n";
+    std::cout << "  --env-intensity <scale>   Environment multiplier (default: 1)\n";
+    std::cout << "  --sun-intensity <value>   Directional light from above, 0 for none (default: 3)\n";
+    std::cout << "  --exposure <scale>        PNG only: applied before tone mapping (default: 1)\n";
+    std::cout << "  --threads <count>         Threads to build and trace on, 1 for none (default: all cores)\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " assets/models/DamagedHelmet/DamagedHelmet.gltf --spp 256 --output helmet.exr\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    std::string modelPath;
+    std::string output = "render.exr";
+    std::string environment;
+    uint32 width = 1280;
+    uint32 height = 720;
+    uint32 threads = 0;
+    float yaw = 30.0f;
+    float pitch = 20.0f;
+    float fov = 45.0f;
+    float environmentIntensity = 1.0f;
+    float sunIntensity = 3.0f;
+    float exposure = 1.0f;
+    CpuPathTracer::Settings settings;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--output" && i + 1 < argc) {
+            output = argv[++i];
+        } else if (arg == "--width" && i + 1 < argc) {
+            width = std::atoi(argv[++i]);
+        } else if (arg == "--height" && i + 1 < argc) {
+            height = std::atoi(argv[++i]);
+        } else if (arg == "--spp" && i + 1 < argc) {
+            settings.samplesPerPixel = std::atoi(argv[++i]);
+        } else if (arg == "--bounces" && i + 1 < argc) {
+            settings.maxBounces = std::atoi(argv[++i]);
+        } else if (arg == "--yaw" && i + 1 < argc) {
+            yaw = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--pitch" && i + 1 < argc) {
+            pitch = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--fov" && i + 1 < argc) {
+            fov = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--environment" && i + 1 < argc) {
+            environment = argv[++i];
+        } else if (arg == "--env-intensity" && i + 1 < argc) {
+            environmentIntensity = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--sun-intensity" && i + 1 < argc) {
+            sunIntensity = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--exposure" && i + 1 < argc) {
+            exposure = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::atoi(argv[++i]);
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else {
+            modelPath = arg;
+        }
+    }
+
+    if (modelPath.empty() || !std::filesystem::exists(modelPath)) {
+        std::cerr << "Error: Model file does not exist: " << modelPath << std::endl;
+        return 1;
+    }
+    std::string extension = std::filesystem::path(output).extension().string();
+    if (extension != ".exr" && extension != ".png") {
+        std::cerr << "Error: Output must be .exr or .png: " << output << std::endl;
+        return 1;
+    }
+    if (width == 0 || height == 0) {
+        std::cerr << "Error: Image size must not be zero" << std::endl;
+        return 1;
+    }
+
+    // The BVH build and the tiles spread over every core; the calling thread takes part
+    if (threads != 1) {
+        JobSystemDesc jobDesc;
+        jobDesc.workerCount = threads > 1 ? threads - 1 : 0;
+        JobSystem::Init(jobDesc);
+    }
+    std::cout << "Threads: " << JobSystem::GetWorkerCount() + 1 << " (" << simd::GetInstructionSet() << ")\n";
+
+    // The import Model::LoadFromFile runs, so the mesh cache is shared with the viewer
+    ModelImporter importer;
+    ModelData model;
+    CpuPathTracer tracer;
+    if (!importer.Import(modelPath, model) || !tracer.Build(model, modelPath)) {
+        std::cerr << "Error: Failed to load " << modelPath << std::endl;
+        JobSystem::Shutdown();
+        return 1;
+    }
+
+    if (!environment.empty()) {
+        utils::HDRImageData image = utils::LoadHDRImage(environment, 3);
+        if (!image.pixels) {
+            std::cerr << "Error: Failed to load environment " << environment << std::endl;
+            JobSystem::Shutdown();
+            return 1;
+        }
+        tracer.SetEnvironmentMap(std::vector<float>(image.pixels, image.pixels + size_t(image.width) * image.height * 3),
+                                 image.width, image.height, environmentIntensity);
+        utils::FreeHDRImage(image);
+    }
+    if (sunIntensity > 0.0f) {
+        DirectionalLight sun(glm::vec3(-0.3f, -1.0f, -0.2f), glm::vec3(1.0f), sunIntensity);
+        tracer.SetLights({ sun.ToGPUData() });
+    }
+
+    // Frame the model's bounds: its bounding sphere fills the vertical field of view
+    glm::vec3 boundsMin(std::numeric_limits<float>::max());
+    glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+    std::vector<glm::mat4> world(model.nodes.size(), glm::mat4(1.0f));
+    for (size_t i = 0; i < model.nodes.size(); ++i) {
+        const NodeData& node = model.nodes[i];
+        world[i] = node.parent == NodeData::NO_PARENT ? node.localTransform : world[node.parent] * node.localTransform;
+    }
+    for (const MeshData& mesh : model.meshes) {
+        glm::mat4 transform = mesh.node < world.size() ? world[mesh.node] : glm::mat4(1.0f);
+        glm::vec3 meshMin, meshMax;
+        simd::TransformBox(transform, mesh.boundsMin, mesh.boundsMax, meshMin, meshMax);
+        boundsMin = glm::min(boundsMin, meshMin);
+        boundsMax = glm::max(boundsMax, meshMax);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = std::max(glm::length(boundsMax - boundsMin) * 0.5f, 0.001f);
+    float fovRadians = glm::radians(fov);
+    float distance = radius / std::sin(fovRadians * 0.5f);
+    glm::vec3 direction(std::cos(glm::radians(pitch)) * std::sin(glm::radians(yaw)), std::sin(glm::radians(pitch)),
+                        std::cos(glm::radians(pitch)) * std::cos(glm::radians(yaw)));
+
+    CpuPathTracer::View view;
+    view.cameraPosition = center + direction * distance;
+    glm::mat4 viewMatrix = glm::lookAt(view.cameraPosition, center, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 projection = glm::perspective(fovRadians, static_cast<float>(width) / static_cast<float>(height),
+                                            distance * 0.01f, distance + radius * 2.0f);
+    view.viewProjection = projection * viewMatrix;
+
+    std::cout << "Rendering " << width << "x" << height << ", " << settings.samplesPerPixel << " spp, "
+              << settings.maxBounces << " bounces..." << std::endl;
+    std::vector<glm::vec3> pixels;
+    tracer.Render(view, settings, width, height, pixels);
+
+    const CpuPathTracer::Stats& stats = tracer.GetStats();
+    double seconds = stats.renderMs / 1000.0;
+    std::cout << "Rendered in " << seconds << " s (" << (seconds > 0.0 ? stats.rayCount / seconds / 1.0e6 : 0.0)
+              << " Mrays/s); BVH of " << stats.triangleCount << " triangles built in " << stats.buildMs << " ms\n";
+
+    bool written = extension == ".exr" ? ImageWriter::WriteEXR(output, pixels, width, height)
+                                       : ImageWriter::WritePNG(output, pixels, width, height, exposure);
+    JobSystem::Shutdown();
+    if (!written) {
+        std::cerr << "Error: Failed to write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << output << std::endl;
+    return 0;
+}
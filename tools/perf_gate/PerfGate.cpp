@@ -0,0 +1,503 @@
+// ============================================================================
+// tools/perf_gate/PerfGate.cpp - Performance Regression Gate
+// ============================================================================
+#include "PerfGate.h"
+#include "metagfx/utils/Json.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+// Exact U distributions are counted up to this many samples in total
+constexpr size_t EXACT_TEST_SAMPLES = 40;
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void WriteSamples(std::ofstream& out, const std::vector<double>& samples) {
+    out << "[";
+    for (size_t i = 0; i < samples.size(); ++i) {
+        out << (i ? ", " : "") << samples[i];
+    }
+    out << "]";
+}
+
+bool ReadJson(const std::filesystem::path& path, utils::JsonValue& document, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        error = "cannot open " + path.string();
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string parseError;
+    if (!utils::JsonValue::Parse(text.data(), text.size(), document, &parseError)) {
+        error = path.string() + ": " + parseError;
+        return false;
+    }
+    return true;
+}
+
+double Median(std::vector<double> values) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+const char* GetExecutableName(const std::string& kind) {
+    if (kind == "frame") {
+        return "metagfx_bench";
+    } else if (kind == "rhi") {
+        return "metagfx_rhi_bench";
+    } else if (kind == "asset") {
+        return "metagfx_asset_bench";
+    }
+    return nullptr;
+}
+
+// In the bin directory itself, its tools/ or its parent: metagfx_bench lives in bin/
+// and the tools in bin/tools
+std::filesystem::path FindExecutable(const std::filesystem::path& binDirectory, const std::string& name) {
+#ifdef _WIN32
+    std::string file = name + ".exe";
+#else
+    std::string file = name;
+#endif
+    for (const std::filesystem::path& directory :
+         { binDirectory, binDirectory / "tools", binDirectory.parent_path() }) {
+        std::error_code error;
+        if (std::filesystem::is_regular_file(directory / file, error)) {
+            return directory / file;
+        }
+    }
+    return {};
+}
+
+std::string Quote(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+GateMetric* FindMetric(std::vector<GateMetric>& metrics, const std::string& name) {
+    auto it = std::find_if(metrics.begin(), metrics.end(), [&](const GateMetric& m) { return m.name == name; });
+    return it != metrics.end() ? &*it : nullptr;
+}
+
+} // anonymous namespace
+
+bool LoadBaseline(const std::string& path, GateBaseline& baseline, std::string& error) {
+    utils::JsonValue document;
+    if (!ReadJson(path, document, error)) {
+        return false;
+    }
+    baseline = GateBaseline{};
+    baseline.profile = document["profile"].AsString();
+    baseline.timestamp = document["timestamp"].AsString();
+    baseline.device = document["device"].AsString();
+    baseline.backend = document["backend"].AsString();
+    baseline.runs = static_cast<uint32>(document["runs"].AsInt(0));
+
+    for (const utils::JsonValue& entry : document["benchmarks"].GetArray()) {
+        GateBenchmark benchmark;
+        benchmark.name = entry["name"].AsString();
+        benchmark.kind = entry["kind"].AsString();
+        if (benchmark.name.empty() || !GetExecutableName(benchmark.kind)) {
+            error = path + ": each benchmark needs a name and a kind of frame, rhi or asset";
+            return false;
+        }
+        for (const utils::JsonValue& arg : entry["args"].GetArray()) {
+            benchmark.args.push_back(arg.AsString());
+        }
+        for (const utils::JsonValue& value : entry["metrics"].GetArray()) {
+            GateMetric metric;
+            metric.name = value["name"].AsString();
+            metric.unit = value["unit"].AsString();
+            metric.higherIsBetter = value["higherIsBetter"].AsBool();
+            for (const utils::JsonValue& sample : value["samples"].GetArray()) {
+                metric.samples.push_back(sample.AsNumber());
+            }
+            benchmark.metrics.push_back(std::move(metric));
+        }
+        baseline.benchmarks.push_back(std::move(benchmark));
+    }
+    if (baseline.benchmarks.empty()) {
+        error = path + ": no benchmarks";
+        return false;
+    }
+    return true;
+}
+
+bool WriteBaseline(const std::string& path, const GateBaseline& baseline) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"profile\": ";
+    WriteJsonString(out, baseline.profile);
+    out << ",\n  \"timestamp\": ";
+    WriteJsonString(out, baseline.timestamp);
+    out << ",\n  \"device\": ";
+    WriteJsonString(out, baseline.device);
+    out << ",\n  \"backend\": ";
+    WriteJsonString(out, baseline.backend);
+    out << ",\n  \"runs\": " << baseline.runs << ",\n  \"benchmarks\": [";
+    for (size_t b = 0; b < baseline.benchmarks.size(); ++b) {
+        const GateBenchmark& benchmark = baseline.benchmarks[b];
+        out << (b ? ",\n    { " : "\n    { ") << "\"name\": ";
+        WriteJsonString(out, benchmark.name);
+        out << ", \"kind\": \"" << benchmark.kind << "\", \"args\": [";
+        for (size_t i = 0; i < benchmark.args.size(); ++i) {
+            out << (i ? ", " : "");
+            WriteJsonString(out, benchmark.args[i]);
+        }
+        out << "],\n      \"metrics\": [";
+        for (size_t m = 0; m < benchmark.metrics.size(); ++m) {
+            const GateMetric& metric = benchmark.metrics[m];
+            out << (m ? ",\n        { " : "\n        { ") << "\"name\": ";
+            WriteJsonString(out, metric.name);
+            out << ", \"unit\": ";
+            WriteJsonString(out, metric.unit);
+            out << ", \"higherIsBetter\": " << (metric.higherIsBetter ? "true" : "false") << ", \"samples\": ";
+            WriteSamples(out, metric.samples);
+            out << " }";
+        }
+        out << " ] }";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+bool RunBenchmark(const GateSettings& settings, GateBenchmark& benchmark, uint32 run, std::string& device,
+                  std::string& backend) {
+    std::filesystem::path executable = FindExecutable(settings.binDirectory, GetExecutableName(benchmark.kind));
+    if (executable.empty()) {
+        std::cerr << "Error: " << GetExecutableName(benchmark.kind) << " not found next to "
+                  << settings.binDirectory.string() << " (see --bin)\n";
+        return false;
+    }
+    std::error_code error;
+    std::filesystem::create_directories(settings.workDirectory, error);
+    std::string stem = benchmark.name + "_" + std::to_string(run + 1);
+    std::filesystem::path output = settings.workDirectory / (stem + ".json");
+    std::filesystem::path log = settings.workDirectory / (stem + ".log");
+    std::filesystem::remove(output, error);
+
+    std::string command = Quote(executable.string());
+    for (const std::string& arg : benchmark.args) {
+        command += " " + Quote(arg);
+    }
+    command += " --output " + Quote(output.string()) + " > " + Quote(log.string()) + " 2>&1";
+#ifdef _WIN32
+    // cmd.exe strips the outer quotes of a command line that starts with one
+    command = "\"" + command + "\"";
+#endif
+    int status = std::system(command.c_str());
+    if (status != 0) {
+        std::cerr << "Error: " << benchmark.name << " run " << run + 1 << " failed (status " << status << "), see "
+                  << log.string() << "\n";
+        return false;
+    }
+
+    utils::JsonValue results;
+    std::string readError;
+    if (!ReadJson(output, results, readError)) {
+        std::cerr << "Error: " << benchmark.name << " run " << run + 1 << ": " << readError << "\n";
+        return false;
+    }
+    std::vector<GateMetric> found;
+    if (!ExtractMetrics(benchmark.kind, results, found)) {
+        std::cerr << "Error: " << benchmark.name << " run " << run + 1 << " reported no metrics\n";
+        return false;
+    }
+    if (device.empty()) {
+        device = results["device"].AsString();
+        backend = results["backend"].AsString();
+    }
+    for (GateMetric& metric : found) {
+        GateMetric* existing = FindMetric(benchmark.metrics, metric.name);
+        if (!existing) {
+            benchmark.metrics.push_back({ metric.name, metric.unit, metric.higherIsBetter, {} });
+            existing = &benchmark.metrics.back();
+        }
+        existing->samples.push_back(metric.samples.front());
+    }
+    return true;
+}
+
+bool ExtractMetrics(const std::string& kind, const utils::JsonValue& results, std::vector<GateMetric>& metrics) {
+    if (kind == "frame") {
+        for (const char* times : { "cpuFrameMs", "gpuFrameMs" }) {
+            const utils::JsonValue& value = results[times];
+            for (const char* percentile : { "p50", "p95", "p99" }) {
+                if (value[percentile].IsNumber()) {
+                    metrics.push_back({ std::string(times) + "." + percentile, "ms", false,
+                                        { value[percentile].AsNumber() } });
+                }
+            }
+        }
+    } else if (kind == "rhi") {
+        for (const utils::JsonValue& result : results["results"].GetArray()) {
+            if (result["median"].IsNumber()) {
+                metrics.push_back({ result["name"].AsString(), result["unit"].AsString(),
+                                    result["higherIsBetter"].AsBool(), { result["median"].AsNumber() } });
+            }
+        }
+    } else if (kind == "asset") {
+        for (const utils::JsonValue& result : results["results"].GetArray()) {
+            std::string prefix = result["name"].AsString() + "/" + result["mode"].AsString() + "/";
+            for (const utils::JsonValue& stage : result["stages"].GetArray()) {
+                if (stage["median"].IsNumber()) {
+                    metrics.push_back({ prefix + stage["name"].AsString(), "ms", false, { stage["median"].AsNumber() } });
+                }
+            }
+        }
+    }
+    return !metrics.empty();
+}
+
+double MannWhitneyGreaterP(const std::vector<double>& a, const std::vector<double>& b) {
+    size_t n1 = a.size();
+    size_t n2 = b.size();
+    if (n1 == 0 || n2 == 0) {
+        return 1.0;
+    }
+
+    // U of b: the pairs where b is larger, ties counting half
+    double u = 0.0;
+    bool ties = false;
+    for (double x : a) {
+        for (double y : b) {
+            u += y > x ? 1.0 : y == x ? 0.5 : 0.0;
+            ties = ties || y == x;
+        }
+    }
+    std::vector<double> all(a);
+    all.insert(all.end(), b.begin(), b.end());
+    std::sort(all.begin(), all.end());
+    for (size_t i = 1; i < all.size() && !ties; ++i) {
+        ties = all[i] == all[i - 1];
+    }
+
+    if (!ties && n1 + n2 <= EXACT_TEST_SAMPLES) {
+        // counts[j][k]: orderings of i samples of a and j of b with U = k, built up over i
+        size_t maxU = n1 * n2;
+        std::vector<std::vector<double>> counts(n2 + 1);
+        for (size_t j = 0; j <= n2; ++j) {
+            counts[j].assign(maxU + 1, 0.0);
+            counts[j][0] = 1.0;  // i = 0: one ordering, U = 0
+        }
+        for (size_t i = 1; i <= n1; ++i) {
+            std::vector<std::vector<double>> next(n2 + 1, std::vector<double>(maxU + 1, 0.0));
+            next[0][0] = 1.0;
+            for (size_t j = 1; j <= n2; ++j) {
+                // The largest sample is either from a, leaving U, or from b, above all i of a
+                for (size_t k = 0; k <= maxU; ++k) {
+                    next[j][k] = counts[j][k] + (k >= i ? next[j - 1][k - i] : 0.0);
+                }
+            }
+            counts.swap(next);
+        }
+        double total = 0.0;
+        double atLeast = 0.0;
+        size_t observed = static_cast<size_t>(u);
+        for (size_t k = 0; k <= maxU; ++k) {
+            total += counts[n2][k];
+            if (k >= observed) {
+                atLeast += counts[n2][k];
+            }
+        }
+        return total > 0.0 ? atLeast / total : 1.0;
+    }
+
+    // Normal approximation with the tie correction and a continuity correction
+    double n = static_cast<double>(n1 + n2);
+    double tieSum = 0.0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j] == all[i]) {
+            ++j;
+        }
+        double t = static_cast<double>(j - i);
+        tieSum += t * t * t - t;
+        i = j;
+    }
+    double mean = static_cast<double>(n1 * n2) / 2.0;
+    double variance = static_cast<double>(n1 * n2) / 12.0 * ((n + 1.0) - tieSum / (n * (n - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    double z = (u - mean - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+std::vector<MetricComparison> Compare(const GateBaseline& baseline, const GateBaseline& current,
+                                      const GateSettings& settings) {
+    std::vector<MetricComparison> comparisons;
+    for (const GateBenchmark& base : baseline.benchmarks) {
+        auto run = std::find_if(current.benchmarks.begin(), current.benchmarks.end(),
+                                [&](const GateBenchmark& b) { return b.name == base.name; });
+        if (run == current.benchmarks.end()) {
+            continue;  // Filtered out
+        }
+        for (const GateMetric& metric : base.metrics) {
+            MetricComparison comparison;
+            comparison.benchmark = base.name;
+            comparison.baseline = metric;
+            comparison.baselineMedian = Median(metric.samples);
+            auto found = std::find_if(run->metrics.begin(), run->metrics.end(),
+                                      [&](const GateMetric& m) { return m.name == metric.name; });
+            if (found == run->metrics.end() || found->samples.empty()) {
+                comparison.current.name = metric.name;
+                comparison.status = MetricStatus::Missing;
+                comparisons.push_back(std::move(comparison));
+                continue;
+            }
+            comparison.current = *found;
+            comparison.currentMedian = Median(found->samples);
+
+            const std::vector<double>& before = metric.samples;
+            const std::vector<double>& after = found->samples;
+            if (metric.higherIsBetter) {
+                comparison.pWorse = MannWhitneyGreaterP(after, before);
+                comparison.pBetter = MannWhitneyGreaterP(before, after);
+            } else {
+                comparison.pWorse = MannWhitneyGreaterP(before, after);
+                comparison.pBetter = MannWhitneyGreaterP(after, before);
+            }
+            if (comparison.baselineMedian != 0.0) {
+                double change = (comparison.currentMedian - comparison.baselineMedian) / std::abs(comparison.baselineMedian);
+                comparison.changePercent = (metric.higherIsBetter ? -change : change) * 100.0;
+            }
+            if (comparison.pWorse < settings.alpha && comparison.changePercent > settings.thresholdPercent) {
+                comparison.status = MetricStatus::Regression;
+            } else if (comparison.pBetter < settings.alpha && comparison.changePercent < -settings.thresholdPercent) {
+                comparison.status = MetricStatus::Improvement;
+            }
+            comparisons.push_back(std::move(comparison));
+        }
+    }
+
+    // Regressions first, the largest first
+    std::stable_sort(comparisons.begin(), comparisons.end(), [](const MetricComparison& a, const MetricComparison& b) {
+        bool aRegressed = a.status == MetricStatus::Regression;
+        bool bRegressed = b.status == MetricStatus::Regression;
+        if (aRegressed != bRegressed) {
+            return aRegressed;
+        }
+        return a.changePercent > b.changePercent;
+    });
+    return comparisons;
+}
+
+bool WriteReport(const std::string& path, const GateBaseline& baseline, const GateBaseline& current,
+                 const GateSettings& settings, const std::vector<MetricComparison>& comparisons) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+    uint32 counts[4] = {};
+    for (const MetricComparison& comparison : comparisons) {
+        ++counts[static_cast<uint32>(comparison.status)];
+    }
+
+    out << std::fixed << std::setprecision(4);
+    out << "{\n  \"timestamp\": ";
+    WriteJsonString(out, current.timestamp);
+    out << ",\n  \"profile\": ";
+    WriteJsonString(out, baseline.profile);
+    out << ",\n  \"baselineTimestamp\": ";
+    WriteJsonString(out, baseline.timestamp);
+    out << ",\n  \"baselineDevice\": ";
+    WriteJsonString(out, baseline.device);
+    out << ",\n  \"device\": ";
+    WriteJsonString(out, current.device);
+    out << ",\n  \"backend\": ";
+    WriteJsonString(out, current.backend);
+    out << ",\n  \"runs\": " << current.runs << ",\n  \"thresholdPercent\": " << settings.thresholdPercent
+        << ",\n  \"alpha\": " << settings.alpha << ",\n  \"regressions\": "
+        << counts[static_cast<uint32>(MetricStatus::Regression)] << ",\n  \"improvements\": "
+        << counts[static_cast<uint32>(MetricStatus::Improvement)] << ",\n  \"missing\": "
+        << counts[static_cast<uint32>(MetricStatus::Missing)] << ",\n  \"metrics\": [";
+    for (size_t i = 0; i < comparisons.size(); ++i) {
+        const MetricComparison& comparison = comparisons[i];
+        out << (i ? ",\n    { " : "\n    { ") << "\"benchmark\": ";
+        WriteJsonString(out, comparison.benchmark);
+        out << ", \"metric\": ";
+        WriteJsonString(out, comparison.baseline.name);
+        out << ", \"unit\": ";
+        WriteJsonString(out, comparison.baseline.unit);
+        out << ", \"higherIsBetter\": " << (comparison.baseline.higherIsBetter ? "true" : "false")
+            << ", \"status\": \"" << GetStatusName(comparison.status) << "\",\n      \"baselineMedian\": "
+            << comparison.baselineMedian << ", \"currentMedian\": " << comparison.currentMedian
+            << ", \"changePercent\": " << comparison.changePercent << ", \"pWorse\": " << comparison.pWorse
+            << ", \"pBetter\": " << comparison.pBetter << ",\n      \"baselineSamples\": ";
+        WriteSamples(out, comparison.baseline.samples);
+        out << ", \"currentSamples\": ";
+        WriteSamples(out, comparison.current.samples);
+        out << " }";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+void PrintComparisons(const std::vector<MetricComparison>& comparisons) {
+    for (const MetricComparison& comparison : comparisons) {
+        std::ostringstream name;
+        name << comparison.benchmark << ": " << comparison.baseline.name;
+        std::cout << "  " << std::left << std::setw(12) << GetStatusName(comparison.status) << std::setw(48)
+                  << name.str() << std::right;
+        if (comparison.status != MetricStatus::Missing) {
+            std::cout << std::fixed << std::setprecision(3) << std::setw(12) << comparison.baselineMedian << " -> "
+                      << std::setw(12) << comparison.currentMedian << " " << std::left << std::setw(6)
+                      << comparison.baseline.unit << std::right << std::showpos << std::setprecision(1)
+                      << std::setw(8) << comparison.changePercent << std::noshowpos << "% worse, p "
+                      << std::setprecision(3)
+                      << (comparison.status == MetricStatus::Improvement ? comparison.pBetter : comparison.pWorse);
+        }
+        std::cout << "\n";
+    }
+}
+
+const char* GetStatusName(MetricStatus status) {
+    switch (status) {
+        case MetricStatus::Unchanged: return "unchanged";
+        case MetricStatus::Regression: return "regression";
+        case MetricStatus::Improvement: return "improvement";
+        case MetricStatus::Missing: return "missing";
+    }
+    return "unknown";
+}
+
+} // namespace tools
+} // namespace metagfx
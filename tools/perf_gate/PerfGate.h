@@ -0,0 +1,103 @@
+// ============================================================================
+// tools/perf_gate/PerfGate.h - Performance Regression Gate
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace utils {
+class JsonValue;
+}
+
+namespace tools {
+
+// One figure of a benchmark's results, with one sample per run
+struct GateMetric {
+    std::string name;            // e.g. "cpuFrameMs.p95", "texture_upload", "sponza/cold/import"
+    std::string unit;
+    bool higherIsBetter = false;
+    std::vector<double> samples;
+};
+
+// A benchmark executable and its arguments. kind picks the executable and how its
+// results are read:
+// - frame: metagfx_bench; the CPU and GPU frame-time p50, p95 and p99
+// - rhi: metagfx_rhi_bench; each test's median
+// - asset: metagfx_asset_bench; each load's median per stage
+struct GateBenchmark {
+    std::string name;
+    std::string kind;
+    std::vector<std::string> args;  // Without --output, which the gate adds
+    std::vector<GateMetric> metrics;
+};
+
+// A suite of benchmarks, and in a baseline the samples of one machine profile: the same
+// hardware, driver and backend as the runs compared against it
+struct GateBaseline {
+    std::string profile;
+    std::string timestamp;
+    std::string device;    // Of the first run
+    std::string backend;
+    uint32 runs = 0;
+    std::vector<GateBenchmark> benchmarks;
+};
+
+struct GateSettings {
+    uint32 runs = 5;                    // Of each benchmark
+    double thresholdPercent = 5.0;      // Smaller changes are never regressions
+    double alpha = 0.05;                // Of the one-sided Mann-Whitney U test
+    std::filesystem::path binDirectory; // Holding the benchmark executables (or its tools/)
+    std::filesystem::path workDirectory = "perf_gate_runs";  // Results and logs of each run
+};
+
+enum class MetricStatus { Unchanged, Regression, Improvement, Missing };
+
+// A metric of the baseline against the same metric of the current runs
+struct MetricComparison {
+    std::string benchmark;
+    GateMetric baseline;
+    GateMetric current;
+    double baselineMedian = 0.0;
+    double currentMedian = 0.0;
+    double changePercent = 0.0;  // Of the median; positive is worse, whichever way the metric improves
+    double pWorse = 1.0;         // That the current samples are no worse than the baseline's
+    double pBetter = 1.0;
+    MetricStatus status = MetricStatus::Unchanged;
+};
+
+// Suite and baseline files: {"profile", "benchmarks": [{"name", "kind", "args", "metrics"}]};
+// a suite has no metrics. False with a message on a malformed file.
+bool LoadBaseline(const std::string& path, GateBaseline& baseline, std::string& error);
+bool WriteBaseline(const std::string& path, const GateBaseline& baseline);
+
+// Runs benchmark once and appends each metric's figure to its samples, adding metrics
+// the first run finds. Sets device and backend from the results. False when the
+// executable is missing, fails or writes no results.
+bool RunBenchmark(const GateSettings& settings, GateBenchmark& benchmark, uint32 run, std::string& device,
+                  std::string& backend);
+
+// The metrics of a benchmark kind's results document, one sample each
+bool ExtractMetrics(const std::string& kind, const utils::JsonValue& results, std::vector<GateMetric>& metrics);
+
+// One-sided exact Mann-Whitney U test (normal approximation with tie correction for
+// large or tied samples): the probability of samples b at least as far above a as they
+// are, were both drawn from one distribution
+double MannWhitneyGreaterP(const std::vector<double>& a, const std::vector<double>& b);
+
+std::vector<MetricComparison> Compare(const GateBaseline& baseline, const GateBaseline& current,
+                                      const GateSettings& settings);
+
+// JSON of every comparison, regressions first
+bool WriteReport(const std::string& path, const GateBaseline& baseline, const GateBaseline& current,
+                 const GateSettings& settings, const std::vector<MetricComparison>& comparisons);
+void PrintComparisons(const std::vector<MetricComparison>& comparisons);
+
+const char* GetStatusName(MetricStatus status);
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,229 @@
+// ============================================================================
+// tools/perf_gate/main.cpp - Performance Regression Gate Entry Point
+// ============================================================================
+#include "PerfGate.h"
+#include "metagfx/core/Types.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+namespace {
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX Performance Regression Gate\n";
+    std::cout << "===================================\n\n";
+    std::cout << "Usage: " << programName << " --suite <file> --record <baseline> [options]\n";
+    std::cout << "       " << programName << " --baseline <baseline> [options]\n\n";
+    std::cout << "Runs metagfx_bench, metagfx_rhi_bench and metagfx_asset_bench several times each and\n";
+    std::cout << "records their figures as the baseline of a machine profile, or compares new runs\n";
+    std::cout << "with a baseline. A metric regresses when its median is worse by more than the\n";
+    std::cout << "threshold and a one-sided Mann-Whitney U test of the runs against the baseline's\n";
+    std::cout << "is significant. Exits with 1 on a regression or a failed run.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --suite <file>        Benchmarks to record (default: suite.json next to this tool)\n";
+    std::cout << "  --record <file>       Write the runs as a baseline\n";
+    std::cout << "  --profile <name>      Machine profile of the recorded baseline (default: the device)\n";
+    std::cout << "  --baseline <file>     Compare the runs of the baseline's benchmarks with it\n";
+    std::cout << "  --report <file>       Per-metric comparison as JSON (default: perf_gate_report.json)\n";
+    std::cout << "  --save-current <file> Also write the compared runs as a baseline\n";
+    std::cout << "  --runs <count>        Runs of each benchmark (default: 5)\n";
+    std::cout << "  --threshold <percent> Smallest change of a median that regresses (default: 5)\n";
+    std::cout << "  --alpha <p>           Significance level of the test (default: 0.05)\n";
+    std::cout << "  --filter <text>       Only the benchmarks whose name contains text\n";
+    std::cout << "  --bin <dir>           Directory of the benchmarks (default: this tool's)\n";
+    std::cout << "  --work <dir>          Results and logs of each run (default: perf_gate_runs)\n";
+    std::cout << "  --allow-device-change Compare even when the device is not the baseline's\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " --suite suite.json --record baselines/rtx4070_vulkan.json\n";
+    std::cout << "  " << programName << " --baseline baselines/rtx4070_vulkan.json --runs 7\n";
+}
+
+std::string GetTimestamp() {
+    std::time_t now = std::time(nullptr);
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return timestamp;
+}
+
+// The smallest p-value the test can give: 1 / C(n1 + n2, n1)
+double GetSmallestP(uint32 n1, uint32 n2) {
+    double orderings = 1.0;
+    for (uint32 i = 1; i <= n1; ++i) {
+        orderings = orderings * (n2 + i) / i;
+    }
+    return 1.0 / orderings;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    GateSettings settings;
+    settings.binDirectory = std::filesystem::absolute(argv[0]).parent_path();
+    std::string suitePath;
+    std::string recordPath;
+    std::string baselinePath;
+    std::string reportPath = "perf_gate_report.json";
+    std::string savePath;
+    std::string profile;
+    std::string filter;
+    bool allowDeviceChange = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (arg == "--suite" && i + 1 < argc) {
+            suitePath = argv[++i];
+        } else if (arg == "--record" && i + 1 < argc) {
+            recordPath = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            profile = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baselinePath = argv[++i];
+        } else if (arg == "--report" && i + 1 < argc) {
+            reportPath = argv[++i];
+        } else if (arg == "--save-current" && i + 1 < argc) {
+            savePath = argv[++i];
+        } else if (arg == "--runs" && i + 1 < argc) {
+            settings.runs = static_cast<uint32>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--threshold" && i + 1 < argc) {
+            settings.thresholdPercent = std::atof(argv[++i]);
+        } else if (arg == "--alpha" && i + 1 < argc) {
+            settings.alpha = std::atof(argv[++i]);
+        } else if (arg == "--filter" && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (arg == "--bin" && i + 1 < argc) {
+            settings.binDirectory = std::filesystem::absolute(argv[++i]);
+        } else if (arg == "--work" && i + 1 < argc) {
+            settings.workDirectory = argv[++i];
+        } else if (arg == "--allow-device-change") {
+            allowDeviceChange = true;
+        } else {
+            std::cerr << "Error: unknown option " << arg << "\n\n";
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    bool recording = !recordPath.empty();
+    if (recording == !baselinePath.empty()) {
+        std::cerr << "Error: give either --record or --baseline\n\n";
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    // The benchmarks to run: the suite's when recording, the baseline's when comparing
+    GateBaseline baseline;
+    std::string error;
+    if (recording) {
+        if (suitePath.empty()) {
+            suitePath = (settings.binDirectory / "suite.json").string();
+        }
+        if (!LoadBaseline(suitePath, baseline, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return 2;
+        }
+    } else if (!LoadBaseline(baselinePath, baseline, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return 2;
+    }
+
+    GateBaseline current;
+    current.profile = recording ? profile : baseline.profile;
+    current.timestamp = GetTimestamp();
+    current.runs = settings.runs;
+    for (const GateBenchmark& benchmark : baseline.benchmarks) {
+        if (filter.empty() || benchmark.name.find(filter) != std::string::npos) {
+            current.benchmarks.push_back({ benchmark.name, benchmark.kind, benchmark.args, {} });
+        }
+    }
+    if (current.benchmarks.empty()) {
+        std::cerr << "Error: no benchmark matches " << filter << "\n";
+        return 2;
+    }
+
+    if (!recording) {
+        uint32 baselineRuns = baseline.runs;
+        if (baselineRuns == 0 && !baseline.benchmarks.front().metrics.empty()) {
+            baselineRuns = static_cast<uint32>(baseline.benchmarks.front().metrics.front().samples.size());
+        }
+        if (GetSmallestP(baselineRuns, settings.runs) >= settings.alpha) {
+            std::cerr << "Warning: " << baselineRuns << " baseline and " << settings.runs
+                      << " current runs cannot reach p < " << settings.alpha << "; nothing can regress\n";
+        }
+    }
+
+    // Interleaved, so that a drift of the machine (thermals, background load) spreads over
+    // every benchmark instead of the last ones
+    bool failed = false;
+    for (uint32 run = 0; run < settings.runs; ++run) {
+        for (GateBenchmark& benchmark : current.benchmarks) {
+            std::cout << "Run " << run + 1 << "/" << settings.runs << ": " << benchmark.name << std::endl;
+            std::string device;
+            if (!RunBenchmark(settings, benchmark, run, device, current.backend)) {
+                failed = true;
+                continue;
+            }
+            if (current.device.empty()) {
+                current.device = device;
+            } else if (!device.empty() && device != current.device) {
+                std::cerr << "Warning: " << benchmark.name << " ran on " << device << ", not " << current.device
+                          << "\n";
+            }
+        }
+    }
+    std::cout << "\nDevice: " << current.device << " (" << current.backend << ")\n";
+
+    if (recording) {
+        if (current.profile.empty()) {
+            current.profile = current.device + " " + current.backend;
+        }
+        if (failed) {
+            std::cerr << "Error: not recording a baseline with failed runs\n";
+            return 1;
+        }
+        if (!WriteBaseline(recordPath, current)) {
+            return 1;
+        }
+        std::cout << "Baseline " << current.profile << " written to " << recordPath << "\n";
+        return 0;
+    }
+
+    if (current.device != baseline.device && !allowDeviceChange) {
+        std::cerr << "Error: the baseline " << baseline.profile << " was recorded on " << baseline.device
+                  << ", not " << current.device << " (see --allow-device-change)\n";
+        return 2;
+    }
+    if (!savePath.empty()) {
+        WriteBaseline(savePath, current);
+    }
+
+    std::vector<MetricComparison> comparisons = Compare(baseline, current, settings);
+    uint32 regressions = 0;
+    uint32 improvements = 0;
+    uint32 missing = 0;
+    for (const MetricComparison& comparison : comparisons) {
+        regressions += comparison.status == MetricStatus::Regression;
+        improvements += comparison.status == MetricStatus::Improvement;
+        missing += comparison.status == MetricStatus::Missing;
+    }
+
+    std::cout << "Baseline: " << baseline.profile << ", " << baseline.timestamp << "\n\n";
+    PrintComparisons(comparisons);
+    std::cout << "\n" << comparisons.size() << " metrics: " << regressions << " regressed, " << improvements
+              << " improved, " << missing << " missing (threshold " << settings.thresholdPercent << "%, alpha "
+              << settings.alpha << ")\n";
+    if (WriteReport(reportPath, baseline, current, settings, comparisons)) {
+        std::cout << "Report written to " << reportPath << "\n";
+    }
+    return regressions > 0 || failed ? 1 : 0;
+}
@@ -0,0 +1,638 @@
+// ============================================================================
+// tools/rhi_bench/RHIBench.cpp
+// ============================================================================
+#include "RHIBench.h"
+#include "metagfx/rhi/Buffer.h"
+#include "metagfx/rhi/CommandBuffer.h"
+#include "metagfx/rhi/DescriptorSet.h"
+#include "metagfx/rhi/Pipeline.h"
+#include "metagfx/rhi/Shader.h"
+#include "metagfx/rhi/SwapChain.h"
+#include "metagfx/rhi/Texture.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+
+// Compiled by metagfx_add_shaders(); without a GLSL compiler the tests that draw are skipped
+#if __has_include("bench.vert.spv.inl") && __has_include("bench.frag.spv.inl")
+#define METAGFX_HAS_BENCH_SHADERS 1
+#else
+#define METAGFX_HAS_BENCH_SHADERS 0
+#endif
+#if METAGFX_HAS_BENCH_SHADERS && __has_include("bench_multiview.vert.spv.inl")
+#define METAGFX_HAS_MULTIVIEW_SHADER 1
+#else
+#define METAGFX_HAS_MULTIVIEW_SHADER 0
+#endif
+
+namespace metagfx {
+namespace tools {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint64 MEGABYTE = 1024 * 1024;
+constexpr uint64 COPY_BUFFER_SIZE = 64 * MEGABYTE;
+constexpr uint64 COPY_CHUNK_SIZE = MEGABYTE;
+constexpr uint32 UPLOAD_TEXTURE_SIZE = 2048;
+constexpr uint32 TARGET_SIZE = 256;
+constexpr rhi::Format TARGET_FORMAT = rhi::Format::R8G8B8A8_UNORM;
+constexpr uint32 PASSES_PER_FRAME = 100;
+constexpr uint32 DRAWS_PER_FRAME = 10000;
+constexpr uint32 DRAW_GRID_CELLS = 64 * 64;  // Triangles bench.vert lays out before repeating
+constexpr uint32 STEREO_VIEWS = 2;
+
+// Must match BenchUniforms in bench.vert and bench.frag
+struct BenchUniforms {
+    float color[4] = { 0.2f, 0.4f, 0.8f, 1.0f };
+    float transform[4] = { 1.0f, 1.0f, 0.0f, 0.0f };  // xy: scale, zw: offset
+};
+
+double ElapsedUs(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+double MegabytesPerSecond(uint64 bytes, Clock::time_point start) {
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return seconds > 0.0 ? static_cast<double>(bytes) / MEGABYTE / seconds : 0.0;
+}
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // anonymous namespace
+
+RHIBench::RHIBench(Ref<rhi::GraphicsDevice> device, const BenchSettings& settings)
+    : m_Device(device)
+    , m_Settings(settings) {
+    m_Settings.repeats = std::max(m_Settings.repeats, 1u);
+}
+
+RHIBench::~RHIBench() {
+    if (m_Device) {
+        m_Device->WaitIdle();
+    }
+}
+
+std::vector<BenchResult> RHIBench::Run() {
+    m_Results.clear();
+    BenchBufferCreateDestroy();
+    BenchCopyData();
+    BenchTextureUpload();
+    BenchDescriptorUpdate();
+
+    static const char* DRAW_TESTS[] = { "pipeline_create_cold", "pipeline_create_cached", "empty_pass_record",
+                                        "empty_pass", "draw_submission_record", "draw_submission",
+                                        "stereo_two_passes", "stereo_multiview" };
+    bool drawTests = std::any_of(std::begin(DRAW_TESTS), std::end(DRAW_TESTS),
+                                 [this](const char* name) { return IsSelected(name); });
+    if (drawTests && !CreateDrawResources()) {
+        std::cerr << "Skipping the pipeline, pass and draw tests: "
+#if METAGFX_HAS_BENCH_SHADERS
+                  << "their resources could not be created\n";
+#else
+                  << "bench.vert and bench.frag have not been compiled\n";
+#endif
+    } else if (drawTests) {
+        BenchPipelineCreation();
+        BenchEmptyPass();
+        BenchDrawSubmission();
+        BenchMultiview();
+    }
+    return m_Results;
+}
+
+bool RHIBench::IsSelected(const char* name) const {
+    return m_Settings.filter.empty() || std::string(name).find(m_Settings.filter) != std::string::npos;
+}
+
+uint64 RHIBench::Iterations(uint64 count) const {
+    return std::max<uint64>(1, static_cast<uint64>(static_cast<double>(count) * m_Settings.scale));
+}
+
+void RHIBench::Measure(const char* name, const char* unit, bool higherIsBetter, uint64 iterations,
+                       const Test& test) {
+    if (!IsSelected(name)) {
+        return;
+    }
+
+    std::vector<double> values;
+    for (uint32 repeat = 0; repeat < m_Settings.repeats; ++repeat) {
+        // Every repeat starts with nothing of the last one in flight
+        m_Device->WaitIdle();
+        values.push_back(test());
+    }
+    std::sort(values.begin(), values.end());
+
+    BenchResult result;
+    result.name = name;
+    result.unit = unit;
+    result.higherIsBetter = higherIsBetter;
+    result.iterations = iterations;
+    result.median = values[values.size() / 2];
+    result.best = higherIsBetter ? values.back() : values.front();
+    m_Results.push_back(result);
+
+    std::cout << "  " << std::left << std::setw(26) << name << std::right << std::fixed << std::setprecision(3)
+              << std::setw(14) << result.median << " " << std::left << std::setw(8) << unit << std::right
+              << " (best " << result.best << ", " << iterations << " per run)\n";
+}
+
+void RHIBench::RunFrame(const std::function<void(rhi::CommandBuffer&, uint32 frameIndex)>& record) {
+    rhi::FrameContext frame = m_Device->BeginFrame();
+    frame.commandBuffer->Begin();
+    if (record) {
+        record(*frame.commandBuffer, frame.frameIndex);
+    }
+    frame.commandBuffer->End();
+    m_Device->SubmitCommandBuffer(frame.commandBuffer);
+    m_Device->GetSwapChain()->Present();
+}
+
+void RHIBench::FinishUploads(const std::function<bool()>& done) {
+    while (!done()) {
+        RunFrame(nullptr);
+    }
+    m_Device->WaitIdle();
+}
+
+// ----------------------------------------------------------------------------
+// Resources
+// ----------------------------------------------------------------------------
+
+void RHIBench::BenchBufferCreateDestroy() {
+    using namespace rhi;
+
+    BufferDesc desc{};
+    desc.size = 64 * 1024;
+    desc.usage = BufferUsage::Vertex | BufferUsage::TransferDst;
+    desc.memoryUsage = MemoryUsage::GPUOnly;
+    desc.debugName = "BenchBuffer";
+
+    uint64 count = Iterations(1000);
+    Measure("buffer_create_destroy", "us", false, count, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 i = 0; i < count; ++i) {
+            Ref<Buffer> buffer = m_Device->CreateBuffer(desc);
+        }
+        return ElapsedUs(start) / static_cast<double>(count);
+    });
+}
+
+void RHIBench::BenchCopyData() {
+    using namespace rhi;
+    if (!IsSelected("copy_data")) {
+        return;
+    }
+
+    std::vector<uint8> data(COPY_CHUNK_SIZE, 0x5A);
+    uint64 chunks = Iterations(256);
+    auto copyChunks = [&](Buffer& buffer) {
+        for (uint64 i = 0; i < chunks; ++i) {
+            buffer.CopyData(data.data(), COPY_CHUNK_SIZE, (i * COPY_CHUNK_SIZE) % COPY_BUFFER_SIZE);
+        }
+    };
+
+    BufferDesc desc{};
+    desc.size = COPY_BUFFER_SIZE;
+    desc.usage = BufferUsage::Storage | BufferUsage::TransferDst;
+    desc.memoryUsage = MemoryUsage::GPUOnly;
+    desc.debugName = "BenchCopyStaged";
+    Ref<Buffer> staged = m_Device->CreateBuffer(desc);
+    if (staged) {
+        Measure("copy_data_staged", "MB/s", true, chunks, [&]() {
+            Clock::time_point start = Clock::now();
+            copyChunks(*staged);
+            FinishUploads([&]() { return staged->IsUploadComplete(); });
+            return MegabytesPerSecond(chunks * COPY_CHUNK_SIZE, start);
+        });
+    }
+
+    desc.memoryUsage = MemoryUsage::CPUToGPU;
+    desc.debugName = "BenchCopyMapped";
+    Ref<Buffer> mapped = m_Device->CreateBuffer(desc);
+    if (mapped) {
+        Measure("copy_data_mapped", "MB/s", true, chunks, [&]() {
+            Clock::time_point start = Clock::now();
+            copyChunks(*mapped);
+            return MegabytesPerSecond(chunks * COPY_CHUNK_SIZE, start);
+        });
+    }
+}
+
+void RHIBench::BenchTextureUpload() {
+    using namespace rhi;
+    if (!IsSelected("texture_upload")) {
+        return;
+    }
+
+    TextureDesc desc{};
+    desc.width = UPLOAD_TEXTURE_SIZE;
+    desc.height = UPLOAD_TEXTURE_SIZE;
+    desc.format = Format::R8G8B8A8_UNORM;
+    desc.usage = TextureUsage::Sampled | TextureUsage::TransferDst;
+    desc.debugName = "BenchUploadTexture";
+    Ref<Texture> texture = m_Device->CreateTexture(desc);
+    if (!texture) {
+        return;
+    }
+
+    std::vector<uint8> pixels(static_cast<size_t>(UPLOAD_TEXTURE_SIZE) * UPLOAD_TEXTURE_SIZE * 4, 0x80);
+    uint64 uploads = Iterations(16);
+    Measure("texture_upload", "MB/s", true, uploads, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 i = 0; i < uploads; ++i) {
+            texture->UploadData(pixels.data(), pixels.size());
+        }
+        FinishUploads([&]() { return texture->IsUploadComplete(); });
+        return MegabytesPerSecond(uploads * pixels.size(), start);
+    });
+}
+
+void RHIBench::BenchDescriptorUpdate() {
+    using namespace rhi;
+    if (!IsSelected("descriptor_update")) {
+        return;
+    }
+
+    BufferDesc bufferDesc{};
+    bufferDesc.size = sizeof(BenchUniforms);
+    bufferDesc.usage = BufferUsage::Uniform;
+    bufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    bufferDesc.debugName = "BenchDescriptorBuffer";
+    Ref<Buffer> buffers[2] = { m_Device->CreateBuffer(bufferDesc), m_Device->CreateBuffer(bufferDesc) };
+
+    DescriptorSetDesc setDesc;
+    setDesc.bindings = {
+        { 0, DescriptorType::UniformBuffer, ShaderStage::Vertex | ShaderStage::Fragment, buffers[0], nullptr, nullptr }
+    };
+    setDesc.debugName = "BenchDescriptorSet";
+    Ref<DescriptorSet> set = m_Device->CreateDescriptorSet(setDesc);
+    if (!buffers[0] || !buffers[1] || !set) {
+        return;
+    }
+
+    // Alternating buffers, so no backend can skip an update as unchanged
+    uint64 count = Iterations(10000);
+    Measure("descriptor_update", "us", false, count, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 i = 0; i < count; ++i) {
+            set->UpdateBuffer(0, buffers[(i + 1) & 1]);
+        }
+        return ElapsedUs(start) / static_cast<double>(count);
+    });
+}
+
+// ----------------------------------------------------------------------------
+// Pipelines, passes and draws
+// ----------------------------------------------------------------------------
+
+bool RHIBench::CreateDrawResources() {
+#if METAGFX_HAS_BENCH_SHADERS
+    using namespace rhi;
+
+    ShaderDesc vertexDesc{};
+    vertexDesc.stage = ShaderStage::Vertex;
+    vertexDesc.code = {
+        #include "bench.vert.spv.inl"
+    };
+    vertexDesc.debugName = "BenchVertex";
+    m_VertexShader = m_Device->CreateShader(vertexDesc);
+
+    ShaderDesc fragmentDesc{};
+    fragmentDesc.stage = ShaderStage::Fragment;
+    fragmentDesc.code = {
+        #include "bench.frag.spv.inl"
+    };
+    fragmentDesc.debugName = "BenchFragment";
+    m_FragmentShader = m_Device->CreateShader(fragmentDesc);
+
+    BenchUniforms uniforms;
+    BufferDesc bufferDesc{};
+    bufferDesc.size = sizeof(uniforms);
+    bufferDesc.usage = BufferUsage::Uniform;
+    bufferDesc.memoryUsage = MemoryUsage::CPUToGPU;
+    bufferDesc.debugName = "BenchUniforms";
+    m_UniformBuffer = m_Device->CreateBuffer(bufferDesc);
+    if (!m_VertexShader || !m_FragmentShader || !m_UniformBuffer) {
+        return false;
+    }
+    m_UniformBuffer->CopyData(&uniforms, sizeof(uniforms));
+
+    DescriptorSetDesc setDesc;
+    setDesc.bindings = {
+        { 0, DescriptorType::UniformBuffer, ShaderStage::Vertex | ShaderStage::Fragment, m_UniformBuffer, nullptr, nullptr }
+    };
+    setDesc.debugName = "BenchDrawSet";
+    m_DescriptorSet = m_Device->CreateDescriptorSet(setDesc);
+
+    TextureDesc targetDesc{};
+    targetDesc.width = TARGET_SIZE;
+    targetDesc.height = TARGET_SIZE;
+    targetDesc.format = TARGET_FORMAT;
+    targetDesc.usage = TextureUsage::ColorAttachment | TextureUsage::Sampled;
+    targetDesc.debugName = "BenchTarget";
+    m_ColorTarget = m_Device->CreateTexture(targetDesc);
+    if (!m_DescriptorSet || !m_ColorTarget) {
+        return false;
+    }
+
+    m_Pipeline = CreatePipeline(0);
+    return m_Pipeline != nullptr;
+#else
+    return false;
+#endif
+}
+
+Ref<rhi::Pipeline> RHIBench::CreatePipeline(uint32 variant) {
+    using namespace rhi;
+
+    PipelineDesc desc{};
+    desc.vertexShader = m_VertexShader;
+    desc.fragmentShader = m_FragmentShader;
+    desc.vertexInput.stride = 0;
+    desc.rasterization.cullMode = CullMode::None;
+    desc.depthStencil.depthTestEnable = false;
+    desc.depthStencil.depthWriteEnable = false;
+    desc.colorFormats = { TARGET_FORMAT };
+    desc.depthFormat = Format::Undefined;
+    desc.specializationConstants = { { 0, variant } };
+    desc.descriptorSetLayout = m_DescriptorSet;
+    desc.debugName = "BenchPipeline";
+    return m_Device->CreateGraphicsPipeline(desc);
+}
+
+void RHIBench::BenchPipelineCreation() {
+    // Cold: a specialization constant the device has not seen, so the backend compiles
+    // (a driver's own cache may still shorten it). Cached: the shared pipeline cache's
+    // lookup of a desc it holds.
+    uint64 coldCount = Iterations(20);
+    Measure("pipeline_create_cold", "ms", false, coldCount, [&]() {
+        std::vector<Ref<rhi::Pipeline>> pipelines;
+        Clock::time_point start = Clock::now();
+        for (uint64 i = 0; i < coldCount; ++i) {
+            pipelines.push_back(CreatePipeline(m_NextVariant++));
+        }
+        return ElapsedUs(start) / 1000.0 / static_cast<double>(coldCount);
+    });
+
+    uint64 cachedCount = Iterations(10000);
+    Measure("pipeline_create_cached", "us", false, cachedCount, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 i = 0; i < cachedCount; ++i) {
+            Ref<rhi::Pipeline> pipeline = CreatePipeline(0);
+        }
+        return ElapsedUs(start) / static_cast<double>(cachedCount);
+    });
+}
+
+void RHIBench::BenchEmptyPass() {
+    using namespace rhi;
+
+    Ref<Texture> targets[] = { m_ColorTarget };
+    ClearValue clear{};
+    clear.color[3] = 1.0f;
+    ClearValue clears[] = { clear };
+
+    uint64 frames = Iterations(20);
+    uint64 passes = frames * PASSES_PER_FRAME;
+    double recordUs = 0.0;
+    auto recordPasses = [&](CommandBuffer& cmd, uint32) {
+        Clock::time_point start = Clock::now();
+        for (uint32 i = 0; i < PASSES_PER_FRAME; ++i) {
+            cmd.BeginRendering(targets, nullptr, clears);
+            cmd.EndRendering();
+        }
+        recordUs += ElapsedUs(start);
+    };
+
+    Measure("empty_pass_record", "us", false, passes, [&]() {
+        recordUs = 0.0;
+        for (uint64 frame = 0; frame < frames; ++frame) {
+            RunFrame(recordPasses);
+        }
+        return recordUs / static_cast<double>(passes);
+    });
+    Measure("empty_pass", "us", false, passes, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 frame = 0; frame < frames; ++frame) {
+            RunFrame(recordPasses);
+        }
+        m_Device->WaitIdle();
+        return ElapsedUs(start) / static_cast<double>(passes);
+    });
+}
+
+void RHIBench::BenchDrawSubmission() {
+    using namespace rhi;
+
+    Ref<Texture> targets[] = { m_ColorTarget };
+    ClearValue clear{};
+    clear.color[3] = 1.0f;
+    ClearValue clears[] = { clear };
+
+    Viewport viewport{};
+    viewport.width = static_cast<float>(TARGET_SIZE);
+    viewport.height = static_cast<float>(TARGET_SIZE);
+    Rect2D scissor{ 0, 0, TARGET_SIZE, TARGET_SIZE };
+
+    // Each draw its own triangle of the grid bench.vert lays out from the first vertex
+    uint64 frames = Iterations(10);
+    uint64 draws = frames * DRAWS_PER_FRAME;
+    double recordSeconds = 0.0;
+    auto recordDraws = [&](CommandBuffer& cmd, uint32 frameIndex) {
+        Clock::time_point start = Clock::now();
+        cmd.BeginRendering(targets, nullptr, clears);
+        cmd.BindPipeline(m_Pipeline);
+        cmd.BindDescriptorSet(m_Pipeline, m_DescriptorSet, frameIndex);
+        cmd.SetViewport(viewport);
+        cmd.SetScissor(scissor);
+        for (uint32 i = 0; i < DRAWS_PER_FRAME; ++i) {
+            cmd.Draw(3, 1, 3 * (i % DRAW_GRID_CELLS), 0);
+        }
+        cmd.EndRendering();
+        recordSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+    };
+
+    Measure("draw_submission_record", "draws/s", true, draws, [&]() {
+        recordSeconds = 0.0;
+        for (uint64 frame = 0; frame < frames; ++frame) {
+            RunFrame(recordDraws);
+        }
+        return recordSeconds > 0.0 ? static_cast<double>(draws) / recordSeconds : 0.0;
+    });
+    Measure("draw_submission", "draws/s", true, draws, [&]() {
+        Clock::time_point start = Clock::now();
+        for (uint64 frame = 0; frame < frames; ++frame) {
+            RunFrame(recordDraws);
+        }
+        m_Device->WaitIdle();
+        double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        return seconds > 0.0 ? static_cast<double>(draws) / seconds : 0.0;
+    });
+}
+
+void RHIBench::BenchMultiview() {
+    using namespace rhi;
+    if (!IsSelected("stereo_")) {
+        return;
+    }
+    if (!m_Device->GetDeviceInfo().supportsMultiview ||
+        m_Device->GetDeviceInfo().maxMultiviewViews < STEREO_VIEWS) {
+        std::cerr << "Skipping the stereo tests: the device has no multiview\n";
+        return;
+    }
+#if METAGFX_HAS_MULTIVIEW_SHADER
+    ShaderDesc vertexDesc{};
+    vertexDesc.stage = ShaderStage::Vertex;
+    vertexDesc.code = {
+        #include "bench_multiview.vert.spv.inl"
+    };
+    vertexDesc.debugName = "BenchMultiviewVertex";
+    Ref<Shader> vertexShader = m_Device->CreateShader(vertexDesc);
+
+    // The eyes as targets of their own, and as the layers of one
+    TextureDesc targetDesc{};
+    targetDesc.width = TARGET_SIZE;
+    targetDesc.height = TARGET_SIZE;
+    targetDesc.format = TARGET_FORMAT;
+    targetDesc.usage = TextureUsage::ColorAttachment | TextureUsage::Sampled;
+    targetDesc.debugName = "BenchEyeTarget";
+    Ref<Texture> eyeTargets[STEREO_VIEWS] = { m_Device->CreateTexture(targetDesc),
+                                              m_Device->CreateTexture(targetDesc) };
+    targetDesc.arrayLayers = STEREO_VIEWS;
+    targetDesc.debugName = "BenchStereoTarget";
+    Ref<Texture> stereoTarget = m_Device->CreateTexture(targetDesc);
+    if (!vertexShader || !eyeTargets[0] || !eyeTargets[1] || !stereoTarget) {
+        return;
+    }
+
+    PipelineDesc pipelineDesc{};
+    pipelineDesc.vertexShader = vertexShader;
+    pipelineDesc.fragmentShader = m_FragmentShader;
+    pipelineDesc.vertexInput.stride = 0;
+    pipelineDesc.rasterization.cullMode = CullMode::None;
+    pipelineDesc.depthStencil.depthTestEnable = false;
+    pipelineDesc.depthStencil.depthWriteEnable = false;
+    pipelineDesc.colorFormats = { TARGET_FORMAT };
+    pipelineDesc.depthFormat = Format::Undefined;
+    pipelineDesc.specializationConstants = { { 0, 0 } };
+    pipelineDesc.viewCount = STEREO_VIEWS;
+    pipelineDesc.descriptorSetLayout = m_DescriptorSet;
+    pipelineDesc.debugName = "BenchMultiviewPipeline";
+    Ref<Pipeline> multiviewPipeline = m_Device->CreateGraphicsPipeline(pipelineDesc);
+    if (!multiviewPipeline) {
+        return;
+    }
+
+    ClearValue clear{};
+    clear.color[3] = 1.0f;
+    ClearValue clears[] = { clear };
+
+    Viewport viewport{};
+    viewport.width = static_cast<float>(TARGET_SIZE);
+    viewport.height = static_cast<float>(TARGET_SIZE);
+    Rect2D scissor{ 0, 0, TARGET_SIZE, TARGET_SIZE };
+
+    auto recordEye = [&](CommandBuffer& cmd, uint32 frameIndex, const Ref<Texture>& target,
+                         const Ref<Pipeline>& pipeline, const RenderPassActions& actions) {
+        Ref<Texture> targets[] = { target };
+        cmd.BeginRendering(targets, nullptr, clears, actions);
+        cmd.BindPipeline(pipeline);
+        cmd.BindDescriptorSet(pipeline, m_DescriptorSet, frameIndex);
+        cmd.SetViewport(viewport);
+        cmd.SetScissor(scissor);
+        for (uint32 i = 0; i < DRAWS_PER_FRAME; ++i) {
+            cmd.Draw(3, 1, 3 * (i % DRAW_GRID_CELLS), 0);
+        }
+        cmd.EndRendering();
+    };
+
+    // The same draws either way: recorded and submitted per eye, or once for both
+    uint64 frames = Iterations(10);
+    auto measureStereo = [&](const char* name, const std::function<void(CommandBuffer&, uint32)>& record) {
+        Measure(name, "us", false, frames, [&]() {
+            Clock::time_point start = Clock::now();
+            for (uint64 frame = 0; frame < frames; ++frame) {
+                RunFrame(record);
+            }
+            m_Device->WaitIdle();
+            return ElapsedUs(start) / static_cast<double>(frames);
+        });
+    };
+    measureStereo("stereo_two_passes", [&](CommandBuffer& cmd, uint32 frameIndex) {
+        for (const Ref<Texture>& eyeTarget : eyeTargets) {
+            recordEye(cmd, frameIndex, eyeTarget, m_Pipeline, RenderPassActions{});
+        }
+    });
+    RenderPassActions multiviewActions{};
+    multiviewActions.viewCount = STEREO_VIEWS;
+    measureStereo("stereo_multiview", [&](CommandBuffer& cmd, uint32 frameIndex) {
+        recordEye(cmd, frameIndex, stereoTarget, multiviewPipeline, multiviewActions);
+    });
+#else
+    std::cerr << "Skipping the stereo tests: bench_multiview.vert has not been compiled\n";
+#endif
+}
+
+// ----------------------------------------------------------------------------
+// Results
+// ----------------------------------------------------------------------------
+
+bool RHIBench::WriteResults(const std::string& path, const rhi::DeviceInfo& deviceInfo,
+                            const BenchSettings& settings, const std::vector<BenchResult>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+
+    const char* apiName = "Unknown";
+    switch (deviceInfo.api) {
+        case rhi::GraphicsAPI::Vulkan: apiName = "Vulkan"; break;
+        case rhi::GraphicsAPI::Direct3D12: apiName = "D3D12"; break;
+        case rhi::GraphicsAPI::Metal: apiName = "Metal"; break;
+        case rhi::GraphicsAPI::WebGPU: apiName = "WebGPU"; break;
+    }
+    std::time_t now = std::time(nullptr);
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"timestamp\": \"" << timestamp << "\",\n  \"backend\": \"" << apiName << "\",\n  \"device\": ";
+    WriteJsonString(out, deviceInfo.deviceName);
+    out << ",\n  \"adapter\": " << deviceInfo.adapterIndex << ",\n  \"features\": [";
+    std::vector<const char*> features = rhi::GetFeatureNames(deviceInfo);
+    for (size_t i = 0; i < features.size(); ++i) {
+        out << (i ? ", \"" : "\"") << features[i] << '"';
+    }
+    out << "],\n  \"repeats\": " << settings.repeats << ",\n  \"scale\": " << settings.scale
+        << ",\n  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& result = results[i];
+        out << (i ? ",\n    { " : "\n    { ") << "\"name\": \"" << result.name << "\", \"unit\": \"" << result.unit
+            << "\", \"higherIsBetter\": " << (result.higherIsBetter ? "true" : "false")
+            << ", \"iterations\": " << result.iterations << ", \"median\": " << result.median
+            << ", \"best\": " << result.best << " }";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+} // namespace tools
+} // namespace metagfx
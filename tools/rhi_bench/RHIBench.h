@@ -0,0 +1,106 @@
+// ============================================================================
+// tools/rhi_bench/RHIBench.h - RHI Microbenchmarks
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+struct BenchSettings {
+    uint32 repeats = 5;      // Runs of each test; the median is reported
+    float scale = 1.0f;      // Of every test's iteration count, e.g. 0.1 for a quick check
+    std::string filter;      // Non-empty: only the tests whose name contains it
+};
+
+// One test's outcome over its repeats
+struct BenchResult {
+    std::string name;
+    std::string unit;            // Of median and best, e.g. "us" per operation or "MB/s"
+    bool higherIsBetter = false;
+    uint64 iterations = 0;       // Operations per repeat
+    double median = 0.0;
+    double best = 0.0;
+};
+
+// Microbenchmarks of the RHI calls the renderer leans on, recorded identically on every
+// backend so their results compare across Vulkan, Metal and WebGPU and over time:
+// - buffer_create_destroy: a 64 KB GPU-only buffer created and released
+// - copy_data_staged / copy_data_mapped: Buffer::CopyData() into GPU-only memory (until
+//   the upload has landed) and into CPU-visible memory
+// - texture_upload: Texture::UploadData() of 2048x2048 RGBA8 mip 0 until it has landed
+// - descriptor_update: DescriptorSet::UpdateBuffer() of one uniform binding
+// - pipeline_create_cold / pipeline_create_cached: a graphics pipeline the device has not
+//   seen (a new specialization constant each time), and one its pipeline cache holds
+// - empty_pass: BeginRendering()/EndRendering() with nothing drawn, recording alone and
+//   until the GPU has run it
+// - draw_submission: non-indexed triangle draws without state changes between them,
+//   recording alone and until the GPU has run them
+// - stereo_two_passes / stereo_multiview: the draw_submission draws into both eyes of a
+//   stereo pair, as a pass per eye and as one multiview pass (bench_multiview.vert) into
+//   a two-layer target; per stereo frame until the GPU has run it. Needs
+//   DeviceInfo::supportsMultiview.
+// Each "until the GPU" figure waits with WaitIdle(), so it includes one submission's
+// latency. The pipeline, pass and draw tests need bench.vert and bench.frag, compiled by
+// metagfx_add_shaders(); without a GLSL compiler they are skipped.
+class RHIBench {
+public:
+    explicit RHIBench(Ref<rhi::GraphicsDevice> device, const BenchSettings& settings = {});
+    ~RHIBench();
+
+    RHIBench(const RHIBench&) = delete;
+    RHIBench& operator=(const RHIBench&) = delete;
+
+    // Runs the tests the filter selects, printing each result as it finishes
+    std::vector<BenchResult> Run();
+
+    // JSON of the device and the results, for tracking them over time
+    static bool WriteResults(const std::string& path, const rhi::DeviceInfo& deviceInfo,
+                             const BenchSettings& settings, const std::vector<BenchResult>& results);
+
+private:
+    using Test = std::function<double()>;  // One repeat; returns its figure in the result's unit
+
+    bool IsSelected(const char* name) const;
+    uint64 Iterations(uint64 count) const;
+    void Measure(const char* name, const char* unit, bool higherIsBetter, uint64 iterations, const Test& test);
+
+    // One frame of record(), submitted; nothing is presented on the offscreen device
+    void RunFrame(const std::function<void(rhi::CommandBuffer&, uint32 frameIndex)>& record);
+    // Runs empty frames until done() holds, so staged uploads are flushed, then waits idle
+    void FinishUploads(const std::function<bool()>& done);
+
+    bool CreateDrawResources();
+    Ref<rhi::Pipeline> CreatePipeline(uint32 variant);
+
+    void BenchBufferCreateDestroy();
+    void BenchCopyData();
+    void BenchTextureUpload();
+    void BenchDescriptorUpdate();
+    void BenchPipelineCreation();
+    void BenchEmptyPass();
+    void BenchDrawSubmission();
+    void BenchMultiview();
+
+    Ref<rhi::GraphicsDevice> m_Device;
+    BenchSettings m_Settings;
+    std::vector<BenchResult> m_Results;
+
+    // Of the pipeline, pass and draw tests
+    Ref<rhi::Shader> m_VertexShader;
+    Ref<rhi::Shader> m_FragmentShader;
+    Ref<rhi::Buffer> m_UniformBuffer;
+    Ref<rhi::DescriptorSet> m_DescriptorSet;
+    Ref<rhi::Texture> m_ColorTarget;
+    Ref<rhi::Pipeline> m_Pipeline;
+    uint32 m_NextVariant = 1;  // Specialization constant of the next cold pipeline
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,16 @@
+#version 450
+
+// Set to a new value for each pipeline of pipeline_create_cold, so each one compiles
+layout(constant_id = 0) const uint VARIANT = 0u;
+
+// RHIBench's BenchUniforms
+layout(binding = 0) uniform BenchUniforms {
+    vec4 color;
+    vec4 transform;
+} ubo;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = ubo.color + vec4(float(VARIANT) * 1e-6);
+}
@@ -0,0 +1,18 @@
+#version 450
+
+// metagfx_rhi_bench's draws: a small triangle per draw, placed on a 64x64 grid by its
+// first vertex (Draw(3, 1, 3 * cell)), so nothing but the draw itself is submitted
+
+// RHIBench's BenchUniforms
+layout(binding = 0) uniform BenchUniforms {
+    vec4 color;
+    vec4 transform;  // xy: scale, zw: offset
+} ubo;
+
+void main() {
+    uint cell = uint(gl_VertexIndex) / 3u;
+    uint corner = uint(gl_VertexIndex) % 3u;
+    vec2 origin = vec2(float(cell % 64u), float((cell / 64u) % 64u)) / 32.0 - 1.0;
+    vec2 position = origin + vec2(corner == 1u ? 1.0 : 0.0, corner == 2u ? 1.0 : 0.0) / 32.0;
+    gl_Position = vec4(position * ubo.transform.xy + ubo.transform.zw, 0.0, 1.0);
+}
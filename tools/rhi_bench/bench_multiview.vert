@@ -0,0 +1,20 @@
+#version 450
+#extension GL_EXT_multiview : require
+
+// metagfx_rhi_bench's multiview draws: bench.vert's triangle grid, drawn once into both
+// layers of a stereo pair, each view shifted like an eye
+
+// RHIBench's BenchUniforms
+layout(binding = 0) uniform BenchUniforms {
+    vec4 color;
+    vec4 transform;  // xy: scale, zw: offset
+} ubo;
+
+void main() {
+    uint cell = uint(gl_VertexIndex) / 3u;
+    uint corner = uint(gl_VertexIndex) % 3u;
+    vec2 origin = vec2(float(cell % 64u), float((cell / 64u) % 64u)) / 32.0 - 1.0;
+    vec2 position = origin + vec2(corner == 1u ? 1.0 : 0.0, corner == 2u ? 1.0 : 0.0) / 32.0;
+    position.x += gl_ViewIndex == 0u ? -0.01 : 0.01;
+    gl_Position = vec4(position * ubo.transform.xy + ubo.transform.zw, 0.0, 1.0);
+}
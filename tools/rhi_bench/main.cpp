@@ -0,0 +1,156 @@
+// ============================================================================
+// tools/rhi_bench/main.cpp - RHI Microbenchmark Tool Entry Point
+// ============================================================================
+#include "RHIBench.h"
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <SDL3/SDL.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <string>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+namespace {
+
+// WGSL tint translated at build time (WebGPU and tint enabled), so the WebGPU backend
+// creates the shaders without translating the SPIR-V
+#if __has_include("precompiled_wgsl.inl")
+#include "precompiled_wgsl.inl"
+#define METAGFX_HAS_PRECOMPILED_WGSL 1
+#else
+#define METAGFX_HAS_PRECOMPILED_WGSL 0
+#endif
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX RHI Microbenchmarks\n";
+    std::cout << "===========================\n\n";
+    std::cout << "Usage: " << programName << " [options]\n\n";
+    std::cout << "Times buffer, texture, descriptor, pipeline, pass and draw calls of the RHI on\n";
+    std::cout << "an offscreen device, the same tests on every backend, and writes the results\n";
+    std::cout << "as JSON.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --api <name>          vulkan, metal or webgpu (default: the first one built)\n";
+    std::cout << "  --adapter <index>     GPU to run on (default: the best one)\n";
+    std::cout << "  --output <file>       JSON results (default: rhi_bench.json)\n";
+    std::cout << "  --repeats <count>     Runs of each test, the median reported (default: 5)\n";
+    std::cout << "  --scale <factor>      Of every test's iteration count (default: 1)\n";
+    std::cout << "  --filter <text>       Only the tests whose name contains text\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " --api vulkan --output results/vulkan.json\n";
+    std::cout << "  " << programName << " --api metal --filter pipeline_create --scale 0.1\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+#if defined(METAGFX_USE_VULKAN)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Vulkan;
+#elif defined(METAGFX_USE_METAL)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Metal;
+#else
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::WebGPU;
+#endif
+    BenchSettings settings;
+    std::string outputPath = "rhi_bench.json";
+    uint32 adapterIndex = rhi::DEFAULT_ADAPTER;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (arg == "--api" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "vulkan") {
+                api = rhi::GraphicsAPI::Vulkan;
+            } else if (name == "metal") {
+                api = rhi::GraphicsAPI::Metal;
+            } else if (name == "webgpu") {
+                api = rhi::GraphicsAPI::WebGPU;
+            } else {
+                std::cerr << "Error: unknown API " << name << "\n";
+                return 1;
+            }
+        } else if (arg == "--adapter" && i + 1 < argc) {
+            adapterIndex = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            settings.repeats = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--scale" && i + 1 < argc) {
+            settings.scale = static_cast<float>(std::atof(argv[++i]));
+        } else if (arg == "--filter" && i + 1 < argc) {
+            settings.filter = argv[++i];
+        } else {
+            std::cerr << "Error: unknown option " << arg << "\n\n";
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    Logger::Init();
+    // As in the renderer: pipeline compiles and uploads may use the workers
+    JobSystem::Init();
+
+    // The device needs a (hidden) window; nothing is presented
+    SDL_WindowFlags windowFlags = SDL_WINDOW_HIDDEN;
+    if (api == rhi::GraphicsAPI::Vulkan) {
+        windowFlags |= SDL_WINDOW_VULKAN;
+    } else if (api == rhi::GraphicsAPI::Metal) {
+        windowFlags |= SDL_WINDOW_METAL;
+    }
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+        std::cerr << "Error: failed to initialize SDL: " << SDL_GetError() << "\n";
+        JobSystem::Shutdown();
+        return 1;
+    }
+    SDL_Window* window = SDL_CreateWindow("metagfx_rhi_bench", 256, 256, windowFlags);
+
+    Ref<rhi::GraphicsDevice> device;
+    if (window) {
+        rhi::GraphicsDeviceDesc deviceDesc{};
+        deviceDesc.offscreen = true;
+        deviceDesc.adapterIndex = adapterIndex;
+#if METAGFX_HAS_PRECOMPILED_WGSL
+        deviceDesc.precompiledShaders = PRECOMPILED_WGSL;
+        deviceDesc.precompiledShaderCount = static_cast<uint32>(std::size(PRECOMPILED_WGSL));
+#endif
+        device = rhi::CreateGraphicsDevice(api, window, deviceDesc);
+    }
+
+    int status = 1;
+    if (device) {
+        const rhi::DeviceInfo& deviceInfo = device->GetDeviceInfo();
+        std::cout << "Device: " << deviceInfo.deviceName << "\n";
+        std::cout << "Repeats: " << settings.repeats << ", scale: " << settings.scale << "\n\n";
+
+        std::vector<BenchResult> results;
+        {
+            RHIBench bench(device, settings);
+            results = bench.Run();
+        }
+        if (results.empty()) {
+            std::cerr << "Error: no test ran" << (settings.filter.empty() ? "" : " (check --filter)") << "\n";
+        } else if (RHIBench::WriteResults(outputPath, deviceInfo, settings, results)) {
+            std::cout << "\nResults written to " << outputPath << "\n";
+            status = 0;
+        }
+    } else {
+        std::cerr << "Error: failed to create the graphics device (is the backend built in?)\n";
+    }
+
+    device.reset();
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+    JobSystem::Shutdown();
+    return status;
+}
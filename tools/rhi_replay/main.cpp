@@ -0,0 +1,307 @@
+// ============================================================================
+// tools/rhi_replay/main.cpp - RHI Trace Replay Tool Entry Point
+// ============================================================================
+#include "metagfx/core/JobSystem.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Types.h"
+#include "metagfx/rhi/CaptureDevice.h"
+#include "metagfx/rhi/GraphicsDevice.h"
+
+#include <SDL3/SDL.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace metagfx;
+
+namespace {
+
+const char* GetApiName(rhi::GraphicsAPI api) {
+    switch (api) {
+        case rhi::GraphicsAPI::Vulkan: return "Vulkan";
+        case rhi::GraphicsAPI::Direct3D12: return "D3D12";
+        case rhi::GraphicsAPI::Metal: return "Metal";
+        case rhi::GraphicsAPI::WebGPU: return "WebGPU";
+    }
+    return "Unknown";
+}
+
+void WriteJsonString(std::ofstream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (static_cast<unsigned char>(c) >= 0x20) {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+// One replay of the trace
+struct ReplayPass {
+    std::vector<rhi::TraceFrameStats> frames;
+};
+
+// Median, 95th percentile and worst of one field over the measured frames
+struct Summary {
+    double median = 0.0;
+    double p95 = 0.0;
+    double max = 0.0;
+};
+
+template <typename Field>
+Summary Summarize(const std::vector<rhi::TraceFrameStats>& frames, uint32 skip, Field field) {
+    std::vector<double> values;
+    for (size_t i = skip; i < frames.size(); ++i) {
+        values.push_back(field(frames[i]));
+    }
+    Summary summary;
+    if (!values.empty()) {
+        std::sort(values.begin(), values.end());
+        summary.median = values[values.size() / 2];
+        summary.p95 = values[std::min(values.size() - 1, values.size() * 95 / 100)];
+        summary.max = values.back();
+    }
+    return summary;
+}
+
+void WriteSummary(std::ofstream& out, const char* name, const Summary& summary, bool last = false) {
+    out << "\"" << name << "\": { \"median\": " << summary.median << ", \"p95\": " << summary.p95
+        << ", \"max\": " << summary.max << " }" << (last ? "" : ", ");
+}
+
+bool WriteResults(const std::string& path, const std::string& tracePath, const rhi::TraceInfo& trace,
+                  const rhi::DeviceInfo& deviceInfo, uint32 skip, const std::vector<ReplayPass>& passes) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "Error: cannot write " << path << "\n";
+        return false;
+    }
+    std::time_t now = std::time(nullptr);
+    char timestamp[32] = {};
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\n  \"timestamp\": \"" << timestamp << "\",\n  \"backend\": \"" << GetApiName(deviceInfo.api)
+        << "\",\n  \"device\": ";
+    WriteJsonString(out, deviceInfo.deviceName);
+    out << ",\n  \"trace\": { \"path\": ";
+    WriteJsonString(out, tracePath);
+    out << ", \"backend\": \"" << GetApiName(trace.api) << "\", \"device\": ";
+    WriteJsonString(out, trace.deviceName);
+    out << ", \"frames\": " << trace.frameCount << ", \"bytes\": " << trace.fileBytes << ", \"width\": "
+        << trace.width << ", \"height\": " << trace.height << " },\n  \"skippedFrames\": " << skip
+        << ",\n  \"unit\": \"ms\",\n  \"passes\": [";
+    for (size_t p = 0; p < passes.size(); ++p) {
+        const std::vector<rhi::TraceFrameStats>& frames = passes[p].frames;
+        out << (p ? ",\n    { " : "\n    { ") << "\"frames\": " << frames.size() << ",\n      ";
+        WriteSummary(out, "cpu", Summarize(frames, skip, [](const auto& f) { return f.cpuMs; }));
+        WriteSummary(out, "record", Summarize(frames, skip, [](const auto& f) { return f.recordMs; }));
+        WriteSummary(out, "submit", Summarize(frames, skip, [](const auto& f) { return f.submitMs; }));
+        out << "\n      ";
+        WriteSummary(out, "present", Summarize(frames, skip, [](const auto& f) { return f.presentMs; }));
+        WriteSummary(out, "resource", Summarize(frames, skip, [](const auto& f) { return f.resourceMs; }));
+        WriteSummary(out, "upload", Summarize(frames, skip, [](const auto& f) { return f.uploadMs; }), true);
+        out << ",\n      \"perFrame\": [";
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const rhi::TraceFrameStats& f = frames[i];
+            out << (i ? ",\n        " : "\n        ") << "{ \"cpu\": " << f.cpuMs << ", \"resource\": " << f.resourceMs
+                << ", \"upload\": " << f.uploadMs << ", \"record\": " << f.recordMs << ", \"submit\": "
+                << f.submitMs << ", \"present\": " << f.presentMs << ", \"commands\": " << f.commands
+                << ", \"submits\": " << f.submits << ", \"uploadBytes\": " << f.uploadBytes << " }";
+        }
+        out << " ] }";
+    }
+    out << "\n  ]\n}\n";
+    return out.good();
+}
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX RHI Trace Replay\n";
+    std::cout << "========================\n\n";
+    std::cout << "Usage: " << programName << " <trace> [options]\n\n";
+    std::cout << "Replays a trace captured with the renderer's --capture option on any backend,\n";
+    std::cout << "without the application: the same resources, uploads and commands, frame by\n";
+    std::cout << "frame. Reports the CPU time of each frame split into resource creation,\n";
+    std::cout << "uploads, command recording, submission and presentation, as JSON.\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --api <name>          vulkan, metal or webgpu (default: the first one built)\n";
+    std::cout << "  --adapter <index>     GPU to run on (default: the best one)\n";
+    std::cout << "  --output <file>       JSON results (default: rhi_replay.json)\n";
+    std::cout << "  --repeats <count>     Replays of the whole trace (default: 3)\n";
+    std::cout << "  --frames <count>      Replay only the first count frames\n";
+    std::cout << "  --skip <count>        Frames left out of the summaries, e.g. loading (default: 1)\n";
+    std::cout << "  --onscreen            Present to a visible window instead of offscreen\n";
+    std::cout << "  --info                Print what the trace was captured on and exit\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " heavy_frame.mgtrace --api vulkan --output results/vulkan.json\n";
+    std::cout << "  " << programName << " heavy_frame.mgtrace --api metal --repeats 10 --skip 2\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+#if defined(METAGFX_USE_VULKAN)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Vulkan;
+#elif defined(METAGFX_USE_METAL)
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::Metal;
+#else
+    rhi::GraphicsAPI api = rhi::GraphicsAPI::WebGPU;
+#endif
+    std::string tracePath;
+    std::string outputPath = "rhi_replay.json";
+    uint32 adapterIndex = rhi::DEFAULT_ADAPTER;
+    uint32 repeats = 3;
+    uint32 frameLimit = 0;
+    uint32 skip = 1;
+    bool onscreen = false;
+    bool infoOnly = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else if (arg == "--api" && i + 1 < argc) {
+            std::string name = argv[++i];
+            if (name == "vulkan") {
+                api = rhi::GraphicsAPI::Vulkan;
+            } else if (name == "metal") {
+                api = rhi::GraphicsAPI::Metal;
+            } else if (name == "webgpu") {
+                api = rhi::GraphicsAPI::WebGPU;
+            } else {
+                std::cerr << "Error: unknown API " << name << "\n";
+                return 1;
+            }
+        } else if (arg == "--adapter" && i + 1 < argc) {
+            adapterIndex = static_cast<uint32>(std::atoi(argv[++i]));
+        } else if (arg == "--output" && i + 1 < argc) {
+            outputPath = argv[++i];
+        } else if (arg == "--repeats" && i + 1 < argc) {
+            repeats = static_cast<uint32>(std::max(std::atoi(argv[++i]), 1));
+        } else if (arg == "--frames" && i + 1 < argc) {
+            frameLimit = static_cast<uint32>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--skip" && i + 1 < argc) {
+            skip = static_cast<uint32>(std::max(std::atoi(argv[++i]), 0));
+        } else if (arg == "--onscreen") {
+            onscreen = true;
+        } else if (arg == "--info") {
+            infoOnly = true;
+        } else if (tracePath.empty() && !arg.empty() && arg[0] != '-') {
+            tracePath = arg;
+        } else {
+            std::cerr << "Error: unknown option " << arg << "\n\n";
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (tracePath.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    rhi::TraceInfo trace;
+    if (!rhi::TraceReplayer::ReadInfo(tracePath, trace)) {
+        std::cerr << "Error: " << tracePath << " is not an RHI trace of this version\n";
+        return 1;
+    }
+    std::cout << "Trace: " << tracePath << " (" << trace.fileBytes / (1024 * 1024) << " MB)\n";
+    std::cout << "Captured on: " << GetApiName(trace.api) << ", " << trace.deviceName << "\n";
+    std::cout << "Frames: " << trace.frameCount << (trace.frameCount ? "" : " (not closed by the capture)")
+              << ", " << trace.width << "x" << trace.height << ", " << trace.framesInFlight << " in flight\n";
+    if (infoOnly) {
+        return 0;
+    }
+
+    Logger::Init();
+    // As in the renderer: pipeline compiles and uploads may use the workers
+    JobSystem::Init();
+
+    SDL_WindowFlags windowFlags = onscreen ? 0 : SDL_WINDOW_HIDDEN;
+    if (api == rhi::GraphicsAPI::Vulkan) {
+        windowFlags |= SDL_WINDOW_VULKAN;
+    } else if (api == rhi::GraphicsAPI::Metal) {
+        windowFlags |= SDL_WINDOW_METAL;
+    }
+    if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_EVENTS)) {
+        std::cerr << "Error: failed to initialize SDL: " << SDL_GetError() << "\n";
+        JobSystem::Shutdown();
+        return 1;
+    }
+    // Sized like the captured swap chain, so the back buffers match what the trace drew
+    SDL_Window* window = SDL_CreateWindow("metagfx_rhi_replay", static_cast<int>(std::max(trace.width, 1u)),
+                                          static_cast<int>(std::max(trace.height, 1u)), windowFlags);
+
+    Ref<rhi::GraphicsDevice> device;
+    if (window) {
+        rhi::GraphicsDeviceDesc deviceDesc{};
+        deviceDesc.offscreen = !onscreen;
+        deviceDesc.adapterIndex = adapterIndex;
+        deviceDesc.framesInFlight = trace.framesInFlight;
+        deviceDesc.presentMode = trace.presentMode;
+        device = rhi::CreateGraphicsDevice(api, window, deviceDesc);
+    }
+
+    int status = 1;
+    if (device) {
+        const rhi::DeviceInfo& deviceInfo = device->GetDeviceInfo();
+        std::cout << "Device: " << deviceInfo.deviceName << "\n\n";
+
+        std::vector<ReplayPass> passes;
+        bool failed = false;
+        for (uint32 repeat = 0; repeat < repeats && !failed; ++repeat) {
+            rhi::TraceReplayer replayer;
+            if (!replayer.Open(tracePath, device)) {
+                failed = true;
+                break;
+            }
+            ReplayPass pass;
+            rhi::TraceFrameStats frame;
+            while ((frameLimit == 0 || replayer.GetFrameIndex() < frameLimit) && replayer.ReplayFrame(&frame)) {
+                pass.frames.push_back(frame);
+                // Keeps an onscreen window responsive
+                SDL_Event event;
+                while (SDL_PollEvent(&event)) {
+                }
+            }
+            // A trace the capture did not close may end mid-frame; anything else is an error
+            failed = pass.frames.empty() || (trace.frameCount > 0 && replayer.GetFrameIndex() < trace.frameCount &&
+                                             (frameLimit == 0 || replayer.GetFrameIndex() < frameLimit));
+            replayer.Close();
+
+            Summary cpu = Summarize(pass.frames, skip, [](const auto& f) { return f.cpuMs; });
+            Summary record = Summarize(pass.frames, skip, [](const auto& f) { return f.recordMs; });
+            Summary submit = Summarize(pass.frames, skip, [](const auto& f) { return f.submitMs; });
+            std::cout << "  pass " << repeat + 1 << ": " << pass.frames.size() << " frames" << std::fixed
+                      << std::setprecision(2) << ", cpu " << cpu.median << " ms (p95 " << cpu.p95 << "), record "
+                      << record.median << " ms, submit " << submit.median << " ms\n";
+            passes.push_back(std::move(pass));
+        }
+
+        if (failed) {
+            std::cerr << "Error: the replay stopped early (see the log)\n";
+        }
+        if (!passes.empty() && WriteResults(outputPath, tracePath, trace, deviceInfo, skip, passes)) {
+            std::cout << "\nResults written to " << outputPath << "\n";
+            status = failed ? 1 : 0;
+        }
+    } else {
+        std::cerr << "Error: failed to create the graphics device (is the backend built in?)\n";
+    }
+
+    device.reset();
+    if (window) {
+        SDL_DestroyWindow(window);
+    }
+    SDL_Quit();
+    JobSystem::Shutdown();
+    return status;
+}
@@ -0,0 +1,228 @@
+// ============================================================================
+// tools/stream_client/VideoDecoder.cpp - H.264 Decoding of Streamed Frames
+// ============================================================================
+#include "VideoDecoder.h"
+#include "metagfx/core/Logger.h"
+
+#if defined(__APPLE__)
+#include <CoreFoundation/CoreFoundation.h>
+#include <CoreMedia/CoreMedia.h>
+#include <CoreVideo/CoreVideo.h>
+#include <VideoToolbox/VideoToolbox.h>
+
+#include <algorithm>
+#include <cstring>
+#endif
+
+namespace metagfx {
+namespace tools {
+
+#if defined(__APPLE__)
+
+namespace {
+
+constexpr uint8 NAL_IDR = 5;
+constexpr uint8 NAL_SPS = 7;
+constexpr uint8 NAL_PPS = 8;
+
+class VideoToolboxDecoder final : public VideoDecoder {
+public:
+    ~VideoToolboxDecoder() override { DestroySession(); }
+
+    Result Decode(const uint8* data, uint64 size, stream::FrameInfo& info, std::vector<uint8>& frame) override {
+        // Annex B to the length-prefixed units (AVCC) VideoToolbox takes, the parameter
+        // sets kept apart for the format description
+        m_Units.clear();
+        std::vector<uint8> sps;
+        std::vector<uint8> pps;
+        bool idr = false;
+        uint64 offset = FindUnit(data, size, 0);
+        while (offset < size) {
+            uint64 next = FindUnit(data, size, offset);
+            uint64 end = next < size ? next - 3 : size;
+            // A four-byte start code leaves a zero at the end of the unit before it
+            while (end > offset && data[end - 1] == 0) {
+                --end;
+            }
+            uint8 type = data[offset] & 0x1F;
+            if (type == NAL_SPS) {
+                sps.assign(data + offset, data + end);
+            } else if (type == NAL_PPS) {
+                pps.assign(data + offset, data + end);
+            } else {
+                uint32 length = static_cast<uint32>(end - offset);
+                uint8 prefix[4] = { static_cast<uint8>(length >> 24), static_cast<uint8>(length >> 16),
+                                    static_cast<uint8>(length >> 8), static_cast<uint8>(length) };
+                m_Units.insert(m_Units.end(), prefix, prefix + 4);
+                m_Units.insert(m_Units.end(), data + offset, data + end);
+                idr = idr || type == NAL_IDR;
+            }
+            offset = next;
+        }
+
+        if (idr) {
+            if (!sps.empty() && !pps.empty() && (sps != m_SPS || pps != m_PPS || !m_Session)) {
+                m_SPS = std::move(sps);
+                m_PPS = std::move(pps);
+                CreateSession();
+            }
+            m_WaitingForKeyFrame = !m_Session;
+        }
+        if (m_WaitingForKeyFrame || m_Units.empty()) {
+            return Result::Skipped;
+        }
+
+        CVPixelBufferRef image = DecodeUnits();
+        if (!image) {
+            // Made again from the next key frame's parameter sets
+            DestroySession();
+            m_WaitingForKeyFrame = true;
+            return Result::Failed;
+        }
+
+        // Row by row into the pitch of the decoder's luma rows
+        CVPixelBufferLockBaseAddress(image, kCVPixelBufferLock_ReadOnly);
+        uint32 pitch = static_cast<uint32>(CVPixelBufferGetBytesPerRowOfPlane(image, 0));
+        uint32 paddedHeight = (info.height + 1) / 2 * 2;
+        frame.assign(static_cast<uint64>(pitch) * paddedHeight * 3 / 2, 0);
+        uint8* planes[2] = { frame.data(), frame.data() + static_cast<uint64>(pitch) * paddedHeight };
+        for (size_t plane = 0; plane < 2; ++plane) {
+            auto* source = static_cast<const uint8*>(CVPixelBufferGetBaseAddressOfPlane(image, plane));
+            size_t sourcePitch = CVPixelBufferGetBytesPerRowOfPlane(image, plane);
+            size_t rows = std::min<size_t>(CVPixelBufferGetHeightOfPlane(image, plane),
+                                           plane == 0 ? paddedHeight : paddedHeight / 2);
+            size_t rowBytes = std::min<size_t>(sourcePitch, pitch);
+            for (size_t row = 0; row < rows; ++row) {
+                std::memcpy(planes[plane] + row * pitch, source + row * sourcePitch, rowBytes);
+            }
+        }
+        CVPixelBufferUnlockBaseAddress(image, kCVPixelBufferLock_ReadOnly);
+        CVPixelBufferRelease(image);
+
+        info.pitch = pitch;
+        info.format = stream::PixelFormat::NV12;
+        return Result::Decoded;
+    }
+
+private:
+    // Offset of the unit after the start code at or after offset; size if none
+    static uint64 FindUnit(const uint8* data, uint64 size, uint64 offset) {
+        for (uint64 i = offset; i + 3 <= size; ++i) {
+            if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+                return i + 3;
+            }
+        }
+        return size;
+    }
+
+    void CreateSession() {
+        DestroySession();
+
+        const uint8_t* parameterSets[] = { m_SPS.data(), m_PPS.data() };
+        const size_t parameterSetSizes[] = { m_SPS.size(), m_PPS.size() };
+        OSStatus status = CMVideoFormatDescriptionCreateFromH264ParameterSets(
+            kCFAllocatorDefault, 2, parameterSets, parameterSetSizes, 4, &m_Format);
+        if (status != noErr) {
+            METAGFX_ERROR << "Video decoder: invalid parameter sets (status " << status << ")";
+            m_Format = nullptr;
+            return;
+        }
+
+        // NV12 of the renderer's range, which SDL's texture takes as it is
+        int32_t pixelFormat = kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange;
+        CFNumberRef formatNumber = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &pixelFormat);
+        const void* keys[] = { kCVPixelBufferPixelFormatTypeKey };
+        const void* values[] = { formatNumber };
+        CFDictionaryRef imageAttributes = CFDictionaryCreate(kCFAllocatorDefault, keys, values, 1,
+                                                             &kCFTypeDictionaryKeyCallBacks,
+                                                             &kCFTypeDictionaryValueCallBacks);
+        VTDecompressionOutputCallbackRecord callback{ &VideoToolboxDecoder::OnFrameDecoded, nullptr };
+        status = VTDecompressionSessionCreate(kCFAllocatorDefault, m_Format, nullptr, imageAttributes, &callback,
+                                              &m_Session);
+        CFRelease(imageAttributes);
+        CFRelease(formatNumber);
+        if (status != noErr) {
+            METAGFX_ERROR << "Video decoder: cannot decode the stream (VideoToolbox status " << status << ")";
+            m_Session = nullptr;
+            return;
+        }
+        METAGFX_INFO << "Video decoder created: VideoToolbox H.264";
+    }
+
+    void DestroySession() {
+        if (m_Session) {
+            VTDecompressionSessionInvalidate(m_Session);
+            CFRelease(m_Session);
+            m_Session = nullptr;
+        }
+        if (m_Format) {
+            CFRelease(m_Format);
+            m_Format = nullptr;
+        }
+    }
+
+    // The image of m_Units, retained; null if it did not decode
+    CVPixelBufferRef DecodeUnits() {
+        CMBlockBufferRef block = nullptr;
+        if (CMBlockBufferCreateWithMemoryBlock(kCFAllocatorDefault, nullptr, m_Units.size(), kCFAllocatorDefault,
+                                               nullptr, 0, m_Units.size(), kCMBlockBufferAssureMemoryNowFlag,
+                                               &block) != kCMBlockBufferNoErr) {
+            return nullptr;
+        }
+        CMBlockBufferReplaceDataBytes(m_Units.data(), block, 0, m_Units.size());
+        CMSampleBufferRef sample = nullptr;
+        size_t sampleSize = m_Units.size();
+        OSStatus status = CMSampleBufferCreateReady(kCFAllocatorDefault, block, m_Format, 1, 0, nullptr, 1,
+                                                    &sampleSize, &sample);
+        CFRelease(block);
+        if (status != noErr) {
+            return nullptr;
+        }
+
+        // Without the asynchronous flag the output callback runs before this returns
+        CVPixelBufferRef image = nullptr;
+        VTDecodeInfoFlags flags = 0;
+        status = VTDecompressionSessionDecodeFrame(m_Session, sample, 0, &image, &flags);
+        CFRelease(sample);
+        if (status != noErr) {
+            METAGFX_WARN << "Video decoder: frame failed (VideoToolbox status " << status << ")";
+            if (image) {
+                CVPixelBufferRelease(image);
+            }
+            return nullptr;
+        }
+        return image;
+    }
+
+    static void OnFrameDecoded(void*, void* frameRefcon, OSStatus status, VTDecodeInfoFlags, CVImageBufferRef image,
+                               CMTime, CMTime) {
+        if (status == noErr && image) {
+            *static_cast<CVPixelBufferRef*>(frameRefcon) = CVPixelBufferRetain(image);
+        }
+    }
+
+    VTDecompressionSessionRef m_Session = nullptr;
+    CMVideoFormatDescriptionRef m_Format = nullptr;
+    std::vector<uint8> m_SPS;
+    std::vector<uint8> m_PPS;
+    std::vector<uint8> m_Units;           // Of the access unit being decoded
+    bool m_WaitingForKeyFrame = true;
+};
+
+} // namespace
+
+std::unique_ptr<VideoDecoder> VideoDecoder::CreateH264() {
+    return std::make_unique<VideoToolboxDecoder>();
+}
+
+#else
+
+// No decoder off Apple platforms: the client asks for NV12
+std::unique_ptr<VideoDecoder> VideoDecoder::CreateH264() {
+    return nullptr;
+}
+
+#endif
+
+} // namespace tools
+} // namespace metagfx
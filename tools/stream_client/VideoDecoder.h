@@ -0,0 +1,41 @@
+// ============================================================================
+// tools/stream_client/VideoDecoder.h - H.264 Decoding of Streamed Frames
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/StreamProtocol.h"
+#include "metagfx/core/Types.h"
+#include <memory>
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+/**
+ * @brief The platform's H.264 decoder, which turns the renderer's access units back
+ * into the NV12 frames SDL's renderer shows
+ *
+ * Apple: a VideoToolbox decompression session, made again whenever the sequence or
+ * picture parameter set of a key frame changes. Other platforms have none (CreateH264()
+ * returns null), and the client asks for NV12 only.
+ */
+class VideoDecoder {
+public:
+    enum class Result {
+        Decoded,
+        Skipped,  // Waiting for a key frame, which the renderer already sends
+        Failed    // Lost its place: frames are skipped until the renderer sends a key frame
+    };
+
+    // Null where the platform has no decoder
+    static std::unique_ptr<VideoDecoder> CreateH264();
+
+    virtual ~VideoDecoder() = default;
+
+    // Decode an Annex B access unit (stream::PixelFormat::H264) into frame, an NV12
+    // frame of info's size; info takes the pitch and the format of it
+    virtual Result Decode(const uint8* data, uint64 size, stream::FrameInfo& info, std::vector<uint8>& frame) = 0;
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,330 @@
+// ============================================================================
+// tools/stream_client/main.cpp - Remote Viewer for Streamed Rendering
+// ============================================================================
+#include "VideoDecoder.h"
+#include "metagfx/core/Logger.h"
+#include "metagfx/core/Socket.h"
+#include "metagfx/core/StreamProtocol.h"
+#include "metagfx/core/Types.h"
+
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace metagfx;
+
+namespace {
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX Stream Client\n";
+    std::cout << "=====================\n\n";
+    std::cout << "Usage: " << programName << " [host] [port]\n\n";
+    std::cout << "Shows the frames of a renderer started with --stream and sends it this\n";
+    std::cout << "window's mouse and keyboard input. Escape closes the client only. Frames\n";
+    std::cout << "arrive as H.264 where this platform decodes it, raw NV12 otherwise.\n\n";
+    std::cout << "Arguments:\n";
+    std::cout << "  host         Address or name of the renderer (default: localhost)\n";
+    std::cout << "  port         Its stream port (default: " << stream::DEFAULT_PORT << ")\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " render-box.local 7420\n";
+}
+
+// The newest frame received; the receive thread replaces it, frames not shown yet too
+struct LatestFrame {
+    std::mutex mutex;
+    stream::FrameInfo info;
+    std::vector<uint8> data;
+    bool fresh = false;
+};
+
+bool ReceiveAll(Socket& socket, void* data, uint64 size) {
+    uint8* bytes = static_cast<uint8*>(data);
+    while (size > 0) {
+        int64 received = socket.Receive(bytes, size);
+        if (received <= 0) {
+            return false;
+        }
+        bytes += received;
+        size -= static_cast<uint64>(received);
+    }
+    return true;
+}
+
+// H.264 frames are decoded here, each of them, since every one predicts from the one
+// before; a frame that fails sets keyFrameNeeded for the main thread to ask for one
+void ReceiveFrames(Socket& socket, LatestFrame& latest, tools::VideoDecoder* decoder, std::atomic<bool>& connected,
+                   std::atomic<bool>& keyFrameNeeded) {
+    std::vector<uint8> data;
+    std::vector<uint8> decoded;
+    while (connected) {
+        stream::MessageHeader header;
+        if (!ReceiveAll(socket, &header, sizeof(header)) || header.magic != stream::MAGIC) {
+            break;
+        }
+        if (header.type != stream::MessageType::Frame || header.size < sizeof(stream::FrameInfo)) {
+            // Not ours to show: skip its payload
+            data.resize(header.size);
+            if (!ReceiveAll(socket, data.data(), header.size)) {
+                break;
+            }
+            continue;
+        }
+
+        stream::FrameInfo info;
+        data.resize(header.size - sizeof(info));
+        if (!ReceiveAll(socket, &info, sizeof(info)) || !ReceiveAll(socket, data.data(), data.size())) {
+            break;
+        }
+        if (info.format == stream::PixelFormat::H264) {
+            tools::VideoDecoder::Result result =
+                decoder ? decoder->Decode(data.data(), data.size(), info, decoded) : tools::VideoDecoder::Result::Failed;
+            if (result == tools::VideoDecoder::Result::Failed) {
+                keyFrameNeeded = true;
+            }
+            if (result != tools::VideoDecoder::Result::Decoded) {
+                continue;
+            }
+            data.swap(decoded);
+        }
+        std::lock_guard<std::mutex> lock(latest.mutex);
+        latest.info = info;
+        latest.data.swap(data);
+        latest.fresh = true;
+    }
+    connected = false;
+}
+
+template<typename T>
+bool SendToRenderer(Socket& socket, stream::MessageType type, const T& payload) {
+    stream::MessageHeader header;
+    header.type = type;
+    header.size = sizeof(payload);
+    return socket.SendAll(&header, sizeof(header)) && socket.SendAll(&payload, sizeof(payload));
+}
+
+bool SendToRenderer(Socket& socket, stream::MessageType type) {
+    stream::MessageHeader header;
+    header.type = type;
+    header.size = 0;
+    return socket.SendAll(&header, sizeof(header));
+}
+
+// The event in the renderer's terms, its positions in pixels of the frame; false for
+// events the renderer does not take
+bool ToInputEvent(const SDL_Event& event, float scaleX, float scaleY, stream::InputEvent& input) {
+    switch (event.type) {
+        case SDL_EVENT_MOUSE_MOTION:
+            input.kind = stream::InputKind::MouseMotion;
+            input.x = event.motion.x * scaleX;
+            input.y = event.motion.y * scaleY;
+            input.deltaX = event.motion.xrel * scaleX;
+            input.deltaY = event.motion.yrel * scaleY;
+            input.modifiers = event.motion.state;
+            return true;
+
+        case SDL_EVENT_MOUSE_BUTTON_DOWN:
+        case SDL_EVENT_MOUSE_BUTTON_UP:
+            input.kind = event.type == SDL_EVENT_MOUSE_BUTTON_DOWN ? stream::InputKind::MouseButtonDown
+                                                                   : stream::InputKind::MouseButtonUp;
+            input.code = event.button.button;
+            input.x = event.button.x * scaleX;
+            input.y = event.button.y * scaleY;
+            return true;
+
+        case SDL_EVENT_MOUSE_WHEEL:
+            input.kind = stream::InputKind::MouseWheel;
+            input.x = event.wheel.x;
+            input.y = event.wheel.y;
+            return true;
+
+        case SDL_EVENT_KEY_DOWN:
+        case SDL_EVENT_KEY_UP:
+            // The renderer repeats held keys itself
+            if (event.key.repeat) {
+                return false;
+            }
+            input.kind = event.type == SDL_EVENT_KEY_DOWN ? stream::InputKind::KeyDown : stream::InputKind::KeyUp;
+            input.code = event.key.scancode;
+            input.keycode = event.key.key;
+            input.modifiers = event.key.mod;
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+SDL_Texture* CreateFrameTexture(SDL_Renderer* renderer, uint32 width, uint32 height) {
+    // NV12 chroma covers 2x2 pixels, so the texture is even on both sides
+    SDL_PropertiesID props = SDL_CreateProperties();
+    SDL_SetNumberProperty(props, SDL_PROP_TEXTURE_CREATE_FORMAT_NUMBER, SDL_PIXELFORMAT_NV12);
+    SDL_SetNumberProperty(props, SDL_PROP_TEXTURE_CREATE_ACCESS_NUMBER, SDL_TEXTUREACCESS_STREAMING);
+    SDL_SetNumberProperty(props, SDL_PROP_TEXTURE_CREATE_WIDTH_NUMBER, (width + 1) / 2 * 2);
+    SDL_SetNumberProperty(props, SDL_PROP_TEXTURE_CREATE_HEIGHT_NUMBER, (height + 1) / 2 * 2);
+    SDL_SetNumberProperty(props, SDL_PROP_TEXTURE_CREATE_COLORSPACE_NUMBER, SDL_COLORSPACE_BT709_LIMITED);
+    SDL_Texture* texture = SDL_CreateTextureWithProperties(renderer, props);
+    SDL_DestroyProperties(props);
+    return texture;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::string host = "localhost";
+    uint16 port = stream::DEFAULT_PORT;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        }
+    }
+    if (argc > 1) {
+        host = argv[1];
+    }
+    if (argc > 2) {
+        port = static_cast<uint16>(std::atoi(argv[2]));
+    }
+
+    Logger::Init();
+
+    Socket socket = Socket::Connect(host.c_str(), port);
+    if (!socket.IsValid()) {
+        std::cerr << "Error: cannot connect to " << host << ":" << port << "\n";
+        return 1;
+    }
+    // Input and acknowledgements are small and should leave at once
+    socket.SetNoDelay(true);
+    std::cout << "Connected to " << host << ":" << port << "\n";
+
+    // The renderer sends H.264 only to a client that says it decodes it
+    std::unique_ptr<tools::VideoDecoder> decoder = tools::VideoDecoder::CreateH264();
+    stream::ClientHello hello;
+    if (decoder) {
+        hello.formats |= stream::FormatBit(stream::PixelFormat::H264);
+    }
+    if (!SendToRenderer(socket, stream::MessageType::Hello, hello)) {
+        std::cerr << "Error: lost the connection to " << host << ":" << port << "\n";
+        return 1;
+    }
+    std::cout << "Decoding " << (decoder ? "H.264 and raw NV12" : "raw NV12 only") << "\n";
+
+    if (!SDL_Init(SDL_INIT_VIDEO)) {
+        std::cerr << "Error: failed to initialize SDL: " << SDL_GetError() << "\n";
+        return 1;
+    }
+    SDL_Window* window = nullptr;
+    SDL_Renderer* renderer = nullptr;
+    if (!SDL_CreateWindowAndRenderer("MetaGFX Stream", 1280, 720, SDL_WINDOW_RESIZABLE, &window, &renderer)) {
+        std::cerr << "Error: failed to create the window: " << SDL_GetError() << "\n";
+        SDL_Quit();
+        return 1;
+    }
+    // Presents as soon as a frame arrives rather than at the display's next refresh
+    SDL_SetRenderVSync(renderer, 0);
+
+    LatestFrame latest;
+    std::atomic<bool> connected{ true };
+    std::atomic<bool> keyFrameNeeded{ false };
+    std::thread receiver([&]() { ReceiveFrames(socket, latest, decoder.get(), connected, keyFrameNeeded); });
+
+    SDL_Texture* texture = nullptr;
+    stream::FrameInfo shown;  // Of the frame on screen
+    std::vector<uint8> frameData;
+    bool running = true;
+    while (running && connected) {
+        // Window positions map to the frame's pixels however the window is sized
+        int windowWidth = 1;
+        int windowHeight = 1;
+        SDL_GetWindowSize(window, &windowWidth, &windowHeight);
+        float scaleX = shown.width > 0 ? static_cast<float>(shown.width) / std::max(windowWidth, 1) : 1.0f;
+        float scaleY = shown.height > 0 ? static_cast<float>(shown.height) / std::max(windowHeight, 1) : 1.0f;
+
+        SDL_Event event;
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_EVENT_QUIT ||
+                (event.type == SDL_EVENT_KEY_DOWN && event.key.key == SDLK_ESCAPE)) {
+                running = false;
+                break;
+            }
+            stream::InputEvent input;
+            if (ToInputEvent(event, scaleX, scaleY, input) &&
+                !SendToRenderer(socket, stream::MessageType::Input, input)) {
+                connected = false;
+            }
+        }
+
+        // Sent from here, where the rest of the client's messages are
+        if (keyFrameNeeded.exchange(false) && !SendToRenderer(socket, stream::MessageType::KeyFrameRequest)) {
+            connected = false;
+        }
+
+        bool fresh = false;
+        {
+            std::lock_guard<std::mutex> lock(latest.mutex);
+            if (latest.fresh) {
+                fresh = true;
+                latest.fresh = false;
+                frameData.swap(latest.data);
+                if (latest.info.width != shown.width || latest.info.height != shown.height || !texture) {
+                    if (texture) {
+                        SDL_DestroyTexture(texture);
+                    }
+                    texture = CreateFrameTexture(renderer, latest.info.width, latest.info.height);
+                    if (!shown.width) {
+                        SDL_SetWindowSize(window, static_cast<int>(latest.info.width),
+                                          static_cast<int>(latest.info.height));
+                    }
+                }
+                shown = latest.info;
+            }
+        }
+        if (!fresh) {
+            SDL_Delay(1);
+            continue;
+        }
+
+        uint32 paddedHeight = (shown.height + 1) / 2 * 2;
+        uint64 lumaSize = static_cast<uint64>(shown.pitch) * paddedHeight;
+        if (texture && shown.format == stream::PixelFormat::NV12 && frameData.size() >= lumaSize * 3 / 2) {
+            SDL_UpdateNVTexture(texture, nullptr, frameData.data(), static_cast<int>(shown.pitch),
+                                frameData.data() + lumaSize, static_cast<int>(shown.pitch));
+        }
+        SDL_FRect source{ 0.0f, 0.0f, static_cast<float>(shown.width), static_cast<float>(shown.height) };
+        SDL_RenderClear(renderer);
+        if (texture) {
+            SDL_RenderTexture(renderer, texture, &source, nullptr);
+        }
+        SDL_RenderPresent(renderer);
+
+        // On screen now: the renderer measures its latency up to here
+        stream::FrameAck ack;
+        ack.frameNumber = shown.frameNumber;
+        if (!SendToRenderer(socket, stream::MessageType::FrameAck, ack)) {
+            connected = false;
+        }
+    }
+
+    if (!connected) {
+        std::cout << "Disconnected from " << host << ":" << port << "\n";
+    }
+    connected = false;
+    socket.Shutdown();  // Ends the receive thread's blocking read
+    receiver.join();
+
+    if (texture) {
+        SDL_DestroyTexture(texture);
+    }
+    SDL_DestroyRenderer(renderer);
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,192 @@
+// ============================================================================
+// tools/texture_cook/BlockCompressor.cpp
+// ============================================================================
+#include "BlockCompressor.h"
+#include <algorithm>
+#include <cstring>
+
+namespace metagfx {
+namespace tools {
+
+static uint16 To565(const int color[3]) {
+    return static_cast<uint16>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+
+static void From565(uint16 packed, int color[3]) {
+    int r = (packed >> 11) & 0x1F;
+    int g = (packed >> 5) & 0x3F;
+    int b = packed & 0x1F;
+    color[0] = (r << 3) | (r >> 2);
+    color[1] = (g << 2) | (g >> 4);
+    color[2] = (b << 3) | (b >> 2);
+}
+
+void BlockCompressor::EncodeBC1(const uint8 block[64], uint8* out) {
+    int minColor[3] = { 255, 255, 255 };
+    int maxColor[3] = { 0, 0, 0 };
+    for (uint32 i = 0; i < 16; ++i) {
+        for (uint32 c = 0; c < 3; ++c) {
+            minColor[c] = std::min(minColor[c], static_cast<int>(block[i * 4 + c]));
+            maxColor[c] = std::max(maxColor[c], static_cast<int>(block[i * 4 + c]));
+        }
+    }
+
+    // The bounding box diagonal only follows the colors when all channels rise together.
+    // Flip the channels that anti-correlate with the widest one.
+    uint32 reference = 0;
+    for (uint32 c = 1; c < 3; ++c) {
+        if (maxColor[c] - minColor[c] > maxColor[reference] - minColor[reference]) {
+            reference = c;
+        }
+    }
+    for (uint32 c = 0; c < 3; ++c) {
+        if (c == reference) {
+            continue;
+        }
+        int covariance = 0;
+        int centerC = minColor[c] + maxColor[c];
+        int centerRef = minColor[reference] + maxColor[reference];
+        for (uint32 i = 0; i < 16; ++i) {
+            covariance += (2 * block[i * 4 + c] - centerC) * (2 * block[i * 4 + reference] - centerRef);
+        }
+        if (covariance < 0) {
+            std::swap(minColor[c], maxColor[c]);
+        }
+    }
+
+    // Inset the endpoints by 1/16 of the range to reduce the error of the outer texels
+    for (uint32 c = 0; c < 3; ++c) {
+        int inset = (maxColor[c] - minColor[c]) / 16;
+        maxColor[c] = std::clamp(maxColor[c] - inset, 0, 255);
+        minColor[c] = std::clamp(minColor[c] + inset, 0, 255);
+    }
+
+    uint16 color0 = To565(maxColor);
+    uint16 color1 = To565(minColor);
+    if (color0 < color1) {
+        std::swap(color0, color1);  // color0 > color1 selects the opaque 4-color mode
+    }
+
+    uint32 indices = 0;
+    if (color0 != color1) {
+        int palette[4][3];
+        From565(color0, palette[0]);
+        From565(color1, palette[1]);
+        for (uint32 c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+
+        for (uint32 i = 0; i < 16; ++i) {
+            uint32 best = 0;
+            int bestDistance = 0x7FFFFFFF;
+            for (uint32 p = 0; p < 4; ++p) {
+                int dr = block[i * 4 + 0] - palette[p][0];
+                int dg = block[i * 4 + 1] - palette[p][1];
+                int db = block[i * 4 + 2] - palette[p][2];
+                int distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 2);
+        }
+    }
+
+    // Little-endian: color0, color1, 2-bit indices (texel 0 in the low bits)
+    out[0] = static_cast<uint8>(color0 & 0xFF);
+    out[1] = static_cast<uint8>(color0 >> 8);
+    out[2] = static_cast<uint8>(color1 & 0xFF);
+    out[3] = static_cast<uint8>(color1 >> 8);
+    for (uint32 b = 0; b < 4; ++b) {
+        out[4 + b] = static_cast<uint8>((indices >> (b * 8)) & 0xFF);
+    }
+}
+
+void BlockCompressor::EncodeAlphaBlock(const uint8 block[64], uint32 channel, uint8* out) {
+    int minValue = 255;
+    int maxValue = 0;
+    for (uint32 i = 0; i < 16; ++i) {
+        minValue = std::min(minValue, static_cast<int>(block[i * 4 + channel]));
+        maxValue = std::max(maxValue, static_cast<int>(block[i * 4 + channel]));
+    }
+
+    out[0] = static_cast<uint8>(maxValue);
+    out[1] = static_cast<uint8>(minValue);
+
+    uint64 indices = 0;
+    if (maxValue != minValue) {
+        // value0 > value1 selects the 8-value mode: 0 = value0, 1 = value1, 2..7 interpolated
+        int palette[8];
+        palette[0] = maxValue;
+        palette[1] = minValue;
+        for (int p = 2; p < 8; ++p) {
+            palette[p] = ((8 - p) * maxValue + (p - 1) * minValue + 3) / 7;
+        }
+
+        for (uint32 i = 0; i < 16; ++i) {
+            int value = block[i * 4 + channel];
+            uint64 best = 0;
+            int bestDistance = 256;
+            for (uint32 p = 0; p < 8; ++p) {
+                int distance = std::abs(value - palette[p]);
+                if (distance < bestDistance) {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= best << (i * 3);
+        }
+    }
+
+    // 48 bits of 3-bit indices, little-endian
+    for (uint32 b = 0; b < 6; ++b) {
+        out[2 + b] = static_cast<uint8>((indices >> (b * 8)) & 0xFF);
+    }
+}
+
+void BlockCompressor::CompressImage(const uint8* rgba, uint32 width, uint32 height,
+                                    BlockFormat format, std::vector<uint8>& outData) {
+    uint32 blocksX = (width + 3) / 4;
+    uint32 blocksY = (height + 3) / 4;
+    uint32 blockSize = GetBlockSize(format);
+
+    size_t offset = outData.size();
+    outData.resize(offset + static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+    uint8 block[64];
+    for (uint32 by = 0; by < blocksY; ++by) {
+        for (uint32 bx = 0; bx < blocksX; ++bx) {
+            for (uint32 y = 0; y < 4; ++y) {
+                uint32 srcY = std::min(by * 4 + y, height - 1);
+                for (uint32 x = 0; x < 4; ++x) {
+                    uint32 srcX = std::min(bx * 4 + x, width - 1);
+                    std::memcpy(&block[(y * 4 + x) * 4], &rgba[(static_cast<size_t>(srcY) * width + srcX) * 4], 4);
+                }
+            }
+
+            uint8* out = &outData[offset];
+            switch (format) {
+                case BlockFormat::BC1:
+                    EncodeBC1(block, out);
+                    break;
+                case BlockFormat::BC3:
+                    EncodeAlphaBlock(block, 3, out);
+                    EncodeBC1(block, out + 8);
+                    break;
+                case BlockFormat::BC4:
+                    EncodeAlphaBlock(block, 0, out);
+                    break;
+                case BlockFormat::BC5:
+                    EncodeAlphaBlock(block, 0, out);
+                    EncodeAlphaBlock(block, 1, out + 8);
+                    break;
+            }
+            offset += blockSize;
+        }
+    }
+}
+
+} // namespace tools
+} // namespace metagfx
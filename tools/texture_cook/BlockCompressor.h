@@ -0,0 +1,38 @@
+// ============================================================================
+// tools/texture_cook/BlockCompressor.h - CPU BC1/BC3/BC4/BC5 Block Encoders
+// ============================================================================
+#pragma once
+
+#include "metagfx/core/Types.h"
+#include <vector>
+
+namespace metagfx {
+namespace tools {
+
+// Block formats the cooker writes
+enum class BlockFormat {
+    BC1,  // RGB, 8 bytes per 4x4 block (alpha ignored)
+    BC3,  // RGBA, 16 bytes per block (BC4-style alpha + BC1 color)
+    BC4,  // Single channel from R, 8 bytes per block
+    BC5   // Two channels from R and G (two BC4 blocks), 16 bytes per block
+};
+
+// Fast bounding-box encoders (no iterative endpoint refinement); quality is in line
+// with real-time DXT compressors, which is what data and color maps on meshes need.
+// sRGB data is encoded as stored - the GPU decodes the palette in gamma space too.
+class BlockCompressor {
+public:
+    static uint32 GetBlockSize(BlockFormat format) { return format == BlockFormat::BC3 || format == BlockFormat::BC5 ? 16 : 8; }
+
+    // Compress one tightly packed RGBA8 image. Edge blocks of sizes that are not a
+    // multiple of 4 repeat the last row/column. Appends to outData.
+    static void CompressImage(const uint8* rgba, uint32 width, uint32 height,
+                              BlockFormat format, std::vector<uint8>& outData);
+
+private:
+    static void EncodeBC1(const uint8 block[64], uint8* out);
+    static void EncodeAlphaBlock(const uint8 block[64], uint32 channel, uint8* out);
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,289 @@
+// ============================================================================
+// tools/texture_cook/TextureCooker.cpp
+// ============================================================================
+#include "TextureCooker.h"
+#include "DDSWriter.h"
+#include "metagfx/rhi/FormatInfo.h"
+#include "metagfx/rhi/MipGenerator.h"
+#include "metagfx/utils/TextureManifest.h"
+#include "metagfx/utils/TextureUtils.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <set>
+
+namespace metagfx {
+namespace tools {
+
+// DXGI formats written by the cooker
+constexpr uint32 DXGI_FORMAT_BC1_UNORM = 71;
+constexpr uint32 DXGI_FORMAT_BC1_UNORM_SRGB = 72;
+constexpr uint32 DXGI_FORMAT_BC3_UNORM_SRGB = 78;
+constexpr uint32 DXGI_FORMAT_BC4_UNORM = 80;
+constexpr uint32 DXGI_FORMAT_BC5_UNORM = 83;
+
+bool TextureCooker::IsSRGBSlot(TextureSlot slot) {
+    return slot == TextureSlot::Albedo || slot == TextureSlot::Emissive;
+}
+
+std::vector<TextureCooker::TextureRef> TextureCooker::CollectTextures(const aiScene* scene) {
+    std::vector<TextureRef> refs;
+
+    auto collect = [&](const aiMaterial* material, aiTextureType type, TextureSlot slot) {
+        aiString texPath;
+        if (material->GetTextureCount(type) > 0 &&
+            material->GetTexture(type, 0, &texPath) == AI_SUCCESS && texPath.length > 0) {
+            refs.push_back({ texPath.C_Str(), slot });
+            return true;
+        }
+        return false;
+    };
+
+    // Mirrors ProcessMaterial in src/scene/Model.cpp
+    for (uint32 i = 0; i < scene->mNumMaterials; ++i) {
+        const aiMaterial* material = scene->mMaterials[i];
+
+        collect(material, aiTextureType_DIFFUSE, TextureSlot::Albedo);
+        collect(material, aiTextureType_NORMALS, TextureSlot::Normal);
+        bool hasMetallicRoughness = collect(material, aiTextureType_METALNESS, TextureSlot::MetallicRoughness);
+        if (!hasMetallicRoughness) {
+            collect(material, aiTextureType_DIFFUSE_ROUGHNESS, TextureSlot::Roughness);
+        }
+        collect(material, aiTextureType_AMBIENT_OCCLUSION, TextureSlot::AmbientOcclusion);
+        collect(material, aiTextureType_EMISSIVE, TextureSlot::Emissive);
+
+        aiString texPath;
+        if (material->GetTextureCount(aiTextureType_UNKNOWN) > 0 &&
+            material->GetTexture(aiTextureType_UNKNOWN, 0, &texPath) == AI_SUCCESS && texPath.length > 0) {
+            std::string pathStr = texPath.C_Str();
+            if (pathStr.find("metallicRoughness") != std::string::npos ||
+                pathStr.find("MetallicRoughness") != std::string::npos ||
+                pathStr.find("metallic_roughness") != std::string::npos ||
+                pathStr[0] == '*') {
+                refs.push_back({ pathStr, TextureSlot::MetallicRoughness });
+            }
+        }
+    }
+
+    return refs;
+}
+
+std::string TextureCooker::MakeCookedFileName(const std::string& texPath, bool srgb) {
+    std::string name;
+    if (texPath[0] == '*') {
+        name = "embedded" + texPath.substr(1);
+    } else {
+        // Flatten the relative path so textures from different folders cannot collide
+        name = std::filesystem::path(texPath).lexically_normal().generic_string();
+        for (char& c : name) {
+            if (c == '/' || c == '\\' || c == ':' || c == ' ') {
+                c = '_';
+            }
+        }
+        std::replace(name.begin(), name.end(), '.', '_');
+    }
+    return name + (srgb ? ".srgb.dds" : ".linear.dds");
+}
+
+bool TextureCooker::CookTexture(const aiScene* scene, const std::string& modelDir, const TextureRef& ref,
+                                const std::string& outputPath) {
+    bool srgb = IsSRGBSlot(ref.slot);
+
+    // Decode the source to RGBA8
+    utils::ImageData image;
+    std::vector<uint8> rawPixels;  // Uncompressed embedded textures (BGRA aiTexels)
+    if (ref.path[0] == '*') {
+        int textureIndex = std::atoi(ref.path.c_str() + 1);
+        if (textureIndex < 0 || static_cast<uint32>(textureIndex) >= scene->mNumTextures) {
+            std::cerr << "  Invalid embedded texture index: " << ref.path << std::endl;
+            return false;
+        }
+
+        const aiTexture* embedded = scene->mTextures[textureIndex];
+        if (embedded->mHeight == 0) {
+            const uint8* data = reinterpret_cast<const uint8*>(embedded->pcData);
+            if (utils::IsKTX2Data(data, embedded->mWidth)) {
+                std::cout << "  Skipping " << ref.path << " (already KTX2)" << std::endl;
+                return false;
+            }
+            image = utils::LoadImageFromMemory(data, embedded->mWidth, 4);
+        } else {
+            uint32 texelCount = embedded->mWidth * embedded->mHeight;
+            rawPixels.resize(static_cast<size_t>(texelCount) * 4);
+            for (uint32 i = 0; i < texelCount; ++i) {
+                const aiTexel& texel = embedded->pcData[i];
+                rawPixels[i * 4 + 0] = texel.r;
+                rawPixels[i * 4 + 1] = texel.g;
+                rawPixels[i * 4 + 2] = texel.b;
+                rawPixels[i * 4 + 3] = texel.a;
+            }
+            image = { rawPixels.data(), embedded->mWidth, embedded->mHeight, 4 };
+        }
+    } else {
+        std::filesystem::path sourcePath = std::filesystem::path(modelDir) / ref.path;
+        std::string extension = sourcePath.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".dds" || extension == ".ktx2") {
+            std::cout << "  Skipping " << ref.path << " (already GPU-ready)" << std::endl;
+            return false;
+        }
+        image = utils::LoadImage(sourcePath.string(), 4);
+    }
+
+    if (!image.pixels) {
+        std::cerr << "  Failed to decode texture: " << ref.path << std::endl;
+        return false;
+    }
+
+    uint32 width = image.width;
+    uint32 height = image.height;
+    uint32 mipLevels = rhi::CalculateMipLevels(width, height);
+
+    // Pick the block format for the slot
+    BlockFormat blockFormat = BlockFormat::BC1;
+    rhi::Format rhiFormat = srgb ? rhi::Format::BC1_RGBA_SRGB : rhi::Format::BC1_RGBA_UNORM;
+    uint32 dxgiFormat = srgb ? DXGI_FORMAT_BC1_UNORM_SRGB : DXGI_FORMAT_BC1_UNORM;
+
+    if (ref.slot == TextureSlot::Roughness || ref.slot == TextureSlot::AmbientOcclusion) {
+        blockFormat = BlockFormat::BC4;
+        rhiFormat = rhi::Format::BC4_R_UNORM;
+        dxgiFormat = DXGI_FORMAT_BC4_UNORM;
+    } else if (ref.slot == TextureSlot::Normal) {
+        blockFormat = BlockFormat::BC5;
+        rhiFormat = rhi::Format::BC5_RG_UNORM;
+        dxgiFormat = DXGI_FORMAT_BC5_UNORM;
+    } else if (ref.slot == TextureSlot::Albedo) {
+        uint64 texelCount = static_cast<uint64>(width) * height;
+        bool hasAlpha = false;
+        for (uint64 i = 0; i < texelCount && !hasAlpha; ++i) {
+            hasAlpha = image.pixels[i * 4 + 3] != 255;
+        }
+        if (hasAlpha) {
+            blockFormat = BlockFormat::BC3;
+            rhiFormat = rhi::Format::BC3_RGBA_SRGB;
+            dxgiFormat = DXGI_FORMAT_BC3_UNORM_SRGB;
+        }
+    }
+
+    // Full mip chain (sRGB slots are filtered in linear space)
+    std::vector<uint8> mipChain;
+    rhi::Format mipFormat = srgb ? rhi::Format::R8G8B8A8_SRGB : rhi::Format::R8G8B8A8_UNORM;
+    bool mipsOk = rhi::GenerateMipChainCPU(image.pixels, width, height, 1, mipLevels, mipFormat, mipChain);
+
+    if (rawPixels.empty()) {
+        utils::FreeImage(image);
+    }
+    if (!mipsOk) {
+        std::cerr << "  Failed to generate mip chain for: " << ref.path << std::endl;
+        return false;
+    }
+
+    // Compress every level
+    std::vector<uint8> compressed;
+    compressed.reserve(mipChain.size() / 4);
+    size_t mipOffset = 0;
+    for (uint32 mip = 0; mip < mipLevels; ++mip) {
+        uint32 mipWidth = std::max(1u, width >> mip);
+        uint32 mipHeight = std::max(1u, height >> mip);
+        BlockCompressor::CompressImage(&mipChain[mipOffset], mipWidth, mipHeight, blockFormat, compressed);
+        mipOffset += static_cast<size_t>(mipWidth) * mipHeight * 4;
+    }
+
+    if (!DDSWriter::WriteTexture2DMips(outputPath, dxgiFormat, width, height, mipLevels, compressed,
+                                       rhi::GetFormatImageSize(rhiFormat, width, height))) {
+        return false;
+    }
+
+    const char* formatNames[] = { "BC1", "BC3", "BC4", "BC5" };
+    const char* formatName = formatNames[static_cast<int>(blockFormat)];
+    std::cout << "  " << ref.path << " -> " << std::filesystem::path(outputPath).filename().string()
+              << " (" << width << "x" << height << ", " << mipLevels << " mips, " << formatName
+              << (srgb ? " sRGB" : "") << ", " << (compressed.size() / 1024) << " KB)" << std::endl;
+    return true;
+}
+
+bool TextureCooker::CookModel(const std::string& modelPath) {
+    // Only materials and embedded textures are needed, so no post-processing
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFile(modelPath, 0);
+    if (!scene) {
+        std::cerr << "Failed to load model: " << importer.GetErrorString() << std::endl;
+        return false;
+    }
+
+    std::filesystem::path modelFile(modelPath);
+    std::filesystem::path modelDir = modelFile.parent_path();
+    if (modelDir.empty()) {
+        modelDir = ".";
+    }
+
+    std::filesystem::path outputDir(m_Settings.outputDir);
+    if (outputDir.is_relative()) {
+        outputDir = modelDir / outputDir;
+    }
+    std::filesystem::create_directories(outputDir);
+
+    std::error_code ec;
+    auto modelTime = std::filesystem::last_write_time(modelFile, ec);
+
+    utils::TextureManifest manifest;
+    std::set<std::string> cookedKeys;
+    uint32 cookedCount = 0;
+    uint32 upToDateCount = 0;
+    uint32 failedCount = 0;
+
+    for (const TextureRef& ref : CollectTextures(scene)) {
+        bool srgb = IsSRGBSlot(ref.slot);
+        if (!cookedKeys.insert((srgb ? "srgb:" : "linear:") + ref.path).second) {
+            continue;  // Shared by several materials
+        }
+
+        std::filesystem::path outputPath = outputDir / MakeCookedFileName(ref.path, srgb);
+
+        // Embedded textures change with the model file, external ones with their image file
+        bool upToDate = false;
+        if (!m_Settings.force && std::filesystem::exists(outputPath, ec)) {
+            auto sourceTime = modelTime;
+            bool haveSourceTime = true;
+            if (ref.path[0] != '*') {
+                sourceTime = std::filesystem::last_write_time(modelDir / ref.path, ec);
+                haveSourceTime = !ec;
+            }
+            auto cookedTime = std::filesystem::last_write_time(outputPath, ec);
+            upToDate = haveSourceTime && !ec && cookedTime >= sourceTime;
+        }
+
+        if (upToDate) {
+            ++upToDateCount;
+        } else if (CookTexture(scene, modelDir.string(), ref, outputPath.string())) {
+            ++cookedCount;
+        } else {
+            ++failedCount;
+            continue;
+        }
+
+        // Cooked paths are stored relative to the manifest (next to the model)
+        std::filesystem::path relativePath = std::filesystem::relative(outputPath, modelDir, ec);
+        manifest.Add(ref.path, srgb, (ec ? outputPath : relativePath).generic_string());
+    }
+
+    std::string manifestPath = utils::TextureManifest::GetPathForModel(modelPath);
+    if (!manifest.Save(manifestPath)) {
+        std::cerr << "Failed to write texture manifest: " << manifestPath << std::endl;
+        return false;
+    }
+
+    std::cout << "Cooked " << cookedCount << " textures (" << upToDateCount << " up to date, "
+              << failedCount << " skipped or failed)" << std::endl;
+    std::cout << "Manifest: " << manifestPath << std::endl;
+    return true;
+}
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,59 @@
+// ============================================================================
+// tools/texture_cook/TextureCooker.h - Offline Texture Cooking
+// ============================================================================
+#pragma once
+
+#include "BlockCompressor.h"
+#include "metagfx/core/Types.h"
+#include <string>
+#include <vector>
+
+struct aiScene;
+
+namespace metagfx {
+namespace tools {
+
+// Material slot a texture is bound to; decides color space and block format
+enum class TextureSlot {
+    Albedo,             // sRGB, BC1 (BC3 when the image has alpha)
+    Normal,             // Linear, BC5 (shaders read .rg and rebuild Z)
+    MetallicRoughness,  // Linear, BC1 (glTF: G = roughness, B = metallic)
+    Roughness,          // Linear, BC4 (shaders read .r)
+    AmbientOcclusion,   // Linear, BC4 (shaders read .r)
+    Emissive            // sRGB, BC1
+};
+
+struct CookSettings {
+    std::string outputDir = "cooked";  // Relative paths are relative to the model's directory
+    bool force = false;                // Re-cook textures whose cooked file is up to date
+};
+
+// Cooks a model's material textures into block-compressed DDS files with a full mip
+// chain and writes the manifest (utils::TextureManifest) Model::LoadFromFile reads.
+// Slots are discovered the same way Model.cpp assigns them, so the manifest keys
+// (texture path + color space) match what the runtime looks up.
+class TextureCooker {
+public:
+    explicit TextureCooker(const CookSettings& settings) : m_Settings(settings) {}
+
+    bool CookModel(const std::string& modelPath);
+
+private:
+    struct TextureRef {
+        std::string path;  // As referenced by the material ("*N" for embedded textures)
+        TextureSlot slot;
+    };
+
+    static std::vector<TextureRef> CollectTextures(const aiScene* scene);
+    static bool IsSRGBSlot(TextureSlot slot);
+    static std::string MakeCookedFileName(const std::string& texPath, bool srgb);
+
+    // Decode, build the mip chain, compress and write one texture
+    bool CookTexture(const aiScene* scene, const std::string& modelDir, const TextureRef& ref,
+                     const std::string& outputPath);
+
+    CookSettings m_Settings;
+};
+
+} // namespace tools
+} // namespace metagfx
@@ -0,0 +1,77 @@
+// ============================================================================
+// tools/texture_cook/main.cpp - Texture Cooking Tool Entry Point
+// ============================================================================
+#include "TextureCooker.h"
+#include "metagfx/core/Types.h"
+
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace metagfx;
+using namespace metagfx::tools;
+
+void PrintUsage(const char* programName) {
+    std::cout << "MetaGFX Texture Cooking Tool\n";
+    std::cout << "============================\n\n";
+    std::cout << "Usage: " << programName << " <model> [<model>...] [options]\n\n";
+    std::cout << "Arguments:\n";
+    std::cout << "  model        Model file (glTF, GLB, OBJ, FBX, ...) whose material textures are cooked\n\n";
+    std::cout << "Options:\n";
+    std::cout << "  --output <dir>            Output directory, relative to the model (default: cooked)\n";
+    std::cout << "  --force                   Re-cook textures that are already up to date\n\n";
+    std::cout << "Output:\n";
+    std::cout << "  <output>/*.dds            BC1/BC3/BC4/BC5 textures with full mip chains\n";
+    std::cout << "                            (sRGB for albedo/emissive, linear for data maps)\n";
+    std::cout << "  <model>.texcook           Manifest; Model::LoadFromFile loads the cooked\n";
+    std::cout << "                            textures instead of decoding PNG/JPG sources\n\n";
+    std::cout << "Example:\n";
+    std::cout << "  " << programName << " assets/models/DamagedHelmet/DamagedHelmet.gltf\n";
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    CookSettings settings;
+    std::vector<std::string> models;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+
+        if (arg == "--output" && i + 1 < argc) {
+            settings.outputDir = argv[++i];
+        } else if (arg == "--force") {
+            settings.force = true;
+        } else if (arg == "--help" || arg == "-h") {
+            PrintUsage(argv[0]);
+            return 0;
+        } else {
+            models.push_back(arg);
+        }
+    }
+
+    if (models.empty()) {
+        PrintUsage(argv[0]);
+        return 1;
+    }
+
+    TextureCooker cooker(settings);
+    bool success = true;
+
+    for (const std::string& model : models) {
+        if (!std::filesystem::exists(model)) {
+            std::cerr << "Error: Model file does not exist: " << model << std::endl;
+            success = false;
+            continue;
+        }
+
+        std::cout << "\nCooking textures for: " << model << "\n";
+        success &= cooker.CookModel(model);
+    }
+
+    return success ? 0 : 1;
+}